@@ -0,0 +1,160 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "attributetriggerscheduler.h"
+#include "core/perfcounters.h"
+#include <QThread>
+#include <cmath>
+
+AttributeTriggerScheduler::AttributeTriggerScheduler(std::function<void(quint32)> apply, std::function<double()> getProgress_m, QObject *parent) :
+    QObject(parent), mApply(apply), mGetProgress_m(getProgress_m)
+{
+    mTimer.setSingleShot(true);
+    mTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mTimer, &ClockTimer::timeout, this, &AttributeTriggerScheduler::timeout);
+    mTriggerErrorId = PerfCounters::getInstance().registerCounter("ATTR_ERR", PerfCounters::Type::Gauge);
+}
+
+void AttributeTriggerScheduler::setEnabled(bool enabled)
+{
+    mEnabled = enabled;
+    if (!mEnabled)
+        cancel();
+}
+
+void AttributeTriggerScheduler::update(double progress_m, double speed_mps, quint32 currentAttributes, double changeProgress_m, quint32 nextAttributes, qint64 period_us)
+{
+    // Route or change ahead is not the one scheduled (anymore)
+    if (mPending && (changeProgress_m != mPendingTrigger.changeProgress_m || nextAttributes != mPendingTrigger.attributes))
+        cancel();
+
+    // The vehicle's pose in the iteration lags behind a change just triggered (prediction error, lead time)
+    if (mTriggered && progress_m >= mLastTrigger.changeProgress_m)
+        mTriggered = false;
+    const bool keepTriggered = mTriggered && mAttributes == mLastTrigger.attributes && progress_m >= mLastTrigger.applyProgress_m - HYSTERESIS;
+
+    if ((currentAttributes != mAttributes || !mHasAttributes) && !keepTriggered) {
+        if (mHasAttributes) {
+            std::lock_guard<std::mutex> lock(mStatisticsMutex);
+            mStatistics.iterationChanges++;
+        }
+        mTriggered = false;
+        setAttributes(currentAttributes);
+    }
+
+    const double speed = fabs(speed_mps);
+    if (changeProgress_m < 0.0 || nextAttributes == mAttributes || speed < MIN_SPEED) {
+        if (mPending)
+            cancel();
+        return;
+    }
+
+    // Predicted from the latest pose, rescheduled in every iteration until due
+    Trigger next;
+    next.attributes = nextAttributes;
+    next.changeProgress_m = changeProgress_m;
+    next.applyProgress_m = changeProgress_m - speed * mLeadTime_ms / 1000.0;
+    const qint64 delay_us = std::llround((next.applyProgress_m - progress_m) / speed * 1e6);
+    if (delay_us >= period_us) {
+        if (mPending)
+            cancel(); // slowed down, the next iteration schedules it
+        return;
+    }
+
+    next.due_us = mTimer.getClock()->now_us() + std::max(delay_us, qint64(0));
+    if (delay_us <= 0) {
+        cancel();
+        trigger(next);
+    } else {
+        mPending = true;
+        mPendingTrigger = next;
+        startTriggerTimer(delay_us);
+    }
+}
+
+void AttributeTriggerScheduler::apply(quint32 attributes)
+{
+    cancel();
+    mTriggered = false;
+    if (attributes != mAttributes || !mHasAttributes)
+        setAttributes(attributes);
+}
+
+void AttributeTriggerScheduler::cancel()
+{
+    if (!mPending)
+        return;
+
+    mPending = false;
+    stopTriggerTimer();
+}
+
+AttributeTriggerStatistics AttributeTriggerScheduler::getStatistics()
+{
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    return mStatistics;
+}
+
+void AttributeTriggerScheduler::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    mStatistics = AttributeTriggerStatistics();
+}
+
+void AttributeTriggerScheduler::trigger(const Trigger &trigger)
+{
+    setAttributes(trigger.attributes);
+    const double error_m = mGetProgress_m() - trigger.applyProgress_m;
+    const double lateness_us = std::max(double(mTimer.getClock()->now_us() - trigger.due_us), 0.0);
+    mTriggered = true;
+    mLastTrigger = trigger;
+
+    PerfCounters::getInstance().setGauge(mTriggerErrorId, error_m);
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    AttributeTriggerStatistics &statistics = mStatistics;
+    statistics.triggers++;
+    statistics.lastError_m = error_m;
+    statistics.maxAbsError_m = std::max(statistics.maxAbsError_m, fabs(error_m));
+    statistics.meanAbsError_m += (fabs(error_m) - statistics.meanAbsError_m) / statistics.triggers;
+    statistics.maxTimerLateness_us = std::max(statistics.maxTimerLateness_us, lateness_us);
+    statistics.meanTimerLateness_us += (lateness_us - statistics.meanTimerLateness_us) / statistics.triggers;
+}
+
+void AttributeTriggerScheduler::timeout()
+{
+    std::unique_lock<std::recursive_mutex> lock;
+    if (mMutex)
+        lock = std::unique_lock<std::recursive_mutex>(*mMutex);
+
+    // Canceled or rescheduled after the timer fired (the timer has ms resolution)
+    if (!mPending || mTimer.getClock()->now_us() < mPendingTrigger.due_us - 1000)
+        return;
+
+    mPending = false;
+    trigger(mPendingTrigger);
+}
+
+void AttributeTriggerScheduler::startTriggerTimer(qint64 delay_us)
+{
+    const int delay_ms = std::max(int(std::lround(delay_us / 1000.0)), 0);
+    if (QThread::currentThread() == mTimer.thread() || !mTimer.getClock()->isRealTime())
+        mTimer.start(delay_ms);
+    else // control iteration on a dedicated thread
+        QMetaObject::invokeMethod(&mTimer, [this, delay_ms]() { mTimer.start(delay_ms); }, Qt::QueuedConnection);
+}
+
+void AttributeTriggerScheduler::stopTriggerTimer()
+{
+    if (QThread::currentThread() == mTimer.thread() || !mTimer.getClock()->isRealTime())
+        mTimer.stop();
+    else
+        QMetaObject::invokeMethod(&mTimer, "stop", Qt::QueuedConnection);
+}
+
+void AttributeTriggerScheduler::setAttributes(quint32 attributes)
+{
+    mAttributes = attributes;
+    mHasAttributes = true;
+    mApply(attributes);
+}
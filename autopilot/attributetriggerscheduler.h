@@ -0,0 +1,93 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Position-triggered route attributes (e.g., implements such as sprayers or seeders): instead of switching attributes
+ * in the control iteration that notices the change, i.e., up to one period late, the time the vehicle crosses the next
+ * change point is predicted from its progress and speed and the attributes are applied on a single-shot timer between
+ * iterations. The timer can fire earlier by the implement's actuation delay (lead time). The trigger error, i.e., the
+ * vehicle's progress past the change point when the attributes are applied, is measured on every trigger.
+ */
+
+#ifndef ATTRIBUTETRIGGERSCHEDULER_H
+#define ATTRIBUTETRIGGERSCHEDULER_H
+
+#include <QObject>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include "core/clock.h"
+
+struct AttributeTriggerStatistics {
+    quint64 triggers = 0; // applied on the timer
+    quint64 iterationChanges = 0; // applied by a control iteration (no prediction, e.g., at the start or standing still)
+    double lastError_m = 0.0; // progress when applied past the change point (less the lead time at the speed), positive: late
+    double meanAbsError_m = 0.0;
+    double maxAbsError_m = 0.0;
+    double meanTimerLateness_us = 0.0; // timeout after the predicted time, i.e., timer and event loop delay
+    double maxTimerLateness_us = 0.0;
+};
+
+class AttributeTriggerScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    // apply: sets the attributes (e.g., MovementController::setDesiredAttributes), getProgress_m: vehicle's current progress along
+    // the route [m] from its latest pose. Both are called with the owner's mutex held (see setMutex).
+    AttributeTriggerScheduler(std::function<void(quint32)> apply, std::function<double()> getProgress_m, QObject *parent = nullptr);
+
+    // update() runs with mutex held (e.g., ControlLoop::getIterationMutex() in the control iteration), the timer locks it when triggering
+    void setMutex(std::recursive_mutex *mutex) { mMutex = mutex; }
+    void setClock(Clock *clock) { mTimer.setClock(clock); }
+
+    bool isEnabled() const { return mEnabled; }
+    void setEnabled(bool enabled);
+    double getLeadTime_ms() const { return mLeadTime_ms; }
+    void setLeadTime_ms(double leadTime_ms) { mLeadTime_ms = std::max(leadTime_ms, 0.0); }
+
+    // Control iteration: the vehicle is at progress_m with speed_mps, the route's attributes there are currentAttributes and change
+    // to nextAttributes at changeProgress_m (< 0: no change ahead). A change crossed before the next iteration is scheduled.
+    void update(double progress_m, double speed_mps, quint32 currentAttributes, double changeProgress_m, quint32 nextAttributes, qint64 period_us);
+    void apply(quint32 attributes); // immediately, cancels a pending trigger
+    void cancel();
+    quint32 getAttributes() const { return mAttributes; }
+
+    AttributeTriggerStatistics getStatistics();
+    void resetStatistics();
+
+private:
+    static constexpr double MIN_SPEED = 0.05; // [m/s], no prediction below
+    static constexpr double HYSTERESIS = 0.5; // [m] before a triggered change point, the iteration keeps the triggered attributes
+
+    struct Trigger {
+        quint32 attributes = 0;
+        double changeProgress_m = -1.0;
+        double applyProgress_m = -1.0; // change point less the lead time
+        qint64 due_us = 0;
+    };
+
+    void trigger(const Trigger &trigger);
+    void timeout();
+    void startTriggerTimer(qint64 delay_us);
+    void stopTriggerTimer();
+    void setAttributes(quint32 attributes);
+
+    std::function<void(quint32)> mApply;
+    std::function<double()> mGetProgress_m;
+    std::recursive_mutex *mMutex = nullptr;
+    ClockTimer mTimer;
+    bool mEnabled = false;
+    double mLeadTime_ms = 0.0;
+    quint32 mAttributes = 0;
+    bool mHasAttributes = false;
+    bool mPending = false;
+    Trigger mPendingTrigger;
+    bool mTriggered = false; // the last change was applied on the timer, until the iteration's progress passes it
+    Trigger mLastTrigger;
+
+    std::mutex mStatisticsMutex;
+    AttributeTriggerStatistics mStatistics;
+    int mTriggerErrorId = -1;
+};
+
+#endif // ATTRIBUTETRIGGERSCHEDULER_H
@@ -0,0 +1,340 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "dwawaypointfollower.h"
+#include "vehicles/carstate.h"
+#include "vehicles/vehiclekinematics.h"
+#include "communication/parameterserver.h"
+#include "core/tickarena.h"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr int MAX_FOOTPRINT_DISCS = 8;
+
+// Route ahead of the vehicle as structure of arrays, arc length from the start of the vehicle's segment
+struct RouteSegments {
+    int count = 0;
+    std::array<double, DwaParameters::MAX_ROUTE_SEGMENTS> x;
+    std::array<double, DwaParameters::MAX_ROUTE_SEGMENTS> y;
+    std::array<double, DwaParameters::MAX_ROUTE_SEGMENTS> cosHeading;
+    std::array<double, DwaParameters::MAX_ROUTE_SEGMENTS> sinHeading;
+    std::array<double, DwaParameters::MAX_ROUTE_SEGMENTS> heading_rad;
+    std::array<double, DwaParameters::MAX_ROUTE_SEGMENTS> length;
+    std::array<double, DwaParameters::MAX_ROUTE_SEGMENTS> arcStart;
+
+    // Closest segment by brute force, progress along the segments and lateral error (positive: left)
+    void project(double px, double py, double &progress, double &lateral, double &heading) const {
+        double minDistance2 = std::numeric_limits<double>::infinity();
+        for (int j = 0; j < count; j++) {
+            const double rx = px - x[j], ry = py - y[j];
+            const double along = std::min(std::max(rx * cosHeading[j] + ry * sinHeading[j], 0.0), length[j]);
+            const double dx = rx - along * cosHeading[j], dy = ry - along * sinHeading[j];
+            const double distance2 = dx * dx + dy * dy;
+            if (distance2 < minDistance2) {
+                minDistance2 = distance2;
+                progress = arcStart[j] + along;
+                lateral = -rx * sinHeading[j] + ry * cosHeading[j];
+                heading = heading_rad[j];
+            }
+        }
+    }
+};
+}
+
+void DwaWaypointFollower::setDwaParameters(const DwaParameters &parameters)
+{
+    std::lock_guard<std::recursive_mutex> lock(getControlLoop().getIterationMutex());
+    mParameters = parameters;
+    mParameters.speedSamples = qBound(1, mParameters.speedSamples, DwaParameters::MAX_SPEED_SAMPLES);
+    mParameters.steeringSamples = qBound(1, mParameters.steeringSamples, DwaParameters::MAX_STEERING_SAMPLES);
+    mParameters.horizonSteps = qBound(1, mParameters.horizonSteps, DwaParameters::MAX_HORIZON_STEPS);
+    mParameters.horizonStep_s = std::max(mParameters.horizonStep_s, 0.001);
+    mParameters.clearanceRange_m = std::max(mParameters.clearanceRange_m, mParameters.minClearance_m + 0.01);
+}
+
+void DwaWaypointFollower::setOccupancyGrid(QSharedPointer<const OccupancyGrid> occupancyGrid)
+{
+    std::lock_guard<std::recursive_mutex> lock(getControlLoop().getIterationMutex());
+    mOccupancyGrid = occupancyGrid;
+    mClearanceMapSize = 0;
+    mClearanceMapTimestamp_ns = utcTime::INVALID;
+}
+
+DwaStatistics DwaWaypointFollower::getDwaStatistics()
+{
+    std::lock_guard<std::recursive_mutex> lock(getControlLoop().getIterationMutex());
+    return mStatistics;
+}
+
+void DwaWaypointFollower::resetDwaStatistics()
+{
+    std::lock_guard<std::recursive_mutex> lock(getControlLoop().getIterationMutex());
+    mStatistics = DwaStatistics();
+}
+
+void DwaWaypointFollower::provideParametersToParameterServer()
+{
+    PurepursuitWaypointFollower::provideParametersToParameterServer();
+    if (ParameterServer::getInstance()) {
+        auto provideParameter = [this](const std::string &name, double DwaParameters::*parameter) {
+            ParameterServer::getInstance()->provideFloatParameter(name, [this, parameter](float value) {
+                DwaParameters parameters = getDwaParameters();
+                parameters.*parameter = value;
+                setDwaParameters(parameters);
+            }, [this, parameter]() { return float(getDwaParameters().*parameter); });
+        };
+        provideParameter("DWA_STEP", &DwaParameters::horizonStep_s);
+        provideParameter("DWA_W_PROG", &DwaParameters::progressWeight);
+        provideParameter("DWA_W_LAT", &DwaParameters::lateralErrorWeight);
+        provideParameter("DWA_W_HDG", &DwaParameters::headingErrorWeight);
+        provideParameter("DWA_W_CLR", &DwaParameters::clearanceWeight);
+        provideParameter("DWA_W_LACC", &DwaParameters::lateralAccelerationWeight);
+        provideParameter("DWA_W_DSTR", &DwaParameters::steeringChangeWeight);
+        provideParameter("DWA_MIN_CLR", &DwaParameters::minClearance_m);
+        provideParameter("DWA_CLR_RNG", &DwaParameters::clearanceRange_m);
+    }
+}
+
+double DwaWaypointFollower::getSteeringCurvature(const PosPoint &goal)
+{
+    double steeringCurvature = 0.0;
+    mActive = evaluate(goal, steeringCurvature, mSpeed);
+    return mActive ? steeringCurvature : PurepursuitWaypointFollower::getSteeringCurvature(goal);
+}
+
+double DwaWaypointFollower::getDesiredSpeed(const PosPoint &goal)
+{
+    return mActive ? mSpeed : PurepursuitWaypointFollower::getDesiredSpeed(goal);
+}
+
+bool DwaWaypointFollower::evaluate(const PosPoint &goal, double &steeringCurvature, double &speed)
+{
+    const QSharedPointer<CarState> carState = getVehicleState().dynamicCast<CarState>();
+    if (!carState || goal.getSpeed() < 0.0)
+        return false;
+    const PosPoint position = carState->getPosition(getPosTypeUsed());
+    const double yaw_rad = position.getYaw() * M_PI / 180.0;
+    const RouteTrackingError trackingError = getRouteTrackingError(position.getPoint(), yaw_rad);
+    if (!trackingError.valid)
+        return false;
+
+    const auto evaluationStart = std::chrono::steady_clock::now();
+    TickArena::Scope arenaScope; // candidates of this evaluation
+    const DwaParameters &p = mParameters;
+    const vehicleKinematics::CarModel model = carState->getKinematicModel();
+    updateClearanceMap();
+
+    // Dynamic window: reachable within one control period
+    const double period_s = getControlLoop().getPeriod_us() / 1e6;
+    const double currentSpeed = std::max(carState->getSpeed(), 0.0);
+    const double minSpeed = std::max(currentSpeed - fabs(carState->getMinAcceleration()) * period_s, 0.0);
+    const double maxSpeed = std::max(std::min(goal.getSpeed(), currentSpeed + carState->getMaxAcceleration() * period_s), minSpeed);
+    const double maxSteering = std::min(carState->getSteeringGeometryTable().getMaxSteering(), 1.0); // as CarState::setCommandedSteering
+    const double currentSteering = qBound(-maxSteering, carState->getSteering(), maxSteering);
+    const double steeringRange = (carState->getMaxSteeringRate() > 0.0) ? carState->getMaxSteeringRate() * period_s : 2.0 * maxSteering;
+    const double minSteering = std::max(currentSteering - steeringRange, -maxSteering);
+    const double maxSteeringInWindow = std::min(currentSteering + steeringRange, maxSteering);
+
+    const int speedSamples = (maxSpeed - minSpeed > 1e-3) ? p.speedSamples : 1;
+    const int steeringSamples = (maxSteeringInWindow - minSteering > 1e-6) ? p.steeringSamples : 1;
+    const int candidates = speedSamples * steeringSamples;
+    ArenaVector<double> steerings(candidates), speeds(candidates), yawChanges(candidates), chords(candidates);
+    ArenaVector<double> x(candidates), y(candidates), yaws(candidates), clearances(candidates);
+    for (int a = 0; a < speedSamples; a++) {
+        for (int b = 0; b < steeringSamples; b++) {
+            const int i = a * steeringSamples + b;
+            speeds[i] = (speedSamples > 1) ? minSpeed + (maxSpeed - minSpeed) * a / (speedSamples - 1) : maxSpeed;
+            steerings[i] = (steeringSamples > 1) ? minSteering + (maxSteeringInWindow - minSteering) * b / (steeringSamples - 1) : currentSteering;
+
+            // Constant speed and steering over the horizon, i.e., the same arc per step
+            const double ds = speeds[i] * p.horizonStep_s;
+            yawChanges[i] = ds * model.getYawCurvature(steerings[i]);
+            chords[i] = ds * model.getPathDistanceFactor(steerings[i]) * vehicleKinematics::detail::chordFactor(0.5 * yawChanges[i]);
+            x[i] = position.getX();
+            y[i] = position.getY();
+            yaws[i] = yaw_rad;
+            clearances[i] = std::numeric_limits<double>::infinity();
+        }
+    }
+
+    // Footprint as discs along the vehicle's x axis
+    const QRectF &footprint = p.footprint;
+    const int discs = qBound(1, int(ceil(footprint.width() / std::max(footprint.height(), 0.01))), MAX_FOOTPRINT_DISCS);
+    const double discRadius = hypot(footprint.width() / discs / 2.0, footprint.height() / 2.0);
+    std::array<double, MAX_FOOTPRINT_DISCS> discOffsets;
+    for (int k = 0; k < discs; k++)
+        discOffsets[k] = footprint.left() + (k + 0.5) * footprint.width() / discs;
+    const double discOffsetY = footprint.center().y();
+
+    // Rollouts, clearance at every step (also at the start: candidates do not help if the vehicle is in collision already)
+    const bool checkClearance = mClearanceMapSize > 0;
+    for (int step = 0; step <= p.horizonSteps; step++) {
+        if (step > 0) {
+            for (int i = 0; i < candidates; i++) {
+                const double yawMid = yaws[i] + 0.5 * yawChanges[i];
+                x[i] += chords[i] * std::cos(yawMid);
+                y[i] += chords[i] * std::sin(yawMid);
+                yaws[i] += yawChanges[i];
+            }
+        }
+        if (checkClearance) {
+            for (int i = 0; i < candidates; i++) {
+                const double c = std::cos(yaws[i]), s = std::sin(yaws[i]);
+                for (int k = 0; k < discs; k++) {
+                    const double clearance = getClearance(x[i] + c * discOffsets[k] - s * discOffsetY, y[i] + s * discOffsets[k] + c * discOffsetY) - discRadius;
+                    clearances[i] = std::min(clearances[i], clearance);
+                }
+            }
+        }
+    }
+
+    // Route ahead, as far as the fastest candidate (and the footprint) can get
+    const RouteGeometry &route = getRouteGeometry();
+    const bool wrapAround = getRepeatRoute();
+    RouteSegments segments;
+    const double reach_m = maxSpeed * p.getHorizon_s() + footprint.right() + p.clearanceRange_m;
+    const int firstSegmentIndex = (trackingError.segmentEndIndex > 0) ? trackingError.segmentEndIndex - 1 : route.size() - 1;
+    int segmentIndex = firstSegmentIndex;
+    double arcLength = 0.0;
+    while (segments.count < DwaParameters::MAX_ROUTE_SEGMENTS && arcLength <= reach_m && segmentIndex < route.size() - (wrapAround ? 0 : 1)) {
+        const double length = route.getSegmentLength(segmentIndex);
+        if (length > 1e-6) {
+            const int j = segments.count++;
+            segments.x[j] = route.getPoint(segmentIndex).x();
+            segments.y[j] = route.getPoint(segmentIndex).y();
+            segments.heading_rad[j] = route.getSegmentHeading_rad(segmentIndex);
+            segments.cosHeading[j] = cos(segments.heading_rad[j]);
+            segments.sinHeading[j] = sin(segments.heading_rad[j]);
+            segments.length[j] = length;
+            segments.arcStart[j] = arcLength;
+            arcLength += length;
+        }
+        segmentIndex = wrapAround ? (segmentIndex + 1) % route.size() : segmentIndex + 1;
+        if (segmentIndex == firstSegmentIndex)
+            break; // once around
+    }
+    if (segments.count == 0)
+        return false;
+
+    double startProgress = 0.0, startLateral = 0.0, startHeading = 0.0;
+    segments.project(position.getX(), position.getY(), startProgress, startLateral, startHeading);
+
+    // Cost, the cheapest feasible candidate wins
+    const double maxProgress = std::max(std::max(goal.getSpeed(), maxSpeed) * p.getHorizon_s(), 1e-3);
+    const double clearanceSpan = p.clearanceRange_m - p.minClearance_m;
+    int best = -1;
+    double bestCost = std::numeric_limits<double>::infinity();
+    int feasible = 0;
+    for (int i = 0; i < candidates; i++) {
+        if (clearances[i] < p.minClearance_m)
+            continue;
+        feasible++;
+
+        double progress = startProgress, lateral = startLateral, heading = startHeading;
+        segments.project(x[i], y[i], progress, lateral, heading);
+        const double headingError = remainder(yaws[i] - heading, 2.0 * M_PI);
+        const double lateralAcceleration = speeds[i] * speeds[i] * model.getYawCurvature(steerings[i]);
+        const double steeringChange = 0.5 * (steerings[i] - currentSteering);
+        const double cost = -p.progressWeight * (progress - startProgress) / maxProgress
+                + p.lateralErrorWeight * lateral * lateral
+                + p.headingErrorWeight * headingError * headingError
+                + p.clearanceWeight * qBound(0.0, (p.clearanceRange_m - clearances[i]) / clearanceSpan, 1.0)
+                + p.lateralAccelerationWeight * lateralAcceleration * lateralAcceleration
+                + p.steeringChangeWeight * steeringChange * steeringChange;
+        if (cost < bestCost) {
+            bestCost = cost;
+            best = i;
+        }
+    }
+
+    if (best >= 0) {
+        speed = speeds[best];
+        steeringCurvature = model.getSteeringCurvature(steerings[best]);
+    } else { // blocked, stop with the current steering
+        speed = 0.0;
+        steeringCurvature = model.getSteeringCurvature(currentSteering);
+        mStatistics.blockedEvaluations++;
+    }
+
+    const double evaluationTime_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - evaluationStart).count();
+    mStatistics.evaluations++;
+    mStatistics.lastCandidates = candidates;
+    mStatistics.lastFeasibleCandidates = feasible;
+    mStatistics.lastEvaluationTime_us = evaluationTime_us;
+    mStatistics.maxEvaluationTime_us = std::max(mStatistics.maxEvaluationTime_us, evaluationTime_us);
+    mStatistics.meanEvaluationTime_us += (evaluationTime_us - mStatistics.meanEvaluationTime_us) / mStatistics.evaluations;
+    return true;
+}
+
+void DwaWaypointFollower::updateClearanceMap()
+{
+    if (!mOccupancyGrid) {
+        mClearanceMapSize = 0;
+        return;
+    }
+
+    // Unchanged grid (updates without timestamp cannot be detected)
+    const qint64 timestamp_ns = mOccupancyGrid->getLastUpdateTimestamp_ns();
+    if (mClearanceMapSize > 0 && timestamp_ns != utcTime::INVALID && timestamp_ns == mClearanceMapTimestamp_ns && mOccupancyGrid->getBounds() == mClearanceBounds)
+        return;
+
+    const int size = mOccupancyGrid->getSize();
+    mGridSnapshot.resize(size * size);
+    mClearanceMap_m.resize(size * size);
+    mOccupancyGrid->getLogOddsSnapshot(mGridSnapshot.data(), mClearanceBounds);
+    mClearanceMapSize = size;
+    mClearanceCellSize_m = mOccupancyGrid->getCellSize();
+    mClearanceMapTimestamp_ns = timestamp_ns;
+
+    // Chamfer distance transform (in cells), forward and backward pass
+    constexpr float FAR = std::numeric_limits<float>::max() / 2.0f;
+    constexpr float DIAGONAL = float(M_SQRT2);
+    float *distance = mClearanceMap_m.data();
+    for (int i = 0; i < size * size; i++)
+        distance[i] = (mGridSnapshot.at(i) >= OccupancyGrid::LOG_ODDS_OCCUPIED) ? 0.0f : FAR;
+    for (int row = 0; row < size; row++) {
+        for (int column = 0; column < size; column++) {
+            float &d = distance[row * size + column];
+            if (column > 0)
+                d = std::min(d, distance[row * size + column - 1] + 1.0f);
+            if (row > 0) {
+                d = std::min(d, distance[(row - 1) * size + column] + 1.0f);
+                if (column > 0)
+                    d = std::min(d, distance[(row - 1) * size + column - 1] + DIAGONAL);
+                if (column + 1 < size)
+                    d = std::min(d, distance[(row - 1) * size + column + 1] + DIAGONAL);
+            }
+        }
+    }
+    for (int row = size - 1; row >= 0; row--) {
+        for (int column = size - 1; column >= 0; column--) {
+            float &d = distance[row * size + column];
+            if (column + 1 < size)
+                d = std::min(d, distance[row * size + column + 1] + 1.0f);
+            if (row + 1 < size) {
+                d = std::min(d, distance[(row + 1) * size + column] + 1.0f);
+                if (column + 1 < size)
+                    d = std::min(d, distance[(row + 1) * size + column + 1] + DIAGONAL);
+                if (column > 0)
+                    d = std::min(d, distance[(row + 1) * size + column - 1] + DIAGONAL);
+            }
+        }
+    }
+    const float cellSize = float(mClearanceCellSize_m);
+    for (int i = 0; i < size * size; i++)
+        distance[i] = (distance[i] >= FAR) ? std::numeric_limits<float>::infinity() : distance[i] * cellSize;
+}
+
+float DwaWaypointFollower::getClearance(double x, double y) const
+{
+    // Outside of the grid is unknown, i.e., free
+    const int column = int(floor((x - mClearanceBounds.left()) / mClearanceCellSize_m));
+    const int row = int(floor((y - mClearanceBounds.top()) / mClearanceCellSize_m));
+    if (column < 0 || row < 0 || column >= mClearanceMapSize || row >= mClearanceMapSize)
+        return std::numeric_limits<float>::infinity();
+    return mClearanceMap_m.at(row * mClearanceMapSize + column);
+}
@@ -0,0 +1,96 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Dynamic-window local controller on the route state machine of PurepursuitWaypointFollower, e.g., for yards with obstacles.
+ * Each control iteration samples (speed, steering) pairs reachable within one control period (acceleration and steering rate
+ * limits of the vehicle), rolls them out over the horizon with the vehicle's kinematic model (vehicleKinematics::CarModel)
+ * and commands the cheapest one. Cost: route progress, lateral and heading error to the route at the end of the rollout,
+ * clearance to occupied cells of an OccupancyGrid along the rollout, lateral acceleration and steering change.
+ * Rollouts closer than minClearance_m to an obstacle are rejected, the vehicle stops if none is left.
+ * Candidates are stored as structure of arrays in the control loop's TickArena, clearance is looked up in a distance map of
+ * the grid (rebuilt when the grid changed). On the vehicle and for car-like vehicles (CarState) while following the route
+ * forwards, pure pursuit otherwise.
+ */
+
+#ifndef DWAWAYPOINTFOLLOWER_H
+#define DWAWAYPOINTFOLLOWER_H
+
+#include "autopilot/purepursuitwaypointfollower.h"
+#include "core/occupancygrid.h"
+#include <QRectF>
+
+struct DwaParameters {
+    static constexpr int MAX_SPEED_SAMPLES = 16;
+    static constexpr int MAX_STEERING_SAMPLES = 64;
+    static constexpr int MAX_HORIZON_STEPS = 50;
+    static constexpr int MAX_ROUTE_SEGMENTS = 64; // ahead of the vehicle, checked for each rollout
+
+    int speedSamples = 7;
+    int steeringSamples = 41;
+    int horizonSteps = 20;
+    double horizonStep_s = 0.1;
+    double progressWeight = 1.0; // per horizon at the goal's speed
+    double lateralErrorWeight = 1.0; // per m²
+    double headingErrorWeight = 0.5; // per rad²
+    double clearanceWeight = 1.0; // at minClearance_m, decreasing linearly to 0 at clearanceRange_m
+    double lateralAccelerationWeight = 0.05; // per (m/s²)²
+    double steeringChangeWeight = 0.1; // per full range
+    double minClearance_m = 0.05;
+    double clearanceRange_m = 1.0;
+    QRectF footprint = QRectF(-0.15, -0.2, 0.8, 0.4); // vehicle frame (x forward, y left) [m], see MovementController::getFootprint
+
+    double getHorizon_s() const { return horizonSteps * horizonStep_s; }
+};
+
+// Evaluations of the dynamic window, i.e., per control iteration while following the route
+struct DwaStatistics {
+    quint64 evaluations = 0;
+    quint64 blockedEvaluations = 0; // no feasible candidate, the vehicle was stopped
+    int lastCandidates = 0;
+    int lastFeasibleCandidates = 0;
+    double lastEvaluationTime_us = 0.0;
+    double maxEvaluationTime_us = 0.0;
+    double meanEvaluationTime_us = 0.0;
+};
+
+class DwaWaypointFollower : public PurepursuitWaypointFollower
+{
+    Q_OBJECT
+public:
+    DwaWaypointFollower(QSharedPointer<MovementController> movementController) : PurepursuitWaypointFollower(movementController) {}
+
+    DwaParameters getDwaParameters() const { return mParameters; }
+    void setDwaParameters(const DwaParameters &parameters);
+    // Obstacles in ENU around the vehicle, nullptr: only route and comfort are considered
+    void setOccupancyGrid(QSharedPointer<const OccupancyGrid> occupancyGrid);
+
+    DwaStatistics getDwaStatistics();
+    void resetDwaStatistics();
+
+    virtual void provideParametersToParameterServer() override;
+
+protected:
+    virtual double getSteeringCurvature(const PosPoint &goal) override;
+    virtual double getDesiredSpeed(const PosPoint &goal) override;
+
+private:
+    bool evaluate(const PosPoint &goal, double &steeringCurvature, double &speed);
+    void updateClearanceMap();
+    float getClearance(double x, double y) const;
+
+    DwaParameters mParameters;
+    DwaStatistics mStatistics;
+    bool mActive = false; // last iteration was evaluated, getDesiredSpeed returns mSpeed
+    double mSpeed = 0.0;
+
+    QSharedPointer<const OccupancyGrid> mOccupancyGrid;
+    QVector<qint8> mGridSnapshot;
+    QVector<float> mClearanceMap_m; // distance to the closest occupied cell, row by row from the lower left corner of mClearanceBounds
+    QRectF mClearanceBounds;
+    int mClearanceMapSize = 0; // cells per side
+    double mClearanceCellSize_m = 0.0;
+    qint64 mClearanceMapTimestamp_ns = utcTime::INVALID; // of the grid's last update
+};
+
+#endif // DWAWAYPOINTFOLLOWER_H
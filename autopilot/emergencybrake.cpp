@@ -3,41 +3,265 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "emergencybrake.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
 
 EmergencyBrake::EmergencyBrake(QObject *parent)
     : QObject{parent}
 {
+    mObjectTracker.setAssociationGate_m(ASSOCIATION_GATE_m);
+    mObjectTracker.setTrackTimeout_ns(TRACK_TIMEOUT_ns);
+    mTrackedObjects.reserve(ObjectTracker::MAX_TRACKS);
 
+    mDecisionLoop.setMode(ControlLoop::Mode::DEDICATED_THREAD);
+    mDecisionLoop.start();
+}
+
+EmergencyBrake::~EmergencyBrake()
+{
+    mDecisionLoop.stop();
+}
+
+void EmergencyBrake::setVehicleState(QSharedPointer<VehicleState> vehicleState)
+{
+    std::lock_guard<std::recursive_mutex> lock(mDecisionLoop.getIterationMutex());
+    mVehicleState = vehicleState;
+}
+
+void EmergencyBrake::setToFSensor(QSharedPointer<ToFSensor> tofSensor)
+{
+    if (mToFSensor)
+        disconnect(mToFSensor.get(), nullptr, this, nullptr);
+
+    mToFSensor = tofSensor;
+    if (mToFSensor)
+        connect(mToFSensor.get(), &ToFSensor::updatedRange, this, [this](double distance_m, qint64 timestamp_ns) {
+            updateRangeMeasurement(RangeSensor::ToF, distance_m, timestamp_ns, TOF_MAX_RANGE_m);
+        });
+}
+
+void EmergencyBrake::setOccupancyGrid(QSharedPointer<const OccupancyGrid> occupancyGrid, PosType posType)
+{
+    std::lock_guard<std::recursive_mutex> lock(mDecisionLoop.getIterationMutex());
+    mOccupancyGrid = occupancyGrid;
+    mOccupancyGridPosType = posType;
+}
+
+EmergencyBrakeLatency EmergencyBrake::getLatency() const
+{
+    const std::lock_guard<std::mutex> lock(mLatencyMutex);
+    return mLatency;
+}
+
+EmergencyBrakeState EmergencyBrake::getState()
+{
+    std::lock_guard<std::recursive_mutex> lock(mDecisionLoop.getIterationMutex());
+    return mCurrentState;
+}
+
+void EmergencyBrake::setState(const EmergencyBrakeState &state)
+{
+    std::lock_guard<std::recursive_mutex> lock(mDecisionLoop.getIterationMutex());
+    const EmergencyBrakeState decision = mCurrentState;
+    mCurrentState = state;
+    mCurrentState.brakeForDetectedCameraObject = decision.brakeForDetectedCameraObject;
+    mCurrentState.brakeForDetectedToFObject = decision.brakeForDetectedToFObject;
+    mCurrentState.brakeForDetectedLidarObject = decision.brakeForDetectedLidarObject;
+    mCurrentState.brakeForDetectedRadarObject = decision.brakeForDetectedRadarObject;
+    mCurrentState.brakeForOccupiedCell = decision.brakeForOccupiedCell;
 }
 
 void EmergencyBrake::deactivateEmergencyBrake()
 {
+    std::lock_guard<std::recursive_mutex> lock(mDecisionLoop.getIterationMutex());
     mCurrentState.emergencyBrakeIsActive = false;
 };
 
 void EmergencyBrake::activateEmergencyBrake()
 {
+    std::lock_guard<std::recursive_mutex> lock(mDecisionLoop.getIterationMutex());
     mCurrentState.emergencyBrakeIsActive = true;
 };
 
 void EmergencyBrake::brakeForDetectedCameraObject(const PosPoint &detectedObject)
 {
     //When no object is detected, objectDistance is zero
-    double objectDistance = sqrt(detectedObject.getX()*detectedObject.getX() + detectedObject.getY()*detectedObject.getY() + detectedObject.getHeight()*detectedObject.getHeight());
-
-    if (objectDistance > 0 && objectDistance < mCurrentState.brakeForObjectAtDistance)
-        mCurrentState.brakeForDetectedCameraObject = true;
-    else
-        mCurrentState.brakeForDetectedCameraObject = false;
+    const bool hasObject = detectedObject.getX() != 0.0 || detectedObject.getY() != 0.0 || detectedObject.getHeight() != 0.0;
 
-    fuseSensorsAndTakeBrakeDecision();
+    const qint64 timestamp_ns = utcTime::isValid(detectedObject.getTimestamp_ns()) ? detectedObject.getTimestamp_ns() : utcTime::now_ns();
+    updateTrackedObjects(&detectedObject, hasObject ? 1 : 0, timestamp_ns);
 };
 
-void EmergencyBrake::fuseSensorsAndTakeBrakeDecision()
+void EmergencyBrake::brakeForDetectedCameraObjects(const QVector<PosPoint> &detectedObjects)
+{
+    qint64 timestamp_ns = utcTime::now_ns();
+    for (const auto& detectedObject : detectedObjects)
+        if (utcTime::isValid(detectedObject.getTimestamp_ns()))
+            timestamp_ns = std::min(timestamp_ns, detectedObject.getTimestamp_ns());
+
+    updateTrackedObjects(detectedObjects.constData(), detectedObjects.size(), timestamp_ns);
+}
+
+void EmergencyBrake::updateRangeMeasurement(RangeSensor sensor, double distance_m, qint64 timestamp_ns, double maxRange_m)
+{
+    std::lock_guard<std::recursive_mutex> lock(mDecisionLoop.getIterationMutex());
+    RangeMeasurement &measurement = mRangeMeasurements[static_cast<int>(sensor)];
+    const bool hasObject = distance_m > 0.0 && distance_m <= maxRange_m;
+
+    if (hasObject && measurement.hasObject && utcTime::isValid(measurement.timestamp_ns) &&
+            timestamp_ns - measurement.timestamp_ns < TRACK_TIMEOUT_ns) {
+        const double dt_s = (timestamp_ns - measurement.timestamp_ns) / 1e9;
+        if (dt_s > 1e-3) {
+            const double measuredClosingSpeed = (measurement.distance_m - distance_m) / dt_s;
+            measurement.closingSpeed = measurement.hasClosingSpeed ? (measurement.closingSpeed + measuredClosingSpeed) / 2.0 : measuredClosingSpeed;
+            measurement.hasClosingSpeed = true;
+        }
+    } else
+        measurement.hasClosingSpeed = false;
+
+    measurement.distance_m = distance_m;
+    measurement.hasObject = hasObject;
+    measurement.timestamp_ns = timestamp_ns;
+}
+
+void EmergencyBrake::updateTrackedObjects(const PosPoint *detectedObjects, int numDetectedObjects, qint64 timestamp_ns)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(mDecisionLoop.getIterationMutex());
+        mObjectTracker.update(detectedObjects, numDetectedObjects, timestamp_ns);
+    }
+
+    const std::lock_guard<std::mutex> lock(mTrackedObjectsMutex);
+    mTrackedObjects.resize(mObjectTracker.size()); // within reserved capacity
+    std::copy(mObjectTracker.begin(), mObjectTracker.end(), mTrackedObjects.begin());
+}
+
+QVector<TrackedObject> EmergencyBrake::getTrackedObjects() const
 {
-    if (mCurrentState.emergencyBrakeIsActive) {
-        // ToDo: create decission logic depending on multiple sensor inputs
-        if (mCurrentState.brakeForDetectedCameraObject)
-            emit emergencyBrake();
+    const std::lock_guard<std::mutex> lock(mTrackedObjectsMutex);
+    return QVector<TrackedObject>(mTrackedObjects.begin(), mTrackedObjects.end()); // deep copy, keeps mTrackedObjects unshared
+}
+
+bool EmergencyBrake::needsToBrake(double distance_m, double lateralOffset_m, double closingSpeed) const
+{
+    if (distance_m < mCurrentState.brakeForObjectAtDistance)
+        return true;
+
+    const bool isInCorridor = fabs(lateralOffset_m) < mCurrentState.corridorHalfWidth;
+    if (!isInCorridor || closingSpeed <= 0.01)
+        return false;
+
+    if (distance_m / closingSpeed < mCurrentState.brakeForTimeToCollision)
+        return true;
+
+    // Distance covered until the relative motion stops: reaction, then full braking
+    const double reactionTime_s = mDecisionLoop.getPeriod_us() / 1e6 + mCurrentState.brakeReactionTime;
+    const double stoppingDistance_m = closingSpeed * reactionTime_s + closingSpeed * closingSpeed / (2.0 * mDeceleration);
+    return stoppingDistance_m > distance_m - mCurrentState.safetyMargin;
+}
+
+EmergencyBrake::BrakeCheck EmergencyBrake::checkCameraObjects(qint64 now_ns) const
+{
+    BrakeCheck check;
+    for (const auto& trackedObject : mObjectTracker) {
+        const double age_s = (now_ns - trackedObject.lastSeen_ns) / 1e9;
+        if (age_s * 1e9 > TRACK_TIMEOUT_ns)
+            continue;
+
+        // Relative velocity from track, static object assumed until then
+        const QPointF relativeVelocity = trackedObject.hasVelocity ? trackedObject.velocity : QPointF(-mVehicleSpeed, 0.0);
+        const QPointF position = trackedObject.position + relativeVelocity * std::max(age_s, 0.0);
+        if (position.x() <= 0.0)
+            continue; // behind the camera
+
+        const double distance_m = std::sqrt(position.x()*position.x() + position.y()*position.y() + trackedObject.height*trackedObject.height);
+        const double planarDistance_m = std::hypot(position.x(), position.y());
+        const double closingSpeed = planarDistance_m > 1e-3 ?
+                    -(position.x() * relativeVelocity.x() + position.y() * relativeVelocity.y()) / planarDistance_m : 0.0;
+
+        if (needsToBrake(distance_m, position.y(), closingSpeed)) {
+            check.brake = true;
+            check.measurementTimestamp_ns = std::max(check.measurementTimestamp_ns, trackedObject.lastSeen_ns);
+        }
+    }
+    return check;
+}
+
+EmergencyBrake::BrakeCheck EmergencyBrake::checkRangeMeasurement(const RangeMeasurement &measurement, qint64 now_ns) const
+{
+    BrakeCheck check;
+    if (!measurement.hasObject || !utcTime::isValid(measurement.timestamp_ns) || now_ns - measurement.timestamp_ns > TRACK_TIMEOUT_ns)
+        return check;
+
+    const double closingSpeed = measurement.hasClosingSpeed ? measurement.closingSpeed : mVehicleSpeed;
+    const double distance_m = measurement.distance_m - closingSpeed * std::max((now_ns - measurement.timestamp_ns) / 1e9, 0.0);
+    if (needsToBrake(distance_m, 0.0, closingSpeed)) {
+        check.brake = true;
+        check.measurementTimestamp_ns = measurement.timestamp_ns;
+    }
+    return check;
+}
+
+EmergencyBrake::BrakeCheck EmergencyBrake::checkOccupancyGrid() const
+{
+    BrakeCheck check;
+    if (!mOccupancyGrid || !mVehicleState)
+        return check;
+
+    // Only up to where braking could be needed, i.e., the distance at which needsToBrake triggers for the vehicle's speed
+    const double reactionTime_s = mDecisionLoop.getPeriod_us() / 1e6 + mCurrentState.brakeReactionTime;
+    const double maxDistance_m = std::max(mVehicleSpeed * reactionTime_s + mVehicleSpeed * mVehicleSpeed / (2.0 * mDeceleration) + mCurrentState.safetyMargin,
+                                          std::max(mVehicleSpeed * mCurrentState.brakeForTimeToCollision, mCurrentState.brakeForObjectAtDistance));
+    const PosPoint pose = mVehicleState->getPosition(mOccupancyGridPosType);
+    double lateralOffset_m = 0.0;
+    const double distance_m = mOccupancyGrid->getDistanceToOccupied(pose.getPoint(), pose.getYaw() * M_PI / 180.0, mCurrentState.corridorHalfWidth,
+                                                                     maxDistance_m, &lateralOffset_m);
+    if (distance_m >= 0.0 && needsToBrake(distance_m, lateralOffset_m, mVehicleSpeed)) {
+        check.brake = true;
+        check.measurementTimestamp_ns = mOccupancyGrid->getLastUpdateTimestamp_ns();
+    }
+    return check;
+}
+
+void EmergencyBrake::takeBrakeDecision()
+{
+    const qint64 now_ns = utcTime::now_ns();
+    mVehicleSpeed = mVehicleState ? std::max(mVehicleState->getSpeed(), 0.0) : 0.0; // forward sensors, no braking for them when reversing
+    const double decelerationLimit = mVehicleState ? -mVehicleState->getMinAcceleration() : 0.0;
+    mDeceleration = decelerationLimit > 0.0 ? decelerationLimit : mCurrentState.defaultDeceleration;
+
+    const BrakeCheck cameraCheck = checkCameraObjects(now_ns);
+    const BrakeCheck tofCheck = checkRangeMeasurement(mRangeMeasurements[static_cast<int>(RangeSensor::ToF)], now_ns);
+    const BrakeCheck lidarCheck = checkRangeMeasurement(mRangeMeasurements[static_cast<int>(RangeSensor::Lidar)], now_ns);
+    const BrakeCheck radarCheck = checkRangeMeasurement(mRangeMeasurements[static_cast<int>(RangeSensor::Radar)], now_ns);
+    const BrakeCheck occupancyGridCheck = checkOccupancyGrid();
+    mCurrentState.brakeForDetectedCameraObject = cameraCheck.brake;
+    mCurrentState.brakeForDetectedToFObject = tofCheck.brake;
+    mCurrentState.brakeForDetectedLidarObject = lidarCheck.brake;
+    mCurrentState.brakeForDetectedRadarObject = radarCheck.brake;
+    mCurrentState.brakeForOccupiedCell = occupancyGridCheck.brake;
+
+    const bool brake = mCurrentState.emergencyBrakeIsActive && (cameraCheck.brake || tofCheck.brake || lidarCheck.brake || radarCheck.brake ||
+                                                                occupancyGridCheck.brake);
+    if (brake && !mIsBraking) {
+        mIsBraking = true;
+        emit emergencyBrake();
+
+        const qint64 measurementTimestamp_ns = std::max({cameraCheck.measurementTimestamp_ns, tofCheck.measurementTimestamp_ns,
+                                                         lidarCheck.measurementTimestamp_ns, radarCheck.measurementTimestamp_ns,
+                                                         occupancyGridCheck.measurementTimestamp_ns});
+        const qint64 latency_ns = utcTime::now_ns() - measurementTimestamp_ns;
+        {
+            const std::lock_guard<std::mutex> lock(mLatencyMutex);
+            mLatency.last_ns = latency_ns;
+            mLatency.max_ns = std::max(mLatency.max_ns, latency_ns);
+            mLatency.brakeCommands++;
+            mLatency.mean_ns += (latency_ns - mLatency.mean_ns) / mLatency.brakeCommands;
+        }
+        emit brakeLatencyMeasured(latency_ns);
+    } else if (!brake && mIsBraking) {
+        mIsBraking = false;
+        emit emergencyBrakeReleased();
     }
 }
@@ -3,40 +3,139 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * Uses sensor inputs to take emergency brake decision
+ * Inputs are timestamped measurements: camera detections (vehicle frame: x forward, y left) that are associated with tracked
+ * objects (ObjectTracker), and forward range sensors (ToFSensor, lidar, radar) whose closing speed is estimated from consecutive ranges.
+ * The decision runs on a ControlLoop at a fixed rate (dedicated thread by default) on the latest inputs, extrapolated to the
+ * decision time, i.e., it does not depend on when inputs arrive.
+ * For every object ahead within the vehicle's corridor, the distance needed to stop relative to it is computed from the closing
+ * speed (vehicle speed for objects without velocity), the reaction time (decision period and brakeReactionTime) and the vehicle's
+ * deceleration limit (VehicleState::getMinAcceleration). Braking is triggered when it exceeds the distance minus safetyMargin,
+ * when the time to collision is below brakeForTimeToCollision, or for any object closer than brakeForObjectAtDistance.
+ * Sensors are fused conservatively (any sensor can trigger), inputs older than the sensor timeout are ignored.
+ * An OccupancyGrid (e.g., from OccupancyGridMapper) is checked for occupied cells in the corridor ahead of the vehicle's pose,
+ * as static objects.
+ * The latency from the timestamp of the triggering measurement to the brake command is measured for every brake command.
  */
 
 #ifndef EMERGENCYBRAKE_H
 #define EMERGENCYBRAKE_H
 
 #include <QObject>
-#include <QTimer>
+#include <QSharedPointer>
+#include <QVector>
+#include <QPointF>
+#include <array>
+#include <mutex>
 #include "core/pospoint.h"
+#include "core/objecttracker.h"
+#include "core/controlloop.h"
+#include "vehicles/vehiclestate.h"
+#include "sensors/tof/tofsensor.h"
+#include "core/occupancygrid.h"
 
 struct EmergencyBrakeState {
     bool brakeForDetectedCameraObject = false;
+    bool brakeForDetectedToFObject = false;
     bool brakeForDetectedLidarObject = false;
     bool brakeForDetectedRadarObject = false;
-    double brakeForObjectAtDistance = 10; // [m] brake when detected object comes closer than
+    bool brakeForOccupiedCell = false;
+    double brakeForObjectAtDistance = 0.3; // [m] brake when detected object comes closer than, independent of speed
+    double brakeForTimeToCollision = 0.5; // [s] brake when detected object in corridor would be hit sooner than
+    double corridorHalfWidth = 1.0; // [m] lateral distance from vehicle center line that is checked for collisions
+    double safetyMargin = 0.5; // [m] distance to keep to objects when stopped ahead of them
+    double brakeReactionTime = 0.1; // [s] brake command to deceleration, added to the decision period
+    double defaultDeceleration = 3.0; // [m/s²] used if the VehicleState has no deceleration limit
     bool emergencyBrakeIsActive = false;
 };
 
+// Detection timestamp to brake command [ns]
+struct EmergencyBrakeLatency {
+    qint64 last_ns = 0;
+    qint64 max_ns = 0;
+    double mean_ns = 0.0;
+    int brakeCommands = 0;
+};
+
 class EmergencyBrake : public QObject
 {
     Q_OBJECT
 public:
+    enum class RangeSensor {ToF, Lidar, Radar};
+
     explicit EmergencyBrake(QObject *parent = nullptr);
+    ~EmergencyBrake();
+
+    void setVehicleState(QSharedPointer<VehicleState> vehicleState); // speed (and deceleration limit) for the stopping distance
+    void setToFSensor(QSharedPointer<ToFSensor> tofSensor); // forward-facing, uses ToFSensor::updatedRange
+    void setOccupancyGrid(QSharedPointer<const OccupancyGrid> occupancyGrid, PosType posType = PosType::fused); // needs the VehicleState
+    EmergencyBrakeLatency getLatency() const;
+    // Copy of the tracked camera objects, vehicle frame
+    QVector<TrackedObject> getTrackedObjects() const;
+    EmergencyBrakeState getState();
+    void setState(const EmergencyBrakeState &state); // parameters, the brake flags are the decision's output
+    bool isBraking() const { return mIsBraking; }
+
+    // Rate and mode of the decision
+    ControlLoop &getDecisionLoop() { return mDecisionLoop; }
+
+    static constexpr double ASSOCIATION_GATE_m = 1.0;
+    static constexpr qint64 TRACK_TIMEOUT_ns = 500 * utcTime::NS_PER_MS; // also for range sensors
+    static constexpr unsigned DEFAULT_DECISION_PERIOD_ms = 10;
+    static constexpr double TOF_MAX_RANGE_m = 2.0; // VL53L0X, larger values mean out of range
 
 signals:
-    void emergencyBrake();
+    void emergencyBrake(); // emitted from the decision loop, when braking starts
+    void emergencyBrakeReleased(); // no sensor triggers braking anymore
+    void brakeLatencyMeasured(qint64 latency_ns);
 
 public slots:
     void deactivateEmergencyBrake();
     void activateEmergencyBrake();
-    void brakeForDetectedCameraObject(const PosPoint &detectedObject);
+    void brakeForDetectedCameraObject(const PosPoint &detectedObject); // zero position: no object
+    void brakeForDetectedCameraObjects(const QVector<PosPoint> &detectedObjects); // all objects of one camera frame
+    // Range to the closest object ahead, <= 0 or beyond maxRange_m: no object
+    void updateRangeMeasurement(EmergencyBrake::RangeSensor sensor, double distance_m, qint64 timestamp_ns, double maxRange_m = std::numeric_limits<double>::max());
 
 private:
+    struct RangeMeasurement {
+        double distance_m = 0.0;
+        double closingSpeed = 0.0; // [m/s]
+        bool hasClosingSpeed = false;
+        bool hasObject = false;
+        qint64 timestamp_ns = utcTime::INVALID;
+    };
+
+    struct BrakeCheck {
+        bool brake = false;
+        qint64 measurementTimestamp_ns = utcTime::INVALID;
+    };
+
+    void updateTrackedObjects(const PosPoint *detectedObjects, int numDetectedObjects, qint64 timestamp_ns);
+    // Decision loop
+    void takeBrakeDecision();
+    bool needsToBrake(double distance_m, double lateralOffset_m, double closingSpeed) const;
+    BrakeCheck checkCameraObjects(qint64 now_ns) const;
+    BrakeCheck checkRangeMeasurement(const RangeMeasurement &measurement, qint64 now_ns) const;
+    BrakeCheck checkOccupancyGrid() const;
+
+    // Inputs and parameters are shared with the decision loop, guarded by its iteration mutex
     EmergencyBrakeState mCurrentState;
-    void fuseSensorsAndTakeBrakeDecision();
+    ObjectTracker mObjectTracker;
+    std::array<RangeMeasurement, 3> mRangeMeasurements; // by RangeSensor
+    QSharedPointer<VehicleState> mVehicleState;
+    QSharedPointer<ToFSensor> mToFSensor;
+    QSharedPointer<const OccupancyGrid> mOccupancyGrid;
+    PosType mOccupancyGridPosType = PosType::fused;
+    double mVehicleSpeed = 0.0; // [m/s] of the current decision
+    double mDeceleration = 0.0; // [m/s²] of the current decision
+    std::atomic<bool> mIsBraking{false};
+
+    mutable std::mutex mTrackedObjectsMutex;
+    QVector<TrackedObject> mTrackedObjects; // copy for getTrackedObjects()
+    mutable std::mutex mLatencyMutex;
+    EmergencyBrakeLatency mLatency;
+
+    ControlLoop mDecisionLoop{[this](){ takeBrakeDecision(); }, DEFAULT_DECISION_PERIOD_ms};
 };
 
 #endif // EMERGENCYBRAKE_H
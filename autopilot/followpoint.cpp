@@ -24,7 +24,7 @@ FollowPoint::FollowPoint(QSharedPointer<VehicleConnection> vehicleConnection, Po
 
     // Lower frequency for remote connection
     mFollowPointTimeout_ms = 3000;
-    mUpdateStatePeriod_ms = 1000;
+    mControlLoop.setPeriod_us(1000000);
 
     initializeTimers();
 }
@@ -38,17 +38,17 @@ void FollowPoint::provideParametersToParameterServer()
         ParameterServer::getInstance()->provideFloatParameter("FP"+id+"_MAX_DIST", std::bind(&FollowPoint::setFollowPointMaximumDistance, this, std::placeholders::_1), std::bind(&FollowPoint::getFollowPointMaximumDistance, this));
         ParameterServer::getInstance()->provideFloatParameter("FP"+id+"_HEIGHT", std::bind(&FollowPoint::setFollowPointHeight, this, std::placeholders::_1), std::bind(&FollowPoint::getFollowPointHeight, this));
         ParameterServer::getInstance()->provideFloatParameter("FP"+id+"_ANGLE_DEG", std::bind(&FollowPoint::setFollowPointAngleInDeg, this, std::placeholders::_1), std::bind(&FollowPoint::getFollowPointAngleInDeg, this));
+        ParameterServer::getInstance()->provideIntParameter("FP"+id+"_PRED_MS", std::bind(&FollowPoint::setMaxPredictionTime, this, std::placeholders::_1), std::bind(&FollowPoint::getMaxPredictionTime, this));
+        mControlLoop.provideParametersToParameterServer("FP"+id+"_CTRL");
     }
 }
 
 void FollowPoint::initializeTimers()
 {
-    connect(&mUpdateStateTimer, &QTimer::timeout, this, &FollowPoint::updateState);
-
     // Follow point requires continuous updates of the point to follow
     mFollowPointTimedOut = true;
     FollowPoint::mFollowPointHeartbeatTimer.setSingleShot(true);
-    connect(&mFollowPointHeartbeatTimer, &QTimer::timeout, this, [&](){
+    connect(&mFollowPointHeartbeatTimer, &ClockTimer::timeout, this, [&](){
         if ((mCurrentState.stmState == FollowPointSTMstates::FOLLOWING || mCurrentState.stmState == FollowPointSTMstates::WAITING) && this->isActive()) {
             qDebug() << "WARNING: Follow point timed out. Stopping FollowPoint.";
             this->stopFollowPoint();
@@ -57,24 +57,34 @@ void FollowPoint::initializeTimers()
     });
 }
 
+void FollowPoint::setClock(Clock *clock)
+{
+    mControlLoop.setClock(clock);
+    mFollowPointHeartbeatTimer.setClock(clock);
+}
+
 bool FollowPoint::isActive()
 {
-    return mUpdateStateTimer.isActive();
+    return mControlLoop.isActive();
 }
 
 void FollowPoint::startFollowPoint()
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     emit deactivateEmergencyBrake();
     mVehicleState->setAutopilotRadius(mCurrentState.autopilotRadius);
     mCurrentState.stmState = FollowPointSTMstates::FOLLOWING;
+    mPredictor.clear();
     mFollowPointHeartbeatTimer.start(mFollowPointTimeout_ms);
-    mUpdateStateTimer.start(mUpdateStatePeriod_ms);
+    mControlLoop.start();
 }
 
 void FollowPoint::stopFollowPoint()
 {
-    mUpdateStateTimer.stop();
-    mFollowPointHeartbeatTimer.stop();
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mControlLoop.stop();
+    // Can be called from the control thread, the timer needs to be stopped from its own thread
+    QMetaObject::invokeMethod(&mFollowPointHeartbeatTimer, "stop");
     mVehicleState->setAutopilotRadius(0);
     holdPosition();
     mCurrentState.stmState = FollowPointSTMstates::NONE;
@@ -93,35 +103,49 @@ void FollowPoint::holdPosition()
 
 void FollowPoint::updatePointToFollowInVehicleFrame(const PosPoint &point)
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     if (thePointIsNewResetTheTimer(point)) {
+        mFollowingEnuPoint = false;
         mCurrentState.currentPointToFollow = point;
         mCurrentState.currentPointToFollow.setRadius(mCurrentState.followPointDistance);
         mCurrentState.lineFromVehicleToPoint.setP1(QPointF(0,0));
         mCurrentState.lineFromVehicleToPoint.setP2(point.getPoint());
         mCurrentState.distanceToPointIn2D = mCurrentState.lineFromVehicleToPoint.length();
-        QVector<QPointF> intersections = geometry::findIntersectionsBetweenCircleAndLine(QPair<QPointF, double>(QPointF(0,0), mVehicleState->getAutopilotRadius()), mCurrentState.lineFromVehicleToPoint);
+        const geometry::CircleLineIntersections intersections = geometry::findCircleLineIntersections(QPointF(0,0), mVehicleState->getAutopilotRadius(), mCurrentState.lineFromVehicleToPoint);
         (intersections.size() != 0) ? mCurrentState.currentPointToFollow.setXY(intersections[0].x(), intersections[0].y()) : mCurrentState.currentPointToFollow.setXY(0, 0);
     }
 }
 
 void FollowPoint::updatePointToFollowInEnuFrame(const PosPoint &point)
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     if (thePointIsNewResetTheTimer(point)) {
-        mCurrentState.currentPointToFollow = point;
-        mCurrentState.currentPointToFollow.setRadius(mCurrentState.followPointDistance/10);
-        mCurrentState.currentPointToFollow.setHeight(point.getHeight() + mCurrentState.followPointHeight);
-        mCurrentState.currentPointToFollow.setXY(point.getX() + mCurrentState.followPointDistance*cos((point.getYaw() + mCurrentState.followPointAngleInDeg)* M_PI / 180.0), point.getY() + mCurrentState.followPointDistance*sin((point.getYaw() + mCurrentState.followPointAngleInDeg)* M_PI / 180.0));
+        Clock *clock = mControlLoop.getClock();
+        // On real time, the point's UTC timestamp tells how old it is (e.g., MAVLink latency)
+        const qint64 latency_us = (clock->isRealTime() && utcTime::isValid(point.getTimestamp_ns())) ? (utcTime::now_ns() - point.getTimestamp_ns()) / 1000 : 0;
+        mPredictor.addPoint(point, clock->now_us(), latency_us);
+        mFollowingEnuPoint = true;
 
-        mCurrentState.distanceToPointIn2D = mVehicleState->getPosition(mPosTypeUsed).getDistanceTo(mCurrentState.currentPointToFollow);
+        setPointToFollowFromEnuPoint(point);
     }
 }
 
+void FollowPoint::setPointToFollowFromEnuPoint(const PosPoint &point)
+{
+    mCurrentState.currentPointToFollow = point;
+    mCurrentState.currentPointToFollow.setRadius(mCurrentState.followPointDistance/10);
+    mCurrentState.currentPointToFollow.setHeight(point.getHeight() + mCurrentState.followPointHeight);
+    mCurrentState.currentPointToFollow.setXY(point.getX() + mCurrentState.followPointDistance*cos((point.getYaw() + mCurrentState.followPointAngleInDeg)* M_PI / 180.0), point.getY() + mCurrentState.followPointDistance*sin((point.getYaw() + mCurrentState.followPointAngleInDeg)* M_PI / 180.0));
+
+    mCurrentState.distanceToPointIn2D = mVehicleState->getPosition(mPosTypeUsed).getDistanceTo(mCurrentState.currentPointToFollow);
+}
+
 bool FollowPoint::thePointIsNewResetTheTimer(const PosPoint &point)
 {
-    static QTime oldPointTime = QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc());
+    static qint64 oldPointTime_ns = utcTime::now_ns();
 
     if ((mCurrentState.stmState == FollowPointSTMstates::FOLLOWING || mCurrentState.stmState == FollowPointSTMstates::WAITING) &&
-            (point.getTime() > oldPointTime)) {
+            (point.getTimestamp_ns() > oldPointTime_ns)) {
         if (mFollowPointTimedOut)
             qDebug() << "Follow Point: timeout reset.";
 
@@ -134,6 +158,12 @@ bool FollowPoint::thePointIsNewResetTheTimer(const PosPoint &point)
 
 void FollowPoint::updateState()
 {
+    if (mFollowingEnuPoint && mPredictionEnabled) {
+        PosPoint predictedPoint;
+        if (mPredictor.predict(mControlLoop.getClock()->now_us(), predictedPoint))
+            setPointToFollowFromEnuPoint(predictedPoint);
+    }
+
     switch (mCurrentState.stmState) {
     case FollowPointSTMstates::NONE:
         qDebug() << "WARNING: FollowPoint running uninitialized statemachine.";
@@ -226,3 +256,14 @@ double FollowPoint::getFollowPointAngleInDeg() const
 {
     return mCurrentState.followPointAngleInDeg;
 }
+
+void FollowPoint::setMaxPredictionTime(int maxPredictionTime_ms)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mPredictor.setMaxPredictionTime(maxPredictionTime_ms);
+}
+
+int FollowPoint::getMaxPredictionTime() const
+{
+    return mPredictor.getMaxPredictionTime();
+}
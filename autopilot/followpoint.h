@@ -3,17 +3,21 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * Follow a person or other vehicle when the point to follow is continously updated.
+ * Points in the ENU frame are extrapolated to the time of each control iteration (see FollowPointPredictor), so that
+ * low update rates of the point to follow neither cause lag nor jerky motion.
  */
 
 #ifndef FOLLOWPOINT_H
 #define FOLLOWPOINT_H
 
 #include <QObject>
-#include <QTimer>
+#include "core/clock.h"
 #include <QSharedPointer>
 #include <QPointF>
 #include <QLineF>
 #include "core/pospoint.h"
+#include "core/controlloop.h"
+#include "autopilot/followpointpredictor.h"
 #include "vehicles/controller/movementcontroller.h"
 #include "communication/vehicleconnections/vehicleconnection.h"
 
@@ -63,9 +67,16 @@ public:
     double getFollowPointHeight() const;
     void setFollowPointAngleInDeg(double angle);
     double getFollowPointAngleInDeg() const;
+    void setPredictionEnabled(bool enabled) { mPredictionEnabled = enabled; }
+    bool isPredictionEnabled() const { return mPredictionEnabled; }
+    void setMaxPredictionTime(int maxPredictionTime_ms);
+    int getMaxPredictionTime() const;
 
     void provideParametersToParameterServer();
 
+    ControlLoop &getControlLoop() { return mControlLoop; }
+    void setClock(Clock *clock); // control loop and follow point timeout, nullptr: real-time clock
+
 signals:
     void deactivateEmergencyBrake();
     void activateEmergencyBrake();
@@ -77,13 +88,14 @@ public slots:
 private:
     unsigned mFollowPointTimeout_ms = 1000;
     bool mFollowPointTimedOut = true;
-    unsigned mUpdateStatePeriod_ms = 50;
-    QTimer mFollowPointHeartbeatTimer;
-    QTimer mUpdateStateTimer;
+    ClockTimer mFollowPointHeartbeatTimer;
 
     PosType mPosTypeUsed = PosType::fused; // The type of position (Odom, GNSS, UWB, ...)
 
     FollowPointState mCurrentState;
+    FollowPointPredictor mPredictor;
+    bool mPredictionEnabled = true;
+    bool mFollowingEnuPoint = false;
 
     QSharedPointer<MovementController> mMovementController;
     QSharedPointer<VehicleConnection> mVehicleConnection;
@@ -92,7 +104,10 @@ private:
     void updateState();
     void holdPosition();
     bool thePointIsNewResetTheTimer(const PosPoint &point);
+    void setPointToFollowFromEnuPoint(const PosPoint &point);
     void initializeTimers();
+
+    ControlLoop mControlLoop{[this](){ updateState(); }, 50};
 };
 
 #endif // FOLLOWPOINT_H
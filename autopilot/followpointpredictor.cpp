@@ -0,0 +1,74 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "followpointpredictor.h"
+#include <algorithm>
+#include <cmath>
+
+void FollowPointPredictor::addPoint(const PosPoint &point, qint64 received_us, qint64 latency_us)
+{
+    const qint64 measured_us = received_us - std::clamp(latency_us, qint64(0), mMaxPredictionTime_us);
+    const qint64 timestamp_us = utcTime::isValid(point.getTimestamp_ns()) ? point.getTimestamp_ns() / 1000 : measured_us;
+    if (!mHistory.isEmpty() && timestamp_us <= mHistory.newest().timestamp)
+        return; // duplicate or out of order
+
+    mHistory.append(timestamp_us, {point, measured_us});
+}
+
+bool FollowPointPredictor::predict(qint64 time_us, PosPoint &predicted) const
+{
+    if (mHistory.isEmpty())
+        return false;
+
+    const auto &newest = mHistory.newest();
+    predicted = newest.sample.point;
+    const double dt_s = std::clamp(time_us - newest.sample.received_us, qint64(0), mMaxPredictionTime_us) / 1e6;
+
+    // Oldest sample within the window and one from its middle, speed and direction over two segments give the turn rate
+    const int oldestIndex = std::min(mHistory.lowerBound(newest.timestamp - ESTIMATION_WINDOW_us), mHistory.size() - 1);
+    if (mHistory.size() - oldestIndex < 2 || dt_s <= 0.0)
+        return true;
+    const int middleIndex = (oldestIndex + mHistory.size()) / 2;
+
+    const auto &oldest = mHistory.at(oldestIndex);
+    const double totalDt_s = (newest.timestamp - oldest.timestamp) / 1e6;
+    const QPointF totalMotion = newest.sample.point.getPoint() - oldest.sample.point.getPoint();
+    const double speed_ms = std::hypot(totalMotion.x(), totalMotion.y()) / totalDt_s;
+    if (speed_ms < MIN_SPEED_ms)
+        return true;
+
+    double direction_rad = std::atan2(totalMotion.y(), totalMotion.x());
+    double turnRate_rads = 0.0;
+    if (middleIndex > oldestIndex && middleIndex < mHistory.size() - 1) {
+        const auto &middle = mHistory.at(middleIndex);
+        const QPointF firstMotion = middle.sample.point.getPoint() - oldest.sample.point.getPoint();
+        const QPointF secondMotion = newest.sample.point.getPoint() - middle.sample.point.getPoint();
+        const double firstDirection_rad = std::atan2(firstMotion.y(), firstMotion.x());
+        const double secondDirection_rad = std::atan2(secondMotion.y(), secondMotion.x());
+        double directionChange_rad = secondDirection_rad - firstDirection_rad;
+        while (directionChange_rad < -M_PI) directionChange_rad += 2.0 * M_PI;
+        while (directionChange_rad > M_PI) directionChange_rad -= 2.0 * M_PI;
+
+        // Segment directions are at their middle times
+        const double dtMiddles_s = (newest.timestamp - oldest.timestamp) / 2e6;
+        turnRate_rads = std::clamp(directionChange_rad / dtMiddles_s, -MAX_TURN_RATE_rads, MAX_TURN_RATE_rads);
+        direction_rad = secondDirection_rad + turnRate_rads * (newest.timestamp - middle.timestamp) / 2e6; // at newest
+    }
+
+    double dx, dy;
+    if (std::fabs(turnRate_rads) < 1e-3) {
+        dx = speed_ms * dt_s * std::cos(direction_rad);
+        dy = speed_ms * dt_s * std::sin(direction_rad);
+    } else {
+        const double radius_m = speed_ms / turnRate_rads;
+        dx = radius_m * (std::sin(direction_rad + turnRate_rads * dt_s) - std::sin(direction_rad));
+        dy = radius_m * (std::cos(direction_rad) - std::cos(direction_rad + turnRate_rads * dt_s));
+    }
+
+    predicted.setXY(predicted.getX() + dx, predicted.getY() + dy);
+    predicted.setYaw(predicted.getYaw() + turnRate_rads * dt_s * 180.0 / M_PI);
+    if (utcTime::isValid(predicted.getTimestamp_ns()))
+        predicted.setTimestamp_ns(predicted.getTimestamp_ns() + qint64(dt_s * 1e9));
+    return true;
+}
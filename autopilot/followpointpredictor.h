@@ -0,0 +1,48 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Extrapolates a point to follow (e.g., a leader vehicle's position received at 5-10 Hz) to the time of a control iteration.
+ * Speed and turn rate are estimated from the recent history (constant turn rate and velocity model) and the point is moved
+ * along the resulting arc. Times are on the follower's clock (see Clock), the points' own timestamps are used to
+ * estimate the motion and, on a real-time clock, to account for their latency.
+ */
+
+#ifndef FOLLOWPOINTPREDICTOR_H
+#define FOLLOWPOINTPREDICTOR_H
+
+#include "core/pospoint.h"
+#include "core/timestampedhistory.h"
+
+class FollowPointPredictor
+{
+public:
+    static constexpr int HISTORY_SIZE = 16;
+    static constexpr qint64 ESTIMATION_WINDOW_us = 1000000; // samples used for speed and turn rate
+    static constexpr double MIN_SPEED_ms = 0.1; // slower points are not extrapolated
+    static constexpr double MAX_TURN_RATE_rads = 1.5;
+
+    // received_us: follower's clock when the point arrived, latency_us: age of the point when it arrived (if known)
+    void addPoint(const PosPoint &point, qint64 received_us, qint64 latency_us = 0);
+    void clear() { mHistory.clear(); }
+    bool isEmpty() const { return mHistory.isEmpty(); }
+
+    // Returns the newest point if its motion is unknown, false without points
+    bool predict(qint64 time_us, PosPoint &predicted) const;
+
+    // Extrapolation is limited, e.g., to the follow point timeout [ms]
+    int getMaxPredictionTime() const { return int(mMaxPredictionTime_us / 1000); }
+    void setMaxPredictionTime(int maxPredictionTime_ms) { mMaxPredictionTime_us = qint64(maxPredictionTime_ms) * 1000; }
+
+private:
+    struct Sample {
+        PosPoint point;
+        qint64 received_us; // minus latency, i.e., on the follower's clock when the point was measured
+    };
+
+    // Timestamps: the point's own if valid (same source, better spacing), otherwise reception
+    TimestampedHistory<Sample> mHistory{HISTORY_SIZE};
+    qint64 mMaxPredictionTime_us = 1000000;
+};
+
+#endif // FOLLOWPOINTPREDICTOR_H
@@ -4,11 +4,11 @@
  */
 
 #include "gotowaypointfollower.h"
+#include "autopilot/gotowaypointfollowerscheduler.h"
 
 GotoWaypointFollower::GotoWaypointFollower(QSharedPointer<VehicleConnection> vehicleConnection, PosType posTypeUsed)
 {
     mVehicleConnection = vehicleConnection;
-    connect(&mUpdateStateTimer, &QTimer::timeout, this, &GotoWaypointFollower::updateState);
     setPosTypeUsed(posTypeUsed);
 }
 
@@ -19,7 +19,9 @@ bool GotoWaypointFollower::getRepeatRoute() const
 
 void GotoWaypointFollower::setRepeatRoute(bool value)
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     mCurrentState.repeatRoute = value;
+    mRouteGeometry.setClosed(value);
 }
 
 const PosPoint GotoWaypointFollower::getCurrentGoal()
@@ -29,48 +31,110 @@ const PosPoint GotoWaypointFollower::getCurrentGoal()
 
 void GotoWaypointFollower::clearRoute()
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     mWaypointList.clear();
+    mRouteGeometry.clear();
+    routeChanged();
 }
 
 void GotoWaypointFollower::addWaypoint(const PosPoint &point)
 {
-    mWaypointList.append(point);
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mWaypointList.append(point.toPOD());
+    mRouteGeometry.appendPoint(point.getPoint());
+    routeChanged();
 }
 
 void GotoWaypointFollower::addRoute(const QList<PosPoint> &route)
 {
+    addRoutePOD(PosPoint::toPODList(route));
+}
+
+void GotoWaypointFollower::addRoutePOD(const QVector<pospoint_t> &route)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     mWaypointList.append(route);
+    mRouteGeometry.appendRoute(route);
+    routeChanged();
+}
+
+void GotoWaypointFollower::appendRoute(const QVector<pospoint_t> &route)
+{
+    // The state machine moves on to appended waypoints when the current one is reached
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mWaypointList.append(route);
+    mRouteGeometry.appendRoute(route);
+    routeChanged();
+}
+
+void GotoWaypointFollower::setRoutePOD(const QVector<pospoint_t> &route, int waypointIndex)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    stop();
+    mWaypointList = route;
+    mRouteGeometry.setRoute(mWaypointList);
+    routeChanged();
+
+    if (waypointIndex > 0 && waypointIndex < mWaypointList.size()) {
+        mCurrentState.currentWaypointIndex = waypointIndex;
+        mCurrentState.currentGoal = mWaypointList.at(waypointIndex);
+        if (mCurrentState.overrideAltitude > 0)
+            mCurrentState.currentGoal.setHeight(mCurrentState.overrideAltitude);
+        mCurrentState.stmState = GotoWayPointFollowerSTMstates::FOLLOW_ROUTE_GOTO;
+    } else {
+        mCurrentState.currentWaypointIndex = 0;
+        mCurrentState.stmState = GotoWayPointFollowerSTMstates::NONE;
+    }
+}
+
+int GotoWaypointFollower::getCurrentWaypointIndex()
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (mCurrentState.stmState == GotoWayPointFollowerSTMstates::FOLLOW_ROUTE_GOTO ||
+            mCurrentState.stmState == GotoWayPointFollowerSTMstates::FOLLOWING_ROUTE ||
+            mCurrentState.stmState == GotoWayPointFollowerSTMstates::FOLLOW_ROUTE_HOLD_POSITION)
+        return mCurrentState.currentWaypointIndex;
+    return 0;
 }
 
 void GotoWaypointFollower::startFollowingRoute(bool fromBeginning)
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+
     mCurrentState.overrideAltitude = mVehicleConnection->getVehicleState()->getPosition(mPosTypeUsed).getHeight(); // Remove this line in order to use route height
     qDebug() << "Note: WaypointFollower starts following route. Height info from route is ignored (staying at" << QString::number(mCurrentState.overrideAltitude, 'g', 2) << "m).";
 
-    if (fromBeginning || mCurrentState.stmState == GotoWayPointFollowerSTMstates::NONE) {
+    if (fromBeginning || mCurrentState.stmState == GotoWayPointFollowerSTMstates::NONE)
         mCurrentState.stmState = GotoWayPointFollowerSTMstates::FOLLOW_ROUTE_INIT;
-        mUpdateStateTimer.start(mUpdateStatePeriod_ms);
-    } else {
+    else
         mCurrentState.stmState = GotoWayPointFollowerSTMstates::FOLLOW_ROUTE_GOTO;
-        mUpdateStateTimer.start(mUpdateStatePeriod_ms);
-    }
+    mHasLastGoto = false; // the vehicle might have been moved meanwhile
+
+    if (mScheduler) {
+        mScheduledActive = true;
+        mScheduler->followerStarted();
+    } else
+        mControlLoop.start();
 }
 
 bool GotoWaypointFollower::isActive()
 {
-    return mUpdateStateTimer.isActive();
+    return mControlLoop.isActive() || mScheduledActive;
 }
 
 void GotoWaypointFollower::stop()
 {
-    mUpdateStateTimer.stop();
+    mControlLoop.stop();
+    mScheduledActive = false;
 
     holdPosition();
 }
 
 void GotoWaypointFollower::resetState()
 {
-    mUpdateStateTimer.stop();
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mControlLoop.stop();
+    mScheduledActive = false;
 
     mCurrentState.stmState = GotoWayPointFollowerSTMstates::NONE;
     mCurrentState.currentWaypointIndex = mWaypointList.size();
@@ -103,7 +167,40 @@ PosPoint GotoWaypointFollower::getCurrentVehiclePosition()
 
 void GotoWaypointFollower::holdPosition()
 {
-     mVehicleConnection->requestGotoENU({getCurrentVehiclePosition().getX(), getCurrentVehiclePosition().getY(), getCurrentVehiclePosition().getHeight()});
+     requestGoto({getCurrentVehiclePosition().getX(), getCurrentVehiclePosition().getY(), getCurrentVehiclePosition().getHeight()});
+}
+
+void GotoWaypointFollower::requestGoto(const xyz_t &xyz)
+{
+    if (mHasLastGoto && mLastGoto.x == xyz.x && mLastGoto.y == xyz.y && mLastGoto.z == xyz.z)
+        return;
+
+    mLastGoto = xyz;
+    mHasLastGoto = true;
+    if (mScheduler)
+        mScheduler->queueGoto(this, xyz);
+    else
+        sendGoto(xyz);
+}
+
+void GotoWaypointFollower::sendGoto(const xyz_t &xyz)
+{
+    mVehicleConnection->requestGotoENU(xyz);
+}
+
+void GotoWaypointFollower::setScheduler(GotoWaypointFollowerScheduler *scheduler)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mScheduler = scheduler;
+
+    if (mScheduler && mControlLoop.isActive()) {
+        mControlLoop.stop();
+        mScheduledActive = true;
+        mScheduler->followerStarted();
+    } else if (!mScheduler && mScheduledActive) {
+        mScheduledActive = false;
+        mControlLoop.start();
+    }
 }
 
 void GotoWaypointFollower::updateState()
@@ -127,7 +224,7 @@ void GotoWaypointFollower::updateState()
         break;
 
     case GotoWayPointFollowerSTMstates::FOLLOW_ROUTE_GOTO:
-            mVehicleConnection->requestGotoENU({mCurrentState.currentGoal.getX(), mCurrentState.currentGoal.getY(), mCurrentState.currentGoal.getHeight()});
+            requestGoto({mCurrentState.currentGoal.getX(), mCurrentState.currentGoal.getY(), mCurrentState.currentGoal.getHeight()});
             mCurrentState.stmState = GotoWayPointFollowerSTMstates::FOLLOWING_ROUTE;
         break;
 
@@ -156,7 +253,7 @@ void GotoWaypointFollower::updateState()
                     mCurrentState.stmState = GotoWayPointFollowerSTMstates::FOLLOW_ROUTE_FINISHED;
             }
         } else
-            mUpdateStateSumator+=mUpdateStatePeriod_ms;
+            mUpdateStateSumator+=mControlLoop.getPeriod_us()/1000;
         break;
 
     case GotoWayPointFollowerSTMstates::FOLLOW_ROUTE_FINISHED:
@@ -171,7 +268,22 @@ void GotoWaypointFollower::updateState()
     }
 }
 
+double GotoWaypointFollower::getArcLengthAtWaypoint(int index) const
+{
+    if (mRouteGeometry.isEmpty())
+        return 0.0;
+
+    return mRouteGeometry.getArcLength(qBound(0, index, mRouteGeometry.size() - 1));
+}
+
 QList<PosPoint> GotoWaypointFollower::getCurrentRoute()
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    return PosPoint::fromPODList(mWaypointList);
+}
+
+QVector<pospoint_t> GotoWaypointFollower::getCurrentRoutePOD()
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     return mWaypointList;
 }
@@ -9,9 +9,12 @@
 #define GOTOWAYPOINTFOLLOWER_H
 
 #include <QSharedPointer>
-#include <QTimer>
 #include "autopilot/waypointfollower.h"
 #include "communication/vehicleconnections/vehicleconnection.h"
+#include "core/controlloop.h"
+#include "core/routegeometry.h"
+
+class GotoWaypointFollowerScheduler;
 
 enum class GotoWayPointFollowerSTMstates {NONE, FOLLOW_ROUTE_INIT, FOLLOW_ROUTE_GOTO, FOLLOWING_ROUTE, FOLLOW_ROUTE_HOLD_POSITION, FOLLOW_ROUTE_FINISHED};
 struct GotoWayPointFollowerState {
@@ -39,7 +42,12 @@ public:
     virtual void clearRoute() override;
     virtual void addWaypoint(const PosPoint &point) override;
     virtual void addRoute(const QList<PosPoint>& route) override;
+    virtual void addRoutePOD(const QVector<pospoint_t> &route) override;
+    virtual void appendRoute(const QVector<pospoint_t> &route) override;
+    virtual void setRoutePOD(const QVector<pospoint_t> &route, int waypointIndex) override;
+    virtual int getCurrentWaypointIndex() override;
     virtual QList<PosPoint> getCurrentRoute() override;
+    virtual QVector<pospoint_t> getCurrentRoutePOD() override;
 
     virtual void startFollowingRoute(bool fromBeginning) override;
     virtual bool isActive() override;
@@ -52,19 +60,38 @@ public:
     double getWaypointProximity() const;
     void setWaypointProximity(double value);
 
+    // Arc length along the current route [m], from first waypoint to waypoint at index
+    double getArcLengthAtWaypoint(int index) const;
+    double getRouteLength() const { return mRouteGeometry.getLength(); }
+    const RouteGeometry &getRouteGeometry() const { return mRouteGeometry; } // of the current route, closed if it is repeated
+
+    ControlLoop &getControlLoop() { return mControlLoop; }
+    void setClock(Clock *clock) { mControlLoop.setClock(clock); } // nullptr: real-time clock
+
+    bool isScheduled() const { return mScheduler != nullptr; } // see GotoWaypointFollowerScheduler
+
 private:
+    friend class GotoWaypointFollowerScheduler;
     GotoWayPointFollowerState mCurrentState;
     PosType mPosTypeUsed = PosType::fused; // The type of position (Odom, GNSS, UWB, ...) that should be used for planning
     QSharedPointer<VehicleConnection> mVehicleConnection;
-    QList <PosPoint> mWaypointList;
-    unsigned mUpdateStatePeriod_ms = 200;
-    QTimer mUpdateStateTimer;
+    QVector<pospoint_t> mWaypointList;
+    RouteGeometry mRouteGeometry; // of mWaypointList
     unsigned mUpdateWaypointPeriod_ms = 5000;
     unsigned mUpdateStateSumator = 0;
+    GotoWaypointFollowerScheduler *mScheduler = nullptr; // runs updateState() instead of mControlLoop if set
+    bool mScheduledActive = false;
+    xyz_t mLastGoto;
+    bool mHasLastGoto = false;
 
     PosPoint getCurrentVehiclePosition();
     void holdPosition();
     void updateState();
+    void requestGoto(const xyz_t &xyz); // skipped if equal to the last one
+    void sendGoto(const xyz_t &xyz);
+    void setScheduler(GotoWaypointFollowerScheduler *scheduler);
+
+    ControlLoop mControlLoop{[this](){ updateState(); }, 200};
 };
 
 #endif // GOTOWAYPOINTFOLLOWER_H
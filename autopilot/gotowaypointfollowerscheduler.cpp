@@ -0,0 +1,106 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "gotowaypointfollowerscheduler.h"
+#include "autopilot/gotowaypointfollower.h"
+#include <algorithm>
+
+GotoWaypointFollowerScheduler::GotoWaypointFollowerScheduler(QObject *parent) : QObject(parent)
+{
+    mSendTimer.setSingleShot(true);
+    connect(&mSendTimer, &ClockTimer::timeout, this, &GotoWaypointFollowerScheduler::sendNextGoto);
+}
+
+GotoWaypointFollowerScheduler::~GotoWaypointFollowerScheduler()
+{
+    mControlLoop.stop();
+    for (const auto &follower : mFollowers)
+        follower->setScheduler(nullptr);
+}
+
+void GotoWaypointFollowerScheduler::addFollower(QSharedPointer<GotoWaypointFollower> follower)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (follower.isNull() || mFollowers.contains(follower))
+        return;
+
+    mFollowers.append(follower);
+    follower->getControlLoop().setPeriod_us(mControlLoop.getPeriod_us()); // for the timing of its state machine
+    follower->setScheduler(this);
+}
+
+void GotoWaypointFollowerScheduler::removeFollower(QSharedPointer<GotoWaypointFollower> follower)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (!mFollowers.removeOne(follower))
+        return;
+
+    follower->setScheduler(nullptr);
+    for (int i = mNextPendingGoto; i < mPendingGotos.size(); i++)
+        if (mPendingGotos[i].follower == follower.get())
+            mPendingGotos[i].follower = nullptr; // skipped when sending
+}
+
+void GotoWaypointFollowerScheduler::setClock(Clock *clock)
+{
+    mControlLoop.setClock(clock);
+    mSendTimer.setClock(clock);
+}
+
+void GotoWaypointFollowerScheduler::queueGoto(GotoWaypointFollower *follower, const xyz_t &xyz)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    for (int i = mNextPendingGoto; i < mPendingGotos.size(); i++)
+        if (mPendingGotos[i].follower == follower) {
+            mPendingGotos[i].xyz = xyz;
+            mNumGotosSuperseded++;
+            return;
+        }
+
+    mPendingGotos.append({follower, xyz});
+}
+
+void GotoWaypointFollowerScheduler::updateFollowers()
+{
+    // Gotos of the last tick that were not sent yet are sent first
+    const int previouslyPending = mPendingGotos.size() - mNextPendingGoto;
+
+    bool anyActive = false;
+    for (const auto &follower : mFollowers)
+        if (follower->isActive()) {
+            follower->getControlLoop().step();
+            anyActive = true;
+        }
+
+    const int numPending = mPendingGotos.size() - mNextPendingGoto;
+    if (numPending > 0 && (previouslyPending == 0 || !mSendTimer.isActive()))
+        sendNextGoto();
+
+    if (!anyActive && mPendingGotos.size() == mNextPendingGoto)
+        mControlLoop.stop();
+}
+
+void GotoWaypointFollowerScheduler::sendNextGoto()
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    while (mNextPendingGoto < mPendingGotos.size()) {
+        const PendingGoto pendingGoto = mPendingGotos.at(mNextPendingGoto++);
+        if (pendingGoto.follower == nullptr)
+            continue;
+
+        pendingGoto.follower->sendGoto(pendingGoto.xyz);
+        mNumGotosSent++;
+        break;
+    }
+
+    const int numPending = mPendingGotos.size() - mNextPendingGoto;
+    if (numPending == 0) {
+        mPendingGotos.clear();
+        mNextPendingGoto = 0;
+        return;
+    }
+
+    // The remaining ones are spread over one tick
+    mSendTimer.start(std::max(1, int(mControlLoop.getPeriod_us() / 1000 / (numPending + 1))));
+}
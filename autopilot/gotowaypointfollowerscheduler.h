@@ -0,0 +1,67 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Runs many GotoWaypointFollowers (e.g., one per drone of a swarm) from one control loop on the ground station:
+ * all active followers are evaluated in one pass per tick instead of by one timer each, and their goto commands are
+ * collected and sent spread over the tick instead of as a burst. A follower only sends a goto command when its target
+ * changes (next waypoint, hold position), a command superseded before it was sent is dropped.
+ */
+
+#ifndef GOTOWAYPOINTFOLLOWERSCHEDULER_H
+#define GOTOWAYPOINTFOLLOWERSCHEDULER_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QSharedPointer>
+#include "core/clock.h"
+#include "core/controlloop.h"
+#include "core/coordinatetransforms.h"
+
+class GotoWaypointFollower;
+
+class GotoWaypointFollowerScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr unsigned DEFAULT_PERIOD_MS = 200;
+
+    explicit GotoWaypointFollowerScheduler(QObject *parent = nullptr);
+    ~GotoWaypointFollowerScheduler();
+
+    // The follower's own control loop is no longer used, its iterations run on this scheduler
+    void addFollower(QSharedPointer<GotoWaypointFollower> follower);
+    void removeFollower(QSharedPointer<GotoWaypointFollower> follower);
+    int getNumFollowers() const { return mFollowers.size(); }
+
+    ControlLoop &getControlLoop() { return mControlLoop; }
+    void setClock(Clock *clock);
+
+    // Called by followers (from their iteration or on stop)
+    void queueGoto(GotoWaypointFollower *follower, const xyz_t &xyz);
+    void followerStarted() { if (!mControlLoop.isActive()) mControlLoop.start(); }
+
+    quint64 getNumGotosSent() const { return mNumGotosSent; }
+    quint64 getNumGotosSuperseded() const { return mNumGotosSuperseded; }
+
+private:
+    struct PendingGoto {
+        GotoWaypointFollower *follower;
+        xyz_t xyz;
+    };
+
+    void updateFollowers();
+    void sendNextGoto();
+
+    QList<QSharedPointer<GotoWaypointFollower>> mFollowers;
+    QVector<PendingGoto> mPendingGotos; // in the order queued, at most one per follower
+    int mNextPendingGoto = 0;
+    ClockTimer mSendTimer;
+    quint64 mNumGotosSent = 0;
+    quint64 mNumGotosSuperseded = 0;
+
+    ControlLoop mControlLoop{[this](){ updateFollowers(); }, DEFAULT_PERIOD_MS};
+};
+
+#endif // GOTOWAYPOINTFOLLOWERSCHEDULER_H
@@ -0,0 +1,112 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mpcwaypointfollower.h"
+#include "vehicles/carstate.h"
+#include "communication/parameterserver.h"
+#include <array>
+#include <cmath>
+
+namespace {
+typedef std::array<double, 3> Vector3;
+typedef std::array<Vector3, 3> Matrix3;
+}
+
+void MpcWaypointFollower::setMpcParameters(const MpcParameters &parameters)
+{
+    std::lock_guard<std::recursive_mutex> lock(getControlLoop().getIterationMutex());
+    mParameters = parameters;
+    mParameters.horizonSteps = qBound(1, mParameters.horizonSteps, MpcParameters::MAX_HORIZON_STEPS);
+    mParameters.horizonStep_s = std::max(mParameters.horizonStep_s, 0.001);
+}
+
+void MpcWaypointFollower::provideParametersToParameterServer()
+{
+    PurepursuitWaypointFollower::provideParametersToParameterServer();
+    if (ParameterServer::getInstance()) {
+        auto provideParameter = [this](const std::string &name, double MpcParameters::*parameter) {
+            ParameterServer::getInstance()->provideFloatParameter(name, [this, parameter](float value) {
+                MpcParameters parameters = getMpcParameters();
+                parameters.*parameter = value;
+                setMpcParameters(parameters);
+            }, [this, parameter]() { return float(getMpcParameters().*parameter); });
+        };
+        provideParameter("MPC_STEP", &MpcParameters::horizonStep_s);
+        provideParameter("MPC_W_LAT", &MpcParameters::lateralErrorWeight);
+        provideParameter("MPC_W_HDG", &MpcParameters::headingErrorWeight);
+        provideParameter("MPC_W_CRV", &MpcParameters::curvatureWeight);
+        provideParameter("MPC_W_DCRV", &MpcParameters::curvatureChangeWeight);
+    }
+}
+
+double MpcWaypointFollower::solve(const MpcParameters &parameters, double speed, double lateralError_m, double headingError_rad, double previousRelativeCurvature)
+{
+    // State z = [lateral error, heading error, relative curvature], input: change of relative curvature, per horizon step of distance d
+    const double d = std::max(fabs(speed), parameters.minSpeed) * parameters.horizonStep_s;
+    const Matrix3 A = {{{1.0, d, 0.0}, {0.0, 1.0, d}, {0.0, 0.0, 1.0}}};
+    const Vector3 B = {0.0, d, 1.0};
+    const Vector3 Q = {parameters.lateralErrorWeight, parameters.headingErrorWeight, parameters.curvatureWeight};
+    const double R = std::max(parameters.curvatureChangeWeight, 1e-9);
+
+    // Backward Riccati recursion from the end of the horizon, the last gain is the one of the first step
+    Matrix3 P = {};
+    for (int i = 0; i < 3; i++)
+        P[i][i] = Q[i];
+    Vector3 K = {};
+    const int horizonSteps = qBound(1, parameters.horizonSteps, MpcParameters::MAX_HORIZON_STEPS);
+    for (int step = 0; step < horizonSteps; step++) {
+        Matrix3 PA = {};
+        Vector3 PB = {};
+        for (int i = 0; i < 3; i++)
+            for (int k = 0; k < 3; k++) {
+                PB[i] += P[i][k] * B[k];
+                for (int j = 0; j < 3; j++)
+                    PA[i][j] += P[i][k] * A[k][j];
+            }
+
+        // P symmetric: B'PA = (PB)'A
+        Vector3 BPA = {};
+        double BPB = 0.0;
+        for (int k = 0; k < 3; k++) {
+            BPB += B[k] * PB[k];
+            for (int j = 0; j < 3; j++)
+                BPA[j] += PB[k] * A[k][j];
+        }
+        for (int j = 0; j < 3; j++)
+            K[j] = BPA[j] / (R + BPB);
+
+        // P = Q + A'PA - (A'PB) K, with A'PB = (B'PA)'
+        Matrix3 nextP = {};
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++) {
+                double value = (i == j) ? Q[i] : 0.0;
+                for (int k = 0; k < 3; k++)
+                    value += A[k][i] * PA[k][j];
+                nextP[i][j] = value - BPA[i] * K[j];
+            }
+        P = nextP;
+    }
+
+    const Vector3 z = {lateralError_m, headingError_rad, previousRelativeCurvature};
+    return previousRelativeCurvature - (K[0] * z[0] + K[1] * z[1] + K[2] * z[2]);
+}
+
+double MpcWaypointFollower::getSteeringCurvature(const PosPoint &goal)
+{
+    const QSharedPointer<CarState> carState = getVehicleState().dynamicCast<CarState>();
+    const PosPoint position = getVehicleState()->getPosition(getPosTypeUsed());
+    const RouteTrackingError trackingError = (carState && goal.getSpeed() >= 0.0)
+            ? getRouteTrackingError(position.getPoint(), position.getYaw() * M_PI / 180.0) : RouteTrackingError();
+    if (!trackingError.valid) {
+        mPreviousRelativeCurvature = 0.0;
+        return PurepursuitWaypointFollower::getSteeringCurvature(goal);
+    }
+
+    const double relativeCurvature = solve(mParameters, carState->getSpeed(), trackingError.lateralError_m, trackingError.headingError_rad, mPreviousRelativeCurvature);
+    const double maxCurvature = carState->getSteeringGeometryTable().getMaxCurvature();
+    const double curvature = qBound(-maxCurvature, trackingError.routeCurvature + relativeCurvature, maxCurvature);
+    mPreviousRelativeCurvature = curvature - trackingError.routeCurvature;
+
+    return -curvature; // steering curvature, negative: left
+}
@@ -0,0 +1,53 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Linear model-predictive lateral controller on the route state machine of PurepursuitWaypointFollower.
+ * Kinematic model of the rear axle linearized around the closest route segment: lateral error, heading error and the
+ * curvature relative to the route's curvature, with curvature changes as input. The quadratic cost over the horizon is
+ * minimized by a backward Riccati recursion on fixed-size 3x3 matrices, i.e., the solve time only depends on the number
+ * of horizon steps; the curvature limit of the vehicle is applied to the solution.
+ * On the vehicle and for car-like vehicles (CarState) while following the route forwards, pure pursuit otherwise.
+ */
+
+#ifndef MPCWAYPOINTFOLLOWER_H
+#define MPCWAYPOINTFOLLOWER_H
+
+#include "autopilot/purepursuitwaypointfollower.h"
+
+struct MpcParameters {
+    static constexpr int MAX_HORIZON_STEPS = 50;
+
+    int horizonSteps = 20;
+    double horizonStep_s = 0.1;
+    double lateralErrorWeight = 1.0; // per m²
+    double headingErrorWeight = 1.0; // per rad²
+    double curvatureWeight = 0.1; // curvature relative to the route, per (1/m)²
+    double curvatureChangeWeight = 1.0; // per (1/m)² between horizon steps
+    double minSpeed = 0.5; // [m/s], used by the model below, keeps the vehicle controllable at standstill
+};
+
+class MpcWaypointFollower : public PurepursuitWaypointFollower
+{
+    Q_OBJECT
+public:
+    MpcWaypointFollower(QSharedPointer<MovementController> movementController) : PurepursuitWaypointFollower(movementController) {}
+
+    MpcParameters getMpcParameters() const { return mParameters; }
+    void setMpcParameters(const MpcParameters &parameters);
+
+    virtual void provideParametersToParameterServer() override;
+
+    // One solve, independent of the vehicle: curvature (yaw change per distance, positive: left) to apply,
+    // relative to the route, for the given errors and previously applied relative curvature
+    static double solve(const MpcParameters &parameters, double speed, double lateralError_m, double headingError_rad, double previousRelativeCurvature);
+
+protected:
+    virtual double getSteeringCurvature(const PosPoint &goal) override;
+
+private:
+    MpcParameters mParameters;
+    double mPreviousRelativeCurvature = 0.0;
+};
+
+#endif // MPCWAYPOINTFOLLOWER_H
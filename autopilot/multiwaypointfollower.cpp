@@ -31,19 +31,58 @@ const PosPoint MultiWaypointFollower::getCurrentGoal()
 
 void MultiWaypointFollower::clearRoute()
 {
+    mActiveRouteID = -1;
     mWaypointFollowerList[mActiveWaypointFollowerID]->clearRoute();
 }
 
 void MultiWaypointFollower::addWaypoint(const PosPoint &point)
 {
+    mActiveRouteID = -1;
     mWaypointFollowerList[mActiveWaypointFollowerID]->addWaypoint(point);
 }
 
 void MultiWaypointFollower::addRoute(const QList<PosPoint> &route)
 {
+    mActiveRouteID = -1;
     mWaypointFollowerList[mActiveWaypointFollowerID]->addRoute(route);
 }
 
+void MultiWaypointFollower::addRoutePOD(const QVector<pospoint_t> &route)
+{
+    mActiveRouteID = -1;
+    mWaypointFollowerList[mActiveWaypointFollowerID]->addRoutePOD(route);
+}
+
+void MultiWaypointFollower::appendRoute(const QVector<pospoint_t> &route)
+{
+    mActiveRouteID = -1;
+    mWaypointFollowerList[mActiveWaypointFollowerID]->appendRoute(route);
+}
+
+void MultiWaypointFollower::patchRoute(const QVector<pospoint_t> &route, int firstChangedIndex)
+{
+    mActiveRouteID = -1;
+    mWaypointFollowerList[mActiveWaypointFollowerID]->patchRoute(route, firstChangedIndex);
+}
+
+void MultiWaypointFollower::insertWaypoints(int index, const QVector<pospoint_t> &waypoints)
+{
+    mActiveRouteID = -1;
+    mWaypointFollowerList[mActiveWaypointFollowerID]->insertWaypoints(index, waypoints);
+}
+
+void MultiWaypointFollower::replaceWaypoints(int index, const QVector<pospoint_t> &waypoints)
+{
+    mActiveRouteID = -1;
+    mWaypointFollowerList[mActiveWaypointFollowerID]->replaceWaypoints(index, waypoints);
+}
+
+void MultiWaypointFollower::removeWaypoints(int index, int count)
+{
+    mActiveRouteID = -1;
+    mWaypointFollowerList[mActiveWaypointFollowerID]->removeWaypoints(index, count);
+}
+
 void MultiWaypointFollower::startFollowingRoute(bool fromBeginning)
 {
     mWaypointFollowerList[mActiveWaypointFollowerID]->startFollowingRoute(fromBeginning);
@@ -136,9 +175,42 @@ void MultiWaypointFollower::provideParametersToParameterServer(int waypointfollo
 
 void MultiWaypointFollower::setActiveWaypointFollower(int waypointfollowerID)
 {
+    if (waypointfollowerID == mActiveWaypointFollowerID)
+        return;
+
+    // The new follower continues on the active route from the store
+    if (mActiveRouteID >= 0) {
+        saveActiveRouteProgress();
+        mWaypointFollowerList[waypointfollowerID]->setRoutePOD(mRouteStore.getRoute(mActiveRouteID), mRouteStore.getProgress(mActiveRouteID).waypointIndex);
+    }
     mActiveWaypointFollowerID = waypointfollowerID;
 }
 
+bool MultiWaypointFollower::setActiveRoute(int routeID)
+{
+    if (!mRouteStore.contains(routeID)) {
+        qDebug() << "WARNING: MultiWaypointFollower has no route with ID" << routeID;
+        return false;
+    }
+
+    const QSharedPointer<WaypointFollower> &waypointFollower = mWaypointFollowerList[mActiveWaypointFollowerID];
+    const bool wasActive = waypointFollower->isActive();
+    saveActiveRouteProgress();
+
+    waypointFollower->setRoutePOD(mRouteStore.getRoute(routeID), mRouteStore.getProgress(routeID).waypointIndex);
+    mActiveRouteID = routeID;
+
+    if (wasActive)
+        waypointFollower->startFollowingRoute(false);
+    return true;
+}
+
+void MultiWaypointFollower::saveActiveRouteProgress()
+{
+    if (mActiveRouteID >= 0)
+        mRouteStore.setProgress(mActiveRouteID, {mWaypointFollowerList[mActiveWaypointFollowerID]->getCurrentWaypointIndex()});
+}
+
 QSharedPointer<WaypointFollower> MultiWaypointFollower::getActiveWaypointFollower()
 {
     return mWaypointFollowerList[mActiveWaypointFollowerID];
@@ -158,3 +230,13 @@ QList<PosPoint> MultiWaypointFollower::getCurrentRoute()
 {
     return mWaypointFollowerList[mActiveWaypointFollowerID]->getCurrentRoute();
 }
+
+QVector<pospoint_t> MultiWaypointFollower::getCurrentRoutePOD()
+{
+    return mWaypointFollowerList[mActiveWaypointFollowerID]->getCurrentRoutePOD();
+}
+
+quint64 MultiWaypointFollower::getRouteVersion() const
+{
+    return (quint64(mActiveWaypointFollowerID) << 48) ^ mWaypointFollowerList[mActiveWaypointFollowerID]->getRouteVersion();
+}
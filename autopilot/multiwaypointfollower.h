@@ -2,7 +2,8 @@
  *     Copyright 2022 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
- * Holds multiple waypointfollowers to enable switching between routes.
+ * Holds multiple waypointfollowers to enable switching between routes or lateral controllers
+ * (e.g., PurepursuitWaypointFollower, StanleyWaypointFollower and MpcWaypointFollower on the same MovementController).
  */
 
 #ifndef MULTIWAYPOINTFOLLOWER_H
@@ -13,6 +14,7 @@
 #include <QSharedPointer>
 #include "autopilot/gotowaypointfollower.h"
 #include "autopilot/purepursuitwaypointfollower.h"
+#include "autopilot/routestore.h"
 
 class MultiWaypointFollower : public WaypointFollower
 {
@@ -28,7 +30,15 @@ public:
     virtual void clearRoute() override;
     virtual void addWaypoint(const PosPoint &point) override;
     virtual void addRoute(const QList<PosPoint>& route) override;
+    virtual void addRoutePOD(const QVector<pospoint_t> &route) override;
+    virtual void appendRoute(const QVector<pospoint_t> &route) override;
+    virtual void patchRoute(const QVector<pospoint_t> &route, int firstChangedIndex) override;
+    virtual void insertWaypoints(int index, const QVector<pospoint_t> &waypoints) override;
+    virtual void replaceWaypoints(int index, const QVector<pospoint_t> &waypoints) override;
+    virtual void removeWaypoints(int index, int count) override;
     virtual QList<PosPoint> getCurrentRoute() override;
+    virtual QVector<pospoint_t> getCurrentRoutePOD() override;
+    virtual quint64 getRouteVersion() const override; // of the active follower, switching followers changes it
 
     virtual void startFollowingRoute(bool fromBeginning) override;
     virtual bool isActive() override;
@@ -47,6 +57,12 @@ public:
     QSharedPointer<WaypointFollower> getActiveWaypointFollower();
     int getNumberOfWaypointFollowers();
 
+    // Alternative routes, shared by all waypoint followers. Switching saves the progress on the previous route and
+    // continues the new one where it was left (without copying it), an active follower is restarted on the new route.
+    RouteStore &getRouteStore() { return mRouteStore; }
+    bool setActiveRoute(int routeID);
+    int getActiveRoute() const { return mActiveRouteID; } // -1: route not from the store
+
     void provideParametersToParameterServer();
     void provideParametersToParameterServer(int waypointfollowerID);
 
@@ -60,6 +76,10 @@ private:
     QList<QSharedPointer<WaypointFollower>> mWaypointFollowerList;
 
     int mActiveWaypointFollowerID = 0;
+    RouteStore mRouteStore;
+    int mActiveRouteID = -1;
+
+    void saveActiveRouteProgress();
 };
 
 #endif // MULTIWAYPOINTFOLLOWER_H
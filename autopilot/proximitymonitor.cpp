@@ -0,0 +1,304 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "proximitymonitor.h"
+#include "core/tickarena.h"
+#include <QLineF>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace {
+typedef std::array<QPointF, 4> Footprint; // corners in ENU, counterclockwise
+
+struct FootprintExtent {
+    double rear, front, halfWidth; // [m] vehicle frame
+};
+
+FootprintExtent getFootprintExtent(const FleetStateStore::Columns &columns, int i, const ProximityMonitorParameters &parameters)
+{
+    if (columns.length.at(i) > 0.0 && columns.width.at(i) > 0.0)
+        return {columns.rearAxleToRearEnd.at(i), columns.rearAxleToRearEnd.at(i) + columns.length.at(i), columns.width.at(i) / 2.0};
+    const double halfSize = parameters.defaultFootprintSize_m / 2.0;
+    return {-halfSize, halfSize, halfSize};
+}
+
+// Constant speed and heading from the current position
+Footprint getPredictedFootprint(const FleetStateStore::Columns &columns, int i, const FootprintExtent &extent, double t_s)
+{
+    const double yaw_rad = columns.yaw_deg.at(i) * M_PI / 180.0;
+    const double cosYaw = cos(yaw_rad), sinYaw = sin(yaw_rad);
+    const double driven = columns.speed.at(i) * t_s;
+    const QPointF position(columns.x.at(i) + cosYaw * driven, columns.y.at(i) + sinYaw * driven);
+
+    const auto toENU = [&](double x, double y) { return position + QPointF(cosYaw * x - sinYaw * y, sinYaw * x + cosYaw * y); };
+    return {toENU(extent.rear, -extent.halfWidth), toENU(extent.front, -extent.halfWidth),
+            toENU(extent.front, extent.halfWidth), toENU(extent.rear, extent.halfWidth)};
+}
+
+// Separating axis test, the edge normals of both rectangles are the candidate axes
+bool footprintsOverlap(const Footprint &a, const Footprint &b)
+{
+    for (const Footprint *footprint : {&a, &b}) {
+        for (int edge = 0; edge < 2; edge++) {
+            const QPointF direction = footprint->at(edge + 1) - footprint->at(edge);
+            const QPointF axis(-direction.y(), direction.x());
+            double minA = std::numeric_limits<double>::infinity(), maxA = -minA, minB = minA, maxB = -minA;
+            for (int corner = 0; corner < 4; corner++) {
+                const double projectionA = QPointF::dotProduct(a.at(corner), axis);
+                const double projectionB = QPointF::dotProduct(b.at(corner), axis);
+                minA = std::min(minA, projectionA);
+                maxA = std::max(maxA, projectionA);
+                minB = std::min(minB, projectionB);
+                maxB = std::max(maxB, projectionB);
+            }
+            if (maxA < minB || maxB < minA)
+                return false;
+        }
+    }
+    return true;
+}
+
+double getPointToSegmentDistance(const QPointF &point, const QPointF &start, const QPointF &end)
+{
+    const QPointF segment = end - start;
+    const double lengthSq = QPointF::dotProduct(segment, segment);
+    const double t = lengthSq > 0.0 ? qBound(0.0, QPointF::dotProduct(point - start, segment) / lengthSq, 1.0) : 0.0;
+    return QLineF(point, start + t * segment).length();
+}
+
+double getFootprintDistance(const Footprint &a, const Footprint &b)
+{
+    if (footprintsOverlap(a, b))
+        return 0.0;
+
+    // Not overlapping: the closest points include a corner of one of the rectangles
+    double distance = std::numeric_limits<double>::infinity();
+    for (int corner = 0; corner < 4; corner++) {
+        for (int edge = 0; edge < 4; edge++) {
+            distance = std::min(distance, getPointToSegmentDistance(a.at(corner), b.at(edge), b.at((edge + 1) % 4)));
+            distance = std::min(distance, getPointToSegmentDistance(b.at(corner), a.at(edge), a.at((edge + 1) % 4)));
+        }
+    }
+    return distance;
+}
+
+quint64 getPairKey(ObjectState::ObjectID_t objectId1, ObjectState::ObjectID_t objectId2)
+{
+    return (quint64(quint32(objectId1)) << 32) | quint32(objectId2);
+}
+}
+
+ProximityMonitor::ProximityMonitor(QObject *parent)
+    : QObject{parent}
+{
+    qRegisterMetaType<ProximityWarning>();
+
+    mThreadContext = new QObject();
+    mCheckTimer = new QTimer(mThreadContext);
+    connect(mCheckTimer, &QTimer::timeout, mThreadContext, [this]() { check(); });
+    mThread.setObjectName("Proximity monitor");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start(QThread::HighPriority);
+}
+
+ProximityMonitor::~ProximityMonitor()
+{
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+}
+
+void ProximityMonitor::setFleetStateStore(QSharedPointer<FleetStateStore> fleetStateStore)
+{
+    QMetaObject::invokeMethod(mThreadContext, [this, fleetStateStore]() {
+        mFleetStateStore = fleetStateStore;
+    }, Qt::QueuedConnection);
+}
+
+void ProximityMonitor::setParameters(const ProximityMonitorParameters &parameters)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mParametersMutex);
+        mParameters = parameters;
+    }
+
+    QMetaObject::invokeMethod(mThreadContext, [this]() {
+        if (mCheckTimer->isActive())
+            startMonitoring();
+    }, Qt::QueuedConnection);
+}
+
+ProximityMonitorParameters ProximityMonitor::getParameters() const
+{
+    const std::lock_guard<std::mutex> lock(mParametersMutex);
+    return mParameters;
+}
+
+void ProximityMonitor::addAutopilot(ObjectState::ObjectID_t objectId, QSharedPointer<WaypointFollower> autopilot)
+{
+    QMetaObject::invokeMethod(mThreadContext, [this, objectId, autopilot]() {
+        mAutopilots.insert(objectId, autopilot);
+        mPausedObjects.remove(objectId);
+    }, Qt::QueuedConnection);
+}
+
+void ProximityMonitor::removeAutopilot(ObjectState::ObjectID_t objectId)
+{
+    QMetaObject::invokeMethod(mThreadContext, [this, objectId]() {
+        mAutopilots.remove(objectId);
+        mPausedObjects.remove(objectId);
+    }, Qt::QueuedConnection);
+}
+
+void ProximityMonitor::startMonitoring()
+{
+    const int interval_ms = qMax(1, int(1000.0 / qMax(getParameters().checkRate_Hz, 0.001)));
+    QMetaObject::invokeMethod(mCheckTimer, [this, interval_ms]() {
+        mCheckTimer->start(interval_ms);
+    }, Qt::QueuedConnection);
+}
+
+void ProximityMonitor::stopMonitoring()
+{
+    QMetaObject::invokeMethod(mCheckTimer, [this]() {
+        mCheckTimer->stop();
+    }, Qt::QueuedConnection);
+}
+
+QVector<ProximityWarning> ProximityMonitor::checkProximity(const FleetStateStore::Columns &columns, const ProximityMonitorParameters &parameters)
+{
+    TickArena::Scope arenaScope; // scratch memory of the check
+    QVector<ProximityWarning> warnings;
+    const int objectCount = columns.size();
+    const double horizon_s = qMax(parameters.predictionHorizon_s, 0.0);
+    const int predictionSteps = parameters.predictionStep_s > 0.0 ? int(ceil(horizon_s / parameters.predictionStep_s)) : 0;
+
+    // Broad phase: bounding boxes of the area reachable within the horizon, extended so that overlapping boxes can come within warningDistance
+    struct ReachableArea {
+        double minX, maxX, minY, maxY;
+    };
+    ArenaVector<FootprintExtent> extents(objectCount);
+    ArenaVector<ReachableArea> areas(objectCount);
+    for (int i = 0; i < objectCount; i++) {
+        extents[i] = getFootprintExtent(columns, i, parameters);
+        const FootprintExtent &extent = extents.at(i);
+        const double radius = std::hypot(std::max(fabs(extent.rear), fabs(extent.front)), extent.halfWidth) + parameters.warningDistance_m / 2.0;
+        const double yaw_rad = columns.yaw_deg.at(i) * M_PI / 180.0;
+        const double driven = columns.speed.at(i) * horizon_s;
+        const double endX = columns.x.at(i) + cos(yaw_rad) * driven;
+        const double endY = columns.y.at(i) + sin(yaw_rad) * driven;
+        areas[i] = {std::min(columns.x.at(i), endX) - radius, std::max(columns.x.at(i), endX) + radius,
+                    std::min(columns.y.at(i), endY) - radius, std::max(columns.y.at(i), endY) + radius};
+    }
+
+    // Sweep and prune along x
+    ArenaVector<int> order(objectCount);
+    for (int i = 0; i < objectCount; i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&areas](int a, int b) { return areas.at(a).minX < areas.at(b).minX; });
+
+    ArenaVector<int> active;
+    active.reserve(objectCount);
+    for (int i : order) {
+        active.erase(std::remove_if(active.begin(), active.end(), [&areas, i](int j) { return areas.at(j).maxX < areas.at(i).minX; }), active.end());
+        for (int j : active) {
+            if (areas.at(i).maxY < areas.at(j).minY || areas.at(j).maxY < areas.at(i).minY)
+                continue;
+
+            // Narrow phase: footprint distance at prediction steps, stopping at first contact
+            ProximityWarning warning;
+            warning.minPredictedDistance_m = std::numeric_limits<double>::infinity();
+            for (int step = 0; step <= predictionSteps; step++) {
+                const double t_s = std::min(step * parameters.predictionStep_s, horizon_s);
+                const double distance = getFootprintDistance(getPredictedFootprint(columns, i, extents.at(i), t_s),
+                                                             getPredictedFootprint(columns, j, extents.at(j), t_s));
+                if (step == 0)
+                    warning.distance_m = distance;
+                if (distance < warning.minPredictedDistance_m) {
+                    warning.minPredictedDistance_m = distance;
+                    warning.timeToMinDistance_s = t_s;
+                }
+                if (distance <= 0.0)
+                    break;
+            }
+
+            if (warning.minPredictedDistance_m >= parameters.warningDistance_m)
+                continue;
+
+            warning.objectId1 = std::min(columns.id.at(i), columns.id.at(j));
+            warning.objectId2 = std::max(columns.id.at(i), columns.id.at(j));
+            warning.level = warning.minPredictedDistance_m < parameters.criticalDistance_m ? ProximityWarning::Level::CRITICAL
+                                                                                           : ProximityWarning::Level::WARNING;
+            warning.timestamp_ns = utcTime::now_ns();
+            warnings.append(warning);
+        }
+        active.append(i);
+    }
+
+    return warnings;
+}
+
+void ProximityMonitor::check()
+{
+    if (!mFleetStateStore)
+        return;
+
+    const ProximityMonitorParameters parameters = getParameters();
+    // Snapshot (implicitly shared) instead of checking under the store's lock, writers are not blocked meanwhile
+    const QVector<ProximityWarning> warnings = checkProximity(mFleetStateStore->snapshot(), parameters);
+
+    QHash<quint64, ProximityWarning> activeWarnings;
+    QSet<ObjectState::ObjectID_t> criticalObjects;
+    for (const auto &warning : warnings) {
+        const quint64 key = getPairKey(warning.objectId1, warning.objectId2);
+        const auto previousWarning = mActiveWarnings.constFind(key);
+        if (previousWarning == mActiveWarnings.constEnd() || previousWarning->level != warning.level)
+            emit proximityWarning(warning);
+        activeWarnings.insert(key, warning);
+
+        if (warning.level == ProximityWarning::Level::CRITICAL) {
+            criticalObjects.insert(warning.objectId1);
+            criticalObjects.insert(warning.objectId2);
+        }
+    }
+    for (auto it = mActiveWarnings.constBegin(); it != mActiveWarnings.constEnd(); it++)
+        if (!activeWarnings.contains(it.key()))
+            emit proximityCleared(it->objectId1, it->objectId2);
+    mActiveWarnings = activeWarnings;
+
+    for (const auto objectId : criticalObjects) {
+        if (!mCriticalObjects.contains(objectId)) {
+            emit emergencyBrake(objectId);
+            setAutopilotPaused(objectId, true);
+        }
+    }
+    if (parameters.resumeAutopilots)
+        for (const auto objectId : mCriticalObjects)
+            if (!criticalObjects.contains(objectId))
+                setAutopilotPaused(objectId, false);
+    mCriticalObjects = criticalObjects;
+}
+
+void ProximityMonitor::setAutopilotPaused(ObjectState::ObjectID_t objectId, bool paused)
+{
+    const QSharedPointer<WaypointFollower> autopilot = mAutopilots.value(objectId);
+    if (!autopilot)
+        return;
+
+    // Autopilots are used from their own thread, only those that were active are resumed later
+    if (paused) {
+        QMetaObject::invokeMethod(autopilot.get(), [this, autopilot, objectId]() {
+            if (!autopilot->isActive())
+                return;
+            autopilot->stop();
+            QMetaObject::invokeMethod(mThreadContext, [this, objectId]() { mPausedObjects.insert(objectId); }, Qt::QueuedConnection);
+        }, Qt::QueuedConnection);
+    } else if (mPausedObjects.remove(objectId)) {
+        QMetaObject::invokeMethod(autopilot.get(), [autopilot]() {
+            autopilot->startFollowingRoute(false);
+        }, Qt::QueuedConnection);
+    }
+}
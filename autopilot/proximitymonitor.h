@@ -0,0 +1,93 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Separation monitoring between all objects of a FleetStateStore (e.g., MapWidget::getFleetStateStore), on a separate thread at a fixed rate.
+ * Broad phase: sweep and prune over the areas the objects can reach within the prediction horizon.
+ * Narrow phase: distance between the footprints (as CarState::getBoundingBox, a square for objects without one) along trajectories
+ * predicted with constant speed and heading. Pairs closer than warningDistance now or within the horizon are reported,
+ * below criticalDistance also as emergencyBrake for both objects, which pauses (stops) their registered autopilots.
+ */
+
+#ifndef PROXIMITYMONITOR_H
+#define PROXIMITYMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QThread>
+#include <QSharedPointer>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <mutex>
+#include "vehicles/fleetstatestore.h"
+#include "autopilot/waypointfollower.h"
+
+struct ProximityMonitorParameters {
+    double checkRate_Hz = 20.0;
+    double warningDistance_m = 2.0; // footprint to footprint
+    double criticalDistance_m = 0.5;
+    double predictionHorizon_s = 3.0;
+    double predictionStep_s = 0.1;
+    double defaultFootprintSize_m = 0.5; // objects without length and width
+    bool resumeAutopilots = false; // restart paused autopilots when they are no longer in a critical pair
+};
+
+struct ProximityWarning {
+    enum class Level {WARNING, CRITICAL};
+
+    ObjectState::ObjectID_t objectId1 = -1; // objectId1 < objectId2
+    ObjectState::ObjectID_t objectId2 = -1;
+    Level level = Level::WARNING;
+    double distance_m = 0.0; // now
+    double minPredictedDistance_m = 0.0; // within the prediction horizon
+    double timeToMinDistance_s = 0.0;
+    qint64 timestamp_ns = utcTime::INVALID;
+};
+Q_DECLARE_METATYPE(ProximityWarning)
+
+class ProximityMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProximityMonitor(QObject *parent = nullptr);
+    ~ProximityMonitor();
+
+    void setFleetStateStore(QSharedPointer<FleetStateStore> fleetStateStore);
+    void setParameters(const ProximityMonitorParameters &parameters);
+    ProximityMonitorParameters getParameters() const;
+    void addAutopilot(ObjectState::ObjectID_t objectId, QSharedPointer<WaypointFollower> autopilot);
+    void removeAutopilot(ObjectState::ObjectID_t objectId);
+
+    // One check of the given state, independent of the monitoring thread
+    static QVector<ProximityWarning> checkProximity(const FleetStateStore::Columns &columns, const ProximityMonitorParameters &parameters);
+
+signals:
+    // Emitted from the monitoring thread
+    void proximityWarning(const ProximityWarning &warning); // new pair or changed level
+    void proximityCleared(ObjectState::ObjectID_t objectId1, ObjectState::ObjectID_t objectId2);
+    void emergencyBrake(ObjectState::ObjectID_t objectId); // object is in a critical pair, once when it enters one
+
+public slots:
+    void startMonitoring();
+    void stopMonitoring();
+
+private:
+    // Monitoring thread
+    void check();
+    void setAutopilotPaused(ObjectState::ObjectID_t objectId, bool paused);
+
+    QThread mThread;
+    QObject *mThreadContext;
+    QTimer *mCheckTimer; // lives in mThread
+    QSharedPointer<FleetStateStore> mFleetStateStore; // monitoring thread
+    mutable std::mutex mParametersMutex;
+    ProximityMonitorParameters mParameters;
+    QHash<quint64, ProximityWarning> mActiveWarnings; // monitoring thread, by pair
+    QMap<ObjectState::ObjectID_t, QSharedPointer<WaypointFollower>> mAutopilots; // monitoring thread
+    QSet<ObjectState::ObjectID_t> mCriticalObjects; // monitoring thread
+    QSet<ObjectState::ObjectID_t> mPausedObjects; // monitoring thread
+};
+
+#endif // PROXIMITYMONITOR_H
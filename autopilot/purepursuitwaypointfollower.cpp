@@ -2,74 +2,115 @@
  *     Copyright 2021 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
+#include <algorithm>
 #include <cmath>
+#include <chrono>
+#include <limits>
 #include <QDebug>
 #include <QLineF>
 #include "purepursuitwaypointfollower.h"
 #include "communication/parameterserver.h"
 #include "core/geometry.h"
+#include "core/perfcounters.h"
+#include "core/allocationtracker.h"
+
+namespace {
+constexpr ParameterDescriptor<float> PP_RADIUS{"PP_RADIUS"};
+constexpr ParameterDescriptor<float> PP_ARC{"PP_ARC"};
+}
 
 PurepursuitWaypointFollower::PurepursuitWaypointFollower(QSharedPointer<MovementController> movementController)
 {
     mMovementController = movementController;
     mVehicleState = mMovementController->getVehicleState();
-    connect(&mUpdateStateTimer, &QTimer::timeout, this, &PurepursuitWaypointFollower::updateState);
+    mAttributeTriggerScheduler.setMutex(&mControlLoop.getIterationMutex());
 }
 
 PurepursuitWaypointFollower::PurepursuitWaypointFollower(QSharedPointer<VehicleConnection> vehicleConnection, PosType posTypeUsed)
 {
     mVehicleConnection = vehicleConnection;
     mVehicleState = mVehicleConnection->getVehicleState();
-    connect(&mUpdateStateTimer, &QTimer::timeout, this, &PurepursuitWaypointFollower::updateState);
     setPosTypeUsed(posTypeUsed);
+    mAttributeTriggerScheduler.setMutex(&mControlLoop.getIterationMutex());
 }
 
 void PurepursuitWaypointFollower::provideParametersToParameterServer()
 {
     if (ParameterServer::getInstance()) {
-        ParameterServer::getInstance()->provideFloatParameter("PP_RADIUS", std::bind(&PurepursuitWaypointFollower::setPurePursuitRadius, this, std::placeholders::_1), std::bind(&PurepursuitWaypointFollower::getPurePursuitRadius, this));
-        ParameterServer::getInstance()->provideFloatParameter("PP_ARC", std::bind(&PurepursuitWaypointFollower::setAdaptivePurePursuitRadiusCoefficient, this, std::placeholders::_1), std::bind(&PurepursuitWaypointFollower::getAdaptivePurePursuitRadiusCoefficient, this));
+        ParameterServer::getInstance()->provideParameter<&PurepursuitWaypointFollower::setPurePursuitRadius, &PurepursuitWaypointFollower::getPurePursuitRadius>(PP_RADIUS, this);
+        ParameterServer::getInstance()->provideParameter<&PurepursuitWaypointFollower::setAdaptivePurePursuitRadiusCoefficient, &PurepursuitWaypointFollower::getAdaptivePurePursuitRadiusCoefficient>(PP_ARC, this);
+        mControlLoop.provideParametersToParameterServer("PP_CTRL");
     }
 }
 
 void PurepursuitWaypointFollower::clearRoute()
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     stop();
     mWaypointList.clear();
+    mWaypointListIndex.clear();
+    mRouteGeometry.clear();
+    mSpeedProfile.clear();
+    mDirectionSegments.clear();
+    mRouteProjection = RouteProjection();
+    routeChanged();
 }
 
 void PurepursuitWaypointFollower::addWaypoint(const PosPoint &point)
 {
-    mWaypointList.append(point);
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mWaypointList.append(point.toPOD());
+    mWaypointListIndex.appendPoint(point.getPoint());
+    mRouteGeometry.appendPoint(point.getPoint());
+    updateSpeedProfile(mWaypointList.size() - 1);
+    updateDirectionSegments(mWaypointList.size() - 1);
+    routeChanged();
 }
 
 void PurepursuitWaypointFollower::addRoute(const QList<PosPoint> &route)
 {
-    if (route.isEmpty()) {
+    addRoutePOD(PosPoint::toPODList(route));
+}
+
+void PurepursuitWaypointFollower::addRoutePOD(const QVector<pospoint_t> &routePOD)
+{
+    if (routePOD.isEmpty()) {
         return;
     }
 
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    routeChanged();
+
     if (!isActive()) {
-        mWaypointList.append(route);
+        const int newRouteStartIndex = mWaypointList.size();
+        mWaypointList.append(routePOD);
+        mWaypointListIndex.appendRoute(routePOD);
+        mRouteGeometry.appendRoute(routePOD);
+        updateSpeedProfile(newRouteStartIndex);
+        updateDirectionSegments(newRouteStartIndex);
     } else {
         // Calculate closest point on new route to current vehicle position
-        QPointF currentVehiclePositionXY = mVehicleState->getPosition(mPosTypeUsed).getPoint();
-        if (mVehicleState->hasTrailingVehicle() && mVehicleState->getSpeed() < 0) // position defined by trailer when backing (if exists)
-            currentVehiclePositionXY = mVehicleState->getTrailingVehicle()->getPosition(mPosTypeUsed).getPoint();
-
-        int closestPointIndex = 0;
-        double minDistance = std::numeric_limits<double>::max();
-
-        for (int i = 0; i < route.size(); i++) {
-            double distance = QLineF(currentVehiclePositionXY, route[i].getPoint()).length();
-            if (distance < minDistance) {
-                minDistance = distance;
-                closestPointIndex = i;
-            }
+        const QPointF currentVehiclePositionXY = getVehiclePositionForDirection();
+
+        // Truncate the current route and append the new route, then cut the new route before its closest point
+        const int keptWaypoints = qBound(0, mCurrentState.currentWaypointIndex, mWaypointList.size());
+        mWaypointList.resize(keptWaypoints);
+        mWaypointListIndex.truncate(keptWaypoints);
+        mRouteGeometry.truncate(keptWaypoints);
+
+        const int newRouteStartIndex = mWaypointList.size();
+        mWaypointList.append(routePOD);
+        mWaypointListIndex.appendRoute(routePOD);
+
+        const int closestPointIndex = mWaypointListIndex.getClosestPointIndex(currentVehiclePositionXY, newRouteStartIndex);
+        if (closestPointIndex > newRouteStartIndex) {
+            mWaypointList.remove(newRouteStartIndex, closestPointIndex - newRouteStartIndex);
+            mWaypointListIndex.truncate(newRouteStartIndex);
+            mWaypointListIndex.appendRoute(routePOD.mid(closestPointIndex - newRouteStartIndex));
         }
-        // Truncate the current route and append the new route from closest point onwards
-        mWaypointList = mWaypointList.mid(0, mCurrentState.currentWaypointIndex);
-        mWaypointList.append(route.mid(closestPointIndex));
+        mRouteGeometry.appendRoute(mWaypointList.mid(newRouteStartIndex));
+        updateSpeedProfile(newRouteStartIndex);
+        updateDirectionSegments(newRouteStartIndex);
 
         // Update current waypoint index
         while (mCurrentState.currentWaypointIndex < mWaypointList.size()) {
@@ -87,8 +128,155 @@ void PurepursuitWaypointFollower::addRoute(const QList<PosPoint> &route)
     }
 }
 
+void PurepursuitWaypointFollower::appendRoute(const QVector<pospoint_t> &route)
+{
+    if (route.isEmpty())
+        return;
+
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    const int newRouteStartIndex = mWaypointList.size();
+    mWaypointList.append(route);
+    mWaypointListIndex.appendRoute(route);
+    mRouteGeometry.appendRoute(route);
+    updateSpeedProfile(newRouteStartIndex);
+    updateDirectionSegments(newRouteStartIndex);
+    routeChanged();
+
+    // The previous end goal is no longer the end of the route
+    if (mCurrentState.stmState == WayPointFollowerSTMstates::FOLLOW_ROUTE_APPROACHING_END_GOAL && mCurrentState.currentWaypointIndex == newRouteStartIndex - 1)
+        mCurrentState.stmState = WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING;
+}
+
+void PurepursuitWaypointFollower::setRoutePOD(const QVector<pospoint_t> &route, int waypointIndex)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    stop();
+    mWaypointList = route;
+    mWaypointListIndex.setRoute(mWaypointList);
+    mRouteGeometry.setRoute(mWaypointList);
+    mSpeedProfile.clear();
+    updateSpeedProfile(0);
+    updateDirectionSegments(0);
+    routeChanged();
+
+    if (waypointIndex > 0 && waypointIndex < mWaypointList.size()) {
+        mCurrentState.currentWaypointIndex = waypointIndex;
+        mCurrentState.currentGoal = mWaypointList.at(waypointIndex);
+        mCurrentState.stmState = WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING;
+    } else {
+        mCurrentState.currentWaypointIndex = 0;
+        mCurrentState.stmState = WayPointFollowerSTMstates::NONE;
+    }
+}
+
+void PurepursuitWaypointFollower::patchRoute(const QVector<pospoint_t> &route, int firstChangedIndex)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (route.isEmpty()) {
+        clearRoute();
+        return;
+    }
+
+    firstChangedIndex = qBound(0, firstChangedIndex, std::min(mWaypointList.size(), route.size()));
+    if (firstChangedIndex == route.size() && route.size() == mWaypointList.size())
+        return; // unchanged
+
+    // Only the changed part is copied and indexed again
+    mWaypointList.resize(route.size());
+    std::copy(route.cbegin() + firstChangedIndex, route.cend(), mWaypointList.begin() + firstChangedIndex);
+    updateRouteFrom(firstChangedIndex);
+}
+
+void PurepursuitWaypointFollower::insertWaypoints(int index, const QVector<pospoint_t> &waypoints)
+{
+    if (waypoints.isEmpty())
+        return;
+
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    index = qBound(0, index, mWaypointList.size());
+    mWaypointList.insert(index, waypoints.size(), pospoint_t());
+    std::copy(waypoints.cbegin(), waypoints.cend(), mWaypointList.begin() + index);
+
+    // Waypoints inserted behind the vehicle shift the current one, inserted at it they are driven to first
+    if (index < mCurrentState.currentWaypointIndex)
+        mCurrentState.currentWaypointIndex += waypoints.size();
+    updateRouteFrom(index);
+}
+
+void PurepursuitWaypointFollower::replaceWaypoints(int index, const QVector<pospoint_t> &waypoints)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (index < 0 || index >= mWaypointList.size() || waypoints.isEmpty())
+        return;
+
+    const int count = std::min(waypoints.size(), mWaypointList.size() - index);
+    std::copy(waypoints.cbegin(), waypoints.cbegin() + count, mWaypointList.begin() + index);
+    updateRouteFrom(index);
+}
+
+void PurepursuitWaypointFollower::removeWaypoints(int index, int count)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (index < 0 || index >= mWaypointList.size() || count <= 0)
+        return;
+
+    count = std::min(count, mWaypointList.size() - index);
+    if (count == mWaypointList.size()) {
+        clearRoute();
+        return;
+    }
+    mWaypointList.remove(index, count);
+
+    // Removing the current waypoint continues with the next remaining one
+    int &currentWaypointIndex = mCurrentState.currentWaypointIndex;
+    if (currentWaypointIndex >= index + count)
+        currentWaypointIndex -= count;
+    else if (currentWaypointIndex > index)
+        currentWaypointIndex = index;
+    updateRouteFrom(index);
+}
+
+QVector<pospoint_t> PurepursuitWaypointFollower::getCurrentRoutePOD()
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    return mWaypointList;
+}
+
+void PurepursuitWaypointFollower::updateRouteFrom(int firstChangedIndex)
+{
+    const QVector<pospoint_t> changedWaypoints = mWaypointList.mid(firstChangedIndex);
+    mWaypointListIndex.truncate(firstChangedIndex);
+    mWaypointListIndex.appendRoute(changedWaypoints);
+    mRouteGeometry.truncate(firstChangedIndex);
+    mRouteGeometry.appendRoute(changedWaypoints);
+    updateSpeedProfile(firstChangedIndex);
+    updateDirectionSegments(firstChangedIndex);
+    routeChanged();
+
+    // Progress is kept, the route may now end before the current waypoint or continue after the previous end goal
+    if (mCurrentState.currentWaypointIndex >= mWaypointList.size()) {
+        mCurrentState.currentWaypointIndex = mWaypointList.size() - 1;
+        if (mCurrentState.stmState == WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING)
+            mCurrentState.stmState = WayPointFollowerSTMstates::FOLLOW_ROUTE_APPROACHING_END_GOAL;
+    } else if (mCurrentState.stmState == WayPointFollowerSTMstates::FOLLOW_ROUTE_APPROACHING_END_GOAL &&
+               mCurrentState.currentWaypointIndex < mWaypointList.size() - 1) {
+        mCurrentState.stmState = WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING;
+    }
+}
+
+int PurepursuitWaypointFollower::getCurrentWaypointIndex()
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (mCurrentState.stmState == WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING ||
+            mCurrentState.stmState == WayPointFollowerSTMstates::FOLLOW_ROUTE_APPROACHING_END_GOAL)
+        return mCurrentState.currentWaypointIndex;
+    return 0;
+}
+
 void PurepursuitWaypointFollower::startFollowingRoute(bool fromBeginning)
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+
     // Activate emergency brake for follow route
     emit activateEmergencyBrake();
     mCurrentState.overrideAltitude = mVehicleState->getPosition(mPosTypeUsed).getHeight();
@@ -97,12 +285,12 @@ void PurepursuitWaypointFollower::startFollowingRoute(bool fromBeginning)
     if (fromBeginning || mCurrentState.stmState == WayPointFollowerSTMstates::NONE)
         mCurrentState.stmState = WayPointFollowerSTMstates::FOLLOW_ROUTE_INIT;
 
-    mUpdateStateTimer.start(mUpdateStatePeriod_ms);
+    mControlLoop.start();
 }
 
 bool PurepursuitWaypointFollower::isActive()
 {
-    return mUpdateStateTimer.isActive();
+    return mControlLoop.isActive();
 }
 
 void PurepursuitWaypointFollower::holdPosition()
@@ -117,9 +305,9 @@ void PurepursuitWaypointFollower::holdPosition()
 
 void PurepursuitWaypointFollower::stop()
 {
-    if (mUpdateStateTimer.isActive()) {
-        mUpdateStateTimer.stop();
-    }
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mControlLoop.stop();
+    mAttributeTriggerScheduler.cancel();
     mVehicleState->setAutopilotRadius(0);
     holdPosition();
     emit deactivateEmergencyBrake();
@@ -127,7 +315,8 @@ void PurepursuitWaypointFollower::stop()
 
 void PurepursuitWaypointFollower::resetState()
 {
-    mUpdateStateTimer.stop();
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mControlLoop.stop();
     mCurrentState.stmState = WayPointFollowerSTMstates::NONE;
     mCurrentState.currentWaypointIndex = mWaypointList.size();
     mCurrentState.startPointXY = QPointF();
@@ -135,9 +324,32 @@ void PurepursuitWaypointFollower::resetState()
 
 void PurepursuitWaypointFollower::updateState()
 {
-    QPointF currentVehiclePositionXY = mVehicleState->getPosition(mPosTypeUsed).getPoint();
-    if (mVehicleState->hasTrailingVehicle() && mVehicleState->getSpeed() < 0) // position defined by trailer when backing (if exists)
-        currentVehiclePositionXY = mVehicleState->getTrailingVehicle()->getPosition(mPosTypeUsed).getPoint();
+    static const int updateStateLatencyId = PerfCounters::getInstance().registerCounter("PP_UPDATE", PerfCounters::Type::Latency);
+    PerfCounters::ScopedLatency latency(updateStateLatencyId);
+    static const int allocationTag = AllocationTracker::getInstance().registerTag("PP");
+    AllocationTracker::ScopedTag tag(allocationTag);
+    const pospoint_t *waypointListData = mWaypointList.constData();
+    const int waypointListCapacity = mWaypointList.capacity();
+
+    updateStateMachine();
+
+    // Windowed around the previous projection, or the current waypoint after the route changed
+    const PosPoint vehiclePosition = mVehicleState->getPosition(mPosTypeUsed);
+    const int hintSegment = (mRouteProjection.valid && mRouteProjection.segmentIndex < mWaypointList.size() - 1)
+            ? mRouteProjection.segmentIndex : mCurrentState.currentWaypointIndex - 1;
+    mRouteProjection = routeProjection::project(mRouteGeometry, mWaypointListIndex, vehiclePosition.getPoint(),
+                                                vehiclePosition.getYaw() * M_PI / 180.0, std::max(hintSegment, 0));
+    if (isOnVehicle() && mAttributeTriggerScheduler.isEnabled() && mCurrentState.stmState == WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING)
+        updateAttributeTrigger();
+
+    if (mWaypointList.constData() != waypointListData || mWaypointList.capacity() != waypointListCapacity)
+        mUpdateStateAllocationCount++;
+}
+
+void PurepursuitWaypointFollower::updateStateMachine()
+{
+    updateCurrentDirectionSegment();
+    const QPointF currentVehiclePositionXY = getVehiclePositionForDirection();
 
     switch (mCurrentState.stmState) {
     case WayPointFollowerSTMstates::NONE:
@@ -160,7 +372,7 @@ void PurepursuitWaypointFollower::updateState()
 
         // draw straight line to first point and apply purePursuitRadius to find intersection
         QLineF carToStartLine(currentVehiclePositionXY, mWaypointList.at(0).getPoint());
-        QVector<QPointF> intersections = geometry::findIntersectionsBetweenCircleAndLine(QPair<QPointF, double>(currentVehiclePositionXY, purePursuitRadius()), carToStartLine);
+        const geometry::CircleLineIntersections intersections = geometry::findCircleLineIntersections(currentVehiclePositionXY, purePursuitRadius(), carToStartLine);
 
         if (intersections.size()) {
             mCurrentState.currentGoal.setXY(intersections[0].x(), intersections[0].y());
@@ -177,9 +389,18 @@ void PurepursuitWaypointFollower::updateState()
     case WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING: {
         calculateDistanceOfRouteLeft(currentVehiclePositionXY);
 
+        // The current direction segment ends at a cusp unless it is the last one
+        const bool endsAtCusp = mCurrentState.currentDirectionSegment < mDirectionSegments.size() - 1;
+        const int cuspIndex = mDirectionSegments.at(mCurrentState.currentDirectionSegment).lastIndex;
+
         QPointF currentWaypointPoint = mWaypointList.at(mCurrentState.currentWaypointIndex).getPoint();
-        if (QLineF(currentVehiclePositionXY, currentWaypointPoint).length() < purePursuitRadius()) // consider previous waypoint as reached
+        if (QLineF(currentVehiclePositionXY, currentWaypointPoint).length() < purePursuitRadius()) { // consider previous waypoint as reached
+            if (endsAtCusp && mCurrentState.currentWaypointIndex == cuspIndex) {
+                approachCusp(currentVehiclePositionXY);
+                break;
+            }
             mCurrentState.currentWaypointIndex++;
+        }
 
         if (mCurrentState.currentWaypointIndex == mWaypointList.size()) {
             mCurrentState.currentWaypointIndex--;
@@ -188,72 +409,33 @@ void PurepursuitWaypointFollower::updateState()
             // --- Calculate current goal on route (which lies between two waypoints)
             // 1. Find intersection between circle around vehicle and route
             // look a number of points ahead and jump forward on route, if applicable
-            // and take care of index wrap in case route is repeated
-            QList<PosPoint> lookAheadWaypoints;
-            if (mCurrentState.repeatRoute) {
-                lookAheadWaypoints = mWaypointList.mid(mCurrentState.currentWaypointIndex - 1, mCurrentState.numWaypointsLookahead);
-
-                const int lookaheadWaypointEndIndex = mCurrentState.currentWaypointIndex + mCurrentState.numWaypointsLookahead - 1;
-                if (lookaheadWaypointEndIndex > mWaypointList.size()) // index wraparound
-                    lookAheadWaypoints.append(mWaypointList.mid(0, lookaheadWaypointEndIndex % mWaypointList.size()));
-                else if (mCurrentState.currentWaypointIndex == 0) // restarting from end to beginning
-                    lookAheadWaypoints.prepend(mWaypointList.last());
-            } else
-                lookAheadWaypoints = mWaypointList.mid(mCurrentState.currentWaypointIndex - 1,  mCurrentState.numWaypointsLookahead);
-
-            QVector<QPointF> intersections;
-            for (int i = lookAheadWaypoints.size() - 1; i > 0; i--) { // step backwards through lookahead window until intersection is found
-                QPointF iWaypoint = lookAheadWaypoints.at(i).getPoint();
-                QLineF iLineSegment(lookAheadWaypoints.at(i-1).getPoint(), iWaypoint);
-
-                intersections = geometry::findIntersectionsBetweenCircleAndLine(QPair<QPointF, double>(currentVehiclePositionXY, purePursuitRadius()), iLineSegment);
-                if (intersections.size() > 0) {
-                    mCurrentState.currentWaypointIndex = (i + mCurrentState.currentWaypointIndex - 1) % mWaypointList.size();
-                    currentWaypointPoint = iWaypoint;
-                    break;
-                }
-            }
+            // and take care of index wrap in case route is repeated, but not beyond a cusp
+            const int numWaypointsLookahead = endsAtCusp ? std::min(mCurrentState.numWaypointsLookahead, cuspIndex - mCurrentState.currentWaypointIndex + 2)
+                                                         : mCurrentState.numWaypointsLookahead;
+            const LookaheadWindow lookAheadWaypoints(mWaypointList, mCurrentState.currentWaypointIndex - 1, numWaypointsLookahead, mCurrentState.repeatRoute);
 
-            // 2. Set Goal depending on number of intersections found
-            int previousWaypointIndex = mCurrentState.currentWaypointIndex - 1 >= 0 ? mCurrentState.currentWaypointIndex - 1 : mWaypointList.size() - 1;
-            switch (intersections.size()) {
-            case 0:
-                // We seem to have left the route (e.g., because of high speed), reuse previous goal to  get back to route
-                break;
-            case 1:
-                mCurrentState.currentGoal.setX(intersections[0].x());
-                mCurrentState.currentGoal.setY(intersections[0].y());
-                mCurrentState.currentGoal.setSpeed(getInterpolatedSpeed(mCurrentState.currentGoal, mWaypointList.at(previousWaypointIndex), mWaypointList.at(mCurrentState.currentWaypointIndex)));
+            const geometry::PolylineIntersection intersection = geometry::findFurthestCirclePolylineIntersection(currentVehiclePositionXY, purePursuitRadius(), lookAheadWaypoints.size(),
+                                                                                                                  [&lookAheadWaypoints](int i) { return lookAheadWaypoints.at(i).getPoint(); });
+            if (intersection.found)
+                mCurrentState.currentWaypointIndex = lookAheadWaypoints.routeIndex(intersection.segmentEndIndex);
 
-                break;
-            case 2:
-                // Take intersection closest to current waypoint (most progress)
-                if (QLineF(intersections[0], currentWaypointPoint).length()
-                        < QLineF(intersections[1], currentWaypointPoint).length()) {
-                    mCurrentState.currentGoal.setX(intersections[0].x());
-                    mCurrentState.currentGoal.setY(intersections[0].y());
-                    mCurrentState.currentGoal.setSpeed(getInterpolatedSpeed(mCurrentState.currentGoal, mWaypointList.at(previousWaypointIndex), mWaypointList.at(mCurrentState.currentWaypointIndex)));
-
-                }
-                else {
-                    mCurrentState.currentGoal.setX(intersections[1].x());
-                    mCurrentState.currentGoal.setY(intersections[1].y());
-                    mCurrentState.currentGoal.setSpeed(getInterpolatedSpeed(mCurrentState.currentGoal, mWaypointList.at(previousWaypointIndex), mWaypointList.at(mCurrentState.currentWaypointIndex)));
-
-                }
-                break;
-            default:
-                break;
-            }
+            // 2. Set Goal to intersection closest to current waypoint (most progress)
+            int previousWaypointIndex = mCurrentState.currentWaypointIndex - 1 >= 0 ? mCurrentState.currentWaypointIndex - 1 : mWaypointList.size() - 1;
+            if (intersection.found) {
+                mCurrentState.currentGoal.setX(intersection.point.x());
+                mCurrentState.currentGoal.setY(intersection.point.y());
+                mCurrentState.currentGoal.setSpeed(mSpeedProfileActive ? getProfileSpeed(intersection.point, previousWaypointIndex, mCurrentState.currentWaypointIndex)
+                                                                       : getInterpolatedSpeed(mCurrentState.currentGoal, mWaypointList.at(previousWaypointIndex), mWaypointList.at(mCurrentState.currentWaypointIndex)));
+            } // else: we seem to have left the route (e.g., because of high speed), reuse previous goal to get back to route
 
             // 3. Determine closest waypoint to vehicle, it determines attributes
-            PosPoint closestWaypoint;
+            const pospoint_t* closestWaypoint;
             if (QLineF(currentVehiclePositionXY, mWaypointList.at(previousWaypointIndex).getPoint()).length()
                     < QLineF(currentVehiclePositionXY, mWaypointList.at(mCurrentState.currentWaypointIndex).getPoint()).length())
-                closestWaypoint = mWaypointList.at(previousWaypointIndex);
+                closestWaypoint = &mWaypointList.at(previousWaypointIndex);
             else
-                closestWaypoint = mWaypointList.at(mCurrentState.currentWaypointIndex);
-            mCurrentState.currentGoal.setAttributes(closestWaypoint.getAttributes());
+                closestWaypoint = &mWaypointList.at(mCurrentState.currentWaypointIndex);
+            mCurrentState.currentGoal.setAttributes(closestWaypoint->attributes);
 
             // 4. Update control for current goal
             updateControl(mCurrentState.currentGoal);
@@ -262,7 +444,7 @@ void PurepursuitWaypointFollower::updateState()
     case WayPointFollowerSTMstates::FOLLOW_ROUTE_APPROACHING_END_GOAL: {
         QPointF vehicleAlignmentReferencePointXY = getVehicleAlignmentReferencePoint();
 
-        const PosPoint& endGoalPosPoint = mWaypointList.at(mCurrentState.currentWaypointIndex);
+        const pospoint_t& endGoalPosPoint = mWaypointList.at(mCurrentState.currentWaypointIndex);
         QPointF endGoalPointXY = endGoalPosPoint.getPoint();
         QLineF referencePointToEndGoalLine(vehicleAlignmentReferencePointXY, endGoalPointXY);
         double referencePointToEndGoalDistance = referencePointToEndGoalLine.length();
@@ -272,7 +454,7 @@ void PurepursuitWaypointFollower::updateState()
         QLineF lastWayPointToEndGoalLine;
         lastWayPointToEndGoalLine.setP2(endGoalPointXY);
         if (mCurrentState.currentWaypointIndex) {
-            lastWayPointToEndGoalLine.setP1(mWaypointList[mCurrentState.currentWaypointIndex - 1].getPoint());
+            lastWayPointToEndGoalLine.setP1(mWaypointList.at(mCurrentState.currentWaypointIndex - 1).getPoint());
         } else {
             lastWayPointToEndGoalLine.setP1(mCurrentState.startPointXY);
         }
@@ -304,7 +486,7 @@ void PurepursuitWaypointFollower::updateState()
             auto extendedGoalPoint = lastWayPointToEndGoalLine.pointAt(extensionRatio);
 
             mCurrentState.currentGoal.setXY(extendedGoalPoint.x(), extendedGoalPoint.y());
-            mCurrentState.currentGoal.setSpeed(endGoalPosPoint.getSpeed());
+            mCurrentState.currentGoal.setSpeed(mSpeedProfileActive ? getProfileSpeedAtWaypoint(mCurrentState.currentWaypointIndex) : endGoalPosPoint.speed);
             updateControl(mCurrentState.currentGoal);
         }
     } break;
@@ -320,12 +502,85 @@ void PurepursuitWaypointFollower::updateState()
     }
 }
 
+void PurepursuitWaypointFollower::approachCusp(const QPointF &currentVehiclePositionXY)
+{
+    const int cuspIndex = mCurrentState.currentWaypointIndex;
+    const pospoint_t &cusp = mWaypointList.at(cuspIndex);
+    const double heading_rad = mRouteGeometry.getSegmentHeading_rad(cuspIndex - 1);
+    const QPointF direction(cos(heading_rad), sin(heading_rad));
+    const double distanceToCusp = QLineF(currentVehiclePositionXY, cusp.getPoint()).length();
+
+    // Passed or close enough: stop, the next iteration follows the next direction segment
+    if (distanceToCusp < mEndGoalAlignmentThreshold || QPointF::dotProduct(currentVehiclePositionXY - cusp.getPoint(), direction) >= 0.0) {
+        mCurrentState.currentWaypointIndex++;
+        holdPosition();
+        return;
+    }
+
+    // Goal on the extension of the last route segment, as for the end goal
+    const double extensionDistance = std::max(purePursuitRadius() - distanceToCusp, 0.0);
+    mCurrentState.currentGoal.setXY(cusp.x + extensionDistance * direction.x(), cusp.y + extensionDistance * direction.y());
+    mCurrentState.currentGoal.setSpeed(mSpeedProfileActive ? getProfileSpeed(currentVehiclePositionXY, cuspIndex - 1, cuspIndex) : cusp.speed);
+    mCurrentState.currentGoal.setAttributes(cusp.attributes);
+    updateControl(mCurrentState.currentGoal);
+}
+
+void PurepursuitWaypointFollower::updateAttributeTrigger()
+{
+    const int segment = mRouteProjection.segmentIndex;
+    if (!mRouteProjection.valid || segment < 0 || segment + 1 >= mWaypointList.size())
+        return;
+
+    // Attributes change halfway between waypoints, i.e., where the closest waypoint changes
+    const auto getChangeProgress_m = [this](int segmentIndex) {
+        return mRouteGeometry.getArcLength(segmentIndex) + mRouteGeometry.getSegmentLength(segmentIndex) / 2.0;
+    };
+    const double progress_m = mRouteProjection.alongTrack_m;
+    const quint32 currentAttributes = mWaypointList.at(progress_m < getChangeProgress_m(segment) ? segment : segment + 1).attributes;
+
+    double changeProgress_m = -1.0;
+    quint32 nextAttributes = currentAttributes;
+    const int lastSegment = std::min(segment + mCurrentState.numWaypointsLookahead, mWaypointList.size() - 1);
+    for (int i = segment; i < lastSegment; i++) {
+        if (mWaypointList.at(i).attributes != mWaypointList.at(i + 1).attributes && getChangeProgress_m(i) > progress_m) {
+            changeProgress_m = getChangeProgress_m(i);
+            nextAttributes = mWaypointList.at(i + 1).attributes;
+            break;
+        }
+    }
+
+    mAttributeTriggerScheduler.update(progress_m, mVehicleState->getSpeed(), currentAttributes, changeProgress_m, nextAttributes, mControlLoop.getPeriod_us());
+}
+
+double PurepursuitWaypointFollower::getRouteProgressOfCurrentPose() const
+{
+    // Latest pose, i.e., between control iterations when triggered
+    const PosPoint vehiclePosition = mVehicleState->getPosition(mPosTypeUsed);
+    const RouteProjection projection = routeProjection::project(mRouteGeometry, mWaypointListIndex, vehiclePosition.getPoint(),
+                                                                vehiclePosition.getYaw() * M_PI / 180.0, mRouteProjection.segmentIndex);
+    return projection.valid ? projection.alongTrack_m : mRouteProjection.alongTrack_m;
+}
+
 void PurepursuitWaypointFollower::updateControl(const PosPoint &goal)
 {
     if (isOnVehicle()) {
-        mMovementController->setDesiredSteeringCurvature(mVehicleState->getCurvatureToPointInENU(goal.getPoint(), mPosTypeUsed));
-        mMovementController->setDesiredSpeed(goal.getSpeed());
-        mMovementController->setDesiredAttributes(goal.getAttributes());
+        const auto solveStart = std::chrono::steady_clock::now();
+        const double steeringCurvature = getSteeringCurvature(goal);
+        const double solveTime_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - solveStart).count();
+
+        LateralControlStatistics &statistics = mLateralControlStatistics;
+        statistics.iterations++;
+        statistics.lastSolveTime_us = solveTime_us;
+        statistics.maxSolveTime_us = std::max(statistics.maxSolveTime_us, solveTime_us);
+        statistics.meanSolveTime_us += (solveTime_us - statistics.meanSolveTime_us) / statistics.iterations;
+        statistics.solveTimeHistogram[ControlLoopStatistics::getHistogramBucket(solveTime_us)]++;
+
+        mMovementController->setDesiredSteeringCurvature(steeringCurvature);
+        mMovementController->setDesiredSpeed(getDesiredSpeed(goal));
+        if (!mAttributeTriggerScheduler.isEnabled())
+            mMovementController->setDesiredAttributes(goal.getAttributes());
+        else if (mCurrentState.stmState != WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING)
+            mAttributeTriggerScheduler.apply(goal.getAttributes()); // triggered by position while following, see updateAttributeTrigger()
 
         mVehicleState->setAutopilotTargetPoint(goal.getPoint());
     } else {
@@ -343,6 +598,74 @@ void PurepursuitWaypointFollower::updateControl(const PosPoint &goal)
     }
 }
 
+double PurepursuitWaypointFollower::getSteeringCurvature(const PosPoint &goal)
+{
+    return mVehicleState->getCurvatureToPointInENU(goal.getPoint(), mPosTypeUsed);
+}
+
+RouteTrackingError PurepursuitWaypointFollower::getRouteTrackingError(const QPointF &position, double yaw_rad) const
+{
+    RouteTrackingError trackingError;
+    if (mCurrentState.stmState != WayPointFollowerSTMstates::FOLLOW_ROUTE_FOLLOWING || mWaypointList.size() < 2)
+        return trackingError;
+
+    // Closest segment within the lookahead, starting at the segment the vehicle is on
+    const LookaheadWindow window(mWaypointList, mCurrentState.currentWaypointIndex - 1, mCurrentState.numWaypointsLookahead, mCurrentState.repeatRoute);
+    double minDistance = std::numeric_limits<double>::infinity();
+    int closestSegment = -1;
+    double closestSegmentRatio = 0.0;
+    // Segment i of the window starts at window point i, i.e., route segment routeIndex(i) (the closing segment when wrapping around)
+    for (int i = 0; i + 1 < window.size(); i++) {
+        const int segmentIndex = window.routeIndex(i);
+        const double segmentLength = mRouteGeometry.getSegmentLength(segmentIndex);
+        if (segmentLength < 1e-6)
+            continue;
+
+        const QPointF segmentStart = mRouteGeometry.getPoint(segmentIndex);
+        const double heading_rad = mRouteGeometry.getSegmentHeading_rad(segmentIndex);
+        const QPointF relative = position - segmentStart;
+        const double along = qBound(0.0, relative.x() * cos(heading_rad) + relative.y() * sin(heading_rad), segmentLength);
+        const double distance = QLineF(position, segmentStart + along * QPointF(cos(heading_rad), sin(heading_rad))).length();
+        if (distance < minDistance) {
+            minDistance = distance;
+            closestSegment = i;
+            closestSegmentRatio = along / segmentLength;
+        }
+    }
+    if (closestSegment < 0)
+        return trackingError;
+
+    const int segmentIndex = window.routeIndex(closestSegment);
+    const double routeHeading_rad = mRouteGeometry.getSegmentHeading_rad(segmentIndex);
+    const QPointF relative = position - mRouteGeometry.getPoint(segmentIndex);
+    trackingError.valid = true;
+    trackingError.segmentEndIndex = window.routeIndex(closestSegment + 1);
+    trackingError.lateralError_m = -relative.x() * sin(routeHeading_rad) + relative.y() * cos(routeHeading_rad);
+    trackingError.headingError_rad = remainder(yaw_rad - routeHeading_rad, 2.0 * M_PI);
+    trackingError.routeCurvature = (1.0 - closestSegmentRatio) * mRouteGeometry.getCurvature(segmentIndex)
+            + closestSegmentRatio * mRouteGeometry.getCurvature(trackingError.segmentEndIndex);
+
+    return trackingError;
+}
+
+RouteProjection PurepursuitWaypointFollower::getRouteProjection()
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    return mRouteProjection;
+}
+
+LateralControlStatistics PurepursuitWaypointFollower::getLateralControlStatistics()
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    return mLateralControlStatistics;
+}
+
+void PurepursuitWaypointFollower::resetLateralControlStatistics()
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mLateralControlStatistics = LateralControlStatistics();
+}
+
 PosType PurepursuitWaypointFollower::getPosTypeUsed() const
 {
     return mPosTypeUsed;
@@ -380,34 +703,188 @@ bool PurepursuitWaypointFollower::getRepeatRoute() const
 
 void PurepursuitWaypointFollower::setRepeatRoute(bool value)
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     mCurrentState.repeatRoute = value;
+    mRouteGeometry.setClosed(value);
 }
 
 const PosPoint PurepursuitWaypointFollower::getCurrentGoal()
 {
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
     return mCurrentState.currentGoal;
 }
 
-double PurepursuitWaypointFollower::getInterpolatedSpeed(const PosPoint &currentGoal, const PosPoint &lastWaypoint, const PosPoint &nextWaypoint)
+double PurepursuitWaypointFollower::getInterpolatedSpeed(const PosPoint &currentGoal, const pospoint_t &lastWaypoint, const pospoint_t &nextWaypoint)
 {
     // Linear interpolation
-    double distanceToNextWaypoint = currentGoal.getDistanceTo(nextWaypoint);
+    double distanceToNextWaypoint = QLineF(currentGoal.getPoint(), nextWaypoint.getPoint()).length();
     double distanceBetweenWaypoints = lastWaypoint.getDistanceTo(nextWaypoint);
     double x = distanceBetweenWaypoints - distanceToNextWaypoint;
 
-    return lastWaypoint.getSpeed() + (nextWaypoint.getSpeed()-lastWaypoint.getSpeed())*(x/distanceBetweenWaypoints);
+    return lastWaypoint.speed + (nextWaypoint.speed-lastWaypoint.speed)*(x/distanceBetweenWaypoints);
 }
 
 void PurepursuitWaypointFollower::calculateDistanceOfRouteLeft(const QPointF currentVehiclePositionXY)
 {
     double distance = QLineF(currentVehiclePositionXY, mWaypointList.at(mCurrentState.currentWaypointIndex).getPoint()).length();
 
-    for (int index = mCurrentState.currentWaypointIndex; index < mWaypointList.size()-1; index++) {
-        distance += QLineF(mWaypointList.at(index).getPoint(), mWaypointList.at(index+1).getPoint()).length();
-    }
+    distance += getRouteLength() - getArcLengthAtWaypoint(mCurrentState.currentWaypointIndex);
     emit distanceOfRouteLeft(distance);
 }
 
+void PurepursuitWaypointFollower::updateSpeedProfile(int fromIndex)
+{
+    const int size = mWaypointList.size();
+    mSpeedProfile.resize(size);
+    if (size == 0)
+        return;
+
+    // The curvature at the waypoint before fromIndex changes with the new waypoints
+    fromIndex = qBound(0, fromIndex - 1, size - 1);
+    const double maxAcceleration = std::max(mVehicleState->getMaxAcceleration(), 0.0);
+    const double maxDeceleration = std::max(-mVehicleState->getMinAcceleration(), 0.0);
+    auto segmentLength = [this](int index) { return mRouteGeometry.getSegmentLength(index); };
+
+    // Unsigned, a segment is driven in the direction of its end waypoint's speed
+    // 1. Speed limits: waypoint speed and v²·|curvature| <= max. lateral acceleration, stop where the driving direction changes
+    for (int i = fromIndex; i < size; i++) {
+        const pospoint_t &waypoint = mWaypointList.at(i);
+        double speedLimit = fabs(waypoint.speed);
+        if (i > 0 && i < size - 1) {
+            const double curvature = fabs(mRouteGeometry.getCurvature(i));
+            if (curvature > 0.0)
+                speedLimit = std::min(speedLimit, sqrt(mMaxLateralAcceleration / curvature));
+        }
+        if (i < size - 1 && (waypoint.speed < 0.0) != (mWaypointList.at(i + 1).speed < 0.0))
+            speedLimit = 0.0;
+        mSpeedProfile[i] = speedLimit;
+    }
+
+    // 2. Forward pass: acceleration limit, v² = v0² + 2·a·s
+    for (int i = std::max(fromIndex, 1); i < size; i++)
+        mSpeedProfile[i] = std::min(mSpeedProfile.at(i), sqrt(pow(mSpeedProfile.at(i - 1), 2) + 2.0 * maxAcceleration * segmentLength(i - 1)));
+
+    // 3. Backward pass: deceleration limit, reaches into the existing route only until the limit is no longer active
+    for (int i = size - 2; i >= 0; i--) {
+        const double reachableSpeed = sqrt(pow(mSpeedProfile.at(i + 1), 2) + 2.0 * maxDeceleration * segmentLength(i));
+        if (reachableSpeed >= mSpeedProfile.at(i)) {
+            if (i < fromIndex)
+                break;
+            continue;
+        }
+        mSpeedProfile[i] = reachableSpeed;
+    }
+}
+
+double PurepursuitWaypointFollower::getProfileSpeed(const QPointF &point, int previousWaypointIndex, int nextWaypointIndex) const
+{
+    // Constant acceleration between waypoints, i.e., v² is linear in distance
+    const pospoint_t &previousWaypoint = mWaypointList.at(previousWaypointIndex);
+    const pospoint_t &nextWaypoint = mWaypointList.at(nextWaypointIndex);
+    const double distanceBetweenWaypoints = previousWaypoint.getDistanceTo(nextWaypoint);
+    const double previousSpeed = mSpeedProfile.at(previousWaypointIndex);
+    const double nextSpeed = mSpeedProfile.at(nextWaypointIndex);
+    if (distanceBetweenWaypoints < 1e-6)
+        return nextSpeed;
+
+    const double ratio = qBound(0.0, 1.0 - QLineF(point, nextWaypoint.getPoint()).length() / distanceBetweenWaypoints, 1.0);
+    const double speed = sqrt(previousSpeed * previousSpeed + (nextSpeed * nextSpeed - previousSpeed * previousSpeed) * ratio);
+    return nextWaypoint.speed < 0.0 ? -speed : speed;
+}
+
+void PurepursuitWaypointFollower::updateDirectionSegments(int fromIndex)
+{
+    const int size = mWaypointList.size();
+
+    // The waypoint before fromIndex can become a cusp, the scan restarts at the beginning of the segment holding it
+    while (!mDirectionSegments.isEmpty() && mDirectionSegments.last().firstIndex >= fromIndex - 1)
+        mDirectionSegments.removeLast();
+    if (size == 0)
+        return;
+
+    // As in updateSpeedProfile, a route segment is driven in the direction of its end waypoint's speed.
+    // Cusp: a waypoint (not the first) whose speed has another sign than the next one's.
+    auto isReverse = [this](int index) { return mWaypointList.at(index).speed < 0.0; };
+    RouteDirectionSegment segment = mDirectionSegments.isEmpty() ? RouteDirectionSegment() : mDirectionSegments.takeLast();
+    segment.lastIndex = segment.firstIndex;
+    segment.reverse = isReverse(std::min(segment.firstIndex + 1, size - 1));
+    for (int i = segment.firstIndex + 1; i < size; i++) {
+        if (i > segment.firstIndex + 1 && isReverse(i) != segment.reverse) { // cusp at i - 1
+            mDirectionSegments.append(segment);
+            segment.firstIndex = i - 1;
+            segment.reverse = isReverse(i);
+        }
+        segment.lastIndex = i;
+    }
+    mDirectionSegments.append(segment);
+}
+
+void PurepursuitWaypointFollower::updateCurrentDirectionSegment()
+{
+    if (mDirectionSegments.isEmpty()) {
+        mCurrentState.currentDirectionSegment = 0;
+        return;
+    }
+
+    const int waypointIndex = mCurrentState.currentWaypointIndex;
+    auto holdsWaypoint = [this, waypointIndex](int segmentIndex) {
+        return segmentIndex >= 0 && segmentIndex < mDirectionSegments.size() && waypointIndex <= mDirectionSegments.at(segmentIndex).lastIndex
+                && (segmentIndex == 0 || waypointIndex > mDirectionSegments.at(segmentIndex).firstIndex);
+    };
+
+    // Usually the same or the next segment, searched after the route changed or wrapped around
+    int &segmentIndex = mCurrentState.currentDirectionSegment;
+    if (holdsWaypoint(segmentIndex))
+        return;
+    if (holdsWaypoint(segmentIndex + 1)) {
+        segmentIndex++;
+        return;
+    }
+    const auto segment = std::lower_bound(mDirectionSegments.cbegin(), mDirectionSegments.cend(), waypointIndex,
+                                          [](const RouteDirectionSegment &directionSegment, int index) { return directionSegment.lastIndex < index; });
+    segmentIndex = std::min(int(segment - mDirectionSegments.cbegin()), mDirectionSegments.size() - 1);
+}
+
+bool PurepursuitWaypointFollower::isReversing() const
+{
+    if (mDirectionSegments.isEmpty())
+        return false;
+
+    return mDirectionSegments.at(qBound(0, mCurrentState.currentDirectionSegment, mDirectionSegments.size() - 1)).reverse;
+}
+
+QPointF PurepursuitWaypointFollower::getVehiclePositionForDirection() const
+{
+    if (mVehicleState->hasTrailingVehicle() && isReversing()) // position defined by trailer when backing (if exists)
+        return mVehicleState->getTrailingVehicle()->getPosition(mPosTypeUsed).getPoint();
+
+    return mVehicleState->getPosition(mPosTypeUsed).getPoint();
+}
+
+double PurepursuitWaypointFollower::getProfileSpeedAtWaypoint(int index) const
+{
+    if (mSpeedProfile.isEmpty())
+        return 0.0;
+
+    index = qBound(0, index, mSpeedProfile.size() - 1);
+    return mWaypointList.at(index).speed < 0.0 ? -mSpeedProfile.at(index) : mSpeedProfile.at(index);
+}
+
+void PurepursuitWaypointFollower::setMaxLateralAcceleration(double maxLateralAcceleration)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    mMaxLateralAcceleration = std::max(maxLateralAcceleration, 0.0);
+    updateSpeedProfile(0);
+}
+
+double PurepursuitWaypointFollower::getArcLengthAtWaypoint(int index) const
+{
+    if (mRouteGeometry.isEmpty())
+        return 0.0;
+
+    return mRouteGeometry.getArcLength(qBound(0, index, mRouteGeometry.size() - 1));
+}
+
 double PurepursuitWaypointFollower::purePursuitRadius()
 {
     if (mCurrentState.adaptivePurePursuitRadius) {
@@ -430,14 +907,16 @@ void PurepursuitWaypointFollower::setAdaptivePurePursuitRadiusActive(bool adapti
 
 QList<PosPoint> PurepursuitWaypointFollower::getCurrentRoute()
 {
-    return mWaypointList;
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    return PosPoint::fromPODList(mWaypointList);
 }
 
 QPointF PurepursuitWaypointFollower::getVehicleAlignmentReferencePoint()
 {
     QPointF vehicleAlignmentReferencePointXY;
     QSharedPointer<VehicleState> referenceVehicleState = mVehicleState;
-    if (mVehicleState->hasTrailingVehicle() && mVehicleState->getSpeed() < 0) { // position defined by trailer when backing (if exists)
+    const bool reversing = isReversing();
+    if (mVehicleState->hasTrailingVehicle() && reversing) { // position defined by trailer when backing (if exists)
         referenceVehicleState = mVehicleState->getTrailingVehicle();
     }
 
@@ -449,7 +928,7 @@ QPointF PurepursuitWaypointFollower::getVehicleAlignmentReferencePoint()
         } break;
         case AutopilotEndGoalAlignmentType::FRONT_REAR_END: {
             rearAxleToReferencePointOffset = referenceVehicleState->getRearAxleToRearEndOffset();
-            if(mVehicleState->getSpeed() >= 0) {
+            if (!reversing) {
                 rearAxleToReferencePointOffset.x += referenceVehicleState->getLength();
             }
             vehicleAlignmentReferencePointXY = referenceVehicleState->posInVehicleFrameToPosPointENU(rearAxleToReferencePointOffset, mPosTypeUsed).getPoint();
@@ -3,6 +3,8 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * Implementation of pure pursuit for following a list of waypoints ("Follow Route").
+ * The route state machine and speed handling are shared with other lateral controllers, which override getSteeringCurvature
+ * (see StanleyWaypointFollower, MpcWaypointFollower).
  */
 
 #ifndef PUREPURSUITWAYPOINTFOLLOWER_H
@@ -11,11 +13,16 @@
 #include <QObject>
 #include <QSharedPointer>
 #include <QPointF>
-#include <QTimer>
+#include <algorithm>
+#include <array>
 #include "vehicles/vehiclestate.h"
 #include "vehicles/controller/movementcontroller.h"
 #include "communication/vehicleconnections/vehicleconnection.h"
 #include "autopilot/waypointfollower.h"
+#include "core/routespatialindex.h"
+#include "core/routegeometry.h"
+#include "core/controlloop.h"
+#include "autopilot/attributetriggerscheduler.h"
 
 enum class WayPointFollowerSTMstates {NONE, FOLLOW_ROUTE_INIT, FOLLOW_ROUTE_GOTO_BEGIN, FOLLOW_ROUTE_FOLLOWING, FOLLOW_ROUTE_APPROACHING_END_GOAL, FOLLOW_ROUTE_FINISHED};
 struct WayPointFollowerState {
@@ -23,6 +30,7 @@ struct WayPointFollowerState {
     PosPoint currentGoal;
     QPointF startPointXY;
     int currentWaypointIndex;
+    int currentDirectionSegment = 0; // holding currentWaypointIndex, see RouteDirectionSegment
     bool adaptivePurePursuitRadius = false;
     double purePursuitRadius = 1.0;
     double adaptivePurePursuitRadiusCoefficient = 1.0;
@@ -33,6 +41,63 @@ struct WayPointFollowerState {
     double overrideAltitude = 0.0;
 };
 
+// Non-owning view on consecutive waypoints of a route, wraps around the end of the route if requested.
+// Used for the lookahead in FOLLOW_ROUTE_FOLLOWING without copying waypoints.
+class LookaheadWindow
+{
+public:
+    LookaheadWindow(const QVector<pospoint_t> &route, int firstRouteIndex, int length, bool wrapAround) :
+        mRoute(route), mWrapAround(wrapAround)
+    {
+        if (mRoute.isEmpty()) {
+            mFirstRouteIndex = 0;
+            mSize = 0;
+        } else if (mWrapAround) {
+            mFirstRouteIndex = ((firstRouteIndex % mRoute.size()) + mRoute.size()) % mRoute.size();
+            mSize = std::min(length, mRoute.size() + 1);
+        } else {
+            mFirstRouteIndex = std::max(firstRouteIndex, 0);
+            mSize = std::max(std::min(firstRouteIndex + length, mRoute.size()) - mFirstRouteIndex, 0);
+        }
+    }
+
+    int size() const { return mSize; }
+    int routeIndex(int i) const { return mWrapAround ? (mFirstRouteIndex + i) % mRoute.size() : mFirstRouteIndex + i; }
+    const pospoint_t &at(int i) const { return mRoute.at(routeIndex(i)); }
+
+private:
+    const QVector<pospoint_t> &mRoute;
+    bool mWrapAround;
+    int mFirstRouteIndex;
+    int mSize;
+};
+
+// Part of a route driven in one direction (forward or reverse). Consecutive direction segments share the cusp waypoint where the direction changes,
+// i.e., lastIndex of one is firstIndex of the next. A waypoint index belongs to the segment that ends at or after it (the cusp to the one before it).
+struct RouteDirectionSegment {
+    int firstIndex = 0;
+    int lastIndex = 0;
+    bool reverse = false;
+};
+
+// Time taken by the lateral controller (getSteeringCurvature) per control iteration
+struct LateralControlStatistics {
+    quint64 iterations = 0;
+    double lastSolveTime_us = 0.0;
+    double maxSolveTime_us = 0.0;
+    double meanSolveTime_us = 0.0;
+    std::array<quint64, ControlLoopStatistics::numHistogramBuckets> solveTimeHistogram = {};
+};
+
+// Pose relative to the closest route segment within the lookahead
+struct RouteTrackingError {
+    bool valid = false;
+    int segmentEndIndex = 0; // index in the route
+    double lateralError_m = 0.0; // positive: left of the route
+    double headingError_rad = 0.0; // yaw - route heading, [-pi:pi]
+    double routeCurvature = 0.0; // [1/m] at the closest point, positive: route turns left
+};
+
 class PurepursuitWaypointFollower : public WaypointFollower
 {
     Q_OBJECT
@@ -62,6 +127,14 @@ public:
     virtual void clearRoute() override;
     virtual void addWaypoint(const PosPoint &point) override;
     virtual void addRoute(const QList<PosPoint>& route) override;
+    virtual void addRoutePOD(const QVector<pospoint_t> &route) override;
+    virtual void appendRoute(const QVector<pospoint_t> &route) override;
+    virtual void setRoutePOD(const QVector<pospoint_t> &route, int waypointIndex) override;
+    virtual void patchRoute(const QVector<pospoint_t> &route, int firstChangedIndex) override;
+    virtual void insertWaypoints(int index, const QVector<pospoint_t> &waypoints) override;
+    virtual void replaceWaypoints(int index, const QVector<pospoint_t> &waypoints) override;
+    virtual void removeWaypoints(int index, int count) override;
+    virtual int getCurrentWaypointIndex() override;
 
     virtual void startFollowingRoute(bool fromBeginning) override;
     virtual bool isActive() override;
@@ -69,18 +142,67 @@ public:
     virtual void resetState() override;
 
     virtual QList<PosPoint> getCurrentRoute() override;
+    virtual QVector<pospoint_t> getCurrentRoutePOD() override;
+
+    double getInterpolatedSpeed(const PosPoint &currentGoal, const pospoint_t &lastWaypoint, const pospoint_t &nextWaypoint);
 
-    double getInterpolatedSpeed(const PosPoint &currentGoal, const PosPoint &lastWaypoint, const PosPoint &nextWaypoint);
+    // Speed profile: waypoint speeds are upper limits that are further reduced in curves (lateral acceleration) and before slower sections
+    // or direction changes (VehicleState::getMinAcceleration), and ramp up within VehicleState::getMaxAcceleration.
+    // Planned whenever waypoints are added, i.e., with the vehicle's acceleration limits at that time.
+    bool isSpeedProfileActive() const { return mSpeedProfileActive; }
+    void setSpeedProfileActive(bool active) { mSpeedProfileActive = active; }
+    double getMaxLateralAcceleration() const { return mMaxLateralAcceleration; }
+    void setMaxLateralAcceleration(double maxLateralAcceleration); // [m/s²], replans the current route
+    double getProfileSpeedAtWaypoint(int index) const; // signed as the waypoint's speed
+
+    // Direction segments of the current route, split at cusps (sign changes of the waypoint speed) whenever waypoints are added.
+    // Following stops at a cusp: the lookahead does not reach beyond it and the cusp is passed like an end goal before the direction changes.
+    const QVector<RouteDirectionSegment> &getDirectionSegments() const { return mDirectionSegments; }
+    bool isReversing() const; // direction of the current direction segment, the trailer (if any) defines the position when reversing
 
     PosType getPosTypeUsed() const;
     void setPosTypeUsed(const PosType &posTypeUsed);
 
-    void provideParametersToParameterServer();
+    virtual void provideParametersToParameterServer();
     QPointF getVehicleAlignmentReferencePoint();
 
+    // Arc length along the current route [m], from first waypoint to waypoint at index
+    double getArcLengthAtWaypoint(int index) const;
+    double getRouteLength() const { return mRouteGeometry.getLength(); }
+    // Heading, curvature, ... of the current route, closed if it is repeated. Not synchronized with the control loop, use while stopped or in getSteeringCurvature.
+    const RouteGeometry &getRouteGeometry() const { return mRouteGeometry; }
+
+    // Rate and mode (Qt event loop or dedicated thread) of the control loop running the state machine
+    ControlLoop &getControlLoop() { return mControlLoop; }
+    void setClock(Clock *clock) { mControlLoop.setClock(clock); mAttributeTriggerScheduler.setClock(clock); } // nullptr: real-time clock
+
+    // On the vehicle: route attributes change halfway between waypoints (where the closest waypoint changes). Enabled, the change
+    // is applied at its predicted time between control iterations while following the route (see AttributeTriggerScheduler).
+    AttributeTriggerScheduler &getAttributeTriggerScheduler() { return mAttributeTriggerScheduler; }
+
+    // Number of times the waypoint list was (re)allocated while running updateState(), expected to stay 0
+    quint64 getUpdateStateAllocationCount() const { return mUpdateStateAllocationCount; }
+
+    // Updated in each control iteration while following the route
+    virtual RouteProjection getRouteProjection() override;
+
+    LateralControlStatistics getLateralControlStatistics();
+    void resetLateralControlStatistics();
+
 signals:
     void distanceOfRouteLeft(double meters);
 
+protected:
+    // Lateral controller, called from the control iteration when on the vehicle. Pure pursuit towards goal, negative: left (see VehicleState::getCurvatureToPointInENU)
+    virtual double getSteeringCurvature(const PosPoint &goal);
+    // Speed to command towards goal, called after getSteeringCurvature. The goal's speed, e.g., from the speed profile
+    virtual double getDesiredSpeed(const PosPoint &goal) { return goal.getSpeed(); }
+
+    // For lateral controllers, valid while following the route (not when going to its beginning or approaching its end goal)
+    RouteTrackingError getRouteTrackingError(const QPointF &position, double yaw_rad) const;
+    WayPointFollowerSTMstates getStmState() const { return mCurrentState.stmState; }
+    QSharedPointer<VehicleState> getVehicleState() const { return mVehicleState; }
+
 private:
     void updateState();
     void updateControl(const PosPoint& goal);
@@ -90,16 +212,40 @@ private:
     QSharedPointer<MovementController> mMovementController;
     QSharedPointer<VehicleConnection> mVehicleConnection;
     QSharedPointer<VehicleState> mVehicleState;
-    QList <PosPoint> mWaypointList;
-    unsigned mUpdateStatePeriod_ms = 50;
-    QTimer mUpdateStateTimer;
-
+    QVector<pospoint_t> mWaypointList;
+    RouteSpatialIndex mWaypointListIndex;
+    RouteGeometry mRouteGeometry; // of mWaypointList
+    QVector<double> mSpeedProfile; // planned speed for each waypoint in mWaypointList
+    QVector<RouteDirectionSegment> mDirectionSegments; // of mWaypointList
+    RouteProjection mRouteProjection; // of the vehicle (not the trailer) onto mWaypointList
+    bool mSpeedProfileActive = false;
+    double mMaxLateralAcceleration = 1.0; // [m/s²]
+    quint64 mUpdateStateAllocationCount = 0;
+
+    void updateStateMachine();
     void holdPosition();
     void calculateDistanceOfRouteLeft(QPointF currentVehiclePositionXY);
+    void updateRouteFrom(int firstChangedIndex); // after mWaypointList changed from firstChangedIndex on, keeps the progress
+    void updateSpeedProfile(int fromIndex);
+    double getProfileSpeed(const QPointF &point, int previousWaypointIndex, int nextWaypointIndex) const;
+    void updateDirectionSegments(int fromIndex);
+    void updateCurrentDirectionSegment();
+    void approachCusp(const QPointF &currentVehiclePositionXY);
+    void updateAttributeTrigger(); // after the vehicle's route projection was updated
+    double getRouteProgressOfCurrentPose() const;
+    QPointF getVehiclePositionForDirection() const; // of the trailer (if any) when reversing
+    LateralControlStatistics mLateralControlStatistics;
     double purePursuitRadius();
 
     bool mRetryAfterEndGoalOvershot = false;
     double mEndGoalAlignmentThreshold = 0.1; //[m]
+
+    AttributeTriggerScheduler mAttributeTriggerScheduler{
+        [this](quint32 attributes) { if (isOnVehicle()) mMovementController->setDesiredAttributes(attributes); },
+        [this]() { return getRouteProgressOfCurrentPose(); }};
+
+    // Last member, i.e., the loop is stopped before anything it uses is destroyed
+    ControlLoop mControlLoop{[this](){ updateState(); }, 50};
 };
 
 #endif // PUREPURSUITWAYPOINTFOLLOWER_H
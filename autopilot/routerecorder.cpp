@@ -0,0 +1,119 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routerecorder.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+RouteRecorder::RouteRecorder(QSharedPointer<VehicleState> vehicleState, QObject *parent) : QObject(parent), mVehicleState(vehicleState)
+{
+    connect(&mSampleTimer, &ClockTimer::timeout, this, &RouteRecorder::sample);
+}
+
+void RouteRecorder::startRecording()
+{
+    mRoute.clear();
+    mHasLastSample = false;
+    mHasSleeve = false;
+    mMaxDistanceFromAnchor_m = 0.0;
+    mRecording = true;
+
+    if (!mVehicleState.isNull())
+        mSampleTimer.start(std::max(int(1000.0 / mParameters.sampleRate_Hz), 1));
+}
+
+void RouteRecorder::stopRecording()
+{
+    if (!mRecording)
+        return;
+
+    if (mHasLastSample && mRoute.size() < mParameters.maxPoints)
+        mRoute.append(mLastSample);
+    mHasLastSample = false;
+    mRecording = false;
+    mSampleTimer.stop();
+
+    qDebug() << "RouteRecorder: recorded route with" << mRoute.size() << "points.";
+    emit routeRecorded(mRoute);
+}
+
+void RouteRecorder::sample()
+{
+    addSample(mVehicleState->getPosition(mParameters.posType), mVehicleState->getSpeed());
+}
+
+void RouteRecorder::addSample(const PosPoint &position, double speed_ms)
+{
+    if (!mRecording || fabs(speed_ms) < mParameters.minSpeed_ms)
+        return;
+
+    PosPoint newSample = position;
+    newSample.setSpeed(speed_ms);
+    if (mRoute.isEmpty()) {
+        keepPoint(newSample);
+        return;
+    }
+
+    const PosPoint &anchor = mRoute.last();
+    bool keepLastSample = false;
+    double distance_m = anchor.getDistanceTo(newSample);
+    if (std::signbit(speed_ms) != std::signbit(anchor.getSpeed()) || fabs(speed_ms - anchor.getSpeed()) > mParameters.speedTolerance_ms) {
+        keepLastSample = true;
+    } else if (distance_m > mParameters.lateralTolerance_m) {
+        // Directions from the anchor that pass within the tolerance of the new sample
+        const double direction_rad = atan2(newSample.getY() - anchor.getY(), newSample.getX() - anchor.getX());
+        const double halfWidth_rad = asin(mParameters.lateralTolerance_m / distance_m);
+
+        if (distance_m > mParameters.maxSegmentLength_m || distance_m < mMaxDistanceFromAnchor_m - mParameters.lateralTolerance_m) {
+            keepLastSample = true; // too long or turning back
+        } else if (!mHasSleeve) {
+            mSleeveReference_rad = direction_rad;
+            mSleeveMin_rad = -halfWidth_rad;
+            mSleeveMax_rad = halfWidth_rad;
+            mHasSleeve = true;
+        } else {
+            const double relativeDirection_rad = normalizedAngle(direction_rad - mSleeveReference_rad);
+            if (relativeDirection_rad < mSleeveMin_rad || relativeDirection_rad > mSleeveMax_rad) {
+                keepLastSample = true;
+            } else {
+                mSleeveMin_rad = std::max(mSleeveMin_rad, relativeDirection_rad - halfWidth_rad);
+                mSleeveMax_rad = std::min(mSleeveMax_rad, relativeDirection_rad + halfWidth_rad);
+            }
+        }
+    }
+
+    if (keepLastSample) {
+        if (!mHasLastSample) { // new sample is the first after the anchor
+            keepPoint(newSample);
+            return;
+        }
+        keepPoint(mLastSample);
+        if (mRecording)
+            addSample(newSample, speed_ms); // from the new anchor, at most once more
+        return;
+    }
+
+    mLastSample = newSample;
+    mHasLastSample = true;
+    mMaxDistanceFromAnchor_m = std::max(mMaxDistanceFromAnchor_m, distance_m);
+}
+
+void RouteRecorder::keepPoint(const PosPoint &point)
+{
+    mRoute.append(point);
+    mHasLastSample = false;
+    mHasSleeve = false;
+    mMaxDistanceFromAnchor_m = 0.0;
+
+    if (mRoute.size() >= mParameters.maxPoints) {
+        qDebug() << "WARNING: RouteRecorder reached" << mParameters.maxPoints << "points, recording stopped.";
+        stopRecording();
+    }
+}
+
+double RouteRecorder::normalizedAngle(double angle_rad)
+{
+    return remainder(angle_rad, 2.0 * M_PI);
+}
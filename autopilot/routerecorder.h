@@ -0,0 +1,78 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Teach and repeat: records the route the vehicle is driven (e.g., manually) for the WaypointFollower to repeat.
+ * The position is sampled at a fixed rate and simplified while recording, in O(1) per sample: the directions from the last
+ * kept point that pass within the tolerance of all samples since form an angular interval (sleeve), a sample outside of it
+ * keeps the previous one. Changes of the speed or the direction of travel and maxSegmentLength also keep a point.
+ * Points have the speed of the vehicle when they were sampled (negative while reversing).
+ */
+
+#ifndef ROUTERECORDER_H
+#define ROUTERECORDER_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QList>
+#include "core/clock.h"
+#include "core/pospoint.h"
+#include "vehicles/vehiclestate.h"
+
+struct RouteRecorderParameters {
+    PosType posType = PosType::fused;
+    double sampleRate_Hz = 20.0;
+    double lateralTolerance_m = 0.05; // of the route to the driven path
+    double speedTolerance_ms = 0.2; // within a segment
+    double minSpeed_ms = 0.05; // standing still below, samples are skipped
+    double maxSegmentLength_m = 20.0;
+    int maxPoints = 10000; // recording stops when reached
+};
+
+class RouteRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    // vehicleState nullptr: samples only come from addSample
+    explicit RouteRecorder(QSharedPointer<VehicleState> vehicleState, QObject *parent = nullptr);
+
+    void setParameters(const RouteRecorderParameters &parameters) { mParameters = parameters; }
+    RouteRecorderParameters getParameters() const { return mParameters; }
+    void setClock(Clock *clock) { mSampleTimer.setClock(clock); }
+
+    bool isRecording() const { return mRecording; }
+    // The route so far, without the current sample
+    QList<PosPoint> getRoute() const { return mRoute; }
+
+    // One sample while recording, e.g., from a log
+    void addSample(const PosPoint &position, double speed_ms);
+
+public slots:
+    void startRecording(); // discards the previous route
+    void stopRecording(); // emits routeRecorded
+
+signals:
+    void routeRecorded(const QList<PosPoint> &route);
+
+private:
+    void sample();
+    void keepPoint(const PosPoint &point);
+    static double normalizedAngle(double angle_rad);
+
+    QSharedPointer<VehicleState> mVehicleState;
+    RouteRecorderParameters mParameters;
+    ClockTimer mSampleTimer;
+    bool mRecording = false;
+    QList<PosPoint> mRoute;
+
+    // Streaming simplification: sleeve from the last kept point (the anchor) through the samples since
+    PosPoint mLastSample;
+    bool mHasLastSample = false;
+    bool mHasSleeve = false;
+    double mSleeveReference_rad = 0.0; // direction the sleeve's bounds are relative to
+    double mSleeveMin_rad = 0.0;
+    double mSleeveMax_rad = 0.0;
+    double mMaxDistanceFromAnchor_m = 0.0;
+};
+
+#endif // ROUTERECORDER_H
@@ -0,0 +1,66 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Alternative routes of a vehicle, each with the progress made on it (see MultiWaypointFollower::setActiveRoute).
+ * Routes are implicitly shared (copy-on-write): getRoute() and the followers it is given to reference the stored waypoints,
+ * they are only copied when one of them modifies its route.
+ */
+
+#ifndef ROUTESTORE_H
+#define ROUTESTORE_H
+
+#include <QMap>
+#include <QVector>
+#include "core/pospoint.h"
+
+struct RouteProgress {
+    int waypointIndex = 0; // 0: start from the beginning
+};
+
+class RouteStore
+{
+public:
+    // Returns the route's ID
+    int addRoute(const QVector<pospoint_t> &route) {
+        mRoutes.insert(mNextRouteID, {route, RouteProgress()});
+        return mNextRouteID++;
+    }
+
+    // Resets the progress on the route
+    bool replaceRoute(int routeID, const QVector<pospoint_t> &route) {
+        auto storedRoute = mRoutes.find(routeID);
+        if (storedRoute == mRoutes.end())
+            return false;
+        *storedRoute = {route, RouteProgress()};
+        return true;
+    }
+
+    bool removeRoute(int routeID) { return mRoutes.remove(routeID) > 0; }
+    void clear() { mRoutes.clear(); }
+
+    bool contains(int routeID) const { return mRoutes.contains(routeID); }
+    int size() const { return mRoutes.size(); }
+    QList<int> getRouteIDs() const { return mRoutes.keys(); }
+
+    // Empty if there is no route with this ID
+    QVector<pospoint_t> getRoute(int routeID) const { return mRoutes.value(routeID).route; }
+
+    RouteProgress getProgress(int routeID) const { return mRoutes.value(routeID).progress; }
+    void setProgress(int routeID, const RouteProgress &progress) {
+        auto storedRoute = mRoutes.find(routeID);
+        if (storedRoute != mRoutes.end())
+            storedRoute->progress = progress;
+    }
+
+private:
+    struct StoredRoute {
+        QVector<pospoint_t> route;
+        RouteProgress progress;
+    };
+
+    QMap<int, StoredRoute> mRoutes;
+    int mNextRouteID = 0;
+};
+
+#endif // ROUTESTORE_H
@@ -0,0 +1,194 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "simulationrunner.h"
+#include "autopilot/purepursuitwaypointfollower.h"
+#include "autopilot/stanleywaypointfollower.h"
+#include "autopilot/mpcwaypointfollower.h"
+#include "autopilot/dwawaypointfollower.h"
+#include "vehicles/carstate.h"
+#include "vehicles/truckstate.h"
+#include "vehicles/trailerstate.h"
+#include "vehicles/controller/carmovementcontroller.h"
+#include "core/routespatialindex.h"
+#include "core/clock.h"
+#include <QThread>
+#include <QElapsedTimer>
+#include <QLineF>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+SimulationRunner::SimulationRunner()
+{
+
+}
+
+void SimulationRunner::setStep_ms(int step_ms)
+{
+    mStep_ms = std::max(step_ms, 1);
+}
+
+void SimulationRunner::setThreadCount(int threadCount)
+{
+    mThreadCount = std::max(threadCount, 0);
+}
+
+QVector<SimulationResult> SimulationRunner::run(const QList<SimulationScenario> &scenarios) const
+{
+    QVector<SimulationResult> results(scenarios.size());
+    const int threadCount = std::min(mThreadCount > 0 ? mThreadCount : QThread::idealThreadCount(), scenarios.size());
+
+    // Scenarios differ a lot in length, threads take the next one when done instead of getting fixed shards
+    std::atomic<int> nextScenario{0};
+    auto worker = [&]() {
+        for (int i = nextScenario++; i < scenarios.size(); i = nextScenario++)
+            results[i] = runScenario(scenarios.at(i), mStep_ms);
+    };
+
+    // QThreads, the vehicles' QObjects expect to live in one
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(QThread::create(worker));
+        threads.back()->start();
+    }
+    for (auto &thread : threads)
+        thread->wait();
+
+    return results;
+}
+
+SimulationResult SimulationRunner::runScenario(const SimulationScenario &scenario, int step_ms, const std::atomic<bool> *cancel)
+{
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+
+    SimulationResult result;
+    result.name = scenario.name;
+    if (scenario.route.isEmpty())
+        return result;
+
+    SimulatedClock clock; // outlives everything using it
+    QSharedPointer<CarState> vehicleState;
+    if (scenario.truck) {
+        QSharedPointer<TruckState> truckState(new TruckState);
+        if (scenario.trailer) {
+            truckState->setTrailingVehicle(QSharedPointer<TrailerState>(new TrailerState));
+            truckState->setSimulateTrailer(true);
+        }
+        vehicleState = truckState;
+    } else
+        vehicleState.reset(new CarState);
+    vehicleState->setSimulateRateLimits(scenario.rateLimits);
+    if (scenario.length_m > 0.0)
+        vehicleState->setLength(scenario.length_m);
+    if (scenario.width_m > 0.0)
+        vehicleState->setWidth(scenario.width_m);
+    if (scenario.axisDistance_m > 0.0)
+        vehicleState->setAxisDistance(scenario.axisDistance_m);
+    if (scenario.maxSteeringAngle_rad > 0.0)
+        vehicleState->setMaxSteeringAngle(scenario.maxSteeringAngle_rad);
+
+    const pospoint_t &first = scenario.route.first();
+    const pospoint_t &second = scenario.route.size() > 1 ? scenario.route.at(1) : first;
+    vehicleState->updatePosition(PosType::fused, [&first, &second](PosPoint &position) {
+        position.setXY(first.x, first.y);
+        position.setYaw(atan2(second.y - first.y, second.x - first.x) * 180.0 / M_PI);
+    });
+
+    QSharedPointer<CarMovementController> movementController(new CarMovementController(vehicleState));
+    QSharedPointer<PurepursuitWaypointFollower> followerPointer;
+    switch (scenario.lateralController) {
+    case LateralController::STANLEY: followerPointer.reset(new StanleyWaypointFollower(movementController)); break;
+    case LateralController::MPC: followerPointer.reset(new MpcWaypointFollower(movementController)); break;
+    case LateralController::DWA: followerPointer.reset(new DwaWaypointFollower(movementController)); break;
+    case LateralController::PURE_PURSUIT:
+    default: followerPointer.reset(new PurepursuitWaypointFollower(movementController)); break;
+    }
+    PurepursuitWaypointFollower &follower = *followerPointer;
+    follower.setPosTypeUsed(PosType::fused);
+    follower.setPurePursuitRadius(scenario.purePursuitRadius);
+    follower.setAdaptivePurePursuitRadiusActive(scenario.adaptivePurePursuitRadius);
+    follower.setRepeatRoute(scenario.repeatRoute);
+    if (scenario.speedProfileMaxLateralAcceleration > 0.0) {
+        follower.setSpeedProfileActive(true);
+        follower.setMaxLateralAcceleration(scenario.speedProfileMaxLateralAcceleration);
+    }
+
+    QList<PosPoint> route;
+    route.reserve(scenario.route.size());
+    for (const auto &point : scenario.route)
+        route.append(PosPoint(point));
+    follower.addRoute(route);
+    result.routeLength_m = follower.getRouteLength();
+
+    RouteSpatialIndex routeIndex;
+    routeIndex.setRoute(scenario.route);
+
+    follower.setClock(&clock);
+    follower.startFollowingRoute(true);
+
+    // Advancing the clock runs the follower's control loop whenever its period has passed, independent of the simulation step
+    const qint64 step_us = qint64(step_ms) * 1000;
+    const qint64 maxDuration_us = qint64(scenario.maxDuration_s * 1e6);
+    double crossTrackErrorSum = 0.0, crossTrackErrorSqSum = 0.0;
+    quint64 crossTrackErrorSamples = 0;
+    QPointF lastPosition = vehicleState->getPosition(PosType::fused).getPoint();
+    double lastYaw_deg = vehicleState->getPosition(PosType::fused).getYaw();
+    double nextTraceDistance_m = 0.0;
+
+    while (follower.isActive() && clock.now_us() < maxDuration_us && !(cancel && *cancel)) {
+        clock.advance(step_us);
+        vehicleState->simulationStep(step_ms, PosType::fused);
+
+        const PosPoint pose = vehicleState->getPosition(PosType::fused);
+        const QPointF position = pose.getPoint();
+        result.drivenDistance_m += QLineF(lastPosition, position).length();
+        lastPosition = position;
+
+        const double yawRate_rads = remainder(pose.getYaw() - lastYaw_deg, 360.0) * M_PI / 180.0 / (step_ms / 1000.0);
+        const double lateralAcceleration = vehicleState->getSpeed() * yawRate_rads;
+        lastYaw_deg = pose.getYaw();
+        result.maxLateralAcceleration_ms2 = std::max(result.maxLateralAcceleration_ms2, fabs(lateralAcceleration));
+
+        double crossTrackError = 0.0;
+        if (routeIndex.size() > 1)
+            routeIndex.getClosestSegmentIndex(position, 0, &crossTrackError);
+        crossTrackErrorSum += crossTrackError;
+        crossTrackErrorSqSum += crossTrackError * crossTrackError;
+        crossTrackErrorSamples++;
+        result.maxCrossTrackError_m = std::max(result.maxCrossTrackError_m, crossTrackError);
+
+        if (scenario.traceSpacing_m > 0.0 && result.drivenDistance_m >= nextTraceDistance_m) {
+            SimulationTracePoint tracePoint;
+            tracePoint.x = position.x();
+            tracePoint.y = position.y();
+            tracePoint.time_s = clock.now_us() / 1e6;
+            tracePoint.speed_ms = vehicleState->getSpeed();
+            tracePoint.crossTrackError_m = crossTrackError;
+            tracePoint.lateralAcceleration_ms2 = lateralAcceleration;
+            result.trace.append(tracePoint);
+            nextTraceDistance_m = result.drivenDistance_m + scenario.traceSpacing_m;
+        }
+    }
+
+    result.finished = !follower.isActive();
+    follower.stop();
+    result.controlIterations = follower.getControlLoop().getStatistics().iterations;
+    const LateralControlStatistics lateralControlStatistics = follower.getLateralControlStatistics();
+    result.meanLateralSolveTime_us = lateralControlStatistics.meanSolveTime_us;
+    result.maxLateralSolveTime_us = lateralControlStatistics.maxSolveTime_us;
+
+    result.simulatedTime_s = clock.now_us() / 1e6;
+    if (crossTrackErrorSamples > 0) {
+        result.meanCrossTrackError_m = crossTrackErrorSum / crossTrackErrorSamples;
+        result.rmsCrossTrackError_m = sqrt(crossTrackErrorSqSum / crossTrackErrorSamples);
+    }
+    const pospoint_t &last = scenario.route.last();
+    result.endGoalDistance_m = QLineF(lastPosition, QPointF(last.x, last.y)).length();
+    result.wallTime_s = wallTimer.nsecsElapsed() / 1e9;
+
+    return result;
+}
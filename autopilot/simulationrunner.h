@@ -0,0 +1,93 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Headless, deterministic simulation of vehicles following routes, e.g., for regression tests of the autopilot on recorded field routes.
+ * Each scenario gets its own CarState or TruckState, CarMovementController (simulated, no motor controller) and PurepursuitWaypointFollower.
+ * They are stepped on a SimulatedClock as fast as possible: VehicleState::simulationStep every step_ms, the follower's control loop
+ * whenever its period has passed in simulated time. Results only depend on the scenario.
+ * Scenarios are distributed over worker threads, each scenario runs on one thread from start to end.
+ */
+
+#ifndef SIMULATIONRUNNER_H
+#define SIMULATIONRUNNER_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "core/pospoint.h"
+
+enum class LateralController {PURE_PURSUIT, STANLEY, MPC, DWA};
+
+struct SimulationScenario {
+    QString name;
+    QVector<pospoint_t> route; // the vehicle starts at the first waypoint, heading towards the second
+    bool truck = false; // TruckState instead of CarState
+    bool trailer = false; // truck only, simulated TrailerState
+    LateralController lateralController = LateralController::PURE_PURSUIT;
+    double purePursuitRadius = 1.0; // also used by the other controllers outside of following the route
+    bool adaptivePurePursuitRadius = false;
+    bool repeatRoute = false;
+    bool rateLimits = false; // speed and steering follow the autopilot within the vehicle's acceleration and steering rate limits
+    double speedProfileMaxLateralAcceleration = 0.0; // [m/s²], > 0: follower plans a speed profile with this limit
+    double maxDuration_s = 3600.0; // virtual time, in case the vehicle never reaches the end of the route
+    // Vehicle model, 0: defaults of CarState / TruckState (e.g., from the vehicle the route is for)
+    double length_m = 0.0;
+    double width_m = 0.0;
+    double axisDistance_m = 0.0;
+    double maxSteeringAngle_rad = 0.0;
+    double traceSpacing_m = 0.0; // > 0: SimulationResult::trace has a point about every traceSpacing_m driven
+};
+
+struct SimulationTracePoint {
+    double x = 0.0;
+    double y = 0.0;
+    double time_s = 0.0;
+    double speed_ms = 0.0;
+    double crossTrackError_m = 0.0;
+    double lateralAcceleration_ms2 = 0.0; // speed * yaw rate
+};
+
+struct SimulationResult {
+    QString name;
+    bool finished = false; // follower reached the end of the route within maxDuration_s
+    double simulatedTime_s = 0.0;
+    double wallTime_s = 0.0;
+    double drivenDistance_m = 0.0;
+    double routeLength_m = 0.0;
+    // Distance of the vehicle to the closest route segment, sampled at every simulation step
+    double meanCrossTrackError_m = 0.0;
+    double rmsCrossTrackError_m = 0.0;
+    double maxCrossTrackError_m = 0.0;
+    double endGoalDistance_m = 0.0; // distance to the last waypoint when the simulation stopped
+    quint64 controlIterations = 0;
+    double meanLateralSolveTime_us = 0.0; // see LateralControlStatistics
+    double maxLateralSolveTime_us = 0.0;
+    double maxLateralAcceleration_ms2 = 0.0;
+    QVector<SimulationTracePoint> trace;
+};
+
+class SimulationRunner
+{
+public:
+    static constexpr int DEFAULT_STEP_ms = 25;
+
+    SimulationRunner();
+
+    int getStep_ms() const { return mStep_ms; }
+    void setStep_ms(int step_ms);
+    int getThreadCount() const { return mThreadCount; }
+    void setThreadCount(int threadCount); // 0: QThread::idealThreadCount()
+
+    // Results are in the order of the scenarios, blocks until all scenarios are done
+    QVector<SimulationResult> run(const QList<SimulationScenario> &scenarios) const;
+    // cancel: stops at the next step, e.g., for previews that are replaced by a newer one
+    static SimulationResult runScenario(const SimulationScenario &scenario, int step_ms = DEFAULT_STEP_ms, const std::atomic<bool> *cancel = nullptr);
+
+private:
+    int mStep_ms = DEFAULT_STEP_ms;
+    int mThreadCount = 0;
+};
+
+#endif // SIMULATIONRUNNER_H
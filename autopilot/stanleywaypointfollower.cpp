@@ -0,0 +1,45 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "stanleywaypointfollower.h"
+#include "vehicles/carstate.h"
+#include "communication/parameterserver.h"
+#include <cmath>
+
+namespace {
+constexpr ParameterDescriptor<float> ST_GAIN{"ST_GAIN"};
+constexpr ParameterDescriptor<float> ST_SOFT{"ST_SOFT"};
+}
+
+void StanleyWaypointFollower::provideParametersToParameterServer()
+{
+    PurepursuitWaypointFollower::provideParametersToParameterServer();
+    if (ParameterServer::getInstance()) {
+        ParameterServer::getInstance()->provideParameter<&StanleyWaypointFollower::setCrossTrackGain, &StanleyWaypointFollower::getCrossTrackGain>(ST_GAIN, this);
+        ParameterServer::getInstance()->provideParameter<&StanleyWaypointFollower::setSofteningSpeed, &StanleyWaypointFollower::getSofteningSpeed>(ST_SOFT, this);
+    }
+}
+
+double StanleyWaypointFollower::getSteeringCurvature(const PosPoint &goal)
+{
+    const QSharedPointer<CarState> carState = getVehicleState().dynamicCast<CarState>();
+    if (!carState || goal.getSpeed() < 0.0)
+        return PurepursuitWaypointFollower::getSteeringCurvature(goal);
+
+    const PosPoint position = carState->getPosition(getPosTypeUsed());
+    const double yaw_rad = position.getYaw() * M_PI / 180.0;
+    const double wheelbase = carState->getAxisDistance();
+    const QPointF frontAxle = position.getPoint() + wheelbase * QPointF(cos(yaw_rad), sin(yaw_rad));
+
+    const RouteTrackingError trackingError = getRouteTrackingError(frontAxle, yaw_rad);
+    if (!trackingError.valid)
+        return PurepursuitWaypointFollower::getSteeringCurvature(goal);
+
+    // Steering angle: heading error plus cross-track correction, positive: left
+    double steeringAngle_rad = -trackingError.headingError_rad
+            + atan2(-mCrossTrackGain * trackingError.lateralError_m, mSofteningSpeed + fabs(carState->getSpeed()));
+    steeringAngle_rad = qBound(-carState->getMaxSteeringAngle(), steeringAngle_rad, carState->getMaxSteeringAngle());
+
+    return -tan(steeringAngle_rad) / wheelbase;
+}
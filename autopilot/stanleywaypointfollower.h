@@ -0,0 +1,36 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Stanley lateral controller on the route state machine of PurepursuitWaypointFollower: steers the front axle onto the closest route
+ * segment, i.e., follows the route's path instead of cutting corners towards a goal ahead. On the vehicle and for car-like vehicles (CarState)
+ * while following the route forwards, pure pursuit otherwise (going to the route's beginning, end goal, reversing).
+ */
+
+#ifndef STANLEYWAYPOINTFOLLOWER_H
+#define STANLEYWAYPOINTFOLLOWER_H
+
+#include "autopilot/purepursuitwaypointfollower.h"
+
+class StanleyWaypointFollower : public PurepursuitWaypointFollower
+{
+    Q_OBJECT
+public:
+    StanleyWaypointFollower(QSharedPointer<MovementController> movementController) : PurepursuitWaypointFollower(movementController) {}
+
+    double getCrossTrackGain() const { return mCrossTrackGain; }
+    void setCrossTrackGain(double gain) { mCrossTrackGain = gain; }
+    double getSofteningSpeed() const { return mSofteningSpeed; }
+    void setSofteningSpeed(double speed) { mSofteningSpeed = speed; }
+
+    virtual void provideParametersToParameterServer() override;
+
+protected:
+    virtual double getSteeringCurvature(const PosPoint &goal) override;
+
+private:
+    double mCrossTrackGain = 1.0; // [1/s]
+    double mSofteningSpeed = 0.5; // [m/s], limits the cross-track correction at low speed
+};
+
+#endif // STANLEYWAYPOINTFOLLOWER_H
@@ -9,7 +9,10 @@
 #define WAYPOINTFOLLOWER_H
 
 #include <QObject>
+#include <algorithm>
+#include <atomic>
 #include "core/pospoint.h"
+#include "core/routeprojection.h"
 
 class WaypointFollower : public QObject
 {
@@ -24,6 +27,59 @@ public:
     virtual void clearRoute() = 0;
     virtual void addWaypoint(const PosPoint &point) = 0;
     virtual void addRoute(const QList<PosPoint>& route) = 0;
+    // Same as addRoute, without converting from/to PosPoint where the follower keeps its route as pospoint_t
+    virtual void addRoutePOD(const QVector<pospoint_t> &route) { addRoute(PosPoint::fromPODList(route)); }
+    // Extends the current route at its end without changing the progress on it, also while active (e.g., streamed trajectories)
+    virtual void appendRoute(const QVector<pospoint_t> &route) {
+        for (const auto &point : route)
+            addWaypoint(PosPoint(point));
+    }
+    // Replaces the route (stopped), which continues at waypointIndex when started with fromBeginning == false. Followers that keep
+    // their route as QVector<pospoint_t> share it with the caller's copy (see RouteStore).
+    virtual void setRoutePOD(const QVector<pospoint_t> &route, int waypointIndex) {
+        Q_UNUSED(waypointIndex)
+        clearRoute();
+        addRoutePOD(route);
+    }
+    // Replaces the route by a modified copy of it (e.g., see routeCodec::applyRoutePatch) that equals the current route up to
+    // firstChangedIndex. Followers that support it keep the progress on the route, also while active.
+    virtual void patchRoute(const QVector<pospoint_t> &route, int firstChangedIndex) {
+        Q_UNUSED(firstChangedIndex)
+        clearRoute();
+        addRoutePOD(route);
+    }
+    // Route edits in place, e.g., while driving. Indices are clamped to the route, waypoint IDs (PosPoint::getId) are kept,
+    // i.e., they can address waypoints across edits (see getWaypointIndexById). Followers that support it keep the progress
+    // (see patchRoute), the current waypoint moves with the waypoints before it.
+    virtual void insertWaypoints(int index, const QVector<pospoint_t> &waypoints) {
+        const QVector<pospoint_t> route = getCurrentRoutePOD();
+        index = qBound(0, index, route.size());
+        patchRoute(route.mid(0, index) + waypoints + route.mid(index), index);
+    }
+    virtual void replaceWaypoints(int index, const QVector<pospoint_t> &waypoints) { // does not extend the route
+        QVector<pospoint_t> route = getCurrentRoutePOD();
+        if (index < 0 || index >= route.size())
+            return;
+        std::copy(waypoints.cbegin(), waypoints.cbegin() + std::min(waypoints.size(), route.size() - index), route.begin() + index);
+        patchRoute(route, index);
+    }
+    virtual void removeWaypoints(int index, int count) {
+        QVector<pospoint_t> route = getCurrentRoutePOD();
+        if (index < 0 || index >= route.size() || count <= 0)
+            return;
+        route.remove(index, std::min(count, route.size() - index));
+        patchRoute(route, index);
+    }
+    // Index of the first waypoint with this ID, -1 if none
+    int getWaypointIndexById(int id) {
+        const QVector<pospoint_t> route = getCurrentRoutePOD();
+        for (int i = 0; i < route.size(); i++)
+            if (route.at(i).id == id)
+                return i;
+        return -1;
+    }
+    // Index of the waypoint currently driven towards, 0 if not following the route
+    virtual int getCurrentWaypointIndex() { return 0; }
 
     virtual void startFollowingRoute(bool fromBeginning) = 0;
     virtual bool isActive() = 0;
@@ -31,10 +87,22 @@ public:
     virtual void resetState() = 0;
 
     virtual QList<PosPoint> getCurrentRoute() = 0;
+    // Without conversion, implicitly shared (no copy of the waypoints) where the follower keeps its route as pospoint_t
+    virtual QVector<pospoint_t> getCurrentRoutePOD() { return PosPoint::toPODList(getCurrentRoute()); }
+    // Vehicle relative to its route (cross-track error, progress, heading error), invalid where not supported
+    virtual RouteProjection getRouteProjection() { return RouteProjection(); }
+    // Changes whenever the route changes (thread-safe), e.g., to encode it once per version
+    virtual quint64 getRouteVersion() const { return mRouteVersion.load(std::memory_order_acquire); }
 
 signals:
     void deactivateEmergencyBrake();
     void activateEmergencyBrake();
+
+protected:
+    void routeChanged() { mRouteVersion.fetch_add(1, std::memory_order_acq_rel); }
+
+private:
+    std::atomic<quint64> mRouteVersion{0};
 };
 
 #endif // WAYPOINTFOLLOWER_H
@@ -0,0 +1,204 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include <QtTest>
+#include "autopilot/purepursuitwaypointfollower.h"
+#include "autopilot/mpcwaypointfollower.h"
+#include "autopilot/dwawaypointfollower.h"
+#include "autopilot/proximitymonitor.h"
+#include "vehicles/controller/carmovementcontroller.h"
+#include "vehicles/carstate.h"
+#include "core/geofence.h"
+#include "core/occupancygrid.h"
+
+class BenchAutopilot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void purepursuitWaypointFollowerTick()
+    {
+        QSharedPointer<CarState> carState(new CarState);
+        QSharedPointer<CarMovementController> movementController(new CarMovementController(carState));
+        PurepursuitWaypointFollower waypointFollower(movementController);
+
+        // Long route with the vehicle at its beginning, the vehicle does not move during the benchmark
+        QList<PosPoint> route;
+        for (int i = 0; i < 1000; i++)
+            route.append(PosPoint(i * 1.0, 5.0 * sin(i * 0.05)));
+        waypointFollower.addRoute(route);
+
+        PosPoint vehiclePosition = carState->getPosition(PosType::fused);
+        vehiclePosition.setXY(route.first().getX(), route.first().getY());
+        carState->setPosition(vehiclePosition);
+
+        // The loop timer does not fire without an event loop, ticks are triggered by step()
+        waypointFollower.startFollowingRoute(true);
+        for (int i = 0; i < 3; i++) // reach FOLLOW_ROUTE_FOLLOWING
+            waypointFollower.getControlLoop().step();
+
+        QBENCHMARK {
+            waypointFollower.getControlLoop().step();
+        }
+        QCOMPARE(waypointFollower.getUpdateStateAllocationCount(), (quint64)0);
+        waypointFollower.stop();
+    }
+
+    void dwaWaypointFollowerTick()
+    {
+        // 7 x 41 candidates over a 2 s horizon, obstacles on both sides of the route ahead
+        QSharedPointer<CarState> carState(new CarState);
+        QSharedPointer<CarMovementController> movementController(new CarMovementController(carState));
+        DwaWaypointFollower waypointFollower(movementController);
+        QSharedPointer<OccupancyGrid> occupancyGrid(new OccupancyGrid);
+        for (int i = 0; i < 30; i++) {
+            occupancyGrid->insertHit(QPointF(i * 0.2, 1.0), 1);
+            occupancyGrid->insertHit(QPointF(i * 0.2, -1.0), 1);
+        }
+        waypointFollower.setOccupancyGrid(occupancyGrid);
+
+        QList<PosPoint> route;
+        for (int i = 0; i < 100; i++)
+            route.append(PosPoint(i * 0.5, 0.0, 0.0, 0.0, 0.0, 0.0, 1.0));
+        waypointFollower.addRoute(route);
+        carState->setSpeed(1.0);
+
+        waypointFollower.startFollowingRoute(true);
+        for (int i = 0; i < 3; i++) // reach FOLLOW_ROUTE_FOLLOWING
+            waypointFollower.getControlLoop().step();
+
+        QBENCHMARK {
+            waypointFollower.getControlLoop().step();
+        }
+        const DwaStatistics statistics = waypointFollower.getDwaStatistics();
+        QVERIFY(statistics.evaluations > 0);
+        QVERIFY(statistics.lastFeasibleCandidates > 0);
+        qDebug() << "DWA evaluation of" << statistics.lastCandidates << "candidates: mean" << statistics.meanEvaluationTime_us << "us, max" << statistics.maxEvaluationTime_us << "us";
+        waypointFollower.stop();
+    }
+
+    void proximityMonitorCheck()
+    {
+        // 256 vehicles 3 m apart on a grid, driving in different directions
+        FleetStateStore fleetStateStore;
+        for (int i = 0; i < 256; i++) {
+            pospoint_t position;
+            position.x = (i % 16) * 3.0;
+            position.y = (i / 16) * 3.0;
+            position.yaw = (i * 37) % 360;
+            fleetStateStore.setState(i, position, 1.0, {1.0, 0.0, 0.0}, WAYWISE_OBJECT_TYPE_CAR, 0.8, 0.335, -0.15);
+        }
+        const FleetStateStore::Columns columns = fleetStateStore.snapshot();
+        const ProximityMonitorParameters parameters;
+
+        QVector<ProximityWarning> warnings;
+        QBENCHMARK {
+            warnings = ProximityMonitor::checkProximity(columns, parameters);
+        }
+        QVERIFY(!warnings.isEmpty());
+    }
+
+    void mpcSolve()
+    {
+        MpcParameters parameters;
+        parameters.horizonSteps = MpcParameters::MAX_HORIZON_STEPS;
+
+        double relativeCurvature = 0.0;
+        QBENCHMARK {
+            relativeCurvature = MpcWaypointFollower::solve(parameters, 2.0, 0.3, 0.1, relativeCurvature);
+        }
+        QVERIFY(std::isfinite(relativeCurvature));
+    }
+
+    void geofenceCheckPath()
+    {
+        // Keep-in field with 1000 edges and 50 keep-out obstacles, footprint checked along a 10 m arc
+        Geofence geofence;
+        QVector<QPointF> field;
+        for (int i = 0; i < 1000; i++) {
+            const double angle = 2.0 * M_PI * i / 1000;
+            const double radius = 100.0 + 5.0 * sin(7.0 * angle);
+            field.append(QPointF(radius * cos(angle), radius * sin(angle)));
+        }
+        geofence.addZone(Geofence::ZoneType::KeepIn, field);
+        for (int i = 0; i < 50; i++) {
+            const QPointF center(-60.0 + (i % 10) * 12.0, -60.0 + (i / 10) * 12.0 + 6.0);
+            geofence.addZone(Geofence::ZoneType::KeepOut, {center + QPointF(-1.0, -1.0), center + QPointF(1.0, -1.0),
+                                                           center + QPointF(1.0, 1.0), center + QPointF(-1.0, 1.0)});
+        }
+
+        const QRectF footprint(-0.15, -0.2, 0.8, 0.4);
+        Geofence::Violation violation;
+        QBENCHMARK {
+            violation = geofence.checkPath(footprint, QPointF(0.0, 3.0), 0.0, 0.05, 10.0, 0.1);
+        }
+        QVERIFY(!violation.isViolated());
+    }
+
+    void occupancyGridInsertAndQuery()
+    {
+        // 64 ToF-like rays of 2 m per iteration (one sensor update each), then the corridor ahead is checked
+        OccupancyGrid grid;
+        grid.insertHit(QPointF(3.0, 0.1));
+        double distance_m = -1.0;
+        QBENCHMARK {
+            for (int i = 0; i < 64; i++) {
+                const double angle = -0.5 + i / 64.0;
+                grid.insertRay(QPointF(0.0, 0.0), QPointF(2.0 * cos(angle), 2.0 * sin(angle)), false);
+            }
+            distance_m = grid.getDistanceToOccupied(QPointF(0.0, 0.0), 0.0, 0.3, 5.0);
+        }
+        QVERIFY(distance_m > 2.0);
+    }
+
+    void vehicleModelStepCandidates_data()
+    {
+        QTest::addColumn<bool>("kernel");
+        QTest::newRow("CarState") << false;
+        QTest::newRow("PoseBatch") << true;
+    }
+
+    void vehicleModelStepCandidates()
+    {
+        // 64 constant-steering candidates over a 5 m horizon of 0.1 m steps
+        static constexpr int numCandidates = 64;
+        static constexpr int numSteps = 50;
+        QFETCH(bool, kernel);
+        CarState carState;
+        carState.setAxisDistance(0.33);
+        std::array<double, numCandidates> steerings;
+        for (int i = 0; i < numCandidates; i++)
+            steerings[i] = -1.0 + 2.0 * i / (numCandidates - 1);
+
+        double sum = 0.0;
+        if (kernel) {
+            const vehicleKinematics::CarModel model = carState.getKinematicModel();
+            vehicleKinematics::PoseBatch<vehicleKinematics::CarModel, numCandidates> batch;
+            QBENCHMARK {
+                batch.reset({}, numCandidates);
+                for (int step = 0; step < numSteps; step++)
+                    batch.step(model, steerings.data(), 0.1);
+                sum += batch.x[numCandidates - 1];
+            }
+        } else {
+            QBENCHMARK {
+                for (double steering : steerings) {
+                    PosPoint start = carState.getPosition(PosType::simulated);
+                    start.setXY(0.0, 0.0);
+                    start.setYaw(0.0);
+                    carState.setPosition(start);
+                    carState.setSteering(steering);
+                    for (int step = 0; step < numSteps; step++)
+                        carState.updateOdomPositionAndYaw(0.1, PosType::simulated);
+                }
+                sum += carState.getPosition(PosType::simulated).getX();
+            }
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+};
+
+QTEST_GUILESS_MAIN(BenchAutopilot)
+
+#include "bench_autopilot.moc"
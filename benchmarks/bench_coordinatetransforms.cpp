@@ -0,0 +1,137 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include <QtTest>
+#include <random>
+#include "core/coordinatetransforms.h"
+
+class BenchCoordinateTransforms : public QObject
+{
+    Q_OBJECT
+
+private:
+    static constexpr int mNumPoints = 10000;
+    coordinateTransforms::EnuFrame mEnuFrame;
+    QVector<llh_t> mLlhPoints;
+    QVector<xyz_t> mEnuPoints;
+    QVector<xyz_t> mEcefPoints;
+
+private slots:
+    void initTestCase()
+    {
+        // Realistic inputs: points within 5 km of an ENU reference close to the earth's surface
+        const llh_t enuReference = {57.71495867, 12.89134921, 219.0};
+        mEnuFrame.setReference(enuReference);
+
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> horizontal(-5000.0, 5000.0);
+        std::uniform_real_distribution<double> vertical(-50.0, 150.0);
+        for (int i = 0; i < mNumPoints; i++) {
+            mEnuPoints.append({horizontal(generator), horizontal(generator), vertical(generator)});
+            mEcefPoints.append(mEnuFrame.enuToEcef(mEnuPoints.last()));
+            mLlhPoints.append(coordinateTransforms::xyzToLlhIterative(mEcefPoints.last()));
+        }
+    }
+
+    void xyzToLlhIterative()
+    {
+        double sum = 0.0;
+        QBENCHMARK {
+            for (const auto &xyz : mEcefPoints)
+                sum += coordinateTransforms::xyzToLlhIterative(xyz).height;
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void xyzToLlhClosedForm()
+    {
+        double sum = 0.0;
+        QBENCHMARK {
+            for (const auto &xyz : mEcefPoints)
+                sum += coordinateTransforms::xyzToLlhClosedForm(xyz).height;
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void xyzToLlhAccuracy()
+    {
+        double maxHorizontalError_deg = 0.0;
+        double maxHeightError_m = 0.0;
+        for (const auto &xyz : mEcefPoints) {
+            const llh_t iterative = coordinateTransforms::xyzToLlhIterative(xyz);
+            const llh_t closedForm = coordinateTransforms::xyzToLlhClosedForm(xyz);
+            maxHorizontalError_deg = std::max({maxHorizontalError_deg, fabs(iterative.latitude - closedForm.latitude), fabs(iterative.longitude - closedForm.longitude)});
+            maxHeightError_m = std::max(maxHeightError_m, fabs(iterative.height - closedForm.height));
+        }
+        qDebug() << "Max. difference iterative vs. closed form:" << maxHorizontalError_deg << "deg," << maxHeightError_m << "m";
+        QVERIFY(maxHorizontalError_deg < 1E-8);
+        QVERIFY(maxHeightError_m < 1E-3);
+    }
+
+    void llhToEnu()
+    {
+        double sum = 0.0;
+        const llh_t enuReference = mEnuFrame.getReference();
+        QBENCHMARK {
+            for (const auto &llh : mLlhPoints)
+                sum += coordinateTransforms::llhToEnu(enuReference, llh).x;
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void enuFrameLlhToEnuBatch()
+    {
+        QVector<xyz_t> enuPoints(mLlhPoints.size());
+        QBENCHMARK {
+            mEnuFrame.llhToEnu(mLlhPoints.constData(), enuPoints.data(), mLlhPoints.size());
+        }
+        QVERIFY(std::isfinite(enuPoints.last().x));
+    }
+
+    void enuToLlh()
+    {
+        double sum = 0.0;
+        const llh_t enuReference = mEnuFrame.getReference();
+        QBENCHMARK {
+            for (const auto &xyz : mEnuPoints)
+                sum += coordinateTransforms::enuToLlh(enuReference, xyz).latitude;
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void enuFrameEnuToLlhBatch()
+    {
+        QVector<llh_t> llhPoints(mEnuPoints.size());
+        QBENCHMARK {
+            mEnuFrame.enuToLlh(mEnuPoints.constData(), llhPoints.data(), mEnuPoints.size());
+        }
+        QVERIFY(std::isfinite(llhPoints.last().latitude));
+    }
+
+    // Change of the ENU reference by 1 km: via ECEF per point vs. one rotation and translation
+    void enuFrameEnuToEnuBatch()
+    {
+        const coordinateTransforms::EnuFrame target(mEnuFrame.enuToLlh({1000.0, 0.0, 0.0}));
+        QVector<xyz_t> enuPoints(mEnuPoints.size());
+        QBENCHMARK {
+            mEnuFrame.enuToEnu(target, mEnuPoints.constData(), enuPoints.data(), mEnuPoints.size());
+        }
+        QVERIFY(std::isfinite(enuPoints.last().x));
+    }
+
+    void enuTransformBatch()
+    {
+        const coordinateTransforms::EnuFrame target(mEnuFrame.enuToLlh({1000.0, 0.0, 0.0}));
+        const coordinateTransforms::EnuTransform transform = mEnuFrame.getTransformTo(target);
+        QVector<xyz_t> enuPoints = mEnuPoints;
+        QBENCHMARK {
+            transform.apply(enuPoints.data(), enuPoints.size());
+        }
+        QVERIFY(std::isfinite(enuPoints.last().x));
+    }
+};
+
+QTEST_APPLESS_MAIN(BenchCoordinateTransforms)
+
+#include "bench_coordinatetransforms.moc"
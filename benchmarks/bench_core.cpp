@@ -0,0 +1,227 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include <QtTest>
+#include <random>
+#include "core/geometry.h"
+#include "core/pospoint.h"
+#include "core/vbytearray.h"
+#include "vehicles/trailerkinematics.h"
+#include "vehicles/steeringgeometrytable.h"
+
+class BenchCore : public QObject
+{
+    Q_OBJECT
+
+private:
+    static constexpr int mNumElements = 10000;
+    QVector<QLineF> mLines;
+    QList<PosPoint> mPosPoints;
+
+private slots:
+    void initTestCase()
+    {
+        // Lookahead-like segments around a pure pursuit circle at the origin
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> coordinate(-3.0, 3.0);
+        for (int i = 0; i < mNumElements; i++) {
+            mLines.append(QLineF(coordinate(generator), coordinate(generator), coordinate(generator), coordinate(generator)));
+
+            PosPoint point(coordinate(generator), coordinate(generator), coordinate(generator));
+            point.setSpeed(coordinate(generator));
+            point.setYaw(coordinate(generator));
+            mPosPoints.append(point);
+        }
+    }
+
+    void findIntersectionsBetweenCircleAndLine()
+    {
+        int numIntersections = 0;
+        const QPair<QPointF, double> circle(QPointF(0.0, 0.0), 1.5);
+        QBENCHMARK {
+            for (const auto &line : mLines)
+                numIntersections += geometry::findIntersectionsBetweenCircleAndLine(circle, line).size();
+        }
+        QVERIFY(numIntersections > 0);
+    }
+
+    void findCircleLineIntersections()
+    {
+        int numIntersections = 0;
+        QBENCHMARK {
+            for (const auto &line : mLines)
+                numIntersections += geometry::findCircleLineIntersections(QPointF(0.0, 0.0), 1.5, line).size();
+        }
+        QVERIFY(numIntersections > 0);
+    }
+
+    void findFurthestCirclePolylineIntersection()
+    {
+        int numFound = 0;
+        QBENCHMARK {
+            for (int i = 0; i + 8 <= mLines.size(); i += 8)
+                numFound += geometry::findFurthestCirclePolylineIntersection(QPointF(0.0, 0.0), 1.5, 8, [this, i](int j) { return mLines.at(i + j).p1(); }).found;
+        }
+        QVERIFY(numFound > 0);
+    }
+
+    void posPointCopy()
+    {
+        QList<PosPoint> copies;
+        copies.reserve(mPosPoints.size());
+        QBENCHMARK {
+            copies.clear();
+            for (const auto &point : mPosPoints)
+                copies.append(point);
+        }
+        QCOMPARE(copies.size(), mPosPoints.size());
+    }
+
+    void posPointAssign()
+    {
+        PosPoint assigned;
+        double sum = 0.0;
+        QBENCHMARK {
+            for (const auto &point : mPosPoints) {
+                assigned = point;
+                sum += assigned.getX();
+            }
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void posPointToPODList()
+    {
+        QVector<pospoint_t> podList;
+        QBENCHMARK {
+            podList = PosPoint::toPODList(mPosPoints);
+        }
+        QCOMPARE(podList.size(), mPosPoints.size());
+    }
+
+    void vByteArrayPackUnpack()
+    {
+        double sum = 0.0;
+        QBENCHMARK {
+            VByteArray packet;
+            for (int i = 0; i < 100; i++) {
+                packet.vbAppendUint8(i);
+                packet.vbAppendInt16(-i);
+                packet.vbAppendUint32(i * 1000);
+                packet.vbAppendDouble32(i * 0.1, 1e4);
+                packet.vbAppendDouble64(i * 0.01, 1e6);
+                packet.vbAppendDouble32Auto(i * 1.5);
+            }
+            while (!packet.isEmpty()) {
+                sum += packet.vbPopFrontUint8();
+                sum += packet.vbPopFrontInt16();
+                sum += packet.vbPopFrontUint32();
+                sum += packet.vbPopFrontDouble32(1e4);
+                sum += packet.vbPopFrontDouble64(1e6);
+                sum += packet.vbPopFrontDouble32Auto();
+            }
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void vByteArrayWriterReader()
+    {
+        double sum = 0.0;
+        QBENCHMARK {
+            QByteArray packet;
+            VByteArrayWriter writer(packet);
+            writer.reserve(100 * 23);
+            for (int i = 0; i < 100; i++) {
+                writer.vbAppendUint8(i);
+                writer.vbAppendInt16(-i);
+                writer.vbAppendUint32(i * 1000);
+                writer.vbAppendDouble32(i * 0.1, 1e4);
+                writer.vbAppendDouble64(i * 0.01, 1e6);
+                writer.vbAppendDouble32Auto(i * 1.5);
+            }
+            VByteArrayReader reader(packet);
+            while (!reader.atEnd()) {
+                sum += reader.vbReadUint8();
+                sum += reader.vbReadInt16();
+                sum += reader.vbReadUint32();
+                sum += reader.vbReadDouble32(1e4);
+                sum += reader.vbReadDouble64(1e6);
+                sum += reader.vbReadDouble32Auto();
+            }
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void trailerKinematicsStepCandidates()
+    {
+        // 64 constant-steering candidates over a 5 m reversing horizon of 0.1 m steps
+        static constexpr int numCandidates = 64;
+        static constexpr int numSteps = 50;
+        const trailerKinematics::Parameters parameters {-0.2, 1.5};
+        std::array<double, numCandidates> curvatures;
+        for (int i = 0; i < numCandidates; i++)
+            curvatures[i] = -0.5 + i / double(numCandidates - 1);
+
+        trailerKinematics::CandidateBatch<numCandidates> batch;
+        double sum = 0.0;
+        QBENCHMARK {
+            batch.reset({0.0, 0.0, 0.0, 0.1}, numCandidates);
+            for (int step = 0; step < numSteps; step++)
+                batch.step(parameters, curvatures.data(), -0.1);
+            sum += batch.trailerYaw_rad[numCandidates / 2];
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void trailerKinematicsLinearize()
+    {
+        const trailerKinematics::Parameters parameters {-0.2, 1.5};
+        trailerKinematics::State state {0.0, 0.0, 0.0, 0.1};
+        trailerKinematics::StateJacobian stateJacobian;
+        trailerKinematics::CurvatureJacobian curvatureJacobian;
+        double sum = 0.0;
+        QBENCHMARK {
+            for (int step = 0; step < 50; step++) {
+                trailerKinematics::linearize(parameters, state, 0.2, -0.1, stateJacobian, curvatureJacobian);
+                state = trailerKinematics::step(parameters, state, 0.2, -0.1);
+            }
+            sum += stateJacobian(3, 3) + curvatureJacobian(3, 0);
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+
+    void steeringGeometryTable_data()
+    {
+        QTest::addColumn<bool>("interpolated");
+        QTest::newRow("direct") << false;
+        QTest::newRow("table") << true;
+    }
+
+    void steeringGeometryTable()
+    {
+        QFETCH(bool, interpolated);
+        SteeringGeometryTable table;
+        table.build(0.33, 25.0 * M_PI / 180.0);
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> ratio(-1.0, 1.0);
+        std::array<double, 1024> ratios;
+        for (double &value : ratios)
+            value = ratio(generator);
+
+        double sum = 0.0;
+        QBENCHMARK {
+            for (double value : ratios) {
+                if (interpolated)
+                    sum += table.getYawCurvature(value * table.getMaxSteering()) + table.getNormalizedSteering(value * table.getMaxCurvature());
+                else
+                    sum += table.computeYawCurvature(value * table.getMaxSteering()) + table.computeNormalizedSteering(value * table.getMaxCurvature());
+            }
+        }
+        QVERIFY(std::isfinite(sum));
+    }
+};
+
+QTEST_APPLESS_MAIN(BenchCore)
+
+#include "bench_core.moc"
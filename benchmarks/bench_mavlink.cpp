@@ -0,0 +1,115 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include <QtTest>
+#include <QElapsedTimer>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+// MAVLink framing (mavlink_parse_char, as in MAVSDK and the fleet emulator) of a vehicle's telemetry as received by the
+// control station, in datagrams. Synthesized unless WAYWISE_BENCH_CORPUS contains mavlink.bin (e.g., captured with nc -u).
+class BenchMavlink : public QObject
+{
+    Q_OBJECT
+
+private:
+    static constexpr int CHUNK_SIZE = 512; // bytes per datagram
+
+    template<typename Encode>
+    static void appendMessage(QByteArray &stream, Encode encode)
+    {
+        mavlink_message_t message;
+        encode(message);
+        uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+        const uint16_t len = mavlink_msg_to_send_buffer(buffer, &message);
+        stream.append(reinterpret_cast<const char*>(buffer), len);
+    }
+
+    QVector<QByteArray> mChunks;
+    qint64 mBytes = 0;
+
+private slots:
+    void initTestCase()
+    {
+        // One second of a WayWise vehicle: position streams at 10 Hz, status at 1 Hz
+        QByteArray stream;
+        const mavlink_channel_t channel = MAVLINK_COMM_1;
+        for (int i = 0; i < 10; i++) {
+            mavlink_global_position_int_t globalPosition;
+            memset(&globalPosition, 0, sizeof(globalPosition));
+            globalPosition.time_boot_ms = 1000 + i * 100;
+            globalPosition.lat = 577149586 + i;
+            globalPosition.lon = 128913492 - i;
+            globalPosition.hdg = 9000;
+            appendMessage(stream, [&](mavlink_message_t &message) {
+                mavlink_msg_global_position_int_encode_chan(1, MAV_COMP_ID_AUTOPILOT1, channel, &message, &globalPosition); });
+
+            mavlink_local_position_ned_t localPosition;
+            memset(&localPosition, 0, sizeof(localPosition));
+            localPosition.time_boot_ms = globalPosition.time_boot_ms;
+            localPosition.x = 0.1f * i;
+            localPosition.vx = 1.0f;
+            appendMessage(stream, [&](mavlink_message_t &message) {
+                mavlink_msg_local_position_ned_encode_chan(1, MAV_COMP_ID_AUTOPILOT1, channel, &message, &localPosition); });
+
+            mavlink_attitude_t attitude;
+            memset(&attitude, 0, sizeof(attitude));
+            attitude.time_boot_ms = globalPosition.time_boot_ms;
+            attitude.yaw = 0.01f * i;
+            appendMessage(stream, [&](mavlink_message_t &message) {
+                mavlink_msg_attitude_encode_chan(1, MAV_COMP_ID_AUTOPILOT1, channel, &message, &attitude); });
+        }
+        mavlink_heartbeat_t heartbeat;
+        memset(&heartbeat, 0, sizeof(heartbeat));
+        heartbeat.type = MAV_TYPE_GROUND_ROVER;
+        heartbeat.autopilot = MAV_AUTOPILOT_GENERIC;
+        heartbeat.system_status = MAV_STATE_ACTIVE;
+        appendMessage(stream, [&](mavlink_message_t &message) {
+            mavlink_msg_heartbeat_encode_chan(1, MAV_COMP_ID_AUTOPILOT1, channel, &message, &heartbeat); });
+        mavlink_sys_status_t sysStatus;
+        memset(&sysStatus, 0, sizeof(sysStatus));
+        sysStatus.voltage_battery = 12000;
+        sysStatus.battery_remaining = 80;
+        appendMessage(stream, [&](mavlink_message_t &message) {
+            mavlink_msg_sys_status_encode_chan(1, MAV_COMP_ID_AUTOPILOT1, channel, &message, &sysStatus); });
+
+        const QString corpusPath = qEnvironmentVariable("WAYWISE_BENCH_CORPUS");
+        QFile corpus(QDir(corpusPath).filePath("mavlink.bin"));
+        if (!corpusPath.isEmpty() && corpus.open(QIODevice::ReadOnly)) {
+            qInfo() << "Using captured" << corpus.fileName() << "(" << corpus.size() << "bytes)";
+            stream = corpus.readAll();
+        }
+
+        for (int i = 0; i < stream.size(); i += CHUNK_SIZE)
+            mChunks.append(stream.mid(i, CHUNK_SIZE));
+        mBytes = stream.size();
+    }
+
+    void mavlinkParseChar()
+    {
+        mavlink_message_t message;
+        mavlink_status_t status;
+        memset(&status, 0, sizeof(status));
+        quint64 messages = 0;
+
+        int passes = 0;
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK {
+            for (const QByteArray &chunk : mChunks)
+                for (const char c : chunk)
+                    if (mavlink_parse_char(MAVLINK_COMM_0, uint8_t(c), &message, &status))
+                        messages++;
+            passes++;
+        }
+
+        const double elapsed_s = timer.nsecsElapsed() * 1e-9;
+        qInfo().noquote() << QString("mavlinkParseChar: %1 MB/s, %2 messages/s")
+                             .arg(passes * mBytes / elapsed_s / 1e6, 0, 'f', 1).arg(messages / elapsed_s, 0, 'f', 0);
+        QVERIFY(messages > 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(BenchMavlink)
+
+#include "bench_mavlink.moc"
@@ -0,0 +1,292 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include <QtTest>
+#include <QElapsedTimer>
+#include "sensors/gnss/ublox.h"
+#include "sensors/gnss/rtcm3_simple.h"
+#include "sensors/gnss/rtcmclient.h"
+#include "external/vesc/vescpacket.h"
+#include "external/vesc/datatypes.h"
+#include "communication/jsonstreamparsertcp.h"
+
+// Throughput of the stream decoders on byte streams as received, in chunks as read from serial ports and sockets.
+// Streams are synthesized unless a captured one is found in the directory given by WAYWISE_BENCH_CORPUS
+// (ubx.bin, rtcm3.bin, vesc.bin, json.txt, e.g., recorded with a raw data tap or captured with nc/cat).
+class BenchParsers : public QObject
+{
+    Q_OBJECT
+
+private:
+    static constexpr int CHUNK_SIZE = 512; // bytes per read
+
+    static QByteArray encodeUbx(uint8_t msgClass, uint8_t id, const QByteArray &payload)
+    {
+        QByteArray frame;
+        frame.append((char)0xB5);
+        frame.append((char)0x62);
+        frame.append((char)msgClass);
+        frame.append((char)id);
+        frame.append((char)(payload.size() & 0xFF));
+        frame.append((char)(payload.size() >> 8));
+        frame.append(payload);
+
+        uint8_t ckA = 0, ckB = 0;
+        for (int i = 2; i < frame.size(); i++) {
+            ckA += (uint8_t)frame.at(i);
+            ckB += ckA;
+        }
+        frame.append((char)ckA);
+        frame.append((char)ckB);
+        return frame;
+    }
+
+    static QByteArray loadCorpus(const QString &filename, const QByteArray &synthetic)
+    {
+        const QString corpusPath = qEnvironmentVariable("WAYWISE_BENCH_CORPUS");
+        if (!corpusPath.isEmpty()) {
+            QFile file(QDir(corpusPath).filePath(filename));
+            if (file.open(QIODevice::ReadOnly)) {
+                qInfo() << "Using captured" << file.fileName() << "(" << file.size() << "bytes)";
+                return file.readAll();
+            }
+        }
+        return synthetic;
+    }
+
+    static QVector<QByteArray> toChunks(const QByteArray &stream)
+    {
+        QVector<QByteArray> chunks;
+        for (int i = 0; i < stream.size(); i += CHUNK_SIZE)
+            chunks.append(stream.mid(i, CHUNK_SIZE));
+        return chunks;
+    }
+
+    // QBENCHMARK reports the time per pass, the rates are printed in addition
+    static void reportThroughput(const QElapsedTimer &timer, int passes, qint64 bytesPerPass, quint64 messages)
+    {
+        const double elapsed_s = timer.nsecsElapsed() * 1e-9;
+        if (passes == 0 || elapsed_s <= 0.0)
+            return;
+        qInfo().noquote() << QString("%1: %2 MB/s, %3 messages/s").arg(QTest::currentTestFunction())
+                             .arg(passes * bytesPerPass / elapsed_s / 1e6, 0, 'f', 1).arg(messages / elapsed_s, 0, 'f', 0);
+    }
+
+    static void appendRtcm(QByteArray &stream, const uint8_t *buffer, int len)
+    {
+        stream.append(reinterpret_cast<const char*>(buffer), len);
+    }
+
+    QVector<QByteArray> mUbxChunks;
+    qint64 mUbxBytes = 0;
+    QVector<QByteArray> mRtcmChunks;
+    qint64 mRtcmBytes = 0;
+    QVector<QByteArray> mVescChunks;
+    qint64 mVescBytes = 0;
+    QVector<QByteArray> mJsonChunks;
+    qint64 mJsonBytes = 0;
+
+private slots:
+    void initTestCase()
+    {
+        // One second of a rover as on the RCCar: NAV-PVT at 20 Hz, RXM-RAWX with 32 measurements and ESF-MEAS at 10 Hz
+        QByteArray ubxStream;
+        QByteArray navPvtPayload(92, 0);
+        for (int i = 0; i < navPvtPayload.size(); i++)
+            navPvtPayload[i] = (char)(i * 37);
+        QByteArray rawxPayload(16 + 32 * 32, 0);
+        rawxPayload[11] = 32;
+        for (int i = 16; i < rawxPayload.size(); i++)
+            rawxPayload[i] = (char)(i * 13);
+        QByteArray esfMeasPayload(8 + 4 * 4, 0);
+        for (int i = 8; i < esfMeasPayload.size(); i++)
+            esfMeasPayload[i] = (char)(i * 7 & 0x3F);
+        for (int i = 0; i < 20; i++) {
+            ubxStream.append(encodeUbx(UBX_CLASS_NAV, UBX_NAV_PVT, navPvtPayload));
+            if (i % 2 == 0) {
+                ubxStream.append(encodeUbx(UBX_CLASS_RXM, UBX_RXM_RAWX, rawxPayload));
+                ubxStream.append(encodeUbx(UBX_CLASS_ESF, UBX_ESF_MEAS, esfMeasPayload));
+            }
+        }
+        ubxStream = loadCorpus("ubx.bin", ubxStream);
+        mUbxChunks = toChunks(ubxStream);
+        mUbxBytes = ubxStream.size();
+
+        // One second of corrections: legacy GPS 1002 and 1006, MSM7 for GPS, GLONASS, Galileo and BeiDou
+        QByteArray rtcmStream;
+        uint8_t buffer[1100];
+        int len = 0;
+        rtcm_obs_header_t header;
+        memset(&header, 0, sizeof(header));
+        header.t_tow = 302400.0;
+        header.t_tod = 43200.0;
+        header.dow = 7;
+        header.staid = 1;
+        rtcm_obs_t obs[16];
+        memset(obs, 0, sizeof(obs));
+        for (int i = 0; i < 16; i++) {
+            obs[i].prn = i + 1;
+            obs[i].freq = 7;
+            for (int f = 0; f < 2; f++) {
+                obs[i].P[f] = 2.0e7 + i * 1.0e5 + f * 10.0;
+                obs[i].L[f] = obs[i].P[f] / (f == 0 ? 0.19029 : 0.24421);
+                obs[i].cn0[f] = 40 + i;
+                obs[i].lock[f] = 127;
+            }
+        }
+        header.sync = true;
+        if (rtcm3_encode_1002(&header, obs, 12, buffer, &len) > 0)
+            appendRtcm(rtcmStream, buffer, len);
+        for (int type : {1077, 1087, 1097, 1127}) {
+            header.sync = type != 1127;
+            if (rtcm3_encode_msm(&header, obs, 12, type, buffer, &len) > 0)
+                appendRtcm(rtcmStream, buffer, len);
+        }
+        rtcm_ref_sta_pos_t pos = {1, 57.71495867, 12.89134921, 200.0, 0.0};
+        if (rtcm3_encode_1006(pos, buffer, &len) > 0)
+            appendRtcm(rtcmStream, buffer, len);
+        QVERIFY(!rtcmStream.isEmpty());
+        rtcmStream = loadCorpus("rtcm3.bin", rtcmStream);
+        mRtcmChunks = toChunks(rtcmStream);
+        mRtcmBytes = rtcmStream.size();
+
+        // Motor controller at 50 Hz: RPM commands and value replies
+        QByteArray vescStream;
+        VESC::Packet packet;
+        connect(&packet, &VESC::Packet::dataToSend, this, [&vescStream](const QByteArray data) { vescStream.append(data); });
+        QByteArray setRpm(5, 0);
+        setRpm[0] = VESC::COMM_SET_RPM;
+        QByteArray getValues(74, 0);
+        getValues[0] = VESC::COMM_GET_VALUES;
+        for (int i = 1; i < getValues.size(); i++)
+            getValues[i] = (char)(i * 29);
+        for (int i = 0; i < 50; i++) {
+            setRpm[4] = (char)i;
+            packet.sendPacket(setRpm);
+            packet.sendPacket(getValues);
+        }
+        vescStream = loadCorpus("vesc.bin", vescStream);
+        mVescChunks = toChunks(vescStream);
+        mVescBytes = vescStream.size();
+
+        // Camera detections, newline-delimited (see DepthAiCamera)
+        QByteArray jsonStream;
+        for (int i = 0; i < 30; i++)
+            jsonStream.append(QString("{\"timestamp\":%1,\"detections\":[{\"label\":\"person\",\"confidence\":0.%2,"
+                                      "\"xmin\":0.1,\"ymin\":0.2,\"xmax\":0.3,\"ymax\":0.4,\"x\":1.25,\"y\":-0.5,\"z\":%3}]}\n")
+                              .arg(1700000000000LL + i * 33).arg(50 + i).arg(2.0 + i * 0.1).toUtf8());
+        jsonStream = loadCorpus("json.txt", jsonStream);
+        mJsonChunks = toChunks(jsonStream);
+        mJsonBytes = jsonStream.size();
+    }
+
+    // Ublox::serialDataAvailable hands each read to decodeData
+    void ubloxDecodeData()
+    {
+        Ublox ublox;
+        quint64 messages = 0;
+        connect(&ublox, &Ublox::rxNavPvt, this, [&messages](const ubx_nav_pvt &) { messages++; });
+        connect(&ublox, &Ublox::rxRawx, this, [&messages](const ubx_rxm_rawx &) { messages++; });
+        connect(&ublox, &Ublox::rxEsfMeas, this, [&messages](const ubx_esf_meas &) { messages++; });
+
+        int passes = 0;
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK {
+            for (const QByteArray &chunk : mUbxChunks)
+                ublox.decodeData(chunk);
+            passes++;
+        }
+        reportThroughput(timer, passes, mUbxBytes, messages);
+        QVERIFY(messages > 0);
+    }
+
+    // Framing and decoding of all observations, as with rtcm3_input_payload in RtcmClient
+    void rtcm3InputData()
+    {
+        rtcm3_state state;
+        rtcm3_init_state(&state);
+        state.decode_all = true;
+        quint64 messages = 0;
+
+        int passes = 0;
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK {
+            for (const QByteArray &chunk : mRtcmChunks) {
+                const uint8_t *data = reinterpret_cast<const uint8_t*>(chunk.constData());
+                for (int i = 0; i < chunk.size(); i++) {
+                    const int consumed = rtcm3_input_payload(data + i, chunk.size() - i, &state);
+                    if (consumed > 0) {
+                        i += consumed - 1;
+                        continue;
+                    }
+                    if (rtcm3_input_data(data[i], &state) >= 1000)
+                        messages++;
+                }
+            }
+            passes++;
+        }
+        reportThroughput(timer, passes, mRtcmBytes, messages);
+        QVERIFY(messages > 0);
+    }
+
+    // Health framing, reference station search and forwarding (unfiltered)
+    void rtcmClientProcessData()
+    {
+        RtcmClient rtcmClient;
+        int passes = 0;
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK {
+            for (const QByteArray &chunk : mRtcmChunks)
+                rtcmClient.processData(chunk);
+            passes++;
+        }
+        reportThroughput(timer, passes, mRtcmBytes, rtcmClient.getHealth().messages);
+        QVERIFY(rtcmClient.getHealth().messages > 0);
+    }
+
+    void vescPacketProcessData()
+    {
+        VESC::Packet packet;
+        quint64 messages = 0;
+        connect(&packet, &VESC::Packet::packetReceived, this, [&messages](QByteArray &) { messages++; });
+
+        int passes = 0;
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK {
+            for (const QByteArray &chunk : mVescChunks)
+                packet.processData(chunk);
+            passes++;
+        }
+        reportThroughput(timer, passes, mVescBytes, messages);
+        QVERIFY(messages > 0);
+    }
+
+    // Incremental framing and QJsonDocument parsing (JsonStreamParserTcp::parseJson hands each read to processData)
+    void jsonStreamParse()
+    {
+        JsonStreamParserTcp parser;
+        quint64 messages = 0;
+        connect(&parser, &JsonStreamParserTcp::gotJsonObject, this, [&messages](const QJsonObject &) { messages++; });
+        connect(&parser, &JsonStreamParserTcp::gotJsonArray, this, [&messages](const QJsonArray &) { messages++; });
+
+        int passes = 0;
+        QElapsedTimer timer;
+        timer.start();
+        QBENCHMARK {
+            for (const QByteArray &chunk : mJsonChunks)
+                parser.processData(chunk);
+            passes++;
+        }
+        reportThroughput(timer, passes, mJsonBytes, messages);
+        QVERIFY(messages > 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(BenchParsers)
+
+#include "bench_parsers.moc"
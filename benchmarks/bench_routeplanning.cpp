@@ -0,0 +1,208 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include <QtTest>
+#include "routeplanning/zigzagroutegenerator.h"
+#include "routeplanning/coverageplanner.h"
+#include "routeplanning/routeprocessing.h"
+#include "routeplanning/missionsequencer.h"
+#include "routeplanning/hybridastarplanner.h"
+#include "routeplanning/routedeconfliction.h"
+#include "routeplanning/polygonoffset.h"
+
+class BenchRoutePlanning : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fillConvexPolygonWithZigZag()
+    {
+        const QList<PosPoint> bounds = {PosPoint(0.0, 0.0), PosPoint(100.0, 0.0), PosPoint(120.0, 60.0), PosPoint(10.0, 80.0)};
+        QList<PosPoint> route;
+        QBENCHMARK {
+            route = ZigZagRouteGenerator::fillConvexPolygonWithZigZag(bounds, 2.0, true, 1.0, 0.5, 10, 1, 0, 0, 0.0, 0.0);
+        }
+        QVERIFY(!route.isEmpty());
+    }
+
+    void fillConvexPolygonWithCurvedZigZag()
+    {
+        // Spacing below two turn radii: Dubins loops or Reeds-Shepp turns with reversing
+        const QList<PosPoint> bounds = {PosPoint(0.0, 0.0), PosPoint(100.0, 0.0), PosPoint(120.0, 60.0), PosPoint(10.0, 80.0)};
+        QList<PosPoint> route;
+        QBENCHMARK {
+            route = ZigZagRouteGenerator::fillConvexPolygonWithCurvedZigZag(bounds, 2.0, 3.0, true, 0.05, 1.0, 0.5, 0, 0, 0, 0.0, 0.0);
+        }
+        QVERIFY(!route.isEmpty());
+    }
+
+    void getAllIntersectionsFineSpacing()
+    {
+        // Parallels of a 0.1 m spaced zig-zag over a 200 m field with curved bounds
+        QList<PosPoint> lines, bounds;
+        for (int i = 0; i < 2000; i++) {
+            lines.append(PosPoint(i % 2 ? 1000.0 : -1000.0, i * 0.1));
+            lines.append(PosPoint(i % 2 ? -1000.0 : 1000.0, i * 0.1));
+        }
+        for (int i = 0; i <= 100; i++)
+            bounds.append(PosPoint(100.0 + 100.0 * cos(2.0 * M_PI * i / 100), 100.0 + 100.0 * sin(2.0 * M_PI * i / 100)));
+
+        QList<PosPoint> intersections;
+        QBENCHMARK {
+            intersections = ZigZagRouteGenerator::getAllIntersections(lines, bounds);
+        }
+        QVERIFY(!intersections.isEmpty());
+    }
+
+    void fillPolygonWithHolesWithZigZag()
+    {
+        // Surveyed field boundary with thousands of vertices and a few obstacles
+        QList<PosPoint> bounds;
+        for (int i = 0; i < 4000; i++) {
+            const double angle = 2.0 * M_PI * i / 4000;
+            const double radius = 200.0 + 30.0 * sin(5.0 * angle);
+            bounds.append(PosPoint(radius * cos(angle), radius * sin(angle)));
+        }
+        QList<QList<PosPoint>> holes;
+        for (int i = 0; i < 3; i++)
+            holes.append({PosPoint(-100.0 + i * 80.0, -10.0), PosPoint(-80.0 + i * 80.0, -10.0), PosPoint(-80.0 + i * 80.0, 10.0), PosPoint(-100.0 + i * 80.0, 10.0)});
+
+        QList<PosPoint> route;
+        QBENCHMARK {
+            route = CoveragePlanner::fillPolygonWithZigZag(bounds, holes, 2.0, false, 1.0, 0.5, 10, 0, 0, 0, 0.0, 0.0);
+        }
+        QVERIFY(!route.isEmpty());
+    }
+
+    void getPolygonInsetRings()
+    {
+        // Frames 2 m apart inside the surveyed field boundary, the lobes split off in the innermost ones
+        QVector<QPointF> bounds;
+        for (int i = 0; i < 4000; i++) {
+            const double angle = 2.0 * M_PI * i / 4000;
+            const double radius = 200.0 + 30.0 * sin(5.0 * angle);
+            bounds.append(QPointF(radius * cos(angle), radius * sin(angle)));
+        }
+
+        QVector<QVector<polygonOffset::OffsetPolygon>> rings;
+        QBENCHMARK {
+            rings = polygonOffset::getInsetRings(bounds, 2.0, 10);
+        }
+        QCOMPARE(rings.size(), 10);
+    }
+
+    void simplifyRecordedRoute()
+    {
+        // 100k points recorded at 0.05 m along a winding path with some noise
+        QVector<pospoint_t> route(100000);
+        for (int i = 0; i < route.size(); i++) {
+            const double s = i * 0.05;
+            route[i].x = s;
+            route[i].y = 20.0 * sin(s / 30.0) + 0.01 * sin(i * 1.7);
+            route[i].speed = (i / 20000) % 2 ? 1.0 : 2.0;
+        }
+
+        QVector<pospoint_t> simplified;
+        QBENCHMARK {
+            simplified = routeProcessing::simplify(route, 0.05);
+        }
+        QVERIFY(simplified.size() > 2 && simplified.size() < route.size() / 10);
+    }
+
+    void resampleAndSmoothZigZag()
+    {
+        const QList<PosPoint> bounds = {PosPoint(0.0, 0.0), PosPoint(100.0, 0.0), PosPoint(120.0, 60.0), PosPoint(10.0, 80.0)};
+        const QVector<pospoint_t> route = PosPoint::toPODList(ZigZagRouteGenerator::fillConvexPolygonWithZigZag(bounds, 2.0, false, 1.0, 1.0, 0, 1, 0, 0, 0.0, 0.0));
+
+        QVector<pospoint_t> processed;
+        QBENCHMARK {
+            processed = routeProcessing::resample(routeProcessing::smoothCorners(route, 1.0), 0.5);
+        }
+        QVERIFY(processed.size() > route.size());
+    }
+
+    void sequenceFields()
+    {
+        // 200 fields on a grid drawn in random order, each with two zig-zag variants
+        QList<MissionSequencer::Task> tasks;
+        QRandomGenerator random(1);
+        for (int i = 0; i < 200; i++) {
+            const double x = random.bounded(20) * 60.0;
+            const double y = random.bounded(20) * 60.0;
+            QVector<pospoint_t> variant0(2), variant1(2);
+            variant0[0].x = x; variant0[0].y = y; variant0[1].x = x + 50.0; variant0[1].y = y + 50.0;
+            variant1[0].x = x + 50.0; variant1[0].y = y; variant1[1].x = x; variant1[1].y = y + 50.0;
+            tasks.append({{variant0, variant1}});
+        }
+
+        MissionSequencer::Options options;
+        options.useStartPoint = true;
+        options.maxDuration_ms = 10000;
+        const std::atomic<bool> cancel {false};
+        MissionSequencer::Sequence sequence;
+        QBENCHMARK {
+            sequence = MissionSequencer::optimize(tasks, options, cancel);
+        }
+        QCOMPARE(sequence.steps.size(), tasks.size());
+    }
+
+    void planAroundWall()
+    {
+        // Wall of 5 m across the direct line to a goal 9 m ahead, one search without heuristic weight
+        QSharedPointer<OccupancyGrid> grid(new OccupancyGrid(8, 0.1));
+        grid->setCenter(QPointF(5.0, 0.0));
+        for (double y = -3.0; y <= 2.0; y += 0.05)
+            for (int i = 0; i < 3; i++)
+                grid->insertHit(QPointF(5.0, y));
+
+        HybridAStarPlanner::Problem problem;
+        problem.goal = QPointF(9.0, 0.0);
+        problem.goalYaw_rad = 0.0;
+        problem.occupancyGrid = grid;
+        HybridAStarPlanner::Parameters parameters;
+        parameters.initialHeuristicWeight = 1.0;
+        parameters.maxDuration_ms = 10000;
+
+        const std::atomic<bool> cancel {false};
+        HybridAStarPlanner::Result result;
+        QBENCHMARK {
+            result = HybridAStarPlanner::plan(problem, parameters, cancel);
+        }
+        QVERIFY(result.isFound());
+    }
+
+    void findRouteConflictsAfterEdit()
+    {
+        // 20 vehicles on a 10 m grid of 200 m straight routes, neighbours meet at the diagonal. One route changes.
+        auto getRoute = [](int vehicle, double offset_m) {
+            QVector<pospoint_t> route;
+            const double position_m = (vehicle / 2) * 10.0 + offset_m;
+            for (int i = 0; i <= 40; i++) {
+                pospoint_t point;
+                point.x = (vehicle % 2) ? -100.0 + i * 5.0 : position_m;
+                point.y = (vehicle % 2) ? position_m : -100.0 + i * 5.0;
+                point.speed = 3.0;
+                route.append(point);
+            }
+            return route;
+        };
+        const QRectF footprint(-0.5, -0.4, 2.0, 0.8);
+        RouteDeconfliction deconfliction;
+        for (int vehicle = 0; vehicle < 20; vehicle++)
+            deconfliction.setVehicleRoute(vehicle, getRoute(vehicle, 0.0), footprint);
+
+        QVector<RouteConflict> conflicts;
+        int edit = 0;
+        QBENCHMARK {
+            deconfliction.setVehicleRoute(4, getRoute(4, (edit++ % 2) ? 0.0 : 0.5), footprint);
+            conflicts = deconfliction.findConflicts(4);
+        }
+        QVERIFY(!deconfliction.findConflicts().isEmpty());
+        QVERIFY(!deconfliction.proposeStartDelays(deconfliction.getVehicleIds()).isEmpty());
+    }
+};
+
+QTEST_APPLESS_MAIN(BenchRoutePlanning)
+
+#include "bench_routeplanning.moc"
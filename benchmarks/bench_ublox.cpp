@@ -0,0 +1,196 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include <QtTest>
+#include "sensors/gnss/ublox.h"
+#include "sensors/gnss/rtcmbits.h"
+
+class BenchUblox : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QByteArray encodeUbx(uint8_t msgClass, uint8_t id, const QByteArray &payload)
+    {
+        QByteArray frame;
+        frame.append((char)0xB5);
+        frame.append((char)0x62);
+        frame.append((char)msgClass);
+        frame.append((char)id);
+        frame.append((char)(payload.size() & 0xFF));
+        frame.append((char)(payload.size() >> 8));
+        frame.append(payload);
+
+        uint8_t ckA = 0, ckB = 0;
+        for (int i = 2; i < frame.size(); i++) {
+            ckA += (uint8_t)frame.at(i);
+            ckB += ckA;
+        }
+        frame.append((char)ckA);
+        frame.append((char)ckB);
+        return frame;
+    }
+
+    // Bit by bit and byte-wise as in RTKLIB (previous implementation), for comparison
+    static unsigned int legacyGetbitu(const uint8_t *buff, int pos, int len)
+    {
+        unsigned int bits = 0;
+        for (int i = pos; i < pos + len; i++)
+            bits = (bits << 1) + ((buff[i / 8] >> (7 - i % 8)) & 1u);
+        return bits;
+    }
+
+    static unsigned int legacyCrc24q(const uint8_t *buff, int len)
+    {
+        const auto &table = rtcmBits::detail::CRC24Q_TABLES[0]; // same as RTKLIB's tbl_CRC24Q
+        unsigned int crc = 0;
+        for (int i = 0; i < len; i++)
+            crc = ((crc << 8) & 0xFFFFFF) ^ table[(crc >> 16) ^ buff[i]];
+        return crc;
+    }
+
+    template<typename GetBitU>
+    static quint64 decodeObservationFields(const QByteArray &message, GetBitU getbitu)
+    {
+        // Field widths of a 1004 (GPS L1/L2 extended) satellite block
+        static constexpr int fieldWidths[] = {6, 1, 24, 20, 7, 8, 8, 2, 14, 20, 7, 8};
+        const uint8_t *buff = reinterpret_cast<const uint8_t*>(message.constData());
+        quint64 sum = 0;
+        int pos = 24 + 64;
+        while (pos + 125 <= (message.size() - 3) * 8)
+            for (int width : fieldWidths) {
+                sum += getbitu(buff, pos, width);
+                pos += width;
+            }
+        return sum;
+    }
+
+    QByteArray mReceivedData;
+    int mNumNavPvtPerBlock = 0;
+    QByteArray mRtcmMessage;
+    QByteArray mNavSatData;
+    int mNumNavSatPerBlock = 0;
+
+private slots:
+    void initTestCase()
+    {
+        // One second of NAV-PVT at 20 Hz, same as a receiver configured for the RCCar, with payload that is not all zeros
+        QByteArray navPvtPayload(92, 0);
+        for (int i = 0; i < navPvtPayload.size(); i++)
+            navPvtPayload[i] = (char)(i * 37);
+
+        for (int i = 0; i < 20; i++) {
+            mReceivedData.append(encodeUbx(UBX_CLASS_NAV, UBX_NAV_PVT, navPvtPayload));
+            mNumNavPvtPerBlock++;
+        }
+        mReceivedData.append("$GNGGA,120020.115,5743.153,N,01256.431,E,1,12,1.0,0.0,M,0.0,M,,*6E\r\n");
+
+        // One second of NAV-SAT at 10 Hz with 40 satellites
+        QByteArray navSatPayload(8 + 40 * 12, 0);
+        navSatPayload[5] = 40;
+        for (int i = 8; i < navSatPayload.size(); i++)
+            navSatPayload[i] = (char)(i * 13);
+        for (int i = 0; i < 10; i++) {
+            mNavSatData.append(encodeUbx(UBX_CLASS_NAV, UBX_NAV_SAT, navSatPayload));
+            mNumNavSatPerBlock++;
+        }
+
+        // Largest RTCM3 message (1023 bytes payload) with pseudo-random content
+        mRtcmMessage.resize(3 + 1023 + 3);
+        for (int i = 0; i < mRtcmMessage.size(); i++)
+            mRtcmMessage[i] = (char)(i * 131 + (i >> 3));
+
+        const uint8_t *buff = reinterpret_cast<const uint8_t*>(mRtcmMessage.constData());
+        QCOMPARE(rtcmBits::crc24q(buff, mRtcmMessage.size()), legacyCrc24q(buff, mRtcmMessage.size()));
+        QCOMPARE(decodeObservationFields(mRtcmMessage, [](const uint8_t *buff, int pos, int len) { return rtcmBits::getbitu(buff, pos, len); }),
+                 decodeObservationFields(mRtcmMessage, legacyGetbitu));
+    }
+
+    void decodeNavPvt()
+    {
+        Ublox ublox;
+        int numNavPvt = 0;
+        connect(&ublox, &Ublox::rxNavPvt, this, [&numNavPvt](const ubx_nav_pvt &) { numNavPvt++; });
+
+        int numBlocks = 0;
+        QBENCHMARK {
+            ublox.decodeData(mReceivedData);
+            numBlocks++;
+        }
+        QCOMPARE(numNavPvt, numBlocks * mNumNavPvtPerBlock);
+    }
+
+    // Signal to a receiver in another thread (as with the I/O thread), i.e., a copy through the event queue
+    void decodeNavSatQueuedSignal()
+    {
+        qRegisterMetaType<ubx_nav_sat>();
+        Ublox ublox;
+        int numNavSat = 0;
+        connect(&ublox, &Ublox::rxNavSat, this, [&numNavSat](const ubx_nav_sat &) { numNavSat++; }, Qt::QueuedConnection);
+
+        int numBlocks = 0;
+        QBENCHMARK {
+            ublox.decodeData(mNavSatData);
+            QCoreApplication::processEvents();
+            numBlocks++;
+        }
+        QCOMPARE(numNavSat, numBlocks * mNumNavSatPerBlock);
+    }
+
+    void decodeNavSatSubscribed()
+    {
+        Ublox ublox;
+        int numNavSat = 0;
+        ublox.subscribeDecoded<ubx_nav_sat>([&numNavSat](const ubx_nav_sat &) { numNavSat++; });
+
+        int numBlocks = 0;
+        QBENCHMARK {
+            ublox.decodeData(mNavSatData);
+            numBlocks++;
+        }
+        QCOMPARE(numNavSat, numBlocks * mNumNavSatPerBlock);
+    }
+
+    void rtcmGetbituLegacy()
+    {
+        quint64 sum = 0;
+        QBENCHMARK {
+            sum += decodeObservationFields(mRtcmMessage, legacyGetbitu);
+        }
+        QVERIFY(sum > 0);
+    }
+
+    void rtcmGetbitu()
+    {
+        quint64 sum = 0;
+        QBENCHMARK {
+            sum += decodeObservationFields(mRtcmMessage, [](const uint8_t *buff, int pos, int len) { return rtcmBits::getbitu(buff, pos, len); });
+        }
+        QVERIFY(sum > 0);
+    }
+
+    void rtcmCrc24qLegacy()
+    {
+        const uint8_t *buff = reinterpret_cast<const uint8_t*>(mRtcmMessage.constData());
+        unsigned int crc = 0;
+        QBENCHMARK {
+            crc ^= legacyCrc24q(buff, mRtcmMessage.size());
+        }
+        Q_UNUSED(crc)
+    }
+
+    void rtcmCrc24q()
+    {
+        const uint8_t *buff = reinterpret_cast<const uint8_t*>(mRtcmMessage.constData());
+        unsigned int crc = 0;
+        QBENCHMARK {
+            crc ^= rtcmBits::crc24q(buff, mRtcmMessage.size());
+        }
+        Q_UNUSED(crc)
+    }
+};
+
+QTEST_GUILESS_MAIN(BenchUblox)
+
+#include "bench_ublox.moc"
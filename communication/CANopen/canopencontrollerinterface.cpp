@@ -8,6 +8,10 @@
 #include <QObject>
 #include <QThread>
 #include <QTimer>
+#include "core/commandlatencytrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 
 #include <lely/ev/loop.hpp>
@@ -22,28 +26,48 @@
 
 using namespace lely;
 
-void CANopenControllerInterface::actualSpeedReceived(double speed) {
-    emit sendActualSpeed(speed);
+void CANopenPdoTimingStatistics::addSample(double latency_us) {
+    if (samples > 0) {
+        const double jitter_us = fabs(latency_us - lastLatency_us);
+        maxJitter_us = std::max(maxJitter_us, jitter_us);
+        meanJitter_us += (jitter_us - meanJitter_us) / samples;
+    }
+    samples++;
+    lastLatency_us = latency_us;
+    maxLatency_us = std::max(maxLatency_us, latency_us);
+    meanLatency_us += (latency_us - meanLatency_us) / samples;
 }
 
-void CANopenControllerInterface::actualSteeringReceived(double steering) {
-    emit sendActualSteeringCurvature(steering);
+qint64 CANopenControllerInterface::getMonotonicTime_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-void CANopenControllerInterface::commandSpeedReceived(const double &speed) {
-    emit sendCommandSpeed(speed);
+CANopenPdoStatistics CANopenControllerInterface::getPdoStatistics() {
+    std::lock_guard<std::mutex> lock(mPdoStatisticsMutex);
+    return mPdoStatistics;
 }
 
-void CANopenControllerInterface::commandSteeringReceived(const double &steering) {
-    emit sendCommandSteering(steering);
+void CANopenControllerInterface::resetPdoStatistics() {
+    std::lock_guard<std::mutex> lock(mPdoStatisticsMutex);
+    mPdoStatistics = CANopenPdoStatistics();
 }
 
-void CANopenControllerInterface::commandStatusReceived(quint8 status) {
-    emit sendCommandStatus(status);
+void CANopenControllerInterface::addPdoTimingSample(CANopenPdoTimingStatistics CANopenPdoStatistics::*signal, qint64 latency_ns) {
+    std::lock_guard<std::mutex> lock(mPdoStatisticsMutex);
+    (mPdoStatistics.*signal).addSample(latency_ns / 1000.0);
+}
+
+// Called from MySlave::OnWrite, i.e., when the RPDO is applied
+void CANopenControllerInterface::actualSpeedReceived(double speed) {
+    emit sendActualSpeed(speed, getMonotonicTime_ns());
 }
 
-void CANopenControllerInterface::actualStatusReceived(const quint8 &status) {
-    emit sendActualStatus(status);
+void CANopenControllerInterface::actualSteeringReceived(double steering) {
+    emit sendActualSteeringCurvature(steering, getMonotonicTime_ns());
+}
+
+void CANopenControllerInterface::commandStatusReceived(quint8 status) {
+    emit sendCommandStatus(status);
 }
 
 void CANopenControllerInterface::batterySOCReceived(double batterysoc) {
@@ -54,16 +78,96 @@ void CANopenControllerInterface::batteryVoltageReceived(double batteryvoltage) {
     emit sendBatteryVoltage(batteryvoltage);
 }
 
-void CANopenControllerInterface::commandAttributesReceived(const quint32 &attributes) {
-    emit sendCommandAttributes(attributes);
+void CANopenControllerInterface::setCommandSpeed(double speed) {
+    mCommandSpeed.publish({speed, getMonotonicTime_ns()});
+}
+
+void CANopenControllerInterface::setCommandSteeringCurvature(double steeringCurvature) {
+    mCommandSteeringCurvature.publish({steeringCurvature, getMonotonicTime_ns()});
+}
+
+void CANopenControllerInterface::setActualStatus(quint8 status) {
+    pushCommandEvent(CommandEvent::Type::ACTUAL_STATUS, [status](CommandEvent &event) { event.status = status; });
+}
+
+void CANopenControllerInterface::setCommandAttributes(quint32 attributes) {
+    pushCommandEvent(CommandEvent::Type::ATTRIBUTES, [attributes](CommandEvent &event) { event.attributes = attributes; });
+}
+
+void CANopenControllerInterface::setGNSSData(const ubx_nav_pvt &pvt) {
+    pushCommandEvent(CommandEvent::Type::GNSS_DATA, [&pvt](CommandEvent &event) { event.gnssData = pvt; });
+}
+
+void CANopenControllerInterface::setDistanceOfRouteLeft(double dist) {
+    pushCommandEvent(CommandEvent::Type::DISTANCE_OF_ROUTE_LEFT, [dist](CommandEvent &event) { event.distanceOfRouteLeft = dist; });
+}
+
+template<typename Fill>
+void CANopenControllerInterface::pushCommandEvent(CommandEvent::Type type, Fill fill) {
+    const bool queued = mCommandEvents.tryPush([&](CommandEvent &event) {
+        event.type = type;
+        fill(event);
+    });
+    if (!queued)
+        mDroppedCommandEvents.fetch_add(1, std::memory_order_relaxed);
 }
 
-void CANopenControllerInterface::GNSSDataToCANReceived(const QVariant& gnssData) {
-    emit sendGNSSDataToCAN(gnssData);
+void CANopenControllerInterface::processCommands(MySlave &slave) {
+    const bool latch = isLatchCommandsAtSync();
+    TimedCommand command;
+    if (mCommandSpeed.take(command)) {
+        mPendingSpeed.command = command;
+        mPendingSpeed.latched = latch;
+        mPendingSpeed.written = !latch;
+        if (!latch)
+            slave.commandSpeedReceived(command.value);
+    }
+    if (mCommandSteeringCurvature.take(command)) {
+        mPendingSteeringCurvature.command = command;
+        mPendingSteeringCurvature.latched = latch;
+        mPendingSteeringCurvature.written = !latch;
+        if (!latch)
+            slave.commandSteeringReceived(command.value);
+    }
+
+    while (mCommandEvents.tryPop([&slave](const CommandEvent &event) {
+        switch (event.type) {
+        case CommandEvent::Type::ACTUAL_STATUS: slave.statusReceived(event.status); break;
+        case CommandEvent::Type::ATTRIBUTES: slave.commandAttributesReceived(event.attributes); break;
+        case CommandEvent::Type::GNSS_DATA: slave.GNSSDataToCANReceived(event.gnssData); break;
+        case CommandEvent::Type::DISTANCE_OF_ROUTE_LEFT: slave.receiveDistanceOfRouteLeft(event.distanceOfRouteLeft); break;
+        }
+    })) {}
 }
 
-void CANopenControllerInterface::receiveDistanceOfRouteLeft(double dist) {
-    emit distanceOfRouteLeft(dist);
+// TPDOs of this SYNC have been transmitted when this is called
+void CANopenControllerInterface::syncReceived(MySlave &slave) {
+    const qint64 now_ns = getMonotonicTime_ns();
+    if (mLastSync_ns >= 0)
+        addPdoTimingSample(&CANopenPdoStatistics::syncInterval, now_ns - mLastSync_ns);
+    mLastSync_ns = now_ns;
+
+    const auto transmitted = [this, now_ns](PendingCommand &pending, CANopenPdoTimingStatistics CANopenPdoStatistics::*signal) {
+        if (pending.written) {
+            CommandLatencyTrace::getInstance().mark(CommandLatencyTrace::Stage::Actuator);
+            addPdoTimingSample(signal, now_ns - pending.command.timestamp_ns);
+            pending.written = false;
+        }
+    };
+    transmitted(mPendingSpeed, &CANopenPdoStatistics::commandSpeed);
+    transmitted(mPendingSteeringCurvature, &CANopenPdoStatistics::commandSteering);
+
+    // Latched commands go out with the next SYNC's TPDOs
+    if (mPendingSpeed.latched) {
+        slave.commandSpeedReceived(mPendingSpeed.command.value);
+        mPendingSpeed.latched = false;
+        mPendingSpeed.written = true;
+    }
+    if (mPendingSteeringCurvature.latched) {
+        slave.commandSteeringReceived(mPendingSteeringCurvature.command.value);
+        mPendingSteeringCurvature.latched = false;
+        mPendingSteeringCurvature.written = true;
+    }
 }
 
 void CANopenControllerInterface::finishEventLoop() {
@@ -103,12 +207,7 @@ void CANopenControllerInterface::startDevice() {
         QObject::connect(&mSlave, &MySlave::sendStatus, this, &CANopenControllerInterface::commandStatusReceived);
         QObject::connect(&mSlave, &MySlave::sendBatterySOC, this, &CANopenControllerInterface::batterySOCReceived);
         QObject::connect(&mSlave, &MySlave::sendBatteryVoltage, this, &CANopenControllerInterface::batteryVoltageReceived);
-        QObject::connect(this, &CANopenControllerInterface::sendCommandSpeed, &mSlave, &MySlave::commandSpeedReceived);
-        QObject::connect(this, &CANopenControllerInterface::sendCommandSteering, &mSlave, &MySlave::commandSteeringReceived);
-        QObject::connect(this, &CANopenControllerInterface::sendActualStatus, &mSlave, &MySlave::statusReceived);
-        QObject::connect(this, &CANopenControllerInterface::sendCommandAttributes, &mSlave, &MySlave::commandAttributesReceived);
-        QObject::connect(this, &CANopenControllerInterface::sendGNSSDataToCAN, &mSlave, &MySlave::GNSSDataToCANReceived);
-        QObject::connect(this, &CANopenControllerInterface::distanceOfRouteLeft, &mSlave, &MySlave::receiveDistanceOfRouteLeft);
+        QObject::connect(&mSlave, &MySlave::sendSync, this, [this, &mSlave](quint8) { syncReceived(mSlave); });
 
         // Create a signal handler.
         io::SignalSet sigset(poll, exec);
@@ -128,9 +227,10 @@ void CANopenControllerInterface::startDevice() {
         // Start the NMT service of the slave by pretending to receive a 'reset node'
         // command.
         mSlave.Reset();
-        // Run the event loop once, then check for Qt events
+        // Run the event loop once, then write pending commands and check for Qt events
         while (mContinueEventLoop) {
             loop.run_one();
+            processCommands(mSlave);
             thread()->eventDispatcher()->processEvents(QEventLoop::ProcessEventsFlag::AllEvents);
         }
     } catch (...) { // TODO: handle specific exception
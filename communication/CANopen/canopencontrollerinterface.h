@@ -3,50 +3,126 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * Creating a CANopen node and connecting relevant data to be sent and received on the CAN bus.
+ * Commands to be sent are handed over from other threads without locks or allocation: speed and steering through
+ * latest-value mailboxes, everything else through a bounded event queue. Both are polled by the CANopen event loop.
+ * PDOs are synchronous (see cpp-slave.eds): TPDOs are transmitted and RPDOs applied at SYNC. Speed and steering commands
+ * can optionally be latched at SYNC, i.e., always transmitted exactly one SYNC period after being sampled.
  */
 
 #ifndef CANOPENCONTROLLERINTERFACE_H
 #define CANOPENCONTROLLERINTERFACE_H
 
 #include <QObject>
+#include <atomic>
+#include <mutex>
+#include "core/latestvaluemailbox.h"
+#include "core/mpscringbuffer.h"
+#include "sensors/gnss/ublox.h"
+
+class MySlave;
+
+// Latency of one PDO signal [us], jitter: deviation of a latency from the previous one
+struct CANopenPdoTimingStatistics {
+    quint64 samples = 0;
+    double lastLatency_us = 0.0;
+    double maxLatency_us = 0.0;
+    double meanLatency_us = 0.0;
+    double maxJitter_us = 0.0;
+    double meanJitter_us = 0.0;
+
+    void addSample(double latency_us);
+};
+
+struct CANopenPdoStatistics {
+    CANopenPdoTimingStatistics commandSpeed; // set by the MovementController -> TPDO transmitted at SYNC
+    CANopenPdoTimingStatistics commandSteering;
+    CANopenPdoTimingStatistics actualSpeed; // RPDO applied -> MovementController updated
+    CANopenPdoTimingStatistics actualSteering;
+    CANopenPdoTimingStatistics syncInterval; // time between two SYNCs
+};
 
 class CANopenControllerInterface : public QObject
 {
     Q_OBJECT
 
+public:
+    // Thread-safe, values are written to the object dictionary by the CANopen event loop
+    void setCommandSpeed(double speed);
+    void setCommandSteeringCurvature(double steeringCurvature);
+    void setActualStatus(quint8 status);
+    void setCommandAttributes(quint32 attributes);
+    void setGNSSData(const ubx_nav_pvt &pvt);
+    void setDistanceOfRouteLeft(double dist);
+
+    quint32 getDroppedCommandEvents() const { return mDroppedCommandEvents.load(std::memory_order_relaxed); }
+
+    bool isLatchCommandsAtSync() const { return mLatchCommandsAtSync.load(std::memory_order_relaxed); }
+    void setLatchCommandsAtSync(bool latch) { mLatchCommandsAtSync.store(latch, std::memory_order_relaxed); }
+
+    CANopenPdoStatistics getPdoStatistics();
+    void resetPdoStatistics();
+    void addPdoTimingSample(CANopenPdoTimingStatistics CANopenPdoStatistics::*signal, qint64 latency_ns); // thread-safe
+
+    static qint64 getMonotonicTime_ns(); // std::chrono::steady_clock, timestamps of the PDO statistics
+
 public slots:
     void startDevice();
     void actualSpeedReceived(double speed);
     void actualSteeringReceived(double steering);
-    void commandSpeedReceived(const double& speed);
-    void commandSteeringReceived(const double& steering);
     void commandStatusReceived(quint8 status);
-    void actualStatusReceived(const quint8& status);
     void batterySOCReceived(double batterysoc);
     void batteryVoltageReceived(double batteryvoltage);
-    void commandAttributesReceived(const quint32& attributes);
-    void GNSSDataToCANReceived(const QVariant& gnssData);
-    void receiveDistanceOfRouteLeft(double dist);
     void finishEventLoop();
 
 signals:
     void finished();
     void error(QString err);
-    void sendActualSpeed(double speed);
-    void sendActualSteeringCurvature(double steeringCurvature);
-    void sendCommandSpeed(const double& speed);
-    void sendCommandSteering(const double& steering);
+    void sendActualSpeed(double speed, qint64 rxTimestamp_ns); // monotonic time at which the RPDO was applied
+    void sendActualSteeringCurvature(double steeringCurvature, qint64 rxTimestamp_ns);
     void sendCommandStatus(quint8 status);
-    void sendActualStatus(const quint8& status);
     void sendBatterySOC(double batterysoc);
     void sendBatteryVoltage(double batteryvoltage);
-    void sendCommandAttributes(const quint32& attributes);
     void activateSimulation();
-    void sendGNSSDataToCAN(const QVariant&);
-    void distanceOfRouteLeft(double dist);
 
 private:
-    bool mContinueEventLoop = true;
+    struct CommandEvent {
+        enum class Type {ACTUAL_STATUS, ATTRIBUTES, GNSS_DATA, DISTANCE_OF_ROUTE_LEFT};
+        Type type;
+        quint8 status;
+        quint32 attributes;
+        double distanceOfRouteLeft;
+        ubx_nav_pvt gnssData;
+    };
+    static constexpr size_t COMMAND_EVENT_QUEUE_CAPACITY = 32;
+
+    struct TimedCommand {
+        double value;
+        qint64 timestamp_ns; // monotonic time of the MovementController setting it
+    };
+    // Command on its way from the mailbox to the bus (CANopen thread)
+    struct PendingCommand {
+        bool latched = false; // taken from the mailbox, waiting for SYNC to be written
+        bool written = false; // in the object dictionary, waiting for SYNC to be transmitted
+        TimedCommand command;
+    };
+
+    template<typename Fill>
+    void pushCommandEvent(CommandEvent::Type type, Fill fill);
+    void processCommands(MySlave &slave); // CANopen thread
+    void syncReceived(MySlave &slave); // CANopen thread
+
+    std::atomic<bool> mContinueEventLoop{true};
+    std::atomic<bool> mLatchCommandsAtSync{false};
+    LatestValueMailbox<TimedCommand> mCommandSpeed;
+    LatestValueMailbox<TimedCommand> mCommandSteeringCurvature;
+    PendingCommand mPendingSpeed;
+    PendingCommand mPendingSteeringCurvature;
+    qint64 mLastSync_ns = -1;
+    MpscRingBuffer<CommandEvent, COMMAND_EVENT_QUEUE_CAPACITY> mCommandEvents;
+    std::atomic<quint32> mDroppedCommandEvents{0};
+
+    std::mutex mPdoStatisticsMutex;
+    CANopenPdoStatistics mPdoStatistics;
 };
 
 #endif // CANOPENCONTROLLERINTERFACE_H
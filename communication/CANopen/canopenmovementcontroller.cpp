@@ -5,9 +5,11 @@
 
 #include <QDebug>
 #include <QThread>
+#include "core/threadconfig.h"
 #include <QTimer>
 
 #include "canopenmovementcontroller.h"
+#include "core/commandlatencytrace.h"
 
 CANopenMovementController::CANopenMovementController(QSharedPointer<VehicleState> vehicleState): MovementController(vehicleState)
 {
@@ -21,16 +23,11 @@ CANopenMovementController::CANopenMovementController(QSharedPointer<VehicleState
         qDebug() << "WARNING: CANopenMovementController could not connect to CAN bus, simulating movement.";
         mSimulateMovement = true;
     });
+    ThreadConfig::getInstance().applyOnStart(mCanopenThread.get(), ThreadConfig::Role::ActuatorIo);
     mCanopenThread->start();
 
     // --- Set up communication between the threads ---
-    QObject::connect(this, &CANopenMovementController::sendCommandSpeed, mCANopenControllerInterface.get(), &CANopenControllerInterface::commandSpeedReceived, Qt::QueuedConnection);
-    QObject::connect(this, &CANopenMovementController::sendCommandSteeringCurvature, mCANopenControllerInterface.get(), &CANopenControllerInterface::commandSteeringReceived, Qt::QueuedConnection);
-    QObject::connect(this, &CANopenMovementController::sendCommandAttributes, mCANopenControllerInterface.get(), &CANopenControllerInterface::commandAttributesReceived, Qt::QueuedConnection);
-    QObject::connect(this, &CANopenMovementController::sendActualStatus, mCANopenControllerInterface.get(), &CANopenControllerInterface::actualStatusReceived, Qt::QueuedConnection);
-    QObject::connect(this, &CANopenMovementController::sendGNSSDataToCAN, mCANopenControllerInterface.get(), &CANopenControllerInterface::GNSSDataToCANReceived, Qt::QueuedConnection);
-    QObject::connect(this, &CANopenMovementController::distanceOfRouteLeft, mCANopenControllerInterface.get(), &CANopenControllerInterface::receiveDistanceOfRouteLeft, Qt::QueuedConnection);
-
+    // Commands are handed over through CANopenControllerInterface's mailboxes/event queue, actual values as queued signals
     QObject::connect(mCANopenControllerInterface.get(), &CANopenControllerInterface::sendActualSpeed, this, &CANopenMovementController::actualSpeedReceived);
     QObject::connect(mCANopenControllerInterface.get(), &CANopenControllerInterface::sendActualSteeringCurvature, this, &CANopenMovementController::actualSteeringCurvatureReceived);
     QObject::connect(mCANopenControllerInterface.get(), &CANopenControllerInterface::sendCommandStatus, this, &CANopenMovementController::commandStatusReceived);
@@ -48,17 +45,20 @@ void CANopenMovementController::setDesiredSteeringCurvature(double desiredSteeri
     MovementController::setDesiredSteeringCurvature(desiredSteeringCurvature);
 
     if (!mSimulateMovement)
-        emit sendCommandSteeringCurvature(desiredSteeringCurvature);
+        mCANopenControllerInterface->setCommandSteeringCurvature(desiredSteeringCurvature);
 }
 
 void CANopenMovementController::setDesiredSpeed(double desiredSpeed)
 {
     MovementController::setDesiredSpeed(desiredSpeed);
+    desiredSpeed = getDesiredSpeed(); // limited, e.g., by the geofence
 
     if (!mSimulateMovement)
-        emit sendCommandSpeed(desiredSpeed);
-    else
+        mCANopenControllerInterface->setCommandSpeed(desiredSpeed);
+    else {
+        CommandLatencyTrace::getInstance().mark(CommandLatencyTrace::Stage::Actuator);
         getVehicleState()->setSpeed(desiredSpeed);
+    }
 }
 
 void CANopenMovementController::setDesiredSteering(double desiredSteering)
@@ -66,9 +66,23 @@ void CANopenMovementController::setDesiredSteering(double desiredSteering)
     MovementController::setDesiredSteering(desiredSteering);
 
     if (!mSimulateMovement)
-        emit sendCommandSteeringCurvature(desiredSteering / (getVehicleState()->getWidth() / 2.0)); // Note: setDesiredSteering(..) not supported by current protocol
-    else
+        mCANopenControllerInterface->setCommandSteeringCurvature(desiredSteering / (getVehicleState()->getWidth() / 2.0)); // Note: setDesiredSteering(..) not supported by current protocol
+    else {
+        CommandLatencyTrace::getInstance().mark(CommandLatencyTrace::Stage::Actuator);
         getVehicleState()->setSteering(desiredSteering);
+    }
+}
+
+void CANopenMovementController::setSafetyStop(bool active)
+{
+    MovementController::setSafetyStop(active);
+    if (!active)
+        return;
+
+    if (!mSimulateMovement)
+        mCANopenControllerInterface->setCommandSpeed(0.0);
+    else
+        getVehicleState()->setSpeed(0.0);
 }
 
 void CANopenMovementController::setDesiredAttributes(quint32 desiredAttributes)
@@ -76,27 +90,32 @@ void CANopenMovementController::setDesiredAttributes(quint32 desiredAttributes)
     MovementController::setDesiredAttributes(desiredAttributes);
 
     if (!mSimulateMovement)
-        emit sendCommandAttributes(desiredAttributes);
+        mCANopenControllerInterface->setCommandAttributes(desiredAttributes);
 }
 
-void CANopenMovementController::actualSpeedReceived(double speed) {
+void CANopenMovementController::actualSpeedReceived(double speed, qint64 rxTimestamp_ns) {
     getVehicleState()->setSpeed(speed);
 
     static double lastSpeed = speed;
-    static QTime lastTimeCalled = QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc());
-    QTime thisTimeCalled = QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc());
-    int dt_ms = lastTimeCalled.msecsTo(thisTimeCalled);
+    static qint64 lastTimeCalled_ns = utcTime::now_ns();
+    qint64 thisTimeCalled_ns = utcTime::now_ns();
+    double dt_ms = (thisTimeCalled_ns - lastTimeCalled_ns) / 1e6;
     double drivenDistance = ((lastSpeed + speed) / 2.0) * dt_ms / 1000.0;
 
     getVehicleState()->updateOdomPositionAndYaw(drivenDistance);
-    emit updatedOdomPositionAndYaw(getVehicleState(), drivenDistance);
+    emit updatedOdomPositionAndYaw(getVehicleState(), drivenDistance, thisTimeCalled_ns, thisTimeCalled_ns - lastTimeCalled_ns);
+    publishOdomPosition(drivenDistance, thisTimeCalled_ns - lastTimeCalled_ns);
 
     lastSpeed = speed;
-    lastTimeCalled = thisTimeCalled;
+    lastTimeCalled_ns = thisTimeCalled_ns;
+
+    mCANopenControllerInterface->addPdoTimingSample(&CANopenPdoStatistics::actualSpeed, CANopenControllerInterface::getMonotonicTime_ns() - rxTimestamp_ns);
 }
 
-void CANopenMovementController::actualSteeringCurvatureReceived(double steeringCurvature) {
+void CANopenMovementController::actualSteeringCurvatureReceived(double steeringCurvature, qint64 rxTimestamp_ns) {
     getVehicleState()->setSteering(getVehicleState()->steeringCurvatureToSteering(steeringCurvature));
+
+    mCANopenControllerInterface->addPdoTimingSample(&CANopenPdoStatistics::actualSteering, CANopenControllerInterface::getMonotonicTime_ns() - rxTimestamp_ns);
 }
 
 void CANopenMovementController::commandStatusReceived(quint8 status) {
@@ -113,7 +132,7 @@ void CANopenMovementController::commandStatusReceived(quint8 status) {
         emit CANOpenAutopilotControlStateChanged(mCANOpenAutopilotControlState);
 
     lastStatus = status;
-    emit sendActualStatus(lastStatus);
+    mCANopenControllerInterface->setActualStatus(lastStatus);
 }
 
 void CANopenMovementController::batterySOCReceived(double batterysoc) {
@@ -129,12 +148,30 @@ bool CANopenMovementController::isMovementSimulated() const
     return mSimulateMovement;
 }
 
+bool CANopenMovementController::isLatchCommandsAtSync() const
+{
+    return mCANopenControllerInterface->isLatchCommandsAtSync();
+}
+
+void CANopenMovementController::setLatchCommandsAtSync(bool latch)
+{
+    mCANopenControllerInterface->setLatchCommandsAtSync(latch);
+}
+
+CANopenPdoStatistics CANopenMovementController::getPdoStatistics()
+{
+    return mCANopenControllerInterface->getPdoStatistics();
+}
+
+void CANopenMovementController::resetPdoStatistics()
+{
+    mCANopenControllerInterface->resetPdoStatistics();
+}
+
 void CANopenMovementController::rxNavPvt(const ubx_nav_pvt &pvt) {
-    QVariant gnssData;
-    gnssData.setValue(pvt);
-    emit sendGNSSDataToCAN(gnssData);
+    mCANopenControllerInterface->setGNSSData(pvt);
 }
 
 void CANopenMovementController::receiveDistanceOfRouteLeft(double dist) {
-    emit distanceOfRouteLeft(dist);
+    mCANopenControllerInterface->setDistanceOfRouteLeft(dist);
 }
@@ -35,22 +35,22 @@ public:
     virtual void setDesiredSteering(double desiredSteering) override;
     virtual void setDesiredSteeringCurvature(double desiredSteeringCurvature) override;
     virtual void setDesiredAttributes(quint32 desiredAttributes) override;
+    virtual void setSafetyStop(bool active) override; // through the command mailbox, i.e., independent of the event loops
 
     bool isMovementSimulated() const;
 
-signals:
-    void sendCommandSpeed(const double& speed);
-    void sendCommandSteeringCurvature(const double& steering);
-    void sendCommandAttributes(const quint32& attributes);
-    void sendActualStatus(const quint8& status);
-    void sendGNSSDataToCAN(const QVariant&);
-    void distanceOfRouteLeft(double dist);
+    // Latch speed and steering commands at SYNC for deterministic timing (transmitted one SYNC period after latching)
+    bool isLatchCommandsAtSync() const;
+    void setLatchCommandsAtSync(bool latch);
+    CANopenPdoStatistics getPdoStatistics();
+    void resetPdoStatistics();
 
+signals:
     void CANOpenAutopilotControlStateChanged(CANOpenAutopilotControlState controlState);
 
 private slots:
-    void actualSpeedReceived(double speed);
-    void actualSteeringCurvatureReceived(double steering);
+    void actualSpeedReceived(double speed, qint64 rxTimestamp_ns);
+    void actualSteeringCurvatureReceived(double steering, qint64 rxTimestamp_ns);
     void commandStatusReceived(quint8 status);
     void batterySOCReceived(double batterysoc);
     void batteryVoltageReceived(double batteryvoltage);
@@ -8,7 +8,6 @@
 #include <iostream>
 
 #include "slave.h"
-#include "sensors/gnss/ublox.h"
 
 // Speed that will be sent with TPDO
 void MySlave::commandSpeedReceived(const double &speed) {
@@ -55,14 +54,11 @@ void MySlave::commandAttributesReceived(const quint32& attributes) {
  * • 4 = GNSS + dead reckoning combined
  * • 5 = time only fix
  */
-void MySlave::GNSSDataToCANReceived(const QVariant& gnssData) {
-    if (gnssData.canConvert<ubx_nav_pvt>()) {
-        ubx_nav_pvt pvt = gnssData.value<ubx_nav_pvt>();
-        (*this)[0x2002][1] = (int16_t)std::round(pvt.g_speed*100); // [cm/s]
-        (*this)[0x2002][2] = (int16_t)std::round(pvt.lat/0.01); // Two decimals
-        (*this)[0x2002][3] = (int16_t)std::round(pvt.lon/0.01); // Two decimals
-        (*this)[0x2002][4] = (int8_t)std::round(pvt.fix_type);
-    }
+void MySlave::GNSSDataToCANReceived(const ubx_nav_pvt& pvt) {
+    (*this)[0x2002][1] = (int16_t)std::round(pvt.g_speed*100); // [cm/s]
+    (*this)[0x2002][2] = (int16_t)std::round(pvt.lat/0.01); // Two decimals
+    (*this)[0x2002][3] = (int16_t)std::round(pvt.lon/0.01); // Two decimals
+    (*this)[0x2002][4] = (int8_t)std::round(pvt.fix_type);
 }
 
 // Distance of route left to be sent with TPDO
@@ -70,6 +66,10 @@ void MySlave::receiveDistanceOfRouteLeft(double dist) {
      (*this)[0x2002][5] = (uint8_t)std::round(dist); // [m]
 }
 
+void MySlave::OnSync(uint8_t cnt, const time_point& /*t*/) noexcept {
+    emit sendSync((quint8)cnt);
+}
+
 // Read the value just written to object 200X:0X by RPDO
 void MySlave::OnWrite(uint16_t idx, uint8_t subidx) noexcept {
     if (idx == 0x2001 && subidx == 1) {
@@ -11,6 +11,7 @@
 #include <QObject>
 #include <lely/coapp/slave.hpp>
 #include <QDebug>
+#include "sensors/gnss/ublox.h"
 
 using namespace lely;
 
@@ -24,7 +25,7 @@ public slots:
     void commandSteeringReceived(const double& steering);
     void statusReceived(const quint8& status);
     void commandAttributesReceived(const quint32& attributes);
-    void GNSSDataToCANReceived(const QVariant& gnssData);
+    void GNSSDataToCANReceived(const ubx_nav_pvt& pvt);
     void receiveDistanceOfRouteLeft(double dist);
 
 signals:
@@ -33,11 +34,15 @@ signals:
     void sendStatus(quint8 status);
     void sendBatterySOC(double batterysoc);
     void sendBatteryVoltage(double batteryvoltage);
+    void sendSync(quint8 counter);
 
 protected:
  // This function gets called every time a value is written to the local object
  // dictionary by an SDO or RPDO.
  void OnWrite(uint16_t idx, uint8_t subidx) noexcept override;
+ // This function gets called on every SYNC, after synchronous RPDOs have been
+ // applied and synchronous TPDOs transmitted.
+ void OnSync(uint8_t cnt, const time_point& t) noexcept override;
 };
 
 #endif // SLAVE_H
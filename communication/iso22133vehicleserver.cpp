@@ -1,6 +1,5 @@
 #include "iso22133vehicleserver.h"
 #include <QDebug>
-#define MONR_RATE_MS 10
 #define METERS_TO_MILLIMETERS 1000
 
 iso22133VehicleServer::iso22133VehicleServer(
@@ -10,7 +9,7 @@ iso22133VehicleServer::iso22133VehicleServer(
     // Safety heartbeat
     mHeartbeat = false;
     mHeartbeatTimer.setSingleShot(true);
-    connect(&mHeartbeatTimer, &QTimer::timeout, this,
+    connect(&mHeartbeatTimer, &ClockTimer::timeout, this,
             &iso22133VehicleServer::heartbeatTimeout);
     connect(this, &iso22133VehicleServer::resetHeartbeat, this,
             &iso22133VehicleServer::heartbeatReset);
@@ -35,48 +34,53 @@ iso22133VehicleServer::iso22133VehicleServer(
     this->setPosition(pos);
     this->setSpeed(spd);
 
-    // Publish vehicleState's info to Monr
-    connect(&mSetMonrTimer, &QTimer::timeout, [this](){
-        CartesianPosition pos;
-        SpeedType spd;
-        AccelerationType acc;
-        DriveDirectionType drd;
-
-        pos.xCoord_m = mVehicleState->getPosition(PosType::fused).getX();
-        pos.yCoord_m = mVehicleState->getPosition(PosType::fused).getY();
-        pos.zCoord_m = mVehicleState->getPosition(PosType::fused).getHeight(); // TODO: Should be negative??
-        pos.isXcoordValid = true;
-        pos.isYcoordValid = true;
-        pos.isPositionValid = true;
-        auto heading = mVehicleState->getPosition(PosType::fused).getYaw();
-        // Convert [-180,180} to [0,360} deg
-        if (heading < 0) { heading += 360; }
-        pos.heading_rad = heading * M_PI / 180;
-        pos.isHeadingValid = true;
-
-        // Convert speed to longitudinal and lateral speed
-        spd.longitudinal_m_s = mVehicleState->getSpeed();
-        spd.lateral_m_s = 0;
-        spd.isLongitudinalValid = true;
-        spd.isLateralValid = true;
-
-        // Note! mVehicleState in not filled with acceleration values at the moment
-        acc.longitudinal_m_s2 = 0;
-        acc.lateral_m_s2 = 0;
-        acc.isLongitudinalValid = true;
-        acc.isLateralValid = true;
-
-        if (spd.longitudinal_m_s >= 0) {
-            drd = DriveDirectionType::OBJECT_DRIVE_DIRECTION_FORWARD;
-        } else {
-            drd = DriveDirectionType::OBJECT_DRIVE_DIRECTION_BACKWARD;
-        }
-        
-        setMonr(pos, spd, acc, drd);
-    });   
-
     // Start writing state to Monr
-    mSetMonrTimer.start(MONR_RATE_MS);
+    mMonrLoop.setMode(ControlLoop::Mode::DEDICATED_THREAD);
+    mMonrLoop.setRealTimePriority(MONR_REALTIME_PRIORITY);
+    mMonrLoop.start();
+}
+
+void iso22133VehicleServer::publishMonr() {
+    // One snapshot of the state per MONR, velocity and acceleration in the vehicle frame (x: longitudinal, y: lateral)
+    const pospoint_t position = mVehicleState->getPositionPOD(PosType::fused);
+    const double speed = mVehicleState->getSpeed();
+    const ObjectState::Velocity velocity = mVehicleState->getVelocity();
+    const ObjectState::Acceleration acceleration = mVehicleState->getAcceleration();
+
+    CartesianPosition pos;
+    SpeedType spd;
+    AccelerationType acc;
+    DriveDirectionType drd;
+
+    pos.xCoord_m = position.x;
+    pos.yCoord_m = position.y;
+    pos.zCoord_m = position.height; // TODO: Should be negative??
+    pos.isXcoordValid = true;
+    pos.isYcoordValid = true;
+    pos.isPositionValid = true;
+    auto heading = position.yaw;
+    // Convert [-180,180} to [0,360} deg
+    if (heading < 0) { heading += 360; }
+    pos.heading_rad = heading * M_PI / 180;
+    pos.isHeadingValid = true;
+
+    spd.longitudinal_m_s = speed;
+    spd.lateral_m_s = velocity.y;
+    spd.isLongitudinalValid = true;
+    spd.isLateralValid = true;
+
+    acc.longitudinal_m_s2 = acceleration.x;
+    acc.lateral_m_s2 = acceleration.y;
+    acc.isLongitudinalValid = true;
+    acc.isLateralValid = true;
+
+    if (spd.longitudinal_m_s >= 0) {
+        drd = DriveDirectionType::OBJECT_DRIVE_DIRECTION_FORWARD;
+    } else {
+        drd = DriveDirectionType::OBJECT_DRIVE_DIRECTION_BACKWARD;
+    }
+
+    setMonr(pos, spd, acc, drd);
 }
 
 void iso22133VehicleServer::setUbloxRover(
@@ -159,6 +163,7 @@ void iso22133VehicleServer::handleAbort() {
 void iso22133VehicleServer::onOSEM(ObjectSettingsType &osem) {
     qDebug() << "Object Settings Received";
     setObjectSettings(osem);
+    mOnlineTrajectoryStarted = false;
     const llh_t llh = {osem.coordinateSystemOrigin.latitude_deg, osem.coordinateSystemOrigin.longitude_deg, osem.coordinateSystemOrigin.altitude_m};
     if (!mGNSSReceiver.isNull())
     {
@@ -171,11 +176,26 @@ void iso22133VehicleServer::onOSEM(ObjectSettingsType &osem) {
 void iso22133VehicleServer::onTRAJ() {
     qDebug() << "Got onTRAJ signal, fetching new traj segments";
 
-    std::vector<TrajectoryWaypointType> newTraj;
-    newTraj = this->getTrajectory();
+    const std::vector<TrajectoryWaypointType> newTraj = this->getTrajectory();
     if (this->getObjectSettings().testMode == TEST_MODE_ONLINE) {
-        qDebug() << "Test mode is online planned, the mode is currently not "
-                    "supported.";
+        if (mWaypointFollower.isNull()) {
+            qDebug() << "iso22133VehicleServer: got trajectory segment but no "
+                        "WaypointFollower is set to receive it.";
+            return;
+        }
+
+        // Each TRAJ is the next segment of the trajectory, the follower continues on the extended route
+        QVector<pospoint_t> segment;
+        segment.reserve(newTraj.size());
+        for (const auto &item : newTraj) {
+            segment.append(convertTrajPointToPOD(item));
+        }
+        if (!mOnlineTrajectoryStarted) {
+            qDebug() << "Test mode is online planned, starting new trajectory";
+            mWaypointFollower->clearRoute();
+            mOnlineTrajectoryStarted = true;
+        }
+        mWaypointFollower->appendRoute(segment);
     } else {
         qDebug() << "Test mode is preplanned, replacing existing trajectory";
         if (!mWaypointFollower.isNull()) {
@@ -194,15 +214,20 @@ void iso22133VehicleServer::onTRAJ() {
 
 PosPoint iso22133VehicleServer::convertTrajPointToPosPoint(
     const TrajectoryWaypointType &trajPoint) {
-    PosPoint posPoint;
-    posPoint.setX(trajPoint.pos.xCoord_m);
-    posPoint.setY(trajPoint.pos.yCoord_m);
-    posPoint.setHeight(trajPoint.pos.zCoord_m);
+    return PosPoint(convertTrajPointToPOD(trajPoint));
+}
+
+pospoint_t iso22133VehicleServer::convertTrajPointToPOD(
+    const TrajectoryWaypointType &trajPoint) {
+    pospoint_t point;
+    point.x = trajPoint.pos.xCoord_m;
+    point.y = trajPoint.pos.yCoord_m;
+    point.height = trajPoint.pos.zCoord_m;
     // Set speed from long/lat speed components
-    posPoint.setSpeed(sqrt(pow(trajPoint.spd.longitudinal_m_s, 2) +
-                           pow(trajPoint.spd.lateral_m_s, 2)));
+    point.speed = sqrt(pow(trajPoint.spd.longitudinal_m_s, 2) +
+                       pow(trajPoint.spd.lateral_m_s, 2));
 
-    return posPoint;
+    return point;
 }
 
 void iso22133VehicleServer::onSTRT(StartMessageType &) {
@@ -2,11 +2,14 @@
 #include <communication/vehicleserver.h>
 #include <QObject>
 #include <QSharedPointer>
-#include <QTimer>
+#include "core/controlloop.h"
 #include "iso22133object.hpp"
 
 #pragma once
 
+#define MONR_RATE_MS 10
+#define MONR_REALTIME_PRIORITY 50
+
 class iso22133VehicleServer : public VehicleServer, public ISO22133::TestObject
 {
     Q_OBJECT
@@ -26,12 +29,20 @@ public:
     void onTRAJ() override;
     void onSTRT(StartMessageType&) override;
 
+    // MONR values are updated on a dedicated thread at MONR_RATE_MS (real-time priority if permitted), independent of the event loop
+    ControlLoop &getMonrLoop() { return mMonrLoop; }
+
 private: 
     void setMonr(CartesianPosition pos, SpeedType spd, AccelerationType acc, DriveDirectionType drd);
-    QTimer mSetMonrTimer;
+    void publishMonr();
     void updateRawGpsAndGpsInfoFromUbx(const ubx_nav_pvt &pvt) override;
     void heartbeatTimeout() override;
     void heartbeatReset() override;
     void setStopCommands();
     static PosPoint convertTrajPointToPosPoint(const TrajectoryWaypointType &trajPoint);
+    static pospoint_t convertTrajPointToPOD(const TrajectoryWaypointType &trajPoint);
+    bool mOnlineTrajectoryStarted = false; // TEST_MODE_ONLINE: TRAJ segments are appended to the route, reset by OSEM
+
+    // Last member, i.e., the loop is stopped before anything it uses is destroyed
+    ControlLoop mMonrLoop{[this](){ publishMonr(); }, MONR_RATE_MS};
 };
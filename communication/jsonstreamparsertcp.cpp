@@ -3,6 +3,10 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "jsonstreamparsertcp.h"
+#include <QCborValue>
+#include <QCborArray>
+#include <QCborMap>
+#include <QtEndian>
 
 JsonStreamParserTcp::JsonStreamParserTcp(QObject *parent) : QObject(parent)
 {
@@ -12,27 +16,152 @@ JsonStreamParserTcp::JsonStreamParserTcp(QObject *parent) : QObject(parent)
 
 void JsonStreamParserTcp::connectToHost(QHostAddress address, qint16 port)
 {
+    resetParser();
     mTcpSocket.connectToHost(address, port, QTcpSocket::ReadOnly);
 }
 
+void JsonStreamParserTcp::setFraming(Framing framing)
+{
+    mFraming = framing;
+    resetParser();
+}
+
+void JsonStreamParserTcp::resetParser()
+{
+    mBuffer.clear();
+    mScanPos = 0;
+    mDocumentStart = -1;
+    mDepth = 0;
+    mInString = false;
+    mEscaped = false;
+}
+
 void JsonStreamParserTcp::parseJson()
 {
-    QJsonParseError err;
-    for (const auto& elem : mTcpSocket.readAll().split('\n')) {
-        if (elem.isEmpty())
+    processData(mTcpSocket.readAll());
+}
+
+void JsonStreamParserTcp::processData(const QByteArray &data)
+{
+    mBuffer.append(data);
+
+    if (mFraming == Framing::LengthPrefixedCbor)
+        frameCborDocuments();
+    else
+        frameJsonDocuments();
+}
+
+void JsonStreamParserTcp::frameJsonDocuments()
+{
+    const char *data = mBuffer.constData();
+    const int size = mBuffer.size();
+    int consumed = 0; // everything before is done with
+
+    // Only new bytes are scanned, the state is kept across reads
+    for (int i = mScanPos; i < size; i++) {
+        const char c = data[i];
+
+        if (mDocumentStart < 0) {
+            if (c == '{' || c == '[') {
+                mDocumentStart = i;
+                mDepth = 1;
+            } else
+                consumed = i + 1; // whitespace/newlines (or garbage) between documents
             continue;
+        }
 
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(elem, &err);
+        if (mInString) {
+            if (mEscaped)
+                mEscaped = false;
+            else if (c == '\\')
+                mEscaped = true;
+            else if (c == '"')
+                mInString = false;
+            continue;
+        }
 
-        if (err.error != QJsonParseError::NoError) {
-            qDebug() << "Skipped input due to error while parsing JSON:" << err.errorString();
-        } else {
-            if (jsonDoc.isArray())
-                emit gotJsonArray(jsonDoc.array());
+        switch (c) {
+        case '"':
+            mInString = true;
+            break;
+        case '{':
+        case '[':
+            mDepth++;
+            break;
+        case '}':
+        case ']':
+            if (--mDepth == 0) {
+                // No copy, the buffer is not modified while parsing
+                parseJsonDocument(QByteArray::fromRawData(data + mDocumentStart, i - mDocumentStart + 1));
+                mDocumentStart = -1;
+                consumed = i + 1;
+            }
+            break;
+        default: ;
+        }
+    }
 
-            if (jsonDoc.isObject())
-                emit gotJsonObject(jsonDoc.object());
+    if (mDocumentStart >= 0 && size - mDocumentStart > MAX_DOCUMENT_SIZE) {
+        qDebug() << "WARNING: JsonStreamParserTcp dropped JSON document larger than" << MAX_DOCUMENT_SIZE << "bytes.";
+        resetParser();
+        return;
+    }
+
+    mBuffer.remove(0, consumed);
+    mScanPos = mBuffer.size();
+    if (mDocumentStart >= 0)
+        mDocumentStart -= consumed;
+}
+
+void JsonStreamParserTcp::frameCborDocuments()
+{
+    int pos = 0;
+    while (mBuffer.size() - pos >= 4) {
+        const quint32 documentSize = qFromBigEndian<quint32>(mBuffer.constData() + pos);
+        if (documentSize > quint32(MAX_DOCUMENT_SIZE)) {
+            qDebug() << "WARNING: JsonStreamParserTcp got CBOR document size" << documentSize << ", framing lost. Dropping buffered data.";
+            resetParser();
+            return;
         }
+        if (mBuffer.size() - pos - 4 < int(documentSize))
+            break;
+
+        parseCborDocument(QByteArray::fromRawData(mBuffer.constData() + pos + 4, documentSize));
+        pos += 4 + documentSize;
+    }
+
+    mBuffer.remove(0, pos);
+}
+
+void JsonStreamParserTcp::parseJsonDocument(const QByteArray &document)
+{
+    QJsonParseError err;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(document, &err);
+
+    if (err.error != QJsonParseError::NoError) {
+        qDebug() << "Skipped input due to error while parsing JSON:" << err.errorString();
+    } else {
+        if (jsonDoc.isArray())
+            emit gotJsonArray(jsonDoc.array());
+
+        if (jsonDoc.isObject())
+            emit gotJsonObject(jsonDoc.object());
+    }
+}
+
+void JsonStreamParserTcp::parseCborDocument(const QByteArray &document)
+{
+    QCborParserError err;
+    const QCborValue cborValue = QCborValue::fromCbor(document, &err);
+
+    if (err.error != QCborError::NoError) {
+        qDebug() << "Skipped input due to error while parsing CBOR:" << err.errorString();
+    } else {
+        if (cborValue.isArray())
+            emit gotJsonArray(cborValue.toArray().toJsonArray());
+
+        if (cborValue.isMap())
+            emit gotJsonObject(cborValue.toMap().toJsonObject());
     }
 }
 
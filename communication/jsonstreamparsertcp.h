@@ -3,6 +3,9 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * Class that connects to a TCP port which is assumed to stream newline-delimited JSON objects and/or arrays, parses stream and makes data available using signals
+ * Documents are framed incrementally: bracket depth (outside of strings) is tracked across reads, so documents split over several reads
+ * are handled and every complete document is parsed exactly once. Alternatively, the stream can consist of CBOR documents,
+ * each prefixed by its size (32 bit, big-endian), which is cheaper to parse. CBOR arrays/maps are emitted as JSON arrays/objects.
  */
 
 #ifndef JSONSTREAMPARSERTCP_H
@@ -15,13 +18,26 @@
 #include <QJsonParseError>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QByteArray>
 
 class JsonStreamParserTcp : public QObject
 {
     Q_OBJECT
 public:
+    enum class Framing {
+        Json,
+        LengthPrefixedCbor,
+    };
+
     explicit JsonStreamParserTcp(QObject *parent = nullptr);
     void connectToHost(QHostAddress address, qint16 port);
+    Framing getFraming() const { return mFraming; }
+    void setFraming(Framing framing); // resets the parser state
+
+    // Parses data as received from the socket, e.g., replayed recordings or benchmarks
+    void processData(const QByteArray &data);
+
+    static constexpr int MAX_DOCUMENT_SIZE = 4 * 1024 * 1024; // larger documents are dropped
 
 signals:
     void gotJsonArray(const QJsonArray& jsonArray);
@@ -30,8 +46,21 @@ signals:
 private:
     void parseJson();
     void tcpError(QTcpSocket::SocketError error);
+    void resetParser();
+    void frameJsonDocuments();
+    void frameCborDocuments();
+    void parseJsonDocument(const QByteArray &document);
+    void parseCborDocument(const QByteArray &document);
 
     QTcpSocket mTcpSocket;
+    Framing mFraming = Framing::Json;
+    QByteArray mBuffer;
+    // JSON framing state, positions are relative to mBuffer
+    int mScanPos = 0;
+    int mDocumentStart = -1; // -1: between documents
+    int mDepth = 0;
+    bool mInString = false;
+    bool mEscaped = false;
 };
 
 #endif // JSONSTREAMPARSERTCP_H
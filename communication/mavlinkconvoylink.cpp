@@ -0,0 +1,114 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mavlinkconvoylink.h"
+#include <QNetworkDatagram>
+#include <QDebug>
+#include <cmath>
+
+MavlinkConvoyLink::MavlinkConvoyLink(QObject *parent) : QObject(parent)
+{
+    connect(&mSocket, &QUdpSocket::readyRead, this, &MavlinkConvoyLink::readDatagrams);
+}
+
+bool MavlinkConvoyLink::start(quint8 systemId, quint16 port, const QHostAddress &group)
+{
+    stop();
+    mSystemId = systemId;
+    mPort = port;
+    mGroup = group;
+
+    // Several vehicles can run on the same host (simulation)
+    if (!mSocket.bind(QHostAddress::AnyIPv4, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        qDebug() << "WARNING: MavlinkConvoyLink could not bind to port" << port << ":" << mSocket.errorString();
+        return false;
+    }
+    if (group.isMulticast()) {
+        if (!mSocket.joinMulticastGroup(group))
+            qDebug() << "WARNING: MavlinkConvoyLink could not join multicast group" << group.toString() << ":" << mSocket.errorString();
+        mSocket.setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+    }
+
+    qDebug() << "MavlinkConvoyLink: system" << systemId << "on" << group.toString() << "port" << port;
+    return true;
+}
+
+void MavlinkConvoyLink::stop()
+{
+    if (mSocket.state() != QAbstractSocket::UnconnectedState)
+        mSocket.close();
+}
+
+void MavlinkConvoyLink::setPredecessor(quint8 predecessorSystemId)
+{
+    if (predecessorSystemId == mSystemId && predecessorSystemId != 0) {
+        qDebug() << "Warning: MavlinkConvoyLink: system" << mSystemId << "cannot follow itself, ignored.";
+        return;
+    }
+    mPredecessorSystemId = predecessorSystemId;
+    mLastPredecessorPosition.invalidate();
+}
+
+bool MavlinkConvoyLink::isPredecessorAlive() const
+{
+    return mPredecessorSystemId != 0 && mLastPredecessorPosition.isValid() && mLastPredecessorPosition.elapsed() < PREDECESSOR_TIMEOUT_MS;
+}
+
+void MavlinkConvoyLink::publishPosition(const llh_t &llh, double yaw_degENU, const xyz_t &velocityENU, qint64 timestamp_ns)
+{
+    if (!isStarted())
+        return;
+
+    mavlink_follow_target_t followTarget;
+    memset(&followTarget, 0, sizeof(followTarget));
+    followTarget.timestamp = timestamp_ns / 1000000;
+    followTarget.est_capabilities = 0x1 | 0x2 | 0x8; // position, velocity, attitude
+    followTarget.lat = std::lround(llh.latitude * 1e7);
+    followTarget.lon = std::lround(llh.longitude * 1e7);
+    followTarget.alt = llh.height;
+    followTarget.vel[0] = velocityENU.y; // NED
+    followTarget.vel[1] = velocityENU.x;
+    followTarget.vel[2] = -velocityENU.z;
+    const double halfYaw_rad = coordinateTransforms::yawENUtoNED(yaw_degENU) * M_PI / 180.0 / 2.0;
+    followTarget.attitude_q[0] = cos(halfYaw_rad);
+    followTarget.attitude_q[3] = sin(halfYaw_rad);
+
+    mavlink_message_t message;
+    mavlink_msg_follow_target_encode_chan(mSystemId, MAV_COMP_ID_AUTOPILOT1, MAVLINK_CHANNEL, &message, &followTarget);
+
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    const uint16_t length = mavlink_msg_to_send_buffer(buffer, &message);
+    mSocket.writeDatagram(reinterpret_cast<const char*>(buffer), length, mGroup, mPort);
+}
+
+void MavlinkConvoyLink::readDatagrams()
+{
+    while (mSocket.hasPendingDatagrams()) {
+        mDatagram.resize(int(mSocket.pendingDatagramSize()));
+        const qint64 size = mSocket.readDatagram(mDatagram.data(), mDatagram.size());
+        if (size <= 0 || mPredecessorSystemId == 0)
+            continue;
+
+        // One message per datagram, parsed with local state (independent of MAVSDK's channels)
+        mavlink_message_t buffer, message;
+        mavlink_status_t bufferStatus, status;
+        memset(&bufferStatus, 0, sizeof(bufferStatus));
+        for (qint64 i = 0; i < size; i++) {
+            if (mavlink_frame_char_buffer(&buffer, &bufferStatus, uint8_t(mDatagram.at(int(i))), &message, &status) != MAVLINK_FRAMING_OK)
+                continue;
+            if (message.msgid != MAVLINK_MSG_ID_FOLLOW_TARGET || message.sysid != mPredecessorSystemId)
+                continue;
+
+            mavlink_follow_target_t followTarget;
+            mavlink_msg_follow_target_decode(&message, &followTarget);
+            const double yaw_degNED = 2.0 * atan2(followTarget.attitude_q[3], followTarget.attitude_q[0]) * 180.0 / M_PI;
+
+            mLastPredecessorPosition.start();
+            emit predecessorPositionReceived({followTarget.lat / 1e7, followTarget.lon / 1e7, followTarget.alt},
+                                             coordinateTransforms::yawNEDtoENU(yaw_degNED),
+                                             {followTarget.vel[1], followTarget.vel[0], -followTarget.vel[2]},
+                                             qint64(followTarget.timestamp) * 1000000);
+        }
+    }
+}
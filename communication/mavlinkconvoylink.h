@@ -0,0 +1,61 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Peer-to-peer position exchange for convoys: every vehicle publishes its position as MAVLink FOLLOW_TARGET
+ * (one message per UDP datagram) to a multicast group, and each follower only takes the messages of its predecessor.
+ * Positions are global (lat/lon), i.e., vehicles do not need to share their ENU reference. FOLLOW_TARGET's timestamp
+ * is UTC [ms] instead of time since boot, vehicles are expected to be GNSS time-synchronized.
+ * The ground station only configures the chain (MAV_CMD_DO_FOLLOW, see MavsdkVehicleServer), it is not on the data path.
+ */
+
+#ifndef MAVLINKCONVOYLINK_H
+#define MAVLINKCONVOYLINK_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include "core/coordinatetransforms.h"
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+class MavlinkConvoyLink : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr quint16 DEFAULT_PORT = 14560;
+    static constexpr int PREDECESSOR_TIMEOUT_MS = 1000;
+
+    explicit MavlinkConvoyLink(QObject *parent = nullptr);
+
+    bool start(quint8 systemId, quint16 port = DEFAULT_PORT, const QHostAddress &group = QHostAddress("239.255.145.1"));
+    void stop();
+    bool isStarted() const { return mSocket.state() == QAbstractSocket::BoundState; }
+
+    // 0: not following (e.g., convoy leader)
+    void setPredecessor(quint8 predecessorSystemId);
+    quint8 getPredecessor() const { return mPredecessorSystemId; }
+    bool isPredecessorAlive() const;
+
+    // yaw: ENU [deg], velocity: ENU [m/s]
+    void publishPosition(const llh_t &llh, double yaw_degENU, const xyz_t &velocityENU, qint64 timestamp_ns);
+
+signals:
+    void predecessorPositionReceived(const llh_t &llh, double yaw_degENU, const xyz_t &velocityENU, qint64 timestamp_ns);
+
+private:
+    void readDatagrams();
+
+    // MAVSDK allocates channels from 0, the last one is left for this link (sequence numbers)
+    static constexpr uint8_t MAVLINK_CHANNEL = MAVLINK_COMM_NUM_BUFFERS - 1;
+
+    QUdpSocket mSocket;
+    QHostAddress mGroup;
+    quint16 mPort = DEFAULT_PORT;
+    quint8 mSystemId = 0;
+    quint8 mPredecessorSystemId = 0;
+    QElapsedTimer mLastPredecessorPosition;
+    QByteArray mDatagram; // reused for every received datagram
+};
+
+#endif // MAVLINKCONVOYLINK_H
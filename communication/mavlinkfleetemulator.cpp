@@ -0,0 +1,400 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mavlinkfleetemulator.h"
+#include "waywise.h"
+#include <QDebug>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+MavlinkFleetEmulator::MavlinkFleetEmulator(const MavlinkFleetEmulatorConfig &config, QObject *parent) : QObject(parent), mConfig(config)
+{
+    memset(&mRxStatus, 0, sizeof(mRxStatus));
+    mTickTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mTickTimer, &QTimer::timeout, this, &MavlinkFleetEmulator::tick);
+    connect(&mSocket, &QUdpSocket::readyRead, this, &MavlinkFleetEmulator::readPendingDatagrams);
+}
+
+bool MavlinkFleetEmulator::start(const QHostAddress &stationAddress, quint16 stationPort, int vehicleCount)
+{
+    stop();
+    if (!mSocket.bind(QHostAddress::AnyIPv4, 0)) {
+        qWarning() << "WARNING: MavlinkFleetEmulator could not bind its socket:" << mSocket.errorString();
+        return false;
+    }
+
+    mStationAddress = stationAddress;
+    mStationPort = stationPort;
+    mLastStatistics_ms = getMonotonicTime_ms();
+    setVehicleCount(vehicleCount);
+    mTickTimer.start(TICK_INTERVAL_MS);
+    return true;
+}
+
+void MavlinkFleetEmulator::stop()
+{
+    mTickTimer.stop();
+    mSocket.close();
+    mVehicles.clear();
+}
+
+void MavlinkFleetEmulator::setVehicleCount(int vehicleCount)
+{
+    vehicleCount = qBound(0, vehicleCount, qMin(MAX_VEHICLES, 256 - mConfig.firstSystemId));
+    const qint64 now_ms = getMonotonicTime_ms();
+    while (mVehicles.size() < vehicleCount)
+        mVehicles.append(createVehicle(mVehicles.size(), now_ms));
+    mVehicles.resize(vehicleCount);
+    mStatistics.vehicles = vehicleCount;
+}
+
+MavlinkFleetEmulatorStatistics MavlinkFleetEmulator::getStatistics()
+{
+    const qint64 now_ms = getMonotonicTime_ms();
+    const double interval_s = (now_ms - mLastStatistics_ms) / 1000.0;
+    if (interval_s > 0.0) {
+        mStatistics.txMessages_Hz = (mStatistics.txMessages - mLastTxMessages) / interval_s;
+        mStatistics.txBytes_Bps = (mStatistics.txBytes - mLastTxBytes) / interval_s;
+    }
+    mLastTxMessages = mStatistics.txMessages;
+    mLastTxBytes = mStatistics.txBytes;
+    mLastStatistics_ms = now_ms;
+    return mStatistics;
+}
+
+MavlinkFleetEmulator::Vehicle MavlinkFleetEmulator::createVehicle(int index, qint64 now_ms) const
+{
+    Vehicle vehicle;
+    vehicle.systemId = quint8(mConfig.firstSystemId + index);
+    vehicle.bootTime_ms = now_ms;
+    vehicle.telemetryRate_Hz = mConfig.telemetryRate_Hz;
+
+    // Square grid of circles that do not overlap
+    const int columns = int(std::ceil(std::sqrt(double(MAX_VEHICLES))));
+    const double spacing_m = 2.5 * mConfig.circleRadius_m;
+    vehicle.center = {(index % columns) * spacing_m, (index / columns) * spacing_m, 0.0};
+    vehicle.phase_rad = 2.0 * M_PI * index / 7.0;
+
+    // Spread within the periods
+    const double nextOffset = double(index % 16) / 16.0;
+    vehicle.nextTelemetry_ms = now_ms + qint64(nextOffset * 1000.0 / vehicle.telemetryRate_Hz);
+    vehicle.nextStatus_ms = now_ms + qint64(nextOffset * 1000.0 / mConfig.statusRate_Hz);
+    vehicle.nextStatusText_ms = now_ms + qint64(nextOffset * mConfig.statusTextInterval_ms);
+    return vehicle;
+}
+
+void MavlinkFleetEmulator::tick()
+{
+    const qint64 now_ms = getMonotonicTime_ms();
+    for (Vehicle &vehicle : mVehicles) {
+        if (now_ms >= vehicle.nextStatus_ms) {
+            sendStatus(vehicle, now_ms);
+            vehicle.nextStatus_ms = qMax(vehicle.nextStatus_ms + qint64(1000.0 / mConfig.statusRate_Hz), now_ms);
+        }
+        if (vehicle.telemetryRate_Hz > 0.0 && now_ms >= vehicle.nextTelemetry_ms) {
+            sendTelemetry(vehicle, now_ms);
+            vehicle.nextTelemetry_ms = qMax(vehicle.nextTelemetry_ms + qint64(1000.0 / vehicle.telemetryRate_Hz), now_ms);
+        }
+        if (mConfig.statusTextInterval_ms > 0 && now_ms >= vehicle.nextStatusText_ms) {
+            sendStatusTextBurst(vehicle);
+            vehicle.nextStatusText_ms = qMax(vehicle.nextStatusText_ms + mConfig.statusTextInterval_ms, now_ms);
+        }
+        flush();
+    }
+}
+
+template<typename Pack>
+void MavlinkFleetEmulator::queueMessage(Vehicle &vehicle, Pack pack)
+{
+    mavlink_get_channel_status(TX_CHANNEL)->current_tx_seq = vehicle.txSequence++;
+    mavlink_message_t message;
+    pack(message);
+
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    const uint16_t length = mavlink_msg_to_send_buffer(buffer, &message);
+    mTxBuffer.append(reinterpret_cast<const char*>(buffer), length);
+    mStatistics.txMessages++;
+    mStatistics.txBytes += length;
+}
+
+void MavlinkFleetEmulator::flush()
+{
+    if (mTxBuffer.isEmpty())
+        return;
+
+    mSocket.writeDatagram(mTxBuffer, mStationAddress, mStationPort);
+    mTxBuffer.clear();
+}
+
+void MavlinkFleetEmulator::sendStatus(Vehicle &vehicle, qint64 now_ms)
+{
+    const quint8 systemId = vehicle.systemId;
+    queueMessage(vehicle, [systemId](mavlink_message_t &message) {
+        mavlink_msg_heartbeat_pack_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &message, MAV_TYPE_GROUND_ROVER, WAYWISE_MAVLINK_AUTOPILOT_ID,
+                                        MAV_MODE_FLAG_SAFETY_ARMED | MAV_MODE_FLAG_CUSTOM_MODE_ENABLED, 0, MAV_STATE_ACTIVE);
+    });
+
+    // Battery changes slowly and differs between vehicles
+    const int8_t batteryRemaining = int8_t(100 - (vehicle.systemId + (now_ms - vehicle.bootTime_ms) / 60000) % 100);
+    queueMessage(vehicle, [systemId, batteryRemaining](mavlink_message_t &message) {
+        mavlink_sys_status_t sysStatus;
+        memset(&sysStatus, 0, sizeof(sysStatus));
+        sysStatus.voltage_battery = 12000;
+        sysStatus.current_battery = -1;
+        sysStatus.battery_remaining = batteryRemaining;
+        mavlink_msg_sys_status_encode_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &message, &sysStatus);
+    });
+
+    const llh_t llh = coordinateTransforms::enuToLlh(mConfig.origin, vehicle.center);
+    const qint64 time_us = (now_ms - vehicle.bootTime_ms) * 1000;
+    queueMessage(vehicle, [systemId, llh, time_us](mavlink_message_t &message) {
+        mavlink_gps_raw_int_t gpsRawInt;
+        memset(&gpsRawInt, 0, sizeof(gpsRawInt));
+        gpsRawInt.time_usec = time_us;
+        gpsRawInt.fix_type = GPS_FIX_TYPE_RTK_FIXED;
+        gpsRawInt.lat = std::lround(llh.latitude * 1e7);
+        gpsRawInt.lon = std::lround(llh.longitude * 1e7);
+        gpsRawInt.alt = std::lround(llh.height * 1e3);
+        gpsRawInt.eph = 100;
+        gpsRawInt.epv = 100;
+        gpsRawInt.vel = UINT16_MAX;
+        gpsRawInt.cog = UINT16_MAX;
+        gpsRawInt.satellites_visible = 20;
+        mavlink_msg_gps_raw_int_encode_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &message, &gpsRawInt);
+    });
+}
+
+void MavlinkFleetEmulator::sendTelemetry(Vehicle &vehicle, qint64 now_ms)
+{
+    // Driving on a circle (counter-clockwise in ENU)
+    const double radius_m = mConfig.circleRadius_m;
+    const double angle_rad = vehicle.phase_rad + mConfig.speed / radius_m * (now_ms - vehicle.bootTime_ms) / 1000.0;
+    const xyz_t position = {vehicle.center.x + radius_m * cos(angle_rad), vehicle.center.y + radius_m * sin(angle_rad), 0.0};
+    const xyz_t velocity = {-mConfig.speed * sin(angle_rad), mConfig.speed * cos(angle_rad), 0.0};
+    const double yaw_degENU = (angle_rad + M_PI / 2.0) * 180.0 / M_PI;
+    const llh_t llh = coordinateTransforms::enuToLlh(mConfig.origin, position);
+    const quint32 timeBoot_ms = quint32(now_ms - vehicle.bootTime_ms);
+    const quint8 systemId = vehicle.systemId;
+
+    queueMessage(vehicle, [systemId, llh, velocity, yaw_degENU, timeBoot_ms](mavlink_message_t &message) {
+        double heading_deg = fmod(coordinateTransforms::yawENUtoNED(yaw_degENU), 360.0);
+        if (heading_deg < 0.0)
+            heading_deg += 360.0;
+        mavlink_msg_global_position_int_pack_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &message, timeBoot_ms,
+                                                  std::lround(llh.latitude * 1e7), std::lround(llh.longitude * 1e7), std::lround(llh.height * 1e3), 0,
+                                                  int16_t(velocity.y * 100.0), int16_t(velocity.x * 100.0), int16_t(-velocity.z * 100.0),
+                                                  uint16_t(heading_deg * 100.0));
+    });
+    queueMessage(vehicle, [systemId, position, velocity, timeBoot_ms](mavlink_message_t &message) {
+        mavlink_msg_local_position_ned_pack_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &message, timeBoot_ms,
+                                                 position.y, position.x, -position.z, velocity.y, velocity.x, -velocity.z);
+    });
+}
+
+void MavlinkFleetEmulator::sendStatusTextBurst(Vehicle &vehicle)
+{
+    const quint8 systemId = vehicle.systemId;
+    for (int i = 0; i < mConfig.statusTextBurst; i++) {
+        mavlink_statustext_t statusText;
+        memset(&statusText, 0, sizeof(statusText));
+        statusText.severity = MAV_SEVERITY_INFO;
+        snprintf(statusText.text, sizeof(statusText.text), "Emulated vehicle %d status text %u", int(systemId), vehicle.statusTexts++);
+        queueMessage(vehicle, [systemId, &statusText](mavlink_message_t &message) {
+            mavlink_msg_statustext_encode_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &message, &statusText);
+        });
+    }
+}
+
+void MavlinkFleetEmulator::readPendingDatagrams()
+{
+    while (mSocket.hasPendingDatagrams()) {
+        mRxDatagram.resize(int(mSocket.pendingDatagramSize()));
+        const qint64 size = mSocket.readDatagram(mRxDatagram.data(), mRxDatagram.size());
+
+        // Parsed with local state (independent of MAVLink's channels)
+        mavlink_message_t message;
+        mavlink_status_t status;
+        for (qint64 i = 0; i < size; i++)
+            if (mavlink_frame_char_buffer(&mRxBuffer, &mRxStatus, uint8_t(mRxDatagram.at(int(i))), &message, &status) == MAVLINK_FRAMING_OK) {
+                mStatistics.rxMessages++;
+                handleMessage(message);
+            }
+        flush();
+    }
+}
+
+MavlinkFleetEmulator::Vehicle *MavlinkFleetEmulator::findVehicle(quint8 systemId)
+{
+    const int index = int(systemId) - mConfig.firstSystemId;
+    return (index >= 0 && index < mVehicles.size()) ? &mVehicles[index] : nullptr;
+}
+
+void MavlinkFleetEmulator::handleMessage(const mavlink_message_t &message)
+{
+    // Only messages to a vehicle are answered, e.g., not the station's heartbeats
+    quint8 targetSystem = 0;
+    switch (message.msgid) {
+    case MAVLINK_MSG_ID_COMMAND_LONG: targetSystem = mavlink_msg_command_long_get_target_system(&message); break;
+    case MAVLINK_MSG_ID_MISSION_COUNT: targetSystem = mavlink_msg_mission_count_get_target_system(&message); break;
+    case MAVLINK_MSG_ID_MISSION_ITEM_INT: targetSystem = mavlink_msg_mission_item_int_get_target_system(&message); break;
+    case MAVLINK_MSG_ID_MISSION_REQUEST_LIST: targetSystem = mavlink_msg_mission_request_list_get_target_system(&message); break;
+    case MAVLINK_MSG_ID_MISSION_REQUEST_INT: targetSystem = mavlink_msg_mission_request_int_get_target_system(&message); break;
+    case MAVLINK_MSG_ID_MISSION_CLEAR_ALL: targetSystem = mavlink_msg_mission_clear_all_get_target_system(&message); break;
+    case MAVLINK_MSG_ID_MISSION_ACK: targetSystem = mavlink_msg_mission_ack_get_target_system(&message); break;
+    default: return;
+    }
+
+    Vehicle *vehicle = findVehicle(targetSystem);
+    if (!vehicle)
+        return;
+
+    if (message.msgid == MAVLINK_MSG_ID_COMMAND_LONG)
+        handleCommandLong(*vehicle, message);
+    else
+        handleMissionMessage(*vehicle, message);
+}
+
+void MavlinkFleetEmulator::handleCommandLong(Vehicle &vehicle, const mavlink_message_t &message)
+{
+    mavlink_command_long_t commandLong;
+    mavlink_msg_command_long_decode(&message, &commandLong);
+
+    uint8_t result = MAV_RESULT_ACCEPTED;
+    switch (commandLong.command) {
+    case MAV_CMD_SET_MESSAGE_INTERVAL: // telemetry streams only, interval in us, -1: disable, 0: default
+        if (commandLong.param1 == MAVLINK_MSG_ID_GLOBAL_POSITION_INT || commandLong.param1 == MAVLINK_MSG_ID_LOCAL_POSITION_NED) {
+            vehicle.telemetryRate_Hz = commandLong.param2 < 0.0f ? 0.0 : (commandLong.param2 == 0.0f ? mConfig.telemetryRate_Hz : 1e6 / commandLong.param2);
+            vehicle.nextTelemetry_ms = getMonotonicTime_ms();
+        } else
+            result = MAV_RESULT_UNSUPPORTED;
+        break;
+    case MAV_CMD_REQUEST_MESSAGE: // e.g., AUTOPILOT_VERSION, not emulated
+        result = MAV_RESULT_UNSUPPORTED;
+        break;
+    default:
+        break;
+    }
+
+    mavlink_command_ack_t commandAck;
+    memset(&commandAck, 0, sizeof(commandAck));
+    commandAck.command = commandLong.command;
+    commandAck.result = result;
+    commandAck.target_system = message.sysid;
+    commandAck.target_component = message.compid;
+    const quint8 systemId = vehicle.systemId;
+    queueMessage(vehicle, [systemId, &commandAck](mavlink_message_t &ack) {
+        mavlink_msg_command_ack_encode_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &ack, &commandAck);
+    });
+    mStatistics.commandsAcked++;
+}
+
+void MavlinkFleetEmulator::handleMissionMessage(Vehicle &vehicle, const mavlink_message_t &message)
+{
+    const quint8 systemId = vehicle.systemId;
+    const quint8 targetSystem = message.sysid;
+    const quint8 targetComponent = message.compid;
+    MissionTransfer &transfer = vehicle.missionTransfer;
+
+    auto sendAck = [this, &vehicle, systemId, targetSystem, targetComponent](uint8_t type, uint8_t missionType) {
+        mavlink_mission_ack_t missionAck;
+        memset(&missionAck, 0, sizeof(missionAck));
+        missionAck.target_system = targetSystem;
+        missionAck.target_component = targetComponent;
+        missionAck.type = type;
+        missionAck.mission_type = missionType;
+        queueMessage(vehicle, [systemId, &missionAck](mavlink_message_t &ack) {
+            mavlink_msg_mission_ack_encode_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &ack, &missionAck);
+        });
+    };
+    auto requestItem = [this, &vehicle, systemId, targetSystem, targetComponent](quint16 sequence, uint8_t missionType) {
+        mavlink_mission_request_int_t missionRequest;
+        memset(&missionRequest, 0, sizeof(missionRequest));
+        missionRequest.target_system = targetSystem;
+        missionRequest.target_component = targetComponent;
+        missionRequest.seq = sequence;
+        missionRequest.mission_type = missionType;
+        queueMessage(vehicle, [systemId, &missionRequest](mavlink_message_t &request) {
+            mavlink_msg_mission_request_int_encode_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &request, &missionRequest);
+        });
+    };
+
+    switch (message.msgid) {
+    case MAVLINK_MSG_ID_MISSION_COUNT: { // upload
+        mavlink_mission_count_t missionCount;
+        mavlink_msg_mission_count_decode(&message, &missionCount);
+        transfer = {missionCount.count > 0, missionCount.count, 0, missionCount.mission_type};
+        vehicle.mission.clear();
+        if (missionCount.count == 0) {
+            sendAck(MAV_MISSION_ACCEPTED, missionCount.mission_type);
+            mStatistics.missionsUploaded++;
+        } else
+            requestItem(0, missionCount.mission_type);
+    } break;
+
+    case MAVLINK_MSG_ID_MISSION_ITEM_INT: {
+        mavlink_mission_item_int_t missionItem;
+        mavlink_msg_mission_item_int_decode(&message, &missionItem);
+        if (!transfer.uploading) {
+            if (missionItem.seq + 1 == transfer.count) // our ack got lost
+                sendAck(MAV_MISSION_ACCEPTED, transfer.missionType);
+            break;
+        }
+        if (missionItem.seq != transfer.nextSequence) { // retransmission
+            requestItem(transfer.nextSequence, transfer.missionType);
+            break;
+        }
+
+        vehicle.mission.append(missionItem);
+        transfer.nextSequence++;
+        if (transfer.nextSequence < transfer.count)
+            requestItem(transfer.nextSequence, transfer.missionType);
+        else {
+            transfer.uploading = false;
+            sendAck(MAV_MISSION_ACCEPTED, transfer.missionType);
+            mStatistics.missionsUploaded++;
+        }
+    } break;
+
+    case MAVLINK_MSG_ID_MISSION_REQUEST_LIST: { // download
+        mavlink_mission_count_t missionCount;
+        memset(&missionCount, 0, sizeof(missionCount));
+        missionCount.target_system = targetSystem;
+        missionCount.target_component = targetComponent;
+        missionCount.count = quint16(vehicle.mission.size());
+        missionCount.mission_type = mavlink_msg_mission_request_list_get_mission_type(&message);
+        queueMessage(vehicle, [systemId, &missionCount](mavlink_message_t &countMessage) {
+            mavlink_msg_mission_count_encode_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &countMessage, &missionCount);
+        });
+    } break;
+
+    case MAVLINK_MSG_ID_MISSION_REQUEST_INT: {
+        const quint16 sequence = mavlink_msg_mission_request_int_get_seq(&message);
+        if (sequence >= vehicle.mission.size()) {
+            sendAck(MAV_MISSION_INVALID_SEQUENCE, mavlink_msg_mission_request_int_get_mission_type(&message));
+            break;
+        }
+        mavlink_mission_item_int_t missionItem = vehicle.mission.at(sequence);
+        missionItem.target_system = targetSystem;
+        missionItem.target_component = targetComponent;
+        queueMessage(vehicle, [systemId, &missionItem](mavlink_message_t &item) {
+            mavlink_msg_mission_item_int_encode_chan(systemId, MAV_COMP_ID_AUTOPILOT1, TX_CHANNEL, &item, &missionItem);
+        });
+    } break;
+
+    case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
+        vehicle.mission.clear();
+        transfer = MissionTransfer();
+        sendAck(MAV_MISSION_ACCEPTED, mavlink_msg_mission_clear_all_get_mission_type(&message));
+        break;
+
+    default: // MISSION_ACK of a download
+        break;
+    }
+}
+
+qint64 MavlinkFleetEmulator::getMonotonicTime_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
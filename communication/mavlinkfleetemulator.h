@@ -0,0 +1,118 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Emulates a fleet of WayWise vehicles towards a control station (e.g., MavsdkStation), for stress testing with many vehicles
+ * from a single process. Vehicles are plain structs that drive on circles and are encoded with the MAVLink C headers directly
+ * (no MAVSDK instance per vehicle): heartbeats as sent by MavsdkVehicleServer, the position telemetry streams, slow status
+ * streams and STATUSTEXT bursts, all on one UDP socket. The mission protocol (upload, download, clear) and COMMAND_LONG are
+ * answered, MAV_CMD_SET_MESSAGE_INTERVAL changes the telemetry rate of the vehicle. Vehicles are phase-shifted within the
+ * telemetry period, i.e., their load is spread instead of bursty. See tools/fleet_load_generator.
+ */
+
+#ifndef MAVLINKFLEETEMULATOR_H
+#define MAVLINKFLEETEMULATOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QVector>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+#include "core/coordinatetransforms.h"
+
+struct MavlinkFleetEmulatorConfig {
+    quint8 firstSystemId = 1;
+    double telemetryRate_Hz = 10.0; // GLOBAL_POSITION_INT, LOCAL_POSITION_NED
+    double statusRate_Hz = 1.0; // HEARTBEAT, SYS_STATUS, GPS_RAW_INT
+    int statusTextInterval_ms = 10000; // 0: none
+    int statusTextBurst = 5; // messages per burst
+    llh_t origin = {57.71495867, 12.89134921, 0};
+    double circleRadius_m = 20.0; // vehicles are spread on a grid, each drives its own circle
+    double speed = 2.0; // [m/s]
+};
+
+struct MavlinkFleetEmulatorStatistics {
+    int vehicles = 0;
+    quint64 txMessages = 0;
+    quint64 txBytes = 0;
+    quint64 rxMessages = 0;
+    quint64 missionsUploaded = 0;
+    quint64 commandsAcked = 0;
+    double txMessages_Hz = 0.0; // since the last getStatistics()
+    double txBytes_Bps = 0.0;
+};
+
+class MavlinkFleetEmulator : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int TICK_INTERVAL_MS = 5; // scheduling resolution
+    static constexpr int MAX_VEHICLES = 250; // system ids
+    static constexpr mavlink_channel_t TX_CHANNEL = MAVLINK_COMM_2; // its sequence is set per vehicle, i.e., not for use by MAVSDK in the same process
+
+    explicit MavlinkFleetEmulator(const MavlinkFleetEmulatorConfig &config = MavlinkFleetEmulatorConfig(), QObject *parent = nullptr);
+
+    bool start(const QHostAddress &stationAddress = QHostAddress::LocalHost, quint16 stationPort = 14540, int vehicleCount = 1);
+    void stop();
+    bool isRunning() const { return mTickTimer.isActive(); }
+    // Vehicles are added or removed (the station sees them time out) while running, e.g., to ramp up the load
+    void setVehicleCount(int vehicleCount);
+    int getVehicleCount() const { return mVehicles.size(); }
+    MavlinkFleetEmulatorStatistics getStatistics();
+
+private:
+    struct MissionTransfer {
+        bool uploading = false;
+        quint16 count = 0;
+        quint16 nextSequence = 0;
+        quint8 missionType = MAV_MISSION_TYPE_MISSION;
+    };
+    struct Vehicle {
+        quint8 systemId = 0;
+        quint8 txSequence = 0;
+        xyz_t center;
+        double phase_rad = 0.0;
+        qint64 bootTime_ms = 0;
+        qint64 nextTelemetry_ms = 0;
+        qint64 nextStatus_ms = 0;
+        qint64 nextStatusText_ms = 0;
+        double telemetryRate_Hz = 10.0;
+        QVector<mavlink_mission_item_int_t> mission;
+        MissionTransfer missionTransfer;
+        quint32 statusTexts = 0;
+    };
+
+    void tick();
+    void readPendingDatagrams();
+    void handleMessage(const mavlink_message_t &message);
+    void handleMissionMessage(Vehicle &vehicle, const mavlink_message_t &message);
+    void handleCommandLong(Vehicle &vehicle, const mavlink_message_t &message);
+
+    void sendTelemetry(Vehicle &vehicle, qint64 now_ms);
+    void sendStatus(Vehicle &vehicle, qint64 now_ms);
+    void sendStatusTextBurst(Vehicle &vehicle);
+    // pack(message) encodes on TX_CHANNEL with the sequence of the vehicle, the message is appended to mTxBuffer
+    template<typename Pack> void queueMessage(Vehicle &vehicle, Pack pack);
+    void flush();
+
+    Vehicle *findVehicle(quint8 systemId);
+    Vehicle createVehicle(int index, qint64 now_ms) const;
+    static qint64 getMonotonicTime_ms();
+
+    MavlinkFleetEmulatorConfig mConfig;
+    QUdpSocket mSocket;
+    QHostAddress mStationAddress;
+    quint16 mStationPort = 14540;
+    QTimer mTickTimer;
+    QVector<Vehicle> mVehicles;
+    QByteArray mTxBuffer; // one datagram per vehicle and tick
+    QByteArray mRxDatagram;
+    mavlink_message_t mRxBuffer;
+    mavlink_status_t mRxStatus;
+    MavlinkFleetEmulatorStatistics mStatistics;
+    quint64 mLastTxMessages = 0;
+    quint64 mLastTxBytes = 0;
+    qint64 mLastStatistics_ms = 0;
+};
+
+#endif // MAVLINKFLEETEMULATOR_H
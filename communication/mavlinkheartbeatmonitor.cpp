@@ -0,0 +1,110 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mavlinkheartbeatmonitor.h"
+#include <algorithm>
+#include <cmath>
+
+MavlinkHeartbeatMonitor::MavlinkHeartbeatMonitor(qint64 timeout_ms, qint64 resolution_ms)
+{
+    mResolution_ms = std::max(resolution_ms, (qint64)1);
+    mTimeout_ms = std::max(timeout_ms, mResolution_ms);
+    // A deadline is at most one timeout (rounded up) after the last expired tick, never in a slot that is still to expire
+    mSlots.fill(NONE, mTimeout_ms / mResolution_ms + 3);
+}
+
+void MavlinkHeartbeatMonitor::add(uint8_t systemId, qint64 now_ms)
+{
+    if (mNextTick < 0)
+        mNextTick = getTick(now_ms);
+
+    Entry &entry = mEntries[systemId];
+    if (entry.active)
+        unlink(systemId);
+    entry = Entry();
+    entry.active = true;
+    entry.lastHeartbeat_ms = now_ms;
+    schedule(systemId, now_ms + mTimeout_ms);
+}
+
+void MavlinkHeartbeatMonitor::remove(uint8_t systemId)
+{
+    if (!mEntries[systemId].active)
+        return;
+
+    unlink(systemId);
+    mEntries[systemId].active = false;
+}
+
+void MavlinkHeartbeatMonitor::refresh(uint8_t systemId, qint64 now_ms)
+{
+    Entry &entry = mEntries[systemId];
+    if (!entry.active)
+        return;
+
+    MavlinkHeartbeatStatistics &statistics = entry.statistics;
+    const double interval_ms = now_ms - entry.lastHeartbeat_ms;
+    if (statistics.heartbeats > 0) {
+        const double jitter_ms = fabs(interval_ms - statistics.lastInterval_ms);
+        statistics.maxJitter_ms = std::max(statistics.maxJitter_ms, jitter_ms);
+        statistics.meanJitter_ms += (jitter_ms - statistics.meanJitter_ms) / statistics.heartbeats;
+    }
+    statistics.heartbeats++;
+    statistics.lastInterval_ms = interval_ms;
+    statistics.maxInterval_ms = std::max(statistics.maxInterval_ms, interval_ms);
+    statistics.meanInterval_ms += (interval_ms - statistics.meanInterval_ms) / statistics.heartbeats;
+    entry.lastHeartbeat_ms = now_ms;
+
+    unlink(systemId);
+    schedule(systemId, now_ms + mTimeout_ms);
+}
+
+QVector<uint8_t> MavlinkHeartbeatMonitor::expire(qint64 now_ms)
+{
+    QVector<uint8_t> expired;
+    if (mNextTick < 0)
+        return expired;
+
+    // At most one round, e.g., after a long pause
+    const qint64 nowTick = now_ms / mResolution_ms;
+    const qint64 lastTick = std::min(nowTick, mNextTick + mSlots.size() - 1);
+    for (qint64 tick = mNextTick; tick <= lastTick; tick++) {
+        int16_t systemId = mSlots[tick % mSlots.size()];
+        while (systemId != NONE) {
+            const int16_t next = mEntries[systemId].next;
+            if (mEntries[systemId].deadline_ms <= now_ms) {
+                remove(systemId);
+                expired.append(systemId);
+            }
+            systemId = next;
+        }
+    }
+    mNextTick = std::max(mNextTick, nowTick + 1);
+
+    return expired;
+}
+
+void MavlinkHeartbeatMonitor::schedule(uint8_t systemId, qint64 deadline_ms)
+{
+    Entry &entry = mEntries[systemId];
+    entry.deadline_ms = deadline_ms;
+    entry.slot = std::max(getTick(deadline_ms), mNextTick) % mSlots.size();
+    entry.previous = NONE;
+    entry.next = mSlots[entry.slot];
+    if (entry.next != NONE)
+        mEntries[entry.next].previous = systemId;
+    mSlots[entry.slot] = systemId;
+}
+
+void MavlinkHeartbeatMonitor::unlink(uint8_t systemId)
+{
+    Entry &entry = mEntries[systemId];
+    if (entry.previous != NONE)
+        mEntries[entry.previous].next = entry.next;
+    else
+        mSlots[entry.slot] = entry.next;
+    if (entry.next != NONE)
+        mEntries[entry.next].previous = entry.previous;
+    entry.previous = entry.next = NONE;
+}
@@ -0,0 +1,62 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Heartbeat timeouts of MAVLink systems (by system id) in a timer wheel: slots of the given resolution cover the
+ * timeout, each holds an intrusive list of the systems whose deadline falls into it. Refreshing a system and expiring
+ * a slot are O(1) per system, independent of the number of monitored systems.
+ * Also keeps heartbeat inter-arrival statistics per system. Not thread-safe, use from one thread.
+ */
+
+#ifndef MAVLINKHEARTBEATMONITOR_H
+#define MAVLINKHEARTBEATMONITOR_H
+
+#include <QVector>
+#include <array>
+#include <cstdint>
+#include "communication/mavlinklinkmonitor.h"
+
+class MavlinkHeartbeatMonitor
+{
+public:
+    MavlinkHeartbeatMonitor(qint64 timeout_ms = 5000, qint64 resolution_ms = 100);
+
+    qint64 getTimeout_ms() const { return mTimeout_ms; }
+    qint64 getResolution_ms() const { return mResolution_ms; }
+
+    // Times are monotonic [ms], e.g., std::chrono::steady_clock
+    void add(uint8_t systemId, qint64 now_ms); // starts monitoring, first deadline is one timeout from now
+    void remove(uint8_t systemId);
+    bool contains(uint8_t systemId) const { return mEntries[systemId].active; }
+    void refresh(uint8_t systemId, qint64 now_ms); // heartbeat received, ignored for systems not monitored
+
+    // Removes and returns the systems whose deadline has passed
+    QVector<uint8_t> expire(qint64 now_ms);
+
+    MavlinkHeartbeatStatistics getStatistics(uint8_t systemId) const { return mEntries[systemId].statistics; }
+
+private:
+    static constexpr int16_t NONE = -1;
+
+    struct Entry {
+        bool active = false;
+        qint64 deadline_ms = 0;
+        int slot = 0;
+        int16_t previous = NONE;
+        int16_t next = NONE;
+        qint64 lastHeartbeat_ms = 0;
+        MavlinkHeartbeatStatistics statistics;
+    };
+
+    qint64 getTick(qint64 time_ms) const { return (time_ms + mResolution_ms - 1) / mResolution_ms; } // rounded up
+    void schedule(uint8_t systemId, qint64 deadline_ms);
+    void unlink(uint8_t systemId);
+
+    qint64 mTimeout_ms;
+    qint64 mResolution_ms;
+    QVector<int16_t> mSlots; // first system of each slot's list
+    qint64 mNextTick = -1; // first tick not expired yet
+    std::array<Entry, 256> mEntries;
+};
+
+#endif // MAVLINKHEARTBEATMONITOR_H
@@ -0,0 +1,76 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mavlinklinkmonitor.h"
+
+MavlinkLinkMonitor::MavlinkLinkMonitor()
+{
+    mLastUpdate = std::chrono::steady_clock::now();
+}
+
+void MavlinkLinkMonitor::countIncoming(const mavlink_message_t &message)
+{
+    mRxBytes += mavlink_msg_get_send_buffer_length(&message);
+    mRxPackets++;
+
+    // Every component increments its sequence number per message sent (wrapping at 256), gaps are lost messages
+    const quint16 source = (quint16(message.sysid) << 8) | message.compid;
+    std::lock_guard<std::mutex> lock(mLastSequenceMutex);
+    auto lastSequence = mLastSequence.find(source);
+    if (lastSequence != mLastSequence.end()) {
+        const uint8_t gap = message.seq - uint8_t(lastSequence.value() + 1);
+        if (gap < 128) // larger "gaps" are reordering or a restarted component
+            mRxPacketsLost += gap;
+        lastSequence.value() = message.seq;
+    } else
+        mLastSequence.insert(source, message.seq);
+}
+
+void MavlinkLinkMonitor::countOutgoing(const mavlink_message_t &message)
+{
+    mTxBytes += mavlink_msg_get_send_buffer_length(&message);
+    mTxPackets++;
+}
+
+MavlinkLinkStatistics MavlinkLinkMonitor::update()
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const double dt_s = std::chrono::duration<double>(now - mLastUpdate).count();
+    mLastUpdate = now;
+
+    MavlinkLinkStatistics statistics;
+    statistics.rxBytes = mRxBytes;
+    statistics.txBytes = mTxBytes;
+    statistics.rxPackets = mRxPackets;
+    statistics.txPackets = mTxPackets;
+    statistics.rxPacketsLost = mRxPacketsLost;
+
+    if (dt_s > 0.0) {
+        statistics.rxBytesPerSecond = (statistics.rxBytes - mStatistics.rxBytes) / dt_s;
+        statistics.txBytesPerSecond = (statistics.txBytes - mStatistics.txBytes) / dt_s;
+        statistics.rxPacketsPerSecond = (statistics.rxPackets - mStatistics.rxPackets) / dt_s;
+        statistics.txPacketsPerSecond = (statistics.txPackets - mStatistics.txPackets) / dt_s;
+    }
+
+    const quint64 rxPacketsReceived = statistics.rxPackets - mStatistics.rxPackets;
+    const quint64 rxPacketsLost = statistics.rxPacketsLost - mStatistics.rxPacketsLost;
+    if (rxPacketsReceived + rxPacketsLost > 0)
+        statistics.rxLossRatio = double(rxPacketsLost) / (rxPacketsReceived + rxPacketsLost);
+
+    mStatistics = statistics;
+    return statistics;
+}
+
+uint8_t MavlinkLinkMonitor::getTargetSystem(const mavlink_message_t &message)
+{
+    const mavlink_msg_entry_t *msgEntry = mavlink_get_msg_entry(message.msgid);
+    if (msgEntry == nullptr || !(msgEntry->flags & MAV_MSG_ENTRY_FLAG_HAVE_TARGET_SYSTEM))
+        return 0;
+
+    // MAVLink 2 truncates trailing zero bytes of the payload, i.e., a missing target is 0
+    if (msgEntry->target_system_ofs >= message.len)
+        return 0;
+
+    return _MAV_PAYLOAD(&message)[msgEntry->target_system_ofs];
+}
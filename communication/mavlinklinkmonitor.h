@@ -0,0 +1,75 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Byte/packet counters of a MAVLink link, fed with the messages passing it (e.g., from MAVSDK's message interception).
+ * Incoming packet loss is estimated from gaps in the MAVLink sequence numbers of each sending component.
+ * Counting is thread-safe, rates are computed over the time between two calls of update().
+ */
+
+#ifndef MAVLINKLINKMONITOR_H
+#define MAVLINKLINKMONITOR_H
+
+#include <QtGlobal>
+#include <QHash>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+// Heartbeats of the other side, by MavlinkHeartbeatMonitor
+struct MavlinkHeartbeatStatistics {
+    quint64 heartbeats = 0;
+    double lastInterval_ms = 0.0;
+    double meanInterval_ms = 0.0;
+    double maxInterval_ms = 0.0;
+    double meanJitter_ms = 0.0; // deviation of an interval from the previous one
+    double maxJitter_ms = 0.0;
+};
+
+struct MavlinkLinkStatistics {
+    // totals since creation
+    quint64 rxBytes = 0;
+    quint64 txBytes = 0;
+    quint64 rxPackets = 0;
+    quint64 txPackets = 0;
+    quint64 rxPacketsLost = 0;
+    // between the last two updates
+    double rxBytesPerSecond = 0.0;
+    double txBytesPerSecond = 0.0;
+    double rxPacketsPerSecond = 0.0;
+    double txPacketsPerSecond = 0.0;
+    double rxLossRatio = 0.0; // lost / (received + lost)
+    MavlinkHeartbeatStatistics heartbeat; // if monitored (ground station)
+};
+
+class MavlinkLinkMonitor
+{
+public:
+    MavlinkLinkMonitor();
+
+    void countIncoming(const mavlink_message_t &message);
+    void countOutgoing(const mavlink_message_t &message);
+
+    // Computes rates since the last update (call periodically from one thread)
+    MavlinkLinkStatistics update();
+    MavlinkLinkStatistics getStatistics() const { return mStatistics; } // as of the last update, from the updating thread
+
+    // Target system id of a message, 0 for broadcasts and messages without target
+    static uint8_t getTargetSystem(const mavlink_message_t &message);
+
+private:
+    std::atomic<quint64> mRxBytes{0};
+    std::atomic<quint64> mTxBytes{0};
+    std::atomic<quint64> mRxPackets{0};
+    std::atomic<quint64> mTxPackets{0};
+    std::atomic<quint64> mRxPacketsLost{0};
+
+    std::mutex mLastSequenceMutex;
+    QHash<quint16, uint8_t> mLastSequence; // by system id << 8 | component id
+
+    std::chrono::steady_clock::time_point mLastUpdate;
+    MavlinkLinkStatistics mStatistics;
+};
+
+#endif // MAVLINKLINKMONITOR_H
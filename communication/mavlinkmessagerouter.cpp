@@ -0,0 +1,100 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mavlinkmessagerouter.h"
+#include <thread>
+
+namespace {
+thread_local int tRouteDepth = 0; // > 0: called from a handler
+}
+
+MavlinkMessageRouter::HandlerId MavlinkMessageRouter::subscribe(uint8_t systemId, uint32_t messageId, MessageHandler handler)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Subscriptions &subscriptions = mSubscriptions[getKey(systemId, messageId)];
+    auto newSubscriptions = subscriptions ? std::make_shared<std::vector<Subscription>>(*subscriptions)
+                                          : std::make_shared<std::vector<Subscription>>();
+    const HandlerId handlerId = mNextHandlerId++;
+    newSubscriptions->push_back({handlerId, std::move(handler)});
+    subscriptions = newSubscriptions;
+    return handlerId;
+}
+
+void MavlinkMessageRouter::unsubscribe(HandlerId handlerId)
+{
+    if (!removeSubscription(handlerId))
+        return;
+    waitForRunningHandlers();
+}
+
+bool MavlinkMessageRouter::removeSubscription(HandlerId handlerId)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto entry = mSubscriptions.begin(); entry != mSubscriptions.end(); entry++) {
+        const std::vector<Subscription> &subscriptions = *entry->second;
+        for (size_t i = 0; i < subscriptions.size(); i++) {
+            if (subscriptions[i].id != handlerId)
+                continue;
+
+            if (subscriptions.size() == 1) {
+                mSubscriptions.erase(entry);
+            } else {
+                auto newSubscriptions = std::make_shared<std::vector<Subscription>>(subscriptions);
+                newSubscriptions->erase(newSubscriptions->begin() + i);
+                entry->second = newSubscriptions;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void MavlinkMessageRouter::unsubscribeSystem(uint8_t systemId)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto entry = mSubscriptions.begin(); entry != mSubscriptions.end();) {
+            if ((entry->first >> 24) == systemId)
+                entry = mSubscriptions.erase(entry);
+            else
+                entry++;
+        }
+    }
+    waitForRunningHandlers();
+}
+
+void MavlinkMessageRouter::waitForRunningHandlers() const
+{
+    // Handlers found before unsubscribing might still run, messages are routed one at a time (MAVSDK's receive thread)
+    if (tRouteDepth > 0)
+        return;
+    while (mActiveRoutes.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}
+
+int MavlinkMessageRouter::route(const mavlink_message_t &message)
+{
+    mActiveRoutes.fetch_add(1, std::memory_order_acq_rel);
+    Subscriptions subscriptions;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const auto entry = mSubscriptions.find(getKey(message.sysid, message.msgid));
+        if (entry != mSubscriptions.end())
+            subscriptions = entry->second;
+    }
+
+    int numHandlers = 0;
+    if (subscriptions) {
+        mRoutedMessages.fetch_add(1, std::memory_order_relaxed);
+        tRouteDepth++;
+        for (const auto &subscription : *subscriptions)
+            subscription.handler(message);
+        tRouteDepth--;
+        numHandlers = subscriptions->size();
+    } else
+        mUnroutedMessages.fetch_add(1, std::memory_order_relaxed);
+
+    mActiveRoutes.fetch_sub(1, std::memory_order_acq_rel);
+    return numHandlers;
+}
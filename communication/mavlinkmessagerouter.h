@@ -0,0 +1,60 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Dispatches incoming MAVLink messages to handlers by system ID and message ID, e.g., fed by MavsdkStation from a single
+ * MAVSDK message interception. Routing is one hash lookup per message and does not allocate, compared to per-vehicle
+ * MavlinkPassthrough/Telemetry subscriptions that each get every message and run their own callback machinery.
+ * Handlers are called on the thread calling route() and may (un)subscribe from within. (Un)subscribing is thread-safe,
+ * unsubscribing from another thread waits for handlers that are running meanwhile, i.e., their context can be deleted afterwards.
+ */
+
+#ifndef MAVLINKMESSAGEROUTER_H
+#define MAVLINKMESSAGEROUTER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+class MavlinkMessageRouter
+{
+public:
+    typedef std::function<void(const mavlink_message_t &)> MessageHandler;
+    typedef quint64 HandlerId; // 0: invalid
+
+    HandlerId subscribe(uint8_t systemId, uint32_t messageId, MessageHandler handler);
+    void unsubscribe(HandlerId handlerId);
+    void unsubscribeSystem(uint8_t systemId);
+
+    // Returns the number of handlers the message was dispatched to
+    int route(const mavlink_message_t &message);
+
+    quint64 getRoutedMessages() const { return mRoutedMessages.load(std::memory_order_relaxed); }
+    quint64 getUnroutedMessages() const { return mUnroutedMessages.load(std::memory_order_relaxed); }
+
+private:
+    struct Subscription {
+        HandlerId id;
+        MessageHandler handler;
+    };
+    // Copy-on-write, route() keeps a reference while calling the handlers without holding the lock
+    typedef std::shared_ptr<const std::vector<Subscription>> Subscriptions;
+
+    static uint32_t getKey(uint8_t systemId, uint32_t messageId) { return (uint32_t(systemId) << 24) | (messageId & 0xFFFFFF); }
+    bool removeSubscription(HandlerId handlerId);
+    void waitForRunningHandlers() const;
+
+    std::mutex mMutex;
+    std::unordered_map<uint32_t, Subscriptions> mSubscriptions;
+    HandlerId mNextHandlerId = 1;
+    std::atomic<int> mActiveRoutes{0};
+    std::atomic<quint64> mRoutedMessages{0};
+    std::atomic<quint64> mUnroutedMessages{0};
+};
+
+#endif // MAVLINKMESSAGEROUTER_H
@@ -4,8 +4,6 @@
  */
 
 #include "mavlinkparameterserver.h"
-#include <QXmlStreamWriter>
-#include <QFile>
 #include <QDebug>
 
 MavlinkParameterServer::MavlinkParameterServer(std::shared_ptr<mavsdk::ServerComponent> serverComponent)
@@ -30,51 +28,30 @@ void MavlinkParameterServer::initialize(std::shared_ptr<mavsdk::ServerComponent>
 
 /**
  * By convention, every parameter in a group should share the same (meaningful) string prefix followed by an underscore.
- *
- * @param parameterName
  * Parameter names must be no more than 16 ASCII characters
  */
-void MavlinkParameterServer::provideIntParameter(std::string parameterName, std::function<void(int)> setClassParameterFunction, std::function<int(void)> getClassParameterFunction)
+void MavlinkParameterServer::parameterProvided(const Parameter &parameter)
 {
-    const std::lock_guard<std::mutex> lock(mMutex);
-    mIntParameterToClassMapping.insert_or_assign(parameterName, std::make_pair(setClassParameterFunction, getClassParameterFunction));
-    mMavsdkParamServer->provide_param_int(parameterName, getClassParameterFunction());
-};
-
-void MavlinkParameterServer::provideFloatParameter(std::string parameterName, std::function<void(float)> setClassParameterFunction, std::function<float(void)> getClassParameterFunction)
-{
-    const std::lock_guard<std::mutex> lock(mMutex);
-    mFloatParameterToClassMapping.insert_or_assign(parameterName, std::make_pair(setClassParameterFunction, getClassParameterFunction));
-    mMavsdkParamServer->provide_param_float(parameterName, getClassParameterFunction());
-};
+    if (parameter.type == ParameterType::Int)
+        mMavsdkParamServer->provide_param_int(parameter.name, int32_t(parameter.get(parameter.object)));
+    else
+        mMavsdkParamServer->provide_param_float(parameter.name, float(parameter.get(parameter.object)));
+}
 
-void MavlinkParameterServer::saveParametersToXmlFile(QString filename)
+ParameterServer::AllParameters MavlinkParameterServer::getParametersToSave()
 {
-    const std::lock_guard<std::mutex> lock(mMutex);
-    mavsdk::ParamServer::AllParams parameters = mMavsdkParamServer->retrieve_all_params();
-    QFile parameterFile(filename);
-
-    if (!parameterFile.open(QIODevice::WriteOnly)) {
-        qDebug() << "Failed to open file, could not save parameters";
-        return;
-    }
-
-    QXmlStreamWriter stream(&parameterFile);
-    stream.setCodec("UTF-8");
-    stream.setAutoFormatting(true);
-    stream.writeStartDocument();
-
-    for (const auto& vehicleParameter : parameters.int_params) {
-        stream.writeTextElement(QString::fromStdString(vehicleParameter.name), QString::number(vehicleParameter.value));
-    }
-    for (const auto& vehicleParameter : parameters.float_params) {
-        stream.writeTextElement(QString::fromStdString(vehicleParameter.name), QString::number(vehicleParameter.value));
-    }
-    for (const auto& vehicleParameter : parameters.custom_params) {
-        stream.writeTextElement(QString::fromStdString(vehicleParameter.name), QString::fromStdString(vehicleParameter.value));
+    mavsdk::ParamServer::AllParams parameters;
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        parameters = mMavsdkParamServer->retrieve_all_params();
     }
 
-    stream.writeEndElement();
-    stream.writeEndDocument();
-    parameterFile.close();
+    AllParameters parametersToSave;
+    for (const auto& vehicleParameter : parameters.int_params)
+        parametersToSave.intParameters.push_back({vehicleParameter.name, vehicleParameter.value});
+    for (const auto& vehicleParameter : parameters.float_params)
+        parametersToSave.floatParameters.push_back({vehicleParameter.name, vehicleParameter.value});
+    for (const auto& vehicleParameter : parameters.custom_params)
+        parametersToSave.customParameters.push_back({vehicleParameter.name, vehicleParameter.value});
+    return parametersToSave;
 };
@@ -16,13 +16,12 @@ class MavlinkParameterServer : public ParameterServer
     Q_OBJECT
 public:
     static void initialize(std::shared_ptr<mavsdk::ServerComponent> serverComponent);
-    virtual void provideIntParameter(std::string parameterName, std::function<void(int)> setClassParameterFunction, std::function<int(void)> getClassParameterFunction) override;
-    virtual void provideFloatParameter(std::string parameterName, std::function<void(float)> setClassParameterFunction, std::function<float(void)> getClassParameterFunction) override;
-    virtual void saveParametersToXmlFile(QString filename) override;
 
 protected:
     MavlinkParameterServer(std::shared_ptr<mavsdk::ServerComponent> serverComponent);
-    ~MavlinkParameterServer(){};
+    ~MavlinkParameterServer() { stopSaveThread(); };
+    virtual AllParameters getParametersToSave() override;
+    virtual void parameterProvided(const Parameter &parameter) override;
 
 private:
     mavsdk::ParamServer *mMavsdkParamServer;
@@ -0,0 +1,396 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mavlinkroutetransfer.h"
+#include "core/routecodec.h"
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+namespace mavlinkRouteTransfer {
+
+namespace {
+void writeUint16(uint8_t *data, uint16_t value)
+{
+    data[0] = value & 0xFF;
+    data[1] = value >> 8;
+}
+
+uint16_t readUint16(const uint8_t *data)
+{
+    return data[0] | (uint16_t(data[1]) << 8);
+}
+
+void writeUint64(uint8_t *data, quint64 value)
+{
+    for (int i = 0; i < 8; i++)
+        data[i] = (value >> (8 * i)) & 0xFF;
+}
+
+quint64 readUint64(const uint8_t *data)
+{
+    quint64 value = 0;
+    for (int i = 0; i < 8; i++)
+        value |= quint64(data[i]) << (8 * i);
+    return value;
+}
+
+void writeUint32(uint8_t *data, quint32 value)
+{
+    for (int i = 0; i < 4; i++)
+        data[i] = (value >> (8 * i)) & 0xFF;
+}
+
+quint32 readUint32(const uint8_t *data)
+{
+    quint32 value = 0;
+    for (int i = 0; i < 4; i++)
+        value |= quint32(data[i]) << (8 * i);
+    return value;
+}
+
+void writeFloat(uint8_t *data, float value)
+{
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    writeUint32(data, bits);
+}
+
+float readFloat(const uint8_t *data)
+{
+    const quint32 bits = readUint32(data);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+}
+
+bool decodePacket(const mavlink_message_t &message, Packet &packet)
+{
+    if (message.msgid != MAVLINK_MSG_ID_V2_EXTENSION)
+        return false;
+
+    mavlink_v2_extension_t v2Extension;
+    mavlink_msg_v2_extension_decode(&message, &v2Extension);
+    if (v2Extension.message_type != V2_EXTENSION_MESSAGE_TYPE)
+        return false;
+
+    const uint8_t *payload = v2Extension.payload;
+    packet.type = static_cast<PacketType>(payload[0]);
+    packet.transferId = readUint16(payload + 1);
+
+    switch (packet.type) {
+    case PacketType::UploadChunk:
+    case PacketType::DownloadChunk:
+    case PacketType::GeofenceUploadChunk:
+    case PacketType::BroadcastChunk: {
+        packet.chunkIndex = readUint16(payload + 3);
+        packet.chunkCount = readUint16(payload + 5);
+        const int dataLength = payload[7];
+        if (dataLength > MAX_CHUNK_DATA_SIZE || packet.chunkIndex >= packet.chunkCount)
+            return false;
+        packet.data = QByteArray(reinterpret_cast<const char*>(payload + CHUNK_HEADER_SIZE), dataLength);
+        return true;
+    }
+    case PacketType::DownloadRequest:
+    case PacketType::StoredRouteRequest:
+        packet.routeHash = readUint64(payload + 3);
+        return true;
+    case PacketType::BroadcastRequest:
+        packet.chunkCount = readUint16(payload + 3);
+        packet.routeHash = readUint64(payload + 5);
+        packet.transform.offsetX_m = readFloat(payload + 13);
+        packet.transform.offsetY_m = readFloat(payload + 17);
+        packet.transform.rotation_deg = readFloat(payload + 21);
+        packet.transform.timeOffset_ms = qint32(readUint32(payload + 25));
+        return packet.chunkCount > 0 && std::isfinite(packet.transform.offsetX_m) && std::isfinite(packet.transform.offsetY_m) &&
+                std::isfinite(packet.transform.rotation_deg);
+    case PacketType::Ack:
+    case PacketType::BroadcastAck: {
+        packet.status = static_cast<AckStatus>(payload[3]);
+        const int missingCount = std::min<int>(payload[4], MAX_MISSING_CHUNKS_PER_ACK);
+        packet.missingChunks.resize(missingCount);
+        for (int i = 0; i < missingCount; i++)
+            packet.missingChunks[i] = readUint16(payload + ACK_HEADER_SIZE + 2 * i);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void encodePacket(const Packet &packet, mavlink_v2_extension_t &v2Extension)
+{
+    v2Extension.message_type = V2_EXTENSION_MESSAGE_TYPE;
+    memset(v2Extension.payload, 0, sizeof(v2Extension.payload)); // MAVLink 2 truncates trailing zeros
+
+    uint8_t *payload = v2Extension.payload;
+    payload[0] = static_cast<uint8_t>(packet.type);
+    writeUint16(payload + 1, packet.transferId);
+
+    switch (packet.type) {
+    case PacketType::UploadChunk:
+    case PacketType::DownloadChunk:
+    case PacketType::GeofenceUploadChunk:
+    case PacketType::BroadcastChunk: {
+        const int dataLength = std::min<int>(packet.data.size(), MAX_CHUNK_DATA_SIZE);
+        writeUint16(payload + 3, packet.chunkIndex);
+        writeUint16(payload + 5, packet.chunkCount);
+        payload[7] = dataLength;
+        memcpy(payload + CHUNK_HEADER_SIZE, packet.data.constData(), dataLength);
+        break;
+    }
+    case PacketType::DownloadRequest:
+    case PacketType::StoredRouteRequest:
+        writeUint64(payload + 3, packet.routeHash);
+        break;
+    case PacketType::BroadcastRequest:
+        writeUint16(payload + 3, packet.chunkCount);
+        writeUint64(payload + 5, packet.routeHash);
+        writeFloat(payload + 13, packet.transform.offsetX_m);
+        writeFloat(payload + 17, packet.transform.offsetY_m);
+        writeFloat(payload + 21, packet.transform.rotation_deg);
+        writeUint32(payload + 25, quint32(packet.transform.timeOffset_ms));
+        break;
+    case PacketType::Ack:
+    case PacketType::BroadcastAck: {
+        const int missingCount = std::min<int>(packet.missingChunks.size(), MAX_MISSING_CHUNKS_PER_ACK);
+        payload[3] = static_cast<uint8_t>(packet.status);
+        payload[4] = missingCount;
+        for (int i = 0; i < missingCount; i++)
+            writeUint16(payload + ACK_HEADER_SIZE + 2 * i, packet.missingChunks.at(i));
+        break;
+    }
+    }
+}
+
+void applyRouteTransform(const RouteTransform &transform, QVector<pospoint_t> &route)
+{
+    if (route.isEmpty())
+        return;
+
+    const double pivotX = route.first().x;
+    const double pivotY = route.first().y;
+    const double rotation_rad = double(transform.rotation_deg) * M_PI / 180.0;
+    const double c = cos(rotation_rad);
+    const double s = sin(rotation_rad);
+    for (pospoint_t &point : route) {
+        const double dx = point.x - pivotX;
+        const double dy = point.y - pivotY;
+        point.x = pivotX + c * dx - s * dy + transform.offsetX_m;
+        point.y = pivotY + s * dx + c * dy + transform.offsetY_m;
+        if (point.timestamp_ns != utcTime::INVALID)
+            point.timestamp_ns += qint64(transform.timeOffset_ms) * 1000000;
+    }
+}
+
+QByteArray encodeGeofence(const Geofence &geofence)
+{
+    QList<QVector<pospoint_t>> zones;
+    for (int i = 0; i < geofence.getZoneCount(); i++) {
+        QVector<pospoint_t> zone;
+        for (const QPointF &point : geofence.getZonePolygon(i)) {
+            pospoint_t zonePoint;
+            zonePoint.x = point.x();
+            zonePoint.y = point.y();
+            zonePoint.attributes = static_cast<quint32>(geofence.getZoneType(i));
+            zone.append(zonePoint);
+        }
+        zones.append(zone);
+    }
+    return routeCodec::encodeRouteFile(zones, llh_t());
+}
+
+bool decodeGeofence(const QByteArray &encodedGeofence, Geofence &geofence)
+{
+    geofence.clear();
+    QList<QVector<pospoint_t>> zones;
+    llh_t enuRef;
+    if (!routeCodec::decodeRouteFile(encodedGeofence, zones, enuRef))
+        return false;
+
+    for (const QVector<pospoint_t> &zone : zones) {
+        if (zone.size() < 3 || zone.first().attributes > static_cast<quint32>(Geofence::ZoneType::KeepOut)) {
+            geofence.clear();
+            return false;
+        }
+        QVector<QPointF> polygon;
+        polygon.reserve(zone.size());
+        for (const pospoint_t &point : zone)
+            polygon.append(point.getPoint());
+        geofence.addZone(static_cast<Geofence::ZoneType>(zone.first().attributes), polygon);
+    }
+    return true;
+}
+
+void ChunkAssembler::reset(uint16_t transferId, uint16_t chunkCount)
+{
+    mTransferId = transferId;
+    mChunkCount = chunkCount;
+    mChunksReceived = 0;
+    mChunks.fill(QByteArray(), chunkCount);
+    mChunkReceived.fill(false, chunkCount);
+}
+
+bool ChunkAssembler::addChunk(const Packet &chunk)
+{
+    if (!isActive() || chunk.transferId != mTransferId || chunk.chunkCount != mChunkCount)
+        reset(chunk.transferId, chunk.chunkCount);
+
+    if (!mChunkReceived.at(chunk.chunkIndex)) {
+        mChunks[chunk.chunkIndex] = chunk.data;
+        mChunkReceived[chunk.chunkIndex] = true;
+        mChunksReceived++;
+    }
+    return isComplete();
+}
+
+QVector<uint16_t> ChunkAssembler::getMissingChunks(int maxCount) const
+{
+    QVector<uint16_t> missingChunks;
+    for (int i = 0; i < mChunkCount && missingChunks.size() < maxCount; i++)
+        if (!mChunkReceived.at(i))
+            missingChunks.append(i);
+    return missingChunks;
+}
+
+QByteArray ChunkAssembler::getData() const
+{
+    QByteArray data;
+    for (const QByteArray &chunk : mChunks)
+        data.append(chunk);
+    return data;
+}
+
+ChunkSender::ChunkSender(QObject *parent) : QObject(parent)
+{
+    mChunkTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mChunkTimer, &QTimer::timeout, this, &ChunkSender::sendPendingChunk);
+    mAckTimer.setSingleShot(true);
+    connect(&mAckTimer, &QTimer::timeout, this, &ChunkSender::ackTimeout);
+}
+
+bool ChunkSender::start(uint16_t transferId, PacketType chunkType, const QByteArray &blob, quint64 storedRouteHash)
+{
+    const int chunkCount = std::max((blob.size() + MAX_CHUNK_DATA_SIZE - 1) / MAX_CHUNK_DATA_SIZE, 1);
+    if (chunkCount > MAX_CHUNKS)
+        return false;
+
+    abort();
+    mTransferId = transferId;
+    mChunkType = chunkType;
+    for (int i = 0; i < chunkCount; i++) {
+        mChunks.append(blob.mid(i * MAX_CHUNK_DATA_SIZE, MAX_CHUNK_DATA_SIZE));
+        mPendingChunks.append(i);
+    }
+    mGotAck = false;
+    mRetries = 0;
+
+    if (storedRouteHash != 0) {
+        Packet request;
+        request.type = PacketType::StoredRouteRequest;
+        request.transferId = transferId;
+        request.routeHash = storedRouteHash;
+        if (mSendPacket && mSendPacket(request)) {
+            mRequestingStoredRoute = true;
+            mAckTimer.start(STORED_ROUTE_TIMEOUT_ms);
+            return true;
+        }
+    }
+
+    startChunks();
+    return true;
+}
+
+void ChunkSender::handleAck(const Packet &ack)
+{
+    if (!isActive() || ack.transferId != mTransferId)
+        return;
+
+    mGotAck = true;
+    if (mRequestingStoredRoute) {
+        if (ack.status == AckStatus::Complete)
+            finish(true);
+        else // not stored, i.e., upload
+            startChunks();
+        return;
+    }
+
+    switch (ack.status) {
+    case AckStatus::Complete:
+        finish(true);
+        break;
+    case AckStatus::Missing:
+        mRetries = 0;
+        mAckTimer.stop();
+        for (uint16_t chunkIndex : ack.missingChunks)
+            if (chunkIndex < mChunks.size() && !mPendingChunks.contains(chunkIndex))
+                mPendingChunks.append(chunkIndex);
+        if (!mChunkTimer.isActive())
+            mChunkTimer.start(mChunkInterval_ms);
+        break;
+    case AckStatus::Failed:
+        finish(false);
+        break;
+    }
+}
+
+void ChunkSender::abort()
+{
+    mChunkTimer.stop();
+    mAckTimer.stop();
+    mChunks.clear();
+    mPendingChunks.clear();
+    mRequestingStoredRoute = false;
+}
+
+void ChunkSender::startChunks()
+{
+    mRequestingStoredRoute = false;
+    mAckTimer.stop();
+    mChunkTimer.start(mChunkInterval_ms);
+}
+
+void ChunkSender::sendPendingChunk()
+{
+    if (mPendingChunks.isEmpty()) {
+        mChunkTimer.stop();
+        mAckTimer.start(ACK_TIMEOUT_ms);
+        return;
+    }
+
+    Packet chunk;
+    chunk.type = mChunkType;
+    chunk.transferId = mTransferId;
+    chunk.chunkIndex = mPendingChunks.first();
+    chunk.chunkCount = mChunks.size();
+    chunk.data = mChunks.at(chunk.chunkIndex);
+    if (mSendPacket && mSendPacket(chunk)) // retry on next tick otherwise
+        mPendingChunks.removeFirst();
+}
+
+void ChunkSender::ackTimeout()
+{
+    if (mRequestingStoredRoute) { // e.g., receiver without route store
+        startChunks();
+        return;
+    }
+
+    if (++mRetries > MAX_RETRIES) {
+        qDebug() << "WARNING: route transfer" << mTransferId << "got no acknowledgement.";
+        finish(false);
+        return;
+    }
+
+    // The last chunk makes the receiver answer: complete again (ack lost) or with missing chunks (including all if none arrived)
+    mPendingChunks.append(mChunks.size() - 1);
+    mChunkTimer.start(mChunkInterval_ms);
+}
+
+void ChunkSender::finish(bool success)
+{
+    abort();
+    emit finished(success, mGotAck);
+}
+}
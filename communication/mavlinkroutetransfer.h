@@ -0,0 +1,165 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Bulk route transfer between WayWise control stations and vehicles over MAVLink. The whole route is encoded
+ * into one blob (see routeCodec) that is sent in V2_EXTENSION chunks without per-item round trips.
+ * The receiver acknowledges the complete blob or requests missing chunks once chunks stop arriving.
+ * Vehicles that do not answer (e.g., PX4) are handled through the standard mission protocol instead.
+ * Uploads can first ask for a route the vehicle already stored (see PersistentRouteStore) by its hash: the vehicle acknowledges
+ * the request as complete if it applied the stored route, chunks are sent otherwise (also if it did not answer).
+ * An upload can also carry a route patch (see routeCodec::encodeRoutePatch) with the changed chunks of the vehicle's route,
+ * which the vehicle rejects (Failed) if its route is not the patch's base.
+ * Downloads can carry the hash of the route the station already has (e.g., from a SessionSnapshot): the vehicle acknowledges the
+ * request as complete instead of sending chunks if its current route has that hash.
+ * Geofences (see Geofence) are uploaded the same way in GeofenceUploadChunks, encoded as route file with one route per zone.
+ * Route broadcasts send one route to many vehicles (see RouteBroadcast): each vehicle gets a BroadcastRequest with the transfer's
+ * chunk count, route hash and its own RouteTransform, the BroadcastChunks are sent once to all vehicles (target system 0).
+ * Each vehicle answers with BroadcastAcks, chunks it missed are resent to it only. Vehicles replace their route with the
+ * transformed one.
+ *
+ * Chunk packet:  type (1) | transferId (2) | chunkIndex (2) | chunkCount (2) | dataLength (1) | data
+ * Request:       type (1) | transferId (2) | known route hash (8, optional)
+ * Stored route:  type (1) | transferId (2) | route hash (8)
+ * Ack:           type (1) | transferId (2) | status (1) | missingCount (1) | missing chunk indices (2 each)
+ * Broadcast request: type (1) | transferId (2) | chunkCount (2) | route hash (8) | offset x, y [m], rotation [deg] (float, 4 each) |
+ *                    time offset [ms] (4)
+ * Broadcast chunks and acks are laid out as chunk packets and acks.
+ */
+
+#ifndef MAVLINKROUTETRANSFER_H
+#define MAVLINKROUTETRANSFER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QByteArray>
+#include <QVector>
+#include <functional>
+#include "core/geofence.h"
+#include "core/pospoint.h"
+#include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
+
+namespace mavlinkRouteTransfer {
+constexpr uint16_t V2_EXTENSION_MESSAGE_TYPE = 40000; // >= 32768: not registered, free to use
+constexpr int PAYLOAD_SIZE = sizeof(mavlink_v2_extension_t::payload);
+constexpr int CHUNK_HEADER_SIZE = 8;
+constexpr int MAX_CHUNK_DATA_SIZE = PAYLOAD_SIZE - CHUNK_HEADER_SIZE;
+constexpr int ACK_HEADER_SIZE = 5;
+constexpr int MAX_MISSING_CHUNKS_PER_ACK = (PAYLOAD_SIZE - ACK_HEADER_SIZE) / 2;
+constexpr int MAX_CHUNKS = 0xFFFF;
+// Receiver: chunks missing after a stall are requested, giving up after some requests without progress
+constexpr int REQUEST_TIMEOUT_ms = 1000;
+constexpr int RECEIVE_STALL_TIMEOUT_ms = 300;
+constexpr int MAX_MISSING_REQUESTS = 5;
+constexpr int STORED_ROUTE_TIMEOUT_ms = 300; // sender: upload starts when the vehicle did not answer a stored route request
+// Teach and repeat (see RouteRecorder), param1: 1 start recording, 0 stop and use the recorded route. It is downloaded as the current route.
+constexpr uint16_t RECORD_ROUTE_COMMAND = MAV_CMD_USER_1;
+
+enum class PacketType : uint8_t {UploadChunk = 1, DownloadRequest = 2, DownloadChunk = 3, Ack = 4, StoredRouteRequest = 5, GeofenceUploadChunk = 6,
+                                BroadcastRequest = 7, BroadcastChunk = 8, BroadcastAck = 9};
+enum class AckStatus : uint8_t {Complete = 0, Missing = 1, Failed = 2};
+
+// Applied by each vehicle of a route broadcast: rotation around the route's first point (counterclockwise in ENU), then offset.
+// The time offset shifts valid timestamps, e.g., to start vehicles one after another.
+struct RouteTransform {
+    float offsetX_m = 0.0f;
+    float offsetY_m = 0.0f;
+    float rotation_deg = 0.0f;
+    qint32 timeOffset_ms = 0;
+};
+
+struct Packet {
+    PacketType type = PacketType::Ack;
+    uint16_t transferId = 0;
+    // chunks
+    uint16_t chunkIndex = 0;
+    uint16_t chunkCount = 0;
+    QByteArray data;
+    // acks
+    AckStatus status = AckStatus::Complete;
+    QVector<uint16_t> missingChunks;
+    // stored route requests, download requests (0: no known route), broadcast requests (also chunkCount)
+    quint64 routeHash = 0;
+    RouteTransform transform; // broadcast requests
+};
+
+// Returns false if message is no (valid) route transfer packet
+bool decodePacket(const mavlink_message_t &message, Packet &packet);
+// Fills the V2_EXTENSION payload and length, target_* fields are left to the caller
+void encodePacket(const Packet &packet, mavlink_v2_extension_t &v2Extension);
+
+void applyRouteTransform(const RouteTransform &transform, QVector<pospoint_t> &route);
+
+// Zones as routes of a route file (see routeCodec), the zone type in their points' attributes. ENU coordinates are rounded to mm.
+QByteArray encodeGeofence(const Geofence &geofence);
+// Returns false (and an empty geofence) on malformed input
+bool decodeGeofence(const QByteArray &encodedGeofence, Geofence &geofence);
+
+// Collects the chunks of one transfer (not thread-safe)
+class ChunkAssembler
+{
+public:
+    void reset(uint16_t transferId, uint16_t chunkCount);
+    bool addChunk(const Packet &chunk); // starts a new transfer on unknown transferId, returns true when complete
+    bool isActive() const { return mChunkCount > 0; }
+    bool isComplete() const { return isActive() && mChunksReceived == mChunkCount; }
+    uint16_t getTransferId() const { return mTransferId; }
+    int getChunkCount() const { return mChunkCount; }
+    QVector<uint16_t> getMissingChunks(int maxCount = MAX_MISSING_CHUNKS_PER_ACK) const;
+    QByteArray getData() const;
+
+private:
+    uint16_t mTransferId = 0;
+    int mChunkCount = 0;
+    int mChunksReceived = 0;
+    QVector<QByteArray> mChunks;
+    QVector<bool> mChunkReceived;
+};
+
+// Sends the chunks of one blob paced by a timer and resends chunks requested by the receiver.
+// Lives in (and must be used from) one thread, acks from other threads need to be queued.
+class ChunkSender : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ChunkSender(QObject *parent = nullptr);
+
+    // sendPacket returns false if the packet could not be queued
+    void setSendPacket(std::function<bool(const Packet &)> sendPacket) { mSendPacket = sendPacket; }
+    void setChunkRate(int chunkRate_Hz) { mChunkInterval_ms = std::max(1000 / std::max(chunkRate_Hz, 1), 1); }
+
+    // false if blob is too large. storedRouteHash != 0: asks the receiver for a stored route first, chunks are only sent if it has none.
+    bool start(uint16_t transferId, PacketType chunkType, const QByteArray &blob, quint64 storedRouteHash = 0);
+    void handleAck(const Packet &ack);
+    void abort();
+    bool isActive() const { return !mChunks.isEmpty(); }
+    uint16_t getTransferId() const { return mTransferId; }
+
+signals:
+    // gotAck: false if the receiver never answered, i.e., likely does not support bulk transfers
+    void finished(bool success, bool gotAck);
+
+private:
+    void startChunks();
+    void sendPendingChunk();
+    void ackTimeout();
+    void finish(bool success);
+
+    std::function<bool(const Packet &)> mSendPacket;
+    uint16_t mTransferId = 0;
+    PacketType mChunkType = PacketType::UploadChunk;
+    QVector<QByteArray> mChunks;
+    QVector<uint16_t> mPendingChunks;
+    bool mRequestingStoredRoute = false;
+    bool mGotAck = false;
+    int mRetries = 0;
+    int mChunkInterval_ms = 5;
+    QTimer mChunkTimer;
+    QTimer mAckTimer;
+
+    static constexpr int ACK_TIMEOUT_ms = 1000;
+    static constexpr int MAX_RETRIES = 3;
+};
+}
+
+#endif // MAVLINKROUTETRANSFER_H
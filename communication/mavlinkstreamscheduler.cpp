@@ -0,0 +1,157 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mavlinkstreamscheduler.h"
+#include <QThread>
+#include <algorithm>
+
+MavlinkStreamScheduler::MavlinkStreamScheduler(QObject *parent) : QObject(parent)
+{
+    mPublishTimer.setSingleShot(true);
+    mPublishTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mPublishTimer, &QTimer::timeout, this, &MavlinkStreamScheduler::publishDueStreams);
+}
+
+void MavlinkStreamScheduler::addStream(uint32_t messageId, qint64 defaultInterval_us, std::function<void()> publish, Priority priority)
+{
+    {
+        std::lock_guard<std::mutex> lock(mStreamsMutex);
+        // Same interval as other streams of this message id, if changed already
+        qint64 interval_us = defaultInterval_us;
+        for (const Stream &stream : mStreams)
+            if (stream.messageId == messageId && stream.interval_us != stream.defaultInterval_us)
+                interval_us = stream.interval_us;
+
+        mStreams.append({messageId, defaultInterval_us, interval_us, priority, Clock::now(), publish});
+        spreadPhases();
+    }
+    scheduleNextPublish();
+}
+
+bool MavlinkStreamScheduler::setMessageInterval(uint32_t messageId, qint64 interval_us)
+{
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(mStreamsMutex);
+        for (Stream &stream : mStreams)
+            if (stream.messageId == messageId) {
+                stream.interval_us = (interval_us == 0) ? stream.defaultInterval_us : ((interval_us < 0) ? INTERVAL_DISABLED : interval_us);
+                found = true;
+            }
+        if (found)
+            spreadPhases();
+    }
+
+    if (found)
+        rescheduleFromAnyThread();
+    return found;
+}
+
+qint64 MavlinkStreamScheduler::getMessageInterval(uint32_t messageId) const
+{
+    std::lock_guard<std::mutex> lock(mStreamsMutex);
+    for (const Stream &stream : mStreams)
+        if (stream.messageId == messageId)
+            return effectiveInterval_us(stream);
+
+    return 0;
+}
+
+bool MavlinkStreamScheduler::hasStream(uint32_t messageId) const
+{
+    std::lock_guard<std::mutex> lock(mStreamsMutex);
+    return std::any_of(mStreams.begin(), mStreams.end(), [messageId](const Stream &stream) { return stream.messageId == messageId; });
+}
+
+void MavlinkStreamScheduler::setThrottleFactor(double throttleFactor)
+{
+    {
+        std::lock_guard<std::mutex> lock(mStreamsMutex);
+        if (mThrottleFactor == std::max(throttleFactor, 1.0))
+            return;
+
+        mThrottleFactor = std::max(throttleFactor, 1.0);
+        spreadPhases();
+    }
+    rescheduleFromAnyThread();
+}
+
+double MavlinkStreamScheduler::getThrottleFactor() const
+{
+    std::lock_guard<std::mutex> lock(mStreamsMutex);
+    return mThrottleFactor;
+}
+
+qint64 MavlinkStreamScheduler::effectiveInterval_us(const Stream &stream) const
+{
+    if (stream.interval_us <= 0 || stream.priority == Priority::Critical)
+        return stream.interval_us;
+
+    return static_cast<qint64>(stream.interval_us * mThrottleFactor);
+}
+
+void MavlinkStreamScheduler::rescheduleFromAnyThread()
+{
+    // QTimer can only be started from the thread it lives in, e.g., not from a MAVSDK callback thread
+    if (thread() == QThread::currentThread())
+        scheduleNextPublish();
+    else
+        QMetaObject::invokeMethod(this, [this]() { scheduleNextPublish(); }, Qt::QueuedConnection);
+}
+
+void MavlinkStreamScheduler::spreadPhases()
+{
+    // The k-th of n enabled streams starts at k/n of its interval
+    const Clock::time_point now = Clock::now();
+    const int enabledStreams = std::count_if(mStreams.begin(), mStreams.end(), [](const Stream &stream) { return stream.interval_us > 0; });
+    int k = 0;
+    for (Stream &stream : mStreams)
+        if (stream.interval_us > 0)
+            stream.nextPublish = now + std::chrono::microseconds(effectiveInterval_us(stream) * k++ / enabledStreams);
+}
+
+void MavlinkStreamScheduler::publishDueStreams()
+{
+    QVector<int> dueStreams;
+    {
+        std::lock_guard<std::mutex> lock(mStreamsMutex);
+        const Clock::time_point now = Clock::now();
+        for (int i = 0; i < mStreams.size(); i++) {
+            Stream &stream = mStreams[i];
+            if (stream.interval_us <= 0 || stream.nextPublish > now)
+                continue;
+
+            dueStreams.append(i);
+            const std::chrono::microseconds interval(effectiveInterval_us(stream));
+            stream.nextPublish += interval;
+            if (stream.nextPublish <= now) // fell behind, do not catch up in bursts
+                stream.nextPublish = now + interval;
+        }
+    }
+
+    // Streams are only added on this thread, i.e., indices stay valid
+    for (int i : dueStreams)
+        mStreams[i].publish();
+
+    scheduleNextPublish();
+}
+
+void MavlinkStreamScheduler::scheduleNextPublish()
+{
+    Clock::time_point nextPublish = Clock::time_point::max();
+    {
+        std::lock_guard<std::mutex> lock(mStreamsMutex);
+        for (const Stream &stream : mStreams)
+            if (stream.interval_us > 0)
+                nextPublish = std::min(nextPublish, stream.nextPublish);
+    }
+
+    if (nextPublish == Clock::time_point::max()) {
+        mPublishTimer.stop();
+        return;
+    }
+
+    const qint64 delay_ms = std::chrono::duration_cast<std::chrono::milliseconds>(nextPublish - Clock::now()).count();
+    mPublishTimer.start(std::max(delay_ms, qint64(0)));
+}
@@ -0,0 +1,66 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Schedules periodic MAVLink streams with individual intervals, settable at runtime per MAVLink message id
+ * (as with MAV_CMD_SET_MESSAGE_INTERVAL). Streams are phase-spread over their interval, so that streams
+ * of the same rate do not burst out at once. Publish functions run on the scheduler's thread.
+ * To save bandwidth, intervals of non-critical streams can be stretched by a common throttle factor.
+ */
+
+#ifndef MAVLINKSTREAMSCHEDULER_H
+#define MAVLINKSTREAMSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+class MavlinkStreamScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr qint64 INTERVAL_DISABLED = -1; // as in MESSAGE_INTERVAL
+    enum class Priority {Critical, Normal}; // only Normal streams are throttled
+
+    explicit MavlinkStreamScheduler(QObject *parent = nullptr);
+
+    // Several streams may share a message id (e.g., NAMED_VALUE_FLOAT), they share its interval then. Call from the scheduler's thread.
+    void addStream(uint32_t messageId, qint64 defaultInterval_us, std::function<void()> publish, Priority priority = Priority::Normal);
+
+    // Thread-safe. interval_us: > 0 interval, 0 default, -1 disabled. Returns false if there is no stream for messageId.
+    bool setMessageInterval(uint32_t messageId, qint64 interval_us);
+    qint64 getMessageInterval(uint32_t messageId) const; // effective (i.e., throttled) interval, 0 if there is no stream for messageId
+    bool hasStream(uint32_t messageId) const;
+
+    // Thread-safe. Intervals of Normal priority streams are multiplied by throttleFactor (>= 1.0)
+    void setThrottleFactor(double throttleFactor);
+    double getThrottleFactor() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Stream {
+        uint32_t messageId;
+        qint64 defaultInterval_us;
+        qint64 interval_us;
+        Priority priority;
+        Clock::time_point nextPublish;
+        std::function<void()> publish;
+    };
+
+    qint64 effectiveInterval_us(const Stream &stream) const; // expects mStreamsMutex
+
+    void spreadPhases(); // expects mStreamsMutex
+    void publishDueStreams();
+    void scheduleNextPublish();
+    void rescheduleFromAnyThread();
+
+    QVector<Stream> mStreams;
+    double mThrottleFactor = 1.0;
+    mutable std::mutex mStreamsMutex;
+    QTimer mPublishTimer;
+};
+
+#endif // MAVLINKSTREAMSCHEDULER_H
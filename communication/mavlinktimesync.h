@@ -0,0 +1,33 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * TIMESYNC round trips between WayWise control stations and vehicles. MAVSDK answers every TIMESYNC request itself, in a time base
+ * that is not the one of the vehicle's time_boot_ms. WayWise requests are therefore tagged in the low bits of ts1 (ns, the lost
+ * resolution does not matter), MavsdkVehicleServer answers tagged requests with its time since boot (the base of all time_boot_ms
+ * it sends) tagged in tc1. Untagged answers are from others, e.g., MAVSDK or PX4 (whose answers are in its time_boot_ms base).
+ */
+
+#ifndef MAVLINKTIMESYNC_H
+#define MAVLINKTIMESYNC_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace mavlinkTimesync {
+constexpr int64_t TAG_MASK = 0x3FF;
+constexpr int64_t REQUEST_TAG = 0x2A5;
+constexpr int64_t RESPONSE_TAG = 0x15A;
+
+inline int64_t tag(int64_t time_ns, int64_t tagValue) { return (time_ns & ~TAG_MASK) | tagValue; }
+inline bool isTagged(int64_t time_ns, int64_t tagValue) { return (time_ns & TAG_MASK) == tagValue; }
+
+// Vehicle time base: steady clock (since boot on Linux), as MAVSDK's own time_boot_ms
+inline int64_t getTimeSinceBoot_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline uint32_t getTimeBoot_ms() { return uint32_t(getTimeSinceBoot_ns() / 1000000); }
+}
+
+#endif // MAVLINKTIMESYNC_H
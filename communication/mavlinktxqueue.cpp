@@ -0,0 +1,145 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mavlinktxqueue.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+MavlinkTxQueue::MavlinkTxQueue(QObject *parent) : QObject(parent)
+{
+    const Clock::time_point now = Clock::now();
+    for (TxClass &txClass : mClasses)
+        txClass.lastRefill = now;
+
+    // Logs come in bursts (a log line can take several STATUSTEXT chunks), everything else is paced by its sender
+    setRate(Class::Log, 20.0, 20);
+
+    mSendTimer.setSingleShot(true);
+    mSendTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mSendTimer, &QTimer::timeout, this, &MavlinkTxQueue::sendQueued);
+}
+
+void MavlinkTxQueue::setRate(Class txClass, double rate_Hz, int burst)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    TxClass &tx = mClasses[static_cast<int>(txClass)];
+    tx.rate_Hz = rate_Hz;
+    tx.burst = std::max(burst, 1);
+    tx.tokens = tx.burst;
+    tx.lastRefill = Clock::now();
+}
+
+double MavlinkTxQueue::getRate(Class txClass) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mClasses[static_cast<int>(txClass)].rate_Hz;
+}
+
+void MavlinkTxQueue::send(Class txClass, std::function<void()> send)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        TxClass &tx = mClasses[static_cast<int>(txClass)];
+        if (!tx.messages.empty() || !takeToken(tx, Clock::now())) {
+            if (tx.messages.size() >= MAX_QUEUED_PER_CLASS) {
+                tx.messages.pop_front();
+                tx.statistics.dropped++;
+            }
+            tx.messages.push_back({std::move(send), Clock::now()});
+            tx.statistics.queued++;
+            scheduleSendQueued();
+            return;
+        }
+        tx.statistics.sent++;
+    }
+    send();
+}
+
+MavlinkTxQueue::ClassStatistics MavlinkTxQueue::getStatistics(Class txClass) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mClasses[static_cast<int>(txClass)].statistics;
+}
+
+int MavlinkTxQueue::getQueuedMessages() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    int queuedMessages = 0;
+    for (const TxClass &txClass : mClasses)
+        queuedMessages += txClass.messages.size();
+    return queuedMessages;
+}
+
+void MavlinkTxQueue::refill(TxClass &txClass, Clock::time_point now)
+{
+    const double dt_s = std::chrono::duration<double>(now - txClass.lastRefill).count();
+    txClass.tokens = std::min(txClass.burst, txClass.tokens + dt_s * txClass.rate_Hz);
+    txClass.lastRefill = now;
+}
+
+bool MavlinkTxQueue::takeToken(TxClass &txClass, Clock::time_point now)
+{
+    if (txClass.rate_Hz <= 0.0)
+        return true;
+
+    refill(txClass, now);
+    if (txClass.tokens < 1.0)
+        return false;
+
+    txClass.tokens -= 1.0;
+    return true;
+}
+
+void MavlinkTxQueue::scheduleSendQueued()
+{
+    // Pending until the queue is empty again, i.e., messages queued meanwhile are picked up by the running sendQueued()
+    if (mSendQueuedScheduled)
+        return;
+
+    mSendQueuedScheduled = true;
+    QMetaObject::invokeMethod(this, [this]() { sendQueued(); }, Qt::QueuedConnection);
+}
+
+void MavlinkTxQueue::sendQueued()
+{
+    while (true) {
+        std::function<void()> send;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            const Clock::time_point now = Clock::now();
+            for (TxClass &tx : mClasses) {
+                if (tx.messages.empty() || !takeToken(tx, now))
+                    continue;
+
+                const double queueDelay_ms = std::chrono::duration<double, std::milli>(now - tx.messages.front().queued).count();
+                tx.queuedSent++;
+                tx.statistics.sent++;
+                tx.statistics.maxQueueDelay_ms = std::max(tx.statistics.maxQueueDelay_ms, queueDelay_ms);
+                tx.statistics.meanQueueDelay_ms += (queueDelay_ms - tx.statistics.meanQueueDelay_ms) / tx.queuedSent;
+                send = std::move(tx.messages.front().send);
+                tx.messages.pop_front();
+                break;
+            }
+
+            if (!send) {
+                // Wait for the next token of a class with queued messages
+                double wait_s = std::numeric_limits<double>::max();
+                for (TxClass &tx : mClasses)
+                    if (!tx.messages.empty()) {
+                        refill(tx, now);
+                        wait_s = std::min(wait_s, (1.0 - tx.tokens) / tx.rate_Hz);
+                    }
+
+                if (wait_s == std::numeric_limits<double>::max()) {
+                    mSendQueuedScheduled = false;
+                    return;
+                }
+                mSendTimer.start(std::max((int)std::ceil(wait_s * 1000.0), 1));
+                return;
+            }
+        }
+        send();
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Prioritized transmit queue for outgoing MAVLink messages. Each traffic class has a token bucket (rate and burst),
+ * a message is sent right away from the calling thread if its class has a token and nothing of it is queued.
+ * Otherwise it waits and queued messages are sent on the queue's thread in class priority order as tokens become available,
+ * i.e., a burst of log messages cannot delay acknowledgements behind it.
+ * Messages are queued as send functions that encode (and send) the message when it is its turn.
+ */
+
+#ifndef MAVLINKTXQUEUE_H
+#define MAVLINKTXQUEUE_H
+
+#include <QObject>
+#include <QTimer>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+class MavlinkTxQueue : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Class {Safety, Telemetry, Log}; // in priority order, Safety: acknowledgements and mission protocol
+    static constexpr int NUM_CLASSES = 3;
+    static constexpr int MAX_QUEUED_PER_CLASS = 64; // the oldest message is dropped when full
+
+    struct ClassStatistics {
+        quint64 sent = 0;
+        quint64 queued = 0; // not sent right away
+        quint64 dropped = 0;
+        double meanQueueDelay_ms = 0.0; // of queued messages
+        double maxQueueDelay_ms = 0.0;
+    };
+
+    explicit MavlinkTxQueue(QObject *parent = nullptr);
+
+    // Thread-safe. rate_Hz <= 0: unlimited (default for all but Log)
+    void setRate(Class txClass, double rate_Hz, int burst);
+    double getRate(Class txClass) const;
+
+    // Thread-safe
+    void send(Class txClass, std::function<void()> send);
+    ClassStatistics getStatistics(Class txClass) const;
+    int getQueuedMessages() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct QueuedMessage {
+        std::function<void()> send;
+        Clock::time_point queued;
+    };
+    struct TxClass {
+        double rate_Hz = 0.0;
+        double burst = 1.0;
+        double tokens = 1.0;
+        Clock::time_point lastRefill;
+        std::deque<QueuedMessage> messages;
+        ClassStatistics statistics;
+        quint64 queuedSent = 0;
+    };
+
+    void refill(TxClass &txClass, Clock::time_point now); // expects mMutex
+    bool takeToken(TxClass &txClass, Clock::time_point now); // expects mMutex
+    void sendQueued();
+    void scheduleSendQueued(); // expects mMutex
+
+    std::array<TxClass, NUM_CLASSES> mClasses;
+    mutable std::mutex mMutex;
+    bool mSendQueuedScheduled = false;
+    QTimer mSendTimer;
+};
+
+#endif // MAVLINKTXQUEUE_H
@@ -11,6 +11,10 @@
 #include <chrono>
 #include "logger/logger.h"
 #include "communication/parameterserver.h"
+#include "communication/mavlinktimesync.h"
+#include "core/commandlatencytrace.h"
+#include "core/allocationtracker.h"
+#include "vehicles/carstate.h"
 
 MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleState, const QHostAddress controlTowerAddress, const unsigned controlTowerPort, const QAbstractSocket::SocketType controlTowerSocketType) :
     VehicleServer(vehicleState)
@@ -24,6 +28,7 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
     config.set_always_send_heartbeats(true);
     config.set_system_id(mSystemId);
     mMavsdk.reset(new mavsdk::Mavsdk{config});
+    StartupProfile::getInstance().markPhase("ST_MAVSDK");
 
 //    mavsdk::Mavsdk::Configuration customConfig = mavsdk::Mavsdk::Configuration{mavsdk::Mavsdk::ComponentType::Custom};
 //    customConfig.set_system_id(mVehicleState->getId());
@@ -39,47 +44,192 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
     mTelemetryServer.reset(new mavsdk::TelemetryServer(serverComponent));
     mActionServer.reset(new mavsdk::ActionServer(serverComponent));
     mMissionRawServer.reset(new mavsdk::MissionRawServer(serverComponent));
+    StartupProfile::getInstance().markPhase("ST_PLUGINS");
 
     // Allow the vehicle to change to auto mode (manual is always allowed) and arm, disable takeoff (only rover support for now)
     mActionServer->set_allowable_flight_modes({true, true, false});
     mActionServer->set_armable(true, true);
     mActionServer->set_allow_takeoff(false);
 
-    // Publish vehicleState's telemetry info
-    connect(&mPublishMavlinkTimer, &QTimer::timeout, [this](){
-        mavsdk::TelemetryServer::PositionVelocityNed positionVelocityNed{{static_cast<float>(mVehicleState->getPosition(PosType::fused).getY()),
-                                                                          static_cast<float>(mVehicleState->getPosition(PosType::fused).getX()),
-                                                                          static_cast<float>(-mVehicleState->getPosition(PosType::fused).getHeight())},
-                                                                         {static_cast<float>(mVehicleState->getVelocity().y),
-                                                                          static_cast<float>(mVehicleState->getVelocity().x),
-                                                                          static_cast<float>(-mVehicleState->getVelocity().z)}};
-
+    // Publish vehicleState's telemetry info, one stream per MAVLink message (rates can be changed via MAV_CMD_SET_MESSAGE_INTERVAL).
+    // Position and heading are critical (closed-loop remote control), the others can be throttled on congested links.
+    addTelemetryStream(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, [this](){
         mavsdk::TelemetryServer::VelocityNed velocity{static_cast<float>(mVehicleState->getVelocity().y),
                                                       static_cast<float>(mVehicleState->getVelocity().x),
                                                       static_cast<float>(-mVehicleState->getVelocity().z)};
 
         mavsdk::TelemetryServer::Heading heading{coordinateTransforms::yawENUtoNED(mVehicleState->getPosition(PosType::fused).getYaw())};
 
-        mavsdk::TelemetryServer::Position homePositionLlh{};
         mavsdk::TelemetryServer::Position positionLlh{};
-
         if (!mGNSSReceiver.isNull()) {
-            // publish gpsOrigin
-            sendGpsOriginLlh(mGNSSReceiver->getEnuRef());
-
-            //TODO: homePositionLlh should not be EnuRef
-            homePositionLlh = {mGNSSReceiver->getEnuRef().latitude, mGNSSReceiver->getEnuRef().longitude, static_cast<float>(mGNSSReceiver->getEnuRef().height), 0};
-
             llh_t fusedPosGlobal = coordinateTransforms::enuToLlh(mGNSSReceiver->getEnuRef(), {mVehicleState->getPosition(PosType::fused).getXYZ()});
             positionLlh = {fusedPosGlobal.latitude, fusedPosGlobal.longitude, static_cast<float>(fusedPosGlobal.height), 0};
         }
 
         mTelemetryServer->publish_position(positionLlh, velocity, heading);
-        mTelemetryServer->publish_home(homePositionLlh);
+    }, MavlinkStreamScheduler::Priority::Critical);
+
+    addTelemetryStream(MAVLINK_MSG_ID_LOCAL_POSITION_NED, [this](){
+        mavsdk::TelemetryServer::PositionVelocityNed positionVelocityNed{{static_cast<float>(mVehicleState->getPosition(PosType::fused).getY()),
+                                                                          static_cast<float>(mVehicleState->getPosition(PosType::fused).getX()),
+                                                                          static_cast<float>(-mVehicleState->getPosition(PosType::fused).getHeight())},
+                                                                         {static_cast<float>(mVehicleState->getVelocity().y),
+                                                                          static_cast<float>(mVehicleState->getVelocity().x),
+                                                                          static_cast<float>(-mVehicleState->getVelocity().z)}};
+
         mTelemetryServer->publish_position_velocity_ned(positionVelocityNed);
+    }, MavlinkStreamScheduler::Priority::Critical);
+
+    addTelemetryStream(MAVLINK_MSG_ID_HOME_POSITION, [this](){
+        //TODO: homePositionLlh should not be EnuRef
+        mavsdk::TelemetryServer::Position homePositionLlh{};
+        if (!mGNSSReceiver.isNull())
+            homePositionLlh = {mGNSSReceiver->getEnuRef().latitude, mGNSSReceiver->getEnuRef().longitude, static_cast<float>(mGNSSReceiver->getEnuRef().height), 0};
+
+        mTelemetryServer->publish_home(homePositionLlh);
+    });
+
+    addTelemetryStream(MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN, [this](){
+        if (!mGNSSReceiver.isNull())
+            sendGpsOriginLlh(mGNSSReceiver->getEnuRef());
+    });
+
+    addTelemetryStream(MAVLINK_MSG_ID_GPS_RAW_INT, [this](){
         mTelemetryServer->publish_raw_gps(mRawGps, mGpsInfo);
     });
 
+    // Publish autopilot radius
+    addTelemetryStream(MAVLINK_MSG_ID_NAMED_VALUE_FLOAT, [this](){
+        if (!mMavlinkPassthrough)
+            return;
+
+        if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+            mavlink_message_t mavAutopilotRadiusmMsg;
+            mavlink_named_value_float_t autopilotRadius;
+
+            memset(&autopilotRadius, 0, sizeof(mavlink_named_value_float_t));
+
+            autopilotRadius.time_boot_ms = mavlinkTimesync::getTimeBoot_ms();
+            autopilotRadius.value = mVehicleState->getAutopilotRadius();
+            mavlink_address.system_id = mSystemId;
+            mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+            strcpy(autopilotRadius.name, "AR");
+            mavlink_msg_named_value_float_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavAutopilotRadiusmMsg, &autopilotRadius);
+
+            return mavAutopilotRadiusmMsg;
+        }) != mavsdk::MavlinkPassthrough::Result::Success)
+                qWarning() << "Could not send Autopilot Radius via MAVLINK.";
+
+        // Convoy monitoring: gap to predecessor
+        if (mConvoyLink.getPredecessor() != 0)
+            mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+                mavlink_message_t mavConvoyGapMsg;
+                mavlink_named_value_float_t convoyGap;
+                memset(&convoyGap, 0, sizeof(mavlink_named_value_float_t));
+
+                convoyGap.time_boot_ms = mavlinkTimesync::getTimeBoot_ms();
+                convoyGap.value = mConvoyLink.isPredecessorAlive() ? mConvoyGap_m : -1.0;
+                mavlink_address.system_id = mSystemId;
+                mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+                strcpy(convoyGap.name, "CVY_GAP");
+                mavlink_msg_named_value_float_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavConvoyGapMsg, &convoyGap);
+
+                return mavConvoyGapMsg;
+            });
+
+        // Sensor health: worst rate ratio first, the bitmask completes an update on the station
+        if (mSensorHealthMonitor)
+            for (const auto &sensorHealthValue : {qMakePair("SNS_MIN", float(mSensorHealthMonitor->getMinRateRatio())),
+                                                  qMakePair("SNS_DEG", float(mSensorHealthMonitor->getDegradedSources()))})
+                mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+                    mavlink_message_t mavSensorHealthMsg;
+                    mavlink_named_value_float_t sensorHealth;
+                    memset(&sensorHealth, 0, sizeof(mavlink_named_value_float_t));
+
+                    sensorHealth.time_boot_ms = mavlinkTimesync::getTimeBoot_ms();
+                    sensorHealth.value = sensorHealthValue.second;
+                    mavlink_address.system_id = mSystemId;
+                    mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+                    strcpy(sensorHealth.name, sensorHealthValue.first);
+                    mavlink_msg_named_value_float_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavSensorHealthMsg, &sensorHealth);
+
+                    return mavSensorHealthMsg;
+                });
+
+        // Route tracking: the cross-track error completes an update on the station
+        const RouteProjection routeProjection = mWaypointFollower ? mWaypointFollower->getRouteProjection() : RouteProjection();
+        if (routeProjection.valid)
+            for (const auto &routeProjectionValue : {qMakePair("RT_HDG", float(routeProjection.headingError_rad)),
+                                                     qMakePair("RT_ATP", float(routeProjection.alongTrack_m)),
+                                                     qMakePair("RT_XTE", float(routeProjection.crossTrackError_m))})
+                mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+                    mavlink_message_t mavRouteProjectionMsg;
+                    mavlink_named_value_float_t routeProjectionValueMsg;
+                    memset(&routeProjectionValueMsg, 0, sizeof(mavlink_named_value_float_t));
+
+                    routeProjectionValueMsg.time_boot_ms = mavlinkTimesync::getTimeBoot_ms();
+                    routeProjectionValueMsg.value = routeProjectionValue.second;
+                    mavlink_address.system_id = mSystemId;
+                    mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+                    strcpy(routeProjectionValueMsg.name, routeProjectionValue.first);
+                    mavlink_msg_named_value_float_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavRouteProjectionMsg, &routeProjectionValueMsg);
+
+                    return mavRouteProjectionMsg;
+                });
+    });
+
+    // On-vehicle performance counters (see PerfCounters)
+    addTelemetryStream(MAVLINK_MSG_ID_DEBUG_FLOAT_ARRAY, [this](){
+        publishPerfCounters();
+    });
+
+    // Publish Autopilot lookahead and reference points
+    addTelemetryStream(MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED, [this]() {
+        if (!mMavlinkPassthrough)
+            return;
+
+        if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+            mavlink_message_t mavMsg;
+            mavlink_position_target_local_ned_t autopilotPoints;
+
+            memset(&autopilotPoints, 0, sizeof(mavlink_position_target_local_ned_t));
+
+            autopilotPoints.time_boot_ms = mavlinkTimesync::getTimeBoot_ms();
+
+            QPointF autopilotTargetPointENU_XY = mVehicleState->getAutopilotTargetPoint();
+            xyz_t autopilotTargetPointNED = coordinateTransforms::enuToNED({autopilotTargetPointENU_XY.x(), autopilotTargetPointENU_XY.y(), 0});
+            autopilotPoints.x = autopilotTargetPointNED.x;
+            autopilotPoints.y = autopilotTargetPointNED.y;
+
+            autopilotPoints.type_mask = POSITION_TARGET_TYPEMASK_Z_IGNORE|
+                                    POSITION_TARGET_TYPEMASK_VX_IGNORE |
+                                    POSITION_TARGET_TYPEMASK_VY_IGNORE |
+                                    POSITION_TARGET_TYPEMASK_VZ_IGNORE |
+                                    POSITION_TARGET_TYPEMASK_AX_IGNORE |
+                                    POSITION_TARGET_TYPEMASK_AY_IGNORE |
+                                    POSITION_TARGET_TYPEMASK_AZ_IGNORE |
+                                    POSITION_TARGET_TYPEMASK_YAW_IGNORE |
+                                    POSITION_TARGET_TYPEMASK_YAW_RATE_IGNORE;
+
+            mavlink_address.system_id = mSystemId;
+            mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+            // Encode and send the POSITION_TARGET_LOCAL_NED message
+            mavlink_msg_position_target_local_ned_encode_chan(mavlink_address.system_id,
+                                                            mavlink_address.component_id,
+                                                            channel,
+                                                            &mavMsg,
+                                                            &autopilotPoints);
+
+            return mavMsg;
+        }) != mavsdk::MavlinkPassthrough::Result::Success)
+            qWarning() << "Could not send Autopilot Reference Point via MAVLINK.";
+    });
+
     mActionServer->subscribe_flight_mode_change([this](mavsdk::ActionServer::Result res, mavsdk::ActionServer::FlightMode mode) {
         if  (res == mavsdk::ActionServer::Result::Success) {
             mVehicleState->setFlightMode((VehicleState::FlightMode) mode);
@@ -112,11 +262,11 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
             qDebug() << "MavsdkVehicleServer: got new mission with" << plan.mission_items.size() << "items.";
 
             if (!mWaypointFollower.isNull()) {
-                QList<PosPoint> route;
-                for (const auto &item : plan.mission_items)
-                    route.append(convertMissionItemToPosPoint(item));
+                mMissionUploadRoute.resize(plan.mission_items.size()); // keeps its capacity
+                for (size_t i = 0; i < plan.mission_items.size(); i++)
+                    convertMissionItemToPOD(plan.mission_items[i], mMissionUploadRoute[i]);
 
-                mWaypointFollower->addRoute(route);
+                mWaypointFollower->addRoutePOD(mMissionUploadRoute);
             } else
                 qDebug() << "MavsdkVehicleServer: got new mission but no WaypointFollower is set to receive it.";
 
@@ -138,22 +288,43 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
             qDebug() << "Warning: jumping to seq ID in mission not implemented in MavsdkVehicleServer / WaypointFollower.";
     });
 
+    // Bulk route transfer, handled on this thread
+    mRouteUploadStallTimer.setSingleShot(true);
+    connect(&mRouteUploadStallTimer, &ClockTimer::timeout, this, &MavsdkVehicleServer::routeUploadStalled);
+    mGeofenceUploadStallTimer.setSingleShot(true);
+    connect(&mGeofenceUploadStallTimer, &ClockTimer::timeout, this, &MavsdkVehicleServer::geofenceUploadStalled);
+    mRouteBroadcastStallTimer.setSingleShot(true);
+    connect(&mRouteBroadcastStallTimer, &ClockTimer::timeout, this, &MavsdkVehicleServer::routeBroadcastStalled);
+    mRouteDownloadSender.setSendPacket([this](const mavlinkRouteTransfer::Packet &packet) { return sendRouteTransferPacket(packet); });
+    connect(&mRouteDownloadSender, &mavlinkRouteTransfer::ChunkSender::finished, [](bool success, bool gotAck) {
+        if (!success)
+            qDebug() << "WARNING: MavsdkVehicleServer route download failed" << (gotAck ? "." : "(no acknowledgement).");
+    });
+
+    // Manual control, applied on this thread
+    connect(&mManualControlTimer, &ClockTimer::timeout, this, &MavsdkVehicleServer::applyManualControl);
+
     // Safety heartbeat
     mHeartbeat = false;
     mHeartbeatTimer.setSingleShot(true);
-    connect(&mHeartbeatTimer, &QTimer::timeout, this, &MavsdkVehicleServer::heartbeatTimeout);
+    connect(&mHeartbeatTimer, &ClockTimer::timeout, this, &MavsdkVehicleServer::heartbeatTimeout);
     connect(this, &MavsdkVehicleServer::resetHeartbeat, this, &MavsdkVehicleServer::heartbeatReset);
 
     mMavsdk->intercept_incoming_messages_async([this](mavlink_message_t &message){
+        mLinkMonitor.countIncoming(message);
+
         if (message.msgid == MAVLINK_MSG_ID_HEARTBEAT) { // TODO: make sure this is actually for us
-            if (!mHeartbeat) {
+            // Accept what follows at once, not only after the (queued) reset of the timeout
+            if (!mHeartbeat.exchange(true)) {
                 qDebug() << "MavsdkVehicleServer: got heartbeat, timeout was reset.";
             }
+            if (mStationHeartbeatCallback)
+                mStationHeartbeatCallback();
             emit resetHeartbeat();
         } else if (!mHeartbeat)
             return false; // Drop incoming messages until heartbeat restored
 
-        static QList<PosPoint> currentRoute;
+        traceCommandLatency(message);
 
         switch (message.msgid) {
         case MAVLINK_MSG_ID_MANUAL_CONTROL:
@@ -161,8 +332,20 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
             mavlink_manual_control_t manual_control;
             mavlink_msg_manual_control_decode(&message, &manual_control);
 
-            if (mVehicleState->getFlightMode() == VehicleState::FlightMode::Manual)
-                handleManualControlMessage(manual_control);
+            if (mVehicleState->getFlightMode() == VehicleState::FlightMode::Manual) {
+                mManualControlMailbox.publish({manual_control.x / 1000.0, manual_control.r / 1000.0, mManualControlTimer.getClock()->now_us()});
+                if (!mManualControlActive.exchange(true))
+                    QMetaObject::invokeMethod(this, [this]() { startManualControl(); }, Qt::QueuedConnection);
+            }
+            break;
+        }
+        case MAVLINK_MSG_ID_V2_EXTENSION:
+        {
+            mavlinkRouteTransfer::Packet packet;
+            const uint8_t targetSystem = mavlink_msg_v2_extension_get_target_system(&message);
+            if ((targetSystem == mSystemId || targetSystem == 0) && mavlinkRouteTransfer::decodePacket(message, packet) &&
+                    (targetSystem == mSystemId || packet.type == mavlinkRouteTransfer::PacketType::BroadcastChunk))
+                QMetaObject::invokeMethod(this, [this, packet]() { handleRouteTransferPacket(packet); }, Qt::QueuedConnection);
             break;
         }
         case MAVLINK_MSG_ID_MISSION_REQUEST_LIST:
@@ -175,25 +358,28 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
                 break;
             }
 
-            currentRoute = mWaypointFollower->getCurrentRoute();
-            if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-                mavlink_mission_count_t missionCount;
-                memset(&missionCount, 0, sizeof(missionCount));
+            // Items are requested from this snapshot of the route
+            updateMissionDownloadItems();
+            mTxQueue.send(MavlinkTxQueue::Class::Safety, [this, routeSize = mMissionDownloadItems.size()]() {
+                if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+                    mavlink_mission_count_t missionCount;
+                    memset(&missionCount, 0, sizeof(missionCount));
 
-                missionCount.target_system = mMavlinkPassthrough->get_target_sysid();
-                missionCount.target_component = mMavlinkPassthrough->get_target_compid();
-                missionCount.count = currentRoute.size();
-                missionCount.mission_type = MAV_MISSION_TYPE_MISSION;
+                    missionCount.target_system = mMavlinkPassthrough->get_target_sysid();
+                    missionCount.target_component = mMavlinkPassthrough->get_target_compid();
+                    missionCount.count = routeSize;
+                    missionCount.mission_type = MAV_MISSION_TYPE_MISSION;
 
-                mavlink_address.system_id = mSystemId;
-                mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+                    mavlink_address.system_id = mSystemId;
+                    mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
 
-                mavlink_message_t mavMissionCountMsg;
-                mavlink_msg_mission_count_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavMissionCountMsg, &missionCount);
+                    mavlink_message_t mavMissionCountMsg;
+                    mavlink_msg_mission_count_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavMissionCountMsg, &missionCount);
 
-                return mavMissionCountMsg;
-            }) != mavsdk::MavlinkPassthrough::Result::Success)
-                qWarning() << "Could not send MISSION_COUNT via MAVLINK.";
+                    return mavMissionCountMsg;
+                }) != mavsdk::MavlinkPassthrough::Result::Success)
+                    qWarning() << "Could not send MISSION_COUNT via MAVLINK.";
+            });
 
             break;
         }
@@ -207,33 +393,23 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
                 break;
             }
 
-            PosPoint posPoint = currentRoute.at(missionRequestInt.seq);
-            if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-                mavlink_mission_item_int_t missionItemInt;
-                memset(&missionItemInt, 0, sizeof(missionItemInt));
-
-                missionItemInt.seq = missionRequestInt.seq;
-                missionItemInt.frame = MAV_FRAME_LOCAL_ENU;
-                missionItemInt.command = MAV_CMD_NAV_WAYPOINT;
-                missionItemInt.current = false;
-                missionItemInt.autocontinue = true;
-                missionItemInt.param1 = posPoint.getSpeed();
-                missionItemInt.param2 = posPoint.getAttributes();
-                missionItemInt.param4 = NAN;    // yaw
-                missionItemInt.x = (int)(posPoint.getX() * 10e4);
-                missionItemInt.y = (int)(posPoint.getY() * 10e4);
-                missionItemInt.z = (float)posPoint.getHeight();
-                missionItemInt.mission_type = MAV_MISSION_TYPE_MISSION;
+            if (missionRequestInt.seq >= mMissionDownloadItems.size()) {
+                sendMissionAck(MAV_MISSION_INVALID_SEQUENCE);
+                break;
+            }
 
-                mavlink_address.system_id = mSystemId;
-                mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+            mTxQueue.send(MavlinkTxQueue::Class::Safety, [this, missionItemInt = mMissionDownloadItems[missionRequestInt.seq]]() {
+                if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+                    mavlink_address.system_id = mSystemId;
+                    mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
 
-                mavlink_message_t mavmissionItemIntMsg;
-                mavlink_msg_mission_item_int_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavmissionItemIntMsg, &missionItemInt);
+                    mavlink_message_t mavmissionItemIntMsg;
+                    mavlink_msg_mission_item_int_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavmissionItemIntMsg, &missionItemInt);
 
-                return mavmissionItemIntMsg;
-            }) != mavsdk::MavlinkPassthrough::Result::Success)
-                qWarning() << "Could not send MISSION_ITEM_INT via MAVLINK.";
+                    return mavmissionItemIntMsg;
+                }) != mavsdk::MavlinkPassthrough::Result::Success)
+                    qWarning() << "Could not send MISSION_ITEM_INT via MAVLINK.";
+            });
             break;
         }
         case MAVLINK_MSG_ID_MISSION_REQUEST:
@@ -246,33 +422,39 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
                 break;
             }
 
-            PosPoint posPoint = currentRoute.at(missionRequest.seq);
-            if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-                mavlink_mission_item_t missionItem;
-                memset(&missionItem, 0, sizeof(missionItem));
-
-                missionItem.seq = missionRequest.seq;
-                missionItem.frame = MAV_FRAME_LOCAL_ENU;
-                missionItem.command = MAV_CMD_NAV_WAYPOINT;
-                missionItem.current = false;
-                missionItem.autocontinue = true;
-                missionItem.param1 = posPoint.getSpeed();
-                missionItem.param2 = posPoint.getAttributes();
-                missionItem.param4 = NAN;    // yaw
-                missionItem.x = (int)(posPoint.getX() * 10e4);
-                missionItem.y = (int)(posPoint.getY() * 10e4);
-                missionItem.z = (float)posPoint.getHeight();
-                missionItem.mission_type = MAV_MISSION_TYPE_MISSION;
-
-                mavlink_address.system_id = mSystemId;
-                mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
-
-                mavlink_message_t mavmissionItemMsg;
-                mavlink_msg_mission_item_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavmissionItemMsg, &missionItem);
+            if (missionRequest.seq >= mMissionDownloadItems.size()) {
+                sendMissionAck(MAV_MISSION_INVALID_SEQUENCE);
+                break;
+            }
 
-                return mavmissionItemMsg;
-            }) != mavsdk::MavlinkPassthrough::Result::Success)
-                qWarning() << "Could not send MISSION_ITEM via MAVLINK.";
+            mTxQueue.send(MavlinkTxQueue::Class::Safety, [this, missionItemInt = mMissionDownloadItems[missionRequest.seq]]() {
+                if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+                    mavlink_mission_item_t missionItem;
+                    memset(&missionItem, 0, sizeof(missionItem));
+
+                    missionItem.seq = missionItemInt.seq;
+                    missionItem.frame = missionItemInt.frame;
+                    missionItem.command = missionItemInt.command;
+                    missionItem.current = missionItemInt.current;
+                    missionItem.autocontinue = missionItemInt.autocontinue;
+                    missionItem.param1 = missionItemInt.param1;
+                    missionItem.param2 = missionItemInt.param2;
+                    missionItem.param4 = missionItemInt.param4;
+                    missionItem.x = missionItemInt.x;
+                    missionItem.y = missionItemInt.y;
+                    missionItem.z = missionItemInt.z;
+                    missionItem.mission_type = missionItemInt.mission_type;
+
+                    mavlink_address.system_id = mSystemId;
+                    mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+                    mavlink_message_t mavmissionItemMsg;
+                    mavlink_msg_mission_item_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavmissionItemMsg, &missionItem);
+
+                    return mavmissionItemMsg;
+                }) != mavsdk::MavlinkPassthrough::Result::Success)
+                    qWarning() << "Could not send MISSION_ITEM via MAVLINK.";
+            });
             break;
         }
         case MAVLINK_MSG_ID_MISSION_ACK:
@@ -291,6 +473,8 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
         return true;
     });
 
+    CommandLatencyTrace::getInstance().setCompletedCallback([this](const CommandLatencyTraceResult &trace) { sendCommandLatencyTrace(trace); });
+
     // --- Things that we should implement/fix in MAVSDK follow from here :-)
     // Create mavlinkpassthrough plugin (TODO: should not be used on vehicle side...)
     mMavsdk->subscribe_on_new_system([this](){
@@ -305,6 +489,35 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
                 else
                     qDebug() << "Warning: got request to change autopilot id, but switchAutopilotID(..) signal is not connected.";
                 break;
+            case MAV_CMD_SET_MESSAGE_INTERVAL: {
+                const uint32_t messageId = mavlink_msg_command_long_get_param1(&message);
+                const qint64 interval_us = mavlink_msg_command_long_get_param2(&message);
+                mavResult(MAV_CMD_SET_MESSAGE_INTERVAL, setMessageInterval(messageId, interval_us) ? MAV_RESULT_ACCEPTED : MAV_RESULT_DENIED, MAV_COMP_ID_AUTOPILOT1);
+                break;
+            }
+            case MAV_CMD_DO_FOLLOW: { // convoy, param1: system id of predecessor, 0: none
+                const quint8 predecessorSystemId = quint8(mavlink_msg_command_long_get_param1(&message));
+                mavResult(MAV_CMD_DO_FOLLOW, mConvoyLink.isStarted() ? MAV_RESULT_ACCEPTED : MAV_RESULT_UNSUPPORTED, MAV_COMP_ID_AUTOPILOT1);
+                QMetaObject::invokeMethod(this, [this, predecessorSystemId]() {
+                    mConvoyLink.setPredecessor(predecessorSystemId);
+                    mConvoyGap_m = -1.0;
+                    qDebug() << "MavsdkVehicleServer: convoy predecessor set to" << predecessorSystemId;
+                }, Qt::QueuedConnection);
+                break;
+            }
+            case mavlinkRouteTransfer::RECORD_ROUTE_COMMAND: {
+                const bool start = mavlink_msg_command_long_get_param1(&message) > 0.5f;
+                QMetaObject::invokeMethod(this, [this, start]() {
+                    mavResult(mavlinkRouteTransfer::RECORD_ROUTE_COMMAND, recordRoute(start) ? MAV_RESULT_ACCEPTED : MAV_RESULT_DENIED, MAV_COMP_ID_AUTOPILOT1);
+                }, Qt::QueuedConnection);
+                break;
+            }
+            case MAV_CMD_GET_MESSAGE_INTERVAL: {
+                const uint32_t messageId = mavlink_msg_command_long_get_param1(&message);
+                mavResult(MAV_CMD_GET_MESSAGE_INTERVAL, MAV_RESULT_ACCEPTED, MAV_COMP_ID_AUTOPILOT1);
+                sendMessageInterval(messageId);
+                break;
+            }
             case MAV_CMD_PREFLIGHT_REBOOT_SHUTDOWN:
                 auto param2Value = mavlink_msg_command_long_get_param2(&message);
                 if (param2Value == 1) {
@@ -319,6 +532,46 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
             }
         });
 
+        // Goto (e.g., MavsdkVehicleConnection::requestGotoLlh), planned on the vehicle by the local planner
+        mMavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_COMMAND_INT, [this](const mavlink_message_t &message) {
+            mavlink_command_int_t commandInt;
+            mavlink_msg_command_int_decode(&message, &commandInt);
+            if (commandInt.command != MAV_CMD_DO_REPOSITION)
+                return;
+
+            const llh_t llh {commandInt.x / 1e7, commandInt.y / 1e7, commandInt.z};
+            const double yaw_degNED = commandInt.param4;
+            QMetaObject::invokeMethod(this, [this, llh, yaw_degNED]() {
+                mavResult(MAV_CMD_DO_REPOSITION, planGoto(llh, yaw_degNED) ? MAV_RESULT_ACCEPTED : MAV_RESULT_DENIED, MAV_COMP_ID_AUTOPILOT1);
+            }, Qt::QueuedConnection);
+        });
+
+        // Clock synchronization: answer tagged requests of control stations in our time_boot_ms base (see mavlinkTimesync)
+        mMavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_TIMESYNC, [this](const mavlink_message_t &message) {
+            mavlink_timesync_t request;
+            mavlink_msg_timesync_decode(&message, &request);
+            if (request.tc1 != 0 || !mavlinkTimesync::isTagged(request.ts1, mavlinkTimesync::REQUEST_TAG))
+                return;
+
+            const int64_t timeSinceBoot_ns = mavlinkTimesync::getTimeSinceBoot_ns();
+            mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+                mavlink_message_t mavTimesyncMsg;
+                mavlink_timesync_t response;
+                memset(&response, 0, sizeof(mavlink_timesync_t));
+
+                response.tc1 = mavlinkTimesync::tag(timeSinceBoot_ns, mavlinkTimesync::RESPONSE_TAG);
+                response.ts1 = request.ts1;
+                response.target_system = message.sysid;
+                response.target_component = message.compid;
+                mavlink_address.system_id = mSystemId;
+                mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+                mavlink_msg_timesync_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavTimesyncMsg, &response);
+
+                return mavTimesyncMsg;
+            });
+        });
+
         // Handle RTCM data
         mMavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_GPS_RTCM_DATA, [this](const mavlink_message_t &message) {
             mavlink_gps_rtcm_data_t mavRtcmData;
@@ -351,67 +604,6 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
                 emit rxRtcmData(rtcmData);
             }
         });
-
-        // Publish autopilot radius
-        connect(&mPublishMavlinkTimer, &QTimer::timeout, [this](){
-            if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-                mavlink_message_t mavAutopilotRadiusmMsg;
-                mavlink_named_value_float_t autopilotRadius;
-
-                memset(&autopilotRadius, 0, sizeof(mavlink_named_value_float_t));
-
-                autopilotRadius.time_boot_ms = QDateTime::currentMSecsSinceEpoch() - mMavsdkVehicleServerCreationTime.toMSecsSinceEpoch();
-                autopilotRadius.value = mVehicleState->getAutopilotRadius();
-                mavlink_address.system_id = mSystemId;
-                mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
-
-                strcpy(autopilotRadius.name, "AR");
-                mavlink_msg_named_value_float_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavAutopilotRadiusmMsg, &autopilotRadius);
-
-                return mavAutopilotRadiusmMsg;
-            }) != mavsdk::MavlinkPassthrough::Result::Success)
-                    qWarning() << "Could not send Autopilot Radius via MAVLINK.";
-        });
-
-        // Publish Autopilot lookahead and reference points
-        connect(&mPublishMavlinkTimer, &QTimer::timeout, [this]() {
-            if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-                mavlink_message_t mavMsg;
-                mavlink_position_target_local_ned_t autopilotPoints;
-
-                memset(&autopilotPoints, 0, sizeof(mavlink_position_target_local_ned_t));
-
-                autopilotPoints.time_boot_ms = QDateTime::currentMSecsSinceEpoch() - mMavsdkVehicleServerCreationTime.toMSecsSinceEpoch();
-
-                QPointF autopilotTargetPointENU_XY = mVehicleState->getAutopilotTargetPoint();
-                xyz_t autopilotTargetPointNED = coordinateTransforms::enuToNED({autopilotTargetPointENU_XY.x(), autopilotTargetPointENU_XY.y(), 0});
-                autopilotPoints.x = autopilotTargetPointNED.x;
-                autopilotPoints.y = autopilotTargetPointNED.y;
-
-                autopilotPoints.type_mask = POSITION_TARGET_TYPEMASK_Z_IGNORE|
-                                        POSITION_TARGET_TYPEMASK_VX_IGNORE |
-                                        POSITION_TARGET_TYPEMASK_VY_IGNORE |
-                                        POSITION_TARGET_TYPEMASK_VZ_IGNORE |
-                                        POSITION_TARGET_TYPEMASK_AX_IGNORE |
-                                        POSITION_TARGET_TYPEMASK_AY_IGNORE |
-                                        POSITION_TARGET_TYPEMASK_AZ_IGNORE |
-                                        POSITION_TARGET_TYPEMASK_YAW_IGNORE |
-                                        POSITION_TARGET_TYPEMASK_YAW_RATE_IGNORE;
-
-                mavlink_address.system_id = mSystemId;
-                mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
-
-                // Encode and send the POSITION_TARGET_LOCAL_NED message
-                mavlink_msg_position_target_local_ned_encode_chan(mavlink_address.system_id,
-                                                                mavlink_address.component_id,
-                                                                channel,
-                                                                &mavMsg,
-                                                                &autopilotPoints);
-
-                return mavMsg;
-            }) != mavsdk::MavlinkPassthrough::Result::Success)
-                qWarning() << "Could not send Autopilot Reference Point via MAVLINK.";
-        });
     });
 
     mMavsdk->intercept_outgoing_messages_async([this](mavlink_message_t &message){
@@ -456,12 +648,14 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
         default: ;
 //            qDebug() << "out:" << message.msgid;
         }
+        mLinkMonitor.countOutgoing(message);
         return true;
 
     });
 
-    // Start publishing status on MAVLink (TODO: rate?)
-    mPublishMavlinkTimer.start(100);
+    // Link statistics, non-critical streams are throttled when the link gets congested (if enabled)
+    connect(&mLinkStatisticsTimer, &ClockTimer::timeout, this, &MavsdkVehicleServer::updateLinkStatistics);
+    mLinkStatisticsTimer.start(1000);
 
     mavsdk::ConnectionResult result;
     switch (controlTowerSocketType) {
@@ -476,8 +670,11 @@ MavsdkVehicleServer::MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleSta
 
     if (result == mavsdk::ConnectionResult::Success) {
         qDebug() << "MavsdkVehicleServer is listening on" << controlTowerAddress.toString() << "with port" << controlTowerPort;
-        if (vehicleState->hasTrailingVehicle())
-            createMavsdkComponentForTrailer(controlTowerAddress, controlTowerPort, controlTowerSocketType);
+        StartupProfile::getInstance().markPhase("ST_LISTEN");
+        mControlTowerAddress = controlTowerAddress;
+        mControlTowerPort = controlTowerPort;
+        mControlTowerSocketType = controlTowerSocketType;
+        mTrailerComponentPending = vehicleState->hasTrailingVehicle();
     }
 }
 
@@ -487,6 +684,192 @@ void MavsdkVehicleServer::provideParametersToParameterServer() {
         std::function<void(int)>([this](int value) {this->mVehicleState->setWaywiseObjectType(static_cast<WAYWISE_OBJECT_TYPE>(value));}),
         std::function<int(void)>([this]() {return static_cast<int>(this->mVehicleState->getWaywiseObjectType());})
     );
+    ParameterServer::getInstance()->provideIntParameter("MAV_TX_BUDGET", std::bind(&MavsdkVehicleServer::setAdaptiveTxBudget, this, std::placeholders::_1), std::bind(&MavsdkVehicleServer::getAdaptiveTxBudget, this));
+    ParameterServer::getInstance()->provideIntParameter("MAV_LOG_SEV", std::bind(&MavsdkVehicleServer::setLogForwardingSeverity, this, std::placeholders::_1), std::bind(&MavsdkVehicleServer::getLogForwardingSeverity, this));
+}
+
+void MavsdkVehicleServer::updateLinkStatistics()
+{
+    const MavlinkLinkStatistics linkStatistics = mLinkMonitor.update();
+    emit updatedLinkStatistics(linkStatistics);
+
+    if (mAdaptiveTxBudget_Bps <= 0) {
+        mStreamScheduler.setThrottleFactor(1.0);
+        return;
+    }
+
+    // Halving/doubling keeps the reaction within a few seconds. Incoming loss indicates a saturated (half-duplex) radio
+    // even below the budget, and losing heartbeats or manual control is what needs to be avoided.
+    const double throttleFactor = mStreamScheduler.getThrottleFactor();
+    if (linkStatistics.txBytesPerSecond > 0.9 * mAdaptiveTxBudget_Bps || linkStatistics.rxLossRatio > MAX_RX_LOSS_RATIO) {
+        if (throttleFactor < MAX_THROTTLE_FACTOR) {
+            mStreamScheduler.setThrottleFactor(std::min(2.0 * throttleFactor, MAX_THROTTLE_FACTOR));
+            qDebug() << "MavsdkVehicleServer: link congested (TX" << linkStatistics.txBytesPerSecond << "B/s, RX loss" << linkStatistics.rxLossRatio
+                     << "), throttling non-critical streams by" << mStreamScheduler.getThrottleFactor();
+        }
+    } else if (throttleFactor > 1.0 && 2.0 * linkStatistics.txBytesPerSecond < 0.7 * mAdaptiveTxBudget_Bps && linkStatistics.rxLossRatio < 0.5 * MAX_RX_LOSS_RATIO)
+        mStreamScheduler.setThrottleFactor(std::max(0.5 * throttleFactor, 1.0));
+}
+
+void MavsdkVehicleServer::setClock(Clock *clock)
+{
+    VehicleServer::setClock(clock);
+    mLinkStatisticsTimer.setClock(clock);
+    mConvoyPublishTimer.setClock(clock);
+    mRouteUploadStallTimer.setClock(clock);
+    mGeofenceUploadStallTimer.setClock(clock);
+    mRouteBroadcastStallTimer.setClock(clock);
+    mManualControlTimer.setClock(clock);
+}
+
+bool MavsdkVehicleServer::startConvoyLink(quint16 port, const QHostAddress &group)
+{
+    if (!mConvoyLink.start(mSystemId, port, group))
+        return false;
+
+    connect(&mConvoyLink, &MavlinkConvoyLink::predecessorPositionReceived, this,
+            [this](const llh_t &llh, double yaw_degENU, const xyz_t &velocityENU, qint64 timestamp_ns) {
+        Q_UNUSED(velocityENU)
+        followConvoyPredecessor(llh, yaw_degENU, timestamp_ns);
+    }, Qt::UniqueConnection);
+    connect(&mConvoyPublishTimer, &ClockTimer::timeout, this, &MavsdkVehicleServer::publishConvoyPosition, Qt::UniqueConnection);
+    mConvoyPublishTimer.start(CONVOY_PUBLISH_INTERVAL_MS);
+    return true;
+}
+
+void MavsdkVehicleServer::publishConvoyPosition()
+{
+    if (mGNSSReceiver.isNull())
+        return;
+
+    const PosPoint fusedPos = mVehicleState->getPosition(PosType::fused);
+    mConvoyLink.publishPosition(coordinateTransforms::enuToLlh(mGNSSReceiver->getEnuRef(), fusedPos.getXYZ()), fusedPos.getYaw(), mVehicleState->getVelocity(),
+                                utcTime::isValid(fusedPos.getTimestamp_ns()) ? fusedPos.getTimestamp_ns() : utcTime::now_ns());
+}
+
+void MavsdkVehicleServer::followConvoyPredecessor(const llh_t &llh, double yaw_degENU, qint64 timestamp_ns)
+{
+    if (mGNSSReceiver.isNull() || mFollowPoint.isNull()) {
+        static bool warned = false;
+        if (!warned)
+            qDebug() << "Warning: MavsdkVehicleServer got convoy predecessor position, but has no GNSS receiver (ENU reference) or FollowPoint.";
+        warned = true;
+        return;
+    }
+
+    const xyz_t predecessorENU = coordinateTransforms::llhToEnu(mGNSSReceiver->getEnuRef(), llh);
+    PosPoint predecessorPos;
+    predecessorPos.setXYZ(predecessorENU);
+    predecessorPos.setYaw(yaw_degENU);
+    predecessorPos.setTimestamp_ns(timestamp_ns);
+    mConvoyGap_m = mVehicleState->getPosition(PosType::fused).getDistanceTo(predecessorPos);
+
+    mFollowPoint->updatePointToFollowInEnuFrame(predecessorPos);
+}
+
+void MavsdkVehicleServer::addTelemetryStream(uint32_t messageId, std::function<void()> publish, MavlinkStreamScheduler::Priority priority)
+{
+    const int publishLatencyId = PerfCounters::getInstance().registerCounter(QString("MAVPUB_%1").arg(messageId), PerfCounters::Type::Latency);
+    static const int allocationTag = AllocationTracker::getInstance().registerTag("MAVPUB");
+    mStreamScheduler.addStream(messageId, DEFAULT_STREAM_INTERVAL_us, [this, publish, publishLatencyId]() {
+        mTxQueue.send(MavlinkTxQueue::Class::Telemetry, [publish, publishLatencyId]() {
+            PerfCounters::ScopedLatency latency(publishLatencyId);
+            AllocationTracker::ScopedTag tag(allocationTag);
+            publish();
+        });
+    }, priority);
+}
+
+void MavsdkVehicleServer::publishPerfCounters()
+{
+    if (!mMavlinkPassthrough)
+        return;
+
+    AllocationTracker::getInstance().publish(); // allocations since the last publication
+    PerfCounters &perfCounters = PerfCounters::getInstance();
+    const int numCounters = perfCounters.getNumCounters();
+    if (numCounters == 0)
+        return;
+    if (mPublishedPerfCounters.size() < numCounters)
+        mPublishedPerfCounters.resize(numCounters);
+
+    for (int i = 0; i < std::min(PERF_COUNTERS_PER_PUBLISH, numCounters); i++) {
+        const int id = mNextPerfCounter++ % numCounters;
+        const PerfCounterSnapshot snapshot = perfCounters.getSnapshot(id);
+        PerfCounterSnapshot &previous = mPublishedPerfCounters[id]; // empty on first publication: latencies since registration
+
+        mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+            mavlink_message_t mavPerfCounterMsg;
+            mavlink_debug_float_array_t perfCounter;
+            memset(&perfCounter, 0, sizeof(mavlink_debug_float_array_t));
+
+            perfCounter.time_usec = mavlinkTimesync::getTimeSinceBoot_ns() / 1000;
+            perfCounter.array_id = static_cast<uint16_t>(snapshot.type);
+            snapshot.toArray(perfCounter.data, previous);
+            strncpy(perfCounter.name, snapshot.name.toLatin1().constData(), sizeof(perfCounter.name));
+            mavlink_address.system_id = mSystemId;
+            mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+            mavlink_msg_debug_float_array_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavPerfCounterMsg, &perfCounter);
+
+            return mavPerfCounterMsg;
+        });
+        previous = snapshot;
+    }
+    mNextPerfCounter %= numCounters;
+}
+
+MavsdkVehicleServer::~MavsdkVehicleServer()
+{
+    CommandLatencyTrace::getInstance().setCompletedCallback(nullptr);
+}
+
+void MavsdkVehicleServer::traceCommandLatency(const mavlink_message_t &message)
+{
+    switch (message.msgid) {
+    case MAVLINK_MSG_ID_DEBUG_FLOAT_ARRAY: { // tag of the next command, issue time in our time since boot
+        mavlink_debug_float_array_t tag;
+        mavlink_msg_debug_float_array_decode(&message, &tag);
+        if (tag.array_id == CommandLatencyTrace::MAVLINK_ARRAY_ID && strncmp(tag.name, CommandLatencyTrace::MAVLINK_TAG_NAME, sizeof(tag.name)) == 0)
+            CommandLatencyTrace::getInstance().begin(quint16(tag.data[0]), quint8(tag.data[1]), tag.time_usec > 0 ? qint64(tag.time_usec) * 1000 : -1);
+    } break;
+    case MAVLINK_MSG_ID_MANUAL_CONTROL:
+    case MAVLINK_MSG_ID_COMMAND_LONG:
+    case MAVLINK_MSG_ID_COMMAND_INT:
+    case MAVLINK_MSG_ID_SET_POSITION_TARGET_LOCAL_NED:
+    case MAVLINK_MSG_ID_SET_MODE:
+        CommandLatencyTrace::getInstance().mark(CommandLatencyTrace::Stage::Received);
+        if (!mFirstCommandReceived.load(std::memory_order_relaxed) && !mFirstCommandReceived.exchange(true))
+            StartupProfile::getInstance().markPhase("ST_COMMAND");
+        break;
+    default:
+        break;
+    }
+}
+
+void MavsdkVehicleServer::sendCommandLatencyTrace(const CommandLatencyTraceResult &trace)
+{
+    if (!mMavlinkPassthrough)
+        return;
+
+    mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+        mavlink_message_t mavTraceMsg;
+        mavlink_debug_float_array_t traceArray;
+        memset(&traceArray, 0, sizeof(mavlink_debug_float_array_t));
+
+        traceArray.time_usec = mavlinkTimesync::getTimeSinceBoot_ns() / 1000;
+        traceArray.array_id = CommandLatencyTrace::MAVLINK_ARRAY_ID;
+        strncpy(traceArray.name, CommandLatencyTrace::MAVLINK_TRACE_NAME, sizeof(traceArray.name));
+        traceArray.data[0] = trace.tag;
+        traceArray.data[1] = trace.command;
+        for (int i = 1; i < CommandLatencyTraceResult::NUM_STAGES; i++)
+            traceArray.data[1 + i] = trace.getStageLatency_ms(i) < 0.0 ? -1.0f : float(trace.getStageLatency_ms(i) * 1000.0);
+        mavlink_address.system_id = mSystemId;
+        mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+        mavlink_msg_debug_float_array_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavTraceMsg, &traceArray);
+        return mavTraceMsg;
+    });
 }
 
 void MavsdkVehicleServer::heartbeatTimeout() {
@@ -507,6 +890,12 @@ void MavsdkVehicleServer::heartbeatReset()
 {
     mHeartbeatTimer.start(mCountdown_ms);
     mHeartbeat = true;
+
+    StartupProfile::getInstance().markPhase("ST_STATION");
+    if (mTrailerComponentPending) {
+        mTrailerComponentPending = false;
+        createMavsdkComponentForTrailer(mControlTowerAddress, mControlTowerPort, mControlTowerSocketType);
+    }
 }
 
 void MavsdkVehicleServer::setUbloxRover(QSharedPointer<UbloxRover> ubloxRover)
@@ -522,7 +911,8 @@ void MavsdkVehicleServer::setUbloxRover(QSharedPointer<UbloxRover> ubloxRover)
 }
 
 void MavsdkVehicleServer::updateRawGpsAndGpsInfoFromUbx(const ubx_nav_pvt &pvt) {
-    mRawGps.timestamp_us = pvt.i_tow*1000; // TODO
+    mRawGps.timestamp_us = (pvt.valid_date && pvt.valid_time) ?
+                utcTime::fromCalendar(pvt.year, pvt.month, pvt.day, pvt.hour, pvt.min, pvt.second, pvt.nano) / 1000 : utcTime::now_ns() / 1000;
     mRawGps.latitude_deg = pvt.lat;
     mRawGps.longitude_deg = pvt.lon;
     mRawGps.absolute_altitude_m = pvt.height;
@@ -578,36 +968,118 @@ void MavsdkVehicleServer::setFollowPoint(QSharedPointer<FollowPoint> followPoint
     connect(this, &MavsdkVehicleServer::stopFollowPoint, mFollowPoint.get(), &FollowPoint::stopFollowPoint);
 }
 
-PosPoint MavsdkVehicleServer::convertMissionItemToPosPoint(const mavsdk::MissionRawServer::MissionItem &item)
+void MavsdkVehicleServer::convertMissionItemToPOD(const mavsdk::MissionRawServer::MissionItem &item, pospoint_t &routePoint)
 {
-    PosPoint routePoint;
-
-    routePoint.setX(item.x / 10e4);
-    routePoint.setY(item.y / 10e4);
-    routePoint.setHeight(item.z);
+    routePoint = pospoint_t();
+    routePoint.x = item.x / 10e4;
+    routePoint.y = item.y / 10e4;
+    routePoint.height = item.z;
      // TODO: does not follow MAV_CMD_NAV_WAYPOINT definition
-    routePoint.setSpeed(item.param1);
-    routePoint.setAttributes(item.param2);
+    routePoint.speed = item.param1;
+    routePoint.attributes = item.param2;
+}
 
-//    qDebug() << routePoint.getX() << routePoint.getY() << routePoint.getHeight();
+void MavsdkVehicleServer::updateMissionDownloadItems()
+{
+    if (mWaypointFollower.isNull()) {
+        mMissionDownloadItems.clear();
+        mMissionDownloadRouteVersion = std::numeric_limits<quint64>::max();
+        return;
+    }
 
-    return routePoint;
+    // Version first: a route changed meanwhile is encoded again on the next request
+    const quint64 routeVersion = mWaypointFollower->getRouteVersion();
+    if (routeVersion == mMissionDownloadRouteVersion)
+        return;
+
+    const QList<PosPoint> route = mWaypointFollower->getCurrentRoute();
+    mMissionDownloadItems.resize(route.size());
+    for (int i = 0; i < route.size(); i++) {
+        const PosPoint &posPoint = route.at(i);
+        mavlink_mission_item_int_t &missionItemInt = mMissionDownloadItems[i];
+        memset(&missionItemInt, 0, sizeof(missionItemInt));
+
+        missionItemInt.seq = i;
+        missionItemInt.frame = MAV_FRAME_LOCAL_ENU;
+        missionItemInt.command = MAV_CMD_NAV_WAYPOINT;
+        missionItemInt.current = false;
+        missionItemInt.autocontinue = true;
+        missionItemInt.param1 = posPoint.getSpeed();
+        missionItemInt.param2 = posPoint.getAttributes();
+        missionItemInt.param4 = NAN;    // yaw
+        missionItemInt.x = (int)(posPoint.getX() * 10e4);
+        missionItemInt.y = (int)(posPoint.getY() * 10e4);
+        missionItemInt.z = (float)posPoint.getHeight();
+        missionItemInt.mission_type = MAV_MISSION_TYPE_MISSION;
+    }
+    mMissionDownloadRouteVersion = routeVersion;
 }
 
-void MavsdkVehicleServer::handleManualControlMessage(mavlink_manual_control_t manualControl)
+void MavsdkVehicleServer::startManualControl()
 {
-    if (!mMovementController.isNull()) {
-        mVehicleState->setFlightMode(VehicleState::FlightMode::Manual);
+    if (mMovementController.isNull()) {
+        qDebug() << "Warning: MavsdkVehicleServer got manual control message, but has no MovementController to talk to.";
+        mManualControlActive.store(false);
+        return;
+    }
+
+    mManualControlOutput = ManualControlSample();
+    mManualControlTarget = ManualControlSample();
+    mManualControlRamp_us = 0;
+    mManualControlTimer.start(MANUAL_CONTROL_APPLY_INTERVAL_MS);
+    applyManualControl();
+}
+
+void MavsdkVehicleServer::stopManualControl()
+{
+    mManualControlTimer.stop();
+    mManualControlActive.store(false);
+
+    // A sample published before the flag was cleared did not restart manual control
+    if (mManualControlMailbox.peek().received_us > mManualControlTarget.received_us && !mManualControlActive.exchange(true))
+        startManualControl();
+}
+
+void MavsdkVehicleServer::applyManualControl()
+{
+    if (mVehicleState->getFlightMode() != VehicleState::FlightMode::Manual) { // left manual mode meanwhile, do not interfere
+        mManualControlTimer.stop();
+        mManualControlActive.store(false);
+        return;
+    }
 
+    const qint64 now_us = mManualControlTimer.getClock()->now_us();
+    ManualControlSample sample;
+    if (mManualControlMailbox.take(sample)) {
         if (!mWaypointFollower.isNull() && mWaypointFollower->isActive()) {
             qDebug() << "MavsdkVehicleServer: WaypointFollower stopped by manual control input.";
             mWaypointFollower->stop();
         }
 
-        mMovementController->setDesiredSpeed((manualControl.x / 1000.0) * mManualControlMaxSpeed);
-        mMovementController->setDesiredSteering(manualControl.r / 1000.0);
-    } else
-        qDebug() << "Warning: MavsdkVehicleServer got manual control message, but has no MovementController to talk to.";
+        // Ramp over the last sample interval (the first sample is applied directly)
+        mManualControlRamp_us = mManualControlTarget.received_us > 0 ?
+                    std::clamp(sample.received_us - mManualControlTarget.received_us, (qint64)0, MANUAL_CONTROL_MAX_RAMP_US) : 0;
+        mManualControlRampStart = mManualControlOutput;
+        mManualControlRampStart.received_us = now_us;
+        mManualControlTarget = sample;
+    }
+
+    if (now_us - mManualControlTarget.received_us > MANUAL_CONTROL_HOLD_US) {
+        if (mManualControlTarget.throttle != 0.0 || mManualControlTarget.steering != 0.0) // not released to neutral
+            qDebug() << "MavsdkVehicleServer: no manual control input for" << MANUAL_CONTROL_HOLD_US / 1000 << "ms, stopping.";
+        mMovementController->setDesiredSteering(0.0);
+        mMovementController->setDesiredSpeed(0.0);
+        stopManualControl();
+        return;
+    }
+
+    const double rampProgress = mManualControlRamp_us > 0 ?
+                std::clamp(double(now_us - mManualControlRampStart.received_us) / mManualControlRamp_us, 0.0, 1.0) : 1.0;
+    mManualControlOutput.throttle = mManualControlRampStart.throttle + rampProgress * (mManualControlTarget.throttle - mManualControlRampStart.throttle);
+    mManualControlOutput.steering = mManualControlRampStart.steering + rampProgress * (mManualControlTarget.steering - mManualControlRampStart.steering);
+
+    mMovementController->setDesiredSpeed(mManualControlOutput.throttle * mManualControlMaxSpeed);
+    mMovementController->setDesiredSteering(mManualControlOutput.steering);
 }
 
 void MavsdkVehicleServer::setManualControlMaxSpeed(double manualControlMaxSpeed_ms)
@@ -622,24 +1094,26 @@ double MavsdkVehicleServer::getManualControlMaxSpeed() const
 
 void MavsdkVehicleServer::mavResult(const uint16_t command, MAV_RESULT result, MAV_COMPONENT compId)
 {
-    if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-        mavlink_message_t ackMsg;
-        mavlink_command_ack_t commandAck;
-        memset(&commandAck, 0, sizeof(commandAck));
-        commandAck.command = command;
-        commandAck.result = result;
-        commandAck.progress = std::numeric_limits<uint8_t>::max();
-        commandAck.result_param2 = 0;
-        commandAck.target_system = mMavlinkPassthrough->get_target_sysid();
-        commandAck.target_component = mMavlinkPassthrough->get_target_compid();
-
-        mavlink_address.system_id = mSystemId;
-        mavlink_address.component_id = compId;
-
-        mavlink_msg_command_ack_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &ackMsg, &commandAck);
-        return ackMsg;
-    }) != mavsdk::MavlinkPassthrough::Result::Success)
-            qWarning() << "Could not send ACK via MAVLINK.";
+    mTxQueue.send(MavlinkTxQueue::Class::Safety, [this, command, result, compId]() {
+        if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+            mavlink_message_t ackMsg;
+            mavlink_command_ack_t commandAck;
+            memset(&commandAck, 0, sizeof(commandAck));
+            commandAck.command = command;
+            commandAck.result = result;
+            commandAck.progress = std::numeric_limits<uint8_t>::max();
+            commandAck.result_param2 = 0;
+            commandAck.target_system = mMavlinkPassthrough->get_target_sysid();
+            commandAck.target_component = mMavlinkPassthrough->get_target_compid();
+
+            mavlink_address.system_id = mSystemId;
+            mavlink_address.component_id = compId;
+
+            mavlink_msg_command_ack_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &ackMsg, &commandAck);
+            return ackMsg;
+        }) != mavsdk::MavlinkPassthrough::Result::Success)
+                qWarning() << "Could not send ACK via MAVLINK.";
+    });
 };
 
 void MavsdkVehicleServer::sendGpsOriginLlh(const llh_t &gpsOriginLlh)
@@ -665,6 +1139,405 @@ void MavsdkVehicleServer::sendGpsOriginLlh(const llh_t &gpsOriginLlh)
             qWarning() << "Could not send GPS_GLOBAL_ORIGIN via MAVLINK.";
 };
 
+bool MavsdkVehicleServer::setMessageInterval(uint32_t messageId, qint64 interval_us)
+{
+    if (!mStreamScheduler.setMessageInterval(messageId, interval_us)) {
+        qDebug() << "WARNING: MavsdkVehicleServer got message interval for unsupported message id" << messageId;
+        return false;
+    }
+    return true;
+}
+
+void MavsdkVehicleServer::sendMessageInterval(uint32_t messageId)
+{
+    if (mMavlinkPassthrough == nullptr)
+        return;
+
+    mTxQueue.send(MavlinkTxQueue::Class::Safety, [this, messageId]() {
+        if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+            mavlink_message_t mavMessageIntervalMsg;
+            mavlink_message_interval_t mavMessageInterval;
+            memset(&mavMessageInterval, 0, sizeof(mavlink_message_interval_t));
+
+            mavMessageInterval.message_id = messageId;
+            mavMessageInterval.interval_us = mStreamScheduler.getMessageInterval(messageId); // 0: not available
+
+            mavlink_address.system_id = mSystemId;
+            mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+            mavlink_msg_message_interval_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavMessageIntervalMsg, &mavMessageInterval);
+            return mavMessageIntervalMsg;
+        }) != mavsdk::MavlinkPassthrough::Result::Success)
+                qWarning() << "Could not send MESSAGE_INTERVAL via MAVLINK.";
+    });
+}
+
+void MavsdkVehicleServer::handleRouteTransferPacket(const mavlinkRouteTransfer::Packet &packet)
+{
+    switch (packet.type) {
+    case mavlinkRouteTransfer::PacketType::UploadChunk:
+        if (packet.transferId == mLastCompletedRouteUploadId) { // our ack got lost
+            sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Complete);
+            break;
+        }
+
+        if (mRouteUploadAssembler.addChunk(packet)) {
+            mRouteUploadStallTimer.stop();
+            const QByteArray encodedRoute = mRouteUploadAssembler.getData();
+            QList<PosPoint> route;
+            if (routeCodec::isRoutePatch(encodedRoute)) {
+                applyRoutePatch(packet.transferId, encodedRoute);
+            } else if (!routeCodec::decodeRoute(encodedRoute, route)) {
+                qDebug() << "WARNING: MavsdkVehicleServer got invalid route in bulk transfer.";
+                sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Failed);
+            } else if (mWaypointFollower.isNull()) {
+                qDebug() << "MavsdkVehicleServer: got new route but no WaypointFollower is set to receive it.";
+                sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Failed);
+            } else {
+                qDebug() << "MavsdkVehicleServer: got new route with" << route.size() << "points in bulk transfer.";
+                mWaypointFollower->addRoute(route);
+                mLastCompletedRouteUploadId = packet.transferId;
+                sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Complete);
+                if (!mPersistentRouteStore.isNull())
+                    mPersistentRouteStore->storeRoute(encodedRoute);
+            }
+            mRouteUploadAssembler = mavlinkRouteTransfer::ChunkAssembler();
+        } else {
+            mRouteUploadMissingRequests = 0;
+            mRouteUploadStallTimer.start(mavlinkRouteTransfer::RECEIVE_STALL_TIMEOUT_ms);
+        }
+        break;
+    case mavlinkRouteTransfer::PacketType::StoredRouteRequest: {
+        if (packet.transferId == mLastCompletedRouteUploadId) { // our ack got lost
+            sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Complete);
+            break;
+        }
+
+        QVector<pospoint_t> route;
+        if (mWaypointFollower.isNull() || mPersistentRouteStore.isNull() || !mPersistentRouteStore->loadRoute(packet.routeHash, route)) {
+            sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Failed); // sender uploads the route
+            break;
+        }
+
+        qDebug() << "MavsdkVehicleServer: using stored route with" << route.size() << "points.";
+        mWaypointFollower->addRoutePOD(route);
+        mLastCompletedRouteUploadId = packet.transferId;
+        sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Complete);
+        break;
+    }
+    case mavlinkRouteTransfer::PacketType::GeofenceUploadChunk:
+        if (packet.transferId == mLastCompletedGeofenceUploadId) { // our ack got lost
+            sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Complete);
+            break;
+        }
+
+        if (mGeofenceUploadAssembler.addChunk(packet)) {
+            mGeofenceUploadStallTimer.stop();
+            QSharedPointer<Geofence> geofence(new Geofence());
+            if (!mavlinkRouteTransfer::decodeGeofence(mGeofenceUploadAssembler.getData(), *geofence)) {
+                qDebug() << "WARNING: MavsdkVehicleServer got invalid geofence.";
+                sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Failed);
+            } else if (mMovementController.isNull()) {
+                qDebug() << "MavsdkVehicleServer: got geofence but no MovementController is set to enforce it.";
+                sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Failed);
+            } else {
+                qDebug() << "MavsdkVehicleServer: got geofence with" << geofence->getZoneCount() << "zones.";
+                mMovementController->setGeofence(geofence->isEmpty() ? QSharedPointer<const Geofence>() : geofence);
+                mLastCompletedGeofenceUploadId = packet.transferId;
+                sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Complete);
+            }
+            mGeofenceUploadAssembler = mavlinkRouteTransfer::ChunkAssembler();
+        } else {
+            mGeofenceUploadMissingRequests = 0;
+            mGeofenceUploadStallTimer.start(mavlinkRouteTransfer::RECEIVE_STALL_TIMEOUT_ms);
+        }
+        break;
+    case mavlinkRouteTransfer::PacketType::DownloadRequest: {
+        if (mRouteDownloadSender.isActive() && mRouteDownloadSender.getTransferId() == packet.transferId)
+            break; // already sending
+        const QByteArray encodedRoute = routeCodec::encodeRoute(mWaypointFollower.isNull() ? QVector<pospoint_t>() : mWaypointFollower->getCurrentRoutePOD());
+        if (packet.routeHash != 0 && routeCodec::getRouteHash(encodedRoute) == packet.routeHash)
+            sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Complete); // the station has this route
+        else if (!mRouteDownloadSender.start(packet.transferId, mavlinkRouteTransfer::PacketType::DownloadChunk, encodedRoute))
+            sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Failed);
+        break;
+    }
+    case mavlinkRouteTransfer::PacketType::Ack:
+        mRouteDownloadSender.handleAck(packet);
+        break;
+    case mavlinkRouteTransfer::PacketType::BroadcastRequest:
+        if (packet.transferId == mLastCompletedRouteBroadcastId) { // our ack got lost
+            sendRouteTransferAck(packet.transferId, mavlinkRouteTransfer::AckStatus::Complete, {}, mavlinkRouteTransfer::PacketType::BroadcastAck);
+            break;
+        }
+
+        if (mRouteBroadcastAssembler.isActive() && mRouteBroadcastAssembler.getTransferId() == packet.transferId) {
+            // Asked again: the station is done sending, i.e., we report what we still miss right away
+            mRouteBroadcastMissingRequests = 0;
+            routeBroadcastStalled();
+            break;
+        }
+        mRouteBroadcastAssembler.reset(packet.transferId, packet.chunkCount);
+        mRouteBroadcastHash = packet.routeHash;
+        mRouteBroadcastTransform = packet.transform;
+        mRouteBroadcastMissingRequests = 0;
+        mRouteBroadcastStallTimer.start(mavlinkRouteTransfer::REQUEST_TIMEOUT_ms);
+        break;
+    case mavlinkRouteTransfer::PacketType::BroadcastChunk:
+        // Chunks of broadcasts to other vehicles are ignored
+        if (!mRouteBroadcastAssembler.isActive() || packet.transferId != mRouteBroadcastAssembler.getTransferId() ||
+                packet.chunkCount != mRouteBroadcastAssembler.getChunkCount())
+            break;
+
+        if (mRouteBroadcastAssembler.addChunk(packet)) {
+            mRouteBroadcastStallTimer.stop();
+            routeBroadcastComplete(packet.transferId);
+        } else {
+            mRouteBroadcastMissingRequests = 0;
+            mRouteBroadcastStallTimer.start(mavlinkRouteTransfer::RECEIVE_STALL_TIMEOUT_ms);
+        }
+        break;
+    default:
+        ;
+    }
+}
+
+void MavsdkVehicleServer::applyRoutePatch(uint16_t transferId, const QByteArray &routePatch)
+{
+    if (mWaypointFollower.isNull()) {
+        qDebug() << "MavsdkVehicleServer: got route patch but no WaypointFollower is set to receive it.";
+        sendRouteTransferAck(transferId, mavlinkRouteTransfer::AckStatus::Failed);
+        return;
+    }
+
+    // Rejected if the follower's route is not the one the patch was made for, the station uploads the complete route then
+    QVector<pospoint_t> route = mWaypointFollower->getCurrentRoutePOD();
+    int firstChangedIndex;
+    if (!routeCodec::applyRoutePatch(routePatch, route, firstChangedIndex)) {
+        qDebug() << "MavsdkVehicleServer: route patch does not match the current route.";
+        sendRouteTransferAck(transferId, mavlinkRouteTransfer::AckStatus::Failed);
+        return;
+    }
+
+    qDebug() << "MavsdkVehicleServer: patched route from point" << firstChangedIndex << "of" << route.size() << ".";
+    mWaypointFollower->patchRoute(route, firstChangedIndex);
+    mLastCompletedRouteUploadId = transferId;
+    sendRouteTransferAck(transferId, mavlinkRouteTransfer::AckStatus::Complete);
+    if (!mPersistentRouteStore.isNull())
+        mPersistentRouteStore->storeRoute(routeCodec::encodeRoute(route));
+}
+
+void MavsdkVehicleServer::routeUploadStalled()
+{
+    if (!mRouteUploadAssembler.isActive())
+        return;
+
+    if (++mRouteUploadMissingRequests > mavlinkRouteTransfer::MAX_MISSING_REQUESTS) {
+        qDebug() << "WARNING: MavsdkVehicleServer route upload" << mRouteUploadAssembler.getTransferId() << "stalled, dropped.";
+        mRouteUploadAssembler = mavlinkRouteTransfer::ChunkAssembler();
+        return;
+    }
+
+    sendRouteTransferAck(mRouteUploadAssembler.getTransferId(), mavlinkRouteTransfer::AckStatus::Missing, mRouteUploadAssembler.getMissingChunks());
+    mRouteUploadStallTimer.start(mavlinkRouteTransfer::RECEIVE_STALL_TIMEOUT_ms);
+}
+
+void MavsdkVehicleServer::setLocalPlanner(QSharedPointer<HybridAStarPlanner> localPlanner, QSharedPointer<const OccupancyGrid> occupancyGrid)
+{
+    if (!mLocalPlanner.isNull())
+        disconnect(mLocalPlanner.get(), &HybridAStarPlanner::finished, this, &MavsdkVehicleServer::localPlannerFinished);
+
+    mLocalPlanner = localPlanner;
+    mLocalPlannerOccupancyGrid = occupancyGrid;
+    if (!mLocalPlanner.isNull())
+        connect(mLocalPlanner.get(), &HybridAStarPlanner::finished, this, &MavsdkVehicleServer::localPlannerFinished);
+}
+
+bool MavsdkVehicleServer::planGoto(const llh_t &llh, double yaw_degNED)
+{
+    if (mLocalPlanner.isNull() || mWaypointFollower.isNull() || mGNSSReceiver.isNull()) {
+        qDebug() << "Warning: MavsdkVehicleServer got goto request, but has no local planner, WaypointFollower or GNSS receiver (ENU reference).";
+        return false;
+    }
+
+    HybridAStarPlanner::Problem problem;
+    problem.start = mVehicleState->getPosition(PosType::fused);
+    const xyz_t goalENU = coordinateTransforms::llhToEnu(mGNSSReceiver->getEnuRef(), llh);
+    problem.goal = QPointF(goalENU.x, goalENU.y);
+    if (!std::isnan(yaw_degNED))
+        problem.goalYaw_rad = coordinateTransforms::yawNEDtoENU(yaw_degNED) * M_PI / 180.0;
+    problem.occupancyGrid = mLocalPlannerOccupancyGrid;
+    if (!mMovementController.isNull())
+        problem.geofence = mMovementController->getGeofence();
+
+    HybridAStarPlanner::Parameters parameters = mLocalPlannerParameters;
+    const QSharedPointer<CarState> carState = mVehicleState.dynamicCast<CarState>();
+    if (!carState.isNull())
+        parameters = HybridAStarPlanner::getParametersForVehicle(*carState, mMovementController.isNull() ? parameters.footprint : mMovementController->getFootprint(),
+                                                                 parameters);
+
+    if (mLocalPlanner->isRunning()) {
+        mHasPendingGoto = true;
+        mPendingGotoProblem = problem;
+        mPendingGotoParameters = parameters;
+        mLocalPlanner->cancel();
+        return true;
+    }
+    return mLocalPlanner->start(problem, parameters);
+}
+
+void MavsdkVehicleServer::localPlannerFinished(const HybridAStarPlanner::Result &result)
+{
+    if (mHasPendingGoto) { // result of a canceled plan
+        mHasPendingGoto = false;
+        mLocalPlanner->start(mPendingGotoProblem, mPendingGotoParameters);
+        return;
+    }
+
+    if (!result.isFound()) {
+        qDebug() << "WARNING: MavsdkVehicleServer found no route to goto position, planner status" << static_cast<int>(result.status)
+                 << "after" << result.expandedNodes << "expanded nodes.";
+        return;
+    }
+
+    qDebug() << "MavsdkVehicleServer: planned goto route with" << result.route.size() << "points, cost" << result.cost
+             << "(heuristic weight" << result.heuristicWeight << ").";
+    mWaypointFollower->clearRoute();
+    mWaypointFollower->addRoute(result.route);
+    emit startWaypointFollower(true);
+}
+
+void MavsdkVehicleServer::setRouteRecorder(QSharedPointer<RouteRecorder> routeRecorder)
+{
+    if (!mRouteRecorder.isNull())
+        disconnect(mRouteRecorder.get(), &RouteRecorder::routeRecorded, this, &MavsdkVehicleServer::routeRecorded);
+
+    mRouteRecorder = routeRecorder;
+    if (!mRouteRecorder.isNull())
+        connect(mRouteRecorder.get(), &RouteRecorder::routeRecorded, this, &MavsdkVehicleServer::routeRecorded);
+}
+
+bool MavsdkVehicleServer::recordRoute(bool start)
+{
+    if (mRouteRecorder.isNull() || mWaypointFollower.isNull()) {
+        qDebug() << "Warning: MavsdkVehicleServer got route recording request, but has no RouteRecorder or WaypointFollower.";
+        return false;
+    }
+
+    if (start)
+        mRouteRecorder->startRecording();
+    else if (mRouteRecorder->isRecording())
+        mRouteRecorder->stopRecording();
+    else
+        return false;
+    return true;
+}
+
+void MavsdkVehicleServer::routeRecorded(const QList<PosPoint> &route)
+{
+    if (route.size() < 2) {
+        qDebug() << "WARNING: MavsdkVehicleServer recorded route has less than two points, not used.";
+        return;
+    }
+
+    qDebug() << "MavsdkVehicleServer: using recorded route with" << route.size() << "points.";
+    mWaypointFollower->clearRoute();
+    mWaypointFollower->addRoute(route);
+    if (!mPersistentRouteStore.isNull())
+        mPersistentRouteStore->storeRoute(routeCodec::encodeRoute(route));
+}
+
+void MavsdkVehicleServer::geofenceUploadStalled()
+{
+    if (!mGeofenceUploadAssembler.isActive())
+        return;
+
+    if (++mGeofenceUploadMissingRequests > mavlinkRouteTransfer::MAX_MISSING_REQUESTS) {
+        qDebug() << "WARNING: MavsdkVehicleServer geofence upload" << mGeofenceUploadAssembler.getTransferId() << "stalled, dropped.";
+        mGeofenceUploadAssembler = mavlinkRouteTransfer::ChunkAssembler();
+        return;
+    }
+
+    sendRouteTransferAck(mGeofenceUploadAssembler.getTransferId(), mavlinkRouteTransfer::AckStatus::Missing, mGeofenceUploadAssembler.getMissingChunks());
+    mGeofenceUploadStallTimer.start(mavlinkRouteTransfer::RECEIVE_STALL_TIMEOUT_ms);
+}
+
+void MavsdkVehicleServer::routeBroadcastComplete(uint16_t transferId)
+{
+    const QByteArray encodedRoute = mRouteBroadcastAssembler.getData();
+    mRouteBroadcastAssembler = mavlinkRouteTransfer::ChunkAssembler();
+
+    QVector<pospoint_t> route;
+    if (routeCodec::getRouteHash(encodedRoute) != mRouteBroadcastHash || !routeCodec::decodeRoute(encodedRoute, route)) {
+        qDebug() << "WARNING: MavsdkVehicleServer got invalid route in broadcast.";
+        sendRouteTransferAck(transferId, mavlinkRouteTransfer::AckStatus::Failed, {}, mavlinkRouteTransfer::PacketType::BroadcastAck);
+        return;
+    }
+    if (mWaypointFollower.isNull()) {
+        qDebug() << "MavsdkVehicleServer: got route broadcast but no WaypointFollower is set to receive it.";
+        sendRouteTransferAck(transferId, mavlinkRouteTransfer::AckStatus::Failed, {}, mavlinkRouteTransfer::PacketType::BroadcastAck);
+        return;
+    }
+
+    mavlinkRouteTransfer::applyRouteTransform(mRouteBroadcastTransform, route);
+    qDebug() << "MavsdkVehicleServer: got new route with" << route.size() << "points in broadcast.";
+    mWaypointFollower->clearRoute();
+    mWaypointFollower->addRoutePOD(route);
+    mLastCompletedRouteBroadcastId = transferId;
+    sendRouteTransferAck(transferId, mavlinkRouteTransfer::AckStatus::Complete, {}, mavlinkRouteTransfer::PacketType::BroadcastAck);
+    if (!mPersistentRouteStore.isNull())
+        mPersistentRouteStore->storeRoute(routeCodec::encodeRoute(route));
+}
+
+void MavsdkVehicleServer::routeBroadcastStalled()
+{
+    if (!mRouteBroadcastAssembler.isActive())
+        return;
+
+    if (++mRouteBroadcastMissingRequests > mavlinkRouteTransfer::MAX_MISSING_REQUESTS) {
+        qDebug() << "WARNING: MavsdkVehicleServer route broadcast" << mRouteBroadcastAssembler.getTransferId() << "stalled, dropped.";
+        mRouteBroadcastAssembler = mavlinkRouteTransfer::ChunkAssembler();
+        return;
+    }
+
+    sendRouteTransferAck(mRouteBroadcastAssembler.getTransferId(), mavlinkRouteTransfer::AckStatus::Missing, mRouteBroadcastAssembler.getMissingChunks(),
+                         mavlinkRouteTransfer::PacketType::BroadcastAck);
+    mRouteBroadcastStallTimer.start(mavlinkRouteTransfer::RECEIVE_STALL_TIMEOUT_ms);
+}
+
+void MavsdkVehicleServer::sendRouteTransferAck(uint16_t transferId, mavlinkRouteTransfer::AckStatus status, const QVector<uint16_t> &missingChunks,
+                                               mavlinkRouteTransfer::PacketType type)
+{
+    mavlinkRouteTransfer::Packet ack;
+    ack.type = type;
+    ack.transferId = transferId;
+    ack.status = status;
+    ack.missingChunks = missingChunks;
+    sendRouteTransferPacket(ack);
+}
+
+bool MavsdkVehicleServer::sendRouteTransferPacket(const mavlinkRouteTransfer::Packet &packet)
+{
+    if (mMavlinkPassthrough == nullptr)
+        return false;
+
+    return mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+        mavlink_message_t mavV2ExtensionMsg;
+        mavlink_v2_extension_t mavV2Extension;
+        memset(&mavV2Extension, 0, sizeof(mavlink_v2_extension_t));
+
+        mavV2Extension.target_system = mMavlinkPassthrough->get_target_sysid();
+        mavV2Extension.target_component = mMavlinkPassthrough->get_target_compid();
+        mavlinkRouteTransfer::encodePacket(packet, mavV2Extension);
+
+        mavlink_address.system_id = mSystemId;
+        mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+
+        mavlink_msg_v2_extension_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavV2ExtensionMsg, &mavV2Extension);
+        return mavV2ExtensionMsg;
+    }) == mavsdk::MavlinkPassthrough::Result::Success;
+}
+
 void MavsdkVehicleServer::on_logSent(const QString& message, const quint8& severity)
 {
     struct logQueueItem {
@@ -675,6 +1548,9 @@ void MavsdkVehicleServer::on_logSent(const QString& message, const quint8& sever
 
     static QVector<logQueueItem> logQueue;
 
+    if (severity > mLogForwardingSeverity)
+        return;
+
     logQueueItem item;
 
     item.log = message;
@@ -715,15 +1591,17 @@ void MavsdkVehicleServer::on_logSent(const QString& message, const quint8& sever
                 statusText.id = 0;  // message can be omitted directly
 
             statusText.chunk_seq = chunkIndex;
-            if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-                mavlink_message_t mavLogMsg;
-                mavlink_address.system_id = mSystemId;
-                mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
-                mavlink_msg_statustext_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavLogMsg, &statusText);
-
-                return mavLogMsg;
-            }) != mavsdk::MavlinkPassthrough::Result::Success)
-                    qWarning() << "Could not send log (STATUSTEXT) via MAVLINK.";
+            mTxQueue.send(MavlinkTxQueue::Class::Log, [this, statusText]() {
+                if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+                    mavlink_message_t mavLogMsg;
+                    mavlink_address.system_id = mSystemId;
+                    mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+                    mavlink_msg_statustext_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavLogMsg, &statusText);
+
+                    return mavLogMsg;
+                }) != mavsdk::MavlinkPassthrough::Result::Success)
+                        qWarning() << "Could not send log (STATUSTEXT) via MAVLINK.";
+            });
         }
 
         if(idCounter == std::numeric_limits<typeof idCounter>::max())  // overflow avoidance
@@ -737,23 +1615,25 @@ void MavsdkVehicleServer::on_logSent(const QString& message, const quint8& sever
 
 void MavsdkVehicleServer::sendMissionAck(quint8 type)
 {
-    if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-        mavlink_mission_ack_t missionAck;
-        mavlink_message_t mavMissionAckMsg;
+    mTxQueue.send(MavlinkTxQueue::Class::Safety, [this, type]() {
+        if (mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+            mavlink_mission_ack_t missionAck;
+            mavlink_message_t mavMissionAckMsg;
 
-        missionAck.target_system = mMavlinkPassthrough->get_target_sysid();
-        missionAck.target_component = mMavlinkPassthrough->get_target_compid();
-        missionAck.type = type;
-        missionAck.mission_type = MAV_MISSION_TYPE_MISSION;
+            missionAck.target_system = mMavlinkPassthrough->get_target_sysid();
+            missionAck.target_component = mMavlinkPassthrough->get_target_compid();
+            missionAck.type = type;
+            missionAck.mission_type = MAV_MISSION_TYPE_MISSION;
 
-        mavlink_address.system_id = mSystemId;
-        mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
+            mavlink_address.system_id = mSystemId;
+            mavlink_address.component_id = MAV_COMP_ID_AUTOPILOT1;
 
-        mavlink_msg_mission_ack_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavMissionAckMsg, &missionAck);
+            mavlink_msg_mission_ack_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavMissionAckMsg, &missionAck);
 
-        return mavMissionAckMsg;
-    }) != mavsdk::MavlinkPassthrough::Result::Success)
-            qWarning() << "Could not send MISSION_ACK via MAVLINK.";
+            return mavMissionAckMsg;
+        }) != mavsdk::MavlinkPassthrough::Result::Success)
+                qWarning() << "Could not send MISSION_ACK via MAVLINK.";
+    });
 }
 
 void MavsdkVehicleServer::createMavsdkComponentForTrailer(const QHostAddress controlTowerAddress, const unsigned controlTowerPort, const QAbstractSocket::SocketType controlTowerSocketType)
@@ -816,14 +1696,14 @@ void MavsdkVehicleServer::createMavsdkComponentForTrailer(const QHostAddress con
     if (result == mavsdk::ConnectionResult::Success) {
         qDebug() << "Trailer component listening for MAVSDK connection.";
 
-        connect(&mPublishMavlinkTimer, &QTimer::timeout, [this](){
+        addTelemetryStream(MAVLINK_MSG_ID_NAMED_VALUE_FLOAT, [this](){
             if (mTrailerMavlinkPassthrough && mTrailerMavlinkPassthrough->queue_message(
                 [this](MavlinkAddress mavlink_address, uint8_t channel)->mavlink_message_t {
                     auto trailerState = mVehicleState->getTrailingVehicle();
                     mavlink_message_t trailerYawMsg;
                     mavlink_named_value_float_t trailerYaw;
 
-                    trailerYaw.time_boot_ms = QDateTime::currentMSecsSinceEpoch() - mMavsdkVehicleServerCreationTime.toMSecsSinceEpoch();
+                    trailerYaw.time_boot_ms = mavlinkTimesync::getTimeBoot_ms();
                     trailerYaw.value = trailerState->getPosition(PosType::fused).getYaw();
                     mavlink_address.system_id = mVehicleState->getId();
                     mavlink_address.component_id = mVehicleState->getTrailingVehicle()->getId();
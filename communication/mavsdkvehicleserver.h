@@ -19,6 +19,23 @@
 #include <mavsdk/plugins/telemetry_server/telemetry_server.h>
 #include <mavsdk/server_component.h>
 #include "communication/mavlinkparameterserver.h"
+#include "communication/mavlinkstreamscheduler.h"
+#include "communication/mavlinktxqueue.h"
+#include "communication/mavlinklinkmonitor.h"
+#include "communication/mavlinkroutetransfer.h"
+#include "communication/mavlinkconvoylink.h"
+#include "core/routecodec.h"
+#include "core/persistentroutestore.h"
+#include "core/latestvaluemailbox.h"
+#include "core/sensorhealthmonitor.h"
+#include "core/perfcounters.h"
+#include "core/commandlatencytrace.h"
+#include "core/startupprofile.h"
+#include "core/occupancygrid.h"
+#include "routeplanning/hybridastarplanner.h"
+#include "autopilot/routerecorder.h"
+#include <atomic>
+#include <limits>
 #include <mavsdk/plugins/mission_raw/mission_raw.h>
 
 class MavsdkVehicleServer : public VehicleServer
@@ -27,6 +44,7 @@ class MavsdkVehicleServer : public VehicleServer
 public:
     explicit MavsdkVehicleServer(QSharedPointer<VehicleState> vehicleState, const QHostAddress controlTowerAddress = QHostAddress("127.0.0.1"),
                                  const unsigned controlTowerPort = 14540, const QAbstractSocket::SocketType controlTowerSocketType = QAbstractSocket::UdpSocket); // NOTE: currently, only UDP supported in mavsdk on vehicle side
+    ~MavsdkVehicleServer();
     void setUbloxRover(QSharedPointer<UbloxRover> ubloxRover) override;
     void setWaypointFollower(QSharedPointer<WaypointFollower> waypointFollower) override;
     void setMovementController(QSharedPointer<MovementController> movementController) override;
@@ -37,10 +55,54 @@ public:
     void mavResult(const uint16_t command, MAV_RESULT result, MAV_COMPONENT compId);
     void on_logSent(const QString& message, const quint8& severity);
     void updateRawGpsAndGpsInfoFromUbx(const ubx_nav_pvt &pvt) override;
+    void setClock(Clock *clock) override; // heartbeat, link statistics, route upload timeouts and manual control
     void setMavsdkRawGpsAndGpsInfo(const mavsdk::TelemetryServer::RawGps &rawGps, const mavsdk::TelemetryServer::GpsInfo &gpsInfo);
 
     void provideParametersToParameterServer();
 
+    // Interval of a telemetry stream by MAVLink message id [us], 0: default, -1: disabled (same as MAV_CMD_SET_MESSAGE_INTERVAL)
+    bool setMessageInterval(uint32_t messageId, qint64 interval_us);
+    qint64 getMessageInterval(uint32_t messageId) const { return mStreamScheduler.getMessageInterval(messageId); }
+
+    // Adaptive throttling of non-critical streams to keep outgoing traffic below the budget [bytes/s], 0: disabled
+    void setAdaptiveTxBudget(int adaptiveTxBudget_Bps) { mAdaptiveTxBudget_Bps = adaptiveTxBudget_Bps; }
+    int getAdaptiveTxBudget() const { return mAdaptiveTxBudget_Bps; }
+    MavlinkLinkStatistics getLinkStatistics() const { return mLinkMonitor.getStatistics(); }
+
+    // Own outgoing messages are sent by priority (acknowledgements before telemetry before logs), rate-limited per class
+    void setTxRate(MavlinkTxQueue::Class txClass, double rate_Hz, int burst) { mTxQueue.setRate(txClass, rate_Hz, burst); }
+    MavlinkTxQueue::ClassStatistics getTxStatistics(MavlinkTxQueue::Class txClass) const { return mTxQueue.getStatistics(txClass); }
+
+    // Log messages are forwarded as STATUSTEXT up to this MAV_SEVERITY (lower is more severe), default: all
+    void setLogForwardingSeverity(int logForwardingSeverity) { mLogForwardingSeverity = logForwardingSeverity; }
+    int getLogForwardingSeverity() const { return mLogForwardingSeverity; }
+
+    // Convoy (see MavlinkConvoyLink): publishes the fused position to the other vehicles and feeds the predecessor's position
+    // (set by the station with MAV_CMD_DO_FOLLOW) to the FollowPoint. Requires a GNSS receiver for the ENU reference.
+    bool startConvoyLink(quint16 port = MavlinkConvoyLink::DEFAULT_PORT, const QHostAddress &group = QHostAddress("239.255.145.1"));
+    MavlinkConvoyLink &getConvoyLink() { return mConvoyLink; }
+
+    // Degraded sensors are published as bitmask (NAMED_VALUE_FLOAT "SNS_DEG") with the worst rate ratio ("SNS_MIN")
+    void setSensorHealthMonitor(QSharedPointer<SensorHealthMonitor> sensorHealthMonitor) { mSensorHealthMonitor = sensorHealthMonitor; }
+
+    // Routes from bulk transfers are stored, the station can then ask for a stored route instead of uploading it again.
+    // Used from the server's thread only.
+    void setPersistentRouteStore(QSharedPointer<PersistentRouteStore> persistentRouteStore) { mPersistentRouteStore = persistentRouteStore; }
+    QSharedPointer<PersistentRouteStore> getPersistentRouteStore() const { return mPersistentRouteStore; }
+
+    // Goto requests (MAV_CMD_DO_REPOSITION) are planned around the occupancy grid (optional) and the MovementController's geofence,
+    // the route replaces the WaypointFollower's route. The vehicle's turn radius and footprint replace those of the parameters.
+    // Requires a GNSS receiver for the ENU reference. A newer request cancels the one being planned.
+    void setLocalPlanner(QSharedPointer<HybridAStarPlanner> localPlanner, QSharedPointer<const OccupancyGrid> occupancyGrid = nullptr);
+    void setLocalPlannerParameters(const HybridAStarPlanner::Parameters &parameters) { mLocalPlannerParameters = parameters; }
+
+    // Teach and repeat: the station starts and stops recording (mavlinkRouteTransfer::RECORD_ROUTE_COMMAND), the recorded route
+    // replaces the WaypointFollower's route (without starting it) and is stored in the PersistentRouteStore
+    void setRouteRecorder(QSharedPointer<RouteRecorder> routeRecorder);
+
+signals:
+    void updatedLinkStatistics(const MavlinkLinkStatistics &linkStatistics);
+
 private:
     std::shared_ptr<mavsdk::Mavsdk> mMavsdk;
     std::shared_ptr<mavsdk::TelemetryServer> mTelemetryServer;
@@ -49,20 +111,118 @@ private:
     std::shared_ptr<mavsdk::ActionServer> mActionServer;
     std::shared_ptr<mavsdk::MissionRawServer> mMissionRawServer;
     std::shared_ptr<mavsdk::MavlinkPassthrough> mMavlinkPassthrough;
-    QTimer mPublishMavlinkTimer;
+    static constexpr qint64 DEFAULT_STREAM_INTERVAL_us = 100000;
+    MavlinkStreamScheduler mStreamScheduler;
+    MavlinkTxQueue mTxQueue; // own messages by priority, heartbeats and route transfer chunks (flow-controlled) bypass it
+    MavlinkLinkMonitor mLinkMonitor;
+    ClockTimer mLinkStatisticsTimer;
+    int mAdaptiveTxBudget_Bps = 0;
+    int mLogForwardingSeverity = MAV_SEVERITY_DEBUG;
+    static constexpr double MAX_RX_LOSS_RATIO = 0.05;
+    static constexpr double MAX_THROTTLE_FACTOR = 16.0;
+
+    MavlinkConvoyLink mConvoyLink;
+    ClockTimer mConvoyPublishTimer;
+    static constexpr int CONVOY_PUBLISH_INTERVAL_MS = 100;
+    double mConvoyGap_m = -1.0; // distance to predecessor, -1: none
+    QSharedPointer<SensorHealthMonitor> mSensorHealthMonitor;
+
+    // PerfCounters are published round-robin, a few per DEBUG_FLOAT_ARRAY stream tick
+    static constexpr int PERF_COUNTERS_PER_PUBLISH = 4;
+    QVector<PerfCounterSnapshot> mPublishedPerfCounters; // last published snapshot per counter ID
+    int mNextPerfCounter = 0;
+    void publishPerfCounters();
+    // Tagged commands (see CommandLatencyTrace), completed traces are sent back to the station. Also marks the first command (ST_COMMAND).
+    void traceCommandLatency(const mavlink_message_t &message);
+    void sendCommandLatencyTrace(const CommandLatencyTraceResult &trace);
+    void publishConvoyPosition();
+    void followConvoyPredecessor(const llh_t &llh, double yaw_degENU, qint64 timestamp_ns);
+
+    // Bulk route transfer (see mavlinkRouteTransfer), in addition to the mission protocol
+    mavlinkRouteTransfer::ChunkAssembler mRouteUploadAssembler;
+    ClockTimer mRouteUploadStallTimer;
+    int mRouteUploadMissingRequests = 0;
+    int mLastCompletedRouteUploadId = -1;
+    mavlinkRouteTransfer::ChunkSender mRouteDownloadSender;
+    // Geofences are uploaded the same way and handed to the MovementController, an empty one removes the geofence
+    mavlinkRouteTransfer::ChunkAssembler mGeofenceUploadAssembler;
+    ClockTimer mGeofenceUploadStallTimer;
+    int mGeofenceUploadMissingRequests = 0;
+    int mLastCompletedGeofenceUploadId = -1;
+    // Route broadcasts: chunks sent to all vehicles after a BroadcastRequest to us, the transformed route replaces ours
+    mavlinkRouteTransfer::ChunkAssembler mRouteBroadcastAssembler;
+    ClockTimer mRouteBroadcastStallTimer;
+    int mRouteBroadcastMissingRequests = 0;
+    int mLastCompletedRouteBroadcastId = -1;
+    quint64 mRouteBroadcastHash = 0;
+    mavlinkRouteTransfer::RouteTransform mRouteBroadcastTransform;
+    QSharedPointer<PersistentRouteStore> mPersistentRouteStore;
+    QSharedPointer<HybridAStarPlanner> mLocalPlanner;
+    QSharedPointer<const OccupancyGrid> mLocalPlannerOccupancyGrid;
+    HybridAStarPlanner::Parameters mLocalPlannerParameters;
+    bool mHasPendingGoto = false; // planned once the running plan is canceled
+    HybridAStarPlanner::Problem mPendingGotoProblem;
+    HybridAStarPlanner::Parameters mPendingGotoParameters;
+    bool planGoto(const llh_t &llh, double yaw_degNED); // NaN: any heading
+    void localPlannerFinished(const HybridAStarPlanner::Result &result);
+    QSharedPointer<RouteRecorder> mRouteRecorder;
+    bool recordRoute(bool start);
+    void routeRecorded(const QList<PosPoint> &route);
     std::shared_ptr<mavsdk::Mavsdk> mTrailerMavsdk;
+    // The trailer's component (its own MAVSDK instance) is created when the station is first seen, i.e., not during boot
+    bool mTrailerComponentPending = false;
+    QHostAddress mControlTowerAddress;
+    unsigned mControlTowerPort = 14540;
+    QAbstractSocket::SocketType mControlTowerSocketType = QAbstractSocket::UdpSocket;
+    std::atomic<bool> mFirstCommandReceived{false};
     std::shared_ptr<mavsdk::MavlinkPassthrough> mTrailerMavlinkPassthrough;
 
-    QDateTime mMavsdkVehicleServerCreationTime = QDateTime::currentDateTime();
     ParameterServer *mParameterServer;
 
     const unsigned mCountdown_ms = 2000;
 
     void heartbeatTimeout() override;
     void heartbeatReset() override;
-    PosPoint convertMissionItemToPosPoint(const mavsdk::MissionRawServer::MissionItem &item);
-    void handleManualControlMessage(mavlink_manual_control_t manualControl);
+    static void convertMissionItemToPOD(const mavsdk::MissionRawServer::MissionItem &item, pospoint_t &routePoint);
+    QVector<pospoint_t> mMissionUploadRoute; // reused for every upload, MAVSDK's mission callback thread
+
+    // Mission download (MAVSDK's receive thread): the route is encoded once per route version, item requests are lookups
+    void updateMissionDownloadItems();
+    QVector<mavlink_mission_item_int_t> mMissionDownloadItems;
+    quint64 mMissionDownloadRouteVersion = std::numeric_limits<quint64>::max();
+    // Manual control samples are taken from MAVSDK's receive thread and applied periodically: the output ramps linearly to the
+    // latest sample over one sample interval and holds it over dropped packets, the vehicle is stopped once no sample arrived for the hold time
+    struct ManualControlSample {
+        double throttle = 0.0; // [-1, 1]
+        double steering = 0.0; // [-1, 1]
+        qint64 received_us = 0;
+    };
+    static constexpr int MANUAL_CONTROL_APPLY_INTERVAL_MS = 20;
+    static constexpr qint64 MANUAL_CONTROL_HOLD_US = 500000;
+    static constexpr qint64 MANUAL_CONTROL_MAX_RAMP_US = 100000;
+    LatestValueMailbox<ManualControlSample> mManualControlMailbox;
+    std::atomic<bool> mManualControlActive{false};
+    ClockTimer mManualControlTimer;
+    ManualControlSample mManualControlTarget;
+    ManualControlSample mManualControlRampStart; // output when the latest sample was taken
+    ManualControlSample mManualControlOutput;
+    qint64 mManualControlRamp_us = 0;
+    void startManualControl();
+    void stopManualControl();
+    void applyManualControl();
+    void addTelemetryStream(uint32_t messageId, std::function<void()> publish, MavlinkStreamScheduler::Priority priority = MavlinkStreamScheduler::Priority::Normal);
     void sendMissionAck(quint8 type);
+    void sendMessageInterval(uint32_t messageId);
+    void updateLinkStatistics();
+    void handleRouteTransferPacket(const mavlinkRouteTransfer::Packet &packet);
+    bool sendRouteTransferPacket(const mavlinkRouteTransfer::Packet &packet);
+    void sendRouteTransferAck(uint16_t transferId, mavlinkRouteTransfer::AckStatus status, const QVector<uint16_t> &missingChunks = {},
+                              mavlinkRouteTransfer::PacketType type = mavlinkRouteTransfer::PacketType::Ack);
+    void applyRoutePatch(uint16_t transferId, const QByteArray &routePatch);
+    void routeUploadStalled();
+    void geofenceUploadStalled();
+    void routeBroadcastComplete(uint16_t transferId);
+    void routeBroadcastStalled();
     double mManualControlMaxSpeed = 2.0; // [m/s]
     quint8 mSystemId = 1;
     void createMavsdkComponentForTrailer(const QHostAddress controlTowerAddress, const unsigned controlTowerPort, const QAbstractSocket::SocketType controlTowerSocketType);
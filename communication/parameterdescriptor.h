@@ -0,0 +1,40 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Compile-time description of a ParameterServer parameter: name (checked against the MAVLink length limit at compile
+ * time) and type. Owners declare their parameters as constants, e.g.,
+ *     static constexpr ParameterDescriptor<float> PP_RADIUS{"PP_RADIUS"};
+ * and provide them with direct storage (std::atomic or getter/setter members, see ParameterServer::provideParameter),
+ * which returns a ParameterId for O(1) access without name lookups.
+ */
+
+#ifndef PARAMETERDESCRIPTOR_H
+#define PARAMETERDESCRIPTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+using ParameterId = int; // dense, in the order parameters were provided
+static constexpr ParameterId INVALID_PARAMETER_ID = -1;
+
+enum class ParameterType {Int, Float};
+
+template<typename T>
+struct ParameterDescriptor
+{
+    static_assert(std::is_same<T, int32_t>::value || std::is_same<T, float>::value, "Parameters are int32_t or float");
+    static constexpr std::size_t MAX_NAME_LENGTH = 16; // MAVLink param_id
+    static constexpr ParameterType type = std::is_same<T, float>::value ? ParameterType::Float : ParameterType::Int;
+
+    template<std::size_t N>
+    constexpr ParameterDescriptor(const char (&parameterName)[N]) : name(parameterName), nameLength(N - 1) {
+        static_assert(N - 1 <= MAX_NAME_LENGTH, "Parameter names must be no more than 16 ASCII characters");
+    }
+
+    const char *name;
+    std::size_t nameLength;
+};
+
+#endif // PARAMETERDESCRIPTOR_H
@@ -4,13 +4,19 @@
  */
 #include <QDebug>
 #include "parameterserver.h"
+#include "core/threadconfig.h"
 #include <QXmlStreamWriter>
-#include <QFile>
+#include <QSaveFile>
 
 ParameterServer* ParameterServer::mInstancePtr = nullptr;
 
 ParameterServer::ParameterServer() {};
 
+ParameterServer::~ParameterServer()
+{
+    stopSaveThread();
+}
+
 void ParameterServer::initialize()
 {
     if(mInstancePtr)
@@ -28,50 +34,188 @@ ParameterServer* ParameterServer::getInstance()
 
 bool ParameterServer::updateIntParameter(std::string parameterName, int parameterValue)
 {
-    const std::lock_guard<std::mutex> lock(mMutex);
-    auto search = mIntParameterToClassMapping.find(parameterName);
+    quint64 version;
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        const ParameterId id = findParameter(parameterName, ParameterType::Int);
+        if (id == INVALID_PARAMETER_ID)
+            return false;
 
-    if (search != mIntParameterToClassMapping.end()) {
-        std::function<void(int)> setParameterFunction = search->second.first;
-        setParameterFunction(parameterValue);
-        return true;
-    } else
-        return false;
+        mParameters[id].set(mParameters[id].object, parameterValue);
+        version = markChanged({id});
+    }
+    notifyChanged({parameterName}, version);
+    return true;
 }
 
 bool ParameterServer::updateFloatParameter(std::string parameterName, float parameterValue)
 {
-    const std::lock_guard<std::mutex> lock(mMutex);
-    auto search = mFloatParameterToClassMapping.find(parameterName);
+    quint64 version;
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        const ParameterId id = findParameter(parameterName, ParameterType::Float);
+        if (id == INVALID_PARAMETER_ID)
+            return false;
 
-    if (search != mFloatParameterToClassMapping.end()) {
-        std::function<void(float)> setParameterFunction = search->second.first;
-        setParameterFunction(parameterValue);
-        return true;
-    } else
-        return false;
+        mParameters[id].set(mParameters[id].object, parameterValue);
+        version = markChanged({id});
+    }
+    notifyChanged({parameterName}, version);
+    return true;
 }
 
 void ParameterServer::provideIntParameter(std::string parameterName, std::function<void(int)> setClassParameterFunction, std::function<int(void)> getClassParameterFunction)
 {
-    const std::lock_guard<std::mutex> lock(mMutex);
-    mIntParameterToClassMapping.insert_or_assign(parameterName, std::make_pair(setClassParameterFunction, getClassParameterFunction));
+    using Functions = std::pair<std::function<void(int)>, std::function<int(void)>>;
+    auto functions = std::make_shared<Functions>(setClassParameterFunction, getClassParameterFunction);
+    provideParameter(parameterName, ParameterType::Int, functions.get(),
+                     [](void *object, double value) { static_cast<Functions*>(object)->first(int(value)); },
+                     [](void *object) { return double(static_cast<Functions*>(object)->second()); }, functions);
 };
 
 void ParameterServer::provideFloatParameter(std::string parameterName, std::function<void(float)> setClassParameterFunction, std::function<float(void)> getClassParameterFunction)
 {
-    const std::lock_guard<std::mutex> lock(mMutex);
-    mFloatParameterToClassMapping.insert_or_assign(parameterName, std::make_pair(setClassParameterFunction, getClassParameterFunction));
+    using Functions = std::pair<std::function<void(float)>, std::function<float(void)>>;
+    auto functions = std::make_shared<Functions>(setClassParameterFunction, getClassParameterFunction);
+    provideParameter(parameterName, ParameterType::Float, functions.get(),
+                     [](void *object, double value) { static_cast<Functions*>(object)->first(float(value)); },
+                     [](void *object) { return double(static_cast<Functions*>(object)->second()); }, functions);
 };
 
-void ParameterServer::saveParametersToXmlFile(QString filename)
+ParameterId ParameterServer::provideParameter(const std::string &parameterName, ParameterType type, void *object,
+                                              void (*set)(void *, double), double (*get)(void *), std::shared_ptr<void> functions)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    if (parameterName.size() > ParameterDescriptor<float>::MAX_NAME_LENGTH)
+        qDebug() << "Warning: parameter name" << QString::fromStdString(parameterName) << "is longer than" << ParameterDescriptor<float>::MAX_NAME_LENGTH << "characters";
+
+    ParameterId id;
+    auto search = mParameterIds.find(parameterName);
+    if (search != mParameterIds.end()) {
+        id = search->second;
+    } else {
+        id = ParameterId(mParameters.size());
+        mParameters.push_back({parameterName, type, nullptr, nullptr, nullptr, nullptr});
+        mParameterIds.emplace(parameterName, id);
+    }
+
+    Parameter &parameter = mParameters[id];
+    parameter.type = type;
+    parameter.object = object;
+    parameter.set = set;
+    parameter.get = get;
+    parameter.functions = functions;
+    markChanged({id});
+    parameterProvided(parameter);
+    return id;
+}
+
+ParameterId ParameterServer::findParameter(const std::string &parameterName, ParameterType type) const
+{
+    auto search = mParameterIds.find(parameterName);
+    if (search == mParameterIds.end() || mParameters[search->second].type != type)
+        return INVALID_PARAMETER_ID;
+    return search->second;
+}
+
+ParameterId ParameterServer::getParameterId(const std::string &parameterName)
 {
     const std::lock_guard<std::mutex> lock(mMutex);
-    QFile parameterFile(filename);
+    auto search = mParameterIds.find(parameterName);
+    return (search == mParameterIds.end()) ? INVALID_PARAMETER_ID : search->second;
+}
+
+std::vector<std::string> ParameterServer::getParameterNames()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<std::string> parameterNames;
+    parameterNames.reserve(mParameters.size());
+    for (const auto& parameter : mParameters)
+        parameterNames.push_back(parameter.name);
+    return parameterNames;
+}
+
+bool ParameterServer::getParameterType(ParameterId id, ParameterType &type)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    if (id < 0 || id >= ParameterId(mParameters.size()))
+        return false;
+    type = mParameters[id].type;
+    return true;
+}
+
+bool ParameterServer::updateParameter(ParameterId id, double parameterValue)
+{
+    std::string parameterName;
+    quint64 version;
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        if (id < 0 || id >= ParameterId(mParameters.size()))
+            return false;
+
+        Parameter &parameter = mParameters[id];
+        parameter.set(parameter.object, parameterValue);
+        parameterName = parameter.name;
+        version = markChanged({id});
+    }
+    notifyChanged({parameterName}, version);
+    return true;
+}
+
+bool ParameterServer::getParameter(ParameterId id, double &parameterValue)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    if (id < 0 || id >= ParameterId(mParameters.size()))
+        return false;
+    parameterValue = mParameters[id].get(mParameters[id].object);
+    return true;
+}
+
+void ParameterServer::appendParameter(AllParameters &parameters, const Parameter &parameter)
+{
+    if (parameter.type == ParameterType::Int)
+        parameters.intParameters.push_back({parameter.name, int32_t(parameter.get(parameter.object))});
+    else
+        parameters.floatParameters.push_back({parameter.name, float(parameter.get(parameter.object))});
+}
+
+void ParameterServer::saveParametersToXmlFile(QString filename)
+{
+    writeParametersToXmlFile(filename, getParametersToSave());
+}
+
+void ParameterServer::scheduleSaveParametersToXmlFile(QString filename, unsigned delay_ms)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mSaveMutex);
+        if (!mPendingSaveFilename.isEmpty() && mPendingSaveFilename != filename)
+            qDebug() << "Warning: parameter save to" << mPendingSaveFilename << "replaced by save to" << filename;
+        mPendingSaveFilename = filename;
+        mPendingSaveTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms);
+
+        if (!mSaveThreadRunning) {
+            mSaveThreadRunning = true;
+            mStopSaveThread = false;
+            mSaveThread = std::thread(&ParameterServer::saveLoop, this);
+        }
+    }
+    mSaveCondition.notify_one();
+}
+
+void ParameterServer::setAutoSaveXmlFile(QString filename, unsigned delay_ms)
+{
+    const std::lock_guard<std::mutex> lock(mSaveMutex);
+    mAutoSaveFilename = filename;
+    mAutoSaveDelay_ms = delay_ms;
+}
+
+bool ParameterServer::writeParametersToXmlFile(const QString &filename, const AllParameters &parameters)
+{
+    QSaveFile parameterFile(filename);
 
     if (!parameterFile.open(QIODevice::WriteOnly)) {
         qDebug() << "Failed to open file, could not save parameters";
-        return;
+        return false;
     }
 
     QXmlStreamWriter stream(&parameterFile);
@@ -79,40 +223,169 @@ void ParameterServer::saveParametersToXmlFile(QString filename)
     stream.setAutoFormatting(true);
     stream.writeStartDocument();
 
-    for (const auto& parameter : mIntParameterToClassMapping) {
-        std::string parameterName = parameter.first;
-        int parameterValue = parameter.second.second();
-        stream.writeTextElement(QString::fromStdString(parameterName), QString::number(parameterValue));
+    for (const auto& parameter : parameters.intParameters)
+        stream.writeTextElement(QString::fromStdString(parameter.name), QString::number(parameter.value));
+    for (const auto& parameter : parameters.floatParameters)
+        stream.writeTextElement(QString::fromStdString(parameter.name), QString::number(parameter.value));
+    for (const auto& parameter : parameters.customParameters)
+        stream.writeTextElement(QString::fromStdString(parameter.name), QString::fromStdString(parameter.value));
+
+    stream.writeEndElement();
+    stream.writeEndDocument();
+
+    if (stream.hasError() || !parameterFile.commit()) {
+        qDebug() << "Failed to write file, could not save parameters";
+        return false;
     }
+    return true;
+}
 
-    for (const auto& parameter : mFloatParameterToClassMapping) {
-        std::string parameterName = parameter.first;
-        float parameterValue = parameter.second.second();
-        stream.writeTextElement(QString::fromStdString(parameterName), QString::number(parameterValue));
+void ParameterServer::stopSaveThread()
+{
+    {
+        const std::lock_guard<std::mutex> lock(mSaveMutex);
+        if (!mSaveThreadRunning)
+            return;
+        mStopSaveThread = true;
     }
+    mSaveCondition.notify_one();
+    if (mSaveThread.joinable())
+        mSaveThread.join();
 
-    stream.writeEndElement();
-    stream.writeEndDocument();
-    parameterFile.close();
-};
+    const std::lock_guard<std::mutex> lock(mSaveMutex);
+    mSaveThreadRunning = false;
+}
+
+void ParameterServer::saveLoop()
+{
+    ThreadConfig::getInstance().applyToCurrentThread(ThreadConfig::Role::Logging);
+    for (;;) {
+        QString filename;
+        {
+            std::unique_lock<std::mutex> lock(mSaveMutex);
+            mSaveCondition.wait(lock, [this]() { return mStopSaveThread || !mPendingSaveFilename.isEmpty(); });
+            // Saves scheduled in the meantime move the deadline
+            while (!mStopSaveThread && !mPendingSaveFilename.isEmpty()
+                   && mSaveCondition.wait_until(lock, mPendingSaveTime) != std::cv_status::timeout);
+
+            if (mPendingSaveFilename.isEmpty()) {
+                if (mStopSaveThread)
+                    break;
+                continue;
+            }
+            filename = mPendingSaveFilename;
+            mPendingSaveFilename.clear();
+        }
+
+        // Latest values, taken now rather than when the save was scheduled
+        writeParametersToXmlFile(filename, getParametersToSave());
+    }
+}
 
 ParameterServer::AllParameters ParameterServer::getAllParameters()
 {
-    ParameterServer::IntParameter intParameter;
-    ParameterServer::FloatParameter floatParameter;
+    const std::lock_guard<std::mutex> lock(mMutex);
     ParameterServer::AllParameters allParameters;
 
-    for (const auto& parameter : mIntParameterToClassMapping) {
-        intParameter.name = parameter.first;
-        intParameter.value = parameter.second.second();
-        allParameters.intParameters.push_back(intParameter);
+    for (const auto& parameter : mParameters)
+        appendParameter(allParameters, parameter);
+
+    return allParameters;
+}
+
+bool ParameterServer::updateParameters(const AllParameters &parameters)
+{
+    std::vector<std::string> changedParameterNames;
+    quint64 version;
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        if (!parameters.customParameters.empty())
+            return false;
+
+        std::vector<ParameterId> changedParameterIds;
+        for (const auto& parameter : parameters.intParameters)
+            changedParameterIds.push_back(findParameter(parameter.name, ParameterType::Int));
+        for (const auto& parameter : parameters.floatParameters)
+            changedParameterIds.push_back(findParameter(parameter.name, ParameterType::Float));
+        for (const auto& id : changedParameterIds)
+            if (id == INVALID_PARAMETER_ID)
+                return false;
+
+        size_t i = 0;
+        for (const auto& parameter : parameters.intParameters) {
+            Parameter &changedParameter = mParameters[changedParameterIds[i++]];
+            changedParameter.set(changedParameter.object, parameter.value);
+            changedParameterNames.push_back(parameter.name);
+        }
+        for (const auto& parameter : parameters.floatParameters) {
+            Parameter &changedParameter = mParameters[changedParameterIds[i++]];
+            changedParameter.set(changedParameter.object, parameter.value);
+            changedParameterNames.push_back(parameter.name);
+        }
+        if (changedParameterNames.empty())
+            return true;
+        version = markChanged(changedParameterIds);
     }
+    notifyChanged(changedParameterNames, version);
+    return true;
+}
+
+ParameterServer::AllParameters ParameterServer::getParameters(const std::vector<std::string> &parameterNames)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    ParameterServer::AllParameters parameters;
 
-    for (const auto& parameter : mFloatParameterToClassMapping) {
-        floatParameter.name = parameter.first;
-        floatParameter.value = parameter.second.second();
-        allParameters.floatParameters.push_back(floatParameter);
+    for (const auto& parameterName : parameterNames) {
+        auto search = mParameterIds.find(parameterName);
+        if (search != mParameterIds.end())
+            appendParameter(parameters, mParameters[search->second]);
     }
 
-    return allParameters;
+    return parameters;
+}
+
+quint64 ParameterServer::getVersion()
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    return mVersion;
+}
+
+ParameterServer::AllParameters ParameterServer::getParametersChangedSince(quint64 version, quint64 *currentVersion)
+{
+    const std::lock_guard<std::mutex> lock(mMutex);
+    ParameterServer::AllParameters parameters;
+
+    for (const auto& parameter : mParameters)
+        if (parameter.version > version)
+            appendParameter(parameters, parameter);
+
+    if (currentVersion)
+        *currentVersion = mVersion;
+    return parameters;
+}
+
+quint64 ParameterServer::markChanged(const std::vector<ParameterId> &parameterIds)
+{
+    mVersion++;
+    for (const auto& id : parameterIds)
+        mParameters[id].version = mVersion;
+    return mVersion;
+}
+
+void ParameterServer::notifyChanged(const std::vector<std::string> &parameterNames, quint64 version)
+{
+    QStringList changedParameterNames;
+    for (const auto& parameterName : parameterNames)
+        changedParameterNames.append(QString::fromStdString(parameterName));
+    emit parametersChanged(changedParameterNames, version);
+
+    QString autoSaveFilename;
+    unsigned autoSaveDelay_ms;
+    {
+        const std::lock_guard<std::mutex> lock(mSaveMutex);
+        autoSaveFilename = mAutoSaveFilename;
+        autoSaveDelay_ms = mAutoSaveDelay_ms;
+    }
+    if (!autoSaveFilename.isEmpty())
+        scheduleSaveParametersToXmlFile(autoSaveFilename, autoSaveDelay_ms);
 }
@@ -1,15 +1,33 @@
 /*
  *     Copyright 2023 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Maps parameter names to the storage of the classes that own them: std::atomic values, getter/setter members
+ * (called directly, see provideParameter) or, through the string-based provide functions, std::function pairs.
+ * Parameters get dense ids in the order they are provided, id-based access is O(1) without name lookups and
+ * getParameterNames() is the id-ordered name table (e.g., for MAVLink param_index). The store is versioned: every change made
+ * through the server (update, batch update, newly provided parameter) increments the version and records it for the
+ * parameter, so that clients can fetch only what changed since the version they have seen and/or subscribe to parametersChanged().
+ * Changes made directly through the owning classes are not tracked.
+ * Parameters are saved from a snapshot taken under the lock and written to a temporary file that replaces the target,
+ * i.e., the file is never partially written. Scheduled saves are written by a background thread and coalesced:
+ * changes within the save delay result in a single write of the latest values.
  */
 
 #ifndef PARAMETERSERVER_H
 #define PARAMETERSERVER_H
 
 #include <QObject>
+#include <QStringList>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <functional>
+#include <memory>
+#include <atomic>
+#include "communication/parameterdescriptor.h"
 
 class ParameterServer : public QObject
 {
@@ -33,22 +51,103 @@ public:
         std::vector<CustomParameter> customParameters{};
     };
 
+    static constexpr unsigned DEFAULT_SAVE_DELAY_ms = 500;
+
     static void initialize();
     static ParameterServer* getInstance();
     bool updateIntParameter(std::string parameterName, int parameterValue);
     bool updateFloatParameter(std::string parameterName, float parameterValue);
-    virtual void provideIntParameter(std::string parameterName, std::function<void(int)> setClassParameterFunction, std::function<int(void)> getClassParameterFunction);
-    virtual void provideFloatParameter(std::string parameterName, std::function<void(float)> setClassParameterFunction, std::function<float(void)> getClassParameterFunction);
-    virtual void saveParametersToXmlFile(QString filename);
+    void provideIntParameter(std::string parameterName, std::function<void(int)> setClassParameterFunction, std::function<int(void)> getClassParameterFunction);
+    void provideFloatParameter(std::string parameterName, std::function<void(float)> setClassParameterFunction, std::function<float(void)> getClassParameterFunction);
+
+    // Typed parameters, providing a name again replaces its storage and keeps the id
+    template<typename T>
+    ParameterId provideParameter(const ParameterDescriptor<T> &descriptor, std::atomic<T> *storage) {
+        static_assert(std::atomic<T>::is_always_lock_free, "Parameter storage is read from other threads");
+        return provideParameter(descriptor.name, descriptor.type, storage,
+                                [](void *object, double value) { static_cast<std::atomic<T>*>(object)->store(T(value)); },
+                                [](void *object) { return double(static_cast<std::atomic<T>*>(object)->load()); });
+    }
+    // e.g., provideParameter<&Class::setValue, &Class::getValue>(VALUE, this)
+    template<auto Setter, auto Getter, typename Class, typename T>
+    ParameterId provideParameter(const ParameterDescriptor<T> &descriptor, Class *object) {
+        return provideParameter(descriptor.name, descriptor.type, object,
+                                [](void *object, double value) { (static_cast<Class*>(object)->*Setter)(T(value)); },
+                                [](void *object) { return double(T((static_cast<Class*>(object)->*Getter)())); });
+    }
+
+    ParameterId getParameterId(const std::string &parameterName); // INVALID_PARAMETER_ID if unknown
+    std::vector<std::string> getParameterNames(); // indexed by id
+    bool getParameterType(ParameterId id, ParameterType &type);
+    // Int parameters are converted exactly
+    bool updateParameter(ParameterId id, double parameterValue);
+    bool getParameter(ParameterId id, double &parameterValue);
+
+    void saveParametersToXmlFile(QString filename); // synchronous
+    // Saves in the background after delay_ms, a save scheduled before that is replaced (written once, with the latest values)
+    void scheduleSaveParametersToXmlFile(QString filename, unsigned delay_ms = DEFAULT_SAVE_DELAY_ms);
+    // Schedules a save on every change made through the server, empty filename: stop
+    void setAutoSaveXmlFile(QString filename, unsigned delay_ms = DEFAULT_SAVE_DELAY_ms);
     AllParameters getAllParameters();
 
+    // Batches, under a single lock. Updates are all-or-nothing: nothing is set if any parameter is unknown (custom parameters are not supported).
+    bool updateParameters(const AllParameters &parameters);
+    AllParameters getParameters(const std::vector<std::string> &parameterNames); // unknown names are skipped
+
+    quint64 getVersion();
+    // Parameters changed after version, currentVersion (optional) receives the version the result corresponds to
+    AllParameters getParametersChangedSince(quint64 version, quint64 *currentVersion = nullptr);
+
+signals:
+    void parametersChanged(const QStringList &parameterNames, quint64 version); // can be emitted from any thread
+
 protected:
     ParameterServer();
-    virtual ~ParameterServer(){};
+    virtual ~ParameterServer();
     static ParameterServer *mInstancePtr;
     std::mutex mMutex;
-    std::unordered_map<std::string, std::pair<std::function<void(int)>, std::function<int(void)>>> mIntParameterToClassMapping;
-    std::unordered_map<std::string, std::pair<std::function<void(float)>, std::function<float(void)>>> mFloatParameterToClassMapping;
+
+    struct Parameter {
+        std::string name;
+        ParameterType type;
+        void *object; // storage or owner, passed to set/get
+        void (*set)(void *object, double value);
+        double (*get)(void *object);
+        std::shared_ptr<void> functions; // owns object when provided through std::function
+        quint64 version = 0;
+    };
+    std::vector<Parameter> mParameters; // indexed by id
+    std::unordered_map<std::string, ParameterId> mParameterIds;
+
+    ParameterId provideParameter(const std::string &parameterName, ParameterType type, void *object,
+                                 void (*set)(void *, double), double (*get)(void *), std::shared_ptr<void> functions = nullptr);
+    // Called with mMutex held after a parameter was provided, e.g., to announce it
+    virtual void parameterProvided(const Parameter &parameter) { Q_UNUSED(parameter) }
+    ParameterId findParameter(const std::string &parameterName, ParameterType type) const; // requires mMutex
+    static void appendParameter(AllParameters &parameters, const Parameter &parameter);
+
+    quint64 markChanged(const std::vector<ParameterId> &parameterIds); // requires mMutex, returns new version
+    void notifyChanged(const std::vector<std::string> &parameterNames, quint64 version); // call without holding mMutex
+    quint64 mVersion = 0;
+
+    // Values to be saved, called without holding mMutex (possibly from the save thread)
+    virtual AllParameters getParametersToSave() { return getAllParameters(); }
+    static bool writeParametersToXmlFile(const QString &filename, const AllParameters &parameters);
+    void stopSaveThread(); // writes a pending save before returning, call from the destructor of derived classes
+
+private:
+    void saveLoop();
+
+    std::thread mSaveThread;
+    std::mutex mSaveMutex;
+    std::condition_variable mSaveCondition;
+    // protected by mSaveMutex
+    bool mSaveThreadRunning = false;
+    bool mStopSaveThread = false;
+    QString mPendingSaveFilename; // empty: none
+    std::chrono::steady_clock::time_point mPendingSaveTime;
+    QString mAutoSaveFilename;
+    unsigned mAutoSaveDelay_ms = DEFAULT_SAVE_DELAY_ms;
 };
 
 #endif // PARAMETERSERVER_H
@@ -0,0 +1,77 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "sharedmemorytransport.h"
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool SharedMemorySegment::create(const std::string &name)
+{
+    close();
+
+    shm_unlink(name.c_str()); // left over by a server that did not shut down cleanly
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+    if (fd < 0)
+        return false;
+
+    void *memory = MAP_FAILED;
+    if (ftruncate(fd, sizeof(sharedMemoryTransport::Layout)) == 0)
+        memory = mmap(nullptr, sizeof(sharedMemoryTransport::Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    mLayout = new (memory) sharedMemoryTransport::Layout();
+    mLayout->magic.store(sharedMemoryTransport::MAGIC, std::memory_order_release);
+    mName = name;
+    mOwner = true;
+    return true;
+}
+
+bool SharedMemorySegment::attach(const std::string &name)
+{
+    close();
+
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat status;
+    void *memory = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && status.st_size == (off_t)sizeof(sharedMemoryTransport::Layout))
+        memory = mmap(nullptr, sizeof(sharedMemoryTransport::Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+        return false;
+
+    sharedMemoryTransport::Layout *layout = static_cast<sharedMemoryTransport::Layout*>(memory);
+    if (layout->magic.load(std::memory_order_acquire) != sharedMemoryTransport::MAGIC || layout->version != sharedMemoryTransport::VERSION) {
+        munmap(memory, sizeof(sharedMemoryTransport::Layout));
+        return false;
+    }
+
+    mLayout = layout;
+    mName = name;
+    mOwner = false;
+    return true;
+}
+
+void SharedMemorySegment::close()
+{
+    if (!mLayout)
+        return;
+
+    if (mOwner) {
+        mLayout->magic.store(0, std::memory_order_release);
+        shm_unlink(mName.c_str());
+    }
+    munmap(mLayout, sizeof(sharedMemoryTransport::Layout));
+    mLayout = nullptr;
+    mOwner = false;
+}
@@ -0,0 +1,154 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Shared-memory transport between co-located processes on the vehicle (e.g., WayWise next to ROS 2 or a perception process),
+ * without serialization or socket hops. A POSIX shared-memory segment holds fixed-layout records: the vehicle state in a
+ * sequence lock (readers never block the publisher) and a lock-free bounded queue of commands (any number of writing processes,
+ * WayWise consumes). Does not depend on Qt, clients can use these files on their own:
+ *
+ *     SharedMemorySegment segment;
+ *     if (segment.attach("/waywise_vehicle_1")) {
+ *         const sharedMemoryTransport::StateRecord state = segment.layout()->state.load();
+ *         sharedMemoryTransport::CommandRecord command = sharedMemoryTransport::makeCommand(sharedMemoryTransport::CommandType::SpeedAndSteering);
+ *         command.speedAndSteering = {1.0, 0.1};
+ *         sharedMemoryTransport::sendCommand(*segment.layout(), command);
+ *     }
+ *
+ * Timestamps are std::chrono::steady_clock (CLOCK_MONOTONIC on Linux), i.e., comparable between processes.
+ * A process that dies while writing a command blocks the queue from that entry on, the server then has to be restarted.
+ */
+
+#ifndef SHAREDMEMORYTRANSPORT_H
+#define SHAREDMEMORYTRANSPORT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "core/seqlock.h"
+#include "core/mpscringbuffer.h"
+
+namespace sharedMemoryTransport {
+
+static constexpr uint32_t MAGIC = 0x57575348; // "WWSH"
+static constexpr uint32_t VERSION = 1; // changes with the layout
+static constexpr size_t COMMAND_QUEUE_CAPACITY = 256;
+
+// Published by WayWise, ENU frame of the vehicle
+struct StateRecord {
+    int64_t timestamp_ns = 0;
+    uint32_t sequence = 0; // incremented per publish
+    int32_t vehicleId = 0;
+    double x_m = 0.0; // fused position
+    double y_m = 0.0;
+    double height_m = 0.0;
+    double yaw_deg = 0.0;
+    double vx_ms = 0.0;
+    double vy_ms = 0.0;
+    double vz_ms = 0.0;
+    double speed_ms = 0.0;
+    double steering = 0.0; // [-1.0, 1.0]
+    double autopilotTargetX_m = 0.0;
+    double autopilotTargetY_m = 0.0;
+    uint8_t flightMode = 0; // VehicleState::FlightMode
+    uint8_t isArmed = 0;
+    uint8_t waypointFollowerActive = 0;
+};
+
+enum class CommandType : uint32_t {
+    Heartbeat, // every command counts as heartbeat, the vehicle stops without any for VehicleServer's countdown
+    SpeedAndSteering, // switches to manual mode
+    ClearRoute,
+    AddWaypoint, // appended to the current route
+    StartRoute, // switches to mission mode
+    PauseRoute,
+    ResetRoute
+};
+
+struct Waypoint {
+    double x_m;
+    double y_m;
+    double height_m;
+    double yaw_deg;
+    double speed_ms;
+    uint32_t attributes;
+};
+
+struct CommandRecord {
+    CommandType type;
+    int64_t timestamp_ns; // sender's, for latency statistics
+    union {
+        struct {
+            double speed_ms;
+            double steering; // [-1.0, 1.0]
+        } speedAndSteering;
+        Waypoint waypoint;
+        bool fromBeginning; // StartRoute
+    };
+};
+
+struct Layout {
+    std::atomic<uint32_t> magic{0}; // set by the server once the layout is initialized
+    uint32_t version = VERSION;
+    std::atomic<int64_t> serverAlive_ns{0}; // updated with every state publish, clients can detect a stopped server
+    std::atomic<uint64_t> droppedCommands{0}; // commands that did not fit into the queue
+    SeqLock<StateRecord> state;
+    MpscRingBuffer<CommandRecord, COMMAND_QUEUE_CAPACITY> commands;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free &&
+              std::atomic<uint32_t>::is_always_lock_free && std::atomic<size_t>::is_always_lock_free,
+              "shared-memory transport requires address-free (lock-free) atomics");
+
+inline int64_t getMonotonicTime_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline CommandRecord makeCommand(CommandType type)
+{
+    CommandRecord command {};
+    command.type = type;
+    command.timestamp_ns = getMonotonicTime_ns();
+    return command;
+}
+
+// Any process, returns false (and counts a dropped command) if the queue is full
+inline bool sendCommand(Layout &layout, const CommandRecord &command)
+{
+    if (layout.commands.tryPush([&command](CommandRecord &entry) { entry = command; }))
+        return true;
+
+    layout.droppedCommands.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+}
+
+// Maps a POSIX shared-memory segment (name like "/waywise_vehicle_1") holding a sharedMemoryTransport::Layout
+class SharedMemorySegment
+{
+public:
+    SharedMemorySegment() = default;
+    SharedMemorySegment(const SharedMemorySegment &) = delete;
+    SharedMemorySegment &operator=(const SharedMemorySegment &) = delete;
+    ~SharedMemorySegment() { close(); }
+
+    // Server: replaces a (stale) segment of the same name, the segment is removed again on close()
+    bool create(const std::string &name);
+    // Client: fails unless the segment was initialized by a server with the same layout version
+    bool attach(const std::string &name);
+    void close();
+
+    bool isOpen() const { return mLayout != nullptr; }
+    const std::string &getName() const { return mName; }
+    sharedMemoryTransport::Layout *layout() const { return mLayout; }
+
+private:
+    std::string mName;
+    sharedMemoryTransport::Layout *mLayout = nullptr;
+    bool mOwner = false;
+};
+
+#endif // SHAREDMEMORYTRANSPORT_H
@@ -0,0 +1,234 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "sharedmemoryvehicleserver.h"
+#include <QDebug>
+#include <algorithm>
+
+SharedMemoryVehicleServer::SharedMemoryVehicleServer(QSharedPointer<VehicleState> vehicleState, const QString &segmentName) :
+    VehicleServer(vehicleState)
+{
+    const QString name = segmentName.isEmpty() ? QString("/waywise_vehicle_%1").arg(mVehicleState->getId()) : segmentName;
+    if (mSegment.create(name.toStdString()))
+        qDebug() << "SharedMemoryVehicleServer: serving vehicle" << mVehicleState->getId() << "on shared-memory segment" << name;
+    else
+        qDebug() << "WARNING: SharedMemoryVehicleServer could not create shared-memory segment" << name;
+
+    // Safety heartbeat
+    mHeartbeat = false;
+    mHeartbeatTimer.setSingleShot(true);
+    connect(&mHeartbeatTimer, &ClockTimer::timeout, this, &SharedMemoryVehicleServer::heartbeatTimeout);
+    connect(this, &SharedMemoryVehicleServer::resetHeartbeat, this, &SharedMemoryVehicleServer::heartbeatReset);
+
+    mUpdateTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mUpdateTimer, &ClockTimer::timeout, this, &SharedMemoryVehicleServer::update);
+    if (mSegment.isOpen())
+        mUpdateTimer.start(DEFAULT_UPDATE_INTERVAL_MS);
+}
+
+void SharedMemoryVehicleServer::setUbloxRover(QSharedPointer<UbloxRover> ubloxRover)
+{
+    VehicleServer::setGNSSReceiver(ubloxRover);
+}
+
+void SharedMemoryVehicleServer::setWaypointFollower(QSharedPointer<WaypointFollower> waypointFollower)
+{
+    mWaypointFollower = waypointFollower;
+    connect(this, &SharedMemoryVehicleServer::startWaypointFollower, mWaypointFollower.get(), &WaypointFollower::startFollowingRoute);
+    connect(this, &SharedMemoryVehicleServer::pauseWaypointFollower, mWaypointFollower.get(), &WaypointFollower::stop);
+    connect(this, &SharedMemoryVehicleServer::resetWaypointFollower, mWaypointFollower.get(), &WaypointFollower::resetState);
+    connect(this, &SharedMemoryVehicleServer::clearRouteOnWaypointFollower, mWaypointFollower.get(), &WaypointFollower::clearRoute);
+}
+
+void SharedMemoryVehicleServer::setMovementController(QSharedPointer<MovementController> movementController)
+{
+    mMovementController = movementController;
+}
+
+void SharedMemoryVehicleServer::setManualControlMaxSpeed(double manualControlMaxSpeed_ms)
+{
+    mManualControlMaxSpeed = manualControlMaxSpeed_ms;
+}
+
+void SharedMemoryVehicleServer::setFollowPoint(QSharedPointer<FollowPoint> followPoint)
+{
+    mFollowPoint = followPoint;
+    connect(this, &SharedMemoryVehicleServer::startFollowPoint, mFollowPoint.get(), &FollowPoint::startFollowPoint);
+    connect(this, &SharedMemoryVehicleServer::stopFollowPoint, mFollowPoint.get(), &FollowPoint::stopFollowPoint);
+}
+
+double SharedMemoryVehicleServer::getManualControlMaxSpeed() const
+{
+    return mManualControlMaxSpeed;
+}
+
+void SharedMemoryVehicleServer::sendGpsOriginLlh(const llh_t &gpsOriginLlh)
+{
+    Q_UNUSED(gpsOriginLlh)
+    // Not part of the shared state, local processes use the ENU frame
+}
+
+void SharedMemoryVehicleServer::updateRawGpsAndGpsInfoFromUbx(const ubx_nav_pvt &pvt)
+{
+    Q_UNUSED(pvt)
+    // Not implemented
+}
+
+void SharedMemoryVehicleServer::setClock(Clock *clock)
+{
+    VehicleServer::setClock(clock);
+    mUpdateTimer.setClock(clock);
+}
+
+void SharedMemoryVehicleServer::setUpdateInterval(int updateInterval_ms)
+{
+    mUpdateTimer.setInterval(std::max(updateInterval_ms, 1));
+}
+
+void SharedMemoryVehicleServer::update()
+{
+    processCommands();
+    publishState();
+}
+
+void SharedMemoryVehicleServer::publishState()
+{
+    const pospoint_t position = mVehicleState->getPositionPOD(PosType::fused);
+    const ObjectState::Velocity velocity = mVehicleState->getVelocity();
+    const QPointF autopilotTargetPoint = mVehicleState->getAutopilotTargetPoint();
+
+    sharedMemoryTransport::StateRecord state;
+    state.timestamp_ns = sharedMemoryTransport::getMonotonicTime_ns();
+    state.sequence = ++mStateSequence;
+    state.vehicleId = mVehicleState->getId();
+    state.x_m = position.x;
+    state.y_m = position.y;
+    state.height_m = position.height;
+    state.yaw_deg = position.yaw;
+    state.vx_ms = velocity.x;
+    state.vy_ms = velocity.y;
+    state.vz_ms = velocity.z;
+    state.speed_ms = mVehicleState->getSpeed();
+    state.steering = mVehicleState->getSteering();
+    state.autopilotTargetX_m = autopilotTargetPoint.x();
+    state.autopilotTargetY_m = autopilotTargetPoint.y();
+    state.flightMode = static_cast<uint8_t>(mVehicleState->getFlightMode());
+    state.isArmed = mVehicleState->getIsArmed();
+    state.waypointFollowerActive = !mWaypointFollower.isNull() && mWaypointFollower->isActive();
+
+    sharedMemoryTransport::Layout *layout = mSegment.layout();
+    layout->state.store(state);
+    layout->serverAlive_ns.store(state.timestamp_ns, std::memory_order_release);
+}
+
+void SharedMemoryVehicleServer::processCommands()
+{
+    sharedMemoryTransport::Layout *layout = mSegment.layout();
+
+    // Bounded by the queue's size, i.e., commands written meanwhile wait for the next update
+    for (size_t i = 0; i < sharedMemoryTransport::COMMAND_QUEUE_CAPACITY; i++) {
+        sharedMemoryTransport::CommandRecord command;
+        if (!layout->commands.tryPop([&command](const sharedMemoryTransport::CommandRecord &entry) { command = entry; }))
+            break;
+
+        if (!mHeartbeat)
+            qDebug() << "SharedMemoryVehicleServer: got command, heartbeat timeout was reset.";
+        emit resetHeartbeat();
+
+        const double latency_us = (sharedMemoryTransport::getMonotonicTime_ns() - command.timestamp_ns) / 1000.0;
+        mCommandStatistics.commands++;
+        mCommandStatistics.lastLatency_us = latency_us;
+        mCommandStatistics.maxLatency_us = std::max(mCommandStatistics.maxLatency_us, latency_us);
+        mCommandStatistics.meanLatency_us += (latency_us - mCommandStatistics.meanLatency_us) / mCommandStatistics.commands;
+
+        handleCommand(command);
+    }
+    appendPendingWaypoints();
+    mCommandStatistics.droppedCommands = layout->droppedCommands.load(std::memory_order_relaxed);
+}
+
+void SharedMemoryVehicleServer::handleCommand(const sharedMemoryTransport::CommandRecord &command)
+{
+    using sharedMemoryTransport::CommandType;
+
+    if (command.type != CommandType::AddWaypoint)
+        appendPendingWaypoints(); // keep the order of route commands
+
+    switch (command.type) {
+    case CommandType::Heartbeat:
+        break;
+    case CommandType::SpeedAndSteering:
+        if (mMovementController.isNull()) {
+            qDebug() << "Warning: SharedMemoryVehicleServer got speed and steering command, but has no MovementController to talk to.";
+            break;
+        }
+        mVehicleState->setFlightMode(VehicleState::FlightMode::Manual);
+        if (!mWaypointFollower.isNull() && mWaypointFollower->isActive()) {
+            qDebug() << "SharedMemoryVehicleServer: WaypointFollower stopped by speed and steering command.";
+            mWaypointFollower->stop();
+        }
+        mMovementController->setDesiredSpeed(std::clamp(command.speedAndSteering.speed_ms, -mManualControlMaxSpeed, mManualControlMaxSpeed));
+        mMovementController->setDesiredSteering(std::clamp(command.speedAndSteering.steering, -1.0, 1.0));
+        break;
+    case CommandType::ClearRoute:
+        emit clearRouteOnWaypointFollower();
+        break;
+    case CommandType::AddWaypoint: {
+        pospoint_t point;
+        point.x = command.waypoint.x_m;
+        point.y = command.waypoint.y_m;
+        point.height = command.waypoint.height_m;
+        point.yaw = command.waypoint.yaw_deg;
+        point.speed = command.waypoint.speed_ms;
+        point.attributes = command.waypoint.attributes;
+        point.timestamp_ns = utcTime::now_ns();
+        mPendingWaypoints.append(point);
+        break;
+    }
+    case CommandType::StartRoute:
+        mVehicleState->setFlightMode(VehicleState::FlightMode::Mission);
+        emit startWaypointFollower(command.fromBeginning);
+        break;
+    case CommandType::PauseRoute:
+        emit pauseWaypointFollower();
+        break;
+    case CommandType::ResetRoute:
+        emit resetWaypointFollower();
+        break;
+    default:
+        qDebug() << "WARNING: SharedMemoryVehicleServer got unknown command type" << static_cast<uint32_t>(command.type);
+    }
+}
+
+void SharedMemoryVehicleServer::appendPendingWaypoints()
+{
+    if (mPendingWaypoints.isEmpty())
+        return;
+
+    if (!mWaypointFollower.isNull())
+        mWaypointFollower->appendRoute(mPendingWaypoints);
+    else
+        qDebug() << "SharedMemoryVehicleServer: got waypoints but no WaypointFollower is set to receive them.";
+    mPendingWaypoints.clear();
+}
+
+void SharedMemoryVehicleServer::heartbeatTimeout()
+{
+    mHeartbeat = false;
+    qDebug() << "SharedMemoryVehicleServer: heartbeat timed out";
+
+    if (mWaypointFollower)
+        mWaypointFollower->stop();
+
+    if (mMovementController) {
+        mMovementController->setDesiredSteering(0.0);
+        mMovementController->setDesiredSpeed(0.0);
+    }
+}
+
+void SharedMemoryVehicleServer::heartbeatReset()
+{
+    mHeartbeatTimer.start(mCountdown_ms);
+    mHeartbeat = true;
+}
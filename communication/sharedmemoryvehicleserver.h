@@ -0,0 +1,70 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * VehicleServer for processes on the same computer, e.g., WayWiseR/ROS 2 or perception next to WayWise, via a shared-memory
+ * segment (see sharedMemoryTransport). The vehicle state is published and commands are taken from the queue periodically
+ * (update interval, default 5 ms), clients read the state and write commands without any system call.
+ */
+
+#ifndef SHAREDMEMORYVEHICLESERVER_H
+#define SHAREDMEMORYVEHICLESERVER_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "communication/vehicleserver.h"
+#include "communication/sharedmemorytransport.h"
+
+struct SharedMemoryCommandStatistics {
+    quint64 commands = 0;
+    quint64 droppedCommands = 0; // queue was full
+    double lastLatency_us = 0.0; // from the sender's timestamp to being applied
+    double meanLatency_us = 0.0;
+    double maxLatency_us = 0.0;
+};
+
+class SharedMemoryVehicleServer : public VehicleServer
+{
+    Q_OBJECT
+public:
+    // Default name: "/waywise_vehicle_<id>"
+    explicit SharedMemoryVehicleServer(QSharedPointer<VehicleState> vehicleState, const QString &segmentName = QString());
+    void setUbloxRover(QSharedPointer<UbloxRover> ubloxRover) override;
+    void setWaypointFollower(QSharedPointer<WaypointFollower> waypointFollower) override;
+    void setMovementController(QSharedPointer<MovementController> movementController) override;
+    void setManualControlMaxSpeed(double manualControlMaxSpeed_ms) override;
+    void setFollowPoint(QSharedPointer<FollowPoint> followPoint) override;
+    double getManualControlMaxSpeed() const override;
+    void sendGpsOriginLlh(const llh_t &gpsOriginLlh) override;
+    void updateRawGpsAndGpsInfoFromUbx(const ubx_nav_pvt &pvt) override;
+    void setClock(Clock *clock) override;
+
+    bool isOpen() const { return mSegment.isOpen(); }
+    QString getSegmentName() const { return QString::fromStdString(mSegment.getName()); }
+
+    void setUpdateInterval(int updateInterval_ms);
+    int getUpdateInterval() const { return mUpdateTimer.interval(); }
+
+    SharedMemoryCommandStatistics getCommandStatistics() const { return mCommandStatistics; }
+
+private:
+    static constexpr int DEFAULT_UPDATE_INTERVAL_MS = 5;
+
+    void update();
+    void publishState();
+    void processCommands();
+    void handleCommand(const sharedMemoryTransport::CommandRecord &command);
+    void appendPendingWaypoints();
+    void heartbeatTimeout() override;
+    void heartbeatReset() override;
+
+    SharedMemorySegment mSegment;
+    ClockTimer mUpdateTimer;
+    uint32_t mStateSequence = 0;
+    QVector<pospoint_t> mPendingWaypoints; // consecutive AddWaypoint commands are appended at once
+    SharedMemoryCommandStatistics mCommandStatistics;
+};
+
+#endif // SHAREDMEMORYVEHICLESERVER_H
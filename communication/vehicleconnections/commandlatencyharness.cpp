@@ -0,0 +1,174 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "commandlatencyharness.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+QString CommandLatencyReport::getCsvHeader()
+{
+    return "command,injected,traced,completed,stage,samples,mean_ms,p50_ms,p90_ms,p99_ms,max_ms";
+}
+
+QString CommandLatencyReport::toCsv() const
+{
+    static const char *commandNames[] = {"manual_control", "velocity_and_yaw", "route_start"};
+
+    QString csv;
+    for (const CommandLatencyStageStatistics &stage : stages)
+        csv += QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10,%11\n").arg(commandNames[int(command)]).arg(injected).arg(traced).arg(completed)
+                .arg(stage.name).arg(stage.samples).arg(stage.mean_ms, 0, 'f', 3).arg(stage.p50_ms, 0, 'f', 3)
+                .arg(stage.p90_ms, 0, 'f', 3).arg(stage.p99_ms, 0, 'f', 3).arg(stage.max_ms, 0, 'f', 3);
+    return csv;
+}
+
+CommandLatencyHarness::CommandLatencyHarness(QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<CommandLatencyReport>();
+
+    mInjectTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mInjectTimer, &QTimer::timeout, this, &CommandLatencyHarness::inject);
+    mSettleTimer.setSingleShot(true);
+    connect(&mSettleTimer, &QTimer::timeout, this, &CommandLatencyHarness::finishRun);
+    mPauseTimer.setSingleShot(true);
+    connect(&mPauseTimer, &QTimer::timeout, this, [this]() {
+        if (mVehicleConnection)
+            mVehicleConnection->pauseAutopilotOnVehicle();
+    });
+}
+
+bool CommandLatencyHarness::start(QSharedPointer<MavsdkVehicleConnection> vehicleConnection, const CommandLatencyHarnessConfig &config)
+{
+    stop();
+    if (!vehicleConnection || config.count <= 0 || config.rate_Hz <= 0.0)
+        return false;
+
+    mVehicleConnection = vehicleConnection;
+    mConfig = config;
+    mInjected = 0;
+    mTraces.clear();
+    // Queued: traces arrive in MAVSDK threads
+    mTraceConnection = connect(mVehicleConnection.get(), &MavsdkVehicleConnection::gotCommandLatencyTrace, this, &CommandLatencyHarness::gotTrace, Qt::QueuedConnection);
+
+    if (!mVehicleConnection->getClockSync().synchronized)
+        qWarning() << "WARNING: CommandLatencyHarness: vehicle clock not synchronized, the link stage is not measured";
+
+    if (mConfig.command == CommandLatencyCommand::ManualControl)
+        mVehicleConnection->requestManualControl();
+
+    mInjectTimer.start(std::max(1, int(std::lround(1000.0 / mConfig.rate_Hz))));
+    return true;
+}
+
+void CommandLatencyHarness::stop()
+{
+    mInjectTimer.stop();
+    mSettleTimer.stop();
+    mPauseTimer.stop();
+    disconnectVehicle();
+}
+
+void CommandLatencyHarness::disconnectVehicle()
+{
+    disconnect(mTraceConnection);
+    if (mVehicleConnection && mConfig.command == CommandLatencyCommand::ManualControl)
+        mVehicleConnection->setManualControl(0, 0, 0, 0, 0);
+    mVehicleConnection.reset();
+}
+
+void CommandLatencyHarness::inject()
+{
+    if (mInjected >= mConfig.count) {
+        mInjectTimer.stop();
+        mSettleTimer.start(mConfig.settleTime_ms);
+        return;
+    }
+
+    const quint16 tag = mNextTag++;
+    const double sign = (mInjected % 2 == 0) ? 1.0 : -1.0; // every command differs from the previous one
+    mTraces.insert(tag, CommandLatencyTraceResult());
+    mInjected++;
+
+    // The tag directly before the command, both queued on the same link
+    if (!mVehicleConnection->sendCommandLatencyTag(tag, quint8(mConfig.command)))
+        return;
+
+    switch (mConfig.command) {
+    case CommandLatencyCommand::ManualControl:
+        mVehicleConnection->setManualControl(mConfig.throttle, 0, 0, sign * mConfig.steeringAmplitude, 0);
+        break;
+    case CommandLatencyCommand::VelocityAndYaw:
+        mVehicleConnection->requestVelocityAndYaw({0, 0, 0}, sign * mConfig.yawAmplitude_deg);
+        break;
+    case CommandLatencyCommand::RouteStart:
+        mVehicleConnection->startAutopilotOnVehicle();
+        mPauseTimer.start(mInjectTimer.interval() / 2); // untagged, the trace is complete before
+        break;
+    }
+}
+
+void CommandLatencyHarness::gotTrace(const CommandLatencyTraceResult &trace)
+{
+    auto tracedCommand = mTraces.find(trace.tag);
+    if (tracedCommand != mTraces.end() && trace.command == quint8(mConfig.command))
+        tracedCommand.value() = trace;
+}
+
+void CommandLatencyHarness::finishRun()
+{
+    static const char *stageNames[CommandLatencyTraceResult::NUM_STAGES] = {"E2E", "LINK", "CTRL", "ACT"};
+
+    CommandLatencyReport report;
+    report.command = mConfig.command;
+    report.injected = mInjected;
+
+    QVector<QVector<double>> latencies_ms(CommandLatencyTraceResult::NUM_STAGES);
+    for (const CommandLatencyTraceResult &trace : mTraces) {
+        if (std::none_of(trace.stage_ns.begin(), trace.stage_ns.end(), [](qint64 stage_ns) { return stage_ns >= 0; }))
+            continue;
+        report.traced++;
+        if (trace.isComplete())
+            report.completed++;
+
+        for (int i = 1; i < CommandLatencyTraceResult::NUM_STAGES; i++)
+            if (trace.getStageLatency_ms(i) >= 0.0)
+                latencies_ms[i].append(trace.getStageLatency_ms(i));
+        if (trace.getEndToEnd_ms() >= 0.0)
+            latencies_ms[0].append(trace.getEndToEnd_ms());
+    }
+
+    for (int i = 1; i < CommandLatencyTraceResult::NUM_STAGES; i++)
+        report.stages.append(getStatistics(stageNames[i], latencies_ms[i]));
+    report.stages.append(getStatistics(stageNames[0], latencies_ms[0]));
+
+    disconnectVehicle();
+    emit finished(report);
+}
+
+CommandLatencyStageStatistics CommandLatencyHarness::getStatistics(const QString &name, QVector<double> latencies_ms)
+{
+    CommandLatencyStageStatistics statistics;
+    statistics.name = name;
+    statistics.samples = latencies_ms.size();
+    if (latencies_ms.isEmpty())
+        return statistics;
+
+    // Exact (nearest rank), runs are short
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    const auto percentile = [&latencies_ms](double p) {
+        const int rank = int(std::ceil(p * latencies_ms.size()));
+        return latencies_ms.at(std::max(0, rank - 1));
+    };
+    double sum_ms = 0.0;
+    for (double latency_ms : latencies_ms)
+        sum_ms += latency_ms;
+
+    statistics.mean_ms = sum_ms / latencies_ms.size();
+    statistics.p50_ms = percentile(0.5);
+    statistics.p90_ms = percentile(0.9);
+    statistics.p99_ms = percentile(0.99);
+    statistics.max_ms = latencies_ms.last();
+    return statistics;
+}
@@ -0,0 +1,90 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Measures the end-to-end latency of control station commands: injects tagged commands at a fixed rate through a
+ * MavsdkVehicleConnection (the calls ControlTower uses) and collects the vehicle's traces (see CommandLatencyTrace), i.e.,
+ * the link (issued to MavsdkVehicleServer), controller (to MovementController) and actuator (to motor/servo or CANopen output)
+ * stages. The same run applies to simulated and real vehicles. The link stage needs clock synchronization (TIMESYNC).
+ */
+
+#ifndef COMMANDLATENCYHARNESS_H
+#define COMMANDLATENCYHARNESS_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+#include <QMap>
+#include "mavsdkvehicleconnection.h"
+
+enum class CommandLatencyCommand : quint8 {
+    ManualControl, // MANUAL_CONTROL, steering alternates (in manual mode)
+    VelocityAndYaw, // offboard velocity and yaw, yaw alternates
+    RouteStart // starts the autopilot on its current route, it is paused again in between
+};
+
+struct CommandLatencyHarnessConfig {
+    CommandLatencyCommand command = CommandLatencyCommand::ManualControl;
+    int count = 100;
+    double rate_Hz = 5.0; // tagged commands, one trace is open at a time on the vehicle
+    double steeringAmplitude = 0.3; // ManualControl [-1, 1], changes above MavsdkVehicleConnection's immediate delta are sent at once
+    double throttle = 0.0; // ManualControl [-1, 1]
+    double yawAmplitude_deg = 10.0; // VelocityAndYaw
+    int settleTime_ms = 2000; // after the last command, for its trace to arrive
+};
+
+struct CommandLatencyStageStatistics {
+    QString name;
+    int samples = 0;
+    double mean_ms = -1.0;
+    double p50_ms = -1.0;
+    double p90_ms = -1.0;
+    double p99_ms = -1.0;
+    double max_ms = -1.0;
+};
+
+struct CommandLatencyReport {
+    CommandLatencyCommand command = CommandLatencyCommand::ManualControl;
+    int injected = 0;
+    int traced = 0; // traces received
+    int completed = 0; // reached the actuator
+    QVector<CommandLatencyStageStatistics> stages; // LINK, CTRL, ACT, E2E
+
+    static QString getCsvHeader();
+    QString toCsv() const; // one line per stage
+};
+Q_DECLARE_METATYPE(CommandLatencyReport)
+
+class CommandLatencyHarness : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CommandLatencyHarness(QObject *parent = nullptr);
+
+    bool start(QSharedPointer<MavsdkVehicleConnection> vehicleConnection, const CommandLatencyHarnessConfig &config = CommandLatencyHarnessConfig());
+    void stop(); // without report
+    bool isRunning() const { return mInjectTimer.isActive() || mSettleTimer.isActive(); }
+
+signals:
+    void finished(const CommandLatencyReport &report);
+
+private:
+    void inject();
+    void gotTrace(const CommandLatencyTraceResult &trace);
+    void finishRun();
+    void disconnectVehicle();
+    static CommandLatencyStageStatistics getStatistics(const QString &name, QVector<double> latencies_ms);
+
+    QSharedPointer<MavsdkVehicleConnection> mVehicleConnection;
+    QMetaObject::Connection mTraceConnection;
+    CommandLatencyHarnessConfig mConfig;
+    QTimer mInjectTimer;
+    QTimer mSettleTimer;
+    QTimer mPauseTimer; // RouteStart
+    quint16 mNextTag = 1;
+    int mInjected = 0;
+    QMap<quint16, CommandLatencyTraceResult> mTraces; // by tag of this run, default (no stage) until received
+};
+
+#endif // COMMANDLATENCYHARNESS_H
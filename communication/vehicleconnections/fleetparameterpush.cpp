@@ -0,0 +1,223 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "fleetparameterpush.h"
+#include <QPointer>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+// mirror: nullptr if unknown, all parameters are changed then
+template<typename Parameter>
+void appendChanged(std::vector<Parameter> &changed, const std::vector<Parameter> &parameters, const std::vector<Parameter> *mirror, int &skipped)
+{
+    for (const Parameter &parameter : parameters) {
+        if (mirror) {
+            const auto mirrored = std::find_if(mirror->begin(), mirror->end(), [&parameter](const Parameter &m) { return m.name == parameter.name; });
+            if (mirrored != mirror->end() && mirrored->value == parameter.value) {
+                skipped++;
+                continue;
+            }
+        }
+        changed.push_back(parameter);
+    }
+}
+
+template<typename Batches, typename Parameter>
+void appendToBatches(Batches &batches, const std::vector<Parameter> &parameters, std::vector<Parameter> ParameterServer::AllParameters::*member, int batchSize)
+{
+    for (const Parameter &parameter : parameters) {
+        if (batches.isEmpty() || batches.last().size >= batchSize)
+            batches.append(typename Batches::value_type());
+        (batches.last().parameters.*member).push_back(parameter);
+        batches.last().size++;
+    }
+}
+}
+
+bool FleetParameterPush::start(const QList<QSharedPointer<VehicleConnection>> &vehicleConnections, const ParameterServer::AllParameters &parameters)
+{
+    if (mRunning)
+        return false;
+
+    mVehicles.clear();
+    mReport = FleetParameterPushReport();
+    for (const auto &vehicleConnection : vehicleConnections) {
+        if (vehicleConnection.isNull())
+            continue;
+        VehiclePush vehicle;
+        vehicle.vehicleConnection = vehicleConnection;
+        mVehicles.append(vehicle);
+        FleetParameterPushVehicleResult result;
+        result.vehicleId = vehicleConnection->getVehicleState()->getId();
+        mReport.vehicles.append(result);
+    }
+    if (mVehicles.isEmpty())
+        return false;
+
+    mPushId++;
+    mParameters = parameters;
+    mFinishedVehicles = 0;
+    mRunning = true;
+    mTimer.start();
+    schedulePump();
+    return true;
+}
+
+void FleetParameterPush::abort()
+{
+    if (mRunning)
+        finish(true);
+}
+
+void FleetParameterPush::startVehicle(int index)
+{
+    VehiclePush &vehicle = mVehicles[index];
+    vehicle.started = true;
+    vehicle.timer.start();
+
+    ParameterServer::AllParameters mirror;
+    const bool hasMirror = mConfig.skipUnchanged && vehicle.vehicleConnection->getCachedParametersFromVehicle(mirror);
+    ParameterServer::AllParameters changed;
+    int skipped = 0;
+    appendChanged(changed.intParameters, mParameters.intParameters, hasMirror ? &mirror.intParameters : nullptr, skipped);
+    appendChanged(changed.floatParameters, mParameters.floatParameters, hasMirror ? &mirror.floatParameters : nullptr, skipped);
+    appendChanged(changed.customParameters, mParameters.customParameters, hasMirror ? &mirror.customParameters : nullptr, skipped);
+
+    const int batchSize = std::max(1, mConfig.batchSize);
+    appendToBatches(vehicle.pendingBatches, changed.intParameters, &ParameterServer::AllParameters::intParameters, batchSize);
+    appendToBatches(vehicle.pendingBatches, changed.floatParameters, &ParameterServer::AllParameters::floatParameters, batchSize);
+    appendToBatches(vehicle.pendingBatches, changed.customParameters, &ParameterServer::AllParameters::customParameters, batchSize);
+    vehicle.parameterCount = int(changed.intParameters.size() + changed.floatParameters.size() + changed.customParameters.size());
+    mReport.vehicles[index].parametersSkipped = skipped;
+}
+
+void FleetParameterPush::sendBatch(int index)
+{
+    VehiclePush &vehicle = mVehicles[index];
+    const Batch batch = vehicle.pendingBatches.takeFirst();
+    vehicle.inFlight++;
+
+    // The connection may call back right away (blocking default implementation) or after we are gone
+    QPointer<FleetParameterPush> self(this);
+    const quint64 pushId = mPushId;
+    vehicle.vehicleConnection->setParametersOnVehicleAsync(batch.parameters, [self, pushId, index, batch](VehicleConnection::Result result) {
+        if (self && self->mPushId == pushId)
+            self->batchFinished(index, batch, result);
+    });
+}
+
+void FleetParameterPush::batchFinished(int index, const Batch &batch, VehicleConnection::Result result)
+{
+    VehiclePush &vehicle = mVehicles[index];
+    FleetParameterPushVehicleResult &vehicleResult = mReport.vehicles[index];
+    vehicle.inFlight--;
+
+    if (result == VehicleConnection::Result::Success) {
+        vehicleResult.parametersSet += batch.size;
+    } else if (isRetryable(result) && batch.attempts < mConfig.maxRetries && !vehicle.failed) {
+        Batch retry = batch;
+        retry.attempts++;
+        vehicle.retriesWaiting++;
+        vehicleResult.retries++;
+        QTimer::singleShot(std::max(0, mConfig.retryDelay_ms), this, [this, pushId = mPushId, index, retry]() {
+            if (pushId != mPushId)
+                return;
+            mVehicles[index].retriesWaiting--;
+            mVehicles[index].pendingBatches.prepend(retry);
+            schedulePump();
+        });
+    } else {
+        vehicle.failed = true;
+        vehicleResult.result = result;
+    }
+    schedulePump();
+}
+
+void FleetParameterPush::finishVehicle(int index)
+{
+    VehiclePush &vehicle = mVehicles[index];
+    FleetParameterPushVehicleResult &vehicleResult = mReport.vehicles[index];
+    vehicle.finished = true;
+    if (!vehicle.failed)
+        vehicleResult.result = VehicleConnection::Result::Success;
+    vehicleResult.parametersFailed = vehicle.parameterCount - vehicleResult.parametersSet;
+    vehicleResult.duration_ms = vehicle.timer.nsecsElapsed() / 1e6;
+    mFinishedVehicles++;
+    emit progress(mFinishedVehicles, mVehicles.size());
+}
+
+void FleetParameterPush::schedulePump()
+{
+    if (mPumpScheduled)
+        return;
+
+    mPumpScheduled = true;
+    QMetaObject::invokeMethod(this, [this]() { pump(); }, Qt::QueuedConnection);
+}
+
+void FleetParameterPush::pump()
+{
+    mPumpScheduled = false;
+    if (!mRunning)
+        return;
+
+    int activeVehicles = int(std::count_if(mVehicles.begin(), mVehicles.end(), [](const VehiclePush &vehicle) { return vehicle.started && !vehicle.finished; }));
+    const int maxInFlight = std::max(1, mConfig.maxInFlightPerVehicle);
+    // Signal handlers may abort or start another push
+    const quint64 pushId = mPushId;
+    for (int i = 0; i < mVehicles.size() && mPushId == pushId; i++) {
+        if (mVehicles.at(i).finished)
+            continue;
+        if (!mVehicles.at(i).started) {
+            if (mConfig.maxConcurrentVehicles > 0 && activeVehicles >= mConfig.maxConcurrentVehicles)
+                continue;
+            startVehicle(i);
+            activeVehicles++;
+        }
+
+        while (!mVehicles.at(i).failed && mVehicles.at(i).retriesWaiting == 0 && !mVehicles.at(i).pendingBatches.isEmpty() &&
+               mVehicles.at(i).inFlight < maxInFlight)
+            sendBatch(i);
+
+        const VehiclePush &vehicle = mVehicles.at(i);
+        if (vehicle.inFlight == 0 && vehicle.retriesWaiting == 0 && (vehicle.failed || vehicle.pendingBatches.isEmpty())) {
+            finishVehicle(i);
+            activeVehicles--;
+        }
+    }
+
+    if (mPushId == pushId && mFinishedVehicles == mVehicles.size())
+        finish(false);
+}
+
+void FleetParameterPush::finish(bool aborted)
+{
+    const int parameterCount = int(mParameters.intParameters.size() + mParameters.floatParameters.size() + mParameters.customParameters.size());
+    for (int i = 0; i < mVehicles.size(); i++) {
+        FleetParameterPushVehicleResult &vehicleResult = mReport.vehicles[i];
+        if (!mVehicles.at(i).finished) {
+            vehicleResult.parametersFailed = mVehicles.at(i).started ? mVehicles.at(i).parameterCount - vehicleResult.parametersSet : parameterCount;
+            vehicleResult.duration_ms = mVehicles.at(i).started ? mVehicles.at(i).timer.nsecsElapsed() / 1e6 : 0.0;
+        }
+        if (mVehicles.at(i).finished && vehicleResult.result == VehicleConnection::Result::Success)
+            mReport.succeededVehicles++;
+        else
+            mReport.failedVehicles++;
+    }
+    mReport.aborted = aborted;
+    mReport.duration_ms = mTimer.nsecsElapsed() / 1e6;
+
+    mPushId++;
+    mRunning = false;
+    mVehicles.clear();
+    emit finished(mReport);
+}
+
+bool FleetParameterPush::isRetryable(VehicleConnection::Result result)
+{
+    // Not when the vehicle rejected the parameters or is gone
+    return result == VehicleConnection::Result::Timeout || result == VehicleConnection::Result::ConnectionError ||
+            result == VehicleConnection::Result::Unknown;
+}
@@ -0,0 +1,110 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Pushes a parameter set to many vehicles concurrently, e.g., the same configuration to a whole fleet, and reports the result per
+ * vehicle. Built on VehicleConnection::setParametersOnVehicleAsync, i.e., MavsdkVehicleConnections set their parameters in
+ * parallel (each on its own parameter thread, with its own retries of timeouts), and on the parameter mirror: parameters a vehicle
+ * already has (getCachedParametersFromVehicle) are not sent. The parameters of a vehicle are sent in batches of up to batchSize,
+ * at most maxInFlightPerVehicle batches are queued on a vehicle's link and at most maxConcurrentVehicles vehicles are pushed to at
+ * a time. Failed batches are sent again after retryDelay_ms unless the vehicle rejected them, a vehicle stops at its first batch
+ * that failed for good. Lives in (and must be used from) the thread of the connections.
+ */
+
+#ifndef FLEETPARAMETERPUSH_H
+#define FLEETPARAMETERPUSH_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+#include "vehicleconnection.h"
+
+struct FleetParameterPushConfig {
+    int batchSize = 8; // parameters per request
+    int maxInFlightPerVehicle = 1; // requests queued on a vehicle's link
+    int maxConcurrentVehicles = 0; // 0: all at once
+    int maxRetries = 2; // per batch, on top of the connection's own retries
+    int retryDelay_ms = 500;
+    bool skipUnchanged = true; // parameters with the same value in the mirror
+};
+
+struct FleetParameterPushVehicleResult {
+    int vehicleId = 0;
+    VehicleConnection::Result result = VehicleConnection::Result::Unknown; // Success if all parameters are set, the failure otherwise
+    int parametersSet = 0; // in successful batches
+    int parametersSkipped = 0; // unchanged
+    int parametersFailed = 0; // not (known to be) set
+    int retries = 0;
+    double duration_ms = 0.0;
+};
+
+struct FleetParameterPushReport {
+    QVector<FleetParameterPushVehicleResult> vehicles; // in the order given to start()
+    int succeededVehicles = 0;
+    int failedVehicles = 0;
+    bool aborted = false;
+    double duration_ms = 0.0;
+    bool isSuccess() const { return failedVehicles == 0 && !aborted; }
+};
+
+class FleetParameterPush : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FleetParameterPush(QObject *parent = nullptr) : QObject(parent) {}
+
+    FleetParameterPushConfig getConfig() const { return mConfig; }
+    void setConfig(const FleetParameterPushConfig &config) { mConfig = config; } // applies to the next push
+
+    // Returns false if a push is running or there are no vehicles
+    bool start(const QList<QSharedPointer<VehicleConnection>> &vehicleConnections, const ParameterServer::AllParameters &parameters);
+    // Batches already queued on the links are still set on the vehicles, their results are ignored. Emits finished.
+    void abort();
+    bool isRunning() const { return mRunning; }
+    FleetParameterPushReport getReport() const { return mReport; } // also while running
+
+signals:
+    void progress(int finishedVehicles, int vehicles);
+    void finished(const FleetParameterPushReport &report);
+
+private:
+    struct Batch {
+        ParameterServer::AllParameters parameters;
+        int size = 0;
+        int attempts = 0;
+    };
+    struct VehiclePush {
+        QSharedPointer<VehicleConnection> vehicleConnection;
+        QList<Batch> pendingBatches;
+        int parameterCount = 0; // to set, without the skipped ones
+        int inFlight = 0;
+        int retriesWaiting = 0;
+        bool started = false;
+        bool failed = false;
+        bool finished = false;
+        QElapsedTimer timer;
+    };
+
+    void startVehicle(int index);
+    void sendBatch(int index);
+    void batchFinished(int index, const Batch &batch, VehicleConnection::Result result);
+    void finishVehicle(int index);
+    void schedulePump();
+    void pump();
+    void finish(bool aborted);
+    static bool isRetryable(VehicleConnection::Result result);
+
+    FleetParameterPushConfig mConfig;
+    ParameterServer::AllParameters mParameters;
+    QVector<VehiclePush> mVehicles;
+    FleetParameterPushReport mReport;
+    QElapsedTimer mTimer;
+    quint64 mPushId = 0; // results of previous pushes are ignored
+    int mFinishedVehicles = 0;
+    bool mRunning = false;
+    bool mPumpScheduled = false;
+};
+
+#endif // FLEETPARAMETERPUSH_H
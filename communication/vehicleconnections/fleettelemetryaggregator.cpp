@@ -0,0 +1,78 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "fleettelemetryaggregator.h"
+#include <cmath>
+
+FleetTelemetryAggregator::FleetTelemetryAggregator(QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<FleetTelemetryFrame>();
+
+    connect(&mFrameTimer, &QTimer::timeout, this, &FleetTelemetryAggregator::publishFrame);
+    setFrameRate(mFrameRate_Hz);
+}
+
+void FleetTelemetryAggregator::addVehicleConnection(QSharedPointer<VehicleConnection> vehicleConnection)
+{
+    if (!vehicleConnection || !vehicleConnection->getVehicleState())
+        return;
+
+    const int vehicleId = vehicleConnection->getVehicleState()->getId();
+    removeVehicleConnection(vehicleId);
+
+    TrackedVehicle trackedVehicle;
+    trackedVehicle.vehicleState = vehicleConnection->getVehicleState();
+    trackedVehicle.dirty = QSharedPointer<std::atomic<bool>>::create(true);
+
+    // Direct connection, i.e., runs in the (MAVSDK) thread that emits
+    QSharedPointer<std::atomic<bool>> dirty = trackedVehicle.dirty;
+    const auto markDirty = [dirty]() { dirty->store(true, std::memory_order_relaxed); };
+    trackedVehicle.connections.append(connect(vehicleConnection.get(), &VehicleConnection::updatedBatteryState, this, markDirty, Qt::DirectConnection));
+
+    mTrackedVehicles.insert(vehicleId, trackedVehicle);
+}
+
+void FleetTelemetryAggregator::removeVehicleConnection(int vehicleId)
+{
+    auto trackedVehicle = mTrackedVehicles.find(vehicleId);
+    if (trackedVehicle == mTrackedVehicles.end())
+        return;
+
+    for (const auto &connection : trackedVehicle->connections)
+        disconnect(connection);
+    mTrackedVehicles.erase(trackedVehicle);
+}
+
+void FleetTelemetryAggregator::setFrameRate(double frameRate_Hz)
+{
+    if (frameRate_Hz <= 0.0)
+        return;
+
+    mFrameRate_Hz = frameRate_Hz;
+    mFrameTimer.start(std::max((int)std::lround(1000.0 / mFrameRate_Hz), 1));
+}
+
+void FleetTelemetryAggregator::publishFrame()
+{
+    FleetTelemetryFrame frame;
+    for (auto &trackedVehicle : mTrackedVehicles) {
+        const bool batteryChanged = trackedVehicle.dirty->exchange(false, std::memory_order_relaxed);
+        // Version first: changes after it are seen (again) in the next frame
+        const quint64 stateVersion = trackedVehicle.vehicleState->getStateVersion(mTrackedFields);
+        const quint32 changedFields = (stateVersion != trackedVehicle.stateVersion) ?
+                    trackedVehicle.vehicleState->getChangedFields(trackedVehicle.stateVersion, mTrackedFields) : ObjectState::FIELD_NONE;
+        trackedVehicle.stateVersion = stateVersion;
+        if (!batteryChanged && changedFields == ObjectState::FIELD_NONE)
+            continue;
+
+        frame.changedVehicles.append(trackedVehicle.vehicleState);
+        frame.changedFields.append(changedFields);
+    }
+
+    if (frame.changedVehicles.isEmpty())
+        return;
+
+    frame.sequenceNumber = mFrameSequenceNumber++;
+    emit updatedFleetTelemetry(frame);
+}
@@ -0,0 +1,63 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Coalesces telemetry updates of many vehicle connections into frames published at a fixed rate, e.g., for UIs.
+ * Vehicle states are compared by their state version (ObjectState::getStateVersion), battery callbacks (any thread) only set a
+ * per-vehicle dirty flag. Frames list the vehicles that changed since the previous frame, no frame is published if no vehicle changed.
+ */
+
+#ifndef FLEETTELEMETRYAGGREGATOR_H
+#define FLEETTELEMETRYAGGREGATOR_H
+
+#include <QObject>
+#include <QMap>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+#include "vehicleconnection.h"
+
+struct FleetTelemetryFrame {
+    quint64 sequenceNumber = 0;
+    QVector<QSharedPointer<VehicleState>> changedVehicles;
+    QVector<quint32> changedFields; // ObjectState::StateField mask per changed vehicle, FIELD_NONE for battery updates only
+};
+Q_DECLARE_METATYPE(FleetTelemetryFrame)
+
+class FleetTelemetryAggregator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FleetTelemetryAggregator(QObject *parent = nullptr);
+
+    void addVehicleConnection(QSharedPointer<VehicleConnection> vehicleConnection);
+    void removeVehicleConnection(int vehicleId);
+
+    double getFrameRate() const { return mFrameRate_Hz; }
+    void setFrameRate(double frameRate_Hz);
+    // Fields of the vehicle states that count as a change, e.g., without FIELD_IMU for UIs that do not show it
+    quint32 getTrackedFields() const { return mTrackedFields; }
+    void setTrackedFields(quint32 trackedFields) { mTrackedFields = trackedFields; }
+
+signals:
+    void updatedFleetTelemetry(const FleetTelemetryFrame &frame);
+
+private:
+    struct TrackedVehicle {
+        QSharedPointer<VehicleState> vehicleState;
+        QSharedPointer<std::atomic<bool>> dirty; // shared with the callbacks, outlives removal while a callback runs
+        quint64 stateVersion = 0; // published in the previous frame
+        QVector<QMetaObject::Connection> connections;
+    };
+
+    void publishFrame();
+
+    QMap<int, TrackedVehicle> mTrackedVehicles;
+    QTimer mFrameTimer;
+    double mFrameRate_Hz = 30.0;
+    quint32 mTrackedFields = ObjectState::FIELD_ALL;
+    quint64 mFrameSequenceNumber = 0;
+};
+
+#endif // FLEETTELEMETRYAGGREGATOR_H
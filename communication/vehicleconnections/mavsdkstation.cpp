@@ -3,13 +3,16 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "mavsdkstation.h"
+#include "core/utctime.h"
 #include <QtDebug>
 #include <QThread>
+#include <chrono>
+#include <sys/resource.h>
 
 MavsdkStation::MavsdkStation(QObject *parent) : QObject(parent)
 {
     connect(&mHeartbeatTimer, &QTimer::timeout, this, &MavsdkStation::on_timeout);
-    mHeartbeatTimer.start(1000);
+    mHeartbeatTimer.start(HEARTBEAT_CHECK_INTERVAL_MS);
 
     mavsdk::Mavsdk::Configuration config = mavsdk::Mavsdk::Configuration{mavsdk::Mavsdk::ComponentType::GroundStation};
     config.set_always_send_heartbeats(true);
@@ -17,7 +20,37 @@ MavsdkStation::MavsdkStation(QObject *parent) : QObject(parent)
 
     mMavsdk->subscribe_on_new_system([this](){ emit gotNewMavsdkSystem(); });
 
+    // Link statistics per vehicle, broadcasts (e.g., our heartbeat) go to every vehicle
+    mMessageRouter = QSharedPointer<MavlinkMessageRouter>::create();
+    mMavlinkRecordingStreamId = mMavlinkRecorder.addStream(MAVLINK_RECORDING_STREAM);
+    mMavsdk->intercept_incoming_messages_async([this](mavlink_message_t &message) {
+        if (mMavlinkRecorder.isRecording()) {
+            uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+            const uint16_t length = mavlink_msg_to_send_buffer(buffer, &message);
+            mMavlinkRecorder.write(mMavlinkRecordingStreamId, reinterpret_cast<const char*>(buffer), length, utcTime::steadyNow_ns());
+        }
+        if (mBenchmarkEnabled.load(std::memory_order_relaxed))
+            sampleCallbackLatency();
+        {
+            std::lock_guard<std::mutex> lock(mLinkMonitorsMutex);
+            getLinkMonitor(message.sysid)->countIncoming(message);
+        }
+        mMessageRouter->route(message); // lightweight connections
+        return true;
+    });
+    mMavsdk->intercept_outgoing_messages_async([this](mavlink_message_t &message) {
+        std::lock_guard<std::mutex> lock(mLinkMonitorsMutex);
+        const uint8_t targetSystem = MavlinkLinkMonitor::getTargetSystem(message);
+        if (targetSystem == 0) {
+            for (const auto &linkMonitor : mLinkMonitors)
+                linkMonitor->countOutgoing(message);
+        } else
+            getLinkMonitor(targetSystem)->countOutgoing(message);
+        return true;
+    });
+
     connect(this, &MavsdkStation::gotNewMavsdkSystem, this, &MavsdkStation::handleNewMavsdkSystem, Qt::QueuedConnection);
+    connect(&mBenchmarkTimer, &QTimer::timeout, this, &MavsdkStation::reportBenchmark);
 }
 
 bool MavsdkStation::startListeningUDP(uint16_t port)
@@ -33,8 +66,9 @@ bool MavsdkStation::startListeningUDP(uint16_t port)
     }
 }
 
-bool MavsdkStation::startListeningSerial(const QSerialPortInfo &portInfo, int baudrate)
+bool MavsdkStation::startListeningSerial(const QSerialPortInfo &portInfo, int baudrate, const SerialPortOptions &options)
 {
+    serialPortOptions::applyToDevice(portInfo, options);
     mavsdk::ConnectionResult connection_result = mMavsdk->add_serial_connection(portInfo.systemLocation().toStdString(), baudrate);
     if (connection_result == mavsdk::ConnectionResult::Success) {
         qDebug() << "MavsdkStation: Waiting to discover vehicles on " + portInfo.systemLocation() + "...";
@@ -48,14 +82,59 @@ bool MavsdkStation::startListeningSerial(const QSerialPortInfo &portInfo, int ba
 void MavsdkStation::forwardRtcmData(const QByteArray &data, const int &type)
 {
     Q_UNUSED(type)
-    for (const auto &vehicleConnection : getVehicleConnectionList())
-        vehicleConnection->inputRtcmData(data);
+    // Fragment once, all vehicles get the same GPS_RTCM_DATA payloads
+    if (!mRtcmFragments.setRtcmData(data, mRtcmSequenceId++)) {
+        qWarning() << "MavsdkStation: RTCM message too large for MAVLINK (" << data.size() << "bytes), dropped";
+        return;
+    }
+
+    for (const auto &vehicleConnection : mVehicleConnectionMap)
+        if (vehicleConnection)
+            vehicleConnection->inputRtcmFragments(mRtcmFragments);
 }
 
 void MavsdkStation::setEnuReference(const llh_t &enuReference)
 {
     for (const auto &vehicleConnection : getVehicleConnectionList())
         vehicleConnection->setEnuReference(enuReference);
+
+    if (mEnuReferenceSet && !mRouteDeconfliction.getVehicleIds().isEmpty())
+        mRouteDeconfliction.reprojectEnu(coordinateTransforms::EnuFrame(mEnuReference).getTransformTo(coordinateTransforms::EnuFrame(enuReference)));
+    mEnuReference = enuReference;
+    mEnuReferenceSet = true;
+}
+
+bool MavsdkStation::configureConvoy(const QList<quint8> &systemIdsFromLeader)
+{
+    for (const quint8 systemId : systemIdsFromLeader)
+        if (getVehicleConnection(systemId).isNull()) {
+            qDebug() << "Warning: MavsdkStation cannot configure convoy, vehicle" << systemId << "is not connected.";
+            return false;
+        }
+
+    dissolveConvoy();
+
+    bool success = true;
+    for (int i = 0; i < systemIdsFromLeader.size(); i++)
+        success &= getVehicleConnection(systemIdsFromLeader.at(i))->requestConvoyPredecessor((i == 0) ? 0 : systemIdsFromLeader.at(i - 1));
+    // Followers start once they know whom to follow
+    for (int i = 1; i < systemIdsFromLeader.size(); i++)
+        getVehicleConnection(systemIdsFromLeader.at(i))->requestFollowPoint();
+
+    mConvoy = systemIdsFromLeader;
+    return success;
+}
+
+void MavsdkStation::dissolveConvoy()
+{
+    for (int i = 1; i < mConvoy.size(); i++) {
+        QSharedPointer<MavsdkVehicleConnection> vehicleConnection = getVehicleConnection(mConvoy.at(i));
+        if (vehicleConnection.isNull())
+            continue;
+        vehicleConnection->stopFollowPoint();
+        vehicleConnection->requestConvoyPredecessor(0);
+    }
+    mConvoy.clear();
 }
 
 QList<QSharedPointer<MavsdkVehicleConnection>> MavsdkStation::getVehicleConnectionList() const
@@ -67,27 +146,164 @@ QList<QSharedPointer<MavsdkVehicleConnection>> MavsdkStation::getVehicleConnecti
     return vehicleConnectionList;
 }
 
-void MavsdkStation::on_timeout()
+QVector<RouteConflict> MavsdkStation::setPlannedRoute(quint8 systemId, const QList<PosPoint> &route, double startTime_s)
 {
-    for(auto& vehicleTimeoutCounter : mVehicleHeartbeatTimeoutCounters) {
-        vehicleTimeoutCounter.second++;
+    QRectF footprint(-0.5, -0.5, 1.0, 1.0);
+    const QSharedPointer<MavsdkVehicleConnection> vehicleConnection = mVehicleConnectionMap.value(systemId);
+    if (vehicleConnection && vehicleConnection->getVehicleState()) {
+        const QSharedPointer<VehicleState> vehicleState = vehicleConnection->getVehicleState();
+        footprint = QRectF(-vehicleState->getLength() / 2.0, -vehicleState->getWidth() / 2.0, vehicleState->getLength(), vehicleState->getWidth());
+#ifdef QT_GUI_LIB
+        const QRectF boundingBox = vehicleState->getBoundingBox().boundingRect();
+        if (boundingBox.width() > 0.0 && boundingBox.height() > 0.0)
+            footprint = boundingBox;
+#endif
+    } else
+        qDebug() << "WARNING: no vehicle state for system" << systemId << "in MavsdkStation::setPlannedRoute, assuming a 1 m footprint.";
 
-        if(vehicleTimeoutCounter.second == HEARTBEATTIMER_TIMEOUT_SECONDS) {
-            mVehicleConnectionMap.remove(vehicleTimeoutCounter.first);
-            emit disconnectOfVehicleConnection(vehicleTimeoutCounter.first);
+    mRouteDeconfliction.setVehicleRoute(systemId, PosPoint::toPODList(route), footprint, startTime_s);
+    const QVector<RouteConflict> conflicts = mRouteDeconfliction.findConflicts(systemId);
+    emit routeConflicts(systemId, conflicts);
+    return conflicts;
+}
+
+void MavsdkStation::clearPlannedRoute(quint8 systemId)
+{
+    mRouteDeconfliction.removeVehicle(systemId);
+    emit routeConflicts(systemId, {});
+}
 
-            qDebug() << "System" << vehicleTimeoutCounter.first << "disconnected. ";
+void MavsdkStation::on_timeout()
+{
+    const qint64 now_ms = getMonotonicTime_ms();
+    if (now_ms - mLastLinkStatisticsUpdate_ms >= LINK_STATISTICS_INTERVAL_MS) {
+        updateLinkStatistics();
+        mLastLinkStatisticsUpdate_ms = now_ms;
+    }
 
-            mVehicleHeartbeatTimeoutCounters.removeOne(vehicleTimeoutCounter);
+    for (const uint8_t systemId : mHeartbeatMonitor.expire(now_ms)) {
+        mMessageRouter->unsubscribeSystem(systemId); // before the connection its handlers refer to is deleted
+        mVehicleConnectionMap.remove(systemId);
+        {
+            std::lock_guard<std::mutex> lock(mLinkMonitorsMutex);
+            mLinkMonitors.remove(systemId);
         }
+        mFleetTelemetryAggregator.removeVehicleConnection(systemId);
+        mRouteDeconfliction.removeVehicle(systemId);
+        emit disconnectOfVehicleConnection(systemId);
+
+        qDebug() << "System" << systemId << "disconnected. ";
     }
 }
 
+void MavsdkStation::updateLinkStatistics()
+{
+    std::lock_guard<std::mutex> lock(mLinkMonitorsMutex);
+    for (auto linkMonitor = mLinkMonitors.begin(); linkMonitor != mLinkMonitors.end(); linkMonitor++) {
+        MavlinkLinkStatistics linkStatistics = linkMonitor.value()->update();
+        linkStatistics.heartbeat = mHeartbeatMonitor.getStatistics(linkMonitor.key());
+        const QSharedPointer<MavsdkVehicleConnection> vehicleConnection = mVehicleConnectionMap.value(linkMonitor.key());
+        if (vehicleConnection)
+            vehicleConnection->setLinkStatistics(linkStatistics);
+    }
+}
+
+void MavsdkStation::setBenchmarkInterval_ms(int benchmarkInterval_ms)
+{
+    if (benchmarkInterval_ms <= 0) {
+        mBenchmarkEnabled = false;
+        mBenchmarkTimer.stop();
+        return;
+    }
+
+    PerfCounters &perfCounters = PerfCounters::getInstance();
+    mCallbackLatencyId = perfCounters.registerCounter("STA_CB", PerfCounters::Type::Latency);
+    mRxMessagesId = perfCounters.registerCounter("STA_RX", PerfCounters::Type::Counter);
+    mFrameLatencyId = perfCounters.registerCounter("MAP_FRAME", PerfCounters::Type::Latency);
+    mLastCallbackLatency = perfCounters.getSnapshot(mCallbackLatencyId);
+    mLastRxMessages = perfCounters.getSnapshot(mRxMessagesId);
+    mLastFrameLatency = perfCounters.getSnapshot(mFrameLatencyId);
+    mLastCpuTime_s = getProcessCpuTime_s();
+    mLastBenchmark_ms = getMonotonicTime_ms();
+
+    mBenchmarkEnabled = true;
+    mBenchmarkTimer.start(benchmarkInterval_ms);
+    qDebug() << "MavsdkStation benchmark: vehicles, CPU [%], rx [msg/s], callback latency mean/p99 [us], frames [Hz], frame time mean/p99 [ms]";
+}
+
+void MavsdkStation::sampleCallbackLatency()
+{
+    // Runs on MAVSDK's receive thread, one sample per interval is posted to the event loop
+    PerfCounters::getInstance().add(mRxMessagesId);
+    const qint64 now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    qint64 lastSample_ns = mLastLatencySample_ns.load(std::memory_order_relaxed);
+    if (now_ns - lastSample_ns < BENCHMARK_LATENCY_SAMPLE_INTERVAL_NS || !mLastLatencySample_ns.compare_exchange_strong(lastSample_ns, now_ns))
+        return;
+
+    QMetaObject::invokeMethod(this, [this, now_ns]() {
+        const qint64 handled_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        PerfCounters::getInstance().recordLatency_ns(mCallbackLatencyId, handled_ns - now_ns);
+    }, Qt::QueuedConnection);
+}
+
+void MavsdkStation::reportBenchmark()
+{
+    const PerfCounters &perfCounters = PerfCounters::getInstance();
+    const PerfCounterSnapshot callbackLatency = perfCounters.getSnapshot(mCallbackLatencyId);
+    const PerfCounterSnapshot rxMessages = perfCounters.getSnapshot(mRxMessagesId);
+    const PerfCounterSnapshot frameLatency = perfCounters.getSnapshot(mFrameLatencyId);
+    const PerfCounterSnapshot callbackLatencyInterval = callbackLatency.since(mLastCallbackLatency);
+    const PerfCounterSnapshot frameLatencyInterval = frameLatency.since(mLastFrameLatency);
+    const double cpuTime_s = getProcessCpuTime_s();
+    const qint64 now_ms = getMonotonicTime_ms();
+
+    MavsdkStationBenchmarkReport report;
+    report.vehicles = getVehicleConnectionList().size();
+    if (now_ms > mLastBenchmark_ms)
+        report.cpu_percent = 100.0 * (cpuTime_s - mLastCpuTime_s) / ((now_ms - mLastBenchmark_ms) / 1000.0);
+    report.rxMessages_Hz = rxMessages.getRate_Hz(mLastRxMessages);
+    report.callbackLatencyMean_us = callbackLatencyInterval.getMeanLatency_us();
+    report.callbackLatencyP99_us = callbackLatencyInterval.getLatencyPercentile_us(99.0);
+    report.frames_Hz = frameLatency.getRate_Hz(mLastFrameLatency);
+    report.frameTimeMean_ms = frameLatencyInterval.getMeanLatency_us() / 1000.0;
+    report.frameTimeP99_ms = frameLatencyInterval.getLatencyPercentile_us(99.0) / 1000.0;
+
+    mLastCallbackLatency = callbackLatency;
+    mLastRxMessages = rxMessages;
+    mLastFrameLatency = frameLatency;
+    mLastCpuTime_s = cpuTime_s;
+    mLastBenchmark_ms = now_ms;
+
+    qDebug().noquote() << QString("MavsdkStation benchmark: %1, %2, %3, %4/%5, %6, %7/%8").arg(report.vehicles).arg(report.cpu_percent, 0, 'f', 1)
+                          .arg(report.rxMessages_Hz, 0, 'f', 0).arg(report.callbackLatencyMean_us, 0, 'f', 0).arg(report.callbackLatencyP99_us, 0, 'f', 0)
+                          .arg(report.frames_Hz, 0, 'f', 1).arg(report.frameTimeMean_ms, 0, 'f', 2).arg(report.frameTimeP99_ms, 0, 'f', 2);
+    emit benchmarkReport(report);
+}
+
+double MavsdkStation::getProcessCpuTime_s()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
 void MavsdkStation::on_gotHeartbeat(const quint8 systemId)
 {
-    for(auto& vehicleTimeoutCounter : mVehicleHeartbeatTimeoutCounters)
-        if(vehicleTimeoutCounter.first == systemId)
-            vehicleTimeoutCounter.second = 0;
+    mHeartbeatMonitor.refresh(systemId, getMonotonicTime_ms());
+}
+
+qint64 MavsdkStation::getMonotonicTime_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+QSharedPointer<MavlinkLinkMonitor> MavsdkStation::getLinkMonitor(quint8 systemId)
+{
+    auto linkMonitor = mLinkMonitors.find(systemId);
+    if (linkMonitor == mLinkMonitors.end())
+        linkMonitor = mLinkMonitors.insert(systemId, QSharedPointer<MavlinkLinkMonitor>::create());
+    return linkMonitor.value();
 }
 
 QSharedPointer<MavsdkVehicleConnection> MavsdkStation::getVehicleConnection(const quint8 systemId) const
@@ -95,6 +311,42 @@ QSharedPointer<MavsdkVehicleConnection> MavsdkStation::getVehicleConnection(cons
     return mVehicleConnectionMap.find(systemId).value();
 }
 
+void MavsdkStation::setDemandDrivenTelemetryEnabled(bool demandDrivenTelemetryEnabled)
+{
+    mDemandDrivenTelemetryEnabled = demandDrivenTelemetryEnabled;
+    updateTelemetryDemand();
+}
+
+void MavsdkStation::setSelectedVehicle(quint8 systemId)
+{
+    mSelectedVehicle = systemId;
+    updateTelemetryDemand();
+}
+
+void MavsdkStation::setVisibleVehicles(const QSet<quint8> &systemIds)
+{
+    mVisibleVehicles = systemIds;
+    mVisibleVehiclesSet = true;
+    updateTelemetryDemand();
+}
+
+MavsdkVehicleConnection::TelemetryDemand MavsdkStation::getTelemetryDemand(quint8 systemId) const
+{
+    if (!mDemandDrivenTelemetryEnabled || systemId == mSelectedVehicle)
+        return MavsdkVehicleConnection::TelemetryDemand::Selected;
+    if (!mVisibleVehiclesSet || mVisibleVehicles.contains(systemId))
+        return MavsdkVehicleConnection::TelemetryDemand::Visible;
+    return MavsdkVehicleConnection::TelemetryDemand::Background;
+}
+
+void MavsdkStation::updateTelemetryDemand()
+{
+    // Only changed demands are sent
+    for (auto it = mVehicleConnectionMap.constBegin(); it != mVehicleConnectionMap.constEnd(); ++it)
+        if (it.value())
+            it.value()->setTelemetryDemand(getTelemetryDemand(it.key()));
+}
+
 void MavsdkStation::handleNewMavsdkSystem()
 {
     for (const auto &system : mMavsdk->systems()) {
@@ -103,27 +355,55 @@ void MavsdkStation::handleNewMavsdkSystem()
                 qDebug() << "MavsdkStation: detected system" << system->get_system_id() << "waiting for another heartbeat for initializing MavsdkVehicleConnection...";
                 mVehicleConnectionMap.insert(system->get_system_id(), nullptr); // Register system_id, but wait for heartbeat to initialize VehicleConnection
 
-                // Wait for heartbeat using passthrough to instantiate vehicleConnection (mainly needed to get MAV_TYPE)
-                auto mavlinkPassthrough = new mavsdk::MavlinkPassthrough(system);
-                mavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_HEARTBEAT, [this, system, mavlinkPassthrough](const mavlink_message_t &message) {
+                // Wait for heartbeat to instantiate vehicleConnection (mainly needed to get MAV_TYPE), returns true when done
+                const bool lightweight = mLightweightConnectionsEnabled;
+                auto handleHeartbeat = [this, system, lightweight](const mavlink_message_t &message) {
                     mavlink_heartbeat_t heartbeat;
                     mavlink_msg_heartbeat_decode(&message, &heartbeat);
 
                     // Only use heartbeat from autopilot component to instantiate vehicleConnection once
                     if ((MAV_AUTOPILOT)heartbeat.autopilot != MAV_AUTOPILOT_INVALID) {
-                        // unsubscribe from further heartbeats by deleting passthrough
-                        delete mavlinkPassthrough;
-
-                        QSharedPointer<MavsdkVehicleConnection> vehicleConnection = QSharedPointer<MavsdkVehicleConnection>::create(system, (MAV_TYPE) heartbeat.type);
+                        QSharedPointer<MavsdkVehicleConnection> vehicleConnection = QSharedPointer<MavsdkVehicleConnection>::create(
+                                    system, (MAV_TYPE) heartbeat.type, lightweight ? mMessageRouter : QSharedPointer<MavlinkMessageRouter>());
                         mVehicleConnectionMap[system->get_system_id()] = vehicleConnection;
 
                         connect(vehicleConnection.get(), &MavsdkVehicleConnection::gotHeartbeat, this, &MavsdkStation::on_gotHeartbeat);
 
-                        mVehicleHeartbeatTimeoutCounters.append(qMakePair(system->get_system_id(), 0));    // Timer initialised to zero
+                        // heartbeat callback runs in a MAVSDK thread, heartbeat monitor and aggregator are only modified on their own
+                        const quint8 systemId = system->get_system_id();
+                        QMetaObject::invokeMethod(this, [this, systemId, vehicleConnection]() {
+                            mHeartbeatMonitor.add(systemId, getMonotonicTime_ms());
+                            if (mDemandDrivenTelemetryEnabled)
+                                vehicleConnection->setTelemetryDemand(getTelemetryDemand(systemId));
+                        }, Qt::QueuedConnection);
+                        QMetaObject::invokeMethod(&mFleetTelemetryAggregator, [this, vehicleConnection]() {
+                            mFleetTelemetryAggregator.addVehicleConnection(vehicleConnection);
+                        }, Qt::QueuedConnection);
 
                         emit gotNewVehicleConnection(vehicleConnection);
+                        return true;
                     }
-                });
+                    return false;
+                };
+
+                if (lightweight) {
+                    // Routed messages of a system are handled sequentially, further heartbeats are ignored once done
+                    auto done = std::make_shared<bool>(false);
+                    auto handlerId = std::make_shared<std::atomic<MavlinkMessageRouter::HandlerId>>(0);
+                    handlerId->store(mMessageRouter->subscribe(system->get_system_id(), MAVLINK_MSG_ID_HEARTBEAT, [this, handleHeartbeat, done, handlerId](const mavlink_message_t &message) {
+                        if (!*done && handleHeartbeat(message)) {
+                            *done = true;
+                            mMessageRouter->unsubscribe(handlerId->load()); // not yet known for the very first heartbeat: removed with the system
+                        }
+                    }));
+                } else {
+                    // unsubscribe from further heartbeats by deleting passthrough
+                    auto mavlinkPassthrough = new mavsdk::MavlinkPassthrough(system);
+                    mavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_HEARTBEAT, [handleHeartbeat, mavlinkPassthrough](const mavlink_message_t &message) {
+                        if (handleHeartbeat(message))
+                            delete mavlinkPassthrough;
+                    });
+                }
             } else
                 qDebug() << "Note: MavsdkStation ignored system" << system->get_system_id(); // ToDo: create connection to systems that doesn't have an autopilot
         }
@@ -10,14 +10,35 @@
 
 #include <QObject>
 #include <QMap>
+#include <QSet>
 #include <QSharedPointer>
 #include <QSerialPortInfo>
 #include <QTimer>
-#include <QVector>
-#include <QPair>
 #include <mavsdk/mavsdk.h>
 #include <mavsdk/plugins/mavlink_passthrough/mavlink_passthrough.h>
 #include "mavsdkvehicleconnection.h"
+#include "fleettelemetryaggregator.h"
+#include "communication/mavlinklinkmonitor.h"
+#include "communication/mavlinkmessagerouter.h"
+#include "communication/mavlinkheartbeatmonitor.h"
+#include "core/serialportoptions.h"
+#include "routeplanning/routedeconfliction.h"
+#include "core/perfcounters.h"
+#include "logger/rawstreamrecorder.h"
+#include <atomic>
+#include <mutex>
+
+// Between two reports of the benchmark mode
+struct MavsdkStationBenchmarkReport {
+    int vehicles = 0;
+    double cpu_percent = 0.0; // of the process, 100 per fully used core
+    double rxMessages_Hz = 0.0;
+    double callbackLatencyMean_us = 0.0; // from MAVSDK's receive thread to the station's event loop (sampled)
+    double callbackLatencyP99_us = 0.0;
+    double frames_Hz = 0.0; // MapWidget frames (MAP_FRAME perf counter), 0 without a map in the process
+    double frameTimeMean_ms = 0.0;
+    double frameTimeP99_ms = 0.0;
+};
 
 class MavsdkStation : public QObject
 {
@@ -25,15 +46,65 @@ class MavsdkStation : public QObject
 public:
     explicit MavsdkStation(QObject *parent = nullptr);
     bool startListeningUDP(uint16_t port = mavsdk::Mavsdk::DEFAULT_UDP_PORT);
-    bool startListeningSerial(const QSerialPortInfo& portInfo = QSerialPortInfo("ttyUSB0"), int baudrate = mavsdk::Mavsdk::DEFAULT_SERIAL_BAUDRATE);
+    // MAVSDK opens the port itself, only options of the driver (lowLatency) apply
+    bool startListeningSerial(const QSerialPortInfo& portInfo = QSerialPortInfo("ttyUSB0"), int baudrate = mavsdk::Mavsdk::DEFAULT_SERIAL_BAUDRATE,
+                              const SerialPortOptions &options = SerialPortOptions());
 
     // broadcasts to all vehicles
     void forwardRtcmData(const QByteArray& data, const int &type);
+    // Vehicle positions and planned routes are converted to the new reference, see EnuReprojector
     void setEnuReference(const llh_t &enuReference);
 
+    // Convoy: each vehicle follows the one before it in the list (first: leader) using peer-to-peer position broadcasts
+    // (see MavlinkConvoyLink), followers are switched to follow point. The station only configures and monitors the chain.
+    bool configureConvoy(const QList<quint8> &systemIdsFromLeader);
+    void dissolveConvoy(); // followers stop following
+    QList<quint8> getConvoy() const { return mConvoy; }
+
     QList<QSharedPointer<MavsdkVehicleConnection>> getVehicleConnectionList() const;
     QSharedPointer<MavsdkVehicleConnection> getVehicleConnection(const quint8 systemId) const;
 
+    // Coalesced telemetry of all vehicle connections for UI consumers (see FleetTelemetryAggregator)
+    FleetTelemetryAggregator *getFleetTelemetryAggregator() { return &mFleetTelemetryAggregator; }
+
+    // Demand-driven telemetry (see MavsdkVehicleConnection::TelemetryDemand): the selected vehicle (0: none) gets full rates,
+    // the others reduced ones depending on whether the UI shows them (e.g., in the map's viewport). Until visible vehicles are
+    // set, all are visible. Off (default): all vehicles at full rates. Applies to vehicles connecting later as well.
+    void setDemandDrivenTelemetryEnabled(bool demandDrivenTelemetryEnabled);
+    bool isDemandDrivenTelemetryEnabled() const { return mDemandDrivenTelemetryEnabled; }
+    void setSelectedVehicle(quint8 systemId);
+    quint8 getSelectedVehicle() const { return mSelectedVehicle; }
+    void setVisibleVehicles(const QSet<quint8> &systemIds);
+
+    // Lightweight connections get their messages from the station's MavlinkMessageRouter (one dispatch per message) and decode
+    // telemetry themselves instead of using MAVSDK's Telemetry/MavlinkPassthrough subscriptions, other MAVSDK plugins are
+    // only created when needed. For many vehicles, applies to vehicles connecting after it has been set.
+    void setLightweightConnectionsEnabled(bool lightweightConnectionsEnabled) { mLightweightConnectionsEnabled = lightweightConnectionsEnabled; }
+    bool isLightweightConnectionsEnabled() const { return mLightweightConnectionsEnabled; }
+    QSharedPointer<MavlinkMessageRouter> getMessageRouter() const { return mMessageRouter; }
+
+    // Space-time conflicts between the routes planned for the vehicles, e.g., checked on every edit before sending them
+    // (see RouteDeconfliction). The footprint comes from the vehicle's state, startTime_s is relative to the common start.
+    // Emits routeConflicts with all conflicts of the vehicle, also returns them.
+    QVector<RouteConflict> setPlannedRoute(quint8 systemId, const QList<PosPoint> &route, double startTime_s = 0.0);
+    void clearPlannedRoute(quint8 systemId);
+    RouteDeconfliction *getRouteDeconfliction() { return &mRouteDeconfliction; }
+
+    // Benchmark mode for load tests with many vehicles (e.g., with tools/fleet_load_generator): prints and emits benchmarkReport
+    // every interval with the process CPU load, received message rate, event loop latency of MAVSDK callbacks and GUI frame
+    // times. 0: off (default).
+    void setBenchmarkInterval_ms(int benchmarkInterval_ms);
+    static constexpr int BENCHMARK_LATENCY_SAMPLE_INTERVAL_NS = 10000000; // at most 100 samples/s, the samples load the event loop too
+
+    // Records all incoming MAVLink messages as serialized on the link with their reception times (RawStreamRecorder, stream
+    // MAVLINK_RECORDING_STREAM), e.g., to reproduce performance problems of a field session by replaying its traffic into a
+    // station without vehicles (see tools/mavlink_replay). Costs a copy per message. maxSegments: older segments are deleted (0: keep all)
+    bool startMavlinkRecording(const QString &basename, int maxSegments = 0) { return mMavlinkRecorder.start(basename, maxSegments); }
+    void stopMavlinkRecording() { mMavlinkRecorder.stop(); }
+    bool isMavlinkRecording() const { return mMavlinkRecorder.isRecording(); }
+    RawStreamRecorderStatistics getMavlinkRecordingStatistics() const { return mMavlinkRecorder.getStatistics(); }
+    static constexpr const char *MAVLINK_RECORDING_STREAM = "mavlink_rx";
+
 private slots:
     void on_gotHeartbeat(quint8 systemId);
     void on_timeout();
@@ -42,15 +113,58 @@ signals:
     void gotNewVehicleConnection(QSharedPointer<MavsdkVehicleConnection>);
     void gotNewMavsdkSystem();
     void disconnectOfVehicleConnection(int systemId);
+    void routeConflicts(quint8 systemId, const QVector<RouteConflict> &conflicts);
+    void benchmarkReport(const MavsdkStationBenchmarkReport &report);
 
 private:
     std::shared_ptr<mavsdk::Mavsdk> mMavsdk;
     QMap<int, QSharedPointer<MavsdkVehicleConnection>> mVehicleConnectionMap;
 
+    static constexpr int HEARTBEAT_TIMEOUT_MS = 5000;
+    static constexpr int HEARTBEAT_CHECK_INTERVAL_MS = 100; // resolution of the timeout
+    static constexpr int LINK_STATISTICS_INTERVAL_MS = 1000;
     QTimer mHeartbeatTimer;
-    const int HEARTBEATTIMER_TIMEOUT_SECONDS = 5;
-    QVector<QPair<quint8, int>> mVehicleHeartbeatTimeoutCounters;
+    MavlinkHeartbeatMonitor mHeartbeatMonitor{HEARTBEAT_TIMEOUT_MS, HEARTBEAT_CHECK_INTERVAL_MS};
+    qint64 mLastLinkStatisticsUpdate_ms = 0;
+    FleetTelemetryAggregator mFleetTelemetryAggregator;
+    MavlinkRtcmFragments mRtcmFragments; // reused for every forwarded message
+    QList<quint8> mConvoy; // system ids from leader
+    uint8_t mRtcmSequenceId = 0;
+    RouteDeconfliction mRouteDeconfliction; // planned routes by system id
+    llh_t mEnuReference;
+    bool mEnuReferenceSet = false;
+
+    bool mDemandDrivenTelemetryEnabled = false;
+    quint8 mSelectedVehicle = 0;
+    QSet<quint8> mVisibleVehicles;
+    bool mVisibleVehiclesSet = false;
+    MavsdkVehicleConnection::TelemetryDemand getTelemetryDemand(quint8 systemId) const;
+    void updateTelemetryDemand();
+
+    // per vehicle (system id), counted from MAVSDK threads, updated with the heartbeat timer
+    QMap<quint8, QSharedPointer<MavlinkLinkMonitor>> mLinkMonitors;
+    std::mutex mLinkMonitorsMutex;
+    QSharedPointer<MavlinkMessageRouter> mMessageRouter;
+    std::atomic<bool> mLightweightConnectionsEnabled{false};
+    RawStreamRecorder mMavlinkRecorder;
+    int mMavlinkRecordingStreamId = -1;
+
+    QTimer mBenchmarkTimer;
+    std::atomic<bool> mBenchmarkEnabled{false};
+    std::atomic<qint64> mLastLatencySample_ns{0};
+    int mCallbackLatencyId = -1;
+    int mRxMessagesId = -1;
+    int mFrameLatencyId = -1;
+    PerfCounterSnapshot mLastCallbackLatency, mLastRxMessages, mLastFrameLatency;
+    double mLastCpuTime_s = 0.0;
+    qint64 mLastBenchmark_ms = 0;
+    void sampleCallbackLatency();
+    void reportBenchmark();
+    static double getProcessCpuTime_s();
+    QSharedPointer<MavlinkLinkMonitor> getLinkMonitor(quint8 systemId); // expects mLinkMonitorsMutex
     void handleNewMavsdkSystem();
+    void updateLinkStatistics();
+    static qint64 getMonotonicTime_ms();
 };
 
 #endif // MAVSDKSTATION_H
@@ -3,17 +3,117 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "mavsdkvehicleconnection.h"
+#include "communication/mavlinktimesync.h"
 #include <QDebug>
 #include <QDateTime>
+#include <algorithm>
+#include <cstdlib>
 
-MavsdkVehicleConnection::MavsdkVehicleConnection(std::shared_ptr<mavsdk::System> system, MAV_TYPE vehicleType)
+namespace {
+bool isNeutralManualControl(const mavlink_manual_control_t &manualControl)
 {
+    return manualControl.x == 0 && manualControl.y == 0 && manualControl.z == 0 && manualControl.r == 0 && manualControl.buttons == 0;
+}
+
+int getMaxAxisDelta(const mavlink_manual_control_t &manualControl1, const mavlink_manual_control_t &manualControl2)
+{
+    return std::max({abs(manualControl1.x - manualControl2.x), abs(manualControl1.y - manualControl2.y),
+                     abs(manualControl1.z - manualControl2.z), abs(manualControl1.r - manualControl2.r)});
+}
+
+template<typename T>
+T *findParameter(std::vector<T> &parameters, const std::string &name)
+{
+    for (auto& parameter : parameters)
+        if (parameter.name == name)
+            return &parameter;
+    return nullptr;
+}
+
+template<typename T>
+const T *findParameter(const std::vector<T> &parameters, const std::string &name)
+{
+    for (const auto& parameter : parameters)
+        if (parameter.name == name)
+            return &parameter;
+    return nullptr;
+}
+
+template<typename T>
+void mergeParameters(std::vector<T> &parameters, const std::vector<T> &newerParameters)
+{
+    for (const auto& newerParameter : newerParameters) {
+        if (auto parameter = findParameter(parameters, newerParameter.name))
+            parameter->value = newerParameter.value;
+        else
+            parameters.push_back(newerParameter);
+    }
+}
+
+// Stream intervals below full demand (see MavsdkVehicleConnection::TelemetryDemand) [ms], 0: the vehicle's default, -1: disabled.
+// Position (with heading and velocity) and status stay, what only the selected vehicle's views show is disabled.
+struct TelemetryStreamInterval {
+    uint16_t messageId;
+    int visibleInterval_ms;
+    int backgroundInterval_ms;
+};
+const TelemetryStreamInterval TELEMETRY_STREAM_INTERVALS[] = {
+    {MAVLINK_MSG_ID_GLOBAL_POSITION_INT, 200, 1000},
+    {MAVLINK_MSG_ID_LOCAL_POSITION_NED, 200, 1000},
+    {MAVLINK_MSG_ID_HOME_POSITION, 5000, 5000},
+    {MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN, 5000, 5000},
+    {MAVLINK_MSG_ID_GPS_RAW_INT, 1000, 5000},
+    {MAVLINK_MSG_ID_NAMED_VALUE_FLOAT, 1000, 2000}, // autopilot radius, convoy gap, sensor health, route tracking
+    {MAVLINK_MSG_ID_DEBUG_FLOAT_ARRAY, -1, -1}, // perf counters (command latency traces are sent directly)
+    {MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED, -1, -1}, // autopilot lookahead and reference points
+};
+
+// PX4 custom mode (main/sub mode) as MAVSDK's Telemetry plugin maps it, vehicles using MAVSDK's server side behave like PX4
+VehicleState::FlightMode px4FlightMode(const mavlink_heartbeat_t &heartbeat)
+{
+    if (!(heartbeat.base_mode & MAV_MODE_FLAG_CUSTOM_MODE_ENABLED))
+        return VehicleState::FlightMode::Unknown;
+
+    const uint8_t mainMode = (heartbeat.custom_mode >> 16) & 0xFF;
+    const uint8_t subMode = (heartbeat.custom_mode >> 24) & 0xFF;
+    switch (mainMode) {
+    case 1: return VehicleState::FlightMode::Manual;
+    case 2: return VehicleState::FlightMode::Altctl;
+    case 3: return VehicleState::FlightMode::Posctl;
+    case 4: // auto
+        switch (subMode) {
+        case 1: return VehicleState::FlightMode::Ready;
+        case 2: return VehicleState::FlightMode::Takeoff;
+        case 3: return VehicleState::FlightMode::Hold;
+        case 4: return VehicleState::FlightMode::Mission;
+        case 5: return VehicleState::FlightMode::ReturnToLaunch;
+        case 6: return VehicleState::FlightMode::Land;
+        case 8: return VehicleState::FlightMode::FollowMe;
+        case 9: return VehicleState::FlightMode::Land; // precision landing
+        default: return VehicleState::FlightMode::Unknown;
+        }
+    case 5: return VehicleState::FlightMode::Acro;
+    case 6: return VehicleState::FlightMode::Offboard;
+    case 7: return VehicleState::FlightMode::Stabilized;
+    case 8: return VehicleState::FlightMode::Rattitude;
+    default: return VehicleState::FlightMode::Unknown;
+    }
+}
+}
+
+MavsdkVehicleConnection::MavsdkVehicleConnection(std::shared_ptr<mavsdk::System> system, MAV_TYPE vehicleType, QSharedPointer<MavlinkMessageRouter> messageRouter)
+{
+    const double setupStart_ms = StartupProfile::getTimeSinceStart_ms();
     mSystem = system;
     mVehicleType = vehicleType;
-    mMavlinkPassthrough.reset(new mavsdk::MavlinkPassthrough(system));
+    mMessageRouter = messageRouter;
+    mMavlinkPassthrough.reset(new mavsdk::MavlinkPassthrough(system)); // sending, receiving unless messages are routed
 
-    // Set up param plugin
-    mParam.reset(new mavsdk::Param(mSystem));
+    // Param plugin is created on first use, asynchronous requests run on their own thread
+    mParameterThreadContext = new QObject();
+    mParameterThread.setObjectName("MAVSDK parameters");
+    mParameterThreadContext->moveToThread(&mParameterThread);
+    mParameterThread.start();
 
     switch (mVehicleType) {
     case MAV_TYPE_QUADROTOR:
@@ -66,12 +166,10 @@ MavsdkVehicleConnection::MavsdkVehicleConnection(std::shared_ptr<mavsdk::System>
             }
 
             if (system->has_autopilot())
-            {
-                auto paramResult = getIntParameterFromVehicle("PP_EGA_TYPE");
-                if (paramResult.first == VehicleConnection::Result::Success) {
-                    mVehicleState->setEndGoalAlignmentType(static_cast<AutopilotEndGoalAlignmentType>(paramResult.second));
-                }
-            }
+                getIntParameterFromVehicleAsync("PP_EGA_TYPE", [this](VehicleConnection::Result result, int32_t value) {
+                    if (result == VehicleConnection::Result::Success)
+                        mVehicleState->setEndGoalAlignmentType(static_cast<AutopilotEndGoalAlignmentType>(value));
+                });
 
             break;
         }
@@ -80,95 +178,21 @@ MavsdkVehicleConnection::MavsdkVehicleConnection(std::shared_ptr<mavsdk::System>
         break;
     }
 
-    // Set up telemetry plugin
-    mTelemetry.reset(new mavsdk::Telemetry(mSystem));
-
-    mTelemetry->subscribe_battery([this](mavsdk::Telemetry::Battery battery) {
-       emit updatedBatteryState(battery.voltage_v, battery.remaining_percent);
-    });
-
-    mTelemetry->subscribe_armed([this](bool isArmed) {
-       mVehicleState->setIsArmed(isArmed);
-    });
-
-    mTelemetry->subscribe_home([this](mavsdk::Telemetry::Position position) {
-        llh_t llh = {position.latitude_deg, position.longitude_deg, position.absolute_altitude_m};
-        xyz_t xyz = coordinateTransforms::llhToEnu(mEnuReference, llh);
-
-        auto homePos = mVehicleState->getHomePosition();
-        homePos.setX(xyz.x);
-        homePos.setY(xyz.y);
-        homePos.setHeight(xyz.z);
-        mVehicleState->setHomePosition(homePos);
-
-        emit gotVehicleHomeLlh({position.latitude_deg, position.longitude_deg, position.absolute_altitude_m});
-    });
-
-    if (mVehicleType == MAV_TYPE::MAV_TYPE_GROUND_ROVER) // assumption: rover = WayWise on vehicle side -> get NED (shared ENU ref), global pos otherwise
-        mTelemetry->subscribe_position_velocity_ned([this](mavsdk::Telemetry::PositionVelocityNed positionVelocity_ned) {
-            auto pos = mVehicleState->getPosition();
-
-            xyz_t positionNED = {positionVelocity_ned.position.north_m, positionVelocity_ned.position.east_m, positionVelocity_ned.position.down_m};
-            pos.setXYZ(coordinateTransforms::nedToENU(positionNED));
-
-            mVehicleState->setPosition(pos);
-        });
+    if (mMessageRouter)
+        setupTelemetryMessages();
     else
-        mTelemetry->subscribe_position([this](mavsdk::Telemetry::Position position) {
-            llh_t llh = {position.latitude_deg, position.longitude_deg, position.absolute_altitude_m};
-            xyz_t xyz = coordinateTransforms::llhToEnu(mEnuReference, llh);
-
-            auto pos = mVehicleState->getPosition();
-            pos.setX(xyz.x);
-            pos.setY(xyz.y);
-            pos.setHeight(xyz.z);
-
-            mVehicleState->setPosition(pos);
-        });
-
-    mTelemetry->subscribe_heading([this](mavsdk::Telemetry::Heading heading) {
-        auto pos = mVehicleState->getPosition();
-
-        pos.setYaw(coordinateTransforms::yawNEDtoENU(heading.heading_deg));
-
-        mVehicleState->setPosition(pos);
-    });
-
-    mTelemetry->subscribe_velocity_ned([this](mavsdk::Telemetry::VelocityNed velocity) {
-        xyz_t velocityNED {velocity.north_m_s, velocity.east_m_s, velocity.down_m_s};
-        xyz_t velocityENU = coordinateTransforms::nedToENU(velocityNED);
-        mVehicleState->setVelocity(velocityENU);
-    });
-
-    if (mVehicleType == MAV_TYPE::MAV_TYPE_QUADROTOR) {
-        mTelemetry->subscribe_landed_state([this](mavsdk::Telemetry::LandedState landedState) {
-           mVehicleState.dynamicCast<CopterState>()->setLandedState(static_cast<CopterState::LandedState>(landedState));
-        });
-    }
-
-    mTelemetry->subscribe_flight_mode([this](mavsdk::Telemetry::FlightMode flightMode) {
-        mVehicleState->setFlightMode(static_cast<CopterState::FlightMode>(flightMode));
-
-        if (flightMode != mavsdk::Telemetry::FlightMode::Offboard &&
-                flightMode != mavsdk::Telemetry::FlightMode::Hold)
-            if (hasWaypointFollowerConnectionLocal() && isAutopilotActive()) {
-                emit stopWaypointFollowerSignal();
-                qDebug() << "MavsdkVehicleConnection: connection-local WaypointFollower stopped by flightmode change (Note: can only be started in hold mode).";
-            }
-
-//            qDebug() << (int)flightMode << (mOffboard ? mOffboard->is_active() : false);
-    });
+        setupTelemetryPlugin();
 
     // poll update of GpsGlobalOrigin once
     MavsdkVehicleConnection::pollCurrentENUreference();
 
 
-    mMavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_HEARTBEAT, [this](const mavlink_message_t &message) {
+    subscribeMessage(MAVLINK_MSG_ID_HEARTBEAT, [this](const mavlink_message_t &message) {
         Q_UNUSED(message)
         emit gotHeartbeat(mSystem->get_system_id());
     });
 
-    mMavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_STATUSTEXT, [](const mavlink_message_t &message)
+    subscribeMessage(MAVLINK_MSG_ID_STATUSTEXT, [](const mavlink_message_t &message)
     {
         struct messageChunk {
             QString text;
@@ -260,27 +284,119 @@ MavsdkVehicleConnection::MavsdkVehicleConnection(std::shared_ptr<mavsdk::System>
         }
     });
 
+    // Bulk route transfer
+    mRouteUploadSender.setSendPacket([this](const mavlinkRouteTransfer::Packet &packet) { return sendRouteTransferPacket(packet); });
+    connect(&mRouteUploadSender, &mavlinkRouteTransfer::ChunkSender::finished, this, [this](bool success, bool gotAck) {
+        const QList<PosPoint> fallbackRoute = mRouteUploadFallback;
+        mRouteUploadFallback.clear();
+        if (success) {
+            mRouteOnVehicle = mRouteUploadRoute;
+        } else if (mRouteUploadIsPatch && gotAck) { // e.g., the vehicle's route changed since
+            qDebug() << "MavsdkVehicleConnection: route patch rejected by vehicle, uploading complete route.";
+            clearRouteOnVehicle(0);
+            appendToRouteOnVehicle(fallbackRoute, 0);
+        } else {
+            if (!gotAck)
+                mBulkRouteTransferSupported = false;
+            qDebug() << "MavsdkVehicleConnection: bulk route upload failed" << (gotAck ? "" : "(no answer)") << ", falling back to mission protocol.";
+            uploadRouteAsMission(fallbackRoute);
+        }
+        if (!mRouteUploadSender.isActive())
+            mRouteUploadRoute.clear();
+    });
+    mGeofenceUploadSender.setSendPacket([this](const mavlinkRouteTransfer::Packet &packet) { return sendRouteTransferPacket(packet); });
+    connect(&mGeofenceUploadSender, &mavlinkRouteTransfer::ChunkSender::finished, this, [this](bool success, bool gotAck) {
+        if (!success)
+            qDebug() << "Warning: MavsdkVehicleConnection's geofence upload failed" << (gotAck ? "." : "(no answer).");
+        emit geofenceUploadFinished(success);
+    });
+    subscribeMessage(MAVLINK_MSG_ID_V2_EXTENSION, [this](const mavlink_message_t &message) {
+        mavlinkRouteTransfer::Packet packet;
+        if (mavlink_msg_v2_extension_get_target_system(&message) == mMavlinkPassthrough->get_our_sysid() && mavlinkRouteTransfer::decodePacket(message, packet))
+            handleRouteTransferPacket(packet);
+    });
+
+    // Parameter mirror
+    subscribeMessage(MAVLINK_MSG_ID_PARAM_VALUE, [this](const mavlink_message_t &message) {
+        handleParameterValue(message);
+    });
+
     // Adaptive pure pursuit radius
-    mMavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_NAMED_VALUE_FLOAT, [this](const mavlink_message_t &message) {
+    subscribeMessage(MAVLINK_MSG_ID_NAMED_VALUE_FLOAT, [this](const mavlink_message_t &message) {
         mavlink_named_value_float_t mavMsg;
         mavlink_msg_named_value_float_decode(&message, &mavMsg);
+        getMessageTimestamp_ns(message.msgid, mavMsg.time_boot_ms);
         if (strcmp(mavMsg.name,"AR") == 0) {
             mavlink_msg_named_value_float_decode(&message, &mavMsg);
             mVehicleState->setAutopilotRadius(mavMsg.value);
+        } else if (strncmp(mavMsg.name, "CVY_GAP", sizeof(mavMsg.name)) == 0) {
+            mConvoyGap_m = mavMsg.value;
+            emit updatedConvoyGap(mavMsg.value);
+        } else if (strncmp(mavMsg.name, "SNS_MIN", sizeof(mavMsg.name)) == 0) {
+            mMinSensorRateRatio = mavMsg.value;
+        } else if (strncmp(mavMsg.name, "SNS_DEG", sizeof(mavMsg.name)) == 0) {
+            const quint32 degradedSensors = quint32(mavMsg.value);
+            if (degradedSensors != mDegradedSensors.exchange(degradedSensors) && degradedSensors != 0)
+                qDebug() << "Warning: vehicle" << mVehicleState->getId() << "reports degraded sensors" << QString::number(degradedSensors, 2);
+            emit updatedSensorHealth(degradedSensors, mMinSensorRateRatio);
+        } else if (strncmp(mavMsg.name, "RT_HDG", sizeof(mavMsg.name)) == 0) {
+            mRouteHeadingError_rad = mavMsg.value;
+        } else if (strncmp(mavMsg.name, "RT_ATP", sizeof(mavMsg.name)) == 0) {
+            mRouteAlongTrack_m = mavMsg.value;
+        } else if (strncmp(mavMsg.name, "RT_XTE", sizeof(mavMsg.name)) == 0) {
+            mRouteCrossTrackError_m = mavMsg.value;
+            mHasRouteTrackingError = true;
+            emit updatedRouteTrackingError(mavMsg.value, mRouteAlongTrack_m, mRouteHeadingError_rad);
         }
     });
 
+    // Performance counters
+    subscribeMessage(MAVLINK_MSG_ID_DEBUG_FLOAT_ARRAY, [this](const mavlink_message_t &message) {
+        mavlink_debug_float_array_t debugFloatArray;
+        mavlink_msg_debug_float_array_decode(&message, &debugFloatArray);
+        if (debugFloatArray.array_id == CommandLatencyTrace::MAVLINK_ARRAY_ID) {
+            if (strncmp(debugFloatArray.name, CommandLatencyTrace::MAVLINK_TRACE_NAME, sizeof(debugFloatArray.name)) == 0)
+                handleCommandLatencyTrace(debugFloatArray);
+            return;
+        }
+        if (debugFloatArray.array_id > static_cast<uint16_t>(PerfCounterSnapshot::Type::Latency))
+            return;
+        getMessageTimestamp_ns(message.msgid, uint32_t(debugFloatArray.time_usec / 1000));
+
+        VehiclePerfCounter perfCounter;
+        perfCounter.name = QString::fromLatin1(debugFloatArray.name, strnlen(debugFloatArray.name, sizeof(debugFloatArray.name)));
+        perfCounter.type = static_cast<PerfCounterSnapshot::Type>(debugFloatArray.array_id);
+        perfCounter.vehicleTime_us = debugFloatArray.time_usec;
+        for (int i = 0; i < PerfCounterSnapshot::getArraySize(perfCounter.type); i++)
+            perfCounter.values.append(debugFloatArray.data[i]);
+
+        {
+            std::lock_guard<std::mutex> lock(mPerfCountersMutex);
+            mPerfCounters.insert(perfCounter.name, perfCounter);
+        }
+        emit updatedPerfCounter(perfCounter.name);
+    });
+
     // Autopilot Target Point
-    mMavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED, [this](const mavlink_message_t &mavMsg) {
+    subscribeMessage(MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED, [this](const mavlink_message_t &mavMsg) {
         mavlink_position_target_local_ned_t autopilotPoints;
         mavlink_msg_position_target_local_ned_decode(&mavMsg, &autopilotPoints);
+        getMessageTimestamp_ns(mavMsg.msgid, autopilotPoints.time_boot_ms);
         xyz_t autopilotTargetPointENU = coordinateTransforms::nedToENU({autopilotPoints.x, autopilotPoints.y, 0});
         mVehicleState->setAutopilotTargetPoint(QPointF(autopilotTargetPointENU.x, autopilotTargetPointENU.y));
     });
 
-    // Set up action plugin
-    mAction.reset(new mavsdk::Action(mSystem));
+    // Clock synchronization
+    qRegisterMetaType<VehicleClockSync>();
+    qRegisterMetaType<CommandLatencyTraceResult>();
+    subscribeMessage(MAVLINK_MSG_ID_TIMESYNC, [this](const mavlink_message_t &message) {
+        handleTimesync(message);
+    });
+    connect(&mTimesyncTimer, &QTimer::timeout, this, &MavsdkVehicleConnection::sendTimesyncRequest);
+    mTimesyncTimer.start(TIMESYNC_INTERVAL_MS);
+    sendTimesyncRequest();
 
+    // Action plugin is created on first use
 // TODO: this should not happen here (blocking)
 //    // Precision Landing: set required target tracking accuracy for starting approach
 //    if (mParam->set_param_float("PLD_HACC_RAD", 5.0) != mavsdk::Param::Result::Success)
@@ -288,102 +404,440 @@ MavsdkVehicleConnection::MavsdkVehicleConnection(std::shared_ptr<mavsdk::System>
 
     // Necessary such that MAVSDK callbacks (from other threads) can stop WaypointFollower (QTimer)
     connect(this, &MavsdkVehicleConnection::stopWaypointFollowerSignal, this, &MavsdkVehicleConnection::stopAutopilot);
+
+    mManualControlTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mManualControlTimer, &QTimer::timeout, this, &MavsdkVehicleConnection::sendManualControl);
+
+    // Only the vehicle type is requested synchronously (it decides the state's class), the rest is asynchronous
+    qDebug() << "MavsdkVehicleConnection: set up in" << StartupProfile::getTimeSinceStart_ms() - setupStart_ms << "ms";
+    StartupProfile::getInstance().markPhase("ST_VEHICLE");
+}
+
+MavsdkVehicleConnection::~MavsdkVehicleConnection()
+{
+    mLandingTargetLoop.stop();
+    if (mMessageRouter)
+        for (const auto &handlerId : mRouterSubscriptions)
+            mMessageRouter->unsubscribe(handlerId);
+    mSystem->unsubscribe_component_discovered(mComponentDiscoveredHandle);
+    mParameterThread.quit();
+    mParameterThread.wait(); // a running request is finished first
+    delete mParameterThreadContext;
 }
 
-void MavsdkVehicleConnection::setupCarState(QSharedPointer<CarState> carState)
+void MavsdkVehicleConnection::setupTelemetryPlugin()
 {
-    auto vehicleParamResult = getFloatParameterFromVehicle("VEH_LENGTH");
-    if (vehicleParamResult.first == VehicleConnection::Result::Success) {
-        carState->setLength(vehicleParamResult.second);
+    mTelemetry.reset(new mavsdk::Telemetry(mSystem));
+
+    mTelemetry->subscribe_battery([this](mavsdk::Telemetry::Battery battery) {
+       emit updatedBatteryState(battery.voltage_v, battery.remaining_percent);
+    });
+
+    mTelemetry->subscribe_armed([this](bool isArmed) {
+       mVehicleState->setIsArmed(isArmed);
+    });
+
+    mTelemetry->subscribe_home([this](mavsdk::Telemetry::Position position) {
+        handleHomePosition({position.latitude_deg, position.longitude_deg, position.absolute_altitude_m});
+    });
+
+    if (mVehicleType == MAV_TYPE::MAV_TYPE_GROUND_ROVER) // assumption: rover = WayWise on vehicle side -> get NED (shared ENU ref), global pos otherwise
+        mTelemetry->subscribe_position_velocity_ned([this](mavsdk::Telemetry::PositionVelocityNed positionVelocity_ned) {
+            xyz_t positionNED = {positionVelocity_ned.position.north_m, positionVelocity_ned.position.east_m, positionVelocity_ned.position.down_m};
+            xyz_t positionENU = coordinateTransforms::nedToENU(positionNED);
+
+            // MAVSDK calls back from its own threads, only update own fields so concurrent heading updates are not lost
+            mVehicleState->updatePosition(PosType::simulated, [&positionENU](PosPoint &pos) {
+                pos.setXYZ(positionENU);
+            });
+        });
+    else
+        mTelemetry->subscribe_position([this](mavsdk::Telemetry::Position position) {
+            llh_t llh = {position.latitude_deg, position.longitude_deg, position.absolute_altitude_m};
+            xyz_t xyz = mEnuFrame.llhToEnu(llh);
+
+            mVehicleState->updatePosition(PosType::simulated, [&xyz](PosPoint &pos) {
+                pos.setX(xyz.x);
+                pos.setY(xyz.y);
+                pos.setHeight(xyz.z);
+            });
+        });
+
+    mTelemetry->subscribe_heading([this](mavsdk::Telemetry::Heading heading) {
+        mVehicleState->updatePosition(PosType::simulated, [&heading](PosPoint &pos) {
+            pos.setYaw(coordinateTransforms::yawNEDtoENU(heading.heading_deg));
+        });
+    });
+
+    mTelemetry->subscribe_velocity_ned([this](mavsdk::Telemetry::VelocityNed velocity) {
+        xyz_t velocityNED {velocity.north_m_s, velocity.east_m_s, velocity.down_m_s};
+        xyz_t velocityENU = coordinateTransforms::nedToENU(velocityNED);
+        mVehicleState->setVelocity(velocityENU);
+    });
+
+    if (mVehicleType == MAV_TYPE::MAV_TYPE_QUADROTOR) {
+        mTelemetry->subscribe_landed_state([this](mavsdk::Telemetry::LandedState landedState) {
+           mVehicleState.dynamicCast<CopterState>()->setLandedState(static_cast<CopterState::LandedState>(landedState));
+        });
     }
-    vehicleParamResult = getFloatParameterFromVehicle("VEH_WIDTH");
-    if (vehicleParamResult.first == VehicleConnection::Result::Success) {
-        carState->setWidth(vehicleParamResult.second);
+
+    mTelemetry->subscribe_flight_mode([this](mavsdk::Telemetry::FlightMode flightMode) {
+        handleFlightMode(static_cast<VehicleState::FlightMode>(flightMode));
+//            qDebug() << (int)flightMode << (mOffboard ? mOffboard->is_active() : false);
+    });
+}
+
+void MavsdkVehicleConnection::setupTelemetryMessages()
+{
+    // Decoded from the messages MAVSDK's Telemetry plugin uses, no message rates are requested (vehicles send their defaults)
+    subscribeMessage(MAVLINK_MSG_ID_HEARTBEAT, [this](const mavlink_message_t &message) {
+        mavlink_heartbeat_t heartbeat;
+        mavlink_msg_heartbeat_decode(&message, &heartbeat);
+        if ((MAV_AUTOPILOT)heartbeat.autopilot == MAV_AUTOPILOT_INVALID) // e.g., camera component
+            return;
+
+        mVehicleState->setIsArmed(heartbeat.base_mode & MAV_MODE_FLAG_SAFETY_ARMED);
+        handleFlightMode(px4FlightMode(heartbeat));
+    });
+
+    subscribeMessage(MAVLINK_MSG_ID_SYS_STATUS, [this](const mavlink_message_t &message) {
+        mavlink_sys_status_t sysStatus;
+        mavlink_msg_sys_status_decode(&message, &sysStatus);
+        if (sysStatus.voltage_battery != UINT16_MAX)
+            emit updatedBatteryState(sysStatus.voltage_battery / 1000.0, sysStatus.battery_remaining >= 0 ? sysStatus.battery_remaining : NAN);
+    });
+
+    subscribeMessage(MAVLINK_MSG_ID_BATTERY_STATUS, [this](const mavlink_message_t &message) {
+        mavlink_battery_status_t batteryStatus;
+        mavlink_msg_battery_status_decode(&message, &batteryStatus);
+        if (batteryStatus.id != 0)
+            return;
+
+        double voltage_mV = 0.0;
+        for (const auto cellVoltage_mV : batteryStatus.voltages)
+            if (cellVoltage_mV != UINT16_MAX)
+                voltage_mV += cellVoltage_mV;
+        emit updatedBatteryState(voltage_mV / 1000.0, batteryStatus.battery_remaining >= 0 ? batteryStatus.battery_remaining : NAN);
+    });
+
+    subscribeMessage(MAVLINK_MSG_ID_HOME_POSITION, [this](const mavlink_message_t &message) {
+        mavlink_home_position_t homePosition;
+        mavlink_msg_home_position_decode(&message, &homePosition);
+        handleHomePosition({homePosition.latitude * 1e-7, homePosition.longitude * 1e-7, homePosition.altitude * 1e-3});
+    });
+
+    if (mVehicleType == MAV_TYPE::MAV_TYPE_GROUND_ROVER) // see setupTelemetryPlugin()
+        subscribeMessage(MAVLINK_MSG_ID_LOCAL_POSITION_NED, [this](const mavlink_message_t &message) {
+            mavlink_local_position_ned_t localPosition;
+            mavlink_msg_local_position_ned_decode(&message, &localPosition);
+            const xyz_t positionENU = coordinateTransforms::nedToENU({localPosition.x, localPosition.y, localPosition.z});
+            const qint64 timestamp_ns = getMessageTimestamp_ns(message.msgid, localPosition.time_boot_ms);
+
+            mVehicleState->updatePosition(PosType::simulated, [&positionENU, timestamp_ns](PosPoint &pos) {
+                pos.setXYZ(positionENU);
+                pos.setTimestamp_ns(timestamp_ns);
+            });
+        });
+
+    // Global position, heading and velocity (like MAVSDK, from GLOBAL_POSITION_INT)
+    subscribeMessage(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, [this](const mavlink_message_t &message) {
+        mavlink_global_position_int_t globalPosition;
+        mavlink_msg_global_position_int_decode(&message, &globalPosition);
+
+        const bool useGlobalPosition = (mVehicleType != MAV_TYPE::MAV_TYPE_GROUND_ROVER);
+        const xyz_t xyz = useGlobalPosition ? mEnuFrame.llhToEnu({globalPosition.lat * 1e-7, globalPosition.lon * 1e-7, globalPosition.alt * 1e-3}) : xyz_t();
+        const bool hasHeading = (globalPosition.hdg != UINT16_MAX);
+        const qint64 timestamp_ns = getMessageTimestamp_ns(message.msgid, globalPosition.time_boot_ms);
+        mVehicleState->updatePosition(PosType::simulated, [&](PosPoint &pos) {
+            pos.setTimestamp_ns(timestamp_ns);
+            if (useGlobalPosition) {
+                pos.setX(xyz.x);
+                pos.setY(xyz.y);
+                pos.setHeight(xyz.z);
+            }
+            if (hasHeading)
+                pos.setYaw(coordinateTransforms::yawNEDtoENU(globalPosition.hdg * 0.01));
+        });
+
+        mVehicleState->setVelocity(coordinateTransforms::nedToENU({globalPosition.vx * 0.01, globalPosition.vy * 0.01, globalPosition.vz * 0.01}));
+    });
+
+    if (mVehicleType == MAV_TYPE::MAV_TYPE_QUADROTOR) {
+        subscribeMessage(MAVLINK_MSG_ID_EXTENDED_SYS_STATE, [this](const mavlink_message_t &message) {
+            const uint8_t landedState = mavlink_msg_extended_sys_state_get_landed_state(&message);
+            mVehicleState.dynamicCast<CopterState>()->setLandedState(landedState <= MAV_LANDED_STATE_LANDING ?
+                                                                         static_cast<CopterState::LandedState>(landedState) : CopterState::LandedState::Unknown);
+        });
     }
-    vehicleParamResult = getFloatParameterFromVehicle("VEH_WHLBASE");
-    if (vehicleParamResult.first == VehicleConnection::Result::Success) {
-        carState->setAxisDistance(vehicleParamResult.second);
+
+    subscribeMessage(MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN, [this](const mavlink_message_t &message) {
+        mavlink_gps_global_origin_t gpsGlobalOrigin;
+        mavlink_msg_gps_global_origin_decode(&message, &gpsGlobalOrigin);
+        mGpsGlobalOrigin = {gpsGlobalOrigin.latitude * 1e-7, gpsGlobalOrigin.longitude * 1e-7, gpsGlobalOrigin.altitude * 1e-3};
+        QMetaObject::invokeMethod(this, [this]() { updateLandingTargetFrames(); }, Qt::QueuedConnection);
+        emit gotVehicleENUreferenceLlh(mGpsGlobalOrigin);
+    });
+}
+
+void MavsdkVehicleConnection::handleHomePosition(const llh_t &homeLlh)
+{
+    xyz_t xyz = mEnuFrame.llhToEnu(homeLlh);
+
+    auto homePos = mVehicleState->getHomePosition();
+    homePos.setX(xyz.x);
+    homePos.setY(xyz.y);
+    homePos.setHeight(xyz.z);
+    mVehicleState->setHomePosition(homePos);
+
+    emit gotVehicleHomeLlh(homeLlh);
+}
+
+void MavsdkVehicleConnection::handleFlightMode(VehicleState::FlightMode flightMode)
+{
+    mVehicleState->setFlightMode(flightMode);
+
+    if (flightMode != VehicleState::FlightMode::Offboard &&
+            flightMode != VehicleState::FlightMode::Hold)
+        if (hasWaypointFollowerConnectionLocal() && isAutopilotActive()) {
+            emit stopWaypointFollowerSignal();
+            qDebug() << "MavsdkVehicleConnection: connection-local WaypointFollower stopped by flightmode change (Note: can only be started in hold mode).";
+        }
+}
+
+void MavsdkVehicleConnection::sendTimesyncRequest()
+{
+    const int64_t ts1 = mavlinkTimesync::tag(utcTime::now_ns(), mavlinkTimesync::REQUEST_TAG);
+    {
+        std::lock_guard<std::mutex> lock(mClockSyncMutex);
+        mTimesyncRequests[mNextTimesyncRequest] = ts1;
+        mNextTimesyncRequest = (mNextTimesyncRequest + 1) % TIMESYNC_PENDING_REQUESTS;
     }
 
-    vehicleParamResult = getFloatParameterFromVehicle("VEH_RA2CO_X");
-    if (vehicleParamResult.first == VehicleConnection::Result::Success) {
-        carState->setRearAxleToCenterOffset(vehicleParamResult.second);
+    mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+        mavlink_message_t mavTimesyncMsg;
+        mavlink_timesync_t request;
+        memset(&request, 0, sizeof(mavlink_timesync_t));
+
+        request.tc1 = 0;
+        request.ts1 = ts1;
+        request.target_system = mMavlinkPassthrough->get_target_sysid();
+        request.target_component = mMavlinkPassthrough->get_target_compid();
+        mavlink_msg_timesync_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavTimesyncMsg, &request);
+
+        return mavTimesyncMsg;
+    });
+}
+
+void MavsdkVehicleConnection::handleTimesync(const mavlink_message_t &message)
+{
+    const qint64 receive_ns = utcTime::now_ns();
+    mavlink_timesync_t response;
+    mavlink_msg_timesync_decode(&message, &response);
+    if (response.tc1 == 0 || !mavlinkTimesync::isTagged(response.ts1, mavlinkTimesync::REQUEST_TAG))
+        return; // a request, or an answer to someone else
+    // Untagged answers of WayWise vehicles are MAVSDK's (another time base), PX4's are in its time_boot_ms base
+    if (!mavlinkTimesync::isTagged(response.tc1, mavlinkTimesync::RESPONSE_TAG) && mVehicleType != MAV_TYPE_QUADROTOR)
+        return;
+
+    VehicleClockSync clockSync;
+    {
+        std::lock_guard<std::mutex> lock(mClockSyncMutex);
+        if (std::find(mTimesyncRequests.begin(), mTimesyncRequests.end(), response.ts1) == mTimesyncRequests.end())
+            return;
+        std::replace(mTimesyncRequests.begin(), mTimesyncRequests.end(), response.ts1, int64_t(0)); // duplicates would be biased
+
+        const bool wasSynchronized = mClockSync.isSynchronized();
+        const int samples = mClockSync.getNumSamples();
+        if (!mClockSync.addSample(response.ts1, response.tc1, receive_ns))
+            return;
+        if (wasSynchronized && mClockSync.getNumSamples() < samples)
+            qDebug() << "MavsdkVehicleConnection: clock of vehicle" << mSystem->get_system_id() << "jumped (restarted?), resynchronizing.";
+        clockSync = getClockSyncLocked();
     }
-    vehicleParamResult = getFloatParameterFromVehicle("VEH_RA2REO_X");
-    if (vehicleParamResult.first == VehicleConnection::Result::Success) {
-        carState->setRearAxleToRearEndOffset(vehicleParamResult.second);
+    emit updatedClockSync(clockSync);
+}
+
+VehicleClockSync MavsdkVehicleConnection::getClockSync() const
+{
+    std::lock_guard<std::mutex> lock(mClockSyncMutex);
+    return getClockSyncLocked();
+}
+
+VehicleClockSync MavsdkVehicleConnection::getClockSyncLocked() const
+{
+    VehicleClockSync clockSync;
+    clockSync.synchronized = mClockSync.isSynchronized();
+    clockSync.offset_ms = mClockSync.getOffset_ns() / utcTime::NS_PER_MS;
+    clockSync.skew_ppm = mClockSync.getSkew_ppm();
+    clockSync.lastRoundTrip_ms = double(mClockSync.getLastRoundTrip_ns()) / utcTime::NS_PER_MS;
+    clockSync.minRoundTrip_ms = double(mClockSync.getMinRoundTrip_ns()) / utcTime::NS_PER_MS;
+    clockSync.samples = mClockSync.getNumSamples();
+    return clockSync;
+}
+
+qint64 MavsdkVehicleConnection::vehicleTimeToUtc_ns(qint64 vehicleTime_ns) const
+{
+    std::lock_guard<std::mutex> lock(mClockSyncMutex);
+    return mClockSync.toLocal_ns(vehicleTime_ns);
+}
+
+qint64 MavsdkVehicleConnection::vehicleTimeBootToUtc_ns(uint32_t time_boot_ms) const
+{
+    std::lock_guard<std::mutex> lock(mClockSyncMutex);
+    const int64_t vehicleTime_ns = unwrapTimeBoot_ns(time_boot_ms);
+    return vehicleTime_ns < 0 ? utcTime::INVALID : mClockSync.toLocal_ns(vehicleTime_ns);
+}
+
+int64_t MavsdkVehicleConnection::unwrapTimeBoot_ns(uint32_t time_boot_ms) const
+{
+    const qint64 vehicleNow_ns = mClockSync.toRemote_ns(utcTime::now_ns());
+    if (vehicleNow_ns == utcTime::INVALID)
+        return -1;
+
+    // Closest to the vehicle's current time
+    constexpr int64_t WRAP_MS = int64_t(1) << 32;
+    const int64_t vehicleNow_ms = vehicleNow_ns / utcTime::NS_PER_MS;
+    int64_t unwrapped_ms = (vehicleNow_ms & ~(WRAP_MS - 1)) | time_boot_ms;
+    if (unwrapped_ms - vehicleNow_ms > WRAP_MS / 2)
+        unwrapped_ms -= WRAP_MS;
+    else if (vehicleNow_ms - unwrapped_ms > WRAP_MS / 2)
+        unwrapped_ms += WRAP_MS;
+    return unwrapped_ms * utcTime::NS_PER_MS;
+}
+
+qint64 MavsdkVehicleConnection::getMessageTimestamp_ns(uint16_t messageId, uint32_t time_boot_ms)
+{
+    const qint64 receive_ns = utcTime::now_ns();
+    std::lock_guard<std::mutex> lock(mClockSyncMutex);
+    const int64_t vehicleTime_ns = unwrapTimeBoot_ns(time_boot_ms);
+    if (vehicleTime_ns < 0)
+        return receive_ns;
+
+    const qint64 send_ns = mClockSync.toLocal_ns(vehicleTime_ns);
+    const double latency_ms = double(receive_ns - send_ns) / utcTime::NS_PER_MS;
+    VehicleMessageLatency &latency = mMessageLatencies[messageId];
+    latency.last_ms = latency_ms;
+    latency.mean_ms = (latency.samples == 0) ? latency_ms : latency.mean_ms + MESSAGE_LATENCY_AVERAGING * (latency_ms - latency.mean_ms);
+    latency.max_ms = (latency.samples == 0) ? latency_ms : std::max(latency.max_ms, latency_ms);
+    latency.samples++;
+    return send_ns;
+}
+
+QMap<uint16_t, VehicleMessageLatency> MavsdkVehicleConnection::getMessageLatencies() const
+{
+    std::lock_guard<std::mutex> lock(mClockSyncMutex);
+    return mMessageLatencies;
+}
+
+VehicleMessageLatency MavsdkVehicleConnection::getMessageLatency(uint16_t messageId) const
+{
+    std::lock_guard<std::mutex> lock(mClockSyncMutex);
+    return mMessageLatencies.value(messageId);
+}
+
+void MavsdkVehicleConnection::subscribeMessage(uint16_t messageId, std::function<void(const mavlink_message_t &)> handler)
+{
+    if (mMessageRouter)
+        mRouterSubscriptions.append(mMessageRouter->subscribe(mSystem->get_system_id(), messageId, handler));
+    else
+        mMavlinkPassthrough->subscribe_message(messageId, handler);
+}
+
+std::shared_ptr<mavsdk::Action> MavsdkVehicleConnection::getActionPlugin()
+{
+    std::lock_guard<std::mutex> lock(mPluginMutex);
+    if (!mAction)
+        mAction.reset(new mavsdk::Action(mSystem));
+    return mAction;
+}
+
+std::shared_ptr<mavsdk::Param> MavsdkVehicleConnection::getParamPlugin() const
+{
+    std::lock_guard<std::mutex> lock(mPluginMutex);
+    if (!mParam)
+        mParam.reset(new mavsdk::Param(mSystem));
+    return mParam;
+}
+
+void MavsdkVehicleConnection::getFloatParametersFromVehicleAsync(const QList<QPair<std::string, std::function<void(float)>>> &parameters,
+                                                                 std::function<void()> finished)
+{
+    QSharedPointer<int> pending = QSharedPointer<int>::create(parameters.size());
+    for (const auto &parameter : parameters) {
+        const std::function<void(float)> apply = parameter.second;
+        getFloatParameterFromVehicleAsync(parameter.first, [pending, apply, finished](VehicleConnection::Result result, float value) {
+            if (result == VehicleConnection::Result::Success)
+                apply(value);
+            if (--(*pending) == 0 && finished)
+                finished();
+        });
     }
-    carState->setStateInitialized(true);
+}
+
+void MavsdkVehicleConnection::setupCarState(QSharedPointer<CarState> carState, QList<QPair<std::string, std::function<void(float)>>> parameters)
+{
+    parameters.prepend({"VEH_RA2REO_X", [carState](float value) { carState->setRearAxleToRearEndOffset(value); }});
+    parameters.prepend({"VEH_RA2CO_X", [carState](float value) { carState->setRearAxleToCenterOffset(value); }});
+    parameters.prepend({"VEH_WHLBASE", [carState](float value) { carState->setAxisDistance(value); }});
+    parameters.prepend({"VEH_WIDTH", [carState](float value) { carState->setWidth(value); }});
+    parameters.prepend({"VEH_LENGTH", [carState](float value) { carState->setLength(value); }});
+    getFloatParametersFromVehicleAsync(parameters, [carState]() { carState->setStateInitialized(true); });
 }
 
 void MavsdkVehicleConnection::setupTruckState(QSharedPointer<TruckState> truckState)
 {
-    setupCarState(truckState);
-    auto vehicleParamResult = getFloatParameterFromVehicle("VEH_RA2HO_X");
-    if (vehicleParamResult.first == VehicleConnection::Result::Success) {
-        truckState->setRearAxleToHitchOffset(vehicleParamResult.second);
-    }
-    truckState->setStateInitialized(true);
-
-    auto trailerParamResult = getIntParameterFromVehicle("TRLR_COMP_ID");
-    if (trailerParamResult.first == VehicleConnection::Result::Success) {
-        int trailer_component_id = trailerParamResult.second;
-        if (trailer_component_id>=0) {
-            // Setup Trailer
-            mavsdk::System::ComponentDiscoveredIdHandle mComponentDiscoveredIdHandle = mSystem->subscribe_component_discovered_id([this, truckState, trailer_component_id](mavsdk::System::ComponentType component_type, uint8_t component_id){
-                if (component_type == mavsdk::System::ComponentType::UNKNOWN && component_id == (uint8_t) trailer_component_id) {
-                    qDebug() << "Trailer discovered with system ID "<< mSystem->get_system_id() << " and component ID "<< component_id;
-                    truckState->setTrailingVehicle(QSharedPointer<TrailerState>::create(component_id));
-                    QSharedPointer<TrailerState> mTrailerState = truckState->getTrailingVehicle();
-                    mTrailerState->setName("Trailer " + QString::number(mSystem->get_system_id()));
-
-                    auto trailerParamResult = getFloatParameterFromVehicle("TRLR_LENGTH");
-                    if (trailerParamResult.first == VehicleConnection::Result::Success) {
-                        mTrailerState->setLength(trailerParamResult.second);
-                    }
-                    trailerParamResult = getFloatParameterFromVehicle("TRLR_WIDTH");
-                    if (trailerParamResult.first == VehicleConnection::Result::Success) {
-                        mTrailerState->setWidth(trailerParamResult.second);
-                    }
-                    trailerParamResult = getFloatParameterFromVehicle("TRLR_WHLBASE");
-                    if (trailerParamResult.first == VehicleConnection::Result::Success) {
-                        mTrailerState->setWheelBase(trailerParamResult.second);
-                    }
+    setupCarState(truckState, {{"VEH_RA2HO_X", [truckState](float value) { truckState->setRearAxleToHitchOffset(value); }}});
 
-                    trailerParamResult = getFloatParameterFromVehicle("TRLR_RA2CO_X");
-                    if (trailerParamResult.first == VehicleConnection::Result::Success) {
-                        mTrailerState->setRearAxleToCenterOffset(trailerParamResult.second);
-                    }
-                    trailerParamResult = getFloatParameterFromVehicle("TRLR_RA2REO_X");
-                    if (trailerParamResult.first == VehicleConnection::Result::Success) {
-                        mTrailerState->setRearAxleToRearEndOffset(trailerParamResult.second);
-                    }
-                    trailerParamResult = getFloatParameterFromVehicle("TRLR_RA2HO_X");
-                    if (trailerParamResult.first == VehicleConnection::Result::Success) {
-                        qDebug() << "Got trailer hitch offset: "<< trailerParamResult.second;
-                        mTrailerState->setRearAxleToHitchOffset(trailerParamResult.second);
-                    }
-                    mTrailerState->setStateInitialized(true);
+    getIntParameterFromVehicleAsync("TRLR_COMP_ID", [this, truckState](VehicleConnection::Result result, int32_t trailer_component_id) {
+        if (result != VehicleConnection::Result::Success || trailer_component_id < 0)
+            return;
 
-                    mMavlinkPassthrough->subscribe_message(MAVLINK_MSG_ID_NAMED_VALUE_FLOAT, [truckState, component_id](const mavlink_message_t &message) {
-                        if (message.compid == component_id) {
-                            mavlink_named_value_float_t mavMsg;
+        // Setup Trailer (discovery callbacks run in MAVSDK threads, parameters are requested from ours)
+        mavsdk::System::ComponentDiscoveredIdHandle componentDiscoveredIdHandle = mSystem->subscribe_component_discovered_id([this, truckState, trailer_component_id](mavsdk::System::ComponentType component_type, uint8_t component_id){
+            if (component_type != mavsdk::System::ComponentType::UNKNOWN || component_id != (uint8_t) trailer_component_id)
+                return;
+
+            QMetaObject::invokeMethod(this, [this, truckState, component_id]() {
+                qDebug() << "Trailer discovered with system ID "<< mSystem->get_system_id() << " and component ID "<< component_id;
+                truckState->setTrailingVehicle(QSharedPointer<TrailerState>::create(component_id));
+                QSharedPointer<TrailerState> trailerState = truckState->getTrailingVehicle();
+                trailerState->setName("Trailer " + QString::number(mSystem->get_system_id()));
+
+                getFloatParametersFromVehicleAsync({
+                    {"TRLR_LENGTH", [trailerState](float value) { trailerState->setLength(value); }},
+                    {"TRLR_WIDTH", [trailerState](float value) { trailerState->setWidth(value); }},
+                    {"TRLR_WHLBASE", [trailerState](float value) { trailerState->setWheelBase(value); }},
+                    {"TRLR_RA2CO_X", [trailerState](float value) { trailerState->setRearAxleToCenterOffset(value); }},
+                    {"TRLR_RA2REO_X", [trailerState](float value) { trailerState->setRearAxleToRearEndOffset(value); }},
+                    {"TRLR_RA2HO_X", [trailerState](float value) {
+                        qDebug() << "Got trailer hitch offset: "<< value;
+                        trailerState->setRearAxleToHitchOffset(value);
+                    }}
+                }, [trailerState]() { trailerState->setStateInitialized(true); });
+
+                subscribeMessage(MAVLINK_MSG_ID_NAMED_VALUE_FLOAT, [truckState, component_id](const mavlink_message_t &message) {
+                    if (message.compid == component_id) {
+                        mavlink_named_value_float_t mavMsg;
+                        mavlink_msg_named_value_float_decode(&message, &mavMsg);
+                        if (strcmp(mavMsg.name,"TRLR_YAW") == 0) {
                             mavlink_msg_named_value_float_decode(&message, &mavMsg);
-                            if (strcmp(mavMsg.name,"TRLR_YAW") == 0) {
-                                mavlink_msg_named_value_float_decode(&message, &mavMsg);
-                                truckState->setTrailerAngle(truckState->getPosition().getYaw() - mavMsg.value);
-                            }
+                            truckState->setTrailerAngle(truckState->getPosition().getYaw() - mavMsg.value);
                         }
-                    });
-                }
-            });
-        }
-    }
+                    }
+                });
+            }, Qt::QueuedConnection);
+        });
+        Q_UNUSED(componentDiscoveredIdHandle)
+    });
 }
 
 void MavsdkVehicleConnection::setEnuReference(const llh_t &enuReference)
 {
-    mEnuReference = enuReference;
+    const coordinateTransforms::EnuFrame enuFrame(enuReference);
+    if (mVehicleState && mVehicleType != MAV_TYPE::MAV_TYPE_GROUND_ROVER)
+        mVehicleState->reprojectEnu(mEnuFrame.getTransformTo(enuFrame));
+    mEnuFrame = enuFrame;
+    updateLandingTargetFrames();
 }
 
 void MavsdkVehicleConnection::setHomeLlh(const llh_t &homeLlh)
@@ -402,7 +856,7 @@ void MavsdkVehicleConnection::setHomeLlh(const llh_t &homeLlh)
     ComLong.param7 = homeLlh.height;
 
     if (mMavlinkPassthrough->send_command_long(ComLong) == mavsdk::MavlinkPassthrough::Result::Success) {
-        xyz_t xyz = coordinateTransforms::llhToEnu(mEnuReference, homeLlh);
+        xyz_t xyz = mEnuFrame.llhToEnu(homeLlh);
 
         auto homePos = mVehicleState->getHomePosition();
         homePos.setX(xyz.x);
@@ -414,7 +868,7 @@ void MavsdkVehicleConnection::setHomeLlh(const llh_t &homeLlh)
 
 void MavsdkVehicleConnection::requestArm()
 {
-    mAction->arm_async([](mavsdk::Action::Result res){
+    getActionPlugin()->arm_async([](mavsdk::Action::Result res){
         if (res != mavsdk::Action::Result::Success)
             qDebug() << "Warning: MavsdkVehicleConnection's arm request failed.";
     });
@@ -422,7 +876,7 @@ void MavsdkVehicleConnection::requestArm()
 
 void MavsdkVehicleConnection::requestDisarm()
 {
-    mAction->disarm_async([](mavsdk::Action::Result res){
+    getActionPlugin()->disarm_async([](mavsdk::Action::Result res){
         if (res != mavsdk::Action::Result::Success)
             qDebug() << "Warning: MavsdkVehicleConnection's disarm request failed.";
     });
@@ -431,7 +885,7 @@ void MavsdkVehicleConnection::requestDisarm()
 void MavsdkVehicleConnection::requestTakeoff()
 {
     if (mVehicleType == MAV_TYPE::MAV_TYPE_QUADROTOR) {
-        mAction->takeoff_async([](mavsdk::Action::Result res){
+        getActionPlugin()->takeoff_async([](mavsdk::Action::Result res){
             if (res != mavsdk::Action::Result::Success)
                 qDebug() << "Warning: MavsdkVehicleConnection's takeoff request failed.";
         });
@@ -442,7 +896,7 @@ void MavsdkVehicleConnection::requestTakeoff()
 void MavsdkVehicleConnection::requestLanding()
 {
     if (mVehicleType == MAV_TYPE::MAV_TYPE_QUADROTOR) {
-        mAction->land_async([](mavsdk::Action::Result res){
+        getActionPlugin()->land_async([](mavsdk::Action::Result res){
             if (res != mavsdk::Action::Result::Success)
                 qDebug() << "Warning: MavsdkVehicleConnection's land request failed.";
         });
@@ -469,7 +923,7 @@ void MavsdkVehicleConnection::requestPrecisionLanding()
 void MavsdkVehicleConnection::requestReturnToHome()
 {
     if (mVehicleType == MAV_TYPE::MAV_TYPE_QUADROTOR) {
-        mAction->return_to_launch_async([](mavsdk::Action::Result res){
+        getActionPlugin()->return_to_launch_async([](mavsdk::Action::Result res){
             if (res != mavsdk::Action::Result::Success)
                 qDebug() << "Warning: MavsdkVehicleConnection's return to home request failed.";
         });
@@ -514,7 +968,7 @@ void MavsdkVehicleConnection::requestFollowPoint()
 void MavsdkVehicleConnection::requestGotoLlh(const llh_t &llh, bool changeFlightmodeToHold)
 {
     if (changeFlightmodeToHold) { // MAVSDK will change flightmode if necessary, not always desired
-        mAction->goto_location_async(llh.latitude, llh.longitude, llh.height, NAN, [](mavsdk::Action::Result res){
+        getActionPlugin()->goto_location_async(llh.latitude, llh.longitude, llh.height, NAN, [](mavsdk::Action::Result res){
             if (res != mavsdk::Action::Result::Success)
                 qDebug() << "Warning: MavsdkVehicleConnection's goto request failed.";
         });
@@ -538,7 +992,7 @@ void MavsdkVehicleConnection::requestGotoLlh(const llh_t &llh, bool changeFlight
 void MavsdkVehicleConnection::requestGotoENU(const xyz_t &xyz, bool changeFlightmodeToHold)
 {
     if (mConvertLocalPositionsToGlobalBeforeSending) {
-        llh_t llh = coordinateTransforms::enuToLlh(mEnuReference, xyz);
+        llh_t llh = mEnuFrame.enuToLlh(xyz);
         requestGotoLlh(llh, changeFlightmodeToHold);
     } else {
         qDebug() << "MavsdkVehicleConnection::requestGotoENU: sending local coordinates to vehicle without converting not implemented.";
@@ -563,102 +1017,187 @@ void MavsdkVehicleConnection::requestVelocityAndYaw(const xyz_t &velocityENU, co
     mOffboard->set_velocity_ned({(float)(velocityNED.x), (float)(velocityNED.y), (float)(velocityNED.z), (float)(coordinateTransforms::yawENUtoNED(yawDeg))});
 }
 
-void MavsdkVehicleConnection::inputRtcmData(const QByteArray &rtcmData)
+bool MavlinkRtcmFragments::setRtcmData(const QByteArray &rtcmData, uint8_t sequenceId)
 {
     // See: https://github.com/mavlink/qgroundcontrol/blob/aba881bf8e3f2fdbf63ef0689a3bf0432f597759/src/GPS/RTCM/RTCMMavlink.cc#L24
+    numFragments = 0;
+    if (rtcmData.size() > maxFragments * MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN)
+        return false;
+
+    if (rtcmData.length() < MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN) {
+        mavlink_gps_rtcm_data_t &mavRtcmData = fragments[numFragments++];
+        memset(&mavRtcmData, 0, sizeof(mavlink_gps_rtcm_data_t));
+
+        mavRtcmData.len = rtcmData.length();
+        mavRtcmData.flags = (sequenceId & 0x1F) << 3;
+        memcpy(mavRtcmData.data, rtcmData.data(), rtcmData.size());
+    } else { // rtcm data needs to be fragmented into multiple messages
+        int numBytesProcessed = 0;
+        while (numBytesProcessed < rtcmData.size()) {
+            int fragmentLength = std::min(rtcmData.size() - numBytesProcessed, MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN);
+            mavlink_gps_rtcm_data_t &mavRtcmData = fragments[numFragments];
+            memset(&mavRtcmData, 0, sizeof(mavlink_gps_rtcm_data_t));
+
+            mavRtcmData.flags = 1;                          // LSB set indicates message is fragmented
+            mavRtcmData.flags |= numFragments++ << 1;       // Next 2 bits are fragment id
+            mavRtcmData.flags |= (sequenceId & 0x1F) << 3;  // Next 5 bits are sequence id
+            mavRtcmData.len = fragmentLength;
+            memcpy(mavRtcmData.data, rtcmData.data() + numBytesProcessed, fragmentLength);
+
+            numBytesProcessed += fragmentLength;
+        }
+    }
+
+    return true;
+}
+
+void MavsdkVehicleConnection::inputRtcmData(const QByteArray &rtcmData)
+{
     if (mMavlinkPassthrough == nullptr)
         return;
 
-    static uint8_t sequenceId = 0;
+    if (!mRtcmFragments.setRtcmData(rtcmData, mRtcmSequenceId++)) {
+        qWarning() << "RTCM message too large for MAVLINK (" << rtcmData.size() << "bytes), dropped";
+        return;
+    }
+    inputRtcmFragments(mRtcmFragments);
+}
 
-    if (rtcmData.length() < MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN) {
+void MavsdkVehicleConnection::inputRtcmFragments(const MavlinkRtcmFragments &rtcmFragments)
+{
+    if (mMavlinkPassthrough == nullptr)
+        return;
+
+    for (int i = 0; i < rtcmFragments.numFragments; i++) {
         auto result = mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
                 mavlink_message_t mavRtcmMsg;
-                mavlink_gps_rtcm_data_t mavRtcmData;
-                memset(&mavRtcmData, 0, sizeof(mavlink_gps_rtcm_data_t));
-
-                mavRtcmData.len = rtcmData.length();
-                mavRtcmData.flags = (sequenceId & 0x1F) << 3;
-                memcpy(mavRtcmData.data, rtcmData.data(), rtcmData.size());
-
-                mavlink_msg_gps_rtcm_data_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavRtcmMsg, &mavRtcmData);
+                mavlink_msg_gps_rtcm_data_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavRtcmMsg, &rtcmFragments.fragments[i]);
                 return mavRtcmMsg;
             });
         if (result != mavsdk::MavlinkPassthrough::Result::Success)
             qWarning() << "Could not send RTCM via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
-    } else { // rtcm data needs to be fragmented into multiple messages
-        uint8_t fragmentId = 0;
-        int numBytesProcessed = 0;
-        while (numBytesProcessed < rtcmData.size()) {
-            int fragmentLength = std::min(rtcmData.size() - numBytesProcessed, MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN);
-            auto result = mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
-                    mavlink_message_t mavRtcmMsg;
-                    mavlink_gps_rtcm_data_t mavRtcmData;
-                    memset(&mavRtcmData, 0, sizeof(mavlink_gps_rtcm_data_t));
-
-                    mavRtcmData.flags = 1;                          // LSB set indicates message is fragmented
-                    mavRtcmData.flags |= fragmentId++ << 1;         // Next 2 bits are fragment id
-                    mavRtcmData.flags |= (sequenceId & 0x1F) << 3;  // Next 5 bits are sequence id
-                    mavRtcmData.len = fragmentLength;
-                    memcpy(mavRtcmData.data, rtcmData.data() + numBytesProcessed, fragmentLength);
-
-                    mavlink_msg_gps_rtcm_data_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavRtcmMsg, &mavRtcmData);
-                    return mavRtcmMsg;
-                });
-            if (result != mavsdk::MavlinkPassthrough::Result::Success)
-                qWarning() << "Could not send RTCM via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
-            numBytesProcessed += fragmentLength;
-        }
     }
+}
+
+void MavsdkVehicleConnection::sendLandingTargetLlh(const llh_t &landingTargetLlh)
+{
+    if (mMavlinkPassthrough == nullptr)
+        return;
+
+    // Note from https://docs.px4.io/master/en/advanced_features/precland.html#mission
+    // The system must publish the coordinates of the target in the LANDING_TARGET message.
+    // Note that PX4 requires LANDING_TARGET.frame to be MAV_FRAME_LOCAL_NED and only populates the fields x, y, and z.
+    // The origin of the local NED frame [0,0] is the home position.
+
+    // Note by Marvin: not home position, gps origin! I tried to update gps origin using mavlink_set_gps_global_origin_t,
+    // but it is not updated while flying (PX4 1.12). Thus, we need to take their gps origin for calculating landing target in NED here.
+
+    // From Llh to their ENU
+    const xyz_t landingTargetENUgpsOrigin = mLandingTargetFrames.load().vehicleOrigin.llhToEnu(landingTargetLlh);
+    const auto result = sendLandingTarget(coordinateTransforms::enuToNED(landingTargetENUgpsOrigin), utcTime::now_ns());
+    if (result != mavsdk::MavlinkPassthrough::Result::Success)
+        qWarning() << "Could not send LANDING_TARGET via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
+}
+
+void MavsdkVehicleConnection::sendLandingTargetENU(const xyz_t &landingTargetENU)
+{
+    if (mMavlinkPassthrough == nullptr)
+        return;
+
+    const xyz_t landingTargetENUgpsOrigin = mLandingTargetFrames.load().fromStationEnu.apply(landingTargetENU);
+    const auto result = sendLandingTarget(coordinateTransforms::enuToNED(landingTargetENUgpsOrigin), utcTime::now_ns());
+    if (result != mavsdk::MavlinkPassthrough::Result::Success)
+        qWarning() << "Could not send LANDING_TARGET via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
+}
 
-    sequenceId++;
+void MavsdkVehicleConnection::startLandingTargetStream(int rate_Hz, int maxSampleAge_ms)
+{
+    mLandingTargetMaxSampleAge_ns = qint64(std::max(maxSampleAge_ms, 1)) * utcTime::NS_PER_MS;
+    LandingTargetSample sample;
+    mLandingTargetMailbox.take(sample); // samples from before the start are stale
+    mLandingTargetLoop.setFrequency(std::max(rate_Hz, 1));
+    mLandingTargetLoop.setMode(ControlLoop::Mode::DEDICATED_THREAD);
+    mLandingTargetLoop.start();
+}
+
+void MavsdkVehicleConnection::stopLandingTargetStream()
+{
+    mLandingTargetLoop.stop();
+}
+
+void MavsdkVehicleConnection::publishLandingTargetENU(const xyz_t &landingTargetENU, qint64 measured_ns)
+{
+    LandingTargetSample sample;
+    sample.positionENU = landingTargetENU;
+    sample.measured_ns = measured_ns;
+    mLandingTargetMailbox.publish(sample);
+}
+
+void MavsdkVehicleConnection::publishLandingTargetLlh(const llh_t &landingTargetLlh, qint64 measured_ns)
+{
+    LandingTargetSample sample;
+    sample.positionLlh = landingTargetLlh;
+    sample.isLlh = true;
+    sample.measured_ns = measured_ns;
+    mLandingTargetMailbox.publish(sample);
 }
 
-void MavsdkVehicleConnection::sendLandingTargetLlh(const llh_t &landingTargetLlh)
+LandingTargetStreamStatistics MavsdkVehicleConnection::getLandingTargetStreamStatistics() const
 {
-    if (mMavlinkPassthrough == nullptr)
-        return;
+    LandingTargetStreamStatistics statistics;
+    statistics.sent = mLandingTargetsSent;
+    statistics.droppedStale = mLandingTargetsDroppedStale;
+    statistics.sendFailures = mLandingTargetSendFailures;
+    statistics.lastSampleAge_ms = mLandingTargetLastSampleAge_ms;
+    return statistics;
+}
 
-    // Note from https://docs.px4.io/master/en/advanced_features/precland.html#mission
-    // The system must publish the coordinates of the target in the LANDING_TARGET message.
-    // Note that PX4 requires LANDING_TARGET.frame to be MAV_FRAME_LOCAL_NED and only populates the fields x, y, and z.
-    // The origin of the local NED frame [0,0] is the home position.
+void MavsdkVehicleConnection::updateLandingTargetFrames()
+{
+    LandingTargetFrames frames;
+    frames.vehicleOrigin = coordinateTransforms::EnuFrame(mGpsGlobalOrigin);
+    frames.fromStationEnu = mEnuFrame.getTransformTo(frames.vehicleOrigin);
+    mLandingTargetFrames.store(frames);
+}
 
-    // Note by Marvin: not home position, gps origin! I tried to update gps origin using mavlink_set_gps_global_origin_t,
-    // but it is not updated while flying (PX4 1.12). Thus, we need to take their gps origin for calculating landing target in NED here.
+void MavsdkVehicleConnection::sendLatestLandingTarget()
+{
+    LandingTargetSample sample;
+    if (!mLandingTargetMailbox.take(sample) || mMavlinkPassthrough == nullptr)
+        return; // nothing new, the vehicle times the target out itself
+
+    const qint64 age_ns = utcTime::now_ns() - sample.measured_ns;
+    mLandingTargetLastSampleAge_ms = double(age_ns) / utcTime::NS_PER_MS;
+    if (age_ns > mLandingTargetMaxSampleAge_ns) {
+        mLandingTargetsDroppedStale++;
+        return;
+    }
 
-    // From Llh to their ENU
-    xyz_t landingTargetENUgpsOrigin = coordinateTransforms::llhToEnu({mGpsGlobalOrigin.latitude, mGpsGlobalOrigin.longitude, mGpsGlobalOrigin.height}, landingTargetLlh);
+    const LandingTargetFrames frames = mLandingTargetFrames.load();
+    const xyz_t landingTargetENUgpsOrigin = sample.isLlh ? frames.vehicleOrigin.llhToEnu(sample.positionLlh) : frames.fromStationEnu.apply(sample.positionENU);
+    if (sendLandingTarget(coordinateTransforms::enuToNED(landingTargetENUgpsOrigin), sample.measured_ns) == mavsdk::MavlinkPassthrough::Result::Success)
+        mLandingTargetsSent++;
+    else
+        mLandingTargetSendFailures++;
+}
 
-    // Send landing target message (with NED frame)
-    auto result = mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+mavsdk::MavlinkPassthrough::Result MavsdkVehicleConnection::sendLandingTarget(const xyz_t &landingTargetNED, qint64 measured_ns)
+{
+    return mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
             mavlink_message_t mavLandingTargetMsg;
             mavlink_landing_target_t mavLandingTargetNED;
             memset(&mavLandingTargetNED, 0, sizeof(mavlink_landing_target_t));
 
             mavLandingTargetNED.position_valid = 1;
             mavLandingTargetNED.frame = MAV_FRAME_LOCAL_NED;
-            mavLandingTargetNED.time_usec = QDateTime::currentDateTimeUtc().toMSecsSinceEpoch();
-
-            xyz_t landingTargetNEDgpsOrigin = coordinateTransforms::enuToNED(landingTargetENUgpsOrigin);
-            mavLandingTargetNED.x = landingTargetNEDgpsOrigin.x;
-            mavLandingTargetNED.y = landingTargetNEDgpsOrigin.y;
-            mavLandingTargetNED.z = landingTargetNEDgpsOrigin.z;
+            mavLandingTargetNED.time_usec = measured_ns / 1000;
+            mavLandingTargetNED.x = landingTargetNED.x;
+            mavLandingTargetNED.y = landingTargetNED.y;
+            mavLandingTargetNED.z = landingTargetNED.z;
 
             mavlink_msg_landing_target_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavLandingTargetMsg, &mavLandingTargetNED);
             return mavLandingTargetMsg;
         });
-    if (result != mavsdk::MavlinkPassthrough::Result::Success)
-        qWarning() << "Could not send LANDING_TARGET via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
-}
-
-void MavsdkVehicleConnection::sendLandingTargetENU(const xyz_t &landingTargetENU)
-{
-    if (mMavlinkPassthrough == nullptr)
-        return;
-
-    llh_t landingTargetLlh = coordinateTransforms::enuToLlh(mEnuReference, landingTargetENU);
-    sendLandingTargetLlh(landingTargetLlh);
 }
 
 void MavsdkVehicleConnection::sendSetGpsOriginLlh(const llh_t &gpsOriginLlh)
@@ -687,7 +1226,7 @@ void MavsdkVehicleConnection::sendSetGpsOriginLlh(const llh_t &gpsOriginLlh)
 
 void MavsdkVehicleConnection::setActuatorOutput(int index, float value)
 {
-    mAction->set_actuator_async(index, value, [](mavsdk::Action::Result res){
+    getActionPlugin()->set_actuator_async(index, value, [](mavsdk::Action::Result res){
         if (res != mavsdk::Action::Result::Success)
             qDebug() << "Warning: MavsdkVehicleConnection's set_actuator request failed.";
     });
@@ -697,19 +1236,51 @@ void MavsdkVehicleConnection::setManualControl(double x, double y, double z, dou
 {
     mavlink_manual_control_t manual_control {};
     manual_control.target = mSystem->get_system_id();
-    manual_control.x = (uint16_t) (x * 1000.0);
-    manual_control.y = (uint16_t) (y * 1000.0);
-    manual_control.z = (uint16_t) (z * 1000.0);
-    manual_control.r = (uint16_t) (r * 1000.0);
+    manual_control.x = (int16_t) (x * 1000.0);
+    manual_control.y = (int16_t) (y * 1000.0);
+    manual_control.z = (int16_t) (z * 1000.0);
+    manual_control.r = (int16_t) (r * 1000.0);
     manual_control.buttons = buttonStateMask;
+    mManualControl = manual_control;
+
+    // Small changes wait for the next periodic send, an idle sender (neutral sent) only wakes up on a change
+    const bool largeChange = manual_control.buttons != mManualControlSent.buttons
+            || getMaxAxisDelta(manual_control, mManualControlSent) > MANUAL_CONTROL_IMMEDIATE_DELTA;
+    const bool changed = largeChange || getMaxAxisDelta(manual_control, mManualControlSent) > 0;
+    if (mManualControlRate_Hz <= 0 || largeChange || (changed && !mManualControlTimer.isActive()))
+        sendManualControl();
+}
+
+void MavsdkVehicleConnection::setManualControlRate(int manualControlRate_Hz)
+{
+    mManualControlRate_Hz = manualControlRate_Hz;
+    if (mManualControlRate_Hz <= 0)
+        mManualControlTimer.stop();
+    else if (mManualControlTimer.isActive())
+        mManualControlTimer.setInterval(1000 / mManualControlRate_Hz);
+}
 
+void MavsdkVehicleConnection::sendManualControl()
+{
     auto result = mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
             mavlink_message_t message;
-            mavlink_msg_manual_control_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &message, &manual_control);
+            mavlink_msg_manual_control_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &message, &mManualControl);
             return message;
         });
     if (result != mavsdk::MavlinkPassthrough::Result::Success)
         qDebug() << "Warning: could not send MANUAL_CONTROL via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
+    mManualControlSent = mManualControl;
+
+    if (isNeutralManualControl(mManualControl))
+        mManualControlNeutralSent++;
+    else
+        mManualControlNeutralSent = 0;
+
+    // Restarting means the next periodic send is one interval after an immediate one
+    if (mManualControlRate_Hz <= 0 || mManualControlNeutralSent >= MANUAL_CONTROL_NEUTRAL_REPEATS)
+        mManualControlTimer.stop();
+    else
+        mManualControlTimer.start(1000 / mManualControlRate_Hz);
 }
 
 void MavsdkVehicleConnection::setConvertLocalPositionsToGlobalBeforeSending(bool convertLocalPositionsToGlobalBeforeSending)
@@ -722,6 +1293,24 @@ MAV_TYPE MavsdkVehicleConnection::getVehicleType() const
     return mVehicleType;
 }
 
+QVector<VehiclePerfCounter> MavsdkVehicleConnection::getPerfCounters() const
+{
+    std::lock_guard<std::mutex> lock(mPerfCountersMutex);
+    return mPerfCounters.values().toVector();
+}
+
+VehiclePerfCounter MavsdkVehicleConnection::getPerfCounter(const QString &name) const
+{
+    std::lock_guard<std::mutex> lock(mPerfCountersMutex);
+    return mPerfCounters.value(name);
+}
+
+void MavsdkVehicleConnection::setLinkStatistics(const MavlinkLinkStatistics &linkStatistics)
+{
+    mLinkStatistics = linkStatistics;
+    emit updatedLinkStatistics(linkStatistics);
+}
+
 mavsdk::MissionRaw::MissionItem MavsdkVehicleConnection::convertPosPointToMissionItem(const PosPoint& posPoint, int sequenceId, bool current) {
     mavsdk::MissionRaw::MissionItem missionItem = {};
 
@@ -806,13 +1395,53 @@ void MavsdkVehicleConnection::clearRouteOnVehicle(int id)
     if (!mMissionRaw)
         mMissionRaw.reset(new mavsdk::MissionRaw(mSystem));
 
+    mRouteOnVehicle.clear();
     if (mMissionRaw->clear_mission() != mavsdk::MissionRaw::Result::Success)
         qDebug() << "Warning: MavsdkVehicleConnection's clear mission request failed.";
 }
 
+void MavsdkVehicleConnection::setRouteOnVehicle(const QList<PosPoint> &route, int id)
+{
+    // Only chunks that changed since the last bulk upload are sent, the vehicle rejects the patch if its route is another one
+    if (mRoutePatchEnabled && useBulkRouteTransfer() && !mRouteOnVehicle.isEmpty() && !route.isEmpty() && !mRouteUploadSender.isActive()) {
+        const QVector<pospoint_t> routePOD = PosPoint::toPODList(route);
+        const QByteArray routePatch = routeCodec::encodeRoutePatch(mRouteOnVehicle, routePOD);
+        if (routePatch.size() < routeCodec::encodeRoute(routePOD).size() &&
+                mRouteUploadSender.start(mNextRouteTransferId++, mavlinkRouteTransfer::PacketType::UploadChunk, routePatch)) {
+            mRouteUploadFallback = route;
+            mRouteUploadRoute = routePOD;
+            mRouteUploadIsPatch = true;
+            return;
+        }
+    }
+
+    clearRouteOnVehicle(id);
+    appendToRouteOnVehicle(route, id);
+}
+
 void MavsdkVehicleConnection::appendToRouteOnVehicle(const QList<PosPoint> &route, int id)
 {
     Q_UNUSED(id)
+    if (useBulkRouteTransfer()) {
+        if (mRouteUploadSender.isActive()) // previous upload is replaced, as with the mission protocol
+            mRouteUploadSender.abort();
+        mRouteUploadFallback = route;
+        const QByteArray encodedRoute = routeCodec::encodeRoute(route);
+        if (mRouteUploadSender.start(mNextRouteTransferId++, mavlinkRouteTransfer::PacketType::UploadChunk, encodedRoute,
+                                     mStoredRouteRequestEnabled ? routeCodec::getRouteHash(encodedRoute) : 0)) {
+            mRouteUploadRoute = mRouteOnVehicle + PosPoint::toPODList(route); // the vehicle appends
+            mRouteUploadIsPatch = false;
+            return;
+        }
+        mRouteUploadFallback.clear();
+    }
+
+    uploadRouteAsMission(route);
+}
+
+void MavsdkVehicleConnection::uploadRouteAsMission(const QList<PosPoint> &route)
+{
+    mRouteOnVehicle.clear(); // no patches on routes from the mission protocol
     if (!mMissionRaw)
         mMissionRaw.reset(new mavsdk::MissionRaw(mSystem));
 
@@ -827,6 +1456,129 @@ void MavsdkVehicleConnection::appendToRouteOnVehicle(const QList<PosPoint> &rout
     });
 }
 
+bool MavsdkVehicleConnection::requestConvoyPredecessor(quint8 predecessorSystemId)
+{
+    mavsdk::MavlinkPassthrough::CommandLong ComLong;
+    memset(&ComLong, 0, sizeof (ComLong));
+    ComLong.target_compid = mMavlinkPassthrough->get_target_compid();
+    ComLong.target_sysid = mMavlinkPassthrough->get_target_sysid();
+    ComLong.command = MAV_CMD_DO_FOLLOW;
+    ComLong.param1 = predecessorSystemId;
+
+    auto result = mMavlinkPassthrough->send_command_long(ComLong);
+    if (result != mavsdk::MavlinkPassthrough::Result::Success) {
+        qDebug() << "Warning: could not send convoy predecessor via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
+        return false;
+    }
+    if (predecessorSystemId == 0)
+        mConvoyGap_m = -1.0;
+    return true;
+}
+
+bool MavsdkVehicleConnection::requestRouteRecording(bool start)
+{
+    mavsdk::MavlinkPassthrough::CommandLong ComLong;
+    memset(&ComLong, 0, sizeof (ComLong));
+    ComLong.target_compid = mMavlinkPassthrough->get_target_compid();
+    ComLong.target_sysid = mMavlinkPassthrough->get_target_sysid();
+    ComLong.command = mavlinkRouteTransfer::RECORD_ROUTE_COMMAND;
+    ComLong.param1 = start ? 1 : 0;
+
+    auto result = mMavlinkPassthrough->send_command_long(ComLong);
+    if (result != mavsdk::MavlinkPassthrough::Result::Success) {
+        qDebug() << "Warning: could not send route recording request via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
+        return false;
+    }
+    return true;
+}
+
+void MavsdkVehicleConnection::setTelemetryDemand(TelemetryDemand telemetryDemand)
+{
+    if (telemetryDemand == mTelemetryDemand)
+        return;
+    mTelemetryDemand = telemetryDemand;
+
+    if (mMavlinkPassthrough == nullptr)
+        return;
+
+    for (const TelemetryStreamInterval &streamInterval : TELEMETRY_STREAM_INTERVALS) {
+        int interval_ms = 0;
+        switch (telemetryDemand) {
+        case TelemetryDemand::Selected: interval_ms = 0; break;
+        case TelemetryDemand::Visible: interval_ms = streamInterval.visibleInterval_ms; break;
+        case TelemetryDemand::Background: interval_ms = streamInterval.backgroundInterval_ms; break;
+        }
+
+        mavsdk::MavlinkPassthrough::CommandLong ComLong;
+        memset(&ComLong, 0, sizeof (ComLong));
+        ComLong.target_compid = mMavlinkPassthrough->get_target_compid();
+        ComLong.target_sysid = mMavlinkPassthrough->get_target_sysid();
+        ComLong.command = MAV_CMD_SET_MESSAGE_INTERVAL;
+        ComLong.param1 = streamInterval.messageId;
+        ComLong.param2 = (interval_ms > 0) ? interval_ms * 1000.0f : interval_ms; // [us]
+
+        auto result = mMavlinkPassthrough->send_command_long(ComLong);
+        if (result != mavsdk::MavlinkPassthrough::Result::Success) {
+            qDebug() << "Warning: could not send message interval request via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
+            return;
+        }
+    }
+}
+
+bool MavsdkVehicleConnection::sendCommandLatencyTag(quint16 tag, quint8 command)
+{
+    if (mMavlinkPassthrough == nullptr)
+        return false;
+
+    qint64 issuedVehicleTime_ns;
+    {
+        std::lock_guard<std::mutex> lock(mClockSyncMutex);
+        issuedVehicleTime_ns = mClockSync.toRemote_ns(utcTime::now_ns());
+    }
+
+    auto result = mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+        mavlink_message_t mavTagMsg;
+        mavlink_debug_float_array_t tagArray;
+        memset(&tagArray, 0, sizeof(mavlink_debug_float_array_t));
+
+        tagArray.time_usec = issuedVehicleTime_ns == utcTime::INVALID ? 0 : issuedVehicleTime_ns / 1000;
+        tagArray.array_id = CommandLatencyTrace::MAVLINK_ARRAY_ID;
+        strncpy(tagArray.name, CommandLatencyTrace::MAVLINK_TAG_NAME, sizeof(tagArray.name));
+        tagArray.data[0] = tag;
+        tagArray.data[1] = command;
+        mavlink_msg_debug_float_array_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavTagMsg, &tagArray);
+
+        return mavTagMsg;
+    });
+    if (result != mavsdk::MavlinkPassthrough::Result::Success) {
+        qDebug() << "Warning: could not send command latency tag via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
+        return false;
+    }
+    return true;
+}
+
+void MavsdkVehicleConnection::handleCommandLatencyTrace(const mavlink_debug_float_array_t &traceArray)
+{
+    // Stage times relative to the first known stage, from the stage latencies
+    CommandLatencyTraceResult trace;
+    trace.tag = quint16(traceArray.data[0]);
+    trace.command = quint8(traceArray.data[1]);
+    qint64 stage_ns = -1;
+    for (int i = 1; i < CommandLatencyTraceResult::NUM_STAGES; i++) {
+        const float latency_us = traceArray.data[1 + i];
+        if (latency_us < 0.0f)
+            continue;
+        if (stage_ns < 0) {
+            stage_ns = 0;
+            trace.stage_ns[i - 1] = stage_ns;
+        } else if (trace.stage_ns[i - 1] < 0)
+            break;
+        stage_ns += qint64(double(latency_us) * 1000.0);
+        trace.stage_ns[i] = stage_ns;
+    }
+    emit gotCommandLatencyTrace(trace);
+}
+
 void MavsdkVehicleConnection::setActiveAutopilotIDOnVehicle(int id)
 {
     mavsdk::MavlinkPassthrough::CommandLong ComLong;
@@ -877,43 +1629,85 @@ bool MavsdkVehicleConnection::requestRebootOrShutdownOfSystemComponents(VehicleC
 
 VehicleConnection::Result MavsdkVehicleConnection::setIntParameterOnVehicle(std::string name, int32_t value)
 {
-    return convertParamResult(mParam->set_param_int(name, value));
+    const VehicleConnection::Result result = convertParamResult(getParamPlugin()->set_param_int(name, value));
+    if (result == VehicleConnection::Result::Success) {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        if (auto cachedParameter = findParameter(mParameterCache.intParameters, name))
+            cachedParameter->value = value;
+    }
+    return result;
 }
 
 VehicleConnection::Result MavsdkVehicleConnection::setFloatParameterOnVehicle(std::string name, float value)
 {
-    return convertParamResult(mParam->set_param_float(name, value));
+    const VehicleConnection::Result result = convertParamResult(getParamPlugin()->set_param_float(name, value));
+    if (result == VehicleConnection::Result::Success) {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        if (auto cachedParameter = findParameter(mParameterCache.floatParameters, name))
+            cachedParameter->value = value;
+    }
+    return result;
 }
 
 VehicleConnection::Result MavsdkVehicleConnection::setCustomParameterOnVehicle(std::string name, std::string value)
 {
-    return convertParamResult(mParam->set_param_custom(name, value));
+    const VehicleConnection::Result result = convertParamResult(getParamPlugin()->set_param_custom(name, value));
+    if (result == VehicleConnection::Result::Success) {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        if (auto cachedParameter = findParameter(mParameterCache.customParameters, name))
+            cachedParameter->value = value;
+    }
+    return result;
 }
 
 std::pair<VehicleConnection::Result, int32_t> MavsdkVehicleConnection::getIntParameterFromVehicle(std::string name) const
 {
-    auto intParameter =  mParam->get_param_int(name);
+    {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        if (auto cachedParameter = findParameter(mParameterCache.intParameters, name))
+            return std::make_pair(VehicleConnection::Result::Success, cachedParameter->value);
+    }
+
+    auto intParameter =  getParamPlugin()->get_param_int(name);
 
     return std::make_pair(convertParamResult(intParameter.first), intParameter.second);
 };
 
 std::pair<VehicleConnection::Result, float> MavsdkVehicleConnection::getFloatParameterFromVehicle(std::string name) const
 {
-    auto intParameter =  mParam->get_param_float(name);
+    {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        if (auto cachedParameter = findParameter(mParameterCache.floatParameters, name))
+            return std::make_pair(VehicleConnection::Result::Success, cachedParameter->value);
+    }
+
+    auto intParameter =  getParamPlugin()->get_param_float(name);
 
     return std::make_pair(convertParamResult(intParameter.first), intParameter.second);
 };
 
 std::pair<VehicleConnection::Result, std::string> MavsdkVehicleConnection::getCustomParameterFromVehicle(std::string name) const
 {
-    auto intParameter =  mParam->get_param_custom(name);
+    {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        if (auto cachedParameter = findParameter(mParameterCache.customParameters, name))
+            return std::make_pair(VehicleConnection::Result::Success, cachedParameter->value);
+    }
+
+    auto intParameter =  getParamPlugin()->get_param_custom(name);
 
     return std::make_pair(convertParamResult(intParameter.first), intParameter.second);
 };
 
 ParameterServer::AllParameters MavsdkVehicleConnection::getAllParametersFromVehicle()
 {
-    mavsdk::Param::AllParams mavsdkVehicleParameters = mParam->get_all_params();
+    {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        if (mParameterCacheValid)
+            return mParameterCache;
+    }
+
+    mavsdk::Param::AllParams mavsdkVehicleParameters = getParamPlugin()->get_all_params();
     ParameterServer::IntParameter intParameter;
     ParameterServer::FloatParameter floatParameter;
     ParameterServer::CustomParameter customParameter;
@@ -922,30 +1716,220 @@ ParameterServer::AllParameters MavsdkVehicleConnection::getAllParametersFromVehi
     for (const auto& vehicleParameter : mavsdkVehicleParameters.int_params) {
         intParameter.name = vehicleParameter.name;
         intParameter.value = vehicleParameter.value;
-        intParameter.value = mParam->get_param_int(intParameter.name).second; //Remove this line when issue #72 is closed
+        intParameter.value = getParamPlugin()->get_param_int(intParameter.name).second; //Remove this line when issue #72 is closed
         allParameters.intParameters.push_back(intParameter);
     }
     for (const auto& vehicleParameter : mavsdkVehicleParameters.float_params) {
         floatParameter.name = vehicleParameter.name;
         floatParameter.value = vehicleParameter.value;
-        floatParameter.value = mParam->get_param_float(floatParameter.name).second; //Remove this line when issue #72 is closed
+        floatParameter.value = getParamPlugin()->get_param_float(floatParameter.name).second; //Remove this line when issue #72 is closed
         allParameters.floatParameters.push_back(floatParameter);
     }
     for (const auto& vehicleParameter : mavsdkVehicleParameters.custom_params) {
         customParameter.name = vehicleParameter.name;
         customParameter.value = vehicleParameter.value;
-        customParameter.value = mParam->get_param_custom(customParameter.name).second; //Remove this line when issue #72 is closed
+        customParameter.value = getParamPlugin()->get_param_custom(customParameter.name).second; //Remove this line when issue #72 is closed
         allParameters.customParameters.push_back(customParameter);
     }
 
+    if (!allParameters.intParameters.empty() || !allParameters.floatParameters.empty() || !allParameters.customParameters.empty()) {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        mParameterCache = allParameters;
+        mParameterCacheValid = true;
+    }
+
     return allParameters;
 }
 
+void MavsdkVehicleConnection::invalidateParameterCache()
+{
+    const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+    mParameterCacheValid = false;
+    mParameterCache = ParameterServer::AllParameters();
+}
+
+bool MavsdkVehicleConnection::getCachedParametersFromVehicle(ParameterServer::AllParameters &parameters) const
+{
+    const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+    if (!mParameterCacheValid)
+        return false;
+
+    parameters = mParameterCache;
+    return true;
+}
+
+void MavsdkVehicleConnection::handleParameterValue(const mavlink_message_t &message)
+{
+    if (message.compid != mMavlinkPassthrough->get_target_compid())
+        return;
+
+    mavlink_param_value_t parameterValue;
+    mavlink_msg_param_value_decode(&message, &parameterValue);
+    char parameterId[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN + 1] = {}; // param_id is not null-terminated at full length
+    memcpy(parameterId, parameterValue.param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
+    const std::string name(parameterId);
+
+    bool changed = true; // unknown parameters count as changed
+    {
+        const std::lock_guard<std::mutex> lock(mParameterCacheMutex);
+        if (!mParameterCacheValid)
+            return;
+
+        bool known = false;
+        if (parameterValue.param_type == MAV_PARAM_TYPE_REAL32) {
+            if (auto cachedParameter = findParameter(mParameterCache.floatParameters, name)) {
+                known = true;
+                changed = (cachedParameter->value != parameterValue.param_value);
+                cachedParameter->value = parameterValue.param_value;
+            }
+        } else if (parameterValue.param_type == MAV_PARAM_TYPE_INT32) {
+            mavlink_param_union_t param; // bytewise encoding, as used by MavsdkVehicleServer
+            param.param_float = parameterValue.param_value;
+            if (auto cachedParameter = findParameter(mParameterCache.intParameters, name)) {
+                known = true;
+                changed = (cachedParameter->value != param.param_int32);
+                cachedParameter->value = param.param_int32;
+            }
+        } else
+            return;
+
+        if (!known) {
+            mParameterCacheValid = false;
+            mParameterCache = ParameterServer::AllParameters();
+        }
+    }
+
+    if (changed)
+        emit updatedParametersOnVehicle({QString::fromStdString(name)});
+}
+
+void MavsdkVehicleConnection::getIntParameterFromVehicleAsync(std::string name, std::function<void(VehicleConnection::Result, int32_t)> callback)
+{
+    queueParameterRequest(ParameterRequest::Type::GetInt, name, {}, [callback](const ParameterRequest &request) {
+        if (callback)
+            callback(request.result, request.intValue);
+    });
+}
+
+void MavsdkVehicleConnection::getFloatParameterFromVehicleAsync(std::string name, std::function<void(VehicleConnection::Result, float)> callback)
+{
+    queueParameterRequest(ParameterRequest::Type::GetFloat, name, {}, [callback](const ParameterRequest &request) {
+        if (callback)
+            callback(request.result, request.floatValue);
+    });
+}
+
+void MavsdkVehicleConnection::getAllParametersFromVehicleAsync(std::function<void(const ParameterServer::AllParameters &)> callback)
+{
+    queueParameterRequest(ParameterRequest::Type::GetAll, {}, {}, [callback](const ParameterRequest &request) {
+        if (callback)
+            callback(request.parameters);
+    });
+}
+
+void MavsdkVehicleConnection::setParametersOnVehicleAsync(const ParameterServer::AllParameters &parameters, std::function<void(VehicleConnection::Result)> callback)
+{
+    queueParameterRequest(ParameterRequest::Type::Set, {}, parameters, [callback](const ParameterRequest &request) {
+        if (callback)
+            callback(request.result);
+    });
+}
+
+void MavsdkVehicleConnection::queueParameterRequest(ParameterRequest::Type type, const std::string &name, const ParameterServer::AllParameters &parameters,
+                                                    std::function<void(const ParameterRequest &)> callback)
+{
+    if (!mParameterRequestQueue.isEmpty()) {
+        QSharedPointer<ParameterRequest> lastRequest = mParameterRequestQueue.last();
+        if (!lastRequest->started && lastRequest->type == type && lastRequest->name == name) {
+            if (type == ParameterRequest::Type::Set) {
+                mergeParameters(lastRequest->parameters.intParameters, parameters.intParameters);
+                mergeParameters(lastRequest->parameters.floatParameters, parameters.floatParameters);
+                mergeParameters(lastRequest->parameters.customParameters, parameters.customParameters);
+            }
+            lastRequest->callbacks.append(callback);
+            return;
+        }
+    }
+
+    QSharedPointer<ParameterRequest> request = QSharedPointer<ParameterRequest>::create();
+    request->type = type;
+    request->name = name;
+    request->parameters = parameters;
+    request->callbacks.append(callback);
+    mParameterRequestQueue.append(request);
+    processNextParameterRequest();
+}
+
+void MavsdkVehicleConnection::processNextParameterRequest()
+{
+    if (mParameterRequestQueue.isEmpty() || mParameterRequestQueue.first()->started)
+        return;
+
+    QSharedPointer<ParameterRequest> request = mParameterRequestQueue.first();
+    request->started = true;
+    QMetaObject::invokeMethod(mParameterThreadContext, [this, request]() {
+        for (int attempt = 0; attempt <= PARAMETER_REQUEST_RETRIES; attempt++) {
+            request->result = executeParameterRequest(*request);
+            if (request->result != VehicleConnection::Result::Timeout)
+                break;
+        }
+
+        QMetaObject::invokeMethod(this, [this, request]() {
+            mParameterRequestQueue.removeFirst();
+            for (const auto& callback : request->callbacks)
+                callback(*request);
+            processNextParameterRequest();
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+VehicleConnection::Result MavsdkVehicleConnection::executeParameterRequest(ParameterRequest &request)
+{
+    switch (request.type) {
+    case ParameterRequest::Type::GetInt: {
+        const auto intParameter = getIntParameterFromVehicle(request.name);
+        request.intValue = intParameter.second;
+        return intParameter.first;
+    }
+    case ParameterRequest::Type::GetFloat: {
+        const auto floatParameter = getFloatParameterFromVehicle(request.name);
+        request.floatValue = floatParameter.second;
+        return floatParameter.first;
+    }
+    case ParameterRequest::Type::GetAll:
+        request.parameters = getAllParametersFromVehicle();
+        // MAVSDK does not report errors here, a vehicle without parameters is taken as no answer
+        return (request.parameters.intParameters.empty() && request.parameters.floatParameters.empty() && request.parameters.customParameters.empty()) ?
+                    VehicleConnection::Result::Timeout : VehicleConnection::Result::Success;
+    case ParameterRequest::Type::Set:
+        return setParametersOnVehicle(request.parameters);
+    }
+    return VehicleConnection::Result::Unknown;
+}
+
 void MavsdkVehicleConnection::pollCurrentENUreference()
 {
+    if (!mTelemetry) { // lightweight, answer is handled in setupTelemetryMessages()
+        mavsdk::MavlinkPassthrough::CommandLong ComLong;
+        ComLong.target_compid = mMavlinkPassthrough->get_target_compid();
+        ComLong.target_sysid = mMavlinkPassthrough->get_target_sysid();
+        ComLong.command = MAV_CMD_REQUEST_MESSAGE;
+        ComLong.param1 = MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN;
+        ComLong.param2 = 0;
+        ComLong.param3 = 0;
+        ComLong.param4 = 0;
+        ComLong.param5 = 0;
+        ComLong.param6 = 0;
+        ComLong.param7 = 0;
+        if (mMavlinkPassthrough->send_command_long(ComLong) != mavsdk::MavlinkPassthrough::Result::Success)
+            qDebug() << "WARNING: MavsdkVehicleConnection failed to request GPS_GLOBAL_ORIGIN.";
+        return;
+    }
+
     mTelemetry->get_gps_global_origin_async([this](mavsdk::Telemetry::Result result, mavsdk::Telemetry::GpsGlobalOrigin gpsGlobalOrigin){
         if (result == mavsdk::Telemetry::Result::Success){
             mGpsGlobalOrigin = {gpsGlobalOrigin.latitude_deg, gpsGlobalOrigin.longitude_deg, gpsGlobalOrigin.altitude_m};
+            QMetaObject::invokeMethod(this, [this]() { updateLandingTargetFrames(); }, Qt::QueuedConnection);
             emit gotVehicleENUreferenceLlh(mGpsGlobalOrigin);
         }
     });
@@ -1047,6 +2031,15 @@ QString MavsdkVehicleConnection::convertMavlinkPassthroughResult(mavsdk::Mavlink
 
 QList<PosPoint> MavsdkVehicleConnection::requestCurrentRouteFromVehicle()
 {    
+    if (useBulkRouteTransfer()) {
+        QList<PosPoint> currentRouteOnVehicle;
+        if (downloadRouteInBulk(currentRouteOnVehicle)) {
+            qInfo() << "Route downloaded, number of points: " << currentRouteOnVehicle.size();
+            return currentRouteOnVehicle;
+        }
+        qDebug() << "MavsdkVehicleConnection: bulk route download failed, falling back to mission protocol.";
+    }
+
     if (!mMissionRaw)
         mMissionRaw.reset(new mavsdk::MissionRaw(mSystem));
 
@@ -1076,6 +2069,148 @@ QList<PosPoint> MavsdkVehicleConnection::requestCurrentRouteFromVehicle()
     return currentRouteOnVehicle;
 }
 
+bool MavsdkVehicleConnection::setGeofenceOnVehicle(const Geofence &geofence)
+{
+    if (!useBulkRouteTransfer()) // WayWise vehicles do not handle the standard fence protocol
+        return false;
+
+    return mGeofenceUploadSender.start(mNextRouteTransferId++, mavlinkRouteTransfer::PacketType::GeofenceUploadChunk,
+                                       mavlinkRouteTransfer::encodeGeofence(geofence));
+}
+
+bool MavsdkVehicleConnection::useBulkRouteTransfer() const
+{
+    return mBulkRouteTransferEnabled && mBulkRouteTransferSupported && mVehicleType == MAV_TYPE_GROUND_ROVER; // assumption: rover = WayWise on vehicle side
+}
+
+bool MavsdkVehicleConnection::downloadRouteInBulk(QList<PosPoint> &route)
+{
+    std::unique_lock<std::mutex> lock(mRouteDownloadMutex);
+    mRouteDownloadTransferId = mNextRouteTransferId++;
+    mRouteDownloadAssembler = mavlinkRouteTransfer::ChunkAssembler();
+    mRouteDownloadChunksReceived = 0;
+    mRouteDownloadUnchanged = false;
+    mRouteDownloadActive = true;
+
+    mavlinkRouteTransfer::Packet request;
+    request.type = mavlinkRouteTransfer::PacketType::DownloadRequest;
+    request.transferId = mRouteDownloadTransferId;
+    request.routeHash = mCachedCurrentRouteHash; // acknowledged without chunks if the vehicle's route did not change
+
+    // Blocks like the mission protocol download. The request is repeated until chunks arrive, missing chunks are requested on stalls.
+    int missingRequests = 0;
+    bool gotChunk = false;
+    while (!mRouteDownloadAssembler.isComplete() && !mRouteDownloadUnchanged) {
+        const int chunksReceived = mRouteDownloadChunksReceived;
+        mavlinkRouteTransfer::Packet packet = request;
+        if (mRouteDownloadAssembler.isActive()) {
+            packet.type = mavlinkRouteTransfer::PacketType::Ack;
+            packet.status = mavlinkRouteTransfer::AckStatus::Missing;
+            packet.missingChunks = mRouteDownloadAssembler.getMissingChunks();
+        }
+        if (missingRequests > 0 || !mRouteDownloadAssembler.isActive()) {
+            lock.unlock();
+            sendRouteTransferPacket(packet);
+            lock.lock();
+        }
+
+        const int timeout_ms = mRouteDownloadAssembler.isActive() ? mavlinkRouteTransfer::RECEIVE_STALL_TIMEOUT_ms : mavlinkRouteTransfer::REQUEST_TIMEOUT_ms;
+        if (mRouteDownloadCondition.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&]() { return mRouteDownloadChunksReceived != chunksReceived || mRouteDownloadUnchanged; })) {
+            gotChunk = true;
+            missingRequests = 0;
+        } else if (++missingRequests > mavlinkRouteTransfer::MAX_MISSING_REQUESTS) {
+            mRouteDownloadActive = false;
+            if (!gotChunk)
+                mBulkRouteTransferSupported = false;
+            return false;
+        }
+    }
+    mRouteDownloadActive = false;
+    if (mRouteDownloadUnchanged)
+        return routeCodec::decodeRoute(mCachedCurrentRoute, route);
+    const QByteArray blob = mRouteDownloadAssembler.getData();
+    lock.unlock();
+
+    mavlinkRouteTransfer::Packet ack;
+    ack.type = mavlinkRouteTransfer::PacketType::Ack;
+    ack.transferId = request.transferId;
+    ack.status = mavlinkRouteTransfer::AckStatus::Complete;
+    sendRouteTransferPacket(ack);
+
+    if (!routeCodec::decodeRoute(blob, route))
+        return false;
+    setCachedCurrentRoute(blob, routeCodec::getRouteHash(blob));
+    return true;
+}
+
+void MavsdkVehicleConnection::handleRouteTransferPacket(const mavlinkRouteTransfer::Packet &packet)
+{
+    switch (packet.type) {
+    case mavlinkRouteTransfer::PacketType::DownloadChunk: {
+        std::lock_guard<std::mutex> lock(mRouteDownloadMutex);
+        if (mRouteDownloadActive && packet.transferId == mRouteDownloadTransferId) {
+            mRouteDownloadAssembler.addChunk(packet);
+            mRouteDownloadChunksReceived++;
+            mRouteDownloadCondition.notify_all();
+        }
+        break;
+    }
+    case mavlinkRouteTransfer::PacketType::Ack: {
+        {
+            std::lock_guard<std::mutex> lock(mRouteDownloadMutex);
+            if (mRouteDownloadActive && packet.transferId == mRouteDownloadTransferId) {
+                if (packet.status == mavlinkRouteTransfer::AckStatus::Complete) { // the vehicle's route is the cached one
+                    mRouteDownloadUnchanged = true;
+                    mRouteDownloadCondition.notify_all();
+                }
+                break;
+            }
+        }
+        // For uploads, sender lives in our thread
+        QMetaObject::invokeMethod(this, [this, packet]() {
+            if (mGeofenceUploadSender.isActive() && packet.transferId == mGeofenceUploadSender.getTransferId())
+                mGeofenceUploadSender.handleAck(packet);
+            else
+                mRouteUploadSender.handleAck(packet);
+        }, Qt::QueuedConnection);
+        break;
+    }
+    case mavlinkRouteTransfer::PacketType::BroadcastAck:
+        QMetaObject::invokeMethod(this, [this, packet]() { emit gotRouteBroadcastAck(packet); }, Qt::QueuedConnection);
+        break;
+    default:
+        ;
+    }
+}
+
+void MavsdkVehicleConnection::setRouteBroadcastOnVehicle(const QVector<pospoint_t> &route)
+{
+    mRouteOnVehicle = route;
+    const QByteArray encodedRoute = routeCodec::encodeRoute(route);
+    setCachedCurrentRoute(encodedRoute, routeCodec::getRouteHash(encodedRoute));
+}
+
+bool MavsdkVehicleConnection::sendRouteTransferPacket(const mavlinkRouteTransfer::Packet &packet, bool toAllVehicles)
+{
+    auto result = mMavlinkPassthrough->queue_message([&](MavlinkAddress mavlink_address, uint8_t channel) {
+            mavlink_message_t mavV2ExtensionMsg;
+            mavlink_v2_extension_t mavV2Extension;
+            memset(&mavV2Extension, 0, sizeof(mavlink_v2_extension_t));
+
+            mavV2Extension.target_system = toAllVehicles ? 0 : mMavlinkPassthrough->get_target_sysid();
+            mavV2Extension.target_component = toAllVehicles ? 0 : mMavlinkPassthrough->get_target_compid();
+            mavlinkRouteTransfer::encodePacket(packet, mavV2Extension);
+
+            mavlink_msg_v2_extension_encode_chan(mavlink_address.system_id, mavlink_address.component_id, channel, &mavV2ExtensionMsg, &mavV2Extension);
+            return mavV2ExtensionMsg;
+        });
+    if (result != mavsdk::MavlinkPassthrough::Result::Success) {
+        qWarning() << "Could not send route transfer packet via MAVLINK (" << convertMavlinkPassthroughResult(result) << ")";
+        return false;
+    }
+    return true;
+}
+
 void MavsdkVehicleConnection::startFollowPointOnVehicle()
 {
     if (mVehicleType == MAV_TYPE_GROUND_ROVER) // WayWise
@@ -10,6 +10,9 @@
 #define MAVSDKVEHICLECONNECTION_H
 
 #include <QSharedPointer>
+#include <QThread>
+#include <QList>
+#include <QTimer>
 #include "waywise.h"
 #include "vehicleconnection.h"
 #include "vehicles/vehiclestate.h"
@@ -20,6 +23,17 @@
 #include "vehicles/carstate.h"
 #include "vehicles/truckstate.h"
 #include "sensors/camera/mavsdkgimbal.h"
+#include "communication/mavlinklinkmonitor.h"
+#include "communication/mavlinkroutetransfer.h"
+#include "communication/mavlinkmessagerouter.h"
+#include "core/routecodec.h"
+#include "core/routeprojection.h"
+#include "core/perfcounters.h"
+#include "core/clocksyncestimator.h"
+#include "core/commandlatencytrace.h"
+#include "core/startupprofile.h"
+#include "core/controlloop.h"
+#include "core/latestvaluemailbox.h"
 #include <mavsdk/mavsdk.h>
 #include <mavsdk/plugins/telemetry/telemetry.h>
 #include <mavsdk/plugins/action/action.h>
@@ -28,14 +42,67 @@
 #include <mavsdk/plugins/offboard/offboard.h>
 #include <mavsdk/plugins/mission_raw/mission_raw.h>
 #include <mavsdk/plugins/info/info.h>
+#include <array>
+#include <mutex>
+#include <condition_variable>
+
+// RTCM message split into GPS_RTCM_DATA payloads. Prepared once per message and sent to any number of vehicles,
+// only the (per link) MAVLink framing is done per vehicle.
+struct MavlinkRtcmFragments {
+    static constexpr int maxFragments = 4; // 2 bits for fragment id
+    int numFragments = 0;
+    std::array<mavlink_gps_rtcm_data_t, maxFragments> fragments;
+
+    // Returns false (and no fragments) if the message does not fit into maxFragments
+    bool setRtcmData(const QByteArray &rtcmData, uint8_t sequenceId);
+};
+
+// Performance counter of the vehicle (see PerfCounters) as published by MavsdkVehicleServer
+struct VehiclePerfCounter {
+    QString name;
+    PerfCounterSnapshot::Type type = PerfCounterSnapshot::Type::Counter;
+    QVector<float> values; // see PerfCounterSnapshot::toArray
+    quint64 vehicleTime_us = 0;
+};
+
+// Vehicle clock relative to the control station's (UTC) as estimated from TIMESYNC round trips (see ClockSyncEstimator)
+struct VehicleClockSync {
+    bool synchronized = false;
+    double offset_ms = 0.0; // station UTC - vehicle time since boot
+    double skew_ppm = 0.0;
+    double lastRoundTrip_ms = 0.0;
+    double minRoundTrip_ms = 0.0;
+    int samples = 0;
+};
+Q_DECLARE_METATYPE(VehicleClockSync)
+Q_DECLARE_METATYPE(CommandLatencyTraceResult)
+
+// Receive time - synchronized send time of messages with a vehicle timestamp
+struct VehicleMessageLatency {
+    double last_ms = 0.0;
+    double mean_ms = 0.0; // exponential moving average
+    double max_ms = 0.0;
+    quint64 samples = 0;
+};
+
+struct LandingTargetStreamStatistics {
+    quint64 sent = 0;
+    quint64 droppedStale = 0; // older than maxSampleAge_ms when due
+    quint64 sendFailures = 0;
+    double lastSampleAge_ms = 0.0; // when sent or dropped
+};
 
 class MavsdkVehicleConnection : public VehicleConnection
 {
     Q_OBJECT
 public:
-    explicit MavsdkVehicleConnection(std::shared_ptr<mavsdk::System> system, MAV_TYPE vehicleType);
-    ~MavsdkVehicleConnection() { mSystem->unsubscribe_component_discovered(mComponentDiscoveredHandle); };
+    // With a messageRouter (see MavsdkStation::setLightweightConnectionsEnabled), incoming messages are taken from it and
+    // telemetry is decoded without MAVSDK's Telemetry plugin
+    explicit MavsdkVehicleConnection(std::shared_ptr<mavsdk::System> system, MAV_TYPE vehicleType, QSharedPointer<MavlinkMessageRouter> messageRouter = {});
+    ~MavsdkVehicleConnection();
+    // Positions from global coordinates (but ground rovers' local ones) are converted to the new reference at once
     void setEnuReference(const llh_t &enuReference);
+    llh_t getEnuReference() const { return mEnuFrame.getReference(); }
     void setHomeLlh(const llh_t &homeLlh);
     virtual QList<PosPoint> requestCurrentRouteFromVehicle() override;
     virtual void requestArm() override;
@@ -50,11 +117,25 @@ public:
     virtual void requestGotoENU(const xyz_t &xyz, bool changeFlightmodeToHold = false) override;
     virtual void requestVelocityAndYaw(const xyz_t &velocityENU, const double &yawDeg) override;
     void inputRtcmData(const QByteArray &rtcmData);
+    void inputRtcmFragments(const MavlinkRtcmFragments &rtcmFragments);
     void sendLandingTargetLlh(const llh_t &landingTargetLlh);
     void sendLandingTargetENU(const xyz_t &landingTargetENU);
+    // Precision landing: the latest published landing target (e.g., from a camera or UWB) is sent as LANDING_TARGET from a stream thread
+    // at a fixed rate, stamped with its measurement time (UTC) for the vehicle to compensate the delay. Each sample is sent once,
+    // samples older than maxSampleAge_ms when due are dropped instead of sent late. Publishing never blocks and works from any thread.
+    void startLandingTargetStream(int rate_Hz = 30, int maxSampleAge_ms = 100);
+    void stopLandingTargetStream();
+    bool isLandingTargetStreamActive() const { return mLandingTargetLoop.isActive(); }
+    void publishLandingTargetENU(const xyz_t &landingTargetENU, qint64 measured_ns = utcTime::now_ns());
+    void publishLandingTargetLlh(const llh_t &landingTargetLlh, qint64 measured_ns = utcTime::now_ns());
+    LandingTargetStreamStatistics getLandingTargetStreamStatistics() const;
     void sendSetGpsOriginLlh(const llh_t &gpsOriginLlh);
     virtual void setActuatorOutput(int index, float value) override;
     virtual void setManualControl(double x, double y, double z, double r, uint16_t buttonStateMask) override;
+    // Manual control keeps only the latest sample and sends it at a fixed rate, large changes (axes or buttons) are sent immediately.
+    // The latest sample is repeated until a neutral one was sent a few times. 0: every sample is sent as it comes
+    void setManualControlRate(int manualControlRate_Hz);
+    int getManualControlRate() const { return mManualControlRate_Hz; }
     virtual bool requestRebootOrShutdownOfSystemComponents(VehicleConnection::SystemComponent systemComponent, VehicleConnection::ComponentAction componentAction) override;
     virtual VehicleConnection::Result setIntParameterOnVehicle(std::string name, int32_t value) override;
     virtual VehicleConnection::Result setFloatParameterOnVehicle(std::string, float value) override;
@@ -65,39 +146,260 @@ public:
     virtual ParameterServer::AllParameters getAllParametersFromVehicle() override;
     virtual void pollCurrentENUreference() override;
 
+    // Parameters are mirrored after the first getAllParametersFromVehicle(). The mirror answers parameter gets without a round trip and
+    // is kept up to date from PARAM_VALUE broadcasts (sent by the vehicle on every change) instead of re-polling.
+    // A PARAM_VALUE for a parameter not in the mirror invalidates it, i.e., the next getAllParametersFromVehicle() fetches everything again.
+    void invalidateParameterCache();
+    virtual bool getCachedParametersFromVehicle(ParameterServer::AllParameters &parameters) const override; // the mirror
+
+    // Blocking MAVSDK calls of these run on a separate thread, one request at a time. Timed out requests are retried.
+    // A request of the same kind as the last queued one (not yet running) is merged into it, merged sets send the latest values.
+    virtual void getIntParameterFromVehicleAsync(std::string name, std::function<void(VehicleConnection::Result, int32_t)> callback) override;
+    virtual void getFloatParameterFromVehicleAsync(std::string name, std::function<void(VehicleConnection::Result, float)> callback) override;
+    virtual void getAllParametersFromVehicleAsync(std::function<void(const ParameterServer::AllParameters &)> callback) override;
+    virtual void setParametersOnVehicleAsync(const ParameterServer::AllParameters &parameters, std::function<void(VehicleConnection::Result)> callback = nullptr) override;
+    static constexpr int PARAMETER_REQUEST_RETRIES = 2;
+
     void setConvertLocalPositionsToGlobalBeforeSending(bool convertLocalPositionsToGlobalBeforeSending);
 
     MAV_TYPE getVehicleType() const;
 
+    // Link statistics as counted by MavsdkStation
+    void setLinkStatistics(const MavlinkLinkStatistics &linkStatistics);
+    MavlinkLinkStatistics getLinkStatistics() const { return mLinkStatistics; }
+
+    // Convoy: the vehicle follows the predecessor's peer-to-peer position broadcast (MAV_CMD_DO_FOLLOW), 0: none.
+    // The gap is reported by the vehicle [m], -1: not following or predecessor lost
+    bool requestConvoyPredecessor(quint8 predecessorSystemId);
+    double getConvoyGap() const { return mConvoyGap_m; }
+
+    // Teach and repeat: the vehicle records the route it is driven until stopped, then follows it when started
+    // (see MavsdkVehicleServer::setRouteRecorder). The recorded route is downloaded with requestCurrentRouteFromVehicle.
+    bool requestRouteRecording(bool start);
+
+    // Sensor health reported by the vehicle (see SensorHealthMonitor): bit i set if sensor i is degraded,
+    // worst rate relative to the expected rate
+    quint32 getDegradedSensors() const { return mDegradedSensors; }
+    double getMinSensorRateRatio() const { return mMinSensorRateRatio; }
+
+    // Vehicle relative to its route as reported by its WaypointFollower (see RouteProjection), invalid until reported
+    RouteProjection getRouteTrackingError() const {
+        RouteProjection routeProjection;
+        routeProjection.valid = mHasRouteTrackingError;
+        routeProjection.crossTrackError_m = mRouteCrossTrackError_m;
+        routeProjection.alongTrack_m = mRouteAlongTrack_m;
+        routeProjection.headingError_rad = mRouteHeadingError_rad;
+        return routeProjection;
+    }
+
+    // Latest value of each performance counter the vehicle published, ordered by name
+    QVector<VehiclePerfCounter> getPerfCounters() const;
+    VehiclePerfCounter getPerfCounter(const QString &name) const; // empty name if not received
+
+    // The vehicle's clock (its time_boot_ms base) is synchronized to ours by TIMESYNC round trips every TIMESYNC_INTERVAL_MS
+    // (see mavlinkTimesync, WayWise vehicles and PX4). Positions decoded from messages (with a message router) are stamped with
+    // their synchronized send time, with their receive time until synchronized.
+    static constexpr int TIMESYNC_INTERVAL_MS = 1000;
+    VehicleClockSync getClockSync() const;
+    qint64 vehicleTimeToUtc_ns(qint64 vehicleTime_ns) const; // utcTime::INVALID if not synchronized
+    qint64 vehicleTimeBootToUtc_ns(uint32_t time_boot_ms) const; // unwraps time_boot_ms (49.7 days)
+    QMap<uint16_t, VehicleMessageLatency> getMessageLatencies() const; // by message ID
+    VehicleMessageLatency getMessageLatency(uint16_t messageId) const;
+
+    // Routes are transferred as one blob to WayWise vehicles (see mavlinkRouteTransfer), the mission protocol is used otherwise
+    // and whenever a bulk transfer fails
+    void setBulkRouteTransferEnabled(bool bulkRouteTransferEnabled) { mBulkRouteTransferEnabled = bulkRouteTransferEnabled; }
+    bool isBulkRouteTransferEnabled() const { return mBulkRouteTransferEnabled; }
+    // Bulk uploads first ask whether the vehicle already stored the route (by hash), the upload is skipped then
+    void setStoredRouteRequestEnabled(bool storedRouteRequestEnabled) { mStoredRouteRequestEnabled = storedRouteRequestEnabled; }
+    bool isStoredRouteRequestEnabled() const { return mStoredRouteRequestEnabled; }
+    // setRoute sends only the changed chunks of the route last uploaded in bulk (see routeCodec::encodeRoutePatch)
+    void setRoutePatchEnabled(bool routePatchEnabled) { mRoutePatchEnabled = routePatchEnabled; }
+    bool isRoutePatchEnabled() const { return mRoutePatchEnabled; }
+    // Geofence enforced by the vehicle's MovementController, uploaded in bulk (WayWise vehicles only), an empty one removes it.
+    // Returns false if it cannot be uploaded, geofenceUploadFinished follows otherwise. A running upload is replaced.
+    bool setGeofenceOnVehicle(const Geofence &geofence);
+    // Route broadcasts (see RouteBroadcast): packets to this vehicle or to all vehicles (target system 0), acks via gotRouteBroadcastAck.
+    // A completed broadcast's transformed route becomes the base for route patches and the cached current route.
+    bool isRouteBroadcastSupported() const { return useBulkRouteTransfer(); }
+    bool sendRouteBroadcastPacket(const mavlinkRouteTransfer::Packet &packet, bool toAllVehicles) { return sendRouteTransferPacket(packet, toAllVehicles); }
+    void setRouteBroadcastOnVehicle(const QVector<pospoint_t> &route);
+
+    // Telemetry rates the UI needs from the vehicle, requested via MAV_CMD_SET_MESSAGE_INTERVAL (WayWise vehicles and PX4):
+    // the selected vehicle gets all streams at their default rates, vehicles only shown on the map get position and
+    // status at reduced rates, off-screen ones at low rates. Vehicles start with all streams at default rates (Selected).
+    enum class TelemetryDemand {Background, Visible, Selected};
+    void setTelemetryDemand(TelemetryDemand telemetryDemand);
+    TelemetryDemand getTelemetryDemand() const { return mTelemetryDemand; }
+
+    // Tags the next command sent (see CommandLatencyTrace): the vehicle traces it through its controllers and returns the
+    // stage latencies with gotCommandLatencyTrace. The issue time is stamped with the synchronized vehicle clock, i.e.,
+    // the link stage is unknown until synchronized.
+    bool sendCommandLatencyTag(quint16 tag, quint8 command);
+
 signals:
     void gotVehicleENUreferenceLlh(const llh_t &enuReferenceLlh);
     void gotVehicleHomeLlh(const llh_t &homePositionLlh);
     void stopWaypointFollowerSignal(); // Used internally from MAVSDK callbacks (that live in other threads)
     void gotHeartbeat(const quint8 systemId);
+    void updatedLinkStatistics(const MavlinkLinkStatistics &linkStatistics);
+    void updatedConvoyGap(double convoyGap_m);
+    void updatedSensorHealth(quint32 degradedSensors, double minSensorRateRatio);
+    void updatedRouteTrackingError(double crossTrackError_m, double alongTrack_m, double headingError_rad);
+    void updatedPerfCounter(const QString &name);
+    void updatedClockSync(const VehicleClockSync &clockSync);
+    void geofenceUploadFinished(bool success);
+    void gotRouteBroadcastAck(const mavlinkRouteTransfer::Packet &ack);
+    void gotCommandLatencyTrace(const CommandLatencyTraceResult &trace);
 
 private:
+    void handleCommandLatencyTrace(const mavlink_debug_float_array_t &traceArray);
+
     MAV_TYPE mVehicleType;
-    llh_t mEnuReference;
+    coordinateTransforms::EnuFrame mEnuFrame;
     llh_t mGpsGlobalOrigin; // reference for on-vehicle EKF (origin in NED, ENU frames on vehicle), polled once at startup
                             // do not use unless you really know what you are doing!
-                            // Use mEnuReference instead.
+                            // Use mEnuFrame instead.
     bool mConvertLocalPositionsToGlobalBeforeSending = false;
     std::shared_ptr<mavsdk::System> mSystem;
     mavsdk::System::ComponentDiscoveredHandle mComponentDiscoveredHandle;
-    std::shared_ptr<mavsdk::Telemetry> mTelemetry;
+    std::shared_ptr<mavsdk::Telemetry> mTelemetry; // not used with a message router
+    mutable std::mutex mPluginMutex; // plugins created on first use, from any thread
     std::shared_ptr<mavsdk::Action> mAction;
-    std::shared_ptr<mavsdk::Param> mParam;
+    mutable std::shared_ptr<mavsdk::Param> mParam;
+    QSharedPointer<MavlinkMessageRouter> mMessageRouter;
+    QList<MavlinkMessageRouter::HandlerId> mRouterSubscriptions;
     std::shared_ptr<mavsdk::MavlinkPassthrough> mMavlinkPassthrough;
     std::shared_ptr<mavsdk::Offboard> mOffboard;
     std::shared_ptr<mavsdk::MissionRaw> mMissionRaw;
     QSharedPointer<QTimer> mPosTimer;
+    static constexpr int MANUAL_CONTROL_IMMEDIATE_DELTA = 200; // [1/1000 of an axis' range]
+    static constexpr int MANUAL_CONTROL_NEUTRAL_REPEATS = 3;
+    QTimer mManualControlTimer;
+    int mManualControlRate_Hz = 25;
+    mavlink_manual_control_t mManualControl {}; // latest sample
+    mavlink_manual_control_t mManualControlSent {};
+    int mManualControlNeutralSent = 0;
+    void sendManualControl();
+    MavlinkRtcmFragments mRtcmFragments;
+    uint8_t mRtcmSequenceId = 0;
+    MavlinkLinkStatistics mLinkStatistics;
+    std::atomic<double> mConvoyGap_m{-1.0};
+    std::atomic<quint32> mDegradedSensors{0};
+    std::atomic<double> mMinSensorRateRatio{1.0};
+    std::atomic<bool> mHasRouteTrackingError{false};
+    std::atomic<double> mRouteCrossTrackError_m{0.0};
+    std::atomic<double> mRouteAlongTrack_m{0.0};
+    std::atomic<double> mRouteHeadingError_rad{0.0};
+
+    TelemetryDemand mTelemetryDemand = TelemetryDemand::Selected;
+
+    bool mBulkRouteTransferEnabled = true;
+    bool mBulkRouteTransferSupported = true; // until the vehicle did not answer
+    bool mStoredRouteRequestEnabled = true;
+    bool mRoutePatchEnabled = true;
+    QVector<pospoint_t> mRouteOnVehicle; // as uploaded in bulk, base for route patches
+    QVector<pospoint_t> mRouteUploadRoute; // the vehicle's route after the running upload
+    bool mRouteUploadIsPatch = false;
+    uint16_t mNextRouteTransferId = 0;
+    mavlinkRouteTransfer::ChunkSender mRouteUploadSender;
+    QList<PosPoint> mRouteUploadFallback; // sent via mission protocol if the bulk upload fails
+    mavlinkRouteTransfer::ChunkSender mGeofenceUploadSender;
+    std::mutex mRouteDownloadMutex; // download chunks arrive in MAVSDK threads
+    std::condition_variable mRouteDownloadCondition;
+    mavlinkRouteTransfer::ChunkAssembler mRouteDownloadAssembler;
+    uint16_t mRouteDownloadTransferId = 0;
+    bool mRouteDownloadActive = false;
+    int mRouteDownloadChunksReceived = 0;
+    bool mRouteDownloadUnchanged = false; // acknowledged without chunks: mCachedCurrentRoute is the vehicle's route
+
+    mutable std::mutex mPerfCountersMutex; // DEBUG_FLOAT_ARRAY arrives in MAVSDK threads
+    QMap<QString, VehiclePerfCounter> mPerfCounters;
+
+    static constexpr int TIMESYNC_PENDING_REQUESTS = 4;
+    static constexpr double MESSAGE_LATENCY_AVERAGING = 0.1;
+    QTimer mTimesyncTimer;
+    mutable std::mutex mClockSyncMutex; // TIMESYNC and timestamped messages arrive in MAVSDK threads
+    ClockSyncEstimator mClockSync; // station UTC [ns] = local, vehicle time since boot [ns] = remote
+    std::array<int64_t, TIMESYNC_PENDING_REQUESTS> mTimesyncRequests {}; // ts1 of the latest requests
+    int mNextTimesyncRequest = 0;
+    QMap<uint16_t, VehicleMessageLatency> mMessageLatencies;
+    void sendTimesyncRequest();
+    void handleTimesync(const mavlink_message_t &message);
+    VehicleClockSync getClockSyncLocked() const;
+    int64_t unwrapTimeBoot_ns(uint32_t time_boot_ms) const; // clock sync mutex held, -1 if not synchronized
+    // Synchronized send time [UTC ns] of a message (and records its latency), its receive time if not synchronized
+    qint64 getMessageTimestamp_ns(uint16_t messageId, uint32_t time_boot_ms);
+
+    // Landing targets are converted to the vehicle's local NED frame (origin: GPS global origin) with frames cached on changes
+    struct LandingTargetFrames {
+        coordinateTransforms::EnuFrame vehicleOrigin;
+        coordinateTransforms::EnuTransform fromStationEnu; // mEnuFrame -> vehicleOrigin
+    };
+    struct LandingTargetSample {
+        xyz_t positionENU; // station ENU
+        llh_t positionLlh;
+        bool isLlh = false;
+        qint64 measured_ns = 0;
+    };
+    SeqLock<LandingTargetFrames> mLandingTargetFrames;
+    LatestValueMailbox<LandingTargetSample> mLandingTargetMailbox;
+    std::atomic<qint64> mLandingTargetMaxSampleAge_ns{100 * utcTime::NS_PER_MS};
+    std::atomic<quint64> mLandingTargetsSent{0};
+    std::atomic<quint64> mLandingTargetsDroppedStale{0};
+    std::atomic<quint64> mLandingTargetSendFailures{0};
+    std::atomic<double> mLandingTargetLastSampleAge_ms{0.0};
+    ControlLoop mLandingTargetLoop{[this]() { sendLatestLandingTarget(); }, 33};
+    void updateLandingTargetFrames();
+    void sendLatestLandingTarget(); // stream thread
+    mavsdk::MavlinkPassthrough::Result sendLandingTarget(const xyz_t &landingTargetNED, qint64 measured_ns); // any thread
+
+    mutable std::mutex mParameterCacheMutex; // PARAM_VALUE arrives in MAVSDK threads
+    ParameterServer::AllParameters mParameterCache;
+    bool mParameterCacheValid = false;
+
+    struct ParameterRequest {
+        enum class Type {GetInt, GetFloat, GetAll, Set};
+        Type type;
+        std::string name; // GetInt/GetFloat
+        ParameterServer::AllParameters parameters; // Set: input, GetAll: output
+        VehicleConnection::Result result = VehicleConnection::Result::Unknown;
+        int32_t intValue = 0;
+        float floatValue = 0.0;
+        bool started = false;
+        QList<std::function<void(const ParameterRequest &)>> callbacks;
+    };
+    QThread mParameterThread;
+    QObject *mParameterThreadContext;
+    QList<QSharedPointer<ParameterRequest>> mParameterRequestQueue; // owner thread only, first entry is running when started
 
     mavsdk::MissionRaw::MissionItem convertPosPointToMissionItem(const PosPoint& posPoint, int sequenceId, bool current = false);
+    bool useBulkRouteTransfer() const;
+    void uploadRouteAsMission(const QList<PosPoint> &route);
+    bool downloadRouteInBulk(QList<PosPoint> &route);
+    void handleRouteTransferPacket(const mavlinkRouteTransfer::Packet &packet);
+    bool sendRouteTransferPacket(const mavlinkRouteTransfer::Packet &packet, bool toAllVehicles = false);
+    void handleParameterValue(const mavlink_message_t &message);
+    void queueParameterRequest(ParameterRequest::Type type, const std::string &name, const ParameterServer::AllParameters &parameters,
+                               std::function<void(const ParameterRequest &)> callback);
+    void processNextParameterRequest();
+    VehicleConnection::Result executeParameterRequest(ParameterRequest &request); // parameter thread
     VehicleConnection::Result convertParamResult(mavsdk::Param::Result result) const;
     QString convertMissionRawResult(mavsdk::MissionRaw::Result result) const;
     QString convertMavlinkPassthroughResult(mavsdk::MavlinkPassthrough::Result result) const;
-    void setupCarState(QSharedPointer<CarState> carState);
+    void subscribeMessage(uint16_t messageId, std::function<void(const mavlink_message_t &)> handler); // via router or MavlinkPassthrough
+    std::shared_ptr<mavsdk::Action> getActionPlugin();
+    std::shared_ptr<mavsdk::Param> getParamPlugin() const;
+    void setupTelemetryPlugin();
+    void setupTelemetryMessages();
+    void handleHomePosition(const llh_t &homeLlh);
+    void handleFlightMode(VehicleState::FlightMode flightMode);
+    // Vehicle geometry is requested asynchronously, i.e., the connection is usable at once and the state is initialized
+    // (see CarState::isStateInitialized) when all parameters arrived. parameters: additional ones (e.g., of a truck)
+    void setupCarState(QSharedPointer<CarState> carState, QList<QPair<std::string, std::function<void(float)>>> parameters = {});
     void setupTruckState(QSharedPointer<TruckState> truckState);
+    // finished is called after the last answer (also if some failed), apply for each successful one
+    void getFloatParametersFromVehicleAsync(const QList<QPair<std::string, std::function<void(float)>>> &parameters, std::function<void()> finished);
 
     // VehicleConnection interface
 protected:
@@ -108,6 +410,7 @@ protected:
     virtual void stopAutopilotOnVehicle() override;
     virtual void clearRouteOnVehicle(int id) override;
     virtual void appendToRouteOnVehicle(const QList<PosPoint> &route, int id) override;
+    virtual void setRouteOnVehicle(const QList<PosPoint> &route, int id) override;
     virtual void setActiveAutopilotIDOnVehicle(int id) override;
     virtual void startFollowPointOnVehicle() override;
     virtual void stopFollowPointOnVehicle() override;
@@ -0,0 +1,205 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routebroadcast.h"
+#include "core/routecodec.h"
+#include <QDebug>
+#include <QRandomGenerator>
+
+bool RouteBroadcastReport::isSuccess() const
+{
+    if (aborted)
+        return false;
+    for (const RouteBroadcastVehicleResult &vehicle : vehicles)
+        if (!vehicle.success)
+            return false;
+    return true;
+}
+
+RouteBroadcast::RouteBroadcast(QObject *parent) : QObject(parent),
+    mTransferId(QRandomGenerator::global()->generate()) // vehicles remember the last completed broadcast, also across our restarts
+{
+    mChunkTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mChunkTimer, &QTimer::timeout, this, &RouteBroadcast::sendNextPacket);
+    mPollTimer.setSingleShot(true);
+    connect(&mPollTimer, &QTimer::timeout, this, &RouteBroadcast::pollReceivers);
+}
+
+bool RouteBroadcast::start(const QList<PosPoint> &route, const QList<RouteBroadcastTarget> &targets)
+{
+    if (isActive() || targets.isEmpty())
+        return false;
+    for (const RouteBroadcastTarget &target : targets)
+        if (target.vehicleConnection.isNull() || !target.vehicleConnection->isRouteBroadcastSupported())
+            return false;
+
+    const QByteArray encodedRoute = routeCodec::encodeRoute(route);
+    const int chunkCount = std::max((encodedRoute.size() + mavlinkRouteTransfer::MAX_CHUNK_DATA_SIZE - 1) / mavlinkRouteTransfer::MAX_CHUNK_DATA_SIZE, 1);
+    if (chunkCount > mavlinkRouteTransfer::MAX_CHUNKS || !routeCodec::decodeRoute(encodedRoute, mRoute))
+        return false;
+
+    mTransferId++;
+    mRouteHash = routeCodec::getRouteHash(encodedRoute);
+    mChunks.clear();
+    for (int i = 0; i < chunkCount; i++)
+        mChunks.append(encodedRoute.mid(i * mavlinkRouteTransfer::MAX_CHUNK_DATA_SIZE, mavlinkRouteTransfer::MAX_CHUNK_DATA_SIZE));
+    mNextBroadcastChunk = 0;
+    mNextReceiver = 0;
+
+    mReport = RouteBroadcastReport();
+    mReport.chunkCount = chunkCount;
+    for (int i = 0; i < targets.size(); i++) {
+        Receiver receiver;
+        receiver.target = targets.at(i);
+        receiver.ackConnection = connect(receiver.target.vehicleConnection.get(), &MavsdkVehicleConnection::gotRouteBroadcastAck, this,
+                                         [this, i](const mavlinkRouteTransfer::Packet &ack) { handleAck(i, ack); });
+        mReceivers.append(receiver);
+        RouteBroadcastVehicleResult result;
+        result.vehicleId = receiver.target.vehicleConnection->getVehicleState()->getId();
+        mReport.vehicles.append(result);
+    }
+
+    mTimer.start();
+    mChunkTimer.start(mChunkInterval_ms);
+    return true;
+}
+
+void RouteBroadcast::abort()
+{
+    if (isActive())
+        finish(true);
+}
+
+void RouteBroadcast::sendNextPacket()
+{
+    mavlinkRouteTransfer::Packet packet;
+    packet.transferId = mTransferId;
+    packet.chunkCount = mChunks.size();
+
+    // Requests first: vehicles only collect broadcast chunks they were asked for
+    for (Receiver &receiver : mReceivers) {
+        if (receiver.finished || !receiver.requestPending)
+            continue;
+        packet.type = mavlinkRouteTransfer::PacketType::BroadcastRequest;
+        packet.routeHash = mRouteHash;
+        packet.transform = receiver.target.transform;
+        if (receiver.target.vehicleConnection->sendRouteBroadcastPacket(packet, false)) // retry on next tick otherwise
+            receiver.requestPending = false;
+        return;
+    }
+
+    packet.type = mavlinkRouteTransfer::PacketType::BroadcastChunk;
+    if (mNextBroadcastChunk < mChunks.size()) {
+        packet.chunkIndex = mNextBroadcastChunk;
+        packet.data = mChunks.at(mNextBroadcastChunk);
+        if (mReceivers.first().target.vehicleConnection->sendRouteBroadcastPacket(packet, true))
+            mNextBroadcastChunk++;
+        return;
+    }
+
+    for (int i = 0; i < mReceivers.size(); i++) {
+        const int index = (mNextReceiver + i) % mReceivers.size();
+        Receiver &receiver = mReceivers[index];
+        if (receiver.finished || receiver.pendingChunks.isEmpty())
+            continue;
+        packet.chunkIndex = receiver.pendingChunks.first();
+        packet.data = mChunks.at(packet.chunkIndex);
+        if (receiver.target.vehicleConnection->sendRouteBroadcastPacket(packet, false)) {
+            receiver.pendingChunks.removeFirst();
+            mReport.vehicles[index].retransmittedChunks++;
+            mReport.retransmittedChunks++;
+        }
+        mNextReceiver = index + 1;
+        return;
+    }
+
+    // Idle until vehicles report missing chunks
+    mChunkTimer.stop();
+    mPollTimer.start(POLL_TIMEOUT_ms);
+}
+
+void RouteBroadcast::pollReceivers()
+{
+    for (int i = 0; i < mReceivers.size() && isActive(); i++) {
+        Receiver &receiver = mReceivers[i];
+        if (receiver.finished)
+            continue;
+        if (++receiver.polls > MAX_POLLS) {
+            qDebug() << "WARNING: route broadcast" << mTransferId << "got no acknowledgement from vehicle" << mReport.vehicles.at(i).vehicleId;
+            finishReceiver(i, false);
+        } else {
+            receiver.requestPending = true; // the vehicle answers with the chunks it misses
+        }
+    }
+    if (isActive())
+        kick();
+}
+
+void RouteBroadcast::handleAck(int index, const mavlinkRouteTransfer::Packet &ack)
+{
+    if (ack.transferId != mTransferId || index >= mReceivers.size() || mReceivers.at(index).finished)
+        return;
+
+    Receiver &receiver = mReceivers[index];
+    switch (ack.status) {
+    case mavlinkRouteTransfer::AckStatus::Complete: {
+        QVector<pospoint_t> route = mRoute;
+        mavlinkRouteTransfer::applyRouteTransform(receiver.target.transform, route);
+        receiver.target.vehicleConnection->setRouteBroadcastOnVehicle(route);
+        finishReceiver(index, true);
+        break;
+    }
+    case mavlinkRouteTransfer::AckStatus::Missing:
+        receiver.polls = 0;
+        for (uint16_t chunkIndex : ack.missingChunks)
+            if (chunkIndex < mChunks.size() && !receiver.pendingChunks.contains(chunkIndex))
+                receiver.pendingChunks.append(chunkIndex);
+        kick();
+        break;
+    case mavlinkRouteTransfer::AckStatus::Failed:
+        finishReceiver(index, false);
+        break;
+    }
+}
+
+void RouteBroadcast::finishReceiver(int index, bool success)
+{
+    Receiver &receiver = mReceivers[index];
+    receiver.finished = true;
+    receiver.pendingChunks.clear();
+    disconnect(receiver.ackConnection);
+    mReport.vehicles[index].success = success;
+    emit vehicleFinished(mReport.vehicles.at(index).vehicleId, success);
+    if (!isActive()) // aborted by a receiver of vehicleFinished
+        return;
+
+    for (const Receiver &other : mReceivers)
+        if (!other.finished)
+            return;
+    finish(false);
+}
+
+void RouteBroadcast::kick()
+{
+    if (mChunkTimer.isActive())
+        return;
+
+    mPollTimer.stop();
+    mChunkTimer.start(mChunkInterval_ms);
+}
+
+void RouteBroadcast::finish(bool aborted)
+{
+    mChunkTimer.stop();
+    mPollTimer.stop();
+    for (const Receiver &receiver : mReceivers)
+        disconnect(receiver.ackConnection);
+    mReceivers.clear();
+    mChunks.clear();
+    mRoute.clear();
+
+    mReport.aborted = aborted;
+    mReport.duration_ms = mTimer.nsecsElapsed() / 1e6;
+    emit finished(mReport);
+}
@@ -0,0 +1,105 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Sends one route to many WayWise vehicles with a single upload, e.g., the same route (or offset copies of it) to a swarm:
+ * the encoded route's chunks are sent once to all vehicles (MAVLink target system 0, see mavlinkRouteTransfer), each vehicle
+ * applies its own RouteTransform and replaces its route with the result. Chunks a vehicle missed are resent to it only.
+ * Broadcast chunks go out on the first target's link, vehicles on other links get all chunks resent to them.
+ * Lives in (and must be used from) the thread of the connections. Uploads through setRoute at the same time are not coordinated.
+ *
+ *     RouteBroadcast broadcast;
+ *     QList<RouteBroadcastTarget> targets;
+ *     mavlinkRouteTransfer::RouteTransform transform;
+ *     for (const auto &vehicleConnection : station.getVehicleConnectionList()) {
+ *         targets.append({vehicleConnection, transform});
+ *         transform.offsetY_m += 3.0f; // side by side
+ *     }
+ *     broadcast.start(route, targets);
+ */
+
+#ifndef ROUTEBROADCAST_H
+#define ROUTEBROADCAST_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+#include "mavsdkvehicleconnection.h"
+#include "communication/mavlinkroutetransfer.h"
+
+struct RouteBroadcastTarget {
+    QSharedPointer<MavsdkVehicleConnection> vehicleConnection;
+    mavlinkRouteTransfer::RouteTransform transform;
+};
+
+struct RouteBroadcastVehicleResult {
+    int vehicleId = 0;
+    bool success = false;
+    int retransmittedChunks = 0; // sent to this vehicle only
+};
+
+struct RouteBroadcastReport {
+    QVector<RouteBroadcastVehicleResult> vehicles; // in the order given to start()
+    int chunkCount = 0;
+    int retransmittedChunks = 0; // to all vehicles
+    bool aborted = false;
+    double duration_ms = 0.0;
+    bool isSuccess() const;
+};
+
+class RouteBroadcast : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RouteBroadcast(QObject *parent = nullptr);
+
+    void setChunkRate(int chunkRate_Hz) { mChunkInterval_ms = std::max(1000 / std::max(chunkRate_Hz, 1), 1); } // on all links together
+
+    // Returns false if a broadcast is running, the route is too large or a target does not support bulk route transfers
+    bool start(const QList<PosPoint> &route, const QList<RouteBroadcastTarget> &targets);
+    void abort(); // emits finished
+    bool isActive() const { return !mReceivers.isEmpty(); }
+    RouteBroadcastReport getReport() const { return mReport; }
+
+signals:
+    void vehicleFinished(int vehicleId, bool success);
+    void finished(const RouteBroadcastReport &report);
+
+private:
+    struct Receiver {
+        RouteBroadcastTarget target;
+        QList<uint16_t> pendingChunks; // resent to this vehicle only
+        bool requestPending = true;
+        bool finished = false;
+        int polls = 0; // requests without progress
+        QMetaObject::Connection ackConnection;
+    };
+
+    void sendNextPacket();
+    void pollReceivers();
+    void handleAck(int index, const mavlinkRouteTransfer::Packet &ack);
+    void finishReceiver(int index, bool success);
+    void kick();
+    void finish(bool aborted);
+
+    uint16_t mTransferId;
+    quint64 mRouteHash = 0;
+    QVector<pospoint_t> mRoute; // as decoded by the vehicles
+    QVector<QByteArray> mChunks;
+    int mNextBroadcastChunk = 0;
+    int mNextReceiver = 0; // round-robin of retransmissions
+    QVector<Receiver> mReceivers;
+    RouteBroadcastReport mReport;
+    QElapsedTimer mTimer;
+    int mChunkInterval_ms = 5;
+    QTimer mChunkTimer;
+    QTimer mPollTimer;
+
+    static constexpr int POLL_TIMEOUT_ms = 1000; // vehicles that stay silent while we are idle are asked again
+    static constexpr int MAX_POLLS = 3;
+};
+
+#endif // ROUTEBROADCAST_H
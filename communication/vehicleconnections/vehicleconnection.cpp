@@ -82,8 +82,11 @@ void VehicleConnection::appendToRoute(const QList<PosPoint> &route, int id)
 }
 
 void VehicleConnection::setRoute(const QList<PosPoint> &route, int id) {
-    clearRoute(id);
-    appendToRoute(route, id);
+    if (!mWaypointFollower.isNull()) {
+        clearRoute(id);
+        appendToRoute(route, id);
+    } else
+        setRouteOnVehicle(route, id);
 }
 
 QSharedPointer<VehicleState> VehicleConnection::getVehicleState() const {
@@ -127,3 +130,51 @@ void VehicleConnection::updatePointToFollowInEnuFrame(const PosPoint &point)
     if (!mFollowPoint.isNull())
         mFollowPoint->updatePointToFollowInEnuFrame(point);
 }
+
+VehicleConnection::Result VehicleConnection::setParametersOnVehicle(const ParameterServer::AllParameters &parameters)
+{
+    for (const auto& parameter : parameters.intParameters) {
+        const Result result = setIntParameterOnVehicle(parameter.name, parameter.value);
+        if (result != Result::Success)
+            return result;
+    }
+    for (const auto& parameter : parameters.floatParameters) {
+        const Result result = setFloatParameterOnVehicle(parameter.name, parameter.value);
+        if (result != Result::Success)
+            return result;
+    }
+    for (const auto& parameter : parameters.customParameters) {
+        const Result result = setCustomParameterOnVehicle(parameter.name, parameter.value);
+        if (result != Result::Success)
+            return result;
+    }
+    return Result::Success;
+}
+
+void VehicleConnection::getIntParameterFromVehicleAsync(std::string name, std::function<void(Result, int32_t)> callback)
+{
+    const auto result = getIntParameterFromVehicle(name);
+    if (callback)
+        callback(result.first, result.second);
+}
+
+void VehicleConnection::getFloatParameterFromVehicleAsync(std::string name, std::function<void(Result, float)> callback)
+{
+    const auto result = getFloatParameterFromVehicle(name);
+    if (callback)
+        callback(result.first, result.second);
+}
+
+void VehicleConnection::getAllParametersFromVehicleAsync(std::function<void(const ParameterServer::AllParameters &)> callback)
+{
+    const ParameterServer::AllParameters parameters = getAllParametersFromVehicle();
+    if (callback)
+        callback(parameters);
+}
+
+void VehicleConnection::setParametersOnVehicleAsync(const ParameterServer::AllParameters &parameters, std::function<void(Result)> callback)
+{
+    const Result result = setParametersOnVehicle(parameters);
+    if (callback)
+        callback(result);
+}
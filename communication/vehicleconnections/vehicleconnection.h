@@ -10,6 +10,7 @@
 
 #include <QObject>
 #include <QDebug>
+#include <functional>
 #include "core/coordinatetransforms.h"
 #include "vehicles/vehiclestate.h"
 #include "sensors/camera/gimbal.h"
@@ -65,8 +66,24 @@ public:
     virtual std::pair<Result, float> getFloatParameterFromVehicle(std::string name) const = 0;
     virtual std::pair<Result, std::string> getCustomParameterFromVehicle(std::string name) const = 0;
     virtual ParameterServer::AllParameters getAllParametersFromVehicle() = 0;
+    // Sets parameters in order, stops at the first failure (parameters before it remain set)
+    virtual Result setParametersOnVehicle(const ParameterServer::AllParameters &parameters);
+    // Non-blocking variants of the above, callbacks are called in the thread the connection lives in.
+    // The defaults call the blocking functions, connections with slow links should override them.
+    virtual void getIntParameterFromVehicleAsync(std::string name, std::function<void(Result, int32_t)> callback);
+    virtual void getFloatParameterFromVehicleAsync(std::string name, std::function<void(Result, float)> callback);
+    virtual void getAllParametersFromVehicleAsync(std::function<void(const ParameterServer::AllParameters &)> callback);
+    virtual void setParametersOnVehicleAsync(const ParameterServer::AllParameters &parameters, std::function<void(Result)> callback = nullptr);
+    // Parameters as known by the connection without a round trip (e.g., a mirror of the vehicle's parameters), false if there are none
+    virtual bool getCachedParametersFromVehicle(ParameterServer::AllParameters &parameters) const { Q_UNUSED(parameters) return false; }
     virtual void pollCurrentENUreference() = 0;
 
+    // Last route downloaded from the vehicle (routeCodec encoded) and its routeCodec::getRouteHash, e.g., restored from a
+    // SessionSnapshot. Connections that can compare it to the vehicle's route reuse it instead of downloading an unchanged route.
+    QByteArray getCachedCurrentRoute() const { return mCachedCurrentRoute; }
+    quint64 getCachedCurrentRouteHash() const { return mCachedCurrentRouteHash; }
+    void setCachedCurrentRoute(const QByteArray &encodedRoute, quint64 routeHash) { mCachedCurrentRoute = encodedRoute; mCachedCurrentRouteHash = routeHash; }
+
     void setWaypointFollowerConnectionLocal(const QSharedPointer<WaypointFollower> &waypointFollower);
     bool hasWaypointFollowerConnectionLocal();
     void setFollowPointConnectionLocal(const QSharedPointer<FollowPoint> &followPoint);
@@ -91,6 +108,7 @@ public:
 signals:
     void detectedGimbal(QSharedPointer<Gimbal> gimbal);
     void updatedBatteryState(float voltage, float percentRemaining);
+    void updatedParametersOnVehicle(const QStringList &parameterNames); // changed on the vehicle, e.g., by another client
 
 protected:
     // Implement these as protected/private, they are used within the respective functions without "OnVehicle" in their names
@@ -101,6 +119,8 @@ protected:
     virtual void stopAutopilotOnVehicle() {throw  std::logic_error("Function not implemented");};
     virtual void clearRouteOnVehicle(int id = 0) {Q_UNUSED(id) throw  std::logic_error("Function not implemented");};
     virtual void appendToRouteOnVehicle(const QList<PosPoint> &route, int id = 0) {Q_UNUSED(route )Q_UNUSED(id) throw  std::logic_error("Function not implemented");};
+    // Connections that can update the vehicle's route in place (e.g., only changed parts) override this
+    virtual void setRouteOnVehicle(const QList<PosPoint> &route, int id = 0) { clearRouteOnVehicle(id); appendToRouteOnVehicle(route, id); }
     virtual void setActiveAutopilotIDOnVehicle(int id = 0) {Q_UNUSED(id) throw  std::logic_error("Function not implemented");};
     virtual void startFollowPointOnVehicle() {throw  std::logic_error("Function not implemented");};
     virtual void stopFollowPointOnVehicle() {throw  std::logic_error("Function not implemented");};
@@ -109,6 +129,8 @@ protected:
     QSharedPointer<Gimbal> mGimbal;
     QSharedPointer<WaypointFollower> mWaypointFollower;
     QSharedPointer<FollowPoint> mFollowPoint;
+    QByteArray mCachedCurrentRoute;
+    quint64 mCachedCurrentRouteHash = 0; // 0: none
 
 };
 
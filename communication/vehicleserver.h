@@ -8,7 +8,9 @@
 
 #include <QObject>
 #include <QSharedPointer>
-#include <QTimer>
+#include <atomic>
+#include <functional>
+#include "core/clock.h"
 #include "autopilot/waypointfollower.h"
 #include "autopilot/followpoint.h"
 #include "sensors/gnss/ubloxrover.h"
@@ -30,6 +32,9 @@ public:
     virtual double getManualControlMaxSpeed() const = 0;
     virtual void sendGpsOriginLlh(const llh_t &gpsOriginLlh) = 0;
     virtual void updateRawGpsAndGpsInfoFromUbx(const ubx_nav_pvt &pvt) = 0;
+    virtual void setClock(Clock *clock) { mHeartbeatTimer.setClock(clock); } // nullptr: real-time clock
+    // Called on every heartbeat of the control station, from communication threads (e.g., to feed a SafetyWatchdog source)
+    void setStationHeartbeatCallback(std::function<void()> stationHeartbeatCallback) { mStationHeartbeatCallback = stationHeartbeatCallback; }
 
 signals:
     void startWaypointFollower(bool fromBeginning);
@@ -50,8 +55,9 @@ protected:
     QSharedPointer<MovementController> mMovementController;
     QSharedPointer<FollowPoint> mFollowPoint;
 
-    bool mHeartbeat;
-    QTimer mHeartbeatTimer;
+    std::atomic<bool> mHeartbeat{false}; // also read and set in communication threads
+    ClockTimer mHeartbeatTimer;
+    std::function<void()> mStationHeartbeatCallback;
     const unsigned mCountdown_ms = 2000;
 
     virtual void heartbeatTimeout() = 0;
@@ -0,0 +1,215 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "allocationtracker.h"
+#include "core/perfcounters.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+struct alignas(64) ThreadCounters {
+    std::atomic<bool> inUse{false};
+    std::array<std::atomic<quint64>, AllocationTracker::MAX_TAGS> allocations {};
+    std::array<std::atomic<quint64>, AllocationTracker::MAX_TAGS> bytes {};
+    std::array<std::atomic<quint64>, AllocationTracker::MAX_TAGS> deallocations {};
+};
+
+// Zero-initialized before any allocation, the last one is shared by threads beyond MAX_THREADS
+ThreadCounters sThreadCounters[AllocationTracker::MAX_THREADS + 1];
+ThreadCounters &sSharedCounters = sThreadCounters[AllocationTracker::MAX_THREADS];
+
+thread_local ThreadCounters *tCounters = nullptr;
+thread_local bool tClaiming = false;
+thread_local bool tExited = false;
+
+// Returns the thread's counters to the pool when it exits, the next thread continues their totals
+struct ThreadCountersRelease {
+    ThreadCounters *counters = nullptr;
+    ~ThreadCountersRelease() {
+        tExited = true;
+        tCounters = &sSharedCounters;
+        if (counters)
+            counters->inUse.store(false, std::memory_order_release);
+    }
+};
+thread_local ThreadCountersRelease tCountersRelease;
+
+ThreadCounters &getThreadCounters() noexcept
+{
+    if (tCounters)
+        return *tCounters;
+    if (tClaiming || tExited) // allocations from registering tCountersRelease
+        return sSharedCounters;
+
+    tClaiming = true;
+    ThreadCounters *counters = &sSharedCounters;
+    for (int i = 0; i < AllocationTracker::MAX_THREADS; i++) {
+        bool inUse = false;
+        if (sThreadCounters[i].inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) {
+            counters = &sThreadCounters[i];
+            break;
+        }
+    }
+    tCountersRelease.counters = counters != &sSharedCounters ? counters : nullptr;
+    tCounters = counters;
+    tClaiming = false;
+    return *counters;
+}
+
+inline void increment(ThreadCounters &counters, std::atomic<quint64> &counter, quint64 value) noexcept
+{
+    // Only the owning thread writes its counters
+    if (&counters == &sSharedCounters)
+        counter.fetch_add(value, std::memory_order_relaxed);
+    else
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+}
+
+AllocationTracker::AllocationTracker()
+{
+    mTagNames[UNTAGGED] = "OTHER";
+    mAllocationsCounterIds.fill(-1);
+    mBytesCounterIds.fill(-1);
+}
+
+AllocationTracker &AllocationTracker::getInstance()
+{
+    static AllocationTracker instance;
+    return instance;
+}
+
+bool AllocationTracker::isEnabled()
+{
+#ifdef WAYWISE_ALLOCATION_TRACKING
+    return true;
+#else
+    return false;
+#endif
+}
+
+int AllocationTracker::registerTag(const QString &name)
+{
+    const QString tagName = name.left(MAX_TAG_LENGTH);
+    std::lock_guard<std::mutex> lock(mRegistrationMutex);
+    const int numTags = mNumTags.load(std::memory_order_relaxed);
+    for (int i = 0; i < numTags; i++)
+        if (mTagNames[i] == tagName)
+            return i;
+
+    if (numTags >= MAX_TAGS)
+        return UNTAGGED;
+
+    mTagNames[numTags] = tagName;
+    mNumTags.store(numTags + 1, std::memory_order_release);
+    return numTags;
+}
+
+QVector<AllocationTagStatistics> AllocationTracker::getStatistics() const
+{
+    const int numTags = getNumTags();
+    QVector<AllocationTagStatistics> statistics(numTags);
+    for (int i = 0; i < numTags; i++)
+        statistics[i].name = mTagNames[i];
+    for (const ThreadCounters &counters : sThreadCounters) {
+        for (int i = 0; i < numTags; i++) {
+            statistics[i].allocations += counters.allocations[i].load(std::memory_order_relaxed);
+            statistics[i].bytes += counters.bytes[i].load(std::memory_order_relaxed);
+            statistics[i].deallocations += counters.deallocations[i].load(std::memory_order_relaxed);
+        }
+    }
+    return statistics;
+}
+
+void AllocationTracker::publish()
+{
+    if (!isEnabled())
+        return;
+
+    const QVector<AllocationTagStatistics> statistics = getStatistics();
+    PerfCounters &perfCounters = PerfCounters::getInstance();
+    std::lock_guard<std::mutex> lock(mPublishMutex);
+    for (int i = 0; i < statistics.size(); i++) {
+        if (mAllocationsCounterIds[i] < 0) {
+            mAllocationsCounterIds[i] = perfCounters.registerCounter("AL_" + statistics.at(i).name, PerfCounters::Type::Counter);
+            mBytesCounterIds[i] = perfCounters.registerCounter("ALB_" + statistics.at(i).name, PerfCounters::Type::Counter);
+        }
+        perfCounters.add(mAllocationsCounterIds[i], statistics.at(i).allocations - mPublishedAllocations[i]);
+        perfCounters.add(mBytesCounterIds[i], statistics.at(i).bytes - mPublishedBytes[i]);
+        mPublishedAllocations[i] = statistics.at(i).allocations;
+        mPublishedBytes[i] = statistics.at(i).bytes;
+    }
+}
+
+void AllocationTracker::recordAllocation(std::size_t size) noexcept
+{
+    ThreadCounters &counters = getThreadCounters();
+    increment(counters, counters.allocations[tCurrentTag], 1);
+    increment(counters, counters.bytes[tCurrentTag], size);
+}
+
+void AllocationTracker::recordDeallocation() noexcept
+{
+    ThreadCounters &counters = getThreadCounters();
+    increment(counters, counters.deallocations[tCurrentTag], 1);
+}
+
+#ifdef WAYWISE_ALLOCATION_TRACKING
+void *operator new(std::size_t size)
+{
+    AllocationTracker::recordAllocation(size);
+    if (void *pointer = std::malloc(size > 0 ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    AllocationTracker::recordAllocation(size);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if (pointer) {
+        AllocationTracker::recordDeallocation();
+        std::free(pointer);
+    }
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+    ::operator delete(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+    ::operator delete(pointer);
+}
+#endif
@@ -0,0 +1,85 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Heap allocations per subsystem. Defining WAYWISE_ALLOCATION_TRACKING replaces the global operator new/delete (see
+ * allocationtracker.cpp), which count every allocation (and its bytes) and deallocation for the tag of the current thread.
+ * Subsystems set their tag for a scope (ScopedTag, nesting restores the outer tag), everything else is UNTAGGED.
+ * Counters are per thread (plain relaxed stores, no contention), summed up on reads. Threads beyond MAX_THREADS share one set of
+ * atomic counters. Deallocations are counted for the tag of the freeing thread, aligned new/delete (alignas > 16) are not counted.
+ * publish() adds what was allocated since its last call to the perf counters AL_<tag> (allocations) and ALB_<tag> (bytes),
+ * i.e., their rate is per second (e.g., called by MavsdkVehicleServer before publishing perf counters).
+ * Without WAYWISE_ALLOCATION_TRACKING, tags are still registered and set, but nothing is counted.
+ *
+ *     static const int tag = AllocationTracker::getInstance().registerTag("PP");
+ *     AllocationTracker::ScopedTag allocationTag(tag);
+ */
+
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+struct AllocationTagStatistics {
+    QString name;
+    quint64 allocations = 0;
+    quint64 bytes = 0; // allocated, without allocator overhead
+    quint64 deallocations = 0;
+};
+
+class AllocationTracker
+{
+public:
+    static constexpr int MAX_TAGS = 16;
+    static constexpr int MAX_THREADS = 64;
+    static constexpr int MAX_TAG_LENGTH = 6; // perf counter name ALB_<tag>
+    static constexpr int UNTAGGED = 0; // named OTHER
+
+    static AllocationTracker &getInstance();
+    static bool isEnabled(); // built with WAYWISE_ALLOCATION_TRACKING
+
+    // Names are cut to MAX_TAG_LENGTH, registering an existing name returns its ID, UNTAGGED if MAX_TAGS are registered
+    int registerTag(const QString &name);
+    int getNumTags() const { return mNumTags.load(std::memory_order_acquire); }
+
+    // Allocations of the current thread are counted for tag from construction to destruction
+    class ScopedTag {
+    public:
+        explicit ScopedTag(int tag) : mPreviousTag(tCurrentTag) { if (tag >= 0 && tag < MAX_TAGS) tCurrentTag = tag; }
+        ~ScopedTag() { tCurrentTag = mPreviousTag; }
+        ScopedTag(const ScopedTag &) = delete;
+        ScopedTag &operator=(const ScopedTag &) = delete;
+    private:
+        int mPreviousTag;
+    };
+
+    // Totals since start, over all threads
+    QVector<AllocationTagStatistics> getStatistics() const;
+    void publish();
+
+    // From the operator new/delete replacements, must not allocate
+    static void recordAllocation(std::size_t size) noexcept;
+    static void recordDeallocation() noexcept;
+
+private:
+    AllocationTracker();
+
+    static inline thread_local int tCurrentTag = UNTAGGED;
+
+    std::array<QString, MAX_TAGS> mTagNames; // written once before the tag is published by mNumTags
+    std::atomic<int> mNumTags{1};
+    std::mutex mRegistrationMutex;
+
+    std::mutex mPublishMutex;
+    std::array<quint64, MAX_TAGS> mPublishedAllocations {};
+    std::array<quint64, MAX_TAGS> mPublishedBytes {};
+    std::array<int, MAX_TAGS> mAllocationsCounterIds;
+    std::array<int, MAX_TAGS> mBytesCounterIds;
+};
+
+#endif // ALLOCATIONTRACKER_H
@@ -0,0 +1,187 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "clock.h"
+#include <algorithm>
+#include <chrono>
+
+Clock *Clock::realTime()
+{
+    static RealTimeClock realTimeClock;
+    return &realTimeClock;
+}
+
+qint64 RealTimeClock::now_us() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SimulatedClock::SimulatedClock(qint64 start_us) : mNow_us(start_us)
+{
+
+}
+
+SimulatedClock::~SimulatedClock()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (ClockTimer *timer : mTimers)
+        timer->mClock = Clock::realTime();
+}
+
+qint64 SimulatedClock::now_us() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNow_us;
+}
+
+void SimulatedClock::advance(qint64 dt_us)
+{
+    advanceTo(now_us() + std::max(dt_us, qint64(0)));
+}
+
+void SimulatedClock::advanceTo(qint64 time_us)
+{
+    forever {
+        ClockTimer *timer;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            const auto next = std::min_element(mScheduledTimers.begin(), mScheduledTimers.end(), [](const ScheduledTimer &a, const ScheduledTimer &b) {
+                return a.due_us < b.due_us || (a.due_us == b.due_us && a.sequence < b.sequence);
+            });
+            if (next == mScheduledTimers.end() || next->due_us > time_us) {
+                mNow_us = std::max(mNow_us, time_us);
+                return;
+            }
+
+            mNow_us = std::max(mNow_us, next->due_us);
+            timer = next->timer;
+            if (timer->isSingleShot()) {
+                mScheduledTimers.erase(next);
+            } else {
+                next->due_us += next->interval_us;
+                next->sequence = mNextSequence++;
+            }
+        }
+
+        // Outside the lock, the timeout may start, stop or delete timers
+        emit timer->timeout();
+    }
+}
+
+void SimulatedClock::startTimer(ClockTimer *timer, qint64 interval_us)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (int i = 0; i < mScheduledTimers.size(); i++) {
+        if (mScheduledTimers.at(i).timer == timer) {
+            mScheduledTimers.removeAt(i);
+            break;
+        }
+    }
+
+    // A periodic 0 ms QTimer fires on every event loop iteration, here once per ms
+    if (!timer->isSingleShot())
+        interval_us = std::max(interval_us, qint64(1000));
+    mScheduledTimers.append({timer, mNow_us + std::max(interval_us, qint64(0)), interval_us, mNextSequence++});
+    if (!mTimers.contains(timer))
+        mTimers.append(timer);
+}
+
+void SimulatedClock::stopTimer(ClockTimer *timer)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (int i = 0; i < mScheduledTimers.size(); i++) {
+        if (mScheduledTimers.at(i).timer == timer) {
+            mScheduledTimers.removeAt(i);
+            break;
+        }
+    }
+}
+
+bool SimulatedClock::isTimerActive(const ClockTimer *timer) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto &scheduledTimer : mScheduledTimers)
+        if (scheduledTimer.timer == timer)
+            return true;
+    return false;
+}
+
+void SimulatedClock::removeTimer(ClockTimer *timer)
+{
+    stopTimer(timer);
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTimers.removeAll(timer);
+}
+
+ClockTimer::ClockTimer(QObject *parent) : QObject(parent), mTimer(this) // child: moves with moveToThread
+{
+    mClock = Clock::realTime();
+    connect(&mTimer, &QTimer::timeout, this, &ClockTimer::timeout);
+}
+
+ClockTimer::~ClockTimer()
+{
+    if (SimulatedClock *clock = simulatedClock())
+        clock->removeTimer(this);
+}
+
+void ClockTimer::setClock(Clock *clock)
+{
+    if (!clock)
+        clock = Clock::realTime();
+    if (clock == mClock)
+        return;
+
+    const bool active = isActive();
+    stop();
+    if (SimulatedClock *oldClock = simulatedClock())
+        oldClock->removeTimer(this);
+
+    mClock = clock;
+    if (active)
+        start();
+}
+
+void ClockTimer::setInterval(int msec)
+{
+    mInterval_ms = msec;
+    // Like QTimer, an active timer is restarted with the new interval
+    if (isActive())
+        start();
+}
+
+void ClockTimer::setSingleShot(bool singleShot)
+{
+    mSingleShot = singleShot;
+    mTimer.setSingleShot(singleShot);
+}
+
+bool ClockTimer::isActive() const
+{
+    if (SimulatedClock *clock = simulatedClock())
+        return clock->isTimerActive(this);
+    return mTimer.isActive();
+}
+
+void ClockTimer::start()
+{
+    if (SimulatedClock *clock = simulatedClock())
+        clock->startTimer(this, qint64(mInterval_ms) * 1000);
+    else
+        mTimer.start(mInterval_ms);
+}
+
+void ClockTimer::start(int msec)
+{
+    mInterval_ms = msec;
+    start();
+}
+
+void ClockTimer::stop()
+{
+    if (SimulatedClock *clock = simulatedClock())
+        clock->stopTimer(this);
+    else
+        mTimer.stop();
+}
@@ -0,0 +1,108 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Time source and timers for autopilots, controllers and watchdogs, so that they can run on simulated time.
+ * The real-time clock (default) is steady_clock with QTimers on Qt's event loop, i.e., the behaviour without a clock.
+ * A SimulatedClock only moves when advanced: advance() fires all timers that become due on the way, in time order and on the calling thread,
+ * without sleeping or an event loop. Timeouts are emitted synchronously, i.e., connections to objects living in other threads are still queued.
+ * ClockTimer is a drop-in replacement for the subset of QTimer used in WayWise and runs on either clock.
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QList>
+#include <mutex>
+
+class Clock
+{
+public:
+    virtual ~Clock() {}
+    virtual qint64 now_us() const = 0; // monotonic, arbitrary epoch
+    virtual bool isRealTime() const = 0;
+
+    static Clock *realTime(); // process-wide real-time clock
+};
+
+class RealTimeClock : public Clock
+{
+public:
+    qint64 now_us() const override;
+    bool isRealTime() const override { return true; }
+};
+
+class ClockTimer;
+
+class SimulatedClock : public Clock
+{
+public:
+    SimulatedClock(qint64 start_us = 0);
+    ~SimulatedClock(); // timers still using this clock are stopped and fall back to the real-time clock
+
+    qint64 now_us() const override;
+    bool isRealTime() const override { return false; }
+
+    // Timers due at the same time fire in the order they were started, timers started or stopped by a timeout are taken into account
+    void advance(qint64 dt_us);
+    void advanceTo(qint64 time_us);
+
+private:
+    friend class ClockTimer;
+    void startTimer(ClockTimer *timer, qint64 interval_us);
+    void stopTimer(ClockTimer *timer);
+    bool isTimerActive(const ClockTimer *timer) const;
+    void removeTimer(ClockTimer *timer);
+
+    struct ScheduledTimer {
+        ClockTimer *timer;
+        qint64 due_us;
+        qint64 interval_us;
+        quint64 sequence; // start order for timers with the same due time
+    };
+
+    mutable std::mutex mMutex;
+    qint64 mNow_us;
+    quint64 mNextSequence = 0;
+    QList<ScheduledTimer> mScheduledTimers;
+    QList<ClockTimer*> mTimers; // all timers using this clock
+};
+
+class ClockTimer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ClockTimer(QObject *parent = nullptr);
+    ~ClockTimer();
+
+    Clock *getClock() const { return mClock; }
+    void setClock(Clock *clock); // nullptr: real-time clock, an active timer is restarted on the new clock
+
+    int interval() const { return mInterval_ms; }
+    void setInterval(int msec);
+    bool isSingleShot() const { return mSingleShot; }
+    void setSingleShot(bool singleShot);
+    void setTimerType(Qt::TimerType timerType) { mTimer.setTimerType(timerType); }
+    bool isActive() const;
+
+public slots:
+    void start();
+    void start(int msec);
+    void stop();
+
+signals:
+    void timeout();
+
+private:
+    friend class SimulatedClock;
+    SimulatedClock *simulatedClock() const { return mClock->isRealTime() ? nullptr : static_cast<SimulatedClock*>(mClock); }
+
+    Clock *mClock;
+    QTimer mTimer; // real-time clock only
+    int mInterval_ms = 0;
+    bool mSingleShot = false;
+};
+
+#endif // CLOCK_H
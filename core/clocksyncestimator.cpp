@@ -0,0 +1,90 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "clocksyncestimator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool ClockSyncEstimator::addSample(qint64 localSend_ns, qint64 remote_ns, qint64 localReceive_ns)
+{
+    const qint64 roundTrip_ns = localReceive_ns - localSend_ns;
+    if (roundTrip_ns < 0 || roundTrip_ns > MAX_ROUND_TRIP_NS)
+        return false;
+
+    const Sample sample = {remote_ns, localSend_ns + roundTrip_ns / 2 - remote_ns, roundTrip_ns};
+    if (isSynchronized() && std::abs(toLocal_ns(remote_ns) - (remote_ns + sample.offset_ns)) > RESYNC_THRESHOLD_NS + roundTrip_ns / 2)
+        reset();
+
+    if (mSamples.size() == WINDOW_SIZE)
+        mSamples.removeFirst();
+    mSamples.append(sample);
+    update();
+    return true;
+}
+
+void ClockSyncEstimator::reset()
+{
+    mSamples.clear();
+    mReferenceRemote_ns = 0;
+    mReferenceOffset_ns = 0;
+    mOffsetCorrection_ns = 0.0;
+    mSkew = 0.0;
+    mMinRoundTrip_ns = 0;
+}
+
+qint64 ClockSyncEstimator::toLocal_ns(qint64 remote_ns) const
+{
+    if (!isSynchronized())
+        return utcTime::INVALID;
+    return remote_ns + mReferenceOffset_ns + qint64(llround(mOffsetCorrection_ns + mSkew * (remote_ns - mReferenceRemote_ns)));
+}
+
+qint64 ClockSyncEstimator::toRemote_ns(qint64 local_ns) const
+{
+    if (!isSynchronized())
+        return utcTime::INVALID;
+    // local = remote + offset + skew * (remote - reference), solved for remote
+    return mReferenceRemote_ns + qint64(llround((local_ns - mReferenceRemote_ns - mReferenceOffset_ns - mOffsetCorrection_ns) / (1.0 + mSkew)));
+}
+
+void ClockSyncEstimator::update()
+{
+    mMinRoundTrip_ns = std::numeric_limits<qint64>::max();
+    for (const Sample &sample : mSamples)
+        mMinRoundTrip_ns = std::min(mMinRoundTrip_ns, sample.roundTrip_ns);
+    const qint64 maxRoundTrip_ns = 2 * mMinRoundTrip_ns + ROUND_TRIP_MARGIN_NS;
+
+    // Relative to the latest used round trip, i.e., small numbers in doubles
+    const Sample *reference = nullptr;
+    for (const Sample &sample : mSamples)
+        if (sample.roundTrip_ns <= maxRoundTrip_ns)
+            reference = &sample;
+    mReferenceRemote_ns = reference->remote_ns;
+    mReferenceOffset_ns = reference->offset_ns;
+
+    int samples = 0;
+    double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+    double minX = 0.0;
+    for (const Sample &sample : mSamples) {
+        if (sample.roundTrip_ns > maxRoundTrip_ns)
+            continue;
+        const double x = (sample.remote_ns - reference->remote_ns) * 1e-9; // [s]
+        const double y = double(sample.offset_ns - reference->offset_ns); // [ns]
+        samples++;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+        minX = std::min(minX, x);
+    }
+
+    const double meanX = sumX / samples;
+    const double meanY = sumY / samples;
+    const double varianceX = sumXX / samples - meanX * meanX;
+    mSkew = 0.0;
+    if (samples >= MIN_SAMPLES && -minX >= MIN_SKEW_SPAN_S && varianceX > 0.0)
+        mSkew = std::clamp((sumXY / samples - meanX * meanY) / varianceX * 1e-9, -MAX_SKEW, MAX_SKEW); // [ns/s] to [ns/ns]
+    mOffsetCorrection_ns = meanY - mSkew * meanX * 1e9;
+}
@@ -0,0 +1,63 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Offset and skew of a remote clock (e.g., a vehicle's time since boot) relative to the local one, estimated from round trips
+ * (e.g., MAVLink TIMESYNC): the remote time of a round trip is assumed to be taken halfway between sending and receiving.
+ * Direct observations (e.g., a GNSS time pulse timestamped locally) are round trips of zero length.
+ * Of the last WINDOW_SIZE round trips only the fast ones (close to the fastest) are used, asymmetric delays of slow ones would bias
+ * the offset. Skew is fitted once the used round trips span MIN_SKEW_SPAN_S, before that the clocks are assumed to run at the same rate.
+ * A round trip that contradicts the estimate by more than RESYNC_THRESHOLD_NS (e.g., the remote restarted) starts over.
+ * Not thread-safe.
+ */
+
+#ifndef CLOCKSYNCESTIMATOR_H
+#define CLOCKSYNCESTIMATOR_H
+
+#include <QtGlobal>
+#include <QVector>
+#include "core/utctime.h"
+
+class ClockSyncEstimator
+{
+public:
+    static constexpr int WINDOW_SIZE = 64;
+    static constexpr int MIN_SAMPLES = 3; // until synchronized
+    static constexpr qint64 MAX_ROUND_TRIP_NS = 2000 * utcTime::NS_PER_MS; // slower round trips are dropped
+    static constexpr qint64 ROUND_TRIP_MARGIN_NS = 2 * utcTime::NS_PER_MS; // used: up to twice the fastest plus margin
+    static constexpr double MIN_SKEW_SPAN_S = 20.0;
+    static constexpr double MAX_SKEW = 1e-3; // 1000 ppm
+    static constexpr qint64 RESYNC_THRESHOLD_NS = 1000 * utcTime::NS_PER_MS;
+
+    // Times of the same round trip, returns false if it is dropped
+    bool addSample(qint64 localSend_ns, qint64 remote_ns, qint64 localReceive_ns);
+    bool addObservation(qint64 local_ns, qint64 remote_ns) { return addSample(local_ns, remote_ns, local_ns); }
+    void reset();
+
+    bool isSynchronized() const { return mSamples.size() >= MIN_SAMPLES; }
+    int getNumSamples() const { return mSamples.size(); }
+    qint64 toLocal_ns(qint64 remote_ns) const; // utcTime::INVALID if not synchronized
+    qint64 toRemote_ns(qint64 local_ns) const;
+    double getOffset_ns() const { return mReferenceOffset_ns + mOffsetCorrection_ns; } // local - remote at the reference (latest used round trip)
+    double getSkew_ppm() const { return mSkew * 1e6; } // local clock runs faster by this
+    qint64 getMinRoundTrip_ns() const { return mMinRoundTrip_ns; } // in the window
+    qint64 getLastRoundTrip_ns() const { return mSamples.isEmpty() ? 0 : mSamples.last().roundTrip_ns; }
+
+private:
+    struct Sample {
+        qint64 remote_ns;
+        qint64 offset_ns; // local midpoint - remote
+        qint64 roundTrip_ns;
+    };
+
+    void update();
+
+    QVector<Sample> mSamples; // oldest first
+    qint64 mReferenceRemote_ns = 0;
+    qint64 mReferenceOffset_ns = 0; // of the reference, the fit adds a correction (offsets can be large, e.g., UTC vs. time since boot)
+    double mOffsetCorrection_ns = 0.0;
+    double mSkew = 0.0;
+    qint64 mMinRoundTrip_ns = 0;
+};
+
+#endif // CLOCKSYNCESTIMATOR_H
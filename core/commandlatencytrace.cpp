@@ -0,0 +1,98 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "commandlatencytrace.h"
+#include "perfcounters.h"
+#include <chrono>
+
+double CommandLatencyTraceResult::getStageLatency_ms(int stage) const
+{
+    if (stage <= 0 || stage >= NUM_STAGES || stage_ns[stage] < 0 || stage_ns[stage - 1] < 0)
+        return -1.0;
+    return (stage_ns[stage] - stage_ns[stage - 1]) / 1e6;
+}
+
+double CommandLatencyTraceResult::getEndToEnd_ms() const
+{
+    if (stage_ns[0] < 0 || stage_ns[NUM_STAGES - 1] < 0)
+        return -1.0;
+    return (stage_ns[NUM_STAGES - 1] - stage_ns[0]) / 1e6;
+}
+
+CommandLatencyTrace::CommandLatencyTrace()
+{
+    PerfCounters &perfCounters = PerfCounters::getInstance();
+    mLatencyIds = {perfCounters.registerCounter("CMD_E2E", PerfCounters::Type::Latency),
+                   perfCounters.registerCounter("CMD_LINK", PerfCounters::Type::Latency),
+                   perfCounters.registerCounter("CMD_CTRL", PerfCounters::Type::Latency),
+                   perfCounters.registerCounter("CMD_ACT", PerfCounters::Type::Latency)};
+    mDroppedId = perfCounters.registerCounter("CMD_DROP", PerfCounters::Type::Counter);
+}
+
+CommandLatencyTrace &CommandLatencyTrace::getInstance()
+{
+    static CommandLatencyTrace instance;
+    return instance;
+}
+
+qint64 CommandLatencyTrace::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CommandLatencyTrace::setCompletedCallback(std::function<void(const CommandLatencyTraceResult &)> completed)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCompleted = completed;
+}
+
+void CommandLatencyTrace::begin(quint16 tag, quint8 command, qint64 issued_ns)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mOpen.load(std::memory_order_relaxed))
+        finish(false);
+
+    mTrace = CommandLatencyTraceResult();
+    mTrace.tag = tag;
+    mTrace.command = command;
+    mTrace.stage_ns[int(Stage::Issued)] = issued_ns;
+    mBegin_ns = now_ns();
+    mOpen.store(true, std::memory_order_relaxed);
+}
+
+void CommandLatencyTrace::markOpen(Stage stage)
+{
+    const qint64 now = now_ns();
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mOpen.load(std::memory_order_relaxed))
+        return;
+
+    if (now - mBegin_ns > TRACE_TIMEOUT_NS) {
+        finish(false);
+        return;
+    }
+
+    const int index = int(stage);
+    if (index <= int(Stage::Issued) || mTrace.stage_ns[index] >= 0 || (index > int(Stage::Received) && mTrace.stage_ns[index - 1] < 0))
+        return;
+
+    mTrace.stage_ns[index] = now;
+    if (mTrace.stage_ns[index - 1] >= 0)
+        PerfCounters::getInstance().recordLatency_ns(mLatencyIds[index], now - mTrace.stage_ns[index - 1]);
+    if (stage == Stage::Actuator)
+        finish(true);
+}
+
+void CommandLatencyTrace::finish(bool complete)
+{
+    if (complete) {
+        if (mTrace.stage_ns[int(Stage::Issued)] >= 0)
+            PerfCounters::getInstance().recordLatency_ns(mLatencyIds[0], mTrace.stage_ns[int(Stage::Actuator)] - mTrace.stage_ns[int(Stage::Issued)]);
+    } else
+        PerfCounters::getInstance().add(mDroppedId);
+
+    mOpen.store(false, std::memory_order_relaxed);
+    if (mCompleted)
+        mCompleted(mTrace);
+}
@@ -0,0 +1,75 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Process-wide trace of tagged commands through the stages of a vehicle: issued (control station), received (MavsdkVehicleServer),
+ * controller (first MovementController::setDesiredSpeed/setDesiredSteering after it) and actuator (first output to the motor/servo
+ * controllers, the simulation or a CANopen TPDO after that). One trace is open at a time, i.e., tagged commands are meant to be
+ * spaced further apart than their latency (see CommandLatencyHarness). Timestamps are the steady clock, i.e., the vehicle's time
+ * since boot that TIMESYNC synchronizes the station to, the station converts the issue time.
+ * Stage latencies are recorded as perf counters (CMD_LINK, CMD_CTRL, CMD_ACT, CMD_E2E; incomplete traces: CMD_DROP) and completed
+ * traces are passed to a callback, e.g., sent back to the station. mark() is one relaxed atomic load without an open trace.
+ */
+
+#ifndef COMMANDLATENCYTRACE_H
+#define COMMANDLATENCYTRACE_H
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+struct CommandLatencyTraceResult {
+    static constexpr int NUM_STAGES = 4;
+    quint16 tag = 0;
+    quint8 command = 0; // as tagged by the issuer, e.g., CommandLatencyHarness's command type
+    std::array<qint64, NUM_STAGES> stage_ns {{-1, -1, -1, -1}}; // steady clock, -1: not reached (or issue time unknown)
+
+    // From the previous stage, -1 if one of them is missing
+    double getStageLatency_ms(int stage) const;
+    double getEndToEnd_ms() const; // issued to actuator
+    bool isComplete() const { return stage_ns[NUM_STAGES - 1] >= 0; }
+};
+
+class CommandLatencyTrace
+{
+public:
+    enum class Stage : int {Issued, Received, Controller, Actuator};
+    static constexpr qint64 TRACE_TIMEOUT_NS = 2000000000LL; // since begin(), later stages are not attributed to the trace
+
+    // DEBUG_FLOAT_ARRAY between station and vehicle: tag (station, time_usec: issue time, data: tag, command) and
+    // completed traces (vehicle, data: tag, command, stage latencies [us], -1: missing)
+    static constexpr uint16_t MAVLINK_ARRAY_ID = 0x4354;
+    static constexpr const char *MAVLINK_TAG_NAME = "CMD_TAG";
+    static constexpr const char *MAVLINK_TRACE_NAME = "CMD_TRACE";
+
+    static CommandLatencyTrace &getInstance();
+    static qint64 now_ns(); // steady clock
+
+    // Opens a trace, an incomplete previous one is dropped. issued_ns: steady clock of this process, -1: unknown.
+    void begin(quint16 tag, quint8 command, qint64 issued_ns);
+    // The stage was reached now, attributed to the open trace if it reached the previous stage and not this one yet
+    void mark(Stage stage) {
+        if (mOpen.load(std::memory_order_relaxed))
+            markOpen(stage);
+    }
+    // Called with finished traces (complete or dropped), from the thread that marked the last stage or began the next trace.
+    // It must not call back into the trace.
+    void setCompletedCallback(std::function<void(const CommandLatencyTraceResult &)> completed);
+
+private:
+    CommandLatencyTrace();
+    void markOpen(Stage stage);
+    void finish(bool complete); // expects mMutex
+
+    std::atomic<bool> mOpen{false};
+    std::mutex mMutex;
+    CommandLatencyTraceResult mTrace;
+    qint64 mBegin_ns = 0;
+    std::function<void(const CommandLatencyTraceResult &)> mCompleted;
+    std::array<int, CommandLatencyTraceResult::NUM_STAGES> mLatencyIds; // 0: end to end, i: from stage i - 1 to i
+    int mDroppedId = -1;
+};
+
+#endif // COMMANDLATENCYTRACE_H
@@ -0,0 +1,298 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "controlloop.h"
+#include "communication/parameterserver.h"
+#include "core/threadconfig.h"
+#include "core/tickarena.h"
+#include <QDebug>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#ifdef Q_OS_LINUX
+#include <time.h>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+int ControlLoopStatistics::getHistogramBucket(double value_us)
+{
+    return std::upper_bound(histogramBucketLimits_us.begin(), histogramBucketLimits_us.end(), value_us) - histogramBucketLimits_us.begin();
+}
+
+ControlLoop::ControlLoop(std::function<void()> iteration, unsigned period_ms, QObject *parent) : QObject(parent)
+{
+    mIteration = iteration;
+    mPeriod_us = std::max(period_ms, 1u) * 1000;
+    mTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mTimer, &ClockTimer::timeout, this, &ControlLoop::runIteration);
+}
+
+ControlLoop::~ControlLoop()
+{
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mThreadMutex);
+        mQuitThread = true;
+    }
+    mThreadCondition.notify_all();
+    if (mThread.joinable())
+        mThread.join();
+}
+
+void ControlLoop::start()
+{
+    std::lock_guard<std::recursive_mutex> iterationLock(mIterationMutex);
+    {
+        std::lock_guard<std::mutex> statisticsLock(mStatisticsMutex);
+        mHasLastIterationStart = false;
+    }
+
+    if (usesTimer()) {
+        mActive = true;
+        startEventLoopTimer();
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(mThreadMutex);
+            mActive = true;
+            if (!mThread.joinable())
+                mThread = std::thread(&ControlLoop::runThread, this);
+        }
+        mThreadCondition.notify_all();
+    }
+}
+
+void ControlLoop::stop()
+{
+    // Holding the iteration mutex guarantees that no iteration runs after stop() returned (except when called from within an iteration)
+    std::lock_guard<std::recursive_mutex> iterationLock(mIterationMutex);
+    {
+        std::lock_guard<std::mutex> lock(mThreadMutex);
+        mActive = false;
+    }
+    if (mHeartbeat)
+        mHeartbeat(false);
+
+    if (mTimer.isActive()) {
+        if (thread() == QThread::currentThread())
+            mTimer.stop();
+        else
+            QMetaObject::invokeMethod(&mTimer, "stop", Qt::QueuedConnection);
+    }
+}
+
+void ControlLoop::setHeartbeat(std::function<void(bool)> heartbeat)
+{
+    std::lock_guard<std::recursive_mutex> iterationLock(mIterationMutex);
+    mHeartbeat = heartbeat;
+}
+
+void ControlLoop::step()
+{
+    std::lock_guard<std::recursive_mutex> iterationLock(mIterationMutex);
+    TickArena::Scope arenaScope;
+    mIteration();
+}
+
+void ControlLoop::setClock(Clock *clock)
+{
+    if (!clock)
+        clock = Clock::realTime();
+
+    std::lock_guard<std::recursive_mutex> iterationLock(mIterationMutex);
+    if (clock == mClock)
+        return;
+
+    const bool wasActive = isActive();
+    stop();
+    mClock = clock;
+    mTimer.setClock(clock);
+    if (wasActive)
+        start();
+}
+
+void ControlLoop::setMode(ControlLoop::Mode mode)
+{
+    if (mode == mMode)
+        return;
+
+    const bool wasActive = isActive();
+    stop();
+    mMode = mode;
+    if (wasActive)
+        start();
+}
+
+void ControlLoop::setPeriod_us(unsigned period_us)
+{
+    if (period_us == 0) {
+        qDebug() << "WARNING: ControlLoop period must be greater than 0.";
+        return;
+    }
+
+    mPeriod_us = period_us;
+    if (usesTimer() && mActive)
+        startEventLoopTimer();
+}
+
+void ControlLoop::setFrequency(double frequency_Hz)
+{
+    if (frequency_Hz <= 0.0) {
+        qDebug() << "WARNING: ControlLoop frequency must be greater than 0.";
+        return;
+    }
+
+    setPeriod_us(std::lround(1e6 / frequency_Hz));
+}
+
+ControlLoopStatistics ControlLoop::getStatistics()
+{
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    return mStatistics;
+}
+
+void ControlLoop::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    mStatistics = ControlLoopStatistics();
+    mHasLastIterationStart = false;
+}
+
+void ControlLoop::provideParametersToParameterServer(const std::string &prefix)
+{
+    ParameterServer *parameterServer = ParameterServer::getInstance();
+    if (!parameterServer)
+        return;
+
+    parameterServer->provideFloatParameter(prefix + "_RATE_HZ", std::bind(&ControlLoop::setFrequency, this, std::placeholders::_1), std::bind(&ControlLoop::getFrequency, this));
+    parameterServer->provideIntParameter(prefix + "_THREAD",
+                                         [this](int value) { setMode(value ? Mode::DEDICATED_THREAD : Mode::EVENT_LOOP); },
+                                         [this]() { return (int)(getMode() == Mode::DEDICATED_THREAD); });
+
+    const auto reset = [this](float) { resetStatistics(); };
+    parameterServer->provideFloatParameter(prefix + "_JIT_MAX", reset, [this]() { return (float)getStatistics().maxJitter_us; });
+    parameterServer->provideFloatParameter(prefix + "_JIT_AVG", reset, [this]() { return (float)getStatistics().meanJitter_us; });
+    parameterServer->provideFloatParameter(prefix + "_LAT_MAX", reset, [this]() { return (float)getStatistics().maxLatency_us; });
+    parameterServer->provideFloatParameter(prefix + "_LAT_AVG", reset, [this]() { return (float)getStatistics().meanLatency_us; });
+    for (int bucket = 0; bucket < ControlLoopStatistics::numHistogramBuckets; bucket++) {
+        parameterServer->provideIntParameter(prefix + "_JH" + std::to_string(bucket), [this](int) { resetStatistics(); },
+                                             [this, bucket]() { return (int)std::min(getStatistics().jitterHistogram[bucket], (quint64)INT32_MAX); });
+        parameterServer->provideIntParameter(prefix + "_LH" + std::to_string(bucket), [this](int) { resetStatistics(); },
+                                             [this, bucket]() { return (int)std::min(getStatistics().latencyHistogram[bucket], (quint64)INT32_MAX); });
+    }
+}
+
+void ControlLoop::startEventLoopTimer()
+{
+    // Timers can only be started from the thread they live in, e.g., not from a ParameterServer callback thread
+    const int interval_ms = std::max((int)std::lround(mPeriod_us / 1000.0), 1);
+    if (thread() == QThread::currentThread())
+        mTimer.start(interval_ms);
+    else
+        QMetaObject::invokeMethod(&mTimer, [this, interval_ms]() { mTimer.start(interval_ms); }, Qt::QueuedConnection);
+}
+
+void ControlLoop::runIteration()
+{
+    std::lock_guard<std::recursive_mutex> iterationLock(mIterationMutex);
+    if (!mActive)
+        return;
+
+    const qint64 iterationStart_us = mClock.load()->now_us();
+    const auto iterationStart = std::chrono::steady_clock::now();
+    {
+        TickArena::Scope arenaScope; // scratch memory of the iteration, reset when it ends
+        mIteration();
+    }
+    const auto iterationEnd = std::chrono::steady_clock::now();
+    if (mHeartbeat)
+        mHeartbeat(true);
+
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    ControlLoopStatistics &statistics = mStatistics;
+    statistics.iterations++;
+
+    const double latency_us = std::chrono::duration<double, std::micro>(iterationEnd - iterationStart).count();
+    statistics.maxLatency_us = std::max(statistics.maxLatency_us, latency_us);
+    statistics.meanLatency_us += (latency_us - statistics.meanLatency_us) / statistics.iterations;
+    statistics.latencyHistogram[ControlLoopStatistics::getHistogramBucket(latency_us)]++;
+
+    if (mHasLastIterationStart) {
+        const double jitter_us = fabs(double(iterationStart_us - mLastIterationStart_us) - mPeriod_us);
+        statistics.jitterSamples++;
+        statistics.maxJitter_us = std::max(statistics.maxJitter_us, jitter_us);
+        statistics.meanJitter_us += (jitter_us - statistics.meanJitter_us) / statistics.jitterSamples;
+        statistics.jitterHistogram[ControlLoopStatistics::getHistogramBucket(jitter_us)]++;
+    }
+    mLastIterationStart_us = iterationStart_us;
+    mHasLastIterationStart = true;
+}
+
+void ControlLoop::runThread()
+{
+    ThreadConfig::getInstance().applyToCurrentThread(ThreadConfig::Role::Control); // setRealTimePriority overrides its priority
+
+    std::unique_lock<std::mutex> lock(mThreadMutex);
+    while (!mQuitThread) {
+        mThreadCondition.wait(lock, [this]() { return mQuitThread || (mActive && !usesTimer()); });
+        if (mQuitThread)
+            break;
+        lock.unlock();
+        applyRealTimePriority();
+
+        // Absolute wakeup times, i.e., the execution time of the iteration does not add up to the period
+        auto wakeupTime = std::chrono::steady_clock::now();
+        while (mActive && !usesTimer()) {
+            const std::chrono::microseconds period(mPeriod_us);
+            wakeupTime += period;
+            sleepUntil(wakeupTime);
+
+            // Do not try to catch up on overruns
+            const auto now = std::chrono::steady_clock::now();
+            if (now - wakeupTime > period)
+                wakeupTime = now;
+
+            runIteration();
+        }
+
+        lock.lock();
+    }
+}
+
+void ControlLoop::applyRealTimePriority()
+{
+    const int priority = mRealTimePriority;
+    if (priority == mAppliedRealTimePriority)
+        return;
+
+#ifdef Q_OS_LINUX
+    sched_param parameters;
+    parameters.sched_priority = priority;
+    const int result = pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &parameters);
+    if (result != 0) {
+        qDebug() << "WARNING: ControlLoop could not set real-time priority" << priority << ":" << strerror(result);
+        return;
+    }
+#else
+    qDebug() << "WARNING: ControlLoop real-time priority is only supported on Linux.";
+#endif
+    mAppliedRealTimePriority = priority;
+}
+
+void ControlLoop::sleepUntil(std::chrono::steady_clock::time_point wakeupTime)
+{
+#ifdef Q_OS_LINUX
+    // steady_clock is CLOCK_MONOTONIC on Linux
+    const auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(wakeupTime.time_since_epoch()).count();
+    timespec wakeup;
+    wakeup.tv_sec = sinceEpoch / 1000000000;
+    wakeup.tv_nsec = sinceEpoch % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, nullptr) == EINTR);
+#else
+    std::this_thread::sleep_until(wakeupTime);
+#endif
+}
@@ -0,0 +1,121 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Periodic execution of a control iteration, either on Qt's event loop (precise QTimer) or on a dedicated
+ * thread (absolute-time sleep), including jitter and latency statistics of the iterations.
+ * In DEDICATED_THREAD mode the iteration runs on the control thread, i.e., everything it calls needs to be thread-safe.
+ * On a simulated clock (see Clock) the loop always runs as timer, i.e., iterations run when the clock is advanced past them, independent of the mode.
+ * The iteration mutex is held while an iteration runs, owners lock it to modify state shared with the iteration.
+ * Each iteration runs in a TickArena::Scope of its thread, i.e., ArenaVectors of the iteration do not use the general heap.
+ */
+
+#ifndef CONTROLLOOP_H
+#define CONTROLLOOP_H
+
+#include <QObject>
+#include "core/clock.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct ControlLoopStatistics {
+    // Upper limits of the histogram buckets [us], last bucket collects everything above
+    static constexpr std::array<double, 7> histogramBucketLimits_us = {50, 100, 250, 500, 1000, 2000, 5000};
+    static constexpr int numHistogramBuckets = histogramBucketLimits_us.size() + 1;
+
+    quint64 iterations = 0;
+    // Jitter: deviation of the time between two iteration starts from the period
+    quint64 jitterSamples = 0;
+    double maxJitter_us = 0.0;
+    double meanJitter_us = 0.0;
+    std::array<quint64, numHistogramBuckets> jitterHistogram = {};
+    // Latency: time taken by the iteration itself
+    double maxLatency_us = 0.0;
+    double meanLatency_us = 0.0;
+    std::array<quint64, numHistogramBuckets> latencyHistogram = {};
+
+    static int getHistogramBucket(double value_us);
+};
+
+class ControlLoop : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Mode {EVENT_LOOP, DEDICATED_THREAD};
+
+    ControlLoop(std::function<void()> iteration, unsigned period_ms, QObject *parent = nullptr);
+    ~ControlLoop();
+
+    void start();
+    void stop();
+    bool isActive() const { return mActive; }
+    void step(); // run a single iteration synchronously, independent of the loop (e.g., for stepping through a simulation or benchmarking)
+
+    Mode getMode() const { return mMode; }
+    void setMode(Mode mode); // restarts the loop if active
+
+    unsigned getPeriod_us() const { return mPeriod_us; }
+    void setPeriod_us(unsigned period_us);
+    double getFrequency() const { return 1e6 / mPeriod_us; }
+    void setFrequency(double frequency_Hz);
+
+    // DEDICATED_THREAD: SCHED_FIFO priority of the control thread (Linux, needs CAP_SYS_NICE or an rtprio limit), 0: normal scheduling.
+    // Applied when the loop (re)starts.
+    int getRealTimePriority() const { return mRealTimePriority; }
+    void setRealTimePriority(int priority) { mRealTimePriority = std::max(priority, 0); }
+
+    Clock *getClock() const { return mClock; }
+    void setClock(Clock *clock); // nullptr: real-time clock, restarts the loop if active. The clock needs to outlive the loop.
+
+    std::recursive_mutex &getIterationMutex() { return mIterationMutex; }
+
+    // Called after every iteration (true) and when the loop is stopped (false), e.g., SafetyWatchdog::getHeartbeat
+    void setHeartbeat(std::function<void(bool running)> heartbeat);
+
+    ControlLoopStatistics getStatistics();
+    void resetStatistics();
+
+    // Provides <prefix>_RATE_HZ, <prefix>_THREAD and the statistics (read-only, writing any of them resets the statistics)
+    void provideParametersToParameterServer(const std::string &prefix);
+
+private:
+    bool usesTimer() const { return mMode == Mode::EVENT_LOOP || !mClock.load()->isRealTime(); }
+    void startEventLoopTimer();
+    void runIteration();
+    void runThread();
+    void sleepUntil(std::chrono::steady_clock::time_point wakeupTime);
+    void applyRealTimePriority();
+
+    std::function<void()> mIteration;
+    std::function<void(bool)> mHeartbeat; // iteration mutex
+    std::recursive_mutex mIterationMutex;
+    std::atomic<bool> mActive{false};
+    std::atomic<unsigned> mPeriod_us;
+    std::atomic<Mode> mMode{Mode::EVENT_LOOP};
+    std::atomic<Clock*> mClock{Clock::realTime()};
+
+    // EVENT_LOOP or simulated clock
+    ClockTimer mTimer;
+
+    // DEDICATED_THREAD, the thread is created on first start and waits while the loop is stopped
+    std::thread mThread;
+    std::mutex mThreadMutex;
+    std::condition_variable mThreadCondition;
+    bool mQuitThread = false;
+    std::atomic<int> mRealTimePriority{0};
+    int mAppliedRealTimePriority = 0; // control thread
+
+    std::mutex mStatisticsMutex;
+    ControlLoopStatistics mStatistics;
+    bool mHasLastIterationStart = false;
+    qint64 mLastIterationStart_us = 0; // clock time, i.e., no jitter on a simulated clock
+};
+
+#endif // CONTROLLOOP_H
@@ -9,6 +9,7 @@
 #define COORDINATETRANSFORMS_H
 
 #include <cmath>
+#include <cstddef>
 #include <QPointF>
 
 struct llh_t {
@@ -79,7 +80,8 @@ inline xyz_t llhToXyz(llh_t llh)
     return res;
 }
 
-inline llh_t xyzToLlh(const xyz_t &xyz)
+// Iterative ECEF -> llh, run time depends on input (tolerance 1E-4 m)
+inline llh_t xyzToLlhIterative(const xyz_t &xyz)
 {
     double e2 = FE_WGS84 * (2.0 - FE_WGS84);
     double r2 = xyz.x * xyz.x + xyz.y * xyz.y;
@@ -102,6 +104,58 @@ inline llh_t xyzToLlh(const xyz_t &xyz)
     return res;
 }
 
+// Closed-form ECEF -> llh with fixed cost, see Heikkinen (1982) / Zhu (1994): "Conversion of Earth-centered
+// Earth-fixed coordinates to geodetic coordinates". Sub-millimeter agreement with xyzToLlhIterative near the earth's surface.
+inline llh_t xyzToLlhClosedForm(const xyz_t &xyz)
+{
+    const double a = RE_WGS84;
+    const double b = RE_WGS84 * (1.0 - FE_WGS84);
+    const double a2 = a * a;
+    const double b2 = b * b;
+    const double e2 = FE_WGS84 * (2.0 - FE_WGS84);
+    const double ep2 = (a2 - b2) / b2;
+
+    const double r2 = xyz.x * xyz.x + xyz.y * xyz.y;
+    const double p = sqrt(r2);
+    const double z2 = xyz.z * xyz.z;
+
+    llh_t res;
+    if (r2 <= 1E-12) { // on the polar axis
+        res.latitude = (xyz.z > 0.0 ? 90.0 : -90.0);
+        res.longitude = 0.0;
+        res.height = fabs(xyz.z) - b;
+        return res;
+    }
+
+    const double F = 54.0 * b2 * z2;
+    const double G = r2 + (1.0 - e2) * z2 - e2 * (a2 - b2);
+    const double c = e2 * e2 * F * r2 / (G * G * G);
+    const double s = cbrt(1.0 + c + sqrt(c * c + 2.0 * c));
+    const double k = s + 1.0 + 1.0 / s;
+    const double P = F / (3.0 * k * k * G * G);
+    const double Q = sqrt(1.0 + 2.0 * e2 * e2 * P);
+    const double r0 = -(P * e2 * p) / (1.0 + Q) + sqrt(0.5 * a2 * (1.0 + 1.0 / Q) - P * (1.0 - e2) * z2 / (Q * (1.0 + Q)) - 0.5 * P * r2);
+    const double pMinusE2r0 = p - e2 * r0;
+    const double U = sqrt(pMinusE2r0 * pMinusE2r0 + z2);
+    const double V = sqrt(pMinusE2r0 * pMinusE2r0 + (1.0 - e2) * z2);
+    const double z0 = b2 * xyz.z / (a * V);
+
+    res.latitude = atan((xyz.z + ep2 * z0) / p) * 180.0 / M_PI;
+    res.longitude = atan2(xyz.y, xyz.x) * 180.0 / M_PI;
+    res.height = U * (1.0 - b2 / (a * V));
+    return res;
+}
+
+// Define COORDINATETRANSFORMS_ITERATIVE_XYZTOLLH to use the iterative conversion
+inline llh_t xyzToLlh(const xyz_t &xyz)
+{
+#ifdef COORDINATETRANSFORMS_ITERATIVE_XYZTOLLH
+    return xyzToLlhIterative(xyz);
+#else
+    return xyzToLlhClosedForm(xyz);
+#endif
+}
+
 inline void createEnuMatrix(double lat, double lon, double *enuMat)
 {
     double so = sin(lon * M_PI / 180.0);
@@ -169,6 +223,169 @@ inline llh_t enuToLlh(const llh_t &iLlh, const xyz_t &xyz)
     return xyzToLlh(temp_xyz);
 }
 
+// Transverse Mercator (e.g., UTM, SWEREF99 TM) grid coordinates [m] to latitude, longitude on the WGS84 ellipsoid (GRS80 differs
+// by less than a mm), Krüger's series as in the Gauss conformal projection of Lantmäteriet: sub-mm within the usual zone widths.
+inline llh_t transverseMercatorToLlh(double northing, double easting, double centralMeridian_deg, double scale,
+                                     double falseNorthing, double falseEasting)
+{
+    const double e2 = FE_WGS84 * (2.0 - FE_WGS84);
+    const double n = FE_WGS84 / (2.0 - FE_WGS84);
+    const double aRoof = RE_WGS84 / (1.0 + n) * (1.0 + n * n / 4.0 + n * n * n * n / 64.0);
+
+    const double delta1 = n / 2.0 - 2.0 * n * n / 3.0 + 37.0 * n * n * n / 96.0 - n * n * n * n / 360.0;
+    const double delta2 = n * n / 48.0 + n * n * n / 15.0 - 437.0 * n * n * n * n / 1440.0;
+    const double delta3 = 17.0 * n * n * n / 480.0 - 37.0 * n * n * n * n / 840.0;
+    const double delta4 = 4397.0 * n * n * n * n / 161280.0;
+
+    const double aStar = e2 + e2 * e2 + e2 * e2 * e2 + e2 * e2 * e2 * e2;
+    const double bStar = -(7.0 * e2 * e2 + 17.0 * e2 * e2 * e2 + 30.0 * e2 * e2 * e2 * e2) / 6.0;
+    const double cStar = (224.0 * e2 * e2 * e2 + 889.0 * e2 * e2 * e2 * e2) / 120.0;
+    const double dStar = -(4279.0 * e2 * e2 * e2 * e2) / 1260.0;
+
+    const double xi = (northing - falseNorthing) / (scale * aRoof);
+    const double eta = (easting - falseEasting) / (scale * aRoof);
+
+    const double xiPrim = xi - delta1 * sin(2.0 * xi) * cosh(2.0 * eta) - delta2 * sin(4.0 * xi) * cosh(4.0 * eta)
+            - delta3 * sin(6.0 * xi) * cosh(6.0 * eta) - delta4 * sin(8.0 * xi) * cosh(8.0 * eta);
+    const double etaPrim = eta - delta1 * cos(2.0 * xi) * sinh(2.0 * eta) - delta2 * cos(4.0 * xi) * sinh(4.0 * eta)
+            - delta3 * cos(6.0 * xi) * sinh(6.0 * eta) - delta4 * cos(8.0 * xi) * sinh(8.0 * eta);
+
+    const double phiStar = asin(sin(xiPrim) / cosh(etaPrim));
+    const double deltaLambda = atan2(sinh(etaPrim), cos(xiPrim));
+    const double sinPhiStar2 = sin(phiStar) * sin(phiStar);
+    const double phi = phiStar + sin(phiStar) * cos(phiStar) *
+            (aStar + bStar * sinPhiStar2 + cStar * sinPhiStar2 * sinPhiStar2 + dStar * sinPhiStar2 * sinPhiStar2 * sinPhiStar2);
+
+    llh_t res;
+    res.latitude = phi * 180.0 / M_PI;
+    res.longitude = centralMeridian_deg + deltaLambda * 180.0 / M_PI;
+    res.height = 0.0;
+    return res;
+}
+
+// Rigid transformation from one ENU frame to another, see EnuFrame::getTransformTo. ECEF <-> ENU is affine, i.e., the
+// conversion via ECEF collapses to a single rotation and translation that converts whole datasets exactly.
+// For frames close to each other (up to some km), planar geometry (z = 0) can use applyPlanar and drop the height change.
+class EnuTransform
+{
+public:
+    EnuTransform() {} // identity
+    EnuTransform(const double *rotation, const xyz_t &translation) : mTranslation(translation) {
+        for (int i = 0; i < 9; i++)
+            mRotation[i] = rotation[i];
+    }
+
+    xyz_t apply(const xyz_t &xyz) const {
+        return {mRotation[0] * xyz.x + mRotation[1] * xyz.y + mRotation[2] * xyz.z + mTranslation.x,
+                mRotation[3] * xyz.x + mRotation[4] * xyz.y + mRotation[5] * xyz.z + mTranslation.y,
+                mRotation[6] * xyz.x + mRotation[7] * xyz.y + mRotation[8] * xyz.z + mTranslation.z};
+    }
+
+    // In place, see EnuFrame's batch versions
+    void apply(xyz_t *xyz, size_t count) const {
+        for (size_t i = 0; i < count; i++)
+            xyz[i] = apply(xyz[i]);
+    }
+
+    // unitsPerMeter: of the points, e.g., 1000 for mm
+    QPointF applyPlanar(const QPointF &point, double unitsPerMeter = 1.0) const {
+        return QPointF(mRotation[0] * point.x() + mRotation[1] * point.y() + mTranslation.x * unitsPerMeter,
+                       mRotation[3] * point.x() + mRotation[4] * point.y() + mTranslation.y * unitsPerMeter);
+    }
+
+    void applyPlanar(QPointF *points, size_t count, double unitsPerMeter = 1.0) const {
+        for (size_t i = 0; i < count; i++)
+            points[i] = applyPlanar(points[i], unitsPerMeter);
+    }
+
+    // Heading [deg] (ENU) of a direction in the horizontal plane
+    double applyYaw_deg(double yaw_deg) const {
+        const double cosYaw = cos(yaw_deg * M_PI / 180.0);
+        const double sinYaw = sin(yaw_deg * M_PI / 180.0);
+        return atan2(mRotation[3] * cosYaw + mRotation[4] * sinYaw, mRotation[0] * cosYaw + mRotation[1] * sinYaw) * 180.0 / M_PI;
+    }
+
+    bool isIdentity() const {
+        return mRotation[0] == 1.0 && mRotation[4] == 1.0 && mRotation[8] == 1.0 && mRotation[1] == 0.0 && mRotation[2] == 0.0 &&
+                mRotation[3] == 0.0 && mRotation[5] == 0.0 && mRotation[6] == 0.0 && mRotation[7] == 0.0 &&
+                mTranslation.x == 0.0 && mTranslation.y == 0.0 && mTranslation.z == 0.0;
+    }
+
+private:
+    double mRotation[9] = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0}; // row-major
+    xyz_t mTranslation = {0.0, 0.0, 0.0};
+};
+
+// ENU frame with cached reference, i.e., llhToXyz of the reference and createEnuMatrix are only computed once.
+// Prefer this over llhToEnu/enuToLlh when converting several points against the same reference.
+class EnuFrame
+{
+public:
+    EnuFrame() : EnuFrame(llh_t{0.0, 0.0, 0.0}) {}
+    EnuFrame(const llh_t &reference) { setReference(reference); }
+
+    void setReference(const llh_t &reference) {
+        mReference = reference;
+        mReferenceXyz = llhToXyz(reference);
+        createEnuMatrix(reference.latitude, reference.longitude, mEnuMat);
+    }
+    const llh_t &getReference() const { return mReference; }
+
+    xyz_t llhToEnu(const llh_t &llh) const {
+        return ecefToEnu(llhToXyz(llh));
+    }
+
+    llh_t enuToLlh(const xyz_t &xyz) const {
+        return xyzToLlh(enuToEcef(xyz));
+    }
+
+    xyz_t ecefToEnu(const xyz_t &xyz) const {
+        const xyz_t dXyz = xyz - mReferenceXyz;
+        return {mEnuMat[0] * dXyz.x + mEnuMat[1] * dXyz.y + mEnuMat[2] * dXyz.z,
+                mEnuMat[3] * dXyz.x + mEnuMat[4] * dXyz.y + mEnuMat[5] * dXyz.z,
+                mEnuMat[6] * dXyz.x + mEnuMat[7] * dXyz.y + mEnuMat[8] * dXyz.z};
+    }
+
+    xyz_t enuToEcef(const xyz_t &xyz) const {
+        return {mEnuMat[0] * xyz.x + mEnuMat[3] * xyz.y + mEnuMat[6] * xyz.z + mReferenceXyz.x,
+                mEnuMat[1] * xyz.x + mEnuMat[4] * xyz.y + mEnuMat[7] * xyz.z + mReferenceXyz.y,
+                mEnuMat[2] * xyz.x + mEnuMat[5] * xyz.y + mEnuMat[8] * xyz.z + mReferenceXyz.z};
+    }
+
+    // Batch versions, loops without branches for the compiler to vectorize (see xyzToLlh on the choice of conversion).
+    // In-place conversion is supported for enuToEnu (enu == enuInTarget).
+    void llhToEnu(const llh_t *llh, xyz_t *enu, size_t count) const {
+        for (size_t i = 0; i < count; i++)
+            enu[i] = ecefToEnu(llhToXyz(llh[i]));
+    }
+
+    void enuToLlh(const xyz_t *enu, llh_t *llh, size_t count) const {
+        for (size_t i = 0; i < count; i++)
+            llh[i] = xyzToLlh(enuToEcef(enu[i]));
+    }
+
+    // Points in this frame to points in target frame, rigid transformation via ECEF without going through llh
+    void enuToEnu(const EnuFrame &target, const xyz_t *enu, xyz_t *enuInTarget, size_t count) const {
+        for (size_t i = 0; i < count; i++)
+            enuInTarget[i] = target.ecefToEnu(enuToEcef(enu[i]));
+    }
+
+    // Same as enuToEnu as one rotation and translation: target * (this^T * enu + reference - target reference)
+    EnuTransform getTransformTo(const EnuFrame &target) const {
+        double rotation[9];
+        for (int row = 0; row < 3; row++)
+            for (int column = 0; column < 3; column++)
+                rotation[row * 3 + column] = target.mEnuMat[row * 3] * mEnuMat[column * 3] + target.mEnuMat[row * 3 + 1] * mEnuMat[column * 3 + 1] +
+                        target.mEnuMat[row * 3 + 2] * mEnuMat[column * 3 + 2];
+        return EnuTransform(rotation, target.ecefToEnu(mReferenceXyz));
+    }
+
+private:
+    llh_t mReference;
+    xyz_t mReferenceXyz;
+    double mEnuMat[9];
+};
+
 inline xyz_t nedToENU(const xyz_t &xyzNED) {
     return {xyzNED.y, xyzNED.x, -xyzNED.z};
 }
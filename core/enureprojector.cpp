@@ -0,0 +1,83 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "enureprojector.h"
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+int EnuReprojector::addDataset(const EnuReprojectionDataset &dataset)
+{
+    mDatasets.insert(mNextId, dataset);
+    return mNextId++;
+}
+
+void EnuReprojector::removeDataset(int id)
+{
+    mDatasets.remove(id);
+}
+
+void EnuReprojector::setThreadCount(int threadCount)
+{
+    mThreadCount = std::max(threadCount, 0);
+}
+
+void EnuReprojector::reproject(const llh_t &fromReference, const llh_t &toReference) const
+{
+    if (fromReference.latitude == toReference.latitude && fromReference.longitude == toReference.longitude &&
+            fromReference.height == toReference.height)
+        return;
+
+    reproject(coordinateTransforms::EnuFrame(fromReference).getTransformTo(coordinateTransforms::EnuFrame(toReference)));
+}
+
+void EnuReprojector::reproject(const coordinateTransforms::EnuTransform &transform) const
+{
+    if (transform.isIdentity() || mDatasets.isEmpty())
+        return;
+
+    const QVector<EnuReprojectionDataset> datasets = mDatasets.values().toVector();
+    const int threadCount = std::min(mThreadCount > 0 ? mThreadCount : QThread::idealThreadCount(), datasets.size());
+
+    // Datasets differ a lot in size, threads take the next one when done (see SimulationRunner)
+    std::atomic<int> nextDataset{0};
+    auto worker = [&]() {
+        for (int i = nextDataset++; i < datasets.size(); i = nextDataset++)
+            if (datasets.at(i).reproject)
+                datasets.at(i).reproject(transform);
+    };
+
+    if (threadCount <= 1)
+        worker();
+    else {
+        std::vector<std::unique_ptr<QThread>> threads;
+        for (int i = 0; i < threadCount; i++) {
+            threads.emplace_back(QThread::create(worker));
+            threads.back()->start();
+        }
+        for (auto &thread : threads)
+            thread->wait();
+    }
+
+    for (const EnuReprojectionDataset &dataset : datasets)
+        if (dataset.reprojected)
+            dataset.reprojected();
+}
+
+void EnuReprojector::reprojectPoint(const coordinateTransforms::EnuTransform &transform, pospoint_t &point)
+{
+    const xyz_t xyz = transform.apply(xyz_t{point.x, point.y, point.height});
+    point.x = xyz.x;
+    point.y = xyz.y;
+    point.height = xyz.z;
+    point.yaw = transform.applyYaw_deg(point.yaw);
+}
+
+void EnuReprojector::reprojectPoints(const coordinateTransforms::EnuTransform &transform, QVector<pospoint_t> &points)
+{
+    for (pospoint_t &point : points)
+        reprojectPoint(transform, point);
+}
@@ -0,0 +1,48 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Converts geometry stored in ENU coordinates (routes, traces, vehicle positions, ...) to a new ENU reference in bulk.
+ * The change of reference becomes one rotation and translation (EnuTransform) that is applied to all datasets,
+ * instead of converting each point via llh. Datasets are converted in parallel on worker threads, each by one thread.
+ */
+
+#ifndef ENUREPROJECTOR_H
+#define ENUREPROJECTOR_H
+
+#include <QMap>
+#include <QVector>
+#include <functional>
+#include "core/coordinatetransforms.h"
+#include "core/pospoint.h"
+
+struct EnuReprojectionDataset {
+    // On a worker thread, must only touch the dataset's own data
+    std::function<void(const coordinateTransforms::EnuTransform &transform)> reproject;
+    // Afterwards, in the thread calling EnuReprojector::reproject, e.g., to notify views. Optional
+    std::function<void()> reprojected;
+};
+
+class EnuReprojector
+{
+public:
+    int addDataset(const EnuReprojectionDataset &dataset); // returns an id for removeDataset
+    void removeDataset(int id);
+    int getDatasetCount() const { return mDatasets.size(); }
+    void setThreadCount(int threadCount); // 0: QThread::idealThreadCount
+
+    // Blocks until all datasets are converted. Nothing happens if the references are the same.
+    void reproject(const llh_t &fromReference, const llh_t &toReference) const;
+    void reproject(const coordinateTransforms::EnuTransform &transform) const;
+
+    // Position, height and yaw
+    static void reprojectPoint(const coordinateTransforms::EnuTransform &transform, pospoint_t &point);
+    static void reprojectPoints(const coordinateTransforms::EnuTransform &transform, QVector<pospoint_t> &points);
+
+private:
+    QMap<int, EnuReprojectionDataset> mDatasets;
+    int mNextId = 0;
+    int mThreadCount = 0;
+};
+
+#endif // ENUREPROJECTOR_H
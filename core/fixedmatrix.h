@@ -0,0 +1,146 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Small dense matrix with dimensions fixed at compile time and inline storage (no allocation),
+ * meant for filters with a handful of states (e.g., EKF). Dimension mismatches are compile errors.
+ */
+
+#ifndef FIXEDMATRIX_H
+#define FIXEDMATRIX_H
+
+#include <array>
+#include <cmath>
+#include <initializer_list>
+#include <algorithm>
+
+template<int Rows, int Cols>
+class FixedMatrix
+{
+    static_assert(Rows > 0 && Cols > 0, "FixedMatrix dimensions must be positive");
+
+public:
+    FixedMatrix() { mData.fill(0.0); }
+    FixedMatrix(std::initializer_list<double> rowMajor) {
+        mData.fill(0.0);
+        std::copy_n(rowMajor.begin(), std::min<size_t>(rowMajor.size(), mData.size()), mData.begin());
+    }
+
+    static FixedMatrix identity() {
+        static_assert(Rows == Cols, "identity() requires a square matrix");
+        FixedMatrix result;
+        for (int i = 0; i < Rows; i++)
+            result(i, i) = 1.0;
+        return result;
+    }
+
+    static FixedMatrix diagonal(std::initializer_list<double> values) {
+        static_assert(Rows == Cols, "diagonal() requires a square matrix");
+        FixedMatrix result;
+        int i = 0;
+        for (double value : values)
+            if (i < Rows) {
+                result(i, i) = value;
+                i++;
+            }
+        return result;
+    }
+
+    static constexpr int rows() { return Rows; }
+    static constexpr int cols() { return Cols; }
+
+    double &operator()(int row, int col) { return mData[row * Cols + col]; }
+    double operator()(int row, int col) const { return mData[row * Cols + col]; }
+    // Element access for vectors (one column)
+    double &operator[](int i) { static_assert(Cols == 1, "operator[] requires a column vector"); return mData[i]; }
+    double operator[](int i) const { static_assert(Cols == 1, "operator[] requires a column vector"); return mData[i]; }
+
+    FixedMatrix &operator+=(const FixedMatrix &other) {
+        for (size_t i = 0; i < mData.size(); i++)
+            mData[i] += other.mData[i];
+        return *this;
+    }
+    FixedMatrix &operator-=(const FixedMatrix &other) {
+        for (size_t i = 0; i < mData.size(); i++)
+            mData[i] -= other.mData[i];
+        return *this;
+    }
+    FixedMatrix &operator*=(double factor) {
+        for (double &value : mData)
+            value *= factor;
+        return *this;
+    }
+
+    friend FixedMatrix operator+(FixedMatrix a, const FixedMatrix &b) { return a += b; }
+    friend FixedMatrix operator-(FixedMatrix a, const FixedMatrix &b) { return a -= b; }
+    friend FixedMatrix operator*(FixedMatrix a, double factor) { return a *= factor; }
+
+    template<int OtherCols>
+    FixedMatrix<Rows, OtherCols> operator*(const FixedMatrix<Cols, OtherCols> &other) const {
+        FixedMatrix<Rows, OtherCols> result;
+        for (int i = 0; i < Rows; i++)
+            for (int k = 0; k < Cols; k++) {
+                const double value = (*this)(i, k);
+                for (int j = 0; j < OtherCols; j++)
+                    result(i, j) += value * other(k, j);
+            }
+        return result;
+    }
+
+    FixedMatrix<Cols, Rows> transposed() const {
+        FixedMatrix<Cols, Rows> result;
+        for (int i = 0; i < Rows; i++)
+            for (int j = 0; j < Cols; j++)
+                result(j, i) = (*this)(i, j);
+        return result;
+    }
+
+    // Gauss-Jordan elimination with partial pivoting, returns false if (close to) singular
+    bool inverse(FixedMatrix &result) const {
+        static_assert(Rows == Cols, "inverse() requires a square matrix");
+        FixedMatrix a = *this;
+        result = identity();
+
+        for (int col = 0; col < Cols; col++) {
+            int pivot = col;
+            for (int row = col + 1; row < Rows; row++)
+                if (std::fabs(a(row, col)) > std::fabs(a(pivot, col)))
+                    pivot = row;
+            if (std::fabs(a(pivot, col)) < 1e-12)
+                return false;
+
+            if (pivot != col)
+                for (int j = 0; j < Cols; j++) {
+                    std::swap(a(col, j), a(pivot, j));
+                    std::swap(result(col, j), result(pivot, j));
+                }
+
+            const double pivotInv = 1.0 / a(col, col);
+            for (int j = 0; j < Cols; j++) {
+                a(col, j) *= pivotInv;
+                result(col, j) *= pivotInv;
+            }
+
+            for (int row = 0; row < Rows; row++) {
+                if (row == col)
+                    continue;
+                const double factor = a(row, col);
+                if (factor == 0.0)
+                    continue;
+                for (int j = 0; j < Cols; j++) {
+                    a(row, j) -= factor * a(col, j);
+                    result(row, j) -= factor * result(col, j);
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    std::array<double, Rows * Cols> mData;
+};
+
+template<int Size>
+using FixedVector = FixedMatrix<Size, 1>;
+
+#endif // FIXEDMATRIX_H
@@ -0,0 +1,327 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "geofence.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+double cross(const QPointF &origin, const QPointF &a, const QPointF &b)
+{
+    return (a.x() - origin.x()) * (b.y() - origin.y()) - (a.y() - origin.y()) * (b.x() - origin.x());
+}
+
+// Segment from point to reference crosses edge a-b. Half-open on the line through point and reference,
+// i.e., a vertex on it counts for exactly one of its edges and the number of crossings keeps its parity.
+bool crossesForParity(const QPointF &point, const QPointF &reference, const QPointF &a, const QPointF &b)
+{
+    if ((cross(point, reference, a) > 0.0) == (cross(point, reference, b) > 0.0))
+        return false;
+    return cross(a, b, point) * cross(a, b, reference) < 0.0;
+}
+
+// Closed segments, touching counts
+bool segmentsIntersect(const QPointF &a, const QPointF &b, const QPointF &c, const QPointF &d)
+{
+    const double d1 = cross(c, d, a);
+    const double d2 = cross(c, d, b);
+    const double d3 = cross(a, b, c);
+    const double d4 = cross(a, b, d);
+    if (((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) && ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0)))
+        return true;
+
+    auto onSegment = [](const QPointF &start, const QPointF &end, const QPointF &point) {
+        return std::min(start.x(), end.x()) <= point.x() && point.x() <= std::max(start.x(), end.x()) &&
+                std::min(start.y(), end.y()) <= point.y() && point.y() <= std::max(start.y(), end.y());
+    };
+    return (d1 == 0.0 && onSegment(c, d, a)) || (d2 == 0.0 && onSegment(c, d, b)) ||
+            (d3 == 0.0 && onSegment(a, b, c)) || (d4 == 0.0 && onSegment(a, b, d));
+}
+
+// Liang-Barsky clipping of segment a-b against the rectangle
+bool segmentIntersectsRect(const QPointF &a, const QPointF &b, const QRectF &rect)
+{
+    double t0 = 0.0;
+    double t1 = 1.0;
+    const double dx = b.x() - a.x();
+    const double dy = b.y() - a.y();
+    auto clip = [&](double p, double q) {
+        if (p == 0.0)
+            return q >= 0.0;
+        const double t = q / p;
+        if (p < 0.0)
+            t0 = std::max(t0, t);
+        else
+            t1 = std::min(t1, t);
+        return t0 <= t1;
+    };
+    return clip(-dx, a.x() - rect.left()) && clip(dx, rect.right() - a.x()) && clip(-dy, a.y() - rect.top()) && clip(dy, rect.bottom() - a.y());
+}
+
+// Also for degenerate polygons, i.e., points and lines (unlike QPolygonF::boundingRect with QRectF's null semantics)
+QRectF getBoundingBox(const QVector<QPointF> &polygon)
+{
+    double minX = polygon.first().x(), maxX = minX;
+    double minY = polygon.first().y(), maxY = minY;
+    for (const QPointF &point : polygon) {
+        minX = std::min(minX, point.x());
+        maxX = std::max(maxX, point.x());
+        minY = std::min(minY, point.y());
+        maxY = std::max(maxY, point.y());
+    }
+    return QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+}
+
+bool boxContains(const QRectF &outer, const QRectF &inner)
+{
+    return inner.left() >= outer.left() && inner.right() <= outer.right() && inner.top() >= outer.top() && inner.bottom() <= outer.bottom();
+}
+
+bool boxesOverlap(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && b.left() <= a.right() && a.top() <= b.bottom() && b.top() <= a.bottom();
+}
+
+bool convexPolygonContains(const QVector<QPointF> &polygon, const QPointF &point)
+{
+    bool hasPositive = false;
+    bool hasNegative = false;
+    for (int i = 0; i < polygon.size(); i++) {
+        const double side = cross(polygon.at(i), polygon.at((i + 1) % polygon.size()), point);
+        hasPositive |= side > 0.0;
+        hasNegative |= side < 0.0;
+    }
+    return hasPositive != hasNegative; // false for degenerate polygons, their points are checked on their own
+}
+}
+
+int Geofence::addZone(ZoneType type, const QVector<QPointF> &polygon)
+{
+    if (polygon.size() < 3)
+        return -1;
+
+    Zone zone;
+    zone.type = type;
+    zone.polygon = polygon;
+    prepareZone(zone);
+    mZones.append(zone);
+    if (type == ZoneType::KeepIn)
+        mKeepInZoneCount++;
+    return mZones.size() - 1;
+}
+
+void Geofence::clear()
+{
+    mZones.clear();
+    mKeepInZoneCount = 0;
+}
+
+bool Geofence::containsPoint(int zoneIndex, const QPointF &point) const
+{
+    return zoneContainsPoint(mZones.at(zoneIndex), point);
+}
+
+bool Geofence::isPointAllowed(const QPointF &point) const
+{
+    bool insideKeepIn = !hasKeepInZones();
+    for (const Zone &zone : mZones) {
+        if (zone.type == ZoneType::KeepOut && zoneContainsPoint(zone, point))
+            return false;
+        if (zone.type == ZoneType::KeepIn && !insideKeepIn)
+            insideKeepIn = zoneContainsPoint(zone, point);
+    }
+    return insideKeepIn;
+}
+
+int Geofence::getViolatedZone(const QVector<QPointF> &footprint) const
+{
+    if (footprint.isEmpty())
+        return -1;
+
+    // The first keep-in zone is reported if the footprint is inside none
+    const QRectF footprintBoundingBox = getBoundingBox(footprint);
+    bool insideKeepIn = !hasKeepInZones();
+    int firstKeepInZone = -1;
+    for (int i = 0; i < mZones.size(); i++) {
+        const Zone &zone = mZones.at(i);
+        if (zone.type == ZoneType::KeepOut) {
+            if (isFootprintOverlapping(zone, footprint, footprintBoundingBox))
+                return i;
+        } else if (!insideKeepIn) {
+            if (firstKeepInZone < 0)
+                firstKeepInZone = i;
+            insideKeepIn = isFootprintInside(zone, footprint, footprintBoundingBox);
+        }
+    }
+    return insideKeepIn ? -1 : firstKeepInZone;
+}
+
+QVector<QPointF> Geofence::placeFootprint(const QRectF &footprint, const QPointF &position, double yaw_rad)
+{
+    const double cosYaw = cos(yaw_rad);
+    const double sinYaw = sin(yaw_rad);
+    auto place = [&](const QPointF &point) {
+        return QPointF(position.x() + point.x() * cosYaw - point.y() * sinYaw, position.y() + point.x() * sinYaw + point.y() * cosYaw);
+    };
+    return {place(footprint.topLeft()), place(footprint.topRight()), place(footprint.bottomRight()), place(footprint.bottomLeft())};
+}
+
+Geofence::Violation Geofence::checkPath(const QRectF &footprint, const QPointF &position, double yaw_rad, double curvature, double distance_m, double step_m) const
+{
+    if (isEmpty())
+        return Violation();
+
+    const int steps = (step_m > 0.0) ? std::max(1, int(ceil(fabs(distance_m) / step_m))) : 1;
+    for (int i = 0; i <= steps; i++) {
+        const double distance = distance_m * i / steps;
+        const double yaw = yaw_rad + curvature * distance;
+        QPointF point;
+        if (fabs(curvature) < 1e-9)
+            point = position + distance * QPointF(cos(yaw_rad), sin(yaw_rad));
+        else
+            point = position + QPointF(sin(yaw) - sin(yaw_rad), cos(yaw_rad) - cos(yaw)) / curvature;
+
+        const int zoneIndex = getViolatedZone(placeFootprint(footprint, point, yaw));
+        if (zoneIndex >= 0)
+            return {zoneIndex, fabs(distance)};
+    }
+    return Violation();
+}
+
+void Geofence::prepareZone(Zone &zone)
+{
+    const QVector<QPointF> &polygon = zone.polygon;
+    const int edgeCount = polygon.size();
+    zone.boundingBox = getBoundingBox(polygon);
+
+    // About one edge per cell for evenly spread edges
+    const int cellsPerSide = std::clamp(int(ceil(sqrt(double(edgeCount)))), 1, MAX_GRID_CELLS_PER_SIDE);
+    zone.cellSize = std::max(std::max(zone.boundingBox.width(), zone.boundingBox.height()) / cellsPerSide, 1e-6);
+    zone.cellsX = std::clamp(int(ceil(zone.boundingBox.width() / zone.cellSize)), 1, MAX_GRID_CELLS_PER_SIDE);
+    zone.cellsY = std::clamp(int(ceil(zone.boundingBox.height() / zone.cellSize)), 1, MAX_GRID_CELLS_PER_SIDE);
+
+    QVector<QVector<int>> edgesPerCell(zone.cellsX * zone.cellsY);
+    for (int i = 0; i < edgeCount; i++) {
+        const QPointF &a = polygon.at(i);
+        const QPointF &b = polygon.at((i + 1) % edgeCount);
+        for (int cellY = getCellY(zone, std::min(a.y(), b.y())); cellY <= getCellY(zone, std::max(a.y(), b.y())); cellY++)
+            for (int cellX = getCellX(zone, std::min(a.x(), b.x())); cellX <= getCellX(zone, std::max(a.x(), b.x())); cellX++) {
+                // Slightly enlarged, edges on cell borders are in both cells
+                const QPointF center = getCellCenter(zone, cellX, cellY);
+                const double halfSize = zone.cellSize * (0.5 + 1e-9);
+                if (segmentIntersectsRect(a, b, QRectF(center - QPointF(halfSize, halfSize), center + QPointF(halfSize, halfSize))))
+                    edgesPerCell[getCellIndex(zone, cellX, cellY)].append(i);
+            }
+    }
+
+    zone.cellEdgesStart.resize(edgesPerCell.size() + 1);
+    zone.cellEdges.clear();
+    for (int i = 0; i < edgesPerCell.size(); i++) {
+        zone.cellEdgesStart[i] = zone.cellEdges.size();
+        zone.cellEdges.append(edgesPerCell.at(i));
+    }
+    zone.cellEdgesStart[edgesPerCell.size()] = zone.cellEdges.size();
+
+    // Cell centers by rows: crossings of the row's center line, inside after an odd number of them
+    zone.cellCenterInside.resize(zone.cellsX * zone.cellsY);
+    QVector<double> crossings;
+    for (int cellY = 0; cellY < zone.cellsY; cellY++) {
+        const double y = getCellCenter(zone, 0, cellY).y();
+        crossings.clear();
+        for (int i = 0; i < edgeCount; i++) {
+            const QPointF &a = polygon.at(i);
+            const QPointF &b = polygon.at((i + 1) % edgeCount);
+            if ((a.y() > y) != (b.y() > y))
+                crossings.append(a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()));
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        int crossingsBefore = 0;
+        for (int cellX = 0; cellX < zone.cellsX; cellX++) {
+            const double x = getCellCenter(zone, cellX, cellY).x();
+            while (crossingsBefore < crossings.size() && crossings.at(crossingsBefore) < x)
+                crossingsBefore++;
+            zone.cellCenterInside[getCellIndex(zone, cellX, cellY)] = (crossingsBefore % 2) == 1;
+        }
+    }
+}
+
+int Geofence::getCellX(const Zone &zone, double x)
+{
+    return std::clamp(int(floor((x - zone.boundingBox.left()) / zone.cellSize)), 0, zone.cellsX - 1);
+}
+
+int Geofence::getCellY(const Zone &zone, double y)
+{
+    return std::clamp(int(floor((y - zone.boundingBox.top()) / zone.cellSize)), 0, zone.cellsY - 1);
+}
+
+QPointF Geofence::getCellCenter(const Zone &zone, int cellX, int cellY)
+{
+    return zone.boundingBox.topLeft() + QPointF((cellX + 0.5) * zone.cellSize, (cellY + 0.5) * zone.cellSize);
+}
+
+bool Geofence::zoneContainsPoint(const Zone &zone, const QPointF &point)
+{
+    if (!boxContains(zone.boundingBox, QRectF(point, point)))
+        return false;
+
+    const int cellX = getCellX(zone, point.x());
+    const int cellY = getCellY(zone, point.y());
+    const int cell = getCellIndex(zone, cellX, cellY);
+    const QPointF center = getCellCenter(zone, cellX, cellY);
+    bool inside = zone.cellCenterInside.at(cell);
+    for (int i = zone.cellEdgesStart.at(cell); i < zone.cellEdgesStart.at(cell + 1); i++) {
+        const int edge = zone.cellEdges.at(i);
+        if (crossesForParity(point, center, zone.polygon.at(edge), zone.polygon.at((edge + 1) % zone.polygon.size())))
+            inside = !inside;
+    }
+    return inside;
+}
+
+bool Geofence::edgesIntersectFootprint(const Zone &zone, const QVector<QPointF> &footprint, const QRectF &footprintBoundingBox)
+{
+    // Edges in several cells are tested more than once, which is cheaper than deduplicating them for footprints of a few cells
+    for (int cellY = getCellY(zone, footprintBoundingBox.top()); cellY <= getCellY(zone, footprintBoundingBox.bottom()); cellY++)
+        for (int cellX = getCellX(zone, footprintBoundingBox.left()); cellX <= getCellX(zone, footprintBoundingBox.right()); cellX++) {
+            const int cell = getCellIndex(zone, cellX, cellY);
+            for (int i = zone.cellEdgesStart.at(cell); i < zone.cellEdgesStart.at(cell + 1); i++) {
+                const int edge = zone.cellEdges.at(i);
+                const QPointF &a = zone.polygon.at(edge);
+                const QPointF &b = zone.polygon.at((edge + 1) % zone.polygon.size());
+                if (!boxesOverlap(footprintBoundingBox, QRectF(QPointF(std::min(a.x(), b.x()), std::min(a.y(), b.y())),
+                                                               QPointF(std::max(a.x(), b.x()), std::max(a.y(), b.y())))))
+                    continue;
+                for (int j = 0; j < footprint.size(); j++)
+                    if (segmentsIntersect(a, b, footprint.at(j), footprint.at((j + 1) % footprint.size())))
+                        return true;
+            }
+        }
+    return false;
+}
+
+bool Geofence::isFootprintInside(const Zone &zone, const QVector<QPointF> &footprint, const QRectF &footprintBoundingBox)
+{
+    if (!boxContains(zone.boundingBox, footprintBoundingBox))
+        return false;
+
+    for (const QPointF &point : footprint)
+        if (!zoneContainsPoint(zone, point))
+            return false;
+    return !edgesIntersectFootprint(zone, footprint, footprintBoundingBox);
+}
+
+bool Geofence::isFootprintOverlapping(const Zone &zone, const QVector<QPointF> &footprint, const QRectF &footprintBoundingBox)
+{
+    if (!boxesOverlap(zone.boundingBox, footprintBoundingBox))
+        return false;
+
+    for (const QPointF &point : footprint)
+        if (zoneContainsPoint(zone, point))
+            return true;
+    // Zone completely inside the footprint
+    if (convexPolygonContains(footprint, zone.polygon.first()))
+        return true;
+    return edgesIntersectFootprint(zone, footprint, footprintBoundingBox);
+}
@@ -0,0 +1,84 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Keep-in and keep-out zones (simple polygons, ENU [m]) prepared for containment checks every control iteration.
+ * Each zone keeps its bounding box and a uniform grid over it: a cell lists the edges crossing it, the side of its center
+ * is classified once. A point is decided by the crossings of its cell's edges with the line to the cell's center,
+ * i.e., by its cell alone in cells without edges.
+ * Footprints (e.g., a vehicle's bounding box placed at its pose) are convex polygons. A footprint is allowed if it is
+ * inside a keep-in zone (if there are any) and disjoint from all keep-out zones. Keep-in zones are not merged,
+ * i.e., a footprint across two overlapping keep-in zones is not allowed.
+ * Zones cannot be changed once added, prepared geofences can be shared between threads, e.g., as QSharedPointer<const Geofence>.
+ */
+
+#ifndef GEOFENCE_H
+#define GEOFENCE_H
+
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+class Geofence
+{
+public:
+    enum class ZoneType : quint32 {KeepIn = 0, KeepOut = 1};
+
+    struct Violation {
+        int zoneIndex = -1; // -1: none
+        double distance_m = 0.0; // along the path, 0: at its start
+
+        bool isViolated() const { return zoneIndex >= 0; }
+    };
+
+    static constexpr int MAX_GRID_CELLS_PER_SIDE = 64;
+
+    // Returns the zone's index, -1 for polygons with less than three points
+    int addZone(ZoneType type, const QVector<QPointF> &polygon);
+    void clear();
+    bool isEmpty() const { return mZones.isEmpty(); }
+    int getZoneCount() const { return mZones.size(); }
+    ZoneType getZoneType(int zoneIndex) const { return mZones.at(zoneIndex).type; }
+    const QVector<QPointF> &getZonePolygon(int zoneIndex) const { return mZones.at(zoneIndex).polygon; }
+    bool hasKeepInZones() const { return mKeepInZoneCount > 0; }
+
+    bool containsPoint(int zoneIndex, const QPointF &point) const;
+    bool isPointAllowed(const QPointF &point) const;
+    // Index of a violated zone, -1 if the footprint is allowed
+    int getViolatedZone(const QVector<QPointF> &footprint) const;
+
+    // footprint: rectangle in the vehicle frame (x forward, y left) [m], placed at position with yaw [rad] (ENU, counter-clockwise from x)
+    static QVector<QPointF> placeFootprint(const QRectF &footprint, const QPointF &position, double yaw_rad);
+    // First violation along the path with constant curvature [1/m] (positive: turning left) from position and yaw,
+    // checked every step [m] for distance [m] (negative: reversing)
+    Violation checkPath(const QRectF &footprint, const QPointF &position, double yaw_rad, double curvature, double distance_m, double step_m = 0.1) const;
+
+private:
+    struct Zone {
+        ZoneType type;
+        QVector<QPointF> polygon;
+        QRectF boundingBox;
+        int cellsX = 1;
+        int cellsY = 1;
+        double cellSize = 1.0;
+        QVector<int> cellEdgesStart; // edges of cell i: cellEdges[cellEdgesStart[i]..cellEdgesStart[i+1]), edge i from point i to i+1
+        QVector<int> cellEdges;
+        QVector<bool> cellCenterInside;
+    };
+
+    static void prepareZone(Zone &zone);
+    static int getCellIndex(const Zone &zone, int cellX, int cellY) { return cellY * zone.cellsX + cellX; }
+    static int getCellX(const Zone &zone, double x);
+    static int getCellY(const Zone &zone, double y);
+    static QPointF getCellCenter(const Zone &zone, int cellX, int cellY);
+    static bool zoneContainsPoint(const Zone &zone, const QPointF &point);
+    // Any edge of the zone in the cells overlapped by the footprint's bounding box intersects an edge of the footprint
+    static bool edgesIntersectFootprint(const Zone &zone, const QVector<QPointF> &footprint, const QRectF &footprintBoundingBox);
+    static bool isFootprintInside(const Zone &zone, const QVector<QPointF> &footprint, const QRectF &footprintBoundingBox);
+    static bool isFootprintOverlapping(const Zone &zone, const QVector<QPointF> &footprint, const QRectF &footprintBoundingBox);
+
+    QVector<Zone> mZones;
+    int mKeepInZoneCount = 0;
+};
+
+#endif // GEOFENCE_H
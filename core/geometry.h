@@ -12,11 +12,22 @@
 #include <QObject>
 #include <QLineF>
 #include <cmath>
+#include <algorithm>
 
 namespace geometry {
 
-inline QVector<QPointF> findIntersectionsBetweenCircleAndLine(QPair<QPointF,double> circle, QLineF line) {
-    QVector<QPointF> intersections;
+// At most two intersections between a circle and a line segment, stored inline (no allocation)
+struct CircleLineIntersections {
+    int count = 0;
+    QPointF points[2];
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    const QPointF &operator[](int i) const { return points[i]; }
+};
+
+inline CircleLineIntersections findCircleLineIntersections(const QPointF &center, double radius, const QLineF &line) {
+    CircleLineIntersections intersections;
 
     double maxX = line.x1();
     double minX = line.x2();
@@ -31,43 +42,99 @@ inline QVector<QPointF> findIntersectionsBetweenCircleAndLine(QPair<QPointF,doub
         minY = line.y1();
     }
 
-    double a = line.dx() * line.dx() + line.dy() * line.dy();
-    double b = 2 * (line.dx() * (line.x1() - circle.first.x()) + line.dy() * (line.y1() - circle.first.y()));
-    double c = (line.x1() - circle.first.x()) * (line.x1() - circle.first.x()) + (line.y1() - circle.first.y()) * (line.y1() - circle.first.y()) - circle.second * circle.second;
+    const double a = line.dx() * line.dx() + line.dy() * line.dy();
+    const double b = 2 * (line.dx() * (line.x1() - center.x()) + line.dy() * (line.y1() - center.y()));
+    const double c = (line.x1() - center.x()) * (line.x1() - center.x()) + (line.y1() - center.y()) * (line.y1() - center.y()) - radius * radius;
 
-    double det = b * b - 4 * a * c;
+    const double det = b * b - 4 * a * c;
 
-    if ((a <= 1e-6) || (det < 0.0)) {
-//         qDebug() << "No real solutions.";
-    } else if (det == 0) {
-//         qDebug() << "One solution.";
-        double t = -b / (2 * a);
-        double x = line.x1() + t * line.dx();
-        double y = line.y1() + t * line.dy();
+    auto appendIfOnSegment = [&](double t) {
+        const double x = line.x1() + t * line.dx();
+        const double y = line.y1() + t * line.dy();
 
         if (x >= minX && x <= maxX &&
                 y >= minY && y <= maxY)
-            intersections.append(QPointF(x, y));
+            intersections.points[intersections.count++] = QPointF(x, y);
+    };
+
+    if ((a <= 1e-6) || (det < 0.0)) {
+        // No real solutions.
+    } else if (det == 0) {
+        // One solution.
+        appendIfOnSegment(-b / (2 * a));
     } else {
-//         qDebug() << "Two solutions.";
-        double t = (-b + sqrtf(det)) / (2 * a);
-        double x = line.x1() + t * line.dx();
-        double y = line.y1() + t * line.dy();
+        // Two solutions.
+        const double sqrtDet = sqrt(det);
+        appendIfOnSegment((-b + sqrtDet) / (2 * a));
+        appendIfOnSegment((-b - sqrtDet) / (2 * a));
+    }
 
-        if (x >= minX && x <= maxX &&
-                y >= minY && y <= maxY)
-            intersections.append(QPointF(x, y));
+    return intersections;
+}
 
-        t = (-b - sqrtf(det)) / (2 * a);
-        x = line.x1() + t * line.dx();
-        y = line.y1() + t * line.dy();
+inline QVector<QPointF> findIntersectionsBetweenCircleAndLine(QPair<QPointF,double> circle, QLineF line) {
+    const CircleLineIntersections found = findCircleLineIntersections(circle.first, circle.second, line);
 
-        if (x >= minX && x <= maxX &&
-                y >= minY && y <= maxY)
-            intersections.append(QPointF(x, y));
+    QVector<QPointF> intersections;
+    for (int i = 0; i < found.size(); i++)
+        intersections.append(found[i]);
+    return intersections;
+}
+
+struct PolylineIntersection {
+    bool found = false;
+    int segmentEndIndex = -1; // segment from point segmentEndIndex-1 to point segmentEndIndex
+    QPointF point;
+};
+
+// Intersection between a circle and a polyline that is furthest along the polyline, i.e., segments are searched backwards
+// from the end and the intersection closest to the end of the last intersected segment is chosen.
+// getPoint(i) returns point i of the polyline (0 <= i < numPoints), e.g., to iterate over waypoints without copying them.
+template<typename GetPoint>
+inline PolylineIntersection findFurthestCirclePolylineIntersection(const QPointF &center, double radius, int numPoints, GetPoint getPoint) {
+    PolylineIntersection result;
+
+    for (int i = numPoints - 1; i > 0; i--) {
+        const QPointF segmentEnd = getPoint(i);
+        const CircleLineIntersections intersections = findCircleLineIntersections(center, radius, QLineF(getPoint(i - 1), segmentEnd));
+        if (intersections.isEmpty())
+            continue;
+
+        result.found = true;
+        result.segmentEndIndex = i;
+        result.point = intersections[0];
+        if (intersections.size() == 2 && QLineF(intersections[1], segmentEnd).length() <= QLineF(intersections[0], segmentEnd).length())
+            result.point = intersections[1];
+        break;
     }
 
-    return intersections;
+    return result;
+}
+
+inline double distanceToLineSegment(const QPointF &point, const QLineF &segment) {
+    const double dx = segment.dx();
+    const double dy = segment.dy();
+    const double lengthSquared = dx * dx + dy * dy;
+
+    double t = 0.0;
+    if (lengthSquared > 1e-12)
+        t = std::clamp(((point.x() - segment.x1()) * dx + (point.y() - segment.y1()) * dy) / lengthSquared, 0.0, 1.0);
+
+    const double closestX = segment.x1() + t * dx;
+    const double closestY = segment.y1() + t * dy;
+    return sqrt((point.x() - closestX) * (point.x() - closestX) + (point.y() - closestY) * (point.y() - closestY));
+}
+
+// Curvature [1/m] of the circle through three points (Menger curvature), positive when turning left, 0 for collinear or coinciding points
+inline double threePointCurvature(const QPointF &previous, const QPointF &point, const QPointF &next) {
+    const double a = QLineF(previous, point).length();
+    const double b = QLineF(point, next).length();
+    const double c = QLineF(previous, next).length();
+    if (a * b * c < 1e-12)
+        return 0.0;
+
+    const double doubleSignedArea = (point.x() - previous.x()) * (next.y() - previous.y()) - (point.y() - previous.y()) * (next.x() - previous.x());
+    return 2.0 * doubleSignedArea / (a * b * c);
 }
 
 }
@@ -0,0 +1,50 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Lock-free single-slot mailbox for commands where only the latest value matters (e.g., speed and steering setpoints).
+ * Writers overwrite the slot (serialized by the underlying SeqLock), exactly one consumer thread takes new values.
+ * Never allocates, a writer never waits for the consumer and older values that were not taken yet are dropped.
+ */
+
+#ifndef LATESTVALUEMAILBOX_H
+#define LATESTVALUEMAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+#include "core/seqlock.h"
+
+template<typename T>
+class LatestValueMailbox
+{
+public:
+    LatestValueMailbox() = default;
+    LatestValueMailbox(const LatestValueMailbox &) = delete;
+    LatestValueMailbox &operator=(const LatestValueMailbox &) = delete;
+
+    // Any thread
+    void publish(const T &value) {
+        mValue.store(value);
+        mVersion.fetch_add(1, std::memory_order_release);
+    }
+
+    // Consumer thread only, returns false if nothing was published since the last take
+    bool take(T &value) {
+        const uint32_t version = mVersion.load(std::memory_order_acquire);
+        if (version == mTakenVersion)
+            return false;
+
+        mTakenVersion = version;
+        value = mValue.load();
+        return true;
+    }
+
+    T peek() const { return mValue.load(); }
+
+private:
+    SeqLock<T> mValue;
+    std::atomic<uint32_t> mVersion{0};
+    uint32_t mTakenVersion = 0;
+};
+
+#endif // LATESTVALUEMAILBOX_H
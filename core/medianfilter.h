@@ -0,0 +1,51 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Median over the last WINDOW samples (fixed windows, no allocations), e.g., to suppress single outliers of range sensors.
+ * Until the window is full, the median of the samples so far is returned. For even counts the lower median is used,
+ * i.e., the result is always one of the samples (invalid markers such as "out of range" pass through unchanged).
+ */
+
+#ifndef MEDIANFILTER_H
+#define MEDIANFILTER_H
+
+#include <array>
+#include <algorithm>
+
+template<typename T, int WINDOW>
+class MedianFilter
+{
+    static_assert(WINDOW > 0, "MedianFilter needs a window of at least one sample");
+
+public:
+    // Returns the median including the new sample
+    T add(const T &sample) {
+        mSamples[mNext] = sample;
+        mNext = (mNext + 1) % WINDOW;
+        mSize = std::min(mSize + 1, WINDOW);
+        return getMedian();
+    }
+
+    T getMedian() const {
+        if (mSize == 0)
+            return T();
+
+        std::array<T, WINDOW> sorted = mSamples;
+        T *middle = sorted.data() + (mSize - 1) / 2;
+        std::nth_element(sorted.data(), middle, sorted.data() + mSize);
+        return *middle;
+    }
+
+    void clear() { mSize = 0; mNext = 0; }
+    int size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+    static constexpr int getWindow() { return WINDOW; }
+
+private:
+    std::array<T, WINDOW> mSamples = {};
+    int mNext = 0; // ring position of the next sample
+    int mSize = 0;
+};
+
+#endif // MEDIANFILTER_H
@@ -0,0 +1,76 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Bounded lock-free queue for many producers and a single consumer (D. Vyukov's bounded queue).
+ * Entries are preallocated and filled/read in place, pushing never allocates and fails when the queue is full.
+ */
+
+#ifndef MPSCRINGBUFFER_H
+#define MPSCRINGBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+template<typename T, size_t Capacity>
+class MpscRingBuffer
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MpscRingBuffer capacity must be a power of two");
+
+public:
+    MpscRingBuffer() {
+        for (size_t i = 0; i < Capacity; i++)
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Any thread. fill(T &entry) writes the entry in place, returns false if full.
+    template<typename Fill>
+    bool tryPush(Fill fill) {
+        Cell *cell;
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &mCells[pos & (Capacity - 1)];
+            const intptr_t diff = intptr_t(cell->sequence.load(std::memory_order_acquire)) - intptr_t(pos);
+            if (diff == 0) {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0)
+                return false;
+            else
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+
+        fill(cell->data);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only. consume(const T &entry) reads the entry in place, returns false if empty.
+    template<typename Consume>
+    bool tryPop(Consume consume) {
+        Cell &cell = mCells[mDequeuePos & (Capacity - 1)];
+        if (intptr_t(cell.sequence.load(std::memory_order_acquire)) - intptr_t(mDequeuePos + 1) < 0)
+            return false;
+
+        consume(static_cast<const T&>(cell.data));
+        cell.sequence.store(mDequeuePos + Capacity, std::memory_order_release);
+        mDequeuePos++;
+        return true;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::array<Cell, Capacity> mCells;
+    alignas(64) std::atomic<size_t> mEnqueuePos {0};
+    alignas(64) size_t mDequeuePos = 0;
+};
+
+#endif // MPSCRINGBUFFER_H
@@ -0,0 +1,69 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "objecttracker.h"
+#include <algorithm>
+#include <cmath>
+
+void ObjectTracker::update(const PosPoint *detections, int detectionCount, qint64 timestamp_ns)
+{
+    // Forget objects that were not seen for a while
+    const auto keptEnd = std::remove_if(mTracks.begin(), mTracks.begin() + mNumTracks, [this, timestamp_ns](const TrackedObject &track) {
+        return timestamp_ns - track.lastSeen_ns > mTrackTimeout_ns;
+    });
+    mNumTracks = int(keptEnd - mTracks.begin());
+
+    const int numDetections = std::min(detectionCount, MAX_DETECTIONS);
+    const int numExistingTracks = mNumTracks;
+    int numCandidates = 0;
+    for (int track = 0; track < numExistingTracks; track++)
+        for (int detection = 0; detection < numDetections; detection++) {
+            const QPointF difference = QPointF(detections[detection].getX(), detections[detection].getY()) - mTracks[track].position;
+            const double distance_m = std::hypot(difference.x(), difference.y());
+            if (distance_m < mAssociationGate_m)
+                mCandidates[numCandidates++] = {distance_m, track, detection};
+        }
+    std::sort(mCandidates.begin(), mCandidates.begin() + numCandidates, [](const Candidate &a, const Candidate &b) {
+        return a.distance_m < b.distance_m;
+    });
+
+    std::array<bool, MAX_TRACKS> isTrackUpdated = {};
+    std::array<bool, MAX_DETECTIONS> isDetectionAssociated = {};
+    for (int i = 0; i < numCandidates; i++) {
+        const Candidate &candidate = mCandidates[i];
+        if (isTrackUpdated[candidate.track] || isDetectionAssociated[candidate.detection])
+            continue;
+        isTrackUpdated[candidate.track] = true;
+        isDetectionAssociated[candidate.detection] = true;
+
+        const PosPoint &detection = detections[candidate.detection];
+        const QPointF position(detection.getX(), detection.getY());
+        TrackedObject &track = mTracks[candidate.track];
+        const double dt_s = (timestamp_ns - track.lastSeen_ns) / 1e9;
+        if (dt_s > 1e-3) {
+            const QPointF measuredVelocity = (position - track.position) / dt_s;
+            track.velocity = track.hasVelocity ? (track.velocity + measuredVelocity) / 2.0 : measuredVelocity;
+            track.hasVelocity = true;
+        }
+        track.position = position;
+        track.height = detection.getHeight();
+        track.lastSeen_ns = timestamp_ns;
+        track.numDetections++;
+    }
+
+    // Unassociated detections start new tracks
+    for (int detection = 0; detection < numDetections && mNumTracks < MAX_TRACKS; detection++) {
+        if (isDetectionAssociated[detection])
+            continue;
+
+        TrackedObject &track = mTracks[mNumTracks++];
+        track = TrackedObject();
+        track.trackId = mNextTrackId++;
+        track.position = QPointF(detections[detection].getX(), detections[detection].getY());
+        track.height = detections[detection].getHeight();
+        track.firstSeen_ns = timestamp_ns;
+        track.lastSeen_ns = timestamp_ns;
+        track.numDetections = 1;
+    }
+}
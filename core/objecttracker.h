@@ -0,0 +1,69 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Associates object detections across frames (e.g., DepthAiCamera, vehicle frame) and keeps a track per object with an ID and
+ * a velocity estimate. Association is greedy on the position: detection/track pairs within the gate are taken in order of
+ * increasing distance, each track and detection at most once. Tracks and association candidates live in fixed-capacity arrays,
+ * i.e., update() does not allocate. Detections beyond MAX_DETECTIONS per frame and new objects beyond MAX_TRACKS are ignored.
+ */
+
+#ifndef OBJECTTRACKER_H
+#define OBJECTTRACKER_H
+
+#include <QPointF>
+#include <QVector>
+#include <array>
+#include "core/pospoint.h"
+
+struct TrackedObject {
+    int trackId = -1; // unique per ObjectTracker, increasing
+    QPointF position; // [m]
+    double height = 0.0; // [m]
+    QPointF velocity; // [m/s], in the frame of the detections (relative to the sensor)
+    bool hasVelocity = false; // seen at least twice
+    qint64 firstSeen_ns = utcTime::INVALID;
+    qint64 lastSeen_ns = utcTime::INVALID;
+    int numDetections = 0;
+};
+
+class ObjectTracker
+{
+public:
+    static constexpr int MAX_TRACKS = 32;
+    static constexpr int MAX_DETECTIONS = 32; // per frame
+    static constexpr double DEFAULT_ASSOCIATION_GATE_m = 1.0;
+    static constexpr qint64 DEFAULT_TRACK_TIMEOUT_ns = 500 * utcTime::NS_PER_MS;
+
+    // All detections of one frame, uses x, y and height. Tracks not seen for the timeout are dropped first.
+    void update(const QVector<PosPoint> &detections, qint64 timestamp_ns) { update(detections.constData(), detections.size(), timestamp_ns); }
+    void update(const PosPoint *detections, int detectionCount, qint64 timestamp_ns);
+    void clear() { mNumTracks = 0; }
+
+    int size() const { return mNumTracks; }
+    bool isEmpty() const { return mNumTracks == 0; }
+    const TrackedObject &at(int index) const { return mTracks[index]; }
+    const TrackedObject *begin() const { return mTracks.data(); }
+    const TrackedObject *end() const { return mTracks.data() + mNumTracks; }
+
+    double getAssociationGate_m() const { return mAssociationGate_m; }
+    void setAssociationGate_m(double associationGate_m) { mAssociationGate_m = associationGate_m; }
+    qint64 getTrackTimeout_ns() const { return mTrackTimeout_ns; }
+    void setTrackTimeout_ns(qint64 trackTimeout_ns) { mTrackTimeout_ns = trackTimeout_ns; }
+
+private:
+    struct Candidate {
+        double distance_m;
+        int track;
+        int detection;
+    };
+
+    std::array<TrackedObject, MAX_TRACKS> mTracks; // [0, mNumTracks) in use
+    int mNumTracks = 0;
+    int mNextTrackId = 0;
+    std::array<Candidate, MAX_TRACKS * MAX_DETECTIONS> mCandidates;
+    double mAssociationGate_m = DEFAULT_ASSOCIATION_GATE_m;
+    qint64 mTrackTimeout_ns = DEFAULT_TRACK_TIMEOUT_ns;
+};
+
+#endif // OBJECTTRACKER_H
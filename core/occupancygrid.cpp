@@ -0,0 +1,175 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "occupancygrid.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+OccupancyGrid::OccupancyGrid(int sizeLog2, double cellSize_m)
+    : mSizeLog2(std::clamp(sizeLog2, 1, 12)), mSize(1 << mSizeLog2), mMask(mSize - 1), mCellSize_m(std::max(cellSize_m, 1e-3)),
+      mCells(mSize * mSize, 0), mOriginX(-mSize / 2), mOriginY(-mSize / 2)
+{
+}
+
+void OccupancyGrid::setCenter(const QPointF &center)
+{
+    const int originX = getCellCoordinate(center.x()) - mSize / 2;
+    const int originY = getCellCoordinate(center.y()) - mSize / 2;
+    std::lock_guard<std::mutex> lock(mMutex);
+    const int shiftX = originX - mOriginX;
+    const int shiftY = originY - mOriginY;
+    if (shiftX == 0 && shiftY == 0)
+        return;
+
+    if (abs(shiftX) >= mSize || abs(shiftY) >= mSize) {
+        mCells.fill(0);
+    } else {
+        // Columns and rows that scroll in reuse the storage of those that scroll out
+        const int firstColumn = (shiftX > 0) ? mOriginX + mSize : originX;
+        for (int cellX = firstColumn; cellX < firstColumn + abs(shiftX); cellX++)
+            for (int row = 0; row < mSize; row++)
+                mCells[(row << mSizeLog2) | (cellX & mMask)] = 0;
+
+        const int firstRow = (shiftY > 0) ? mOriginY + mSize : originY;
+        for (int cellY = firstRow; cellY < firstRow + abs(shiftY); cellY++)
+            std::fill_n(mCells.begin() + ((cellY & mMask) << mSizeLog2), mSize, 0);
+    }
+    mOriginX = originX;
+    mOriginY = originY;
+}
+
+QRectF OccupancyGrid::getBounds() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return QRectF(mOriginX * mCellSize_m, mOriginY * mCellSize_m, mSize * mCellSize_m, mSize * mCellSize_m);
+}
+
+void OccupancyGrid::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCells.fill(0);
+    mLastUpdate_ns = utcTime::INVALID;
+}
+
+void OccupancyGrid::insertRay(const QPointF &origin, const QPointF &end, bool endIsHit, qint64 timestamp_ns)
+{
+    // Grid traversal (Amanatides & Woo): one cell step in x or y at a time, |dx| + |dy| steps from the origin's to the end's cell
+    int cellX = getCellCoordinate(origin.x());
+    int cellY = getCellCoordinate(origin.y());
+    const int endX = getCellCoordinate(end.x());
+    const int endY = getCellCoordinate(end.y());
+    const double dx = end.x() - origin.x();
+    const double dy = end.y() - origin.y();
+    const int stepX = (dx > 0.0) ? 1 : -1;
+    const int stepY = (dy > 0.0) ? 1 : -1;
+    const double infinity = std::numeric_limits<double>::infinity();
+    double tMaxX = (dx != 0.0) ? ((cellX + (stepX > 0 ? 1 : 0)) * mCellSize_m - origin.x()) / dx : infinity;
+    double tMaxY = (dy != 0.0) ? ((cellY + (stepY > 0 ? 1 : 0)) * mCellSize_m - origin.y()) / dy : infinity;
+    const double tDeltaX = (dx != 0.0) ? mCellSize_m / fabs(dx) : infinity;
+    const double tDeltaY = (dy != 0.0) ? mCellSize_m / fabs(dy) : infinity;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    const int steps = abs(endX - cellX) + abs(endY - cellY);
+    for (int i = 0; i < steps; i++) {
+        updateCell(cellX, cellY, LOG_ODDS_MISS);
+        if (cellY == endY || (cellX != endX && tMaxX < tMaxY)) {
+            tMaxX += tDeltaX;
+            cellX += stepX;
+        } else {
+            tMaxY += tDeltaY;
+            cellY += stepY;
+        }
+    }
+    updateCell(endX, endY, endIsHit ? LOG_ODDS_HIT : LOG_ODDS_MISS);
+    if (utcTime::isValid(timestamp_ns))
+        mLastUpdate_ns = timestamp_ns;
+}
+
+void OccupancyGrid::insertHit(const QPointF &point, qint64 timestamp_ns)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    updateCell(getCellCoordinate(point.x()), getCellCoordinate(point.y()), LOG_ODDS_HIT);
+    if (utcTime::isValid(timestamp_ns))
+        mLastUpdate_ns = timestamp_ns;
+}
+
+qint64 OccupancyGrid::getLastUpdateTimestamp_ns() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLastUpdate_ns;
+}
+
+int OccupancyGrid::getLogOdds(const QPointF &point) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return getLogOddsLocked(getCellCoordinate(point.x()), getCellCoordinate(point.y()));
+}
+
+bool OccupancyGrid::isAnyOccupied(const QVector<QPointF> &points) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const QPointF &point : points)
+        if (getLogOddsLocked(getCellCoordinate(point.x()), getCellCoordinate(point.y())) >= LOG_ODDS_OCCUPIED)
+            return true;
+    return false;
+}
+
+double OccupancyGrid::getOccupancyProbability(const QPointF &point) const
+{
+    return 1.0 - 1.0 / (1.0 + exp(double(getLogOdds(point)) / LOG_ODDS_SCALE));
+}
+
+double OccupancyGrid::getDistanceToOccupied(const QPointF &origin, double yaw_rad, double halfWidth_m, double maxDistance_m, double *lateralOffset_m) const
+{
+    const QPointF direction(cos(yaw_rad), sin(yaw_rad));
+    const QPointF left(-direction.y(), direction.x());
+    const int lateralSteps = int(ceil(halfWidth_m / mCellSize_m));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (double distance = 0.0; distance <= maxDistance_m; distance += mCellSize_m) {
+        const QPointF center = origin + distance * direction;
+        for (int i = -lateralSteps; i <= lateralSteps; i++) {
+            const double lateralOffset = std::clamp(i * mCellSize_m, -halfWidth_m, halfWidth_m);
+            const QPointF point = center + lateralOffset * left;
+            if (getLogOddsLocked(getCellCoordinate(point.x()), getCellCoordinate(point.y())) >= LOG_ODDS_OCCUPIED) {
+                if (lateralOffset_m)
+                    *lateralOffset_m = lateralOffset;
+                return distance;
+            }
+        }
+    }
+    return -1.0;
+}
+
+QVector<qint8> OccupancyGrid::getLogOddsSnapshot(QRectF &bounds) const
+{
+    QVector<qint8> snapshot(mSize * mSize);
+    getLogOddsSnapshot(snapshot.data(), bounds);
+    return snapshot;
+}
+
+void OccupancyGrid::getLogOddsSnapshot(qint8 *cells, QRectF &bounds) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    bounds = QRectF(mOriginX * mCellSize_m, mOriginY * mCellSize_m, mSize * mCellSize_m, mSize * mCellSize_m);
+
+    // Each stored row starts at the origin's column, i.e., it is copied in two parts
+    const int firstColumn = mOriginX & mMask;
+    for (int row = 0; row < mSize; row++) {
+        const qint8 *source = mCells.constData() + (((mOriginY + row) & mMask) << mSizeLog2);
+        qint8 *destination = cells + row * mSize;
+        memcpy(destination, source + firstColumn, mSize - firstColumn);
+        memcpy(destination + mSize - firstColumn, source, firstColumn);
+    }
+}
+
+void OccupancyGrid::updateCell(int cellX, int cellY, int logOddsChange)
+{
+    if (!isInGrid(cellX, cellY))
+        return;
+
+    qint8 &cell = mCells[getIndex(cellX, cellY)];
+    cell = qint8(std::clamp(cell + logOddsChange, LOG_ODDS_MIN, LOG_ODDS_MAX));
+}
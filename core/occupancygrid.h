@@ -0,0 +1,80 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Rolling occupancy grid around a (moving) center, e.g., the vehicle, in ENU.
+ * Cells hold log odds (fixed point, 1/LOG_ODDS_SCALE) as one byte each, row-major in a ring buffer of size x size cells
+ * (power of two): global cell (x, y) is stored at (y mod size) * size + (x mod size). Moving the center only clears the
+ * rows and columns that scroll in, nothing is copied. Points outside of the grid are unknown (log odds 0).
+ * Rays mark the cells they pass as free and their end cell as occupied (on a hit), point lookups are O(1).
+ * Thread-safe, e.g., for updates from sensor threads and queries from the decision loop of EmergencyBrake.
+ */
+
+#ifndef OCCUPANCYGRID_H
+#define OCCUPANCYGRID_H
+
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <cmath>
+#include <mutex>
+#include "core/utctime.h"
+
+class OccupancyGrid
+{
+public:
+    static constexpr int DEFAULT_SIZE_LOG2 = 7; // 128 x 128 cells
+    static constexpr double DEFAULT_CELL_SIZE_m = 0.1;
+    static constexpr int LOG_ODDS_SCALE = 32;
+    static constexpr int LOG_ODDS_HIT = 28; // ~0.85, i.e., p = 0.7 for a single hit
+    static constexpr int LOG_ODDS_MISS = -13; // ~-0.4
+    static constexpr int LOG_ODDS_MIN = -112;
+    static constexpr int LOG_ODDS_MAX = 112;
+    static constexpr int LOG_ODDS_OCCUPIED = 22; // p > ~0.67
+
+    OccupancyGrid(int sizeLog2 = DEFAULT_SIZE_LOG2, double cellSize_m = DEFAULT_CELL_SIZE_m);
+
+    int getSize() const { return mSize; } // cells per side
+    double getCellSize() const { return mCellSize_m; }
+    // Scrolls the grid to have center in its middle cell, cells that leave the grid are forgotten
+    void setCenter(const QPointF &center);
+    QRectF getBounds() const;
+    void clear();
+
+    // Cells from origin to end are free, end is occupied if it is a hit (e.g., a range) or free otherwise (e.g., out of range)
+    void insertRay(const QPointF &origin, const QPointF &end, bool endIsHit, qint64 timestamp_ns = utcTime::INVALID);
+    void insertHit(const QPointF &point, qint64 timestamp_ns = utcTime::INVALID);
+    qint64 getLastUpdateTimestamp_ns() const;
+
+    int getLogOdds(const QPointF &point) const;
+    double getOccupancyProbability(const QPointF &point) const;
+    bool isOccupied(const QPointF &point) const { return getLogOdds(point) >= LOG_ODDS_OCCUPIED; }
+    // Any of the points occupied, e.g., samples of a footprint (locks once)
+    bool isAnyOccupied(const QVector<QPointF> &points) const;
+    // Distance to the first occupied cell in the corridor of halfWidth from origin along yaw [rad] (ENU), checked every cell up to
+    // maxDistance. Returns -1 if there is none. lateralOffset: of that cell, positive to the left
+    double getDistanceToOccupied(const QPointF &origin, double yaw_rad, double halfWidth_m, double maxDistance_m, double *lateralOffset_m = nullptr) const;
+
+    // Copy of all cells row by row from the lower left corner of bounds (the grid's bounds at the time of the copy)
+    QVector<qint8> getLogOddsSnapshot(QRectF &bounds) const;
+    void getLogOddsSnapshot(qint8 *cells, QRectF &bounds) const; // into getSize() * getSize() cells, e.g., reused per control iteration
+
+private:
+    int getCellCoordinate(double value) const { return int(floor(value / mCellSize_m)); }
+    bool isInGrid(int cellX, int cellY) const { return cellX >= mOriginX && cellX < mOriginX + mSize && cellY >= mOriginY && cellY < mOriginY + mSize; }
+    int getIndex(int cellX, int cellY) const { return ((cellY & mMask) << mSizeLog2) | (cellX & mMask); }
+    void updateCell(int cellX, int cellY, int logOddsChange);
+    int getLogOddsLocked(int cellX, int cellY) const { return isInGrid(cellX, cellY) ? mCells.at(getIndex(cellX, cellY)) : 0; }
+
+    const int mSizeLog2;
+    const int mSize;
+    const int mMask;
+    const double mCellSize_m;
+    mutable std::mutex mMutex;
+    QVector<qint8> mCells;
+    int mOriginX; // global cell coordinates of the lower left cell
+    int mOriginY;
+    qint64 mLastUpdate_ns = utcTime::INVALID;
+};
+
+#endif // OCCUPANCYGRID_H
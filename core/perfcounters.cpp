@@ -0,0 +1,142 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "perfcounters.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+PerfCounterSnapshot PerfCounterSnapshot::since(const PerfCounterSnapshot &previous) const
+{
+    PerfCounterSnapshot difference = *this;
+    difference.count = count - std::min(previous.count, count);
+    difference.latencySum_ns = latencySum_ns - std::min(previous.latencySum_ns, latencySum_ns);
+    for (int i = 0; i < NUM_BUCKETS; i++)
+        difference.buckets[i] = buckets[i] - std::min(previous.buckets[i], buckets[i]);
+    return difference;
+}
+
+double PerfCounterSnapshot::getRate_Hz(const PerfCounterSnapshot &previous) const
+{
+    const qint64 elapsed_ns = timestamp_ns - previous.timestamp_ns;
+    return (elapsed_ns > 0 && count >= previous.count) ? (count - previous.count) * 1e9 / elapsed_ns : 0.0;
+}
+
+double PerfCounterSnapshot::getLatencyPercentile_us(double percentile) const
+{
+    quint64 samples = 0;
+    for (const quint64 bucketSamples : buckets)
+        samples += bucketSamples;
+    if (samples == 0)
+        return 0.0;
+
+    const quint64 rank = std::max<quint64>(1, std::ceil(samples * std::clamp(percentile, 0.0, 100.0) / 100.0));
+    quint64 cumulative = 0;
+    for (int i = 0; i < NUM_BUCKETS - 1; i++) {
+        cumulative += buckets[i];
+        if (cumulative >= rank)
+            return std::min(double(1ull << (i + 1)), latencyMax_ns / 1000.0);
+    }
+    return latencyMax_ns / 1000.0;
+}
+
+int PerfCounterSnapshot::toArray(float *values, const PerfCounterSnapshot &previous) const
+{
+    switch (type) {
+    case Type::Counter:
+        values[0] = count;
+        values[1] = getRate_Hz(previous);
+        return 2;
+    case Type::Gauge:
+        values[0] = gauge;
+        return 1;
+    case Type::Latency: {
+        const PerfCounterSnapshot interval = since(previous);
+        values[0] = interval.count;
+        values[1] = interval.getMeanLatency_us();
+        values[2] = interval.getLatencyPercentile_us(50.0);
+        values[3] = interval.getLatencyPercentile_us(99.0);
+        values[4] = latencyMax_ns / 1000.0;
+        return 5;
+    }
+    }
+    return 0;
+}
+
+PerfCounters &PerfCounters::getInstance()
+{
+    static PerfCounters instance;
+    return instance;
+}
+
+int PerfCounters::registerCounter(const QString &name, Type type)
+{
+    const QString counterName = name.left(MAX_NAME_LENGTH);
+    std::lock_guard<std::mutex> lock(mRegistrationMutex);
+
+    const int numCounters = mNumCounters.load(std::memory_order_relaxed);
+    for (int id = 0; id < numCounters; id++)
+        if (mCounters[id].name == counterName) {
+            if (mCounters[id].type != type)
+                qDebug() << "Warning: PerfCounters:" << counterName << "is already registered with another type";
+            return id;
+        }
+
+    if (numCounters >= MAX_COUNTERS) {
+        qDebug() << "Warning: PerfCounters cannot register more than" << MAX_COUNTERS << "counters, ignoring" << counterName;
+        return -1;
+    }
+
+    mCounters[numCounters].name = counterName;
+    mCounters[numCounters].type = type;
+    mNumCounters.store(numCounters + 1, std::memory_order_release);
+    return numCounters;
+}
+
+void PerfCounters::recordLatency_ns(int id, qint64 latency_ns)
+{
+    if (!isValid(id))
+        return;
+
+    Counter &counter = mCounters[id];
+    const quint64 sample_ns = quint64(std::max<qint64>(latency_ns, 0));
+    counter.count.fetch_add(1, std::memory_order_relaxed);
+    counter.latencySum_ns.fetch_add(sample_ns, std::memory_order_relaxed);
+
+    quint64 max_ns = counter.latencyMax_ns.load(std::memory_order_relaxed);
+    while (sample_ns > max_ns && !counter.latencyMax_ns.compare_exchange_weak(max_ns, sample_ns, std::memory_order_relaxed));
+
+    const quint64 sample_us = sample_ns / 1000;
+    const int bucket = sample_us > 1 ? std::min<int>(63 - __builtin_clzll(sample_us), PerfCounterSnapshot::NUM_BUCKETS - 1) : 0;
+    counter.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+PerfCounterSnapshot PerfCounters::getSnapshot(int id) const
+{
+    PerfCounterSnapshot snapshot;
+    if (!isValid(id))
+        return snapshot;
+
+    const Counter &counter = mCounters[id];
+    snapshot.name = counter.name;
+    snapshot.type = counter.type;
+    snapshot.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    snapshot.count = counter.count.load(std::memory_order_relaxed);
+    snapshot.gauge = counter.gauge.load(std::memory_order_relaxed);
+    snapshot.latencySum_ns = counter.latencySum_ns.load(std::memory_order_relaxed);
+    snapshot.latencyMax_ns = counter.latencyMax_ns.load(std::memory_order_relaxed);
+    for (int i = 0; i < PerfCounterSnapshot::NUM_BUCKETS; i++)
+        snapshot.buckets[i] = counter.buckets[i].load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+QVector<PerfCounterSnapshot> PerfCounters::getSnapshots() const
+{
+    QVector<PerfCounterSnapshot> snapshots;
+    const int numCounters = getNumCounters();
+    snapshots.reserve(numCounters);
+    for (int id = 0; id < numCounters; id++)
+        snapshots.append(getSnapshot(id));
+    return snapshots;
+}
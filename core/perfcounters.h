@@ -0,0 +1,112 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Process-wide registry of named performance counters: event counters, gauges and latency histograms.
+ * Registration takes a lock and is meant to be done once (e.g., into a function-local static), updates are a few
+ * relaxed atomic operations, i.e., they can be done from any thread in hot paths. Latencies are counted in
+ * power-of-two buckets of microseconds, percentiles are approximated from them.
+ * Snapshots hold the raw totals, the difference of two snapshots gives the statistics of the time in between.
+ * MavsdkVehicleServer publishes the counters as DEBUG_FLOAT_ARRAY (see PerfCounterSnapshot::toArray), shown by PerfCountersUI.
+ *
+ *     static const int latencyId = PerfCounters::getInstance().registerCounter("PP_UPDATE", PerfCounters::Type::Latency);
+ *     PerfCounters::ScopedLatency latency(latencyId);
+ */
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+struct PerfCounterSnapshot {
+    static constexpr int NUM_BUCKETS = 24; // bucket i: [2^i, 2^(i + 1)) us (bucket 0 from 0), the last one is open
+    static constexpr int MAX_ARRAY_SIZE = 5;
+    enum class Type : uint8_t {Counter, Gauge, Latency};
+
+    QString name;
+    Type type = Type::Counter;
+    qint64 timestamp_ns = 0; // steady clock
+    quint64 count = 0; // events or latency samples
+    double gauge = 0.0;
+    quint64 latencySum_ns = 0;
+    quint64 latencyMax_ns = 0; // since registration, also in differences
+    std::array<quint64, NUM_BUCKETS> buckets {};
+
+    // Statistics of the time between previous and this snapshot (of the same counter)
+    PerfCounterSnapshot since(const PerfCounterSnapshot &previous) const;
+    double getRate_Hz(const PerfCounterSnapshot &previous) const;
+    double getMeanLatency_us() const { return count > 0 ? latencySum_ns / 1000.0 / count : 0.0; }
+    double getLatencyPercentile_us(double percentile) const; // upper bound of the bucket, percentile: 0 - 100
+
+    // Counter: total, rate [Hz]; gauge: value; latency: samples, mean, p50, p99, max [us]
+    int toArray(float *values, const PerfCounterSnapshot &previous) const;
+    static int getArraySize(Type type) { return type == Type::Counter ? 2 : (type == Type::Gauge ? 1 : MAX_ARRAY_SIZE); }
+};
+
+class PerfCounters
+{
+public:
+    using Type = PerfCounterSnapshot::Type;
+    static constexpr int MAX_COUNTERS = 64;
+    static constexpr int MAX_NAME_LENGTH = 10; // MAVLink DEBUG_FLOAT_ARRAY name
+
+    static PerfCounters &getInstance();
+
+    // Names are cut to MAX_NAME_LENGTH, registering an existing name returns its ID, -1 if MAX_COUNTERS are registered
+    int registerCounter(const QString &name, Type type);
+    int getNumCounters() const { return mNumCounters.load(std::memory_order_acquire); }
+
+    void add(int id, quint64 events = 1) {
+        if (isValid(id))
+            mCounters[id].count.fetch_add(events, std::memory_order_relaxed);
+    }
+    void setGauge(int id, double value) {
+        if (isValid(id)) {
+            mCounters[id].gauge.store(value, std::memory_order_relaxed);
+            mCounters[id].count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void recordLatency_ns(int id, qint64 latency_ns);
+
+    PerfCounterSnapshot getSnapshot(int id) const;
+    QVector<PerfCounterSnapshot> getSnapshots() const;
+
+    // Records the latency from construction to destruction
+    class ScopedLatency {
+    public:
+        explicit ScopedLatency(int id) : mId(id), mStart(std::chrono::steady_clock::now()) {}
+        ~ScopedLatency() {
+            PerfCounters::getInstance().recordLatency_ns(mId, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count());
+        }
+        ScopedLatency(const ScopedLatency &) = delete;
+        ScopedLatency &operator=(const ScopedLatency &) = delete;
+    private:
+        int mId;
+        std::chrono::steady_clock::time_point mStart;
+    };
+
+private:
+    struct Counter {
+        QString name; // written once before the counter is published by mNumCounters
+        Type type = Type::Counter;
+        std::atomic<quint64> count{0};
+        std::atomic<double> gauge{0.0};
+        std::atomic<quint64> latencySum_ns{0};
+        std::atomic<quint64> latencyMax_ns{0};
+        std::array<std::atomic<quint64>, PerfCounterSnapshot::NUM_BUCKETS> buckets {};
+    };
+
+    PerfCounters() = default;
+    bool isValid(int id) const { return id >= 0 && id < mNumCounters.load(std::memory_order_acquire); }
+
+    std::array<Counter, MAX_COUNTERS> mCounters;
+    std::atomic<int> mNumCounters{0};
+    std::mutex mRegistrationMutex;
+};
+
+#endif // PERFCOUNTERS_H
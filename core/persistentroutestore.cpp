@@ -0,0 +1,193 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "persistentroutestore.h"
+#include "core/routecodec.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+constexpr char STORE_MAGIC[] = {'W', 'R', 'S', '1'};
+constexpr quint32 STORE_VERSION = 1;
+const QString FILE_SUFFIX = QStringLiteral(".wrs");
+
+// Host byte order, files are not meant to be moved between machines (the encoded route is portable)
+struct StoredRouteHeader {
+    char magic[4];
+    quint32 version;
+    quint64 hash;
+    quint32 pointSize;
+    quint32 pointCount;
+    quint32 encodedSize;
+    quint32 reserved;
+};
+static_assert(sizeof(StoredRouteHeader) == 32, "points are expected to start 8-byte aligned");
+static_assert(std::is_trivially_copyable<pospoint_t>::value, "points are stored as raw memory");
+}
+
+struct PersistentRouteStore::MappedRoute {
+    QFile file;
+    const uchar *data = nullptr;
+    StoredRouteHeader header;
+
+    ~MappedRoute() {
+        if (data != nullptr)
+            file.unmap(const_cast<uchar*>(data));
+    }
+
+    const uchar *getPoints() const { return data + sizeof(StoredRouteHeader); }
+    const uchar *getEncodedRoute() const { return getPoints() + qint64(header.pointCount) * header.pointSize; }
+};
+
+PersistentRouteStore::PersistentRouteStore(const QString &directory) : mDirectory(directory)
+{
+    QDir dir(directory);
+    if (!dir.mkpath(".")) {
+        qDebug() << "Warning: PersistentRouteStore could not create" << directory;
+        return;
+    }
+
+    // Oldest first
+    for (const QFileInfo &fileInfo : dir.entryInfoList({"*" + FILE_SUFFIX}, QDir::Files, QDir::Time | QDir::Reversed)) {
+        bool ok;
+        const quint64 hash = fileInfo.completeBaseName().toULongLong(&ok, 16);
+        if (ok && hash != 0)
+            mStoredRoutes.append(hash);
+    }
+}
+
+quint64 PersistentRouteStore::storeRoute(const QByteArray &encodedRoute)
+{
+    const quint64 hash = routeCodec::getRouteHash(encodedRoute);
+    if (contains(hash)) {
+        markUsed(hash);
+        return hash;
+    }
+
+    QVector<pospoint_t> route;
+    if (!routeCodec::decodeRoute(encodedRoute, route))
+        return 0;
+
+    StoredRouteHeader header;
+    memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    header.version = STORE_VERSION;
+    header.hash = hash;
+    header.pointSize = sizeof(pospoint_t);
+    header.pointCount = route.size();
+    header.encodedSize = encodedRoute.size();
+    header.reserved = 0;
+
+    QSaveFile file(getFilePath(hash));
+    if (!file.open(QIODevice::WriteOnly) ||
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+            file.write(reinterpret_cast<const char*>(route.constData()), qint64(route.size()) * sizeof(pospoint_t)) != qint64(route.size()) * qint64(sizeof(pospoint_t)) ||
+            file.write(encodedRoute) != encodedRoute.size() || !file.commit()) {
+        qDebug() << "Warning: PersistentRouteStore could not write" << file.fileName() << ":" << file.errorString();
+        return 0;
+    }
+
+    mStoredRoutes.append(hash);
+    removeOldRoutes();
+    return hash;
+}
+
+bool PersistentRouteStore::contains(quint64 hash) const
+{
+    return hash != 0 && mStoredRoutes.contains(hash);
+}
+
+bool PersistentRouteStore::loadRoute(quint64 hash, QVector<pospoint_t> &route)
+{
+    route.clear();
+    MappedRoute mappedRoute;
+    if (!mapRoute(hash, mappedRoute))
+        return false;
+
+    if (mappedRoute.header.pointSize == sizeof(pospoint_t)) {
+        route.resize(mappedRoute.header.pointCount);
+        memcpy(static_cast<void*>(route.data()), mappedRoute.getPoints(), qint64(route.size()) * sizeof(pospoint_t));
+    } else if (!routeCodec::decodeRoute(QByteArray::fromRawData(reinterpret_cast<const char*>(mappedRoute.getEncodedRoute()), mappedRoute.header.encodedSize), route)) {
+        return false;
+    }
+
+    markUsed(hash);
+    return true;
+}
+
+QByteArray PersistentRouteStore::loadEncodedRoute(quint64 hash) const
+{
+    MappedRoute mappedRoute;
+    if (!mapRoute(hash, mappedRoute))
+        return QByteArray();
+    return QByteArray(reinterpret_cast<const char*>(mappedRoute.getEncodedRoute()), mappedRoute.header.encodedSize); // deep copy, unmapped below
+}
+
+void PersistentRouteStore::removeRoute(quint64 hash)
+{
+    if (!mStoredRoutes.removeOne(hash))
+        return;
+    QFile::remove(getFilePath(hash));
+}
+
+QVector<quint64> PersistentRouteStore::getStoredRoutes() const
+{
+    return mStoredRoutes;
+}
+
+void PersistentRouteStore::setMaxRoutes(int maxRoutes)
+{
+    mMaxRoutes = std::max(maxRoutes, 1);
+    removeOldRoutes();
+}
+
+bool PersistentRouteStore::mapRoute(quint64 hash, MappedRoute &mappedRoute) const
+{
+    if (!contains(hash))
+        return false;
+
+    mappedRoute.file.setFileName(getFilePath(hash));
+    const qint64 fileSize = mappedRoute.file.size();
+    if (fileSize < qint64(sizeof(StoredRouteHeader)) || !mappedRoute.file.open(QIODevice::ReadOnly))
+        return false;
+    mappedRoute.data = mappedRoute.file.map(0, fileSize);
+    if (mappedRoute.data == nullptr)
+        return false;
+
+    const StoredRouteHeader &header = mappedRoute.header;
+    memcpy(&mappedRoute.header, mappedRoute.data, sizeof(StoredRouteHeader));
+    if (memcmp(header.magic, STORE_MAGIC, sizeof(header.magic)) != 0 || header.version != STORE_VERSION || header.hash != hash ||
+            qint64(sizeof(StoredRouteHeader)) + qint64(header.pointCount) * header.pointSize + header.encodedSize != fileSize) {
+        qDebug() << "Warning: PersistentRouteStore found corrupt file" << mappedRoute.file.fileName();
+        return false;
+    }
+    return true;
+}
+
+void PersistentRouteStore::markUsed(quint64 hash)
+{
+    if (mStoredRoutes.removeOne(hash))
+        mStoredRoutes.append(hash);
+
+    // Keeps the order across restarts
+    QFile file(getFilePath(hash));
+    if (file.open(QIODevice::ReadWrite))
+        file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+}
+
+QString PersistentRouteStore::getFilePath(quint64 hash) const
+{
+    return QDir(mDirectory).filePath(QString("%1%2").arg(hash, 16, 16, QChar('0')).arg(FILE_SUFFIX));
+}
+
+void PersistentRouteStore::removeOldRoutes()
+{
+    while (mStoredRoutes.size() > mMaxRoutes)
+        removeRoute(mStoredRoutes.first());
+}
@@ -0,0 +1,55 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Persistent store for routes received by a vehicle, one file per route named by its hash (see routeCodec::getRouteHash),
+ * so that a control station can ask whether a route is already known instead of uploading it again
+ * (in contrast to RouteStore, which holds alternative routes of MultiWaypointFollower in memory).
+ * The file holds the decoded pospoint_t array next to the encoded route: loading maps the file and copies the points
+ * without decoding (the encoded route is used if the file was written by a build with another pospoint_t layout).
+ * Files are written atomically (QSaveFile), the least recently used routes are removed beyond getMaxRoutes().
+ *
+ * File: header (magic "WRS1", version, hash, sizeof(pospoint_t), point count, encoded size) | points | encoded route
+ * Not thread-safe.
+ */
+
+#ifndef PERSISTENTROUTESTORE_H
+#define PERSISTENTROUTESTORE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include "core/pospoint.h"
+
+class PersistentRouteStore
+{
+public:
+    static constexpr int DEFAULT_MAX_ROUTES = 32;
+
+    explicit PersistentRouteStore(const QString &directory);
+
+    // Returns the route's hash, 0 if it could not be stored
+    quint64 storeRoute(const QByteArray &encodedRoute);
+    bool contains(quint64 hash) const;
+    bool loadRoute(quint64 hash, QVector<pospoint_t> &route); // false (and an empty route) if missing or corrupt
+    QByteArray loadEncodedRoute(quint64 hash) const; // empty if missing or corrupt
+    void removeRoute(quint64 hash);
+    QVector<quint64> getStoredRoutes() const; // least recently stored or loaded first
+
+    void setMaxRoutes(int maxRoutes);
+    int getMaxRoutes() const { return mMaxRoutes; }
+    QString getDirectory() const { return mDirectory; }
+
+private:
+    struct MappedRoute;
+    bool mapRoute(quint64 hash, MappedRoute &mappedRoute) const;
+    void markUsed(quint64 hash);
+    QString getFilePath(quint64 hash) const;
+    void removeOldRoutes();
+
+    QString mDirectory;
+    int mMaxRoutes = DEFAULT_MAX_ROUTES;
+    QVector<quint64> mStoredRoutes; // least recently used first
+};
+
+#endif // PERSISTENTROUTESTORE_H
@@ -9,16 +9,61 @@
 PosPoint::PosPoint(double x, double y, double height, double roll, double pitch, double yaw, double speed,
                    double radius, double sigma, QTime time, int id, bool drawLine, quint32 attributes, PosType type) :
     mX(x), mY(y), mHeight(height), mRoll(roll), mPitch(pitch), mYaw(yaw), mSpeed(speed),
-    mRadius(radius), mSigma(sigma), mTime(time), mId(id), mDrawLine(drawLine),
+    mRadius(radius), mSigma(sigma), mTimestamp_ns(utcTime::fromTimeOfDay(time)), mId(id), mDrawLine(drawLine),
     mAttributes(attributes), mType(type)
 {
 }
 
-PosPoint::PosPoint(const PosPoint &point) : QObject()
+PosPoint::PosPoint(const PosPoint &point)
 {
     *this = point;
 }
 
+PosPoint::PosPoint(const pospoint_t &point) :
+    mX(point.x), mY(point.y), mHeight(point.height), mRoll(point.roll), mPitch(point.pitch), mYaw(point.yaw), mSpeed(point.speed),
+    mRadius(point.radius), mSigma(point.sigma), mTimestamp_ns(point.timestamp_ns), mId(point.id), mDrawLine(point.drawLine),
+    mAttributes(point.attributes), mType(point.type)
+{
+}
+
+pospoint_t PosPoint::toPOD() const
+{
+    pospoint_t point;
+    point.x = mX;
+    point.y = mY;
+    point.height = mHeight;
+    point.roll = mRoll;
+    point.pitch = mPitch;
+    point.yaw = mYaw;
+    point.speed = mSpeed;
+    point.radius = mRadius;
+    point.sigma = mSigma;
+    point.timestamp_ns = mTimestamp_ns;
+    point.id = mId;
+    point.attributes = mAttributes;
+    point.type = mType;
+    point.drawLine = mDrawLine;
+    return point;
+}
+
+QVector<pospoint_t> PosPoint::toPODList(const QList<PosPoint> &points)
+{
+    QVector<pospoint_t> podPoints;
+    podPoints.reserve(points.size());
+    for (const auto &point : points)
+        podPoints.append(point.toPOD());
+    return podPoints;
+}
+
+QList<PosPoint> PosPoint::fromPODList(const QVector<pospoint_t> &points)
+{
+    QList<PosPoint> posPoints;
+    posPoints.reserve(points.size());
+    for (const auto &point : points)
+        posPoints.append(PosPoint(point));
+    return posPoints;
+}
+
 double PosPoint::getX() const
 {
     return mX;
@@ -109,7 +154,12 @@ void PosPoint::setXYZ(xyz_t xyz)
 
 void PosPoint::setTime(const QTime &time)
 {
-    mTime = time;
+    mTimestamp_ns = utcTime::fromTimeOfDay(time);
+}
+
+void PosPoint::setTimestamp_ns(qint64 timestamp_ns)
+{
+    mTimestamp_ns = timestamp_ns;
 }
 
 void PosPoint::setId(int id)
@@ -124,7 +174,12 @@ QString PosPoint::getInfo() const
 
 QTime PosPoint::getTime() const
 {
-    return mTime;
+    return utcTime::toTimeOfDay(mTimestamp_ns);
+}
+
+qint64 PosPoint::getTimestamp_ns() const
+{
+    return mTimestamp_ns;
 }
 
 int PosPoint::getId() const
@@ -144,7 +199,7 @@ PosPoint &PosPoint::operator =(const PosPoint &point)
     mRadius = point.mRadius;
     mSigma = point.mSigma;
     mInfo = point.mInfo;
-    mTime = point.mTime;
+    mTimestamp_ns = point.mTimestamp_ns;
     mId = point.mId;
     mDrawLine = point.mDrawLine;
     mAttributes = point.mAttributes;
@@ -187,7 +242,7 @@ bool PosPoint::operator ==(const PosPoint &point)
             mRadius == point.mRadius &&
             mSigma == point.mSigma &&
             mInfo == point.mInfo &&
-            mTime == point.mTime &&
+            mTimestamp_ns == point.mTimestamp_ns &&
             mId == point.mId &&
             mDrawLine == point.mDrawLine &&
             mAttributes == point.mAttributes) {
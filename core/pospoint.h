@@ -9,6 +9,8 @@
 #include <QPointF>
 #include <QString>
 #include <QTime>
+#include <QVector>
+#include <type_traits>
 
 enum class PosType {
     simulated,
@@ -21,10 +23,46 @@ enum class PosType {
     defaultPosType = simulated
 };
 #include "coordinatetransforms.h"
+#include "utctime.h"
 
-class PosPoint : public QObject
+// Solution of PosType::GNSS positions, stored as their attributes (Unknown: not reported by the source)
+enum class GnssFixType : quint8 {
+    Unknown,
+    NoFix,
+    DeadReckoning,
+    Fix2D,
+    Fix3D,
+    RtkFloat,
+    RtkFixed,
+    _LAST_
+};
+
+// Trivially copyable counterpart of PosPoint for storing (long) routes and traces in contiguous memory.
+// Omits PosPoint's info string, time is stored as UTC ns since epoch (see utcTime, -1: invalid).
+struct pospoint_t {
+    double x = 0.0;
+    double y = 0.0;
+    double height = 0.0;
+    double roll = 0.0;
+    double pitch = 0.0;
+    double yaw = 0.0;
+    double speed = 0.5;
+    double radius = 5.0;
+    double sigma = 0.0;
+    qint64 timestamp_ns = utcTime::INVALID;
+    int id = 0;
+    quint32 attributes = 0;
+    PosType type = PosType::simulated;
+    bool drawLine = true;
+
+    QPointF getPoint() const { return QPointF(x, y); }
+    QPointF getPointMm() const { return QPointF(x * 1000.0, y * 1000.0); }
+    double getDistanceTo(const pospoint_t &point) const { return sqrt((point.x - x)*(point.x - x) + (point.y - y)*(point.y - y)); }
+};
+Q_DECLARE_TYPEINFO(pospoint_t, Q_PRIMITIVE_TYPE);
+
+class PosPoint
 {
-    Q_OBJECT
 public:
 
     PosPoint(double x = 0, double y = 0, double height = 0, double roll = 0,
@@ -32,6 +70,11 @@ public:
              double sigma = 0.0, QTime time = QTime(),
              int id = 0, bool drawLine = true, quint32 attributes = 0, PosType type = PosType::simulated);
     PosPoint(const PosPoint &point);
+    PosPoint(const pospoint_t &point);
+
+    pospoint_t toPOD() const;
+    static QVector<pospoint_t> toPODList(const QList<PosPoint> &points);
+    static QList<PosPoint> fromPODList(const QVector<pospoint_t> &points);
 
     PosType getType() const;
     double getX() const;
@@ -48,7 +91,8 @@ public:
     double getSigma() const;
     QString getInfo() const;
     QColor getColor() const;
-    QTime getTime() const;
+    QTime getTime() const; // UTC time of day of the timestamp
+    qint64 getTimestamp_ns() const;
     int getId() const;
     bool getDrawLine() const;
     quint32 getAttributes() const;
@@ -71,7 +115,8 @@ public:
     void setSigma(double sigma);
     void setInfo(const QString &info);
     void setColor(const QColor &color);
-    void setTime(const QTime &time);
+    void setTime(const QTime &time); // see utcTime::fromTimeOfDay, use setTimestamp_ns for sensor data
+    void setTimestamp_ns(qint64 timestamp_ns);
     void setId(int id);
     void setDrawLine(bool drawLine);
     void setAttributes(quint32 attributes);
@@ -94,7 +139,7 @@ private:
     double mRadius;
     double mSigma;
     QString mInfo;
-    QTime mTime;
+    qint64 mTimestamp_ns; // UTC [ns], see utcTime
     int mId;
     bool mDrawLine;
     quint32 mAttributes;
@@ -102,4 +147,6 @@ private:
 
 };
 
+static_assert(std::is_trivially_copyable<pospoint_t>::value, "pospoint_t needs to stay trivially copyable");
+
 #endif // POSPOINT_H
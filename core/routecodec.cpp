@@ -0,0 +1,410 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routecodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace routeCodec {
+
+namespace {
+constexpr char ROUTE_MAGIC[] = {'W', 'R'};
+constexpr char ROUTE_FILE_MAGIC[] = {'W', 'R', 'F'};
+constexpr char ROUTE_PATCH_MAGIC[] = {'W', 'R', 'P'};
+constexpr uint8_t VERSION = 1;
+constexpr uint8_t FLAG_TIMESTAMPS = 0x01;
+
+void writeVarint(QByteArray &data, quint64 value)
+{
+    while (value >= 0x80) {
+        data.append(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.append(char(value));
+}
+
+void writeSignedVarint(QByteArray &data, qint64 value)
+{
+    writeVarint(data, (quint64(value) << 1) ^ quint64(value >> 63)); // zigzag: small magnitudes -> few bytes
+}
+
+void writeUint64(QByteArray &data, quint64 value)
+{
+    for (int i = 0; i < 8; i++)
+        data.append(char((value >> (8 * i)) & 0xFF));
+}
+
+void writeDouble(QByteArray &data, double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    writeUint64(data, bits);
+}
+
+// Round to fixed point, i.e., mm for [m]
+qint64 quantize(double value, double scale)
+{
+    return std::llround(value * scale);
+}
+
+class Reader
+{
+public:
+    Reader(const QByteArray &data) : mData(reinterpret_cast<const uint8_t*>(data.constData())), mSize(data.size()) {}
+
+    bool atEnd() const { return mPos == mSize; }
+    int remaining() const { return mSize - mPos; }
+
+    bool readMagic(const char *magic, int size) {
+        if (remaining() < size || memcmp(mData + mPos, magic, size) != 0)
+            return false;
+        mPos += size;
+        return true;
+    }
+
+    bool readByte(uint8_t &value) {
+        if (atEnd())
+            return false;
+        value = mData[mPos++];
+        return true;
+    }
+
+    bool readVarint(quint64 &value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && mPos < mSize; shift += 7) {
+            const uint8_t byte = mData[mPos++];
+            value |= quint64(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    bool readSignedVarint(qint64 &value) {
+        quint64 zigzag;
+        if (!readVarint(zigzag))
+            return false;
+        value = qint64(zigzag >> 1) ^ -qint64(zigzag & 1);
+        return true;
+    }
+
+    bool readUint64(quint64 &value) {
+        if (remaining() < 8)
+            return false;
+        value = 0;
+        for (int i = 0; i < 8; i++)
+            value |= quint64(mData[mPos++]) << (8 * i);
+        return true;
+    }
+
+    bool readDouble(double &value) {
+        quint64 bits;
+        if (!readUint64(bits))
+            return false;
+        memcpy(&value, &bits, sizeof(value));
+        return true;
+    }
+
+    bool readBytes(int size, QByteArray &bytes) {
+        if (size < 0 || remaining() < size)
+            return false;
+        bytes = QByteArray(reinterpret_cast<const char*>(mData + mPos), size);
+        mPos += size;
+        return true;
+    }
+
+private:
+    const uint8_t *mData;
+    int mSize;
+    int mPos = 0;
+};
+
+template<typename GetValue>
+void writeDeltaColumn(QByteArray &data, const QVector<pospoint_t> &route, GetValue getValue)
+{
+    qint64 last = 0;
+    for (const pospoint_t &point : route) {
+        const qint64 value = getValue(point);
+        writeSignedVarint(data, value - last);
+        last = value;
+    }
+}
+
+template<typename SetValue>
+bool readDeltaColumn(Reader &reader, QVector<pospoint_t> &route, SetValue setValue)
+{
+    qint64 value = 0;
+    for (pospoint_t &point : route) {
+        qint64 delta;
+        if (!reader.readSignedVarint(delta))
+            return false;
+        value += delta;
+        setValue(point, value);
+    }
+    return true;
+}
+
+// Runs of equal values: length (varint) | value delta to previous run (zigzag varint) or value (varint)
+template<typename GetValue>
+void writeRunColumn(QByteArray &data, const QVector<pospoint_t> &route, GetValue getValue, bool deltaEncoded)
+{
+    qint64 lastRunValue = 0;
+    for (int i = 0; i < route.size();) {
+        const qint64 value = getValue(route.at(i));
+        int runLength = 1;
+        while (i + runLength < route.size() && getValue(route.at(i + runLength)) == value)
+            runLength++;
+
+        writeVarint(data, runLength);
+        if (deltaEncoded)
+            writeSignedVarint(data, value - lastRunValue);
+        else
+            writeVarint(data, quint64(value));
+        lastRunValue = value;
+        i += runLength;
+    }
+}
+
+template<typename SetValue>
+bool readRunColumn(Reader &reader, QVector<pospoint_t> &route, SetValue setValue, bool deltaEncoded)
+{
+    qint64 runValue = 0;
+    for (int i = 0; i < route.size();) {
+        quint64 runLength;
+        if (!reader.readVarint(runLength) || runLength == 0 || runLength > quint64(route.size() - i))
+            return false;
+
+        if (deltaEncoded) {
+            qint64 delta;
+            if (!reader.readSignedVarint(delta))
+                return false;
+            runValue += delta;
+        } else {
+            quint64 value;
+            if (!reader.readVarint(value))
+                return false;
+            runValue = qint64(value);
+        }
+
+        for (quint64 j = 0; j < runLength; j++)
+            setValue(route[i++], runValue);
+    }
+    return true;
+}
+
+bool decodeRoute(Reader &reader, QVector<pospoint_t> &route)
+{
+    route.clear();
+    uint8_t version, flags;
+    quint64 count;
+    if (!reader.readMagic(ROUTE_MAGIC, sizeof(ROUTE_MAGIC)) || !reader.readByte(version) || version != VERSION ||
+            !reader.readByte(flags) || !reader.readVarint(count) || count > quint64(reader.remaining())) // at least a byte per point
+        return false;
+
+    route.resize(count);
+    const bool ok = readDeltaColumn(reader, route, [](pospoint_t &point, qint64 value) { point.x = value / 1000.0; }) &&
+            readDeltaColumn(reader, route, [](pospoint_t &point, qint64 value) { point.y = value / 1000.0; }) &&
+            readDeltaColumn(reader, route, [](pospoint_t &point, qint64 value) { point.height = value / 1000.0; }) &&
+            readRunColumn(reader, route, [](pospoint_t &point, qint64 value) { point.speed = value / 1000.0; }, true) &&
+            readRunColumn(reader, route, [](pospoint_t &point, qint64 value) { point.attributes = quint32(value); }, false) &&
+            (!(flags & FLAG_TIMESTAMPS) ||
+             readDeltaColumn(reader, route, [](pospoint_t &point, qint64 value) { point.timestamp_ns = (value < 0) ? utcTime::INVALID : value * utcTime::NS_PER_MS; }));
+
+    if (!ok)
+        route.clear();
+    return ok;
+}
+}
+
+QByteArray encodeRoute(const QVector<pospoint_t> &route)
+{
+    const bool hasTimestamps = std::any_of(route.begin(), route.end(), [](const pospoint_t &point) { return utcTime::isValid(point.timestamp_ns); });
+
+    QByteArray encodedRoute;
+    encodedRoute.reserve(16 + route.size() * (hasTimestamps ? 8 : 5));
+    encodedRoute.append(ROUTE_MAGIC, sizeof(ROUTE_MAGIC));
+    encodedRoute.append(char(VERSION));
+    encodedRoute.append(char(hasTimestamps ? FLAG_TIMESTAMPS : 0));
+    writeVarint(encodedRoute, route.size());
+
+    writeDeltaColumn(encodedRoute, route, [](const pospoint_t &point) { return quantize(point.x, 1000.0); });
+    writeDeltaColumn(encodedRoute, route, [](const pospoint_t &point) { return quantize(point.y, 1000.0); });
+    writeDeltaColumn(encodedRoute, route, [](const pospoint_t &point) { return quantize(point.height, 1000.0); });
+    writeRunColumn(encodedRoute, route, [](const pospoint_t &point) { return quantize(point.speed, 1000.0); }, true);
+    writeRunColumn(encodedRoute, route, [](const pospoint_t &point) { return qint64(point.attributes); }, false);
+    if (hasTimestamps)
+        writeDeltaColumn(encodedRoute, route, [](const pospoint_t &point) {
+            return utcTime::isValid(point.timestamp_ns) ? point.timestamp_ns / utcTime::NS_PER_MS : qint64(-1);
+        });
+
+    return encodedRoute;
+}
+
+QByteArray encodeRoute(const QList<PosPoint> &route)
+{
+    return encodeRoute(PosPoint::toPODList(route));
+}
+
+bool decodeRoute(const QByteArray &encodedRoute, QVector<pospoint_t> &route)
+{
+    Reader reader(encodedRoute);
+    if (!decodeRoute(reader, route) || !reader.atEnd()) {
+        route.clear();
+        return false;
+    }
+    return true;
+}
+
+bool decodeRoute(const QByteArray &encodedRoute, QList<PosPoint> &route)
+{
+    QVector<pospoint_t> podRoute;
+    const bool ok = decodeRoute(encodedRoute, podRoute);
+    route = PosPoint::fromPODList(podRoute);
+    return ok;
+}
+
+QByteArray encodeRouteFile(const QList<QVector<pospoint_t>> &routes, const llh_t &enuRef)
+{
+    QByteArray routeFile;
+    routeFile.append(ROUTE_FILE_MAGIC, sizeof(ROUTE_FILE_MAGIC));
+    routeFile.append(char(VERSION));
+    writeDouble(routeFile, enuRef.latitude);
+    writeDouble(routeFile, enuRef.longitude);
+    writeDouble(routeFile, enuRef.height);
+    writeVarint(routeFile, routes.size());
+
+    for (const QVector<pospoint_t> &route : routes) {
+        const QByteArray encodedRoute = encodeRoute(route);
+        writeVarint(routeFile, encodedRoute.size());
+        routeFile.append(encodedRoute);
+    }
+    return routeFile;
+}
+
+bool decodeRouteFile(const QByteArray &routeFile, QList<QVector<pospoint_t>> &routes, llh_t &enuRef)
+{
+    routes.clear();
+    Reader reader(routeFile);
+    uint8_t version;
+    quint64 routeCount;
+    if (!reader.readMagic(ROUTE_FILE_MAGIC, sizeof(ROUTE_FILE_MAGIC)) || !reader.readByte(version) || version != VERSION ||
+            !reader.readDouble(enuRef.latitude) || !reader.readDouble(enuRef.longitude) || !reader.readDouble(enuRef.height) ||
+            !reader.readVarint(routeCount) || routeCount > quint64(reader.remaining()))
+        return false;
+
+    routes.reserve(routeCount);
+    for (quint64 i = 0; i < routeCount; i++) {
+        quint64 size;
+        QByteArray encodedRoute;
+        QVector<pospoint_t> route;
+        if (!reader.readVarint(size) || size > quint64(reader.remaining()) || !reader.readBytes(int(size), encodedRoute) ||
+                !decodeRoute(encodedRoute, route)) {
+            routes.clear();
+            return false;
+        }
+        routes.append(route);
+    }
+    return reader.atEnd();
+}
+
+bool isRouteFile(const QByteArray &data)
+{
+    return data.startsWith(QByteArray(ROUTE_FILE_MAGIC, sizeof(ROUTE_FILE_MAGIC)));
+}
+
+quint64 getRouteHash(const QByteArray &encodedRoute)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+    for (char byte : encodedRoute) {
+        hash ^= uint8_t(byte);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+QVector<quint64> getChunkHashes(const QVector<pospoint_t> &route, int chunkSize)
+{
+    QVector<quint64> chunkHashes;
+    chunkSize = std::max(chunkSize, 1);
+    chunkHashes.reserve((route.size() + chunkSize - 1) / chunkSize);
+    for (int first = 0; first < route.size(); first += chunkSize)
+        chunkHashes.append(getRouteHash(encodeRoute(route.mid(first, chunkSize))));
+    return chunkHashes;
+}
+
+QByteArray encodeRoutePatch(const QVector<pospoint_t> &baseRoute, const QVector<pospoint_t> &route, int chunkSize)
+{
+    chunkSize = std::max(chunkSize, 1);
+    const QVector<quint64> baseChunkHashes = getChunkHashes(baseRoute, chunkSize);
+
+    QByteArray changedChunks;
+    quint64 changedChunkCount = 0;
+    for (int first = 0, chunkIndex = 0; first < route.size(); first += chunkSize, chunkIndex++) {
+        const QByteArray encodedChunk = encodeRoute(route.mid(first, chunkSize));
+        if (chunkIndex < baseChunkHashes.size() && getRouteHash(encodedChunk) == baseChunkHashes.at(chunkIndex))
+            continue;
+        writeVarint(changedChunks, chunkIndex);
+        writeVarint(changedChunks, encodedChunk.size());
+        changedChunks.append(encodedChunk);
+        changedChunkCount++;
+    }
+
+    QByteArray routePatch;
+    routePatch.reserve(32 + changedChunks.size());
+    routePatch.append(ROUTE_PATCH_MAGIC, sizeof(ROUTE_PATCH_MAGIC));
+    routePatch.append(char(VERSION));
+    writeUint64(routePatch, getRouteHash(encodeRoute(baseRoute)));
+    writeUint64(routePatch, getRouteHash(encodeRoute(route)));
+    writeVarint(routePatch, chunkSize);
+    writeVarint(routePatch, route.size());
+    writeVarint(routePatch, changedChunkCount);
+    routePatch.append(changedChunks);
+    return routePatch;
+}
+
+bool applyRoutePatch(const QByteArray &routePatch, QVector<pospoint_t> &route, int &firstChangedIndex)
+{
+    Reader reader(routePatch);
+    uint8_t version;
+    quint64 baseHash, resultHash, chunkSize, pointCount, changedChunkCount;
+    if (!reader.readMagic(ROUTE_PATCH_MAGIC, sizeof(ROUTE_PATCH_MAGIC)) || !reader.readByte(version) || version != VERSION ||
+            !reader.readUint64(baseHash) || !reader.readUint64(resultHash) || !reader.readVarint(chunkSize) || chunkSize == 0 ||
+            chunkSize > quint64(std::numeric_limits<int>::max()) ||
+            !reader.readVarint(pointCount) || pointCount > quint64(std::numeric_limits<int>::max()) ||
+            !reader.readVarint(changedChunkCount) || changedChunkCount > quint64(reader.remaining()))
+        return false;
+
+    if (getRouteHash(encodeRoute(route)) != baseHash)
+        return false;
+
+    QVector<pospoint_t> patchedRoute = route;
+    patchedRoute.resize(int(pointCount));
+    quint64 firstChanged = std::min(quint64(route.size()), pointCount); // route shrunk or grew
+    for (quint64 i = 0; i < changedChunkCount; i++) {
+        quint64 chunkIndex, size;
+        QByteArray encodedChunk;
+        QVector<pospoint_t> chunk;
+        if (!reader.readVarint(chunkIndex) || chunkIndex >= (pointCount + chunkSize - 1) / chunkSize ||
+                !reader.readVarint(size) || size > quint64(reader.remaining()) || !reader.readBytes(int(size), encodedChunk) ||
+                !decodeRoute(encodedChunk, chunk) || quint64(chunk.size()) != std::min(chunkSize, pointCount - chunkIndex * chunkSize))
+            return false;
+        std::copy(chunk.cbegin(), chunk.cend(), patchedRoute.begin() + chunkIndex * chunkSize);
+        firstChanged = std::min(firstChanged, chunkIndex * chunkSize);
+    }
+
+    if (!reader.atEnd() || getRouteHash(encodeRoute(patchedRoute)) != resultHash)
+        return false;
+
+    route = patchedRoute;
+    firstChangedIndex = int(firstChanged);
+    return true;
+}
+
+bool isRoutePatch(const QByteArray &data)
+{
+    return data.startsWith(QByteArray(ROUTE_PATCH_MAGIC, sizeof(ROUTE_PATCH_MAGIC)));
+}
+}
@@ -0,0 +1,50 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Compact binary route format for storage and transfer (e.g., route files, MAVLink bulk transfer).
+ * Only route fields are stored: x/y/height [mm] and UTC timestamps [ms] as zigzag varint deltas,
+ * speed [mm/s] and attributes run-length encoded. Other PosPoint fields are left at their defaults.
+ * Fields are stored column-wise (all x, then all y, ...), which keeps deltas of a kind together.
+ *
+ * Route:      "WR" | version (1) | flags (1) | count (varint) | x | y | height | speed runs | attribute runs [| timestamps]
+ * Route file: "WRF" | version (1) | ENU reference (3 x double, little-endian) | route count (varint) | (size (varint) | route)...
+ * Route patch: "WRP" | version (1) | base route hash (8) | patched route hash (8) | chunk size (varint) | point count (varint) |
+ *             changed chunk count (varint) | (chunk index (varint) | size (varint) | route)...
+ * A patch carries the chunks (consecutive runs of chunk size points) of a route that differ from another route the
+ * receiver has, compared by chunk hashes. Points inserted or removed shift the following chunks, i.e., they are all sent.
+ */
+
+#ifndef ROUTECODEC_H
+#define ROUTECODEC_H
+
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include "core/pospoint.h"
+
+namespace routeCodec {
+QByteArray encodeRoute(const QVector<pospoint_t> &route);
+QByteArray encodeRoute(const QList<PosPoint> &route);
+// Return false (and an empty route) on malformed input
+bool decodeRoute(const QByteArray &encodedRoute, QVector<pospoint_t> &route);
+bool decodeRoute(const QByteArray &encodedRoute, QList<PosPoint> &route);
+
+QByteArray encodeRouteFile(const QList<QVector<pospoint_t>> &routes, const llh_t &enuRef);
+bool decodeRouteFile(const QByteArray &routeFile, QList<QVector<pospoint_t>> &routes, llh_t &enuRef);
+bool isRouteFile(const QByteArray &data); // checks the header only
+
+// 64-bit FNV-1a of an encoded route, e.g., to identify stored routes. Never 0 (0: no route).
+quint64 getRouteHash(const QByteArray &encodedRoute);
+
+constexpr int DEFAULT_PATCH_CHUNK_SIZE = 16; // points
+// Hash of each chunk as encoded route, the last chunk can be shorter
+QVector<quint64> getChunkHashes(const QVector<pospoint_t> &route, int chunkSize = DEFAULT_PATCH_CHUNK_SIZE);
+QByteArray encodeRoutePatch(const QVector<pospoint_t> &baseRoute, const QVector<pospoint_t> &route, int chunkSize = DEFAULT_PATCH_CHUNK_SIZE);
+// Patches route in place. Returns false (route unchanged) if route is not the patch's base route or the patch is malformed.
+// firstChangedIndex: points before it are unchanged, the route's size if none changed.
+bool applyRoutePatch(const QByteArray &routePatch, QVector<pospoint_t> &route, int &firstChangedIndex);
+bool isRoutePatch(const QByteArray &data); // checks the header only
+}
+
+#endif // ROUTECODEC_H
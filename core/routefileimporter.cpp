@@ -0,0 +1,204 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routefileimporter.h"
+#include "core/routecodec.h"
+#include <QXmlStreamReader>
+
+RouteFileImporter::RouteFileImporter(QObject *parent) : QObject(parent)
+{
+    mThreadContext = new QObject();
+    mThread.setObjectName("Route file import");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start();
+}
+
+RouteFileImporter::~RouteFileImporter()
+{
+    mCancel = true;
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+}
+
+bool RouteFileImporter::start(const QString &filename, const llh_t &targetEnuRef)
+{
+    if (mRunning)
+        return false;
+
+    mRunning = true;
+    mCancel = false;
+    QMetaObject::invokeMethod(mThreadContext, [this, filename, targetEnuRef]() {
+        importFile(filename, targetEnuRef);
+    }, Qt::QueuedConnection);
+
+    return true;
+}
+
+void RouteFileImporter::cancel()
+{
+    mCancel = true;
+}
+
+void RouteFileImporter::importFile(const QString &filename, const llh_t &targetEnuRef)
+{
+    mTargetFrame.setReference(targetEnuRef);
+    mPendingRoutes.clear();
+    mPendingPoints = 0;
+    mProgressTimer.start();
+
+    QString errorString;
+    bool success = false;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        errorString = "Could not open \"" + filename + "\" for reading.";
+    else {
+        success = routeCodec::isRouteFile(file.peek(4)) ? importBinary(file, errorString) : importXml(file, errorString);
+        if (!success && errorString.isEmpty() && !mCancel)
+            errorString = "Could not read routes from \"" + filename + "\".";
+        publishProgress(file.size(), file.size(), true);
+    }
+
+    publishRoutes();
+    mEnuPointsBuffer = QVector<xyz_t>(); // do not keep the memory of large imports
+
+    const bool canceled = mCancel;
+    QMetaObject::invokeMethod(this, [this, success, canceled, errorString]() {
+        mRunning = false;
+        emit finished(success && !canceled, canceled ? QString() : errorString);
+    }, Qt::QueuedConnection);
+}
+
+bool RouteFileImporter::importXml(QFile &file, QString &errorString)
+{
+    QXmlStreamReader stream(&file);
+    const qint64 bytesTotal = file.size();
+
+    if (!stream.readNextStartElement() || stream.name() != "routes") {
+        errorString = "\"" + file.fileName() + "\" is not a route file.";
+        return false;
+    }
+
+    coordinateTransforms::EnuFrame sourceFrame(llh_t{0.0, 0.0, 0.0});
+    while (!mCancel && stream.readNextStartElement()) {
+        if (stream.name() == "enuref") {
+            llh_t importedEnuRef{0.0, 0.0, 0.0};
+            while (stream.readNextStartElement()) {
+                if (stream.name() == "Latitude")
+                    importedEnuRef.latitude = stream.readElementText().toDouble();
+                else if (stream.name() == "Longitude")
+                    importedEnuRef.longitude = stream.readElementText().toDouble();
+                else if (stream.name() == "Height")
+                    importedEnuRef.height = stream.readElementText().toDouble();
+                else
+                    stream.skipCurrentElement();
+            }
+            sourceFrame.setReference(importedEnuRef);
+        } else if (stream.name() == "route") {
+            QVector<pospoint_t> importedRoute;
+            while (!mCancel && stream.readNextStartElement()) {
+                if (stream.name() != "point") {
+                    stream.skipCurrentElement();
+                    continue;
+                }
+
+                pospoint_t importedPoint;
+                while (stream.readNextStartElement()) {
+                    if (stream.name() == "x")
+                        importedPoint.x = stream.readElementText().toDouble();
+                    else if (stream.name() == "y")
+                        importedPoint.y = stream.readElementText().toDouble();
+                    else if (stream.name() == "z")
+                        importedPoint.height = stream.readElementText().toDouble();
+                    else if (stream.name() == "speed")
+                        importedPoint.speed = stream.readElementText().toDouble();
+                    else if (stream.name() == "attributes")
+                        importedPoint.attributes = stream.readElementText().toUInt();
+                    else
+                        stream.skipCurrentElement();
+                }
+                importedRoute.append(importedPoint);
+                publishProgress(file.pos(), bytesTotal);
+            }
+            if (!mCancel) // drop partially read route
+                addRoute(importedRoute, sourceFrame);
+        } else
+            stream.skipCurrentElement();
+    }
+
+    if (stream.hasError() && !mCancel) {
+        errorString = "Error in \"" + file.fileName() + "\" at line " + QString::number(stream.lineNumber()) + ": " + stream.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool RouteFileImporter::importBinary(QFile &file, QString &errorString)
+{
+    Q_UNUSED(errorString) // default message from importFile is sufficient
+    QList<QVector<pospoint_t>> importedRoutes;
+    llh_t importedEnuRef;
+    if (!routeCodec::decodeRouteFile(file.readAll(), importedRoutes, importedEnuRef))
+        return false;
+
+    const coordinateTransforms::EnuFrame sourceFrame(importedEnuRef);
+    for (auto &importedRoute : importedRoutes) {
+        if (mCancel)
+            break;
+        addRoute(importedRoute, sourceFrame);
+    }
+    return true;
+}
+
+void RouteFileImporter::addRoute(QVector<pospoint_t> &route, const coordinateTransforms::EnuFrame &sourceFrame)
+{
+    if (route.isEmpty())
+        return;
+
+    // Transform route from imported ENU frame to target ENU frame (nothing to do if they match)
+    const llh_t &sourceRef = sourceFrame.getReference();
+    const llh_t &targetRef = mTargetFrame.getReference();
+    if (sourceRef.latitude != targetRef.latitude || sourceRef.longitude != targetRef.longitude || sourceRef.height != targetRef.height) {
+        mEnuPointsBuffer.resize(route.size());
+        for (int i = 0; i < route.size(); i++)
+            mEnuPointsBuffer[i] = {route.at(i).x, route.at(i).y, route.at(i).height};
+
+        sourceFrame.enuToEnu(mTargetFrame, mEnuPointsBuffer.constData(), mEnuPointsBuffer.data(), mEnuPointsBuffer.size());
+
+        for (int i = 0; i < route.size(); i++) {
+            route[i].x = mEnuPointsBuffer.at(i).x;
+            route[i].y = mEnuPointsBuffer.at(i).y;
+            route[i].height = mEnuPointsBuffer.at(i).z;
+        }
+    }
+
+    mPendingPoints += route.size();
+    mPendingRoutes.append(std::move(route));
+    if (mPendingPoints >= POINTS_PER_BATCH)
+        publishRoutes();
+}
+
+void RouteFileImporter::publishRoutes()
+{
+    if (mPendingRoutes.isEmpty())
+        return;
+
+    QList<QVector<pospoint_t>> routes;
+    routes.swap(mPendingRoutes);
+    mPendingPoints = 0;
+    QMetaObject::invokeMethod(this, [this, routes]() {
+        emit importedRoutes(routes);
+    }, Qt::QueuedConnection);
+}
+
+void RouteFileImporter::publishProgress(qint64 bytesRead, qint64 bytesTotal, bool force)
+{
+    if (!force && mProgressTimer.elapsed() < PROGRESS_INTERVAL_ms)
+        return;
+
+    mProgressTimer.restart();
+    QMetaObject::invokeMethod(this, [this, bytesRead, bytesTotal]() {
+        emit progress(bytesRead, bytesTotal);
+    }, Qt::QueuedConnection);
+}
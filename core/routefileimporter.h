@@ -0,0 +1,68 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Imports routes from XML or binary (routeCodec) route files on a worker thread.
+ * XML is parsed incrementally from the file (QXmlStreamReader, no DOM and no full copy of the file in memory),
+ * each route is transformed from the file's ENU frame to the target ENU frame as soon as it is complete.
+ * Finished routes are handed out in batches of roughly POINTS_PER_BATCH points, so that the receiver
+ * (e.g., RoutePlannerModule) is updated while the rest of the file is still being parsed.
+ * Routes are handed out and all signals are emitted in the thread the importer lives in.
+ */
+
+#ifndef ROUTEFILEIMPORTER_H
+#define ROUTEFILEIMPORTER_H
+
+#include <QObject>
+#include <QThread>
+#include <QFile>
+#include <QList>
+#include <QVector>
+#include <QElapsedTimer>
+#include <atomic>
+#include "core/pospoint.h"
+#include "core/coordinatetransforms.h"
+
+class RouteFileImporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RouteFileImporter(QObject *parent = nullptr);
+    ~RouteFileImporter();
+
+    // Only one import at a time, returns false if an import is already running
+    bool start(const QString &filename, const llh_t &targetEnuRef);
+    // Stops as soon as possible, routes handed out so far are kept. finished() follows with an empty errorString.
+    void cancel();
+    bool isRunning() const { return mRunning; }
+
+    static constexpr int POINTS_PER_BATCH = 20000;
+    static constexpr int PROGRESS_INTERVAL_ms = 100;
+
+signals:
+    void importedRoutes(const QList<QVector<pospoint_t>> &routes); // transformed to targetEnuRef
+    void progress(qint64 bytesRead, qint64 bytesTotal);
+    void finished(bool success, const QString &errorString);
+
+private:
+    // Worker thread
+    void importFile(const QString &filename, const llh_t &targetEnuRef);
+    bool importXml(QFile &file, QString &errorString);
+    bool importBinary(QFile &file, QString &errorString);
+    void addRoute(QVector<pospoint_t> &route, const coordinateTransforms::EnuFrame &sourceFrame);
+    void publishRoutes();
+    void publishProgress(qint64 bytesRead, qint64 bytesTotal, bool force = false);
+
+    QThread mThread;
+    QObject *mThreadContext;
+    bool mRunning = false; // owner thread only
+    std::atomic<bool> mCancel {false};
+
+    coordinateTransforms::EnuFrame mTargetFrame;
+    QVector<xyz_t> mEnuPointsBuffer;
+    QList<QVector<pospoint_t>> mPendingRoutes;
+    int mPendingPoints = 0;
+    QElapsedTimer mProgressTimer;
+};
+
+#endif // ROUTEFILEIMPORTER_H
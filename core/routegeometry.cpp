@@ -0,0 +1,126 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routegeometry.h"
+#include "core/geometry.h"
+#include <QLineF>
+#include <algorithm>
+#include <cmath>
+
+void RouteGeometry::clear()
+{
+    mPoints.clear();
+    mArcLength.clear();
+    mCurvature.clear();
+    mSegmentLength.clear();
+    mSegmentHeading_rad.clear();
+    mBounds = QRectF();
+}
+
+void RouteGeometry::setRoute(const QVector<pospoint_t> &route)
+{
+    clear();
+    appendRoute(route);
+}
+
+void RouteGeometry::appendRoute(const QVector<pospoint_t> &route)
+{
+    if (route.isEmpty())
+        return;
+
+    const int firstNewIndex = mPoints.size();
+    mPoints.reserve(mPoints.size() + route.size());
+    for (const auto &point : route)
+        mPoints.append(point.getPoint());
+    updateFrom(firstNewIndex);
+}
+
+void RouteGeometry::appendPoint(const QPointF &point)
+{
+    mPoints.append(point);
+    updateFrom(mPoints.size() - 1);
+}
+
+void RouteGeometry::truncate(int size)
+{
+    if (size >= mPoints.size())
+        return;
+    if (size <= 0) {
+        clear();
+        return;
+    }
+
+    mPoints.resize(size);
+    updateFrom(size);
+
+    mBounds = QRectF(mPoints.first(), QSizeF(0.0, 0.0));
+    for (const auto &point : mPoints)
+        includeInBounds(point);
+}
+
+void RouteGeometry::setClosed(bool closed)
+{
+    mClosed = closed;
+    if (!mPoints.isEmpty()) {
+        updateCurvature(0);
+        updateCurvature(mPoints.size() - 1);
+    }
+}
+
+QRectF RouteGeometry::getSegmentBounds(int segmentIndex) const
+{
+    return QRectF(mPoints.at(segmentIndex), mPoints.at((segmentIndex + 1) % mPoints.size())).normalized();
+}
+
+void RouteGeometry::updateFrom(int index)
+{
+    const int size = mPoints.size();
+    mArcLength.resize(size);
+    mCurvature.resize(size);
+    mSegmentLength.resize(size);
+    mSegmentHeading_rad.resize(size);
+    if (size == 0)
+        return;
+
+    if (index == 0)
+        mBounds = QRectF(mPoints.first(), QSizeF(0.0, 0.0));
+    for (int i = index; i < size; i++) {
+        mArcLength[i] = (i == 0) ? 0.0 : mArcLength.at(i - 1) + QLineF(mPoints.at(i - 1), mPoints.at(i)).length();
+        includeInBounds(mPoints.at(i));
+    }
+
+    // The segment into index and the closing segment change, as well as the curvature at their points
+    for (int i = std::max(index - 1, 0); i < size; i++) {
+        updateSegment(i);
+        updateCurvature(i);
+    }
+    updateCurvature(0);
+}
+
+void RouteGeometry::includeInBounds(const QPointF &point)
+{
+    // Not QRectF::united, it ignores empty rectangles
+    mBounds.setLeft(std::min(mBounds.left(), point.x()));
+    mBounds.setRight(std::max(mBounds.right(), point.x()));
+    mBounds.setTop(std::min(mBounds.top(), point.y()));
+    mBounds.setBottom(std::max(mBounds.bottom(), point.y()));
+}
+
+void RouteGeometry::updateCurvature(int index)
+{
+    const int size = mPoints.size();
+    if (size < 3 || (!mClosed && (index == 0 || index == size - 1))) {
+        mCurvature[index] = 0.0;
+        return;
+    }
+
+    mCurvature[index] = geometry::threePointCurvature(mPoints.at((index - 1 + size) % size), mPoints.at(index), mPoints.at((index + 1) % size));
+}
+
+void RouteGeometry::updateSegment(int segmentIndex)
+{
+    const QLineF segment(mPoints.at(segmentIndex), mPoints.at((segmentIndex + 1) % mPoints.size()));
+    mSegmentLength[segmentIndex] = segment.length();
+    mSegmentHeading_rad[segmentIndex] = atan2(segment.dy(), segment.dx());
+}
@@ -0,0 +1,60 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Precomputed geometry of a route: arc length and curvature per point, length and heading per segment, and bounds.
+ * Kept up to date incrementally while the route is modified (same operations as RouteSpatialIndex), queries are O(1).
+ * Segment i connects point i and point i+1, segment size()-1 closes the route from its last back to its first point.
+ * Curvature is that of the circle through a point and its neighbours, at the ends of open routes it is 0.
+ */
+
+#ifndef ROUTEGEOMETRY_H
+#define ROUTEGEOMETRY_H
+
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include "core/pospoint.h"
+
+class RouteGeometry
+{
+public:
+    RouteGeometry() {}
+
+    void clear();
+    void setRoute(const QVector<pospoint_t> &route);
+    void appendRoute(const QVector<pospoint_t> &route);
+    void appendPoint(const QPointF &point);
+    void truncate(int size); // remove points with index >= size
+
+    bool isClosed() const { return mClosed; }
+    void setClosed(bool closed); // e.g., repeated routes, the curvature of the first and last point depends on the other end
+
+    int size() const { return mPoints.size(); }
+    bool isEmpty() const { return mPoints.isEmpty(); }
+    const QPointF &getPoint(int index) const { return mPoints.at(index); }
+
+    double getLength() const { return mArcLength.isEmpty() ? 0.0 : mArcLength.last(); } // without the closing segment
+    double getArcLength(int index) const { return mArcLength.at(index); } // [m] from the first point
+    double getCurvature(int index) const { return mCurvature.at(index); } // [1/m], positive: turning left
+    double getSegmentLength(int segmentIndex) const { return mSegmentLength.at(segmentIndex); }
+    double getSegmentHeading_rad(int segmentIndex) const { return mSegmentHeading_rad.at(segmentIndex); } // ENU, 0: east, counter-clockwise
+    QRectF getSegmentBounds(int segmentIndex) const;
+    QRectF getBounds() const { return mBounds; } // top: min. y
+
+private:
+    void updateFrom(int index); // recompute everything depending on points >= index
+    void updateCurvature(int index);
+    void updateSegment(int segmentIndex);
+    void includeInBounds(const QPointF &point);
+
+    bool mClosed = false;
+    QVector<QPointF> mPoints;
+    QVector<double> mArcLength;
+    QVector<double> mCurvature;
+    QVector<double> mSegmentLength;
+    QVector<double> mSegmentHeading_rad;
+    QRectF mBounds;
+};
+
+#endif // ROUTEGEOMETRY_H
@@ -0,0 +1,71 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routeprojection.h"
+#include <QLineF>
+#include <cmath>
+#include <limits>
+
+namespace routeProjection {
+
+namespace {
+// Closest point on segmentIndex, returns the distance to it
+double projectOnSegment(const RouteGeometry &geometry, const QPointF &position, int segmentIndex, double &along_m)
+{
+    const QPointF &segmentStart = geometry.getPoint(segmentIndex);
+    const double heading_rad = geometry.getSegmentHeading_rad(segmentIndex);
+    const QPointF relative = position - segmentStart;
+    along_m = qBound(0.0, relative.x() * cos(heading_rad) + relative.y() * sin(heading_rad), geometry.getSegmentLength(segmentIndex));
+    return QLineF(position, segmentStart + along_m * QPointF(cos(heading_rad), sin(heading_rad))).length();
+}
+}
+
+RouteProjection project(const RouteGeometry &geometry, const RouteSpatialIndex &spatialIndex, const QPointF &position, double yaw_rad,
+                        int hintSegment, int searchWindow)
+{
+    RouteProjection projection;
+    const int segmentCount = geometry.size() - 1; // without the closing segment
+    if (segmentCount < 1 || spatialIndex.size() != geometry.size())
+        return projection;
+
+    int closestSegment = -1;
+    double closestDistance = std::numeric_limits<double>::infinity();
+    double closestAlong_m = 0.0;
+    if (hintSegment >= 0) {
+        const int firstSegment = std::max(std::min(hintSegment, segmentCount - 1) - searchWindow, 0);
+        const int lastSegment = std::min(hintSegment + searchWindow, segmentCount - 1);
+        for (int segmentIndex = firstSegment; segmentIndex <= lastSegment; segmentIndex++) {
+            double along_m;
+            const double distance = projectOnSegment(geometry, position, segmentIndex, along_m);
+            if (distance < closestDistance) {
+                closestDistance = distance;
+                closestSegment = segmentIndex;
+                closestAlong_m = along_m;
+            }
+        }
+
+        // At the window's edge (but not the route's), closer segments can be outside of it
+        if ((closestSegment == firstSegment && firstSegment > 0) || (closestSegment == lastSegment && lastSegment < segmentCount - 1))
+            closestSegment = -1;
+    }
+
+    if (closestSegment < 0) {
+        closestSegment = spatialIndex.getClosestSegmentIndex(position);
+        if (closestSegment < 0 || closestSegment >= segmentCount)
+            return projection;
+        projectOnSegment(geometry, position, closestSegment, closestAlong_m);
+    }
+
+    const double heading_rad = geometry.getSegmentHeading_rad(closestSegment);
+    projection.valid = true;
+    projection.segmentIndex = closestSegment;
+    projection.point = geometry.getPoint(closestSegment) + closestAlong_m * QPointF(cos(heading_rad), sin(heading_rad));
+    const QPointF offset = position - projection.point;
+    const double distance = QLineF(position, projection.point).length();
+    projection.crossTrackError_m = (cos(heading_rad) * offset.y() - sin(heading_rad) * offset.x() < 0.0) ? -distance : distance;
+    projection.alongTrack_m = geometry.getArcLength(closestSegment) + closestAlong_m;
+    projection.headingError_rad = remainder(yaw_rad - heading_rad, 2.0 * M_PI);
+    return projection;
+}
+}
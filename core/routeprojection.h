@@ -0,0 +1,36 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Projection of a pose onto a route (map matching) for tracking error metrics: cross-track error, progress along the
+ * route and heading error. Works on the RouteGeometry and RouteSpatialIndex kept for the route anyway. Only the segments
+ * around a hint (e.g., the previous projection's segment) are checked, i.e., O(1) per call while the pose moves along
+ * the route; the spatial index is searched when the closest segment is at the window's edge or there is no hint.
+ */
+
+#ifndef ROUTEPROJECTION_H
+#define ROUTEPROJECTION_H
+
+#include <QPointF>
+#include "core/routegeometry.h"
+#include "core/routespatialindex.h"
+
+struct RouteProjection {
+    bool valid = false;
+    int segmentIndex = -1; // segment i connects point i and point i+1
+    QPointF point; // closest point on the route
+    double crossTrackError_m = 0.0; // distance to point, positive: left of the route
+    double alongTrack_m = 0.0; // arc length from the route's first point to point
+    double headingError_rad = 0.0; // yaw - segment heading, [-pi:pi]
+};
+
+namespace routeProjection {
+constexpr int DEFAULT_SEARCH_WINDOW = 4; // segments before and after the hint
+
+// geometry and spatialIndex: of the same (open) route with at least two points, invalid result otherwise.
+// yaw_rad: ENU, 0: east, counter-clockwise. hintSegment < 0: no hint.
+RouteProjection project(const RouteGeometry &geometry, const RouteSpatialIndex &spatialIndex, const QPointF &position, double yaw_rad,
+                        int hintSegment = -1, int searchWindow = DEFAULT_SEARCH_WINDOW);
+}
+
+#endif // ROUTEPROJECTION_H
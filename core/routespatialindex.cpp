@@ -0,0 +1,283 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routespatialindex.h"
+#include "core/geometry.h"
+#include <QLineF>
+#include <algorithm>
+#include <limits>
+
+RouteSpatialIndex::RouteSpatialIndex(double cellSize)
+{
+    mCellSize = cellSize > 0.0 ? cellSize : 5.0;
+}
+
+template<typename DistanceFunction>
+int RouteSpatialIndex::findClosest(const CellMap &cells, const QPointF &point, int minIndex, double *distance, DistanceFunction distanceTo) const
+{
+    int closestIndex = -1;
+    double minDistance = std::numeric_limits<double>::max();
+
+    if (mHasExtent) {
+        const int centerX = cellCoordinate(point.x());
+        const int centerY = cellCoordinate(point.y());
+
+        auto visitCell = [&](int cellX, int cellY) {
+            auto cellIt = cells.constFind(cellKey(cellX, cellY));
+            if (cellIt == cells.constEnd())
+                return;
+            for (int index : *cellIt) {
+                if (index < minIndex)
+                    continue;
+                const double currentDistance = distanceTo(index);
+                if (currentDistance < minDistance || (currentDistance == minDistance && index < closestIndex)) {
+                    minDistance = currentDistance;
+                    closestIndex = index;
+                }
+            }
+        };
+
+        // Search rings of cells around the center cell, restricted to occupied extent.
+        // All cells of ring r are at least (r-1)*cellSize away from point.
+        const int firstRing = std::max({mMinCellX - centerX, centerX - mMaxCellX, mMinCellY - centerY, centerY - mMaxCellY, 0});
+        const int lastRing = std::max({abs(centerX - mMinCellX), abs(centerX - mMaxCellX), abs(centerY - mMinCellY), abs(centerY - mMaxCellY)});
+        for (int ring = firstRing; ring <= lastRing; ring++) {
+            if (closestIndex >= 0 && minDistance <= (ring - 1) * mCellSize)
+                break;
+
+            if (ring == 0) {
+                visitCell(centerX, centerY);
+                continue;
+            }
+
+            const int fromX = std::max(centerX - ring, mMinCellX);
+            const int toX = std::min(centerX + ring, mMaxCellX);
+            for (int cellX = fromX; cellX <= toX; cellX++) {
+                if (centerY - ring >= mMinCellY)
+                    visitCell(cellX, centerY - ring);
+                if (centerY + ring <= mMaxCellY)
+                    visitCell(cellX, centerY + ring);
+            }
+
+            const int fromY = std::max(centerY - ring + 1, mMinCellY);
+            const int toY = std::min(centerY + ring - 1, mMaxCellY);
+            for (int cellY = fromY; cellY <= toY; cellY++) {
+                if (centerX - ring >= mMinCellX)
+                    visitCell(centerX - ring, cellY);
+                if (centerX + ring <= mMaxCellX)
+                    visitCell(centerX + ring, cellY);
+            }
+        }
+    }
+
+    if (distance)
+        *distance = (closestIndex >= 0) ? minDistance : -1.0;
+
+    return closestIndex;
+}
+
+void RouteSpatialIndex::clear()
+{
+    mPoints.clear();
+    mPointCells.clear();
+    mSegmentCells.clear();
+    mHasExtent = false;
+}
+
+void RouteSpatialIndex::setRoute(const QVector<pospoint_t> &route)
+{
+    clear();
+    appendRoute(route);
+}
+
+void RouteSpatialIndex::appendRoute(const QVector<pospoint_t> &route)
+{
+    mPoints.reserve(mPoints.size() + route.size());
+    for (const auto &point : route)
+        appendPoint(point.getPoint());
+}
+
+void RouteSpatialIndex::appendPoint(const QPointF &point)
+{
+    const int pointIndex = mPoints.size();
+    mPoints.append(point);
+
+    const int cellX = cellCoordinate(point.x());
+    const int cellY = cellCoordinate(point.y());
+    mPointCells[cellKey(cellX, cellY)].append(pointIndex);
+    includeCellInExtent(cellX, cellY);
+
+    if (pointIndex > 0)
+        for (const auto &cell : getCellsOnSegment(pointIndex - 1))
+            mSegmentCells[cellKey(cell.first, cell.second)].append(pointIndex - 1);
+}
+
+void RouteSpatialIndex::truncate(int size)
+{
+    size = std::max(size, 0);
+
+    // Indices were appended in ascending order, i.e., the highest index of a cell is always its last entry
+    for (int segmentIndex = mPoints.size() - 2; segmentIndex >= std::max(size - 1, 0); segmentIndex--)
+        for (const auto &cell : getCellsOnSegment(segmentIndex)) {
+            auto cellIt = mSegmentCells.find(cellKey(cell.first, cell.second));
+            if (cellIt != mSegmentCells.end() && !cellIt->isEmpty() && cellIt->last() == segmentIndex) {
+                cellIt->removeLast();
+                if (cellIt->isEmpty())
+                    mSegmentCells.erase(cellIt);
+            }
+        }
+
+    for (int pointIndex = mPoints.size() - 1; pointIndex >= size; pointIndex--) {
+        auto cellIt = mPointCells.find(cellKey(cellCoordinate(mPoints.at(pointIndex).x()), cellCoordinate(mPoints.at(pointIndex).y())));
+        if (cellIt != mPointCells.end() && !cellIt->isEmpty() && cellIt->last() == pointIndex) {
+            cellIt->removeLast();
+            if (cellIt->isEmpty())
+                mPointCells.erase(cellIt);
+        }
+    }
+
+    if (size < mPoints.size())
+        mPoints.resize(size);
+    if (mPoints.isEmpty())
+        mHasExtent = false;
+}
+
+void RouteSpatialIndex::setCellSize(double cellSize)
+{
+    if (cellSize <= 0.0 || cellSize == mCellSize)
+        return;
+
+    QVector<QPointF> points = mPoints;
+    clear();
+    mCellSize = cellSize;
+    for (const auto &point : points)
+        appendPoint(point);
+}
+
+int RouteSpatialIndex::getClosestPointIndex(const QPointF &point, int minIndex, double *distance) const
+{
+    return findClosest(mPointCells, point, minIndex, distance, [this, &point](int pointIndex) {
+        return QLineF(point, mPoints.at(pointIndex)).length();
+    });
+}
+
+int RouteSpatialIndex::getClosestSegmentIndex(const QPointF &point, int minIndex, double *distance) const
+{
+    return findClosest(mSegmentCells, point, minIndex, distance, [this, &point](int segmentIndex) {
+        return getDistanceToSegment(point, segmentIndex);
+    });
+}
+
+QVector<int> RouteSpatialIndex::getPointIndicesWithinRadius(const QPointF &point, double radius) const
+{
+    QVector<int> pointIndices;
+    if (!mHasExtent || radius < 0.0)
+        return pointIndices;
+
+    const int minCellX = std::max(cellCoordinate(point.x() - radius), mMinCellX);
+    const int maxCellX = std::min(cellCoordinate(point.x() + radius), mMaxCellX);
+    const int minCellY = std::max(cellCoordinate(point.y() - radius), mMinCellY);
+    const int maxCellY = std::min(cellCoordinate(point.y() + radius), mMaxCellY);
+
+    for (int cellX = minCellX; cellX <= maxCellX; cellX++)
+        for (int cellY = minCellY; cellY <= maxCellY; cellY++) {
+            auto cellIt = mPointCells.constFind(cellKey(cellX, cellY));
+            if (cellIt == mPointCells.constEnd())
+                continue;
+            for (int pointIndex : *cellIt)
+                if (QLineF(point, mPoints.at(pointIndex)).length() <= radius)
+                    pointIndices.append(pointIndex);
+        }
+
+    std::sort(pointIndices.begin(), pointIndices.end());
+    return pointIndices;
+}
+
+QVector<int> RouteSpatialIndex::getSegmentIndicesWithinRadius(const QPointF &point, double radius) const
+{
+    QVector<int> segmentIndices;
+    if (!mHasExtent || radius < 0.0)
+        return segmentIndices;
+
+    const int minCellX = std::max(cellCoordinate(point.x() - radius), mMinCellX);
+    const int maxCellX = std::min(cellCoordinate(point.x() + radius), mMaxCellX);
+    const int minCellY = std::max(cellCoordinate(point.y() - radius), mMinCellY);
+    const int maxCellY = std::min(cellCoordinate(point.y() + radius), mMaxCellY);
+
+    for (int cellX = minCellX; cellX <= maxCellX; cellX++)
+        for (int cellY = minCellY; cellY <= maxCellY; cellY++) {
+            auto cellIt = mSegmentCells.constFind(cellKey(cellX, cellY));
+            if (cellIt == mSegmentCells.constEnd())
+                continue;
+            for (int segmentIndex : *cellIt)
+                if (getDistanceToSegment(point, segmentIndex) <= radius)
+                    segmentIndices.append(segmentIndex);
+        }
+
+    // segments can span multiple cells
+    std::sort(segmentIndices.begin(), segmentIndices.end());
+    segmentIndices.erase(std::unique(segmentIndices.begin(), segmentIndices.end()), segmentIndices.end());
+    return segmentIndices;
+}
+
+void RouteSpatialIndex::includeCellInExtent(int cellX, int cellY)
+{
+    if (!mHasExtent) {
+        mMinCellX = mMaxCellX = cellX;
+        mMinCellY = mMaxCellY = cellY;
+        mHasExtent = true;
+        return;
+    }
+
+    mMinCellX = std::min(mMinCellX, cellX);
+    mMaxCellX = std::max(mMaxCellX, cellX);
+    mMinCellY = std::min(mMinCellY, cellY);
+    mMaxCellY = std::max(mMaxCellY, cellY);
+}
+
+QVector<QPair<int, int>> RouteSpatialIndex::getCellsOnSegment(int segmentIndex) const
+{
+    // Grid traversal along the segment, see Amanatides & Woo: "A Fast Voxel Traversal Algorithm for Ray Tracing"
+    const QPointF &start = mPoints.at(segmentIndex);
+    const QPointF &end = mPoints.at(segmentIndex + 1);
+
+    int cellX = cellCoordinate(start.x());
+    int cellY = cellCoordinate(start.y());
+    const int endCellX = cellCoordinate(end.x());
+    const int endCellY = cellCoordinate(end.y());
+
+    const double dx = end.x() - start.x();
+    const double dy = end.y() - start.y();
+    const int stepX = dx > 0 ? 1 : -1;
+    const int stepY = dy > 0 ? 1 : -1;
+    const double infinity = std::numeric_limits<double>::infinity();
+    double tMaxX = (dx != 0.0) ? ((cellX + (stepX > 0 ? 1 : 0)) * mCellSize - start.x()) / dx : infinity;
+    double tMaxY = (dy != 0.0) ? ((cellY + (stepY > 0 ? 1 : 0)) * mCellSize - start.y()) / dy : infinity;
+    const double tDeltaX = (dx != 0.0) ? mCellSize / fabs(dx) : infinity;
+    const double tDeltaY = (dy != 0.0) ? mCellSize / fabs(dy) : infinity;
+
+    QVector<QPair<int, int>> cells;
+    const int numSteps = abs(endCellX - cellX) + abs(endCellY - cellY);
+    cells.reserve(numSteps + 1);
+    cells.append({cellX, cellY});
+    for (int i = 0; i < numSteps; i++) {
+        if (tMaxX < tMaxY) {
+            cellX += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            cellY += stepY;
+            tMaxY += tDeltaY;
+        }
+        cells.append({cellX, cellY});
+    }
+    if (cells.last() != QPair<int, int>(endCellX, endCellY)) // numerical corner case
+        cells.append({endCellX, endCellY});
+
+    return cells;
+}
+
+double RouteSpatialIndex::getDistanceToSegment(const QPointF &point, int segmentIndex) const
+{
+    return geometry::distanceToLineSegment(point, QLineF(mPoints.at(segmentIndex), mPoints.at(segmentIndex + 1)));
+}
@@ -0,0 +1,66 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Uniform grid over the points and segments of a route for fast closest point/segment and radius queries.
+ * Segment i connects point i and point i+1.
+ */
+
+#ifndef ROUTESPATIALINDEX_H
+#define ROUTESPATIALINDEX_H
+
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include <QPointF>
+#include "core/pospoint.h"
+
+class RouteSpatialIndex
+{
+public:
+    RouteSpatialIndex(double cellSize = 5.0);
+
+    void clear();
+    void setRoute(const QVector<pospoint_t> &route);
+    void appendRoute(const QVector<pospoint_t> &route);
+    void appendPoint(const QPointF &point);
+    void truncate(int size); // remove points with index >= size (and segments they belong to)
+
+    int size() const { return mPoints.size(); }
+    bool isEmpty() const { return mPoints.isEmpty(); }
+    double getCellSize() const { return mCellSize; }
+    void setCellSize(double cellSize);
+
+    // Only points/segments with index >= minIndex are considered. Returns -1 if there are none.
+    int getClosestPointIndex(const QPointF &point, int minIndex = 0, double *distance = nullptr) const;
+    int getClosestSegmentIndex(const QPointF &point, int minIndex = 0, double *distance = nullptr) const;
+    // Results are sorted by index
+    QVector<int> getPointIndicesWithinRadius(const QPointF &point, double radius) const;
+    QVector<int> getSegmentIndicesWithinRadius(const QPointF &point, double radius) const;
+
+private:
+    typedef quint64 CellKey;
+    typedef QHash<CellKey, QVector<int>> CellMap;
+
+    int cellCoordinate(double value) const { return (int)floor(value / mCellSize); }
+    static CellKey cellKey(int cellX, int cellY) { return ((CellKey)(quint32)cellX << 32) | (quint32)cellY; }
+    void includeCellInExtent(int cellX, int cellY);
+    QVector<QPair<int,int>> getCellsOnSegment(int segmentIndex) const;
+    double getDistanceToSegment(const QPointF &point, int segmentIndex) const;
+    template<typename DistanceFunction>
+    int findClosest(const CellMap &cells, const QPointF &point, int minIndex, double *distance, DistanceFunction distanceTo) const;
+
+    double mCellSize;
+    QVector<QPointF> mPoints;
+    CellMap mPointCells;
+    CellMap mSegmentCells;
+
+    // Extent of all cells that were ever occupied, bounds the search
+    bool mHasExtent = false;
+    int mMinCellX = 0;
+    int mMaxCellX = 0;
+    int mMinCellY = 0;
+    int mMaxCellY = 0;
+};
+
+#endif // ROUTESPATIALINDEX_H
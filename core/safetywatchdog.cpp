@@ -0,0 +1,192 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "safetywatchdog.h"
+#include "core/threadconfig.h"
+#include <QDebug>
+#include <chrono>
+
+SafetyWatchdog::SafetyWatchdog(QObject *parent) : QObject(parent)
+{
+    mEventLoopTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mEventLoopTimer, &ClockTimer::timeout, this, [this]() { feed(mEventLoopSource); });
+}
+
+SafetyWatchdog::~SafetyWatchdog()
+{
+    stop();
+}
+
+int SafetyWatchdog::addSource(const QString &name, int timeout_ms)
+{
+    if (mRunning) {
+        qWarning() << "WARNING: SafetyWatchdog: sources need to be added before starting, ignoring" << name;
+        return -1;
+    }
+
+    const int sourceId = mNumSources;
+    if (sourceId >= MAX_SOURCES) {
+        qWarning() << "WARNING: SafetyWatchdog: too many sources, ignoring" << name;
+        return -1;
+    }
+
+    mSources[sourceId].name = name;
+    mSources[sourceId].timeout_ns = qint64(timeout_ms) * 1000000;
+    mNumSources = sourceId + 1;
+    return sourceId;
+}
+
+int SafetyWatchdog::addEventLoopSource(int timeout_ms)
+{
+    if (mEventLoopSource >= 0)
+        return mEventLoopSource;
+
+    mEventLoopSource = addSource("event loop", timeout_ms);
+    if (mEventLoopSource >= 0)
+        mEventLoopTimer.setInterval(std::max(timeout_ms / 4, 1));
+    return mEventLoopSource;
+}
+
+void SafetyWatchdog::feed(int sourceId)
+{
+    if (sourceId < 0 || sourceId >= mNumSources)
+        return;
+
+    Source &source = mSources[sourceId];
+    source.lastFeed_ns.store(getMonotonicTime_ns(), std::memory_order_relaxed);
+    source.armed.store(true, std::memory_order_release);
+}
+
+void SafetyWatchdog::disarm(int sourceId)
+{
+    if (sourceId >= 0 && sourceId < mNumSources)
+        mSources[sourceId].armed.store(false, std::memory_order_release);
+}
+
+void SafetyWatchdog::start()
+{
+    std::lock_guard<std::mutex> lock(mThreadMutex);
+    if (mRunning)
+        return;
+
+    mRunning = true;
+    mThread = std::thread(&SafetyWatchdog::runThread, this);
+    if (mEventLoopSource >= 0)
+        mEventLoopTimer.start();
+}
+
+void SafetyWatchdog::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mThreadMutex);
+        if (!mRunning)
+            return;
+        mRunning = false;
+    }
+    mThreadCondition.notify_all();
+    mThread.join();
+    mEventLoopTimer.stop();
+}
+
+QVector<SafetyWatchdogSource> SafetyWatchdog::getSources() const
+{
+    QVector<SafetyWatchdogSource> sources;
+    const qint64 now_ns = getMonotonicTime_ns();
+    for (int i = 0; i < mNumSources; i++) {
+        const Source &source = mSources[i];
+        SafetyWatchdogSource sourceInfo;
+        sourceInfo.name = source.name;
+        sourceInfo.timeout_ms = source.timeout_ns / 1000000;
+        sourceInfo.armed = source.armed.load(std::memory_order_acquire);
+        sourceInfo.age_ms = sourceInfo.armed ? (now_ns - source.lastFeed_ns.load(std::memory_order_relaxed)) / 1e6 : 0.0;
+        sourceInfo.trips = source.trips;
+        sources.append(sourceInfo);
+    }
+    return sources;
+}
+
+SafetyWatchdogStatistics SafetyWatchdog::getStatistics()
+{
+    std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    return mStatistics;
+}
+
+qint64 SafetyWatchdog::getMonotonicTime_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SafetyWatchdog::runThread()
+{
+    ThreadConfig::getInstance().applyToCurrentThread(ThreadConfig::Role::Safety);
+
+    // Absolute wakeup times, as in ControlLoop
+    auto wakeupTime = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mThreadMutex);
+    while (mRunning) {
+        const std::chrono::milliseconds period(mCheckPeriod_ms);
+        wakeupTime += period;
+        if (mThreadCondition.wait_until(lock, wakeupTime, [this]() { return !mRunning; }))
+            break;
+        lock.unlock();
+
+        const auto now = std::chrono::steady_clock::now();
+        const double lateness_us = std::chrono::duration<double, std::micro>(now - wakeupTime).count();
+        if (now - wakeupTime > period)
+            wakeupTime = now;
+
+        check();
+
+        {
+            std::lock_guard<std::mutex> statisticsLock(mStatisticsMutex);
+            mStatistics.checks++;
+            mStatistics.maxCheckLateness_us = std::max(mStatistics.maxCheckLateness_us, lateness_us);
+        }
+        lock.lock();
+    }
+}
+
+void SafetyWatchdog::check()
+{
+    const qint64 now_ns = getMonotonicTime_ns();
+    int timedOutSource = -1;
+    bool anyTimedOut = false;
+    for (int i = 0; i < mNumSources; i++) {
+        Source &source = mSources[i];
+        const bool timedOut = source.armed.load(std::memory_order_acquire)
+                && now_ns - source.lastFeed_ns.load(std::memory_order_relaxed) > source.timeout_ns;
+        if (timedOut && !source.timedOut) {
+            source.trips++;
+            if (timedOutSource < 0)
+                timedOutSource = i;
+        }
+        source.timedOut = timedOut;
+        anyTimedOut |= timedOut;
+    }
+
+    if (timedOutSource >= 0 && !mTripped) {
+        // Stop first, report after
+        mTripped = true;
+        const auto stopStart = std::chrono::steady_clock::now();
+        if (mStopAction)
+            mStopAction(mSources[timedOutSource].name);
+        const double stopDuration_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - stopStart).count();
+
+        {
+            std::lock_guard<std::mutex> statisticsLock(mStatisticsMutex);
+            mStatistics.trips++;
+            mStatistics.maxStopActionDuration_us = std::max(mStatistics.maxStopActionDuration_us, stopDuration_us);
+            mStatistics.lastTrippedSource = mSources[timedOutSource].name;
+        }
+        qWarning() << "WARNING: SafetyWatchdog:" << mSources[timedOutSource].name << "timed out, vehicle stopped (stop action took"
+                   << stopDuration_us << "us)";
+        emit tripped(mSources[timedOutSource].name);
+    } else if (!anyTimedOut && mTripped) {
+        mTripped = false;
+        if (mReleaseAction)
+            mReleaseAction();
+        qDebug() << "SafetyWatchdog: all sources alive again, stop released.";
+        emit released();
+    }
+}
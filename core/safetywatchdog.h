@@ -0,0 +1,129 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Safety watchdog independent of Qt's event loop: a dedicated thread (ThreadConfig role safety, e.g., with a high SCHED_FIFO
+ * priority) checks the heartbeats of sources such as the control loop (ControlLoop::setHeartbeat), the link to the control
+ * station (VehicleServer::setStationHeartbeatCallback) or sensors (monitorSignal). Sources are fed with an atomic timestamp
+ * from any thread, lock-free. A source is checked from its first feed until it is disarmed, i.e., what does not run yet
+ * (no station connected, autopilot stopped) does not trip. When an armed source times out, the stop action is called on the
+ * watchdog's thread, e.g., MovementController::setSafetyStop commanding the actuators directly. The vehicle is thus stopped
+ * within timeout + check period, even if the event loop stalls. The release action follows once all armed sources are alive again.
+ * Checks real time (steady_clock) only, i.e., not for simulated clocks.
+ */
+
+#ifndef SAFETYWATCHDOG_H
+#define SAFETYWATCHDOG_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "core/clock.h"
+
+struct SafetyWatchdogSource {
+    QString name;
+    int timeout_ms = 0;
+    bool armed = false;
+    double age_ms = 0.0; // since the last feed, 0 if not armed
+    quint64 trips = 0;
+};
+
+struct SafetyWatchdogStatistics {
+    quint64 checks = 0;
+    quint64 trips = 0;
+    double maxCheckLateness_us = 0.0; // wake-up of the watchdog thread after its period
+    double maxStopActionDuration_us = 0.0;
+    QString lastTrippedSource;
+};
+
+class SafetyWatchdog : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int MAX_SOURCES = 16;
+    static constexpr int DEFAULT_CHECK_PERIOD_MS = 10;
+    static constexpr int DEFAULT_EVENT_LOOP_TIMEOUT_MS = 500;
+
+    explicit SafetyWatchdog(QObject *parent = nullptr);
+    ~SafetyWatchdog();
+
+    // Before start(), returns the source ID for feed(), -1 if MAX_SOURCES are registered
+    int addSource(const QString &name, int timeout_ms);
+    // Fed by a timer on the watchdog's (owner's) event loop, i.e., trips when the event loop stalls
+    int addEventLoopSource(int timeout_ms = DEFAULT_EVENT_LOOP_TIMEOUT_MS);
+    // Feeds on every emission of signal (on the sender's thread), returns the source ID
+    template<typename Sender, typename Signal>
+    int monitorSignal(const Sender *sender, Signal signal, const QString &name, int timeout_ms) {
+        const int sourceId = addSource(name, timeout_ms);
+        if (sourceId >= 0)
+            connect(sender, signal, this, [this, sourceId]() { feed(sourceId); }, Qt::DirectConnection);
+        return sourceId;
+    }
+
+    // Thread-safe and lock-free, feeding arms the source. Disarm, e.g., when the monitored loop is stopped on purpose.
+    void feed(int sourceId);
+    void disarm(int sourceId);
+    // For ControlLoop::setHeartbeat: feeds while running, disarms when stopped
+    std::function<void(bool)> getHeartbeat(int sourceId) {
+        return [this, sourceId](bool running) { if (running) feed(sourceId); else disarm(sourceId); };
+    }
+
+    // Called on the watchdog's thread: need to be thread-safe and must not wait for other threads' event loops
+    void setStopAction(std::function<void(const QString &source)> stopAction) { mStopAction = stopAction; }
+    void setReleaseAction(std::function<void()> releaseAction) { mReleaseAction = releaseAction; }
+
+    int getCheckPeriod_ms() const { return mCheckPeriod_ms; }
+    void setCheckPeriod_ms(int checkPeriod_ms) { mCheckPeriod_ms = std::max(checkPeriod_ms, 1); }
+
+    void start();
+    void stop();
+    bool isRunning() const { return mRunning; }
+    bool isTripped() const { return mTripped; }
+
+    QVector<SafetyWatchdogSource> getSources() const;
+    SafetyWatchdogStatistics getStatistics();
+
+signals:
+    // From the watchdog's thread, i.e., queued to receivers in other threads
+    void tripped(const QString &source);
+    void released();
+
+private:
+    struct Source {
+        QString name; // constant after registration
+        qint64 timeout_ns = 0;
+        std::atomic<qint64> lastFeed_ns{0};
+        std::atomic<bool> armed{false};
+        std::atomic<quint64> trips{0};
+        bool timedOut = false; // watchdog thread
+    };
+
+    static qint64 getMonotonicTime_ns();
+    void runThread();
+    void check();
+
+    std::array<Source, MAX_SOURCES> mSources;
+    std::atomic<int> mNumSources{0};
+    std::function<void(const QString &)> mStopAction;
+    std::function<void()> mReleaseAction;
+    std::atomic<int> mCheckPeriod_ms{DEFAULT_CHECK_PERIOD_MS};
+    std::atomic<bool> mTripped{false};
+    ClockTimer mEventLoopTimer;
+    int mEventLoopSource = -1;
+
+    std::thread mThread;
+    std::mutex mThreadMutex;
+    std::condition_variable mThreadCondition;
+    std::atomic<bool> mRunning{false};
+
+    std::mutex mStatisticsMutex;
+    SafetyWatchdogStatistics mStatistics;
+};
+
+#endif // SAFETYWATCHDOG_H
@@ -0,0 +1,136 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "sensorhealthmonitor.h"
+#include <QDebug>
+#include <QStringList>
+#include <algorithm>
+
+SensorHealthMonitor::SensorHealthMonitor(QObject *parent) : QObject(parent)
+{
+    connect(&mEvaluationTimer, &ClockTimer::timeout, this, &SensorHealthMonitor::evaluate);
+    mLastEvaluation_us = mLastSummary_us = mClock.load()->now_us();
+    mEvaluationTimer.start(DEFAULT_EVALUATION_INTERVAL_MS);
+}
+
+SensorHealthMonitor::~SensorHealthMonitor()
+{
+    for (const auto &removeCallback : mTopicCallbackRemovers)
+        removeCallback();
+}
+
+int SensorHealthMonitor::registerSource(const QString &name, double expectedRate_Hz, double degradedRateRatio)
+{
+    const int sourceId = mNumSources;
+    if (sourceId >= MAX_SOURCES) {
+        qDebug() << "Warning: SensorHealthMonitor cannot monitor more than" << MAX_SOURCES << "sources, ignoring" << name;
+        return -1;
+    }
+
+    Source &source = mSources[sourceId];
+    source.health.name = name;
+    source.health.expectedRate_Hz = expectedRate_Hz;
+    source.degradedRateRatio = degradedRateRatio;
+    source.lastSample_us = mClock.load()->now_us();
+    mNumSources = sourceId + 1; // publishes the source to recordSample
+    return sourceId;
+}
+
+void SensorHealthMonitor::recordSample(int sourceId)
+{
+    if (sourceId < 0 || sourceId >= mNumSources.load(std::memory_order_acquire))
+        return;
+
+    Source &source = mSources[sourceId];
+    const qint64 now_us = mClock.load(std::memory_order_relaxed)->now_us();
+    const qint64 interval_us = now_us - source.lastSample_us.exchange(now_us, std::memory_order_relaxed);
+    if (source.samples.fetch_add(1, std::memory_order_relaxed) > 0)
+        source.intervalSum_us.fetch_add(interval_us, std::memory_order_relaxed);
+
+    qint64 maxInterval_us = source.maxInterval_us.load(std::memory_order_relaxed);
+    while (interval_us > maxInterval_us && !source.maxInterval_us.compare_exchange_weak(maxInterval_us, interval_us, std::memory_order_relaxed));
+}
+
+QVector<SensorHealth> SensorHealthMonitor::getHealth() const
+{
+    QVector<SensorHealth> health;
+    for (int i = 0; i < mNumSources; i++)
+        health.append(mSources[i].health);
+    return health;
+}
+
+QString SensorHealthMonitor::getSummary() const
+{
+    QStringList sources;
+    for (int i = 0; i < mNumSources; i++) {
+        const SensorHealth &health = mSources[i].health;
+        sources.append(QString("%1 %2/%3 Hz%4").arg(health.name).arg(health.rate_Hz, 0, 'g', 3).arg(health.expectedRate_Hz, 0, 'g', 3)
+                       .arg(health.degraded ? " DEGRADED" : ""));
+    }
+    return sources.join(", ");
+}
+
+void SensorHealthMonitor::setEvaluationInterval_ms(int evaluationInterval_ms)
+{
+    mEvaluationTimer.start(std::max(evaluationInterval_ms, 1));
+}
+
+void SensorHealthMonitor::setClock(Clock *clock)
+{
+    mClock = clock ? clock : Clock::realTime();
+    mEvaluationTimer.setClock(clock);
+    mLastEvaluation_us = mLastSummary_us = mClock.load()->now_us();
+    for (int i = 0; i < mNumSources; i++)
+        mSources[i].lastSample_us = mLastEvaluation_us;
+}
+
+void SensorHealthMonitor::evaluate()
+{
+    const qint64 now_us = mClock.load()->now_us();
+    const double elapsed_s = (now_us - mLastEvaluation_us) / 1e6;
+    mLastEvaluation_us = now_us;
+    if (elapsed_s <= 0.0)
+        return;
+
+    quint32 degradedSources = 0;
+    double minRateRatio = 1.0;
+    for (int i = 0; i < mNumSources; i++) {
+        Source &source = mSources[i];
+        SensorHealth &health = source.health;
+        const quint64 samples = source.samples.load(std::memory_order_relaxed);
+
+        health.samples = samples;
+        health.rate_Hz = (samples - source.samplesAtLastEvaluation) / elapsed_s;
+        health.maxInterval_ms = std::max(source.maxInterval_us.exchange(0, std::memory_order_relaxed),
+                                         now_us - source.lastSample_us.load(std::memory_order_relaxed)) / 1000.0;
+        health.meanInterval_ms = samples > 1 ? source.intervalSum_us.load(std::memory_order_relaxed) / 1000.0 / (samples - 1) : 0.0;
+        source.samplesAtLastEvaluation = samples;
+
+        const double rateRatio = health.expectedRate_Hz > 0.0 ? health.rate_Hz / health.expectedRate_Hz : 1.0;
+        minRateRatio = std::min(minRateRatio, rateRatio);
+        const bool degraded = rateRatio < source.degradedRateRatio;
+        if (degraded != health.degraded) {
+            health.degraded = degraded;
+            if (degraded) {
+                qWarning() << "Warning: sensor" << health.name << "degraded:" << health.rate_Hz << "Hz, expected" << health.expectedRate_Hz
+                           << "Hz (max. interval" << health.maxInterval_ms << "ms)";
+                emit sourceDegraded(i, health.rate_Hz);
+            } else {
+                qInfo() << "Sensor" << health.name << "recovered:" << health.rate_Hz << "Hz";
+                emit sourceRecovered(i, health.rate_Hz);
+            }
+        }
+        if (degraded)
+            degradedSources |= (1u << i);
+    }
+    mDegradedSources = degradedSources;
+    mMinRateRatio = minRateRatio;
+
+    if (mSummaryInterval_ms > 0 && mNumSources > 0 && now_us - mLastSummary_us >= mSummaryInterval_ms * 1000ll) {
+        mLastSummary_us = now_us;
+        qInfo().noquote() << "Sensor health:" << getSummary();
+    }
+
+    emit evaluated();
+}
@@ -0,0 +1,114 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Registry of sensor sources (e.g., GNSS NAV-PVT, IMU, motor controller odometry, UWB, camera) with their expected rates.
+ * Every sample is recorded with a few relaxed atomic operations from whichever thread delivers it (no locks), rates and
+ * inter-arrival statistics are evaluated periodically on the monitor's thread. A source is degraded when its rate over the
+ * last evaluation interval is below degradedRateRatio times the expected rate; changes are logged (i.e., also to Logger) and signalled.
+ * getSummary() gives one compact line for all sources, which is logged every summary interval and in MavsdkVehicleServer
+ * degraded sources are sent as bitmask (NAMED_VALUE_FLOAT "SNS_DEG", bit = source ID) together with the worst rate ratio ("SNS_MIN").
+ */
+
+#ifndef SENSORHEALTHMONITOR_H
+#define SENSORHEALTHMONITOR_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <functional>
+#include "core/clock.h"
+#include "core/topicbus.h"
+
+struct SensorHealth {
+    QString name;
+    double expectedRate_Hz = 0.0;
+    double rate_Hz = 0.0; // over the last evaluation interval
+    double maxInterval_ms = 0.0; // longest time between two samples in the last evaluation interval (incl. since the last sample)
+    double meanInterval_ms = 0.0; // since registration
+    quint64 samples = 0;
+    bool degraded = false;
+};
+
+class SensorHealthMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int MAX_SOURCES = 24; // fits a float bitmask exactly
+    static constexpr int DEFAULT_EVALUATION_INTERVAL_MS = 1000;
+    static constexpr int DEFAULT_SUMMARY_INTERVAL_MS = 60000; // 0: no periodic summary
+    static constexpr double DEFAULT_DEGRADED_RATE_RATIO = 0.8;
+
+    explicit SensorHealthMonitor(QObject *parent = nullptr);
+    ~SensorHealthMonitor();
+
+    // Returns the source ID for recordSample(), -1 if MAX_SOURCES are registered
+    int registerSource(const QString &name, double expectedRate_Hz, double degradedRateRatio = DEFAULT_DEGRADED_RATE_RATIO);
+    // Thread-safe and lock-free, i.e., can be called from I/O threads
+    void recordSample(int sourceId);
+
+    // Records a sample on every emission of signal (on the sender's thread), returns the source ID
+    template<typename Sender, typename Signal>
+    int monitorSignal(const Sender *sender, Signal signal, const QString &name, double expectedRate_Hz, double degradedRateRatio = DEFAULT_DEGRADED_RATE_RATIO) {
+        const int sourceId = registerSource(name, expectedRate_Hz, degradedRateRatio);
+        if (sourceId >= 0)
+            connect(sender, signal, this, [this, sourceId]() { recordSample(sourceId); }, Qt::DirectConnection);
+        return sourceId;
+    }
+    // Same for every message published to topic (on the publisher's thread), the callback is removed with the monitor
+    template<typename T>
+    int monitorTopic(Topic<T> *topic, const QString &name, double expectedRate_Hz, double degradedRateRatio = DEFAULT_DEGRADED_RATE_RATIO) {
+        const int sourceId = registerSource(name, expectedRate_Hz, degradedRateRatio);
+        if (sourceId >= 0 && topic) {
+            const int callbackId = topic->addCallback([this, sourceId](const T &) { recordSample(sourceId); });
+            if (callbackId >= 0)
+                mTopicCallbackRemovers.append([topic, callbackId]() { topic->removeCallback(callbackId); });
+        }
+        return sourceId;
+    }
+
+    int getNumSources() const { return mNumSources; }
+    QVector<SensorHealth> getHealth() const;
+    quint32 getDegradedSources() const { return mDegradedSources; } // bit i: source i
+    double getMinRateRatio() const { return mMinRateRatio; } // rate / expected rate of the worst source of the last evaluation, 1.0 without sources
+    QString getSummary() const; // e.g., "GNSS 9.9/10 Hz, IMU 50/50 Hz, ODOM 2/50 Hz DEGRADED"
+
+    void setEvaluationInterval_ms(int evaluationInterval_ms);
+    void setSummaryInterval_ms(int summaryInterval_ms) { mSummaryInterval_ms = summaryInterval_ms; }
+    void setClock(Clock *clock); // nullptr: real-time clock
+
+signals:
+    void sourceDegraded(int sourceId, double rate_Hz);
+    void sourceRecovered(int sourceId, double rate_Hz);
+    void evaluated(); // new health for all sources
+
+private:
+    struct Source {
+        // Written by recordSample
+        std::atomic<quint64> samples{0};
+        std::atomic<qint64> lastSample_us{0};
+        std::atomic<qint64> maxInterval_us{0}; // reset by evaluation
+        std::atomic<qint64> intervalSum_us{0};
+        // Monitor thread
+        SensorHealth health;
+        double degradedRateRatio = DEFAULT_DEGRADED_RATE_RATIO;
+        quint64 samplesAtLastEvaluation = 0;
+    };
+
+    void evaluate();
+
+    std::array<Source, MAX_SOURCES> mSources;
+    std::atomic<int> mNumSources{0};
+    std::atomic<Clock*> mClock{Clock::realTime()};
+    ClockTimer mEvaluationTimer;
+    qint64 mLastEvaluation_us = 0;
+    qint64 mLastSummary_us = 0;
+    int mSummaryInterval_ms = DEFAULT_SUMMARY_INTERVAL_MS;
+    std::atomic<quint32> mDegradedSources{0};
+    std::atomic<double> mMinRateRatio{1.0};
+    QVector<std::function<void()>> mTopicCallbackRemovers;
+};
+
+#endif // SENSORHEALTHMONITOR_H
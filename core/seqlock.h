@@ -0,0 +1,97 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Sequence lock for publishing snapshots of trivially copyable state between threads.
+ * Readers never block writers and always get a consistent snapshot (they retry if a write happened meanwhile).
+ * Writers are serialized by a spinlock, write-heavy state should not use this.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+template<typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    SeqLock(const T &value = T()) { storeUnlocked(value); }
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    T load() const {
+        Words words;
+        uint32_t sequenceBefore, sequenceAfter;
+        do {
+            while ((sequenceBefore = mSequence.load(std::memory_order_acquire)) & 1) // write in progress
+                std::this_thread::yield();
+
+            for (size_t i = 0; i < mNumWords; i++)
+                words[i] = mWords[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            sequenceAfter = mSequence.load(std::memory_order_relaxed);
+        } while (sequenceBefore != sequenceAfter);
+
+        T value;
+        memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+    void store(const T &value) {
+        lockWriters();
+        storeUnlocked(value);
+        unlockWriters();
+    }
+
+    // Read-modify-write that is atomic with respect to other writers, e.g., to update single fields from different threads
+    template<typename Function>
+    void update(Function modify) {
+        lockWriters();
+        T value = load();
+        modify(value);
+        storeUnlocked(value);
+        unlockWriters();
+    }
+
+private:
+    static constexpr size_t mNumWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    typedef std::array<uint64_t, mNumWords> Words;
+
+    void lockWriters() {
+        while (mWriterLock.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    void unlockWriters() {
+        mWriterLock.clear(std::memory_order_release);
+    }
+
+    void storeUnlocked(const T &value) {
+        Words words = {};
+        memcpy(words.data(), &value, sizeof(T));
+
+        const uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+        mSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < mNumWords; i++)
+            mWords[i].store(words[i], std::memory_order_relaxed);
+
+        mSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    std::atomic<uint32_t> mSequence{0};
+    std::atomic_flag mWriterLock = ATOMIC_FLAG_INIT;
+    std::array<std::atomic<uint64_t>, mNumWords> mWords{};
+};
+
+#endif // SEQLOCK_H
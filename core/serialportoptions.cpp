@@ -0,0 +1,112 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "serialportoptions.h"
+#include <QDebug>
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef Q_OS_LINUX
+bool enableLowLatency(int fd, const QString &portName)
+{
+    serial_struct serial;
+    if (ioctl(fd, TIOCGSERIAL, &serial) != 0) {
+        qDebug() << "WARNING: could not read serial settings of" << portName << ":" << strerror(errno);
+        return false;
+    }
+
+    if (serial.flags & ASYNC_LOW_LATENCY)
+        return true;
+    serial.flags |= ASYNC_LOW_LATENCY;
+    if (ioctl(fd, TIOCSSERIAL, &serial) != 0) {
+        qDebug() << "WARNING: could not set low latency mode of" << portName << ":" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool setReadThreshold(int fd, int readThreshold, const QString &portName)
+{
+    termios settings;
+    if (tcgetattr(fd, &settings) != 0) {
+        qDebug() << "WARNING: could not read termios settings of" << portName << ":" << strerror(errno);
+        return false;
+    }
+
+    settings.c_cc[VMIN] = cc_t(qBound(0, readThreshold, 255));
+    settings.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &settings) != 0) {
+        qDebug() << "WARNING: could not set read threshold of" << portName << ":" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+#endif
+}
+
+bool serialPortOptions::apply(QSerialPort &serialPort, const SerialPortOptions &options)
+{
+    if (!serialPort.isOpen()) {
+        qDebug() << "WARNING: serial port options can only be applied to open ports";
+        return false;
+    }
+
+    serialPort.setReadBufferSize(options.readBufferSize);
+
+#ifdef Q_OS_LINUX
+    const int fd = int(serialPort.handle());
+    bool result = true;
+    if (options.lowLatency)
+        result = enableLowLatency(fd, serialPort.portName());
+    if (options.readThreshold > 0)
+        result = setReadThreshold(fd, options.readThreshold, serialPort.portName()) && result;
+    return result;
+#else
+    if (options.lowLatency || options.readThreshold > 0) {
+        qDebug() << "WARNING: serial port low latency options are only supported on Linux.";
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool serialPortOptions::applyToDevice(const QSerialPortInfo &serialPortInfo, const SerialPortOptions &options)
+{
+    if (!options.lowLatency)
+        return true;
+
+#ifdef Q_OS_LINUX
+    const int fd = open(serialPortInfo.systemLocation().toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        qDebug() << "WARNING: could not open" << serialPortInfo.systemLocation() << ":" << strerror(errno);
+        return false;
+    }
+    const bool result = enableLowLatency(fd, serialPortInfo.portName());
+    close(fd);
+    return result;
+#else
+    Q_UNUSED(serialPortInfo)
+    qDebug() << "WARNING: serial port low latency options are only supported on Linux.";
+    return false;
+#endif
+}
+
+bool serialPortOptions::isLowLatency(QSerialPort &serialPort)
+{
+#ifdef Q_OS_LINUX
+    serial_struct serial;
+    return serialPort.isOpen() && ioctl(int(serialPort.handle()), TIOCGSERIAL, &serial) == 0 && (serial.flags & ASYNC_LOW_LATENCY);
+#else
+    Q_UNUSED(serialPort)
+    return false;
+#endif
+}
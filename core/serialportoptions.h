@@ -0,0 +1,34 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Latency related options of serial ports, applied after a QSerialPort was opened and configured (QSerialPort rewrites
+ * the termios settings on configuration changes). Only supported on Linux:
+ * - lowLatency: enables ASYNC_LOW_LATENCY of the tty driver (disabled: left as is). For FTDI adapters this also sets
+ *   their latency timer to 1 ms (default 16 ms, i.e., small packets are delivered up to 16 ms late).
+ * - readThreshold: VMIN, the port becomes readable (readyRead) once this many bytes arrived. Only useful for fixed-size
+ *   frames, smaller frames are held back until more data arrives.
+ * The driver options stay set after the port is closed, i.e., they can be applied before handing a device to a library
+ * that opens it itself (e.g., MAVSDK).
+ */
+
+#ifndef SERIALPORTOPTIONS_H
+#define SERIALPORTOPTIONS_H
+
+#include <QSerialPort>
+#include <QSerialPortInfo>
+
+struct SerialPortOptions {
+    bool lowLatency = false;
+    int readThreshold = 0; // [bytes], 0: readable on any data
+    qint64 readBufferSize = 0; // QSerialPort::setReadBufferSize, 0: unlimited
+};
+
+namespace serialPortOptions {
+// Returns false if an option could not be applied
+bool apply(QSerialPort &serialPort, const SerialPortOptions &options);
+bool applyToDevice(const QSerialPortInfo &serialPortInfo, const SerialPortOptions &options); // lowLatency only
+bool isLowLatency(QSerialPort &serialPort);
+}
+
+#endif // SERIALPORTOPTIONS_H
@@ -3,24 +3,49 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "simplewatchdog.h"
-#include <QTime>
+#include "communication/parameterserver.h"
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QThread>
 #include <QDebug>
+#include <algorithm>
+
+int EventLoopProfile::getHistogramBucket(double value_us)
+{
+    return std::upper_bound(histogramBucketLimits_us.begin(), histogramBucketLimits_us.end(), value_us) - histogramBucketLimits_us.begin();
+}
+
+uint qHash(const SimpleWatchdog::OffenderKey &key, uint seed)
+{
+    return qHash(quintptr(key.receiverClass), seed) ^ qHash(quintptr(key.parentClass), seed) ^ qHash(key.objectName, seed) ^ uint(key.eventType);
+}
 
 SimpleWatchdog::SimpleWatchdog(QObject *parent) : QObject(parent)
 {
-    connect(&mWatchdogTimer, &QTimer::timeout, [this](){
-        static QTime last = QTime::currentTime();
-        int timeTaken_ms = QTime::currentTime().msecsSinceStartOfDay() - last.msecsSinceStartOfDay();
+    mLastWatchdogTick_us = mWatchdogTimer.getClock()->now_us();
+    connect(&mWatchdogTimer, &ClockTimer::timeout, [this](){
+        const qint64 now_us = mWatchdogTimer.getClock()->now_us();
+        int timeTaken_ms = (now_us - mLastWatchdogTick_us) / 1000;
 
         if (timeTaken_ms > timeout_ms + timeout_tolerance_ms) {
             qDebug() << "WARNING: SimpleWatchdog timed out, EventLoop slowed down? Time taken:" << timeTaken_ms << "ms (time out:" << timeout_ms << "ms, tolerance:" << timeout_tolerance_ms << "ms).";
+            if (mProfilingEnabled && mSlowestSinceLastTick.count > 0)
+                qDebug() << "WARNING: SimpleWatchdog, slowest event dispatch:" << mSlowestSinceLastTick.receiver << "event type" << mSlowestSinceLastTick.eventType
+                         << "took" << mSlowestSinceLastTick.maxDuration_us / 1000.0 << "ms.";
             emit timeout(timeTaken_ms);
         }
-        last = QTime::currentTime();
+        mSlowestSinceLastTick = EventLoopOffender();
+        mLastWatchdogTick_us = now_us;
     });
     mWatchdogTimer.start(timeout_ms);
 }
 
+SimpleWatchdog::~SimpleWatchdog()
+{
+    setProfilingEnabled(false);
+}
+
 int SimpleWatchdog::getTimeout() const
 {
     return timeout_ms;
@@ -32,6 +57,12 @@ void SimpleWatchdog::setTimeout(const int &value_ms)
     mWatchdogTimer.start(timeout_ms);
 }
 
+void SimpleWatchdog::setClock(Clock *clock)
+{
+    mWatchdogTimer.setClock(clock);
+    mLastWatchdogTick_us = mWatchdogTimer.getClock()->now_us();
+}
+
 int SimpleWatchdog::getTimeoutTolerance() const
 {
     return timeout_tolerance_ms;
@@ -41,3 +72,132 @@ void SimpleWatchdog::setTimeoutTolerance(const int &value)
 {
     timeout_tolerance_ms = value;
 }
+
+void SimpleWatchdog::setProfilingEnabled(bool enabled)
+{
+    // Event filter and dispatcher connection need to be set up on the watchdog's thread, e.g., not from a ParameterServer callback thread
+    if (thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(this, [this, enabled]() { setProfilingEnabled(enabled); }, Qt::QueuedConnection);
+        return;
+    }
+
+    if (enabled == mProfilingEnabled || !QCoreApplication::instance())
+        return;
+
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread());
+    if (enabled) {
+        QCoreApplication::instance()->installEventFilter(this);
+        if (dispatcher)
+            connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, [this]() { finishDispatch(std::chrono::steady_clock::now()); });
+    } else {
+        QCoreApplication::instance()->removeEventFilter(this);
+        if (dispatcher)
+            disconnect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, nullptr);
+        mDispatchActive = false;
+    }
+    mProfilingEnabled = enabled;
+}
+
+bool SimpleWatchdog::eventFilter(QObject *watched, QEvent *event)
+{
+    // Application-wide filters see events of all objects in the main thread, only this watchdog's thread is profiled
+    if (watched->thread() == thread()) {
+        const auto now = std::chrono::steady_clock::now();
+        finishDispatch(now);
+
+        mCurrentDispatch.receiverClass = watched->metaObject();
+        mCurrentDispatch.parentClass = watched->parent() ? watched->parent()->metaObject() : nullptr;
+        mCurrentDispatch.objectName = watched->objectName();
+        mCurrentDispatch.eventType = event->type();
+        mCurrentDispatchStart = now;
+        mDispatchActive = true;
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void SimpleWatchdog::finishDispatch(std::chrono::steady_clock::time_point end)
+{
+    if (!mDispatchActive)
+        return;
+    mDispatchActive = false;
+
+    const double duration_us = std::chrono::duration<double, std::micro>(end - mCurrentDispatchStart).count();
+    mProfile.dispatches++;
+    mProfile.maxDuration_us = std::max(mProfile.maxDuration_us, duration_us);
+    mProfile.histogram[EventLoopProfile::getHistogramBucket(duration_us)]++;
+
+    if (duration_us < mOffenderThreshold_us)
+        return;
+
+    EventLoopOffender &offender = mOffenders[mCurrentDispatch];
+    if (offender.count == 0) {
+        offender.receiver = QString(mCurrentDispatch.receiverClass->className());
+        if (!mCurrentDispatch.objectName.isEmpty())
+            offender.receiver += " (" + mCurrentDispatch.objectName + ")";
+        if (mCurrentDispatch.parentClass)
+            offender.receiver += QString(" [") + mCurrentDispatch.parentClass->className() + "]";
+        offender.eventType = mCurrentDispatch.eventType;
+    }
+    offender.count++;
+    offender.maxDuration_us = std::max(offender.maxDuration_us, duration_us);
+    offender.totalDuration_us += duration_us;
+
+    if (duration_us > mSlowestSinceLastTick.maxDuration_us) {
+        mSlowestSinceLastTick = offender;
+        mSlowestSinceLastTick.maxDuration_us = duration_us;
+    }
+}
+
+EventLoopProfile SimpleWatchdog::getProfile(int topN) const
+{
+    EventLoopProfile profile = mProfile;
+    profile.topOffenders = mOffenders.values().toVector();
+    std::sort(profile.topOffenders.begin(), profile.topOffenders.end(), [](const EventLoopOffender &a, const EventLoopOffender &b) {
+        return a.maxDuration_us > b.maxDuration_us;
+    });
+    if (profile.topOffenders.size() > topN)
+        profile.topOffenders.resize(topN);
+
+    return profile;
+}
+
+void SimpleWatchdog::resetProfile()
+{
+    mProfile = EventLoopProfile();
+    mOffenders.clear();
+}
+
+void SimpleWatchdog::dumpProfile(int topN) const
+{
+    const EventLoopProfile profile = getProfile(topN);
+
+    qInfo() << "SimpleWatchdog event loop profile:" << profile.dispatches << "dispatches, longest" << profile.maxDuration_us / 1000.0 << "ms.";
+    QString histogram;
+    for (int bucket = 0; bucket < EventLoopProfile::numHistogramBuckets; bucket++) {
+        if (bucket < (int)EventLoopProfile::histogramBucketLimits_us.size())
+            histogram += QString("<%1us: %2 ").arg(EventLoopProfile::histogramBucketLimits_us[bucket]).arg(profile.histogram[bucket]);
+        else
+            histogram += QString("more: %1").arg(profile.histogram[bucket]);
+    }
+    qInfo() << "SimpleWatchdog histogram:" << histogram;
+    for (const EventLoopOffender &offender : profile.topOffenders)
+        qInfo() << "SimpleWatchdog offender:" << offender.receiver << "event type" << offender.eventType << "max" << offender.maxDuration_us / 1000.0 << "ms,"
+                << offender.count << "times >" << mOffenderThreshold_us / 1000.0 << "ms, total" << offender.totalDuration_us / 1000.0 << "ms.";
+}
+
+void SimpleWatchdog::provideParametersToParameterServer(const std::string &prefix)
+{
+    ParameterServer *parameterServer = ParameterServer::getInstance();
+    if (!parameterServer)
+        return;
+
+    parameterServer->provideIntParameter(prefix + "_PROF", [this](int value) { setProfilingEnabled(value); }, [this]() { return (int)isProfilingEnabled(); });
+    parameterServer->provideIntParameter(prefix + "_DUMP", [this](int) {
+        QMetaObject::invokeMethod(this, [this]() {
+            dumpProfile();
+            resetProfile();
+        }, Qt::QueuedConnection);
+    }, []() { return 0; });
+    parameterServer->provideFloatParameter(prefix + "_MAX_MS", [](float) {}, [this]() { return (float)(mProfile.maxDuration_us / 1000.0); });
+}
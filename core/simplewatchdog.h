@@ -2,20 +2,51 @@
  *     Copyright 2021 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
- * A simple class to detect when Qt's event loop takes longer than expected
+ * A simple class to detect when Qt's event loop takes longer than expected.
+ * Optionally profiles the event loop (of the thread the watchdog lives in) to find out what blocked it:
+ * an application-wide event filter marks the start of each event dispatch, the next dispatch or the event dispatcher
+ * going idle marks its end. Durations are kept as histogram and per receiver/event type (top offenders).
  */
 
 #ifndef SIMPLEWATCHDOG_H
 #define SIMPLEWATCHDOG_H
 
 #include <QObject>
-#include <QTimer>
+#include "core/clock.h"
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <array>
+#include <chrono>
+#include <string>
+
+struct EventLoopOffender {
+    QString receiver; // class (objectName) [parent class] of the receiving object
+    int eventType = 0; // QEvent::Type, e.g., 1: Timer, 43: MetaCall (queued slot)
+    quint64 count = 0; // dispatches longer than the offender threshold
+    double maxDuration_us = 0.0;
+    double totalDuration_us = 0.0;
+};
+
+struct EventLoopProfile {
+    // Upper limits of the histogram buckets [us], last bucket collects everything above
+    static constexpr std::array<double, 7> histogramBucketLimits_us = {100, 500, 1000, 5000, 10000, 20000, 50000};
+    static constexpr int numHistogramBuckets = histogramBucketLimits_us.size() + 1;
+
+    quint64 dispatches = 0;
+    double maxDuration_us = 0.0;
+    std::array<quint64, numHistogramBuckets> histogram = {};
+    QVector<EventLoopOffender> topOffenders; // sorted by max duration, longest first
+
+    static int getHistogramBucket(double value_us);
+};
 
 class SimpleWatchdog : public QObject
 {
     Q_OBJECT
 public:
     explicit SimpleWatchdog(QObject *parent = nullptr);
+    ~SimpleWatchdog();
 
     int getTimeout() const;
     void setTimeout(const int &value_ms);
@@ -23,14 +54,53 @@ public:
     int getTimeoutTolerance() const;
     void setTimeoutTolerance(const int &value_ms);
 
+    void setClock(Clock *clock); // watchdog period, nullptr: real-time clock (profiling always measures real time)
+
+    bool isProfilingEnabled() const { return mProfilingEnabled; }
+    void setProfilingEnabled(bool enabled);
+    // Only dispatches taking longer are tracked per receiver [us]
+    double getOffenderThreshold_us() const { return mOffenderThreshold_us; }
+    void setOffenderThreshold_us(double offenderThreshold_us) { mOffenderThreshold_us = offenderThreshold_us; }
+    EventLoopProfile getProfile(int topN = 10) const;
+    void resetProfile();
+    void dumpProfile(int topN = 10) const; // via qInfo, i.e., also Logger (and MAVLink if connected)
+
+    // Provides <prefix>_PROF (enable profiling), <prefix>_DUMP (write to dump and reset) and <prefix>_MAX_MS (longest dispatch, read-only)
+    void provideParametersToParameterServer(const std::string &prefix);
+
 signals:
     void timeout(int timeTaken_ms);
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private:
-    QTimer mWatchdogTimer;
+    struct OffenderKey {
+        const QMetaObject *receiverClass;
+        const QMetaObject *parentClass;
+        QString objectName;
+        int eventType;
+        bool operator==(const OffenderKey &other) const {
+            return receiverClass == other.receiverClass && parentClass == other.parentClass && eventType == other.eventType && objectName == other.objectName;
+        }
+    };
+    friend uint qHash(const OffenderKey &key, uint seed);
+
+    void finishDispatch(std::chrono::steady_clock::time_point end);
+
+    ClockTimer mWatchdogTimer;
     int timeout_ms = 20;
     int timeout_tolerance_ms = 5;
+    qint64 mLastWatchdogTick_us;
 
+    bool mProfilingEnabled = false;
+    double mOffenderThreshold_us = 1000.0;
+    bool mDispatchActive = false;
+    OffenderKey mCurrentDispatch;
+    std::chrono::steady_clock::time_point mCurrentDispatchStart;
+    EventLoopProfile mProfile;
+    QHash<OffenderKey, EventLoopOffender> mOffenders;
+    EventLoopOffender mSlowestSinceLastTick; // reported with watchdog timeouts
 };
 
 #endif // SIMPLEWATCHDOG_H
@@ -0,0 +1,59 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Bounded lock-free single-producer/single-consumer ring buffer, e.g., to hand over decoded messages from an I/O thread.
+ * Exactly one thread may push and exactly one (other) thread may pop. A full queue rejects new elements.
+ */
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side, returns false (and drops the element) if the queue is full
+    bool push(const T &element) {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mTail.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        mElements[head & (Capacity - 1)] = element;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false if the queue is empty
+    bool pop(T &element) {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail == mHead.load(std::memory_order_acquire))
+            return false;
+
+        element = mElements[tail & (Capacity - 1)];
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const { return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire); }
+    size_t size() const { return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire); }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    // Producer and consumer index on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> mHead{0};
+    alignas(64) std::atomic<size_t> mTail{0};
+    std::array<T, Capacity> mElements;
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,59 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "startupprofile.h"
+#include "perfcounters.h"
+#include <QDebug>
+#include <chrono>
+
+namespace {
+// Dynamic initialization runs before main(), i.e., close to process start
+const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+}
+
+StartupProfile &StartupProfile::getInstance()
+{
+    static StartupProfile instance;
+    return instance;
+}
+
+double StartupProfile::getTimeSinceStart_ms()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - processStart).count();
+}
+
+bool StartupProfile::markPhase(const QString &name)
+{
+    const double sinceStart_ms = getTimeSinceStart_ms();
+    double previous_ms = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const StartupPhase &phase : mPhases)
+            if (phase.name == name)
+                return false;
+        if (!mPhases.isEmpty())
+            previous_ms = mPhases.last().sinceStart_ms;
+        mPhases.append({name, sinceStart_ms});
+    }
+
+    PerfCounters &perfCounters = PerfCounters::getInstance();
+    perfCounters.setGauge(perfCounters.registerCounter(name, PerfCounters::Type::Gauge), sinceStart_ms);
+    qDebug().noquote() << QString("Startup: %1 after %2 ms (+%3 ms)").arg(name).arg(sinceStart_ms, 0, 'f', 1).arg(sinceStart_ms - previous_ms, 0, 'f', 1);
+    return true;
+}
+
+bool StartupProfile::hasPhase(const QString &name) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const StartupPhase &phase : mPhases)
+        if (phase.name == name)
+            return true;
+    return false;
+}
+
+QVector<StartupPhase> StartupProfile::getPhases() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPhases;
+}
@@ -0,0 +1,44 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Process-wide timing of startup phases, e.g., vehicle boot to ready (MavsdkVehicleServer) or station connect: the time from
+ * process start (static initialization) at which each phase was first reached. Later marks of a phase are ignored (a short
+ * locked lookup, hot paths should keep their own flag). Phases are logged and published
+ * as perf counter gauges [ms] under their name (up to PerfCounters::MAX_NAME_LENGTH), i.e., a vehicle's boot phases are seen
+ * by the station (see PerfCountersUI).
+ *
+ *     StartupProfile::getInstance().markPhase("ST_LISTEN");
+ */
+
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+#include <QString>
+#include <QVector>
+#include <mutex>
+
+struct StartupPhase {
+    QString name;
+    double sinceStart_ms = 0.0;
+};
+
+class StartupProfile
+{
+public:
+    static StartupProfile &getInstance();
+    static double getTimeSinceStart_ms();
+
+    // Returns true if the phase was reached for the first time
+    bool markPhase(const QString &name);
+    bool hasPhase(const QString &name) const;
+    QVector<StartupPhase> getPhases() const; // in the order reached
+
+private:
+    StartupProfile() = default;
+
+    mutable std::mutex mMutex;
+    QVector<StartupPhase> mPhases;
+};
+
+#endif // STARTUPPROFILE_H
@@ -0,0 +1,247 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "threadconfig.h"
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <cerrno>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char *getThreadName(ThreadConfig::Role role)
+{
+    // At most 15 characters (pthread_setname_np)
+    switch (role) {
+    case ThreadConfig::Role::Control: return "ww-control";
+    case ThreadConfig::Role::GnssIo: return "ww-gnss-io";
+    case ThreadConfig::Role::ActuatorIo: return "ww-actuator-io";
+    case ThreadConfig::Role::Telemetry: return "ww-telemetry";
+    case ThreadConfig::Role::Logging: return "ww-logging";
+    case ThreadConfig::Role::Safety: return "ww-safety";
+    default: return "ww-worker";
+    }
+}
+}
+
+ThreadConfig &ThreadConfig::getInstance()
+{
+    static ThreadConfig instance;
+    return instance;
+}
+
+QString ThreadConfig::getRoleName(ThreadConfig::Role role)
+{
+    switch (role) {
+    case Role::Control: return "control";
+    case Role::GnssIo: return "gnssIo";
+    case Role::ActuatorIo: return "actuatorIo";
+    case Role::Telemetry: return "telemetry";
+    case Role::Logging: return "logging";
+    case Role::Safety: return "safety";
+    default: return "unknown";
+    }
+}
+
+void ThreadConfig::setSettings(ThreadConfig::Role role, const ThreadSettings &settings)
+{
+    if (role >= Role::_LAST_)
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRoles[int(role)].settings = settings;
+}
+
+ThreadSettings ThreadConfig::getSettings(ThreadConfig::Role role) const
+{
+    if (role >= Role::_LAST_)
+        return ThreadSettings();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRoles[int(role)].settings;
+}
+
+bool ThreadConfig::lockMemory()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMemoryLockRequested = true;
+    if (mMemoryLocked)
+        return true;
+
+#ifdef Q_OS_LINUX
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        mMemoryLockError = strerror(errno);
+        qWarning() << "WARNING: ThreadConfig could not lock memory:" << mMemoryLockError;
+        return false;
+    }
+    mMemoryLocked = true;
+    mMemoryLockError.clear();
+    return true;
+#else
+    mMemoryLockError = "only supported on Linux";
+    qWarning() << "WARNING: ThreadConfig memory locking is only supported on Linux.";
+    return false;
+#endif
+}
+
+bool ThreadConfig::isMemoryLocked() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMemoryLocked;
+}
+
+bool ThreadConfig::loadFromFile(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "WARNING: ThreadConfig could not open" << filename;
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        qWarning() << "WARNING: ThreadConfig could not parse" << filename << ":" << parseError.errorString();
+        return false;
+    }
+
+    const QJsonObject json = document.object();
+    const QJsonObject threads = json.value("threads").toObject();
+    bool ok = true;
+    for (auto it = threads.constBegin(); it != threads.constEnd(); it++) {
+        int role = 0;
+        while (role < NUM_ROLES && getRoleName(Role(role)) != it.key())
+            role++;
+        if (role == NUM_ROLES) {
+            qWarning() << "WARNING: ThreadConfig ignores unknown thread role" << it.key() << "in" << filename;
+            ok = false;
+            continue;
+        }
+
+        const QJsonObject threadJson = it.value().toObject();
+        ThreadSettings settings;
+        for (const QJsonValue &cpu : threadJson.value("cpus").toArray())
+            settings.cpus.append(cpu.toInt(-1));
+        settings.realTimePriority = threadJson.value("priority").toInt(0);
+        setSettings(Role(role), settings);
+    }
+
+    if (json.value("lockMemory").toBool(false))
+        ok = lockMemory() && ok;
+
+    return ok;
+}
+
+bool ThreadConfig::loadFromEnvironment()
+{
+    const QString filename = qEnvironmentVariable(ENVIRONMENT_VARIABLE);
+    if (filename.isEmpty())
+        return true;
+    return loadFromFile(filename);
+}
+
+bool ThreadConfig::applyToCurrentThread(ThreadConfig::Role role)
+{
+    if (role >= Role::_LAST_)
+        return false;
+
+    const ThreadSettings settings = getSettings(role);
+    QStringList errors;
+
+#ifdef Q_OS_LINUX
+    pthread_setname_np(pthread_self(), getThreadName(role));
+
+    if (!settings.cpus.isEmpty()) {
+        const long numCpus = sysconf(_SC_NPROCESSORS_CONF);
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (int cpu : settings.cpus) {
+            if (cpu < 0 || cpu >= numCpus || cpu >= CPU_SETSIZE)
+                errors.append(QString("no CPU %1").arg(cpu));
+            else
+                CPU_SET(cpu, &cpuSet);
+        }
+        if (CPU_COUNT(&cpuSet) > 0) {
+            const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+            if (result != 0)
+                errors.append(QString("CPU affinity: %1").arg(strerror(result)));
+        }
+    }
+
+    if (settings.realTimePriority > 0) {
+        sched_param parameters;
+        parameters.sched_priority = qBound(sched_get_priority_min(SCHED_FIFO), settings.realTimePriority, sched_get_priority_max(SCHED_FIFO));
+        const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+        if (result != 0)
+            errors.append(QString("SCHED_FIFO %1: %2").arg(parameters.sched_priority).arg(strerror(result)));
+    }
+#else
+    if (!settings.isDefault())
+        errors.append("only supported on Linux");
+#endif
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    RoleState &state = mRoles[int(role)];
+    if (errors.isEmpty()) {
+        state.appliedThreads++;
+        return true;
+    }
+
+    state.failedThreads++;
+    state.lastError = errors.join(", ");
+    qWarning() << "WARNING: ThreadConfig could not apply" << getRoleName(role) << "settings:" << state.lastError;
+    return false;
+}
+
+void ThreadConfig::applyOnStart(QThread *thread, ThreadConfig::Role role)
+{
+    if (!thread)
+        return;
+
+    // started is emitted on the new thread
+    QObject::connect(thread, &QThread::started, thread, [role]() {
+        ThreadConfig::getInstance().applyToCurrentThread(role);
+    }, Qt::DirectConnection);
+}
+
+QString ThreadConfig::getReport() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    QStringList lines;
+    if (mMemoryLockRequested)
+        lines.append(QString("memory: %1").arg(mMemoryLocked ? QString("locked") : "NOT LOCKED (" + mMemoryLockError + ")"));
+
+    for (int role = 0; role < NUM_ROLES; role++) {
+        const RoleState &state = mRoles[role];
+        QString line = getRoleName(Role(role)) + ": ";
+        if (!state.settings.cpus.isEmpty()) {
+            QStringList cpus;
+            for (int cpu : state.settings.cpus)
+                cpus.append(QString::number(cpu));
+            line += "CPU " + cpus.join(",") + ", ";
+        } else
+            line += "any CPU, ";
+        line += state.settings.realTimePriority > 0 ? QString("SCHED_FIFO %1").arg(state.settings.realTimePriority) : QString("normal scheduling");
+        line += QString(", %1 thread(s)").arg(state.appliedThreads);
+        if (state.failedThreads > 0)
+            line += QString(", %1 FAILED (%2)").arg(state.failedThreads).arg(state.lastError);
+        lines.append(line);
+    }
+    return lines.join("\n");
+}
+
+void ThreadConfig::logReport() const
+{
+    for (const QString &line : getReport().split("\n"))
+        qDebug().noquote() << "ThreadConfig" << line;
+}
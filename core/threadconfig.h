@@ -0,0 +1,88 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Real-time configuration of WayWise's worker threads in one place: each role (control loops, GNSS I/O, actuator I/O, telemetry,
+ * logging) can be pinned to CPU cores and run with a SCHED_FIFO priority, and the process memory can be locked (no page faults
+ * in the control path). Workers apply the settings of their role on their own thread when they start (ControlLoop in
+ * DEDICATED_THREAD mode: control, the Ublox I/O thread: GNSS I/O, CANopenMovementController's thread: actuator I/O,
+ * ParameterServer's save thread: logging, SafetyWatchdog's thread: safety), i.e., settings need to be made before the workers are started.
+ * An application's own threads can use applyToCurrentThread/applyOnStart with any role (e.g., telemetry for a MAVLink thread).
+ * Only supported on Linux, real-time priorities and memory locking need CAP_SYS_NICE/CAP_IPC_LOCK or rtprio/memlock limits.
+ *
+ * The configuration can be read from a JSON file, e.g., given by the WAYWISE_THREAD_CONFIG environment variable:
+ *     {"lockMemory": true,
+ *      "threads": {"control": {"cpus": [3], "priority": 80}, "gnssIo": {"cpus": [2], "priority": 70}}}
+ */
+
+#ifndef THREADCONFIG_H
+#define THREADCONFIG_H
+
+#include <QString>
+#include <QVector>
+#include <QThread>
+#include <array>
+#include <mutex>
+
+struct ThreadSettings {
+    QVector<int> cpus; // empty: any
+    int realTimePriority = 0; // SCHED_FIFO 1..99, 0: normal scheduling
+
+    bool isDefault() const { return cpus.isEmpty() && realTimePriority == 0; }
+};
+
+class ThreadConfig
+{
+public:
+    enum class Role {
+        Control,
+        GnssIo,
+        ActuatorIo,
+        Telemetry,
+        Logging,
+        Safety,
+        _LAST_
+    };
+    static constexpr int NUM_ROLES = int(Role::_LAST_);
+    static constexpr const char *ENVIRONMENT_VARIABLE = "WAYWISE_THREAD_CONFIG";
+
+    static ThreadConfig &getInstance();
+
+    static QString getRoleName(Role role); // as in the JSON file, e.g., "gnssIo"
+    void setSettings(Role role, const ThreadSettings &settings);
+    ThreadSettings getSettings(Role role) const;
+
+    // mlockall of current and future pages, false if it failed (see getReport)
+    bool lockMemory();
+    bool isMemoryLocked() const;
+
+    bool loadFromFile(const QString &filename); // false (and a warning) if it cannot be read or has errors
+    bool loadFromEnvironment(); // no variable: true and nothing changed
+
+    // Sets CPU affinity, scheduling and the thread name (e.g., "ww-control", shown by top -H) of the calling thread.
+    // Roles with default settings only set the name. false if a setting could not be applied.
+    bool applyToCurrentThread(Role role);
+    // Applies on the thread when it starts, needs to be called before QThread::start
+    void applyOnStart(QThread *thread, Role role);
+
+    QString getReport() const; // configured and applied settings per role
+    void logReport() const;
+
+private:
+    struct RoleState {
+        ThreadSettings settings;
+        int appliedThreads = 0;
+        int failedThreads = 0;
+        QString lastError;
+    };
+
+    ThreadConfig() = default;
+
+    mutable std::mutex mMutex;
+    std::array<RoleState, NUM_ROLES> mRoles;
+    bool mMemoryLockRequested = false;
+    bool mMemoryLocked = false;
+    QString mMemoryLockError;
+};
+
+#endif // THREADCONFIG_H
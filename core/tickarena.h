@@ -0,0 +1,178 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Monotonic per-thread arena for scratch memory of one tick (e.g., a control iteration, see ControlLoop), with ArenaVector
+ * as container on top. Allocations bump a pointer in one buffer, nothing is freed until the scope ends: nested scopes rewind to where
+ * they started, the outermost one resets the arena. When a tick needs more than the buffer, the rest is allocated on the heap
+ * (counted as overflow) and the buffer grows to the tick's high watermark when the outermost scope ends, i.e., steady-state ticks
+ * do not use the general heap. Outside of a scope, ArenaVector falls back to the heap.
+ * Memory from the arena is only valid within the scope it was allocated in, ArenaVectors need to be locals of that scope.
+ *
+ *     TickArena::Scope arenaScope;
+ *     ArenaVector<int> order(count);
+ */
+
+#ifndef TICKARENA_H
+#define TICKARENA_H
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+class TickArena
+{
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 64 * 1024; // allocated on first use
+
+    static TickArena &getThreadArena() {
+        static thread_local TickArena arena;
+        return arena;
+    }
+
+    bool isInScope() const { return mScopeDepth > 0; }
+    std::size_t getCapacity() const { return mCapacity; }
+    std::size_t getHighWatermark() const { return mHighWatermark; } // bytes used by the largest tick
+    quint64 getOverflowCount() const { return mOverflowCount; } // heap allocations because the buffer was full
+
+    // Within a scope only, alignment: power of two
+    void *allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+        if (!mBuffer) {
+            mCapacity = std::max(mCapacity, DEFAULT_CAPACITY);
+            mBuffer.reset(new char[mCapacity]);
+        }
+
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(mBuffer.get());
+        const std::size_t alignedOffset = ((base + mOffset + alignment - 1) & ~std::uintptr_t(alignment - 1)) - base;
+        if (alignedOffset + size <= mCapacity) {
+            mOffset = alignedOffset + size;
+            mHighWatermark = std::max(mHighWatermark, mOffset + mOverflowBytes);
+            return mBuffer.get() + alignedOffset;
+        }
+
+        mOverflowCount++;
+        mOverflowBytes += size + alignment;
+        mHighWatermark = std::max(mHighWatermark, mOffset + mOverflowBytes);
+        mOverflowBlocks.emplace_back(new char[size + alignment]);
+        const std::uintptr_t block = reinterpret_cast<std::uintptr_t>(mOverflowBlocks.back().get());
+        return reinterpret_cast<void *>((block + alignment - 1) & ~std::uintptr_t(alignment - 1));
+    }
+
+    class Scope {
+    public:
+        Scope() : mArena(getThreadArena()), mOffset(mArena.mOffset) { mArena.mScopeDepth++; }
+        ~Scope() { mArena.endScope(mOffset); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    private:
+        TickArena &mArena;
+        std::size_t mOffset;
+    };
+
+private:
+    TickArena() = default;
+
+    void endScope(std::size_t offset) {
+        mOffset = offset;
+        if (--mScopeDepth > 0)
+            return;
+
+        // Outermost scope: overflow blocks are dropped and the next tick fits into the buffer
+        mOffset = 0;
+        if (!mOverflowBlocks.empty()) {
+            mOverflowBlocks.clear();
+            mOverflowBytes = 0;
+            mCapacity = std::max(mCapacity * 2, mHighWatermark);
+            mBuffer.reset(new char[mCapacity]);
+        }
+    }
+
+    std::unique_ptr<char[]> mBuffer;
+    std::size_t mCapacity = 0;
+    std::size_t mOffset = 0;
+    std::size_t mHighWatermark = 0;
+    std::vector<std::unique_ptr<char[]>> mOverflowBlocks;
+    std::size_t mOverflowBytes = 0;
+    quint64 mOverflowCount = 0;
+    int mScopeDepth = 0;
+};
+
+// Vector of trivially copyable elements in the tick arena of the thread it was created on (heap outside of a scope).
+// Growing takes a new block from the arena, the old one is only reclaimed at the end of the scope: reserve when the size is known.
+template<typename T>
+class ArenaVector
+{
+    static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value, "ArenaVector needs trivially copyable elements");
+
+public:
+    ArenaVector() : mArena(TickArena::getThreadArena().isInScope() ? &TickArena::getThreadArena() : nullptr) {}
+    explicit ArenaVector(int size) : ArenaVector() { resize(size); }
+    ~ArenaVector() {
+        if (!mArena)
+            ::operator delete(mData);
+    }
+    ArenaVector(const ArenaVector &) = delete;
+    ArenaVector &operator=(const ArenaVector &) = delete;
+
+    int size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+    int capacity() const { return mCapacity; }
+    T *data() { return mData; }
+    const T *data() const { return mData; }
+    T *begin() { return mData; }
+    T *end() { return mData + mSize; }
+    const T *begin() const { return mData; }
+    const T *end() const { return mData + mSize; }
+    T &operator[](int i) { return mData[i]; }
+    const T &operator[](int i) const { return mData[i]; }
+    const T &at(int i) const { return mData[i]; }
+    T &first() { return mData[0]; }
+    T &last() { return mData[mSize - 1]; }
+
+    void reserve(int capacity) {
+        if (capacity <= mCapacity)
+            return;
+
+        T *data = static_cast<T *>(mArena ? mArena->allocate(capacity * sizeof(T), alignof(T)) : ::operator new(capacity * sizeof(T)));
+        if (mSize > 0)
+            memcpy(static_cast<void *>(data), mData, mSize * sizeof(T));
+        if (!mArena)
+            ::operator delete(mData);
+        mData = data;
+        mCapacity = capacity;
+    }
+    void resize(int size) {
+        reserve(size);
+        for (int i = mSize; i < size; i++)
+            new (mData + i) T();
+        mSize = size;
+    }
+    void append(const T &value) {
+        if (mSize == mCapacity)
+            reserve(std::max(2 * mCapacity, 8));
+        mData[mSize++] = value;
+    }
+    void push_back(const T &value) { append(value); }
+    T *erase(T *first, T *last) {
+        if (first != last) {
+            memmove(static_cast<void *>(first), last, (end() - last) * sizeof(T));
+            mSize -= int(last - first);
+        }
+        return first;
+    }
+    void clear() { mSize = 0; }
+
+private:
+    TickArena *mArena;
+    T *mData = nullptr;
+    int mSize = 0;
+    int mCapacity = 0;
+};
+
+#endif // TICKARENA_H
@@ -0,0 +1,117 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Fixed-capacity ring buffer of samples with monotonically increasing timestamps (oldest samples are overwritten).
+ * Lookup by time is a binary search, samples at times between two entries can be interpolated.
+ */
+
+#ifndef TIMESTAMPEDHISTORY_H
+#define TIMESTAMPEDHISTORY_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <algorithm>
+
+template<typename T>
+class TimestampedHistory
+{
+public:
+    struct Entry {
+        qint64 timestamp;
+        T sample;
+    };
+
+    TimestampedHistory(int capacity = 128) { setCapacity(capacity); }
+
+    int getCapacity() const { return mEntries.size(); }
+    void setCapacity(int capacity) { // clears the history
+        mEntries.resize(std::max(capacity, 1));
+        clear();
+    }
+    void clear() { mFirst = 0; mSize = 0; }
+    int size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+
+    // Index 0 is the oldest entry
+    const Entry &at(int index) const { return mEntries.at((mFirst + index) % mEntries.size()); }
+    const Entry &newest() const { return at(mSize - 1); }
+    const Entry &oldest() const { return at(0); }
+
+    // Samples older than the newest one are dropped, i.e., timestamps are kept monotonic
+    bool append(qint64 timestamp, const T &sample) {
+        if (mSize > 0 && timestamp < newest().timestamp)
+            return false;
+
+        if (mSize < mEntries.size()) {
+            mEntries[(mFirst + mSize) % mEntries.size()] = {timestamp, sample};
+            mSize++;
+        } else {
+            mEntries[mFirst] = {timestamp, sample};
+            mFirst = (mFirst + 1) % mEntries.size();
+        }
+        return true;
+    }
+
+    // E.g., for a correction of the latest sample, does nothing if empty
+    void replaceNewest(const T &sample) {
+        if (mSize > 0)
+            mEntries[(mFirst + mSize - 1) % mEntries.size()].sample = sample;
+    }
+
+    // Index of the first entry with timestamp >= time (size() if there is none)
+    int lowerBound(qint64 time) const {
+        int first = 0;
+        int count = mSize;
+        while (count > 0) {
+            const int step = count / 2;
+            if (at(first + step).timestamp < time) {
+                first += step + 1;
+                count -= step + 1;
+            } else
+                count = step;
+        }
+        return first;
+    }
+
+    // Returns -1 if empty
+    int getClosestIndex(qint64 time) const {
+        if (mSize == 0)
+            return -1;
+
+        const int upper = lowerBound(time);
+        if (upper == 0)
+            return 0;
+        if (upper == mSize)
+            return mSize - 1;
+        return (time - at(upper - 1).timestamp <= at(upper).timestamp - time) ? upper - 1 : upper;
+    }
+
+    // Interpolates between the two entries bracketing time, interpolate(const T &a, const T &b, double fraction) -> T.
+    // Times outside of the history are clamped to the oldest/newest entry. Returns false if empty.
+    template<typename Interpolate>
+    bool getSampleAt(qint64 time, T &sample, Interpolate interpolate) const {
+        if (mSize == 0)
+            return false;
+
+        const int upper = lowerBound(time);
+        if (upper == 0)
+            sample = oldest().sample;
+        else if (upper == mSize)
+            sample = newest().sample;
+        else {
+            const Entry &before = at(upper - 1);
+            const Entry &after = at(upper);
+            const qint64 interval = after.timestamp - before.timestamp;
+            sample = (interval > 0) ? interpolate(before.sample, after.sample, double(time - before.timestamp) / interval) : after.sample;
+        }
+        return true;
+    }
+
+private:
+    QVector<Entry> mEntries;
+    int mFirst;
+    int mSize;
+};
+
+#endif // TIMESTAMPEDHISTORY_H
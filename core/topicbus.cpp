@@ -0,0 +1,29 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "topicbus.h"
+#include <QDebug>
+
+TopicBus &TopicBus::getInstance()
+{
+    static TopicBus instance;
+    return instance;
+}
+
+QStringList TopicBus::getTopicNames() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTopics.keys();
+}
+
+std::shared_ptr<TopicBase> TopicBus::getTopicBase(const QString &name) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTopics.value(name);
+}
+
+void TopicBus::warnTypeMismatch(const QString &name)
+{
+    qWarning() << "WARNING: topic" << name << "exists with another message type";
+}
@@ -0,0 +1,242 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * In-process publish/subscribe bus of typed topics, e.g., sensor samples (see sensors/sensortopics.h) that fusion, autopilot and
+ * telemetry take on their own threads. Messages are trivially copyable structs of fixed layout, copied into preallocated slots:
+ * publishing never allocates or goes through an event loop and can be done from any thread (e.g., an I/O thread).
+ * Each topic keeps its latest message (SeqLock) for readers that only need the newest value, feeds a bounded lock-free queue
+ * (MpscRingBuffer, full queues drop new messages) per queued subscription and calls its direct callbacks on the publisher's thread.
+ * Topics are created on first use by name and type. Creating topics and subscribing take a lock and are meant for setup.
+ * Subscriptions and callbacks are deactivated instead of removed (their slots are not reused), deactivating waits until running
+ * publishes are done, i.e., whatever a notifier or callback refers to can be destroyed afterwards.
+ *
+ *     Topic<GnssPositionMessage> *topic = sensorTopics::gnssPosition();
+ *     topic->publish(message); // e.g., in the receiver
+ *
+ *     TopicSubscription<GnssPositionMessage> *subscription = topic->subscribe(); // e.g., in a fuser, popping in its control loop
+ *     GnssPositionMessage message;
+ *     while (subscription->pop(message)) ...
+ */
+
+#ifndef TOPICBUS_H
+#define TOPICBUS_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <typeindex>
+#include "core/seqlock.h"
+#include "core/mpscringbuffer.h"
+
+class TopicBase
+{
+public:
+    static constexpr int MAX_SUBSCRIPTIONS = 8; // queued ones, and direct callbacks
+    static constexpr size_t QUEUE_CAPACITY = 64;
+
+    TopicBase(const QString &name, std::type_index type) : mName(name), mType(type) {}
+    virtual ~TopicBase() = default;
+    TopicBase(const TopicBase &) = delete;
+    TopicBase &operator=(const TopicBase &) = delete;
+
+    QString getName() const { return mName; }
+    std::type_index getType() const { return mType; }
+    virtual quint64 getPublished() const = 0;
+    virtual quint64 getDropped() const = 0; // by full queues of all subscriptions
+
+private:
+    const QString mName;
+    const std::type_index mType;
+};
+
+template<typename T>
+class TopicSubscription
+{
+public:
+    // Consumer thread only, false if the queue is empty
+    bool pop(T &message) { return mQueue.tryPop([&message](const T &queued) { message = queued; }); }
+    template<typename Function>
+    int popAll(Function function) { // function(const T &message), returns the number of messages
+        int messages = 0;
+        while (mQueue.tryPop(function))
+            messages++;
+        return messages;
+    }
+
+    quint64 getDropped() const { return mDropped.load(std::memory_order_relaxed); }
+    bool isActive() const { return mActive.load(std::memory_order_acquire); } // see Topic::unsubscribe
+
+private:
+    template<typename> friend class Topic;
+    explicit TopicSubscription(std::function<void()> notifier) : mNotifier(std::move(notifier)) {}
+
+    void push(const T &message) {
+        if (!mActive.load(std::memory_order_acquire))
+            return;
+        if (!mQueue.tryPush([&message](T &slot) { slot = message; })) {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (mNotifier)
+            mNotifier();
+    }
+
+    MpscRingBuffer<T, TopicBase::QUEUE_CAPACITY> mQueue;
+    const std::function<void()> mNotifier; // after queueing, on the publisher's thread
+    std::atomic<bool> mActive{true};
+    std::atomic<quint64> mDropped{0};
+};
+
+template<typename T>
+class Topic : public TopicBase
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Topic messages must be trivially copyable");
+
+public:
+    explicit Topic(const QString &name) : TopicBase(name, std::type_index(typeid(T))) {}
+
+    // Any thread, concurrent publishers are serialized only for the latest message
+    void publish(const T &message) {
+        mLatest.update([&message](Latest &latest) {
+            latest.sequence++;
+            latest.message = message;
+        });
+
+        mRunningPublishes.fetch_add(1, std::memory_order_seq_cst);
+        const int callbacks = mNumCallbacks.load(std::memory_order_acquire);
+        for (int i = 0; i < callbacks; i++)
+            if (mCallbacks[i].active.load(std::memory_order_seq_cst))
+                mCallbacks[i].function(message);
+        const int subscriptions = mNumSubscriptions.load(std::memory_order_acquire);
+        for (int i = 0; i < subscriptions; i++)
+            mSubscriptions[i]->push(message);
+        mRunningPublishes.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Latest-value readers keep the sequence of what they took last (start with 0), false if nothing newer was published
+    bool takeLatest(T &message, quint64 &sequence) const {
+        const Latest latest = mLatest.load();
+        if (latest.sequence == sequence)
+            return false;
+        sequence = latest.sequence;
+        message = latest.message;
+        return true;
+    }
+    bool getLatest(T &message) const { // false if nothing was published yet
+        quint64 sequence = 0;
+        return takeLatest(message, sequence);
+    }
+
+    // Queued subscription, notifier (optional, e.g., to wake the consumer) is called on the publisher's thread.
+    // nullptr if MAX_SUBSCRIPTIONS are taken.
+    TopicSubscription<T> *subscribe(std::function<void()> notifier = nullptr) {
+        std::lock_guard<std::mutex> lock(mSubscribeMutex);
+        const int subscriptions = mNumSubscriptions.load(std::memory_order_relaxed);
+        if (subscriptions == MAX_SUBSCRIPTIONS)
+            return nullptr;
+
+        mSubscriptions[subscriptions].reset(new TopicSubscription<T>(std::move(notifier)));
+        mNumSubscriptions.store(subscriptions + 1, std::memory_order_release);
+        return mSubscriptions[subscriptions].get();
+    }
+    void unsubscribe(TopicSubscription<T> *subscription) {
+        if (!subscription)
+            return;
+        subscription->mActive.store(false, std::memory_order_seq_cst);
+        waitForRunningPublishes();
+    }
+
+    // Called with every message on the publisher's thread, i.e., needs to be thread-safe and short.
+    // Returns the ID for removeCallback, -1 if MAX_SUBSCRIPTIONS are taken.
+    int addCallback(std::function<void(const T &message)> callback) {
+        std::lock_guard<std::mutex> lock(mSubscribeMutex);
+        const int callbacks = mNumCallbacks.load(std::memory_order_relaxed);
+        if (callbacks == MAX_SUBSCRIPTIONS)
+            return -1;
+
+        mCallbacks[callbacks].function = std::move(callback);
+        mNumCallbacks.store(callbacks + 1, std::memory_order_release);
+        return callbacks;
+    }
+    void removeCallback(int callbackId) {
+        if (callbackId < 0 || callbackId >= mNumCallbacks.load(std::memory_order_acquire))
+            return;
+        mCallbacks[callbackId].active.store(false, std::memory_order_seq_cst);
+        waitForRunningPublishes();
+    }
+
+    // TopicBase interface
+    virtual quint64 getPublished() const override { return mLatest.load().sequence; }
+    virtual quint64 getDropped() const override {
+        quint64 dropped = 0;
+        const int subscriptions = mNumSubscriptions.load(std::memory_order_acquire);
+        for (int i = 0; i < subscriptions; i++)
+            dropped += mSubscriptions[i]->getDropped();
+        return dropped;
+    }
+
+private:
+    struct Latest {
+        quint64 sequence = 0; // number of published messages
+        T message;
+    };
+
+    struct Callback {
+        std::function<void(const T &message)> function;
+        std::atomic<bool> active{true};
+    };
+
+    void waitForRunningPublishes() const {
+        while (mRunningPublishes.load(std::memory_order_seq_cst) > 0)
+            std::this_thread::yield();
+    }
+
+    SeqLock<Latest> mLatest;
+    // Slots below mNum... are written once before they are published by it
+    std::array<std::unique_ptr<TopicSubscription<T>>, MAX_SUBSCRIPTIONS> mSubscriptions;
+    std::atomic<int> mNumSubscriptions{0};
+    std::array<Callback, MAX_SUBSCRIPTIONS> mCallbacks;
+    std::atomic<int> mNumCallbacks{0};
+    std::atomic<int> mRunningPublishes{0}; // past the latest message
+    std::mutex mSubscribeMutex;
+};
+
+class TopicBus
+{
+public:
+    static TopicBus &getInstance();
+
+    // Creates the topic on first use. nullptr (and a warning) if the name is taken by a topic of another message type.
+    template<typename T>
+    Topic<T> *getTopic(const QString &name) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mTopics.find(name);
+        if (it == mTopics.end())
+            it = mTopics.insert(name, std::shared_ptr<TopicBase>(new Topic<T>(name)));
+        else if (it.value()->getType() != std::type_index(typeid(T))) {
+            warnTypeMismatch(name);
+            return nullptr;
+        }
+        return static_cast<Topic<T>*>(it.value().get());
+    }
+
+    QStringList getTopicNames() const;
+    std::shared_ptr<TopicBase> getTopicBase(const QString &name) const; // e.g., for statistics, nullptr if unknown
+
+private:
+    TopicBus() = default;
+    static void warnTypeMismatch(const QString &name);
+
+    mutable std::mutex mMutex;
+    QMap<QString, std::shared_ptr<TopicBase>> mTopics; // never removed
+};
+
+#endif // TOPICBUS_H
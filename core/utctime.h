@@ -0,0 +1,130 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * 64-bit UTC timestamps [ns since Unix epoch] for sensor data, taking one is a single clock read.
+ * Unlike QTime, they have sub-ms resolution and do not wrap at midnight. Negative values are invalid.
+ * For replay and simulation, now_ns() can be switched to a virtual time that is set explicitly.
+ * A disciplined time source (e.g., GnssTimeDiscipline from the GNSS time pulse) can replace the system clock: it maps the steady
+ * clock (monotonic, e.g., the rx_time_ns of UBX messages) to UTC and is independent of system clock adjustments.
+ */
+
+#ifndef UTCTIME_H
+#define UTCTIME_H
+
+#include <QTime>
+#include <QtGlobal>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include "core/seqlock.h"
+
+namespace utcTime {
+constexpr qint64 INVALID = -1;
+constexpr qint64 NS_PER_MS = 1000000;
+constexpr qint64 MS_PER_DAY = 24 * 60 * 60 * 1000;
+
+inline std::atomic<qint64> &virtualTime_ns() // INVALID: use system clock
+{
+    static std::atomic<qint64> virtualTime_ns{INVALID};
+    return virtualTime_ns;
+}
+
+inline void setVirtualTime_ns(qint64 timestamp_ns) { virtualTime_ns().store(timestamp_ns, std::memory_order_relaxed); }
+inline void clearVirtualTime() { virtualTime_ns().store(INVALID, std::memory_order_relaxed); }
+
+// UTC = referenceUtc_ns + (steady - referenceSteady_ns) * rate
+struct SteadyToUtcMapping {
+    bool valid = false;
+    qint64 referenceSteady_ns = 0;
+    qint64 referenceUtc_ns = 0;
+    double rate = 1.0; // UTC per steady clock time
+};
+
+inline SeqLock<SteadyToUtcMapping> &steadyToUtcMapping()
+{
+    static SeqLock<SteadyToUtcMapping> steadyToUtcMapping;
+    return steadyToUtcMapping;
+}
+
+inline std::atomic<bool> &hasSteadyToUtcMapping() // avoids the SeqLock read without a time source
+{
+    static std::atomic<bool> hasSteadyToUtcMapping{false};
+    return hasSteadyToUtcMapping;
+}
+
+inline void setTimeSource(const SteadyToUtcMapping &mapping)
+{
+    steadyToUtcMapping().store(mapping);
+    hasSteadyToUtcMapping().store(mapping.valid, std::memory_order_release);
+}
+inline void clearTimeSource() { setTimeSource(SteadyToUtcMapping()); }
+inline bool hasTimeSource() { return hasSteadyToUtcMapping().load(std::memory_order_acquire); }
+
+inline qint64 steadyNow_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline qint64 systemNow_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Steady clock time (e.g., a reception time) to UTC, by the time source if set, otherwise by the current system clock offset
+inline qint64 fromSteady_ns(qint64 steady_ns)
+{
+    if (hasTimeSource()) {
+        const SteadyToUtcMapping mapping = steadyToUtcMapping().load();
+        if (mapping.valid)
+            return mapping.referenceUtc_ns + qint64(llround((steady_ns - mapping.referenceSteady_ns) * mapping.rate));
+    }
+    return systemNow_ns() - (steadyNow_ns() - steady_ns);
+}
+
+inline qint64 now_ns()
+{
+    const qint64 virtualNow_ns = virtualTime_ns().load(std::memory_order_relaxed);
+    if (virtualNow_ns >= 0)
+        return virtualNow_ns;
+
+    if (hasTimeSource())
+        return fromSteady_ns(steadyNow_ns());
+
+    return systemNow_ns();
+}
+
+inline bool isValid(qint64 timestamp_ns) { return timestamp_ns >= 0; }
+
+inline int msecsSinceStartOfDay(qint64 timestamp_ns)
+{
+    return isValid(timestamp_ns) ? (timestamp_ns / NS_PER_MS) % MS_PER_DAY : -1;
+}
+
+// Time of day (UTC), e.g., for display
+inline QTime toTimeOfDay(qint64 timestamp_ns)
+{
+    return isValid(timestamp_ns) ? QTime::fromMSecsSinceStartOfDay(msecsSinceStartOfDay(timestamp_ns)) : QTime();
+}
+
+// Time of day without date, i.e., on 1970-01-01. Only meaningful in relation to other times of day (e.g., within a route).
+inline qint64 fromTimeOfDay(const QTime &time)
+{
+    return time.isValid() ? time.msecsSinceStartOfDay() * NS_PER_MS : INVALID;
+}
+
+// From UTC calendar date and time (e.g., from GNSS), see: http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+inline qint64 fromCalendar(int year, unsigned month, unsigned day, unsigned hour, unsigned minute, unsigned second, qint64 nanosecond = 0)
+{
+    year -= month <= 2;
+    const qint64 era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    const qint64 daysSinceEpoch = era * 146097 + static_cast<qint64>(dayOfEra) - 719468;
+
+    return ((daysSinceEpoch * 24 + hour) * 60 + minute) * 60 * 1000000000LL + second * 1000000000LL + nanosecond;
+}
+}
+
+#endif // UTCTIME_H
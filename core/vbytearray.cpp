@@ -18,13 +18,226 @@
     */
 
 #include "core/vbytearray.h"
+#include <QtEndian>
 #include <cmath>
+#include <cstring>
 #include <stdint.h>
 
 namespace {
 inline double roundDouble(double x) {
     return x < 0.0 ? ceil(x - 0.5) : floor(x + 0.5);
 }
+
+uint32_t encodeDouble32Auto(double number)
+{
+    int e = 0;
+    float fr = frexpf(number, &e);
+    float fr_abs = fabsf(fr);
+    uint32_t fr_s = 0;
+
+    if (fr_abs >= 0.5) {
+        fr_s = (uint32_t)((fr_abs - 0.5f) * 2.0f * 8388608.0f);
+        e += 126;
+    }
+
+    uint32_t res = ((e & 0xFF) << 23) | (fr_s & 0x7FFFFF);
+    if (fr < 0) {
+        res |= 1 << 31;
+    }
+
+    return res;
+}
+
+double decodeDouble32Auto(uint32_t res)
+{
+    int e = (res >> 23) & 0xFF;
+    int fr = res & 0x7FFFFF;
+    bool negative = res & (1 << 31);
+
+    float f = 0.0;
+    if (e != 0 || fr != 0) {
+        f = (float)fr / (8388608.0 * 2.0) + 0.5;
+        e -= 126;
+    }
+
+    if (negative) {
+        f = -f;
+    }
+
+    return ldexpf(f, e);
+}
+}
+
+char *VByteArrayWriter::grow(int size)
+{
+    // QByteArray grows its capacity geometrically, appending field by field is amortized O(1)
+    const int position = mBuffer.size();
+    mBuffer.resize(position + size);
+    return mBuffer.data() + position;
+}
+
+void VByteArrayWriter::vbAppendInt64(qint64 number)
+{
+    qToBigEndian<qint64>(number, reinterpret_cast<uchar*>(grow(8)));
+}
+
+void VByteArrayWriter::vbAppendUint64(quint64 number)
+{
+    qToBigEndian<quint64>(number, reinterpret_cast<uchar*>(grow(8)));
+}
+
+void VByteArrayWriter::vbAppendInt32(qint32 number)
+{
+    qToBigEndian<qint32>(number, reinterpret_cast<uchar*>(grow(4)));
+}
+
+void VByteArrayWriter::vbAppendUint32(quint32 number)
+{
+    qToBigEndian<quint32>(number, reinterpret_cast<uchar*>(grow(4)));
+}
+
+void VByteArrayWriter::vbAppendInt16(qint16 number)
+{
+    qToBigEndian<qint16>(number, reinterpret_cast<uchar*>(grow(2)));
+}
+
+void VByteArrayWriter::vbAppendUint16(quint16 number)
+{
+    qToBigEndian<quint16>(number, reinterpret_cast<uchar*>(grow(2)));
+}
+
+void VByteArrayWriter::vbAppendInt8(qint8 number)
+{
+    mBuffer.append((char)number);
+}
+
+void VByteArrayWriter::vbAppendUint8(quint8 number)
+{
+    mBuffer.append((char)number);
+}
+
+void VByteArrayWriter::vbAppendDouble64(double number, double scale)
+{
+    vbAppendInt64((qint64)roundDouble(number * scale));
+}
+
+void VByteArrayWriter::vbAppendDouble32(double number, double scale)
+{
+    vbAppendInt32((qint32)roundDouble(number * scale));
+}
+
+void VByteArrayWriter::vbAppendDouble16(double number, double scale)
+{
+    vbAppendInt16((qint16)roundDouble(number * scale));
+}
+
+void VByteArrayWriter::vbAppendDouble32Auto(double number)
+{
+    vbAppendUint32(encodeDouble32Auto(number));
+}
+
+void VByteArrayWriter::vbAppendString(const QString &str)
+{
+    mBuffer.append(str.toLocal8Bit());
+    mBuffer.append((char)0);
+}
+
+const uchar *VByteArrayReader::take(int size)
+{
+    if (getRemaining() < size)
+        return nullptr;
+
+    const uchar *data = reinterpret_cast<const uchar*>(mData + mPosition);
+    mPosition += size;
+    return data;
+}
+
+qint64 VByteArrayReader::vbReadInt64()
+{
+    const uchar *data = take(8);
+    return data ? qFromBigEndian<qint64>(data) : 0;
+}
+
+quint64 VByteArrayReader::vbReadUint64()
+{
+    const uchar *data = take(8);
+    return data ? qFromBigEndian<quint64>(data) : 0;
+}
+
+qint32 VByteArrayReader::vbReadInt32()
+{
+    const uchar *data = take(4);
+    return data ? qFromBigEndian<qint32>(data) : 0;
+}
+
+quint32 VByteArrayReader::vbReadUint32()
+{
+    const uchar *data = take(4);
+    return data ? qFromBigEndian<quint32>(data) : 0;
+}
+
+qint16 VByteArrayReader::vbReadInt16()
+{
+    const uchar *data = take(2);
+    return data ? qFromBigEndian<qint16>(data) : 0;
+}
+
+quint16 VByteArrayReader::vbReadUint16()
+{
+    const uchar *data = take(2);
+    return data ? qFromBigEndian<quint16>(data) : 0;
+}
+
+qint8 VByteArrayReader::vbReadInt8()
+{
+    const uchar *data = take(1);
+    return data ? (qint8)*data : 0;
+}
+
+quint8 VByteArrayReader::vbReadUint8()
+{
+    const uchar *data = take(1);
+    return data ? *data : 0;
+}
+
+double VByteArrayReader::vbReadDouble64(double scale)
+{
+    return (double)vbReadInt64() / scale;
+}
+
+double VByteArrayReader::vbReadDouble32(double scale)
+{
+    return (double)vbReadInt32() / scale;
+}
+
+double VByteArrayReader::vbReadDouble16(double scale)
+{
+    return (double)vbReadInt16() / scale;
+}
+
+double VByteArrayReader::vbReadDouble32Auto()
+{
+    return decodeDouble32Auto(vbReadUint32());
+}
+
+QString VByteArrayReader::vbReadString()
+{
+    if (atEnd())
+        return QString();
+
+    const char *start = mData + mPosition;
+    const char *end = static_cast<const char*>(memchr(start, 0, getRemaining()));
+    const int length = end ? int(end - start) : getRemaining();
+    mPosition += end ? length + 1 : length;
+    return QString::fromUtf8(start, length);
+}
+
+QByteArray VByteArrayReader::vbReadBytes(int size)
+{
+    size = qBound(0, size, getRemaining());
+    const QByteArray bytes(mData + mPosition, size);
+    mPosition += size;
+    return bytes;
 }
 
 VByteArray::VByteArray()
@@ -39,66 +252,32 @@ VByteArray::VByteArray(const QByteArray &data) : QByteArray(data)
 
 void VByteArray::vbAppendInt64(qint64 number)
 {
-    QByteArray data;
-    data.append((char)((number >> 56) & 0xFF));
-    data.append((char)((number >> 48) & 0xFF));
-    data.append((char)((number >> 40) & 0xFF));
-    data.append((char)((number >> 32) & 0xFF));
-    data.append((char)((number >> 24) & 0xFF));
-    data.append((char)((number >> 16) & 0xFF));
-    data.append((char)((number >> 8) & 0xFF));
-    data.append((char)(number & 0xFF));
-    append(data);
+    VByteArrayWriter(*this).vbAppendInt64(number);
 }
 
 void VByteArray::vbAppendUint64(quint64 number)
 {
-    QByteArray data;
-    data.append((char)((number >> 56) & 0xFF));
-    data.append((char)((number >> 48) & 0xFF));
-    data.append((char)((number >> 40) & 0xFF));
-    data.append((char)((number >> 32) & 0xFF));
-    data.append((char)((number >> 24) & 0xFF));
-    data.append((char)((number >> 16) & 0xFF));
-    data.append((char)((number >> 8) & 0xFF));
-    data.append((char)(number & 0xFF));
-    append(data);
+    VByteArrayWriter(*this).vbAppendUint64(number);
 }
 
 void VByteArray::vbAppendInt32(qint32 number)
 {
-    QByteArray data;
-    data.append((char)((number >> 24) & 0xFF));
-    data.append((char)((number >> 16) & 0xFF));
-    data.append((char)((number >> 8) & 0xFF));
-    data.append((char)(number & 0xFF));
-    append(data);
+    VByteArrayWriter(*this).vbAppendInt32(number);
 }
 
 void VByteArray::vbAppendUint32(quint32 number)
 {
-    QByteArray data;
-    data.append((char)((number >> 24) & 0xFF));
-    data.append((char)((number >> 16) & 0xFF));
-    data.append((char)((number >> 8) & 0xFF));
-    data.append((char)(number & 0xFF));
-    append(data);
+    VByteArrayWriter(*this).vbAppendUint32(number);
 }
 
 void VByteArray::vbAppendInt16(qint16 number)
 {
-    QByteArray data;
-    data.append((char)((number >> 8) & 0xFF));
-    data.append((char)(number & 0xFF));
-    append(data);
+    VByteArrayWriter(*this).vbAppendInt16(number);
 }
 
 void VByteArray::vbAppendUint16(quint16 number)
 {
-    QByteArray data;
-    data.append((char)((number >> 8) & 0xFF));
-    data.append((char)(number & 0xFF));
-    append(data);
+    VByteArrayWriter(*this).vbAppendUint16(number);
 }
 
 void VByteArray::vbAppendInt8(qint8 number)
@@ -113,160 +292,90 @@ void VByteArray::vbAppendUint8(quint8 number)
 
 void VByteArray::vbAppendDouble64(double number, double scale)
 {
-    vbAppendInt64((qint64)roundDouble(number * scale));
+    VByteArrayWriter(*this).vbAppendDouble64(number, scale);
 }
 
 void VByteArray::vbAppendDouble32(double number, double scale)
 {
-    vbAppendInt32((qint32)roundDouble(number * scale));
+    VByteArrayWriter(*this).vbAppendDouble32(number, scale);
 }
 
 void VByteArray::vbAppendDouble16(double number, double scale)
 {
-    vbAppendInt16((qint16)roundDouble(number * scale));
+    VByteArrayWriter(*this).vbAppendDouble16(number, scale);
 }
 
 void VByteArray::vbAppendDouble32Auto(double number)
 {
-    int e = 0;
-    float fr = frexpf(number, &e);
-    float fr_abs = fabsf(fr);
-    uint32_t fr_s = 0;
-
-    if (fr_abs >= 0.5) {
-        fr_s = (uint32_t)((fr_abs - 0.5f) * 2.0f * 8388608.0f);
-        e += 126;
-    }
-
-    uint32_t res = ((e & 0xFF) << 23) | (fr_s & 0x7FFFFF);
-    if (fr < 0) {
-        res |= 1 << 31;
-    }
-
-    vbAppendUint32(res);
+    VByteArrayWriter(*this).vbAppendDouble32Auto(number);
 }
 
 void VByteArray::vbAppendString(QString str)
 {
-    append(str.toLocal8Bit());
-    append((char)0);
+    VByteArrayWriter(*this).vbAppendString(str);
 }
 
 qint64 VByteArray::vbPopFrontInt64()
 {
-    if (size() < 8) {
-        return 0;
-    }
-
-    qint64 res = (quint64)((quint8) at(0)) << 56 |
-                 (quint64)((quint8) at(1)) << 48 |
-                 (quint64)((quint8) at(2)) << 40 |
-                 (quint64)((quint8) at(3)) << 32 |
-                 (quint64)((quint8) at(4)) << 24 |
-                 (quint64)((quint8) at(5)) << 16 |
-                 (quint64)((quint8) at(6)) << 8 |
-                 (quint64)((quint8) at(7));
-
-    remove(0, 8);
+    VByteArrayReader reader(*this);
+    const qint64 res = reader.vbReadInt64();
+    remove(0, reader.getPosition());
     return res;
 }
 
 qint64 VByteArray::vbPopFrontUint64()
 {
-    if (size() < 8) {
-        return 0;
-    }
-
-    quint64 res = (quint64)((quint8) at(0)) << 56 |
-                  (quint64)((quint8) at(1)) << 48 |
-                  (quint64)((quint8) at(2)) << 40 |
-                  (quint64)((quint8) at(3)) << 32 |
-                  (quint64)((quint8) at(4)) << 24 |
-                  (quint64)((quint8) at(5)) << 16 |
-                  (quint64)((quint8) at(6)) << 8 |
-                  (quint64)((quint8) at(7));
-
-    remove(0, 8);
+    VByteArrayReader reader(*this);
+    const qint64 res = reader.vbReadUint64();
+    remove(0, reader.getPosition());
     return res;
 }
 
 qint32 VByteArray::vbPopFrontInt32()
 {
-    if (size() < 4) {
-        return 0;
-    }
-
-    qint32 res =	((quint8) at(0)) << 24 |
-                    ((quint8) at(1)) << 16 |
-                    ((quint8) at(2)) << 8 |
-                    ((quint8) at(3));
-
-    remove(0, 4);
+    VByteArrayReader reader(*this);
+    const qint32 res = reader.vbReadInt32();
+    remove(0, reader.getPosition());
     return res;
 }
 
 quint32 VByteArray::vbPopFrontUint32()
 {
-    if (size() < 4) {
-        return 0;
-    }
-
-    quint32 res =	((quint8) at(0)) << 24 |
-                    ((quint8) at(1)) << 16 |
-                    ((quint8) at(2)) << 8 |
-                    ((quint8) at(3));
-
-    remove(0, 4);
+    VByteArrayReader reader(*this);
+    const quint32 res = reader.vbReadUint32();
+    remove(0, reader.getPosition());
     return res;
 }
 
 qint16 VByteArray::vbPopFrontInt16()
 {
-    if (size() < 2) {
-        return 0;
-    }
-
-    qint16 res =	((quint8) at(0)) << 8 |
-                    ((quint8) at(1));
-
-    remove(0, 2);
+    VByteArrayReader reader(*this);
+    const qint16 res = reader.vbReadInt16();
+    remove(0, reader.getPosition());
     return res;
 }
 
 quint16 VByteArray::vbPopFrontUint16()
 {
-    if (size() < 2) {
-        return 0;
-    }
-
-    quint16 res =	((quint8) at(0)) << 8 |
-                    ((quint8) at(1));
-
-    remove(0, 2);
+    VByteArrayReader reader(*this);
+    const quint16 res = reader.vbReadUint16();
+    remove(0, reader.getPosition());
     return res;
 }
 
 qint8 VByteArray::vbPopFrontInt8()
 {
-    if (size() < 1) {
-        return 0;
-    }
-
-    qint8 res = (quint8)at(0);
-
-    remove(0, 1);
+    VByteArrayReader reader(*this);
+    const qint8 res = reader.vbReadInt8();
+    remove(0, reader.getPosition());
     return res;
 }
 
 quint8 VByteArray::vbPopFrontUint8()
 {
-    if (size() < 1) {
-        return 0;
-    }
-
-    quint8 res = (quint8)at(0);
-
-    remove(0, 1);
+    VByteArrayReader reader(*this);
+    const quint8 res = reader.vbReadUint8();
+    remove(0, reader.getPosition());
     return res;
 }
 
@@ -287,32 +396,13 @@ double VByteArray::vbPopFrontDouble16(double scale)
 
 double VByteArray::vbPopFrontDouble32Auto()
 {
-    uint32_t res = vbPopFrontUint32();
-
-    int e = (res >> 23) & 0xFF;
-    int fr = res & 0x7FFFFF;
-    bool negative = res & (1 << 31);
-
-    float f = 0.0;
-    if (e != 0 || fr != 0) {
-        f = (float)fr / (8388608.0 * 2.0) + 0.5;
-        e -= 126;
-    }
-
-    if (negative) {
-        f = -f;
-    }
-
-    return ldexpf(f, e);
+    return decodeDouble32Auto(vbPopFrontUint32());
 }
 
 QString VByteArray::vbPopFrontString()
 {
-    if (size() < 1) {
-        return QString();
-    }
-
-    QString str(data());
-    remove(0, str.size() + 1);
-    return str;
+    VByteArrayReader reader(*this);
+    const QString res = reader.vbReadString();
+    remove(0, reader.getPosition());
+    return res;
 }
@@ -23,6 +23,73 @@
 #include <QByteArray>
 #include <QString>
 
+// Appends big-endian fields in place to a buffer (no temporaries), reserve() the expected size to avoid reallocations
+class VByteArrayWriter
+{
+public:
+    explicit VByteArrayWriter(QByteArray &buffer) : mBuffer(buffer) {}
+
+    void reserve(int size) { mBuffer.reserve(mBuffer.size() + size); }
+    QByteArray &getBuffer() const { return mBuffer; }
+
+    void vbAppendInt64(qint64 number);
+    void vbAppendUint64(quint64 number);
+    void vbAppendInt32(qint32 number);
+    void vbAppendUint32(quint32 number);
+    void vbAppendInt16(qint16 number);
+    void vbAppendUint16(quint16 number);
+    void vbAppendInt8(qint8 number);
+    void vbAppendUint8(quint8 number);
+    void vbAppendDouble64(double number, double scale);
+    void vbAppendDouble32(double number, double scale);
+    void vbAppendDouble16(double number, double scale);
+    void vbAppendDouble32Auto(double number);
+    void vbAppendString(const QString &str);
+
+private:
+    char *grow(int size); // returns the start of the appended bytes
+
+    QByteArray &mBuffer;
+};
+
+// Reads big-endian fields at a cursor, the buffer is not modified (and must outlive the reader).
+// Reading past the end returns 0 (empty) without moving the cursor, as VByteArray's pop functions.
+class VByteArrayReader
+{
+public:
+    explicit VByteArrayReader(const QByteArray &buffer) : mData(buffer.constData()), mSize(buffer.size()) {}
+    VByteArrayReader(const char *data, int size) : mData(data), mSize(size) {}
+
+    int getPosition() const { return mPosition; }
+    int getRemaining() const { return mSize - mPosition; }
+    bool atEnd() const { return mPosition >= mSize; }
+    void skip(int size) { mPosition += qBound(0, size, getRemaining()); }
+
+    qint64 vbReadInt64();
+    quint64 vbReadUint64();
+    qint32 vbReadInt32();
+    quint32 vbReadUint32();
+    qint16 vbReadInt16();
+    quint16 vbReadUint16();
+    qint8 vbReadInt8();
+    quint8 vbReadUint8();
+    double vbReadDouble64(double scale);
+    double vbReadDouble32(double scale);
+    double vbReadDouble16(double scale);
+    double vbReadDouble32Auto();
+    QString vbReadString(); // NUL-terminated (or up to the end)
+    QByteArray vbReadBytes(int size); // at most the remaining bytes
+
+private:
+    const uchar *take(int size); // nullptr if not enough bytes left
+
+    const char *mData;
+    int mSize;
+    int mPosition = 0;
+};
+
+// Compatibility layer: appends use VByteArrayWriter, pops read with VByteArrayReader and remove from the front
+// (i.e., one memmove per field). Prefer VByteArrayReader for decoding packets with many fields.
 class VByteArray : public QByteArray
 {
 public:
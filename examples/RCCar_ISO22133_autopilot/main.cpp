@@ -1,5 +1,6 @@
 #include <QCoreApplication>
 #include "core/simplewatchdog.h"
+#include "core/threadconfig.h"
 #include "vehicles/carstate.h"
 #include "vehicles/controller/carmovementcontroller.h"
 #include "autopilot/purepursuitwaypointfollower.h"
@@ -12,6 +13,10 @@ int main(int argc, char *argv[])
     Logger::initVehicle();
 
     QCoreApplication a(argc, argv);
+
+    // Thread priorities and CPU pinning (see core/threadconfig.h), reported once the workers are running
+    ThreadConfig::getInstance().loadFromEnvironment();
+    QTimer::singleShot(0, []() { ThreadConfig::getInstance().logReport(); });
     const int mUpdateVehicleStatePeriod_ms = 25;
     QTimer mUpdateVehicleStateTimer;
 
@@ -1,5 +1,8 @@
 #include <QCoreApplication>
+#include <QStandardPaths>
 #include "core/simplewatchdog.h"
+#include "core/safetywatchdog.h"
+#include "core/threadconfig.h"
 #include "vehicles/carstate.h"
 #include "vehicles/controller/carmovementcontroller.h"
 #include "autopilot/purepursuitwaypointfollower.h"
@@ -11,6 +14,12 @@ int main(int argc, char *argv[])
     Logger::initVehicle();
 
     QCoreApplication a(argc, argv);
+
+    // Thread priorities and CPU pinning (see core/threadconfig.h), reported once the workers are running
+    ThreadConfig::getInstance().loadFromEnvironment();
+    QTimer::singleShot(0, []() { ThreadConfig::getInstance().logReport(); });
+    // Outlives everything that feeds it
+    SafetyWatchdog safetyWatchdog;
     const int mUpdateVehicleStatePeriod_ms = 25;
     QTimer mUpdateVehicleStateTimer;
 
@@ -33,10 +42,22 @@ int main(int argc, char *argv[])
     // Setup MAVLINK communication towards ControlTower
     mavsdkVehicleServer.setMovementController(mCarMovementController);
     mavsdkVehicleServer.setWaypointFollower(mWaypointFollower);
+    mavsdkVehicleServer.setPersistentRouteStore(QSharedPointer<PersistentRouteStore>::create(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/routes"));
+    mavsdkVehicleServer.setRouteRecorder(QSharedPointer<RouteRecorder>::create(mCarState));
 
     // Watchdog that warns when EventLoop is slowed down
     SimpleWatchdog watchdog;
 
+    // Stops the vehicle from its own thread when the autopilot's control loop, the control station's heartbeat or the event loop stall
+    const int autopilotSource = safetyWatchdog.addSource("autopilot", 200);
+    mWaypointFollower->getControlLoop().setHeartbeat(safetyWatchdog.getHeartbeat(autopilotSource));
+    const int stationSource = safetyWatchdog.addSource("station", 2500);
+    mavsdkVehicleServer.setStationHeartbeatCallback([&safetyWatchdog, stationSource]() { safetyWatchdog.feed(stationSource); });
+    safetyWatchdog.addEventLoopSource();
+    safetyWatchdog.setStopAction([mCarMovementController](const QString &) { mCarMovementController->setSafetyStop(true); });
+    safetyWatchdog.setReleaseAction([mCarMovementController]() { mCarMovementController->setSafetyStop(false); });
+    safetyWatchdog.start();
+
     qDebug() << "\n" // by hjw
              << "                    .------.\n"
              << "                    :|||\"\"\"`.`.\n"
@@ -89,6 +89,8 @@ typedef struct tagSequenceStepTimeouts
 #define GLOBAL_CONFIG_SPAD_ENABLES_REF_0        0xB0
 #define GPIO_HV_MUX_ACTIVE_HIGH                 0x84
 #define SYSTEM_INTERRUPT_CLEAR                  0x0B
+#define SYSTEM_INTERMEASUREMENT_PERIOD          0x04
+#define OSC_CALIBRATE_VAL                       0xF8
 //
 // Opens a file system handle to the I2C device
 // reads the calibration data and sets the device
@@ -831,6 +833,80 @@ int iTimeout;
 
 } /* tofReadDistance() */
 
+//
+// Start continuous ranging, a new range every iPeriod_ms
+// (0 = back-to-back, as fast as the timing budget allows)
+//
+int tofStartContinuous(int iPeriod_ms)
+{
+unsigned char ucTemp[4];
+uint32_t period;
+
+	if (file_i2c == -1)
+		return 0;
+
+	writeReg(0x80, 0x01);
+	writeReg(0xFF, 0x01);
+	writeReg(0x00, 0x00);
+	writeReg(0x91, stop_variable);
+	writeReg(0x00, 0x01);
+	writeReg(0xFF, 0x00);
+	writeReg(0x80, 0x00);
+
+	if (iPeriod_ms > 0)
+	{
+		// timed mode, the period is given in oscillator cycles
+		uint16_t osc_calibrate_val = readReg16(OSC_CALIBRATE_VAL);
+		period = (uint32_t)iPeriod_ms;
+		if (osc_calibrate_val != 0)
+			period *= osc_calibrate_val;
+		ucTemp[0] = (unsigned char)(period >> 24); // MSB first
+		ucTemp[1] = (unsigned char)(period >> 16);
+		ucTemp[2] = (unsigned char)(period >> 8);
+		ucTemp[3] = (unsigned char)period;
+		writeMulti(SYSTEM_INTERMEASUREMENT_PERIOD, ucTemp, 4);
+		writeReg(SYSRANGE_START, 0x04); // VL53L0X_REG_SYSRANGE_MODE_TIMED
+	}
+	else
+	{
+		writeReg(SYSRANGE_START, 0x02); // VL53L0X_REG_SYSRANGE_MODE_BACKTOBACK
+	}
+	return 1;
+} /* tofStartContinuous() */
+
+//
+// Stop continuous ranging
+//
+void tofStopContinuous(void)
+{
+	if (file_i2c == -1)
+		return;
+
+	writeReg(SYSRANGE_START, 0x01); // VL53L0X_REG_SYSRANGE_MODE_SINGLESHOT
+	writeReg(0xFF, 0x01);
+	writeReg(0x00, 0x00);
+	writeReg(0x91, 0x00);
+	writeReg(0x00, 0x01);
+	writeReg(0xFF, 0x00);
+} /* tofStopContinuous() */
+
+//
+// Read a range of continuous ranging without waiting,
+// returns -2 if no new range is available yet
+//
+int tofReadContinuousDistance(void)
+{
+uint16_t range;
+
+	if ((readReg(RESULT_INTERRUPT_STATUS) & 0x07) == 0)
+		return -2;
+
+	range = readReg16(RESULT_RANGE_STATUS + 10);
+	writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+
+	return range;
+} /* tofReadContinuousDistance() */
+
 int tofGetModel(int *model, int *revision)
 {
 unsigned char ucTemp[2];
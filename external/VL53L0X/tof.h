@@ -29,6 +29,18 @@ int tofGetModel(int *model, int *revision);
 //
 int tofReadDistance(void);
 
+//
+// Start/stop continuous ranging, iPeriod_ms = 0: back-to-back
+//
+int tofStartContinuous(int iPeriod_ms);
+void tofStopContinuous(void);
+
+//
+// Read the latest distance in mm of continuous ranging without waiting,
+// -2 if no new range is available
+//
+int tofReadContinuousDistance(void);
+
 //
 // Opens a file system handle to the I2C device
 // sets the device continous capture mode
@@ -82,10 +82,12 @@ uint8_t as5600_basic_read(float *angle, uint16_t *angle_raw, uint16_t *scaled_an
 {
     uint8_t res;
     
-    /* Read RAW ANGLE 
+    uint8_t buf[4];
+    
+    /* Read RAW ANGLE (0x0C, 0x0D) and scaled ANGLE (0x0E, 0x0F) in one burst, the registers are consecutive
     The RAW ANGLE register contains the unscaled and unmodified
     */
-    res = as5600_read(&gs_handle, angle_raw, angle);
+    res = as5600_get_reg(&gs_handle, 0x0C, buf, 4);
     if (res != 0)
     {
         as5600_interface_debug_print("as5600: read failed.\n");
@@ -93,17 +95,38 @@ uint8_t as5600_basic_read(float *angle, uint16_t *angle_raw, uint16_t *scaled_an
         return 1;
     }
     
-    /* Read scaled angle  */
-    res = as5600_get_angle(&gs_handle, scaled_angle);
+    *angle_raw = (uint16_t)(((buf[0] >> 0) & 0xF) << 8) | buf[1];
+    *angle = (float)(*angle_raw) * (360.0f / 4096.0f);
+    *scaled_angle = (uint16_t)(((buf[2] >> 0) & 0xF) << 8) | buf[3];
+
+
+    
+    return 0;
+}
+
+/**
+ * @brief      basic example read of the raw angle only
+ * @param[out] *angle_raw points to a raw angle buffer (0 - 4095)
+ * @return     status code
+ *             - 0 success
+ *             - 1 read failed
+ * @note       none
+ */
+uint8_t as5600_basic_read_raw(uint16_t *angle_raw)
+{
+    uint8_t res;
+    uint8_t buf[2];
+
+    res = as5600_get_reg(&gs_handle, 0x0C, buf, 2);
     if (res != 0)
     {
-        as5600_interface_debug_print("as5600: get angle failed.\n");
-       
+        as5600_interface_debug_print("as5600: read failed.\n");
+
         return 1;
     }
 
+    *angle_raw = (uint16_t)(((buf[0] >> 0) & 0xF) << 8) | buf[1];
 
-    
     return 0;
 }
 
@@ -68,6 +68,16 @@ uint8_t as5600_basic_init(void);
  * @note       none
  */
 uint8_t as5600_basic_read(float *angle, uint16_t *angle_raw , uint16_t *scaled_angle);
+
+/**
+ * @brief      basic example read of the raw angle only
+ * @param[out] *angle_raw points to a raw angle buffer (0 - 4095)
+ * @return     status code
+ *             - 0 success
+ *             - 1 read failed
+ * @note       one two-byte burst read of RAW ANGLE (0x0C, 0x0D), e.g., for high-rate sampling
+ */
+uint8_t as5600_basic_read_raw(uint16_t *angle_raw);
 /**
  * @brief  basic example deinit
  * @return status code
@@ -56,20 +56,14 @@ const unsigned short crc16_tab[] = { 0x0000, 0x1021, 0x2042, 0x3063, 0x4084,
 
 VESC::Packet::Packet(QObject *parent) : QObject(parent)
 {
-    mRxTimer = 0;
-    mByteTimeout = 50;
+    mByteTimeout_ms = 500;
     mMaxPacketLen = 512;
     mRxReadPtr = 0;
     mRxWritePtr = 0;
     mBytesLeft = 0;
     mBufferLen = mMaxPacketLen + 8;
     mRxBuffer = new unsigned char[mBufferLen];
-
-    mTimer = new QTimer(this);
-    mTimer->setInterval(10);
-    mTimer->start();
-
-    connect(mTimer, SIGNAL(timeout()), this, SLOT(timerSlot()));
+    mTxFrame.reserve(mMaxPacketLen + 8);
 }
 
 VESC::Packet::~Packet()
@@ -83,31 +77,25 @@ void VESC::Packet::sendPacket(const QByteArray &data)
         return;
     }
 
-    QByteArray to_send;
-    unsigned int len_tot = data.size();
-
-    if (len_tot <= 255) {
-        to_send.append((char)2);
-        to_send.append((char)len_tot);
-    } else if (len_tot <= 65535) {
-        to_send.append((char)3);
-        to_send.append((char)(len_tot >> 8));
-        to_send.append((char)(len_tot & 0xFF));
-    } else {
-        to_send.append((char)4);
-        to_send.append((char)((len_tot >> 16) & 0xFF));
-        to_send.append((char)((len_tot >> 8) & 0xFF));
-        to_send.append((char)(len_tot & 0xFF));
-    }
-
-    unsigned short crc = crc16((const unsigned char*)data.data(), len_tot);
-
-    to_send.append(data);
-    to_send.append((char)(crc >> 8));
-    to_send.append((char)(crc & 0xFF));
-    to_send.append((char)3);
-
-    emit dataToSend(to_send);
+    const unsigned int len_tot = data.size();
+    // Start byte 2, 3 or 4 is also the header size (start byte + 1, 2 or 3 length bytes)
+    const unsigned int header_len = (len_tot <= 255) ? 2 : ((len_tot <= 65535) ? 3 : 4);
+
+    // Header, payload, CRC and stop byte are written in place into one buffer
+    const std::lock_guard<std::mutex> lock(mTxMutex);
+    mTxFrame.resize(header_len + len_tot + 3);
+    unsigned char *frame = (unsigned char*)mTxFrame.data();
+    frame[0] = header_len;
+    for (unsigned int i = 1; i < header_len; i++)
+        frame[i] = (len_tot >> (8 * (header_len - 1 - i))) & 0xFF;
+    memcpy(frame + header_len, data.constData(), len_tot);
+
+    const unsigned short crc = crc16(frame + header_len, len_tot);
+    frame[header_len + len_tot] = crc >> 8;
+    frame[header_len + len_tot + 1] = crc & 0xFF;
+    frame[header_len + len_tot + 2] = 3;
+
+    emit dataToSend(mTxFrame);
 }
 
 void VESC::Packet::resetState()
@@ -126,44 +114,45 @@ unsigned short VESC::Packet::crc16(const unsigned char *buf, unsigned int len)
     return cksum;
 }
 
-void VESC::Packet::processData(QByteArray data)
+void VESC::Packet::processData(const QByteArray &data)
 {
     QVector<QByteArray> decodedPackets;
 
-    for(unsigned char rx_data: data) {
-        mRxTimer = mByteTimeout;
-
-        unsigned int data_len = mRxWritePtr - mRxReadPtr;
-
-        // Out of space (should not happen)
-        if (data_len >= mBufferLen) {
-            mRxWritePtr = 0;
-            mRxReadPtr = 0;
-            mBytesLeft = 0;
-            mRxBuffer[mRxWritePtr++] = rx_data;
-            continue;
-        }
+    // Decoding is driven by received data, a long gap in between drops partial packets
+    if (mRxTimer.isValid() && mRxTimer.elapsed() > mByteTimeout_ms)
+        resetState();
+    mRxTimer.start();
 
+    const unsigned char *rx_data = (const unsigned char*)data.constData();
+    unsigned int rx_len = data.size();
+    while (rx_len > 0) {
         // Everything has to be aligned, so shift buffer if we are out of space.
         // (as opposed to using a circular buffer)
-        if (mRxWritePtr >= mBufferLen) {
-            memmove(mRxBuffer, mRxBuffer + mRxReadPtr, data_len);
+        if (mRxWritePtr + rx_len > mBufferLen && mRxReadPtr > 0) {
+            memmove(mRxBuffer, mRxBuffer + mRxReadPtr, mRxWritePtr - mRxReadPtr);
+            mRxWritePtr -= mRxReadPtr;
             mRxReadPtr = 0;
-            mRxWritePtr = data_len;
         }
 
-        mRxBuffer[mRxWritePtr++] = rx_data;
-        data_len++;
+        // Out of space (should not happen)
+        if (mRxWritePtr >= mBufferLen)
+            resetState();
+
+        const unsigned int chunk_len = qMin(rx_len, mBufferLen - mRxWritePtr);
+        memcpy(mRxBuffer + mRxWritePtr, rx_data, chunk_len);
+        mRxWritePtr += chunk_len;
+        rx_data += chunk_len;
+        rx_len -= chunk_len;
 
-        if (mBytesLeft > 1) {
-            mBytesLeft--;
+        if (mBytesLeft > (int)chunk_len) {
+            mBytesLeft -= chunk_len;
             continue;
         }
 
         // Try decoding the packet at various offsets until it succeeds, or
         // until we run out of data.
         for (;;) {
-            int res = try_decode_packet(mRxBuffer + mRxReadPtr, data_len,
+            int res = try_decode_packet(mRxBuffer + mRxReadPtr, mRxWritePtr - mRxReadPtr,
                                         &mBytesLeft, decodedPackets);
 
             // More data is needed
@@ -172,17 +161,15 @@ void VESC::Packet::processData(QByteArray data)
             }
 
             if (res > 0) {
-                data_len -= res;
                 mRxReadPtr += res;
             } else if (res == -1) {
                 // Something went wrong. Move pointer forward and try again.
                 mRxReadPtr++;
-                data_len--;
             }
         }
 
         // Nothing left, move pointers to avoid memmove
-        if (data_len == 0) {
+        if (mRxReadPtr == mRxWritePtr) {
             mRxReadPtr = 0;
             mRxWritePtr = 0;
         }
@@ -193,17 +180,6 @@ void VESC::Packet::processData(QByteArray data)
     }
 }
 
-void VESC::Packet::timerSlot()
-{
-    if (mRxTimer) {
-        mRxTimer--;
-    } else {
-        mRxReadPtr = 0;
-        mRxWritePtr = 0;
-        mBytesLeft = 0;
-    }
-}
-
 int VESC::Packet::try_decode_packet(unsigned char *buffer, unsigned int in_len,
                               int *bytes_left, QVector<QByteArray> &decodedPackets)
 {
@@ -21,7 +21,10 @@
 #define VESCPACKET_H
 
 #include <QObject>
-#include <QTimer>
+#include <QByteArray>
+#include <QVector>
+#include <QElapsedTimer>
+#include <mutex>
 
 namespace VESC {
 
@@ -31,7 +34,7 @@ class Packet : public QObject
 public:
     explicit Packet(QObject *parent = nullptr);
     ~Packet();
-    void sendPacket(const QByteArray &data);
+    void sendPacket(const QByteArray &data); // thread-safe
     void resetState();
     static unsigned short crc16(const unsigned char *buf, unsigned int len);
 
@@ -40,21 +43,20 @@ signals:
     void packetReceived(QByteArray &packet);
 
 public slots:
-    void processData(QByteArray data);
-
-private slots:
-    void timerSlot();
+    void processData(const QByteArray &data);
 
 private:
-    QTimer *mTimer;
-    int mRxTimer;
-    int mByteTimeout;
+    // Partially received packets are dropped after this long without data
+    QElapsedTimer mRxTimer;
+    int mByteTimeout_ms;
     unsigned int mRxReadPtr;
     unsigned int mRxWritePtr;
     int mBytesLeft;
     unsigned int mMaxPacketLen;
     unsigned int mBufferLen;
     unsigned char *mRxBuffer;
+    std::mutex mTxMutex;
+    QByteArray mTxFrame; // reused while no receiver holds on to the previous frame
 
     int try_decode_packet(unsigned char *buffer, unsigned int in_len,
                           int *bytes_left, QVector<QByteArray> &decodedPackets);
@@ -0,0 +1,326 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "flightrecorder.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <array>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+using namespace flightRecorderFormat;
+
+namespace {
+const char *posTypeName(PosType type)
+{
+    switch (type) {
+    case PosType::simulated: return "simulated";
+    case PosType::fused: return "fused";
+    case PosType::odom: return "odom";
+    case PosType::IMU: return "IMU";
+    case PosType::GNSS: return "GNSS";
+    case PosType::UWB: return "UWB";
+    case PosType::_LAST_: break;
+    }
+    return "unknown";
+}
+}
+
+FlightRecorder::FlightRecorder(QObject *parent) : QObject(parent)
+{
+    mThreadContext = new QObject();
+    mThread.setObjectName("Flight recorder");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start(QThread::HighPriority);
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    stop();
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+}
+
+int FlightRecorder::addChannel(const QString &name, const QString &type, quint32 sampleSize, int period_ms, std::function<void(char *)> sample)
+{
+    if (mRecording) {
+        qDebug() << "WARNING: FlightRecorder cannot add channel" << name << "while recording.";
+        return -1;
+    }
+    if (mChannels.size() >= MAX_CHANNELS || name.toUtf8().size() >= CHANNEL_NAME_SIZE ||
+            type.toUtf8().size() >= CHANNEL_TYPE_SIZE || sampleSize > 0xffff) {
+        qDebug() << "WARNING: FlightRecorder cannot add channel" << name << "(too many channels, name/type too long or sample too large).";
+        return -1;
+    }
+
+    const int roundedPeriod_ms = std::max(1, (period_ms + BASE_PERIOD_ms / 2) / BASE_PERIOD_ms) * BASE_PERIOD_ms;
+    mChannels.append({name, type, sampleSize, roundedPeriod_ms, sample, 0});
+    return mChannels.size() - 1;
+}
+
+void FlightRecorder::addVehicleStateChannels(QSharedPointer<VehicleState> vehicleState, int period_ms, const QString &prefix)
+{
+    for (int i = 0; i < (int)PosType::_LAST_; i++) {
+        const PosType type = (PosType)i;
+        addChannel<pospoint_t>(prefix + "position/" + posTypeName(type), "pospoint_t", period_ms, [vehicleState, type]() {
+            return vehicleState->getPosition(type).toPOD();
+        });
+    }
+    addChannel<double>(prefix + "speed", "f64", period_ms, [vehicleState]() {
+        return vehicleState->getSpeed();
+    });
+    addChannel<double>(prefix + "steering", "f64", period_ms, [vehicleState]() {
+        return vehicleState->getSteering();
+    });
+    addChannel<std::array<double, 3>>(prefix + "autopilot/target", "f64x3", period_ms, [vehicleState]() {
+        const QPointF targetPoint = vehicleState->getAutopilotTargetPoint();
+        return std::array<double, 3>{targetPoint.x(), targetPoint.y(), vehicleState->getAutopilotRadius()};
+    });
+    addChannel<std::array<float, 3>>(prefix + "imu/gyroscope", "f32x3", period_ms, [vehicleState]() {
+        return vehicleState->getGyroscopeXYZ();
+    });
+    addChannel<std::array<float, 3>>(prefix + "imu/accelerometer", "f32x3", period_ms, [vehicleState]() {
+        return vehicleState->getAccelerometerXYZ();
+    });
+}
+
+bool FlightRecorder::start(const QString &filename)
+{
+    if (mRecording)
+        return false;
+
+    bool success = false;
+    QMetaObject::invokeMethod(mThreadContext, [this, filename, &success]() {
+        QString errorString;
+        success = openFile(filename, errorString);
+        if (!success) {
+            qDebug() << "WARNING: FlightRecorder could not start:" << errorString;
+            return;
+        }
+
+        if (!mSampleTimer) {
+            mSampleTimer = new QTimer(mThreadContext);
+            mSampleTimer->setTimerType(Qt::PreciseTimer);
+            connect(mSampleTimer, &QTimer::timeout, mThreadContext, [this]() { sampleChannels(); });
+        }
+        mSampleTimer->start(BASE_PERIOD_ms);
+        mRecording = true;
+    }, Qt::BlockingQueuedConnection);
+
+    return success;
+}
+
+void FlightRecorder::stop()
+{
+    if (!mRecording)
+        return;
+
+    QMetaObject::invokeMethod(mThreadContext, [this]() {
+        closeFile();
+    }, Qt::BlockingQueuedConnection);
+    emit recordingStopped(QString());
+}
+
+FlightRecorderStatistics FlightRecorder::getStatistics() const
+{
+    const std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    return mStatistics;
+}
+
+bool FlightRecorder::openFile(const QString &filename, QString &errorString)
+{
+    if (mChannels.isEmpty()) {
+        errorString = "no channels added.";
+        return false;
+    }
+
+    mFile.setFileName(filename);
+    if (!mFile.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        errorString = "could not open \"" + filename + "\" for writing.";
+        return false;
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.chunkSize = CHUNK_SIZE;
+    header.startTime_ns = utcTime::now_ns();
+    header.channelCount = mChannels.size();
+    for (int i = 0; i < mChannels.size(); i++) {
+        const QByteArray name = mChannels.at(i).name.toUtf8();
+        const QByteArray type = mChannels.at(i).type.toUtf8();
+        memcpy(header.channels[i].name, name.constData(), name.size());
+        memcpy(header.channels[i].type, type.constData(), type.size());
+        header.channels[i].sampleSize = mChannels.at(i).sampleSize;
+        header.channels[i].period_ms = mChannels.at(i).period_ms;
+        mChannels[i].nextSample_ns = header.startTime_ns;
+    }
+    header.checksum = qChecksum(reinterpret_cast<const char*>(&header), offsetof(FileHeader, checksum));
+
+    QByteArray headerBlock(FILE_HEADER_SIZE, '\0');
+    memcpy(headerBlock.data(), &header, sizeof(header));
+    if (mFile.write(headerBlock) != headerBlock.size() || !mFile.flush()) {
+        errorString = "could not write header to \"" + filename + "\": " + mFile.errorString();
+        mFile.close();
+        return false;
+    }
+
+    mChunk = nullptr;
+    mChunkIndex = 0;
+    {
+        const std::lock_guard<std::mutex> lock(mStatisticsMutex);
+        mStatistics = FlightRecorderStatistics();
+    }
+    if (!mapNextChunk()) {
+        errorString = "could not map \"" + filename + "\": " + mFile.errorString();
+        mFile.close();
+        return false;
+    }
+    mLastSync_ns = header.startTime_ns;
+
+    return true;
+}
+
+void FlightRecorder::sampleChannels()
+{
+    if (!mChunk)
+        return;
+
+    QElapsedTimer cycleTimer;
+    cycleTimer.start();
+    const qint64 now_ns = utcTime::now_ns();
+    quint64 samples = 0;
+
+    for (int i = 0; i < mChannels.size(); i++) {
+        Channel &channel = mChannels[i];
+        if (now_ns < channel.nextSample_ns)
+            continue;
+
+        // Keep phase, but do not catch up on missed samples
+        channel.nextSample_ns += channel.period_ms * utcTime::NS_PER_MS;
+        if (channel.nextSample_ns <= now_ns)
+            channel.nextSample_ns = now_ns + channel.period_ms * utcTime::NS_PER_MS;
+
+        const quint32 size = recordSize(channel.sampleSize);
+        if (CHUNK_HEADER_SIZE + mChunkUsedBytes + size > CHUNK_SIZE) {
+            commitChunk();
+            if (!mapNextChunk()) {
+                const QString errorString = "could not extend \"" + mFile.fileName() + "\": " + mFile.errorString();
+                qDebug() << "WARNING: FlightRecorder stopped," << errorString;
+                closeFile();
+                QMetaObject::invokeMethod(this, [this, errorString]() {
+                    emit recordingStopped(errorString);
+                }, Qt::QueuedConnection);
+                return;
+            }
+        }
+
+        char *record = reinterpret_cast<char*>(mChunk) + CHUNK_HEADER_SIZE + mChunkUsedBytes;
+        RecordHeader recordHeader{quint16(i), quint16(channel.sampleSize), 0, utcTime::now_ns()};
+        memcpy(record, &recordHeader, sizeof(recordHeader));
+        channel.sample(record + sizeof(RecordHeader));
+
+        if (!utcTime::isValid(mChunkFirstTimestamp_ns))
+            mChunkFirstTimestamp_ns = recordHeader.timestamp_ns;
+        mChunkLastTimestamp_ns = recordHeader.timestamp_ns;
+        mChunkUsedBytes += size;
+        mChunkRecordCount++;
+        mChunkDirty = true;
+        samples++;
+    }
+
+    commitChunk();
+    if (now_ns - mLastSync_ns >= SYNC_INTERVAL_ms * utcTime::NS_PER_MS) {
+        syncFile();
+        mLastSync_ns = now_ns;
+    }
+
+    const qint64 cycleTime_ns = cycleTimer.nsecsElapsed();
+    const std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    mStatistics.samples += samples;
+    mStatistics.maxCycleTime_ns = std::max(mStatistics.maxCycleTime_ns, cycleTime_ns);
+    if (cycleTime_ns > BASE_PERIOD_ms * utcTime::NS_PER_MS)
+        mStatistics.overruns++;
+}
+
+bool FlightRecorder::mapNextChunk()
+{
+    if (mChunk) {
+        mFile.unmap(mChunk);
+        mChunk = nullptr;
+        mChunkIndex++;
+    }
+
+    const qint64 offset = FILE_HEADER_SIZE + qint64(mChunkIndex) * CHUNK_SIZE;
+    if (!mFile.resize(offset + CHUNK_SIZE)) // zero-filled
+        return false;
+    mChunk = mFile.map(offset, CHUNK_SIZE);
+    if (!mChunk)
+        return false;
+
+    mChunkUpdate = 0;
+    mChunkUsedBytes = 0;
+    mChunkRecordCount = 0;
+    mChunkFirstTimestamp_ns = utcTime::INVALID;
+    mChunkLastTimestamp_ns = utcTime::INVALID;
+    mChunkDirty = true;
+    commitChunk(); // empty, but valid chunk
+
+    const std::lock_guard<std::mutex> lock(mStatisticsMutex);
+    mStatistics.chunks++;
+    return true;
+}
+
+void FlightRecorder::commitChunk()
+{
+    if (!mChunk || !mChunkDirty)
+        return;
+
+    // Alternate between slots, the previous commit stays intact while this one is written
+    ChunkHeader chunkHeader;
+    memset(&chunkHeader, 0, sizeof(chunkHeader));
+    chunkHeader.magic = CHUNK_MAGIC;
+    chunkHeader.chunkIndex = mChunkIndex;
+    chunkHeader.update = ++mChunkUpdate;
+    chunkHeader.usedBytes = mChunkUsedBytes;
+    chunkHeader.recordCount = mChunkRecordCount;
+    chunkHeader.firstTimestamp_ns = mChunkFirstTimestamp_ns;
+    chunkHeader.lastTimestamp_ns = mChunkLastTimestamp_ns;
+    chunkHeader.checksum = qChecksum(reinterpret_cast<const char*>(&chunkHeader), offsetof(ChunkHeader, checksum));
+
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(mChunk + (mChunkUpdate % CHUNK_HEADER_SLOTS) * (CHUNK_HEADER_SIZE / CHUNK_HEADER_SLOTS), &chunkHeader, sizeof(chunkHeader));
+    mChunkDirty = false;
+}
+
+void FlightRecorder::closeFile()
+{
+    if (mSampleTimer)
+        mSampleTimer->stop();
+
+    if (mChunk) {
+        commitChunk();
+        mFile.unmap(mChunk);
+        mChunk = nullptr;
+        mFile.resize(FILE_HEADER_SIZE + qint64(mChunkIndex) * CHUNK_SIZE + CHUNK_HEADER_SIZE + mChunkUsedBytes);
+    }
+    if (mFile.isOpen()) {
+        syncFile();
+        mFile.close();
+    }
+    mRecording = false;
+}
+
+void FlightRecorder::syncFile()
+{
+#ifdef Q_OS_UNIX
+    fsync(mFile.handle()); // includes pages written through the mapping
+#else
+    mFile.flush();
+#endif
+}
@@ -0,0 +1,110 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Binary flight recorder that samples registered channels (trivially copyable values, each with its own period) on a separate thread
+ * and appends them with their sampling timestamp to a log file (see flightRecorderFormat). The file grows by fixed-size chunks
+ * that are memory-mapped one at a time, samples are written directly into the mapping. Chunk headers are committed after every
+ * sampling cycle and the file is synced to disk periodically, a crash only loses the cycle in progress.
+ * Cost on the vehicle is bounded by the fixed base period, fixed-size records and the number of registered channels.
+ * Use FlightRecorderReader for post-analysis.
+ */
+
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QFile>
+#include <QVector>
+#include <QSharedPointer>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include "logger/flightrecorderformat.h"
+#include "vehicles/vehiclestate.h"
+
+struct FlightRecorderStatistics {
+    quint64 samples = 0;
+    quint64 chunks = 0;
+    quint64 overruns = 0; // sampling cycles that took longer than BASE_PERIOD_ms
+    qint64 maxCycleTime_ns = 0;
+};
+
+class FlightRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FlightRecorder(QObject *parent = nullptr);
+    ~FlightRecorder();
+
+    // Channels can only be added while not recording, returns channel id or -1. sample() is called on the recorder thread.
+    template<typename T>
+    int addChannel(const QString &name, const QString &type, int period_ms, std::function<T()> sample) {
+        static_assert(std::is_trivially_copyable<T>::value, "flight recorder samples must be trivially copyable");
+        return addChannel(name, type, sizeof(T), period_ms, [sample](char *destination) {
+            const T value = sample();
+            memcpy(destination, &value, sizeof(T));
+        });
+    }
+    // Positions for every PosType, speed, steering, autopilot target (x, y, radius), gyroscope and accelerometer
+    void addVehicleStateChannels(QSharedPointer<VehicleState> vehicleState, int period_ms = 20, const QString &prefix = "vehicle/");
+
+    bool start(const QString &filename);
+    void stop(); // commits and closes the file
+    bool isRecording() const { return mRecording; }
+    FlightRecorderStatistics getStatistics() const;
+
+    static constexpr int BASE_PERIOD_ms = 10; // channel periods are rounded to multiples
+    static constexpr quint32 CHUNK_SIZE = 1 << 20; // [bytes]
+    static constexpr int SYNC_INTERVAL_ms = 1000;
+
+signals:
+    void recordingStopped(const QString &errorString); // empty when stopped regularly
+
+private:
+    struct Channel {
+        QString name;
+        QString type;
+        quint32 sampleSize;
+        int period_ms;
+        std::function<void(char *destination)> sample;
+        qint64 nextSample_ns;
+    };
+
+    int addChannel(const QString &name, const QString &type, quint32 sampleSize, int period_ms, std::function<void(char *)> sample);
+
+    // Recorder thread
+    bool openFile(const QString &filename, QString &errorString);
+    void sampleChannels();
+    bool mapNextChunk();
+    void commitChunk();
+    void closeFile();
+    void syncFile();
+
+    QThread mThread;
+    QObject *mThreadContext;
+    QTimer *mSampleTimer = nullptr; // recorder thread
+    std::atomic<bool> mRecording {false};
+    QVector<Channel> mChannels; // only modified while not recording
+
+    // Recorder thread
+    QFile mFile;
+    uchar *mChunk = nullptr;
+    quint32 mChunkIndex = 0;
+    quint32 mChunkUpdate = 0;
+    quint32 mChunkUsedBytes = 0;
+    quint32 mChunkRecordCount = 0;
+    qint64 mChunkFirstTimestamp_ns = utcTime::INVALID;
+    qint64 mChunkLastTimestamp_ns = utcTime::INVALID;
+    bool mChunkDirty = false;
+    qint64 mLastSync_ns = 0;
+
+    mutable std::mutex mStatisticsMutex;
+    FlightRecorderStatistics mStatistics;
+};
+
+#endif // FLIGHTRECORDER_H
@@ -0,0 +1,75 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * File layout shared by FlightRecorder and FlightRecorderReader (native byte order):
+ * FileHeader (padded to FILE_HEADER_SIZE) followed by chunks of FileHeader::chunkSize bytes (the last one may be truncated).
+ * A chunk starts with two ChunkHeader slots that are written alternately after the records they describe,
+ * followed by records (RecordHeader + sample, padded to RECORD_ALIGNMENT).
+ */
+
+#ifndef FLIGHTRECORDERFORMAT_H
+#define FLIGHTRECORDERFORMAT_H
+
+#include <QtGlobal>
+#include <cstddef>
+
+namespace flightRecorderFormat {
+
+constexpr char FILE_MAGIC[8] = {'W', 'W', 'F', 'L', 'T', 'R', 'E', 'C'};
+constexpr quint32 VERSION = 1;
+constexpr quint32 CHUNK_MAGIC = 0x4b434657; // "WFCK"
+constexpr int MAX_CHANNELS = 64;
+constexpr int CHANNEL_NAME_SIZE = 48;
+constexpr int CHANNEL_TYPE_SIZE = 16;
+constexpr quint32 FILE_HEADER_SIZE = 8192;
+constexpr quint32 CHUNK_HEADER_SLOTS = 2;
+constexpr quint32 RECORD_ALIGNMENT = 8;
+
+struct ChannelDescriptor {
+    char name[CHANNEL_NAME_SIZE]; // zero-terminated
+    char type[CHANNEL_TYPE_SIZE]; // zero-terminated, e.g., "pospoint_t", "f64", "f32x3"
+    quint32 sampleSize; // [bytes]
+    quint32 period_ms;
+};
+
+struct FileHeader {
+    char magic[8];
+    quint32 version;
+    quint32 chunkSize; // [bytes]
+    qint64 startTime_ns; // UTC
+    quint32 channelCount;
+    quint32 reserved;
+    ChannelDescriptor channels[MAX_CHANNELS];
+    quint16 checksum; // qChecksum over all preceding bytes
+};
+static_assert(sizeof(FileHeader) <= FILE_HEADER_SIZE, "flight recorder file header does not fit");
+
+struct ChunkHeader {
+    quint32 magic;
+    quint32 chunkIndex;
+    quint32 update; // increased with every commit, the valid slot with the highest update is current
+    quint32 usedBytes; // record bytes after the header slots
+    quint32 recordCount;
+    quint32 reserved;
+    qint64 firstTimestamp_ns;
+    qint64 lastTimestamp_ns;
+    quint16 checksum; // qChecksum over all preceding bytes
+};
+constexpr quint32 CHUNK_HEADER_SIZE = CHUNK_HEADER_SLOTS * 64;
+static_assert(sizeof(ChunkHeader) <= CHUNK_HEADER_SIZE / CHUNK_HEADER_SLOTS, "flight recorder chunk header does not fit");
+
+struct RecordHeader {
+    quint16 channel;
+    quint16 size; // sample size [bytes]
+    quint32 reserved;
+    qint64 timestamp_ns; // UTC, time of sampling
+};
+
+constexpr quint32 recordSize(quint32 sampleSize) {
+    return (sizeof(RecordHeader) + sampleSize + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+}
+
+}
+
+#endif // FLIGHTRECORDERFORMAT_H
@@ -0,0 +1,141 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "flightrecorderreader.h"
+#include <algorithm>
+
+using namespace flightRecorderFormat;
+
+bool FlightRecorderReader::open(const QString &filename)
+{
+    close();
+
+    mFile.setFileName(filename);
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        mErrorString = "Could not open \"" + filename + "\" for reading.";
+        return false;
+    }
+
+    const qint64 size = mFile.size();
+    if (size < FILE_HEADER_SIZE || !(mData = mFile.map(0, size))) {
+        mErrorString = "\"" + filename + "\" is not a flight recorder file.";
+        close();
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, mData, sizeof(header));
+    if (memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0 ||
+            header.checksum != qChecksum(reinterpret_cast<const char*>(&header), offsetof(FileHeader, checksum))) {
+        mErrorString = "\"" + filename + "\" is not a flight recorder file.";
+        close();
+        return false;
+    }
+    if (header.version != VERSION || header.channelCount > MAX_CHANNELS || header.chunkSize <= CHUNK_HEADER_SIZE) {
+        mErrorString = "Unsupported flight recorder file version " + QString::number(header.version) + " in \"" + filename + "\".";
+        close();
+        return false;
+    }
+
+    mStartTime_ns = header.startTime_ns;
+    for (quint32 i = 0; i < header.channelCount; i++) {
+        const ChannelDescriptor &descriptor = header.channels[i];
+        mChannels.append({int(i), QString::fromUtf8(descriptor.name, qstrnlen(descriptor.name, CHANNEL_NAME_SIZE)),
+                          QString::fromUtf8(descriptor.type, qstrnlen(descriptor.type, CHANNEL_TYPE_SIZE)),
+                          descriptor.sampleSize, int(descriptor.period_ms)});
+    }
+
+    for (quint32 chunkIndex = 0; ; chunkIndex++) {
+        const qint64 offset = FILE_HEADER_SIZE + qint64(chunkIndex) * header.chunkSize;
+        if (offset >= size)
+            break;
+
+        const qint64 available = std::min<qint64>(header.chunkSize, size - offset);
+        ChunkHeader chunkHeader;
+        if (!readChunkHeader(mData + offset, chunkIndex, available, chunkHeader)) {
+            mTruncated = true;
+            break;
+        }
+
+        // Only keep records up to the first invalid one
+        const uchar *records = mData + offset + CHUNK_HEADER_SIZE;
+        quint32 validBytes = 0;
+        while (validBytes + sizeof(RecordHeader) <= chunkHeader.usedBytes) {
+            RecordHeader recordHeader;
+            memcpy(&recordHeader, records + validBytes, sizeof(recordHeader));
+            if (recordHeader.channel >= mChannels.size() || recordHeader.size != mChannels.at(recordHeader.channel).sampleSize ||
+                    validBytes + recordSize(recordHeader.size) > chunkHeader.usedBytes)
+                break;
+            validBytes += recordSize(recordHeader.size);
+        }
+        if (validBytes != chunkHeader.usedBytes)
+            mTruncated = true;
+
+        mChunks.append({records, validBytes});
+        if (mTruncated)
+            break;
+    }
+
+    return true;
+}
+
+void FlightRecorderReader::close()
+{
+    if (mData) {
+        mFile.unmap(const_cast<uchar*>(mData));
+        mData = nullptr;
+    }
+    if (mFile.isOpen())
+        mFile.close();
+
+    mStartTime_ns = -1;
+    mChannels.clear();
+    mChunks.clear();
+    mTruncated = false;
+}
+
+int FlightRecorderReader::findChannel(const QString &name) const
+{
+    for (const auto &channel : mChannels)
+        if (channel.name == name)
+            return channel.id;
+    return -1;
+}
+
+void FlightRecorderReader::forEachRecord(const std::function<void (int, qint64, const char *)> &callback) const
+{
+    for (const auto &chunk : mChunks) {
+        quint32 position = 0;
+        while (position < chunk.usedBytes) {
+            RecordHeader recordHeader;
+            memcpy(&recordHeader, chunk.records + position, sizeof(recordHeader));
+            callback(recordHeader.channel, recordHeader.timestamp_ns, reinterpret_cast<const char*>(chunk.records + position + sizeof(RecordHeader)));
+            position += recordSize(recordHeader.size);
+        }
+    }
+}
+
+bool FlightRecorderReader::readChunkHeader(const uchar *chunk, quint32 chunkIndex, qint64 size, ChunkHeader &chunkHeader) const
+{
+    if (size < CHUNK_HEADER_SIZE)
+        return false;
+
+    // Newest valid slot, the other one may have been torn while writing
+    bool isValid = false;
+    for (quint32 slot = 0; slot < CHUNK_HEADER_SLOTS; slot++) {
+        ChunkHeader slotHeader;
+        memcpy(&slotHeader, chunk + slot * (CHUNK_HEADER_SIZE / CHUNK_HEADER_SLOTS), sizeof(slotHeader));
+        if (slotHeader.magic != CHUNK_MAGIC || slotHeader.chunkIndex != chunkIndex ||
+                slotHeader.checksum != qChecksum(reinterpret_cast<const char*>(&slotHeader), offsetof(ChunkHeader, checksum)) ||
+                slotHeader.usedBytes > size - CHUNK_HEADER_SIZE)
+            continue;
+
+        if (!isValid || slotHeader.update > chunkHeader.update) {
+            chunkHeader = slotHeader;
+            isValid = true;
+        }
+    }
+
+    return isValid;
+}
@@ -0,0 +1,82 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Reads files written by FlightRecorder for post-analysis. The file is memory-mapped read-only,
+ * chunks and records are validated, so that files of crashed recordings can be read up to their last commit.
+ */
+
+#ifndef FLIGHTRECORDERREADER_H
+#define FLIGHTRECORDERREADER_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QPair>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include "logger/flightrecorderformat.h"
+
+class FlightRecorderReader
+{
+public:
+    struct Channel {
+        int id;
+        QString name;
+        QString type;
+        quint32 sampleSize;
+        int period_ms;
+    };
+
+    FlightRecorderReader() = default;
+    ~FlightRecorderReader() { close(); }
+
+    bool open(const QString &filename);
+    void close();
+    QString getErrorString() const { return mErrorString; }
+
+    qint64 getStartTime_ns() const { return mStartTime_ns; }
+    QVector<Channel> getChannels() const { return mChannels; }
+    int findChannel(const QString &name) const; // -1 if not found
+    int getChunkCount() const { return mChunks.size(); } // valid chunks only
+    bool isTruncated() const { return mTruncated; } // invalid data found, e.g., after a crash
+
+    // Records of all channels in file order, data points to sampleSize bytes of the mapped file
+    void forEachRecord(const std::function<void(int channelId, qint64 timestamp_ns, const char *data)> &callback) const;
+
+    template<typename T>
+    QVector<QPair<qint64, T>> readSamples(int channelId) const {
+        static_assert(std::is_trivially_copyable<T>::value, "flight recorder samples must be trivially copyable");
+        QVector<QPair<qint64, T>> samples;
+        if (channelId < 0 || channelId >= mChannels.size() || mChannels.at(channelId).sampleSize != sizeof(T))
+            return samples;
+
+        forEachRecord([&samples, channelId](int recordChannelId, qint64 timestamp_ns, const char *data) {
+            if (recordChannelId != channelId)
+                return;
+            T sample;
+            memcpy(&sample, data, sizeof(T));
+            samples.append({timestamp_ns, sample});
+        });
+        return samples;
+    }
+
+private:
+    struct Chunk {
+        const uchar *records;
+        quint32 usedBytes;
+    };
+
+    bool readChunkHeader(const uchar *chunk, quint32 chunkIndex, qint64 size, flightRecorderFormat::ChunkHeader &chunkHeader) const;
+
+    QFile mFile;
+    const uchar *mData = nullptr;
+    QString mErrorString;
+    qint64 mStartTime_ns = -1;
+    QVector<Channel> mChannels;
+    QVector<Chunk> mChunks;
+    bool mTruncated = false;
+};
+
+#endif // FLIGHTRECORDERREADER_H
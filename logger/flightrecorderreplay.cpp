@@ -0,0 +1,185 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "flightrecorderreplay.h"
+#include "logger/flightrecorderreader.h"
+#include "core/routespatialindex.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#ifdef Q_OS_UNIX
+#include <time.h>
+#endif
+
+namespace {
+qint64 threadCpuTime_ns()
+{
+#ifdef Q_OS_UNIX
+    timespec cpuTime;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime);
+    return qint64(cpuTime.tv_sec) * 1000000000LL + cpuTime.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+}
+
+FlightRecorderReplay::FlightRecorderReplay(QSharedPointer<VehicleState> vehicleState, QObject *parent)
+    : QObject(parent), mVehicleState(vehicleState)
+{
+
+}
+
+bool FlightRecorderReplay::open(const QString &filename, const QString &prefix)
+{
+    mEvents.clear();
+
+    FlightRecorderReader reader;
+    if (!reader.open(filename)) {
+        mErrorString = reader.getErrorString();
+        return false;
+    }
+
+    loadPositions(reader, prefix + "position/GNSS", Event::Type::GNSS, PosType::GNSS);
+    loadPositions(reader, prefix + "position/IMU", Event::Type::IMU, PosType::IMU);
+    loadPositions(reader, prefix + "position/odom", Event::Type::Odom, PosType::odom);
+    for (const auto &sample : reader.readSamples<double>(reader.findChannel(prefix + "speed")))
+        mEvents.append({sample.first, Event::Type::Speed, pospoint_t(), sample.second});
+
+    if (mEvents.isEmpty()) {
+        mErrorString = "No GNSS, IMU or odometry positions with prefix \"" + prefix + "\" in \"" + filename + "\".";
+        return false;
+    }
+
+    std::stable_sort(mEvents.begin(), mEvents.end(), [](const Event &first, const Event &second) {
+        return first.timestamp_ns < second.timestamp_ns;
+    });
+    mErrorString.clear();
+    return true;
+}
+
+void FlightRecorderReplay::loadPositions(const FlightRecorderReader &reader, const QString &channelName, Event::Type type, PosType posType)
+{
+    // Positions are sampled periodically, only replay updates (by measurement timestamp)
+    qint64 lastTimestamp_ns = utcTime::INVALID;
+    for (const auto &sample : reader.readSamples<pospoint_t>(reader.findChannel(channelName))) {
+        pospoint_t position = sample.second;
+        if (!utcTime::isValid(position.timestamp_ns) || position.timestamp_ns == lastTimestamp_ns)
+            continue;
+
+        lastTimestamp_ns = position.timestamp_ns;
+        position.type = posType;
+        mEvents.append({position.timestamp_ns, type, position, 0.0});
+    }
+}
+
+FlightRecorderReplayMetrics FlightRecorderReplay::run()
+{
+    mMetrics = FlightRecorderReplayMetrics();
+    mHasLastGnssPosition = false;
+    mHasLastOdomPosition = false;
+    if (mEvents.isEmpty())
+        return mMetrics;
+
+    RouteSpatialIndex referenceRoute;
+    if (!mReferenceRoute.isEmpty())
+        referenceRoute.setRoute(mReferenceRoute);
+    else if (mWaypointFollower)
+        referenceRoute.setRoute(mWaypointFollower->getCurrentRoutePOD());
+
+    const qint64 tickPeriod_ns = mWaypointFollower ? qint64(mWaypointFollower->getControlLoop().getPeriod_us()) * 1000 :
+                                                     DEFAULT_TICK_PERIOD_ms * utcTime::NS_PER_MS;
+    const qint64 startTime_ns = mEvents.first().timestamp_ns;
+    const qint64 endTime_ns = mEvents.last().timestamp_ns;
+    double sumSquaredCrossTrackError = 0.0;
+    quint64 crossTrackSamples = 0;
+    double sumTickCpuTime_us = 0.0;
+
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+
+    int eventIndex = 0;
+    for (qint64 tickTime_ns = startTime_ns + tickPeriod_ns; eventIndex < mEvents.size(); tickTime_ns += tickPeriod_ns) {
+        const qint64 tickStartCpuTime_ns = threadCpuTime_ns();
+
+        for (; eventIndex < mEvents.size() && mEvents.at(eventIndex).timestamp_ns <= tickTime_ns; eventIndex++) {
+            utcTime::setVirtualTime_ns(mEvents.at(eventIndex).timestamp_ns);
+            replayEvent(mEvents.at(eventIndex));
+        }
+
+        utcTime::setVirtualTime_ns(tickTime_ns);
+        if (mWaypointFollower)
+            mWaypointFollower->getControlLoop().step();
+
+        const double tickCpuTime_us = (threadCpuTime_ns() - tickStartCpuTime_ns) / 1000.0;
+        sumTickCpuTime_us += tickCpuTime_us;
+        mMetrics.maxTickCpuTime_us = std::max(mMetrics.maxTickCpuTime_us, tickCpuTime_us);
+        mMetrics.ticks++;
+
+        if (!referenceRoute.isEmpty()) {
+            const QPointF position = mVehicleState->getPosition(mCrossTrackPosType).getPoint();
+            double crossTrackError = 0.0;
+            if (referenceRoute.size() < 2)
+                referenceRoute.getClosestPointIndex(position, 0, &crossTrackError);
+            else
+                referenceRoute.getClosestSegmentIndex(position, 0, &crossTrackError);
+
+            mMetrics.maxCrossTrackError_m = std::max(mMetrics.maxCrossTrackError_m, crossTrackError);
+            sumSquaredCrossTrackError += crossTrackError * crossTrackError;
+            crossTrackSamples++;
+        }
+    }
+
+    utcTime::clearVirtualTime();
+
+    mMetrics.wallTime_ns = wallTimer.nsecsElapsed();
+    mMetrics.replayedTime_ns = endTime_ns - startTime_ns;
+    mMetrics.meanTickCpuTime_us = sumTickCpuTime_us / mMetrics.ticks;
+    if (crossTrackSamples > 0)
+        mMetrics.rmsCrossTrackError_m = std::sqrt(sumSquaredCrossTrackError / crossTrackSamples);
+
+    return mMetrics;
+}
+
+void FlightRecorderReplay::replayEvent(const Event &event)
+{
+    PosPoint position(event.position);
+
+    switch (event.type) {
+    case Event::Type::GNSS: {
+        const double distanceMoved = mHasLastGnssPosition ? event.position.getDistanceTo(mLastGnssPosition) : 0.0;
+        mLastGnssPosition = event.position;
+        mHasLastGnssPosition = true;
+        mVehicleState->setPosition(position);
+        mMetrics.gnssSamples++;
+        emit updatedGNSSPositionAndYaw(mVehicleState, distanceMoved, mGnssIsFused);
+    } break;
+
+    case Event::Type::IMU:
+        mVehicleState->setPosition(position);
+        mMetrics.imuSamples++;
+        emit updatedIMUOrientation(mVehicleState);
+        break;
+
+    case Event::Type::Odom: {
+        // Driven distance is negative when moving against the recorded heading
+        double distanceMoved = 0.0;
+        if (mHasLastOdomPosition) {
+            const double yawRad = mLastOdomPosition.yaw * M_PI / 180.0;
+            const double forward = (event.position.x - mLastOdomPosition.x) * cos(yawRad) + (event.position.y - mLastOdomPosition.y) * sin(yawRad);
+            distanceMoved = (forward < 0.0 ? -1.0 : 1.0) * event.position.getDistanceTo(mLastOdomPosition);
+        }
+        mLastOdomPosition = event.position;
+        mHasLastOdomPosition = true;
+        mVehicleState->setPosition(position);
+        mMetrics.odomSamples++;
+        emit updatedOdomPositionAndYaw(mVehicleState, distanceMoved);
+    } break;
+
+    case Event::Type::Speed:
+        mVehicleState->setSpeed(event.value);
+        break;
+    }
+}
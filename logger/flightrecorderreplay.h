@@ -0,0 +1,91 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Offline replay of GNSS, IMU and odometry positions recorded by FlightRecorder (addVehicleStateChannels), e.g., to tune
+ * position fusion and autopilot gains. Recorded samples are written to the VehicleState and announced with the same signals as
+ * UbloxRover, IMUOrientationUpdater and MovementController, so consumers are connected as on the vehicle, e.g.:
+ *   connect(&replay, &FlightRecorderReplay::updatedGNSSPositionAndYaw, &fuser, &SDVPVehiclePositionFuser::correctPositionAndYawGNSS);
+ * run() replays as fast as possible on the calling thread with a virtual time (utcTime::now_ns() follows the recording) and steps
+ * the waypoint follower's control loop at its period. Inputs are open loop, i.e., the follower's commands do not change the replayed positions.
+ */
+
+#ifndef FLIGHTRECORDERREPLAY_H
+#define FLIGHTRECORDERREPLAY_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+#include "vehicles/vehiclestate.h"
+#include "autopilot/purepursuitwaypointfollower.h"
+
+class FlightRecorderReader;
+
+struct FlightRecorderReplayMetrics {
+    quint64 ticks = 0;
+    quint64 gnssSamples = 0;
+    quint64 imuSamples = 0;
+    quint64 odomSamples = 0;
+    qint64 replayedTime_ns = 0; // virtual time covered
+    qint64 wallTime_ns = 0;
+    // Distance of the position used for cross-track error to the reference route, sampled every tick
+    double maxCrossTrackError_m = 0.0;
+    double rmsCrossTrackError_m = 0.0;
+    // Thread CPU time per tick: replayed inputs and control loop iteration
+    double meanTickCpuTime_us = 0.0;
+    double maxTickCpuTime_us = 0.0;
+};
+
+class FlightRecorderReplay : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FlightRecorderReplay(QSharedPointer<VehicleState> vehicleState, QObject *parent = nullptr);
+
+    bool open(const QString &filename, const QString &prefix = "vehicle/"); // channel prefix as in addVehicleStateChannels
+    QString getErrorString() const { return mErrorString; }
+
+    // Control loop is stepped by run(), keep it in ControlLoop::Mode::EVENT_LOOP (its timer cannot fire while run() blocks)
+    void setWaypointFollower(QSharedPointer<PurepursuitWaypointFollower> waypointFollower) { mWaypointFollower = waypointFollower; }
+    void setReferenceRoute(const QList<PosPoint> &route) { mReferenceRoute = PosPoint::toPODList(route); } // default: follower's route
+    void setCrossTrackPosType(PosType crossTrackPosType) { mCrossTrackPosType = crossTrackPosType; }
+    void setGnssIsFused(bool gnssIsFused) { mGnssIsFused = gnssIsFused; } // fused argument of updatedGNSSPositionAndYaw
+
+    FlightRecorderReplayMetrics run();
+
+    static constexpr int DEFAULT_TICK_PERIOD_ms = 50; // without waypoint follower
+
+signals:
+    void updatedGNSSPositionAndYaw(QSharedPointer<VehicleState> vehicleState, double distanceMoved, bool fused);
+    void updatedIMUOrientation(QSharedPointer<VehicleState> vehicleState);
+    void updatedOdomPositionAndYaw(QSharedPointer<VehicleState> vehicleState, double distanceMoved);
+
+private:
+    struct Event {
+        enum class Type {GNSS, IMU, Odom, Speed};
+        qint64 timestamp_ns;
+        Type type;
+        pospoint_t position;
+        double value;
+    };
+
+    void loadPositions(const FlightRecorderReader &reader, const QString &channelName, Event::Type type, PosType posType);
+    void replayEvent(const Event &event);
+
+    QSharedPointer<VehicleState> mVehicleState;
+    QSharedPointer<PurepursuitWaypointFollower> mWaypointFollower;
+    QVector<pospoint_t> mReferenceRoute;
+    PosType mCrossTrackPosType = PosType::fused;
+    bool mGnssIsFused = false;
+    QString mErrorString;
+    QVector<Event> mEvents; // sorted by timestamp
+
+    // Replay state
+    FlightRecorderReplayMetrics mMetrics;
+    bool mHasLastGnssPosition = false;
+    pospoint_t mLastGnssPosition;
+    bool mHasLastOdomPosition = false;
+    pospoint_t mLastOdomPosition;
+};
+
+#endif // FLIGHTRECORDERREPLAY_H
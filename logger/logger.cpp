@@ -8,7 +8,13 @@
 #include <QDir>
 #include <mavsdk/mavsdk.h>
 #include <QStandardPaths>
+#include <chrono>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
 #include "logger.h"
+#include "core/allocationtracker.h"
 
 QFile* Logger::logFile = nullptr;
 bool Logger::isInit = false;
@@ -21,12 +27,13 @@ Logger::Logger(QObject *parent)
 
 Logger::~Logger()
 {
+    qInstallMessageHandler(0);  // detach qInstallMessageHandler
+    stopWriter();
+
     if(logFile) {
         logFile->close();
         delete logFile;
     }
-
-    qInstallMessageHandler(0);  // detach qInstallMessageHandler
 }
 
 Logger& Logger::getInstance()
@@ -63,6 +70,7 @@ void Logger::initGroundStation()
     logFile->setFileName(fileName);
     logFile->open(QIODevice::Append | QIODevice::Text);
 
+    getInstance().startWriter();
     qInstallMessageHandler(Logger::messageOutput);
 
     Logger::isInit = true;
@@ -72,6 +80,7 @@ void Logger::initVehicle()
 {
     if(isInit)  return;
 
+    getInstance().startWriter();
     qInstallMessageHandler(Logger::messageOutput);
 
     Logger::isInit = true;
@@ -79,56 +88,315 @@ void Logger::initVehicle()
 
 void Logger::messageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
-    Q_UNUSED(context)
+    static const int allocationTag = AllocationTracker::getInstance().registerTag("LOG");
+    AllocationTracker::ScopedTag tag(allocationTag); // formatting msg is counted for the caller
+    Logger &logger = Logger::getInstance();
+    if (!logger.mWriterRunning) { // stopped, write directly
+        fprintf(stderr, "%s\n", qPrintable(msg));
+        return;
+    }
+
+    const qint64 timestamp_ms = QDateTime::currentMSecsSinceEpoch();
+    const bool queued = logger.mLogQueue.tryPush([&](LogRecord &record) {
+        record.timestamp_ms = timestamp_ms;
+        record.type = type;
+        record.file = context.file;
+        record.line = context.line;
+        record.length = encodeUtf8(msg, record.text, LOG_RECORD_TEXT_SIZE);
+    });
+    if (!queued)
+        logger.mDroppedMessages++;
+
+    if (type == QtFatalMsg) // application is aborted after return
+        logger.stopWriter();
+}
+
+void Logger::startWriter()
+{
+    if (mWriterRunning)
+        return;
+
+    {
+        const std::lock_guard<std::mutex> lock(mWriterMutex);
+        mStopWriter = false;
+    }
+    mWriterRunning = true;
+    mWriterThread = std::thread(&Logger::writerLoop, this);
+}
+
+void Logger::stopWriter()
+{
+    if (!mWriterRunning.exchange(false))
+        return;
+
+    {
+        const std::lock_guard<std::mutex> lock(mWriterMutex);
+        mStopWriter = true;
+    }
+    mWriterCondition.notify_one();
+    if (mWriterThread.joinable() && mWriterThread.get_id() != std::this_thread::get_id())
+        mWriterThread.join();
+}
+
+void Logger::writerLoop()
+{
+    AllocationTracker::ScopedTag tag(AllocationTracker::getInstance().registerTag("LOG"));
+    auto lastSync = std::chrono::steady_clock::now();
 
-    struct logItem {
-        QString log;
-        quint8 severity;
-    };
+    for (;;) {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(mWriterMutex);
+            mWriterCondition.wait_for(lock, std::chrono::milliseconds(WRITE_INTERVAL_ms), [this]() { return mStopWriter; });
+            stop = mStopWriter;
+        }
 
-    logItem newItem;
+        writeRecords();
 
+        const auto now = std::chrono::steady_clock::now();
+        if (logFile && (stop || now - lastSync >= std::chrono::milliseconds(FSYNC_INTERVAL_ms))) {
+            logFile->flush();
+#ifdef Q_OS_UNIX
+            fsync(logFile->handle());
+#endif
+            lastSync = now;
+        }
+
+        if (stop)
+            break;
+    }
+}
+
+namespace {
+const char *typeLabel(QtMsgType type)
+{
     switch (type) {
-    case QtDebugMsg:
-        newItem.log = QObject::tr("%1 | Debug: %2").arg(QDateTime::currentDateTime().toString("dd-MM-yyyy hh:mm:ss")).arg(qPrintable(msg));
-        newItem.severity = MAV_SEVERITY_DEBUG;
-        break;
-    case QtInfoMsg:
-        newItem.log = QObject::tr("%1 | Info: %2").arg(QDateTime::currentDateTime().toString("dd-MM-yyyy hh:mm:ss")).arg(qPrintable(msg));
-        newItem.severity = MAV_SEVERITY_INFO;
-        break;
-    case QtWarningMsg:
-        newItem.log = QObject::tr("%1 | Warning: %2").arg(QDateTime::currentDateTime().toString("dd-MM-yyyy hh:mm:ss")).arg(qPrintable(msg));
-        newItem.severity = MAV_SEVERITY_WARNING;
-        break;
-    case QtCriticalMsg:
-        newItem.log = QObject::tr("%1 | Critical: %2").arg(QDateTime::currentDateTime().toString("dd-MM-yyyy hh:mm:ss")).arg(qPrintable(msg));
-        newItem.severity = MAV_SEVERITY_CRITICAL;
-        break;
-    case QtFatalMsg:
-        newItem.log = QObject::tr("%1 | Fatal: %2").arg(QDateTime::currentDateTime().toString("dd-MM-yyyy hh:mm:ss")).arg(qPrintable(msg));
-        newItem.severity = MAV_SEVERITY_EMERGENCY;
-        break;
-    }
-
-    fprintf(stderr, "%s\n", qPrintable(newItem.log));
-
-    static QVector<logItem> logQueue;
-
-    if(Logger::getInstance().isConnected()) {
-        if(!logQueue.isEmpty())
-            for(const logItem &item : logQueue)
-                Logger::getInstance().emit logSent(item.log, item.severity);
-
-        logQueue.clear();
-
-        Logger::getInstance().emit logSent(newItem.log, newItem.severity);
-    } else
-        logQueue.push_back(newItem);
+    case QtDebugMsg: return "Debug";
+    case QtInfoMsg: return "Info";
+    case QtWarningMsg: return "Warning";
+    case QtCriticalMsg: return "Critical";
+    case QtFatalMsg: return "Fatal";
+    }
+    return "Unknown";
+}
 
-    if(logFile) {
-        newItem.log.append("\n");
-        logFile->write(newItem.log.toLocal8Bit());
-        logFile->flush();
+quint8 typeSeverity(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg: return MAV_SEVERITY_DEBUG;
+    case QtInfoMsg: return MAV_SEVERITY_INFO;
+    case QtWarningMsg: return MAV_SEVERITY_WARNING;
+    case QtCriticalMsg: return MAV_SEVERITY_CRITICAL;
+    case QtFatalMsg: return MAV_SEVERITY_EMERGENCY;
+    }
+    return MAV_SEVERITY_DEBUG;
+}
+
+// Call site from file/line, otherwise from message text ignoring digits (changing values), FNV-1a
+quint64 callSiteKey(const char *file, int line, const char *text, int length)
+{
+    quint64 key = 14695981039346656037ull;
+    auto add = [&key](quint64 value) { key = (key ^ value) * 1099511628211ull; };
+    if (file) {
+        add(quintptr(file));
+        add(quint64(line));
+    } else {
+        for (int i = 0; i < length; i++)
+            if (text[i] < '0' || text[i] > '9')
+                add(quint8(text[i]));
     }
+    return key;
+}
+}
+
+void Logger::writeRecords()
+{
+    mBatch.clear();
+    mNewSignals.clear();
+    const qint64 now_ms = QDateTime::currentMSecsSinceEpoch();
+
+    while (mLogQueue.tryPop([this](const LogRecord &record) {
+        processRecord(record);
+    }));
+
+    const quint64 droppedMessages = mDroppedMessages;
+    if (droppedMessages > mReportedDroppedMessages) {
+        writeNote(QtWarningMsg, QString("Logger queue full, dropped %1 messages").arg(droppedMessages - mReportedDroppedMessages));
+        mReportedDroppedMessages = droppedMessages;
+    }
+
+    if (mRepetitions > 0 && now_ms - mFirstRepetition_ms >= REPEAT_REPORT_INTERVAL_ms)
+        reportRepetitions();
+    if (now_ms - mLastCallSiteCheck_ms >= RATE_LIMIT_INTERVAL_ms) {
+        for (auto it = mCallSites.begin(); it != mCallSites.end();) {
+            if (now_ms - it.value().windowStart_ms >= RATE_LIMIT_INTERVAL_ms)
+                reportSuppressedMessages(it.value());
+
+            if (now_ms - it.value().windowStart_ms >= 60 * RATE_LIMIT_INTERVAL_ms) // forget idle call sites
+                it = mCallSites.erase(it);
+            else
+                it++;
+        }
+        mLastCallSiteCheck_ms = now_ms;
+    }
+
+    if (mBatch.isEmpty())
+        return;
+
+    fwrite(mBatch.constData(), 1, mBatch.size(), stderr);
+    fflush(stderr);
+    if (logFile)
+        logFile->write(mBatch);
+
+    if (isConnected()) {
+        for (const auto &pendingSignal : mPendingSignals)
+            emit logSent(pendingSignal.first, pendingSignal.second);
+        mPendingSignals.clear();
+        for (const auto &newSignal : mNewSignals)
+            emit logSent(newSignal.first, newSignal.second);
+    } else {
+        mPendingSignals.append(mNewSignals);
+        if (mPendingSignals.size() > MAX_PENDING_SIGNALS)
+            mPendingSignals.remove(0, mPendingSignals.size() - MAX_PENDING_SIGNALS);
+    }
+}
+
+void Logger::processRecord(const LogRecord &record)
+{
+    const qint64 now_ms = record.timestamp_ms;
+    if (record.type == QtFatalMsg) {
+        reportRepetitions();
+        writeRecord(record);
+        return;
+    }
+
+    const quint64 key = callSiteKey(record.file, record.line, record.text, record.length);
+
+    // Collapse consecutive identical messages
+    if (mRepetitions >= 0 && key == mLastMessageKey && record.type == mLastMessageType &&
+            mLastMessageText.size() == record.length && memcmp(mLastMessageText.constData(), record.text, record.length) == 0) {
+        if (mRepetitions++ == 0)
+            mFirstRepetition_ms = now_ms;
+        return;
+    }
+    reportRepetitions();
+
+    CallSite &callSite = mCallSites[key];
+    if (now_ms - callSite.windowStart_ms >= RATE_LIMIT_INTERVAL_ms) {
+        reportSuppressedMessages(callSite);
+        callSite.windowStart_ms = now_ms;
+        callSite.messages = 0;
+    }
+    if (++callSite.messages > RATE_LIMIT_MESSAGES) {
+        if (callSite.suppressed++ == 0) {
+            callSite.type = record.type;
+            callSite.suppressedExample = QByteArray(record.text, record.length);
+        }
+        mSuppressedMessages++;
+        return;
+    }
+
+    writeRecord(record);
+    mLastMessageKey = key;
+    mLastMessageType = record.type;
+    mLastMessageText.resize(record.length);
+    memcpy(mLastMessageText.data(), record.text, record.length);
+    mRepetitions = 0;
+}
+
+void Logger::writeRecord(const LogRecord &record)
+{
+    const int lineStart = mBatch.size();
+    appendFormatted(mBatch, record);
+    mNewSignals.append({QString::fromUtf8(mBatch.constData() + lineStart, mBatch.size() - lineStart - 1), typeSeverity(record.type)});
+}
+
+void Logger::writeNote(QtMsgType type, const QString &note)
+{
+    LogRecord record;
+    record.timestamp_ms = QDateTime::currentMSecsSinceEpoch();
+    record.type = type;
+    record.file = nullptr;
+    record.line = 0;
+    record.length = encodeUtf8(note, record.text, LOG_RECORD_TEXT_SIZE);
+    writeRecord(record);
+}
+
+void Logger::reportRepetitions()
+{
+    if (mRepetitions > 0)
+        writeNote(mLastMessageType, QString("Last message repeated %1 times").arg(mRepetitions));
+    mRepetitions = mRepetitions >= 0 ? 0 : -1; // further repetitions are counted again
+    mFirstRepetition_ms = 0;
+}
+
+void Logger::reportSuppressedMessages(CallSite &callSite)
+{
+    if (callSite.suppressed == 0)
+        return;
+
+    writeNote(callSite.type, QString("Suppressed %1 messages like: %2").arg(callSite.suppressed).arg(QString::fromUtf8(callSite.suppressedExample)));
+    callSite.suppressed = 0;
+    callSite.suppressedExample.clear();
+}
+
+void Logger::appendFormatted(QByteArray &batch, const LogRecord &record)
+{
+    // Time formatting is expensive, done once per second
+    const qint64 second = record.timestamp_ms / 1000;
+    if (second != mCachedTimeSecond) {
+        mCachedTimeString = QDateTime::fromMSecsSinceEpoch(second * 1000).toString("dd-MM-yyyy hh:mm:ss").toUtf8();
+        mCachedTimeSecond = second;
+    }
+
+    batch.append(mCachedTimeString);
+    batch.append(" | ");
+    batch.append(typeLabel(record.type));
+    batch.append(": ");
+    batch.append(record.text, record.length);
+    batch.append('\n');
+}
+
+int Logger::encodeUtf8(const QString &msg, char *buffer, int bufferSize)
+{
+    const ushort *utf16 = msg.utf16();
+    const int size = msg.size();
+    int length = 0;
+
+    for (int i = 0; i < size; i++) {
+        uint codePoint = utf16[i];
+        if (QChar::isHighSurrogate(codePoint) && i + 1 < size && QChar::isLowSurrogate(utf16[i + 1])) {
+            codePoint = QChar::surrogateToUcs4(utf16[i], utf16[i + 1]);
+            i++;
+        }
+
+        char encoded[4];
+        int encodedLength;
+        if (codePoint < 0x80) {
+            encoded[0] = char(codePoint);
+            encodedLength = 1;
+        } else if (codePoint < 0x800) {
+            encoded[0] = char(0xC0 | (codePoint >> 6));
+            encoded[1] = char(0x80 | (codePoint & 0x3F));
+            encodedLength = 2;
+        } else if (codePoint < 0x10000) {
+            encoded[0] = char(0xE0 | (codePoint >> 12));
+            encoded[1] = char(0x80 | ((codePoint >> 6) & 0x3F));
+            encoded[2] = char(0x80 | (codePoint & 0x3F));
+            encodedLength = 3;
+        } else {
+            encoded[0] = char(0xF0 | (codePoint >> 18));
+            encoded[1] = char(0x80 | ((codePoint >> 12) & 0x3F));
+            encoded[2] = char(0x80 | ((codePoint >> 6) & 0x3F));
+            encoded[3] = char(0x80 | (codePoint & 0x3F));
+            encodedLength = 4;
+        }
+
+        if (length + encodedLength > bufferSize) // truncate at character boundary
+            break;
+        memcpy(buffer + length, encoded, encodedLength);
+        length += encodedLength;
+    }
+
+    return length;
 }
@@ -1,6 +1,13 @@
 /*
  *     Copyright 2023 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Installs a Qt message handler that writes log messages to stderr, a log file (ground station) and emits them with logSent().
+ * The handler only copies messages into preallocated records of a lock-free queue, formatting and (batched) writing is done by
+ * a background thread, which also syncs the log file to disk periodically. When the queue is full, messages are dropped and counted.
+ * Fatal messages are written before the handler returns.
+ * To contain log storms, consecutive identical messages are collapsed into a "repeated N times" note and every call site
+ * (file/line if available, message text without digits otherwise) may log at most RATE_LIMIT_MESSAGES per RATE_LIMIT_INTERVAL_ms.
  */
 
 #ifndef LOGGER_H
@@ -9,6 +16,14 @@
 #include <QObject>
 #include <QMetaMethod>
 #include <QFile>
+#include <QVector>
+#include <QPair>
+#include <QHash>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "core/mpscringbuffer.h"
 
 class Logger : public QObject {
     Q_OBJECT
@@ -23,15 +38,80 @@ public:
 
     static void messageOutput(QtMsgType type, const QMessageLogContext& context, const QString& msg);
 
+    quint64 getDroppedMessages() const { return mDroppedMessages; }
+    quint64 getSuppressedMessages() const { return mSuppressedMessages; } // by rate limiting, repetitions not included
+
+    static constexpr int LOG_RECORD_TEXT_SIZE = 480; // [bytes] UTF-8, longer messages are truncated
+    static constexpr size_t LOG_QUEUE_CAPACITY = 1024;
+    static constexpr int WRITE_INTERVAL_ms = 20;
+    static constexpr int FSYNC_INTERVAL_ms = 1000;
+    static constexpr int MAX_PENDING_SIGNALS = 1000; // kept until logSent is connected
+    static constexpr int RATE_LIMIT_MESSAGES = 10;
+    static constexpr int RATE_LIMIT_INTERVAL_ms = 1000;
+    static constexpr int REPEAT_REPORT_INTERVAL_ms = 5000; // repetitions of a message are reported at least that often
+
 private:
+    struct LogRecord {
+        qint64 timestamp_ms;
+        QtMsgType type;
+        const char *file; // from QMessageLogContext, static storage, nullptr if not available
+        int line;
+        int length;
+        char text[LOG_RECORD_TEXT_SIZE];
+    };
+
     explicit Logger(QObject *parent = nullptr);
 
     ~Logger();
 
+    void startWriter();
+    void stopWriter(); // writes everything queued before returning
+    void writerLoop();
+    void writeRecords();
+    void processRecord(const LogRecord &record);
+    void writeRecord(const LogRecord &record);
+    void writeNote(QtMsgType type, const QString &note);
+    void reportRepetitions();
+    void appendFormatted(QByteArray &batch, const LogRecord &record);
+    static int encodeUtf8(const QString &msg, char *buffer, int bufferSize);
+
     static QFile* logFile;
 
     static bool isInit;
 
+    MpscRingBuffer<LogRecord, LOG_QUEUE_CAPACITY> mLogQueue;
+    std::atomic<quint64> mDroppedMessages {0};
+    quint64 mReportedDroppedMessages = 0; // writer thread
+    std::thread mWriterThread;
+    std::atomic<bool> mWriterRunning {false};
+    std::mutex mWriterMutex;
+    std::condition_variable mWriterCondition;
+    bool mStopWriter = false; // protected by mWriterMutex
+    std::atomic<quint64> mSuppressedMessages {0};
+
+    // Writer thread
+    struct CallSite {
+        qint64 windowStart_ms = 0;
+        int messages = 0;
+        quint64 suppressed = 0;
+        QtMsgType type = QtDebugMsg;
+        QByteArray suppressedExample;
+    };
+    void reportSuppressedMessages(CallSite &callSite);
+
+    QByteArray mBatch;
+    QVector<QPair<QString, quint8>> mNewSignals;
+    QVector<QPair<QString, quint8>> mPendingSignals;
+    QHash<quint64, CallSite> mCallSites;
+    qint64 mLastCallSiteCheck_ms = 0;
+    quint64 mLastMessageKey = 0;
+    QtMsgType mLastMessageType = QtDebugMsg;
+    QByteArray mLastMessageText;
+    int mRepetitions = -1; // of the last message, -1: none written yet
+    qint64 mFirstRepetition_ms = 0;
+    qint64 mCachedTimeSecond = -1;
+    QByteArray mCachedTimeString;
+
 signals:
     void logSent(const QString& message, const quint8& severity);
 };
@@ -0,0 +1,62 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Segment file layout shared by RawStreamRecorder and RawStreamReplay (native byte order):
+ * SegmentHeader (padded to SEGMENT_HEADER_SIZE), an index of IndexEntry (indexCapacity entries, one per index interval, i.e.,
+ * timestamp to data offset), then records (RecordHeader + the raw bytes as received, padded to RECORD_ALIGNMENT).
+ * Segments are pre-allocated to their full size. usedBytes and indexCount are the commit: they are written after the data they
+ * cover, everything beyond them is invalid.
+ */
+
+#ifndef RAWSTREAMFORMAT_H
+#define RAWSTREAMFORMAT_H
+
+#include <QtGlobal>
+
+namespace rawStreamFormat {
+
+constexpr char SEGMENT_MAGIC[8] = {'W', 'W', 'R', 'A', 'W', 'S', 'T', 'R'};
+constexpr quint32 VERSION = 1;
+constexpr int MAX_STREAMS = 8;
+constexpr int STREAM_NAME_SIZE = 32;
+constexpr quint32 SEGMENT_HEADER_SIZE = 4096;
+constexpr quint32 RECORD_ALIGNMENT = 8;
+
+struct SegmentHeader {
+    char magic[8];
+    quint32 version;
+    quint32 segmentIndex; // of the recording, starting at 0
+    quint64 segmentSize; // [bytes], pre-allocated
+    quint64 dataOffset; // [bytes] from the start of the segment
+    quint32 indexCapacity;
+    quint32 streamCount;
+    char streamNames[MAX_STREAMS][STREAM_NAME_SIZE]; // zero-terminated, e.g., "ublox", "rtcm"
+    qint64 startTime_ns; // UTC and steady clock at the same time, to convert record timestamps
+    qint64 startSteady_ns;
+    // Commit
+    quint64 usedBytes; // record bytes after dataOffset
+    quint32 indexCount;
+    quint32 reserved;
+};
+static_assert(sizeof(SegmentHeader) <= SEGMENT_HEADER_SIZE, "raw stream segment header does not fit");
+
+struct IndexEntry {
+    qint64 timestamp_ns; // steady clock, of the record at offset
+    quint64 offset; // [bytes] after dataOffset
+};
+
+struct RecordHeader {
+    quint32 size; // raw bytes
+    quint16 stream;
+    quint16 reserved;
+    qint64 timestamp_ns; // steady clock, reception
+};
+
+constexpr quint64 recordSize(quint32 size) {
+    return (sizeof(RecordHeader) + size + RECORD_ALIGNMENT - 1) & ~quint64(RECORD_ALIGNMENT - 1);
+}
+
+}
+
+#endif // RAWSTREAMFORMAT_H
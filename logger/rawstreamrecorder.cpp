@@ -0,0 +1,321 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "rawstreamrecorder.h"
+#include "core/threadconfig.h"
+#include "core/utctime.h"
+#include <QDebug>
+#include <cstddef>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace rawStreamFormat;
+
+RawStreamRecorder::~RawStreamRecorder()
+{
+    stop();
+}
+
+int RawStreamRecorder::addStream(const QString &name)
+{
+    if (mRecording) {
+        qWarning() << "WARNING: RawStreamRecorder cannot add stream" << name << "while recording.";
+        return -1;
+    }
+    if (mStreamNames.size() >= MAX_STREAMS || name.toUtf8().size() >= STREAM_NAME_SIZE) {
+        qWarning() << "WARNING: RawStreamRecorder cannot add stream" << name << "(too many streams or name too long).";
+        return -1;
+    }
+
+    mStreamNames.append(name);
+    return mStreamNames.size() - 1;
+}
+
+bool RawStreamRecorder::start(const QString &basename, int maxSegments, quint64 segmentSize)
+{
+    if (mRecording)
+        return false;
+
+    const quint64 minSegmentSize = SEGMENT_HEADER_SIZE + INDEX_CAPACITY * sizeof(IndexEntry) + (1 << 16);
+    if (mStreamNames.isEmpty() || (maxSegments != 0 && maxSegments < 2) || segmentSize < minSegmentSize) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mErrorString = "no streams added, maxSegments below 2 or segments smaller than " + QString::number(minSegmentSize) + " bytes.";
+        qWarning() << "WARNING: RawStreamRecorder could not start:" << mErrorString;
+        return false;
+    }
+
+    mBasename = basename;
+    mMaxSegments = maxSegments;
+    mSegmentSize = segmentSize;
+    mStartTime_ns = utcTime::now_ns();
+    mStartSteady_ns = utcTime::steadyNow_ns();
+
+    QString errorString;
+    std::unique_ptr<Segment> segment = createSegment(0, errorString);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!segment) {
+        mErrorString = errorString;
+        qWarning() << "WARNING: RawStreamRecorder could not start:" << mErrorString;
+        return false;
+    }
+
+    mErrorString.clear();
+    mStatistics = RawStreamRecorderStatistics();
+    mStatistics.segments = 1;
+    mStatistics.currentSegmentIndex = 0;
+    mSegment = std::move(segment);
+    mNextSegmentRequested = false;
+    mStopMaintenance = false;
+    mMaintenanceThread = std::thread([this]() { maintenanceLoop(); });
+    mRecording = true;
+    return true;
+}
+
+void RawStreamRecorder::stop()
+{
+    if (!mRecording)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRecording = false;
+        mStopMaintenance = true;
+    }
+    mMaintenanceCondition.notify_all();
+    mMaintenanceThread.join();
+
+    // Only this thread is left, writers drop their chunks while not recording
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto &retiredSegment : mRetiredSegments)
+        closeSegment(*retiredSegment);
+    mRetiredSegments.clear();
+    if (mSegment)
+        closeSegment(*mSegment);
+    mSegment.reset();
+    if (mNextSegment) { // never written to
+        closeSegment(*mNextSegment);
+        mNextSegment->file.remove();
+    }
+    mNextSegment.reset();
+}
+
+QString RawStreamRecorder::getErrorString() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mErrorString;
+}
+
+RawStreamRecorderStatistics RawStreamRecorder::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStatistics;
+}
+
+QString RawStreamRecorder::getSegmentFilename(const QString &basename, int segmentIndex)
+{
+    return basename + QString("_%1.wwraw").arg(segmentIndex, 4, 10, QChar('0'));
+}
+
+void RawStreamRecorder::write(int streamId, const char *data, quint32 size, qint64 rxSteady_ns)
+{
+    if (streamId < 0 || streamId >= mStreamNames.size() || size == 0)
+        return;
+
+    const quint64 bytes = recordSize(size);
+    const quint64 dataCapacity = mSegmentSize - SEGMENT_HEADER_SIZE - INDEX_CAPACITY * sizeof(IndexEntry);
+    bool notify = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mRecording || !mSegment)
+            return;
+
+        const bool needsIndex = rxSteady_ns >= mSegment->nextIndex_ns;
+        if (mSegment->usedBytes + bytes > dataCapacity || (needsIndex && mSegment->indexCount == INDEX_CAPACITY)) {
+            if (!mNextSegment) {
+                mStatistics.droppedChunks++;
+                if (!mNextSegmentRequested) {
+                    mNextSegmentRequested = true;
+                    mMaintenanceCondition.notify_all();
+                }
+                return;
+            }
+            commit(*mSegment);
+            mRetiredSegments.push_back(std::move(mSegment));
+            mSegment = std::move(mNextSegment);
+            mStatistics.segments++;
+            mStatistics.currentSegmentIndex = mSegment->segmentIndex;
+            notify = true;
+        }
+
+        Segment &segment = *mSegment;
+        uchar *dataArea = segment.map + SEGMENT_HEADER_SIZE + INDEX_CAPACITY * sizeof(IndexEntry);
+        if (rxSteady_ns >= segment.nextIndex_ns) {
+            const IndexEntry indexEntry = {rxSteady_ns, segment.usedBytes};
+            memcpy(segment.map + SEGMENT_HEADER_SIZE + segment.indexCount * sizeof(IndexEntry), &indexEntry, sizeof(indexEntry));
+            segment.indexCount++;
+            segment.nextIndex_ns = rxSteady_ns + INDEX_INTERVAL_MS * utcTime::NS_PER_MS;
+        }
+
+        const RecordHeader recordHeader = {size, quint16(streamId), 0, rxSteady_ns};
+        memcpy(dataArea + segment.usedBytes, &recordHeader, sizeof(recordHeader));
+        memcpy(dataArea + segment.usedBytes + sizeof(recordHeader), data, size);
+        segment.usedBytes += bytes;
+        commit(segment);
+
+        mStatistics.chunks++;
+        mStatistics.bytes += size;
+        if (!mNextSegment && !mNextSegmentRequested &&
+                (segment.usedBytes > PREPARE_NEXT_RATIO * dataCapacity || segment.indexCount > PREPARE_NEXT_RATIO * INDEX_CAPACITY)) {
+            mNextSegmentRequested = true;
+            notify = true;
+        }
+    }
+
+    if (notify)
+        mMaintenanceCondition.notify_all();
+}
+
+void RawStreamRecorder::write(int streamId, const QByteArray &data, std::chrono::steady_clock::time_point rxTime)
+{
+    write(streamId, data.constData(), quint32(data.size()), std::chrono::duration_cast<std::chrono::nanoseconds>(rxTime.time_since_epoch()).count());
+}
+
+RawStreamRecorder::Tap RawStreamRecorder::getTap(int streamId)
+{
+    return [this, streamId](const QByteArray &data, std::chrono::steady_clock::time_point rxTime) {
+        write(streamId, data, rxTime);
+    };
+}
+
+std::unique_ptr<RawStreamRecorder::Segment> RawStreamRecorder::createSegment(int segmentIndex, QString &errorString) const
+{
+    std::unique_ptr<Segment> segment(new Segment);
+    segment->segmentIndex = segmentIndex;
+    segment->file.setFileName(getSegmentFilename(mBasename, segmentIndex));
+    if (!segment->file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        errorString = "could not open \"" + segment->file.fileName() + "\" for writing.";
+        return nullptr;
+    }
+
+    // Allocate the blocks now, writing through the mapping must not fail or wait for the file system later
+#ifdef Q_OS_LINUX
+    const int result = posix_fallocate(segment->file.handle(), 0, off_t(mSegmentSize));
+    if (result != 0) {
+        errorString = "could not allocate " + QString::number(mSegmentSize) + " bytes for \"" + segment->file.fileName() + "\": " + strerror(result);
+        segment->file.close();
+        segment->file.remove();
+        return nullptr;
+    }
+#else
+    if (!segment->file.resize(qint64(mSegmentSize))) {
+        errorString = "could not resize \"" + segment->file.fileName() + "\": " + segment->file.errorString();
+        segment->file.close();
+        segment->file.remove();
+        return nullptr;
+    }
+#endif
+
+    segment->map = segment->file.map(0, qint64(mSegmentSize));
+    if (!segment->map) {
+        errorString = "could not map \"" + segment->file.fileName() + "\": " + segment->file.errorString();
+        segment->file.close();
+        segment->file.remove();
+        return nullptr;
+    }
+
+    SegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.segmentIndex = quint32(segmentIndex);
+    header.segmentSize = mSegmentSize;
+    header.dataOffset = SEGMENT_HEADER_SIZE + INDEX_CAPACITY * sizeof(IndexEntry);
+    header.indexCapacity = INDEX_CAPACITY;
+    header.streamCount = quint32(mStreamNames.size());
+    for (int i = 0; i < mStreamNames.size(); i++) {
+        const QByteArray name = mStreamNames.at(i).toUtf8();
+        memcpy(header.streamNames[i], name.constData(), name.size());
+    }
+    header.startTime_ns = mStartTime_ns;
+    header.startSteady_ns = mStartSteady_ns;
+    memcpy(segment->map, &header, sizeof(header));
+
+    return segment;
+}
+
+void RawStreamRecorder::commit(Segment &segment) const
+{
+    // Records and index entries before the counts that make them valid
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(segment.map + offsetof(SegmentHeader, indexCount), &segment.indexCount, sizeof(segment.indexCount));
+    memcpy(segment.map + offsetof(SegmentHeader, usedBytes), &segment.usedBytes, sizeof(segment.usedBytes));
+}
+
+void RawStreamRecorder::closeSegment(Segment &segment) const
+{
+    if (!segment.map)
+        return;
+
+    commit(segment);
+    segment.file.unmap(segment.map);
+    segment.map = nullptr;
+    segment.file.resize(qint64(SEGMENT_HEADER_SIZE + INDEX_CAPACITY * sizeof(IndexEntry) + segment.usedBytes));
+#ifdef Q_OS_UNIX
+    fsync(segment.file.handle());
+#endif
+    segment.file.close();
+}
+
+void RawStreamRecorder::maintenanceLoop()
+{
+    ThreadConfig::getInstance().applyToCurrentThread(ThreadConfig::Role::Logging);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStopMaintenance) {
+        mMaintenanceCondition.wait_for(lock, std::chrono::milliseconds(SYNC_INTERVAL_MS));
+        if (mStopMaintenance)
+            break;
+
+        // Close retired segments, prepare the next one and sync without holding the lock (writers keep writing)
+        std::vector<std::unique_ptr<Segment>> retiredSegments;
+        retiredSegments.swap(mRetiredSegments);
+        const bool prepareNext = mNextSegmentRequested && !mNextSegment;
+        const int nextSegmentIndex = mSegment ? mSegment->segmentIndex + 1 : 0;
+        const int fileHandle = mSegment ? mSegment->file.handle() : -1; // closed only by this thread (via retired segments)
+        lock.unlock();
+
+        for (auto &retiredSegment : retiredSegments)
+            closeSegment(*retiredSegment);
+
+        std::unique_ptr<Segment> nextSegment;
+        QString errorString;
+        if (prepareNext) {
+            if (mMaxSegments > 0 && nextSegmentIndex >= mMaxSegments)
+                QFile::remove(getSegmentFilename(mBasename, nextSegmentIndex - mMaxSegments));
+            nextSegment = createSegment(nextSegmentIndex, errorString);
+            if (!nextSegment)
+                qWarning() << "WARNING: RawStreamRecorder could not prepare the next segment:" << errorString;
+        }
+
+#ifdef Q_OS_UNIX
+        if (fileHandle >= 0)
+            fsync(fileHandle); // includes pages written through the mapping
+#else
+        (void)fileHandle;
+#endif
+
+        lock.lock();
+        if (prepareNext) {
+            if (nextSegment)
+                mNextSegment = std::move(nextSegment);
+            else
+                mErrorString = errorString;
+            mNextSegmentRequested = false; // retried on the next request after a failure
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Recorder of raw byte streams as received (e.g., UBX/NMEA/RTCM from the receiver and RTCM corrections), for post-processing.
+ * Sources tee their chunks in at the reception layer (see getTap, Ublox::setRawDataTap, RtcmClient::setRawDataTap): the chunk is
+ * copied once, directly into a pre-allocated, memory-mapped segment file (see rawStreamFormat), with an index entry per
+ * INDEX_INTERVAL_MS. Writing only takes a short lock, a maintenance thread (ThreadConfig logging role) syncs to disk, prepares
+ * the next segment ahead of time and closes and deletes old ones (rotation: basename_0000.wwraw, basename_0001.wwraw, ...).
+ * Chunks that do not fit while the next segment is not ready yet are dropped and counted instead of blocking the source.
+ * Use RawStreamReplay to feed recordings back to Ublox.
+ */
+
+#ifndef RAWSTREAMRECORDER_H
+#define RAWSTREAMRECORDER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "logger/rawstreamformat.h"
+
+struct RawStreamRecorderStatistics {
+    quint64 chunks = 0;
+    quint64 bytes = 0;
+    quint64 droppedChunks = 0;
+    quint64 segments = 0;
+    int currentSegmentIndex = -1;
+};
+
+class RawStreamRecorder
+{
+public:
+    using Tap = std::function<void(const QByteArray &data, std::chrono::steady_clock::time_point rxTime)>;
+
+    static constexpr quint64 DEFAULT_SEGMENT_SIZE = 64 << 20; // [bytes]
+    static constexpr quint32 INDEX_CAPACITY = 4096; // index entries per segment, a segment is full after that many intervals
+    static constexpr int INDEX_INTERVAL_MS = 1000;
+    static constexpr int SYNC_INTERVAL_MS = 1000;
+    static constexpr double PREPARE_NEXT_RATIO = 0.5; // of the segment used when the next one is prepared
+
+    RawStreamRecorder() = default;
+    ~RawStreamRecorder();
+
+    // Streams can only be added while not recording, returns the stream id or -1
+    int addStream(const QString &name);
+    // maxSegments: older segments are deleted (0: keep all)
+    bool start(const QString &basename, int maxSegments = 0, quint64 segmentSize = DEFAULT_SEGMENT_SIZE);
+    void stop(); // commits and closes, the last segment is truncated to its used size
+    bool isRecording() const { return mRecording; }
+    QString getErrorString() const;
+    RawStreamRecorderStatistics getStatistics() const;
+    static QString getSegmentFilename(const QString &basename, int segmentIndex);
+
+    // Thread-safe, drops the chunk when not recording
+    void write(int streamId, const char *data, quint32 size, qint64 rxSteady_ns);
+    void write(int streamId, const QByteArray &data, std::chrono::steady_clock::time_point rxTime);
+    // To be set on sources, writes to streamId (the recorder needs to outlive the sources)
+    Tap getTap(int streamId);
+
+private:
+    struct Segment {
+        QFile file;
+        uchar *map = nullptr;
+        int segmentIndex = 0;
+        quint64 usedBytes = 0;
+        quint32 indexCount = 0;
+        qint64 nextIndex_ns = 0;
+    };
+
+    std::unique_ptr<Segment> createSegment(int segmentIndex, QString &errorString) const;
+    void commit(Segment &segment) const;
+    void closeSegment(Segment &segment) const;
+    void maintenanceLoop();
+
+    QStringList mStreamNames; // only modified while not recording
+    QString mBasename;
+    int mMaxSegments = 0;
+    quint64 mSegmentSize = DEFAULT_SEGMENT_SIZE;
+    std::atomic<bool> mRecording{false};
+    qint64 mStartTime_ns = 0;
+    qint64 mStartSteady_ns = 0;
+
+    mutable std::mutex mMutex; // segments, statistics
+    std::condition_variable mMaintenanceCondition;
+    std::thread mMaintenanceThread;
+    bool mStopMaintenance = false;
+    std::unique_ptr<Segment> mSegment; // written to
+    std::unique_ptr<Segment> mNextSegment; // prepared by the maintenance thread
+    bool mNextSegmentRequested = false;
+    std::vector<std::unique_ptr<Segment>> mRetiredSegments; // to be closed by the maintenance thread
+    QString mErrorString;
+    RawStreamRecorderStatistics mStatistics;
+};
+
+#endif // RAWSTREAMRECORDER_H
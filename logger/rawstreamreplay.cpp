@@ -0,0 +1,249 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "rawstreamreplay.h"
+#include "core/utctime.h"
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+
+using namespace rawStreamFormat;
+
+RawStreamReplay::RawStreamReplay(QObject *parent) : QObject(parent)
+{
+    mTimer.setSingleShot(true);
+    mTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mTimer, &QTimer::timeout, this, &RawStreamReplay::replayDue);
+}
+
+RawStreamReplay::~RawStreamReplay()
+{
+    close();
+}
+
+bool RawStreamReplay::open(const QString &basenameOrFilename)
+{
+    close();
+
+    QStringList filenames;
+    const QFileInfo fileInfo(basenameOrFilename);
+    if (fileInfo.isFile())
+        filenames.append(basenameOrFilename);
+    else {
+        // Rotation may have deleted the first segments, zero-padded indices sort by name
+        const QDir directory = fileInfo.absoluteDir();
+        for (const QString &filename : directory.entryList({fileInfo.fileName() + "_*.wwraw"}, QDir::Files, QDir::Name))
+            filenames.append(directory.filePath(filename));
+    }
+    if (filenames.isEmpty()) {
+        mErrorString = "No recording \"" + basenameOrFilename + "\" found.";
+        return false;
+    }
+
+    for (const QString &filename : filenames)
+        if (!openSegment(filename)) {
+            close();
+            return false;
+        }
+
+    // Record count and time span, headers only
+    RecordHeader recordHeader;
+    const char *recordData;
+    while (peek(recordHeader, recordData)) {
+        if (mRecordCount == 0)
+            mFirstTimestamp_ns = recordHeader.timestamp_ns;
+        mLastTimestamp_ns = recordHeader.timestamp_ns;
+        mRecordCount++;
+        mPosition.offset += recordSize(recordHeader.size);
+    }
+    mPosition = Position();
+
+    mErrorString.clear();
+    return true;
+}
+
+bool RawStreamReplay::openSegment(const QString &filename)
+{
+    Segment segment;
+    segment.file.reset(new QFile(filename));
+    const qint64 size = segment.file->size();
+    if (!segment.file->open(QIODevice::ReadOnly) || size < SEGMENT_HEADER_SIZE || !(segment.map = segment.file->map(0, size))) {
+        mErrorString = "Could not open and map \"" + filename + "\".";
+        return false;
+    }
+    mSegments.push_back(std::move(segment));
+    Segment &openedSegment = mSegments.back();
+
+    SegmentHeader header;
+    memcpy(&header, openedSegment.map, sizeof(header));
+    if (memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) != 0 || header.version != VERSION ||
+            header.streamCount > quint32(MAX_STREAMS) || header.dataOffset < SEGMENT_HEADER_SIZE + header.indexCapacity * sizeof(IndexEntry) ||
+            header.dataOffset > quint64(size)) {
+        mErrorString = "\"" + filename + "\" is no raw stream recording (or of another version).";
+        return false;
+    }
+
+    if (mSegments.size() == 1) {
+        for (quint32 i = 0; i < header.streamCount; i++)
+            mStreamNames.append(QString::fromUtf8(header.streamNames[i], int(strnlen(header.streamNames[i], STREAM_NAME_SIZE))));
+        mStartTime_ns = header.startTime_ns;
+    }
+
+    // Only up to the commit, a crashed recording has zeros or incomplete records beyond it
+    openedSegment.index = reinterpret_cast<const IndexEntry*>(openedSegment.map + SEGMENT_HEADER_SIZE);
+    openedSegment.indexCount = std::min(header.indexCount, header.indexCapacity);
+    openedSegment.data = openedSegment.map + header.dataOffset;
+    openedSegment.usedBytes = std::min(header.usedBytes, quint64(size) - header.dataOffset);
+    return true;
+}
+
+void RawStreamReplay::close()
+{
+    stop();
+    for (Segment &segment : mSegments) {
+        segment.file->unmap(const_cast<uchar*>(segment.map));
+        segment.file->close();
+    }
+    mSegments.clear();
+    mStreamNames.clear();
+    mStartTime_ns = -1;
+    mFirstTimestamp_ns = -1;
+    mLastTimestamp_ns = -1;
+    mRecordCount = 0;
+    mPosition = Position();
+}
+
+qint64 RawStreamReplay::getDuration_ns() const
+{
+    return mRecordCount > 0 ? mLastTimestamp_ns - mFirstTimestamp_ns : 0;
+}
+
+void RawStreamReplay::setUblox(Ublox *ublox, int streamId)
+{
+    mUblox = ublox;
+    mUbloxStreamId = streamId;
+}
+
+void RawStreamReplay::setSpeed(double speed)
+{
+    if (speed <= 0.0)
+        return;
+
+    mSpeed = speed;
+    if (isRunning()) // continue from the next record at the new speed
+        start();
+}
+
+bool RawStreamReplay::seek(qint64 offsetFromStart_ns)
+{
+    if (mRecordCount == 0)
+        return false;
+
+    const qint64 timestamp_ns = mFirstTimestamp_ns + offsetFromStart_ns;
+    Position position;
+    for (int i = 0; i < int(mSegments.size()); i++) {
+        const Segment &segment = mSegments.at(i);
+        if (segment.indexCount == 0 || segment.index[0].timestamp_ns > timestamp_ns)
+            break;
+
+        const IndexEntry *entry = std::upper_bound(segment.index, segment.index + segment.indexCount, timestamp_ns,
+                                                   [](qint64 timestamp_ns, const IndexEntry &entry) { return timestamp_ns < entry.timestamp_ns; }) - 1;
+        position = {i, entry->offset};
+    }
+
+    mPosition = position;
+    if (isRunning())
+        start();
+    return true;
+}
+
+void RawStreamReplay::start()
+{
+    stop();
+
+    RecordHeader recordHeader;
+    const char *recordData;
+    if (!peek(recordHeader, recordData)) {
+        emit finished();
+        return;
+    }
+
+    mReplayStartSteady_ns = utcTime::steadyNow_ns();
+    mReplayStartTimestamp_ns = recordHeader.timestamp_ns;
+    replayDue();
+}
+
+void RawStreamReplay::stop()
+{
+    mTimer.stop();
+}
+
+quint64 RawStreamReplay::replayAll()
+{
+    stop();
+
+    RecordHeader recordHeader;
+    const char *recordData;
+    quint64 chunks = 0;
+    mReplayStartSteady_ns = utcTime::steadyNow_ns();
+    for (bool first = true; peek(recordHeader, recordData); first = false) {
+        if (first)
+            mReplayStartTimestamp_ns = recordHeader.timestamp_ns;
+        replayNext(mReplayStartSteady_ns + (recordHeader.timestamp_ns - mReplayStartTimestamp_ns));
+        chunks++;
+    }
+
+    emit finished();
+    return chunks;
+}
+
+bool RawStreamReplay::peek(RecordHeader &recordHeader, const char *&recordData)
+{
+    while (mPosition.segment < int(mSegments.size())) {
+        const Segment &segment = mSegments.at(mPosition.segment);
+        if (mPosition.offset + sizeof(RecordHeader) <= segment.usedBytes) {
+            memcpy(&recordHeader, segment.data + mPosition.offset, sizeof(recordHeader));
+            if (recordSize(recordHeader.size) <= segment.usedBytes - mPosition.offset) {
+                recordData = reinterpret_cast<const char*>(segment.data + mPosition.offset + sizeof(RecordHeader));
+                return true;
+            }
+        }
+
+        mPosition.segment++;
+        mPosition.offset = 0;
+    }
+    return false;
+}
+
+void RawStreamReplay::replayNext(qint64 rxSteady_ns)
+{
+    RecordHeader recordHeader;
+    const char *recordData;
+    if (!peek(recordHeader, recordData))
+        return;
+    mPosition.offset += recordSize(recordHeader.size);
+
+    const QByteArray data = QByteArray::fromRawData(recordData, int(recordHeader.size));
+    if (mUblox && recordHeader.stream == mUbloxStreamId)
+        mUblox->decodeData(data, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(rxSteady_ns)));
+    emit rawData(recordHeader.stream, data, rxSteady_ns);
+}
+
+void RawStreamReplay::replayDue()
+{
+    RecordHeader recordHeader;
+    const char *recordData;
+    const qint64 now_ns = utcTime::steadyNow_ns();
+    while (peek(recordHeader, recordData)) {
+        const qint64 due_ns = mReplayStartSteady_ns + qint64((recordHeader.timestamp_ns - mReplayStartTimestamp_ns) / mSpeed);
+        if (due_ns > now_ns) {
+            mTimer.start(int((due_ns - now_ns) / utcTime::NS_PER_MS));
+            return;
+        }
+        replayNext(due_ns);
+    }
+
+    emit finished();
+}
@@ -0,0 +1,94 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Replays recordings of RawStreamRecorder: the chunks of a stream are fed to Ublox::decodeData (i.e., to its decoders,
+ * subscriptions and signals as if received) and all chunks are signalled with rawData, e.g., for RTCM corrections.
+ * Segments are memory-mapped read-only and read up to their commit, i.e., also recordings of a crashed process.
+ * start() replays on the event loop at the recorded pace times speed, reception times are then those of the replay.
+ * replayAll() replays as fast as possible on the calling thread, with the recorded reception times (shifted to now).
+ * seek() uses the segment index.
+ */
+
+#ifndef RAWSTREAMREPLAY_H
+#define RAWSTREAMREPLAY_H
+
+#include <QFile>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
+#include <memory>
+#include <vector>
+#include "logger/rawstreamformat.h"
+#include "sensors/gnss/ublox.h"
+
+class RawStreamReplay : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RawStreamReplay(QObject *parent = nullptr);
+    ~RawStreamReplay();
+
+    // All segments of a recording (the basename given to RawStreamRecorder::start), or a single segment file
+    bool open(const QString &basenameOrFilename);
+    void close();
+    QString getErrorString() const { return mErrorString; }
+
+    QStringList getStreamNames() const { return mStreamNames; }
+    int findStream(const QString &name) const { return mStreamNames.indexOf(name); }
+    qint64 getStartTime_ns() const { return mStartTime_ns; } // UTC
+    qint64 getDuration_ns() const;
+    quint64 getRecordCount() const { return mRecordCount; }
+
+    void setUblox(Ublox *ublox, int streamId); // stream decoded by ublox
+    void setSpeed(double speed); // for start(), e.g., 1: real time, 10: ten times faster
+    bool seek(qint64 offsetFromStart_ns); // to the index entry at or before it
+
+    void start();
+    void stop();
+    bool isRunning() const { return mTimer.isActive(); }
+    quint64 replayAll(); // returns the number of replayed chunks
+
+signals:
+    // data refers to the mapped recording (no copy), i.e., it is valid until close()
+    void rawData(int streamId, const QByteArray &data, qint64 rxSteady_ns);
+    void finished();
+
+private:
+    struct Segment {
+        std::unique_ptr<QFile> file;
+        const uchar *map = nullptr;
+        const rawStreamFormat::IndexEntry *index = nullptr;
+        quint32 indexCount = 0;
+        const uchar *data = nullptr;
+        quint64 usedBytes = 0;
+    };
+    struct Position {
+        int segment = 0;
+        quint64 offset = 0;
+    };
+
+    bool openSegment(const QString &filename);
+    bool peek(rawStreamFormat::RecordHeader &recordHeader, const char *&recordData);
+    void replayNext(qint64 rxSteady_ns);
+    void replayDue();
+
+    std::vector<Segment> mSegments;
+    QString mErrorString;
+    QStringList mStreamNames;
+    qint64 mStartTime_ns = -1;
+    qint64 mFirstTimestamp_ns = -1;
+    qint64 mLastTimestamp_ns = -1;
+    quint64 mRecordCount = 0;
+
+    QPointer<Ublox> mUblox;
+    int mUbloxStreamId = -1;
+    double mSpeed = 1.0;
+    Position mPosition;
+    QTimer mTimer;
+    qint64 mReplayStartSteady_ns = 0; // start() or replayAll()
+    qint64 mReplayStartTimestamp_ns = 0; // recorded time at the start
+};
+
+#endif // RAWSTREAMREPLAY_H
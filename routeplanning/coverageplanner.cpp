@@ -0,0 +1,290 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "coverageplanner.h"
+#include "zigzagroutegenerator.h"
+#include <QPointF>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Sweep frame: u along the passes, v across them
+struct Frame {
+    double cosA;
+    double sinA;
+
+    QPointF toUV(const PosPoint &point) const
+    {
+        return QPointF(point.getX() * cosA + point.getY() * sinA, -point.getX() * sinA + point.getY() * cosA);
+    }
+
+    PosPoint toXY(double u, double v) const
+    {
+        return PosPoint(u * cosA - v * sinA, u * sinA + v * cosA);
+    }
+};
+
+struct Edge {
+    double vMin;
+    double vMax; // half-open [vMin, vMax) so that shared vertices are crossed once
+    double uAtVMin;
+    double dudv;
+};
+
+struct Interval {
+    double u0;
+    double u1;
+};
+
+struct OpenCell {
+    CoveragePlanner::Cell cell;
+    Interval interval;
+};
+
+void appendEdges(QVector<Edge> &edges, const QList<PosPoint> &ring, const Frame &frame)
+{
+    if (ring.size() < 3)
+        return;
+
+    QVector<QPointF> points;
+    points.reserve(ring.size() + 1);
+    for (const auto &point : ring)
+        points.append(frame.toUV(point));
+    if (points.first() != points.last())
+        points.append(points.first());
+
+    for (int i = 1; i < points.size(); i++) {
+        QPointF lower = points.at(i - 1);
+        QPointF upper = points.at(i);
+        if (lower.y() == upper.y())
+            continue;
+        if (lower.y() > upper.y())
+            std::swap(lower, upper);
+        edges.append({lower.y(), upper.y(), lower.x(), (upper.x() - lower.x()) / (upper.y() - lower.y())});
+    }
+}
+
+void closeCell(QList<CoveragePlanner::Cell> &cells, CoveragePlanner::Cell cell)
+{
+    for (const auto &pass : cell.passes)
+        cell.polygon.append(pass.first);
+    for (int i = cell.passes.size() - 1; i >= 0; i--)
+        cell.polygon.append(cell.passes.at(i).second);
+    cell.polygon.append(cell.polygon.first());
+    cells.append(cell);
+}
+
+double cross(const QPointF &o, const QPointF &a, const QPointF &b)
+{
+    return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+// Monotone chain, counter-clockwise without repeating the first point
+QVector<QPointF> getConvexHull(QVector<QPointF> points)
+{
+    std::sort(points.begin(), points.end(), [](const QPointF &a, const QPointF &b) {
+        return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+    });
+    if (points.size() < 3)
+        return points;
+
+    QVector<QPointF> hull(2 * points.size());
+    int k = 0;
+    for (int i = 0; i < points.size(); i++) {
+        while (k >= 2 && cross(hull.at(k - 2), hull.at(k - 1), points.at(i)) <= 0)
+            k--;
+        hull[k++] = points.at(i);
+    }
+    for (int i = points.size() - 2, lower = k + 1; i >= 0; i--) {
+        while (k >= lower && cross(hull.at(k - 2), hull.at(k - 1), points.at(i)) <= 0)
+            k--;
+        hull[k++] = points.at(i);
+    }
+    hull.resize(k - 1);
+    return hull;
+}
+}
+
+CoveragePlanner::CoveragePlanner()
+{
+
+}
+
+double CoveragePlanner::getSweepAngle(const QList<PosPoint> &bounds)
+{
+    QVector<QPointF> points;
+    points.reserve(bounds.size());
+    for (const auto &point : bounds)
+        points.append(QPointF(point.getX(), point.getY()));
+    const QVector<QPointF> hull = getConvexHull(points);
+    if (hull.size() < 2)
+        return 0.0;
+
+    // Width across each hull edge is the distance to the farthest hull vertex, the antipodal vertex only moves forward
+    double minWidth = std::numeric_limits<double>::infinity();
+    double angle = 0.0;
+    for (int i = 0, farthest = 1; i < hull.size(); i++) {
+        const QPointF &a = hull.at(i);
+        const QPointF &b = hull.at((i + 1) % hull.size());
+        const double length = hypot(b.x() - a.x(), b.y() - a.y());
+        if (length <= 0.0)
+            continue;
+
+        while (cross(a, b, hull.at((farthest + 1) % hull.size())) > cross(a, b, hull.at(farthest)))
+            farthest = (farthest + 1) % hull.size();
+        const double width = cross(a, b, hull.at(farthest)) / length;
+        if (width < minWidth) {
+            minWidth = width;
+            angle = atan2(b.y() - a.y(), b.x() - a.x());
+        }
+    }
+
+    return angle;
+}
+
+QList<CoveragePlanner::Cell> CoveragePlanner::decompose(const QList<PosPoint> &bounds, const QList<QList<PosPoint>> &holes, double angle, double spacing)
+{
+    QList<Cell> cells;
+    if (!(spacing > 0.0))
+        return cells;
+
+    const Frame frame = {cos(angle), sin(angle)};
+    QVector<Edge> edges;
+    appendEdges(edges, bounds, frame);
+    for (const auto &hole : holes)
+        appendEdges(edges, hole, frame);
+    if (edges.isEmpty())
+        return cells;
+
+    std::sort(edges.begin(), edges.end(), [](const Edge &first, const Edge &second) {
+        return first.vMin < second.vMin;
+    });
+    double vEnd = -std::numeric_limits<double>::infinity();
+    for (const auto &edge : edges)
+        vEnd = std::max(vEnd, edge.vMax);
+
+    QVector<Edge> active;
+    QVector<double> crossings;
+    QVector<Interval> intervals;
+    QList<OpenCell> open;
+    int nextEdge = 0;
+    for (int pass = 0;; pass++) {
+        const double v = edges.first().vMin + (pass + 0.5) * spacing;
+        if (!(v < vEnd))
+            break;
+
+        while (nextEdge < edges.size() && edges.at(nextEdge).vMin <= v)
+            active.append(edges.at(nextEdge++));
+
+        crossings.clear();
+        int kept = 0;
+        for (int i = 0; i < active.size(); i++) {
+            if (active.at(i).vMax <= v)
+                continue;
+            active[kept++] = active.at(i);
+            crossings.append(active.at(i).uAtVMin + (v - active.at(i).vMin) * active.at(i).dudv);
+        }
+        active.resize(kept);
+        std::sort(crossings.begin(), crossings.end());
+
+        intervals.clear();
+        for (int i = 1; i < crossings.size(); i += 2)
+            if (crossings.at(i) > crossings.at(i - 1))
+                intervals.append({crossings.at(i - 1), crossings.at(i)});
+
+        // A cell continues when its last pass and the new one overlap only each other
+        QVector<int> cellOverlaps(open.size(), 0), intervalOverlaps(intervals.size(), 0), intervalCell(intervals.size(), -1);
+        for (int c = 0; c < open.size(); c++) {
+            for (int i = 0; i < intervals.size(); i++) {
+                if (open.at(c).interval.u0 <= intervals.at(i).u1 && intervals.at(i).u0 <= open.at(c).interval.u1) {
+                    cellOverlaps[c]++;
+                    intervalOverlaps[i]++;
+                    intervalCell[i] = c;
+                }
+            }
+        }
+
+        QList<OpenCell> nextOpen;
+        QVector<bool> continued(open.size(), false);
+        for (int i = 0; i < intervals.size(); i++) {
+            const QPair<PosPoint, PosPoint> passPoints(frame.toXY(intervals.at(i).u0, v), frame.toXY(intervals.at(i).u1, v));
+            const int c = intervalCell.at(i);
+            if (intervalOverlaps.at(i) == 1 && cellOverlaps.at(c) == 1) {
+                continued[c] = true;
+                nextOpen.append(open.at(c));
+                nextOpen.last().cell.passes.append(passPoints);
+                nextOpen.last().interval = intervals.at(i);
+            } else {
+                nextOpen.append({Cell(), intervals.at(i)});
+                nextOpen.last().cell.passes.append(passPoints);
+            }
+        }
+
+        for (int c = 0; c < open.size(); c++)
+            if (!continued.at(c))
+                closeCell(cells, open.at(c).cell);
+        open = nextOpen;
+    }
+
+    for (const auto &openCell : open)
+        closeCell(cells, openCell.cell);
+
+    return cells;
+}
+
+QList<PosPoint> CoveragePlanner::fillPolygonWithZigZag(const QList<PosPoint> &bounds, const QList<QList<PosPoint>> &holes, double spacing, bool keepTurnsInBounds, double speed, double speedInTurns,
+                                                       int turnIntermediateSteps, int visitEveryX, uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns,
+                                                       double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn)
+{
+    const double angle = getSweepAngle(bounds);
+    QList<Cell> remaining = decompose(bounds, holes, angle, spacing);
+
+    QList<PosPoint> route;
+    while (!remaining.isEmpty()) {
+        // Start with the first pass of the first cell, afterwards at the cell corner closest to where the previous cell ended
+        int bestCell = 0;
+        bool bestBackwards = false, bestReversed = false;
+        if (!route.isEmpty()) {
+            double bestDistance = std::numeric_limits<double>::infinity();
+            for (int c = 0; c < remaining.size(); c++) {
+                for (bool backwards : {false, true}) {
+                    const auto &firstPass = backwards ? remaining.at(c).passes.last() : remaining.at(c).passes.first();
+                    for (bool reversed : {false, true}) {
+                        const double distance = route.last().getDistanceTo(reversed ? firstPass.second : firstPass.first);
+                        if (distance < bestDistance) {
+                            bestDistance = distance;
+                            bestCell = c;
+                            bestBackwards = backwards;
+                            bestReversed = reversed;
+                        }
+                    }
+                }
+            }
+        }
+
+        const Cell cell = remaining.takeAt(bestCell);
+        QList<PosPoint> passes;
+        for (int i = 0; i < cell.passes.size(); i++) {
+            const auto &pass = cell.passes.at(bestBackwards ? cell.passes.size() - 1 - i : i);
+            if ((i % 2 == 1) != bestReversed) {
+                passes.append(pass.second);
+                passes.append(pass.first);
+            } else {
+                passes.append(pass.first);
+                passes.append(pass.second);
+            }
+        }
+
+        // Pass 0 heads along cellAngle, the following ones are shifted towards polygonDirectionSign * normal of cellAngle
+        const double cellAngle = bestReversed ? angle + M_PI : angle;
+        const int polygonDirectionSign = (bestBackwards ? -1 : 1) * (bestReversed ? -1 : 1);
+        route.append(ZigZagRouteGenerator::addTurnsToPasses(passes, cell.polygon, cellAngle, polygonDirectionSign, spacing, keepTurnsInBounds,
+                                                            speed, speedInTurns, turnIntermediateSteps, visitEveryX,
+                                                            setAttributesOnStraights, setAttributesInTurns, attributeDistanceAfterTurn, attributeDistanceBeforeTurn));
+    }
+
+    return route;
+}
@@ -0,0 +1,39 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Zig-zag coverage of non-convex fields with holes (obstacles). The field is decomposed into boustrophedon cells:
+ * pass lines are intersected with all bounds (scanline with an active edge table, even-odd rule), consecutive passes
+ * stay in one cell as long as their intervals overlap one to one, cells split and merge where obstacles or bays begin and end.
+ * Cells are visited greedily by shortest transit from the end of the previous cell (choosing one of the four corners to start),
+ * each cell is driven with the turns and attributes of ZigZagRouteGenerator.
+ */
+
+#ifndef COVERAGEPLANNER_H
+#define COVERAGEPLANNER_H
+
+#include <QList>
+#include <QPair>
+#include "core/pospoint.h"
+
+class CoveragePlanner
+{
+public:
+    struct Cell {
+        QList<QPair<PosPoint, PosPoint>> passes; // ordered along the sweep, each pointing along the sweep angle
+        QList<PosPoint> polygon; // closed, start points of the passes followed by the end points in reverse
+    };
+
+    // Direction of passes [rad], along the edge of the convex hull that gives the minimum width of bounds (fewest turns)
+    static double getSweepAngle(const QList<PosPoint> &bounds);
+    // Passes are spacing apart, the first one spacing/2 from the lowest point of bounds across the sweep angle
+    static QList<Cell> decompose(const QList<PosPoint> &bounds, const QList<QList<PosPoint>> &holes, double angle, double spacing);
+    static QList<PosPoint> fillPolygonWithZigZag(const QList<PosPoint> &bounds, const QList<QList<PosPoint>> &holes, double spacing, bool keepTurnsInBounds, double speed, double speedInTurns,
+                                                 int turnIntermediateSteps, int visitEveryX, uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns,
+                                                 double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn);
+
+protected:
+    CoveragePlanner();
+};
+
+#endif // COVERAGEPLANNER_H
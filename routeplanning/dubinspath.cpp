@@ -0,0 +1,153 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "dubinspath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+double mod2pi(double angle)
+{
+    return angle - 2.0 * M_PI * floor(angle / (2.0 * M_PI));
+}
+
+constexpr DubinsPath::SegmentType SEGMENT_TYPES[6][3] = {
+    {DubinsPath::SegmentType::Left, DubinsPath::SegmentType::Straight, DubinsPath::SegmentType::Left}, // LSL
+    {DubinsPath::SegmentType::Left, DubinsPath::SegmentType::Straight, DubinsPath::SegmentType::Right}, // LSR
+    {DubinsPath::SegmentType::Right, DubinsPath::SegmentType::Straight, DubinsPath::SegmentType::Left}, // RSL
+    {DubinsPath::SegmentType::Right, DubinsPath::SegmentType::Straight, DubinsPath::SegmentType::Right}, // RSR
+    {DubinsPath::SegmentType::Right, DubinsPath::SegmentType::Left, DubinsPath::SegmentType::Right}, // RLR
+    {DubinsPath::SegmentType::Left, DubinsPath::SegmentType::Right, DubinsPath::SegmentType::Left}, // LRL
+};
+
+// Segment lengths of a word in the normalized frame (start at the origin, end at (d, 0)), false if the word has no solution.
+// See Shkel and Lumelsky, "Classification of the Dubins set", 2001.
+bool getSegmentLengths(DubinsPath::Type type, double alpha, double beta, double d, std::array<double, 3> &lengths)
+{
+    const double sa = sin(alpha), sb = sin(beta), ca = cos(alpha), cb = cos(beta);
+    const double cab = cos(alpha - beta);
+
+    switch (type) {
+    case DubinsPath::Type::LSL: {
+        const double pSquared = 2.0 + d * d - 2.0 * cab + 2.0 * d * (sa - sb);
+        if (pSquared < 0.0)
+            return false;
+        const double theta = atan2(cb - ca, d + sa - sb);
+        lengths = {mod2pi(theta - alpha), sqrt(pSquared), mod2pi(beta - theta)};
+        return true;
+    }
+    case DubinsPath::Type::RSR: {
+        const double pSquared = 2.0 + d * d - 2.0 * cab + 2.0 * d * (sb - sa);
+        if (pSquared < 0.0)
+            return false;
+        const double theta = atan2(ca - cb, d - sa + sb);
+        lengths = {mod2pi(alpha - theta), sqrt(pSquared), mod2pi(theta - beta)};
+        return true;
+    }
+    case DubinsPath::Type::LSR: {
+        const double pSquared = -2.0 + d * d + 2.0 * cab + 2.0 * d * (sa + sb);
+        if (pSquared < 0.0)
+            return false;
+        const double p = sqrt(pSquared);
+        const double theta = atan2(-ca - cb, d + sa + sb) - atan2(-2.0, p);
+        lengths = {mod2pi(theta - alpha), p, mod2pi(theta - mod2pi(beta))};
+        return true;
+    }
+    case DubinsPath::Type::RSL: {
+        const double pSquared = -2.0 + d * d + 2.0 * cab - 2.0 * d * (sa + sb);
+        if (pSquared < 0.0)
+            return false;
+        const double p = sqrt(pSquared);
+        const double theta = atan2(ca + cb, d - sa - sb) - atan2(2.0, p);
+        lengths = {mod2pi(alpha - theta), p, mod2pi(beta - theta)};
+        return true;
+    }
+    case DubinsPath::Type::RLR: {
+        const double cosP = (6.0 - d * d + 2.0 * cab + 2.0 * d * (sa - sb)) / 8.0;
+        if (fabs(cosP) > 1.0)
+            return false;
+        const double p = mod2pi(2.0 * M_PI - acos(cosP));
+        const double t = mod2pi(alpha - atan2(ca - cb, d - sa + sb) + p / 2.0);
+        lengths = {t, p, mod2pi(alpha - beta - t + p)};
+        return true;
+    }
+    case DubinsPath::Type::LRL: {
+        const double cosP = (6.0 - d * d + 2.0 * cab + 2.0 * d * (sb - sa)) / 8.0;
+        if (fabs(cosP) > 1.0)
+            return false;
+        const double p = mod2pi(2.0 * M_PI - acos(cosP));
+        const double t = mod2pi(-alpha - atan2(ca - cb, d + sa - sb) + p / 2.0);
+        lengths = {t, p, mod2pi(mod2pi(beta) - alpha - t + p)};
+        return true;
+    }
+    }
+    return false;
+}
+}
+
+DubinsPath DubinsPath::getShortest(const QPointF &start, double startYaw_rad, const QPointF &end, double endYaw_rad, double turnRadius_m)
+{
+    DubinsPath path;
+    if (!(turnRadius_m > 0.0))
+        return path;
+
+    const QPointF delta = end - start;
+    const double d = sqrt(QPointF::dotProduct(delta, delta)) / turnRadius_m;
+    const double theta = (d > 0.0) ? atan2(delta.y(), delta.x()) : 0.0;
+    const double alpha = mod2pi(startYaw_rad - theta);
+    const double beta = mod2pi(endYaw_rad - theta);
+
+    double bestLength = std::numeric_limits<double>::infinity();
+    for (const Type type : {Type::LSL, Type::LSR, Type::RSL, Type::RSR, Type::RLR, Type::LRL}) {
+        std::array<double, 3> lengths;
+        if (getSegmentLengths(type, alpha, beta, d, lengths) && lengths[0] + lengths[1] + lengths[2] < bestLength) {
+            bestLength = lengths[0] + lengths[1] + lengths[2];
+            path.mType = type;
+            path.mSegmentLengths = lengths;
+            path.mValid = true;
+        }
+    }
+
+    path.mStart = start;
+    path.mStartYaw_rad = startYaw_rad;
+    path.mTurnRadius_m = turnRadius_m;
+    return path;
+}
+
+DubinsPath::SegmentType DubinsPath::getSegmentType(int segment) const
+{
+    return SEGMENT_TYPES[static_cast<int>(mType)][segment];
+}
+
+void DubinsPath::getPose(double distance_m, QPointF &position, double &yaw_rad) const
+{
+    // Unit turn radius, scaled at the end
+    double remaining = std::max(distance_m, 0.0) / mTurnRadius_m;
+    double x = 0.0, y = 0.0;
+    double yaw = mStartYaw_rad;
+    for (int segment = 0; segment < 3 && remaining > 0.0; segment++) {
+        const double length = std::min(remaining, mSegmentLengths[segment]);
+        switch (getSegmentType(segment)) {
+        case SegmentType::Left:
+            x += sin(yaw + length) - sin(yaw);
+            y += cos(yaw) - cos(yaw + length);
+            yaw += length;
+            break;
+        case SegmentType::Right:
+            x += sin(yaw) - sin(yaw - length);
+            y += cos(yaw - length) - cos(yaw);
+            yaw -= length;
+            break;
+        case SegmentType::Straight:
+            x += length * cos(yaw);
+            y += length * sin(yaw);
+            break;
+        }
+        remaining -= length;
+    }
+
+    position = mStart + QPointF(x, y) * mTurnRadius_m;
+    yaw_rad = yaw;
+}
@@ -0,0 +1,44 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Shortest forward path between two poses for a vehicle with a minimum turn radius (Dubins): three segments,
+ * each a left turn, right turn or straight at the turn radius, of the words LSL, LSR, RSL, RSR, RLR and LRL.
+ * Closed-form (no search), e.g., for analytic expansions and heuristics of planners. Yaw in rad (ENU).
+ */
+
+#ifndef DUBINSPATH_H
+#define DUBINSPATH_H
+
+#include <QPointF>
+#include <array>
+
+class DubinsPath
+{
+public:
+    enum class Type {LSL, LSR, RSL, RSR, RLR, LRL};
+    enum class SegmentType {Left, Straight, Right};
+
+    DubinsPath() = default;
+    // Invalid for turnRadius_m <= 0
+    static DubinsPath getShortest(const QPointF &start, double startYaw_rad, const QPointF &end, double endYaw_rad, double turnRadius_m);
+
+    bool isValid() const { return mValid; }
+    Type getType() const { return mType; }
+    double getLength() const { return (mSegmentLengths[0] + mSegmentLengths[1] + mSegmentLengths[2]) * mTurnRadius_m; }
+    int getSegmentCount() const { return 3; }
+    double getSegmentLength(int segment) const { return mSegmentLengths.at(segment) * mTurnRadius_m; } // [m]
+    SegmentType getSegmentType(int segment) const;
+    // Pose at distance [0:getLength()] along the path
+    void getPose(double distance_m, QPointF &position, double &yaw_rad) const;
+
+private:
+    bool mValid = false;
+    Type mType = Type::LSL;
+    QPointF mStart;
+    double mStartYaw_rad = 0.0;
+    double mTurnRadius_m = 1.0;
+    std::array<double, 3> mSegmentLengths {}; // normalized by the turn radius, i.e., [rad] for turns
+};
+
+#endif // DUBINSPATH_H
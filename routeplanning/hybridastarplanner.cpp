@@ -0,0 +1,454 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "hybridastarplanner.h"
+#include "routeplanning/dubinspath.h"
+#include "vehicles/carstate.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <vector>
+
+namespace {
+struct Pose {
+    double x;
+    double y;
+    double yaw_rad;
+};
+
+struct Arc {
+    double curvature; // [1/m], positive: turning left
+    double distance_m; // negative: reversing
+};
+
+struct Node {
+    Pose pose;
+    double cost;
+    int parent; // -1: start
+    int arc; // from the parent
+    bool closed;
+};
+
+struct OpenEntry {
+    double priority; // cost + weighted heuristic
+    double cost; // of the node when pushed, outdated entries are skipped
+    int node;
+
+    bool operator<(const OpenEntry &other) const { return priority > other.priority; } // std::push_heap: lowest priority on top
+};
+
+struct VisitedSlot {
+    quint64 key;
+    int node;
+    quint32 generation; // empty if not the current one
+};
+
+double normalizeAngle(double angle_rad) // [-pi, pi)
+{
+    return angle_rad - 2.0 * M_PI * floor((angle_rad + M_PI) / (2.0 * M_PI));
+}
+
+Pose drive(const Pose &pose, const Arc &arc, double distance_m)
+{
+    if (fabs(arc.curvature) < 1e-9)
+        return {pose.x + distance_m * cos(pose.yaw_rad), pose.y + distance_m * sin(pose.yaw_rad), pose.yaw_rad};
+
+    const double yaw_rad = pose.yaw_rad + arc.curvature * distance_m;
+    return {pose.x + (sin(yaw_rad) - sin(pose.yaw_rad)) / arc.curvature,
+            pose.y - (cos(yaw_rad) - cos(pose.yaw_rad)) / arc.curvature, yaw_rad};
+}
+
+class Search
+{
+public:
+    using Parameters = HybridAStarPlanner::Parameters;
+    using Problem = HybridAStarPlanner::Problem;
+    using Result = HybridAStarPlanner::Result;
+
+    Search(const Problem &problem, const Parameters &parameters, const std::function<bool()> &shouldStop)
+        : mProblem(problem), mParameters(parameters), mShouldStop(shouldStop)
+    {
+        const double maxCurvature = 1.0 / std::max(parameters.minTurnRadius_m, 0.01);
+        mHeadingCellSize_rad = 2.0 * M_PI / std::max(parameters.headingCells, 1);
+        const double stepLength_m = (parameters.stepLength_m > 0.0) ? parameters.stepLength_m
+                                                                    : std::max(M_SQRT2 * parameters.cellSize_m, 1.1 * mHeadingCellSize_rad / maxCurvature);
+        for (const double direction : {1.0, -1.0}) {
+            if (direction < 0.0 && !parameters.allowReverse)
+                break;
+            for (int steering = -parameters.steeringSteps; steering <= parameters.steeringSteps; steering++)
+                mArcs.push_back({maxCurvature * steering / std::max(parameters.steeringSteps, 1), direction * stepLength_m});
+        }
+        mMaxCurvature = maxCurvature;
+
+        // Footprint samples (interior included) at most one grid cell apart
+        const QRectF footprint = parameters.footprint.adjusted(-parameters.clearance_m, -parameters.clearance_m, parameters.clearance_m, parameters.clearance_m);
+        mFootprint = footprint;
+        const double sampleSpacing_m = problem.occupancyGrid ? problem.occupancyGrid->getCellSize() : parameters.cellSize_m;
+        const int samplesX = int(ceil(footprint.width() / sampleSpacing_m)) + 1;
+        const int samplesY = int(ceil(footprint.height() / sampleSpacing_m)) + 1;
+        for (int i = 0; i < samplesX; i++)
+            for (int j = 0; j < samplesY; j++)
+                mFootprintSamples.append(QPointF(footprint.left() + footprint.width() * i / std::max(samplesX - 1, 1),
+                                                 footprint.top() + footprint.height() * j / std::max(samplesY - 1, 1)));
+        mPlacedFootprintSamples.resize(mFootprintSamples.size());
+
+        // Pool and tables, reused by all searches of this plan
+        mNodes.resize(std::max(parameters.maxNodes, 1));
+        mOpen.reserve(mNodes.size());
+        size_t visitedSlots = 1;
+        while (visitedSlots < 2 * mNodes.size())
+            visitedSlots <<= 1;
+        mVisited.assign(visitedSlots, VisitedSlot{0, -1, 0});
+    }
+
+    bool isPoseFree(const Pose &pose)
+    {
+        const double c = cos(pose.yaw_rad), s = sin(pose.yaw_rad);
+        if (mProblem.geofence && !mProblem.geofence->isEmpty() &&
+                mProblem.geofence->getViolatedZone(Geofence::placeFootprint(mFootprint, QPointF(pose.x, pose.y), pose.yaw_rad)) >= 0)
+            return false;
+
+        if (mProblem.occupancyGrid) {
+            for (int i = 0; i < mFootprintSamples.size(); i++) {
+                const QPointF &sample = mFootprintSamples.at(i);
+                mPlacedFootprintSamples[i] = QPointF(pose.x + c * sample.x() - s * sample.y(), pose.y + s * sample.x() + c * sample.y());
+            }
+            if (mProblem.occupancyGrid->isAnyOccupied(mPlacedFootprintSamples))
+                return false;
+        }
+        return true;
+    }
+
+    bool isGoalFree()
+    {
+        if (!std::isnan(mProblem.goalYaw_rad))
+            return isPoseFree({mProblem.goal.x(), mProblem.goal.y(), mProblem.goalYaw_rad});
+        return (!mProblem.geofence || mProblem.geofence->isPointAllowed(mProblem.goal)) &&
+                (!mProblem.occupancyGrid || !mProblem.occupancyGrid->isOccupied(mProblem.goal));
+    }
+
+    bool isArcFree(const Pose &from, const Arc &arc)
+    {
+        const int steps = std::max(int(ceil(fabs(arc.distance_m) / mParameters.collisionCheckStep_m)), 1);
+        for (int step = 1; step <= steps; step++)
+            if (!isPoseFree(drive(from, arc, arc.distance_m * step / steps)))
+                return false;
+        return true;
+    }
+
+    Result run(double heuristicWeight)
+    {
+        Result result;
+        result.heuristicWeight = heuristicWeight;
+        mGeneration++;
+        mNodeCount = 0;
+        mOpen.clear();
+
+        const Pose start {mProblem.start.getX(), mProblem.start.getY(), mProblem.start.getYaw() * M_PI / 180.0};
+        const int startNode = addNode(start, 0.0, -1, -1, getKey(start));
+        pushOpen(startNode, heuristicWeight);
+
+        int goalNode = -1;
+        DubinsPath analyticPath;
+        while (!mOpen.empty()) {
+            if ((result.expandedNodes & 63) == 0 && mShouldStop())
+                break;
+
+            std::pop_heap(mOpen.begin(), mOpen.end());
+            const OpenEntry entry = mOpen.back();
+            mOpen.pop_back();
+            Node &node = mNodes[entry.node];
+            if (node.closed || entry.cost > node.cost)
+                continue;
+            node.closed = true;
+            result.expandedNodes++;
+
+            if (isGoal(node.pose)) {
+                goalNode = entry.node;
+                break;
+            }
+            if (result.expandedNodes % std::max(mParameters.analyticExpansionInterval, 1) == 0 && tryAnalyticExpansion(node.pose, analyticPath)) {
+                goalNode = entry.node;
+                break;
+            }
+
+            const Node parent = node; // mNodes is not reallocated, but node may be updated below
+            for (int arcIndex = 0; arcIndex < int(mArcs.size()); arcIndex++) {
+                const Arc &arc = mArcs.at(arcIndex);
+                const Pose pose = drive(parent.pose, arc, arc.distance_m);
+                const quint64 key = getKey(pose);
+                VisitedSlot &slot = findSlot(key);
+                const bool isVisited = slot.generation == mGeneration;
+                if (isVisited && mNodes.at(slot.node).closed)
+                    continue;
+
+                const double cost = parent.cost + getArcCost(parent, arc);
+                if (isVisited && cost >= mNodes.at(slot.node).cost)
+                    continue;
+                if (!isArcFree(parent.pose, arc))
+                    continue;
+
+                int child;
+                if (isVisited) {
+                    child = slot.node;
+                    mNodes[child] = Node{pose, cost, entry.node, arcIndex, false};
+                } else if (mNodeCount < int(mNodes.size())) {
+                    child = addNode(pose, cost, entry.node, arcIndex, key);
+                } else {
+                    result.poolExhausted = true;
+                    continue;
+                }
+                pushOpen(child, heuristicWeight);
+            }
+        }
+
+        if (goalNode >= 0) {
+            result.status = HybridAStarPlanner::Status::Found;
+            result.cost = mNodes.at(goalNode).cost;
+            if (analyticPath.isValid())
+                result.cost += analyticPath.getLength() + (isReversing(mNodes.at(goalNode)) ? mParameters.directionChangePenalty_m : 0.0);
+            result.route = getRoute(goalNode, analyticPath);
+        }
+        return result;
+    }
+
+private:
+    quint64 getKey(const Pose &pose) const
+    {
+        const quint64 cellX = quint64(qint64(floor(pose.x / mParameters.cellSize_m)) + (1 << 23)) & 0xFFFFFF;
+        const quint64 cellY = quint64(qint64(floor(pose.y / mParameters.cellSize_m)) + (1 << 23)) & 0xFFFFFF;
+        const int headingCells = std::max(mParameters.headingCells, 1);
+        const quint64 heading = quint64((int(floor((normalizeAngle(pose.yaw_rad) + M_PI) / mHeadingCellSize_rad + 0.5)) % headingCells + headingCells) % headingCells);
+        return (cellX << 40) | (cellY << 16) | heading;
+    }
+
+    VisitedSlot &findSlot(quint64 key)
+    {
+        const size_t mask = mVisited.size() - 1;
+        size_t index = size_t((key * 0x9E3779B97F4A7C15ull) >> 20) & mask;
+        while (mVisited[index].generation == mGeneration && mVisited[index].key != key)
+            index = (index + 1) & mask;
+        return mVisited[index];
+    }
+
+    int addNode(const Pose &pose, double cost, int parent, int arc, quint64 key)
+    {
+        const int node = mNodeCount++;
+        mNodes[node] = Node{pose, cost, parent, arc, false};
+        VisitedSlot &slot = findSlot(key);
+        slot = VisitedSlot{key, node, mGeneration};
+        return node;
+    }
+
+    void pushOpen(int node, double heuristicWeight)
+    {
+        mOpen.push_back({mNodes.at(node).cost + heuristicWeight * getHeuristic(mNodes.at(node).pose), mNodes.at(node).cost, node});
+        std::push_heap(mOpen.begin(), mOpen.end());
+    }
+
+    bool isReversing(const Node &node) const { return node.arc >= 0 && mArcs.at(node.arc).distance_m < 0.0; }
+
+    double getArcCost(const Node &parent, const Arc &arc) const
+    {
+        const double length_m = fabs(arc.distance_m);
+        double cost = length_m * (arc.distance_m < 0.0 ? mParameters.reversePenalty : 1.0);
+        cost += mParameters.steeringPenalty * length_m * fabs(arc.curvature) / mMaxCurvature;
+        if (parent.arc >= 0) {
+            const Arc &parentArc = mArcs.at(parent.arc);
+            cost += mParameters.steeringChangePenalty * fabs(arc.curvature - parentArc.curvature) / mMaxCurvature;
+            if ((arc.distance_m < 0.0) != (parentArc.distance_m < 0.0))
+                cost += mParameters.directionChangePenalty_m;
+        }
+        return cost;
+    }
+
+    // Straight-line distance, Dubins length if only driving forward to a goal heading (both ignore obstacles)
+    double getHeuristic(const Pose &pose) const
+    {
+        const double distance_m = hypot(mProblem.goal.x() - pose.x, mProblem.goal.y() - pose.y);
+        if (mParameters.allowReverse || std::isnan(mProblem.goalYaw_rad))
+            return distance_m;
+        const DubinsPath path = DubinsPath::getShortest(QPointF(pose.x, pose.y), pose.yaw_rad, mProblem.goal, mProblem.goalYaw_rad, mParameters.minTurnRadius_m);
+        return path.isValid() ? std::max(distance_m, path.getLength()) : distance_m;
+    }
+
+    bool isGoal(const Pose &pose) const
+    {
+        return hypot(mProblem.goal.x() - pose.x, mProblem.goal.y() - pose.y) <= mParameters.goalTolerance_m &&
+                (std::isnan(mProblem.goalYaw_rad) || fabs(normalizeAngle(pose.yaw_rad - mProblem.goalYaw_rad)) <= mParameters.goalYawTolerance_rad);
+    }
+
+    // Without a goal heading, the path ends along the line from the pose to the goal
+    bool tryAnalyticExpansion(const Pose &pose, DubinsPath &path)
+    {
+        const double goalYaw_rad = std::isnan(mProblem.goalYaw_rad) ? atan2(mProblem.goal.y() - pose.y, mProblem.goal.x() - pose.x) : mProblem.goalYaw_rad;
+        path = DubinsPath::getShortest(QPointF(pose.x, pose.y), pose.yaw_rad, mProblem.goal, goalYaw_rad, mParameters.minTurnRadius_m);
+        if (!path.isValid())
+            return false;
+
+        const int steps = std::max(int(ceil(path.getLength() / mParameters.collisionCheckStep_m)), 1);
+        for (int step = 1; step <= steps; step++) {
+            Pose checked;
+            QPointF position;
+            path.getPose(path.getLength() * step / steps, position, checked.yaw_rad);
+            checked.x = position.x();
+            checked.y = position.y();
+            if (!isPoseFree(checked)) {
+                path = DubinsPath();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void appendRoutePoint(QList<PosPoint> &route, const Pose &pose, bool reversing) const
+    {
+        PosPoint point;
+        point.setXY(pose.x, pose.y);
+        point.setYaw(normalizeAngle(pose.yaw_rad) * 180.0 / M_PI);
+        point.setSpeed(reversing ? -mParameters.reverseSpeed : mParameters.speed);
+        route.append(point);
+    }
+
+    QList<PosPoint> getRoute(int goalNode, const DubinsPath &analyticPath) const
+    {
+        QVector<int> nodes;
+        for (int node = goalNode; node >= 0; node = mNodes.at(node).parent)
+            nodes.prepend(node);
+
+        QList<PosPoint> route;
+        const bool firstReversing = nodes.size() > 1 ? isReversing(mNodes.at(nodes.at(1))) : false;
+        appendRoutePoint(route, mNodes.at(nodes.first()).pose, firstReversing);
+        for (int i = 1; i < nodes.size(); i++) {
+            const Node &node = mNodes.at(nodes.at(i));
+            const Arc &arc = mArcs.at(node.arc);
+            const int steps = std::max(int(ceil(fabs(arc.distance_m) / mParameters.routeSpacing_m)), 1);
+            for (int step = 1; step <= steps; step++)
+                appendRoutePoint(route, drive(mNodes.at(node.parent).pose, arc, arc.distance_m * step / steps), arc.distance_m < 0.0);
+        }
+
+        if (analyticPath.isValid()) {
+            const int steps = std::max(int(ceil(analyticPath.getLength() / mParameters.routeSpacing_m)), 1);
+            for (int step = 1; step <= steps; step++) {
+                Pose pose;
+                QPointF position;
+                analyticPath.getPose(analyticPath.getLength() * step / steps, position, pose.yaw_rad);
+                pose.x = position.x();
+                pose.y = position.y();
+                appendRoutePoint(route, pose, false);
+            }
+        }
+        return route;
+    }
+
+    const Problem &mProblem;
+    const Parameters &mParameters;
+    const std::function<bool()> &mShouldStop;
+    std::vector<Arc> mArcs;
+    double mMaxCurvature = 1.0;
+    double mHeadingCellSize_rad = 0.1;
+    QRectF mFootprint;
+    QVector<QPointF> mFootprintSamples;
+    QVector<QPointF> mPlacedFootprintSamples;
+
+    std::vector<Node> mNodes; // pool
+    int mNodeCount = 0;
+    std::vector<OpenEntry> mOpen; // binary heap
+    std::vector<VisitedSlot> mVisited;
+    quint32 mGeneration = 0;
+};
+}
+
+HybridAStarPlanner::HybridAStarPlanner(QObject *parent) : QObject(parent)
+{
+    mThreadContext = new QObject();
+    mThread.setObjectName("Hybrid A* planner");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start();
+}
+
+HybridAStarPlanner::~HybridAStarPlanner()
+{
+    mCancel = true;
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+}
+
+HybridAStarPlanner::Parameters HybridAStarPlanner::getParametersForVehicle(const CarState &carState, const QRectF &footprint, Parameters parameters)
+{
+    // As CarState::getMinTurnRadiusRear, for the route's speed instead of the current one
+    parameters.minTurnRadius_m = std::max(carState.getMinTurnRadiusRear(), pow(parameters.speed, 2) / (0.21 * 9.81));
+    parameters.footprint = footprint;
+    return parameters;
+}
+
+bool HybridAStarPlanner::start(const Problem &problem, const Parameters &parameters)
+{
+    if (mRunning)
+        return false;
+
+    mRunning = true;
+    mCancel = false;
+    QMetaObject::invokeMethod(mThreadContext, [this, problem, parameters]() {
+        const Result result = plan(problem, parameters, mCancel, [this](const Result &result) {
+            QMetaObject::invokeMethod(this, [this, result]() { emit improved(result); }, Qt::QueuedConnection);
+        });
+        QMetaObject::invokeMethod(this, [this, result]() {
+            mRunning = false;
+            emit finished(result);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+
+    return true;
+}
+
+void HybridAStarPlanner::cancel()
+{
+    mCancel = true;
+}
+
+HybridAStarPlanner::Result HybridAStarPlanner::plan(const Problem &problem, const Parameters &parameters, const std::atomic<bool> &cancel,
+                                                    const std::function<void (const Result &)> &improved)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const std::function<bool()> shouldStop = [&]() { return cancel || timer.elapsed() >= parameters.maxDuration_ms; };
+    Search search(problem, parameters, shouldStop);
+
+    Result best;
+    const Pose start {problem.start.getX(), problem.start.getY(), problem.start.getYaw() * M_PI / 180.0};
+    if (!search.isPoseFree(start)) {
+        best.status = Status::StartInCollision;
+        return best;
+    }
+    if (!search.isGoalFree()) {
+        best.status = Status::GoalInCollision;
+        return best;
+    }
+
+    // Lower weights expand more nodes for cheaper routes, a search that fails leaves nothing to improve
+    int expandedNodes = 0;
+    bool poolExhausted = false;
+    for (double weight = std::max(parameters.initialHeuristicWeight, 1.0); ; weight = std::max(weight - std::max(parameters.heuristicWeightStep, 0.1), 1.0)) {
+        const Result result = search.run(weight);
+        expandedNodes += result.expandedNodes;
+        poolExhausted |= result.poolExhausted;
+        if (!result.isFound())
+            break;
+
+        if (result.cost < best.cost) {
+            best = result;
+            best.expandedNodes = expandedNodes;
+            best.poolExhausted = poolExhausted;
+            if (improved)
+                improved(best);
+        }
+        if (weight <= 1.0 || shouldStop())
+            break;
+    }
+
+    best.expandedNodes = expandedNodes;
+    best.poolExhausted = poolExhausted;
+    return best;
+}
@@ -0,0 +1,114 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Local planner for car-like vehicles (Hybrid A*), e.g., for goto requests around obstacles: nodes are continuous poses,
+ * expanded by arcs of a few curvatures up to the minimum turn radius (forward and, optionally, reversing), and pruned by a
+ * grid of x, y and heading cells (one node per cell). The vehicle's footprint is checked along every arc against an
+ * OccupancyGrid and a Geofence. Every few expansions, a Dubins path to the goal is tried (analytic expansion).
+ * Anytime: restarting weighted A*, i.e., searches with decreasing heuristic weight until the weight is one or the time limit is
+ * reached, the best route so far is handed out. Nodes come from a pool allocated once per plan, the visited cells are an open
+ * addressing table that is cleared by a generation counter, i.e., searches do not allocate per node.
+ * Routes have the poses of the arcs (speed negative when reversing) for PurepursuitWaypointFollower.
+ * Planning runs on a worker thread, signals are emitted in the thread the planner lives in.
+ */
+
+#ifndef HYBRIDASTARPLANNER_H
+#define HYBRIDASTARPLANNER_H
+
+#include <QObject>
+#include <QThread>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QSharedPointer>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include "core/pospoint.h"
+#include "core/occupancygrid.h"
+#include "core/geofence.h"
+
+class CarState;
+
+class HybridAStarPlanner : public QObject
+{
+    Q_OBJECT
+public:
+    struct Parameters {
+        double minTurnRadius_m = 1.0;
+        QRectF footprint = QRectF(-0.15, -0.2, 0.8, 0.4); // vehicle frame (x forward, y left) [m], see MovementController::getFootprint
+        double clearance_m = 0.1; // added around the footprint
+        double speed = 1.0; // [m/s] of the route
+        bool allowReverse = true;
+        double reverseSpeed = 0.5; // [m/s]
+        double reversePenalty = 2.0; // cost per reversed meter
+        double directionChangePenalty_m = 2.0;
+        double steeringPenalty = 0.1; // cost per meter at full curvature
+        double steeringChangePenalty = 0.2; // cost per change from zero to full curvature
+        int steeringSteps = 2; // curvatures per side, i.e., 2 * steeringSteps + 1 arcs per direction
+        double cellSize_m = 0.25;
+        int headingCells = 72;
+        double stepLength_m = 0.0; // of arcs, 0: at least one heading cell at full curvature and a diagonal cell
+        double collisionCheckStep_m = 0.1;
+        double routeSpacing_m = 0.2; // between route points
+        double goalTolerance_m = 0.3;
+        double goalYawTolerance_rad = 0.2;
+        int analyticExpansionInterval = 8; // expansions between Dubins paths to the goal
+        double initialHeuristicWeight = 2.5;
+        double heuristicWeightStep = 0.5;
+        int maxNodes = 50000;
+        int maxDuration_ms = 200;
+    };
+
+    struct Problem {
+        PosPoint start; // vehicle pose, yaw in degrees (as PosPoint)
+        QPointF goal;
+        double goalYaw_rad = std::numeric_limits<double>::quiet_NaN(); // NaN: any heading at the goal
+        QSharedPointer<const OccupancyGrid> occupancyGrid; // nullptr: no obstacles
+        QSharedPointer<const Geofence> geofence; // nullptr: no zones
+    };
+
+    enum class Status {Found, NotFound, StartInCollision, GoalInCollision};
+
+    struct Result {
+        Status status = Status::NotFound;
+        QList<PosPoint> route;
+        double cost = std::numeric_limits<double>::infinity();
+        double heuristicWeight = 0.0; // of the search the route is from
+        int expandedNodes = 0; // of all searches
+        bool poolExhausted = false;
+
+        bool isFound() const { return status == Status::Found; }
+    };
+
+    explicit HybridAStarPlanner(QObject *parent = nullptr);
+    ~HybridAStarPlanner();
+
+    // parameters with the vehicle's turn radius (at parameters.speed) and footprint.
+    // TruckState: the trailer is not modeled, reversing should be disabled with a trailer.
+    static Parameters getParametersForVehicle(const CarState &carState, const QRectF &footprint, Parameters parameters);
+
+    // Only one plan at a time, returns false if one is already running
+    bool start(const Problem &problem, const Parameters &parameters);
+    // Stops as soon as possible, finished() follows with the best route so far
+    void cancel();
+    bool isRunning() const { return mRunning; }
+
+    // Synchronous planning, improved is called with every better route (in the calling thread)
+    static Result plan(const Problem &problem, const Parameters &parameters, const std::atomic<bool> &cancel,
+                       const std::function<void(const Result &result)> &improved = nullptr);
+
+signals:
+    void improved(const HybridAStarPlanner::Result &result);
+    void finished(const HybridAStarPlanner::Result &result);
+
+private:
+    QThread mThread;
+    QObject *mThreadContext;
+    bool mRunning = false; // owner thread only
+    std::atomic<bool> mCancel {false};
+};
+
+#endif // HYBRIDASTARPLANNER_H
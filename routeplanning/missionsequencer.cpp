@@ -0,0 +1,342 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "missionsequencer.h"
+#include <QElapsedTimer>
+#include <QLineF>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <optional>
+
+namespace {
+constexpr double MIN_IMPROVEMENT_m = 1e-6;
+
+struct Endpoints {
+    QPointF start;
+    QPointF end;
+};
+
+class SequenceOptimizer
+{
+public:
+    using Step = MissionSequencer::Step;
+
+    SequenceOptimizer(const QList<MissionSequencer::Task> &tasks, const MissionSequencer::Options &options, const std::function<bool()> &shouldStop)
+        : mOptions(options), mShouldStop(shouldStop)
+    {
+        mVariants.reserve(tasks.size());
+        for (const auto &task : tasks) {
+            QVector<Endpoints> variants;
+            for (const auto &route : task.variants)
+                variants.append(route.isEmpty() ? Endpoints() : Endpoints{route.first().getPoint(), route.last().getPoint()});
+            mVariants.append(variants);
+        }
+    }
+
+    QVector<Step> getNearestNeighbourSteps() const
+    {
+        QVector<Step> steps;
+        QVector<bool> used(mVariants.size(), false);
+        std::optional<QPointF> position;
+        if (mOptions.useStartPoint)
+            position = mOptions.startPoint;
+
+        for (int i = 0; i < mVariants.size(); i++) {
+            Step best {-1, 0, false};
+            double bestDistance = std::numeric_limits<double>::infinity();
+            for (int task = 0; task < mVariants.size() && (position || best.task < 0); task++) {
+                if (used.at(task))
+                    continue;
+                for (int variant = 0; variant < mVariants.at(task).size(); variant++)
+                    for (const bool reversed : {false, true}) {
+                        const Step step {task, variant, reversed};
+                        const double distance = getTransit(position, getStart(step));
+                        if (distance < bestDistance) {
+                            bestDistance = distance;
+                            best = step;
+                        }
+                    }
+            }
+            used[best.task] = true;
+            steps.append(best);
+            position = getEnd(best);
+        }
+        return steps;
+    }
+
+    double getTransitDistance(const QVector<Step> &steps) const
+    {
+        if (steps.isEmpty())
+            return 0.0;
+
+        double transitDistance = 0.0;
+        for (int i = 0; i < steps.size(); i++)
+            transitDistance += getTransit(getEndBefore(steps, i), getStart(steps.at(i)));
+        return transitDistance + getTransit(getEnd(steps.last()), getStartAfter(steps, steps.size() - 1));
+    }
+
+    // Reverses runs of steps (each step is then driven reversed), only the transits at both ends of the run change
+    bool improveByTwoOpt(QVector<Step> &steps) const
+    {
+        bool improved = false;
+        for (int i = 0; i + 1 < steps.size() && !mShouldStop(); i++)
+            for (int j = i + 1; j < steps.size(); j++) {
+                const std::optional<QPointF> before = getEndBefore(steps, i);
+                const std::optional<QPointF> after = getStartAfter(steps, j);
+                const double change = getTransit(before, getEnd(steps.at(j))) + getTransit(getStart(steps.at(i)), after)
+                        - getTransit(before, getStart(steps.at(i))) - getTransit(getEnd(steps.at(j)), after);
+                if (change < -MIN_IMPROVEMENT_m) {
+                    std::reverse(steps.begin() + i, steps.begin() + j + 1);
+                    for (int k = i; k <= j; k++)
+                        steps[k].reversed = !steps.at(k).reversed;
+                    improved = true;
+                }
+            }
+        return improved;
+    }
+
+    // Moves runs of up to three steps elsewhere, as they are or reversed
+    bool improveByOrOpt(QVector<Step> &steps) const
+    {
+        bool improved = false;
+        for (int length = 1; length <= 3; length++)
+            for (int i = 0; i + length <= steps.size() && !mShouldStop(); i++) {
+                const int last = i + length - 1;
+                const std::optional<QPointF> before = getEndBefore(steps, i);
+                const std::optional<QPointF> after = getStartAfter(steps, last);
+                const QPointF runStart = getStart(steps.at(i));
+                const QPointF runEnd = getEnd(steps.at(last));
+                const double removalGain = getTransit(before, runStart) + getTransit(runEnd, after) - getTransit(before, after);
+
+                // Positions in the steps without the run
+                const int remaining = steps.size() - length;
+                auto getRemaining = [&](int index) { return steps.at(index < i ? index : index + length); };
+                double bestChange = -MIN_IMPROVEMENT_m;
+                int bestPosition = -1;
+                bool bestReversed = false;
+                for (int position = 0; position <= remaining; position++) {
+                    if (position == i)
+                        continue;
+                    std::optional<QPointF> from, to;
+                    if (position > 0)
+                        from = getEnd(getRemaining(position - 1));
+                    else if (mOptions.useStartPoint)
+                        from = mOptions.startPoint;
+                    if (position < remaining)
+                        to = getStart(getRemaining(position));
+                    else if (mOptions.useStartPoint && mOptions.returnToStartPoint)
+                        to = mOptions.startPoint;
+
+                    const double gap = getTransit(from, to);
+                    const double change = getTransit(from, runStart) + getTransit(runEnd, to) - gap - removalGain;
+                    const double reversedChange = getTransit(from, runEnd) + getTransit(runStart, to) - gap - removalGain;
+                    if (change < bestChange || reversedChange < bestChange) {
+                        bestReversed = reversedChange < change;
+                        bestChange = std::min(change, reversedChange);
+                        bestPosition = position;
+                    }
+                }
+
+                if (bestPosition < 0)
+                    continue;
+
+                QVector<Step> run = steps.mid(i, length);
+                if (bestReversed) {
+                    std::reverse(run.begin(), run.end());
+                    for (Step &step : run)
+                        step.reversed = !step.reversed;
+                }
+                steps.remove(i, length);
+                for (int k = 0; k < length; k++)
+                    steps.insert(bestPosition + k, run.at(k));
+                improved = true;
+            }
+        return improved;
+    }
+
+    // Best variant and direction of each step for the order of the steps
+    void selectVariants(QVector<Step> &steps) const
+    {
+        if (steps.isEmpty())
+            return;
+
+        auto getOptions = [this](const Step &step) {
+            QVector<Step> options;
+            for (int variant = 0; variant < mVariants.at(step.task).size(); variant++) {
+                options.append({step.task, variant, false});
+                options.append({step.task, variant, true});
+            }
+            return options;
+        };
+
+        std::optional<QPointF> start;
+        if (mOptions.useStartPoint)
+            start = mOptions.startPoint;
+        QVector<QVector<Step>> options = {getOptions(steps.first())};
+        QVector<QVector<double>> distances = {QVector<double>(options.first().size())};
+        QVector<QVector<int>> previousOptions = {QVector<int>(options.first().size(), -1)};
+        for (int o = 0; o < options.first().size(); o++)
+            distances[0][o] = getTransit(start, getStart(options.first().at(o)));
+
+        for (int i = 1; i < steps.size(); i++) {
+            options.append(getOptions(steps.at(i)));
+            distances.append(QVector<double>(options.last().size(), std::numeric_limits<double>::infinity()));
+            previousOptions.append(QVector<int>(options.last().size(), -1));
+            for (int o = 0; o < options.at(i).size(); o++)
+                for (int p = 0; p < options.at(i - 1).size(); p++) {
+                    const double distance = distances.at(i - 1).at(p) + QLineF(getEnd(options.at(i - 1).at(p)), getStart(options.at(i).at(o))).length();
+                    if (distance < distances.at(i).at(o)) {
+                        distances[i][o] = distance;
+                        previousOptions[i][o] = p;
+                    }
+                }
+        }
+
+        std::optional<QPointF> end;
+        if (mOptions.useStartPoint && mOptions.returnToStartPoint)
+            end = mOptions.startPoint;
+        int bestOption = 0;
+        double bestDistance = std::numeric_limits<double>::infinity();
+        for (int o = 0; o < options.last().size(); o++) {
+            const double distance = distances.last().at(o) + getTransit(getEnd(options.last().at(o)), end);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                bestOption = o;
+            }
+        }
+
+        for (int i = steps.size() - 1; i >= 0; i--) {
+            steps[i] = options.at(i).at(bestOption);
+            bestOption = previousOptions.at(i).at(bestOption);
+        }
+    }
+
+private:
+    QPointF getStart(const Step &step) const { const Endpoints &e = mVariants.at(step.task).at(step.variant); return step.reversed ? e.end : e.start; }
+    QPointF getEnd(const Step &step) const { const Endpoints &e = mVariants.at(step.task).at(step.variant); return step.reversed ? e.start : e.end; }
+
+    // End of the step before index, or the start point
+    std::optional<QPointF> getEndBefore(const QVector<Step> &steps, int index) const
+    {
+        if (index > 0)
+            return getEnd(steps.at(index - 1));
+        if (mOptions.useStartPoint)
+            return mOptions.startPoint;
+        return std::nullopt;
+    }
+
+    // Start of the step after index, or the start point to return to
+    std::optional<QPointF> getStartAfter(const QVector<Step> &steps, int index) const
+    {
+        if (index + 1 < steps.size())
+            return getStart(steps.at(index + 1));
+        if (mOptions.useStartPoint && mOptions.returnToStartPoint)
+            return mOptions.startPoint;
+        return std::nullopt;
+    }
+
+    // No transit without a point to come from or go to
+    static double getTransit(const std::optional<QPointF> &from, const std::optional<QPointF> &to)
+    {
+        return (from && to) ? QLineF(*from, *to).length() : 0.0;
+    }
+
+    MissionSequencer::Options mOptions;
+    std::function<bool()> mShouldStop;
+    QVector<QVector<Endpoints>> mVariants; // per task
+};
+}
+
+MissionSequencer::MissionSequencer(QObject *parent) : QObject(parent)
+{
+    mThreadContext = new QObject();
+    mThread.setObjectName("Mission sequencer");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start();
+}
+
+MissionSequencer::~MissionSequencer()
+{
+    mCancel = true;
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+}
+
+bool MissionSequencer::start(const QList<Task> &tasks, const Options &options)
+{
+    if (mRunning)
+        return false;
+    for (const Task &task : tasks)
+        if (task.variants.isEmpty())
+            return false;
+
+    mRunning = true;
+    mCancel = false;
+    QMetaObject::invokeMethod(mThreadContext, [this, tasks, options]() {
+        const Sequence sequence = optimize(tasks, options, mCancel, [this](const Sequence &sequence) {
+            QMetaObject::invokeMethod(this, [this, sequence]() { emit improved(sequence); }, Qt::QueuedConnection);
+        });
+        QMetaObject::invokeMethod(this, [this, sequence]() {
+            mRunning = false;
+            emit finished(sequence);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+
+    return true;
+}
+
+void MissionSequencer::cancel()
+{
+    mCancel = true;
+}
+
+MissionSequencer::Sequence MissionSequencer::optimize(const QList<Task> &tasks, const Options &options, const std::atomic<bool> &cancel,
+                                                      const std::function<void (const Sequence &)> &improved)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const SequenceOptimizer optimizer(tasks, options, [&]() { return cancel || timer.elapsed() >= options.maxDuration_ms; });
+
+    Sequence best;
+    best.steps = optimizer.getNearestNeighbourSteps();
+    optimizer.selectVariants(best.steps);
+    best.transitDistance_m = optimizer.getTransitDistance(best.steps);
+    if (improved)
+        improved(best);
+
+    // Until a round finds no improvement (local optimum) or time is up
+    QVector<Step> steps = best.steps;
+    while (!cancel && timer.elapsed() < options.maxDuration_ms) {
+        const bool changedByTwoOpt = optimizer.improveByTwoOpt(steps);
+        const bool changedByOrOpt = optimizer.improveByOrOpt(steps);
+        if (!changedByTwoOpt && !changedByOrOpt)
+            break;
+        optimizer.selectVariants(steps);
+
+        const double transitDistance = optimizer.getTransitDistance(steps);
+        if (transitDistance >= best.transitDistance_m - MIN_IMPROVEMENT_m)
+            break;
+        best.steps = steps;
+        best.transitDistance_m = transitDistance;
+        if (improved)
+            improved(best);
+    }
+
+    return best;
+}
+
+QVector<pospoint_t> MissionSequencer::getRoute(const QList<Task> &tasks, const Sequence &sequence)
+{
+    QVector<pospoint_t> route;
+    for (const Step &step : sequence.steps) {
+        const QVector<pospoint_t> &variant = tasks.at(step.task).variants.at(step.variant);
+        if (step.reversed)
+            std::reverse_copy(variant.begin(), variant.end(), std::back_inserter(route));
+        else
+            route.append(variant);
+    }
+    return route;
+}
@@ -0,0 +1,80 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Orders the routes of a mission (e.g., zig-zag coverage of several fields) to minimize the transits between them.
+ * Each task has one or more variants (e.g., zig-zags of a field starting from different corners), each of which can also
+ * be driven reversed. Only the end points of the variants matter: a nearest neighbour tour is improved by 2-opt and
+ * Or-opt moves on the task order, after each round the best variants for the order are chosen (dynamic programming).
+ * Optimization runs on a worker thread until no move improves the sequence, the time limit is reached or it is canceled.
+ * Every improvement is handed out (anytime), all signals are emitted in the thread the sequencer lives in.
+ */
+
+#ifndef MISSIONSEQUENCER_H
+#define MISSIONSEQUENCER_H
+
+#include <QObject>
+#include <QThread>
+#include <QList>
+#include <QVector>
+#include <QPointF>
+#include <atomic>
+#include <functional>
+#include "core/pospoint.h"
+
+class MissionSequencer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Task {
+        QList<QVector<pospoint_t>> variants; // alternatives covering the same, at least one
+    };
+
+    struct Step {
+        int task;
+        int variant;
+        bool reversed;
+    };
+
+    struct Sequence {
+        QVector<Step> steps; // every task once
+        double transitDistance_m = 0.0; // straight lines between the end and start of consecutive steps
+    };
+
+    struct Options {
+        bool useStartPoint = false; // e.g., the vehicle's position, otherwise the first task can start anywhere
+        QPointF startPoint; // [m] ENU
+        bool returnToStartPoint = false;
+        int maxDuration_ms = DEFAULT_MAX_DURATION_ms;
+    };
+
+    static constexpr int DEFAULT_MAX_DURATION_ms = 1000;
+
+    explicit MissionSequencer(QObject *parent = nullptr);
+    ~MissionSequencer();
+
+    // Only one optimization at a time, returns false if one is already running or a task has no variants
+    bool start(const QList<Task> &tasks, const Options &options);
+    bool start(const QList<Task> &tasks) { return start(tasks, Options()); } // not a default argument: Options' member initializers are not usable within the class
+    // Stops as soon as possible, finished() follows with the best sequence so far
+    void cancel();
+    bool isRunning() const { return mRunning; }
+
+    // Synchronous optimization, improved is called with every improvement (in the calling thread)
+    static Sequence optimize(const QList<Task> &tasks, const Options &options, const std::atomic<bool> &cancel,
+                             const std::function<void(const Sequence &sequence)> &improved = nullptr);
+    // The steps' routes concatenated
+    static QVector<pospoint_t> getRoute(const QList<Task> &tasks, const Sequence &sequence);
+
+signals:
+    void improved(const MissionSequencer::Sequence &sequence);
+    void finished(const MissionSequencer::Sequence &sequence);
+
+private:
+    QThread mThread;
+    QObject *mThreadContext;
+    bool mRunning = false; // owner thread only
+    std::atomic<bool> mCancel {false};
+};
+
+#endif // MISSIONSEQUENCER_H
@@ -0,0 +1,516 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "polygonoffset.h"
+#include "segmentsweep.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+// Grid coordinates, within +-1e9 (i.e., +-100 km at 0.1 mm) products of differences fit 64 bits
+struct IntPoint {
+    qint64 x;
+    qint64 y;
+
+    bool operator==(const IntPoint &other) const { return x == other.x && y == other.y; }
+    bool operator!=(const IntPoint &other) const { return !(*this == other); }
+};
+
+struct Crossing {
+    int segment0, segment1; // segment i is (contour[i], contour[i + 1])
+    double t0, t1; // position along segment0 and segment1
+    QPointF point;
+};
+
+struct Node {
+    QPointF point;
+    int crossing = -1; // -1: vertex of the contour
+};
+
+struct Loop {
+    QVector<QPointF> points;
+    double area = 0.0;
+};
+
+// (a - o) x (b - o), positive: b is left of o -> a
+qint64 cross(const IntPoint &o, const IntPoint &a, const IntPoint &b)
+{
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Sign of cross(points[i], points[j], points[k]) with the points perturbed symbolically (simulation of simplicity, Edelsbrunner
+// and Muecke): never 0, i.e., collinear segments and vertices on segments cross or not, consistently for all tests
+int orientation(const QVector<IntPoint> &points, int i, int j, int k)
+{
+    const qint64 determinant = cross(points.at(i), points.at(j), points.at(k));
+    if (determinant != 0)
+        return determinant > 0 ? 1 : -1;
+
+    int sign = 1;
+    if (i > j) { std::swap(i, j); sign = -sign; }
+    if (j > k) { std::swap(j, k); sign = -sign; }
+    if (i > j) { std::swap(i, j); sign = -sign; }
+    const IntPoint &pi = points.at(i), &pj = points.at(j), &pk = points.at(k);
+    // Coefficients of the perturbations in decreasing order, x of a point before its y, lower indices first
+    qint64 coefficient = pj.y - pk.y;
+    if (coefficient == 0)
+        coefficient = pk.x - pj.x;
+    if (coefficient == 0)
+        coefficient = pk.y - pi.y;
+    if (coefficient == 0)
+        coefficient = -1;
+    return coefficient > 0 ? sign : -sign;
+}
+
+QPointF toPointF(const IntPoint &point)
+{
+    return QPointF(point.x, point.y);
+}
+
+IntPoint toIntPoint(const QPointF &point)
+{
+    return IntPoint{std::llround(point.x()), std::llround(point.y())};
+}
+
+double getSignedArea(const QVector<IntPoint> &polygon)
+{
+    double area = 0.0;
+    for (int i = 0; i < polygon.size(); i++) {
+        const IntPoint &a = polygon.at(i);
+        const IntPoint &b = polygon.at((i + 1) % polygon.size());
+        area += double(a.x) * double(b.y) - double(b.x) * double(a.y);
+    }
+    return area / 2.0;
+}
+
+// Without duplicate (within a grid unit) and collinear (including reversing) points
+QVector<IntPoint> cleanPolygon(const QVector<IntPoint> &points)
+{
+    auto isDuplicate = [](const IntPoint &a, const IntPoint &b) { return std::abs(a.x - b.x) <= 1 && std::abs(a.y - b.y) <= 1; };
+    QVector<IntPoint> polygon;
+    polygon.reserve(points.size());
+    for (const IntPoint &point : points)
+        if (polygon.isEmpty() || !isDuplicate(point, polygon.last()))
+            polygon.append(point);
+    while (polygon.size() > 1 && isDuplicate(polygon.first(), polygon.last()))
+        polygon.removeLast();
+
+    bool changed = true;
+    while (changed && polygon.size() >= 3) {
+        changed = false;
+        QVector<IntPoint> cleaned;
+        cleaned.reserve(polygon.size());
+        for (int i = 0; i < polygon.size(); i++) {
+            const IntPoint &previous = cleaned.isEmpty() ? polygon.last() : cleaned.last();
+            if (cross(previous, polygon.at(i), polygon.at((i + 1) % polygon.size())) == 0)
+                changed = true;
+            else
+                cleaned.append(polygon.at(i));
+        }
+        polygon = cleaned;
+    }
+    return polygon.size() >= 3 ? polygon : QVector<IntPoint>();
+}
+
+// Edges moved by distance along their normals (outward for counter-clockwise polygons) and joined, in grid units
+QVector<IntPoint> getRawContour(const QVector<IntPoint> &polygon, double distance, const polygonOffset::Parameters &parameters, double arcTolerance)
+{
+    auto getLength = [](const IntPoint &from, const IntPoint &to) {
+        const QPointF d = toPointF(to) - toPointF(from);
+        return sqrt(d.x() * d.x() + d.y() * d.y());
+    };
+    auto getNormal = [&getLength](const IntPoint &from, const IntPoint &to) {
+        const QPointF d = toPointF(to) - toPointF(from);
+        const double length = getLength(from, to);
+        return QPointF(d.y() / length, -d.x() / length);
+    };
+
+    QVector<QPointF> contour;
+    contour.reserve(polygon.size() * 2);
+    const int n = polygon.size();
+    for (int i = 0; i < n; i++) {
+        const IntPoint &previous = polygon.at((i + n - 1) % n);
+        const IntPoint &vertex = polygon.at(i);
+        const IntPoint &next = polygon.at((i + 1) % n);
+        const QPointF p = toPointF(vertex);
+        const QPointF n0 = getNormal(previous, vertex);
+        const QPointF n1 = getNormal(vertex, next);
+        const QPointF a = p + n0 * distance;
+        const QPointF b = p + n1 * distance;
+        const double cosAngle = n0.x() * n1.x() + n0.y() * n1.y();
+        const double sinAngle = n0.x() * n1.y() - n0.y() * n1.x();
+        // Offset edges separate at convex vertices when growing and concave vertices when shrinking. Where they overlap, they are
+        // trimmed to their intersection as long as both keep their direction (trimmed at both ends by distance * tan(angle / 2) at most).
+        // Otherwise the contour runs through the vertex (as in Clipper): a miter would turn inside out for offsets beyond the
+        // polygon's width, the loops of the overlap are dropped afterwards.
+        const bool separating = (cross(previous, vertex, next) > 0) == (distance > 0.0);
+        if (!separating) {
+            const double trim = fabs(distance * sinAngle) / (1.0 + cosAngle);
+            if (2.0 * trim <= std::min(getLength(previous, vertex), getLength(vertex, next))) {
+                contour.append(p + (n0 + n1) * (distance / (1.0 + cosAngle)));
+            } else {
+                contour.append(a);
+                contour.append(p);
+                contour.append(b);
+            }
+        } else if (parameters.joinType == polygonOffset::JoinType::Round) {
+            const double angle = atan2(sinAngle, cosAngle);
+            const double maxStep = 2.0 * acos(std::max(1.0 - arcTolerance / fabs(distance), -1.0));
+            const int steps = std::max(int(ceil(fabs(angle) / std::max(maxStep, 1e-3))), 1);
+            for (int step = 0; step < steps; step++) {
+                const double stepAngle = angle * step / steps;
+                const QPointF normal(n0.x() * cos(stepAngle) - n0.y() * sin(stepAngle), n0.x() * sin(stepAngle) + n0.y() * cos(stepAngle));
+                contour.append(p + normal * distance);
+            }
+            contour.append(b);
+        } else if (1.0 + cosAngle > 2.0 / (parameters.miterLimit * parameters.miterLimit)) { // miter at distance / cos(angle / 2)
+            contour.append(p + (n0 + n1) * (distance / (1.0 + cosAngle)));
+        } else { // squared off at distance from the vertex (as in Clipper), i.e., still covering the round join
+            const double bisectorLength = sqrt(std::max(2.0 + 2.0 * cosAngle, 1e-12));
+            const QPointF bisector = (n0 + n1) / bisectorLength;
+            const QPointF direction0(-n0.y(), n0.x());
+            const double shift = distance * (1.0 - bisectorLength / 2.0) / (bisector.x() * direction0.x() + bisector.y() * direction0.y());
+            contour.append(a + direction0 * shift);
+            contour.append(b - QPointF(-n1.y(), n1.x()) * shift);
+        }
+    }
+
+    QVector<IntPoint> rawContour;
+    rawContour.reserve(contour.size());
+    for (const QPointF &point : contour) {
+        const IntPoint intPoint = toIntPoint(point);
+        if (rawContour.isEmpty() || intPoint != rawContour.last())
+            rawContour.append(intPoint);
+    }
+    while (rawContour.size() > 1 && rawContour.first() == rawContour.last())
+        rawContour.removeLast();
+    return rawContour;
+}
+
+QVector<Crossing> findCrossings(const QVector<IntPoint> &contour)
+{
+    const int n = contour.size();
+    QVector<QPointF> closed;
+    closed.reserve(n + 1);
+    for (const IntPoint &point : contour)
+        closed.append(toPointF(point));
+    closed.append(closed.first());
+
+    // Sweep segment i is (closed[i - 1], closed[i]), the first and last one are adjacent
+    auto crosses = [&](int i, int j) {
+        if (i == 1 && j == n)
+            return false;
+        const int a = i - 1, b = i % n, c = j - 1, d = j % n;
+        return orientation(contour, a, b, c) != orientation(contour, a, b, d) && orientation(contour, c, d, a) != orientation(contour, c, d, b);
+    };
+
+    QVector<Crossing> crossings;
+    for (const auto &pair : segmentSweep::findIntersectingSegments(closed, 2, crosses)) {
+        const QPointF a = closed.at(pair.first - 1), b = closed.at(pair.first);
+        const QPointF c = closed.at(pair.second - 1), d = closed.at(pair.second);
+        const double ca = cross(contour.at(pair.second - 1), contour.at(pair.second % n), contour.at(pair.first - 1));
+        const double cb = cross(contour.at(pair.second - 1), contour.at(pair.second % n), contour.at(pair.first % n));
+
+        Crossing crossing;
+        crossing.segment0 = pair.first - 1;
+        crossing.segment1 = pair.second - 1;
+        const QPointF ab = b - a, cd = d - c;
+        if (ca != cb) {
+            crossing.t0 = std::min(std::max(ca / (ca - cb), 0.0), 1.0);
+        } else { // collinear, in the middle of the overlap
+            const double abLengthSq = std::max(ab.x() * ab.x() + ab.y() * ab.y(), 1e-12);
+            const double tc = ((c - a).x() * ab.x() + (c - a).y() * ab.y()) / abLengthSq;
+            const double td = ((d - a).x() * ab.x() + (d - a).y() * ab.y()) / abLengthSq;
+            crossing.t0 = (std::max(std::min(tc, td), 0.0) + std::min(std::max(tc, td), 1.0)) / 2.0;
+        }
+        crossing.point = a + ab * crossing.t0;
+        const double cdLengthSq = std::max(cd.x() * cd.x() + cd.y() * cd.y(), 1e-12);
+        crossing.t1 = std::min(std::max(((crossing.point - c).x() * cd.x() + (crossing.point - c).y() * cd.y()) / cdLengthSq, 0.0), 1.0);
+        crossings.append(crossing);
+    }
+    return crossings;
+}
+
+// Splits the contour at its crossings: arriving at a crossing, the loop continues on the other strand
+QVector<Loop> splitIntoLoops(const QVector<IntPoint> &contour, const QVector<Crossing> &crossings)
+{
+    const int n = contour.size();
+    QVector<QVector<QPair<double, int>>> crossingsOnSegment(n);
+    for (int i = 0; i < crossings.size(); i++) {
+        crossingsOnSegment[crossings.at(i).segment0].append(qMakePair(crossings.at(i).t0, i));
+        crossingsOnSegment[crossings.at(i).segment1].append(qMakePair(crossings.at(i).t1, i));
+    }
+
+    QVector<Node> nodes;
+    nodes.reserve(n + 2 * crossings.size());
+    QVector<int> firstOccurrence(crossings.size(), -1);
+    QVector<int> partner; // node index of the crossing's other occurrence, -1 for vertices
+    partner.reserve(nodes.capacity());
+    for (int i = 0; i < n; i++) {
+        nodes.append({toPointF(contour.at(i)), -1});
+        partner.append(-1);
+        auto &onSegment = crossingsOnSegment[i];
+        std::sort(onSegment.begin(), onSegment.end());
+        for (const auto &crossing : onSegment) {
+            const int node = nodes.size();
+            nodes.append({crossings.at(crossing.second).point, crossing.second});
+            partner.append(firstOccurrence.at(crossing.second));
+            if (firstOccurrence.at(crossing.second) < 0)
+                firstOccurrence[crossing.second] = node;
+            else
+                partner[firstOccurrence.at(crossing.second)] = node;
+        }
+    }
+
+    // Edge e is (nodes[e], nodes[e + 1]), every edge belongs to one loop
+    const int m = nodes.size();
+    QVector<bool> visited(m, false);
+    QVector<Loop> loops;
+    for (int start = 0; start < m; start++) {
+        if (visited.at(start))
+            continue;
+
+        Loop loop;
+        int edge = start;
+        while (!visited.at(edge)) {
+            visited[edge] = true;
+            loop.points.append(nodes.at(edge).point);
+            const int next = (edge + 1) % m;
+            edge = (partner.at(next) >= 0) ? partner.at(next) : next;
+        }
+
+        for (int i = 0; i < loop.points.size(); i++) {
+            const QPointF &a = loop.points.at(i);
+            const QPointF &b = loop.points.at((i + 1) % loop.points.size());
+            loop.area += (a.x() * b.y() - b.x() * a.y()) / 2.0;
+        }
+        loops.append(loop);
+    }
+    return loops;
+}
+
+// Winding numbers of the whole contour (the sum of its loops), Sunday's algorithm on the edges of the point's horizontal strip only
+class WindingIndex
+{
+public:
+    explicit WindingIndex(const QVector<IntPoint> &contour) : mContour(contour)
+    {
+        qint64 yMin = contour.first().y, yMax = contour.first().y;
+        for (const IntPoint &point : contour) {
+            yMin = std::min(yMin, point.y);
+            yMax = std::max(yMax, point.y);
+        }
+        mYMin = yMin;
+        mStripHeight = std::max(double(yMax - yMin) / contour.size(), 1.0);
+        mStrips.resize(int((yMax - yMin) / mStripHeight) + 1);
+        for (int i = 0; i < contour.size(); i++) {
+            const qint64 y0 = contour.at(i).y, y1 = contour.at((i + 1) % contour.size()).y;
+            for (int strip = getStrip(std::min(y0, y1)); strip <= getStrip(std::max(y0, y1)); strip++)
+                mStrips[strip].append(i);
+        }
+    }
+
+    int getWindingNumber(const QPointF &point) const
+    {
+        const int strip = getStrip(point.y());
+        if (strip < 0 || strip >= mStrips.size())
+            return 0;
+
+        int winding = 0;
+        for (const int i : mStrips.at(strip)) {
+            const QPointF a = toPointF(mContour.at(i));
+            const QPointF b = toPointF(mContour.at((i + 1) % mContour.size()));
+            const double isLeft = (b.x() - a.x()) * (point.y() - a.y()) - (point.x() - a.x()) * (b.y() - a.y());
+            if (a.y() <= point.y()) {
+                if (b.y() > point.y() && isLeft > 0.0)
+                    winding++;
+            } else if (b.y() <= point.y() && isLeft < 0.0) {
+                winding--;
+            }
+        }
+        return winding;
+    }
+
+private:
+    int getStrip(double y) const { return int(floor((y - mYMin) / mStripHeight)); }
+
+    const QVector<IntPoint> &mContour;
+    double mYMin = 0.0;
+    double mStripHeight = 1.0;
+    QVector<QVector<int>> mStrips;
+};
+
+// Winding just inside the loop, next to the middle of one of its longest edges: the winding across it needs to change by the loop's
+// orientation, otherwise another part of the contour runs along the edge
+int getWindingInside(const WindingIndex &windingIndex, const Loop &loop, QPointF *pointInside = nullptr)
+{
+    static constexpr int MAX_TRIED_EDGES = 8;
+    static constexpr double SAMPLE_DISTANCE = 0.25; // [grid units], from the edge
+
+    QVector<QPair<double, int>> edges;
+    edges.reserve(loop.points.size());
+    for (int i = 0; i < loop.points.size(); i++) {
+        const QPointF d = loop.points.at((i + 1) % loop.points.size()) - loop.points.at(i);
+        edges.append(qMakePair(-(d.x() * d.x() + d.y() * d.y()), i));
+    }
+    const int triedEdges = std::min(MAX_TRIED_EDGES, edges.size());
+    std::partial_sort(edges.begin(), edges.begin() + triedEdges, edges.end());
+
+    const int loopOrientation = loop.area > 0.0 ? 1 : -1;
+    int fallbackWinding = 0;
+    for (int i = 0; i < triedEdges; i++) {
+        const QPointF a = loop.points.at(edges.at(i).second);
+        const QPointF b = loop.points.at((edges.at(i).second + 1) % loop.points.size());
+        const double length = sqrt(std::max(-edges.at(i).first, 1e-12));
+        const QPointF inward = QPointF(-(b.y() - a.y()) / length, (b.x() - a.x()) / length) * (loopOrientation * SAMPLE_DISTANCE);
+        const QPointF middle = (a + b) / 2.0;
+        const int windingInside = windingIndex.getWindingNumber(middle + inward);
+        if (i == 0) {
+            fallbackWinding = windingInside;
+            if (pointInside)
+                *pointInside = middle + inward;
+        }
+        if (windingInside - windingIndex.getWindingNumber(middle - inward) == loopOrientation) {
+            if (pointInside)
+                *pointInside = middle + inward;
+            return windingInside;
+        }
+    }
+    return fallbackWinding;
+}
+
+bool isPointInside(const QVector<QPointF> &polygon, const QPointF &point)
+{
+    bool inside = false;
+    for (int i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const QPointF &a = polygon.at(i), &b = polygon.at(j);
+        if ((a.y() > point.y()) != (b.y() > point.y())
+                && point.x() < (b.x() - a.x()) * (point.y() - a.y()) / (b.y() - a.y()) + a.x())
+            inside = !inside;
+    }
+    return inside;
+}
+
+// Without the duplicate and collinear points at crossings
+QVector<QPointF> toWorld(const QVector<QPointF> &points, double precision_m)
+{
+    QVector<IntPoint> intPoints;
+    intPoints.reserve(points.size());
+    for (const QPointF &point : points)
+        intPoints.append(toIntPoint(point));
+
+    QVector<QPointF> world;
+    for (const IntPoint &point : cleanPolygon(intPoints))
+        world.append(toPointF(point) * precision_m);
+    return world;
+}
+}
+
+QVector<polygonOffset::OffsetPolygon> polygonOffset::offset(const QVector<QPointF> &polygon, double distance, const Parameters &parameters)
+{
+    const double precision_m = std::max(parameters.precision_m, 1e-9);
+    QVector<IntPoint> input;
+    input.reserve(polygon.size());
+    for (const QPointF &point : polygon)
+        input.append(toIntPoint(point / precision_m));
+    input = cleanPolygon(input);
+    if (input.isEmpty())
+        return {};
+    if (getSignedArea(input) < 0.0)
+        std::reverse(input.begin(), input.end());
+
+    const double scaledDistance = distance / precision_m;
+    if (fabs(scaledDistance) < 0.5) {
+        QVector<QPointF> points;
+        for (const IntPoint &point : input)
+            points.append(toPointF(point));
+        return {OffsetPolygon{toWorld(points, precision_m), {}}};
+    }
+
+    const QVector<IntPoint> contour = getRawContour(input, scaledDistance, parameters, std::max(parameters.arcTolerance_m / precision_m, 1.0));
+    if (contour.size() < 3)
+        return {};
+
+    // The offset polygon is where the contour winds at least once (positive fill rule): its outer boundaries are counter-clockwise
+    // loops with winding one inside, holes clockwise loops with winding zero inside. Loops elsewhere, e.g., where the offset
+    // folds over at vertices or swept over narrow parts, wind negative or more than once.
+    static constexpr double MIN_LOOP_AREA = 1.0; // [grid units^2]
+    const WindingIndex windingIndex(contour);
+    QVector<Loop> outers, holes;
+    QVector<QPointF> holePoints;
+    for (const Loop &loop : splitIntoLoops(contour, findCrossings(contour))) {
+        // Shrinking leaves no holes
+        if (loop.points.size() < 3 || fabs(loop.area) < MIN_LOOP_AREA || (loop.area < 0.0 && distance < 0.0))
+            continue;
+
+        QPointF pointInside;
+        const int winding = getWindingInside(windingIndex, loop, &pointInside);
+        if (loop.area > 0.0 && winding == 1) {
+            outers.append(loop);
+        } else if (loop.area < 0.0 && winding == 0) {
+            holes.append(loop);
+            holePoints.append(pointInside);
+        }
+    }
+    std::sort(outers.begin(), outers.end(), [](const Loop &a, const Loop &b) { return a.area > b.area; });
+
+    QVector<OffsetPolygon> result;
+    for (const Loop &outer : outers)
+        result.append(OffsetPolygon{toWorld(outer.points, precision_m), {}});
+    for (int hole = 0; hole < holes.size(); hole++) {
+        // In the smallest outer boundary around it
+        for (int i = outers.size() - 1; i >= 0; i--) {
+            if (isPointInside(outers.at(i).points, holePoints.at(hole))) {
+                result[i].holes.append(toWorld(holes.at(hole).points, precision_m));
+                break;
+            }
+        }
+    }
+    result.erase(std::remove_if(result.begin(), result.end(), [](const OffsetPolygon &offsetPolygon) { return offsetPolygon.outer.size() < 3; }),
+                 result.end());
+    return result;
+}
+
+QVector<QVector<polygonOffset::OffsetPolygon>> polygonOffset::getInsetRings(const QVector<QPointF> &polygon, double spacing, int maxRings, const Parameters &parameters)
+{
+    QVector<QVector<OffsetPolygon>> rings;
+    if (spacing <= 0.0)
+        return rings;
+
+    for (int ring = 1; ring <= maxRings; ring++) {
+        const QVector<OffsetPolygon> inset = offset(polygon, -ring * spacing, parameters);
+        if (inset.isEmpty())
+            break;
+        rings.append(inset);
+    }
+    return rings;
+}
+
+double polygonOffset::getSignedArea(const QVector<QPointF> &polygon)
+{
+    double area = 0.0;
+    for (int i = 0; i < polygon.size(); i++) {
+        const QPointF &a = polygon.at(i);
+        const QPointF &b = polygon.at((i + 1) % polygon.size());
+        area += a.x() * b.y() - b.x() * a.y();
+    }
+    return area / 2.0;
+}
+
+int polygonOffset::addBufferedZone(Geofence &geofence, Geofence::ZoneType type, const QVector<QPointF> &polygon, double margin_m, const Parameters &parameters)
+{
+    if (margin_m <= 0.0)
+        return geofence.addZone(type, polygon) >= 0 ? 1 : 0;
+
+    Parameters roundParameters = parameters;
+    roundParameters.joinType = JoinType::Round;
+    const QVector<OffsetPolygon> buffered = offset(polygon, type == Geofence::ZoneType::KeepOut ? margin_m : -margin_m, roundParameters);
+
+    int added = 0;
+    for (const OffsetPolygon &zone : buffered)
+        if (geofence.addZone(type, zone.outer) >= 0)
+            added++;
+    return added;
+}
@@ -0,0 +1,52 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Offsetting of simple polygons (convex or not) by a distance, e.g., the frames of framed zig-zag routes or safety margins
+ * of geofence zones. Points are snapped to a grid of precision_m and handled as 64-bit integers: orientation tests are exact,
+ * with symbolic perturbation (simulation of simplicity) for collinear cases. Each edge is moved along its normal, consecutive
+ * edges are joined by their intersection (miter, squared off beyond the miter limit) or an arc (round). The raw contour
+ * self-intersects where the offset is larger than features of the polygon: its crossings are found with segmentSweep and
+ * it is split into disjoint loops at them (in O(n + k) for k crossings). The offset polygon is where the contour winds at least
+ * once (as with Clipper's positive fill rule). It is bounded by the loops that wind once inside and zero times outside,
+ * found by the winding next to one edge of each loop. Thus a shrunk polygon splits where its narrow parts vanish and a grown one
+ * gets holes where it closes around a bay. Unlike a straight skeleton, each offset is computed from the polygon directly.
+ */
+
+#ifndef POLYGONOFFSET_H
+#define POLYGONOFFSET_H
+
+#include <QVector>
+#include <QPointF>
+#include "core/geofence.h"
+
+namespace polygonOffset {
+enum class JoinType {Miter, Round};
+
+struct Parameters {
+    JoinType joinType = JoinType::Miter;
+    double miterLimit = 2.0; // maximal distance of a miter from its vertex in multiples of the offset, squared off beyond
+    double arcTolerance_m = 0.01; // of round joins
+    double precision_m = 1e-4; // grid of the integer coordinates
+};
+
+struct OffsetPolygon {
+    QVector<QPointF> outer; // counter-clockwise, not closed (last point is not the first)
+    QVector<QVector<QPointF>> holes; // clockwise, only from outward offsets (e.g., a U-shaped polygon closing around its bay)
+};
+
+// polygon: simple, either orientation, closed or not. distance [m]: positive grows, negative shrinks the polygon.
+// Returns the offset polygons ordered by decreasing area, empty if nothing is left.
+QVector<OffsetPolygon> offset(const QVector<QPointF> &polygon, double distance, const Parameters &parameters = Parameters());
+// Rings spacing, 2 * spacing, ... inside polygon (at most maxRings, until nothing is left), each offset from polygon directly,
+// i.e., without accumulating errors. Ring k can consist of several polygons where polygon is narrower than 2 * k * spacing.
+QVector<QVector<OffsetPolygon>> getInsetRings(const QVector<QPointF> &polygon, double spacing, int maxRings, const Parameters &parameters = Parameters());
+double getSignedArea(const QVector<QPointF> &polygon); // positive: counter-clockwise
+
+// Adds polygon with a safety margin [m] (round joins, i.e., exact distance): keep-out zones grow by it (holes filled, i.e., conservative),
+// keep-in zones shrink by it and can split into several zones. Returns the number of zones added.
+int addBufferedZone(Geofence &geofence, Geofence::ZoneType type, const QVector<QPointF> &polygon, double margin_m,
+                    const Parameters &parameters = Parameters());
+}
+
+#endif // POLYGONOFFSET_H
@@ -0,0 +1,387 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "reedsshepppath.h"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+
+namespace {
+constexpr double ZERO = 1e-9;
+
+using Segment = DubinsPath::SegmentType;
+constexpr Segment L = Segment::Left;
+constexpr Segment S = Segment::Straight;
+constexpr Segment R = Segment::Right;
+
+double mod2pi(double angle) // [-pi, pi]
+{
+    double value = fmod(angle, 2.0 * M_PI);
+    if (value < -M_PI)
+        value += 2.0 * M_PI;
+    else if (value > M_PI)
+        value -= 2.0 * M_PI;
+    return value;
+}
+
+void polar(double x, double y, double &r, double &theta)
+{
+    r = sqrt(x * x + y * y);
+    theta = atan2(y, x);
+}
+
+void tauOmega(double u, double v, double xi, double eta, double phi, double &tau, double &omega)
+{
+    const double delta = mod2pi(u - v);
+    const double a = sin(u) - sin(delta);
+    const double b = cos(u) - cos(delta) - 1.0;
+    const double t1 = atan2(eta * a - xi * b, xi * a + eta * b);
+    const double t2 = 2.0 * (cos(delta) - cos(v) - cos(u)) + 3.0;
+    tau = (t2 < 0.0) ? mod2pi(t1 + M_PI) : mod2pi(t1);
+    omega = mod2pi(tau - u + v - phi);
+}
+
+// Formulas of Reeds and Shepp, "Optimal paths for a car that goes both forwards and backwards", 1990 (numbers as in the paper,
+// with the corrections of 8.3/8.4 and 8.11). Normalized: start at the origin heading along x, turn radius one.
+
+// 8.1
+bool LpSpLp(double x, double y, double phi, double &t, double &u, double &v)
+{
+    polar(x - sin(phi), y - 1.0 + cos(phi), u, t);
+    if (t >= -ZERO) {
+        v = mod2pi(phi - t);
+        return v >= -ZERO;
+    }
+    return false;
+}
+
+// 8.2
+bool LpSpRp(double x, double y, double phi, double &t, double &u, double &v)
+{
+    double t1, u1;
+    polar(x + sin(phi), y - 1.0 - cos(phi), u1, t1);
+    u1 = u1 * u1;
+    if (u1 >= 4.0) {
+        u = sqrt(u1 - 4.0);
+        const double theta = atan2(2.0, u);
+        t = mod2pi(t1 + theta);
+        v = mod2pi(t - phi);
+        return t >= -ZERO && v >= -ZERO;
+    }
+    return false;
+}
+
+// 8.3/8.4
+bool LpRmL(double x, double y, double phi, double &t, double &u, double &v)
+{
+    const double xi = x - sin(phi);
+    const double eta = y - 1.0 + cos(phi);
+    double u1, theta;
+    polar(xi, eta, u1, theta);
+    if (u1 <= 4.0) {
+        u = -2.0 * asin(0.25 * u1);
+        t = mod2pi(theta + 0.5 * u + M_PI);
+        v = mod2pi(phi - t + u);
+        return t >= -ZERO && u <= ZERO;
+    }
+    return false;
+}
+
+// 8.7
+bool LpRupLumRm(double x, double y, double phi, double &t, double &u, double &v)
+{
+    const double xi = x + sin(phi);
+    const double eta = y - 1.0 - cos(phi);
+    const double rho = 0.25 * (2.0 + sqrt(xi * xi + eta * eta));
+    if (rho <= 1.0) {
+        u = acos(rho);
+        tauOmega(u, -u, xi, eta, phi, t, v);
+        return t >= -ZERO && v <= ZERO;
+    }
+    return false;
+}
+
+// 8.8
+bool LpRumLumRp(double x, double y, double phi, double &t, double &u, double &v)
+{
+    const double xi = x + sin(phi);
+    const double eta = y - 1.0 - cos(phi);
+    const double rho = (20.0 - xi * xi - eta * eta) / 16.0;
+    if (rho >= 0.0 && rho <= 1.0) {
+        u = -acos(rho);
+        if (u >= -0.5 * M_PI) {
+            tauOmega(u, u, xi, eta, phi, t, v);
+            return t >= -ZERO && v >= -ZERO;
+        }
+    }
+    return false;
+}
+
+// 8.9
+bool LpRmSmLm(double x, double y, double phi, double &t, double &u, double &v)
+{
+    const double xi = x - sin(phi);
+    const double eta = y - 1.0 + cos(phi);
+    double rho, theta;
+    polar(xi, eta, rho, theta);
+    if (rho >= 2.0) {
+        const double r = sqrt(rho * rho - 4.0);
+        u = 2.0 - r;
+        t = mod2pi(theta + atan2(r, -2.0));
+        v = mod2pi(phi - 0.5 * M_PI - t);
+        return t >= -ZERO && u <= ZERO && v <= ZERO;
+    }
+    return false;
+}
+
+// 8.10
+bool LpRmSmRm(double x, double y, double phi, double &t, double &u, double &v)
+{
+    const double xi = x + sin(phi);
+    const double eta = y - 1.0 - cos(phi);
+    double rho, theta;
+    polar(-eta, xi, rho, theta);
+    if (rho >= 2.0) {
+        t = theta;
+        u = 2.0 - rho;
+        v = mod2pi(t + 0.5 * M_PI - phi);
+        return t >= -ZERO && u <= ZERO && v <= ZERO;
+    }
+    return false;
+}
+
+// 8.11
+bool LpRmSLmRp(double x, double y, double phi, double &t, double &u, double &v)
+{
+    const double xi = x + sin(phi);
+    const double eta = y - 1.0 - cos(phi);
+    double rho, theta;
+    polar(xi, eta, rho, theta);
+    if (rho >= 2.0) {
+        u = 4.0 - sqrt(rho * rho - 4.0);
+        if (u <= ZERO) {
+            t = mod2pi(atan2((4.0 - u) * xi - 2.0 * eta, -2.0 * xi + (u - 4.0) * eta));
+            v = mod2pi(t - phi);
+            return t >= -ZERO && v >= -ZERO;
+        }
+    }
+    return false;
+}
+}
+
+// Collects the shortest word, friend of ReedsSheppPath
+class ReedsSheppWords
+{
+public:
+    explicit ReedsSheppWords(ReedsSheppPath &path) : mPath(path) {}
+
+    void offer(std::initializer_list<Segment> types, std::initializer_list<double> lengths)
+    {
+        double length = 0.0;
+        for (const double segmentLength : lengths)
+            length += fabs(segmentLength);
+        if (length >= mLength)
+            return;
+
+        mLength = length;
+        mPath.mValid = true;
+        mPath.mSegmentCount = int(types.size());
+        std::copy(types.begin(), types.end(), mPath.mSegmentTypes.begin());
+        std::copy(lengths.begin(), lengths.end(), mPath.mSegmentLengths.begin());
+    }
+
+    void CSC(double x, double y, double phi)
+    {
+        double t, u, v;
+        if (LpSpLp(x, y, phi, t, u, v))
+            offer({L, S, L}, {t, u, v});
+        if (LpSpLp(-x, y, -phi, t, u, v)) // timeflip
+            offer({L, S, L}, {-t, -u, -v});
+        if (LpSpLp(x, -y, -phi, t, u, v)) // reflect
+            offer({R, S, R}, {t, u, v});
+        if (LpSpLp(-x, -y, phi, t, u, v)) // timeflip + reflect
+            offer({R, S, R}, {-t, -u, -v});
+        if (LpSpRp(x, y, phi, t, u, v))
+            offer({L, S, R}, {t, u, v});
+        if (LpSpRp(-x, y, -phi, t, u, v))
+            offer({L, S, R}, {-t, -u, -v});
+        if (LpSpRp(x, -y, -phi, t, u, v))
+            offer({R, S, L}, {t, u, v});
+        if (LpSpRp(-x, -y, phi, t, u, v))
+            offer({R, S, L}, {-t, -u, -v});
+    }
+
+    void CCC(double x, double y, double phi)
+    {
+        double t, u, v;
+        if (LpRmL(x, y, phi, t, u, v))
+            offer({L, R, L}, {t, u, v});
+        if (LpRmL(-x, y, -phi, t, u, v))
+            offer({L, R, L}, {-t, -u, -v});
+        if (LpRmL(x, -y, -phi, t, u, v))
+            offer({R, L, R}, {t, u, v});
+        if (LpRmL(-x, -y, phi, t, u, v))
+            offer({R, L, R}, {-t, -u, -v});
+
+        // Backwards
+        const double xb = x * cos(phi) + y * sin(phi);
+        const double yb = x * sin(phi) - y * cos(phi);
+        if (LpRmL(xb, yb, phi, t, u, v))
+            offer({L, R, L}, {v, u, t});
+        if (LpRmL(-xb, yb, -phi, t, u, v))
+            offer({L, R, L}, {-v, -u, -t});
+        if (LpRmL(xb, -yb, -phi, t, u, v))
+            offer({R, L, R}, {v, u, t});
+        if (LpRmL(-xb, -yb, phi, t, u, v))
+            offer({R, L, R}, {-v, -u, -t});
+    }
+
+    void CCCC(double x, double y, double phi)
+    {
+        double t, u, v;
+        if (LpRupLumRm(x, y, phi, t, u, v))
+            offer({L, R, L, R}, {t, u, -u, v});
+        if (LpRupLumRm(-x, y, -phi, t, u, v))
+            offer({L, R, L, R}, {-t, -u, u, -v});
+        if (LpRupLumRm(x, -y, -phi, t, u, v))
+            offer({R, L, R, L}, {t, u, -u, v});
+        if (LpRupLumRm(-x, -y, phi, t, u, v))
+            offer({R, L, R, L}, {-t, -u, u, -v});
+
+        if (LpRumLumRp(x, y, phi, t, u, v))
+            offer({L, R, L, R}, {t, u, u, v});
+        if (LpRumLumRp(-x, y, -phi, t, u, v))
+            offer({L, R, L, R}, {-t, -u, -u, -v});
+        if (LpRumLumRp(x, -y, -phi, t, u, v))
+            offer({R, L, R, L}, {t, u, u, v});
+        if (LpRumLumRp(-x, -y, phi, t, u, v))
+            offer({R, L, R, L}, {-t, -u, -u, -v});
+    }
+
+    void CCSC(double x, double y, double phi)
+    {
+        double t, u, v;
+        if (LpRmSmLm(x, y, phi, t, u, v))
+            offer({L, R, S, L}, {t, -0.5 * M_PI, u, v});
+        if (LpRmSmLm(-x, y, -phi, t, u, v))
+            offer({L, R, S, L}, {-t, 0.5 * M_PI, -u, -v});
+        if (LpRmSmLm(x, -y, -phi, t, u, v))
+            offer({R, L, S, R}, {t, -0.5 * M_PI, u, v});
+        if (LpRmSmLm(-x, -y, phi, t, u, v))
+            offer({R, L, S, R}, {-t, 0.5 * M_PI, -u, -v});
+
+        if (LpRmSmRm(x, y, phi, t, u, v))
+            offer({L, R, S, R}, {t, -0.5 * M_PI, u, v});
+        if (LpRmSmRm(-x, y, -phi, t, u, v))
+            offer({L, R, S, R}, {-t, 0.5 * M_PI, -u, -v});
+        if (LpRmSmRm(x, -y, -phi, t, u, v))
+            offer({R, L, S, L}, {t, -0.5 * M_PI, u, v});
+        if (LpRmSmRm(-x, -y, phi, t, u, v))
+            offer({R, L, S, L}, {-t, 0.5 * M_PI, -u, -v});
+
+        // Backwards
+        const double xb = x * cos(phi) + y * sin(phi);
+        const double yb = x * sin(phi) - y * cos(phi);
+        if (LpRmSmLm(xb, yb, phi, t, u, v))
+            offer({L, S, R, L}, {v, u, -0.5 * M_PI, t});
+        if (LpRmSmLm(-xb, yb, -phi, t, u, v))
+            offer({L, S, R, L}, {-v, -u, 0.5 * M_PI, -t});
+        if (LpRmSmLm(xb, -yb, -phi, t, u, v))
+            offer({R, S, L, R}, {v, u, -0.5 * M_PI, t});
+        if (LpRmSmLm(-xb, -yb, phi, t, u, v))
+            offer({R, S, L, R}, {-v, -u, 0.5 * M_PI, -t});
+
+        if (LpRmSmRm(xb, yb, phi, t, u, v))
+            offer({R, S, R, L}, {v, u, -0.5 * M_PI, t});
+        if (LpRmSmRm(-xb, yb, -phi, t, u, v))
+            offer({R, S, R, L}, {-v, -u, 0.5 * M_PI, -t});
+        if (LpRmSmRm(xb, -yb, -phi, t, u, v))
+            offer({L, S, L, R}, {v, u, -0.5 * M_PI, t});
+        if (LpRmSmRm(-xb, -yb, phi, t, u, v))
+            offer({L, S, L, R}, {-v, -u, 0.5 * M_PI, -t});
+    }
+
+    void CCSCC(double x, double y, double phi)
+    {
+        double t, u, v;
+        if (LpRmSLmRp(x, y, phi, t, u, v))
+            offer({L, R, S, L, R}, {t, -0.5 * M_PI, u, -0.5 * M_PI, v});
+        if (LpRmSLmRp(-x, y, -phi, t, u, v))
+            offer({L, R, S, L, R}, {-t, 0.5 * M_PI, -u, 0.5 * M_PI, -v});
+        if (LpRmSLmRp(x, -y, -phi, t, u, v))
+            offer({R, L, S, R, L}, {t, -0.5 * M_PI, u, -0.5 * M_PI, v});
+        if (LpRmSLmRp(-x, -y, phi, t, u, v))
+            offer({R, L, S, R, L}, {-t, 0.5 * M_PI, -u, 0.5 * M_PI, -v});
+    }
+
+private:
+    ReedsSheppPath &mPath;
+    double mLength = std::numeric_limits<double>::infinity();
+};
+
+ReedsSheppPath ReedsSheppPath::getShortest(const QPointF &start, double startYaw_rad, const QPointF &end, double endYaw_rad, double turnRadius_m)
+{
+    ReedsSheppPath path;
+    if (!(turnRadius_m > 0.0))
+        return path;
+
+    // End pose in the frame of the start pose, normalized by the turn radius
+    const QPointF delta = (end - start) / turnRadius_m;
+    const double c = cos(startYaw_rad), s = sin(startYaw_rad);
+    const double x = c * delta.x() + s * delta.y();
+    const double y = -s * delta.x() + c * delta.y();
+    const double phi = endYaw_rad - startYaw_rad;
+
+    ReedsSheppWords words(path);
+    words.CSC(x, y, phi);
+    words.CCC(x, y, phi);
+    words.CCCC(x, y, phi);
+    words.CCSC(x, y, phi);
+    words.CCSCC(x, y, phi);
+
+    path.mStart = start;
+    path.mStartYaw_rad = startYaw_rad;
+    path.mTurnRadius_m = turnRadius_m;
+    return path;
+}
+
+double ReedsSheppPath::getLength() const
+{
+    double length = 0.0;
+    for (int segment = 0; segment < mSegmentCount; segment++)
+        length += fabs(mSegmentLengths[segment]);
+    return length * mTurnRadius_m;
+}
+
+void ReedsSheppPath::getPose(double distance_m, QPointF &position, double &yaw_rad) const
+{
+    // Unit turn radius, scaled at the end
+    double remaining = std::max(distance_m, 0.0) / mTurnRadius_m;
+    double x = 0.0, y = 0.0;
+    double yaw = mStartYaw_rad;
+    for (int segment = 0; segment < mSegmentCount && remaining > 0.0; segment++) {
+        const double length = std::copysign(std::min(remaining, fabs(mSegmentLengths[segment])), mSegmentLengths[segment]);
+        switch (mSegmentTypes[segment]) {
+        case SegmentType::Left:
+            x += sin(yaw + length) - sin(yaw);
+            y += cos(yaw) - cos(yaw + length);
+            yaw += length;
+            break;
+        case SegmentType::Right:
+            x += sin(yaw) - sin(yaw - length);
+            y += cos(yaw - length) - cos(yaw);
+            yaw -= length;
+            break;
+        case SegmentType::Straight:
+            x += length * cos(yaw);
+            y += length * sin(yaw);
+            break;
+        }
+        remaining -= fabs(length);
+    }
+
+    position = mStart + QPointF(x, y) * mTurnRadius_m;
+    yaw_rad = yaw;
+}
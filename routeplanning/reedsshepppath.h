@@ -0,0 +1,48 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Shortest path between two poses for a vehicle with a minimum turn radius that can also reverse (Reeds-Shepp):
+ * up to five segments, each a left turn, right turn or straight at the turn radius, driven forward or reversing.
+ * Closed-form over the word families CSC, CCC, CCCC, CCSC and CCSCC (with their time-flipped, reflected and backwards variants),
+ * as DubinsPath. Yaw in rad (ENU).
+ */
+
+#ifndef REEDSSHEPPPATH_H
+#define REEDSSHEPPPATH_H
+
+#include <QPointF>
+#include <array>
+#include "routeplanning/dubinspath.h"
+
+class ReedsSheppPath
+{
+public:
+    using SegmentType = DubinsPath::SegmentType;
+    static constexpr int MAX_SEGMENTS = 5;
+
+    ReedsSheppPath() = default;
+    // Invalid for turnRadius_m <= 0
+    static ReedsSheppPath getShortest(const QPointF &start, double startYaw_rad, const QPointF &end, double endYaw_rad, double turnRadius_m);
+
+    bool isValid() const { return mValid; }
+    double getLength() const; // [m], reversed segments count positive
+    int getSegmentCount() const { return mSegmentCount; }
+    SegmentType getSegmentType(int segment) const { return mSegmentTypes.at(segment); }
+    double getSegmentLength(int segment) const { return mSegmentLengths.at(segment) * mTurnRadius_m; } // [m], negative: reversing
+    // Pose at distance [0:getLength()] along the path
+    void getPose(double distance_m, QPointF &position, double &yaw_rad) const;
+
+private:
+    friend class ReedsSheppWords;
+
+    bool mValid = false;
+    QPointF mStart;
+    double mStartYaw_rad = 0.0;
+    double mTurnRadius_m = 1.0;
+    int mSegmentCount = 0;
+    std::array<SegmentType, MAX_SEGMENTS> mSegmentTypes {};
+    std::array<double, MAX_SEGMENTS> mSegmentLengths {}; // normalized by the turn radius, i.e., [rad] for turns
+};
+
+#endif // REEDSSHEPPPATH_H
@@ -0,0 +1,361 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routedeconfliction.h"
+#include "core/enureprojector.h"
+#include <QLineF>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+void RouteDeconfliction::setParameters(const RouteDeconflictionParameters &parameters)
+{
+    mParameters = parameters;
+    mParameters.timeStep_s = std::max(mParameters.timeStep_s, 0.01);
+    mParameters.timeBucket_s = std::max(mParameters.timeBucket_s, mParameters.timeStep_s);
+    mParameters.cellSize_m = std::max(mParameters.cellSize_m, 0.1);
+    mParameters.waitStep_s = std::max(mParameters.waitStep_s, 0.01);
+
+    // Keys and radii depend on the parameters
+    setVehicleRoutes(mRoutes);
+}
+
+void RouteDeconfliction::reprojectEnu(const coordinateTransforms::EnuTransform &transform)
+{
+    QMap<int, QVector<pospoint_t>> routes = mRoutes;
+    for (QVector<pospoint_t> &route : routes)
+        EnuReprojector::reprojectPoints(transform, route);
+    setVehicleRoutes(routes);
+}
+
+void RouteDeconfliction::setVehicleRoutes(QMap<int, QVector<pospoint_t>> routes)
+{
+    const QMap<int, QRectF> footprints = mFootprints;
+    const QMap<int, double> startTimes = getStartTimes();
+    clear();
+    for (auto route = routes.cbegin(); route != routes.cend(); ++route)
+        setVehicleRoute(route.key(), route.value(), footprints.value(route.key()), startTimes.value(route.key()));
+}
+
+void RouteDeconfliction::setVehicleRoute(int vehicleId, const QVector<pospoint_t> &route, const QRectF &footprint, double startTime_s)
+{
+    erase(vehicleId);
+    if (route.isEmpty())
+        return;
+
+    mRoutes.insert(vehicleId, route);
+    mFootprints.insert(vehicleId, footprint);
+    Timeline timeline = sampleRoute(route, footprint, startTime_s);
+    timeline.keys.reserve(timeline.samples.size());
+    for (const Sample &sample : timeline.samples) {
+        timeline.keys.append(getKey(sample.center, startTime_s + sample.time_s));
+        mMaxRadius_m = std::max(mMaxRadius_m, sample.radius_m);
+    }
+    insert(mHash, vehicleId, timeline, startTime_s);
+    mTimelines.insert(vehicleId, timeline);
+}
+
+void RouteDeconfliction::removeVehicle(int vehicleId)
+{
+    erase(vehicleId);
+}
+
+void RouteDeconfliction::clear()
+{
+    mTimelines.clear();
+    mRoutes.clear();
+    mFootprints.clear();
+    mHash.clear();
+    mMaxRadius_m = 0.0;
+}
+
+double RouteDeconfliction::getEndTime(int vehicleId) const
+{
+    const auto timeline = mTimelines.constFind(vehicleId);
+    return timeline == mTimelines.cend() ? 0.0 : timeline->startTime_s + timeline->end.time_s;
+}
+
+QVector<RouteConflict> RouteDeconfliction::findConflicts() const
+{
+    QVector<RouteConflict> conflicts;
+    const QMap<int, double> startTimes = getStartTimes();
+    for (auto timeline = mTimelines.cbegin(); timeline != mTimelines.cend(); ++timeline)
+        collectConflicts(timeline.key(), timeline->startTime_s, mHash, startTimes, true, false, &conflicts);
+    mergeConflicts(conflicts, 2.0 * mParameters.timeStep_s);
+    return conflicts;
+}
+
+QVector<RouteConflict> RouteDeconfliction::findConflicts(int vehicleId) const
+{
+    QVector<RouteConflict> conflicts;
+    const auto timeline = mTimelines.constFind(vehicleId);
+    if (timeline != mTimelines.cend())
+        collectConflicts(vehicleId, timeline->startTime_s, mHash, getStartTimes(), false, false, &conflicts);
+    mergeConflicts(conflicts, 2.0 * mParameters.timeStep_s);
+    return conflicts;
+}
+
+QMap<int, double> RouteDeconfliction::proposeStartDelays(const QList<int> &priorityOrder) const
+{
+    QMap<int, double> delays;
+    QMap<int, double> startTimes; // of the vehicles placed so far
+    SampleHash hash;
+
+    for (const int vehicleId : priorityOrder) {
+        const auto timeline = mTimelines.constFind(vehicleId);
+        if (timeline == mTimelines.cend() || startTimes.contains(vehicleId))
+            continue;
+
+        double delay_s = -1.0;
+        for (double candidate_s = 0.0; candidate_s <= mParameters.maxWait_s + 1e-9; candidate_s += mParameters.waitStep_s) {
+            if (!collectConflicts(vehicleId, timeline->startTime_s + candidate_s, hash, startTimes, false, true, nullptr)) {
+                delay_s = candidate_s;
+                break;
+            }
+        }
+
+        delays.insert(vehicleId, delay_s);
+        if (delay_s >= 0.0) {
+            startTimes.insert(vehicleId, timeline->startTime_s + delay_s);
+            insert(hash, vehicleId, *timeline, timeline->startTime_s + delay_s);
+        }
+    }
+
+    return delays;
+}
+
+RouteDeconfliction::Timeline RouteDeconfliction::sampleRoute(const QVector<pospoint_t> &route, const QRectF &footprint, double startTime_s) const
+{
+    Timeline timeline;
+    timeline.startTime_s = startTime_s;
+
+    const QPointF footprintCenter = footprint.center();
+    const double footprintRadius_m = 0.5 * hypot(footprint.width(), footprint.height()) + mParameters.margin_m;
+    auto center = [&footprintCenter](const QPointF &position, double yaw_rad) {
+        return position + QPointF(cos(yaw_rad) * footprintCenter.x() - sin(yaw_rad) * footprintCenter.y(),
+                                  sin(yaw_rad) * footprintCenter.x() + cos(yaw_rad) * footprintCenter.y());
+    };
+
+    double yaw_rad = route.size() > 1 ? atan2(route.at(1).y - route.first().y, route.at(1).x - route.first().x) : 0.0;
+    timeline.start = {center(route.first().getPoint(), yaw_rad), footprintRadius_m, 0.0};
+
+    const double dt = mParameters.timeStep_s;
+    double time_s = 0.0;
+    double nextSample_s = 0.0;
+    for (int i = 1; i < route.size(); i++) {
+        const pospoint_t &from = route.at(i - 1);
+        const pospoint_t &to = route.at(i);
+        const double length_m = from.getDistanceTo(to);
+        if (length_m <= 0.0)
+            continue;
+
+        const double speed_ms = fabs(to.speed) > 1e-3 ? fabs(to.speed) : mParameters.defaultSpeed_ms;
+        const double duration_s = length_m / speed_ms;
+        yaw_rad = atan2(to.y - from.y, to.x - from.x);
+        if (to.speed < 0.0)
+            yaw_rad += M_PI; // reversing
+
+        // Discs cover the distance driven within a step
+        const double radius_m = footprintRadius_m + 0.5 * speed_ms * dt;
+        for (; nextSample_s <= time_s + duration_s; nextSample_s += dt) {
+            const double fraction = (nextSample_s - time_s) / duration_s;
+            const QPointF position = from.getPoint() + fraction * (to.getPoint() - from.getPoint());
+            timeline.samples.append({center(position, yaw_rad), radius_m, nextSample_s});
+        }
+        time_s += duration_s;
+    }
+
+    timeline.end = {center(route.last().getPoint(), yaw_rad), footprintRadius_m, time_s};
+    return timeline;
+}
+
+quint64 RouteDeconfliction::getKey(qint64 cellX, qint64 cellY, qint64 timeBucket) const
+{
+    // 21 bits per cell coordinate, 22 bits for the time bucket
+    return (quint64(cellX & 0x1FFFFF) << 43) | (quint64(cellY & 0x1FFFFF) << 22) | quint64(timeBucket & 0x3FFFFF);
+}
+
+quint64 RouteDeconfliction::getKey(const QPointF &position, double time_s) const
+{
+    return getKey(qint64(floor(position.x() / mParameters.cellSize_m)), qint64(floor(position.y() / mParameters.cellSize_m)),
+                  qint64(floor(time_s / mParameters.timeBucket_s)));
+}
+
+void RouteDeconfliction::insert(SampleHash &hash, int vehicleId, const Timeline &timeline, double startTime_s) const
+{
+    for (int i = 0; i < timeline.samples.size(); i++)
+        hash[getKey(timeline.samples.at(i).center, startTime_s + timeline.samples.at(i).time_s)].append({vehicleId, i});
+}
+
+void RouteDeconfliction::erase(int vehicleId)
+{
+    const auto timeline = mTimelines.constFind(vehicleId);
+    if (timeline == mTimelines.cend())
+        return;
+
+    for (const quint64 key : timeline->keys) {
+        auto cell = mHash.find(key);
+        if (cell == mHash.end())
+            continue;
+        cell->erase(std::remove_if(cell->begin(), cell->end(), [vehicleId](const SampleRef &ref) { return ref.vehicleId == vehicleId; }), cell->end());
+        if (cell->isEmpty())
+            mHash.erase(cell);
+    }
+
+    mTimelines.remove(vehicleId);
+    mRoutes.remove(vehicleId);
+    mFootprints.remove(vehicleId);
+}
+
+QMap<int, double> RouteDeconfliction::getStartTimes() const
+{
+    QMap<int, double> startTimes;
+    for (auto timeline = mTimelines.cbegin(); timeline != mTimelines.cend(); ++timeline)
+        startTimes.insert(timeline.key(), timeline->startTime_s);
+    return startTimes;
+}
+
+bool RouteDeconfliction::addConflict(int vehicleId1, int vehicleId2, double time_s, const QPointF &position1, const QPointF &position2,
+                                     QVector<RouteConflict> *conflicts) const
+{
+    if (conflicts) {
+        RouteConflict conflict;
+        conflict.vehicleId1 = std::min(vehicleId1, vehicleId2);
+        conflict.vehicleId2 = std::max(vehicleId1, vehicleId2);
+        conflict.startTime_s = time_s;
+        conflict.endTime_s = time_s;
+        conflict.position = (position1 + position2) / 2.0;
+        conflicts->append(conflict);
+    }
+    return true;
+}
+
+bool RouteDeconfliction::collectConflicts(int vehicleId, double startTime_s, const SampleHash &hash, const QMap<int, double> &startTimes,
+                                          bool onlyHigherIds, bool stopAtFirst, QVector<RouteConflict> *conflicts) const
+{
+    const Timeline &timeline = *mTimelines.constFind(vehicleId); // constFind: the const operator[] returns a copy
+    const double dt = mParameters.timeStep_s;
+    const double endTime_s = startTime_s + timeline.end.time_s;
+    bool found = false;
+    auto isOther = [vehicleId, onlyHigherIds](int otherId) { return otherId != vehicleId && (!onlyHigherIds || otherId > vehicleId); };
+    auto overlaps = [](const Sample &a, const Sample &b) { return QLineF(a.center, b.center).length() < a.radius_m + b.radius_m; };
+
+    // Moving samples of the other vehicles close to the disc within [from_s, to_s] (absolute)
+    auto queryHash = [&](const Sample &sample, double from_s, double to_s, const std::function<bool(int, const Sample&, double)> &onSample) {
+        const qint64 range = qint64(ceil((sample.radius_m + mMaxRadius_m) / mParameters.cellSize_m));
+        const qint64 cellX = qint64(floor(sample.center.x() / mParameters.cellSize_m));
+        const qint64 cellY = qint64(floor(sample.center.y() / mParameters.cellSize_m));
+        const qint64 firstBucket = qint64(floor(from_s / mParameters.timeBucket_s));
+        const qint64 lastBucket = qint64(floor(to_s / mParameters.timeBucket_s));
+        for (qint64 bucket = firstBucket; bucket <= lastBucket; bucket++)
+            for (qint64 x = cellX - range; x <= cellX + range; x++)
+                for (qint64 y = cellY - range; y <= cellY + range; y++) {
+                    const auto cell = hash.constFind(getKey(x, y, bucket));
+                    if (cell == hash.cend())
+                        continue;
+                    for (const SampleRef &ref : *cell) {
+                        if (!isOther(ref.vehicleId) || !startTimes.contains(ref.vehicleId))
+                            continue;
+                        const Sample &other = mTimelines.constFind(ref.vehicleId)->samples.at(ref.sampleIndex);
+                        const double otherTime_s = startTimes.value(ref.vehicleId) + other.time_s;
+                        if (otherTime_s >= from_s && otherTime_s <= to_s && overlaps(sample, other) && onSample(ref.vehicleId, other, otherTime_s))
+                            return true;
+                    }
+                }
+        return false;
+    };
+
+    // 1. Moving vs. moving
+    for (const Sample &sample : timeline.samples) {
+        const double time_s = startTime_s + sample.time_s;
+        if (queryHash(sample, time_s - dt, time_s + dt, [&](int otherId, const Sample &other, double otherTime_s) {
+                     found = addConflict(vehicleId, otherId, std::max(time_s, otherTime_s), sample.center, other.center, conflicts);
+                     return stopAtFirst;
+                 }))
+            return true;
+    }
+
+    if (!mParameters.occupyStartAndEndPositions)
+        return found;
+
+    double minTime_s = startTime_s, maxTime_s = endTime_s;
+    for (auto otherStart = startTimes.cbegin(); otherStart != startTimes.cend(); ++otherStart) {
+        minTime_s = std::min(minTime_s, otherStart.value());
+        maxTime_s = std::max(maxTime_s, otherStart.value() + mTimelines.constFind(otherStart.key())->end.time_s);
+    }
+
+    for (auto otherStart = startTimes.cbegin(); otherStart != startTimes.cend(); ++otherStart) {
+        const int otherId = otherStart.key();
+        if (!isOther(otherId))
+            continue;
+        const Timeline &other = *mTimelines.constFind(otherId);
+        const double otherStartTime_s = otherStart.value();
+        const double otherEndTime_s = otherStartTime_s + other.end.time_s;
+
+        // 2. Moving vs. the other one waiting or parked
+        for (const Sample &sample : timeline.samples) {
+            const double time_s = startTime_s + sample.time_s;
+            const Sample *otherStatic = (time_s < otherStartTime_s) ? &other.start : (time_s > otherEndTime_s) ? &other.end : nullptr;
+            if (otherStatic && overlaps(sample, *otherStatic)) {
+                found = addConflict(vehicleId, otherId, time_s, sample.center, otherStatic->center, conflicts);
+                if (stopAtFirst)
+                    return true;
+            }
+        }
+
+        // 4. Waiting or parked vs. waiting or parked
+        const Sample *statics[2] = {&timeline.start, &timeline.end};
+        const double staticFrom_s[2] = {minTime_s, endTime_s};
+        const double staticTo_s[2] = {startTime_s, maxTime_s};
+        const Sample *otherStatics[2] = {&other.start, &other.end};
+        const double otherStaticFrom_s[2] = {minTime_s, otherEndTime_s};
+        const double otherStaticTo_s[2] = {otherStartTime_s, maxTime_s};
+        for (int i = 0; i < 2; i++)
+            for (int j = 0; j < 2; j++) {
+                const double from_s = std::max(staticFrom_s[i], otherStaticFrom_s[j]);
+                if (from_s < std::min(staticTo_s[i], otherStaticTo_s[j]) && overlaps(*statics[i], *otherStatics[j])) {
+                    found = addConflict(vehicleId, otherId, from_s, statics[i]->center, otherStatics[j]->center, conflicts);
+                    if (stopAtFirst)
+                        return true;
+                }
+            }
+    }
+
+    // 3. Waiting or parked vs. the others moving
+    const Sample *statics[2] = {&timeline.start, &timeline.end};
+    const double staticFrom_s[2] = {minTime_s, endTime_s};
+    const double staticTo_s[2] = {startTime_s, maxTime_s};
+    for (int i = 0; i < 2; i++) {
+        if (staticFrom_s[i] >= staticTo_s[i])
+            continue;
+        if (queryHash(*statics[i], staticFrom_s[i], staticTo_s[i], [&](int otherId, const Sample &other, double otherTime_s) {
+                     found = addConflict(vehicleId, otherId, otherTime_s, statics[i]->center, other.center, conflicts);
+                     return stopAtFirst;
+                 }))
+            return true;
+    }
+
+    return found;
+}
+
+void RouteDeconfliction::mergeConflicts(QVector<RouteConflict> &conflicts, double maxGap_s)
+{
+    std::sort(conflicts.begin(), conflicts.end(), [](const RouteConflict &a, const RouteConflict &b) {
+        if (a.vehicleId1 != b.vehicleId1)
+            return a.vehicleId1 < b.vehicleId1;
+        if (a.vehicleId2 != b.vehicleId2)
+            return a.vehicleId2 < b.vehicleId2;
+        return a.startTime_s < b.startTime_s;
+    });
+
+    QVector<RouteConflict> merged;
+    for (const RouteConflict &conflict : conflicts) {
+        if (!merged.isEmpty() && merged.last().vehicleId1 == conflict.vehicleId1 && merged.last().vehicleId2 == conflict.vehicleId2 &&
+                conflict.startTime_s <= merged.last().endTime_s + maxGap_s)
+            merged.last().endTime_s = std::max(merged.last().endTime_s, conflict.endTime_s);
+        else
+            merged.append(conflict);
+    }
+    conflicts = merged;
+}
@@ -0,0 +1,109 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Space-time conflicts between the routes of several vehicles, e.g., of all vehicles of a MavsdkStation before they are sent.
+ * Each route becomes a timeline along its arc length from the speed of its points (a point's speed applies to the segment
+ * ending at it, as for PurepursuitWaypointFollower), sampled every timeStep as discs around the footprint that cover the
+ * distance driven within the step. Samples are kept in a spatial hash over time buckets: changing one route only re-samples
+ * that route and finds its conflicts in O(its samples), independent of the other routes' lengths.
+ * Vehicles wait at their first point before their start time and stay at their last one (occupyStartAndEndPositions).
+ * Conflicts can be resolved by start delays (proposeStartDelays), in priority order.
+ */
+
+#ifndef ROUTEDECONFLICTION_H
+#define ROUTEDECONFLICTION_H
+
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include "core/pospoint.h"
+
+struct RouteDeconflictionParameters {
+    double timeStep_s = 0.25; // sampling of the timelines
+    double timeBucket_s = 2.0; // of the hash, >= timeStep_s
+    double cellSize_m = 4.0; // of the hash, ideally about the diameter of the largest sample disc
+    double margin_m = 0.3; // added around the footprints
+    double defaultSpeed_ms = 1.0; // route points without speed
+    bool occupyStartAndEndPositions = true;
+    double waitStep_s = 1.0; // resolution of proposed start delays
+    double maxWait_s = 300.0;
+};
+
+struct RouteConflict {
+    int vehicleId1 = -1; // vehicleId1 < vehicleId2
+    int vehicleId2 = -1;
+    double startTime_s = 0.0; // relative to the common start
+    double endTime_s = 0.0;
+    QPointF position; // between the vehicles at startTime_s [m]
+};
+
+class RouteDeconfliction
+{
+public:
+    void setParameters(const RouteDeconflictionParameters &parameters); // re-samples all routes
+    RouteDeconflictionParameters getParameters() const { return mParameters; }
+
+    // footprint in the vehicle frame (x forward, y left) [m], e.g., MovementController::getFootprint.
+    // startTime_s relative to the common start. Replaces the vehicle's previous route.
+    void setVehicleRoute(int vehicleId, const QVector<pospoint_t> &route, const QRectF &footprint, double startTime_s = 0.0);
+    void removeVehicle(int vehicleId);
+    void clear();
+    QList<int> getVehicleIds() const { return mTimelines.keys(); }
+    double getEndTime(int vehicleId) const; // arrival at the last point, relative to the common start
+
+    // Routes (re-sampled) to another ENU reference, see EnuReprojector
+    void reprojectEnu(const coordinateTransforms::EnuTransform &transform);
+
+    QVector<RouteConflict> findConflicts() const; // all pairs
+    QVector<RouteConflict> findConflicts(int vehicleId) const; // pairs with vehicleId, e.g., after changing its route
+
+    // Start delays [s] by vehicle ID (added to their start times) so that no vehicle conflicts with one before it in priorityOrder.
+    // -1: no delay up to maxWait_s avoids the conflicts, the vehicle is then ignored for the following ones.
+    QMap<int, double> proposeStartDelays(const QList<int> &priorityOrder) const;
+
+private:
+    struct Sample {
+        QPointF center; // of the footprint [m]
+        double radius_m;
+        double time_s; // relative to the vehicle's start, covers [time_s - timeStep_s / 2, time_s + timeStep_s / 2]
+    };
+    struct Timeline {
+        QVector<Sample> samples;
+        QVector<quint64> keys; // hash key per sample
+        Sample start; // waiting before the start
+        Sample end; // staying after the end, time_s: arrival
+        double startTime_s = 0.0;
+    };
+    struct SampleRef {
+        int vehicleId;
+        int sampleIndex;
+    };
+    typedef QHash<quint64, QVector<SampleRef>> SampleHash;
+
+    void setVehicleRoutes(QMap<int, QVector<pospoint_t>> routes); // keeps footprints and start times, copy: replaces mRoutes
+    Timeline sampleRoute(const QVector<pospoint_t> &route, const QRectF &footprint, double startTime_s) const;
+    quint64 getKey(const QPointF &position, double time_s) const;
+    quint64 getKey(qint64 cellX, qint64 cellY, qint64 timeBucket) const;
+    void insert(SampleHash &hash, int vehicleId, const Timeline &timeline, double startTime_s) const;
+    void erase(int vehicleId);
+    // Conflicts of the vehicle with the other timelines (with their start times) in the hash, only those with IDs above
+    // the vehicle's if onlyHigherIds. stopAtFirst: returns as soon as one is found.
+    bool collectConflicts(int vehicleId, double startTime_s, const SampleHash &hash, const QMap<int, double> &startTimes,
+                          bool onlyHigherIds, bool stopAtFirst, QVector<RouteConflict> *conflicts) const;
+    QMap<int, double> getStartTimes() const;
+    bool addConflict(int vehicleId1, int vehicleId2, double time_s, const QPointF &position1, const QPointF &position2, QVector<RouteConflict> *conflicts) const;
+    static void mergeConflicts(QVector<RouteConflict> &conflicts, double maxGap_s);
+
+    RouteDeconflictionParameters mParameters;
+    QMap<int, Timeline> mTimelines;
+    QMap<int, QVector<pospoint_t>> mRoutes; // for re-sampling with new parameters
+    QMap<int, QRectF> mFootprints;
+    SampleHash mHash;
+    double mMaxRadius_m = 0.0; // of all samples, grows only (until clear or setParameters)
+};
+
+#endif // ROUTEDECONFLICTION_H
@@ -0,0 +1,246 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routegenerationservice.h"
+#include "routeplanning/zigzagroutegenerator.h"
+#include "routeplanning/coverageplanner.h"
+#include <QThread>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QXmlStreamWriter>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace {
+bool readRing(const QJsonArray &coordinates, QVector<llh_t> &ring)
+{
+    ring.clear();
+    for (const auto &position : coordinates) {
+        const QJsonArray lonLat = position.toArray();
+        if (lonLat.size() < 2 || !lonLat.at(0).isDouble() || !lonLat.at(1).isDouble())
+            return false;
+        ring.append({lonLat.at(1).toDouble(), lonLat.at(0).toDouble(), lonLat.size() > 2 ? lonLat.at(2).toDouble() : 0.0});
+    }
+
+    // Linear rings are closed in GeoJSON
+    if (ring.size() > 1 && ring.first().latitude == ring.last().latitude && ring.first().longitude == ring.last().longitude)
+        ring.removeLast();
+    return ring.size() >= 3;
+}
+
+bool readPolygon(const QJsonArray &rings, const QString &name, QList<RouteGenerationField> &fields)
+{
+    RouteGenerationField field;
+    field.name = name;
+    for (int i = 0; i < rings.size(); i++) {
+        QVector<llh_t> ring;
+        if (!readRing(rings.at(i).toArray(), ring))
+            return false;
+        if (i == 0)
+            field.bounds = ring;
+        else
+            field.holes.append(ring);
+    }
+
+    if (field.bounds.isEmpty())
+        return false;
+    fields.append(field);
+    return true;
+}
+
+bool readGeometry(const QJsonObject &geometry, const QString &name, QList<RouteGenerationField> &fields, QString &error)
+{
+    const QString type = geometry.value("type").toString();
+    const QJsonArray coordinates = geometry.value("coordinates").toArray();
+    if (type == "Polygon") {
+        if (!readPolygon(coordinates, name, fields)) {
+            error = "invalid polygon " + name;
+            return false;
+        }
+    } else if (type == "MultiPolygon") {
+        for (int i = 0; i < coordinates.size(); i++) {
+            const QString polygonName = coordinates.size() > 1 ? QString("%1#%2").arg(name).arg(i) : name;
+            if (!readPolygon(coordinates.at(i).toArray(), polygonName, fields)) {
+                error = "invalid polygon " + polygonName;
+                return false;
+            }
+        }
+    } else if (type == "GeometryCollection") {
+        const QJsonArray geometries = geometry.value("geometries").toArray();
+        for (int i = 0; i < geometries.size(); i++)
+            if (!readGeometry(geometries.at(i).toObject(), geometries.size() > 1 ? QString("%1#%2").arg(name).arg(i) : name, fields, error))
+                return false;
+    } // other geometries (points, lines) are no fields
+
+    return true;
+}
+
+QList<PosPoint> toEnu(const QVector<llh_t> &ring, const EnuFrame &enuFrame)
+{
+    QList<PosPoint> points;
+    for (const llh_t &llh : ring) {
+        const xyz_t xyz = enuFrame.llhToEnu(llh);
+        points.append(PosPoint(xyz.x, xyz.y, xyz.z));
+    }
+    return points;
+}
+}
+
+RouteGenerationService::RouteGenerationService()
+{
+
+}
+
+void RouteGenerationService::setThreadCount(int threadCount)
+{
+    mThreadCount = std::max(threadCount, 0);
+}
+
+void RouteGenerationService::setEnuRef(const llh_t &enuRef)
+{
+    mEnuRef = enuRef;
+    mHasEnuRef = true;
+}
+
+QVector<RouteGenerationResult> RouteGenerationService::run(const QList<RouteGenerationField> &fields) const
+{
+    QVector<RouteGenerationResult> results(fields.size());
+    const int threadCount = std::min(mThreadCount > 0 ? mThreadCount : QThread::idealThreadCount(), fields.size());
+
+    // Fields differ a lot in size, threads take the next one when done instead of getting fixed shards
+    std::atomic<int> nextField{0};
+    auto worker = [&]() {
+        for (int i = nextField++; i < fields.size(); i = nextField++) {
+            const RouteGenerationField &field = fields.at(i);
+            const llh_t enuRef = mHasEnuRef || field.bounds.isEmpty() ? mEnuRef : field.bounds.first();
+            results[i] = generate(field, enuRef, mParameters);
+        }
+    };
+
+    std::vector<std::unique_ptr<QThread>> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(QThread::create(worker));
+        threads.back()->start();
+    }
+    for (auto &thread : threads)
+        thread->wait();
+
+    return results;
+}
+
+RouteGenerationResult RouteGenerationService::generate(const RouteGenerationField &field, const llh_t &enuRef, const RouteGenerationParameters &parameters)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    RouteGenerationResult result;
+    result.name = field.name;
+    result.enuRef = enuRef;
+
+    const EnuFrame enuFrame(enuRef);
+    QList<QList<PosPoint>> holes;
+    for (const auto &hole : field.holes)
+        holes.append(toEnu(hole, enuFrame));
+    result.route = generateRoute(toEnu(field.bounds, enuFrame), holes, parameters);
+
+    result.generated = !result.route.isEmpty();
+    for (int i = 1; i < result.route.size(); i++)
+        result.routeLength_m += result.route.at(i - 1).getDistanceTo(result.route.at(i));
+    result.generationTime_ms = timer.nsecsElapsed() / 1e6;
+    return result;
+}
+
+QList<PosPoint> RouteGenerationService::generateRoute(const QList<PosPoint> &bounds, const QList<QList<PosPoint>> &holes, const RouteGenerationParameters &parameters)
+{
+    if (bounds.size() < 3 || parameters.spacing <= 0.0)
+        return {};
+
+    const RouteGenerationParameters &p = parameters;
+    switch (p.pattern) {
+    case RoutePattern::ZIGZAG:
+        return ZigZagRouteGenerator::fillConvexPolygonWithZigZag(bounds, p.spacing, p.keepTurnsInBounds, p.speed, p.speedInTurns, p.turnIntermediateSteps, p.visitEveryX,
+                                                                 p.setAttributesOnStraights, p.setAttributesInTurns, p.attributeDistanceAfterTurn, p.attributeDistanceBeforeTurn);
+    case RoutePattern::FRAMED_ZIGZAG:
+        return ZigZagRouteGenerator::fillConvexPolygonWithFramedZigZag(bounds, p.spacing, p.keepTurnsInBounds, p.speed, p.speedInTurns, p.turnIntermediateSteps, p.visitEveryX,
+                                                                       p.setAttributesOnStraights, p.setAttributesInTurns, p.attributeDistanceAfterTurn, p.attributeDistanceBeforeTurn, p.frameCount);
+    case RoutePattern::CURVED_ZIGZAG:
+        return ZigZagRouteGenerator::fillConvexPolygonWithCurvedZigZag(bounds, p.spacing, p.minTurnRadius, p.allowReverse, p.lateralTolerance, p.speed, p.speedInTurns, p.visitEveryX,
+                                                                       p.setAttributesOnStraights, p.setAttributesInTurns, p.attributeDistanceAfterTurn, p.attributeDistanceBeforeTurn);
+    case RoutePattern::COVERAGE:
+        return CoveragePlanner::fillPolygonWithZigZag(bounds, holes, p.spacing, p.keepTurnsInBounds, p.speed, p.speedInTurns, p.turnIntermediateSteps, p.visitEveryX,
+                                                      p.setAttributesOnStraights, p.setAttributesInTurns, p.attributeDistanceAfterTurn, p.attributeDistanceBeforeTurn);
+    }
+    return {};
+}
+
+bool RouteGenerationService::readGeoJsonFields(const QByteArray &geoJson, QList<RouteGenerationField> &fields, QString *error)
+{
+    fields.clear();
+    QString readError;
+    QJsonParseError parseError;
+    const QJsonObject root = QJsonDocument::fromJson(geoJson, &parseError).object();
+    if (parseError.error != QJsonParseError::NoError)
+        readError = parseError.errorString();
+    else if (root.value("type").toString() == "FeatureCollection") {
+        const QJsonArray features = root.value("features").toArray();
+        for (int i = 0; i < features.size() && readError.isEmpty(); i++) {
+            const QJsonObject feature = features.at(i).toObject();
+            QString name = feature.value("properties").toObject().value("name").toVariant().toString();
+            if (name.isEmpty())
+                name = feature.value("id").toVariant().toString();
+            if (name.isEmpty())
+                name = QString::number(i);
+            readGeometry(feature.value("geometry").toObject(), name, fields, readError);
+        }
+    } else if (root.value("type").toString() == "Feature") {
+        const QString name = root.value("properties").toObject().value("name").toVariant().toString();
+        readGeometry(root.value("geometry").toObject(), name.isEmpty() ? "0" : name, fields, readError);
+    } else
+        readGeometry(root, "0", fields, readError);
+
+    if (!readError.isEmpty()) {
+        fields.clear();
+        if (error)
+            *error = readError;
+        return false;
+    }
+    return true;
+}
+
+QByteArray RouteGenerationService::encodeRoutesXml(const QList<QList<PosPoint>> &routes, const llh_t &enuRef)
+{
+    QByteArray xml;
+    QXmlStreamWriter stream(&xml);
+    stream.setCodec("UTF-8");
+    stream.setAutoFormatting(true);
+    stream.writeStartDocument();
+    stream.writeStartElement("routes");
+
+    stream.writeStartElement("enuref");
+    stream.writeTextElement("Latitude", QString::number(enuRef.latitude, 'g', 49));
+    stream.writeTextElement("Longitude", QString::number(enuRef.longitude, 'g', 49));
+    stream.writeTextElement("Height", QString::number(enuRef.height, 'g', 49));
+    stream.writeEndElement();
+
+    for (const auto &route : routes) {
+        stream.writeStartElement("route");
+        for (const PosPoint &point : route) {
+            stream.writeStartElement("point");
+            stream.writeTextElement("x", QString::number(point.getX()));
+            stream.writeTextElement("y", QString::number(point.getY()));
+            stream.writeTextElement("z", QString::number(point.getHeight()));
+            stream.writeTextElement("speed", QString::number(point.getSpeed()));
+            stream.writeTextElement("attributes", QString::number(point.getAttributes()));
+            stream.writeEndElement();
+        }
+        stream.writeEndElement();
+    }
+
+    stream.writeEndElement();
+    stream.writeEndDocument();
+    return xml;
+}
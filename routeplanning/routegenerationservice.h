@@ -0,0 +1,87 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Headless route generation for many fields at once, e.g., batch planning of the fields of a GIS export (tools/route_generator).
+ * Fields are read from GeoJSON (WGS84 lon/lat) and converted to ENU, routes are generated with the planners of RouteGeneratorZigZagUI
+ * (ZigZagRouteGenerator) or CoveragePlanner (non-convex fields and holes). Fields are distributed over worker threads,
+ * each field is generated on one thread from start to end. Results only depend on the field and the parameters.
+ */
+
+#ifndef ROUTEGENERATIONSERVICE_H
+#define ROUTEGENERATIONSERVICE_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "core/pospoint.h"
+
+enum class RoutePattern {ZIGZAG, FRAMED_ZIGZAG, CURVED_ZIGZAG, COVERAGE};
+
+struct RouteGenerationParameters {
+    RoutePattern pattern = RoutePattern::ZIGZAG; // the zig-zags assume convex fields and ignore holes
+    double spacing = 2.0;
+    bool keepTurnsInBounds = false;
+    double speed = 1.0;
+    double speedInTurns = 0.5;
+    int turnIntermediateSteps = 10;
+    int visitEveryX = 0;
+    uint32_t setAttributesOnStraights = 0;
+    uint32_t setAttributesInTurns = 0;
+    double attributeDistanceAfterTurn = 0.0;
+    double attributeDistanceBeforeTurn = 0.0;
+    int frameCount = 1; // FRAMED_ZIGZAG
+    double minTurnRadius = 3.0; // CURVED_ZIGZAG
+    bool allowReverse = false;
+    double lateralTolerance = 0.05;
+};
+
+struct RouteGenerationField {
+    QString name;
+    QVector<llh_t> bounds; // not closed
+    QVector<QVector<llh_t>> holes;
+};
+
+struct RouteGenerationResult {
+    QString name;
+    bool generated = false; // false: no route fits into the field (e.g., narrower than spacing)
+    llh_t enuRef = {0.0, 0.0, 0.0};
+    QList<PosPoint> route; // ENU of enuRef
+    double generationTime_ms = 0.0;
+    double routeLength_m = 0.0;
+};
+
+class RouteGenerationService
+{
+public:
+    RouteGenerationService();
+
+    const RouteGenerationParameters &getParameters() const { return mParameters; }
+    void setParameters(const RouteGenerationParameters &parameters) { mParameters = parameters; }
+    int getThreadCount() const { return mThreadCount; }
+    void setThreadCount(int threadCount); // 0: QThread::idealThreadCount()
+    // Common ENU reference of all routes, e.g., for a single route file. Otherwise, each field's first vertex is its reference.
+    void setEnuRef(const llh_t &enuRef);
+    void clearEnuRef() { mHasEnuRef = false; }
+
+    // Results are in the order of the fields, blocks until all fields are done
+    QVector<RouteGenerationResult> run(const QList<RouteGenerationField> &fields) const;
+    static RouteGenerationResult generate(const RouteGenerationField &field, const llh_t &enuRef, const RouteGenerationParameters &parameters);
+    static QList<PosPoint> generateRoute(const QList<PosPoint> &bounds, const QList<QList<PosPoint>> &holes, const RouteGenerationParameters &parameters);
+
+    // Polygons and MultiPolygons of a GeoJSON FeatureCollection, Feature or geometry, each polygon is a field with the interior rings as holes.
+    // Fields are named by the feature's "name" property (or its id, or its index), with "#n" for the polygons of a MultiPolygon.
+    // Returns false (and the reason in error) if geoJson is not valid GeoJSON.
+    static bool readGeoJsonFields(const QByteArray &geoJson, QList<RouteGenerationField> &fields, QString *error = nullptr);
+    // XML route file as exported by PlanUI
+    static QByteArray encodeRoutesXml(const QList<QList<PosPoint>> &routes, const llh_t &enuRef);
+
+private:
+    RouteGenerationParameters mParameters;
+    int mThreadCount = 0;
+    bool mHasEnuRef = false;
+    llh_t mEnuRef = {0.0, 0.0, 0.0};
+};
+
+#endif // ROUTEGENERATIONSERVICE_H
@@ -0,0 +1,185 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routeprocessing.h"
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+
+namespace routeProcessing {
+
+namespace {
+// The speed or attributes change at point index, i.e., from the segment before it
+bool isChangePoint(const QVector<pospoint_t> &route, int index)
+{
+    return index > 0 && (route.at(index).speed != route.at(index - 1).speed || route.at(index).attributes != route.at(index - 1).attributes);
+}
+
+double distanceToSegment(const pospoint_t &point, const pospoint_t &start, const pospoint_t &end)
+{
+    const double dx = end.x - start.x;
+    const double dy = end.y - start.y;
+    const double lengthSquared = dx * dx + dy * dy;
+    const double t = lengthSquared > 0.0 ? std::max(0.0, std::min(1.0, ((point.x - start.x) * dx + (point.y - start.y) * dy) / lengthSquared)) : 0.0;
+    return std::hypot(point.x - (start.x + t * dx), point.y - (start.y + t * dy));
+}
+
+// Fields of start, with position, height and timestamp interpolated
+pospoint_t interpolate(const pospoint_t &start, const pospoint_t &end, double fraction)
+{
+    pospoint_t point = start;
+    point.x = start.x + (end.x - start.x) * fraction;
+    point.y = start.y + (end.y - start.y) * fraction;
+    point.height = start.height + (end.height - start.height) * fraction;
+    if (start.timestamp_ns != utcTime::INVALID && end.timestamp_ns != utcTime::INVALID)
+        point.timestamp_ns = start.timestamp_ns + qint64((end.timestamp_ns - start.timestamp_ns) * fraction);
+    return point;
+}
+
+// Douglas-Peucker between first and last (both kept)
+void simplifyRun(const QVector<pospoint_t> &route, int first, int last, double tolerance_m, QVector<bool> &keep)
+{
+    QVector<QPair<int, int>> ranges = {{first, last}};
+    while (!ranges.isEmpty()) {
+        const QPair<int, int> range = ranges.takeLast();
+        double maxDistance = 0.0;
+        int maxIndex = -1;
+        for (int i = range.first + 1; i < range.second; i++) {
+            const double distance = distanceToSegment(route.at(i), route.at(range.first), route.at(range.second));
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                maxIndex = i;
+            }
+        }
+
+        if (maxDistance > tolerance_m) {
+            keep[maxIndex] = true;
+            ranges.append({range.first, maxIndex});
+            ranges.append({maxIndex, range.second});
+        }
+    }
+}
+}
+
+QVector<pospoint_t> simplify(const QVector<pospoint_t> &route, double tolerance_m)
+{
+    if (route.size() < 3)
+        return route;
+
+    // Runs end at points to keep anyway and are bounded in length, which bounds the quadratic worst case of Douglas-Peucker
+    QVector<bool> keep(route.size(), false);
+    keep.first() = true;
+    keep.last() = true;
+    int runStart = 0;
+    for (int i = 1; i < route.size(); i++) {
+        if (i == route.size() - 1 || isChangePoint(route, i) || i - runStart >= SIMPLIFY_MAX_RUN_POINTS) {
+            keep[i] = true;
+            simplifyRun(route, runStart, i, tolerance_m, keep);
+            runStart = i;
+        }
+    }
+
+    QVector<pospoint_t> simplified;
+    simplified.reserve(std::count(keep.begin(), keep.end(), true));
+    for (int i = 0; i < route.size(); i++)
+        if (keep.at(i))
+            simplified.append(route.at(i));
+    return simplified;
+}
+
+QList<PosPoint> simplify(const QList<PosPoint> &route, double tolerance_m)
+{
+    return PosPoint::fromPODList(simplify(PosPoint::toPODList(route), tolerance_m));
+}
+
+QVector<pospoint_t> resample(const QVector<pospoint_t> &route, double spacing_m)
+{
+    if (route.size() < 2 || spacing_m <= 0.0)
+        return route;
+
+    QVector<pospoint_t> resampled = {route.first()};
+    double sinceLastPoint = 0.0; // distance along the route from the last resampled point to the start of the segment
+    for (int i = 0; i + 1 < route.size(); i++) {
+        const pospoint_t &start = route.at(i);
+        const pospoint_t &end = route.at(i + 1);
+        const double length = start.getDistanceTo(end);
+
+        double position = spacing_m - sinceLastPoint;
+        for (; position < length; position += spacing_m)
+            resampled.append(interpolate(start, end, position / length));
+        sinceLastPoint = length - (position - spacing_m);
+
+        // Spacing restarts at changes of speed or attributes
+        if ((i + 2 == route.size() || isChangePoint(route, i + 1)) && sinceLastPoint > 1e-6) {
+            resampled.append(end);
+            sinceLastPoint = 0.0;
+        }
+    }
+    return resampled;
+}
+
+QList<PosPoint> resample(const QList<PosPoint> &route, double spacing_m)
+{
+    return PosPoint::fromPODList(resample(PosPoint::toPODList(route), spacing_m));
+}
+
+QVector<pospoint_t> smoothCorners(const QVector<pospoint_t> &route, double minRadius_m, double arcStep_m)
+{
+    if (route.size() < 3 || minRadius_m <= 0.0 || arcStep_m <= 0.0)
+        return route;
+
+    QVector<pospoint_t> smoothed = {route.first()};
+    for (int i = 1; i + 1 < route.size(); i++) {
+        const pospoint_t &previous = route.at(i - 1);
+        const pospoint_t &corner = route.at(i);
+        const pospoint_t &next = route.at(i + 1);
+        const double length0 = previous.getDistanceTo(corner);
+        const double length1 = corner.getDistanceTo(next);
+        if (isChangePoint(route, i) || length0 <= 0.0 || length1 <= 0.0) {
+            smoothed.append(corner);
+            continue;
+        }
+
+        const QPointF direction0 = (corner.getPoint() - previous.getPoint()) / length0;
+        const QPointF direction1 = (next.getPoint() - corner.getPoint()) / length1;
+        const double turn = atan2(direction0.x() * direction1.y() - direction0.y() * direction1.x(), QPointF::dotProduct(direction0, direction1));
+        if (fabs(turn) < 1e-3 || fabs(turn) > M_PI - 1e-3) { // straight or reversing
+            smoothed.append(corner);
+            continue;
+        }
+
+        // Tangent points at distance tangent from the corner
+        double radius = minRadius_m;
+        double tangent = radius * tan(fabs(turn) / 2.0);
+        const double maxTangent = std::min(length0, length1) / 2.0;
+        if (tangent > maxTangent) {
+            tangent = maxTangent;
+            radius = tangent / tan(fabs(turn) / 2.0);
+        }
+
+        const pospoint_t arcStart = interpolate(previous, corner, 1.0 - tangent / length0);
+        const pospoint_t arcEnd = interpolate(corner, next, tangent / length1);
+        const double side = (turn > 0.0) ? 1.0 : -1.0; // positive: turning left (counter-clockwise)
+        const QPointF center = arcStart.getPoint() + side * radius * QPointF(-direction0.y(), direction0.x());
+        const double startAngle = atan2(arcStart.y - center.y(), arcStart.x - center.x());
+        const int steps = std::max(1, int(ceil(radius * fabs(turn) / arcStep_m)));
+        for (int step = 0; step <= steps; step++) {
+            const double fraction = double(step) / steps;
+            pospoint_t point = interpolate(arcStart, arcEnd, fraction);
+            const double angle = startAngle + side * fabs(turn) * fraction;
+            point.x = center.x() + radius * cos(angle);
+            point.y = center.y() + radius * sin(angle);
+            smoothed.append(point);
+        }
+    }
+    smoothed.append(route.last());
+    return smoothed;
+}
+
+QList<PosPoint> smoothCorners(const QList<PosPoint> &route, double minRadius_m, double arcStep_m)
+{
+    return PosPoint::fromPODList(smoothCorners(PosPoint::toPODList(route), minRadius_m, arcStep_m));
+}
+
+}
@@ -0,0 +1,35 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Post-processing of routes, e.g., generated or recorded ones with more points than needed. All operations are linear
+ * in the number of points (simplification is Douglas-Peucker on runs of at most SIMPLIFY_MAX_RUN_POINTS points).
+ * Points where the speed or the attributes change are kept as they are, i.e., those changes stay where they were.
+ */
+
+#ifndef ROUTEPROCESSING_H
+#define ROUTEPROCESSING_H
+
+#include <QList>
+#include <QVector>
+#include "core/pospoint.h"
+
+namespace routeProcessing {
+constexpr int SIMPLIFY_MAX_RUN_POINTS = 1024;
+
+// Subset of the route's points, no removed point is further than tolerance [m] from the simplified route
+QVector<pospoint_t> simplify(const QVector<pospoint_t> &route, double tolerance_m);
+QList<PosPoint> simplify(const QList<PosPoint> &route, double tolerance_m);
+
+// Points spacing [m] apart along the route (and its last point), interpolated between the original points.
+// Height and timestamps are interpolated, other fields are those of the start of the segment.
+QVector<pospoint_t> resample(const QVector<pospoint_t> &route, double spacing_m);
+QList<PosPoint> resample(const QList<PosPoint> &route, double spacing_m);
+
+// Replaces corners by circular arcs of minRadius [m] tangent to both segments, sampled at most arcStep [m] apart.
+// An arc uses at most half of each adjacent segment, i.e., corners between short segments get a smaller radius.
+QVector<pospoint_t> smoothCorners(const QVector<pospoint_t> &route, double minRadius_m, double arcStep_m = 0.2);
+QList<PosPoint> smoothCorners(const QList<PosPoint> &route, double minRadius_m, double arcStep_m = 0.2);
+}
+
+#endif // ROUTEPROCESSING_H
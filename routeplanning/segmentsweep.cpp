@@ -0,0 +1,196 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "segmentsweep.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdlib>
+
+namespace {
+struct SweepSegment {
+    double min; // projection onto the sweep axis
+    double max;
+    int index; // of the segment's end point
+    int set;
+};
+
+double project(const QPointF &point, const QPointF &axis)
+{
+    return point.x() * axis.x() + point.y() * axis.y();
+}
+
+// Expected number of active segments is the summed projected length divided by the projected extent
+QPointF chooseSweepAxis(std::initializer_list<const QVector<QPointF>*> polylines)
+{
+    QVector<QPointF> axes = {QPointF(1.0, 0.0), QPointF(0.0, 1.0)};
+    QPointF longest;
+    double longestLengthSq = 0.0;
+    for (const auto *points : polylines) {
+        for (int i = 1; i < points->size(); i++) {
+            const QPointF d = points->at(i) - points->at(i - 1);
+            const double lengthSq = d.x() * d.x() + d.y() * d.y();
+            if (lengthSq > longestLengthSq) {
+                longestLengthSq = lengthSq;
+                longest = d;
+            }
+        }
+    }
+    if (longestLengthSq > 0.0 && std::isfinite(longestLengthSq)) {
+        const double length = sqrt(longestLengthSq);
+        axes.append(QPointF(-longest.y() / length, longest.x() / length));
+    }
+
+    QPointF bestAxis = axes.first();
+    double bestCost = std::numeric_limits<double>::infinity();
+    for (const auto &axis : axes) {
+        double projectedLength = 0.0;
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        for (const auto *points : polylines) {
+            for (int i = 1; i < points->size(); i++) {
+                const double a = project(points->at(i - 1), axis);
+                const double b = project(points->at(i), axis);
+                if (!std::isfinite(a) || !std::isfinite(b))
+                    continue;
+                projectedLength += fabs(b - a);
+                min = std::min(min, std::min(a, b));
+                max = std::max(max, std::max(a, b));
+            }
+        }
+
+        const double cost = max > min ? projectedLength / (max - min) : std::numeric_limits<double>::infinity();
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestAxis = axis;
+        }
+    }
+
+    return bestAxis;
+}
+
+// Segments with non-finite projections cannot be ordered, they are tested against all others
+void appendSegments(QVector<SweepSegment> &segments, QVector<int> &unbounded, const QVector<QPointF> &points, const QPointF &axis, int set)
+{
+    for (int i = 1; i < points.size(); i++) {
+        const double a = project(points.at(i - 1), axis);
+        const double b = project(points.at(i), axis);
+        if (std::isfinite(a) && std::isfinite(b))
+            segments.append({std::min(a, b), std::max(a, b), i, set});
+        else
+            unbounded.append(i);
+    }
+}
+
+void sortSegments(QVector<SweepSegment> &segments)
+{
+    std::sort(segments.begin(), segments.end(), [](const SweepSegment &first, const SweepSegment &second) {
+        return first.min < second.min;
+    });
+}
+
+// Projections are rounded, keep segments active a bit longer so that touching segments are still tested
+double sweepPadding(const QVector<SweepSegment> &segments)
+{
+    double maxAbs = 0.0;
+    for (const auto &segment : segments)
+        maxAbs = std::max(maxAbs, std::max(fabs(segment.min), fabs(segment.max)));
+    return 1e-9 * (1.0 + maxAbs);
+}
+
+// Removes active segments that end before position, calls test for the remaining ones
+template<typename Test>
+void sweepActive(QVector<SweepSegment> &active, double position, Test test)
+{
+    int kept = 0;
+    for (int i = 0; i < active.size(); i++) {
+        if (active.at(i).max < position)
+            continue;
+        active[kept++] = active.at(i);
+        test(active.at(i));
+    }
+    active.resize(kept);
+}
+}
+
+QVector<QPair<int, int>> segmentSweep::findIntersectingSegments(const QVector<QPointF> &points0, const QVector<QPointF> &points1,
+                                                              const std::function<bool(int i, int j)> &intersects)
+{
+    QVector<QPair<int, int>> pairs;
+    if (points0.size() < 2 || points1.size() < 2)
+        return pairs;
+
+    const QPointF axis = chooseSweepAxis({&points0, &points1});
+    QVector<SweepSegment> segments;
+    QVector<int> unbounded[2];
+    appendSegments(segments, unbounded[0], points0, axis, 0);
+    appendSegments(segments, unbounded[1], points1, axis, 1);
+    sortSegments(segments);
+    const double padding = sweepPadding(segments);
+
+    QVector<SweepSegment> active[2];
+    for (const auto &segment : segments) {
+        sweepActive(active[1 - segment.set], segment.min - padding, [&](const SweepSegment &other) {
+            const QPair<int, int> pair = segment.set == 0 ? qMakePair(segment.index, other.index) : qMakePair(other.index, segment.index);
+            if (intersects(pair.first, pair.second))
+                pairs.append(pair);
+        });
+        active[segment.set].append(segment);
+    }
+
+    for (int i : unbounded[0])
+        for (int j = 1; j < points1.size(); j++)
+            if (intersects(i, j))
+                pairs.append(qMakePair(i, j));
+    for (int j : unbounded[1])
+        for (int i = 1; i < points0.size(); i++)
+            if (!std::binary_search(unbounded[0].constBegin(), unbounded[0].constEnd(), i) && intersects(i, j))
+                pairs.append(qMakePair(i, j));
+
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+QVector<QPair<int, int>> segmentSweep::findIntersectingSegments(const QVector<QPointF> &points, int minIndexDistance,
+                                                              const std::function<bool(int i, int j)> &intersects)
+{
+    QVector<QPair<int, int>> pairs;
+    if (points.size() < 2)
+        return pairs;
+
+    const QPointF axis = chooseSweepAxis({&points});
+    QVector<SweepSegment> segments;
+    QVector<int> unbounded;
+    appendSegments(segments, unbounded, points, axis, 0);
+    sortSegments(segments);
+    const double padding = sweepPadding(segments);
+
+    QVector<SweepSegment> active;
+    for (const auto &segment : segments) {
+        sweepActive(active, segment.min - padding, [&](const SweepSegment &other) {
+            const int i = std::min(segment.index, other.index);
+            const int j = std::max(segment.index, other.index);
+            if (j - i >= minIndexDistance && intersects(i, j))
+                pairs.append(qMakePair(i, j));
+        });
+        active.append(segment);
+    }
+
+    for (int unboundedIndex : unbounded) {
+        for (int other = 1; other < points.size(); other++) {
+            // Pairs of two unbounded segments once
+            if (std::abs(other - unboundedIndex) < minIndexDistance ||
+                    (other < unboundedIndex && std::binary_search(unbounded.constBegin(), unbounded.constEnd(), other)))
+                continue;
+
+            const int i = std::min(unboundedIndex, other);
+            const int j = std::max(unboundedIndex, other);
+            if (intersects(i, j))
+                pairs.append(qMakePair(i, j));
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
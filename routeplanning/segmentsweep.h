@@ -0,0 +1,30 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Sweep-line search for intersecting segments of polylines. Segment i is (points[i-1], points[i]).
+ * Segments are projected onto a sweep axis, the sweep visits them ordered by projection and keeps the segments whose
+ * projection still overlaps the sweep position active. Only overlapping pairs are passed to the intersects callback,
+ * which makes the final decision (e.g., ZigZagRouteGenerator::lineIntersect), so results equal testing all pairs.
+ * The axis is chosen per call: x, y or the normal of the longest segment, whichever overlaps least
+ * (e.g., the parallel lines of a zig-zag route are swept across).
+ */
+
+#ifndef SEGMENTSWEEP_H
+#define SEGMENTSWEEP_H
+
+#include <QVector>
+#include <QPair>
+#include <QPointF>
+#include <functional>
+
+namespace segmentSweep {
+// Pairs (i, j) of segment i of points0 and segment j of points1 with intersects(i, j), sorted by i, then j
+QVector<QPair<int, int>> findIntersectingSegments(const QVector<QPointF> &points0, const QVector<QPointF> &points1,
+                                                  const std::function<bool(int i, int j)> &intersects);
+// Pairs (i, j) of segments of points with j >= i + minIndexDistance and intersects(i, j), sorted by i, then j
+QVector<QPair<int, int>> findIntersectingSegments(const QVector<QPointF> &points, int minIndexDistance,
+                                                  const std::function<bool(int i, int j)> &intersects);
+}
+
+#endif // SEGMENTSWEEP_H
@@ -3,13 +3,82 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "zigzagroutegenerator.h"
+#include "segmentsweep.h"
+#include "polygonoffset.h"
+#include "dubinspath.h"
+#include "reedsshepppath.h"
+
+namespace {
+QVector<QPointF> toPoints(const QList<PosPoint> &route)
+{
+    QVector<QPointF> points;
+    points.reserve(route.size());
+    for (const auto &point : route)
+        points.append(point.getPoint());
+    return points;
+}
+
+// Polygon from polygonOffset (counter-clockwise) in the orientation of bounds, closed at the point closest to start
+QList<PosPoint> toFrame(const QVector<QPointF> &polygon, const QList<PosPoint> &bounds, const PosPoint &start)
+{
+    QList<PosPoint> ring;
+    for (const QPointF &point : polygon)
+        ring.append(PosPoint(point.x(), point.y()));
+    if (polygonOffset::getSignedArea(toPoints(bounds)) < 0.0)
+        std::reverse(ring.begin(), ring.end());
+
+    const int startIdx = ZigZagRouteGenerator::getClosestPointInRoute(start, ring);
+    QList<PosPoint> frame;
+    for (int i = 0; i <= ring.size(); i++)
+        frame.append(ring.at((startIdx + i) % ring.size()));
+    return frame;
+}
+
+// Appends the points of path after its start, the last one replaced by end (keeping its attributes). Arcs are split into the fewest
+// chords within lateralTolerance, i.e., a sagitta of turnRadius * (1 - cos(step / 2)) at most.
+template<typename Path>
+void appendTurn(QList<PosPoint> &route, const Path &path, PosPoint end, double turnRadius, double lateralTolerance, double speed, double speedInTurns, uint32_t setAttributesInTurns)
+{
+    const double maxStep_rad = std::max(std::min(2.0*acos(std::max(1.0 - lateralTolerance/turnRadius, -1.0)), M_PI/2), 0.01);
+
+    double distance = 0.0;
+    double direction = 1.0;
+    for (int segment = 0; segment < path.getSegmentCount(); segment++) {
+        const double length = path.getSegmentLength(segment);
+        if (fabs(length) < 1e-9)
+            continue;
+
+        direction = length < 0.0 ? -1.0 : 1.0;
+        const bool last = (segment == path.getSegmentCount() - 1);
+        const int steps = (path.getSegmentType(segment) == DubinsPath::SegmentType::Straight) ? 1 : int(ceil(fabs(length)/turnRadius/maxStep_rad));
+        for (int step = 1; step <= steps; step++) {
+            if (last && step == steps)
+                break;
+
+            QPointF position;
+            double yaw_rad;
+            path.getPose(distance + step*fabs(length)/steps, position, yaw_rad);
+            PosPoint turnStep(position.x(), position.y());
+            turnStep.setSpeed(direction*speedInTurns);
+            turnStep.setAttributes(turnStep.getAttributes() | setAttributesInTurns);
+            route.append(turnStep);
+        }
+        distance += fabs(length);
+    }
+
+    // The end point is approached in the direction of the last segment (see PurepursuitWaypointFollower)
+    end.setSpeed(direction*speed);
+    end.setAttributes(end.getAttributes() | setAttributesInTurns);
+    route.append(end);
+}
+}
 
 ZigZagRouteGenerator::ZigZagRouteGenerator()
 {
 
 }
 
-bool ZigZagRouteGenerator::isPointWithin(double px, double py, QList<PosPoint> route)
+bool ZigZagRouteGenerator::isPointWithin(double px, double py, const QList<PosPoint> &route)
 {
     if (route.size() < 3) {
         return false;
@@ -32,7 +101,7 @@ bool ZigZagRouteGenerator::isPointWithin(double px, double py, QList<PosPoint> r
     return c;
 }
 
-bool ZigZagRouteGenerator::isPointWithin(PosPoint p, QList<PosPoint> route)
+bool ZigZagRouteGenerator::isPointWithin(const PosPoint &p, const QList<PosPoint> &route)
 {
     return isPointWithin(p.getX(),p.getY(),route);
 }
@@ -124,12 +193,15 @@ QList<PosPoint> ZigZagRouteGenerator::getAllIntersections(QList<PosPoint> points
     if (points0.size() < 2 || points1.size() < 2)
         return intersections;
 
-    for (int i = 1; i < points0.size(); i++)
-        for (int j = 1; j < points1.size(); j++)
-            if (lineIntersect(points0.at(i-1), points0.at(i), points1.at(j-1), points1.at(j))) {
-                intersections.append(getLineIntersection(QPair<PosPoint, PosPoint>(points0.at(i-1), points0.at(i)),
-                                                         QPair<PosPoint, PosPoint>(points1.at(j-1), points1.at(j))));
-            }
+    // Same pairs and order as testing all segment pairs (i, j)
+    const auto segmentPairs = segmentSweep::findIntersectingSegments(toPoints(points0), toPoints(points1), [&points0, &points1](int i, int j) {
+        return lineIntersect(points0.at(i-1), points0.at(i), points1.at(j-1), points1.at(j));
+    });
+    for (const auto &segmentPair : segmentPairs) {
+        const int i = segmentPair.first, j = segmentPair.second;
+        intersections.append(getLineIntersection(QPair<PosPoint, PosPoint>(points0.at(i-1), points0.at(i)),
+                                                 QPair<PosPoint, PosPoint>(points1.at(j-1), points1.at(j))));
+    }
 
     return intersections;
 }
@@ -140,11 +212,15 @@ QList<PosPoint> ZigZagRouteGenerator::getAllIntersections(QList<PosPoint> route)
     if (route.size() < 2)
         return intersections;
 
-    for (int i = 1; i < route.size(); i++)
-        for (int j = i+2; j < route.size(); j++)
-            if (lineIntersect(route.at(i-1), route.at(i), route.at(j-1), route.at(j)))
-                intersections.append(getLineIntersection(QPair<PosPoint, PosPoint>(route.at(i-1), route.at(i)),
-                                                         QPair<PosPoint, PosPoint>(route.at(j-1), route.at(j))));
+    // Same pairs and order as testing all non-adjacent segment pairs (i, j >= i+2)
+    const auto segmentPairs = segmentSweep::findIntersectingSegments(toPoints(route), 2, [&route](int i, int j) {
+        return lineIntersect(route.at(i-1), route.at(i), route.at(j-1), route.at(j));
+    });
+    for (const auto &segmentPair : segmentPairs) {
+        const int i = segmentPair.first, j = segmentPair.second;
+        intersections.append(getLineIntersection(QPair<PosPoint, PosPoint>(route.at(i-1), route.at(i)),
+                                                 QPair<PosPoint, PosPoint>(route.at(j-1), route.at(j))));
+    }
 
     return intersections;
 }
@@ -165,6 +241,14 @@ int ZigZagRouteGenerator::getClosestPointInRoute(PosPoint referencePoint, QList<
     return minIdx;
 }
 
+int ZigZagRouteGenerator::getClosestPointInRoute(PosPoint referencePoint, const RouteSpatialIndex &routeIndex)
+{
+    int minIdx = routeIndex.getClosestPointIndex(referencePoint.getPoint());
+    assert(minIdx != -1);
+
+    return minIdx;
+}
+
 QPair<PosPoint,PosPoint> ZigZagRouteGenerator::getBaselineDeterminingMinHeightOfConvexPolygon(QList<PosPoint> convexPolygon)
 {
     // 1. Determine point with max distance for each line
@@ -244,6 +328,14 @@ QList<PosPoint> ZigZagRouteGenerator::fillConvexPolygonWithZigZag(QList<PosPoint
     for (int i = 1; i < route.size(); i+=4)
         std::swap(route[i-1], route[i]);
 
+    return addTurnsToPasses(route, bounds, angle, polygonDirectionSign, spacing, keepTurnsInBounds, speed, speedInTurns, turnIntermediateSteps, visitEveryX,
+                            setAttributesOnStraights, setAttributesInTurns, attributeDistanceAfterTurn, attributeDistanceBeforeTurn);
+}
+
+QList<PosPoint> ZigZagRouteGenerator::addTurnsToPasses(QList<PosPoint> route, const QList<PosPoint> &bounds, double angle, int polygonDirectionSign, double spacing, bool keepTurnsInBounds,
+                                                       double speed, double speedInTurns, int turnIntermediateSteps, int visitEveryX,
+                                                       uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn)
+{
     QList<int> endsOfPasses;
     if (visitEveryX > 0) {
         QList<PosPoint> routeWIPeveryX;
@@ -418,22 +510,92 @@ QList<PosPoint> ZigZagRouteGenerator::fillConvexPolygonWithZigZag(QList<PosPoint
     return route;
 }
 
-QList<PosPoint> ZigZagRouteGenerator::fillConvexPolygonWithFramedZigZag(QList<PosPoint> bounds, double spacing, bool keepTurnsInBounds, double speed, double speedInTurns, int turnIntermediateSteps, int visitEveryX,
-                                                              uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn)
+QList<PosPoint> ZigZagRouteGenerator::fillConvexPolygonWithCurvedZigZag(QList<PosPoint> bounds, double spacing, double minTurnRadius, bool allowReverse, double lateralTolerance,
+                                                                        double speed, double speedInTurns, int visitEveryX,
+                                                                        uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn)
 {
-    QList<PosPoint> frame = getShrinkedConvexPolygon(bounds, spacing);
-
-    QList<PosPoint> zigzag = fillConvexPolygonWithZigZag(frame, spacing, keepTurnsInBounds, speed, speedInTurns, turnIntermediateSteps, visitEveryX, setAttributesOnStraights, setAttributesInTurns, attributeDistanceAfterTurn, attributeDistanceBeforeTurn);
+    // Passes in driving order without turns
+    QList<PosPoint> passes = fillConvexPolygonWithZigZag(bounds, spacing, false, speed, speedInTurns, 0, visitEveryX, 0, 0, 0.0, 0.0);
 
-    int pointIdx = getClosestPointInRoute(zigzag.first(), frame);
+    return addCurvedTurnsToPasses(passes, minTurnRadius, allowReverse, lateralTolerance, speed, speedInTurns,
+                                  setAttributesOnStraights, setAttributesInTurns, attributeDistanceAfterTurn, attributeDistanceBeforeTurn);
+}
 
+QList<PosPoint> ZigZagRouteGenerator::addCurvedTurnsToPasses(const QList<PosPoint> &passes, double minTurnRadius, bool allowReverse, double lateralTolerance, double speed, double speedInTurns,
+                                                             uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn)
+{
     QList<PosPoint> route;
-    for (int i = pointIdx; i < frame.size(); i++)
-        route.append(frame.at(i));
-    for (int i = 0; i < pointIdx; i++)
-        route.append(frame.at(i));
-    route.append(frame.at(pointIdx));
+    double passYaw = 0.0;
+    for (int i = 0; i + 1 < passes.size(); i += 2) {
+        PosPoint passStart = passes.at(i);
+        PosPoint passEnd = passes.at(i+1);
+        const double passLength = passStart.getDistanceTo(passEnd);
+        if (passLength > 1e-9)
+            passYaw = atan2(passEnd.getY() - passStart.getY(), passEnd.getX() - passStart.getX());
+
+        // 1. turn from the end of the previous pass
+        if (route.isEmpty()) {
+            passStart.setSpeed(speed);
+            route.append(passStart);
+        } else {
+            const PosPoint previousStart = passes.at(i-2);
+            const PosPoint previousEnd = passes.at(i-1);
+            const double previousYaw = (previousStart.getDistanceTo(previousEnd) > 1e-9)
+                    ? atan2(previousEnd.getY() - previousStart.getY(), previousEnd.getX() - previousStart.getX()) : passYaw;
+
+            if (allowReverse)
+                appendTurn(route, ReedsSheppPath::getShortest(previousEnd.getPoint(), previousYaw, passStart.getPoint(), passYaw, minTurnRadius),
+                           passStart, minTurnRadius, lateralTolerance, speed, speedInTurns, setAttributesInTurns);
+            else
+                appendTurn(route, DubinsPath::getShortest(previousEnd.getPoint(), previousYaw, passStart.getPoint(), passYaw, minTurnRadius),
+                           passStart, minTurnRadius, lateralTolerance, speed, speedInTurns, setAttributesInTurns);
+        }
+
+        // 2. points for predictable processing of attributes on the pass
+        if (setAttributesOnStraights) {
+            PosPoint attrStart(passStart.getX() + attributeDistanceAfterTurn*cos(passYaw), passStart.getY() + attributeDistanceAfterTurn*sin(passYaw));
+            PosPoint attrEnd(passEnd.getX() - attributeDistanceBeforeTurn*cos(passYaw), passEnd.getY() - attributeDistanceBeforeTurn*sin(passYaw));
+
+            attrStart.setAttributes(attrStart.getAttributes() | setAttributesOnStraights);
+            attrEnd.setAttributes(attrEnd.getAttributes() | setAttributesOnStraights);
+            attrStart.setSpeed(speed);
+            attrEnd.setSpeed(speed);
+
+            route.append(attrStart);
+            route.append(attrEnd);
+        }
 
+        passEnd.setSpeed(speed);
+        if (i + 2 < passes.size())
+            passEnd.setAttributes(passEnd.getAttributes() | setAttributesInTurns);
+        route.append(passEnd);
+    }
+
+    return route;
+}
+
+QList<PosPoint> ZigZagRouteGenerator::fillConvexPolygonWithFramedZigZag(QList<PosPoint> bounds, double spacing, bool keepTurnsInBounds, double speed, double speedInTurns, int turnIntermediateSteps, int visitEveryX,
+                                                              uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn, int frameCount)
+{
+    // Each frame is offset from bounds directly, the largest polygon of a frame that splits is kept
+    const QVector<QVector<polygonOffset::OffsetPolygon>> insets = polygonOffset::getInsetRings(toPoints(bounds), spacing, std::max(frameCount, 1));
+    if (insets.isEmpty())
+        return {};
+
+    const QList<PosPoint> innermostFrame = toFrame(insets.last().first().outer, bounds, PosPoint());
+    QList<PosPoint> zigzag = fillConvexPolygonWithZigZag(innermostFrame, spacing, keepTurnsInBounds, speed, speedInTurns, turnIntermediateSteps, visitEveryX, setAttributesOnStraights, setAttributesInTurns, attributeDistanceAfterTurn, attributeDistanceBeforeTurn);
+
+    // The innermost frame ends where the zig-zag starts, each outer one next to the start of the frame inside it
+    QList<QList<PosPoint>> frames;
+    PosPoint start = zigzag.isEmpty() ? innermostFrame.first() : zigzag.first();
+    for (int i = insets.size() - 1; i >= 0; i--) {
+        frames.prepend(toFrame(insets.at(i).first().outer, bounds, start));
+        start = frames.first().first();
+    }
+
+    QList<PosPoint> route;
+    for (const auto &frame : frames)
+        route.append(frame);
     for (auto& pt : route)
         pt.setSpeed(speed);
     route.append(zigzag);
@@ -443,23 +605,12 @@ QList<PosPoint> ZigZagRouteGenerator::fillConvexPolygonWithFramedZigZag(QList<Po
 
 QList<PosPoint> ZigZagRouteGenerator::getShrinkedConvexPolygon(QList<PosPoint> bounds, double spacing)
 {
-    //bounds.append(bounds.at(0)); // NOTE: might make sense to make sure bounds are closed, but sometimes leads to strange results in this form
-    int directionSign = getConvexPolygonOrientation(bounds);
-    QList<PosPoint> shrinkedBounds;
-    for (int i=1; i<bounds.size(); i++) {
-        double angle = atan2(bounds.at(i).getY() - bounds.at(i-1).getY(), bounds.at(i).getX() - bounds.at(i-1).getX());
-        PosPoint lineStart = PosPoint(bounds.at(i-1).getX() + directionSign*spacing*cos(angle + M_PI/2), bounds.at(i-1).getY() + directionSign*spacing*sin(angle + M_PI/2));
-        PosPoint lineEnd = PosPoint(bounds.at(i).getX() + directionSign*spacing*cos(angle + M_PI/2), bounds.at(i).getY() + directionSign*spacing*sin(angle + M_PI/2));
-        shrinkedBounds.append(lineStart);
-        shrinkedBounds.append(lineEnd);
-    }
-
-    shrinkedBounds = getAllIntersections(shrinkedBounds);
-    if (shrinkedBounds.size() > 1)
-       std::swap(shrinkedBounds[0], shrinkedBounds[1]);
-    shrinkedBounds.append(shrinkedBounds[0]);
+    // Largest polygon of the inward offset (also for non-convex bounds), closed at the point closest to the start of bounds
+    const QVector<polygonOffset::OffsetPolygon> shrinked = polygonOffset::offset(toPoints(bounds), -spacing);
+    if (shrinked.isEmpty() || bounds.isEmpty())
+        return {};
 
-    return shrinkedBounds;
+    return toFrame(shrinked.first().outer, bounds, bounds.first());
 }
 
 int ZigZagRouteGenerator::getConvexPolygonOrientation(QList<PosPoint> bounds)
@@ -7,13 +7,14 @@
 
 #include <QPair>
 #include "core/pospoint.h"
+#include "core/routespatialindex.h"
 
 
 class ZigZagRouteGenerator
 {
 public:
-    static bool isPointWithin(double px, double py, QList<PosPoint> route);
-    static bool isPointWithin(PosPoint p, QList<PosPoint> route);
+    static bool isPointWithin(double px, double py, const QList<PosPoint> &route);
+    static bool isPointWithin(const PosPoint &p, const QList<PosPoint> &route);
     static double distanceToLine(PosPoint p, PosPoint l0, PosPoint l1);
     static bool ccw(PosPoint a, PosPoint b, PosPoint c);
     static bool lineIntersect(PosPoint a, PosPoint b, PosPoint c, PosPoint d);
@@ -22,11 +23,27 @@ public:
     static QList<PosPoint> getAllIntersections(QList<PosPoint> points0, QList<PosPoint> points1);
     static QList<PosPoint> getAllIntersections(QList<PosPoint> route);
     static int getClosestPointInRoute(PosPoint referencePoint, QList<PosPoint> route);
+    static int getClosestPointInRoute(PosPoint referencePoint, const RouteSpatialIndex &routeIndex);
     static QPair<PosPoint,PosPoint> getBaselineDeterminingMinHeightOfConvexPolygon(QList<PosPoint> convexPolygon);
     static QList<PosPoint> fillConvexPolygonWithZigZag(QList<PosPoint> bounds, double spacing, bool keepTurnsInBounds, double speed, double speedInTurns, int turnIntermediateSteps, int visitEveryX,
                                                             uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn);
+    // Driven around frameCount frames spacing apart inside bounds (see polygonOffset) before filling the innermost one with a zig-zag
     static QList<PosPoint> fillConvexPolygonWithFramedZigZag(QList<PosPoint> bounds, double spacing, bool keepTurnsInBounds, double speed, double speedInTurns, int turnIntermediateSteps, int visitEveryX,
-                                                                  uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn);
+                                                                  uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn, int frameCount = 1);
+    // Connects passes (start and end point of each pass in driving order, pass 0 heading along angle, the following ones shifted by one spacing towards
+    // polygonDirectionSign * normal of angle) with turns and sets speeds and attributes, e.g., for passes of cells from CoveragePlanner
+    static QList<PosPoint> addTurnsToPasses(QList<PosPoint> route, const QList<PosPoint> &bounds, double angle, int polygonDirectionSign, double spacing, bool keepTurnsInBounds,
+                                            double speed, double speedInTurns, int turnIntermediateSteps, int visitEveryX,
+                                            uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn);
+    // As fillConvexPolygonWithZigZag, but turns are the shortest paths the vehicle can drive at minTurnRadius: forward only (Dubins) or with reversing
+    // (Reeds-Shepp, negative speed while reversing, e.g., for spacings below two turn radii). Turns leave the bounds (as without keepTurnsInBounds),
+    // arcs are the fewest waypoints with chords within lateralTolerance of the arc, straights only their end points
+    static QList<PosPoint> fillConvexPolygonWithCurvedZigZag(QList<PosPoint> bounds, double spacing, double minTurnRadius, bool allowReverse, double lateralTolerance,
+                                                             double speed, double speedInTurns, int visitEveryX,
+                                                             uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn);
+    // Connects passes (start and end point of each pass in driving order) with curved turns as above and sets speeds and attributes
+    static QList<PosPoint> addCurvedTurnsToPasses(const QList<PosPoint> &passes, double minTurnRadius, bool allowReverse, double lateralTolerance, double speed, double speedInTurns,
+                                                  uint32_t setAttributesOnStraights, uint32_t setAttributesInTurns, double attributeDistanceAfterTurn, double attributeDistanceBeforeTurn);
     static QList<PosPoint> getShrinkedConvexPolygon(QList<PosPoint> bounds, double spacing);
     static int getConvexPolygonOrientation(QList<PosPoint> bounds);
 
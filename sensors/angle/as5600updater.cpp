@@ -8,47 +8,72 @@
 
 AS5600Updater::AS5600Updater(QSharedPointer<VehicleState> vehicleState, double angleOffset) : AngleSensorUpdater(vehicleState), angleOffset(angleOffset)
 {
+   mTruckState = qSharedPointerDynamicCast<TruckState>(vehicleState);
+   if (!mTruckState)
+      qDebug() << "Error: Failed to cast VehicleState to TruckState.";
+
    int res{};
    res = as5600_basic_init(); // basic init for reading angle using i2c
-   
+
    if (res == 0) {
       printSensorInfo(); // print AS5600 information
-      connect(&mPollTimer, &QTimer::timeout, [this, vehicleState]() {
-         uint16_t angle_raw{};    
-         uint16_t scaled_angle{};    
-         float angleInDegrees{};
-         int res{};
-         // read 1) degree angle (converted from raw value), 2) raw angle (0x0C | 0x0D), 3) scaled angle (0x0E | 0x0F)
-         res = as5600_basic_read(&angleInDegrees, &angle_raw, &scaled_angle);
-         if (res == 0) {
-            //qDebug() << "as5600: scaled angle: " << scaled_angle << "| in Radians : "  <<"| in degrees: " << deg ;
-            angleInDegrees = angleInDegrees - this->angleOffset;
-            // for the moment only a truck has an angle sensor
-            QSharedPointer<TruckState> truckState = qSharedPointerDynamicCast<TruckState>(vehicleState);
-            if (truckState) {
-                truckState->setTrailerAngle(angleInDegrees);
-                mIsConnected = true;
-            } else {
-                qDebug() << "Error: Failed to cast VehicleState to TruckState.";
-            }
-         } else {
-            qDebug() << "ERROR: as5600 Read failed";
-         }
-      });
-      mPollTimer.start(mPollIntervall_ms);
+      // reads run on the I2C thread
+      mPollId = I2CBusWorker::getInstance().addPoll(getActivePollIntervall(), [this]() { readAngle(); });
    } else {
       qDebug() << "ERROR: Unable to open i2c bus to AS5600";
    }
 }
 
+AS5600Updater::~AS5600Updater()
+{
+   if (mPollId >= 0)
+      I2CBusWorker::getInstance().removePoll(mPollId);
+}
+
 bool AS5600Updater::setUpdateIntervall(int pollIntervall_ms)
 {
    mPollIntervall_ms = pollIntervall_ms;
-   mPollTimer.start(mPollIntervall_ms);
+   if (mPollId >= 0)
+      I2CBusWorker::getInstance().setPollIntervall(mPollId, getActivePollIntervall());
 
    return true;
 }
 
+void AS5600Updater::setHighRateSampling(bool enabled)
+{
+   mHighRateSampling = enabled;
+   if (mPollId >= 0)
+      I2CBusWorker::getInstance().setPollIntervall(mPollId, getActivePollIntervall());
+}
+
+void AS5600Updater::readAngle()
+{
+   // raw angle (0x0C | 0x0D) in one burst, 12 bit
+   uint16_t angle_raw{};
+   if (as5600_basic_read_raw(&angle_raw) != 0) {
+      if (!mReadFailing) // once per failure period, reads may run at a high rate
+         qDebug() << "ERROR: as5600 Read failed";
+      mReadFailing = true;
+      return;
+   }
+   mReadFailing = false;
+   const qint64 timestamp_ns = utcTime::now_ns();
+   mIsConnected = true;
+
+   // [-180:180) around the offset, i.e., the median does not see the wrap for trailer angles
+   const double angle_deg = remainder(angle_raw * (360.0 / 4096.0) - angleOffset, 360.0);
+   const double filteredAngle_deg = mAngleFilter.add(angle_deg);
+
+   if (mTruckState)
+      mTruckState->setTrailerAngle(filteredAngle_deg, timestamp_ns);
+
+   if (!mNotificationPending.exchange(true))
+      I2CBusWorker::publish(this, [this]() {
+         mNotificationPending = false;
+         emit updatedAngleSensor(getVehicleState());
+      });
+}
+
 bool AS5600Updater::isConnected()
 {
     return mIsConnected;
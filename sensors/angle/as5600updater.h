@@ -8,27 +8,50 @@
 #ifndef AS5600UPDATER_H
 #define AS5600UPDATER_H
 
+#include <atomic>
 #include "sensors/angle/anglesensorupdater.h"
 #include "vehicles/truckstate.h"
+#include "core/medianfilter.h"
 
 extern "C" {
 #include "external/pi-as5600/driver_as5600_basic.h"
 }
-#include <QTimer>
+#include "sensors/i2cbusworker.h"
 
-// connects to AS5600 via i2c bus and polls orientation data (angle) periodically
+// connects to AS5600 via i2c bus and polls orientation data (angle) periodically on the I2C bus worker.
+// Each sample is a burst read of the raw angle registers, timestamped and median filtered on the I2C thread and stored
+// directly (lock-free) as the truck's trailer angle, i.e., without passing the owner's event loop. updatedAngleSensor is
+// emitted on the owner's thread, coalesced if samples arrive faster than they are handled.
+// The AS5600 converts continuously (no data-ready signal), i.e., the poll intervall is the sampling period.
 class AS5600Updater : public AngleSensorUpdater
 {
 public:
+    static constexpr int DEFAULT_POLL_INTERVALL_MS = 50;
+    static constexpr int HIGH_RATE_POLL_INTERVALL_MS = 2; // a two-byte read takes about 0.1 ms at 400 kHz
+    static constexpr int MEDIAN_WINDOW = 3; // samples, suppresses single read glitches
+
     AS5600Updater(QSharedPointer<VehicleState> vehicleState, double angleOffset=0);
+    ~AS5600Updater();
     void printSensorInfo();
     virtual bool setUpdateIntervall(int pollIntervall_ms) override;
     virtual bool isConnected() override;
 
+    // Samples at HIGH_RATE_POLL_INTERVALL_MS instead of the update intervall, e.g., for reversing with a trailer
+    void setHighRateSampling(bool enabled);
+    bool isHighRateSampling() const { return mHighRateSampling; }
+
 private:
-    int mPollIntervall_ms = 50; // interval (ms) to read from AS5600,
-    QTimer mPollTimer;
-    bool mIsConnected = false;
+    void readAngle(); // I2C thread
+    int getActivePollIntervall() const { return mHighRateSampling ? HIGH_RATE_POLL_INTERVALL_MS : mPollIntervall_ms; }
+
+    int mPollIntervall_ms = DEFAULT_POLL_INTERVALL_MS; // interval (ms) to read from AS5600,
+    bool mHighRateSampling = false;
+    int mPollId = -1;
+    std::atomic<bool> mIsConnected{false};
+    std::atomic<bool> mNotificationPending{false};
+    QSharedPointer<TruckState> mTruckState; // for the moment only a truck has an angle sensor
+    MedianFilter<double, MEDIAN_WINDOW> mAngleFilter; // I2C thread, [deg]
+    bool mReadFailing = false; // I2C thread
     double angleOffset; // offset if the start angle is not zero
 
 };
@@ -6,9 +6,13 @@
  */
 #include "depthaicamera.h"
 #include <QDebug>
+#include <cmath>
 
 DepthAiCamera::DepthAiCamera()
 {
+    for (int i = 0; i < ObjectTracker::MAX_TRACKS; i++)
+        mTrackedObjectStates.append(QSharedPointer<DetectedObjectState>::create(DEFAULT_TRACKED_OBJECT_ID_BASE + i));
+
     // Connect to camera stream
     mJsonParser.connectToHost(QHostAddress::LocalHost, 8070);
     QObject::connect(&mJsonParser, &JsonStreamParserTcp::gotJsonArray, this, &DepthAiCamera::cameraInput);
@@ -20,28 +24,80 @@ DepthAiCamera::DepthAiCamera()
 void DepthAiCamera::cameraInput(const QJsonArray& jsonArray)
 {
     // 3D position x,y,z in meters from the camera.
+    const qint64 timestamp_ns = utcTime::now_ns(); // as early as possible, brake latency is measured from here
+
+    QVector<PosPoint> &objects = mObjects; // keeps its capacity, unless shared by a queued receiver of detectedObjects
+    objects.clear();
+    objects.reserve(jsonArray.size());
+    for (const auto& jsonValue : jsonArray) {
+        const QJsonObject jsonObject = jsonValue.toObject();
+        PosPoint object;
+        object.setX(jsonObject.value("depth_z").toDouble());
+        object.setY(-jsonObject.value("depth_x").toDouble());
+        object.setHeight(jsonObject.value("depth_y").toDouble());
+        object.setTimestamp_ns(timestamp_ns);
+        objects.append(object);
+    }
+    emit detectedObjects(objects);
+
+    mObjectTracker.update(objects, timestamp_ns);
+    updateTrackedObjectStates();
+    emit trackedObjectsUpdated();
 
     // Objects detected, save only the closest one
+    mCameraData.setX(0);
+    mCameraData.setY(0);
+    mCameraData.setHeight(0);
     double closeObject = std::numeric_limits<double>::max();
-    for (int i=0; i<jsonArray.size(); i++) {
-        if (closeObject > jsonArray.at(i).toObject().value("depth_z").toDouble()) {
-            mCameraData.setX(jsonArray.at(i).toObject().value("depth_z").toDouble());
-            mCameraData.setY(-jsonArray.at(i).toObject().value("depth_x").toDouble());
-            mCameraData.setHeight(jsonArray.at(i).toObject().value("depth_y").toDouble());
-            closeObject = mCameraData.getY();
+    for (const auto& object : objects) {
+        if (closeObject > object.getX()) {
+            mCameraData.setX(object.getX());
+            mCameraData.setY(object.getY());
+            mCameraData.setHeight(object.getHeight());
+            closeObject = object.getX();
         }
     }
 
-    // No objects detected
-    if (jsonArray.size() == 0) {
-        mCameraData.setX(0);
-        mCameraData.setY(0);
-        mCameraData.setHeight(0);
-    }
-
-    mCameraData.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
+    mCameraData.setTimestamp_ns(timestamp_ns);
     emit closestObject(mCameraData);
 
 //    qDebug() << jsonArray
 //             << "\nsize:" << jsonArray.size();
 }
+
+void DepthAiCamera::setTrackedObjectIdBase(int idBase)
+{
+    for (int i = 0; i < mTrackedObjectStates.size(); i++)
+        mTrackedObjectStates[i]->setId(idBase + i);
+}
+
+void DepthAiCamera::updateTrackedObjectStates()
+{
+    PosPoint vehiclePosition;
+    if (mVehicleState)
+        vehiclePosition = mVehicleState->getPosition();
+    const double yaw_rad = vehiclePosition.getYaw() * M_PI / 180.0;
+    const double cosYaw = cos(yaw_rad);
+    const double sinYaw = sin(yaw_rad);
+
+    for (int i = 0; i < mTrackedObjectStates.size(); i++) {
+        DetectedObjectState &objectState = *mTrackedObjectStates[i];
+        if (i >= mObjectTracker.size()) {
+            objectState.setActive(false);
+            continue;
+        }
+
+        // Vehicle frame to ENU (identity without VehicleState), velocity stays relative to the vehicle
+        const TrackedObject &track = mObjectTracker.at(i);
+        PosPoint position;
+        position.setX(vehiclePosition.getX() + cosYaw * track.position.x() - sinYaw * track.position.y());
+        position.setY(vehiclePosition.getY() + sinYaw * track.position.x() + cosYaw * track.position.y());
+        position.setHeight(vehiclePosition.getHeight() + track.height);
+        position.setTimestamp_ns(track.lastSeen_ns);
+        objectState.setVelocity({cosYaw * track.velocity.x() - sinYaw * track.velocity.y(),
+                                 sinYaw * track.velocity.x() + cosYaw * track.velocity.y(), 0.0});
+        objectState.setTrackId(track.trackId);
+        objectState.setActive(true);
+        objectState.setPosition(position);
+    }
+}
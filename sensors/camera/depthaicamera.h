@@ -3,14 +3,20 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * Class to parse a JSON stream with object detections (incl. depth information) from DepthAI
+ * Detections are associated across frames (ObjectTracker), the tracks are also available as DetectedObjectStates
+ * (in ENU if a VehicleState is set, vehicle frame otherwise) that are updated in place for every frame.
  */
 
 #ifndef DEPTHAICAMERA_H
 #define DEPTHAICAMERA_H
 
 #include <QObject>
+#include <QVector>
 #include "core/pospoint.h"
 #include "communication/jsonstreamparsertcp.h"
+#include "core/objecttracker.h"
+#include "vehicles/detectedobjectstate.h"
+#include "vehicles/vehiclestate.h"
 
 class DepthAiCamera : public QObject
 {
@@ -18,14 +24,31 @@ class DepthAiCamera : public QObject
 public:
     DepthAiCamera();
 
+    static constexpr int DEFAULT_TRACKED_OBJECT_ID_BASE = 1000; // ObjectState IDs, e.g., to add them to MapWidget next to vehicles
+
+    // Vehicle carrying the camera, to express tracked objects in ENU
+    void setVehicleState(QSharedPointer<VehicleState> vehicleState) { mVehicleState = vehicleState; }
+    const ObjectTracker &getObjectTracker() const { return mObjectTracker; }
+    // One per possible track, the active ones (DetectedObjectState::isActive) are tracked at the moment
+    const QVector<QSharedPointer<DetectedObjectState>> &getTrackedObjectStates() const { return mTrackedObjectStates; }
+    void setTrackedObjectIdBase(int idBase);
+
 signals:
     void closestObject(const PosPoint &obj);
+    void detectedObjects(const QVector<PosPoint> &objects); // all objects of a frame, vehicle frame (x forward, y left), timestamped at reception
+    void trackedObjectsUpdated(); // after each frame
 
 private:
     JsonStreamParserTcp mJsonParser;
 
     PosPoint mCameraData;
+    QVector<PosPoint> mObjects; // of the last frame
+    ObjectTracker mObjectTracker;
+    QVector<QSharedPointer<DetectedObjectState>> mTrackedObjectStates;
+    QSharedPointer<VehicleState> mVehicleState;
+
     void cameraInput(const QJsonArray& jsonArray);
+    void updateTrackedObjectStates();
 };
 
 #endif // DEPTHAICAMERA_H
@@ -0,0 +1,103 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "gimbalroitracker.h"
+#include <QtDebug>
+#include <cmath>
+
+GimbalRoiTracker::GimbalRoiTracker(QSharedPointer<Gimbal> gimbal, QSharedPointer<ObjectState> carrier) :
+    mGimbal(gimbal), mCarrier(carrier)
+{
+    mUpdateTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mUpdateTimer, &ClockTimer::timeout, this, &GimbalRoiTracker::update);
+    mCommandAge.setSingleShot(true);
+}
+
+void GimbalRoiTracker::startTracking(QSharedPointer<ObjectState> target, double heightOffset_m)
+{
+    if (target.isNull()) {
+        qDebug() << "Warning: GimbalRoiTracker got no target to track.";
+        return;
+    }
+
+    mTarget = target;
+    mHeightOffset_m = heightOffset_m;
+    startUpdates();
+}
+
+void GimbalRoiTracker::startTracking(const xyz_t &roiENU)
+{
+    mTarget.clear();
+    mRoiENU = roiENU;
+    mHeightOffset_m = 0.0;
+    startUpdates();
+}
+
+void GimbalRoiTracker::stopTracking()
+{
+    if (!isTracking())
+        return;
+
+    mUpdateTimer.stop();
+    mTarget.clear();
+    emit trackingStopped();
+}
+
+void GimbalRoiTracker::setUpdatePeriod_ms(int updatePeriod_ms)
+{
+    mUpdatePeriod_ms = std::max(updatePeriod_ms, 1);
+    if (isTracking())
+        mUpdateTimer.start(mUpdatePeriod_ms);
+}
+
+void GimbalRoiTracker::startUpdates()
+{
+    if (mGimbal.isNull() || mCarrier.isNull()) {
+        qDebug() << "Warning: GimbalRoiTracker needs a gimbal and the vehicle carrying it.";
+        return;
+    }
+
+    mGimbal->setYawLocked(false); // yaw is relative to the carrier
+    mHasSentCommand = false;
+    mUpdateTimer.start(mUpdatePeriod_ms);
+    update();
+}
+
+void GimbalRoiTracker::update()
+{
+    mNumUpdates++;
+
+    xyz_t roi = mRoiENU;
+    if (!mTarget.isNull()) {
+        const PosPoint targetPosition = mTarget->getPosition();
+        const ObjectState::Velocity targetVelocity = mTarget->getVelocity();
+        const double leadTime_s = mLeadTime_ms / 1000.0;
+        roi = {targetPosition.getX() + targetVelocity.x * leadTime_s,
+               targetPosition.getY() + targetVelocity.y * leadTime_s,
+               targetPosition.getHeight() + targetVelocity.z * leadTime_s + mHeightOffset_m};
+    }
+
+    const PosPoint carrierPosition = mCarrier->getPosition();
+    const QPointF roiInVehicleFrame = coordinateTransforms::ENUToVehicleFrame(QPointF(roi.x, roi.y), carrierPosition.getXYZ(), carrierPosition.getYaw());
+    const double horizontalDistance_m = std::hypot(roiInVehicleFrame.x(), roiInVehicleFrame.y());
+    if (horizontalDistance_m < 1e-3 && std::abs(roi.z - carrierPosition.getHeight()) < 1e-3)
+        return; // at the gimbal, direction undefined
+
+    // Gimbal yaw is positive to the right, vehicle frame y to the left
+    const double pitch_deg = atan2(roi.z - carrierPosition.getHeight(), horizontalDistance_m) * 180.0 / M_PI;
+    const double yaw_deg = -atan2(roiInVehicleFrame.y(), roiInVehicleFrame.x()) * 180.0 / M_PI;
+
+    double yawChange_deg = std::fmod(std::abs(yaw_deg - mLastYaw_deg), 360.0);
+    yawChange_deg = std::min(yawChange_deg, 360.0 - yawChange_deg);
+    if (mHasSentCommand && mCommandAge.isActive() &&
+            std::abs(pitch_deg - mLastPitch_deg) <= mDeadband_deg && yawChange_deg <= mDeadband_deg)
+        return;
+
+    mGimbal->setPitchAndYaw(pitch_deg, yaw_deg);
+    mLastPitch_deg = pitch_deg;
+    mLastYaw_deg = yaw_deg;
+    mHasSentCommand = true;
+    mCommandAge.start(MAX_COMMAND_AGE_MS);
+    mNumCommandsSent++;
+}
@@ -0,0 +1,76 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Keeps a Gimbal pointed at a moving object (e.g., another vehicle) or a fixed point. Pitch and yaw (relative to the carrying
+ * vehicle, yaw follow mode) are computed from both ObjectStates at a fixed rate, but only sent when they changed by more than
+ * a deadband (or when the last command is getting old), i.e., the command stream is bounded independently of the target.
+ * The target is extrapolated by its (ENU) velocity for the lead time, the gimbal slews towards each command on its own and
+ * thereby interpolates between them.
+ */
+
+#ifndef GIMBALROITRACKER_H
+#define GIMBALROITRACKER_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include "sensors/camera/gimbal.h"
+#include "vehicles/objectstate.h"
+#include "core/clock.h"
+
+class GimbalRoiTracker : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int DEFAULT_UPDATE_PERIOD_MS = 100;
+    static constexpr double DEFAULT_DEADBAND_DEG = 0.5;
+    static constexpr int MAX_COMMAND_AGE_MS = 1000; // resent within the deadband after this time
+
+    // carrier: the vehicle the gimbal is mounted on
+    GimbalRoiTracker(QSharedPointer<Gimbal> gimbal, QSharedPointer<ObjectState> carrier);
+
+    // heightOffset_m: point above the target's position to look at (e.g., center of a car)
+    void startTracking(QSharedPointer<ObjectState> target, double heightOffset_m = 0.0);
+    void startTracking(const xyz_t &roiENU);
+    void stopTracking();
+    bool isTracking() const { return mUpdateTimer.isActive(); }
+
+    double getDeadband_deg() const { return mDeadband_deg; }
+    void setDeadband_deg(double deadband_deg) { mDeadband_deg = deadband_deg; }
+    int getUpdatePeriod_ms() const { return mUpdatePeriod_ms; }
+    void setUpdatePeriod_ms(int updatePeriod_ms);
+    int getLeadTime_ms() const { return mLeadTime_ms; }
+    void setLeadTime_ms(int leadTime_ms) { mLeadTime_ms = leadTime_ms; } // default: one update period
+
+    void setClock(Clock *clock) { mUpdateTimer.setClock(clock); mCommandAge.setClock(clock); }
+
+    quint64 getNumCommandsSent() const { return mNumCommandsSent; }
+    quint64 getNumUpdates() const { return mNumUpdates; }
+
+signals:
+    void trackingStopped();
+
+private:
+    void startUpdates();
+    void update();
+
+    QSharedPointer<Gimbal> mGimbal;
+    QSharedPointer<ObjectState> mCarrier;
+    QSharedPointer<ObjectState> mTarget; // null: mRoiENU is tracked
+    xyz_t mRoiENU;
+    double mHeightOffset_m = 0.0;
+
+    double mDeadband_deg = DEFAULT_DEADBAND_DEG;
+    int mUpdatePeriod_ms = DEFAULT_UPDATE_PERIOD_MS;
+    int mLeadTime_ms = DEFAULT_UPDATE_PERIOD_MS;
+    ClockTimer mUpdateTimer;
+    ClockTimer mCommandAge; // single shot, running while the last command is recent
+
+    bool mHasSentCommand = false;
+    double mLastPitch_deg = 0.0;
+    double mLastYaw_deg = 0.0;
+    quint64 mNumCommandsSent = 0;
+    quint64 mNumUpdates = 0;
+};
+
+#endif // GIMBALROITRACKER_H
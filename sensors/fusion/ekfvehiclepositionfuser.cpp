@@ -0,0 +1,286 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "ekfvehiclepositionfuser.h"
+#include <QDebug>
+#include <cstdlib>
+
+EKFVehiclePositionFuser::EKFVehiclePositionFuser(QObject *parent) : QObject(parent)
+{
+    reset();
+}
+
+void EKFVehiclePositionFuser::reset()
+{
+    mCovariance = StateMatrix::diagonal({0.0, 0.0, INITIAL_YAW_STDDEV_rad * INITIAL_YAW_STDDEV_rad});
+    mInitialized = false;
+    mLastIMUTimestamp_ns = utcTime::INVALID;
+    mPosOdomDistanceDrivenSinceGNSSupdate = 0.0;
+    mLastGNSSHeading_ns = utcTime::INVALID;
+    mLastGNSSPosition_ns = utcTime::INVALID;
+    mUWBRejectedInRow = 0;
+    mPosFusedHistory.clear();
+}
+
+EKFVehiclePositionFuser::StateVector EKFVehiclePositionFuser::stateFromPosPoint(const PosPoint &pos)
+{
+    return StateVector({pos.getX(), pos.getY(), pos.getYaw() * M_PI / 180.0});
+}
+
+void EKFVehiclePositionFuser::stateToPosPoint(const StateVector &state, PosPoint &pos)
+{
+    pos.setXY(state[X], state[Y]);
+    pos.setYaw(normalizeAngle_rad(state[YAW]) * 180.0 / M_PI);
+}
+
+double EKFVehiclePositionFuser::normalizeAngle_rad(double angle_rad)
+{
+    // normalize to [-pi:pi[
+    while (angle_rad < -M_PI)
+        angle_rad += 2.0 * M_PI;
+    while (angle_rad >= M_PI)
+        angle_rad -= 2.0 * M_PI;
+    return angle_rad;
+}
+
+void EKFVehiclePositionFuser::samplePosFused(const PosPoint &posFused)
+{
+    mPosFusedHistory.append(posFused.getTimestamp_ns(), PosSample {posFused.getPoint(), posFused.getYaw()});
+}
+
+EKFVehiclePositionFuser::PosSample EKFVehiclePositionFuser::getPosFusedSampleAtTime(qint64 timestamp_ns, const PosPoint &posFused) const
+{
+    PosSample sample {posFused.getPoint(), posFused.getYaw()}; // no history (yet)
+    mPosFusedHistory.getSampleAt(timestamp_ns, sample, [](const PosSample &before, const PosSample &after, double fraction) {
+        double yawDiff = after.yaw - before.yaw;
+        while (yawDiff < -180.0) yawDiff += 360.0;
+        while (yawDiff > 180.0) yawDiff -= 360.0;
+        return PosSample {before.posXY + (after.posXY - before.posXY) * fraction, before.yaw + yawDiff * fraction};
+    });
+    return sample;
+}
+
+bool EKFVehiclePositionFuser::hasRecentGNSSHeading(qint64 timestamp_ns) const
+{
+    return mLastGNSSHeading_ns != utcTime::INVALID && std::abs(timestamp_ns - mLastGNSSHeading_ns) < GNSS_HEADING_TIMEOUT_ns;
+}
+
+bool EKFVehiclePositionFuser::hasRecentGNSSPosition(qint64 timestamp_ns) const
+{
+    return mLastGNSSPosition_ns != utcTime::INVALID && std::abs(timestamp_ns - mLastGNSSPosition_ns) < GNSS_POSITION_TIMEOUT_ns;
+}
+
+void EKFVehiclePositionFuser::predict(const StateMatrix &jacobian, const StateMatrix &processNoise)
+{
+    mCovariance = jacobian * mCovariance * jacobian.transposed() + processNoise;
+}
+
+template<int MeasurementSize>
+void EKFVehiclePositionFuser::update(StateVector &state, const FixedVector<MeasurementSize> &innovation, const FixedMatrix<MeasurementSize, 3> &measurementJacobian,
+                                     const FixedMatrix<MeasurementSize, MeasurementSize> &measurementNoise)
+{
+    const FixedMatrix<3, MeasurementSize> covarianceTimesJacobianT = mCovariance * measurementJacobian.transposed();
+    const FixedMatrix<MeasurementSize, MeasurementSize> innovationCovariance = measurementJacobian * covarianceTimesJacobianT + measurementNoise;
+    FixedMatrix<MeasurementSize, MeasurementSize> innovationCovarianceInv;
+    if (!innovationCovariance.inverse(innovationCovarianceInv)) {
+        qDebug() << "WARNING: EKFVehiclePositionFuser has a singular innovation covariance, skipping update.";
+        return;
+    }
+
+    const FixedMatrix<3, MeasurementSize> gain = covarianceTimesJacobianT * innovationCovarianceInv;
+    state += gain * innovation;
+    state[YAW] = normalizeAngle_rad(state[YAW]);
+
+    // Joseph form, keeps the covariance symmetric and positive semi-definite
+    const StateMatrix iMinusKH = StateMatrix::identity() - gain * measurementJacobian;
+    mCovariance = iMinusKH * mCovariance * iMinusKH.transposed() + gain * measurementNoise * gain.transposed();
+}
+
+void EKFVehiclePositionFuser::correctPositionAndYawGNSS(QSharedPointer<VehicleState> vehicleState, double distanceMoved, bool fused)
+{
+    mPosGNSSisFused = fused;
+    PosPoint posGNSS = vehicleState->getPosition(PosType::GNSS);
+    PosPoint posFused = vehicleState->getPosition(PosType::fused);
+
+    if (mPosGNSSisFused) {// use GNSS position directly if that was already fused (e.g., F9R).
+        posFused.setYaw(posGNSS.getYaw());
+        posFused.setXY(posGNSS.getX(), posGNSS.getY());
+    } else {
+        const double posStdDev_m = (posGNSS.getSigma() > 0.0) ? posGNSS.getSigma() : mGNSSPositionStdDev_m;
+        StateVector state = stateFromPosPoint(posFused);
+
+        // 1. GNSS position is precise, but old. Find sampled position at matching time to calculate innovation
+        PosSample posFusedSample = getPosFusedSampleAtTime(posGNSS.getTimestamp_ns(), posFused);
+        FixedVector<2> posInnovation({posGNSS.getX() - posFusedSample.posXY.x(), posGNSS.getY() - posFusedSample.posXY.y()});
+
+        if (!mInitialized || fabs(posInnovation[0]) > BIG_DISTANCE_ERROR_m || fabs(posInnovation[1]) > BIG_DISTANCE_ERROR_m) {
+            // 2a. (Re)start at GNSS position, previous history no longer matches
+            state[X] = posGNSS.getX();
+            state[Y] = posGNSS.getY();
+            mCovariance = StateMatrix::diagonal({posStdDev_m * posStdDev_m, posStdDev_m * posStdDev_m, mCovariance(YAW, YAW)});
+            mPosFusedHistory.clear();
+            mInitialized = true;
+        } else if (fabs(distanceMoved) >= mGNSSYawMinDistance_m && !hasRecentGNSSHeading(posGNSS.getTimestamp_ns())) {
+            // 2b. Update position and yaw. GNSS yaw is the direction of motion, needs to be reversed when driving backwards.
+            //     Its uncertainty depends on the distance between the two GNSS positions it was derived from.
+            const double yawGNSS_rad = (((mPosOdomDistanceDrivenSinceGNSSupdate < 0.0) ? 180.0 : 0.0) + posGNSS.getYaw()) * M_PI / 180.0;
+            const double yawStdDev_rad = atan2(M_SQRT2 * posStdDev_m, fabs(distanceMoved));
+
+            FixedVector<3> innovation({posInnovation[0], posInnovation[1], normalizeAngle_rad(yawGNSS_rad - posFusedSample.yaw * M_PI / 180.0)});
+            update<3>(state, innovation, FixedMatrix<3, 3>::identity(),
+                      FixedMatrix<3, 3>::diagonal({posStdDev_m * posStdDev_m, posStdDev_m * posStdDev_m, yawStdDev_rad * yawStdDev_rad}));
+        } else {
+            // 2c. Update position only (yaw is still corrected through its correlation with position)
+            update<2>(state, posInnovation, FixedMatrix<2, 3>({1.0, 0.0, 0.0,
+                                                               0.0, 1.0, 0.0}),
+                      FixedMatrix<2, 2>::diagonal({posStdDev_m * posStdDev_m, posStdDev_m * posStdDev_m}));
+        }
+
+        stateToPosPoint(state, posFused);
+        posFused.setSigma(sqrt(std::max(mCovariance(X, X), mCovariance(Y, Y))));
+    }
+
+    posFused.setHeight(posGNSS.getHeight());
+    posFused.setTimestamp_ns(utcTime::now_ns());
+    vehicleState->setPosition(posFused);
+    mPosOdomDistanceDrivenSinceGNSSupdate = 0.0;
+    mLastGNSSPosition_ns = posGNSS.getTimestamp_ns();
+}
+
+void EKFVehiclePositionFuser::correctPositionUWB(QSharedPointer<VehicleState> vehicleState)
+{
+    if (mPosGNSSisFused)
+        return;
+
+    PosPoint posUWB = vehicleState->getPosition(PosType::UWB);
+    PosPoint posFused = vehicleState->getPosition(PosType::fused);
+    const double posStdDev_m = (posUWB.getSigma() > 0.0) ? posUWB.getSigma() : mUWBPositionStdDev_m;
+    const bool recentGNSS = hasRecentGNSSPosition(posUWB.getTimestamp_ns());
+    StateVector state = stateFromPosPoint(posFused);
+
+    // 1. Innovation against the fused position at the UWB position's time, gated by its covariance
+    PosSample posFusedSample = getPosFusedSampleAtTime(posUWB.getTimestamp_ns(), posFused);
+    FixedVector<2> posInnovation({posUWB.getX() - posFusedSample.posXY.x(), posUWB.getY() - posFusedSample.posXY.y()});
+    const FixedMatrix<2, 3> measurementJacobian({1.0, 0.0, 0.0,
+                                                 0.0, 1.0, 0.0});
+    const FixedMatrix<2, 2> measurementNoise = FixedMatrix<2, 2>::diagonal({posStdDev_m * posStdDev_m, posStdDev_m * posStdDev_m});
+    FixedMatrix<2, 2> innovationCovarianceInv;
+    const bool inGate = mInitialized &&
+            (measurementJacobian * mCovariance * measurementJacobian.transposed() + measurementNoise).inverse(innovationCovarianceInv) &&
+            (posInnovation.transposed() * innovationCovarianceInv * posInnovation)(0, 0) <= UWB_GATE_MAHALANOBIS_SQUARED;
+
+    if (inGate) {
+        // 2a. Update position (yaw through its correlation with position)
+        update<2>(state, posInnovation, measurementJacobian, measurementNoise);
+    } else if (recentGNSS || (mInitialized && ++mUWBRejectedInRow < UWB_MAX_REJECTED_IN_ROW)) {
+        return;
+    } else {
+        // 2b. (Re)start at UWB position, e.g., without GNSS since start-up or after GNSS was lost
+        if (mInitialized)
+            qDebug() << "EKFVehiclePositionFuser: restarting at UWB position after" << mUWBRejectedInRow << "rejected UWB positions";
+        state[X] = posUWB.getX();
+        state[Y] = posUWB.getY();
+        mCovariance = StateMatrix::diagonal({posStdDev_m * posStdDev_m, posStdDev_m * posStdDev_m, mCovariance(YAW, YAW)});
+        mPosFusedHistory.clear();
+        mInitialized = true;
+    }
+
+    stateToPosPoint(state, posFused);
+    posFused.setSigma(sqrt(std::max(mCovariance(X, X), mCovariance(Y, Y))));
+    if (!recentGNSS)
+        posFused.setHeight(posUWB.getHeight());
+    posFused.setTimestamp_ns(utcTime::now_ns());
+    vehicleState->setPosition(posFused);
+    mUWBRejectedInRow = 0;
+}
+
+void EKFVehiclePositionFuser::correctYawGNSSHeading(QSharedPointer<VehicleState> vehicleState, double yaw_degENU, double yawStdDev_deg, qint64 timestamp_ns)
+{
+    if (mPosGNSSisFused)
+        return;
+
+    PosPoint posFused = vehicleState->getPosition(PosType::fused);
+    StateVector state = stateFromPosPoint(posFused);
+
+    // Heading is old when it arrives, innovation against the fused yaw at its time
+    PosSample posFusedSample = getPosFusedSampleAtTime(timestamp_ns, posFused);
+    const double yawStdDev_rad = yawStdDev_deg * M_PI / 180.0;
+    FixedVector<1> innovation({normalizeAngle_rad((yaw_degENU - posFusedSample.yaw) * M_PI / 180.0)});
+    update<1>(state, innovation, FixedMatrix<1, 3>({0.0, 0.0, 1.0}), FixedMatrix<1, 1>::diagonal({yawStdDev_rad * yawStdDev_rad}));
+
+    stateToPosPoint(state, posFused);
+    posFused.setTimestamp_ns(utcTime::now_ns());
+    vehicleState->setPosition(posFused);
+    mLastGNSSHeading_ns = timestamp_ns;
+}
+
+void EKFVehiclePositionFuser::correctPositionAndYawOdom(QSharedPointer<VehicleState> vehicleState, double distanceDriven)
+{
+    if (!mPosGNSSisFused) {
+        PosPoint posFused = vehicleState->getPosition(PosType::fused);
+        StateVector state = stateFromPosPoint(posFused);
+
+        // use Odom input from motorcontroller for IMU-based dead reckoning
+        const double cosYaw = cos(state[YAW]);
+        const double sinYaw = sin(state[YAW]);
+        state[X] += cosYaw * distanceDriven;
+        state[Y] += sinYaw * distanceDriven;
+
+        StateMatrix jacobian = StateMatrix::identity();
+        jacobian(X, YAW) = -sinYaw * distanceDriven;
+        jacobian(Y, YAW) = cosYaw * distanceDriven;
+
+        // along/cross-track noise rotated into ENU
+        const double alongVariance = pow(mOdomAlongTrackStdDev * distanceDriven, 2);
+        const double crossVariance = pow(mOdomCrossTrackStdDev * distanceDriven, 2);
+        StateMatrix processNoise;
+        processNoise(X, X) = cosYaw * cosYaw * alongVariance + sinYaw * sinYaw * crossVariance;
+        processNoise(Y, Y) = sinYaw * sinYaw * alongVariance + cosYaw * cosYaw * crossVariance;
+        processNoise(X, Y) = processNoise(Y, X) = cosYaw * sinYaw * (alongVariance - crossVariance);
+
+        predict(jacobian, processNoise);
+
+        stateToPosPoint(state, posFused);
+        posFused.setSigma(sqrt(std::max(mCovariance(X, X), mCovariance(Y, Y))));
+        posFused.setTimestamp_ns(utcTime::now_ns());
+        vehicleState->setPosition(posFused);
+
+        samplePosFused(posFused);
+    }
+
+    mPosOdomDistanceDrivenSinceGNSSupdate += distanceDriven;
+}
+
+void EKFVehiclePositionFuser::correctPositionAndYawIMU(QSharedPointer<VehicleState> vehicleState)
+{
+    if (!mPosGNSSisFused) {
+        PosPoint posIMU = vehicleState->getPosition(PosType::IMU);
+        const qint64 imuTimestamp_ns = utcTime::isValid(posIMU.getTimestamp_ns()) ? posIMU.getTimestamp_ns() : utcTime::now_ns();
+
+        if (!utcTime::isValid(mLastIMUTimestamp_ns)) { // relative IMU yaw, need two samples for a change
+            mLastIMUYaw_deg = posIMU.getYaw();
+            mLastIMUTimestamp_ns = imuTimestamp_ns;
+            return;
+        }
+
+        // IMU yaw is relative and drifts, only its change is used (and not at all at standstill)
+        double yawChange_rad = normalizeAngle_rad((posIMU.getYaw() - mLastIMUYaw_deg) * M_PI / 180.0);
+        const double dt_s = std::max(imuTimestamp_ns - mLastIMUTimestamp_ns, qint64(0)) / 1e9;
+        mLastIMUYaw_deg = posIMU.getYaw();
+        mLastIMUTimestamp_ns = imuTimestamp_ns;
+        if (fabs(vehicleState->getSpeed()) < 0.05)
+            yawChange_rad = 0.0;
+
+        PosPoint posFused = vehicleState->getPosition(PosType::fused);
+        StateVector state = stateFromPosPoint(posFused);
+        state[YAW] = normalizeAngle_rad(state[YAW] + yawChange_rad);
+
+        // Jacobian is identity, only yaw variance grows
+        mCovariance(YAW, YAW) += pow(mIMUYawChangeStdDev * yawChange_rad, 2) + mIMUYawRandomWalk * mIMUYawRandomWalk * dt_s;
+
+        stateToPosPoint(state, posFused);
+        posFused.setTimestamp_ns(utcTime::now_ns());
+        vehicleState->setPosition(posFused);
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Extended Kalman filter alternative to SDVPVehiclePositionFuser with the same inputs (GNSS position, odometry, relative IMU yaw).
+ * The state is the "fused" position and yaw (x [m], y [m], yaw [rad], ENU) as stored in VehicleState, the fuser keeps its covariance:
+ *  - Odometry: prediction step, moves the state by the driven distance along the current yaw. Uncertainty grows with the distance driven,
+ *      which also correlates position and yaw, so that GNSS positions alone can correct yaw when moving.
+ *  - IMU: prediction step, applies the change of the relative IMU yaw (ignored at standstill to counter drift).
+ *  - GNSS: measurement update of x/y (and yaw from consecutive GNSS positions when moved far enough). Measurements are old when they arrive,
+ *      the innovation is therefore computed against the "fused" state at the GNSS position's time (interpolated from the history buffer)
+ *      and the correction is applied to the current state.
+ *  - GNSS heading (e.g., dual antenna): measurement update of yaw, replaces yaw from consecutive GNSS positions while it keeps arriving.
+ *  - UWB: measurement update of x/y like GNSS, gated by the Mahalanobis distance of the innovation. Consistently rejected UWB positions
+ *      restart the filter at the UWB position when there is no recent GNSS position (handover, e.g., after entering a building).
+ * Compared to fixed gains, GNSS is weighted by the actual uncertainty, so low GNSS rates lose less accuracy.
+ * All matrices are fixed-size (FixedMatrix), no allocation happens per update.
+ */
+
+#ifndef EKFVEHICLEPOSITIONFUSER_H
+#define EKFVEHICLEPOSITIONFUSER_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include "vehicles/vehiclestate.h"
+#include "core/timestampedhistory.h"
+#include "core/fixedmatrix.h"
+
+class EKFVehiclePositionFuser : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EKFVehiclePositionFuser(QObject *parent = nullptr);
+    void correctPositionAndYawGNSS(QSharedPointer<VehicleState> vehicleState, double distanceMoved, bool fused);
+    void correctPositionAndYawOdom(QSharedPointer<VehicleState> vehicleState, double distanceDriven);
+    void correctPositionAndYawIMU(QSharedPointer<VehicleState> vehicleState);
+    // E.g., from UbloxRover::updatedGNSSHeading
+    void correctYawGNSSHeading(QSharedPointer<VehicleState> vehicleState, double yaw_degENU, double yawStdDev_deg, qint64 timestamp_ns);
+    // E.g., from PozyxPositionUpdater::updatedUWBPositionAndYaw, uses the PosType::UWB position (its yaw is not used)
+    void correctPositionUWB(QSharedPointer<VehicleState> vehicleState);
+
+    // Standard deviation of GNSS x/y [m], used if the GNSS position does not provide its sigma
+    double getGNSSPositionStdDev() const { return mGNSSPositionStdDev_m; }
+    void setGNSSPositionStdDev(double gnssPositionStdDev_m) { mGNSSPositionStdDev_m = gnssPositionStdDev_m; }
+    // Standard deviation of UWB x/y [m], used if the UWB position does not provide its sigma
+    double getUWBPositionStdDev() const { return mUWBPositionStdDev_m; }
+    void setUWBPositionStdDev(double uwbPositionStdDev_m) { mUWBPositionStdDev_m = uwbPositionStdDev_m; }
+    // Minimum distance between GNSS positions to use their direction as yaw measurement [m]
+    double getGNSSYawMinDistance() const { return mGNSSYawMinDistance_m; }
+    void setGNSSYawMinDistance(double gnssYawMinDistance_m) { mGNSSYawMinDistance_m = gnssYawMinDistance_m; }
+    // Odometry standard deviation along and across the direction of motion, relative to the distance driven
+    double getOdomAlongTrackStdDev() const { return mOdomAlongTrackStdDev; }
+    void setOdomAlongTrackStdDev(double odomAlongTrackStdDev) { mOdomAlongTrackStdDev = odomAlongTrackStdDev; }
+    double getOdomCrossTrackStdDev() const { return mOdomCrossTrackStdDev; }
+    void setOdomCrossTrackStdDev(double odomCrossTrackStdDev) { mOdomCrossTrackStdDev = odomCrossTrackStdDev; }
+    // IMU yaw standard deviation, relative to the yaw change and as random walk [rad/sqrt(s)]
+    double getIMUYawChangeStdDev() const { return mIMUYawChangeStdDev; }
+    void setIMUYawChangeStdDev(double imuYawChangeStdDev) { mIMUYawChangeStdDev = imuYawChangeStdDev; }
+    double getIMUYawRandomWalk() const { return mIMUYawRandomWalk; }
+    void setIMUYawRandomWalk(double imuYawRandomWalk) { mIMUYawRandomWalk = imuYawRandomWalk; }
+
+    // Number of odometry updates kept, needs to cover GNSS latency (clears the history)
+    int getPosFusedHistorySize() const { return mPosFusedHistory.getCapacity(); }
+    void setPosFusedHistorySize(int posFusedHistorySize) { mPosFusedHistory.setCapacity(posFusedHistorySize); }
+
+    // Covariance of x [m], y [m], yaw [rad]
+    FixedMatrix<3, 3> getCovariance() const { return mCovariance; }
+    void reset(); // forget covariance and history, the next GNSS position is taken as is
+
+signals:
+
+private:
+    using StateVector = FixedVector<3>;
+    using StateMatrix = FixedMatrix<3, 3>;
+    enum StateIndex {X = 0, Y = 1, YAW = 2};
+
+    struct PosSample {
+        QPointF posXY;
+        double yaw;
+    };
+
+    static StateVector stateFromPosPoint(const PosPoint &pos);
+    static void stateToPosPoint(const StateVector &state, PosPoint &pos);
+    static double normalizeAngle_rad(double angle_rad);
+
+    void predict(const StateMatrix &jacobian, const StateMatrix &processNoise);
+    template<int MeasurementSize>
+    void update(StateVector &state, const FixedVector<MeasurementSize> &innovation, const FixedMatrix<MeasurementSize, 3> &measurementJacobian,
+                const FixedMatrix<MeasurementSize, MeasurementSize> &measurementNoise);
+
+    void samplePosFused(const PosPoint &posFused);
+    PosSample getPosFusedSampleAtTime(qint64 timestamp_ns, const PosPoint &posFused) const;
+    bool hasRecentGNSSHeading(qint64 timestamp_ns) const;
+    bool hasRecentGNSSPosition(qint64 timestamp_ns) const;
+
+    StateMatrix mCovariance;
+    bool mInitialized = false;
+    bool mPosGNSSisFused = false; // use GNSS pos as "fused" pos when true, e.g., F9R
+    double mLastIMUYaw_deg = 0.0;
+    qint64 mLastIMUTimestamp_ns = utcTime::INVALID;
+    double mPosOdomDistanceDrivenSinceGNSSupdate = 0.0;
+    qint64 mLastGNSSHeading_ns = utcTime::INVALID;
+    qint64 mLastGNSSPosition_ns = utcTime::INVALID;
+    int mUWBRejectedInRow = 0;
+
+    double mGNSSPositionStdDev_m = 0.05;
+    double mUWBPositionStdDev_m = 0.1;
+    double mGNSSYawMinDistance_m = 0.5;
+    double mOdomAlongTrackStdDev = 0.05;
+    double mOdomCrossTrackStdDev = 0.02;
+    double mIMUYawChangeStdDev = 0.02;
+    double mIMUYawRandomWalk = 0.002;
+    static constexpr double INITIAL_YAW_STDDEV_rad = M_PI;
+    static constexpr double BIG_DISTANCE_ERROR_m = 50.0;
+    static constexpr qint64 GNSS_HEADING_TIMEOUT_ns = 2000000000; // falls back to yaw from GNSS positions
+    static constexpr qint64 GNSS_POSITION_TIMEOUT_ns = 1000000000; // UWB can restart the filter
+    static constexpr double UWB_GATE_MAHALANOBIS_SQUARED = 9.21; // chi-squared, 2 DOF, 99 %
+    static constexpr int UWB_MAX_REJECTED_IN_ROW = 10;
+
+    static constexpr int POSFUSED_HISTORY_SIZE = 128;
+    TimestampedHistory<PosSample> mPosFusedHistory{POSFUSED_HISTORY_SIZE}; // timestamps: UTC [ns]
+};
+
+#endif // EKFVEHICLEPOSITIONFUSER_H
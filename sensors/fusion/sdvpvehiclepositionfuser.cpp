@@ -4,6 +4,9 @@
  */
 #include "sdvpvehiclepositionfuser.h"
 #include <QDebug>
+#include <QLineF>
+#include <cstdlib>
+#include "core/perfcounters.h"
 
 SDVPVehiclePositionFuser::SDVPVehiclePositionFuser(QObject *parent) : QObject(parent)
 {
@@ -12,30 +15,29 @@ SDVPVehiclePositionFuser::SDVPVehiclePositionFuser(QObject *parent) : QObject(pa
 
 void SDVPVehiclePositionFuser::samplePosFused(const PosPoint &posFused)
 {
-    mPosFusedHistory[mPosFusedHistoryCurrentIdx++] = PosSample {posFused.getPoint(), posFused.getYaw(), posFused.getTime()};
-    if (mPosFusedHistoryCurrentIdx == POSFUSED_HISTORY_SIZE)
-        mPosFusedHistoryCurrentIdx = 0;
+    mPosFusedHistory.append(posFused.getTimestamp_ns(), PosSample {posFused.getPoint(), posFused.getYaw()});
 }
 
-SDVPVehiclePositionFuser::PosSample SDVPVehiclePositionFuser::getClosestPosFusedSampleInTime(QTime timeUTC)
+SDVPVehiclePositionFuser::PosSample SDVPVehiclePositionFuser::getPosFusedSampleAtTime(qint64 timestamp_ns, const PosPoint &posFused) const
 {
-    int lastSavedHistoryIdx = mPosFusedHistoryCurrentIdx - 1 >= 0 ? mPosFusedHistoryCurrentIdx - 1 : POSFUSED_HISTORY_SIZE - 1;
-    int smallestDiffFound = abs(timeUTC.msecsSinceStartOfDay() - mPosFusedHistory[lastSavedHistoryIdx].timestamp.msecsSinceStartOfDay());
-    int posFusedHistoryClosestIdx = -1;
-
-    for (int i = lastSavedHistoryIdx; i != mPosFusedHistoryCurrentIdx; i--) {
-        if (i < 0)
-            i = POSFUSED_HISTORY_SIZE-1;
-
-        int currentDiff = abs(timeUTC.msecsSinceStartOfDay() - mPosFusedHistory[i].timestamp.msecsSinceStartOfDay());
-        if (currentDiff <= smallestDiffFound) {
-            smallestDiffFound = currentDiff;
-            posFusedHistoryClosestIdx = i;
-        } else
-            break;
-    }
+    PosSample sample {posFused.getPoint(), posFused.getYaw()}; // no history (yet)
+    mPosFusedHistory.getSampleAt(timestamp_ns, sample, [](const PosSample &before, const PosSample &after, double fraction) {
+        double yawDiff = after.yaw - before.yaw;
+        while (yawDiff < -180.0) yawDiff += 360.0;
+        while (yawDiff > 180.0) yawDiff -= 360.0;
+        return PosSample {before.posXY + (after.posXY - before.posXY) * fraction, before.yaw + yawDiff * fraction};
+    });
+    return sample;
+}
 
-    return mPosFusedHistory[posFusedHistoryClosestIdx];
+bool SDVPVehiclePositionFuser::hasRecentGNSSHeading(qint64 timestamp_ns) const
+{
+    return mLastGNSSHeading_ns != utcTime::INVALID && std::abs(timestamp_ns - mLastGNSSHeading_ns) < GNSS_HEADING_TIMEOUT_ns;
+}
+
+bool SDVPVehiclePositionFuser::hasRecentGNSSPosition(qint64 timestamp_ns) const
+{
+    return mLastGNSSPosition_ns != utcTime::INVALID && std::abs(timestamp_ns - mLastGNSSPosition_ns) < GNSS_POSITION_TIMEOUT_ns;
 }
 
 double SDVPVehiclePositionFuser::getPosGNSSxyDynamicGain() const
@@ -62,6 +64,8 @@ double SDVPVehiclePositionFuser::getMaxSignedStepFromValueTowardsGoal(double val
 
 void SDVPVehiclePositionFuser::correctPositionAndYawGNSS(QSharedPointer<VehicleState> vehicleState, double distanceMoved, bool fused)
 {
+    static const int latencyId = PerfCounters::getInstance().registerCounter("FUS_GNSS", PerfCounters::Type::Latency);
+    PerfCounters::ScopedLatency latency(latencyId);
     mPosGNSSisFused = fused;
     PosPoint posGNSS = vehicleState->getPosition(PosType::GNSS);
     PosPoint posIMU = vehicleState->getPosition(PosType::IMU);
@@ -72,7 +76,7 @@ void SDVPVehiclePositionFuser::correctPositionAndYawGNSS(QSharedPointer<VehicleS
         posFused.setXY(posGNSS.getX(), posGNSS.getY());
     } else {
         // 1. GNSS position is precise, but old. Find sampled position at matching time to calculate error
-        PosSample closestPosFusedSample = getClosestPosFusedSampleInTime(posGNSS.getTime());
+        PosSample closestPosFusedSample = getPosFusedSampleAtTime(posGNSS.getTimestamp_ns(), posFused);
 
         // 2. Update yaw offset, limit max change depending on last driven distance reported by odometry (if available)
         //    GNSS yaw represents direction of motion and needs to be reversed when driving backwards
@@ -83,7 +87,8 @@ void SDVPVehiclePositionFuser::correctPositionAndYawGNSS(QSharedPointer<VehicleS
         double yawStepSize = yawMaxChangeDistanceInput * mPosGNSSyawGain;
         double stepYaw = getMaxSignedStepFromValueTowardsGoal(mPosIMUyawOffset, mPosIMUyawOffset + yawErrorCmpToGNSS, yawStepSize);
 
-        mPosIMUyawOffset += stepYaw;
+        if (!hasRecentGNSSHeading(posGNSS.getTimestamp_ns())) // direct yaw measurement is better
+            mPosIMUyawOffset += stepYaw;
 
         // 3. Update position, limit max change depending on last driven distance reported by odometry (if available) but jump to GNSS position if error is big
         double posMaxChangeDistanceInput = yawMaxChangeDistanceInput;
@@ -102,13 +107,16 @@ void SDVPVehiclePositionFuser::correctPositionAndYawGNSS(QSharedPointer<VehicleS
     }
 
     posFused.setHeight(posGNSS.getHeight());
-    posFused.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
+    posFused.setTimestamp_ns(utcTime::now_ns());
     vehicleState->setPosition(posFused);
     mPosOdomDistanceDrivenSinceGNSSupdate = 0.0;
+    mLastGNSSPosition_ns = posGNSS.getTimestamp_ns();
 }
 
 void SDVPVehiclePositionFuser::correctPositionAndYawOdom(QSharedPointer<VehicleState> vehicleState, double distanceDriven)
 {
+    static const int latencyId = PerfCounters::getInstance().registerCounter("FUS_ODOM", PerfCounters::Type::Latency);
+    PerfCounters::ScopedLatency latency(latencyId);
     if (!mPosGNSSisFused) {
         PosPoint posFused = vehicleState->getPosition(PosType::fused);
 
@@ -117,17 +125,20 @@ void SDVPVehiclePositionFuser::correctPositionAndYawOdom(QSharedPointer<VehicleS
         posFused.setXY(posFused.getX() + cos(yawRad) * distanceDriven,
                        posFused.getY() + sin(yawRad) * distanceDriven);
 
-        posFused.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
+        posFused.setTimestamp_ns(utcTime::now_ns());
         vehicleState->setPosition(posFused);
 
         samplePosFused(posFused);
     }
 
     mPosOdomDistanceDrivenSinceGNSSupdate += distanceDriven;
+    mPosOdomDistanceDrivenSinceUWBupdate += distanceDriven;
 }
 
 void SDVPVehiclePositionFuser::correctPositionAndYawIMU(QSharedPointer<VehicleState> vehicleState)
 {
+    static const int latencyId = PerfCounters::getInstance().registerCounter("FUS_IMU", PerfCounters::Type::Latency);
+    PerfCounters::ScopedLatency latency(latencyId);
     if (!mPosGNSSisFused) {
         static bool standstillAtLastCall = false;
         static double yawWhenStopping = 0.0;
@@ -160,11 +171,76 @@ void SDVPVehiclePositionFuser::correctPositionAndYawIMU(QSharedPointer<VehicleSt
             yawResult -= 360.0;
         posFused.setYaw(yawResult);
 
-        posFused.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
+        posFused.setTimestamp_ns(utcTime::now_ns());
         vehicleState->setPosition(posFused);
     }
 }
 
+void SDVPVehiclePositionFuser::correctYawGNSSHeading(QSharedPointer<VehicleState> vehicleState, double yaw_degENU, double yawStdDev_deg, qint64 timestamp_ns)
+{
+    if (mPosGNSSisFused || yawStdDev_deg > mGNSSHeadingMaxStdDev_deg)
+        return;
+
+    PosPoint posFused = vehicleState->getPosition(PosType::fused);
+
+    // Heading is old when it arrives, compare to fused yaw at its time. It is absolute, i.e., no need to wait for motion:
+    // taken as is when there was none recently (e.g., start-up), weighted afterwards
+    PosSample closestPosFusedSample = getPosFusedSampleAtTime(timestamp_ns, posFused);
+    double yawError = yaw_degENU - closestPosFusedSample.yaw;
+    while (yawError < -180.0) yawError += 360.0;
+    while (yawError > 180.0) yawError -= 360.0;
+    const double stepYaw = yawError * (hasRecentGNSSHeading(timestamp_ns) ? mPosGNSSHeadingGain : 1.0);
+
+    mPosIMUyawOffset += stepYaw;
+    double yawResult = posFused.getYaw() + stepYaw;
+    while (yawResult < -180.0)
+        yawResult += 360.0;
+    while (yawResult >= 180.0)
+        yawResult -= 360.0;
+    posFused.setYaw(yawResult);
+
+    posFused.setTimestamp_ns(utcTime::now_ns());
+    vehicleState->setPosition(posFused);
+    mLastGNSSHeading_ns = timestamp_ns;
+}
+
+void SDVPVehiclePositionFuser::correctPositionUWB(QSharedPointer<VehicleState> vehicleState)
+{
+    if (mPosGNSSisFused)
+        return;
+
+    PosPoint posUWB = vehicleState->getPosition(PosType::UWB);
+    PosPoint posFused = vehicleState->getPosition(PosType::fused);
+    if (posUWB.getSigma() > mUWBMaxStdDev_m)
+        return;
+
+    // 1. Like GNSS, UWB is old when it arrives. Gate by the error towards the sampled position at its time
+    PosSample closestPosFusedSample = getPosFusedSampleAtTime(posUWB.getTimestamp_ns(), posFused);
+    QPointF posErrorCmpToUWB = posUWB.getPoint() - closestPosFusedSample.posXY;
+    const bool recentGNSS = hasRecentGNSSPosition(posUWB.getTimestamp_ns());
+
+    if (QLineF(QPointF(), posErrorCmpToUWB).length() > mUWBMaxInnovation_m) {
+        // 2a. Outlier, or fused position is off (e.g., GNSS lost on the way indoors): take UWB if it insists and GNSS does not disagree
+        if (++mUWBRejectedInRow < UWB_MAX_REJECTED_IN_ROW || recentGNSS)
+            return;
+
+        qDebug() << "SDVPVehiclePositionFuser: fused position jumps to UWB position after" << mUWBRejectedInRow << "rejected UWB positions";
+        posFused.setXY(posUWB.getX(), posUWB.getY());
+    } else {
+        // 2b. Step towards UWB position, limited depending on the distance driven
+        double xyStepSize = mPosUWBxyStaticGain + fabs(mPosOdomDistanceDrivenSinceUWBupdate) * mPosUWBxyDynamicGain;
+        posFused.setX(posFused.getX() + getMaxSignedStepFromValueTowardsGoal(closestPosFusedSample.posXY.x(), posUWB.getX(), xyStepSize));
+        posFused.setY(posFused.getY() + getMaxSignedStepFromValueTowardsGoal(closestPosFusedSample.posXY.y(), posUWB.getY(), xyStepSize));
+    }
+
+    if (!recentGNSS)
+        posFused.setHeight(posUWB.getHeight());
+    posFused.setTimestamp_ns(utcTime::now_ns());
+    vehicleState->setPosition(posFused);
+    mPosOdomDistanceDrivenSinceUWBupdate = 0.0;
+    mUWBRejectedInRow = 0;
+}
+
 void SDVPVehiclePositionFuser::setPosGNSSxyStaticGain(double posGNSSxyStaticGain)
 {
     mPosGNSSxyStaticGain = posGNSSxyStaticGain;
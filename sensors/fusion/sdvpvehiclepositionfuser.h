@@ -12,8 +12,13 @@
  *      The yaw offset from GNSS allows to calculate the absolute yaw. The offset is fixed at standstill to counter IMU drift.
  *  - Odom feedback also arrives more frequently than GNSS. The driven distance received and the "fused" yaw are used to update the "fused" position inbetween input from GNSS.
  *      The resulting "fused" position and yaw are sampled in a history buffer.
- *  - When a new GNSS position arrives, the time-wise closest "fused" position in the history buffer is taken to calculate the position error towards the new GNSS position at the GNSS position's time.
+ *  - When a new GNSS position arrives, the "fused" position at the GNSS position's time is interpolated from the history buffer to calculate the position error towards the new GNSS position.
  *      The resulting error is applied to the current "fused" position with weights (static and dynamic, based on distance moved). Yaw is updated similarly.
+ *  - A direct yaw measurement (e.g., dual-antenna GNSS heading) corrects the yaw offset also at standstill and replaces the yaw from consecutive
+ *      GNSS positions while it keeps arriving.
+ *  - UWB positions (e.g., indoors) correct the "fused" position like GNSS positions, with separate gains. They are gated by their distance to the
+ *      "fused" position at their time. Consistently rejected UWB positions are taken as is when there is no recent GNSS position (e.g., after
+ *      entering a building), i.e., the handover between GNSS and UWB is weighted and only jumps when the sources disagree persistently.
  */
 
 #ifndef SDVPVEHICLEPOSITIONFUSER_H
@@ -22,6 +27,7 @@
 #include <QObject>
 #include <QSharedPointer>
 #include "vehicles/vehiclestate.h"
+#include "core/timestampedhistory.h"
 
 class SDVPVehiclePositionFuser : public QObject
 {
@@ -31,38 +37,70 @@ public:
     void correctPositionAndYawGNSS(QSharedPointer<VehicleState> vehicleState, double distanceMoved, bool fused);
     void correctPositionAndYawOdom(QSharedPointer<VehicleState> vehicleState, double distanceDriven);
     void correctPositionAndYawIMU(QSharedPointer<VehicleState> vehicleState);
+    // E.g., from UbloxRover::updatedGNSSHeading, measurements less accurate than the maximum standard deviation are ignored
+    void correctYawGNSSHeading(QSharedPointer<VehicleState> vehicleState, double yaw_degENU, double yawStdDev_deg, qint64 timestamp_ns);
+    // E.g., from PozyxPositionUpdater::updatedUWBPositionAndYaw, uses the PosType::UWB position (its yaw is not used)
+    void correctPositionUWB(QSharedPointer<VehicleState> vehicleState);
 
     void setPosGNSSxyStaticGain(double posGNSSxyStaticGain);
     void setPosGNSSyawGain(double posGNSSyawGain);
+    void setPosGNSSHeadingGain(double posGNSSHeadingGain) { mPosGNSSHeadingGain = posGNSSHeadingGain; }
+    double getGNSSHeadingMaxStdDev() const { return mGNSSHeadingMaxStdDev_deg; }
+    void setGNSSHeadingMaxStdDev(double gnssHeadingMaxStdDev_deg) { mGNSSHeadingMaxStdDev_deg = gnssHeadingMaxStdDev_deg; }
 
     double getPosGNSSxyDynamicGain() const;
     void setPosGNSSxyDynamicGain(double posGNSSxyDynamicGain);
 
+    void setPosUWBxyStaticGain(double posUWBxyStaticGain) { mPosUWBxyStaticGain = posUWBxyStaticGain; }
+    void setPosUWBxyDynamicGain(double posUWBxyDynamicGain) { mPosUWBxyDynamicGain = posUWBxyDynamicGain; }
+    // UWB positions further away from the "fused" position (or with a larger sigma, if set) are rejected [m]
+    double getUWBMaxInnovation() const { return mUWBMaxInnovation_m; }
+    void setUWBMaxInnovation(double uwbMaxInnovation_m) { mUWBMaxInnovation_m = uwbMaxInnovation_m; }
+    double getUWBMaxStdDev() const { return mUWBMaxStdDev_m; }
+    void setUWBMaxStdDev(double uwbMaxStdDev_m) { mUWBMaxStdDev_m = uwbMaxStdDev_m; }
+
+    // Number of odometry updates kept, needs to cover GNSS latency (clears the history)
+    int getPosFusedHistorySize() const { return mPosFusedHistory.getCapacity(); }
+    void setPosFusedHistorySize(int posFusedHistorySize) { mPosFusedHistory.setCapacity(posFusedHistorySize); }
+
 signals:
 
 private:
     struct PosSample {
         QPointF posXY;
         double yaw;
-        QTime timestamp;
     };
 
     double getMaxSignedStepFromValueTowardsGoal(double value, double goal, double maxStepSize);
 
     void samplePosFused(const PosPoint &posFused);
-    PosSample getClosestPosFusedSampleInTime(QTime timeUTC);
+    PosSample getPosFusedSampleAtTime(qint64 timestamp_ns, const PosPoint &posFused) const;
+    bool hasRecentGNSSHeading(qint64 timestamp_ns) const;
+    bool hasRecentGNSSPosition(qint64 timestamp_ns) const;
 
     double mPosIMUyawOffset = 0.0;
     bool mPosGNSSisFused = false; // use GNSS pos as "fused" pos when true, e.g., F9R
     double mPosGNSSxyStaticGain = 0.05;
     double mPosGNSSxyDynamicGain = 0.1;
     double mPosGNSSyawGain = 1.0;
+    double mPosGNSSHeadingGain = 0.5;
+    double mGNSSHeadingMaxStdDev_deg = 5.0;
+    qint64 mLastGNSSHeading_ns = utcTime::INVALID;
+    static constexpr qint64 GNSS_HEADING_TIMEOUT_ns = 2000000000; // falls back to yaw from GNSS positions
     double mPosOdomDistanceDrivenSinceGNSSupdate = std::numeric_limits<double>::min();
+    qint64 mLastGNSSPosition_ns = utcTime::INVALID;
+    static constexpr qint64 GNSS_POSITION_TIMEOUT_ns = 1000000000; // UWB can take over
+    double mPosUWBxyStaticGain = 0.05;
+    double mPosUWBxyDynamicGain = 0.1;
+    double mUWBMaxInnovation_m = 1.0;
+    double mUWBMaxStdDev_m = 0.5;
+    double mPosOdomDistanceDrivenSinceUWBupdate = 0.0;
+    int mUWBRejectedInRow = 0;
+    static constexpr int UWB_MAX_REJECTED_IN_ROW = 10; // then taken as is, if GNSS is not recent
     static constexpr double BIG_DISTANCE_ERROR_m = 50.0;
 
     static constexpr int POSFUSED_HISTORY_SIZE = 128;
-    PosSample mPosFusedHistory[POSFUSED_HISTORY_SIZE];
-    int mPosFusedHistoryCurrentIdx = 0;
+    TimestampedHistory<PosSample> mPosFusedHistory{POSFUSED_HISTORY_SIZE}; // timestamps: UTC [ns]
 };
 
 #endif // SDVPVEHICLEPOSITIONFUSER_H
@@ -15,6 +15,8 @@ GNSSReceiver::GNSSReceiver(QSharedPointer<VehicleState> vehicleState)
 
 void GNSSReceiver::setEnuRef(llh_t enuRef)
 {
+    if (mEnuReferenceSet && mVehicleState)
+        mVehicleState->reprojectEnu(coordinateTransforms::EnuFrame(mEnuReference).getTransformTo(coordinateTransforms::EnuFrame(enuRef)));
     mEnuReference = enuRef;
     mEnuReferenceSet = true;
     emit updatedEnuReference(mEnuReference);
@@ -21,6 +21,7 @@ public:
     GNSSReceiver(QSharedPointer<VehicleState> vehicleState);
 
     virtual llh_t getEnuRef() const { return mEnuReference; }
+    // Converts the vehicle's positions to the new reference if one was set before
     virtual void setEnuRef(llh_t enuRef);
     virtual void setIMUOrientationOffset(double roll_deg, double pitch_deg, double yaw_deg);
     virtual void setGNSSPositionOffset(double xOffset, double yOffset);
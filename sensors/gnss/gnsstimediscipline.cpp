@@ -0,0 +1,328 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "gnsstimediscipline.h"
+#include "core/threadconfig.h"
+#include <QDebug>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <linux/pps.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr qint64 NS_PER_S = 1000 * utcTime::NS_PER_MS;
+constexpr qint64 SECONDS_PER_WEEK = 7 * 24 * 60 * 60;
+constexpr qint64 MS_PER_WEEK = SECONDS_PER_WEEK * 1000;
+}
+
+GnssTimeDiscipline::GnssTimeDiscipline(QObject *parent) : QObject(parent)
+{
+    connect(&mTimeoutTimer, &QTimer::timeout, this, &GnssTimeDiscipline::checkTimeout);
+    mTimeoutTimer.start(1000);
+}
+
+GnssTimeDiscipline::~GnssTimeDiscipline()
+{
+    stopPps();
+    setUblox(nullptr);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mTimeSourcePublished)
+        utcTime::clearTimeSource();
+}
+
+void GnssTimeDiscipline::setUblox(Ublox *ublox)
+{
+    if (mUblox)
+        for (int subscriptionId : mSubscriptionIds)
+            mUblox->unsubscribe(subscriptionId);
+    mSubscriptionIds.clear();
+
+    mUblox = ublox;
+    if (!mUblox)
+        return;
+
+    mSubscriptionIds.append(mUblox->subscribeDecoded<ubx_tim_tp>([this](const ubx_tim_tp &tp) { updateTimTp(tp); }));
+    mSubscriptionIds.append(mUblox->subscribeDecoded<ubx_nav_pvt>([this](const ubx_nav_pvt &pvt) { updateNavPvt(pvt); }));
+}
+
+void GnssTimeDiscipline::addTimTpOutput(UbloxCfgBuilder &cfg, UbloxCfgBuilder::Port port)
+{
+    cfg.setMessageRate(CFG_MSGOUT_UBX_TIM_TP, port, 1);
+}
+
+bool GnssTimeDiscipline::startPps(const QString &device)
+{
+    stopPps();
+
+#ifdef Q_OS_LINUX
+    const QByteArray path = device.toLocal8Bit();
+    int fd = open(path.constData(), O_RDWR);
+    if (fd < 0) // capture mode cannot be set then, the default may do
+        fd = open(path.constData(), O_RDONLY);
+    if (fd < 0) {
+        qWarning() << "WARNING: GnssTimeDiscipline could not open" << device << ":" << strerror(errno);
+        return false;
+    }
+
+    int capabilities = 0;
+    if (ioctl(fd, PPS_GETCAP, &capabilities) < 0 || !(capabilities & PPS_CAPTUREASSERT)) {
+        qWarning() << "WARNING: GnssTimeDiscipline:" << device << "is no PPS device with assert capture";
+        close(fd);
+        return false;
+    }
+
+    pps_kparams parameters;
+    if (ioctl(fd, PPS_GETPARAMS, &parameters) == 0 && !(parameters.mode & PPS_CAPTUREASSERT)) {
+        parameters.mode |= PPS_CAPTUREASSERT;
+        if (ioctl(fd, PPS_SETPARAMS, &parameters) < 0)
+            qWarning() << "WARNING: GnssTimeDiscipline could not enable assert capture on" << device << ":" << strerror(errno);
+    }
+
+    mPpsDevice = device;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStatus.ppsRunning = true;
+    }
+    mPpsRunning = true;
+    mPpsThread = std::thread([this, fd]() { readPps(fd); });
+    return true;
+#else
+    qWarning() << "WARNING: GnssTimeDiscipline PPS input is only supported on Linux, cannot read" << device;
+    return false;
+#endif
+}
+
+void GnssTimeDiscipline::stopPps()
+{
+    mPpsRunning = false;
+    if (mPpsThread.joinable())
+        mPpsThread.join(); // PPS_FETCH times out within a second
+}
+
+void GnssTimeDiscipline::readPps(int fd)
+{
+    ThreadConfig::getInstance().applyToCurrentThread(ThreadConfig::Role::GnssIo);
+
+#ifdef Q_OS_LINUX
+    while (mPpsRunning) {
+        pps_fdata data;
+        memset(&data, 0, sizeof(data));
+        data.timeout.sec = 1; // flags without PPS_TIME_INVALID: the timeout is used
+        if (ioctl(fd, PPS_FETCH, &data) < 0) {
+            if (errno == ETIMEDOUT || errno == EINTR)
+                continue;
+            qWarning() << "WARNING: GnssTimeDiscipline stopped reading" << mPpsDevice << ":" << strerror(errno);
+            break;
+        }
+
+        // The kernel timestamps in CLOCK_REALTIME (the system clock), its current offset to the steady clock is taken
+        // between two steady clock reads
+        const qint64 edgeSystem_ns = qint64(data.info.assert_tu.sec) * NS_PER_S + data.info.assert_tu.nsec;
+        const qint64 steadyBefore_ns = utcTime::steadyNow_ns();
+        const qint64 system_ns = utcTime::systemNow_ns();
+        const qint64 steadyAfter_ns = utcTime::steadyNow_ns();
+        addPulse(edgeSystem_ns + steadyBefore_ns + (steadyAfter_ns - steadyBefore_ns) / 2 - system_ns);
+    }
+    close(fd);
+#else
+    (void)fd;
+#endif
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStatus.ppsRunning = false;
+}
+
+void GnssTimeDiscipline::addPulse(qint64 steady_ns)
+{
+    bool locked;
+    bool lockChangedNow;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStatus.pulses++;
+        mStatus.lastPulseSteady_ns = steady_ns;
+
+        qint64 local_ns = steady_ns;
+        qint64 utc_ns = utcTime::INVALID;
+        if (utcTime::isValid(mTimTpLabel.utc_ns) && steady_ns >= mTimTpLabel.rx_ns && steady_ns - mTimTpLabel.rx_ns <= MAX_LABEL_AGE_NS) {
+            utc_ns = mTimTpLabel.utc_ns;
+            local_ns = steady_ns - mTimTpLabel.quantizationError_ns; // edge at the ideal time plus the quantization error
+            mTimTpLabel = PulseLabel(); // labels one pulse
+        } else if (utcTime::isValid(mPvtLabel.utc_ns) && steady_ns >= mPvtLabel.rx_ns && steady_ns - mPvtLabel.rx_ns <= MAX_PVT_AGE_NS) {
+            const qint64 estimate_ns = mPvtLabel.utc_ns + (steady_ns - mPvtLabel.rx_ns) + ASSUMED_PVT_LATENCY_NS;
+            utc_ns = (estimate_ns + NS_PER_S / 2) / NS_PER_S * NS_PER_S;
+        }
+
+        bool fitChanged = false;
+        if (!utcTime::isValid(utc_ns)) {
+            mStatus.unlabeledPulses++;
+        } else {
+            bool accepted = true;
+            double residual_ns = 0.0;
+            if (mEstimator.isSynchronized()) {
+                residual_ns = double(mEstimator.toLocal_ns(utc_ns) - local_ns);
+                if (std::abs(residual_ns) > MAX_RESIDUAL_NS) {
+                    mStatus.rejectedPulses++;
+                    accepted = false;
+                    if (++mRejectedInARow >= MAX_REJECTED_IN_A_ROW) {
+                        qWarning() << "WARNING: GnssTimeDiscipline: time pulses contradict the fit, starting over";
+                        mEstimator.reset();
+                        accepted = true;
+                        residual_ns = 0.0;
+                    }
+                }
+            }
+
+            if (accepted) {
+                mRejectedInARow = 0;
+                mStatus.lastResidual_ns = residual_ns;
+                fitChanged = mEstimator.addObservation(local_ns, utc_ns);
+            }
+        }
+
+        lockChangedNow = updateLockState(steady_ns, fitChanged);
+        locked = mStatus.locked;
+    }
+
+    if (lockChangedNow)
+        emit lockChanged(locked);
+}
+
+void GnssTimeDiscipline::setUtcTimeSource(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mUseAsUtcTimeSource = enabled;
+    if (!enabled && mTimeSourcePublished) {
+        utcTime::clearTimeSource();
+        mTimeSourcePublished = false;
+    }
+}
+
+bool GnssTimeDiscipline::isLocked() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStatus.locked;
+}
+
+qint64 GnssTimeDiscipline::steadyToUtc_ns(qint64 steady_ns) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEstimator.toRemote_ns(steady_ns);
+}
+
+qint64 GnssTimeDiscipline::now_ns() const
+{
+    return steadyToUtc_ns(utcTime::steadyNow_ns());
+}
+
+GnssTimeDisciplineStatus GnssTimeDiscipline::getStatus() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStatus;
+}
+
+void GnssTimeDiscipline::updateTimTp(const ubx_tim_tp &tp)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // GLONASS, BeiDou and Galileo time bases have their own week numbers and offsets
+    if (!tp.utc && tp.time_ref_gnss != 0) {
+        if (!mUnsupportedTimeBaseWarned)
+            qWarning() << "WARNING: GnssTimeDiscipline ignores TIM-TP in time base" << tp.time_ref_gnss << "(UTC or GPS are supported)";
+        mUnsupportedTimeBaseWarned = true;
+        return;
+    }
+
+    // Weeks and time of week since the GPS epoch, in UTC without leap seconds (like Unix time) or in GPS time
+    qint64 utc_ns = (GPS_EPOCH_UNIX_S + qint64(tp.week) * SECONDS_PER_WEEK) * NS_PER_S + qint64(tp.tow_ms) * utcTime::NS_PER_MS +
+            ((qint64(tp.tow_sub_ms) * utcTime::NS_PER_MS) >> 32);
+    if (!tp.utc)
+        utc_ns -= mLeapSeconds * NS_PER_S;
+
+    mTimTpLabel.utc_ns = utc_ns;
+    mTimTpLabel.rx_ns = tp.rx_time_ns;
+    mTimTpLabel.quantizationError_ns = tp.q_err_invalid ? 0 : std::lround(tp.q_err_ps * 1e-3);
+}
+
+void GnssTimeDiscipline::updateNavPvt(const ubx_nav_pvt &pvt)
+{
+    if (!pvt.valid_date || !pvt.valid_time)
+        return;
+
+    const qint64 utc_ns = utcTime::fromCalendar(pvt.year, pvt.month, pvt.day, pvt.hour, pvt.min, pvt.second, pvt.nano);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPvtLabel.utc_ns = utc_ns;
+    mPvtLabel.rx_ns = pvt.rx_time_ns;
+
+    // Leap seconds: GPS time of week (iTOW) - UTC time of week, once UTC is fully resolved
+    if (pvt.fully_resolved) {
+        const qint64 utcTimeOfWeek_ms = (utc_ns / utcTime::NS_PER_MS - GPS_EPOCH_UNIX_S * 1000) % MS_PER_WEEK;
+        qint64 difference_ms = qint64(pvt.i_tow) - utcTimeOfWeek_ms;
+        if (difference_ms < -MS_PER_WEEK / 2)
+            difference_ms += MS_PER_WEEK;
+        else if (difference_ms > MS_PER_WEEK / 2)
+            difference_ms -= MS_PER_WEEK;
+
+        const int leapSeconds = int(std::lround(difference_ms * 1e-3));
+        if (leapSeconds >= 0 && leapSeconds < 100)
+            mLeapSeconds = leapSeconds;
+    }
+}
+
+void GnssTimeDiscipline::checkTimeout()
+{
+    bool locked;
+    bool lockChangedNow;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        lockChangedNow = updateLockState(utcTime::steadyNow_ns(), false);
+        locked = mStatus.locked;
+    }
+
+    if (lockChangedNow)
+        emit lockChanged(locked);
+}
+
+bool GnssTimeDiscipline::updateLockState(qint64 steadyNow_ns, bool fitChanged)
+{
+    const qint64 sinceLastPulse_ns = utcTime::isValid(mStatus.lastPulseSteady_ns) ? steadyNow_ns - mStatus.lastPulseSteady_ns : -1;
+    const bool recentPulse = sinceLastPulse_ns >= 0 && sinceLastPulse_ns <= LOCK_TIMEOUT_MS * utcTime::NS_PER_MS;
+    if (mEstimator.isSynchronized() && !recentPulse && sinceLastPulse_ns > MAX_HOLDOVER_S * NS_PER_S) {
+        qWarning() << "WARNING: GnssTimeDiscipline: no time pulse for" << MAX_HOLDOVER_S << "s, holdover ends";
+        mEstimator.reset();
+    }
+
+    const bool wasLocked = mStatus.locked;
+    const bool synchronized = mEstimator.isSynchronized();
+    mStatus.locked = synchronized && recentPulse;
+    mStatus.holdover = synchronized && !recentPulse;
+    mStatus.offset_ns = mEstimator.getOffset_ns();
+    mStatus.skew_ppm = mEstimator.getSkew_ppm();
+    mStatus.leapSeconds = mLeapSeconds;
+
+    if (mUseAsUtcTimeSource) {
+        if (synchronized && fitChanged) {
+            utcTime::SteadyToUtcMapping mapping;
+            mapping.valid = true;
+            mapping.referenceSteady_ns = mStatus.lastPulseSteady_ns;
+            mapping.referenceUtc_ns = mEstimator.toRemote_ns(mapping.referenceSteady_ns);
+            mapping.rate = 1.0 / (1.0 + mEstimator.getSkew_ppm() * 1e-6);
+            utcTime::setTimeSource(mapping);
+            mTimeSourcePublished = true;
+        } else if (!synchronized && mTimeSourcePublished) {
+            utcTime::clearTimeSource();
+            mTimeSourcePublished = false;
+        }
+    }
+
+    if (wasLocked != mStatus.locked)
+        qDebug() << "GnssTimeDiscipline:" << (mStatus.locked ? "locked to the time pulse" : "lost the time pulse");
+    return wasLocked != mStatus.locked;
+}
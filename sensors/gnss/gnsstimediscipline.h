@@ -0,0 +1,115 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Disciplines WayWise timestamps to the GNSS receiver's time pulse: the pulse edges are timestamped by the kernel (Linux PPS,
+ * e.g., /dev/pps0 from pps-gpio) and labelled with their UTC time from the TIM-TP message that precedes each pulse (corrected
+ * by its quantization error), or, without TIM-TP, from the last NAV-PVT (rounded to the second, the pulse is at the top of a
+ * UTC second by default). ClockSyncEstimator fits offset and skew of the steady clock to these pairs, which gives UTC of any
+ * steady clock time (e.g., UBX rx_time_ns) with the accuracy of the pulse timestamps instead of the serial latency.
+ * While locked, it is the time source of utcTime::now_ns() (see setUtcTimeSource). Without pulses it keeps the last fit for
+ * MAX_HOLDOVER_S (the steady clock drifts by its residual skew).
+ * Pulses and messages arrive on the PPS and the Ublox I/O thread, the public functions are thread-safe.
+ */
+
+#ifndef GNSSTIMEDISCIPLINE_H
+#define GNSSTIMEDISCIPLINE_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "core/clocksyncestimator.h"
+#include "core/utctime.h"
+#include "sensors/gnss/ublox.h"
+
+struct GnssTimeDisciplineStatus {
+    bool locked = false; // pulses within LOCK_TIMEOUT_MS and enough of them fitted
+    bool holdover = false; // no recent pulses, last fit still used
+    bool ppsRunning = false;
+    quint64 pulses = 0;
+    quint64 unlabeledPulses = 0; // no TIM-TP or NAV-PVT for them
+    quint64 rejectedPulses = 0; // contradicted the fit by more than MAX_RESIDUAL_NS
+    qint64 lastPulseSteady_ns = utcTime::INVALID;
+    double lastResidual_ns = 0.0; // pulse time by the fit before it was added minus its timestamp
+    double offset_ns = 0.0; // steady - UTC
+    double skew_ppm = 0.0;
+    int leapSeconds = 0;
+};
+
+class GnssTimeDiscipline : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr qint64 GPS_EPOCH_UNIX_S = 315964800; // 1980-01-06
+    static constexpr int DEFAULT_LEAP_SECONDS = 18; // GPS - UTC, until NAV-PVT has fully resolved UTC
+    static constexpr qint64 MAX_LABEL_AGE_NS = 1200 * utcTime::NS_PER_MS; // TIM-TP is sent up to a second before its pulse
+    static constexpr qint64 MAX_PVT_AGE_NS = 5000 * utcTime::NS_PER_MS; // for labelling pulses without TIM-TP
+    static constexpr qint64 ASSUMED_PVT_LATENCY_NS = 100 * utcTime::NS_PER_MS; // navigation epoch to reception, labels are right within +-0.5 s of it
+    static constexpr qint64 MAX_RESIDUAL_NS = 20 * utcTime::NS_PER_MS;
+    static constexpr int MAX_REJECTED_IN_A_ROW = 3; // then the fit starts over (e.g., the system clock was stepped)
+    static constexpr int LOCK_TIMEOUT_MS = 2500;
+    static constexpr int MAX_HOLDOVER_S = 60;
+
+    explicit GnssTimeDiscipline(QObject *parent = nullptr);
+    ~GnssTimeDiscipline();
+
+    // Subscribes to TIM-TP and NAV-PVT, needs to be done while ublox is disconnected (see Ublox::subscribeDecoded)
+    void setUblox(Ublox *ublox);
+    // CFG-MSGOUT for TIM-TP (once per time pulse) on port, e.g., in addition to a receiver's configuration
+    static void addTimTpOutput(UbloxCfgBuilder &cfg, UbloxCfgBuilder::Port port);
+
+    // Reads pulses from a Linux PPS device on its own thread (GnssIo settings of ThreadConfig). false if it cannot be opened.
+    bool startPps(const QString &device = "/dev/pps0");
+    void stopPps();
+    // Pulse from another source, steady_ns: steady clock time of the edge
+    void addPulse(qint64 steady_ns);
+
+    // Publish the fit as utcTime's time source while locked or in holdover (default: true)
+    void setUtcTimeSource(bool enabled);
+
+    bool isLocked() const;
+    qint64 steadyToUtc_ns(qint64 steady_ns) const; // utcTime::INVALID without a fit
+    qint64 now_ns() const;
+    GnssTimeDisciplineStatus getStatus() const;
+
+signals:
+    void lockChanged(bool locked); // emitted from the thread that caused the change
+
+private:
+    struct PulseLabel {
+        qint64 utc_ns = utcTime::INVALID;
+        qint64 rx_ns = utcTime::INVALID; // steady clock
+        qint64 quantizationError_ns = 0;
+    };
+
+    void updateTimTp(const ubx_tim_tp &tp);
+    void updateNavPvt(const ubx_nav_pvt &pvt);
+    void readPps(int fd);
+    void checkTimeout();
+    bool updateLockState(qint64 steadyNow_ns, bool fitChanged); // with mMutex held, true if locked changed
+
+    QPointer<Ublox> mUblox;
+    QVector<int> mSubscriptionIds;
+    QTimer mTimeoutTimer;
+
+    std::atomic<bool> mPpsRunning{false};
+    std::thread mPpsThread;
+    QString mPpsDevice;
+
+    mutable std::mutex mMutex;
+    ClockSyncEstimator mEstimator; // local: steady clock, remote: UTC
+    PulseLabel mTimTpLabel;
+    PulseLabel mPvtLabel; // time of the navigation epoch
+    int mLeapSeconds = DEFAULT_LEAP_SECONDS;
+    bool mUnsupportedTimeBaseWarned = false;
+    int mRejectedInARow = 0;
+    bool mUseAsUtcTimeSource = true;
+    bool mTimeSourcePublished = false;
+    GnssTimeDisciplineStatus mStatus;
+};
+
+#endif // GNSSTIMEDISCIPLINE_H
@@ -0,0 +1,208 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "ntripcasterselector.h"
+#include <QDebug>
+#include <QFile>
+
+NtripCasterSelector::NtripCasterSelector(QObject *parent) : QObject(parent)
+{
+    connect(&mEvaluationTimer, &QTimer::timeout, this, &NtripCasterSelector::evaluate);
+}
+
+void NtripCasterSelector::addCaster(const NtripCaster &caster)
+{
+    if (isRunning()) {
+        qWarning() << "WARNING: NtripCasterSelector cannot add casters while running";
+        return;
+    }
+
+    const int index = mCasters.size();
+    QSharedPointer<RtcmClient> client = QSharedPointer<RtcmClient>::create();
+    client->setGgaInterval_ms(mGgaInterval_ms);
+    connect(client.data(), &RtcmClient::rtcmData, this, [this, index](const QByteArray &data){
+        if (index == mActive)
+            emit rtcmData(data);
+    });
+    connect(client.data(), &RtcmClient::baseStationPosition, this, [this, index](const llh_t &position){
+        if (index == mActive)
+            emit baseStationPosition(position);
+    });
+
+    mCasters.append(caster);
+    mClients.append(client);
+    mProbeHealth.append(RtcmClientHealth());
+    mProbeTime_ns.append(utcTime::INVALID);
+}
+
+bool NtripCasterSelector::addCastersFromFile(QString filePath)
+{
+    QFile casterFile(filePath);
+    if (!casterFile.open(QIODevice::ReadOnly)) {
+        qWarning() << "WARNING: NtripCasterSelector was unable to open" << filePath;
+        return false;
+    }
+
+    QStringList lines;
+    while (!casterFile.atEnd()) {
+        const QString line = QString(casterFile.readLine()).trimmed();
+        if (!line.isEmpty())
+            lines.append(line);
+        if ((line.isEmpty() || casterFile.atEnd()) && !lines.isEmpty()) {
+            if (lines.size() != 5) {
+                qWarning() << "WARNING: NtripCasterSelector skipped an incomplete caster in" << filePath;
+            } else
+                addCaster({lines.at(0), lines.at(1).toShort(), {lines.at(2), lines.at(3), lines.at(4)}});
+            lines.clear();
+        }
+    }
+
+    return !mCasters.isEmpty();
+}
+
+bool NtripCasterSelector::start(int index)
+{
+    if (index < 0 || index >= mCasters.size())
+        return false;
+
+    stop();
+    activate(index);
+    mLastProbeStart_ns = utcTime::now_ns();
+    mNextProbe = index + 1;
+    mEvaluationTimer.start(EVALUATION_INTERVAL_MS);
+    return true;
+}
+
+void NtripCasterSelector::stop()
+{
+    mEvaluationTimer.stop();
+    for (const auto &client : mClients) {
+        client->setAutoReconnect(false);
+        client->disconnect();
+    }
+    mActive = -1;
+    mProbing = -1;
+}
+
+RtcmClientHealth NtripCasterSelector::getHealth(int index) const
+{
+    if (index == mActive || index == mProbing)
+        return mClients.at(index)->getHealth();
+    return mProbeHealth.at(index);
+}
+
+void NtripCasterSelector::setGgaInterval_ms(int ggaInterval_ms)
+{
+    mGgaInterval_ms = ggaInterval_ms;
+    for (const auto &client : mClients)
+        client->setGgaInterval_ms(ggaInterval_ms);
+}
+
+void NtripCasterSelector::forwardNmeaGgaToServer(const QByteArray &nmeaGgaStr)
+{
+    if (mActive >= 0)
+        mClients.at(mActive)->forwardNmeaGgaToServer(nmeaGgaStr);
+    if (mProbing >= 0)
+        mClients.at(mProbing)->forwardNmeaGgaToServer(nmeaGgaStr);
+}
+
+void NtripCasterSelector::connectClient(int index, bool autoReconnect)
+{
+    const NtripCaster &caster = mCasters.at(index);
+    QSharedPointer<RtcmClient> client = mClients.at(index);
+    client->setAutoReconnect(autoReconnect);
+    if (caster.info.stream.isEmpty())
+        client->connectTcp(caster.host, caster.port);
+    else
+        client->connectNtrip(caster.host, caster.port, caster.info);
+}
+
+void NtripCasterSelector::activate(int index)
+{
+    const int previous = mActive;
+    mActive = index;
+    mActivated_ns = utcTime::now_ns();
+
+    if (index == mProbing) { // already connected
+        mProbing = -1;
+        mClients.at(index)->setAutoReconnect(true);
+    } else
+        connectClient(index, true);
+
+    if (previous >= 0 && previous != index) {
+        mProbeHealth[previous] = mClients.at(previous)->getHealth();
+        mProbeTime_ns[previous] = mActivated_ns;
+        mClients.at(previous)->setAutoReconnect(false);
+        mClients.at(previous)->disconnect();
+    }
+
+    qDebug() << "NtripCasterSelector: active caster" << index << mCasters.at(index).host << mCasters.at(index).info.stream;
+    emit activeCasterChanged(index, mCasters.at(index).host);
+}
+
+bool NtripCasterSelector::isHealthy(const RtcmClientHealth &health, qint64 now_ns) const
+{
+    return health.connected && utcTime::isValid(health.lastData_ns) &&
+            now_ns - health.lastData_ns < UNHEALTHY_TIMEOUT_MS * utcTime::NS_PER_MS && health.throughput_Bps >= MIN_THROUGHPUT_BPS;
+}
+
+int NtripCasterSelector::getFailoverCandidate(qint64 now_ns) const
+{
+    // The best recent probe that was healthy, otherwise the next caster in order
+    int candidate = -1;
+    for (int i = 0; i < mCasters.size(); i++) {
+        const RtcmClientHealth &health = mProbeHealth.at(i);
+        if (i == mActive || !utcTime::isValid(mProbeTime_ns.at(i)) || now_ns - mProbeTime_ns.at(i) > 2 * qint64(PROBE_INTERVAL_MS) * utcTime::NS_PER_MS ||
+                !isHealthy(health, mProbeTime_ns.at(i)))
+            continue;
+        if (candidate < 0 || (health.meanCorrectionAge_ms >= 0.0 && (mProbeHealth.at(candidate).meanCorrectionAge_ms < 0.0 ||
+                                                                      health.meanCorrectionAge_ms < mProbeHealth.at(candidate).meanCorrectionAge_ms)))
+            candidate = i;
+    }
+    return candidate >= 0 ? candidate : (mActive + 1) % mCasters.size();
+}
+
+void NtripCasterSelector::evaluate()
+{
+    const qint64 now_ns = utcTime::now_ns();
+    const RtcmClientHealth activeHealth = mClients.at(mActive)->getHealth();
+
+    // Failover
+    if (mCasters.size() > 1 && now_ns - mActivated_ns > ACTIVATION_GRACE_MS * utcTime::NS_PER_MS && !isHealthy(activeHealth, now_ns)) {
+        const int candidate = mProbing >= 0 && isHealthy(mClients.at(mProbing)->getHealth(), now_ns) ? mProbing : getFailoverCandidate(now_ns);
+        qWarning() << "WARNING: NtripCasterSelector: caster" << mActive << mCasters.at(mActive).host << "is unhealthy, failing over to" << candidate;
+        activate(candidate);
+        return;
+    }
+
+    // Finish the probe, switch when it is clearly better
+    if (mProbing >= 0 && now_ns - mProbeStart_ns >= PROBE_DURATION_MS * utcTime::NS_PER_MS) {
+        const int probed = mProbing;
+        const RtcmClientHealth probeHealth = mClients.at(probed)->getHealth();
+        mProbeHealth[probed] = probeHealth;
+        mProbeTime_ns[probed] = now_ns;
+
+        if (isHealthy(probeHealth, now_ns) && probeHealth.meanCorrectionAge_ms >= 0.0 &&
+                (activeHealth.meanCorrectionAge_ms < 0.0 || probeHealth.meanCorrectionAge_ms + SWITCH_MARGIN_MS < activeHealth.meanCorrectionAge_ms)) {
+            qDebug() << "NtripCasterSelector: caster" << probed << "has a lower correction age:" << probeHealth.meanCorrectionAge_ms
+                     << "ms vs" << activeHealth.meanCorrectionAge_ms << "ms";
+            activate(probed);
+        } else {
+            mProbing = -1;
+            mClients.at(probed)->disconnect();
+        }
+        return;
+    }
+
+    // Start the next probe
+    if (mProbing < 0 && mCasters.size() > 1 && now_ns - mLastProbeStart_ns >= PROBE_INTERVAL_MS * utcTime::NS_PER_MS) {
+        if (mNextProbe % mCasters.size() == mActive)
+            mNextProbe++;
+        mProbing = mNextProbe % mCasters.size();
+        mNextProbe = mProbing + 1;
+        mProbeStart_ns = now_ns;
+        mLastProbeStart_ns = now_ns;
+        connectClient(mProbing, false);
+    }
+}
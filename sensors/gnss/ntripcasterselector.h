@@ -0,0 +1,86 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Failover between several NTRIP casters (or mountpoints), each with its own RtcmClient. Only the active caster is forwarded
+ * (rtcmData, baseStationPosition). It reconnects with backoff, but when it stays unhealthy (no data or too low throughput) the
+ * selector fails over to the best recently probed caster, or the next one in order. Standby casters are probed one at a time,
+ * round-robin every PROBE_INTERVAL_MS for PROBE_DURATION_MS, and a probe that has a lower mean correction age than the active
+ * caster by SWITCH_MARGIN_MS becomes active without a gap (it is already connected).
+ */
+
+#ifndef NTRIPCASTERSELECTOR_H
+#define NTRIPCASTERSELECTOR_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+#include "sensors/gnss/rtcmclient.h"
+
+struct NtripCaster {
+    QString host;
+    qint16 port;
+    NtripConnectionInfo info; // empty stream: plain TCP
+};
+
+class NtripCasterSelector : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int EVALUATION_INTERVAL_MS = 1000;
+    static constexpr int PROBE_INTERVAL_MS = 120000;
+    static constexpr int PROBE_DURATION_MS = 15000;
+    static constexpr int ACTIVATION_GRACE_MS = 15000; // before a newly active caster can be unhealthy
+    static constexpr int UNHEALTHY_TIMEOUT_MS = 5000; // without data
+    static constexpr double MIN_THROUGHPUT_BPS = 50.0;
+    static constexpr double SWITCH_MARGIN_MS = 250.0;
+
+    explicit NtripCasterSelector(QObject *parent = nullptr);
+
+    // Casters can only be added while not started, ordered by preference
+    void addCaster(const NtripCaster &caster);
+    // Blocks in the format of RtcmClient::connectWithInfoFromFile (host, port, user, password, stream), separated by empty lines
+    bool addCastersFromFile(QString filePath);
+    int getCasterCount() const { return mCasters.size(); }
+    NtripCaster getCaster(int index) const { return mCasters.at(index); }
+    QSharedPointer<RtcmClient> getClient(int index) const { return mClients.at(index); } // e.g., to configure its filter
+
+    bool start(int index = 0);
+    void stop();
+    bool isRunning() const { return mEvaluationTimer.isActive(); }
+    int getActiveCaster() const { return mActive; }
+    // Live for connected casters, otherwise of the last probe
+    RtcmClientHealth getHealth(int index) const;
+
+    void setGgaInterval_ms(int ggaInterval_ms);
+    void forwardNmeaGgaToServer(const QByteArray& nmeaGgaStr); // to the active and the probed caster
+
+signals:
+    void rtcmData(const QByteArray &data);
+    void baseStationPosition(const llh_t &baseStationPosition);
+    void activeCasterChanged(int index, const QString &host);
+
+private:
+    void connectClient(int index, bool autoReconnect);
+    void activate(int index);
+    void evaluate();
+    bool isHealthy(const RtcmClientHealth &health, qint64 now_ns) const;
+    int getFailoverCandidate(qint64 now_ns) const;
+
+    QVector<NtripCaster> mCasters;
+    QVector<QSharedPointer<RtcmClient>> mClients;
+    QVector<RtcmClientHealth> mProbeHealth;
+    QVector<qint64> mProbeTime_ns;
+    int mGgaInterval_ms = RtcmClient::DEFAULT_GGA_INTERVAL_MS;
+
+    QTimer mEvaluationTimer;
+    int mActive = -1;
+    qint64 mActivated_ns = utcTime::INVALID;
+    int mProbing = -1;
+    qint64 mProbeStart_ns = utcTime::INVALID;
+    qint64 mLastProbeStart_ns = utcTime::INVALID;
+    int mNextProbe = 0;
+};
+
+#endif // NTRIPCASTERSELECTOR_H
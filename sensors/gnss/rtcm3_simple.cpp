@@ -7,6 +7,7 @@
 // https://github.com/tomojitakasu/RTKLIB
 
 #include "rtcm3_simple.h"
+#include "rtcmbits.h"
 #include <math.h>
 #include <string.h>
 #include <stdio.h>
@@ -21,6 +22,7 @@
 #define FREQ6           D(1.27875E9)        // E6/LEX frequency (Hz)
 #define FREQ7           D(1.20714E9)        // E5b    frequency (Hz)
 #define FREQ8           D(1.191795E9)       // E5a+b  frequency (Hz)
+#define FREQ1_CMP       D(1.561098E9)       // BeiDou B1I frequency (Hz)
 #define FREQ1_GLO       D(1.60200E9)        // GLONASS L1 base frequency (Hz)
 #define DFRQ1_GLO       D(0.56250E6)        // GLONASS L1 bias frequency (Hz/n)
 #define FREQ2_GLO       D(1.24600E9)        // GLONASS L2 base frequency (Hz)
@@ -30,9 +32,12 @@
 #define PRUNIT_GLO      D(599584.916)       // rtcm ver.3 unit of glonass pseudorange (m)
 #define FE_WGS84        (D(1.0)/D(298.257223563)) // earth flattening (WGS84)
 #define RE_WGS84        D(6378137.0)           // earth semimajor axis (WGS84) (m)
+#define RANGE_MS        (CLIGHT*D(0.001))      // range in 1 ms (m)
 
 #define P2_5        D(0.03125)                 // 2^-5
+#define P2_10       D(0.0009765625)            // 2^-10
 #define P2_19       D(1.907348632812500E-06)   // 2^-19
+#define P2_24       D(5.960464477539063E-08)   // 2^-24
 #define P2_29       D(1.862645149230957E-09)   // 2^-29
 #define P2_31       D(4.656612873077393E-10)   // 2^-31
 #define P2_33       D(1.164153218269348E-10)   // 2^-33
@@ -49,6 +54,30 @@ const double lam_carr[] = { // carrier wave length (m)
                             CLIGHT/FREQ8
                           };
 
+// MSM signal IDs (DF395) decoded into the two observation slots, first entry of a slot is used for encoding unknown codes
+typedef struct {
+    uint8_t sig;
+    uint8_t slot;
+    uint8_t code;
+} msm_signal_t;
+
+static const msm_signal_t msm_signals_gps[] = {
+    {2, 0, CODE_L1C}, {3, 0, CODE_L1P}, {4, 0, CODE_L1W},
+    {8, 1, CODE_L2C}, {9, 1, CODE_L2P}, {10, 1, CODE_L2W}, {15, 1, CODE_L2S}, {16, 1, CODE_L2L}, {17, 1, CODE_L2X}
+};
+static const msm_signal_t msm_signals_glo[] = {
+    {2, 0, CODE_L1C}, {3, 0, CODE_L1P},
+    {8, 1, CODE_L2C}, {9, 1, CODE_L2P}
+};
+static const msm_signal_t msm_signals_gal[] = {
+    {2, 0, CODE_L1C}, {3, 0, CODE_L1A}, {4, 0, CODE_L1B}, {5, 0, CODE_L1X}, {6, 0, CODE_L1Z},
+    {14, 1, CODE_L7I}, {15, 1, CODE_L7Q}, {16, 1, CODE_L7X}
+};
+static const msm_signal_t msm_signals_cmp[] = {
+    {2, 0, CODE_L2I}, {3, 0, CODE_L2Q}, {4, 0, CODE_L2X},
+    {14, 1, CODE_L7I}, {15, 1, CODE_L7Q}, {16, 1, CODE_L7X}
+};
+
 // TODO: Fix this properly!!
 static int last_wn = 1874;
 
@@ -65,14 +94,24 @@ static int decode_1006(rtcm3_state *state);
 static int decode_1010(rtcm3_state *state);
 static int decode_1012(rtcm3_state *state);
 static int decode_1019(rtcm3_state *state);
+static int msm_system(int type);
+static const msm_signal_t *msm_signals(int sys, int *num);
+static const msm_signal_t *msm_find_signal(const msm_signal_t *signals, int num, int sig);
+static int msm_signal_id(const msm_signal_t *signals, int num, int slot, int code);
+static double msm_frequency(int sys, int slot, int freq);
+static uint32_t msm_lock_time_ms(int lock, int level);
+static int msm_lock_indicator(uint32_t lock_ms, int level);
+static uint32_t lock_time_ms(int lock);
+static int lock_indicator(uint32_t lock_ms);
 static double cp_pr(double cp, double pr_cyc);
 static void setbitu(uint8_t *buff, int pos, int len, unsigned int data);
 static void setbits(unsigned char *buff, int pos, int len, int data);
 static void set38bits(unsigned char *buff, int pos, double value);
-static unsigned int getbitu(const unsigned char *buff, int pos, int len);
-static int getbits(const unsigned char *buff, int pos, int len);
-static double getbits_38(const unsigned char *buff, int pos);
-static unsigned int crc24q(const unsigned char *buff, int len);
+
+using rtcmBits::getbitu;
+using rtcmBits::getbits;
+using rtcmBits::getbits_38;
+using rtcmBits::crc24q;
 
 /**
  * @brief rtcm3_set_rx_callback_obs_gps
@@ -116,6 +155,43 @@ void rtcm3_init_state(rtcm3_state *state) {
     memset(state, 0, sizeof(rtcm3_state));
 }
 
+/**
+ * @brief rtcm3_input_payload
+ * Copy the body of a frame whose header (and thereby length) was already received
+ * directly to the buffer instead of feeding it byte by byte to rtcm3_input_data.
+ * The last byte of a frame is never consumed, it has to go through rtcm3_input_data
+ * to check the crc and decode the message.
+ *
+ * @param data
+ * The received bytes.
+ *
+ * @param len
+ * Number of received bytes.
+ *
+ * @param state
+ * Pointer to the state of the RTCM decoder.
+ *
+ * @return
+ * The number of bytes consumed, 0 when not inside a frame with known length.
+ */
+int rtcm3_input_payload(const uint8_t *data, int len, rtcm3_state *state) {
+    if (state->buffer_ptr < 3) {
+        return 0;
+    }
+
+    int to_copy = state->len + 3 - 1 - state->buffer_ptr;
+    if (to_copy > len) {
+        to_copy = len;
+    }
+    if (to_copy <= 0) {
+        return 0;
+    }
+
+    memcpy(state->buffer + state->buffer_ptr, data, to_copy);
+    state->buffer_ptr += to_copy;
+    return to_copy;
+}
+
 /**
  * @brief rtcm3_input_data
  * Decode RTCM3 data.
@@ -211,6 +287,15 @@ int rtcm3_input_data(uint8_t data, rtcm3_state *state) {
         }
         break;
 
+    case 1074: case 1077: // GPS MSM4/MSM7
+    case 1084: case 1087: // GLONASS
+    case 1094: case 1097: // Galileo
+    case 1124: case 1127: // BeiDou
+        if (state->rx_rtcm_obs || state->decode_all) {
+            rtcm3_decode_msm(state);
+        }
+        break;
+
     default:
         // Not supported
         break;
@@ -524,6 +609,420 @@ int rtcm3_encode_1019(rtcm_ephemeris_t *eph, uint8_t *buffer, int *buffer_len) {
     return *buffer_len > 0;
 }
 
+/**
+ * @brief rtcm3_is_supported_msm
+ * Check if a message type is an MSM that can be decoded and encoded.
+ *
+ * @param type
+ * RTCM message type.
+ *
+ * @return
+ * True for MSM4 and MSM7 of GPS, GLONASS, Galileo and BeiDou (1074/1077, 1084/1087, 1094/1097, 1124/1127).
+ */
+bool rtcm3_is_supported_msm(int type) {
+    return msm_system(type) != SYS_NONE && (type % 10 == 4 || type % 10 == 7);
+}
+
+/**
+ * @brief rtcm3_decode_msm
+ * Decode the MSM4/MSM7 message in the buffer of the state, e.g., after rtcm3_input_data
+ * returned its type, to state->header and state->obs. Calls the observation callback if it is set.
+ * Only the signals of the two observation slots are decoded (see rtcm_obs_t), Doppler is not decoded.
+ *
+ * @param state
+ * Pointer to the state of the RTCM decoder.
+ *
+ * @return
+ * The number of observations (satellites), -1 if the message is not a supported MSM or is truncated.
+ */
+int rtcm3_decode_msm(rtcm3_state *state) {
+    const uint8_t *buffer = state->buffer;
+    int type = getbitu(buffer, 24, 12);
+    int sys = msm_system(type);
+    int level = type % 10;
+    int i = 24 + 12, j, k, nsat = 0, nsig = 0, ncell = 0, nsignals;
+    int sats[64], sigs[32], pr[64], cp[64], lock[64], cnr[64], ext[64];
+    bool cells[64];
+    double range[64];
+    const msm_signal_t *signals;
+
+    if (!rtcm3_is_supported_msm(type) || i + 61 + 64 + 32 > state->len * 8) {
+        return -1;
+    }
+
+    signals = msm_signals(sys, &nsignals);
+
+    // header
+    state->header.type = type;
+    state->header.staid = getbitu(buffer, i, 12); i+=12;
+    if (sys == SYS_GLO) {
+        state->header.dow = getbitu(buffer, i, 3); i+=3;
+        state->header.t_tod = getbitu(buffer, i, 27) * D(0.001); i+=27;
+    } else {
+        state->header.t_tow = getbitu(buffer, i, 30) * D(0.001); i+=30;
+    }
+    state->header.sync = getbitu(buffer, i, 1); i+=1;
+    i += 3 + 7 + 2 + 2 + 1 + 3; // iods, session time, clock steering, external clock, smoothing, smoothing interval
+    state->header.t_wn = last_wn;
+
+    for (j = 1;j <= 64;j++) {
+        if (getbitu(buffer, i++, 1)) {
+            sats[nsat++] = j;
+        }
+    }
+    for (j = 1;j <= 32;j++) {
+        if (getbitu(buffer, i++, 1)) {
+            sigs[nsig++] = j;
+        }
+    }
+    if (nsat * nsig > 64 || i + nsat * nsig > state->len * 8) {
+        return -1;
+    }
+    for (j = 0;j < nsat * nsig;j++) {
+        cells[j] = getbitu(buffer, i++, 1);
+        ncell += cells[j];
+    }
+    if (i + nsat * (level == 7 ? 36 : 18) + ncell * (level == 7 ? 80 : 48) > state->len * 8) {
+        return -1;
+    }
+
+    // satellite data, rough range in ms (0: invalid)
+    for (j = 0;j < nsat;j++) {
+        int rng = getbitu(buffer, i, 8); i+= 8;
+        range[j] = rng == 255 ? D(0.0) : rng;
+        ext[j] = 15;
+    }
+    if (level == 7) {
+        for (j = 0;j < nsat;j++) {
+            ext[j] = getbitu(buffer, i, 4); i+= 4;
+        }
+    }
+    for (j = 0;j < nsat;j++) {
+        int rng_m = getbitu(buffer, i, 10); i+=10;
+        if (range[j] != D(0.0)) {
+            range[j] += rng_m * P2_10;
+        }
+    }
+    if (level == 7) {
+        i += 14 * nsat; // rough phase range rates
+    }
+
+    // signal data, fine ranges relative to the rough range
+    if (level == 7) {
+        for (j = 0;j < ncell;j++) { pr[j] = getbits(buffer, i, 20); i+=20; }
+        for (j = 0;j < ncell;j++) { cp[j] = getbits(buffer, i, 24); i+=24; }
+        for (j = 0;j < ncell;j++) { lock[j] = getbitu(buffer, i, 10); i+=10; }
+        i += ncell; // half-cycle ambiguity
+        for (j = 0;j < ncell;j++) { cnr[j] = getbitu(buffer, i, 10); i+=10; }
+    } else {
+        for (j = 0;j < ncell;j++) { pr[j] = getbits(buffer, i, 15); i+=15; }
+        for (j = 0;j < ncell;j++) { cp[j] = getbits(buffer, i, 22); i+=22; }
+        for (j = 0;j < ncell;j++) { lock[j] = getbitu(buffer, i, 4); i+= 4; }
+        i += ncell; // half-cycle ambiguity
+        for (j = 0;j < ncell;j++) { cnr[j] = getbitu(buffer, i, 6); i+= 6; }
+    }
+
+    memset(state->obs, 0, sizeof(rtcm_obs_t) * nsat);
+
+    for (j = 0, k = 0;j < nsat;j++) {
+        rtcm_obs_t *obs = &state->obs[j];
+        int s;
+
+        obs->prn = sats[j];
+        obs->freq = 255;
+        if (sys == SYS_GLO) {
+            if (ext[j] <= 13) {
+                state->glo_freq[obs->prn - 1] = ext[j] + 1;
+            }
+            if (state->glo_freq[obs->prn - 1]) {
+                obs->freq = state->glo_freq[obs->prn - 1] - 1;
+            }
+        }
+
+        for (s = 0;s < nsig;s++) {
+            const msm_signal_t *signal;
+            double freq;
+            int slot;
+
+            if (!cells[j * nsig + s]) {
+                continue;
+            }
+
+            signal = msm_find_signal(signals, nsignals, sigs[s]);
+            k++;
+            if (!signal || obs->code[signal->slot]) {
+                continue; // band without slot or slot already filled by another signal
+            }
+
+            slot = signal->slot;
+            obs->code[slot] = signal->code;
+            if (range[j] == D(0.0)) {
+                continue;
+            }
+
+            if (pr[k - 1] != (level == 7 ? -524288 : -16384)) {
+                obs->P[slot] = (range[j] + pr[k - 1] * (level == 7 ? P2_29 : P2_24)) * RANGE_MS;
+            }
+
+            freq = msm_frequency(sys, slot, obs->freq);
+            if (freq > D(0.0) && cp[k - 1] != (level == 7 ? -8388608 : -2097152)) {
+                obs->L[slot] = (range[j] + cp[k - 1] * (level == 7 ? P2_31 : P2_29)) * RANGE_MS * freq / CLIGHT;
+            }
+
+            obs->lock[slot] = lock_indicator(msm_lock_time_ms(lock[k - 1], level));
+            obs->cn0[slot] = level == 7 ? cnr[k - 1] / 16 : cnr[k - 1];
+        }
+    }
+
+    // Call callback if it is set
+    if (state->rx_rtcm_obs) {
+        state->rx_rtcm_obs(&state->header, state->obs, nsat);
+    }
+
+    return nsat;
+}
+
+/**
+ * @brief rtcm3_encode_msm
+ * Encode RTCM3 MSM4 or MSM7 observations of one constellation, e.g., to transcode MSM7 to the
+ * about half as large MSM4. The signal of each slot is selected by its code (see rtcm_obs_t),
+ * Doppler and the half-cycle ambiguity flag are not encoded.
+ *
+ * @param header
+ * RTCM header. The epoch is t_tod and dow for GLONASS, t_tow otherwise.
+ *
+ * @param obs
+ * Observation data, prn 1 - 64 of the constellation of the message type.
+ *
+ * @param obs_num
+ * Number of observations.
+ *
+ * @param type
+ * Message type, see rtcm3_is_supported_msm.
+ *
+ * @param buffer
+ * Buffer to store the RTCM stream to, at least 1029 bytes.
+ *
+ * @param buffer_len
+ * Length of the buffer.
+ *
+ * @return
+ * 1 for success, <= 0 otherwise (unsupported type or more than 64 cells).
+ */
+int rtcm3_encode_msm(rtcm_obs_header_t *header, rtcm_obs_t *obs,
+                     int obs_num, int type, uint8_t *buffer, int *buffer_len) {
+    int sys = msm_system(type);
+    int level = type % 10;
+    int i = 0, j, s, epoch, nsat = 0, nsig = 0, ncell = 0, nsignals;
+    int sat_obs[64], sats[64], sigs[32], cell_obs[64], cell_slot[64];
+    int rng[64];
+    bool cells[64];
+    uint32_t sig_mask = 0;
+    double tadj;
+    const msm_signal_t *signals;
+
+    if (!rtcm3_is_supported_msm(type)) {
+        return 0;
+    }
+
+    signals = msm_signals(sys, &nsignals);
+
+    // satellites in order of prn, signals in order of their id
+    for (j = 0;j < 64;j++) {
+        sat_obs[j] = -1;
+    }
+    for (j = 0;j < obs_num;j++) {
+        if (obs[j].prn < 1 || obs[j].prn > 64) {
+            continue;
+        }
+        for (s = 0;s < 2;s++) {
+            if (obs[j].P[s] != D(0.0) || obs[j].L[s] != D(0.0)) {
+                sat_obs[obs[j].prn - 1] = j;
+                sig_mask |= 1u << (msm_signal_id(signals, nsignals, s, obs[j].code[s]) - 1);
+            }
+        }
+    }
+    for (j = 0;j < 64;j++) {
+        if (sat_obs[j] >= 0) {
+            sats[nsat++] = j + 1;
+        }
+    }
+    for (j = 1;j <= 32;j++) {
+        if (sig_mask & (1u << (j - 1))) {
+            sigs[nsig++] = j;
+        }
+    }
+    if (nsat * nsig > 64) {
+        return 0;
+    }
+
+    for (j = 0;j < nsat;j++) {
+        const rtcm_obs_t *o = &obs[sat_obs[sats[j] - 1]];
+        for (s = 0;s < nsig;s++) {
+            int slot;
+            cells[j * nsig + s] = false;
+            for (slot = 0;slot < 2;slot++) {
+                if ((o->P[slot] != D(0.0) || o->L[slot] != D(0.0)) &&
+                        msm_signal_id(signals, nsignals, slot, o->code[slot]) == sigs[s]) {
+                    cells[j * nsig + s] = true;
+                    cell_obs[ncell] = sat_obs[sats[j] - 1];
+                    cell_slot[ncell++] = slot;
+                    break;
+                }
+            }
+        }
+    }
+
+    // header
+    header->type = type;
+    setbitu(buffer,i, 8, RTCM3PREAMB); i+= 8;
+    setbitu(buffer,i, 6, 0); i+= 6;
+    setbitu(buffer, i, 10, 0); i+=10;
+    setbitu(buffer,i,12,type); i+=12; // message type
+    setbitu(buffer,i,12,header->staid); i+=12; // ref station id
+
+    if (sys == SYS_GLO) {
+        epoch = ROUND(header->t_tod / D(0.001));
+        tadj = (header->t_tod / D(0.001) - epoch) * D(0.001);
+        setbitu(buffer,i, 3,header->dow); i+= 3; // glonass day of week
+        setbitu(buffer,i,27,epoch); i+=27; // glonass epoch time
+    } else {
+        epoch = ROUND(header->t_tow / D(0.001));
+        tadj = (header->t_tow / D(0.001) - epoch) * D(0.001);
+        setbitu(buffer,i,30,epoch); i+=30; // epoch time
+    }
+
+    setbitu(buffer,i, 1,header->sync); i+= 1; // multiple message bit
+    setbitu(buffer,i, 3,0); i+= 3; // issue of data station
+    setbitu(buffer,i, 7,0); i+= 7; // session time indicator
+    setbitu(buffer,i, 2,0); i+= 2; // clock steering indicator
+    setbitu(buffer,i, 2,0); i+= 2; // external clock indicator
+    setbitu(buffer,i, 1,0); i+= 1; // divergence free smoothing indicator
+    setbitu(buffer,i, 3,0); i+= 3; // smoothing interval
+
+    for (j = 1;j <= 64;j++) {
+        setbitu(buffer,i, 1,sat_obs[j - 1] >= 0); i+= 1; // satellite mask
+    }
+    for (j = 1;j <= 32;j++) {
+        setbitu(buffer,i, 1,(sig_mask >> (j - 1)) & 1u); i+= 1; // signal mask
+    }
+    for (j = 0;j < nsat * nsig;j++) {
+        setbitu(buffer,i, 1,cells[j]); i+= 1; // cell mask
+    }
+
+    // satellite data, rough range (1/1024 ms) from the first pseudorange or carrier phase
+    for (j = 0;j < nsat;j++) {
+        const rtcm_obs_t *o = &obs[sat_obs[sats[j] - 1]];
+        double r = D(0.0);
+
+        for (s = 0;s < 2 && r == D(0.0);s++) {
+            double freq = msm_frequency(sys, s, o->freq);
+            if (o->P[s] != D(0.0)) {
+                r = o->P[s] - tadj * CLIGHT;
+            } else if (o->L[s] != D(0.0) && freq > D(0.0)) {
+                r = (o->L[s] - tadj * freq) * CLIGHT / freq;
+            }
+        }
+
+        rng[j] = ROUND(r / RANGE_MS / P2_10);
+        if (r <= D(0.0) || rng[j] >= 255 * 1024) {
+            rng[j] = -1;
+        }
+    }
+    for (j = 0;j < nsat;j++) {
+        setbitu(buffer,i, 8,rng[j] < 0 ? 255 : rng[j] >> 10); i+= 8;
+    }
+    if (level == 7) {
+        for (j = 0;j < nsat;j++) {
+            const rtcm_obs_t *o = &obs[sat_obs[sats[j] - 1]];
+            setbitu(buffer,i, 4,sys == SYS_GLO ? (o->freq <= 13 ? o->freq : 15) : 0); i+= 4; // extended satellite info
+        }
+    }
+    for (j = 0;j < nsat;j++) {
+        setbitu(buffer,i,10,rng[j] < 0 ? 0 : rng[j] & 0x3FF); i+=10;
+    }
+    if (level == 7) {
+        for (j = 0;j < nsat;j++) {
+            setbits(buffer,i,14,-8192); i+=14; // rough phase range rate, not available
+        }
+    }
+
+    // signal data, fine ranges relative to the rough range
+    {
+        const int pr_bits = level == 7 ? 20 : 15;
+        const int cp_bits = level == 7 ? 24 : 22;
+        const double pr_unit = level == 7 ? P2_29 : P2_24;
+        const double cp_unit = level == 7 ? P2_31 : P2_29;
+        int pr[64], cp[64], k;
+
+        for (k = 0, j = 0;j < nsat;j++) {
+            for (s = 0;s < nsig;s++) {
+                const rtcm_obs_t *o;
+                double freq, rough, fine;
+                int slot;
+
+                if (!cells[j * nsig + s]) {
+                    continue;
+                }
+
+                o = &obs[cell_obs[k]];
+                slot = cell_slot[k];
+                freq = msm_frequency(sys, slot, o->freq);
+                rough = rng[j] * P2_10;
+                pr[k] = -(1 << (pr_bits - 1));
+                cp[k] = -(1 << (cp_bits - 1));
+
+                if (rng[j] >= 0 && o->P[slot] != D(0.0)) {
+                    fine = (o->P[slot] - tadj * CLIGHT) / RANGE_MS - rough;
+                    if (fabs(fine) < P2_10 && ROUND(fine / pr_unit) < (1 << (pr_bits - 1))) {
+                        pr[k] = ROUND(fine / pr_unit);
+                    }
+                }
+                if (rng[j] >= 0 && o->L[slot] != D(0.0) && freq > D(0.0)) {
+                    fine = (o->L[slot] - tadj * freq) * CLIGHT / freq / RANGE_MS - rough;
+                    if (fabs(fine) < D(4.0) * P2_10 && ROUND(fine / cp_unit) < (1 << (cp_bits - 1))) {
+                        cp[k] = ROUND(fine / cp_unit);
+                    }
+                }
+                k++;
+            }
+        }
+
+        for (k = 0;k < ncell;k++) {
+            setbits(buffer,i,pr_bits,pr[k]); i+=pr_bits;
+        }
+        for (k = 0;k < ncell;k++) {
+            setbits(buffer,i,cp_bits,cp[k]); i+=cp_bits;
+        }
+        for (k = 0;k < ncell;k++) {
+            const rtcm_obs_t *o = &obs[cell_obs[k]];
+            int bits = level == 7 ? 10 : 4;
+            setbitu(buffer,i,bits,msm_lock_indicator(lock_time_ms(o->lock[cell_slot[k]]), level)); i+=bits;
+        }
+        for (k = 0;k < ncell;k++) {
+            setbitu(buffer,i, 1,0); i+= 1; // half-cycle ambiguity
+        }
+        for (k = 0;k < ncell;k++) {
+            const rtcm_obs_t *o = &obs[cell_obs[k]];
+            int cn0 = o->cn0[cell_slot[k]];
+            if (level == 7) {
+                setbitu(buffer,i,10,cn0 * 16 > 1023 ? 1023 : cn0 * 16); i+=10;
+            } else {
+                setbitu(buffer,i, 6,cn0 > 63 ? 63 : cn0); i+= 6;
+            }
+        }
+        if (level == 7) {
+            for (k = 0;k < ncell;k++) {
+                setbits(buffer,i,15,-16384); i+=15; // fine phase range rate, not available
+            }
+        }
+    }
+
+    *buffer_len = encode_end(buffer, i);
+
+    return *buffer_len > 0;
+}
+
 static int encode_head(rtcm_obs_header_t *header, int nsat, int sys,
                        uint8_t *buffer, double *tadj) {
     int i=0, epoch;
@@ -578,6 +1077,8 @@ static int decode_head1009(rtcm_obs_header_t *header, int *nsat, uint8_t *buffer
     header->sync  = getbitu(buffer, i, 1);          i+=1;
     *nsat = getbitu(buffer, i, 5);                  i+=5;
 
+    header->dow = 7; // not part of the legacy messages
+
     header->t_wn = last_wn;
 
     return i;
@@ -835,6 +1336,10 @@ static int decode_1010(rtcm3_state *state) {
         state->obs[j].cn0[0] = cnr1 * D(0.25);
         state->obs[j].code[0] = code ? CODE_L1P : CODE_L1C;
         state->obs[j].freq = freq;
+
+        if (prn >= 1 && prn <= 64) {
+            state->glo_freq[prn - 1] = freq + 1;
+        }
     }
 
     // Call callback if it is set
@@ -895,6 +1400,10 @@ static int decode_1012(rtcm3_state *state) {
         state->obs[j].cn0[1] = cnr2 * D(0.25);
         state->obs[j].code[1] = code2 ? CODE_L2P : CODE_L2C;
         state->obs[j].freq = freq;
+
+        if (prn >= 1 && prn <= 64) {
+            state->glo_freq[prn - 1] = freq + 1;
+        }
     }
 
     // Call callback if it is set
@@ -955,6 +1464,139 @@ static int decode_1019(rtcm3_state *state) {
     return 1019;
 }
 
+static int msm_system(int type) {
+    switch ((type - 1070) / 10) {
+    case 0: return SYS_GPS;
+    case 1: return SYS_GLO;
+    case 2: return SYS_GAL;
+    case 5: return SYS_CMP;
+    default: return SYS_NONE;
+    }
+}
+
+static const msm_signal_t *msm_signals(int sys, int *num) {
+    switch (sys) {
+    case SYS_GPS: *num = sizeof(msm_signals_gps) / sizeof(msm_signals_gps[0]); return msm_signals_gps;
+    case SYS_GLO: *num = sizeof(msm_signals_glo) / sizeof(msm_signals_glo[0]); return msm_signals_glo;
+    case SYS_GAL: *num = sizeof(msm_signals_gal) / sizeof(msm_signals_gal[0]); return msm_signals_gal;
+    case SYS_CMP: *num = sizeof(msm_signals_cmp) / sizeof(msm_signals_cmp[0]); return msm_signals_cmp;
+    default: *num = 0; return 0;
+    }
+}
+
+static const msm_signal_t *msm_find_signal(const msm_signal_t *signals, int num, int sig) {
+    int i;
+
+    for (i = 0;i < num;i++) {
+        if (signals[i].sig == sig) {
+            return &signals[i];
+        }
+    }
+
+    return 0;
+}
+
+// signal id of the code in the slot, the slot's first signal if the code is unknown
+static int msm_signal_id(const msm_signal_t *signals, int num, int slot, int code) {
+    int i, first = 0;
+
+    for (i = 0;i < num;i++) {
+        if (signals[i].slot != slot) {
+            continue;
+        }
+        if (signals[i].code == code) {
+            return signals[i].sig;
+        }
+        if (!first) {
+            first = signals[i].sig;
+        }
+    }
+
+    return first;
+}
+
+// carrier frequency of the slot, 0 if unknown (GLONASS frequency slot)
+static double msm_frequency(int sys, int slot, int freq) {
+    switch (sys) {
+    case SYS_GPS: return slot == 0 ? FREQ1 : FREQ2;
+    case SYS_GAL: return slot == 0 ? FREQ1 : FREQ7;
+    case SYS_CMP: return slot == 0 ? FREQ1_CMP : FREQ7;
+    case SYS_GLO:
+        if (freq > 13) {
+            return D(0.0);
+        }
+        return slot == 0 ? FREQ1_GLO + DFRQ1_GLO * (freq - 7) : FREQ2_GLO + DFRQ2_GLO * (freq - 7);
+    default: return D(0.0);
+    }
+}
+
+// minimum lock time of the MSM4 (DF402) or MSM7 (DF407) lock time indicator
+static uint32_t msm_lock_time_ms(int lock, int level) {
+    int s;
+
+    if (level != 7) {
+        return lock ? 1u << (lock + 4) : 0;
+    }
+
+    if (lock < 64) {
+        return lock;
+    }
+    if (lock > 704) {
+        lock = 704;
+    }
+    s = (lock - 64) / 32;
+    return (1u << (s + 1)) * (lock - 64 - 32 * s) + (64u << s);
+}
+
+static int msm_lock_indicator(uint32_t lock_ms, int level) {
+    int s;
+
+    if (level != 7) {
+        for (s = 15;s > 0;s--) {
+            if (lock_ms >= (1u << (s + 4))) {
+                return s;
+            }
+        }
+        return 0;
+    }
+
+    if (lock_ms < 64) {
+        return lock_ms;
+    }
+    for (s = 0;s < 20 && lock_ms >= (128u << s);s++);
+    if (s >= 20) {
+        return 704;
+    }
+    return 64 + 32 * s + (lock_ms - (64u << s)) / (1u << (s + 1));
+}
+
+// minimum lock time of the legacy lock time indicator (DF013, as in rtcm_obs_t)
+static uint32_t lock_time_ms(int lock) {
+    uint32_t t;
+
+    if (lock < 24) t = lock;
+    else if (lock < 48) t = 2 * lock - 24;
+    else if (lock < 72) t = 4 * lock - 120;
+    else if (lock < 96) t = 8 * lock - 408;
+    else if (lock < 120) t = 16 * lock - 1176;
+    else if (lock < 127) t = 32 * lock - 3096;
+    else t = 937;
+
+    return t * 1000;
+}
+
+static int lock_indicator(uint32_t lock_ms) {
+    uint32_t t = lock_ms / 1000;
+
+    if (t < 24) return t;
+    if (t < 72) return (t + 24) / 2;
+    if (t < 168) return (t + 120) / 4;
+    if (t < 360) return (t + 408) / 8;
+    if (t < 744) return (t + 1176) / 16;
+    if (t < 937) return (t + 3096) / 32;
+    return 127;
+}
+
 // carrier-phase - pseudorange in cycle
 static double cp_pr(double cp, double pr_cyc) {
     return fmod(cp - pr_cyc + D(1500.0), D(3000.0)) - D(1500.0);
@@ -994,75 +1636,3 @@ static void set38bits(unsigned char *buff, int pos, double value) {
     setbits(buff, pos  , 32, word_h);
     setbitu(buff, pos + 32, 6, word_l);
 }
-
-static unsigned int getbitu(const unsigned char *buff, int pos, int len) {
-    unsigned int bits=0;
-    int i;
-
-    for (i = pos;i < pos + len;i++) {
-        bits = (bits << 1) + ((buff[i / 8] >> (7 - i % 8)) & 1u);
-    }
-
-    return bits;
-}
-
-static int getbits(const unsigned char *buff, int pos, int len) {
-    unsigned int bits = getbitu(buff, pos, len);
-
-    if (len <= 0 || 32 <= len || !(bits & (1u << (len - 1)))) {
-        return (int)bits;
-    }
-
-    return (int)(bits | (~0u << len)); // extend sign
-}
-
-// get signed 38bit field
-static double getbits_38(const unsigned char *buff, int pos) {
-    return (double)getbits(buff, pos, 32) * D(64.0) + getbitu(buff, pos + 32, 6);
-}
-
-static const unsigned int tbl_CRC24Q[]={
-    0x000000,0x864CFB,0x8AD50D,0x0C99F6,0x93E6E1,0x15AA1A,0x1933EC,0x9F7F17,
-    0xA18139,0x27CDC2,0x2B5434,0xAD18CF,0x3267D8,0xB42B23,0xB8B2D5,0x3EFE2E,
-    0xC54E89,0x430272,0x4F9B84,0xC9D77F,0x56A868,0xD0E493,0xDC7D65,0x5A319E,
-    0x64CFB0,0xE2834B,0xEE1ABD,0x685646,0xF72951,0x7165AA,0x7DFC5C,0xFBB0A7,
-    0x0CD1E9,0x8A9D12,0x8604E4,0x00481F,0x9F3708,0x197BF3,0x15E205,0x93AEFE,
-    0xAD50D0,0x2B1C2B,0x2785DD,0xA1C926,0x3EB631,0xB8FACA,0xB4633C,0x322FC7,
-    0xC99F60,0x4FD39B,0x434A6D,0xC50696,0x5A7981,0xDC357A,0xD0AC8C,0x56E077,
-    0x681E59,0xEE52A2,0xE2CB54,0x6487AF,0xFBF8B8,0x7DB443,0x712DB5,0xF7614E,
-    0x19A3D2,0x9FEF29,0x9376DF,0x153A24,0x8A4533,0x0C09C8,0x00903E,0x86DCC5,
-    0xB822EB,0x3E6E10,0x32F7E6,0xB4BB1D,0x2BC40A,0xAD88F1,0xA11107,0x275DFC,
-    0xDCED5B,0x5AA1A0,0x563856,0xD074AD,0x4F0BBA,0xC94741,0xC5DEB7,0x43924C,
-    0x7D6C62,0xFB2099,0xF7B96F,0x71F594,0xEE8A83,0x68C678,0x645F8E,0xE21375,
-    0x15723B,0x933EC0,0x9FA736,0x19EBCD,0x8694DA,0x00D821,0x0C41D7,0x8A0D2C,
-    0xB4F302,0x32BFF9,0x3E260F,0xB86AF4,0x2715E3,0xA15918,0xADC0EE,0x2B8C15,
-    0xD03CB2,0x567049,0x5AE9BF,0xDCA544,0x43DA53,0xC596A8,0xC90F5E,0x4F43A5,
-    0x71BD8B,0xF7F170,0xFB6886,0x7D247D,0xE25B6A,0x641791,0x688E67,0xEEC29C,
-    0x3347A4,0xB50B5F,0xB992A9,0x3FDE52,0xA0A145,0x26EDBE,0x2A7448,0xAC38B3,
-    0x92C69D,0x148A66,0x181390,0x9E5F6B,0x01207C,0x876C87,0x8BF571,0x0DB98A,
-    0xF6092D,0x7045D6,0x7CDC20,0xFA90DB,0x65EFCC,0xE3A337,0xEF3AC1,0x69763A,
-    0x578814,0xD1C4EF,0xDD5D19,0x5B11E2,0xC46EF5,0x42220E,0x4EBBF8,0xC8F703,
-    0x3F964D,0xB9DAB6,0xB54340,0x330FBB,0xAC70AC,0x2A3C57,0x26A5A1,0xA0E95A,
-    0x9E1774,0x185B8F,0x14C279,0x928E82,0x0DF195,0x8BBD6E,0x872498,0x016863,
-    0xFAD8C4,0x7C943F,0x700DC9,0xF64132,0x693E25,0xEF72DE,0xE3EB28,0x65A7D3,
-    0x5B59FD,0xDD1506,0xD18CF0,0x57C00B,0xC8BF1C,0x4EF3E7,0x426A11,0xC426EA,
-    0x2AE476,0xACA88D,0xA0317B,0x267D80,0xB90297,0x3F4E6C,0x33D79A,0xB59B61,
-    0x8B654F,0x0D29B4,0x01B042,0x87FCB9,0x1883AE,0x9ECF55,0x9256A3,0x141A58,
-    0xEFAAFF,0x69E604,0x657FF2,0xE33309,0x7C4C1E,0xFA00E5,0xF69913,0x70D5E8,
-    0x4E2BC6,0xC8673D,0xC4FECB,0x42B230,0xDDCD27,0x5B81DC,0x57182A,0xD154D1,
-    0x26359F,0xA07964,0xACE092,0x2AAC69,0xB5D37E,0x339F85,0x3F0673,0xB94A88,
-    0x87B4A6,0x01F85D,0x0D61AB,0x8B2D50,0x145247,0x921EBC,0x9E874A,0x18CBB1,
-    0xE37B16,0x6537ED,0x69AE1B,0xEFE2E0,0x709DF7,0xF6D10C,0xFA48FA,0x7C0401,
-    0x42FA2F,0xC4B6D4,0xC82F22,0x4E63D9,0xD11CCE,0x575035,0x5BC9C3,0xDD8538
-};
-
-static unsigned int crc24q(const unsigned char *buff, int len) {
-    unsigned int crc=0;
-    int i;
-
-    for (i=0;i < len;i++) {
-        crc= ((crc << 8) & 0xFFFFFF) ^ tbl_CRC24Q[(crc >> 16) ^ buff[i]];
-    }
-
-    return crc;
-}
@@ -26,9 +26,22 @@ extern "C" {
 #define RTCM3PREAMB		0xD3                // rtcm ver.3 frame preamble
 #define CODE_L1C        1                   // obs code: L1C/A,G1C/A,E1C (GPS,GLO,GAL,QZS,SBS)
 #define CODE_L1P        2                   // obs code: L1P,G1P    (GPS,GLO)
+#define CODE_L1W        3                   // obs code: L1 Z-track (GPS)
+#define CODE_L1A        10                  // obs code: E1A        (GAL)
+#define CODE_L1B        11                  // obs code: E1B        (GAL)
+#define CODE_L1X        12                  // obs code: E1B+C      (GAL)
+#define CODE_L1Z        13                  // obs code: E1A+B+C    (GAL)
 #define CODE_L2C        14                  // obs code: L2C/A,G1C/A (GPS,GLO)
+#define CODE_L2S        16                  // obs code: L2C(M)     (GPS)
+#define CODE_L2L        17                  // obs code: L2C(L)     (GPS)
+#define CODE_L2X        18                  // obs code: L2C(M+L),B1I+Q (GPS,CMP)
 #define CODE_L2P        19                  // obs code: L2P,G2P    (GPS,GLO)
 #define CODE_L2W        20                  // obs code: L2 Z-track (GPS)
+#define CODE_L7I        27                  // obs code: E5bI,B2I   (GAL,CMP)
+#define CODE_L7Q        28                  // obs code: E5bQ,B2Q   (GAL,CMP)
+#define CODE_L7X        29                  // obs code: E5bI+Q,B2I+Q (GAL,CMP)
+#define CODE_L2I        40                  // obs code: B1I        (CMP)
+#define CODE_L2Q        41                  // obs code: B1Q        (CMP)
 
 #define SYS_NONE        0x00                // navigation system: none
 #define SYS_GPS         0x01                // navigation system: GPS
@@ -42,21 +55,23 @@ extern "C" {
 
 // Datatypes
 typedef struct {
-    double t_tow;       // Time of week (GPS)
+    double t_tow;       // Time of week (GPS, for MSM also Galileo and BeiDou in their system time)
     double t_tod;       // Time of day (GLONASS)
     double t_wn;        // Week number
+    int dow;            // Day of week (GLONASS MSM), 7 if unknown
     int staid;          // ref station id
     bool sync;          // True if more messages are coming
     int type;           // RTCM Type
 } rtcm_obs_header_t;
 
+// Observations of one satellite, index 0: L1/G1/E1/B1I, index 1: L2/G2/E5b/B2I (for MSM, other bands are not decoded)
 typedef struct {
     double P[2];        // Pseudorange observation
     double L[2];        // Carrier phase observation
     uint8_t cn0[2];     // Carrier-to-Noise density [dB Hz]
     uint8_t lock[2];    // Lock. Set to 0 when the lock has changed, 127 otherwise. TODO: is this correct?
     uint8_t prn;        // Sattelite
-    uint8_t freq;       // Frequency slot (GLONASS)
+    uint8_t freq;       // Frequency slot (GLONASS), i.e., frequency channel number + 7, 255 if unknown (MSM4 without earlier 1010/1012/MSM7)
     uint8_t code[2];    // Code indicator
 } rtcm_obs_t;
 
@@ -110,6 +125,7 @@ typedef struct {
     rtcm_obs_t obs[64];
     rtcm_ref_sta_pos_t pos;
     rtcm_ephemeris_t eph;
+    uint8_t glo_freq[64]; // Frequency slot + 1 per GLONASS satellite seen in 1010/1012/MSM7, 0: unknown. Needed for MSM4 carrier phase.
     void(*rx_rtcm_obs)(rtcm_obs_header_t *header, rtcm_obs_t *obs, int obs_num);
     void(*rx_rtcm_1005_1006)(rtcm_ref_sta_pos_t *pos);
     void(*rx_rtcm_1019)(rtcm_ephemeris_t *eph);
@@ -123,12 +139,17 @@ void rtcm3_set_rx_callback_1019(void(*func)(rtcm_ephemeris_t *eph), rtcm3_state
 void rtcm3_set_rx_callback(void(*func)(uint8_t *data, int len, int type), rtcm3_state *state);
 void rtcm3_init_state(rtcm3_state *state);
 int rtcm3_input_data(uint8_t data, rtcm3_state *state);
+int rtcm3_input_payload(const uint8_t *data, int len, rtcm3_state *state);
 int rtcm3_encode_1002(rtcm_obs_header_t *header, rtcm_obs_t *obs,
                       int obs_num, uint8_t *buffer, int *buffer_len);
 int rtcm3_encode_1010(rtcm_obs_header_t *header, rtcm_obs_t *obs,
                       int obs_num, uint8_t *buffer, int *buffer_len);
 int rtcm3_encode_1006(rtcm_ref_sta_pos_t pos, uint8_t *buffer, int *buffer_len);
 int rtcm3_encode_1019(rtcm_ephemeris_t *eph, uint8_t *buffer, int *buffer_len);
+int rtcm3_encode_msm(rtcm_obs_header_t *header, rtcm_obs_t *obs,
+                     int obs_num, int type, uint8_t *buffer, int *buffer_len);
+int rtcm3_decode_msm(rtcm3_state *state);
+bool rtcm3_is_supported_msm(int type);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,139 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Bit field extraction and CRC-24Q for RTCM3, shared by rtcm3_simple and RtcmClient. Same semantics as RTKLIB's
+ * getbitu/getbits/getbits_38/crc24q (fields of up to 32 bits, MSB first), but word at a time instead of bit by bit:
+ * the bytes holding a field are loaded into a 64-bit word and the field is taken out with one shift and mask.
+ * The CRC processes four bytes per step (slicing-by-4, tables generated at compile time).
+ *
+ * The overloads with a buffer size are bounds-checked (fields past the end read as 0) and load eight bytes at once
+ * where the buffer allows, the ones without only read the bytes that hold the field.
+ */
+
+#ifndef RTCMBITS_H
+#define RTCMBITS_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace rtcmBits {
+
+namespace detail {
+static constexpr uint32_t CRC24Q_POLYNOMIAL = 0x1864CFB;
+
+constexpr std::array<std::array<uint32_t, 256>, 4> makeCrc24qTables()
+{
+    std::array<std::array<uint32_t, 256>, 4> tables {};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i << 16;
+        for (int bit = 0; bit < 8; bit++) {
+            crc <<= 1;
+            if (crc & 0x1000000)
+                crc ^= CRC24Q_POLYNOMIAL;
+        }
+        tables[0][i] = crc;
+    }
+    // tables[k][i]: CRC of byte i followed by k zero bytes
+    for (int k = 1; k < 4; k++)
+        for (uint32_t i = 0; i < 256; i++)
+            tables[k][i] = ((tables[k - 1][i] << 8) & 0xFFFFFF) ^ tables[0][tables[k - 1][i] >> 16];
+    return tables;
+}
+
+static constexpr std::array<std::array<uint32_t, 256>, 4> CRC24Q_TABLES = makeCrc24qTables();
+
+inline uint64_t loadBigEndian64(const uint8_t *data)
+{
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return __builtin_bswap64(word);
+#else
+    word = 0;
+    for (int i = 0; i < 8; i++)
+        word = (word << 8) | data[i];
+    return word;
+#endif
+}
+
+inline uint32_t extendSign(uint32_t bits, int len)
+{
+    if (len <= 0 || 32 <= len || !(bits & (1u << (len - 1))))
+        return bits;
+    return bits | (~0u << len);
+}
+}
+
+// len: 0 - 32, reads the bytes from pos / 8 to (pos + len - 1) / 8
+inline uint32_t getbitu(const uint8_t *buff, int pos, int len)
+{
+    if (len <= 0)
+        return 0;
+
+    const uint8_t *data = buff + (pos >> 3);
+    const int offset = pos & 7;
+    const int numBytes = (offset + len + 7) >> 3; // at most 5
+    uint64_t word = 0;
+    for (int i = 0; i < numBytes; i++)
+        word = (word << 8) | data[i];
+
+    return uint32_t((word >> (numBytes * 8 - offset - len)) & (~0ull >> (64 - len)));
+}
+
+// Bounds-checked, size: of buff in bytes
+inline uint32_t getbitu(const uint8_t *buff, int size, int pos, int len)
+{
+    if (len <= 0 || pos < 0 || pos + len > size * 8)
+        return 0;
+
+    const int index = pos >> 3;
+    if (index + 8 > size)
+        return getbitu(buff, pos, len);
+
+    const uint64_t word = detail::loadBigEndian64(buff + index);
+    return uint32_t((word << (pos & 7)) >> (64 - len));
+}
+
+inline int getbits(const uint8_t *buff, int pos, int len)
+{
+    return int(detail::extendSign(getbitu(buff, pos, len), len));
+}
+
+inline int getbits(const uint8_t *buff, int size, int pos, int len)
+{
+    return int(detail::extendSign(getbitu(buff, size, pos, len), len));
+}
+
+// Signed 38-bit field
+inline double getbits_38(const uint8_t *buff, int pos)
+{
+    return double(getbits(buff, pos, 32)) * 64.0 + getbitu(buff, pos + 32, 6);
+}
+
+inline double getbits_38(const uint8_t *buff, int size, int pos)
+{
+    return double(getbits(buff, size, pos, 32)) * 64.0 + getbitu(buff, size, pos + 32, 6);
+}
+
+inline uint32_t crc24q(const uint8_t *buff, int len)
+{
+    const auto &tables = detail::CRC24Q_TABLES;
+    uint32_t crc = 0;
+    int i = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        const uint32_t word = ((crc << 8) ^ (uint32_t(buff[i]) << 24 | uint32_t(buff[i + 1]) << 16 |
+                                             uint32_t(buff[i + 2]) << 8 | uint32_t(buff[i + 3])));
+        crc = tables[3][word >> 24] ^ tables[2][(word >> 16) & 0xFF] ^ tables[1][(word >> 8) & 0xFF] ^ tables[0][word & 0xFF];
+    }
+    for (; i < len; i++)
+        crc = ((crc << 8) & 0xFFFFFF) ^ tables[0][(crc >> 16) ^ buff[i]];
+
+    return crc;
+}
+
+}
+
+#endif // RTCMBITS_H
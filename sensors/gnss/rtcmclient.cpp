@@ -3,45 +3,92 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "rtcmclient.h"
+#include "rtcmbits.h"
 #include <QFile>
 
+namespace {
+constexpr qint64 GPS_EPOCH_UNIX_MS = 315964800000LL;
+constexpr qint64 MS_PER_WEEK = 7 * utcTime::MS_PER_DAY;
+constexpr int THROUGHPUT_WINDOW_MS = 1000;
+constexpr int THROUGHPUT_STALE_MS = 3000;
+
+// Time since the epoch of an MSM message, in the time system of its constellation
+double getMsmCorrectionAge_ms(const uint8_t *frame, int size, int type, qint64 now_ns)
+{
+    const qint64 utc_ms = now_ns / utcTime::NS_PER_MS;
+    const int constellation = RtcmFilter::getMsmConstellation(type);
+    const qint64 epoch = rtcmBits::getbitu(frame, size, 24 + 12 + 12, 30);
+    qint64 period_ms, age_ms;
+    if (constellation == 1) { // GLONASS: day of week (3 bits) and time of day in Moscow time (UTC + 3 h)
+        period_ms = utcTime::MS_PER_DAY;
+        age_ms = (utc_ms + 3 * 3600 * 1000) % utcTime::MS_PER_DAY - (epoch & 0x7FFFFFF);
+    } else { // GPS time of week, BeiDou time is 14 s behind
+        period_ms = MS_PER_WEEK;
+        const qint64 gps_ms = utc_ms - GPS_EPOCH_UNIX_MS + RtcmClient::GPS_LEAP_SECONDS * 1000 - (constellation == 5 ? 14000 : 0);
+        age_ms = gps_ms % MS_PER_WEEK - epoch;
+    }
+
+    if (age_ms < -period_ms / 2)
+        age_ms += period_ms;
+    else if (age_ms >= period_ms / 2)
+        age_ms -= period_ms;
+    return double(age_ms);
+}
+}
+
 RtcmClient::RtcmClient(QObject *parent) : QObject(parent)
 {
+    rtcm3_init_state(&mHealthRtcmState);
+
+    mReconnectTimer.setSingleShot(true);
+    connect(&mReconnectTimer, &QTimer::timeout, this, [this]{
+        mHealth.reconnects++;
+        connectToCurrentHost();
+    });
+    connect(&mStaleTimer, &QTimer::timeout, this, &RtcmClient::checkStale);
+
+    connect(&mTcpSocket, &QTcpSocket::disconnected, this, [this]{
+        mHealth.connected = false;
+        mStaleTimer.stop();
+        if (mAutoReconnect && !mDisconnectRequested)
+            scheduleReconnect();
+    });
+    connect(&mTcpSocket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::errorOccurred), this, [this]{
+        // A failed connection attempt does not emit disconnected
+        if (mTcpSocket.state() == QAbstractSocket::UnconnectedState && mAutoReconnect && !mDisconnectRequested)
+            scheduleReconnect();
+    });
+
     connect(&mTcpSocket, &QTcpSocket::readyRead, [this]{
+        const auto rxTime = std::chrono::steady_clock::now();
         QByteArray data =  mTcpSocket.readAll();
 //        qDebug() << data;
+        if (mRawDataTap)
+            mRawDataTap(data, rxTime);
 
         // Make sure to skip "ICY 200 OK" when connection to NTRIP
         if (!mSkippedFirstReply) {
             mSkippedFirstReply = true;
             return;
         }
-
-        // Try to read 1005 or 1006 from stream to get base station position
-        // See RTKLIB for how RTCM is decoded (https://github.com/tomojitakasu/RTKLIB)
-        // We are not CRC checking here (getting data via TCP anyways)
-        // TODO: wait for rest of incomplete message?
-        if (!mFoundReferenceStationInfo) {
-            const char* dataPtr = data.constData();
-            while ((dataPtr = std::find(dataPtr, data.constEnd(), RTCM3_PREAMBLE)) != data.constEnd()) {
-                if (dataPtr + 5 < data.constEnd()) {
-                    int length = getbitu(dataPtr, 14, 10) + 1; // number of bytes inkl. crc
-                    int type = getbitu(dataPtr, 24, 12);
-                    if (dataPtr + length < data.constEnd() && (type == 1005 || type == 1006)) {
-                        llh_t baseLlh = decodeLllhFromReferenceStationInfo(data.mid(dataPtr - data.constData(), length));
-//                        qDebug() << baseLlh.latitude << baseLlh.longitude << baseLlh.height << dataPtr - data.data() << length;
-                        qDebug() << "RtcmClient got base station position:" << baseLlh.latitude << baseLlh.longitude << baseLlh.height;
-                        mFoundReferenceStationInfo = true;
-                        emit baseStationPosition(baseLlh);
-                    }
-                }
-                dataPtr++;
-            }
-        }
-        emit rtcmData(data);
+        processData(data);
     });
 
     connect(&mTcpSocket, &QTcpSocket::connected, [this]{
+        mRtcmFilter.reset();
+        mSkippedFirstReply = false;
+        mLastGgaSent_ns = utcTime::INVALID;
+
+        const int reconnects = mHealth.reconnects;
+        mHealth = RtcmClientHealth();
+        mHealth.connected = true;
+        mHealth.reconnects = reconnects;
+        rtcm3_init_state(&mHealthRtcmState);
+        mConnectedTime_ns = utcTime::now_ns();
+        mThroughputWindowStart_ns = utcTime::INVALID;
+        mThroughputWindowBytes = 0;
+        mStaleTimer.start(1000);
+
         // If a stream is selected, we connected to an NTRIP server and potentially need to authenticate.
         if (mCurrentNtripConnectionInfo.stream.size() > 0) {
             QString msg;
@@ -63,12 +110,45 @@ RtcmClient::RtcmClient(QObject *parent) : QObject(parent)
     });
 }
 
+void RtcmClient::processData(QByteArray data)
+{
+    updateHealth(data);
+
+    // Try to read 1005 or 1006 from stream to get base station position
+    // See RTKLIB for how RTCM is decoded (https://github.com/tomojitakasu/RTKLIB)
+    // We are not CRC checking here (getting data via TCP anyways)
+    // TODO: wait for rest of incomplete message?
+    if (!mFoundReferenceStationInfo) {
+        const char* dataPtr = data.constData();
+        while ((dataPtr = std::find(dataPtr, data.constEnd(), RTCM3_PREAMBLE)) != data.constEnd()) {
+            if (dataPtr + 5 < data.constEnd()) {
+                const uint8_t *frame = reinterpret_cast<const uint8_t*>(dataPtr);
+                const int available = data.constEnd() - dataPtr;
+                int length = rtcmBits::getbitu(frame, available, 14, 10) + 1; // number of bytes inkl. crc
+                int type = rtcmBits::getbitu(frame, available, 24, 12);
+                if (dataPtr + length < data.constEnd() && (type == 1005 || type == 1006)) {
+                    llh_t baseLlh = decodeLllhFromReferenceStationInfo(data.mid(dataPtr - data.constData(), length));
+//                        qDebug() << baseLlh.latitude << baseLlh.longitude << baseLlh.height << dataPtr - data.data() << length;
+                    qDebug() << "RtcmClient got base station position:" << baseLlh.latitude << baseLlh.longitude << baseLlh.height;
+                    mFoundReferenceStationInfo = true;
+                    emit baseStationPosition(baseLlh);
+                }
+            }
+            dataPtr++;
+        }
+    }
+
+    if (mFilterEnabled) {
+        data = mRtcmFilter.filter(data);
+        if (data.isEmpty())
+            return;
+    }
+    emit rtcmData(data);
+}
+
 void RtcmClient::connectTcp(QString host, qint16 port)
 {
-    mCurrentHost = host;
-    mCurrentPort = port;
-    mCurrentNtripConnectionInfo = {"", "", ""};
-    mTcpSocket.connectToHost(mCurrentHost, mCurrentPort);
+    connectNtrip(host, port, {"", "", ""});
 }
 
 void RtcmClient::connectNtrip(QString host, qint16 port, NtripConnectionInfo ntripConnectionInfo)
@@ -76,6 +156,18 @@ void RtcmClient::connectNtrip(QString host, qint16 port, NtripConnectionInfo ntr
     mCurrentHost = host;
     mCurrentPort = port;
     mCurrentNtripConnectionInfo = ntripConnectionInfo;
+    mFoundReferenceStationInfo = false;
+    mHealth.reconnects = 0;
+    mReconnectDelay_ms = MIN_RECONNECT_DELAY_MS;
+    connectToCurrentHost();
+}
+
+void RtcmClient::connectToCurrentHost()
+{
+    mDisconnectRequested = false;
+    mReconnectTimer.stop();
+    if (mTcpSocket.state() != QAbstractSocket::UnconnectedState)
+        mTcpSocket.abort();
     mTcpSocket.connectToHost(mCurrentHost, mCurrentPort);
 }
 
@@ -106,8 +198,19 @@ bool RtcmClient::isConnected()
 
 void RtcmClient::disconnect()
 {
+    mDisconnectRequested = true;
+    mReconnectTimer.stop();
     if (isConnected())
         mTcpSocket.disconnectFromHost();
+    else if (mTcpSocket.state() != QAbstractSocket::UnconnectedState)
+        mTcpSocket.abort(); // still connecting
+}
+
+void RtcmClient::setFilterEnabled(bool filterEnabled)
+{
+    if (filterEnabled && !mFilterEnabled)
+        mRtcmFilter.reset();
+    mFilterEnabled = filterEnabled;
 }
 
 QString RtcmClient::getCurrentHost() const
@@ -124,33 +227,95 @@ void RtcmClient::forwardNmeaGgaToServer(const QByteArray &nmeaGgaStr)
 {
     // Send NMEA GGA to NTRIP/RTCM server until we got reference station information.
     // Some NTRIP servers will not start sending RTCM unless they got NMEA GGA.
-    if (isConnected() && mSkippedFirstReply)
-        mTcpSocket.write(nmeaGgaStr);
-}
+    if (!isConnected() || !mSkippedFirstReply)
+        return;
 
-unsigned int RtcmClient::getbitu(const char *buff, int pos, int len) {
-    unsigned int bits=0;
-    int i;
+    const qint64 now_ns = utcTime::now_ns();
+    if (mGgaInterval_ms > 0 && utcTime::isValid(mLastGgaSent_ns) && now_ns - mLastGgaSent_ns < mGgaInterval_ms * utcTime::NS_PER_MS)
+        return;
 
-    for (i = pos;i < pos + len;i++) {
-        bits = (bits << 1) + ((buff[i / 8] >> (7 - i % 8)) & 1u);
-    }
+    mTcpSocket.write(nmeaGgaStr);
+    mLastGgaSent_ns = now_ns;
+}
 
-    return bits;
+void RtcmClient::setAutoReconnect(bool autoReconnect)
+{
+    mAutoReconnect = autoReconnect;
+    if (!autoReconnect)
+        mReconnectTimer.stop();
 }
 
-int RtcmClient::getbits(const char *buff, int pos, int len) {
-    unsigned int bits = getbitu(buff, pos, len);
+RtcmClientHealth RtcmClient::getHealth() const
+{
+    RtcmClientHealth health = mHealth;
+    if (!utcTime::isValid(health.lastData_ns) || utcTime::now_ns() - health.lastData_ns > THROUGHPUT_STALE_MS * utcTime::NS_PER_MS)
+        health.throughput_Bps = 0.0;
+    return health;
+}
 
-    if (len <= 0 || 32 <= len || !(bits & (1u << (len - 1)))) {
-        return (int)bits;
+void RtcmClient::updateHealth(const QByteArray &data)
+{
+    const qint64 now_ns = utcTime::now_ns();
+    if (!utcTime::isValid(mHealth.lastData_ns))
+        mReconnectDelay_ms = MIN_RECONNECT_DELAY_MS; // the connection works
+    mHealth.bytes += data.size();
+    mHealth.lastData_ns = now_ns;
+
+    if (!utcTime::isValid(mThroughputWindowStart_ns))
+        mThroughputWindowStart_ns = now_ns;
+    mThroughputWindowBytes += data.size();
+    const qint64 window_ns = now_ns - mThroughputWindowStart_ns;
+    if (window_ns >= THROUGHPUT_WINDOW_MS * utcTime::NS_PER_MS) {
+        const double throughput_Bps = mThroughputWindowBytes / (window_ns * 1e-9);
+        mHealth.throughput_Bps = mHealth.throughput_Bps > 0.0 ? 0.7 * mHealth.throughput_Bps + 0.3 * throughput_Bps : throughput_Bps;
+        mThroughputWindowStart_ns = now_ns;
+        mThroughputWindowBytes = 0;
     }
 
-    return (int)(bits | (~0u << len)); // extend sign
+    const uint8_t *dataPtr = reinterpret_cast<const uint8_t*>(data.constData());
+    for (int i = 0; i < data.size(); i++) {
+        const int consumed = rtcm3_input_payload(dataPtr + i, data.size() - i, &mHealthRtcmState);
+        if (consumed > 0) {
+            i += consumed - 1;
+            continue;
+        }
+
+        const int type = rtcm3_input_data(dataPtr[i], &mHealthRtcmState);
+        if (type < 1000)
+            continue;
+
+        mHealth.messages++;
+        if (type == 1005 || type == 1006)
+            mHealth.lastReferenceStation_ns = now_ns;
+        else if (RtcmFilter::isMsm(type)) {
+            mHealth.correctionAge_ms = getMsmCorrectionAge_ms(mHealthRtcmState.buffer, mHealthRtcmState.len + 3, type, now_ns);
+            mHealth.meanCorrectionAge_ms = mHealth.meanCorrectionAge_ms < 0.0 ? mHealth.correctionAge_ms :
+                                                                                 0.9 * mHealth.meanCorrectionAge_ms + 0.1 * mHealth.correctionAge_ms;
+        }
+    }
+}
+
+void RtcmClient::scheduleReconnect()
+{
+    if (mReconnectTimer.isActive())
+        return;
+
+    qDebug() << "RtcmClient: reconnecting to" << mCurrentHost << "in" << mReconnectDelay_ms / 1000.0 << "s";
+    mReconnectTimer.start(mReconnectDelay_ms);
+    mReconnectDelay_ms = qMin(2 * mReconnectDelay_ms, MAX_RECONNECT_DELAY_MS);
 }
 
-double RtcmClient::getbits_38(const char *buff, int pos) {
-    return (double)getbits(buff, pos, 32) * D(64.0) + getbitu(buff, pos + 32, 6);
+void RtcmClient::checkStale()
+{
+    const qint64 lastActivity_ns = utcTime::isValid(mHealth.lastData_ns) ? mHealth.lastData_ns : mConnectedTime_ns;
+    if (!mAutoReconnect || !mHealth.connected || utcTime::now_ns() - lastActivity_ns <= STALE_TIMEOUT_MS * utcTime::NS_PER_MS)
+        return;
+
+    qWarning() << "WARNING: RtcmClient got no data from" << mCurrentHost << "for" << STALE_TIMEOUT_MS / 1000 << "s, reconnecting";
+    mTcpSocket.abort();
+    mHealth.connected = false;
+    mStaleTimer.stop();
+    scheduleReconnect();
 }
 
 llh_t RtcmClient::decodeLllhFromReferenceStationInfo(const QByteArray data)
@@ -163,12 +328,15 @@ llh_t RtcmClient::decodeLllhFromReferenceStationInfo(const QByteArray data)
     int itrf; Q_UNUSED(itrf)
     llh_t llhResult = {0.0, 0.0, 0.0};
 
+    // Bounds-checked, fields past the end of a truncated message read as 0
+    const uint8_t *buff = reinterpret_cast<const uint8_t*>(data.constData());
+    const int size = data.size();
 //    if (bitIdx + 140 <= data.size() * 8) {
-        staid = getbitu(data.constData(), bitIdx, 12); bitIdx+=12;
-        itrf  = getbitu(data.constData(), bitIdx, 6);  bitIdx+= 6+4;
-        p0    = getbits_38(data.constData(), bitIdx);  bitIdx+=38+2;
-        p1    = getbits_38(data.constData(), bitIdx);  bitIdx+=38+2;
-        p2    = getbits_38(data.constData(), bitIdx);
+        staid = rtcmBits::getbitu(buff, size, bitIdx, 12); bitIdx+=12;
+        itrf  = rtcmBits::getbitu(buff, size, bitIdx, 6);  bitIdx+= 6+4;
+        p0    = rtcmBits::getbits_38(buff, size, bitIdx);  bitIdx+=38+2;
+        p1    = rtcmBits::getbits_38(buff, size, bitIdx);  bitIdx+=38+2;
+        p2    = rtcmBits::getbits_38(buff, size, bitIdx);
 
 
         p0 *= D(0.0001);
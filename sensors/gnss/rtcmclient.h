@@ -4,6 +4,10 @@
  *
  * Connects to NTRIP / RTCM server (TCP/IP) and streams received messages using singal/slot
  * Some rudimentary parsing of messages.
+ * Health of the stream (see getHealth): throughput and the age of the corrections, i.e., of MSM epochs relative to
+ * utcTime::now_ns() (only meaningful with a synchronized clock, e.g., NTP or GnssTimeDiscipline). Optionally reconnects with
+ * exponential backoff when the connection is lost or no data arrives for STALE_TIMEOUT_MS. See NtripCasterSelector for failover
+ * between casters.
  */
 
 #ifndef RTCMCLIENT_H
@@ -12,7 +16,13 @@
 #include <QObject>
 #include <QTcpSocket>
 #include <QHostAddress>
+#include <QTimer>
+#include <chrono>
+#include <functional>
 #include "core/coordinatetransforms.h"
+#include "core/utctime.h"
+#include "rtcm3_simple.h"
+#include "rtcmfilter.h"
 
 #ifndef D
 #define D(x) 						((double)x##L)
@@ -28,6 +38,18 @@ struct NtripConnectionInfo {
     QString stream;
 };
 
+struct RtcmClientHealth {
+    bool connected = false;
+    quint64 bytes = 0; // since connecting
+    quint64 messages = 0;
+    double throughput_Bps = 0.0; // smoothed, 0 when stale
+    qint64 lastData_ns = utcTime::INVALID; // UTC
+    qint64 lastReferenceStation_ns = utcTime::INVALID; // 1005/1006
+    double correctionAge_ms = -1.0; // of the last MSM epoch, -1: none received
+    double meanCorrectionAge_ms = -1.0; // smoothed
+    int reconnects = 0;
+};
+
 class RtcmClient : public QObject
 {
     Q_OBJECT
@@ -42,26 +64,68 @@ public:
     QString getCurrentHost() const;
     qint16 getCurrentPort() const;
 
+    // Rate limited to the GGA interval (VRS casters need a position, but not at the receiver's rate), 0: every GGA
     void forwardNmeaGgaToServer(const QByteArray& nmeaGgaStr);
+    void setGgaInterval_ms(int ggaInterval_ms) { mGgaInterval_ms = ggaInterval_ms; }
+    int getGgaInterval_ms() const { return mGgaInterval_ms; }
+
+    // Reconnect after connection loss or a stale stream (not after disconnect()), with backoff from MIN to MAX_RECONNECT_DELAY_MS
+    void setAutoReconnect(bool autoReconnect);
+    bool getAutoReconnect() const { return mAutoReconnect; }
+    RtcmClientHealth getHealth() const;
+
+    static constexpr int DEFAULT_GGA_INTERVAL_MS = 5000;
+    static constexpr int STALE_TIMEOUT_MS = 10000;
+    static constexpr int MIN_RECONNECT_DELAY_MS = 1000;
+    static constexpr int MAX_RECONNECT_DELAY_MS = 60000;
+    static constexpr int GPS_LEAP_SECONDS = 18; // GPS - UTC, for correction ages
+
+    // Optional filtering of the stream before rtcmData is emitted (disabled by default, i.e., data is forwarded unchanged)
+    RtcmFilter &getFilter() { return mRtcmFilter; }
+    bool getFilterEnabled() const { return mFilterEnabled; }
+    void setFilterEnabled(bool filterEnabled);
+
+    // Called with every chunk received from the server (before filtering), e.g., to record the raw stream (see RawStreamRecorder::getTap)
+    using RawDataTap = std::function<void(const QByteArray &data, std::chrono::steady_clock::time_point rxTime)>;
+    void setRawDataTap(RawDataTap tap) { mRawDataTap = tap; }
+    // Processes data as received from the server (after the NTRIP reply), e.g., replayed recordings or benchmarks
+    void processData(QByteArray data);
 
 signals:
     void rtcmData(const QByteArray &data);
     void baseStationPosition(const llh_t &baseStationPosition);
 
 private:
+    void connectToCurrentHost();
+    void updateHealth(const QByteArray &data);
+    void scheduleReconnect();
+    void checkStale();
+
     QTcpSocket mTcpSocket;
     QString mCurrentHost;
     qint16 mCurrentPort;
     NtripConnectionInfo mCurrentNtripConnectionInfo;
     bool mFoundReferenceStationInfo = false;
     bool mSkippedFirstReply = false;
+    RtcmFilter mRtcmFilter;
+    bool mFilterEnabled = false;
+    RawDataTap mRawDataTap;
 
-    // For parsing RTCMv3 (from RTKLIB)
-    const char RTCM3_PREAMBLE = char(0xD3);
-    static unsigned int getbitu(const char *buff, int pos, int len);
-    static int getbits(const char *buff, int pos, int len);
-    static double getbits_38(const char *buff, int pos);
+    int mGgaInterval_ms = DEFAULT_GGA_INTERVAL_MS;
+    qint64 mLastGgaSent_ns = utcTime::INVALID;
+    bool mAutoReconnect = false;
+    bool mDisconnectRequested = false;
+    int mReconnectDelay_ms = MIN_RECONNECT_DELAY_MS;
+    QTimer mReconnectTimer;
+    QTimer mStaleTimer;
+    rtcm3_state mHealthRtcmState; // frames the stream for health
+    RtcmClientHealth mHealth;
+    qint64 mConnectedTime_ns = utcTime::INVALID;
+    qint64 mThroughputWindowStart_ns = utcTime::INVALID;
+    quint64 mThroughputWindowBytes = 0;
 
+    // For parsing RTCMv3 (bit fields, see rtcmbits.h)
+    const char RTCM3_PREAMBLE = char(0xD3);
 };
 
 #endif // RTCMCLIENT_H
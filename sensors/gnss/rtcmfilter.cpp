@@ -0,0 +1,105 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "rtcmfilter.h"
+
+RtcmFilter::RtcmFilter()
+{
+    rtcm3_init_state(&mRtcmState);
+}
+
+QByteArray RtcmFilter::filter(const QByteArray &data)
+{
+    QByteArray filtered;
+    const uint8_t *dataPtr = (const uint8_t*)data.constData();
+
+    for (int i = 0; i < data.size(); i++) {
+        int consumed = rtcm3_input_payload(dataPtr + i, data.size() - i, &mRtcmState);
+        if (consumed > 0) {
+            i += consumed - 1;
+            continue;
+        }
+
+        int type = rtcm3_input_data(dataPtr[i], &mRtcmState);
+        if (type < 1000)
+            continue;
+
+        const int length = mRtcmState.len + 3; // incl. crc
+        RtcmTypeStatistics &statistics = mStatistics[type];
+        statistics.messagesIn++;
+        statistics.bytesIn += length;
+
+        if (passes(type)) {
+            const int filteredSize = filtered.size();
+            if (!(mTranscodeMsm7ToMsm4 && getMsmLevel(type) == 7 && transcodeToMsm4(type, filtered)))
+                filtered.append((const char*)mRtcmState.buffer, length);
+
+            statistics.messagesOut++;
+            statistics.bytesOut += filtered.size() - filteredSize;
+        }
+    }
+
+    return filtered;
+}
+
+void RtcmFilter::reset()
+{
+    rtcm3_init_state(&mRtcmState);
+    mDecimationCounters.clear();
+    mMsm4Constellations = 0;
+}
+
+void RtcmFilter::setDecimation(int type, int n)
+{
+    if (n <= 1) {
+        mDecimation.remove(type);
+        mDecimationCounters.remove(type);
+    } else
+        mDecimation[type] = n;
+}
+
+bool RtcmFilter::transcodeToMsm4(int type, QByteArray &output)
+{
+    if (!rtcm3_is_supported_msm(type))
+        return false;
+
+    const int numObservations = rtcm3_decode_msm(&mRtcmState);
+    if (numObservations < 0)
+        return false;
+
+    // Encoded in place at the end of output
+    const int outputSize = output.size();
+    output.resize(outputSize + 3 + 1024 + 3);
+    int length = 0;
+    if (!rtcm3_encode_msm(&mRtcmState.header, mRtcmState.obs, numObservations, type - 3, (uint8_t*)output.data() + outputSize, &length)) {
+        output.resize(outputSize);
+        return false;
+    }
+    output.resize(outputSize + length);
+    return true;
+}
+
+bool RtcmFilter::passes(int type)
+{
+    if (!mAllowedTypes.isEmpty() && !mAllowedTypes.contains(type))
+        return false;
+
+    if (mPreferMsm4 && isMsm(type)) {
+        const quint8 constellationBit = 1 << getMsmConstellation(type);
+        if (getMsmLevel(type) == 4)
+            mMsm4Constellations |= constellationBit;
+        else if (getMsmLevel(type) == 7 && (mMsm4Constellations & constellationBit))
+            return false;
+    }
+
+    auto decimation = mDecimation.constFind(type);
+    if (decimation != mDecimation.constEnd()) {
+        int &counter = mDecimationCounters[type];
+        const bool forward = (counter == 0);
+        counter = (counter + 1) % *decimation;
+        return forward;
+    }
+
+    return true;
+}
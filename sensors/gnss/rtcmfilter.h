@@ -0,0 +1,71 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Frames an RTCM3 byte stream into messages and forwards only a configurable subset of them
+ * (allow-list of message types, per-type decimation, MSM4 over MSM7, MSM7 transcoded to MSM4), e.g., to fit corrections into
+ * low-bandwidth telemetry links.
+ * Keeps per-type message/byte counters of input and output.
+ */
+
+#ifndef RTCMFILTER_H
+#define RTCMFILTER_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QSet>
+#include <QtGlobal>
+#include "rtcm3_simple.h"
+
+struct RtcmTypeStatistics {
+    quint64 messagesIn = 0;
+    quint64 bytesIn = 0;
+    quint64 messagesOut = 0;
+    quint64 bytesOut = 0;
+};
+
+class RtcmFilter
+{
+public:
+    RtcmFilter();
+
+    // Returns the complete messages of data (and of earlier calls) that pass the filter, partial messages are kept until complete
+    QByteArray filter(const QByteArray &data);
+    void reset(); // drop partial messages and MSM history, e.g., on reconnect
+
+    // Empty allow-list: all types are allowed
+    QSet<int> getAllowedTypes() const { return mAllowedTypes; }
+    void setAllowedTypes(const QSet<int> &allowedTypes) { mAllowedTypes = allowedTypes; }
+    // Forward only every n-th message of type (n <= 1: all)
+    int getDecimation(int type) const { return mDecimation.value(type, 1); }
+    void setDecimation(int type, int n);
+    // Drop MSM7 of a constellation once MSM4 of the same constellation was received (MSM4 is about half the size)
+    bool getPreferMsm4() const { return mPreferMsm4; }
+    void setPreferMsm4(bool preferMsm4) { mPreferMsm4 = preferMsm4; }
+    // Re-encode forwarded MSM7 of GPS, GLONASS, Galileo and BeiDou as MSM4 (drops Doppler and the resolution MSM4 does not have,
+    // only L1/L2-type signals, see rtcm3_decode_msm). Output statistics count the MSM4 under the MSM7 type.
+    bool getTranscodeMsm7ToMsm4() const { return mTranscodeMsm7ToMsm4; }
+    void setTranscodeMsm7ToMsm4(bool transcodeMsm7ToMsm4) { mTranscodeMsm7ToMsm4 = transcodeMsm7ToMsm4; }
+
+    QMap<int, RtcmTypeStatistics> getStatistics() const { return mStatistics; }
+    void resetStatistics() { mStatistics.clear(); }
+
+    static bool isMsm(int type) { return type >= 1071 && type <= 1137 && (type % 10) >= 1 && (type % 10) <= 7; }
+    static int getMsmConstellation(int type) { return (type - 1070) / 10; } // 0: GPS, 1: GLONASS, 2: Galileo, 3: SBAS, 4: QZSS, 5: BeiDou, 6: NavIC
+    static int getMsmLevel(int type) { return type % 10; }
+
+private:
+    bool passes(int type);
+    bool transcodeToMsm4(int type, QByteArray &output);
+
+    rtcm3_state mRtcmState;
+    QSet<int> mAllowedTypes;
+    QMap<int, int> mDecimation;
+    QMap<int, int> mDecimationCounters;
+    bool mPreferMsm4 = false;
+    bool mTranscodeMsm7ToMsm4 = false;
+    quint8 mMsm4Constellations = 0; // bit per constellation
+    QMap<int, RtcmTypeStatistics> mStatistics;
+};
+
+#endif // RTCMFILTER_H
@@ -0,0 +1,335 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "rtcmrelayserver.h"
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+bool isStationFrame(int type)
+{
+    return type == 1005 || type == 1006 || type == 1007 || type == 1008 || type == 1033 || type == 1230;
+}
+}
+
+RtcmRelayServer::RtcmRelayServer(QObject *parent) : QObject(parent)
+{
+    rtcm3_init_state(&mRtcmState);
+    mRing.resize(RING_CAPACITY);
+
+    connect(&mTcpServer, &QTcpServer::newConnection, this, [this]{ acceptConnections(&mTcpServer, false); });
+    connect(&mNtripServer, &QTcpServer::newConnection, this, [this]{ acceptConnections(&mNtripServer, true); });
+
+    connect(&mStatisticsTimer, &QTimer::timeout, this, &RtcmRelayServer::updateThroughput);
+    mStatisticsTimer.start(STATISTICS_INTERVAL_MS);
+    mStatisticsElapsed.start();
+}
+
+bool RtcmRelayServer::startTcp(quint16 port, const QHostAddress &address)
+{
+    if (!mTcpServer.listen(address, port)) {
+        qDebug() << "Warning: RtcmRelayServer could not listen on TCP port" << port << ":" << mTcpServer.errorString();
+        return false;
+    }
+    qDebug() << "RtcmRelayServer: relaying RTCM on TCP port" << port;
+    return true;
+}
+
+bool RtcmRelayServer::startNtrip(quint16 port, const QString &mountpoint, const QHostAddress &address)
+{
+    mNtripMountpoint = mountpoint.startsWith('/') ? mountpoint.mid(1) : mountpoint;
+    if (!mNtripServer.listen(address, port)) {
+        qDebug() << "Warning: RtcmRelayServer could not listen on NTRIP port" << port << ":" << mNtripServer.errorString();
+        return false;
+    }
+    qDebug() << "RtcmRelayServer: NTRIP caster for mountpoint" << mNtripMountpoint << "on port" << port;
+    return true;
+}
+
+void RtcmRelayServer::setNtripCredentials(const QString &user, const QString &password)
+{
+    mNtripAuthorization = user.isEmpty() ? QByteArray() : QString(user + ":" + password).toUtf8().toBase64();
+}
+
+bool RtcmRelayServer::startUdp(const QHostAddress &address, quint16 port, int multicastTtl)
+{
+    if (mUdpSocket.state() != QAbstractSocket::BoundState &&
+            !mUdpSocket.bind(address.protocol() == QAbstractSocket::IPv6Protocol ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4, 0)) {
+        qDebug() << "Warning: RtcmRelayServer could not open UDP socket:" << mUdpSocket.errorString();
+        return false;
+    }
+    if (address.isMulticast())
+        mUdpSocket.setSocketOption(QAbstractSocket::MulticastTtlOption, multicastTtl);
+
+    mUdpAddress = address;
+    mUdpPort = port;
+    mUdpStatistics = RtcmRelayClientStatistics();
+    mUdpStatistics.protocol = RtcmRelayClientStatistics::Protocol::Udp;
+    mUdpStatistics.address = address;
+    mUdpStatistics.port = port;
+    mUdpBytesSentAtLastUpdate = 0;
+    mUdpStarted.start();
+    qDebug() << "RtcmRelayServer: relaying RTCM to UDP" << address.toString() << port;
+    return true;
+}
+
+void RtcmRelayServer::stop()
+{
+    mTcpServer.close();
+    mNtripServer.close();
+    mUdpSocket.close();
+    mUdpPort = 0;
+
+    const QList<QTcpSocket*> sockets = mClients.keys();
+    for (QTcpSocket *socket : sockets) {
+        socket->abort();
+        removeClient(socket);
+    }
+}
+
+void RtcmRelayServer::setMaxClientBacklog(int frames)
+{
+    mMaxClientBacklog = std::clamp(frames, 1, RING_CAPACITY);
+}
+
+QVector<RtcmRelayClientStatistics> RtcmRelayServer::getClientStatistics() const
+{
+    QVector<RtcmRelayClientStatistics> statistics;
+    statistics.reserve(mClients.size());
+    for (const Client &client : mClients) {
+        RtcmRelayClientStatistics clientStatistics = client.statistics;
+        clientStatistics.connectedFor_ms = client.connected.elapsed();
+        clientStatistics.backlogFrames = client.streaming ? int(mNextFrame - client.nextFrame) + client.stationFrames.size() : 0;
+        statistics.append(clientStatistics);
+    }
+    return statistics;
+}
+
+void RtcmRelayServer::relayRtcmData(const QByteArray &data)
+{
+    const uint8_t *dataPtr = (const uint8_t*)data.constData();
+
+    for (int i = 0; i < data.size(); i++) {
+        int consumed = rtcm3_input_payload(dataPtr + i, data.size() - i, &mRtcmState);
+        if (consumed > 0) {
+            i += consumed - 1;
+            continue;
+        }
+
+        int type = rtcm3_input_data(dataPtr[i], &mRtcmState);
+        if (type >= 1000)
+            relayFrame(QByteArray((const char*)mRtcmState.buffer, mRtcmState.len + 3), type);
+    }
+}
+
+void RtcmRelayServer::relayFrame(const QByteArray &frame, int type)
+{
+    if (isStationFrame(type))
+        mStationFrames[type] = frame;
+
+    if (mUdpPort != 0) {
+        if (mUdpSocket.writeDatagram(frame, mUdpAddress, mUdpPort) == frame.size()) {
+            mUdpStatistics.framesSent++;
+            mUdpStatistics.bytesSent += frame.size();
+        } else
+            mUdpStatistics.framesDropped++;
+    }
+
+    // Stored once, clients share the frame (implicitly shared QByteArray)
+    mRing[mNextFrame % RING_CAPACITY] = frame;
+    mNextFrame++;
+
+    for (Client &client : mClients)
+        if (client.streaming)
+            sendFrames(client);
+}
+
+void RtcmRelayServer::acceptConnections(QTcpServer *server, bool ntrip)
+{
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        Client client;
+        client.socket = socket;
+        client.statistics.protocol = ntrip ? RtcmRelayClientStatistics::Protocol::NtripV1 : RtcmRelayClientStatistics::Protocol::Tcp;
+        client.statistics.address = socket->peerAddress();
+        client.statistics.port = socket->peerPort();
+        client.connected.start();
+        Client &added = *mClients.insert(socket, client);
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]{ readClient(socket); });
+        connect(socket, &QTcpSocket::bytesWritten, this, [this, socket]{
+            auto client = mClients.find(socket);
+            if (client != mClients.end() && client->streaming)
+                sendFrames(*client);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]{ removeClient(socket); });
+
+        qDebug() << "RtcmRelayServer: client connected from" << socket->peerAddress().toString() << socket->peerPort();
+        emit clientConnected(socket->peerAddress(), socket->peerPort());
+
+        if (!ntrip)
+            startStreaming(added);
+    }
+}
+
+void RtcmRelayServer::readClient(QTcpSocket *socket)
+{
+    auto client = mClients.find(socket);
+    if (client == mClients.end())
+        return;
+
+    // Streaming clients may send, e.g., NMEA GGA, which is not needed for a single base
+    if (client->streaming || client->statistics.protocol == RtcmRelayClientStatistics::Protocol::Tcp) {
+        socket->readAll();
+        return;
+    }
+
+    client->request.append(socket->readAll());
+    if (client->request.contains("\r\n\r\n"))
+        handleNtripRequest(*client);
+    else if (client->request.size() > MAX_REQUEST_SIZE)
+        socket->disconnectFromHost();
+}
+
+void RtcmRelayServer::handleNtripRequest(Client &client)
+{
+    const QList<QByteArray> lines = client.request.left(client.request.indexOf("\r\n\r\n")).split('\n');
+    const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    QTcpSocket *socket = client.socket;
+
+    bool ntripV2 = false;
+    QByteArray authorization;
+    for (const QByteArray &line : lines) {
+        const QByteArray header = line.trimmed();
+        if (header.toLower().startsWith("ntrip-version:"))
+            ntripV2 = header.mid(header.indexOf(':') + 1).trimmed() == "Ntrip/2.0";
+        else if (header.toLower().startsWith("authorization:")) {
+            const QList<QByteArray> credentials = header.mid(header.indexOf(':') + 1).trimmed().split(' ');
+            if (credentials.size() == 2 && credentials.first().toLower() == "basic")
+                authorization = credentials.last();
+        }
+    }
+    client.statistics.protocol = ntripV2 ? RtcmRelayClientStatistics::Protocol::NtripV2 : RtcmRelayClientStatistics::Protocol::NtripV1;
+
+    if (requestLine.size() < 2 || requestLine.first() != "GET") {
+        socket->write("HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n");
+        socket->disconnectFromHost();
+        return;
+    }
+
+    const QByteArray mountpoint = requestLine.at(1).mid(1);
+    if (mountpoint.isEmpty() || mountpoint != mNtripMountpoint.toUtf8()) {
+        const QByteArray sourceTable = getSourceTable();
+        if (ntripV2)
+            socket->write("HTTP/1.1 200 OK\r\nNtrip-Version: Ntrip/2.0\r\nServer: NTRIP WayWise RtcmRelayServer\r\n"
+                          "Content-Type: gnss/sourcetable\r\nConnection: close\r\nContent-Length: " + QByteArray::number(sourceTable.size()) + "\r\n\r\n");
+        else
+            socket->write("SOURCETABLE 200 OK\r\nServer: NTRIP WayWise RtcmRelayServer\r\nContent-Type: text/plain\r\n"
+                          "Content-Length: " + QByteArray::number(sourceTable.size()) + "\r\n\r\n");
+        socket->write(sourceTable);
+        socket->disconnectFromHost();
+        return;
+    }
+
+    if (!mNtripAuthorization.isEmpty() && authorization != mNtripAuthorization) {
+        socket->write("HTTP/1.1 401 Unauthorized\r\nWWW-Authenticate: Basic realm=\"/" + mNtripMountpoint.toUtf8() + "\"\r\nConnection: close\r\n\r\n");
+        socket->disconnectFromHost();
+        return;
+    }
+
+    if (ntripV2)
+        socket->write("HTTP/1.1 200 OK\r\nNtrip-Version: Ntrip/2.0\r\nServer: NTRIP WayWise RtcmRelayServer\r\nContent-Type: gnss/data\r\n"
+                      "Cache-Control: no-store, no-cache, max-age=0\r\nPragma: no-cache\r\nConnection: close\r\nTransfer-Encoding: chunked\r\n\r\n");
+    else
+        socket->write("ICY 200 OK\r\n\r\n");
+
+    client.request.clear();
+    startStreaming(client);
+}
+
+void RtcmRelayServer::startStreaming(Client &client)
+{
+    client.streaming = true;
+    client.nextFrame = mNextFrame;
+    client.stationFrames = mStationFrames.values().toVector();
+    sendFrames(client);
+}
+
+void RtcmRelayServer::sendFrames(Client &client)
+{
+    if (client.socket->state() != QAbstractSocket::ConnectedState)
+        return;
+
+    if (mNextFrame - client.nextFrame > quint64(mMaxClientBacklog)) {
+        // Too slow: old corrections are of no use, continue with the next frame
+        client.statistics.framesDropped += mNextFrame - client.nextFrame;
+        client.nextFrame = mNextFrame;
+    }
+
+    while (client.socket->bytesToWrite() < MAX_SOCKET_PENDING_BYTES) {
+        if (!client.stationFrames.isEmpty())
+            writeFrame(client, client.stationFrames.takeFirst());
+        else if (client.nextFrame < mNextFrame)
+            writeFrame(client, mRing.at(client.nextFrame++ % RING_CAPACITY));
+        else
+            break;
+    }
+}
+
+void RtcmRelayServer::writeFrame(Client &client, const QByteArray &frame)
+{
+    qint64 written;
+    if (client.statistics.protocol == RtcmRelayClientStatistics::Protocol::NtripV2) {
+        written = client.socket->write(QByteArray::number(frame.size(), 16) + "\r\n");
+        written += client.socket->write(frame);
+        written += client.socket->write("\r\n");
+    } else
+        written = client.socket->write(frame);
+
+    client.statistics.framesSent++;
+    client.statistics.bytesSent += std::max(written, qint64(0));
+}
+
+void RtcmRelayServer::removeClient(QTcpSocket *socket)
+{
+    auto client = mClients.find(socket);
+    if (client == mClients.end())
+        return;
+
+    const QHostAddress address = client->statistics.address;
+    const quint16 port = client->statistics.port;
+    qDebug() << "RtcmRelayServer: client" << address.toString() << port << "disconnected after sending" << client->statistics.bytesSent
+             << "bytes," << client->statistics.framesDropped << "frames dropped";
+    mClients.erase(client);
+    socket->deleteLater();
+    emit clientDisconnected(address, port);
+}
+
+void RtcmRelayServer::updateThroughput()
+{
+    const qint64 elapsed_ms = mStatisticsElapsed.restart();
+    if (elapsed_ms <= 0)
+        return;
+
+    for (Client &client : mClients) {
+        client.statistics.throughput_Bps = (client.statistics.bytesSent - client.bytesSentAtLastUpdate) * 1000.0 / elapsed_ms;
+        client.bytesSentAtLastUpdate = client.statistics.bytesSent;
+    }
+
+    mUdpStatistics.throughput_Bps = (mUdpStatistics.bytesSent - mUdpBytesSentAtLastUpdate) * 1000.0 / elapsed_ms;
+    mUdpBytesSentAtLastUpdate = mUdpStatistics.bytesSent;
+    if (mUdpStarted.isValid())
+        mUdpStatistics.connectedFor_ms = mUdpStarted.elapsed();
+}
+
+QByteArray RtcmRelayServer::getSourceTable() const
+{
+    // STR;mountpoint;identifier;format;format-details;carrier;nav-system;network;country;latitude;longitude;nmea;solution;
+    //     generator;compression;authentication;fee;bitrate;misc
+    QByteArray sourceTable;
+    if (!mNtripMountpoint.isEmpty())
+        sourceTable += "STR;" + mNtripMountpoint.toUtf8() + ";" + mNtripMountpoint.toUtf8() + ";RTCM 3;;2;GNSS;WayWise;;0.00;0.00;0;0;"
+                       "WayWise;none;" + (mNtripAuthorization.isEmpty() ? "N" : "B") + ";N;0;\r\n";
+    sourceTable += "ENDSOURCETABLE\r\n";
+    return sourceTable;
+}
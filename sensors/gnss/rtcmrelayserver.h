@@ -0,0 +1,123 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Relays RTCM3 from one source (e.g., UbloxBasestation::rtcmData or RtcmClient::rtcmData) to many subscribers:
+ * raw TCP clients, NTRIP clients (v1 and v2, one mountpoint, optional basic authentication) and UDP (multicast), one frame per datagram.
+ * Received data is split into RTCM frames that are stored once in a shared ring buffer, each TCP client has a read position into it.
+ * A client's socket is only given more frames while little of its data is pending, i.e., a slow client falls behind in the ring
+ * (its bounded queue) and its backlog is dropped when it exceeds the limit, it never delays other clients.
+ * New clients start with the latest frames, preceded by the most recent station description (1005/1006/1007/1008/1033/1230).
+ */
+
+#ifndef RTCMRELAYSERVER_H
+#define RTCMRELAYSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include "rtcm3_simple.h"
+
+struct RtcmRelayClientStatistics {
+    enum class Protocol {Tcp, NtripV1, NtripV2, Udp};
+
+    Protocol protocol = Protocol::Tcp;
+    QHostAddress address;
+    quint16 port = 0;
+    qint64 connectedFor_ms = 0;
+    quint64 framesSent = 0;
+    quint64 bytesSent = 0;
+    quint64 framesDropped = 0; // backlog exceeded the limit
+    int backlogFrames = 0; // not yet given to the socket
+    double throughput_Bps = 0.0; // over the last statistics interval
+};
+
+class RtcmRelayServer : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int RING_CAPACITY = 512; // frames
+    static constexpr int DEFAULT_MAX_CLIENT_BACKLOG = 128; // frames, a few seconds of full-constellation MSM7
+    static constexpr qint64 MAX_SOCKET_PENDING_BYTES = 16 * 1024;
+    static constexpr int MAX_REQUEST_SIZE = 4096; // NTRIP request header
+    static constexpr int STATISTICS_INTERVAL_MS = 1000;
+
+    explicit RtcmRelayServer(QObject *parent = nullptr);
+
+    // Raw RTCM3 over TCP, the stream starts right after connecting
+    bool startTcp(quint16 port, const QHostAddress &address = QHostAddress::Any);
+    // NTRIP caster with a single mountpoint, credentials are only checked if a user is set
+    bool startNtrip(quint16 port, const QString &mountpoint, const QHostAddress &address = QHostAddress::Any);
+    void setNtripCredentials(const QString &user, const QString &password);
+    // One datagram per frame, e.g., group 239.255.0.1
+    bool startUdp(const QHostAddress &address, quint16 port, int multicastTtl = 1);
+    void stop(); // disconnects all clients
+
+    int getMaxClientBacklog() const { return mMaxClientBacklog; }
+    void setMaxClientBacklog(int frames);
+
+    int getNumClients() const { return mClients.size(); }
+    QVector<RtcmRelayClientStatistics> getClientStatistics() const;
+    RtcmRelayClientStatistics getUdpStatistics() const { return mUdpStatistics; }
+
+public slots:
+    // Any chunking, frames are reassembled (frames with a wrong crc are dropped)
+    void relayRtcmData(const QByteArray &data);
+
+signals:
+    void clientConnected(const QHostAddress &address, quint16 port);
+    void clientDisconnected(const QHostAddress &address, quint16 port);
+
+private:
+    struct Client {
+        QTcpSocket *socket = nullptr;
+        bool streaming = false; // NTRIP: request accepted
+        QByteArray request;
+        quint64 nextFrame = 0; // sequence number in the ring
+        QVector<QByteArray> stationFrames; // sent before the first frame from the ring
+        RtcmRelayClientStatistics statistics;
+        QElapsedTimer connected;
+        quint64 bytesSentAtLastUpdate = 0;
+    };
+
+    void acceptConnections(QTcpServer *server, bool ntrip);
+    void readClient(QTcpSocket *socket);
+    void handleNtripRequest(Client &client);
+    void startStreaming(Client &client);
+    void sendFrames(Client &client);
+    void writeFrame(Client &client, const QByteArray &frame);
+    void removeClient(QTcpSocket *socket);
+    void relayFrame(const QByteArray &frame, int type);
+    void updateThroughput();
+    QByteArray getSourceTable() const;
+
+    QTcpServer mTcpServer;
+    QTcpServer mNtripServer;
+    QString mNtripMountpoint;
+    QByteArray mNtripAuthorization; // base64 of user:password, empty: no authentication
+    QUdpSocket mUdpSocket;
+    QHostAddress mUdpAddress;
+    quint16 mUdpPort = 0;
+    RtcmRelayClientStatistics mUdpStatistics;
+    QElapsedTimer mUdpStarted;
+    quint64 mUdpBytesSentAtLastUpdate = 0;
+
+    rtcm3_state mRtcmState;
+    QVector<QByteArray> mRing; // frame n at n % RING_CAPACITY
+    quint64 mNextFrame = 0;
+    QMap<int, QByteArray> mStationFrames; // latest per type
+    QHash<QTcpSocket*, Client> mClients;
+    int mMaxClientBacklog = DEFAULT_MAX_CLIENT_BACKLOG;
+
+    QTimer mStatisticsTimer;
+    QElapsedTimer mStatisticsElapsed;
+};
+
+#endif // RTCMRELAYSERVER_H
@@ -4,12 +4,18 @@
  */
 
 #include "ublox.h"
+#include "core/perfcounters.h"
+#include "core/allocationtracker.h"
+#include "core/threadconfig.h"
 #include <QEventLoop>
 #include <cmath>
+#include <algorithm>
 #include <QDebug>
 #include <QDateTime>
 
 namespace {
+static constexpr uint16_t UBLOX_USB_VENDOR_ID = 0x1546;
+
 static uint8_t ubx_get_U1(uint8_t *msg, int *ind) {
     return msg[(*ind)++];
 }
@@ -187,6 +193,19 @@ static void ubx_put_R8(uint8_t *msg, int *ind, double data) {
     msg[(*ind)++] = x.i >> 48;
     msg[(*ind)++] = x.i >> 56;
 }
+
+// UBX (8-bit Fletcher) checksum over a whole block. Written without the serial dependency
+// of the byte-wise form (ck_b += ck_a after each byte), so that the compiler can vectorize it.
+static void ubx_checksum_update(const uint8_t *data, unsigned len, uint8_t *ck_a, uint8_t *ck_b) {
+    uint32_t sum_a = 0;
+    uint32_t sum_b = 0;
+    for (unsigned i = 0;i < len;i++) {
+        sum_a += data[i];
+        sum_b += (len - i) * data[i];
+    }
+    *ck_b += len * *ck_a + sum_b;
+    *ck_a += sum_a;
+}
 }
 
 Ublox::Ublox(QObject *parent) : QObject(parent)
@@ -199,6 +218,26 @@ Ublox::Ublox(QObject *parent) : QObject(parent)
     connect(mSerialPort, &QSerialPort::readyRead, this, &Ublox::serialDataAvailable);
     connect(mSerialPort, QOverload<QSerialPort::SerialPortError>::of(&QSerialPort::error), this, &Ublox::serialPortError);
 
+    // Decoders by class and id, always decoded: NAV-PVT (also feeds the queue) and ACK/NAK (needed for waiting)
+    mUbxRxSignal = QMetaMethod::fromSignal(&Ublox::ubxRx);
+    registerUbxDecoder(UBX_CLASS_NAV, UBX_NAV_RELPOSNED, &Ublox::ubx_decode_relposned, QMetaMethod::fromSignal(&Ublox::rxRelPosNed));
+    registerUbxDecoder(UBX_CLASS_NAV, UBX_NAV_SVIN, &Ublox::ubx_decode_svin, QMetaMethod::fromSignal(&Ublox::rxSvin));
+    // TODO: dropped on F9P, implement UBX-NAV-PVT or UBX-NAV-HPPOSLLH (see: https://cdn.sparkfun.com/assets/learn_tutorials/8/5/6/ZED-F9P_FW_1.00_HPG_1.00_release_notes.pdf)
+    registerUbxDecoder(UBX_CLASS_NAV, UBX_NAV_SOL, &Ublox::ubx_decode_nav_sol, QMetaMethod::fromSignal(&Ublox::rxNavSol));
+    registerUbxDecoder(UBX_CLASS_NAV, UBX_NAV_PVT, &Ublox::ubx_decode_nav_pvt, QMetaMethod::fromSignal(&Ublox::rxNavPvt), true);
+    registerUbxDecoder(UBX_CLASS_NAV, UBX_NAV_SAT, &Ublox::ubx_decode_nav_sat, QMetaMethod::fromSignal(&Ublox::rxNavSat));
+    registerUbxDecoder(UBX_CLASS_ACK, UBX_ACK_ACK, &Ublox::ubx_decode_ack, QMetaMethod::fromSignal(&Ublox::rxAck), true);
+    registerUbxDecoder(UBX_CLASS_ACK, UBX_ACK_NAK, &Ublox::ubx_decode_nak, QMetaMethod::fromSignal(&Ublox::rxNak), true);
+    registerUbxDecoder(UBX_CLASS_ESF, UBX_ESF_MEAS, &Ublox::ubx_decode_esf_meas, QMetaMethod::fromSignal(&Ublox::rxEsfMeas));
+    registerUbxDecoder(UBX_CLASS_ESF, UBX_ESF_STATUS, &Ublox::ubx_decode_esf_status, QMetaMethod::fromSignal(&Ublox::rxEsfStatus));
+    registerUbxDecoder(UBX_CLASS_ESF, UBX_ESF_ALG, &Ublox::ubx_decode_esf_alg, QMetaMethod::fromSignal(&Ublox::rxEsfAlg));
+    registerUbxDecoder(UBX_CLASS_RXM, UBX_RXM_RAWX, &Ublox::ubx_decode_rawx, QMetaMethod::fromSignal(&Ublox::rxRawx));
+    registerUbxDecoder(UBX_CLASS_CFG, UBX_CFG_GNSS, &Ublox::ubx_decode_cfg_gnss, QMetaMethod::fromSignal(&Ublox::rxCfgGnss));
+    registerUbxDecoder(UBX_CLASS_CFG, UBX_CFG_VALGET, &Ublox::ubx_decode_cfg_valget, QMetaMethod::fromSignal(&Ublox::rxCfgValget));
+    registerUbxDecoder(UBX_CLASS_MON, UBX_MON_VER, &Ublox::ubx_decode_mon_ver, QMetaMethod::fromSignal(&Ublox::rxMonVer));
+    registerUbxDecoder(UBX_CLASS_UPD, UBX_UPD_SOS, &Ublox::ubx_decode_upd_sos, QMetaMethod::fromSignal(&Ublox::rxUpdSos));
+    registerUbxDecoder(UBX_CLASS_TIM, UBX_TIM_TP, &Ublox::ubx_decode_tim_tp, QMetaMethod::fromSignal(&Ublox::rxTimTp));
+
     // Prevent unused warnings
     (void)ubx_get_U1;
     (void)ubx_get_I1;
@@ -225,41 +264,110 @@ Ublox::Ublox(QObject *parent) : QObject(parent)
     (void)ubx_put_R8;
 }
 
-bool Ublox::connectSerial(const QSerialPortInfo &serialPortInfo, unsigned baudrate)
+Ublox::~Ublox()
 {
-    if(mSerialPort->isOpen()) {
-        mSerialPort->close();
+    if (mIoThread) {
+        runOnIoThread([this]() { delete mSerialPort; });
+        mIoThread->quit();
+        mIoThread->wait();
     }
+}
 
-    mSerialPort->setPort(serialPortInfo);
-    mSerialPort->open(QIODevice::ReadWrite);
-    mWaitingAck = false;
+void Ublox::setDedicatedIoThread(bool enabled)
+{
+    if (enabled == hasDedicatedIoThread())
+        return;
 
-    if(!mSerialPort->isOpen()) {
-        return false;
+    if (isSerialConnected()) {
+        qDebug() << "WARNING: Ublox I/O thread can only be changed while disconnected.";
+        return;
+    }
+
+    // Slots are connected directly, i.e., they run in the thread the serial port lives in
+    disconnect(mSerialPort, nullptr, this, nullptr);
+    if (enabled) {
+        qRegisterMetaType<uint8_t>("uint8_t");
+        qRegisterMetaType<ubx_nav_pvt>();
+        qRegisterMetaType<ubx_nav_relposned>();
+        qRegisterMetaType<ubx_nav_svin>();
+        qRegisterMetaType<ubx_nav_sat>();
+        qRegisterMetaType<ubx_cfg_gnss>();
+        qRegisterMetaType<ubx_tim_tp>();
+
+        mIoThread = new QThread(this);
+        mIoThread->setObjectName("Ublox I/O");
+        mSerialPort->setParent(nullptr);
+        mSerialPort->moveToThread(mIoThread);
+        ThreadConfig::getInstance().applyOnStart(mIoThread, ThreadConfig::Role::GnssIo);
+        mIoThread->start(QThread::HighPriority);
+    } else {
+        runOnIoThread([this]() {
+            mSerialPort->moveToThread(thread());
+        });
+        mIoThread->quit();
+        mIoThread->wait();
+        delete mIoThread;
+        mIoThread = nullptr;
+        mSerialPort->setParent(this);
     }
+    connect(mSerialPort, &QSerialPort::readyRead, this, &Ublox::serialDataAvailable, Qt::DirectConnection);
+    connect(mSerialPort, QOverload<QSerialPort::SerialPortError>::of(&QSerialPort::error), this, &Ublox::serialPortError, Qt::DirectConnection);
+}
 
-    if (supportedBaudrates.contains(baudrate))
-        mSerialPort->setBaudRate(baudrate);
+template<typename Function>
+void Ublox::runOnIoThread(Function function)
+{
+    if (mSerialPort->thread() == QThread::currentThread())
+        function();
     else
-        return false;
+        QMetaObject::invokeMethod(mSerialPort, function, Qt::BlockingQueuedConnection);
+}
 
-    mSerialPort->setDataBits(QSerialPort::Data8);
-    mSerialPort->setParity(QSerialPort::NoParity);
-    mSerialPort->setStopBits(QSerialPort::OneStop);
-    mSerialPort->setFlowControl(QSerialPort::NoFlowControl);
+bool Ublox::connectSerial(const QSerialPortInfo &serialPortInfo, unsigned baudrate)
+{
+    bool result = false;
+    runOnIoThread([this, &serialPortInfo, baudrate, &result]() {
+        if(mSerialPort->isOpen()) {
+            mSerialPort->close();
+        }
+
+        mSerialPort->setPort(serialPortInfo);
+        mSerialPort->open(QIODevice::ReadWrite);
+        mWaitingAck = false;
+        mReceiverPort = (serialPortInfo.hasVendorIdentifier() && serialPortInfo.vendorIdentifier() == UBLOX_USB_VENDOR_ID) ?
+                    UbloxCfgBuilder::Port::Usb : UbloxCfgBuilder::Port::Uart1;
+
+        if(!mSerialPort->isOpen()) {
+            return;
+        }
 
-    return true;
+        if (supportedBaudrates.contains(baudrate))
+            mSerialPort->setBaudRate(baudrate);
+        else
+            return;
+
+        mSerialPort->setDataBits(QSerialPort::Data8);
+        mSerialPort->setParity(QSerialPort::NoParity);
+        mSerialPort->setStopBits(QSerialPort::OneStop);
+        mSerialPort->setFlowControl(QSerialPort::NoFlowControl);
+        serialPortOptions::apply(*mSerialPort, mSerialPortOptions);
+
+        result = true;
+    });
+
+    return result;
 }
 
 void Ublox::disconnectSerial()
 {
-    mSerialPort->close();
+    runOnIoThread([this]() { mSerialPort->close(); });
 }
 
 bool Ublox::isSerialConnected()
 {
-    return mSerialPort->isOpen();
+    bool isOpen = false;
+    runOnIoThread([this, &isOpen]() { isOpen = mSerialPort->isOpen(); });
+    return isOpen;
 }
 
 void Ublox::writeRaw(QByteArray data)
@@ -738,6 +846,53 @@ bool Ublox::ubloxCfgValset(unsigned char *values, int len,
     return ubx_encode_send(UBX_CLASS_CFG, UBX_CFG_VALSET, buffer, ind, 500);
 }
 
+bool Ublox::ubloxCfgValset(const UbloxCfgBuilder &cfg, bool ram, bool bbr, bool flash)
+{
+    const uint8_t layers = (ram ? 1 : 0) | (bbr ? 2 : 0) | (flash ? 4 : 0);
+    const QVector<QByteArray> payloads = cfg.getValsetPayloads(layers);
+    if (payloads.isEmpty())
+        return true;
+
+    if (!mWaitForAck) {
+        for (const auto &payload : payloads)
+            ubx_send(ubx_encode(UBX_CLASS_CFG, UBX_CFG_VALSET, payload));
+        return true;
+    }
+
+    if (mWaitingAck) {
+        qDebug() << "Already waiting for ack";
+        return false;
+    }
+    mWaitingAck = true;
+
+    // The receiver answers each message in order
+    int acks = 0;
+    bool nak = false;
+    QEventLoop loop;
+    QTimer timeoutTimer;
+    timeoutTimer.setSingleShot(true);
+    timeoutTimer.start(500 * payloads.size());
+    connect(this, &Ublox::rxAck, &loop, [&loop, &acks, &payloads](uint8_t cls_id, uint8_t msg_id) {
+        if (cls_id == UBX_CLASS_CFG && msg_id == UBX_CFG_VALSET && ++acks == payloads.size())
+            loop.quit();
+    });
+    connect(this, &Ublox::rxNak, &loop, [&loop, &nak](uint8_t cls_id, uint8_t msg_id) {
+        if (cls_id == UBX_CLASS_CFG && msg_id == UBX_CFG_VALSET) {
+            nak = true;
+            loop.quit();
+        }
+    });
+    connect(&timeoutTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+    for (const auto &payload : payloads)
+        ubx_send(ubx_encode(UBX_CLASS_CFG, UBX_CFG_VALSET, payload));
+    loop.exec();
+
+    mWaitingAck = false;
+
+    return !nak && acks == payloads.size();
+}
+
 /**
  *This message is used to get configuration values by providing a list of configuration key IDs, which
  *identify the configuration items to retrieve.
@@ -1032,132 +1187,185 @@ void Ublox::ubloxUpdSos(uint8_t cmd)
  */
 void Ublox::ubloxOdometerInput(ubx_esf_datatype_enum dataType, uint32_t dataField)
 {
-    uint8_t buffer[12];
-    int ind = 0;
-
-    uint32_t data = 0;
-    data |= dataField << 0;
-    data |= dataType << 24;
+    ubx_esf_meas meas = {};
+    meas.time_tag = utcTime::msecsSinceStartOfDay(utcTime::now_ns()); // TODO: Time  tag  of  measurement  generated  by  external sensor?
+    meas.num_meas = 1;
+    meas.data_type[0] = dataType;
+    meas.data_field[0] = dataField;
+    ubloxEsfMeasInput(meas);
+}
 
-    uint32_t timeTag = QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()).msecsSinceStartOfDay();
+void Ublox::ubloxEsfMeasInput(const ubx_esf_meas &meas)
+{
+    uint8_t buffer[12 + 4 * MAX_ESF_NUM_MEAS];
+    int ind = 0;
 
-    ubx_put_U4(buffer, &ind, timeTag); // TODO: Time  tag  of  measurement  generated  by  external sensor?
-    ubx_put_X2(buffer, &ind, 4096); // Binary: 0001000000000000. Flags. Set all unused bits to zero. We have 1 measurement
-    ubx_put_U2(buffer, &ind, 0); // Identification number of data provider?
-    ubx_put_X4(buffer, &ind, data);
+    const uint8_t numMeas = qMin<uint8_t>(meas.num_meas, MAX_ESF_NUM_MEAS);
+    ubx_put_U4(buffer, &ind, meas.time_tag);
+    ubx_put_X2(buffer, &ind, (numMeas << 11) | (meas.calib_t_tag_valid << 3)); // Flags: numMeas in bits 11-15, no time mark
+    ubx_put_U2(buffer, &ind, meas.id); // Identification number of data provider
+    for (int i = 0; i < numMeas; i++)
+        ubx_put_X4(buffer, &ind, (meas.data_field[i] & 0x00FFFFFF) | (uint32_t(meas.data_type[i] & 0x3F) << 24));
+    if (meas.calib_t_tag_valid)
+        ubx_put_U4(buffer, &ind, meas.calib_t_tag);
 
     ubx_encode_send(UBX_CLASS_ESF, UBX_ESF_MEAS, buffer, ind, 0);
 }
 
 void Ublox::serialDataAvailable()
 {
+    static const int rxLatencyId = PerfCounters::getInstance().registerCounter("UBX_RX", PerfCounters::Type::Latency);
+    static const int rxBytesId = PerfCounters::getInstance().registerCounter("UBX_BYTES", PerfCounters::Type::Counter);
+    PerfCounters::ScopedLatency latency(rxLatencyId);
+    static const int allocationTag = AllocationTracker::getInstance().registerTag("UBX");
+    AllocationTracker::ScopedTag tag(allocationTag);
+
     while (mSerialPort->bytesAvailable() > 0) {
-        QByteArray data = mSerialPort->readAll();
+        const auto rxTime = std::chrono::steady_clock::now();
+        const QByteArray data = mSerialPort->readAll();
+        PerfCounters::getInstance().add(rxBytesId, data.size());
+        if (mRawDataTap)
+            mRawDataTap(data, rxTime);
+        decodeData(data, rxTime);
+    }
+}
 
-        for (int i = 0;i < data.size();i++) {
-            uint8_t ch = data.at(i);
-            bool ch_used = false;
+bool Ublox::popNavPvt(ubx_nav_pvt &pvt)
+{
+    if (mNavPvtQueue.pop(pvt))
+        return true;
 
-            // RTCM
-            if (!ch_used && mDecoderState.line_pos == 0 && mDecoderState.ubx_pos == 0) {
-                int res = rtcm3_input_data(ch, &mRtcmState);
-                ch_used = res >= 0;
+    // Queue is empty, re-arm notification and check again for a message that was pushed in between
+    mNavPvtNotified = false;
+    return mNavPvtQueue.pop(pvt);
+}
 
-                if (res >= 1000) {
-                    QByteArray rtcmData((const char*)mRtcmState.buffer, mRtcmState.len + 3);
-                    emit rtcmRx(rtcmData, res);
-                }
+void Ublox::decodeData(const QByteArray &data, std::chrono::steady_clock::time_point rxTime)
+{
+    mRxTime = rxTime;
+    const uint8_t *dataPtr = (const uint8_t*)data.constData();
+
+    for (int i = 0;i < data.size();i++) {
+        // Fast path: payload of a RTCM or UBX frame with known length is copied as a block,
+        // the byte-wise state machine below only handles sync, header and checksum bytes
+        if (mDecoderState.line_pos == 0 && mDecoderState.ubx_pos == 0) {
+            int consumed = rtcm3_input_payload(dataPtr + i, data.size() - i, &mRtcmState);
+            if (consumed > 0) {
+                i += consumed - 1;
+                continue;
             }
+        } else if (mDecoderState.line_pos == 0 && mDecoderState.ubx_pos >= 6 &&
+                   (mDecoderState.ubx_pos - 6) < mDecoderState.ubx_len) {
+            unsigned consumed = std::min(mDecoderState.ubx_len - (mDecoderState.ubx_pos - 6), (unsigned)(data.size() - i));
+            memcpy(mDecoderState.ubx + (mDecoderState.ubx_pos - 6), dataPtr + i, consumed);
+            ubx_checksum_update(dataPtr + i, consumed, &mDecoderState.ubx_ck_a, &mDecoderState.ubx_ck_b);
+            mDecoderState.ubx_pos += consumed;
+            i += consumed - 1;
+            continue;
+        }
 
-            // Ubx
-            if (!ch_used && mDecoderState.line_pos == 0) {
-                unsigned ubx_pos_last = mDecoderState.ubx_pos;
+        uint8_t ch = dataPtr[i];
+        bool ch_used = false;
 
-                if (mDecoderState.ubx_pos == 0) {
-                    if (ch == 0xB5) {
-                        mDecoderState.ubx_pos++;
-                    }
-                } else if (mDecoderState.ubx_pos == 1) {
-                    if (ch == 0x62) {
-                        mDecoderState.ubx_pos++;
-                        mDecoderState.ubx_ck_a = 0;
-                        mDecoderState.ubx_ck_b = 0;
-                    }
-                } else if (mDecoderState.ubx_pos == 2) {
-                    mDecoderState.ubx_class = ch;
-                    mDecoderState.ubx_ck_a += ch;
-                    mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
+        // RTCM
+        if (!ch_used && mDecoderState.line_pos == 0 && mDecoderState.ubx_pos == 0) {
+            int res = rtcm3_input_data(ch, &mRtcmState);
+            ch_used = res >= 0;
+
+            if (res >= 1000) {
+                QByteArray rtcmData((const char*)mRtcmState.buffer, mRtcmState.len + 3);
+                emit rtcmRx(rtcmData, res);
+            }
+        }
+
+        // Ubx
+        if (!ch_used && mDecoderState.line_pos == 0) {
+            unsigned ubx_pos_last = mDecoderState.ubx_pos;
+
+            if (mDecoderState.ubx_pos == 0) {
+                if (ch == 0xB5) {
                     mDecoderState.ubx_pos++;
-                } else if (mDecoderState.ubx_pos == 3) {
-                    mDecoderState.ubx_id = ch;
-                    mDecoderState.ubx_ck_a += ch;
-                    mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
+                }
+            } else if (mDecoderState.ubx_pos == 1) {
+                if (ch == 0x62) {
                     mDecoderState.ubx_pos++;
-                } else if (mDecoderState.ubx_pos == 4) {
-                    mDecoderState.ubx_len = ch;
+                    mDecoderState.ubx_ck_a = 0;
+                    mDecoderState.ubx_ck_b = 0;
+                }
+            } else if (mDecoderState.ubx_pos == 2) {
+                mDecoderState.ubx_class = ch;
+                mDecoderState.ubx_ck_a += ch;
+                mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
+                mDecoderState.ubx_pos++;
+            } else if (mDecoderState.ubx_pos == 3) {
+                mDecoderState.ubx_id = ch;
+                mDecoderState.ubx_ck_a += ch;
+                mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
+                mDecoderState.ubx_pos++;
+            } else if (mDecoderState.ubx_pos == 4) {
+                mDecoderState.ubx_len = ch;
+                mDecoderState.ubx_ck_a += ch;
+                mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
+                mDecoderState.ubx_pos++;
+            } else if (mDecoderState.ubx_pos == 5) {
+                mDecoderState.ubx_len |= ch << 8;
+                if (mDecoderState.ubx_len >= sizeof(mDecoderState.ubx)) {
+                    qDebug() << "Too large UBX packet" << mDecoderState.ubx_len;
+                } else {
                     mDecoderState.ubx_ck_a += ch;
                     mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
                     mDecoderState.ubx_pos++;
-                } else if (mDecoderState.ubx_pos == 5) {
-                    mDecoderState.ubx_len |= ch << 8;
-                    if (mDecoderState.ubx_len >= sizeof(mDecoderState.ubx)) {
-                        qDebug() << "Too large UBX packet" << mDecoderState.ubx_len;
-                    } else {
-                        mDecoderState.ubx_ck_a += ch;
-                        mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
-                        mDecoderState.ubx_pos++;
-                    }
-                } else if ((mDecoderState.ubx_pos - 6) < mDecoderState.ubx_len) {
-                    mDecoderState.ubx[mDecoderState.ubx_pos - 6] = ch;
-                    mDecoderState.ubx_ck_a += ch;
-                    mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
+                }
+            } else if ((mDecoderState.ubx_pos - 6) < mDecoderState.ubx_len) {
+                mDecoderState.ubx[mDecoderState.ubx_pos - 6] = ch;
+                mDecoderState.ubx_ck_a += ch;
+                mDecoderState.ubx_ck_b += mDecoderState.ubx_ck_a;
+                mDecoderState.ubx_pos++;
+            } else if ((mDecoderState.ubx_pos - 6) == mDecoderState.ubx_len) {
+                if (ch == mDecoderState.ubx_ck_a) {
                     mDecoderState.ubx_pos++;
-                } else if ((mDecoderState.ubx_pos - 6) == mDecoderState.ubx_len) {
-                    if (ch == mDecoderState.ubx_ck_a) {
-                        mDecoderState.ubx_pos++;
-                    }
-                } else if ((mDecoderState.ubx_pos - 6) == (mDecoderState.ubx_len + 1)) {
-                    if (ch == mDecoderState.ubx_ck_b) {
-                        ubx_decode(mDecoderState.ubx_class, mDecoderState.ubx_id,
-                                   mDecoderState.ubx, mDecoderState.ubx_len);
-                        mDecoderState.ubx_pos = 0;
-                    }
                 }
-
-                if (ubx_pos_last != mDecoderState.ubx_pos) {
-                    ch_used = true;
-                } else {
+            } else if ((mDecoderState.ubx_pos - 6) == (mDecoderState.ubx_len + 1)) {
+                if (ch == mDecoderState.ubx_ck_b) {
+                    ubx_decode(mDecoderState.ubx_class, mDecoderState.ubx_id,
+                               mDecoderState.ubx, mDecoderState.ubx_len);
                     mDecoderState.ubx_pos = 0;
                 }
             }
 
-            // NMEA
-            if (!ch_used) {
-                mDecoderState.line[mDecoderState.line_pos++] = ch;
-                if (mDecoderState.line_pos == sizeof (mDecoderState.line)) {
-                    mDecoderState.line_pos = 0;
-                }
+            if (ubx_pos_last != mDecoderState.ubx_pos) {
+                ch_used = true;
+            } else {
+                mDecoderState.ubx_pos = 0;
+            }
+        }
 
-                if (mDecoderState.line_pos > 0 && mDecoderState.line[mDecoderState.line_pos - 1] == '\n') {
-                    mDecoderState.line[mDecoderState.line_pos] = '\0';
-                    mDecoderState.line_pos = 0;
-
-                    QByteArray line((char*)mDecoderState.line);
-                    // Check whether this is NMEA GGA with correct checksum
-                    // Example: $GNGGA,120020.115,5743.153,N,01256.431,E,1,12,1.0,0.0,M,0.0,M,,*6E
-                    if (line.at(0) == '$' && line.size() > 6)
-                        if (line.mid(3, 3) == QString("GGA")) {
-                            QList split = line.split('*');
-                            if (split.size() == 2) {
-                                // Test checksum
-                                int checksum = 0;
-                                for (int i = 1; i < split.at(0).size(); i++)
-                                    checksum ^= split.at(0).at(i);
-                                if (checksum == split.at(1).trimmed().toInt(nullptr, 16))
-                                    emit rxNmeaGga(line);
-                            }
+        // NMEA
+        if (!ch_used) {
+            mDecoderState.line[mDecoderState.line_pos++] = ch;
+            if (mDecoderState.line_pos == sizeof (mDecoderState.line)) {
+                mDecoderState.line_pos = 0;
+            }
+
+            if (mDecoderState.line_pos > 0 && mDecoderState.line[mDecoderState.line_pos - 1] == '\n') {
+                mDecoderState.line[mDecoderState.line_pos] = '\0';
+                mDecoderState.line_pos = 0;
+
+                QByteArray line((char*)mDecoderState.line);
+                // Check whether this is NMEA GGA with correct checksum
+                // Example: $GNGGA,120020.115,5743.153,N,01256.431,E,1,12,1.0,0.0,M,0.0,M,,*6E
+                if (line.at(0) == '$' && line.size() > 6)
+                    if (line.mid(3, 3) == QString("GGA")) {
+                        QList split = line.split('*');
+                        if (split.size() == 2) {
+                            // Test checksum
+                            int checksum = 0;
+                            for (int i = 1; i < split.at(0).size(); i++)
+                                checksum ^= split.at(0).at(i);
+                            if (checksum == split.at(1).trimmed().toInt(nullptr, 16))
+                                emit rxNmeaGga(line);
                         }
-                }
+                    }
             }
         }
     }
@@ -1186,6 +1394,14 @@ void Ublox::serialPortError(QSerialPort::SerialPortError error)
 
 void Ublox::ubx_send(QByteArray data)
 {
+    if (mIoThread && mSerialPort->thread() != QThread::currentThread()) {
+        QMetaObject::invokeMethod(mSerialPort, [this, data]() {
+            if (mSerialPort->isOpen())
+                mSerialPort->write(data);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
     if (mSerialPort->isOpen()) {
         mSerialPort->write(data);
     }
@@ -1196,7 +1412,7 @@ bool Ublox::ubx_encode_send(uint8_t msg_class, uint8_t id, uint8_t *msg, int len
     auto ubx = ubx_encode(msg_class, id, QByteArray((const char*)msg, len));
 
     bool retVal = false;
-    if (timeoutMs > 0) {
+    if (timeoutMs > 0 && mWaitForAck) {
         if (mWaitingAck) {
             qDebug() << "Already waiting for ack";
         } else {
@@ -1206,7 +1422,7 @@ bool Ublox::ubx_encode_send(uint8_t msg_class, uint8_t id, uint8_t *msg, int len
             QTimer timeoutTimer;
             timeoutTimer.setSingleShot(true);
             timeoutTimer.start(timeoutMs);
-            auto conn = connect(this, &Ublox::rxAck,
+            auto conn = connect(this, &Ublox::rxAck, &loop,
                                 [&loop, &retVal](uint8_t, uint8_t){retVal = true; loop.quit();});
             connect(this, &Ublox::rxNak, &loop, &QEventLoop::quit);
             connect(&timeoutTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
@@ -1252,11 +1468,8 @@ QByteArray Ublox::ubx_encode(uint8_t msg_class, uint8_t id, const QByteArray &da
     ck_a += ubx.at(ubx.size() - 1);
     ck_b += ck_a;
 
-    for (int i = 0;i < data.size();i++) {
-        ubx.append(data.at(i));
-        ck_a += data.at(i);
-        ck_b += ck_a;
-    }
+    ubx.append(data);
+    ubx_checksum_update((const uint8_t*)data.constData(), data.size(), &ck_a, &ck_b);
 
     ubx.append(ck_a);
     ubx.append(ck_b);
@@ -1264,108 +1477,70 @@ QByteArray Ublox::ubx_encode(uint8_t msg_class, uint8_t id, const QByteArray &da
     return ubx;
 }
 
+void Ublox::registerUbxDecoder(uint8_t msg_class, uint8_t id, void (Ublox::*decode)(uint8_t *, int), const QMetaMethod &signal, bool alwaysDecode)
+{
+    UbxDispatchEntry &entry = mUbxDispatch[ubxDispatchKey(msg_class, id)];
+    entry.decode = decode;
+    entry.signal = signal;
+    entry.alwaysDecode = alwaysDecode;
+}
+
+int Ublox::subscribeUbxMessage(uint8_t msg_class, uint8_t id, std::function<void(const UbxMessageView &)> handler)
+{
+    const int subscriptionId = mNextSubscriptionId++;
+    mUbxDispatch[ubxDispatchKey(msg_class, id)].messageHandlers.append({subscriptionId, handler});
+    return subscriptionId;
+}
+
+int Ublox::subscribeDecodedMessage(uint8_t msg_class, uint8_t id, std::function<void(const void *)> handler)
+{
+    const int subscriptionId = mNextSubscriptionId++;
+    mUbxDispatch[ubxDispatchKey(msg_class, id)].decodedHandlers.append({subscriptionId, handler});
+    return subscriptionId;
+}
+
+void Ublox::unsubscribe(int subscriptionId)
+{
+    for (auto &entry : mUbxDispatch) {
+        for (int i = 0; i < entry.messageHandlers.size(); i++)
+            if (entry.messageHandlers.at(i).first == subscriptionId) {
+                entry.messageHandlers.removeAt(i);
+                return;
+            }
+        for (int i = 0; i < entry.decodedHandlers.size(); i++)
+            if (entry.decodedHandlers.at(i).first == subscriptionId) {
+                entry.decodedHandlers.removeAt(i);
+                return;
+            }
+    }
+}
+
+template<typename T>
+void Ublox::dispatchDecoded(const T &message)
+{
+    const auto entry = mUbxDispatch.constFind(ubxDispatchKey(UbxMessageType<T>::msgClass, UbxMessageType<T>::id));
+    if (entry != mUbxDispatch.constEnd())
+        for (const auto &handler : entry->decodedHandlers)
+            handler.second(&message);
+}
+
 void Ublox::ubx_decode(uint8_t msg_class, uint8_t id, uint8_t *msg, int len)
 {
-    emit ubxRx(ubx_encode(msg_class, id, QByteArray((const char*)msg, len)));
-
-    switch (msg_class) {
-    case UBX_CLASS_NAV: {
-        switch (id) {
-        case UBX_NAV_RELPOSNED:
-            ubx_decode_relposned(msg, len);
-            break;
-        case UBX_NAV_SVIN:
-            ubx_decode_svin(msg, len);
-            break;
-        case UBX_NAV_SOL: // TODO: dropped on F9P, implement UBX-NAV-PVT or UBX-NAV-HPPOSLLH (see: https://cdn.sparkfun.com/assets/learn_tutorials/8/5/6/ZED-F9P_FW_1.00_HPG_1.00_release_notes.pdf)
-            ubx_decode_nav_sol(msg, len);
-            break;
-        case UBX_NAV_PVT:
-            ubx_decode_nav_pvt(msg, len);
-            break;
-        case UBX_NAV_SAT:
-            ubx_decode_nav_sat(msg, len);
-            break;
-        default:
-            break;
-        }
-    } break;
-
-    case UBX_CLASS_ACK: {
-        switch (id) {
-        case UBX_ACK_ACK:
-            ubx_decode_ack(msg, len);
-            break;
-        case UBX_ACK_NAK:
-            ubx_decode_nak(msg, len);
-            break;
-        default:
-            break;
-        }
-    } break;
-
-    case UBX_CLASS_ESF: {
-        switch (id) {
-        case UBX_ESF_MEAS:
-            ubx_decode_esf_meas(msg, len);
-            break;
-         case UBX_ESF_STATUS:
-            ubx_decode_esf_status(msg, len);
-            break;
-        case UBX_ESF_ALG:
-           ubx_decode_esf_alg(msg, len);
-           break;
-         default:
-            break;
-        }
-    } break;
-
-    case UBX_CLASS_RXM: {
-        switch (id) {
-        case UBX_RXM_RAWX:
-            ubx_decode_rawx(msg, len);
-            break;
-        default:
-            break;
-        }
-    } break;
-
-    case UBX_CLASS_CFG: {
-        switch (id) {
-        case UBX_CFG_GNSS:
-            ubx_decode_cfg_gnss(msg, len);
-            break;
-        case UBX_CFG_VALGET:
-            ubx_decode_cfg_valget(msg, len);
-            break;
-        default:
-            break;
-        }
-    } break;
-
-    case UBX_CLASS_MON: {
-        switch (id) {
-        case UBX_MON_VER:
-            ubx_decode_mon_ver(msg, len);
-            break;
-        default:
-            break;
-        }
-    } break;
-
-    case UBX_CLASS_UPD: {
-        switch (id) {
-        case UBX_UPD_SOS:
-            ubx_decode_upd_sos(msg, len);
-            break;
-        default:
-            break;
-        }
-    } break;
+    if (isSignalConnected(mUbxRxSignal))
+        emit ubxRx(ubx_encode(msg_class, id, QByteArray((const char*)msg, len)));
 
-    default:
-        break;
+    const auto entry = mUbxDispatch.constFind(ubxDispatchKey(msg_class, id));
+    if (entry == mUbxDispatch.constEnd())
+        return;
+
+    if (!entry->messageHandlers.isEmpty()) {
+        const UbxMessageView view = {msg_class, id, msg, len, mRxTime};
+        for (const auto &handler : entry->messageHandlers)
+            handler.second(view);
     }
+
+    if (entry->decode && (entry->alwaysDecode || !entry->decodedHandlers.isEmpty() || isSignalConnected(entry->signal)))
+        (this->*(entry->decode))(msg, len);
 }
 
 void Ublox::ubx_decode_nav_sol(uint8_t *msg, int len)
@@ -1397,6 +1572,7 @@ void Ublox::ubx_decode_nav_sol(uint8_t *msg, int len)
     ind += 1; // 46
     sol.num_sv = ubx_get_U1(msg, &ind); // 47
 
+    dispatchDecoded(sol);
     emit rxNavSol(sol);
 }
 
@@ -1404,10 +1580,11 @@ void Ublox::ubx_decode_nav_pvt(uint8_t *msg, int len)
 {
     (void)len;
 
-    static ubx_nav_pvt pvt;
+    ubx_nav_pvt pvt;
     int ind = 0;
     uint8_t flags;
 
+    pvt.rx_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mRxTime.time_since_epoch()).count();
     pvt.i_tow  = ubx_get_U4(msg, &ind); // 0
     pvt.year   = ubx_get_U2(msg, &ind); // 4
     pvt.month  = ubx_get_U1(msg, &ind); // 6
@@ -1463,7 +1640,11 @@ void Ublox::ubx_decode_nav_pvt(uint8_t *msg, int len)
     pvt.mag_dec   = ((double)ubx_get_I2(msg, &ind))*1.0e-2; // 88
     pvt.mag_acc   = ((double)ubx_get_U2(msg, &ind))*1.0e-2; // 92
 
+    dispatchDecoded(pvt);
     emit rxNavPvt(pvt);
+
+    if (mNavPvtQueue.push(pvt) && !mNavPvtNotified.exchange(true))
+        emit navPvtQueued();
 }
 
 void Ublox::ubx_decode_relposned(uint8_t *msg, int len)
@@ -1515,6 +1696,7 @@ void Ublox::ubx_decode_relposned(uint8_t *msg, int len)
     pos.rel_pos_heading_valid = (flags >> 8) & 1;
     pos.rel_pos_normalized =    (flags >> 9) & 1;
 
+    dispatchDecoded(pos);
     emit rxRelPosNed(pos);
 }
 
@@ -1539,6 +1721,7 @@ void Ublox::ubx_decode_svin(uint8_t *msg, int len)
     svin.valid = ubx_get_U1(msg, &ind);
     svin.active = ubx_get_U1(msg, &ind);
 
+    dispatchDecoded(svin);
     emit rxSvin(svin);
 }
 
@@ -1605,6 +1788,7 @@ void Ublox::ubx_decode_rawx(uint8_t *msg, int len)
         ind += 1;
     }
 
+    dispatchDecoded(raw);
     emit rxRawx(raw);
 }
 
@@ -1639,6 +1823,7 @@ void Ublox::ubx_decode_nav_sat(uint8_t *msg, int len)
         sat.sats[i].diffcorr = (flags >> 6) & 0x01;
     }
 
+    dispatchDecoded(sat);
     emit rxNavSat(sat);
 }
 
@@ -1668,6 +1853,7 @@ void Ublox::ubx_decode_cfg_gnss(uint8_t *msg, int len)
         cfg.blocks[i].flags = flags >> 16 & 0xFF;
     }
 
+    dispatchDecoded(cfg);
     emit rxCfgGnss(cfg);
 }
 
@@ -1702,7 +1888,7 @@ void Ublox::ubx_decode_esf_meas(uint8_t *msg, int len)
     meas.time_mark_sent =       (flags & 0b0000000000000011);
     meas.time_mark_edge =       (flags & 0b0000000000000100);
     meas.calib_t_tag_valid =    (flags & 0b0000000000001000);
-    meas.num_meas =             len - 8 - meas.calib_t_tag_valid * 4; //flags & 0b1111100000000000;
+    meas.num_meas =             (len - 8 - (meas.calib_t_tag_valid ? 4 : 0)) / 4; //flags & 0b1111100000000000;
     meas.id = ubx_get_U2(msg, &ind);
 
     for (int i = 0; i < meas.num_meas && i < MAX_ESF_NUM_MEAS; i++) {
@@ -1716,6 +1902,7 @@ void Ublox::ubx_decode_esf_meas(uint8_t *msg, int len)
     if (meas.calib_t_tag_valid)
         meas.calib_t_tag = ubx_get_U4(msg, &ind);
 
+    dispatchDecoded(meas);
     emit rxEsfMeas(meas);
 }
 
@@ -1753,6 +1940,7 @@ void Ublox::ubx_decode_esf_status(uint8_t *msg, int len)
         status.sensors[i].noisy_meas   = (flags >> 3) & 1;
     }
 
+    dispatchDecoded(status);
     emit rxEsfStatus(status);
 }
 
@@ -1781,6 +1969,7 @@ void Ublox::ubx_decode_esf_alg(uint8_t *msg, int len)
     alg.pitch       = ubx_get_I2(msg, &ind) * 1e-2; // 12
     alg.roll        = ubx_get_I2(msg, &ind) * 1e-2; // 14
 
+    dispatchDecoded(alg);
     emit rxEsfAlg(alg);
 }
 
@@ -1796,9 +1985,36 @@ void Ublox::ubx_decode_upd_sos(uint8_t *msg, int len)
     sos.response = ubx_get_U1(msg, &ind);
     ind += 3; // Reserved 5-7
 
+    dispatchDecoded(sos);
     emit rxUpdSos(sos);
 }
 
+void Ublox::ubx_decode_tim_tp(uint8_t *msg, int len)
+{
+    (void)len;
+
+    ubx_tim_tp tp;
+    int ind = 0;
+    uint8_t flags;
+
+    tp.rx_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mRxTime.time_since_epoch()).count();
+    tp.tow_ms     = ubx_get_U4(msg, &ind); // 0
+    tp.tow_sub_ms = ubx_get_U4(msg, &ind); // 4
+    tp.q_err_ps   = ubx_get_I4(msg, &ind); // 8
+    tp.week       = ubx_get_U2(msg, &ind); // 12
+
+    flags            = ubx_get_X1(msg, &ind); // 14
+    tp.utc           = (flags >> 0) & 1;
+    tp.utc_available = (flags >> 1) & 1;
+    tp.q_err_invalid = (flags >> 4) & 1;
+
+    flags            = ubx_get_X1(msg, &ind); // 15, refInfo
+    tp.time_ref_gnss = flags & 0x0F;
+
+    dispatchDecoded(tp);
+    emit rxTimTp(tp);
+}
+
 void Ublox::ubx_decode_cfg_valget(uint8_t *msg, int len)
 {
     static ubx_cfg_valget valget;
@@ -1813,5 +2029,6 @@ void Ublox::ubx_decode_cfg_valget(uint8_t *msg, int len)
         valget.cfgData[i]      = ubx_get_U1(msg, &ind);
     }
 
+    dispatchDecoded(valget);
     emit rxCfgValget(valget);
 }
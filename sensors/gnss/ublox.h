@@ -9,10 +9,20 @@
 #include <QObject>
 #include <QVector>
 #include <QSerialPort>
+#include "core/serialportoptions.h"
 #include <QTimer>
+#include <QThread>
+#include <QHash>
+#include <QMetaMethod>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <cmath>
 #include "rtcm3_simple.h"
+#include "ubloxcfgbuilder.h"
+#include "core/spscqueue.h"
+#include "core/utctime.h"
 
 // Datatypes
 typedef struct {
@@ -39,6 +49,8 @@ typedef struct {
     bool rel_pos_normalized; // Position values are normalized
 } ubx_nav_relposned;
 
+Q_DECLARE_METATYPE(ubx_nav_relposned)
+
 typedef struct {
     uint32_t i_tow; // GPS time of week of the navigation epoch
     uint32_t dur; // Passed survey-in observation time (s)
@@ -51,6 +63,8 @@ typedef struct {
     bool active; // Survey-in in progress flag, 1 = in-progress, otherwise 0
 } ubx_nav_svin;
 
+Q_DECLARE_METATYPE(ubx_nav_svin)
+
 typedef struct {
     uint32_t i_tow; // GPS time of week of the navigation epoch
 
@@ -140,6 +154,8 @@ typedef struct {
     double head_veh;
     double mag_dec;
     double mag_acc;
+
+    int64_t rx_time_ns; // Reception time of the data containing this message (std::chrono::steady_clock, i.e., monotonic)
 } ubx_nav_pvt;
 
 Q_DECLARE_METATYPE(ubx_nav_pvt)
@@ -163,6 +179,23 @@ typedef struct {
     ubx_nav_sat_info sats[128];
 } ubx_nav_sat;
 
+Q_DECLARE_METATYPE(ubx_nav_sat)
+
+// Time of the next time pulse, sent before it
+typedef struct {
+    uint32_t tow_ms; // Time pulse time of week
+    uint32_t tow_sub_ms; // Submillisecond part of tow_ms [2^-32 ms]
+    int32_t q_err_ps; // Quantization error of the time pulse
+    uint16_t week;
+    bool utc; // Time base: UTC (or GNSS, see time_ref_gnss)
+    bool utc_available; // UTC parameters known
+    bool q_err_invalid;
+    uint8_t time_ref_gnss; // 0: GPS, 1: GLONASS, 2: BeiDou, 3: Galileo, 15: unknown
+    int64_t rx_time_ns; // Reception time of the data containing this message (std::chrono::steady_clock, i.e., monotonic)
+} ubx_tim_tp;
+
+Q_DECLARE_METATYPE(ubx_tim_tp)
+
 typedef struct {
     double pr_mes;
     double cp_mes;
@@ -490,6 +523,8 @@ typedef struct {
     int num_blocks;
 } ubx_cfg_gnss;
 
+Q_DECLARE_METATYPE(ubx_cfg_gnss)
+
 typedef struct {
     // Filter
     bool posFilt; // Enable position output for failed or invalid fixes
@@ -575,10 +610,22 @@ public:
     const unsigned defaultBaudrateUart = 38400; // F9P
 
     explicit Ublox(QObject *parent = 0);
+    ~Ublox();
+    // Serial reading and decoding on a dedicated thread, independent of the owner's event loop. Needs to be set before connecting.
+    // Signals are then emitted from the I/O thread, i.e., queued to receivers in other threads.
+    void setDedicatedIoThread(bool enabled);
+    bool hasDedicatedIoThread() const { return mIoThread != nullptr; }
+    // Port of the receiver at the other end: USB for u-blox' own USB interface, UART1 otherwise
+    UbloxCfgBuilder::Port getReceiverPort() const { return mReceiverPort; }
+    void setSerialPortOptions(const SerialPortOptions &options) { mSerialPortOptions = options; } // applied when connecting
     bool connectSerial(const QSerialPortInfo& serialPortInfo, unsigned baudrate = 921600);
     void disconnectSerial();
     bool isSerialConnected();
     void writeRaw(QByteArray data);
+    // The configuration functions (ubxCfg*, ubloxCfg*) wait for ACK in a local event loop by default. Without waiting,
+    // they return true once sent and the answer is only signalled (rxAck/rxNak), e.g., for pipelining several commands.
+    void setWaitForAck(bool waitForAck) { mWaitForAck = waitForAck; }
+    bool getWaitForAck() const { return mWaitForAck; }
 
     void ubxPoll(uint8_t msg_class, uint8_t id);
     bool ubxCfgPrtUart(ubx_cfg_prt_uart *cfg);
@@ -593,6 +640,8 @@ public:
     bool ubloxCfgNmea(ubx_cfg_nmea *nmea);
     bool ubloxCfgValset(unsigned char *values, int len,
                         bool ram, bool bbr, bool flash);
+    // All messages are sent at once and the ACKs collected afterwards, false on NAK (nothing is applied) or timeout
+    bool ubloxCfgValset(const UbloxCfgBuilder &cfg, bool ram, bool bbr, bool flash);
     bool ubloxCfgValget(unsigned char *keys, int len,
                         uint8_t layer, uint16_t position = 0);
 
@@ -615,6 +664,36 @@ public:
 
     void ubloxUpdSos(uint8_t cmd);
     void ubloxOdometerInput(ubx_esf_datatype_enum dataType, uint32_t dataField);
+    // External sensor data (ESF-MEAS input): num_meas measurements sharing time_tag [ms], see UbloxOdometryFeeder
+    void ubloxEsfMeasInput(const ubx_esf_meas &meas);
+
+    // Decode data received from the receiver (RTCM3, UBX and NMEA GGA), called for all serial data. Can also be used for
+    // data from other sources, e.g., logs.
+    void decodeData(const QByteArray &data, std::chrono::steady_clock::time_point rxTime = std::chrono::steady_clock::now());
+    // Called with every chunk read from the serial port before it is decoded (on the reading thread), e.g., to record the
+    // raw stream (see RawStreamRecorder::getTap). The chunk is not copied for it. Set while disconnected.
+    using RawDataTap = std::function<void(const QByteArray &data, std::chrono::steady_clock::time_point rxTime)>;
+    void setRawDataTap(RawDataTap tap) { mRawDataTap = tap; }
+
+    // Decoded NAV-PVT messages are also queued for a single consumer (lock-free, no copy through Qt's event queue).
+    // navPvtQueued() is emitted once when the queue becomes non-empty after popNavPvt() returned false, i.e., drain the queue on it.
+    bool popNavPvt(ubx_nav_pvt &pvt);
+
+    // Subscriptions in addition to the signals: handlers are called directly on the decoding thread (the I/O thread if
+    // dedicated), nothing is copied through Qt's event queue. Messages without a subscriber or connected signal are not
+    // decoded at all. (Un)subscribe while disconnected, not from within a handler.
+    struct UbxMessageView {
+        uint8_t msgClass;
+        uint8_t id;
+        const uint8_t *payload; // only valid during the call
+        int len;
+        std::chrono::steady_clock::time_point rxTime;
+    };
+    int subscribeUbxMessage(uint8_t msg_class, uint8_t id, std::function<void(const UbxMessageView &)> handler);
+    // T: a decoded message with UbxMessageType<T>, e.g., ubx_nav_sat
+    template<typename T>
+    int subscribeDecoded(std::function<void(const T &)> handler);
+    void unsubscribe(int subscriptionId);
 
 signals:
     void rxNavSol(const ubx_nav_sol &sol);
@@ -634,7 +713,9 @@ signals:
     void ubxRx(const QByteArray &data);
     void rtcmRx(const QByteArray &data, const int &type);
     void rxUpdSos(const ubx_upd_sos &sos);
+    void rxTimTp(const ubx_tim_tp &tp);
     void rxNmeaGga(const QByteArray &nmeaGgaStr);
+    void navPvtQueued();
 
 public slots:
 
@@ -656,9 +737,38 @@ private:
     } decoder_state;
 
     QSerialPort *mSerialPort;
+    SerialPortOptions mSerialPortOptions;
+    QThread *mIoThread = nullptr;
     decoder_state mDecoderState;
     rtcm3_state mRtcmState;
-    bool mWaitingAck;
+    std::atomic<bool> mWaitingAck{false};
+    std::atomic<bool> mWaitForAck{true};
+    UbloxCfgBuilder::Port mReceiverPort = UbloxCfgBuilder::Port::Uart1;
+    std::chrono::steady_clock::time_point mRxTime;
+    SpscQueue<ubx_nav_pvt, 32> mNavPvtQueue;
+    std::atomic<bool> mNavPvtNotified{false};
+
+    template<typename Function>
+    void runOnIoThread(Function function);
+
+    struct UbxDispatchEntry {
+        void (Ublox::*decode)(uint8_t *msg, int len) = nullptr;
+        QMetaMethod signal; // of the decoded message
+        bool alwaysDecode = false;
+        QVector<QPair<int, std::function<void(const UbxMessageView &)>>> messageHandlers;
+        QVector<QPair<int, std::function<void(const void *)>>> decodedHandlers;
+    };
+    static uint16_t ubxDispatchKey(uint8_t msg_class, uint8_t id) { return uint16_t(msg_class << 8 | id); }
+    void registerUbxDecoder(uint8_t msg_class, uint8_t id, void (Ublox::*decode)(uint8_t *msg, int len),
+                            const QMetaMethod &signal, bool alwaysDecode = false);
+    int subscribeDecodedMessage(uint8_t msg_class, uint8_t id, std::function<void(const void *)> handler);
+    template<typename T>
+    void dispatchDecoded(const T &message);
+
+    QHash<uint16_t, UbxDispatchEntry> mUbxDispatch;
+    int mNextSubscriptionId = 1;
+    RawDataTap mRawDataTap;
+    QMetaMethod mUbxRxSignal;
 
     void ubx_send(QByteArray data);
     bool ubx_encode_send(uint8_t msg_class, uint8_t id, uint8_t *msg, int len, int timeoutMs = -1);
@@ -680,6 +790,7 @@ private:
     void ubx_decode_esf_status(uint8_t *msg, int len);
     void ubx_decode_esf_alg(uint8_t *msg, int len);
     void ubx_decode_upd_sos(uint8_t *msg, int len);
+    void ubx_decode_tim_tp(uint8_t *msg, int len);
 };
 
 // Message classes
@@ -723,6 +834,9 @@ private:
 // Receiver firmware on flash
 #define UBX_UPD_SOS                     0x14
 
+// Timing messages
+#define UBX_TIM_TP                      0x01
+
 // Configuration messages
 #define UBX_CFG_PRT						0x00
 #define UBX_CFG_MSG						0x01
@@ -804,6 +918,44 @@ private:
 #define CFG_RATE_TIMEREF                0x20210003
 #define CFG_RATE_NAV_PRIO               0x20210004
 
+#define CFG_TMODE_MODE                  0x20030001 // 0: disabled, 1: survey-in, 2: fixed
+#define CFG_NAVSPG_DYNMODEL             0x20110021
+
+// Output rates (per navigation solution) on I2C, the other ports follow, see UbloxCfgBuilder::setMessageRate
+#define CFG_MSGOUT_UBX_NAV_PVT          0x20910006
+#define CFG_MSGOUT_UBX_NAV_SAT          0x20910015
+#define CFG_MSGOUT_UBX_NAV_SVIN         0x20910088
+#define CFG_MSGOUT_UBX_NAV_RELPOSNED    0x2091008D
+#define CFG_MSGOUT_UBX_RXM_RAWX         0x209102A4
+#define CFG_MSGOUT_UBX_RXM_SFRBX        0x20910231
+#define CFG_MSGOUT_UBX_ESF_MEAS         0x20910277
+#define CFG_MSGOUT_UBX_ESF_STATUS       0x20910105
+#define CFG_MSGOUT_UBX_ESF_ALG          0x2091010F
+#define CFG_MSGOUT_UBX_TIM_TP           0x2091017D
+#define CFG_MSGOUT_NMEA_GGA             0x209100BA
+#define CFG_MSGOUT_NMEA_GLL             0x209100C9
+#define CFG_MSGOUT_NMEA_GSA             0x209100BF
+#define CFG_MSGOUT_NMEA_GSV             0x209100C4
+#define CFG_MSGOUT_NMEA_RMC             0x209100AB
+#define CFG_MSGOUT_NMEA_VTG             0x209100B0
+#define CFG_MSGOUT_NMEA_GRS             0x209100CE
+#define CFG_MSGOUT_NMEA_GST             0x209100D3
+#define CFG_MSGOUT_NMEA_ZDA             0x209100D8
+#define CFG_MSGOUT_NMEA_GBS             0x209100DD
+#define CFG_MSGOUT_NMEA_DTM             0x209100A6
+#define CFG_MSGOUT_RTCM_1005            0x209102BD
+#define CFG_MSGOUT_RTCM_1074            0x2091035E
+#define CFG_MSGOUT_RTCM_1077            0x209102CC
+#define CFG_MSGOUT_RTCM_1084            0x20910363
+#define CFG_MSGOUT_RTCM_1087            0x209102D1
+#define CFG_MSGOUT_RTCM_1094            0x20910368
+#define CFG_MSGOUT_RTCM_1097            0x20910318
+#define CFG_MSGOUT_RTCM_1124            0x2091036D
+#define CFG_MSGOUT_RTCM_1127            0x209102D6
+#define CFG_MSGOUT_RTCM_1230            0x20910303
+#define CFG_MSGOUT_RTCM_4072_0          0x209102FE
+#define CFG_MSGOUT_RTCM_4072_1          0x20910381
+
 // RTCM3 messages
 #define UBX_RTCM3_1005					0x05 // Stationary RTK reference station ARP
 #define UBX_RTCM3_1074					0x4A // GPS MSM4
@@ -857,4 +1009,28 @@ private:
 #define UBX_NMEA_GBS                    0x09
 #define UBX_NMEA_DTM                    0x0A
 
+// Class and id of the decoded messages, see Ublox::subscribeDecoded
+template<typename T> struct UbxMessageType;
+template<> struct UbxMessageType<ubx_nav_sol> { static constexpr uint8_t msgClass = UBX_CLASS_NAV, id = UBX_NAV_SOL; };
+template<> struct UbxMessageType<ubx_nav_pvt> { static constexpr uint8_t msgClass = UBX_CLASS_NAV, id = UBX_NAV_PVT; };
+template<> struct UbxMessageType<ubx_nav_relposned> { static constexpr uint8_t msgClass = UBX_CLASS_NAV, id = UBX_NAV_RELPOSNED; };
+template<> struct UbxMessageType<ubx_nav_svin> { static constexpr uint8_t msgClass = UBX_CLASS_NAV, id = UBX_NAV_SVIN; };
+template<> struct UbxMessageType<ubx_nav_sat> { static constexpr uint8_t msgClass = UBX_CLASS_NAV, id = UBX_NAV_SAT; };
+template<> struct UbxMessageType<ubx_rxm_rawx> { static constexpr uint8_t msgClass = UBX_CLASS_RXM, id = UBX_RXM_RAWX; };
+template<> struct UbxMessageType<ubx_cfg_gnss> { static constexpr uint8_t msgClass = UBX_CLASS_CFG, id = UBX_CFG_GNSS; };
+template<> struct UbxMessageType<ubx_cfg_valget> { static constexpr uint8_t msgClass = UBX_CLASS_CFG, id = UBX_CFG_VALGET; };
+template<> struct UbxMessageType<ubx_esf_meas> { static constexpr uint8_t msgClass = UBX_CLASS_ESF, id = UBX_ESF_MEAS; };
+template<> struct UbxMessageType<ubx_esf_status> { static constexpr uint8_t msgClass = UBX_CLASS_ESF, id = UBX_ESF_STATUS; };
+template<> struct UbxMessageType<ubx_esf_alg> { static constexpr uint8_t msgClass = UBX_CLASS_ESF, id = UBX_ESF_ALG; };
+template<> struct UbxMessageType<ubx_upd_sos> { static constexpr uint8_t msgClass = UBX_CLASS_UPD, id = UBX_UPD_SOS; };
+template<> struct UbxMessageType<ubx_tim_tp> { static constexpr uint8_t msgClass = UBX_CLASS_TIM, id = UBX_TIM_TP; };
+
+template<typename T>
+int Ublox::subscribeDecoded(std::function<void(const T &)> handler)
+{
+    return subscribeDecodedMessage(UbxMessageType<T>::msgClass, UbxMessageType<T>::id, [handler](const void *message) {
+        handler(*static_cast<const T *>(message));
+    });
+}
+
 #endif // UBLOX_H
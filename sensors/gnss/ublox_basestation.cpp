@@ -4,32 +4,56 @@
  */
 #include "ublox_basestation.h"
 #include <QDebug>
+#include <algorithm>
 
 const UbloxBasestation::BasestationConfig UbloxBasestation::defaultConfig;
 
 UbloxBasestation::UbloxBasestation(QObject *parent) : QObject(parent)
 {
-    connect(&mUblox, &Ublox::rxNavPvt, [this](const ubx_nav_pvt& pvt) {
+    // Signals from mUblox are emitted on its I/O thread, the receivers below (with this as context) run in our thread
+    mUblox.setDedicatedIoThread(true);
+    mUblox.setWaitForAck(false);
+
+    connect(&mUblox, &Ublox::rxNavPvt, this, [this](const ubx_nav_pvt& pvt) {
         emit currentPosition({pvt.lat, pvt.lon, pvt.height});
     });
 
-    connect(&mUblox, &Ublox::rxNavSat, [this](const ubx_nav_sat& sat) {
-        emit rxNavSat(sat);
+    connect(&mUblox, &Ublox::rxNavSat, this, [this](const ubx_nav_sat& sat) {
+        mLatestNavSat = sat;
+        mNavSatPending = true;
+        scheduleTelemetry();
     });
 
-    connect(&mUblox, &Ublox::rxSvin, [this](ubx_nav_svin svin){
-        emit rxSvin(svin);
+    connect(&mUblox, &Ublox::rxSvin, this, [this](const ubx_nav_svin &svin){
+        mLatestSvin = svin;
+        mSvinPending = true;
+        scheduleTelemetry();
     });
 
-    connect(&mUblox, &Ublox::rxCfgGnss, [this](const ubx_cfg_gnss &gnss){
+    connect(&mUblox, &Ublox::rxCfgGnss, this, [this](const ubx_cfg_gnss &gnss){
         emit rxCfgGnss(gnss);
     });
 
-    connect(&mUblox, &Ublox::rxMonVer, [this](const QString &sw, const QString &hw, const QStringList &extensions){
+    connect(&mUblox, &Ublox::rxMonVer, this, [this](const QString &sw, const QString &hw, const QStringList &extensions){
         emit rxMonVer(sw, hw, extensions);
     });
 
-    connect(&mUblox, &Ublox::rtcmRx, [this](const QByteArray& data, const int &type)
+    connect(&mUblox, &Ublox::rxAck, this, [this](uint8_t cls_id, uint8_t msg_id){
+        configurationStepAnswered(cls_id, msg_id, true);
+    });
+
+    connect(&mUblox, &Ublox::rxNak, this, [this](uint8_t cls_id, uint8_t msg_id){
+        configurationStepAnswered(cls_id, msg_id, false);
+    });
+
+    mConfigurationTimer.setSingleShot(true);
+    connect(&mConfigurationTimer, &QTimer::timeout, this, &UbloxBasestation::configurationStepTimeout);
+
+    mTelemetryTimer.setSingleShot(true);
+    connect(&mTelemetryTimer, &QTimer::timeout, this, &UbloxBasestation::forwardTelemetry);
+    mTelemetryElapsed.start();
+
+    connect(&mUblox, &Ublox::rtcmRx, this, [this](const QByteArray& data, const int &type)
     {
         // Send base station position every sendRtcmRefDelayMultiplier cycles to save some bandwidth.
         static int basePosCnt = 0;
@@ -60,9 +84,27 @@ bool UbloxBasestation::connectSerial(const QSerialPortInfo& serialPortInfo, cons
 bool UbloxBasestation::disconnectSerial()
 {
     mUblox.disconnectSerial();
+    cancelConfiguration();
     return true;
 }
 
+void UbloxBasestation::cancelConfiguration()
+{
+    if (!isConfiguring())
+        return;
+
+    mPendingSteps.clear();
+    mOutstandingSteps.clear();
+    mConfigurationTimer.stop();
+    mConfigurationStepsTotal = 0;
+    emit configurationFinished(false);
+}
+
+void UbloxBasestation::setTelemetryInterval(int interval_ms)
+{
+    mTelemetryInterval_ms = std::max(interval_ms, 0);
+}
+
 
 bool UbloxBasestation::configureUblox(const BasestationConfig& basestationConfig)
 {
@@ -71,6 +113,9 @@ bool UbloxBasestation::configureUblox(const BasestationConfig& basestationConfig
         return false;
     }
 
+    cancelConfiguration();
+    mConfigurationSucceeded = true;
+
     ubx_cfg_prt_uart uart;
     uart.baudrate = basestationConfig.baudrate;
     uart.in_ubx = true;
@@ -80,50 +125,57 @@ bool UbloxBasestation::configureUblox(const BasestationConfig& basestationConfig
     uart.out_ubx = true;
     uart.out_nmea = true;
     uart.out_rtcm3 = true;
-/*    qDebug() << "CfgPrtUart:" << */mUblox.ubxCfgPrtUart(&uart);
+    // Changes the port settings, i.e., nothing else is in flight meanwhile
+    addConfigurationStep("CFG-PRT", UBX_CLASS_CFG, UBX_CFG_PRT, [this, uart]() mutable {
+        mUblox.ubxCfgPrtUart(&uart);
+    }, true);
 
-    mUblox.ubxCfgRate(basestationConfig.measurementRate, basestationConfig.navSolutionRate, 0);
+    const uint16_t measurementRate = basestationConfig.measurementRate;
+    const uint16_t navSolutionRate = basestationConfig.navSolutionRate;
+    addConfigurationStep("CFG-RATE", UBX_CLASS_CFG, UBX_CFG_RATE, [this, measurementRate, navSolutionRate]() {
+        mUblox.ubxCfgRate(measurementRate, navSolutionRate, 0);
+    });
 
     // Configure messages sent from ublox
-    mUblox.ubxCfgMsg(UBX_CLASS_RXM, UBX_RXM_RAWX, 0);
-    mUblox.ubxCfgMsg(UBX_CLASS_RXM, UBX_RXM_SFRBX, 0);
-    mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_SOL, 0);
-    mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_SAT, 1);
-    mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_PVT, 1);
+    addCfgMsgStep(UBX_CLASS_RXM, UBX_RXM_RAWX, 0);
+    addCfgMsgStep(UBX_CLASS_RXM, UBX_RXM_SFRBX, 0);
+    addCfgMsgStep(UBX_CLASS_NAV, UBX_NAV_SOL, 0);
+    addCfgMsgStep(UBX_CLASS_NAV, UBX_NAV_SAT, 1);
+    addCfgMsgStep(UBX_CLASS_NAV, UBX_NAV_PVT, 1);
 
     switch (basestationConfig.mode) {
     case BasestationMode::MovingBase:
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1005, 0);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1074, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1077, 0);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1084, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1087, 0);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1094, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1097, 0);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1124, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1127, 0);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1230, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_4072_0, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_4072_1, 0);
-
-        mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_SVIN, 0);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1005, 0);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1074, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1077, 0);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1084, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1087, 0);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1094, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1097, 0);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1124, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1127, 0);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1230, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_4072_0, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_4072_1, 0);
+
+        addCfgMsgStep(UBX_CLASS_NAV, UBX_NAV_SVIN, 0);
         break;
     case BasestationMode::Fixed:
     case BasestationMode::SurveyIn:
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1005, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1074, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1077, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1084, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1087, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1094, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1097, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1124, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1127, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1230, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_4072_0, 1);
-        mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_4072_1, 0);
-
-        mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_SVIN, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1005, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1074, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1077, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1084, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1087, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1094, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1097, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1124, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1127, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_1230, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_4072_0, 1);
+        addCfgMsgStep(UBX_CLASS_RTCM3, UBX_RTCM3_4072_1, 0);
+
+        addCfgMsgStep(UBX_CLASS_NAV, UBX_NAV_SVIN, 1);
         break;
     }
 
@@ -134,7 +186,11 @@ bool UbloxBasestation::configureUblox(const BasestationConfig& basestationConfig
     mUblox.ubloxCfgAppendEnableGal(buffer, &ind, true, true, true);
     mUblox.ubloxCfgAppendEnableBds(buffer, &ind, true, true, true);
     mUblox.ubloxCfgAppendEnableGlo(buffer, &ind, true, true, true);
-    mUblox.ubloxCfgValset(buffer, ind, true, true, true);
+    const QByteArray values(reinterpret_cast<const char*>(buffer), ind);
+    addConfigurationStep("CFG-VALSET (GNSS)", UBX_CLASS_CFG, UBX_CFG_VALSET, [this, values]() {
+        QByteArray buffer = values;
+        mUblox.ubloxCfgValset(reinterpret_cast<unsigned char*>(buffer.data()), buffer.size(), true, true, true);
+    });
 
     // Set BasestationMode
     ubx_cfg_tmode3 cfg_mode;
@@ -157,15 +213,18 @@ bool UbloxBasestation::configureUblox(const BasestationConfig& basestationConfig
         cfg_mode.svin_acc_limit = basestationConfig.surveyInMinAcc;
         break;
     }
-    mUblox.ubxCfgTmode3(&cfg_mode);
+    addConfigurationStep("CFG-TMODE3", UBX_CLASS_CFG, UBX_CFG_TMODE3, [this, cfg_mode]() mutable {
+        mUblox.ubxCfgTmode3(&cfg_mode);
+    });
 
-    // Stationary dynamic model
+    // Stationary dynamic model (automotive for a moving base)
     ubx_cfg_nav5 nav5;
     memset(&nav5, 0, sizeof(ubx_cfg_nav5));
     nav5.apply_dyn = true;
-    nav5.apply_dyn = true;
-    nav5.dyn_model = 2;
-    mUblox.ubxCfgNav5(&nav5);
+    nav5.dyn_model = (basestationConfig.mode == BasestationMode::MovingBase) ? 4 : 2;
+    addConfigurationStep("CFG-NAV5", UBX_CLASS_CFG, UBX_CFG_NAV5, [this, nav5]() mutable {
+        mUblox.ubxCfgNav5(&nav5);
+    });
 
     // Time pulse configuration
     ubx_cfg_tp5 tp5;
@@ -186,7 +245,9 @@ bool UbloxBasestation::configureUblox(const BasestationConfig& basestationConfig
     tp5.user_config_delay = 0;
     tp5.rf_group_delay = 0;
     tp5.ant_cable_delay = 50;
-    mUblox.ubloxCfgTp5(&tp5);
+    addConfigurationStep("CFG-TP5", UBX_CLASS_CFG, UBX_CFG_TP5, [this, tp5]() mutable {
+        mUblox.ubloxCfgTp5(&tp5);
+    });
 
     // Save everything
     ubx_cfg_cfg cfg;
@@ -203,11 +264,114 @@ bool UbloxBasestation::configureUblox(const BasestationConfig& basestationConfig
     cfg.save_fts_conf = true;
     cfg.dev_bbr = true;
     cfg.dev_flash = true;
-    mUblox.ubloxCfgCfg(&cfg);
+    // Saves what was acknowledged before
+    addConfigurationStep("CFG-CFG", UBX_CLASS_CFG, UBX_CFG_CFG, [this, cfg]() mutable {
+        mUblox.ubloxCfgCfg(&cfg);
+    }, true);
+
+    mConfigurationStepsTotal = mPendingSteps.size();
+    sendConfigurationSteps();
 
     return true;
 }
 
+void UbloxBasestation::addConfigurationStep(const QString &name, uint8_t msgClass, uint8_t msgId, std::function<void()> send, bool exclusive)
+{
+    ConfigurationStep step;
+    step.name = name;
+    step.msgClass = msgClass;
+    step.msgId = msgId;
+    step.send = send;
+    step.exclusive = exclusive;
+    mPendingSteps.append(step);
+}
+
+void UbloxBasestation::addCfgMsgStep(uint8_t msgClass, uint8_t msgId, uint8_t rate)
+{
+    addConfigurationStep(QString("CFG-MSG %1/%2").arg(msgClass, 2, 16, QChar('0')).arg(msgId, 2, 16, QChar('0')),
+                         UBX_CLASS_CFG, UBX_CFG_MSG, [this, msgClass, msgId, rate]() {
+        mUblox.ubxCfgMsg(msgClass, msgId, rate);
+    });
+}
+
+void UbloxBasestation::sendConfigurationSteps()
+{
+    while (!mPendingSteps.isEmpty() && mOutstandingSteps.size() < MAX_OUTSTANDING_CONFIGURATION_STEPS) {
+        if (!mOutstandingSteps.isEmpty() && (mOutstandingSteps.last().exclusive || mPendingSteps.first().exclusive))
+            break;
+
+        mOutstandingSteps.append(mPendingSteps.takeFirst());
+        mOutstandingSteps.last().sent.start();
+        mOutstandingSteps.last().send();
+    }
+
+    if (!mOutstandingSteps.isEmpty()) {
+        const qint64 remaining_ms = CONFIGURATION_STEP_TIMEOUT_MS - mOutstandingSteps.first().sent.elapsed();
+        mConfigurationTimer.start(int(std::max<qint64>(remaining_ms, 0)));
+    } else if (mConfigurationStepsTotal > 0) {
+        mConfigurationTimer.stop();
+        mConfigurationStepsTotal = 0;
+        emit configurationFinished(mConfigurationSucceeded);
+    }
+}
+
+void UbloxBasestation::configurationStepAnswered(uint8_t msgClass, uint8_t msgId, bool ack)
+{
+    // The receiver answers in order, i.e., the first outstanding step with that class and id
+    for (int i = 0; i < mOutstandingSteps.size(); i++) {
+        if (mOutstandingSteps.at(i).msgClass == msgClass && mOutstandingSteps.at(i).msgId == msgId) {
+            if (!ack)
+                qDebug() << "Warning: UbloxBasestation got NAK for" << mOutstandingSteps.at(i).name;
+            finishConfigurationStep(i, ack);
+            return;
+        }
+    }
+}
+
+void UbloxBasestation::configurationStepTimeout()
+{
+    if (mOutstandingSteps.isEmpty())
+        return;
+
+    qDebug() << "Warning: UbloxBasestation got no answer for" << mOutstandingSteps.first().name
+             << "within" << CONFIGURATION_STEP_TIMEOUT_MS << "ms";
+    finishConfigurationStep(0, false);
+}
+
+void UbloxBasestation::finishConfigurationStep(int index, bool succeeded)
+{
+    mOutstandingSteps.removeAt(index);
+    mConfigurationSucceeded = mConfigurationSucceeded && succeeded;
+    emit configurationProgress(mConfigurationStepsTotal - mPendingSteps.size() - mOutstandingSteps.size(), mConfigurationStepsTotal);
+    sendConfigurationSteps();
+}
+
+void UbloxBasestation::scheduleTelemetry()
+{
+    if (mTelemetryTimer.isActive())
+        return;
+
+    const qint64 remaining_ms = mTelemetryInterval_ms - mTelemetryElapsed.elapsed();
+    if (remaining_ms <= 0)
+        forwardTelemetry();
+    else
+        mTelemetryTimer.start(int(remaining_ms));
+}
+
+void UbloxBasestation::forwardTelemetry()
+{
+    mTelemetryElapsed.restart();
+
+    if (mNavSatPending) {
+        mNavSatPending = false;
+        emit rxNavSat(mLatestNavSat);
+    }
+    if (mSvinPending) {
+        mSvinPending = false;
+        emit rxSvin(mLatestSvin);
+    }
+}
+
 void UbloxBasestation::pollMonVer()
 {
     mUblox.ubxPoll(UBX_CLASS_MON, UBX_MON_VER);
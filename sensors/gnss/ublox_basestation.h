@@ -3,6 +3,9 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * Sets up u-blox GNSS reciver connected over serial as a basestation. Supports/tested with F9P/F9R only for now.
+ * Serial data is read and decoded on a dedicated thread. The configuration is sent as a pipeline of commands that are
+ * correlated with their ACK/NAK, i.e., connectSerial() does not wait for the receiver. NAV-SAT and NAV-SVIN are forwarded
+ * at a limited rate (latest message per interval), as they are meant for display.
  */
 
 #ifndef UBLOX_BASESTATION_H
@@ -12,6 +15,10 @@
 #include <QMap>
 #include <QSerialPort>
 #include <QSerialPortInfo>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include <functional>
 #include "ublox.h"
 #include "core/coordinatetransforms.h"
 
@@ -32,14 +39,24 @@ public:
         unsigned surveyInMinDuration = 60; // [s]
     };
     static const BasestationConfig defaultConfig;
+    static constexpr int CONFIGURATION_STEP_TIMEOUT_MS = 500;
+    static constexpr int MAX_OUTSTANDING_CONFIGURATION_STEPS = 4; // receiver's input buffer is small
+    static constexpr int DEFAULT_TELEMETRY_INTERVAL_MS = 250;
 
     explicit UbloxBasestation(QObject *parent = nullptr);
+    // Returns once connected, configurationFinished() is emitted when the receiver has answered all configuration steps
     bool connectSerial(const QSerialPortInfo &serialPortInfo, const BasestationConfig config = defaultConfig);
     bool disconnectSerial();
+    bool isConfiguring() const { return !mPendingSteps.isEmpty() || !mOutstandingSteps.isEmpty(); }
+    void cancelConfiguration();
+    // Minimum interval between rxNavSat/rxSvin, 0: every message
+    void setTelemetryInterval(int interval_ms);
+    int getTelemetryInterval() const { return mTelemetryInterval_ms; }
     bool isSerialConnected() {return mUblox.isSerialConnected();}
     BasestationConfig& getBasestationConfigCurrent();
     BasestationConfig& getBasestationConfigDefault();
     void pollMonVer();
+    void writeRtcm(const QByteArray &data) { mUblox.writeRaw(data); } // corrections, e.g., for a moving base
     void pollCfgGNSS();
 
 signals:
@@ -49,11 +66,44 @@ signals:
     void rxSvin(const ubx_nav_svin &svin);
     void rxCfgGnss(const ubx_cfg_gnss &gnss);
     void rxMonVer(const QString &sw, const QString &hw, const QStringList &extensions);
+    void configurationProgress(int stepsDone, int stepsTotal);
+    void configurationFinished(bool succeeded); // false: a step got NAK or timed out, or configuration was cancelled
 
 private:
+    struct ConfigurationStep {
+        QString name;
+        uint8_t msgClass;
+        uint8_t msgId;
+        std::function<void()> send;
+        bool exclusive = false; // sent when nothing else is outstanding and nothing follows before its answer
+        QElapsedTimer sent;
+    };
+
     Ublox mUblox;
     const int sendRtcmRefDelayMultiplier = 5;
     bool configureUblox(const BasestationConfig& basestationConfig);
+    void addConfigurationStep(const QString &name, uint8_t msgClass, uint8_t msgId, std::function<void()> send, bool exclusive = false);
+    void addCfgMsgStep(uint8_t msgClass, uint8_t msgId, uint8_t rate);
+    void sendConfigurationSteps();
+    void configurationStepAnswered(uint8_t msgClass, uint8_t msgId, bool ack);
+    void configurationStepTimeout();
+    void finishConfigurationStep(int index, bool succeeded);
+    void scheduleTelemetry();
+    void forwardTelemetry();
+
+    QList<ConfigurationStep> mPendingSteps;
+    QList<ConfigurationStep> mOutstandingSteps; // in the order sent, answers come in the same order
+    int mConfigurationStepsTotal = 0;
+    bool mConfigurationSucceeded = true;
+    QTimer mConfigurationTimer; // for the oldest outstanding step
+
+    int mTelemetryInterval_ms = DEFAULT_TELEMETRY_INTERVAL_MS;
+    QTimer mTelemetryTimer;
+    QElapsedTimer mTelemetryElapsed;
+    ubx_nav_sat mLatestNavSat;
+    ubx_nav_svin mLatestSvin;
+    bool mNavSatPending = false;
+    bool mSvinPending = false;
 
 };
 
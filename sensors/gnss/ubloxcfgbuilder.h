@@ -0,0 +1,95 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Collects configuration key/value pairs for u-blox generation 9 receivers (CFG-VALSET). The storage size of a value
+ * is taken from its key (bits 28-30), i.e., values only need to be given as integers. The pairs are split into messages
+ * of at most 64 keys that form one transaction (begin/continue/apply): the receiver applies all of them or none.
+ * See Ublox::ubloxCfgValset(const UbloxCfgBuilder &, ...).
+ */
+
+#ifndef UBLOXCFGBUILDER_H
+#define UBLOXCFGBUILDER_H
+
+#include <QByteArray>
+#include <QPair>
+#include <QVector>
+#include <algorithm>
+#include <cstdint>
+
+class UbloxCfgBuilder
+{
+public:
+    static constexpr int MAX_KEYS_PER_VALSET = 64;
+    enum class Port {I2c, Uart1, Uart2, Usb, Spi}; // order of the CFG-MSGOUT keys
+
+
+    // Replaces the value if the key was set before, signed values are stored in two's complement
+    UbloxCfgBuilder &set(uint32_t key, int64_t value) {
+        for (auto &keyValue : mKeyValues)
+            if (keyValue.first == key) {
+                keyValue.second = value;
+                return *this;
+            }
+        mKeyValues.append({key, value});
+        return *this;
+    }
+
+    // msgoutKey: CFG-MSGOUT key for I2C (CFG_MSGOUT_*), the keys for the other ports follow it
+    UbloxCfgBuilder &setMessageRate(uint32_t msgoutKey, Port port, uint8_t rate) {
+        return set(msgoutKey + static_cast<uint32_t>(port), rate);
+    }
+
+    // Bytes in the message: 1 bit and 1 byte values use one byte
+    static int getValueSize(uint32_t key) {
+        switch ((key >> 28) & 0x07) {
+        case 1: case 2: return 1;
+        case 3: return 2;
+        case 4: return 4;
+        case 5: return 8;
+        default: return 0;
+        }
+    }
+
+    int size() const { return mKeyValues.size(); }
+    bool isEmpty() const { return mKeyValues.isEmpty(); }
+    void clear() { mKeyValues.clear(); }
+
+    // layers: bit 0 RAM, bit 1 BBR, bit 2 flash. A single message is sent without a transaction.
+    QVector<QByteArray> getValsetPayloads(uint8_t layers) const {
+        QVector<QByteArray> payloads;
+        const int numMessages = (mKeyValues.size() + MAX_KEYS_PER_VALSET - 1) / MAX_KEYS_PER_VALSET;
+
+        for (int message = 0; message < numMessages; message++) {
+            uint8_t transaction = 0; // none
+            if (numMessages > 1)
+                transaction = (message == 0) ? 1 : ((message == numMessages - 1) ? 3 : 2); // begin, continue, apply
+
+            QByteArray payload;
+            payload.reserve(4 + MAX_KEYS_PER_VALSET * 12);
+            payload.append(char(1)); // version with transactions
+            payload.append(char(layers));
+            payload.append(char(transaction));
+            payload.append(char(0));
+
+            const int end = std::min((message + 1) * MAX_KEYS_PER_VALSET, mKeyValues.size());
+            for (int i = message * MAX_KEYS_PER_VALSET; i < end; i++) {
+                appendLittleEndian(payload, mKeyValues.at(i).first, 4);
+                appendLittleEndian(payload, uint64_t(mKeyValues.at(i).second), getValueSize(mKeyValues.at(i).first));
+            }
+            payloads.append(payload);
+        }
+
+        return payloads;
+    }
+
+private:
+    static void appendLittleEndian(QByteArray &buffer, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++)
+            buffer.append(char((value >> (8 * i)) & 0xFF));
+    }
+
+    QVector<QPair<uint32_t, int64_t>> mKeyValues; // in the order set
+};
+
+#endif // UBLOXCFGBUILDER_H
@@ -0,0 +1,55 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "ubloxmovingbasepair.h"
+#include <QDebug>
+
+UbloxMovingBasePair::UbloxMovingBasePair(QSharedPointer<VehicleState> vehicleState, double baselineYawOffset_deg)
+{
+    mRover = QSharedPointer<UbloxRover>::create(vehicleState);
+    mRover->setDualAntennaHeading(true, baselineYawOffset_deg);
+
+    // Moving base corrections for the rover, every message (1005 is not sent by a moving base)
+    connect(&mMovingBase, &UbloxBasestation::rtcmData, this, [this](const QByteArray &data, const int &type) {
+        Q_UNUSED(type)
+        mRover->writeRtcmToUblox(data);
+    });
+
+    connect(&mMovingBase, &UbloxBasestation::configurationFinished, this, [](bool succeeded) {
+        if (!succeeded)
+            qDebug() << "Warning: UbloxMovingBasePair: moving base did not acknowledge all configuration steps";
+    });
+}
+
+bool UbloxMovingBasePair::connectSerial(const QSerialPortInfo &movingBasePortInfo, const QSerialPortInfo &roverPortInfo)
+{
+    UbloxBasestation::BasestationConfig config = UbloxBasestation::defaultConfig;
+    config.mode = UbloxBasestation::BasestationMode::MovingBase;
+    config.measurementRate = MEASUREMENT_PERIOD_MS;
+    config.navSolutionRate = 1;
+
+    if (!mMovingBase.connectSerial(movingBasePortInfo, config)) {
+        qDebug() << "UbloxMovingBasePair: unable to connect to moving base at" << movingBasePortInfo.systemLocation();
+        return false;
+    }
+
+    if (!mRover->connectSerial(roverPortInfo)) {
+        qDebug() << "UbloxMovingBasePair: unable to connect to rover at" << roverPortInfo.systemLocation();
+        mMovingBase.disconnectSerial();
+        return false;
+    }
+
+    return true;
+}
+
+void UbloxMovingBasePair::disconnectSerial()
+{
+    mMovingBase.disconnectSerial();
+    // UbloxRover has no disconnect, its port is closed when it is destroyed
+}
+
+void UbloxMovingBasePair::writeRtcmToMovingBase(const QByteArray &data)
+{
+    mMovingBase.writeRtcm(data);
+}
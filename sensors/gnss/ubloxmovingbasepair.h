@@ -0,0 +1,44 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Two u-blox F9P receivers on one vehicle for dual-antenna heading: the moving base (primary antenna) gets external corrections
+ * (e.g., NTRIP) and sends its RTCM (4072.0, MSM4, 1230) to the rover (secondary antenna). The rover provides the vehicle's GNSS
+ * position (NAV-PVT) and the heading of the baseline (NAV-RELPOSNED). The heading is available at standstill and right after
+ * start-up; connect the rover's updatedGNSSHeading to the fuser's correctYawGNSSHeading next to updatedGNSSPositionAndYaw.
+ */
+
+#ifndef UBLOXMOVINGBASEPAIR_H
+#define UBLOXMOVINGBASEPAIR_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QSerialPortInfo>
+#include "ublox_basestation.h"
+#include "ubloxrover.h"
+
+class UbloxMovingBasePair : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr unsigned MEASUREMENT_PERIOD_MS = 200; // needs to match the rover's
+
+    // baselineYawOffset_deg: see UbloxRover::setDualAntennaHeading
+    UbloxMovingBasePair(QSharedPointer<VehicleState> vehicleState, double baselineYawOffset_deg = 0.0);
+    bool connectSerial(const QSerialPortInfo &movingBasePortInfo, const QSerialPortInfo &roverPortInfo);
+    void disconnectSerial();
+    bool isSerialConnected() { return mMovingBase.isSerialConnected() && mRover->isSerialConnected(); }
+
+    // E.g., for VehicleServer::setGNSSReceiver and the fuser's inputs
+    QSharedPointer<UbloxRover> getRover() const { return mRover; }
+    UbloxBasestation &getMovingBase() { return mMovingBase; }
+
+public slots:
+    void writeRtcmToMovingBase(const QByteArray &data);
+
+private:
+    UbloxBasestation mMovingBase;
+    QSharedPointer<UbloxRover> mRover;
+};
+
+#endif // UBLOXMOVINGBASEPAIR_H
@@ -0,0 +1,72 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "ubloxodometryfeeder.h"
+#include <cmath>
+#include <cstdlib>
+
+UbloxOdometryFeeder::UbloxOdometryFeeder(std::function<void(const ubx_esf_meas &)> send) : mSend(send)
+{
+}
+
+void UbloxOdometryFeeder::setRate_Hz(double rate_Hz)
+{
+    mRate_Hz = qBound(MIN_RATE_HZ, rate_Hz, MAX_RATE_HZ);
+}
+
+void UbloxOdometryFeeder::addTachometer(int tachometer, qint64 timestamp_ns)
+{
+    if (!utcTime::isValid(timestamp_ns) || (mHasPrevious && timestamp_ns < mPreviousTimestamp_ns))
+        return;
+
+    if (!mHasPrevious) {
+        mHasPrevious = true;
+        mSentTachometer = tachometer;
+        mSentTimestamp_ns = timestamp_ns;
+    } else {
+        const int delta = tachometer - mPreviousTachometer;
+        mTicks = (mTicks + uint32_t(std::abs(delta))) & TICK_MASK;
+        if (delta != 0)
+            mBackward = delta < 0;
+    }
+    mPreviousTachometer = tachometer;
+    mPreviousTimestamp_ns = timestamp_ns;
+
+    // Sent on a fixed schedule (not relative to the last message), i.e., decimated updates keep the average rate
+    if (utcTime::isValid(mNextSend_ns) && timestamp_ns < mNextSend_ns) {
+        mDecimatedUpdates++;
+        return;
+    }
+    const qint64 period_ns = qint64(1e9 / mRate_Hz);
+    mNextSend_ns = utcTime::isValid(mNextSend_ns) ? mNextSend_ns + period_ns : timestamp_ns + period_ns;
+    if (mNextSend_ns <= timestamp_ns) // after a gap
+        mNextSend_ns = timestamp_ns + period_ns;
+
+    ubx_esf_meas meas = {};
+    meas.time_tag = uint32_t(timestamp_ns / utcTime::NS_PER_MS); // wraps (like the receiver's) after 49 days, continuous
+    meas.data_type[meas.num_meas] = SINGLE_TICK;
+    meas.data_field[meas.num_meas++] = mTicks | (mBackward ? (1u << 23) : 0u);
+    if (mMetersPerTick > 0.0 && timestamp_ns > mSentTimestamp_ns) {
+        const double speed_mps = (tachometer - mSentTachometer) * mMetersPerTick / ((timestamp_ns - mSentTimestamp_ns) * 1e-9);
+        meas.data_type[meas.num_meas] = SPEED;
+        meas.data_field[meas.num_meas++] = uint32_t(int32_t(std::lround(speed_mps * 1e3))) & 0x00FFFFFF; // signed 24 bit
+    }
+    mSentTachometer = tachometer;
+    mSentTimestamp_ns = timestamp_ns;
+
+    mSend(meas);
+    mSentMessages++;
+}
+
+void UbloxOdometryFeeder::reset()
+{
+    mHasPrevious = false;
+    mPreviousTachometer = 0;
+    mPreviousTimestamp_ns = utcTime::INVALID;
+    mTicks = 0;
+    mBackward = false;
+    mNextSend_ns = utcTime::INVALID;
+    mSentTachometer = 0;
+    mSentTimestamp_ns = utcTime::INVALID;
+}
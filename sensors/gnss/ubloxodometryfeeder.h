@@ -0,0 +1,62 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Wheel odometry input for u-blox dead reckoning receivers (F9R) from a motor controller's tachometer (e.g., VESC).
+ * Every tachometer update is accumulated, but ESF-MEAS is sent at a fixed rate (the F9R wants 10-50 Hz, updates in between
+ * are decimated). Each message carries all measurements of its sample at once (cumulative ticks with direction, and speed if
+ * enabled), time tagged with the time the motor controller was sampled instead of when the message is sent.
+ * Not thread-safe, use it from the thread that delivers the tachometer updates.
+ */
+
+#ifndef UBLOXODOMETRYFEEDER_H
+#define UBLOXODOMETRYFEEDER_H
+
+#include <QtGlobal>
+#include <functional>
+#include "core/utctime.h"
+#include "sensors/gnss/ublox.h"
+
+class UbloxOdometryFeeder
+{
+public:
+    static constexpr double MIN_RATE_HZ = 10.0;
+    static constexpr double MAX_RATE_HZ = 50.0;
+    static constexpr double DEFAULT_RATE_HZ = 20.0;
+    static constexpr uint32_t TICK_MASK = 0x7FFFFF; // SINGLE_TICK: 23 bit tick count, bit 23 direction (1: backward)
+
+    // send: e.g., Ublox::ubloxEsfMeasInput
+    explicit UbloxOdometryFeeder(std::function<void(const ubx_esf_meas &)> send);
+
+    void setRate_Hz(double rate_Hz); // limited to MIN_RATE_HZ..MAX_RATE_HZ
+    double getRate_Hz() const { return mRate_Hz; }
+    // SPEED in addition to SINGLE_TICK, from the ticks since the last message. metersPerTick <= 0: off
+    void setSpeedOutput(double metersPerTick) { mMetersPerTick = metersPerTick; }
+
+    // Cumulative, signed tachometer (e.g., from MotorController::gotStatusValues), timestamp_ns: when it was sampled.
+    // Updates with a timestamp before the previous one are ignored.
+    void addTachometer(int tachometer, qint64 timestamp_ns);
+    void reset();
+
+    quint64 getSentMessages() const { return mSentMessages; }
+    quint64 getDecimatedUpdates() const { return mDecimatedUpdates; }
+
+private:
+    std::function<void(const ubx_esf_meas &)> mSend;
+    double mRate_Hz = DEFAULT_RATE_HZ;
+    double mMetersPerTick = 0.0;
+
+    bool mHasPrevious = false;
+    int mPreviousTachometer = 0;
+    qint64 mPreviousTimestamp_ns = utcTime::INVALID;
+    uint32_t mTicks = 0; // absolute, wraps at TICK_MASK
+    bool mBackward = false;
+
+    qint64 mNextSend_ns = utcTime::INVALID;
+    int mSentTachometer = 0;
+    qint64 mSentTimestamp_ns = utcTime::INVALID;
+    quint64 mSentMessages = 0;
+    quint64 mDecimatedUpdates = 0;
+};
+
+#endif // UBLOXODOMETRYFEEDER_H
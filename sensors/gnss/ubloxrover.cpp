@@ -3,17 +3,21 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "ubloxrover.h"
+#include "sensors/sensortopics.h"
 #include <QDebug>
 #include <QDateTime>
 #include <QLineF>
 #include <cmath>
 
 UbloxRover::UbloxRover(QSharedPointer<VehicleState> vehicleState)
-    : GNSSReceiver(vehicleState)
+    : GNSSReceiver(vehicleState), mOdometryFeeder([this](const ubx_esf_meas &meas) { mUblox.ubloxEsfMeasInput(meas); })
 {
     // Use GNSS reception to update location
     connect(&mUblox, &Ublox::rxNavPvt, this, &UbloxRover::updateGNSSPositionAndYaw);
 
+    // Dual-antenna heading (only output if enabled)
+    connect(&mUblox, &Ublox::rxRelPosNed, this, &UbloxRover::updateGNSSHeading);
+
     // Save-on-shutdown feature
     connect(&mUblox, &Ublox::rxUpdSos, this, &UbloxRover::updSosResponse);
 
@@ -128,6 +132,38 @@ bool UbloxRover::connectSerial(const QSerialPortInfo &serialPortInfo)
         return false;
 }
 
+void UbloxRover::setDualAntennaHeading(bool enabled, double baselineYawOffset_deg)
+{
+    mDualAntennaHeading = enabled;
+    mBaselineYawOffset_deg = baselineYawOffset_deg;
+}
+
+void UbloxRover::setTimeDiscipline(QSharedPointer<GnssTimeDiscipline> timeDiscipline)
+{
+    if (mTimeDiscipline)
+        mTimeDiscipline->setUblox(nullptr);
+    mTimeDiscipline = timeDiscipline;
+    if (mTimeDiscipline)
+        mTimeDiscipline->setUblox(&mUblox);
+}
+
+void UbloxRover::setDedicatedIoThread(bool enabled)
+{
+    mUblox.setDedicatedIoThread(enabled);
+
+    // With a dedicated I/O thread, NAV-PVT is taken from the lock-free queue instead of being copied through the event queue
+    disconnect(&mUblox, &Ublox::rxNavPvt, this, &UbloxRover::updateGNSSPositionAndYaw);
+    disconnect(&mUblox, &Ublox::navPvtQueued, this, nullptr);
+    if (mUblox.hasDedicatedIoThread())
+        connect(&mUblox, &Ublox::navPvtQueued, this, [this](){
+            ubx_nav_pvt pvt;
+            while (mUblox.popNavPvt(pvt))
+                updateGNSSPositionAndYaw(pvt);
+        });
+    else
+        connect(&mUblox, &Ublox::rxNavPvt, this, &UbloxRover::updateGNSSPositionAndYaw);
+}
+
 bool UbloxRover::isSerialConnected()
 {
     return mUblox.isSerialConnected();
@@ -153,82 +189,64 @@ bool UbloxRover::configureUblox()
     // and it is possible to enable or disable single NMEA or UBX messages individually.
     // If the rate configuration value is zero, then the corresponding message will not be output.
     // Values greater than zero indicate how often the message is output.
-    // TODO: convert to VALSET msg
-    mUblox.ubxCfgMsg(UBX_CLASS_ESF, UBX_ESF_MEAS, 0);
-    mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_PVT, 1);
-    mUblox.ubxCfgMsg(UBX_CLASS_ESF, UBX_ESF_STATUS, 1);
-    mUblox.ubxCfgMsg(UBX_CLASS_ESF, UBX_ESF_ALG, 1);
-    // make sure some messages are disabled
-    mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_SAT, 0);
-    mUblox.ubxCfgMsg(UBX_CLASS_RXM, UBX_RXM_RAWX, 0);
-    mUblox.ubxCfgMsg(UBX_CLASS_RXM, UBX_RXM_SFRBX, 0);
-    mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_SOL, 0);
-
-    unsigned char buffer[512];
-    int ind = 0;
-    mUblox.ubloxCfgAppendMntalg(buffer, &ind, true); // enable auto mount alignment
-    mUblox.ubloxCfgAppendRate(buffer, &ind, 100, 1, 0, 30); // nav prio mode
-    if (!mUblox.ubloxCfgValset(buffer, ind, true, true, true)) { // try valset
-        // setting auto mount alignment and nav prio failed -> this is F9P)
-        bool result = true;
-        result &= mUblox.ubxCfgRate(200, 1, 0);
+    // Everything is set in one VALSET transaction: an F9R applies it, an F9P rejects all of it (unknown sensor fusion keys)
+    const UbloxCfgBuilder::Port port = mUblox.getReceiverPort();
+    UbloxCfgBuilder cfg;
+    cfg.setMessageRate(CFG_MSGOUT_UBX_ESF_MEAS, port, 0)
+            .setMessageRate(CFG_MSGOUT_UBX_NAV_PVT, port, 1)
+            .setMessageRate(CFG_MSGOUT_UBX_ESF_STATUS, port, 1)
+            .setMessageRate(CFG_MSGOUT_UBX_ESF_ALG, port, 1)
+            // make sure some messages are disabled
+            .setMessageRate(CFG_MSGOUT_UBX_NAV_SAT, port, 0)
+            .setMessageRate(CFG_MSGOUT_UBX_RXM_RAWX, port, 0)
+            .setMessageRate(CFG_MSGOUT_UBX_RXM_SFRBX, port, 0)
+            .setMessageRate(CFG_MSGOUT_UBX_NAV_RELPOSNED, port, mDualAntennaHeading ? 1 : 0)
+            .set(CFG_SFIMU_AUTO_MNTALG_ENA, true) // enable auto mount alignment
+            .set(CFG_RATE_MEAS, 100).set(CFG_RATE_NAV, 1).set(CFG_RATE_TIMEREF, 0).set(CFG_RATE_NAV_PRIO, 30); // nav prio mode
+    if (mTimeDiscipline)
+        GnssTimeDiscipline::addTimTpOutput(cfg, port);
+    if (!mUblox.ubloxCfgValset(cfg, true, true, true)) {
+        // setting auto mount alignment and nav prio failed -> this is F9P
+        cfg.clear();
+        cfg.setMessageRate(CFG_MSGOUT_UBX_NAV_PVT, port, 1)
+                .setMessageRate(CFG_MSGOUT_UBX_NAV_SAT, port, 0)
+                .setMessageRate(CFG_MSGOUT_UBX_RXM_RAWX, port, 0)
+                .setMessageRate(CFG_MSGOUT_UBX_RXM_SFRBX, port, 0)
+                .setMessageRate(CFG_MSGOUT_UBX_NAV_RELPOSNED, port, mDualAntennaHeading ? 1 : 0)
+                .set(CFG_RATE_MEAS, 200).set(CFG_RATE_NAV, 1).set(CFG_RATE_TIMEREF, 0);
+        if (mTimeDiscipline)
+            GnssTimeDiscipline::addTimTpOutput(cfg, port);
 
         // Chip might have been used as base station, make sure to reconfigure.
-        // TODO: this code is taken from "old sdvp" s.th. F9P behaves as we are used to,
-        //       but needs to be revised, e.g., use VALSET msgs that work for F9R and F9P:
-        //        ind = 0;
-        //        mUblox.ubloxCfgAppendRate(buffer, &ind, 200, 1, 0);
-        //        result &= mUblox.ubloxCfgValset(buffer, ind, true, true, true);
-
         // Disable RTCM output
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1005, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1074, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1077, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1084, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1087, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1094, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1097, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1124, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1127, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_1230, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_4072_0, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_RTCM3, UBX_RTCM3_4072_1, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NAV, UBX_NAV_SVIN, 0);
+        for (uint32_t msgoutKey : {CFG_MSGOUT_RTCM_1005, CFG_MSGOUT_RTCM_1074, CFG_MSGOUT_RTCM_1077, CFG_MSGOUT_RTCM_1084,
+             CFG_MSGOUT_RTCM_1087, CFG_MSGOUT_RTCM_1094, CFG_MSGOUT_RTCM_1097, CFG_MSGOUT_RTCM_1124,
+             CFG_MSGOUT_RTCM_1127, CFG_MSGOUT_RTCM_1230, CFG_MSGOUT_RTCM_4072_0, CFG_MSGOUT_RTCM_4072_1,
+             CFG_MSGOUT_UBX_NAV_SVIN})
+            cfg.setMessageRate(msgoutKey, port, 0);
 
         // Enable NMEA GGA output (required by some NTRIP/RTCM servers)
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_GGA, 1);
+        cfg.setMessageRate(CFG_MSGOUT_NMEA_GGA, port, 1);
 
         // Disable NMEA output (all but GGA)
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_GSV, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_GLL, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_GSA, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_RMC, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_VTG, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_GRS, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_GST, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_ZDA, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_GBS, 0);
-        result &= mUblox.ubxCfgMsg(UBX_CLASS_NMEA, UBX_NMEA_DTM, 0);
+        for (uint32_t msgoutKey : {CFG_MSGOUT_NMEA_GSV, CFG_MSGOUT_NMEA_GLL, CFG_MSGOUT_NMEA_GSA, CFG_MSGOUT_NMEA_RMC,
+             CFG_MSGOUT_NMEA_VTG, CFG_MSGOUT_NMEA_GRS, CFG_MSGOUT_NMEA_GST, CFG_MSGOUT_NMEA_ZDA,
+             CFG_MSGOUT_NMEA_GBS, CFG_MSGOUT_NMEA_DTM})
+            cfg.setMessageRate(msgoutKey, port, 0);
 
         // Disable possible survey-in / fixed position
-        ubx_cfg_tmode3 cfg_mode;
-        memset(&cfg_mode, 0, sizeof(cfg_mode));
-        cfg_mode.mode = 0;
-        result &= mUblox.ubxCfgTmode3(&cfg_mode);
-
-        // Stationary dynamic model
-        ubx_cfg_nav5 nav5;
-        memset(&nav5, 0, sizeof(ubx_cfg_nav5));
-        nav5.apply_dyn = true;
-        nav5.dyn_model = 4;
-        result &= mUblox.ubxCfgNav5(&nav5);
-
-        ind = 0;
-        mUblox.ubloxCfgAppendEnableGps(buffer, &ind, true, true, true);
-        mUblox.ubloxCfgAppendEnableGal(buffer, &ind, true, true, true);
-        mUblox.ubloxCfgAppendEnableBds(buffer, &ind, true, true, true);
-        mUblox.ubloxCfgAppendEnableGlo(buffer, &ind, true, true, true);
-        result &= mUblox.ubloxCfgValset(buffer, ind, true, true, true);
+        cfg.set(CFG_TMODE_MODE, 0);
+
+        // Automotive dynamic model
+        cfg.set(CFG_NAVSPG_DYNMODEL, 4);
+
+        for (uint32_t signalKey : {CFG_SIGNAL_GPS_ENA, CFG_SIGNAL_GPS_L1C_ENA, CFG_SIGNAL_GPS_L2C_ENA,
+             CFG_SIGNAL_GAL_ENA, CFG_SIGNAL_GAL_E1_ENA, CFG_SIGNAL_GAL_E5B_ENA,
+             CFG_SIGNAL_BDS_ENA, CFG_SIGNAL_BDS_B1_ENA, CFG_SIGNAL_BDS_B2_ENA,
+             CFG_SIGNAL_GLO_ENA, CFG_SIGNAL_GLO_L1_ENA, CFG_SIGNAL_GLO_L2_ENA})
+            cfg.set(signalKey, true);
+
+        const bool result = mUblox.ubloxCfgValset(cfg, true, true, true);
 
         qDebug() << "UbloxRover: F9P configuration" << (result ? "was successful" : "reported an error");
     }
@@ -238,61 +256,94 @@ bool UbloxRover::configureUblox()
 
 void UbloxRover::updateGNSSPositionAndYaw(const ubx_nav_pvt &pvt)
 {
-    static bool initializationDone = false;
-    static int leapSeconds_ms = 0;
-
-    if (!initializationDone && pvt.valid_time) {
-        leapSeconds_ms =  (pvt.i_tow % ms_per_day) - ((pvt.hour * 60 * 60 + pvt.min * 60 + pvt.second) * 1000);
-        qDebug() << "UbloxRover: assuming" << leapSeconds_ms / 1000 << "seconds difference between GNSS time and UTC.";
-        initializationDone = true;
-    } else {
-        PosPoint gnssPos = mVehicleState->getPosition(PosType::GNSS);
-
-        llh_t llh = {pvt.lat, pvt.lon, pvt.height};
-        xyz_t xyz = {0.0, 0.0, 0.0};
-
-        if (!mEnuReferenceSet) {
-            setEnuRef(llh);
-        } else
-            xyz = coordinateTransforms::llhToEnu(mEnuReference, llh);
-
-        // Position
-        gnssPos.setXYZ(xyz);
-        // Apply antenna offset to reference point (e.g., back axle) if set. Assumes fused yaw is updated.
-        if (mGNSSPositionOffset.x != 0.0 || mGNSSPositionOffset.y != 0.0) {
-            PosPoint fusedPos = mVehicleState->getPosition(PosType::fused);
-            double fusedYaw_radENU = fusedPos.getYaw() * M_PI / 180.0;
-
-            gnssPos.updateWithOffsetAndYawRotation(-mGNSSPositionOffset, fusedYaw_radENU);
-        }
+    PosPoint gnssPos = mVehicleState->getPosition(PosType::GNSS);
 
-        // Yaw --- based on last GNSS position if fusion (F9R) unavailable
-        static xyz_t lastXyz;
-        if(pvt.head_veh_valid) {
-            double yaw_degENU = coordinateTransforms::yawNEDtoENU(pvt.head_veh) + mIMUOrientationOffset.yawOffset_deg;
+    llh_t llh = {pvt.lat, pvt.lon, pvt.height};
+    xyz_t xyz = {0.0, 0.0, 0.0};
 
-            // normalize to [-180.0:180.0[
-            while (yaw_degENU < -180.0)
-                yaw_degENU += 360.0;
-            while (yaw_degENU >= 180.0)
-                yaw_degENU -= 360.0;
+    if (!mEnuReferenceSet) {
+        setEnuRef(llh);
+    } else
+        xyz = coordinateTransforms::llhToEnu(mEnuReference, llh);
 
-            gnssPos.setYaw(yaw_degENU);
-        } else
-            gnssPos.setYaw(atan2(xyz.y - lastXyz.y, xyz.x - lastXyz.x) * 180.0 / M_PI);
+    // Position
+    gnssPos.setXYZ(xyz);
+    // Apply antenna offset to reference point (e.g., back axle) if set. Assumes fused yaw is updated.
+    if (mGNSSPositionOffset.x != 0.0 || mGNSSPositionOffset.y != 0.0) {
+        PosPoint fusedPos = mVehicleState->getPosition(PosType::fused);
+        double fusedYaw_radENU = fusedPos.getYaw() * M_PI / 180.0;
 
-        // Time and speed
-        gnssPos.setTime(QTime::fromMSecsSinceStartOfDay((pvt.i_tow % ms_per_day) - leapSeconds_ms));
-//        qDebug() << "UbloxRover, gnssPos.getTime() - msSinceTodayUTC:" << QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()).msecsSinceStartOfDay() - gnssPos.getTime();
-        gnssPos.setSpeed(pvt.g_speed);
+        gnssPos.updateWithOffsetAndYawRotation(-mGNSSPositionOffset, fusedYaw_radENU);
+    }
 
-        mVehicleState->setPosition(gnssPos);
-        emit updatedGNSSPositionAndYaw(mVehicleState, QLineF(QPointF(lastXyz.x, lastXyz.y), gnssPos.getPoint()).length(), pvt.head_veh_valid);
-        emit txNavPvt(pvt);
+    // Yaw --- based on last GNSS position if fusion (F9R) unavailable
+    static xyz_t lastXyz;
+    if(pvt.head_veh_valid) {
+        double yaw_degENU = coordinateTransforms::yawNEDtoENU(pvt.head_veh) + mIMUOrientationOffset.yawOffset_deg;
 
+        // normalize to [-180.0:180.0[
+        while (yaw_degENU < -180.0)
+            yaw_degENU += 360.0;
+        while (yaw_degENU >= 180.0)
+            yaw_degENU -= 360.0;
 
-        lastXyz = xyz;
+        gnssPos.setYaw(yaw_degENU);
+    } else
+        gnssPos.setYaw(atan2(xyz.y - lastXyz.y, xyz.x - lastXyz.x) * 180.0 / M_PI);
+
+    // Time and speed
+    if (pvt.valid_date && pvt.valid_time)
+        gnssPos.setTimestamp_ns(utcTime::fromCalendar(pvt.year, pvt.month, pvt.day, pvt.hour, pvt.min, pvt.second, pvt.nano));
+    else { // fall back to reception time
+        const qint64 sinceReception_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() - pvt.rx_time_ns;
+        gnssPos.setTimestamp_ns(utcTime::now_ns() - sinceReception_ns);
     }
+    gnssPos.setSpeed(pvt.g_speed);
+    gnssPos.setSigma(pvt.h_acc);
+
+    // Fix type 1: dead reckoning only, 4: GNSS and dead reckoning, 5: time only
+    GnssFixType fixType;
+    if (pvt.fix_type == 1)
+        fixType = GnssFixType::DeadReckoning;
+    else if (!pvt.gnss_fix_ok || pvt.fix_type == 0 || pvt.fix_type == 5)
+        fixType = GnssFixType::NoFix;
+    else if (pvt.carr_soln == 2)
+        fixType = GnssFixType::RtkFixed;
+    else if (pvt.carr_soln == 1)
+        fixType = GnssFixType::RtkFloat;
+    else
+        fixType = (pvt.fix_type == 2) ? GnssFixType::Fix2D : GnssFixType::Fix3D;
+    gnssPos.setAttributes(quint32(fixType));
+
+    mLastNavPvtITow = pvt.i_tow;
+    mLastNavPvtTimestamp_ns = gnssPos.getTimestamp_ns();
+
+    mVehicleState->setPosition(gnssPos);
+    const double distanceMoved = QLineF(QPointF(lastXyz.x, lastXyz.y), gnssPos.getPoint()).length();
+    emit updatedGNSSPositionAndYaw(mVehicleState, distanceMoved, pvt.head_veh_valid);
+
+    GnssPositionMessage message;
+    message.vehicleId = mVehicleState->getId();
+    message.position = gnssPos.toPOD();
+    message.distanceMoved_m = distanceMoved;
+    message.fused = pvt.head_veh_valid;
+    sensorTopics::gnssPosition()->publish(message);
+    emit txNavPvt(pvt);
+
+
+    lastXyz = xyz;
+}
+
+void UbloxRover::updateGNSSHeading(const ubx_nav_relposned &relPosNed)
+{
+    // Heading needs a carrier-phase solution (float or fixed) of the baseline
+    if (!relPosNed.rel_pos_valid || !relPosNed.rel_pos_heading_valid || relPosNed.carr_soln == 0)
+        return;
+
+    const double yaw_degENU = coordinateTransforms::yawNEDtoENU(relPosNed.pos_heading - mBaselineYawOffset_deg);
+    const qint64 timestamp_ns = (relPosNed.i_tow == mLastNavPvtITow && mLastNavPvtTimestamp_ns != utcTime::INVALID) ?
+                mLastNavPvtTimestamp_ns : utcTime::now_ns();
+    emit updatedGNSSHeading(mVehicleState, yaw_degENU, relPosNed.acc_heading, timestamp_ns);
 }
 
 void UbloxRover::updSosResponse(const ubx_upd_sos &sos)
@@ -12,6 +12,8 @@
 #include <QSharedPointer>
 #include "ublox.h"
 #include "gnssreceiver.h"
+#include "gnsstimediscipline.h"
+#include "ubloxodometryfeeder.h"
 
 class UbloxRover : public GNSSReceiver
 {
@@ -19,13 +21,24 @@ class UbloxRover : public GNSSReceiver
 public:
     UbloxRover(QSharedPointer<VehicleState> vehicleState);
     bool connectSerial(const QSerialPortInfo &serialPortInfo);
+    void setDedicatedIoThread(bool enabled); // see Ublox::setDedicatedIoThread, set before connecting
     bool isSerialConnected();
     void writeRtcmToUblox(QByteArray data);
     void writeOdoToUblox(ubx_esf_datatype_enum dataType, uint32_t dataField);
+    // Wheel ticks for dead reckoning (F9R), batched and rate controlled, e.g., connected to MotorController::gotStatusValues
+    void writeTachometerToUblox(int tachometer, qint64 timestamp_ns) { mOdometryFeeder.addTachometer(tachometer, timestamp_ns); }
+    UbloxOdometryFeeder &getOdometryFeeder() { return mOdometryFeeder; }
     void saveOnShutdown();
+    // Dual-antenna heading from NAV-RELPOSNED, for a receiver that gets RTCM from a moving base (see UbloxMovingBasePair). Set before connecting.
+    // baselineYawOffset_deg: direction from the moving base's antenna to this one, clockwise from the vehicle's forward direction
+    void setDualAntennaHeading(bool enabled, double baselineYawOffset_deg = 0.0);
+    // Time pulse labels (TIM-TP, NAV-PVT) for the discipline, TIM-TP output is enabled. Set before connecting.
+    void setTimeDiscipline(QSharedPointer<GnssTimeDiscipline> timeDiscipline);
 
 signals:
     void updatedGNSSPositionAndYaw(QSharedPointer<VehicleState> vehicleState, double distanceMoved, bool fused);
+    // Vehicle yaw, e.g., for SDVPVehiclePositionFuser::correctYawGNSSHeading
+    void updatedGNSSHeading(QSharedPointer<VehicleState> vehicleState, double yaw_degENU, double yawStdDev_deg, qint64 timestamp_ns);
     void txNavPvt(const ubx_nav_pvt &pvt);
     void gotNmeaGga(const QByteArray& nmeaGgaStr);
 
@@ -33,9 +46,15 @@ private:
     bool configureUblox();
     void updSosResponse(const ubx_upd_sos &sos);
     void updateGNSSPositionAndYaw(const ubx_nav_pvt &pvt);
+    void updateGNSSHeading(const ubx_nav_relposned &relPosNed);
 
-    const int ms_per_day = 24 * 60 * 60 * 1000;
     Ublox mUblox;
+    UbloxOdometryFeeder mOdometryFeeder;
+    QSharedPointer<GnssTimeDiscipline> mTimeDiscipline;
+    bool mDualAntennaHeading = false;
+    double mBaselineYawOffset_deg = 0.0;
+    uint32_t mLastNavPvtITow = 0; // RELPOSNED of the same epoch gets its timestamp
+    qint64 mLastNavPvtTimestamp_ns = utcTime::INVALID;
 };
 
 #endif // UBLOXROVER_H
@@ -0,0 +1,66 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "i2cbusworker.h"
+
+I2CBusWorker &I2CBusWorker::getInstance()
+{
+    static I2CBusWorker instance;
+    return instance;
+}
+
+I2CBusWorker::I2CBusWorker()
+{
+    mThreadContext = new QObject();
+    mThread.setObjectName("I2C bus");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start();
+}
+
+I2CBusWorker::~I2CBusWorker()
+{
+    QMetaObject::invokeMethod(mThreadContext, [this]() {
+        qDeleteAll(mPollTimers);
+        mPollTimers.clear();
+    }, Qt::BlockingQueuedConnection);
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+}
+
+int I2CBusWorker::addPoll(int intervall_ms, std::function<void()> read)
+{
+    const int pollId = mNextPollId++;
+    QMetaObject::invokeMethod(mThreadContext, [this, pollId, intervall_ms, read]() {
+        QTimer *pollTimer = new QTimer(mThreadContext);
+        pollTimer->setTimerType(getTimerType(intervall_ms));
+        QObject::connect(pollTimer, &QTimer::timeout, read);
+        pollTimer->start(intervall_ms);
+        mPollTimers[pollId] = pollTimer;
+    }, Qt::QueuedConnection);
+
+    return pollId;
+}
+
+void I2CBusWorker::setPollIntervall(int pollId, int intervall_ms)
+{
+    QMetaObject::invokeMethod(mThreadContext, [this, pollId, intervall_ms]() {
+        if (mPollTimers.contains(pollId)) {
+            mPollTimers[pollId]->setTimerType(getTimerType(intervall_ms));
+            mPollTimers[pollId]->start(intervall_ms);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void I2CBusWorker::removePoll(int pollId)
+{
+    auto remove = [this, pollId]() {
+        delete mPollTimers.take(pollId);
+    };
+
+    if (QThread::currentThread() == &mThread)
+        remove();
+    else
+        QMetaObject::invokeMethod(mThreadContext, remove, Qt::BlockingQueuedConnection);
+}
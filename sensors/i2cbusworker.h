@@ -0,0 +1,52 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Shared worker thread for polling I2C sensors, so that blocking bus transfers do not stall the Qt event loop.
+ * Sensors register periodic read functions, which are run (serialized) on the I2C thread. Results are published back
+ * to the sensor's thread via publish(), i.e., asynchronously and dropped if the sensor was deleted in the meantime.
+ */
+
+#ifndef I2CBUSWORKER_H
+#define I2CBUSWORKER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QHash>
+#include <atomic>
+#include <functional>
+
+class I2CBusWorker
+{
+public:
+    static I2CBusWorker &getInstance();
+    ~I2CBusWorker();
+
+    // Calls read every intervall_ms on the I2C thread, returns the poll's id
+    int addPoll(int intervall_ms, std::function<void()> read);
+    void setPollIntervall(int pollId, int intervall_ms);
+    // Blocks until a read in progress is done, i.e., read may refer to the caller afterwards no longer
+    void removePoll(int pollId);
+
+    // Runs function on context's thread (to be called from read functions)
+    template<typename Function>
+    static void publish(QObject *context, Function function) {
+        QMetaObject::invokeMethod(context, function, Qt::QueuedConnection);
+    }
+
+private:
+    I2CBusWorker();
+    I2CBusWorker(const I2CBusWorker &) = delete;
+    I2CBusWorker &operator=(const I2CBusWorker &) = delete;
+    // Coarse timers may fire up to 5% early or late, too much for high-rate sampling
+    static Qt::TimerType getTimerType(int intervall_ms) { return intervall_ms < PRECISE_TIMER_LIMIT_MS ? Qt::PreciseTimer : Qt::CoarseTimer; }
+    static constexpr int PRECISE_TIMER_LIMIT_MS = 20;
+
+    QThread mThread;
+    QObject *mThreadContext; // lives on mThread, parent of the poll timers
+    QHash<int, QTimer*> mPollTimers; // only accessed on mThread
+    std::atomic<int> mNextPollId{0};
+};
+
+#endif // I2CBUSWORKER_H
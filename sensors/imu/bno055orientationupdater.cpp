@@ -19,28 +19,30 @@ BNO055OrientationUpdater::BNO055OrientationUpdater(QSharedPointer<VehicleState>
         opmode_t newmode = imu;
         res = set_mode(newmode);
 
-        connect(&mPollTimer, &QTimer::timeout, [this]() {
-            static struct bnoeul bnod;
+        // euler angles are read in one burst (6 bytes) on the I2C thread
+        mPollId = I2CBusWorker::getInstance().addPoll(mPollIntervall_ms, [this]() {
+            struct bnoeul bnod;
             int res = get_eul(&bnod);
             if (res != 0) {
                 qDebug() << "WARNING: BNO055OrientationUpdater cannot read orientation data from i2c bus.";
             } else {
                 // qDebug() << "Roll:" << bnod.eul_roll << "Pitch:" << bnod.eul_pitc << "Yaw:" << bnod.eul_head;
-                QSharedPointer<VehicleState> vehicleState = getVehicleState();
-                PosPoint currIMUPos = vehicleState->getPosition(PosType::IMU);
-
-                currIMUPos.setRollPitchYaw(bnod.eul_roll, bnod.eul_pitc, coordinateTransforms::yawNEDtoENU(bnod.eul_head));
-                currIMUPos.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
-                vehicleState->setPosition(currIMUPos);
-
-                emit updatedIMUOrientation(vehicleState);
+                const qint64 timestamp_ns = utcTime::now_ns();
+                I2CBusWorker::publish(this, [this, bnod, timestamp_ns]() {
+                    inputIMUSample(bnod.eul_roll, bnod.eul_pitc, coordinateTransforms::yawNEDtoENU(bnod.eul_head), timestamp_ns);
+                });
             }
         });
-        mPollTimer.start(mPollIntervall_ms);
     } else
         qDebug() << "WARNING: BNO055OrientationUpdater is unable to open i2c bus" << i2cBus << ". Disabled.";
 }
 
+BNO055OrientationUpdater::~BNO055OrientationUpdater()
+{
+    if (mPollId >= 0)
+        I2CBusWorker::getInstance().removePoll(mPollId);
+}
+
 void BNO055OrientationUpdater::printBNO055Info()
 {
     struct bnoinf bnoi;
@@ -136,7 +138,8 @@ void BNO055OrientationUpdater::printBNO055Info()
 bool BNO055OrientationUpdater::setUpdateIntervall(int pollIntervall_ms)
 {
     mPollIntervall_ms = pollIntervall_ms;
-    mPollTimer.start(mPollIntervall_ms);
+    if (mPollId >= 0)
+        I2CBusWorker::getInstance().setPollIntervall(mPollId, mPollIntervall_ms);
 
     return true;
 }
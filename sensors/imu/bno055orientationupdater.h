@@ -12,13 +12,14 @@
 extern "C" {
 #include "external/pi-bno055/getbno055.h"
 }
-#include <QTimer>
+#include "sensors/i2cbusworker.h"
 
-// connects to BNO055 via i2c bus and polls orientation data (euler angles) periodically
+// connects to BNO055 via i2c bus and polls orientation data (euler angles) periodically on the I2C bus worker
 class BNO055OrientationUpdater : public IMUOrientationUpdater
 {
 public:
     BNO055OrientationUpdater(QSharedPointer<VehicleState> vehicleState, QString i2cBus = "/dev/i2c-1");
+    ~BNO055OrientationUpdater();
     void printBNO055Info();
 
     virtual bool setUpdateIntervall(int pollIntervall_ms) override;
@@ -26,7 +27,7 @@ public:
 private:
     const QString mBNO055I2CAddress = "0x28";
     int mPollIntervall_ms = 20;
-    QTimer mPollTimer;
+    int mPollId = -1;
 };
 
 #endif // BNO055ORIENTATIONUPDATER_H
@@ -3,13 +3,92 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "imuorientationupdater.h"
+#include "sensors/sensortopics.h"
 
 IMUOrientationUpdater::IMUOrientationUpdater(QSharedPointer<VehicleState> vehicleState)
 {
     mVehicleState = vehicleState;
+
+    connect(&mBatchTimer, &QTimer::timeout, this, &IMUOrientationUpdater::deliverBatch);
 }
 
 QSharedPointer<VehicleState> IMUOrientationUpdater::getVehicleState() const
 {
     return mVehicleState;
 }
+
+void IMUOrientationUpdater::setBatchIntervall(int batchIntervall_ms)
+{
+    mBatchIntervall_ms = batchIntervall_ms;
+
+    if (mBatchIntervall_ms > 0)
+        mBatchTimer.start(mBatchIntervall_ms);
+    else {
+        mBatchTimer.stop();
+        deliverBatch();
+    }
+}
+
+void IMUOrientationUpdater::inputIMUSample(double roll_deg, double pitch_deg, double yaw_degENU, qint64 timestamp_ns)
+{
+    ImuOrientationMessage message;
+    message.vehicleId = mVehicleState->getId();
+    message.roll_deg = roll_deg;
+    message.pitch_deg = pitch_deg;
+    message.yaw_degENU = yaw_degENU;
+    message.timestamp_ns = timestamp_ns;
+    sensorTopics::imuOrientation()->publish(message);
+
+    if (mBatchIntervall_ms <= 0) {
+        PosPoint currIMUPos = mVehicleState->getPosition(PosType::IMU);
+
+        currIMUPos.setRollPitchYaw(roll_deg, pitch_deg, yaw_degENU);
+        currIMUPos.setTimestamp_ns(timestamp_ns);
+        mVehicleState->setPosition(currIMUPos);
+
+        emit updatedIMUOrientation(mVehicleState);
+        return;
+    }
+
+    mBatch[mBatchSize++] = {roll_deg, pitch_deg, yaw_degENU, timestamp_ns};
+    if (mBatchSize == BATCH_CAPACITY)
+        deliverBatch();
+}
+
+void IMUOrientationUpdater::deliverBatch()
+{
+    if (mBatchSize == 0)
+        return;
+
+    // Integrate yaw change from the last delivered sample (or first sample of the first batch)
+    IMUSample previous = utcTime::isValid(mLastDeliveredSample.timestamp_ns) ? mLastDeliveredSample : mBatch[0];
+    const qint64 startTimestamp_ns = previous.timestamp_ns;
+    IMUBatchSummary summary;
+    for (int i = 0; i < mBatchSize; i++) {
+        double yawDiff = mBatch[i].yaw_degENU - previous.yaw_degENU;
+        while (yawDiff < -180.0) yawDiff += 360.0;
+        while (yawDiff > 180.0) yawDiff -= 360.0;
+
+        summary.yawChange_deg += yawDiff;
+        summary.meanRoll_deg += mBatch[i].roll_deg;
+        summary.meanPitch_deg += mBatch[i].pitch_deg;
+        previous = mBatch[i];
+    }
+    summary.sampleCount = mBatchSize;
+    summary.meanRoll_deg /= mBatchSize;
+    summary.meanPitch_deg /= mBatchSize;
+    const qint64 duration_ns = previous.timestamp_ns - startTimestamp_ns;
+    summary.meanYawRate_degps = (duration_ns > 0) ? summary.yawChange_deg / (duration_ns / 1e9) : 0.0;
+
+    mLastBatchSummary = summary;
+    mLastDeliveredSample = previous;
+    mBatchSize = 0;
+
+    // Newest yaw (yaw is used as relative orientation), mean roll and pitch
+    PosPoint currIMUPos = mVehicleState->getPosition(PosType::IMU);
+    currIMUPos.setRollPitchYaw(summary.meanRoll_deg, summary.meanPitch_deg, previous.yaw_degENU);
+    currIMUPos.setTimestamp_ns(previous.timestamp_ns);
+    mVehicleState->setPosition(currIMUPos);
+
+    emit updatedIMUOrientation(mVehicleState);
+}
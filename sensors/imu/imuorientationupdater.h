@@ -10,8 +10,19 @@
 
 #include <QObject>
 #include <QSharedPointer>
+#include <QTimer>
+#include <array>
 #include "vehicles/vehiclestate.h"
 
+// Summary of the IMU samples delivered by one updatedIMUOrientation in batched mode
+struct IMUBatchSummary {
+    int sampleCount = 0;
+    double meanRoll_deg = 0.0;
+    double meanPitch_deg = 0.0;
+    double yawChange_deg = 0.0; // integrated (unwrapped) since the previous batch
+    double meanYawRate_degps = 0.0;
+};
+
 class IMUOrientationUpdater : public QObject
 {
     Q_OBJECT
@@ -20,13 +31,37 @@ public:
     QSharedPointer<VehicleState> getVehicleState() const;
     virtual bool setUpdateIntervall(int intervall_ms) = 0;
 
+    // Batched mode: accumulate samples and update PosType::IMU/emit updatedIMUOrientation only every interval (0: per sample)
+    int getBatchIntervall() const { return mBatchIntervall_ms; }
+    void setBatchIntervall(int batchIntervall_ms);
+    IMUBatchSummary getLastBatchSummary() const { return mLastBatchSummary; }
 
 signals:
     void updatedIMUOrientation(QSharedPointer<VehicleState> vehicleState);
 
+protected:
+    // To be called by implementations for each new sample
+    void inputIMUSample(double roll_deg, double pitch_deg, double yaw_degENU, qint64 timestamp_ns);
+
 private:
+    struct IMUSample {
+        double roll_deg;
+        double pitch_deg;
+        double yaw_degENU;
+        qint64 timestamp_ns;
+    };
+
+    void deliverBatch();
+
     QSharedPointer<VehicleState> mVehicleState; // vehicle which's PosType::IMU is periodically updated
 
+    static constexpr int BATCH_CAPACITY = 64; // delivered early when full
+    std::array<IMUSample, BATCH_CAPACITY> mBatch;
+    int mBatchSize = 0;
+    int mBatchIntervall_ms = 0;
+    QTimer mBatchTimer;
+    IMUSample mLastDeliveredSample = {0.0, 0.0, 0.0, utcTime::INVALID};
+    IMUBatchSummary mLastBatchSummary;
 };
 
 #endif // IMUORIENTATIONUPDATER_H
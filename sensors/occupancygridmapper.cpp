@@ -0,0 +1,58 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "occupancygridmapper.h"
+#include <cmath>
+
+OccupancyGridMapper::OccupancyGridMapper(QSharedPointer<VehicleState> vehicleState, QSharedPointer<OccupancyGrid> occupancyGrid, PosType posType)
+    : mVehicleState(vehicleState), mOccupancyGrid(occupancyGrid), mPosType(posType)
+{
+}
+
+void OccupancyGridMapper::setToFSensor(QSharedPointer<ToFSensor> tofSensor, const SensorMount &mount, double maxRange_m)
+{
+    if (mToFSensor)
+        disconnect(mToFSensor.get(), nullptr, this, nullptr);
+
+    mToFSensor = tofSensor;
+    if (mToFSensor)
+        connect(mToFSensor.get(), &ToFSensor::updatedRange, this, [this, mount, maxRange_m](double distance_m, qint64 timestamp_ns) {
+            insertRange(mount, distance_m, timestamp_ns, maxRange_m);
+        });
+}
+
+void OccupancyGridMapper::insertRange(const SensorMount &mount, double distance_m, qint64 timestamp_ns, double maxRange_m)
+{
+    const PosPoint pose = getPoseAt(timestamp_ns);
+    const bool hasObject = distance_m > 0.0 && distance_m <= maxRange_m;
+    const double range_m = hasObject ? distance_m : maxRange_m;
+    const QPointF origin = toENU(pose, mount.x, mount.y);
+    const QPointF end = toENU(pose, mount.x + range_m * cos(mount.yaw_rad), mount.y + range_m * sin(mount.yaw_rad));
+    mOccupancyGrid->insertRay(origin, end, hasObject, timestamp_ns);
+}
+
+void OccupancyGridMapper::insertCameraDetections(const QVector<PosPoint> &detectedObjects)
+{
+    if (detectedObjects.isEmpty())
+        return;
+
+    const qint64 timestamp_ns = detectedObjects.first().getTimestamp_ns();
+    const PosPoint pose = getPoseAt(timestamp_ns);
+    const QPointF origin = toENU(pose, mCameraMount.x, mCameraMount.y);
+    for (const PosPoint &detectedObject : detectedObjects)
+        mOccupancyGrid->insertRay(origin, toENU(pose, detectedObject.getX(), detectedObject.getY()), true, timestamp_ns);
+}
+
+PosPoint OccupancyGridMapper::getPoseAt(qint64 timestamp_ns)
+{
+    const PosPoint pose = utcTime::isValid(timestamp_ns) ? mVehicleState->getPosition(mPosType, timestamp_ns) : mVehicleState->getPosition(mPosType);
+    mOccupancyGrid->setCenter(mVehicleState->getPosition(mPosType).getPoint());
+    return pose;
+}
+
+QPointF OccupancyGridMapper::toENU(const PosPoint &pose, double x, double y)
+{
+    const double yaw_rad = pose.getYaw() * M_PI / 180.0;
+    return QPointF(pose.getX() + x * cos(yaw_rad) - y * sin(yaw_rad), pose.getY() + x * sin(yaw_rad) + y * cos(yaw_rad));
+}
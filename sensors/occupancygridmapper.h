@@ -0,0 +1,59 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Integrates range sensors (e.g., VL53L0XToFSensor) and camera detections (e.g., DepthAiCamera::detectedObjects) into an
+ * OccupancyGrid. Measurements are placed with the vehicle's pose at their timestamp (VehicleState's position history) and
+ * the grid is kept centered on the vehicle. Ranges clear the cells up to the range and mark the cell at the range as occupied
+ * (cleared up to the maximum range if out of range), detections clear the line of sight from the camera to the object.
+ */
+
+#ifndef OCCUPANCYGRIDMAPPER_H
+#define OCCUPANCYGRIDMAPPER_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+#include "core/occupancygrid.h"
+#include "vehicles/vehiclestate.h"
+#include "sensors/tof/tofsensor.h"
+
+class OccupancyGridMapper : public QObject
+{
+    Q_OBJECT
+public:
+    // Sensor position and orientation in the vehicle frame (x forward, y left)
+    struct SensorMount {
+        double x = 0.0; // [m]
+        double y = 0.0; // [m]
+        double yaw_rad = 0.0;
+    };
+
+    static constexpr double TOF_MAX_RANGE_m = 2.0; // VL53L0X, larger values mean out of range
+
+    OccupancyGridMapper(QSharedPointer<VehicleState> vehicleState, QSharedPointer<OccupancyGrid> occupancyGrid, PosType posType = PosType::fused);
+
+    QSharedPointer<OccupancyGrid> getOccupancyGrid() const { return mOccupancyGrid; }
+    // Uses ToFSensor::updatedRange
+    void setToFSensor(QSharedPointer<ToFSensor> tofSensor, const SensorMount &mount = SensorMount(), double maxRange_m = TOF_MAX_RANGE_m);
+    void setCameraMount(const SensorMount &cameraMount) { mCameraMount = cameraMount; }
+
+public slots:
+    // Range along the sensor's x axis, <= 0 or beyond maxRange_m: no object within maxRange_m
+    void insertRange(const OccupancyGridMapper::SensorMount &mount, double distance_m, qint64 timestamp_ns, double maxRange_m);
+    // All objects of a camera frame in the vehicle frame, e.g., connected to DepthAiCamera::detectedObjects
+    void insertCameraDetections(const QVector<PosPoint> &detectedObjects);
+
+private:
+    // Vehicle pose at the measurement, also recenters the grid
+    PosPoint getPoseAt(qint64 timestamp_ns);
+    static QPointF toENU(const PosPoint &pose, double x, double y);
+
+    QSharedPointer<VehicleState> mVehicleState;
+    QSharedPointer<OccupancyGrid> mOccupancyGrid;
+    PosType mPosType;
+    QSharedPointer<ToFSensor> mToFSensor;
+    SensorMount mCameraMount;
+};
+
+#endif // OCCUPANCYGRIDMAPPER_H
@@ -0,0 +1,58 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * TopicBus topics and messages of the sensors, published next to their (VehicleState based) signals: UbloxRover (GNSS),
+ * the movement controllers (odometry) and IMUOrientationUpdater (every IMU sample, also in batched mode).
+ * Messages carry the values of the sample, i.e., subscribers do not need to read them back from the VehicleState.
+ */
+
+#ifndef SENSORTOPICS_H
+#define SENSORTOPICS_H
+
+#include "core/topicbus.h"
+#include "core/pospoint.h"
+
+struct GnssPositionMessage {
+    int vehicleId = 0;
+    pospoint_t position; // PosType::GNSS incl. antenna offset, sigma: horizontal accuracy, attributes: GnssFixType
+    double distanceMoved_m = 0.0; // since the previous position
+    bool fused = false; // yaw from the receiver's sensor fusion, not from the movement
+};
+
+struct OdomPositionMessage {
+    int vehicleId = 0;
+    pospoint_t position; // PosType::odom
+    double distanceDriven_m = 0.0; // since the previous sample
+    qint64 dt_ns = 0; // since the previous sample, 0: first
+};
+
+struct ImuOrientationMessage {
+    int vehicleId = 0;
+    double roll_deg = 0.0;
+    double pitch_deg = 0.0;
+    double yaw_degENU = 0.0;
+    qint64 timestamp_ns = 0; // UTC
+};
+
+namespace sensorTopics {
+inline Topic<GnssPositionMessage> *gnssPosition()
+{
+    static Topic<GnssPositionMessage> *const topic = TopicBus::getInstance().getTopic<GnssPositionMessage>("sensors/gnss/position");
+    return topic;
+}
+
+inline Topic<OdomPositionMessage> *odomPosition()
+{
+    static Topic<OdomPositionMessage> *const topic = TopicBus::getInstance().getTopic<OdomPositionMessage>("sensors/odom/position");
+    return topic;
+}
+
+inline Topic<ImuOrientationMessage> *imuOrientation()
+{
+    static Topic<ImuOrientationMessage> *const topic = TopicBus::getInstance().getTopic<ImuOrientationMessage>("sensors/imu/orientation");
+    return topic;
+}
+}
+
+#endif // SENSORTOPICS_H
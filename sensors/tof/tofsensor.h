@@ -19,7 +19,8 @@ public:
 
 
 signals:
-    void updatedDistance(double distance_m);
+    void updatedDistance(double distance_m); // negative: no valid range
+    void updatedRange(double distance_m, qint64 timestamp_ns); // same, timestamped at measurement (UTC, see utcTime)
 
 protected:
     double mLastDistance = 0;
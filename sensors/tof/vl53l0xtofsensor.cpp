@@ -3,6 +3,7 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "vl53l0xtofsensor.h"
+#include "core/utctime.h"
 #include <cmath>
 #include <QDebug>
 
@@ -20,24 +21,56 @@ VL53L0XToFSensor::VL53L0XToFSensor()
         tofGetModel(&model, &revision);
         qDebug() << "VL53L0X" << "Model ID - "<< model<< "Revision ID -" << revision << "successfully opened.";
 
-        connect(&mPollTimer, &QTimer::timeout, [this]() {
-            int iDistance_mm = tofReadDistance();
-            if (iDistance_mm < 4096) { // valid range?
-                //qDebug() <<  "Object Distance to trailer = " <<  iDistance << "mm";
-                mLastDistance = iDistance_mm / 1000.0;
-            } else
-                mLastDistance = -1.0;
-
-            emit updatedDistance(mLastDistance);
-        });
-        mPollTimer.start(mPollIntervall_ms); // call back (poll) every mPollIntervall_ms e.g., 50 ms
+        // Continuous ranging is started (and restarted on period changes) from the poll, all bus transfers run on the I2C thread
+        mPollId = I2CBusWorker::getInstance().addPoll(RANGE_POLL_INTERVALL_MS, [this]() { readRange(); });
     }
 }
 
-bool VL53L0XToFSensor::setUpdateIntervall(int pollIntervall_ms)
+VL53L0XToFSensor::~VL53L0XToFSensor()
 {
-   mPollIntervall_ms = pollIntervall_ms;
-   mPollTimer.start(mPollIntervall_ms);
+    if (mPollId >= 0) {
+        I2CBusWorker::getInstance().removePoll(mPollId);
+        tofStopContinuous();
+    }
+}
+
+bool VL53L0XToFSensor::setUpdateIntervall(int rangingPeriod_ms)
+{
+    if (rangingPeriod_ms <= 0)
+        return false;
+
+    mRangingPeriod_ms = rangingPeriod_ms;
+    return true;
+}
+
+void VL53L0XToFSensor::readRange()
+{
+    const int rangingPeriod_ms = mRangingPeriod_ms;
+    if (rangingPeriod_ms != mActiveRangingPeriod_ms) {
+        if (mActiveRangingPeriod_ms > 0)
+            tofStopContinuous();
+        if (tofStartContinuous(rangingPeriod_ms) != 1) {
+            qDebug() << "Warning: VL53L0XToFSensor failed to start continuous ranging.";
+            return;
+        }
+        mActiveRangingPeriod_ms = rangingPeriod_ms;
+        mRangeFilter.clear();
+    }
+
+    const int range_mm = tofReadContinuousDistance();
+    if (range_mm == -2) // not ranged yet
+        return;
+
+    const qint64 timestamp_ns = utcTime::now_ns();
+    const int filteredRange_mm = mRangeFilter.add((range_mm >= 0 && range_mm < MAX_VALID_RANGE_MM) ? range_mm : MAX_VALID_RANGE_MM);
+
+    I2CBusWorker::publish(this, [this, filteredRange_mm, timestamp_ns]() {
+        if (filteredRange_mm < MAX_VALID_RANGE_MM) // valid range?
+            mLastDistance = filteredRange_mm / 1000.0;
+        else
+            mLastDistance = -1.0;
 
-   return true;
+        emit updatedDistance(mLastDistance);
+        emit updatedRange(mLastDistance, timestamp_ns);
+    });
 }
@@ -8,19 +8,33 @@
 #ifndef VL53L0XTOFSENSOR_H
 #define VL53L0XTOFSENSOR_H
 
+#include <atomic>
 #include "sensors/tof/tofsensor.h"
-#include <QTimer>
+#include "sensors/i2cbusworker.h"
+#include "core/medianfilter.h"
 
-// connects to VL53L0X via i2c bus and polls distance values periodically
+// Connects to VL53L0X via i2c bus, which ranges continuously (timed mode). New ranges are picked up by a short, non-blocking
+// poll on the I2C bus worker, i.e., at most RANGE_POLL_INTERVALL_MS after the sensor has them, timestamped and median filtered
+// there. The update intervall is the ranging period.
 class VL53L0XToFSensor : public ToFSensor
 {
 public:
+    static constexpr int DEFAULT_RANGING_PERIOD_MS = 35; // just above the default timing budget (33 ms)
+    static constexpr int RANGE_POLL_INTERVALL_MS = 5;
+    static constexpr int MEDIAN_WINDOW = 5; // ranges, delay of the filtered range is (MEDIAN_WINDOW - 1) / 2 ranging periods for steps
+    static constexpr int MAX_VALID_RANGE_MM = 4096;
+
     VL53L0XToFSensor();
-    virtual bool setUpdateIntervall(int pollIntervall_ms) override;
+    ~VL53L0XToFSensor();
+    virtual bool setUpdateIntervall(int rangingPeriod_ms) override;
 
 private:
-    int mPollIntervall_ms = 500;
-    QTimer mPollTimer;
+    void readRange(); // I2C thread
+
+    std::atomic<int> mRangingPeriod_ms{DEFAULT_RANGING_PERIOD_MS};
+    int mActiveRangingPeriod_ms = 0; // I2C thread, 0: not ranging
+    MedianFilter<int, MEDIAN_WINDOW> mRangeFilter; // I2C thread, [mm], invalid ranges as MAX_VALID_RANGE_MM
+    int mPollId = -1;
 };
 
 #endif // VL53L0XTOFSENSOR_H
@@ -10,64 +10,90 @@ PozyxPositionUpdater::PozyxPositionUpdater(QSharedPointer<VehicleState> vehicleS
 {
     mVehicleState = vehicleState;
 
-    connect(&mSerialPort, &QSerialPort::readyRead, [&]() {
-        while (mSerialPort.canReadLine()) {
-            QString receivedString(mSerialPort.readLine());
-
-            // get raw data from result string (format: D,%data%\r)
-            QString receivedData = receivedString.split(',').last().trimmed();
-//            qDebug() << receivedData;
-
-            static double heading = 0;
-            static double xyz[3] = {0,0,0};
-            if (receivedData.length() == 4) { // POZYX_EUL_HEADING
-                heading = qFromBigEndian((int16_t) receivedData.toUInt(nullptr, 16)) / 16.0;
-            } else if (receivedData.length() == 24) { // POZYX_POS_XYZ
-                xyz[0] = qFromBigEndian((int32_t) receivedData.mid( 0,8).toUInt(nullptr, 16)) / 1000.0;
-                xyz[1] = qFromBigEndian((int32_t) receivedData.mid( 8,8).toUInt(nullptr, 16)) / 1000.0;
-                xyz[2] = qFromBigEndian((int32_t) receivedData.mid(16,8).toUInt(nullptr, 16)) / 1000.0;
-
-                // Trigger new positioning
-                QString pollPozyxStr;
-                pollPozyxStr.sprintf("F,%.2x,,1\r", POZYX_DO_POSITIONING);
-                mSerialPort.write(pollPozyxStr.toLatin1());
-                mSerialPort.flush();
-            } else if (receivedData.length() == 2) { // POZYX_DO_POSITIONING
-                if (receivedData.compare("01") != 0)
-                    qDebug() << "Warning: PozyxPositionUpdater could not trigger position update.";
-            } else
-                qDebug() << "Warning: PozyxPositionUpdater could not parse incoming data.";
-
-//            qDebug() /*<< result*/ << heading << xyz[0] << xyz[1] << xyz[2];
-
-            PosPoint currUWBpos = mVehicleState->getPosition(PosType::UWB);
-            currUWBpos.setX(xyz[0]);
-            currUWBpos.setY(xyz[1]);
-            currUWBpos.setHeight(xyz[2]);
-            currUWBpos.setYaw(heading);
-            currUWBpos.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
-            mVehicleState->setPosition(currUWBpos);
-        }
+    connect(&mSerialPort, &QSerialPort::readyRead, this, &PozyxPositionUpdater::readReplies);
 
-        emit updatedUWBPositionAndYaw(mVehicleState);
+    mReplyTimeoutTimer.setSingleShot(true);
+    connect(&mReplyTimeoutTimer, &QTimer::timeout, this, [this]() {
+        qDebug() << "Warning: PozyxPositionUpdater got no reply in time, restarting positioning.";
+        mSerialPort.clear(QSerialPort::Input);
+        sendRequest(Request::DoPositioning);
     });
+}
 
-    connect(&mPollPositionTimer, &QTimer::timeout, this, [this](){
-        QString pollPozyxStr;
-        static int i = 0;
+void PozyxPositionUpdater::readReplies()
+{
+    while (mSerialPort.canReadLine()) {
+        QString receivedString(mSerialPort.readLine());
 
-        pollPozyxStr.sprintf("R,%.2x,%i\r", POZYX_EUL_HEADING, POZYX_EUL_HEADING_size);
-        mSerialPort.write(pollPozyxStr.toLatin1());
-        mSerialPort.flush();
+        // get raw data from result string (format: D,%data%\r)
+        handleReply(receivedString.split(',').last().trimmed());
+    }
+}
 
-        // poll position every POLL_HEADINGS_PER_POSITIONth time
-        if (i == 0) {
-            pollPozyxStr.sprintf("R,%.2x,%i\r", POZYX_POS_XYZ, POZYX_POS_XYZ_size);
-            mSerialPort.write(pollPozyxStr.toLatin1());
-            mSerialPort.flush();
+void PozyxPositionUpdater::handleReply(const QString &receivedData)
+{
+    switch (mPendingRequest) {
+    case Request::DoPositioning:
+        if (receivedData.length() != 2 || receivedData.compare("01") != 0) {
+            qDebug() << "Warning: PozyxPositionUpdater could not trigger position update.";
+            sendRequest(Request::DoPositioning);
+            return;
         }
-        i = (i + 1) % POLL_HEADINGS_PER_POSITION;
-    });
+        mPositioningTimestamp_ns = utcTime::now_ns();
+        sendRequest(Request::Heading);
+        break;
+
+    case Request::Heading:
+        if (receivedData.length() != 4) {
+            qDebug() << "Warning: PozyxPositionUpdater could not parse incoming data.";
+            sendRequest(Request::DoPositioning);
+            return;
+        }
+        mHeading = qFromBigEndian((int16_t) receivedData.toUInt(nullptr, 16)) / 16.0;
+        sendRequest(Request::Position);
+        break;
+
+    case Request::Position: {
+        if (receivedData.length() != 24) {
+            qDebug() << "Warning: PozyxPositionUpdater could not parse incoming data.";
+            sendRequest(Request::DoPositioning);
+            return;
+        }
+        // Trigger new positioning right away, it runs while the position is processed
+        sendRequest(Request::DoPositioning);
+
+        mVehicleState->updatePosition(PosType::UWB, [this, &receivedData](PosPoint &currUWBpos) {
+            currUWBpos.setX(qFromBigEndian((int32_t) receivedData.mid( 0,8).toUInt(nullptr, 16)) / 1000.0);
+            currUWBpos.setY(qFromBigEndian((int32_t) receivedData.mid( 8,8).toUInt(nullptr, 16)) / 1000.0);
+            currUWBpos.setHeight(qFromBigEndian((int32_t) receivedData.mid(16,8).toUInt(nullptr, 16)) / 1000.0);
+            currUWBpos.setYaw(mHeading);
+            currUWBpos.setTimestamp_ns(mPositioningTimestamp_ns);
+        });
+
+        emit updatedUWBPositionAndYaw(mVehicleState);
+        break;
+    }
+
+    case Request::None:
+        qDebug() << "Warning: PozyxPositionUpdater got unexpected data.";
+        break;
+    }
+}
+
+void PozyxPositionUpdater::sendRequest(Request request)
+{
+    QString requestStr;
+    switch (request) {
+    case Request::DoPositioning: requestStr.sprintf("F,%.2x,,1\r", POZYX_DO_POSITIONING); break;
+    case Request::Heading: requestStr.sprintf("R,%.2x,%i\r", POZYX_EUL_HEADING, POZYX_EUL_HEADING_size); break;
+    case Request::Position: requestStr.sprintf("R,%.2x,%i\r", POZYX_POS_XYZ, POZYX_POS_XYZ_size); break;
+    case Request::None: return;
+    }
+
+    mPendingRequest = request;
+    mSerialPort.write(requestStr.toLatin1());
+    mSerialPort.flush();
+    mReplyTimeoutTimer.start(REPLY_TIMEOUT_MS);
 }
 
 bool PozyxPositionUpdater::connectSerial(const QSerialPortInfo &serialPortInfo)
@@ -87,8 +113,9 @@ bool PozyxPositionUpdater::connectSerial(const QSerialPortInfo &serialPortInfo)
     mSerialPort.setDataBits(QSerialPort::DataBits::Data8);
     mSerialPort.setParity(QSerialPort::Parity::NoParity);
     mSerialPort.setStopBits(QSerialPort::StopBits::OneStop);
+    serialPortOptions::apply(mSerialPort, mSerialPortOptions);
 
-    mPollPositionTimer.start(25);
+    sendRequest(Request::DoPositioning);
 
     return true;
 }
@@ -6,6 +6,8 @@
  * Requires that anchors and coordinate system are setup using their tools:
  * https://docs.pozyx.io/creator/
  * Then, the tag's position can be read from the tag itself using this class.
+ * Requests are chained on the replies (positioning, heading, position, repeat) instead of being polled by a timer,
+ * i.e., a new position is read as soon as the tag has one. A timeout restarts the chain if a reply is lost.
  */
 
 #ifndef POZYXPOSITIONUPDATER_H
@@ -14,6 +16,7 @@
 #include <QObject>
 #include <QSerialPort>
 #include <QSerialPortInfo>
+#include "core/serialportoptions.h"
 #include <QTimer>
 #include <QSharedPointer>
 #include "vehicles/vehiclestate.h"
@@ -25,6 +28,7 @@ public:
     explicit PozyxPositionUpdater(QSharedPointer<VehicleState> vehicleState);
 
 
+    void setSerialPortOptions(const SerialPortOptions &options) { mSerialPortOptions = options; } // applied when connecting
     bool connectSerial(const QSerialPortInfo &serialPortInfo);
     bool isSerialConnected();
 
@@ -32,15 +36,25 @@ signals:
     void updatedUWBPositionAndYaw(QSharedPointer<VehicleState> vehicleState);
 
 private:
+    enum class Request {None, DoPositioning, Heading, Position};
+
+    void readReplies();
+    void handleReply(const QString &receivedData);
+    void sendRequest(Request request);
+
     const int POZYX_POS_XYZ = 0x30;         // x,y,z-coordinates [mm]
     const int POZYX_POS_XYZ_size = 12;      //  reply size in bytes
     const int POZYX_EUL_HEADING = 0x66;     // Euler angles of yaw
     const int POZYX_EUL_HEADING_size = 2;   // reply size in bytes
     const int POZYX_DO_POSITIONING = 0xB6;  // Initiate positioning process
+    static constexpr int REPLY_TIMEOUT_MS = 200;
 
     QSerialPort mSerialPort;
-    QTimer mPollPositionTimer;
-    const int POLL_HEADINGS_PER_POSITION = 2;
+    SerialPortOptions mSerialPortOptions;
+    QTimer mReplyTimeoutTimer;
+    Request mPendingRequest = Request::None;
+    double mHeading = 0.0;
+    qint64 mPositioningTimestamp_ns = utcTime::INVALID; // when the position that is read next was determined
     QSharedPointer<VehicleState> mVehicleState;
 
 };
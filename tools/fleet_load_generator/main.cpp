@@ -0,0 +1,81 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Emulates many WayWise vehicles from one process towards a control station (see MavlinkFleetEmulator), e.g., to find the
+ * fleet size at which ControlTower stops keeping up (together with MavsdkStation::setBenchmarkInterval_ms):
+ *   fleet_load_generator --vehicles 10 --ramp 10 --ramp-interval 30 --max-vehicles 200
+ * Prints the load sent as CSV once per second: time [s], vehicles, messages/s, bytes/s, received messages, uploaded missions.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <cstdio>
+#include "communication/mavlinkfleetemulator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Emulate a fleet of WayWise vehicles via MAVLink over UDP for control station load tests.");
+    parser.addHelpOption();
+    QCommandLineOption hostOption("host", "Address of the control station.", "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "UDP port of the control station.", "port", "14540");
+    QCommandLineOption vehiclesOption("vehicles", "Number of vehicles at start.", "n", "10");
+    QCommandLineOption firstSystemIdOption("first-system-id", "MAVLink system id of the first vehicle.", "id", "1");
+    QCommandLineOption rampOption("ramp", "Vehicles added every ramp interval.", "n", "0");
+    QCommandLineOption rampIntervalOption("ramp-interval", "Ramp interval [s].", "s", "30");
+    QCommandLineOption maxVehiclesOption("max-vehicles", "Vehicle count the ramp stops at.", "n", QString::number(MavlinkFleetEmulator::MAX_VEHICLES));
+    QCommandLineOption telemetryRateOption("telemetry-rate", "Position telemetry rate per vehicle [Hz].", "Hz", "10");
+    QCommandLineOption statusTextIntervalOption("statustext-interval", "Interval of STATUSTEXT bursts per vehicle [s], 0: none.", "s", "10");
+    QCommandLineOption statusTextBurstOption("statustext-burst", "STATUSTEXT messages per burst.", "n", "5");
+    QCommandLineOption durationOption("duration", "Stop after this time [s], 0: run until interrupted.", "s", "0");
+    parser.addOptions({hostOption, portOption, vehiclesOption, firstSystemIdOption, rampOption, rampIntervalOption, maxVehiclesOption,
+                       telemetryRateOption, statusTextIntervalOption, statusTextBurstOption, durationOption});
+    parser.process(app);
+
+    MavlinkFleetEmulatorConfig config;
+    config.firstSystemId = quint8(qBound(1, parser.value(firstSystemIdOption).toInt(), 255));
+    config.telemetryRate_Hz = parser.value(telemetryRateOption).toDouble();
+    config.statusTextInterval_ms = int(parser.value(statusTextIntervalOption).toDouble() * 1000.0);
+    config.statusTextBurst = parser.value(statusTextBurstOption).toInt();
+
+    MavlinkFleetEmulator fleetEmulator(config);
+    const QHostAddress stationAddress(parser.value(hostOption));
+    if (stationAddress.isNull() || !fleetEmulator.start(stationAddress, quint16(parser.value(portOption).toUInt()), parser.value(vehiclesOption).toInt())) {
+        fprintf(stderr, "Could not start emulating towards %s\n", qPrintable(parser.value(hostOption)));
+        return 1;
+    }
+
+    const int ramp = parser.value(rampOption).toInt();
+    const int maxVehicles = parser.value(maxVehiclesOption).toInt();
+    QTimer rampTimer;
+    QObject::connect(&rampTimer, &QTimer::timeout, [&]{
+        fleetEmulator.setVehicleCount(qMin(fleetEmulator.getVehicleCount() + ramp, maxVehicles));
+        if (fleetEmulator.getVehicleCount() >= maxVehicles)
+            rampTimer.stop();
+    });
+    if (ramp > 0)
+        rampTimer.start(int(parser.value(rampIntervalOption).toDouble() * 1000.0));
+
+    QElapsedTimer runTime;
+    runTime.start();
+    QTimer reportTimer;
+    QObject::connect(&reportTimer, &QTimer::timeout, [&]{
+        const MavlinkFleetEmulatorStatistics statistics = fleetEmulator.getStatistics();
+        printf("%.1f,%d,%.0f,%.0f,%llu,%llu\n", runTime.elapsed() / 1000.0, statistics.vehicles, statistics.txMessages_Hz, statistics.txBytes_Bps,
+               static_cast<unsigned long long>(statistics.rxMessages), static_cast<unsigned long long>(statistics.missionsUploaded));
+        fflush(stdout);
+    });
+    printf("time_s,vehicles,tx_messages_Hz,tx_Bps,rx_messages,missions_uploaded\n");
+    reportTimer.start(1000);
+
+    const double duration_s = parser.value(durationOption).toDouble();
+    if (duration_s > 0.0)
+        QTimer::singleShot(int(duration_s * 1000.0), &app, &QCoreApplication::quit);
+
+    return app.exec();
+}
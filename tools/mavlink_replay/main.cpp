@@ -0,0 +1,109 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Replays a MAVLink recording of MavsdkStation (see MavsdkStation::startMavlinkRecording) into a control station over UDP,
+ * one datagram per recorded message at the recorded pace times --speed, e.g., to profile ControlTower (MavsdkVehicleConnection
+ * callbacks, MapWidget rendering, together with MavsdkStation::setBenchmarkInterval_ms) under the traffic of a field session:
+ *   mavlink_replay --speed 10 --loop field_session
+ * The station's answers are received and counted only, i.e., requests of the station time out as with vehicles that do not answer.
+ * Prints the load sent as CSV once per second: time [s], replayed messages, messages/s, bytes/s, received messages.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QTimer>
+#include <QUdpSocket>
+#include <cstdio>
+#include "logger/rawstreamreplay.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay a MAVLink recording of MavsdkStation into a control station via UDP.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("recording", "Basename given to MavsdkStation::startMavlinkRecording, or a single segment file.");
+    QCommandLineOption hostOption("host", "Address of the control station.", "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "UDP port of the control station.", "port", "14540");
+    QCommandLineOption speedOption("speed", "Replay speed relative to the recording, 1 to 50.", "factor", "1");
+    QCommandLineOption seekOption("seek", "Start this far into the recording [s].", "s", "0");
+    QCommandLineOption loopOption("loop", "Start over at the end of the recording.");
+    QCommandLineOption streamOption("stream", "Recorded stream to replay.", "name", "mavlink_rx"); // MavsdkStation::MAVLINK_RECORDING_STREAM
+    parser.addOptions({hostOption, portOption, speedOption, seekOption, loopOption, streamOption});
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    RawStreamReplay replay;
+    if (!replay.open(parser.positionalArguments().first())) {
+        fprintf(stderr, "Could not open recording: %s\n", qPrintable(replay.getErrorString()));
+        return 1;
+    }
+    const int streamId = replay.findStream(parser.value(streamOption));
+    if (streamId < 0) {
+        fprintf(stderr, "Recording has no stream \"%s\", streams: %s\n", qPrintable(parser.value(streamOption)),
+                qPrintable(replay.getStreamNames().join(", ")));
+        return 1;
+    }
+
+    const QHostAddress stationAddress(parser.value(hostOption));
+    const quint16 stationPort = quint16(parser.value(portOption).toUInt());
+    QUdpSocket socket;
+    if (stationAddress.isNull() || !socket.bind()) {
+        fprintf(stderr, "Could not replay towards %s\n", qPrintable(parser.value(hostOption)));
+        return 1;
+    }
+
+    quint64 txMessages = 0, txBytes = 0, rxMessages = 0;
+    QObject::connect(&replay, &RawStreamReplay::rawData, [&](int id, const QByteArray &data, qint64) {
+        if (id != streamId)
+            return;
+        socket.writeDatagram(data, stationAddress, stationPort);
+        txMessages++;
+        txBytes += data.size();
+    });
+    QObject::connect(&socket, &QUdpSocket::readyRead, [&]{
+        while (socket.hasPendingDatagrams()) {
+            socket.receiveDatagram(0);
+            rxMessages++;
+        }
+    });
+
+    const qint64 seek_ns = qint64(parser.value(seekOption).toDouble() * 1e9);
+    const bool loop = parser.isSet(loopOption);
+    QObject::connect(&replay, &RawStreamReplay::finished, [&]{
+        if (loop && replay.seek(seek_ns))
+            replay.start();
+        else
+            app.quit();
+    });
+
+    QElapsedTimer runTime;
+    runTime.start();
+    quint64 lastTxMessages = 0, lastTxBytes = 0;
+    QTimer reportTimer;
+    QObject::connect(&reportTimer, &QTimer::timeout, [&]{
+        printf("%.1f,%llu,%llu,%llu,%llu\n", runTime.elapsed() / 1000.0, static_cast<unsigned long long>(txMessages),
+               static_cast<unsigned long long>(txMessages - lastTxMessages), static_cast<unsigned long long>(txBytes - lastTxBytes),
+               static_cast<unsigned long long>(rxMessages));
+        fflush(stdout);
+        lastTxMessages = txMessages;
+        lastTxBytes = txBytes;
+    });
+    printf("time_s,tx_messages,tx_messages_Hz,tx_Bps,rx_messages\n");
+    reportTimer.start(1000);
+
+    replay.setSpeed(qBound(1.0, parser.value(speedOption).toDouble(), 50.0));
+    if (!replay.seek(seek_ns)) {
+        fprintf(stderr, "Could not seek to %s s\n", qPrintable(parser.value(seekOption)));
+        return 1;
+    }
+    replay.start();
+
+    return app.exec();
+}
@@ -0,0 +1,106 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Prepares OSM tiles for offline use: downloads an area over several zoom levels into a tile cache dir and/or
+ * packs the cache dir into a single OsmTilePack file, which is loaded with OsmClient::setTilePack, e.g.:
+ *   osm_tile_pack --cache-dir osm_tiles --area 57.70,11.90,57.72,11.95 --zoom 10-19 --output site.wwtiles
+ */
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <QDebug>
+#include <cstdio>
+#include <algorithm>
+#include "userinterface/map/osmclient.h"
+#include "userinterface/map/osmtilepack.h"
+
+int main(int argc, char *argv[])
+{
+    // OsmClient renders status pixmaps, no display needed
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Download OSM tiles of an area and pack them for offline use.");
+    parser.addHelpOption();
+    QCommandLineOption cacheDirOption("cache-dir", "Tile cache directory (zoom/x/y.png).", "dir", "osm_tiles");
+    QCommandLineOption serverOption("server", "Tile server URL.", "url", "http://c.osm.rrze.fau.de/osmhd");
+    QCommandLineOption areaOption("area", "Area to download: latMin,lonMin,latMax,lonMax.", "area");
+    QCommandLineOption zoomOption("zoom", "Zoom levels to download: min-max.", "zoom", "0-19");
+    QCommandLineOption concurrentOption("concurrent", "Concurrent downloads.", "n", "6");
+    QCommandLineOption outputOption("output", "Tile pack to create from the cache directory.", "file");
+    parser.addOptions({cacheDirOption, serverOption, areaOption, zoomOption, concurrentOption, outputOption});
+    parser.process(app);
+
+    if (!parser.isSet(areaOption) && !parser.isSet(outputOption))
+        parser.showHelp(1);
+
+    const QString cacheDir = parser.value(cacheDirOption);
+    auto createPack = [&parser, &outputOption, &cacheDir]() {
+        if (!parser.isSet(outputOption))
+            return 0;
+
+        QString errorString;
+        const int tiles = OsmTilePack::create(cacheDir, parser.value(outputOption), &errorString);
+        if (tiles < 0) {
+            fprintf(stderr, "%s\n", qPrintable(errorString));
+            return 1;
+        }
+        printf("Packed %d tiles into %s\n", tiles, qPrintable(parser.value(outputOption)));
+        return 0;
+    };
+
+    if (!parser.isSet(areaOption))
+        return createPack();
+
+    const QStringList area = parser.value(areaOption).split(',');
+    const QStringList zoom = parser.value(zoomOption).split('-');
+    bool ok = area.size() == 4 && (zoom.size() == 1 || zoom.size() == 2);
+    double bounds[4];
+    for (int i = 0; ok && i < 4; i++)
+        bounds[i] = area.at(i).toDouble(&ok);
+    bool maxZoomOk = true;
+    const int minZoom = ok ? zoom.first().toInt(&ok) : 0;
+    const int maxZoom = zoom.last().toInt(&maxZoomOk);
+    if (!ok || !maxZoomOk || minZoom > maxZoom) {
+        fprintf(stderr, "Invalid area or zoom levels.\n");
+        return 1;
+    }
+
+    OsmClient osm;
+    if (!osm.setCacheDir(cacheDir) || !osm.setTileServerUrl(parser.value(serverOption)))
+        return 1;
+    // Area downloads leave PREFETCH_RESERVED_DOWNLOADS slots for visible tiles, there are none here
+    osm.setMaxDownloadingTiles(std::max(1, parser.value(concurrentOption).toInt()) + OsmClient::PREFETCH_RESERVED_DOWNLOADS);
+
+    int result = 0;
+    QObject::connect(&osm, &OsmClient::errorGetTile, [](QString reason) {
+        qWarning() << "OSM tile error:" << reason;
+    });
+    QObject::connect(&osm, &OsmClient::areaDownloadProgress, [&](int tilesDone, int tilesTotal, int tilesFailed) {
+        printf("\r%d/%d tiles (%d failed)", tilesDone, tilesTotal, tilesFailed);
+        fflush(stdout);
+        if (tilesDone == tilesTotal) {
+            printf("\n");
+            result = tilesFailed > 0 ? 1 : 0;
+            if (createPack() != 0)
+                result = 1;
+            app.quit();
+        }
+    });
+
+    // Progress is reported immediately for cached tiles, start in the event loop
+    QTimer::singleShot(0, [&]() {
+        const int tiles = osm.downloadArea(bounds[0], bounds[1], bounds[2], bounds[3], minZoom, maxZoom);
+        if (tiles <= 0) {
+            result = tiles < 0 ? 1 : createPack();
+            app.quit();
+        }
+    });
+
+    app.exec();
+    return result;
+}
@@ -0,0 +1,183 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Generates coverage routes for all fields (polygons) of GeoJSON files on all cores (RouteGenerationService) and prints
+ * the timing per field as CSV, e.g.:
+ *   route_generator --pattern coverage --spacing 3.0 --output-dir routes fields.geojson > timing.csv
+ * Routes are written as one route file (--output, binary routeCodec or XML as exported by PlanUI) or one file per field (--output-dir).
+ * Exits with 1 if no route fits into a field.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QThread>
+#include <cstdio>
+#include "routeplanning/routegenerationservice.h"
+#include "core/routecodec.h"
+
+static bool writeRouteFile(const QString &filename, bool xml, const QList<QList<PosPoint>> &routes, const llh_t &enuRef)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    if (xml)
+        return file.write(RouteGenerationService::encodeRoutesXml(routes, enuRef)) >= 0;
+
+    QList<QVector<pospoint_t>> routesPOD;
+    for (const auto &route : routes)
+        routesPOD.append(PosPoint::toPODList(route));
+    return file.write(routeCodec::encodeRouteFile(routesPOD, enuRef)) >= 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Generate coverage routes for the fields of GeoJSON files.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "GeoJSON files with (Multi)Polygon fields.", "files...");
+    QCommandLineOption patternOption("pattern", "Route pattern: zigzag, framed, curved or coverage (non-convex fields with holes).", "name", "zigzag");
+    QCommandLineOption spacingOption("spacing", "Distance between passes [m].", "m", "2.0");
+    QCommandLineOption speedOption("speed", "Speed on straights [m/s].", "m/s", "1.0");
+    QCommandLineOption speedInTurnsOption("speed-in-turns", "Speed in turns [m/s].", "m/s", "0.5");
+    QCommandLineOption turnStepsOption("turn-steps", "Intermediate points per turn.", "n", "10");
+    QCommandLineOption keepTurnsOption("keep-turns-in-bounds", "Turns stay inside the field.");
+    QCommandLineOption visitEveryXOption("visit-every", "Visit every x-th pass per sweep (even, 0: all in order).", "x", "0");
+    QCommandLineOption framesOption("frames", "Frames around the zig-zag (framed).", "n", "1");
+    QCommandLineOption turnRadiusOption("turn-radius", "Minimum turn radius (curved) [m].", "m", "3.0");
+    QCommandLineOption reverseOption("allow-reverse", "Turns with reversing (curved).");
+    QCommandLineOption attributesOnStraightsOption("attributes-straights", "Attributes set on straights (hex).", "hex", "0");
+    QCommandLineOption attributesInTurnsOption("attributes-turns", "Attributes set in turns (hex).", "hex", "0");
+    QCommandLineOption threadsOption("threads", "Worker threads, 0: one per core.", "n", "0");
+    QCommandLineOption enuRefOption("enu-ref", "ENU reference of all routes, default: first field vertex (--output) or each field's first vertex (--output-dir).", "lat,lon,height");
+    QCommandLineOption outputOption({"o", "output"}, "Route file with the routes of all fields, XML if it ends with .xml.", "file");
+    QCommandLineOption outputDirOption("output-dir", "Directory for one route file per field.", "dir");
+    QCommandLineOption xmlOption("xml", "Write XML route files to --output-dir instead of binary ones.");
+    parser.addOptions({patternOption, spacingOption, speedOption, speedInTurnsOption, turnStepsOption, keepTurnsOption, visitEveryXOption, framesOption, turnRadiusOption,
+                       reverseOption, attributesOnStraightsOption, attributesInTurnsOption, threadsOption, enuRefOption, outputOption, outputDirOption, xmlOption});
+    parser.process(app);
+
+    if (parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    RouteGenerationParameters parameters;
+    const QString pattern = parser.value(patternOption);
+    if (pattern == "framed")
+        parameters.pattern = RoutePattern::FRAMED_ZIGZAG;
+    else if (pattern == "curved")
+        parameters.pattern = RoutePattern::CURVED_ZIGZAG;
+    else if (pattern == "coverage")
+        parameters.pattern = RoutePattern::COVERAGE;
+    else if (pattern != "zigzag") {
+        fprintf(stderr, "Unknown pattern %s\n", qPrintable(pattern));
+        return 1;
+    }
+    parameters.spacing = parser.value(spacingOption).toDouble();
+    parameters.speed = parser.value(speedOption).toDouble();
+    parameters.speedInTurns = parser.value(speedInTurnsOption).toDouble();
+    parameters.turnIntermediateSteps = parser.value(turnStepsOption).toInt();
+    parameters.keepTurnsInBounds = parser.isSet(keepTurnsOption);
+    parameters.visitEveryX = parser.value(visitEveryXOption).toInt();
+    parameters.frameCount = parser.value(framesOption).toInt();
+    parameters.minTurnRadius = parser.value(turnRadiusOption).toDouble();
+    parameters.allowReverse = parser.isSet(reverseOption);
+    parameters.setAttributesOnStraights = parser.value(attributesOnStraightsOption).toUInt(nullptr, 16);
+    parameters.setAttributesInTurns = parser.value(attributesInTurnsOption).toUInt(nullptr, 16);
+    if (parameters.visitEveryX % 2 != 0) {
+        fprintf(stderr, "--visit-every needs to be even\n");
+        return 1;
+    }
+
+    QList<RouteGenerationField> fields;
+    for (const auto &filename : parser.positionalArguments()) {
+        QFile file(filename);
+        QList<RouteGenerationField> fileFields;
+        QString error;
+        if (!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "Could not open %s\n", qPrintable(filename));
+            return 1;
+        }
+        if (!RouteGenerationService::readGeoJsonFields(file.readAll(), fileFields, &error)) {
+            fprintf(stderr, "Could not read %s: %s\n", qPrintable(filename), qPrintable(error));
+            return 1;
+        }
+        // Keep names unique over several files
+        if (parser.positionalArguments().size() > 1)
+            for (auto &field : fileFields)
+                field.name = QFileInfo(filename).completeBaseName() + ":" + field.name;
+        fields.append(fileFields);
+    }
+
+    RouteGenerationService service;
+    service.setParameters(parameters);
+    service.setThreadCount(parser.value(threadsOption).toInt());
+    if (parser.isSet(enuRefOption)) {
+        const QStringList enuRef = parser.value(enuRefOption).split(',');
+        if (enuRef.size() != 3) {
+            fprintf(stderr, "--enu-ref needs lat,lon,height\n");
+            return 1;
+        }
+        service.setEnuRef({enuRef.at(0).toDouble(), enuRef.at(1).toDouble(), enuRef.at(2).toDouble()});
+    } else if (parser.isSet(outputOption) && !fields.isEmpty())
+        service.setEnuRef(fields.first().bounds.first()); // one reference per route file
+
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+    const QVector<RouteGenerationResult> results = service.run(fields);
+    const double wallTime_s = wallTimer.nsecsElapsed() / 1e9;
+
+    int failed = 0;
+    double generationTime_s = 0.0;
+    printf("field,generated,points,route_m,generation_ms\n");
+    for (const auto &result : results) {
+        printf("%s,%d,%d,%.2f,%.3f\n", qPrintable(result.name), result.generated ? 1 : 0, result.route.size(), result.routeLength_m, result.generationTime_ms);
+        generationTime_s += result.generationTime_ms / 1000.0;
+        if (!result.generated)
+            failed++;
+    }
+
+    if (parser.isSet(outputOption)) {
+        const QString filename = parser.value(outputOption);
+        QList<QList<PosPoint>> routes;
+        for (const auto &result : results)
+            if (result.generated)
+                routes.append(result.route);
+        if (!writeRouteFile(filename, filename.endsWith(".xml", Qt::CaseInsensitive), routes, results.isEmpty() ? llh_t{0.0, 0.0, 0.0} : results.first().enuRef)) {
+            fprintf(stderr, "Could not write %s\n", qPrintable(filename));
+            return 1;
+        }
+    }
+
+    if (parser.isSet(outputDirOption)) {
+        const QDir dir(parser.value(outputDirOption));
+        if (!dir.mkpath(".")) {
+            fprintf(stderr, "Could not create %s\n", qPrintable(dir.path()));
+            return 1;
+        }
+        const bool xml = parser.isSet(xmlOption);
+        for (const auto &result : results) {
+            if (!result.generated)
+                continue;
+            QString filename = result.name;
+            filename.replace(QRegularExpression("[^A-Za-z0-9_.#-]"), "_");
+            filename = dir.filePath(filename + (xml ? ".xml" : ".wwr"));
+            if (!writeRouteFile(filename, xml, {result.route}, result.enuRef)) {
+                fprintf(stderr, "Could not write %s\n", qPrintable(filename));
+                return 1;
+            }
+        }
+    }
+
+    fprintf(stderr, "%d fields, %d without route, %.2f s of generation in %.2f s on %d threads\n", results.size(), failed,
+            generationTime_s, wallTime_s, service.getThreadCount() > 0 ? service.getThreadCount() : QThread::idealThreadCount());
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Runs the pure pursuit autopilot on simulated vehicles along all routes of binary route files (routeCodec, as exported by PlanUI)
+ * faster than real time and prints tracking metrics per route as CSV, e.g.:
+ *   simulation_runner --truck --trailer --radius 2.0 --repeat 10 field1.wwr field2.wwr > results.csv
+ * Exits with 1 if a route was not finished or exceeded --max-cross-track-error.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <cstdio>
+#include <algorithm>
+#include "autopilot/simulationrunner.h"
+#include "core/routecodec.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulate vehicles following the routes of route files and report tracking metrics.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "Binary route files.", "files...");
+    QCommandLineOption truckOption("truck", "Simulate trucks instead of cars.");
+    QCommandLineOption trailerOption("trailer", "Trucks pull a simulated trailer.");
+    QCommandLineOption controllerOption("controller", "Lateral controller: pure-pursuit, stanley, mpc or dwa.", "name", "pure-pursuit");
+    QCommandLineOption radiusOption("radius", "Pure pursuit radius [m].", "m", "1.0");
+    QCommandLineOption adaptiveOption("adaptive-radius", "Speed-dependent pure pursuit radius.");
+    QCommandLineOption rateLimitsOption("rate-limits", "Limit acceleration and steering rate of the vehicles.");
+    QCommandLineOption speedProfileOption("speed-profile", "Plan a speed profile with this lateral acceleration limit [m/s²].", "m/s²");
+    QCommandLineOption repeatOption("repeat", "Simulate each route n times (e.g., for load tests, results are identical).", "n", "1");
+    QCommandLineOption stepOption("step-ms", "Simulation step [ms].", "ms", QString::number(SimulationRunner::DEFAULT_STEP_ms));
+    QCommandLineOption threadsOption("threads", "Worker threads, 0: one per core.", "n", "0");
+    QCommandLineOption maxDurationOption("max-duration", "Virtual time limit per route [s].", "s", "3600");
+    QCommandLineOption maxErrorOption("max-cross-track-error", "Fail if the maximum cross-track error of a route exceeds this [m].", "m");
+    parser.addOptions({truckOption, trailerOption, controllerOption, radiusOption, adaptiveOption, rateLimitsOption, speedProfileOption, repeatOption, stepOption, threadsOption, maxDurationOption, maxErrorOption});
+    parser.process(app);
+
+    if (parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    SimulationScenario scenarioTemplate;
+    scenarioTemplate.truck = parser.isSet(truckOption);
+    scenarioTemplate.trailer = parser.isSet(trailerOption);
+    const QString controller = parser.value(controllerOption);
+    if (controller == "stanley")
+        scenarioTemplate.lateralController = LateralController::STANLEY;
+    else if (controller == "mpc")
+        scenarioTemplate.lateralController = LateralController::MPC;
+    else if (controller == "dwa")
+        scenarioTemplate.lateralController = LateralController::DWA;
+    else if (controller != "pure-pursuit") {
+        fprintf(stderr, "Unknown controller %s\n", qPrintable(controller));
+        return 1;
+    }
+    scenarioTemplate.purePursuitRadius = parser.value(radiusOption).toDouble();
+    scenarioTemplate.adaptivePurePursuitRadius = parser.isSet(adaptiveOption);
+    scenarioTemplate.rateLimits = parser.isSet(rateLimitsOption);
+    if (parser.isSet(speedProfileOption))
+        scenarioTemplate.speedProfileMaxLateralAcceleration = parser.value(speedProfileOption).toDouble();
+    scenarioTemplate.maxDuration_s = parser.value(maxDurationOption).toDouble();
+    const int repeat = std::max(parser.value(repeatOption).toInt(), 1);
+
+    QList<SimulationScenario> scenarios;
+    for (const auto &filename : parser.positionalArguments()) {
+        QFile file(filename);
+        QList<QVector<pospoint_t>> routes;
+        llh_t enuRef;
+        if (!file.open(QIODevice::ReadOnly) || !routeCodec::decodeRouteFile(file.readAll(), routes, enuRef)) {
+            fprintf(stderr, "Could not read route file %s\n", qPrintable(filename));
+            return 1;
+        }
+
+        for (int i = 0; i < routes.size(); i++) {
+            for (int j = 0; j < repeat; j++) {
+                SimulationScenario scenario = scenarioTemplate;
+                scenario.name = QString("%1:%2").arg(QFileInfo(filename).fileName()).arg(i);
+                if (repeat > 1)
+                    scenario.name += QString("#%1").arg(j);
+                scenario.route = routes.at(i);
+                scenarios.append(scenario);
+            }
+        }
+    }
+
+    SimulationRunner runner;
+    runner.setStep_ms(parser.value(stepOption).toInt());
+    runner.setThreadCount(parser.value(threadsOption).toInt());
+
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+    const QVector<SimulationResult> results = runner.run(scenarios);
+    const double wallTime_s = wallTimer.nsecsElapsed() / 1e9;
+
+    const bool checkMaxError = parser.isSet(maxErrorOption);
+    const double maxError_m = parser.value(maxErrorOption).toDouble();
+    int failed = 0;
+    double simulatedTime_s = 0.0;
+    printf("route,finished,simulated_s,wall_s,route_m,driven_m,cte_mean_m,cte_rms_m,cte_max_m,end_goal_m,solve_mean_us,solve_max_us\n");
+    for (const auto &result : results) {
+        printf("%s,%d,%.2f,%.4f,%.2f,%.2f,%.4f,%.4f,%.4f,%.4f,%.2f,%.2f\n", qPrintable(result.name), result.finished ? 1 : 0, result.simulatedTime_s, result.wallTime_s,
+               result.routeLength_m, result.drivenDistance_m, result.meanCrossTrackError_m, result.rmsCrossTrackError_m, result.maxCrossTrackError_m, result.endGoalDistance_m,
+               result.meanLateralSolveTime_us, result.maxLateralSolveTime_us);
+        simulatedTime_s += result.simulatedTime_s;
+        if (!result.finished || (checkMaxError && result.maxCrossTrackError_m > maxError_m))
+            failed++;
+    }
+
+    fprintf(stderr, "%d routes, %d failed, %.2f vehicle-hours in %.1f s (%.0fx real time)\n", results.size(), failed,
+            simulatedTime_s / 3600.0, wallTime_s, wallTime_s > 0.0 ? simulatedTime_s / wallTime_s : 0.0);
+
+    return failed > 0 ? 1 : 0;
+}
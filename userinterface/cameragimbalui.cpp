@@ -29,6 +29,7 @@ CameraGimbalUI::~CameraGimbalUI()
 void CameraGimbalUI::setGimbal(const QSharedPointer<Gimbal> gimbal)
 {
     mGimbal = gimbal;
+    updateRoiTracker();
 
     emit gotGimbal();
 }
@@ -41,16 +42,44 @@ QSharedPointer<MapModule> CameraGimbalUI::getSetRoiByClickOnMapModule() const
 void CameraGimbalUI::setVehicleConnection(const QSharedPointer<VehicleConnection> &vehicleConnection)
 {
     mVehicleConnection = vehicleConnection;
+    updateRoiTracker();
+}
+
+void CameraGimbalUI::updateRoiTracker()
+{
+    if (mRoiTracker)
+        mRoiTracker->stopTracking();
+
+    if (mGimbal.isNull() || mVehicleConnection.isNull())
+        mRoiTracker.clear();
+    else
+        mRoiTracker = QSharedPointer<GimbalRoiTracker>::create(mGimbal, mVehicleConnection->getVehicleState());
+}
+
+void CameraGimbalUI::stopRoiTracking()
+{
+    if (mRoiTracker)
+        mRoiTracker->stopTracking();
 }
 
 CameraGimbalUI::SetRoiByClickOnMapModule::SetRoiByClickOnMapModule(CameraGimbalUI *parent) : mCameraGimbalUI(parent)
 {
     mSetRoiAction = QSharedPointer<QAction>::create(this);
     mRoiContextMenu = QSharedPointer<QMenu>::create();
+    mTrackRoiAction = QSharedPointer<QAction>::create(this);
     mRoiContextMenu->addAction(mSetRoiAction.get());
+    mRoiContextMenu->addAction(mTrackRoiAction.get());
     connect(mSetRoiAction.get(), &QAction::triggered, [&](){
+            mCameraGimbalUI->stopRoiTracking();
             mCameraGimbalUI->mGimbal->setRegionOfInterest(mLastClickedMapPos, mLastEnuRefFromMap);
             mLastRoiSet = mLastClickedMapPos;
+            emit requestRepaint();
+    });
+    // Pitch and yaw are computed locally, the ROI stays in view while the vehicle moves without relying on gimbal ROI support
+    connect(mTrackRoiAction.get(), &QAction::triggered, [&](){
+            mCameraGimbalUI->mRoiTracker->startTracking(mLastClickedMapPos);
+            mLastRoiSet = mLastClickedMapPos;
+            emit requestRepaint();
     });
 }
 
@@ -93,6 +122,10 @@ QSharedPointer<QMenu> CameraGimbalUI::SetRoiByClickOnMapModule::populateContextM
                         .arg(mapPos.x)
                         .arg(mapPos.y)
                         .arg(mCameraGimbalUI->ui->roiHeightSpinBox->value()));
+    mTrackRoiAction->setText(QString("Track ROI at x=%1, y=%2, z=%3")
+                        .arg(mapPos.x)
+                        .arg(mapPos.y)
+                        .arg(mCameraGimbalUI->ui->roiHeightSpinBox->value()));
     mLastClickedMapPos = {mapPos.x, mapPos.y, mCameraGimbalUI->ui->roiHeightSpinBox->value()};
     mLastEnuRefFromMap = enuReference;
 
@@ -132,6 +165,7 @@ void CameraGimbalUI::on_actuatorTwoHighButton_clicked()
 void CameraGimbalUI::on_zeroButton_clicked()
 {
     mPitchYawState = {0.0, 0.0};
+    stopRoiTracking();
     mGimbal->setPitchAndYaw(mPitchYawState.first, mPitchYawState.second);
 }
 
@@ -212,6 +246,7 @@ void CameraGimbalUI::moveGimbal(double pitch_deg, double yaw_deg)
     if (mPitchYawState.second < YAW_RANGE.first)
         mPitchYawState.second = YAW_RANGE.first;
 
+    stopRoiTracking();
     mGimbal->setPitchAndYaw(mPitchYawState.first, mPitchYawState.second);
 //    qDebug() << "Set pitch" << mPitchYawState.first << "and yaw" << mPitchYawState.second;
 }
@@ -223,6 +258,7 @@ void CameraGimbalUI::on_yawFollowButton_clicked()
 
 void CameraGimbalUI::on_yawLockButton_clicked()
 {
+    stopRoiTracking(); // tracking uses yaw follow
     mGimbal->setYawLocked(true);
 }
 
@@ -10,6 +10,7 @@
 #include <QVideoWidget>
 #include <QSharedPointer>
 #include "sensors/camera/gimbal.h"
+#include "sensors/camera/gimbalroitracker.h"
 #include "userinterface/map/mapwidget.h"
 #include <QGamepad>
 #include <QMessageBox>
@@ -37,6 +38,8 @@ public:
     QSharedPointer<MapModule> getSetRoiByClickOnMapModule() const;
 
     void setVehicleConnection(const QSharedPointer<VehicleConnection> &vehicleConnection);
+    // Available once gimbal and vehicle connection are set, e.g., to track another vehicle. Stopped by manual gimbal commands.
+    QSharedPointer<GimbalRoiTracker> getRoiTracker() const { return mRoiTracker; }
 
 private slots:
     void on_actuatorTwoHighButton_clicked();
@@ -75,6 +78,7 @@ private:
         CameraGimbalUI *mCameraGimbalUI;
         QSharedPointer<QMenu> mRoiContextMenu;
         QSharedPointer<QAction> mSetRoiAction;
+        QSharedPointer<QAction> mTrackRoiAction;
         xyz_t mLastClickedMapPos;
         llh_t mLastEnuRefFromMap;
         xyz_t mLastRoiSet = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
@@ -95,10 +99,13 @@ private:
     };
 
     void moveGimbal(double pitch_deg, double yaw_deg);
+    void updateRoiTracker();
+    void stopRoiTracking();
     Ui::CameraGimbalUI *ui;
     QSharedPointer<Gimbal> mGimbal;
     QSharedPointer<SetRoiByClickOnMapModule> mSetRoiByClickOnMapModule;
     QSharedPointer<VehicleConnection> mVehicleConnection;
+    QSharedPointer<GimbalRoiTracker> mRoiTracker;
     QPair<double, double> mPitchYawState = {0.0, 0.0};
     const double SMALL_STEP = 1.0;
     const double MEDIUM_STEP = 5.0;
@@ -11,36 +11,13 @@ DriveUI::DriveUI(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::DriveUI)
 {
-    memset(&mArrowKeyStates, 0, sizeof (mArrowKeyStates));
-    memset(&mKeyControlState, 0, sizeof (mKeyControlState));
-
     ui->setupUi(this);
 
     grabKeyboard();
-    connect(&mKeyControlTimer, &QTimer::timeout, [this](){
-        if (mArrowKeyStates.upPressed)
-            mKeyControlState.throttle += getMaxSignedStepFromValueTowardsGoal(mKeyControlState.throttle, 1.0, 0.03);
-        else if (mArrowKeyStates.downPressed)
-            mKeyControlState.throttle += getMaxSignedStepFromValueTowardsGoal(mKeyControlState.throttle, -1.0, 0.03);
-        else
-            mKeyControlState.throttle += getMaxSignedStepFromValueTowardsGoal(mKeyControlState.throttle, 0.0, 0.03);
-
-        if (mArrowKeyStates.leftPressed)
-            mKeyControlState.steering += getMaxSignedStepFromValueTowardsGoal(mKeyControlState.steering, -1.0, 0.08);
-        else if (mArrowKeyStates.rightPressed)
-            mKeyControlState.steering += getMaxSignedStepFromValueTowardsGoal(mKeyControlState.steering, 1.0, 0.08);
-        else
-            mKeyControlState.steering += getMaxSignedStepFromValueTowardsGoal(mKeyControlState.steering, 0.0, 0.08);
-
-//        qDebug() << mArrowKeyStates.upPressed << mArrowKeyStates.downPressed << mArrowKeyStates.leftPressed << mArrowKeyStates.rightPressed;
-//        qDebug() << mKeyControlState.throttle << mKeyControlState.steering;
-        ui->throttleBar->setValue(mKeyControlState.throttle * 100);
-        ui->steeringBar->setValue(mKeyControlState.steering * 100);
-
-        if (mCurrentVehicleConnection && mCurrentVehicleConnection->getVehicleState()->getFlightMode() == VehicleState::FlightMode::Manual)
-            mCurrentVehicleConnection->setManualControl(mKeyControlState.throttle, 0, 0, mKeyControlState.steering, 0);
+    connect(&mManualControlInput, &ManualControlInput::sampled, this, [this](double throttle, double steering) {
+        ui->throttleBar->setValue(throttle * 100);
+        ui->steeringBar->setValue(steering * 100);
     });
-    mKeyControlTimer.start(40);
 }
 
 DriveUI::~DriveUI()
@@ -51,6 +28,7 @@ DriveUI::~DriveUI()
 void DriveUI::setCurrentVehicleConnection(const QSharedPointer<VehicleConnection> &currentVehicleConnection)
 {
     mCurrentVehicleConnection = currentVehicleConnection;
+    mManualControlInput.setVehicleConnection(currentVehicleConnection);
 }
 
 void DriveUI::gotRouteForAutopilot(const QList<PosPoint> &route)
@@ -113,54 +91,14 @@ void DriveUI::on_apStopButton_clicked()
 
 void DriveUI::keyPressEvent(QKeyEvent *event)
 {
-    switch (event->key()) {
-    case Qt::Key_Up:
-        mArrowKeyStates.upPressed = true;
-        break;
-    case Qt::Key_Down:
-        mArrowKeyStates.downPressed = true;
-        break;
-    case Qt::Key_Left:
-        mArrowKeyStates.leftPressed = true;
-        break;
-    case Qt::Key_Right:
-        mArrowKeyStates.rightPressed = true;
-        break;
-    default:
-        break;
-    }
+    if (event->isAutoRepeat() || !mManualControlInput.setKeyPressed(event->key(), true))
+        QWidget::keyPressEvent(event);
 }
 
 void DriveUI::keyReleaseEvent(QKeyEvent *event)
 {
-    switch (event->key()) {
-    case Qt::Key_Up:
-        mArrowKeyStates.upPressed = false;
-        break;
-    case Qt::Key_Down:
-        mArrowKeyStates.downPressed = false;
-        break;
-    case Qt::Key_Left:
-        mArrowKeyStates.leftPressed = false;
-        break;
-    case Qt::Key_Right:
-        mArrowKeyStates.rightPressed = false;
-        break;
-    default:
-        break;
-    }
-}
-
-double DriveUI::getMaxSignedStepFromValueTowardsGoal(double value, double goal, double maxStepSize) {
-    maxStepSize = abs(maxStepSize);
-
-    if ((value < goal) && (value + maxStepSize) < goal)
-        return maxStepSize;
-
-    if ((value > goal) && (value - maxStepSize) > goal)
-        return -maxStepSize;
-
-    return goal - value;
+    if (event->isAutoRepeat() || !mManualControlInput.setKeyPressed(event->key(), false))
+        QWidget::keyReleaseEvent(event);
 }
 
 void DriveUI::on_apSetActiveIDButton_clicked()
@@ -204,3 +142,12 @@ void DriveUI::on_pollENUrefButton_clicked()
         mCurrentVehicleConnection->pollCurrentENUreference();
 }
 
+
+void DriveUI::on_perfCountersButton_clicked()
+{
+    if (mPerfCountersUI.isNull())
+        mPerfCountersUI = QSharedPointer<PerfCountersUI>::create(this);
+    mPerfCountersUI->setCurrentVehicleConnection(mCurrentVehicleConnection);
+    mPerfCountersUI->show();
+    this->releaseKeyboard();
+}
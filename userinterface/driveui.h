@@ -12,6 +12,8 @@
 #include <QTableWidget>
 #include "communication/vehicleconnections/vehicleconnection.h"
 #include "userinterface/vehicleparameterui.h"
+#include "userinterface/perfcountersui.h"
+#include "userinterface/manualcontrolinput.h"
 
 namespace Ui {
 class DriveUI;
@@ -47,16 +49,15 @@ private slots:
 
     void on_pollENUrefButton_clicked();
 
+    void on_perfCountersButton_clicked();
+
 private:
     Ui::DriveUI *ui;
 
     QSharedPointer<VehicleParameterUI> mVehicleParameterUI;
+    QSharedPointer<PerfCountersUI> mPerfCountersUI;
     QSharedPointer<VehicleConnection> mCurrentVehicleConnection;
-    struct {bool upPressed, downPressed, leftPressed, rightPressed;} mArrowKeyStates;
-    struct {double throttle, steering;} mKeyControlState;
-    QTimer mKeyControlTimer;
-
-    double getMaxSignedStepFromValueTowardsGoal(double value, double goal, double maxStepSize);
+    ManualControlInput mManualControlInput;
 
     // QWidget interface
 protected:
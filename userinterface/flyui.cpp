@@ -256,7 +256,7 @@ void FlyUI::updateVehicleIdToFollow(int index)
 
     connect(vehicleState.get(), &ObjectState::positionUpdated, this, [this, vehicleState](){
         auto positionOfVehicleToFollow = vehicleState->getPosition();
-        positionOfVehicleToFollow.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
+        positionOfVehicleToFollow.setTimestamp_ns(utcTime::now_ns());
         if (mCurrentVehicleConnection)
             mCurrentVehicleConnection->updatePointToFollowInEnuFrame(positionOfVehicleToFollow);
     }, Qt::QueuedConnection);
@@ -0,0 +1,179 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "manualcontrolinput.h"
+#include <QDebug>
+#include <cmath>
+#ifdef QT_GAMEPAD_LIB
+#include <QGamepad>
+#include <QGamepadManager>
+#endif
+
+ManualControlInput::ManualControlInput(QObject *parent) : QObject(parent)
+{
+    mClock.start();
+    mSampleTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mSampleTimer, &QTimer::timeout, this, &ManualControlInput::sample);
+    mSampleTimer.start(1000 / mSampleRate_Hz);
+
+#ifdef QT_GAMEPAD_LIB
+    connect(QGamepadManager::instance(), &QGamepadManager::connectedGamepadsChanged, this, &ManualControlInput::updateGamepad);
+    updateGamepad();
+#endif
+}
+
+ManualControlInput::~ManualControlInput()
+{
+}
+
+void ManualControlInput::setVehicleConnection(const QSharedPointer<VehicleConnection> &vehicleConnection)
+{
+    mVehicleConnection = vehicleConnection;
+}
+
+void ManualControlInput::setSampleRate(int sampleRate_Hz)
+{
+    if (sampleRate_Hz <= 0) {
+        qDebug() << "Warning: ManualControlInput sample rate must be positive, got" << sampleRate_Hz;
+        return;
+    }
+    mSampleRate_Hz = sampleRate_Hz;
+    mSampleTimer.setInterval(qMax(1, 1000 / mSampleRate_Hz));
+}
+
+bool ManualControlInput::setKeyPressed(int key, bool pressed)
+{
+    switch (key) {
+    case Qt::Key_Up:
+        mArrowKeyStates.upPressed = pressed;
+        break;
+    case Qt::Key_Down:
+        mArrowKeyStates.downPressed = pressed;
+        break;
+    case Qt::Key_Left:
+        mArrowKeyStates.leftPressed = pressed;
+        break;
+    case Qt::Key_Right:
+        mArrowKeyStates.rightPressed = pressed;
+        break;
+    default:
+        return false;
+    }
+
+    inputChanged();
+    return true;
+}
+
+bool ManualControlInput::hasGamepad() const
+{
+#ifdef QT_GAMEPAD_LIB
+    return mGamepad && mGamepad->isConnected();
+#else
+    return false;
+#endif
+}
+
+void ManualControlInput::sample()
+{
+    const qint64 now_us = mClock.nsecsElapsed() / 1000;
+    // At most a few periods, e.g., after the event loop was blocked
+    const qint64 period_us = 1000000 / mSampleRate_Hz;
+    const double dt_s = (mLastSample_us < 0 ? period_us : qBound(qint64(0), now_us - mLastSample_us, 4 * period_us)) / 1e6;
+    mLastSample_us = now_us;
+    mStatistics.samples++;
+
+    // Keyboard: ramps towards full deflection or neutral
+    const double throttleGoal = mArrowKeyStates.upPressed ? 1.0 : (mArrowKeyStates.downPressed ? -1.0 : 0.0);
+    const double steeringGoal = mArrowKeyStates.leftPressed ? -1.0 : (mArrowKeyStates.rightPressed ? 1.0 : 0.0);
+    mKeyThrottle += getMaxSignedStepFromValueTowardsGoal(mKeyThrottle, throttleGoal, mConfig.keyboardThrottleRate * dt_s);
+    mKeySteering += getMaxSignedStepFromValueTowardsGoal(mKeySteering, steeringGoal, mConfig.keyboardSteeringRate * dt_s);
+
+    double throttle = mKeyThrottle;
+    double steering = mKeySteering;
+
+#ifdef QT_GAMEPAD_LIB
+    // The gamepad overrides the keyboard while deflected
+    if (hasGamepad()) {
+        const double gamepadThrottle = shapeAxis(-mGamepad->axisLeftY());
+        const double gamepadSteering = shapeAxis(mGamepad->axisRightX());
+        if (gamepadThrottle != 0.0 || gamepadSteering != 0.0) {
+            throttle = gamepadThrottle;
+            steering = gamepadSteering;
+        }
+    }
+#endif
+
+    // Exact for a constant input over dt
+    if (mConfig.filterTimeConstant_s > 0.0) {
+        const double alpha = 1.0 - exp(-dt_s / mConfig.filterTimeConstant_s);
+        throttle = mThrottle + (throttle - mThrottle) * alpha;
+        steering = mSteering + (steering - mSteering) * alpha;
+    }
+    mThrottle = qBound(-1.0, throttle, 1.0);
+    mSteering = qBound(-1.0, steering, 1.0);
+    emit sampled(mThrottle, mSteering);
+
+    if (!mVehicleConnection || mVehicleConnection->getVehicleState()->getFlightMode() != VehicleState::FlightMode::Manual) {
+        mInputChange_us = -1;
+        return;
+    }
+
+    mVehicleConnection->setManualControl(mThrottle, 0, 0, mSteering, 0);
+    mStatistics.handoffs++;
+    if (mInputChange_us >= 0) {
+        mStatistics.lastLatency_us = mClock.nsecsElapsed() / 1000 - mInputChange_us;
+        mStatistics.maxLatency_us = qMax(mStatistics.maxLatency_us, mStatistics.lastLatency_us);
+        mInputChange_us = -1;
+    }
+}
+
+void ManualControlInput::inputChanged()
+{
+    if (mInputChange_us < 0)
+        mInputChange_us = mClock.nsecsElapsed() / 1000;
+}
+
+double ManualControlInput::shapeAxis(double value) const
+{
+    const double deadzone = qBound(0.0, mConfig.gamepadDeadzone, 0.99);
+    if (fabs(value) <= deadzone)
+        return 0.0;
+
+    // Rescaled to start at 0 outside the deadzone, then expo: (1 - e) * x + e * x^3
+    const double x = qBound(-1.0, (fabs(value) - deadzone) / (1.0 - deadzone), 1.0) * (value > 0.0 ? 1.0 : -1.0);
+    const double expo = qBound(0.0, mConfig.expo, 1.0);
+    return (1.0 - expo) * x + expo * x * x * x;
+}
+
+double ManualControlInput::getMaxSignedStepFromValueTowardsGoal(double value, double goal, double maxStepSize)
+{
+    maxStepSize = fabs(maxStepSize);
+
+    if ((value < goal) && (value + maxStepSize) < goal)
+        return maxStepSize;
+
+    if ((value > goal) && (value - maxStepSize) > goal)
+        return -maxStepSize;
+
+    return goal - value;
+}
+
+#ifdef QT_GAMEPAD_LIB
+void ManualControlInput::updateGamepad()
+{
+    const QList<int> gamepads = QGamepadManager::instance()->connectedGamepads();
+    if (mGamepad && gamepads.contains(mGamepad->deviceId()))
+        return;
+
+    delete mGamepad;
+    mGamepad = nullptr;
+    if (gamepads.isEmpty())
+        return;
+
+    mGamepad = new QGamepad(gamepads.first(), this);
+    connect(mGamepad, &QGamepad::axisLeftYChanged, this, &ManualControlInput::inputChanged);
+    connect(mGamepad, &QGamepad::axisRightXChanged, this, &ManualControlInput::inputChanged);
+    qDebug() << "ManualControlInput: using gamepad" << mGamepad->name();
+}
+#endif
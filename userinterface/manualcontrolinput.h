@@ -0,0 +1,95 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Samples manual control input (arrow keys and, if the Qt Gamepad module is available, the first connected gamepad)
+ * at a fixed rate on its own precise timer, shapes it (deadzone, expo curve, first-order low-pass) and hands the result
+ * to VehicleConnection::setManualControl, which coalesces it for sending. The latency from an input change to its
+ * first hand-off is measured.
+ */
+
+#ifndef MANUALCONTROLINPUT_H
+#define MANUALCONTROLINPUT_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include "communication/vehicleconnections/vehicleconnection.h"
+
+#ifdef QT_GAMEPAD_LIB
+class QGamepad;
+#endif
+
+struct ManualControlInputConfig {
+    double keyboardThrottleRate = 0.75; // [1/s] ramp towards full throttle / neutral
+    double keyboardSteeringRate = 2.0; // [1/s]
+    double gamepadDeadzone = 0.05;
+    double expo = 0.3; // 0: linear, 1: cubic
+    double filterTimeConstant_s = 0.02; // 0: no filtering
+};
+
+struct ManualControlInputStatistics {
+    quint64 samples = 0;
+    quint64 handoffs = 0; // to the connection
+    qint64 lastLatency_us = 0; // input change to hand-off
+    qint64 maxLatency_us = 0;
+};
+
+class ManualControlInput : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int DEFAULT_SAMPLE_RATE_Hz = 100;
+
+    explicit ManualControlInput(QObject *parent = nullptr);
+    ~ManualControlInput();
+
+    void setVehicleConnection(const QSharedPointer<VehicleConnection> &vehicleConnection);
+    void setSampleRate(int sampleRate_Hz);
+    int getSampleRate() const { return mSampleRate_Hz; }
+    void setConfig(const ManualControlInputConfig &config) { mConfig = config; }
+    ManualControlInputConfig getConfig() const { return mConfig; }
+
+    // Returns false for keys that are not used for control
+    bool setKeyPressed(int key, bool pressed);
+    bool hasGamepad() const;
+
+    double getThrottle() const { return mThrottle; }
+    double getSteering() const { return mSteering; }
+    ManualControlInputStatistics getStatistics() const { return mStatistics; }
+    void resetStatistics() { mStatistics = ManualControlInputStatistics(); }
+
+signals:
+    void sampled(double throttle, double steering); // shaped values, at the sample rate
+
+private:
+    void sample();
+    void inputChanged(); // records the time of the first unhandled input change
+    double shapeAxis(double value) const;
+    static double getMaxSignedStepFromValueTowardsGoal(double value, double goal, double maxStepSize);
+#ifdef QT_GAMEPAD_LIB
+    void updateGamepad();
+#endif
+
+    QTimer mSampleTimer;
+    int mSampleRate_Hz = DEFAULT_SAMPLE_RATE_Hz;
+    QElapsedTimer mClock;
+    qint64 mLastSample_us = -1;
+    qint64 mInputChange_us = -1; // -1: no input change since the last hand-off
+    ManualControlInputConfig mConfig;
+    ManualControlInputStatistics mStatistics;
+    QSharedPointer<VehicleConnection> mVehicleConnection;
+
+    struct {bool upPressed, downPressed, leftPressed, rightPressed;} mArrowKeyStates {};
+    double mKeyThrottle = 0.0;
+    double mKeySteering = 0.0;
+    double mThrottle = 0.0;
+    double mSteering = 0.0;
+
+#ifdef QT_GAMEPAD_LIB
+    QGamepad *mGamepad = nullptr;
+#endif
+};
+
+#endif // MANUALCONTROLINPUT_H
@@ -0,0 +1,614 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "geotiffreader.h"
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+enum TiffTag : quint16 {
+    IMAGE_WIDTH = 256,
+    IMAGE_LENGTH = 257,
+    BITS_PER_SAMPLE = 258,
+    COMPRESSION = 259,
+    PHOTOMETRIC = 262,
+    STRIP_OFFSETS = 273,
+    SAMPLES_PER_PIXEL = 277,
+    ROWS_PER_STRIP = 278,
+    STRIP_BYTE_COUNTS = 279,
+    PLANAR_CONFIGURATION = 284,
+    PREDICTOR = 317,
+    TILE_WIDTH = 322,
+    TILE_LENGTH = 323,
+    TILE_OFFSETS = 324,
+    TILE_BYTE_COUNTS = 325,
+    EXTRA_SAMPLES = 338,
+    SAMPLE_FORMAT = 339,
+    JPEG_TABLES = 347,
+    MODEL_PIXEL_SCALE = 33550,
+    MODEL_TIEPOINT = 33922,
+    MODEL_TRANSFORMATION = 34264,
+    GEO_KEY_DIRECTORY = 34735
+};
+
+enum GeoKey : quint16 {
+    GT_MODEL_TYPE = 1024,
+    GT_RASTER_TYPE = 1025,
+    GEOGRAPHIC_TYPE = 2048,
+    PROJECTED_CS_TYPE = 3072
+};
+
+constexpr quint64 MAX_ENTRY_BYTES = 1ull << 30;
+}
+
+bool GeoTiffGeoreference::isProjectionSupported() const
+{
+    llh_t llh;
+    return valid && modelToLlh(QPointF(pixelToModel[2], pixelToModel[5]), llh);
+}
+
+bool GeoTiffGeoreference::modelToLlh(const QPointF &model, llh_t &llh) const
+{
+    if (geographic) {
+        if (epsg != 0 && epsg != 4326 && epsg != 4258 && epsg != 4619)
+            return false;
+        llh = {model.y(), model.x(), 0.0};
+        return true;
+    }
+
+    if ((epsg > 32600 && epsg <= 32660) || (epsg > 32700 && epsg <= 32760) || (epsg >= 25828 && epsg <= 25838)) {
+        const int zone = epsg % 100;
+        const bool south = epsg > 32700 && epsg <= 32760;
+        llh = coordinateTransforms::transverseMercatorToLlh(model.y(), model.x(), -183.0 + 6.0 * zone, 0.9996, south ? 10000000.0 : 0.0, 500000.0);
+        return true;
+    }
+    if (epsg == 3006) { // SWEREF99 TM
+        llh = coordinateTransforms::transverseMercatorToLlh(model.y(), model.x(), 15.0, 0.9996, 0.0, 500000.0);
+        return true;
+    }
+    if (epsg >= 3007 && epsg <= 3018) { // SWEREF99 12 00 ... 23 15
+        static constexpr double centralMeridians_deg[] = {12.0, 13.5, 15.0, 16.5, 18.0, 14.25, 15.75, 17.25, 18.75, 20.25, 21.75, 23.25};
+        llh = coordinateTransforms::transverseMercatorToLlh(model.y(), model.x(), centralMeridians_deg[epsg - 3007], 1.0, 0.0, 150000.0);
+        return true;
+    }
+    if (epsg == 3857 || epsg == 3785 || epsg == 900913) { // Web Mercator, spherical
+        llh = {atan(sinh(model.y() / RE_WGS84)) * 180.0 / M_PI, model.x() / RE_WGS84 * 180.0 / M_PI, 0.0};
+        return true;
+    }
+
+    return false;
+}
+
+bool GeoTiffReader::open(const QString &path, QString &errorString)
+{
+    close();
+    mFile.setFileName(path);
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        errorString = mFile.errorString();
+        return false;
+    }
+
+    const QByteArray header = mFile.read(16);
+    if (header.size() < 8 || (!header.startsWith("II") && !header.startsWith("MM"))) {
+        errorString = "not a TIFF file";
+        close();
+        return false;
+    }
+    mBigEndian = header.startsWith("MM");
+    const quint16 version = toUInt16(header.constData() + 2);
+    quint64 directoryOffset;
+    if (version == 42) {
+        mBigTiff = false;
+        directoryOffset = toUInt32(header.constData() + 4);
+    } else if (version == 43 && header.size() == 16 && toUInt16(header.constData() + 4) == 8) {
+        mBigTiff = true;
+        directoryOffset = toUInt64(header.constData() + 8);
+    } else {
+        errorString = "unsupported TIFF version";
+        close();
+        return false;
+    }
+
+    QVector<Entry> entries;
+    if (!readDirectory(directoryOffset, entries, errorString)) {
+        close();
+        return false;
+    }
+
+    auto fail = [this, &errorString](const QString &error) {
+        errorString = error;
+        close();
+        return false;
+    };
+
+    mWidth = (int)getUInt(entries, IMAGE_WIDTH, 0);
+    mHeight = (int)getUInt(entries, IMAGE_LENGTH, 0);
+    if (mWidth <= 0 || mHeight <= 0)
+        return fail("missing image size");
+
+    mSamplesPerPixel = (int)getUInt(entries, SAMPLES_PER_PIXEL, 1);
+    const QVector<quint64> bitsPerSample = getUInts(findEntry(entries, BITS_PER_SAMPLE));
+    for (quint64 bits : bitsPerSample)
+        if (bits != 8)
+            return fail("only 8 bits per sample are supported");
+    const QVector<quint64> sampleFormat = getUInts(findEntry(entries, SAMPLE_FORMAT));
+    for (quint64 format : sampleFormat)
+        if (format != 1)
+            return fail("only unsigned integer samples are supported");
+    if (getUInt(entries, PLANAR_CONFIGURATION, 1) != 1 && mSamplesPerPixel > 1)
+        return fail("only chunky (interleaved) samples are supported");
+
+    mCompression = (int)getUInt(entries, COMPRESSION, 1);
+    if (mCompression != 1 && mCompression != 5 && mCompression != 7 && mCompression != 8 && mCompression != 32946 && mCompression != 32773)
+        return fail(QString("unsupported compression %1").arg(mCompression));
+    mPredictor = (int)getUInt(entries, PREDICTOR, 1);
+    if (mPredictor != 1 && mPredictor != 2)
+        return fail(QString("unsupported predictor %1").arg(mPredictor));
+
+    const int photometric = (int)getUInt(entries, PHOTOMETRIC, mSamplesPerPixel >= 3 ? 2 : 1);
+    switch (photometric) {
+    case 0: mWhiteIsZero = true; mColorSamples = 1; break;
+    case 1: mColorSamples = 1; break;
+    case 2: mColorSamples = 3; break;
+    case 6: // YCbCr, decoded by the JPEG decoder
+        if (mCompression != 7)
+            return fail("YCbCr is only supported with JPEG compression");
+        mColorSamples = 3;
+        break;
+    default: return fail(QString("unsupported photometric interpretation %1").arg(photometric));
+    }
+    if (mSamplesPerPixel < mColorSamples)
+        return fail("too few samples per pixel");
+
+    const QVector<quint64> extraSamples = getUInts(findEntry(entries, EXTRA_SAMPLES));
+    if (mSamplesPerPixel > mColorSamples && !extraSamples.isEmpty() && (extraSamples.first() == 1 || extraSamples.first() == 2)) {
+        mAlphaSample = mColorSamples;
+        mAlphaPremultiplied = extraSamples.first() == 1;
+    }
+    if (mCompression == 7 && mSamplesPerPixel != mColorSamples)
+        return fail("JPEG compression is only supported without extra samples");
+
+    mTiled = findEntry(entries, TILE_OFFSETS) != nullptr;
+    if (mTiled) {
+        mBlockWidth = (int)getUInt(entries, TILE_WIDTH, 0);
+        mBlockHeight = (int)getUInt(entries, TILE_LENGTH, 0);
+        mBlockOffsets = getUInts(findEntry(entries, TILE_OFFSETS));
+        mBlockByteCounts = getUInts(findEntry(entries, TILE_BYTE_COUNTS));
+    } else {
+        mBlockWidth = mWidth;
+        mBlockHeight = (int)std::min<quint64>(getUInt(entries, ROWS_PER_STRIP, mHeight), mHeight);
+        mBlockOffsets = getUInts(findEntry(entries, STRIP_OFFSETS));
+        mBlockByteCounts = getUInts(findEntry(entries, STRIP_BYTE_COUNTS));
+    }
+    if (mBlockWidth <= 0 || mBlockHeight <= 0)
+        return fail("missing tile size");
+    const int blockCount = getBlocksAcross() * getBlocksDown();
+    if (mBlockOffsets.size() != blockCount || mBlockByteCounts.size() != blockCount)
+        return fail("block offsets do not match the image size");
+    if ((qint64)mBlockWidth * mBlockHeight * mSamplesPerPixel > std::numeric_limits<int>::max())
+        return fail("blocks are too large");
+
+    if (const Entry *jpegTables = findEntry(entries, JPEG_TABLES)) {
+        mJpegTables = jpegTables->value;
+        if (mJpegTables.endsWith("\xff\xd9"))
+            mJpegTables.chop(2);
+    }
+
+    readGeoreference(entries);
+    return true;
+}
+
+void GeoTiffReader::close()
+{
+    mFile.close();
+    mWidth = mHeight = mBlockWidth = mBlockHeight = 0;
+    mSamplesPerPixel = mColorSamples = 1;
+    mAlphaSample = -1;
+    mAlphaPremultiplied = false;
+    mWhiteIsZero = false;
+    mCompression = mPredictor = 1;
+    mJpegTables.clear();
+    mBlockOffsets.clear();
+    mBlockByteCounts.clear();
+    mGeoreference = GeoTiffGeoreference();
+}
+
+QImage GeoTiffReader::readBlock(int blockX, int blockY, QString *errorString)
+{
+    QString error;
+    auto fail = [&](const QString &message) {
+        if (errorString)
+            *errorString = message;
+        return QImage();
+    };
+
+    if (!mFile.isOpen() || blockX < 0 || blockY < 0 || blockX >= getBlocksAcross() || blockY >= getBlocksDown())
+        return fail("block out of range");
+
+    const int index = blockY * getBlocksAcross() + blockX;
+    const int rows = mTiled ? mBlockHeight : std::min(mBlockHeight, mHeight - blockY * mBlockHeight);
+    const int rowBytes = mBlockWidth * mSamplesPerPixel;
+    const QImage::Format format = hasAlpha() ? (mAlphaPremultiplied ? QImage::Format_RGBA8888_Premultiplied : QImage::Format_RGBA8888) : QImage::Format_RGB888;
+
+    QByteArray data;
+    if (mBlockByteCounts.at(index) > 0) {
+        if (mBlockByteCounts.at(index) > MAX_ENTRY_BYTES || !mFile.seek((qint64)mBlockOffsets.at(index)))
+            return fail("invalid block offset");
+        data = mFile.read((qint64)mBlockByteCounts.at(index));
+        if (data.size() != (int)mBlockByteCounts.at(index))
+            return fail("truncated file");
+    }
+    if (data.isEmpty()) { // sparse file, block not written
+        QImage image(mBlockWidth, rows, format);
+        image.fill(Qt::transparent);
+        return image;
+    }
+
+    if (mCompression == 7) {
+        QByteArray jpeg = data;
+        if (!mJpegTables.isEmpty() && data.startsWith("\xff\xd8"))
+            jpeg = mJpegTables + data.mid(2);
+        QImage image;
+        if (!image.loadFromData(jpeg, "JPG"))
+            return fail("JPEG decoding failed");
+        image = image.convertToFormat(QImage::Format_RGB888);
+        if (image.width() != mBlockWidth || image.height() != rows)
+            image = image.copy(0, 0, mBlockWidth, rows);
+        return image;
+    }
+
+    QByteArray raw = decompress(data, rowBytes * rows, error);
+    if (raw.isEmpty())
+        return fail(error);
+    if (raw.size() < rowBytes * rows)
+        raw.append(QByteArray(rowBytes * rows - raw.size(), '\0')); // some writers truncate the padding
+
+    uchar *samples = reinterpret_cast<uchar*>(raw.data());
+    if (mPredictor == 2)
+        for (int row = 0; row < rows; row++) {
+            uchar *rowSamples = samples + (qint64)row * rowBytes;
+            for (int i = mSamplesPerPixel; i < rowBytes; i++)
+                rowSamples[i] += rowSamples[i - mSamplesPerPixel];
+        }
+
+    QImage image(mBlockWidth, rows, format);
+    const int outChannels = hasAlpha() ? 4 : 3;
+    for (int row = 0; row < rows; row++) {
+        const uchar *in = samples + (qint64)row * rowBytes;
+        uchar *out = image.scanLine(row);
+        if (mColorSamples == 3 && mSamplesPerPixel == outChannels) {
+            memcpy(out, in, rowBytes);
+            continue;
+        }
+        for (int column = 0; column < mBlockWidth; column++, in += mSamplesPerPixel, out += outChannels) {
+            if (mColorSamples == 3) {
+                out[0] = in[0]; out[1] = in[1]; out[2] = in[2];
+            } else {
+                const uchar gray = mWhiteIsZero ? 255 - in[0] : in[0];
+                out[0] = out[1] = out[2] = gray;
+            }
+            if (hasAlpha())
+                out[3] = in[mAlphaSample];
+        }
+    }
+    return image;
+}
+
+bool GeoTiffReader::readDirectory(quint64 offset, QVector<Entry> &entries, QString &errorString)
+{
+    const int countSize = mBigTiff ? 8 : 2;
+    const int entrySize = mBigTiff ? 20 : 12;
+    const int inlineSize = mBigTiff ? 8 : 4;
+
+    if (!mFile.seek((qint64)offset)) {
+        errorString = "invalid directory offset";
+        return false;
+    }
+    const QByteArray countData = mFile.read(countSize);
+    if (countData.size() != countSize) {
+        errorString = "truncated file";
+        return false;
+    }
+    const quint64 count = mBigTiff ? toUInt64(countData.constData()) : toUInt16(countData.constData());
+    const QByteArray directory = mFile.read((qint64)(count * entrySize));
+    if ((quint64)directory.size() != count * entrySize) {
+        errorString = "truncated file";
+        return false;
+    }
+
+    entries.clear();
+    for (quint64 i = 0; i < count; i++) {
+        const char *data = directory.constData() + i * entrySize;
+        Entry entry;
+        entry.tag = toUInt16(data);
+        entry.type = toUInt16(data + 2);
+        entry.count = mBigTiff ? toUInt64(data + 4) : toUInt32(data + 4);
+        const char *valueData = data + (mBigTiff ? 12 : 8);
+
+        const int size = typeSize(entry.type);
+        if (size == 0)
+            continue; // unknown type, not needed
+        const quint64 bytes = entry.count * size;
+        if (bytes > MAX_ENTRY_BYTES) {
+            errorString = "invalid directory entry";
+            return false;
+        }
+        if (bytes <= (quint64)inlineSize)
+            entry.value = QByteArray(valueData, (int)bytes);
+        else {
+            const quint64 valueOffset = mBigTiff ? toUInt64(valueData) : toUInt32(valueData);
+            if (!mFile.seek((qint64)valueOffset)) {
+                errorString = "invalid directory entry";
+                return false;
+            }
+            entry.value = mFile.read((qint64)bytes);
+            if ((quint64)entry.value.size() != bytes) {
+                errorString = "truncated file";
+                return false;
+            }
+        }
+        entries.append(entry);
+    }
+    return true;
+}
+
+const GeoTiffReader::Entry *GeoTiffReader::findEntry(const QVector<Entry> &entries, quint16 tag) const
+{
+    for (const Entry &entry : entries)
+        if (entry.tag == tag)
+            return &entry;
+    return nullptr;
+}
+
+QVector<quint64> GeoTiffReader::getUInts(const Entry *entry) const
+{
+    QVector<quint64> values;
+    if (!entry)
+        return values;
+
+    const int size = typeSize(entry->type);
+    values.reserve((int)entry->count);
+    for (quint64 i = 0; i < entry->count; i++) {
+        const char *data = entry->value.constData() + i * size;
+        switch (entry->type) {
+        case 1: case 7: values.append((uchar)*data); break;
+        case 3: values.append(toUInt16(data)); break;
+        case 4: case 13: values.append(toUInt32(data)); break;
+        case 16: case 18: values.append(toUInt64(data)); break;
+        default: return QVector<quint64>();
+        }
+    }
+    return values;
+}
+
+QVector<double> GeoTiffReader::getDoubles(const Entry *entry) const
+{
+    QVector<double> values;
+    if (!entry)
+        return values;
+
+    const int size = typeSize(entry->type);
+    values.reserve((int)entry->count);
+    for (quint64 i = 0; i < entry->count; i++) {
+        const char *data = entry->value.constData() + i * size;
+        switch (entry->type) {
+        case 1: values.append((uchar)*data); break;
+        case 3: values.append(toUInt16(data)); break;
+        case 4: values.append(toUInt32(data)); break;
+        case 5: values.append(toUInt32(data + 4) != 0 ? (double)toUInt32(data) / toUInt32(data + 4) : 0.0); break;
+        case 8: values.append((qint16)toUInt16(data)); break;
+        case 9: values.append((qint32)toUInt32(data)); break;
+        case 10: values.append(toUInt32(data + 4) != 0 ? (double)(qint32)toUInt32(data) / (qint32)toUInt32(data + 4) : 0.0); break;
+        case 11: { const quint32 bits = toUInt32(data); float value; memcpy(&value, &bits, sizeof(value)); values.append(value); break; }
+        case 12: values.append(toDouble(data)); break;
+        case 16: values.append((double)toUInt64(data)); break;
+        case 17: values.append((double)(qint64)toUInt64(data)); break;
+        default: return QVector<double>();
+        }
+    }
+    return values;
+}
+
+quint64 GeoTiffReader::getUInt(const QVector<Entry> &entries, quint16 tag, quint64 defaultValue) const
+{
+    const QVector<quint64> values = getUInts(findEntry(entries, tag));
+    return values.isEmpty() ? defaultValue : values.first();
+}
+
+quint16 GeoTiffReader::toUInt16(const char *data) const
+{
+    return mBigEndian ? qFromBigEndian<quint16>(data) : qFromLittleEndian<quint16>(data);
+}
+
+quint32 GeoTiffReader::toUInt32(const char *data) const
+{
+    return mBigEndian ? qFromBigEndian<quint32>(data) : qFromLittleEndian<quint32>(data);
+}
+
+quint64 GeoTiffReader::toUInt64(const char *data) const
+{
+    return mBigEndian ? qFromBigEndian<quint64>(data) : qFromLittleEndian<quint64>(data);
+}
+
+double GeoTiffReader::toDouble(const char *data) const
+{
+    const quint64 bits = toUInt64(data);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+int GeoTiffReader::typeSize(quint16 type)
+{
+    switch (type) {
+    case 1: case 2: case 6: case 7: return 1; // BYTE, ASCII, SBYTE, UNDEFINED
+    case 3: case 8: return 2; // SHORT, SSHORT
+    case 4: case 9: case 11: case 13: return 4; // LONG, SLONG, FLOAT, IFD
+    case 5: case 10: case 12: case 16: case 17: case 18: return 8; // RATIONAL, SRATIONAL, DOUBLE, LONG8, SLONG8, IFD8
+    default: return 0;
+    }
+}
+
+void GeoTiffReader::readGeoreference(const QVector<Entry> &entries)
+{
+    GeoTiffGeoreference georeference;
+
+    int modelType = 0, rasterType = 1, geographicType = 0, projectedType = 0;
+    const QVector<quint64> keys = getUInts(findEntry(entries, GEO_KEY_DIRECTORY));
+    if (keys.size() >= 4) {
+        const int keyCount = std::min<int>((int)keys.at(3), (keys.size() - 4) / 4);
+        for (int i = 0; i < keyCount; i++) {
+            const quint64 *key = keys.constData() + 4 + i * 4;
+            if (key[1] != 0) // value not inline, none of the keys used are
+                continue;
+            switch (key[0]) {
+            case GT_MODEL_TYPE: modelType = (int)key[3]; break;
+            case GT_RASTER_TYPE: rasterType = (int)key[3]; break;
+            case GEOGRAPHIC_TYPE: geographicType = (int)key[3]; break;
+            case PROJECTED_CS_TYPE: projectedType = (int)key[3]; break;
+            default: break;
+            }
+        }
+    }
+    georeference.geographic = modelType == 2 || (modelType == 0 && projectedType == 0 && geographicType != 0);
+    georeference.epsg = georeference.geographic ? geographicType : projectedType;
+
+    double *m = georeference.pixelToModel;
+    const QVector<double> transformation = getDoubles(findEntry(entries, MODEL_TRANSFORMATION));
+    const QVector<double> scale = getDoubles(findEntry(entries, MODEL_PIXEL_SCALE));
+    const QVector<double> tiepoints = getDoubles(findEntry(entries, MODEL_TIEPOINT));
+    if (transformation.size() == 16) {
+        m[0] = transformation.at(0); m[1] = transformation.at(1); m[2] = transformation.at(3);
+        m[3] = transformation.at(4); m[4] = transformation.at(5); m[5] = transformation.at(7);
+        georeference.valid = true;
+    } else if (scale.size() >= 2 && tiepoints.size() >= 6) {
+        // Raster (I, J) -> model (X, Y), y axis of the model up
+        m[0] = scale.at(0); m[1] = 0.0; m[2] = tiepoints.at(3) - tiepoints.at(0) * scale.at(0);
+        m[3] = 0.0; m[4] = -scale.at(1); m[5] = tiepoints.at(4) + tiepoints.at(1) * scale.at(1);
+        georeference.valid = true;
+    }
+
+    if (georeference.valid && rasterType == 2) { // PixelIsPoint: raster coordinates are pixel centers
+        m[2] -= 0.5 * (m[0] + m[1]);
+        m[5] -= 0.5 * (m[3] + m[4]);
+    }
+
+    mGeoreference = georeference;
+}
+
+QByteArray GeoTiffReader::decompress(const QByteArray &data, int expectedBytes, QString &errorString) const
+{
+    QByteArray result;
+    switch (mCompression) {
+    case 1: result = data; break;
+    case 5: result = decodeLzw(data, expectedBytes); break;
+    case 8: case 32946: {
+        // qUncompress expects the uncompressed size in front of the zlib stream
+        QByteArray prefixed(4, '\0');
+        qToBigEndian<quint32>((quint32)expectedBytes, prefixed.data());
+        result = qUncompress(prefixed + data);
+        break;
+    }
+    case 32773: result = decodePackBits(data, expectedBytes); break;
+    default: break;
+    }
+    if (result.isEmpty())
+        errorString = "decompression failed";
+    return result;
+}
+
+QByteArray GeoTiffReader::decodeLzw(const QByteArray &data, int expectedBytes)
+{
+    static constexpr int CLEAR_CODE = 256;
+    static constexpr int END_CODE = 257;
+    static constexpr int MAX_CODES = 4096;
+
+    if (data.size() >= 2 && data.at(0) == 0 && (data.at(1) & 0x01))
+        return QByteArray(); // old-style (LSB first) LZW
+
+    std::vector<int> prefix(MAX_CODES, -1), length(MAX_CODES, 1);
+    std::vector<uchar> suffix(MAX_CODES), first(MAX_CODES);
+    for (int i = 0; i < 256; i++)
+        suffix[i] = first[i] = (uchar)i;
+
+    QByteArray out;
+    out.reserve(expectedBytes);
+    const uchar *in = reinterpret_cast<const uchar*>(data.constData());
+    quint32 bitBuffer = 0;
+    int bitCount = 0, position = 0;
+    int nextCode = 258, codeWidth = 9, previous = -1;
+
+    while (out.size() < expectedBytes) {
+        while (bitCount < codeWidth && position < data.size()) {
+            bitBuffer = (bitBuffer << 8) | in[position++];
+            bitCount += 8;
+        }
+        if (bitCount < codeWidth)
+            break;
+        const int code = (bitBuffer >> (bitCount - codeWidth)) & ((1 << codeWidth) - 1);
+        bitCount -= codeWidth;
+
+        if (code == END_CODE)
+            break;
+        if (code == CLEAR_CODE) {
+            nextCode = 258;
+            codeWidth = 9;
+            previous = -1;
+            continue;
+        }
+        if (previous < 0) {
+            if (code >= 256)
+                break; // corrupt
+            out.append((char)code);
+            previous = code;
+            continue;
+        }
+        if (code > nextCode)
+            break; // corrupt
+
+        // New entry: previous string + first byte of the current one (of previous itself for the code being defined)
+        if (nextCode < MAX_CODES) {
+            prefix[nextCode] = previous;
+            suffix[nextCode] = code < nextCode ? first[code] : first[previous];
+            first[nextCode] = first[previous];
+            length[nextCode] = length[previous] + 1;
+            nextCode++;
+            if (nextCode + 1 >= (1 << codeWidth) && codeWidth < 12) // "early change"
+                codeWidth++;
+        }
+
+        const int end = out.size() + length[code];
+        out.resize(end);
+        char *write = out.data() + end;
+        for (int c = code; c >= 0; c = prefix[c])
+            *--write = (char)suffix[c];
+        previous = code;
+    }
+
+    if (out.size() > expectedBytes)
+        out.truncate(expectedBytes);
+    return out;
+}
+
+QByteArray GeoTiffReader::decodePackBits(const QByteArray &data, int expectedBytes)
+{
+    QByteArray out;
+    out.reserve(expectedBytes);
+    int position = 0;
+    while (position < data.size() && out.size() < expectedBytes) {
+        const int n = (signed char)data.at(position++);
+        if (n >= 0) {
+            const int count = std::min(n + 1, data.size() - position);
+            out.append(data.constData() + position, count);
+            position += count;
+        } else if (n != -128 && position < data.size())
+            out.append(QByteArray(1 - n, data.at(position++)));
+    }
+    if (out.size() > expectedBytes)
+        out.truncate(expectedBytes);
+    return out;
+}
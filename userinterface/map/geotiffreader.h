@@ -0,0 +1,106 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Minimal reader for (Big)TIFF images with GeoTIFF georeferencing, e.g., drone orthophotos, block by block (strips or tiles)
+ * so that images far larger than memory can be converted (see RasterOverlayModule). Only the first image (full resolution) is read.
+ * Supported: 8 bit gray, gray + alpha, RGB and RGBA, chunky (interleaved) samples; uncompressed, LZW, Deflate, PackBits and JPEG
+ * compression; horizontal predictor. Projections by EPSG code: geographic (WGS84, ETRS89, SWEREF99), UTM (WGS84 and ETRS89),
+ * SWEREF99 TM and its local zones, and Web Mercator.
+ */
+
+#ifndef GEOTIFFREADER_H
+#define GEOTIFFREADER_H
+
+#include <QFile>
+#include <QImage>
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+#include "core/coordinatetransforms.h"
+
+struct GeoTiffGeoreference {
+    bool valid = false;
+    // Pixel (column, row, at the top left corner of the pixel) to model coordinates: x = a * column + b * row + c, y = d * column + e * row + f
+    double pixelToModel[6] = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0};
+    int epsg = 0; // of the model coordinates, projected or geographic
+    bool geographic = false; // model coordinates are longitude, latitude [deg]
+
+    QPointF pixelToModelCoordinates(double column, double row) const {
+        return QPointF(pixelToModel[0] * column + pixelToModel[1] * row + pixelToModel[2],
+                pixelToModel[3] * column + pixelToModel[4] * row + pixelToModel[5]);
+    }
+    // false for unsupported projections
+    bool modelToLlh(const QPointF &model, llh_t &llh) const;
+    bool pixelToLlh(double column, double row, llh_t &llh) const { return modelToLlh(pixelToModelCoordinates(column, row), llh); }
+    bool isProjectionSupported() const;
+};
+
+class GeoTiffReader
+{
+public:
+    // Reads the directory and georeferencing, errorString set on failure (also for unsupported formats)
+    bool open(const QString &path, QString &errorString);
+    void close();
+    bool isOpen() const { return mFile.isOpen(); }
+
+    int getWidth() const { return mWidth; }
+    int getHeight() const { return mHeight; }
+    bool hasAlpha() const { return mAlphaSample >= 0; }
+    const GeoTiffGeoreference &getGeoreference() const { return mGeoreference; }
+
+    // Blocks are strips (block width: image width) or tiles, in rows of blocksAcross
+    int getBlockWidth() const { return mBlockWidth; }
+    int getBlockHeight() const { return mBlockHeight; }
+    int getBlocksAcross() const { return (mWidth + mBlockWidth - 1) / mBlockWidth; }
+    int getBlocksDown() const { return (mHeight + mBlockHeight - 1) / mBlockHeight; }
+    // Format_RGB888 or Format_RGBA8888(_Premultiplied) (hasAlpha), block size (tiles at the edges include their padding,
+    // the last strip is shorter). Null image and errorString on failure.
+    QImage readBlock(int blockX, int blockY, QString *errorString = nullptr);
+
+private:
+    struct Entry {
+        quint16 tag;
+        quint16 type;
+        quint64 count;
+        QByteArray value; // raw, count * size of type
+    };
+
+    bool readDirectory(quint64 offset, QVector<Entry> &entries, QString &errorString);
+    const Entry *findEntry(const QVector<Entry> &entries, quint16 tag) const;
+    QVector<quint64> getUInts(const Entry *entry) const;
+    QVector<double> getDoubles(const Entry *entry) const;
+    quint64 getUInt(const QVector<Entry> &entries, quint16 tag, quint64 defaultValue) const;
+    quint16 toUInt16(const char *data) const;
+    quint32 toUInt32(const char *data) const;
+    quint64 toUInt64(const char *data) const;
+    double toDouble(const char *data) const;
+    static int typeSize(quint16 type);
+    void readGeoreference(const QVector<Entry> &entries);
+
+    QByteArray decompress(const QByteArray &data, int expectedBytes, QString &errorString) const;
+    static QByteArray decodeLzw(const QByteArray &data, int expectedBytes);
+    static QByteArray decodePackBits(const QByteArray &data, int expectedBytes);
+
+    QFile mFile;
+    bool mBigEndian = false;
+    bool mBigTiff = false;
+    int mWidth = 0;
+    int mHeight = 0;
+    int mBlockWidth = 0;
+    int mBlockHeight = 0;
+    bool mTiled = false;
+    int mSamplesPerPixel = 1;
+    int mColorSamples = 1; // 1: gray, 3: RGB
+    int mAlphaSample = -1; // index of the alpha sample, -1: none
+    bool mAlphaPremultiplied = false;
+    bool mWhiteIsZero = false;
+    int mCompression = 1;
+    int mPredictor = 1;
+    QByteArray mJpegTables; // without the end of image marker
+    QVector<quint64> mBlockOffsets;
+    QVector<quint64> mBlockByteCounts;
+    GeoTiffGeoreference mGeoreference;
+};
+
+#endif // GEOTIFFREADER_H
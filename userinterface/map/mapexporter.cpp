@@ -0,0 +1,234 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "mapexporter.h"
+#include <QPainter>
+#include <QPdfWriter>
+#include <QImageWriter>
+#include <QDebug>
+#include <algorithm>
+
+MapExporter::MapExporter(QSharedPointer<OsmClient> osm, QObject *parent) : QObject(parent), mOsm(osm)
+{
+    mThreadContext = new QObject();
+    mThread.setObjectName("Map export");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start(QThread::LowPriority);
+
+    mPollTimer.setInterval(TILE_POLL_INTERVAL_ms);
+    connect(&mPollTimer, &QTimer::timeout, this, &MapExporter::pollTiles);
+}
+
+MapExporter::~MapExporter()
+{
+    mCancel = true;
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+}
+
+bool MapExporter::start(const Job &job)
+{
+    if (mRunning || job.width <= 0 || job.height <= 0)
+        return false;
+
+    mRunning = true;
+    mCancel = false;
+    mJob = job;
+    mTileImages.clear();
+    mPendingTiles.clear();
+    for (int i = 0; i < mJob.tiles.size(); i++)
+        mPendingTiles.insert(calcKey(mJob.tiles.at(i).zoom, mJob.tiles.at(i).x, mJob.tiles.at(i).y), i);
+
+    if (mOsm)
+        connect(mOsm.get(), &OsmClient::tileReady, this, &MapExporter::tileReady, Qt::UniqueConnection);
+    mLastTileTimer.start();
+    mPollTimer.start();
+    // First signals after the caller had a chance to connect
+    QTimer::singleShot(0, this, &MapExporter::pollTiles);
+
+    return true;
+}
+
+void MapExporter::cancel()
+{
+    mCancel = true;
+}
+
+void MapExporter::tileReady(OsmTile tile)
+{
+    const quint64 key = calcKey(tile.zoom(), tile.x(), tile.y());
+    if (mPendingTiles.contains(key))
+        tileLoaded(key, tile.pixmap().toImage());
+}
+
+void MapExporter::tileLoaded(quint64 key, const QImage &image)
+{
+    mTileImages.insert(key, image);
+    mPendingTiles.remove(key);
+    mLastTileTimer.restart();
+}
+
+void MapExporter::pollTiles()
+{
+    if (!mRunning || !mPollTimer.isActive())
+        return;
+
+    if (mCancel) {
+        mPollTimer.stop();
+        if (mOsm)
+            disconnect(mOsm.get(), &OsmClient::tileReady, this, &MapExporter::tileReady);
+        mJob = Job();
+        mTileImages.clear();
+        mPendingTiles.clear();
+        mRunning = false;
+        emit finished(false, QString());
+        return;
+    }
+
+    // Tiles are requested again on every poll, OsmClient drops queued downloads that are not in its view anymore
+    QVector<QPair<quint64, QImage>> loadedTiles;
+    QVector<quint64> missingTiles;
+    for (auto it = mPendingTiles.constBegin(); mOsm && it != mPendingTiles.constEnd(); it++) {
+        const Tile &tile = mJob.tiles.at(it.value());
+        int res;
+        const OsmTile osmTile = mOsm->getTile(tile.zoom, tile.x, tile.y, res);
+        if (res > 0)
+            loadedTiles.append({it.key(), osmTile.pixmap().toImage()});
+        else if (res == -1 || (res == 0 && mOsm->downloadTile(tile.zoom, tile.x, tile.y, it.value()) == -3))
+            missingTiles.append(it.key()); // outside of the map or no tile server
+    }
+
+    for (const auto &loadedTile : loadedTiles)
+        tileLoaded(loadedTile.first, loadedTile.second);
+    for (quint64 key : missingTiles)
+        mPendingTiles.remove(key);
+
+    emit tilesProgress(mJob.tiles.size() - mPendingTiles.size(), mJob.tiles.size());
+
+    if (!mOsm || mPendingTiles.isEmpty() || mLastTileTimer.elapsed() > TILE_WAIT_TIMEOUT_ms) {
+        if (!mPendingTiles.isEmpty())
+            qWarning() << "MapExporter:" << mPendingTiles.size() << "OSM tiles did not arrive, exporting without them.";
+        startRendering();
+    }
+}
+
+void MapExporter::startRendering()
+{
+    mPollTimer.stop();
+    if (mOsm)
+        disconnect(mOsm.get(), &OsmClient::tileReady, this, &MapExporter::tileReady);
+
+    const Job job = mJob;
+    const QHash<quint64, QImage> tileImages = mTileImages;
+    mJob = Job();
+    mTileImages.clear();
+    mPendingTiles.clear();
+
+    QMetaObject::invokeMethod(mThreadContext, [this, job, tileImages]() {
+        render(job, tileImages);
+    }, Qt::QueuedConnection);
+}
+
+void MapExporter::render(const Job &job, const QHash<quint64, QImage> &tileImages)
+{
+    QString errorString;
+    bool success = false;
+    if (!mCancel)
+        success = job.path.endsWith(".pdf", Qt::CaseInsensitive) ? renderPdf(job, tileImages, errorString) :
+                                                                   renderImage(job, tileImages, errorString);
+
+    const bool canceled = mCancel;
+    QMetaObject::invokeMethod(this, [this, success, canceled, errorString]() {
+        mRunning = false;
+        emit finished(success && !canceled, canceled ? QString() : errorString);
+    }, Qt::QueuedConnection);
+}
+
+void MapExporter::drawTiles(QPainter &painter, const Job &job, const QHash<quint64, QImage> &tileImages, const QRectF &clip)
+{
+    painter.save();
+    painter.setTransform(job.tileTrans, true);
+    for (const auto &tile : job.tiles) {
+        const auto image = tileImages.constFind(calcKey(tile.zoom, tile.x, tile.y));
+        if (image != tileImages.constEnd() && job.tileTrans.mapRect(tile.rect).intersects(clip))
+            painter.drawImage(tile.rect, *image);
+    }
+    painter.restore();
+}
+
+bool MapExporter::renderImage(const Job &job, const QHash<quint64, QImage> &tileImages, QString &errorString)
+{
+    QImage image(job.width, job.height, QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull()) {
+        errorString = "Could not allocate a " + QString::number(job.width) + "x" + QString::number(job.height) + " image.";
+        return false;
+    }
+    image.fill(Qt::transparent);
+
+    // Bands bound the work between progress updates and cancel checks
+    for (int top = 0; top < job.height; top += BAND_HEIGHT_px) {
+        if (mCancel)
+            return false;
+
+        const QRect band(0, top, job.width, std::min(BAND_HEIGHT_px, job.height - top));
+        QPainter painter(&image);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+        painter.setClipRect(band);
+        drawTiles(painter, job, tileImages, band);
+        painter.drawPicture(0, 0, job.overlay);
+        painter.end();
+
+        const int rowsRendered = band.bottom() + 1;
+        const int rowsTotal = job.height;
+        QMetaObject::invokeMethod(this, [this, rowsRendered, rowsTotal]() {
+            emit renderProgress(rowsRendered, rowsTotal);
+        }, Qt::QueuedConnection);
+    }
+
+    QImageWriter writer(job.path);
+    if (!writer.write(image)) {
+        errorString = "Could not write \"" + job.path + "\": " + writer.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool MapExporter::renderPdf(const Job &job, const QHash<quint64, QImage> &tileImages, QString &errorString)
+{
+    // One point per pixel, drawings of the overlay stay vectors
+    QPdfWriter writer(job.path);
+    writer.setCreator("ControlTower");
+    writer.setTitle("Map");
+    writer.setResolution(72);
+    writer.setPageLayout(QPageLayout(QPageSize(QSize(job.width, job.height), QPageSize::Point, QString(), QPageSize::ExactMatch),
+                                     QPageLayout::Portrait, QMarginsF(0, 0, 0, 0)));
+
+    QPainter painter;
+    if (!painter.begin(&writer)) {
+        errorString = "Could not open \"" + job.path + "\" for writing.";
+        return false;
+    }
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+
+    drawTiles(painter, job, tileImages, QRectF(0, 0, job.width, job.height));
+    if (mCancel)
+        return false;
+    const int rowsTotal = job.height;
+    QMetaObject::invokeMethod(this, [this, rowsTotal]() {
+        emit renderProgress(0, rowsTotal);
+    }, Qt::QueuedConnection);
+
+    painter.drawPicture(0, 0, job.overlay);
+    if (!painter.end()) {
+        errorString = "Could not write \"" + job.path + "\".";
+        return false;
+    }
+
+    QMetaObject::invokeMethod(this, [this, rowsTotal]() {
+        emit renderProgress(rowsTotal, rowsTotal);
+    }, Qt::QueuedConnection);
+    return true;
+}
@@ -0,0 +1,95 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Exports a map view to PDF or an image file (PNG etc., by suffix) without blocking the GUI thread, see MapWidget::exportMap.
+ * The OSM tiles of the view are first fetched through OsmClient (memory/disk cache or download), tiles that do not
+ * arrive within TILE_WAIT_TIMEOUT_ms are left out. Everything else (grid, map modules, object states) is recorded
+ * into a QPicture on the GUI thread by MapWidget. Rendering then runs on a worker thread: images are rendered in
+ * bands of BAND_HEIGHT_px rows, PDFs keep the recorded drawings as vectors.
+ * Signals are emitted in the thread the exporter lives in.
+ */
+
+#ifndef MAPEXPORTER_H
+#define MAPEXPORTER_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QPicture>
+#include <QTransform>
+#include <QHash>
+#include <QImage>
+#include <atomic>
+#include "osmclient.h"
+
+class MapExporter : public QObject
+{
+    Q_OBJECT
+public:
+    struct Tile {
+        int zoom;
+        int x;
+        int y;
+        QRectF rect; // in tileTrans coordinates
+    };
+
+    struct Job {
+        QString path;
+        int width;
+        int height;
+        QTransform tileTrans;
+        QVector<Tile> tiles;
+        QPicture overlay; // drawn on top of the tiles, in output pixels
+    };
+
+    explicit MapExporter(QSharedPointer<OsmClient> osm, QObject *parent = nullptr);
+    ~MapExporter();
+
+    // Only one export at a time, returns false if an export is already running
+    bool start(const Job &job);
+    // Stops as soon as possible, finished() follows with success false and an empty errorString
+    void cancel();
+    bool isRunning() const { return mRunning; }
+
+    static constexpr int BAND_HEIGHT_px = 2048;
+    static constexpr int TILE_WAIT_TIMEOUT_ms = 30000; // without any tile arriving
+    static constexpr int TILE_POLL_INTERVAL_ms = 250;
+
+signals:
+    void tilesProgress(int tilesLoaded, int tilesTotal);
+    void renderProgress(int rowsRendered, int rowsTotal);
+    void finished(bool success, const QString &errorString);
+
+private slots:
+    void tileReady(OsmTile tile);
+    void pollTiles();
+
+private:
+    void tileLoaded(quint64 key, const QImage &image);
+    void startRendering();
+
+    // Worker thread
+    void render(const Job &job, const QHash<quint64, QImage> &tileImages);
+    void drawTiles(QPainter &painter, const Job &job, const QHash<quint64, QImage> &tileImages, const QRectF &clip);
+    bool renderImage(const Job &job, const QHash<quint64, QImage> &tileImages, QString &errorString);
+    bool renderPdf(const Job &job, const QHash<quint64, QImage> &tileImages, QString &errorString);
+
+    static quint64 calcKey(int zoom, int x, int y) { return ((quint64)zoom << 48) | ((quint64)x << 24) | (quint64)y; }
+
+    QSharedPointer<OsmClient> mOsm;
+    QThread mThread;
+    QObject *mThreadContext;
+    bool mRunning = false; // owner thread only
+    std::atomic<bool> mCancel {false};
+
+    Job mJob;
+    QHash<quint64, int> mPendingTiles; // key -> index in mJob.tiles
+    QHash<quint64, QImage> mTileImages;
+    QTimer mPollTimer;
+    QElapsedTimer mLastTileTimer;
+};
+
+#endif // MAPEXPORTER_H
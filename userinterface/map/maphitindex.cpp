@@ -0,0 +1,139 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "maphitindex.h"
+#include <algorithm>
+#include <cmath>
+
+MapHitIndex::MapHitIndex(double cellSize) : mCellSize(cellSize > 0.0 ? cellSize : 5.0)
+{
+
+}
+
+void MapHitIndex::setPoints(const void *owner, int id, const QVector<QPointF> &points)
+{
+    remove(owner, id);
+
+    const GeometryKey geometry = geometryKey(owner, id);
+    mGeometries.insert(geometry, points);
+    for (int i = 0; i < points.size(); i++)
+        mCells[cellKeyOf(points.at(i))].append({geometry, i, points.at(i)});
+}
+
+void MapHitIndex::movePoint(const void *owner, int id, int index, const QPointF &point)
+{
+    const GeometryKey geometry = geometryKey(owner, id);
+    auto it = mGeometries.find(geometry);
+    if (it == mGeometries.end() || index < 0 || index >= it->size())
+        return;
+
+    const CellKey oldCell = cellKeyOf(it->at(index));
+    const CellKey newCell = cellKeyOf(point);
+    (*it)[index] = point;
+    if (oldCell != newCell) {
+        removeFromCell(oldCell, geometry, index);
+        mCells[newCell].append({geometry, index, point});
+        return;
+    }
+
+    for (auto &entry : mCells[newCell]) {
+        if (entry.geometry == geometry && entry.index == index) {
+            entry.point = point;
+            break;
+        }
+    }
+}
+
+void MapHitIndex::remove(const void *owner, int id)
+{
+    const GeometryKey geometry = geometryKey(owner, id);
+    auto it = mGeometries.find(geometry);
+    if (it == mGeometries.end())
+        return;
+
+    for (int i = 0; i < it->size(); i++)
+        removeFromCell(cellKeyOf(it->at(i)), geometry, i);
+    mGeometries.erase(it);
+}
+
+void MapHitIndex::removeOwner(const void *owner)
+{
+    QVector<int> ids;
+    for (auto it = mGeometries.constBegin(); it != mGeometries.constEnd(); it++)
+        if (it.key().first == (quintptr)owner)
+            ids.append(it.key().second);
+
+    for (int id : ids)
+        remove(owner, id);
+}
+
+void MapHitIndex::clear()
+{
+    mGeometries.clear();
+    mCells.clear();
+}
+
+QVector<MapHitIndex::Hit> MapHitIndex::hitTest(const QPointF &point, double radius, const void *owner, int id) const
+{
+    QVector<Hit> hits;
+    if (radius < 0.0 || mCells.isEmpty())
+        return hits;
+
+    auto testCell = [&hits, &point, radius, owner, id](const QVector<CellEntry> &entries) {
+        for (const auto &entry : entries) {
+            if (owner && (entry.geometry.first != (quintptr)owner || (id >= 0 && entry.geometry.second != id)))
+                continue;
+
+            const double distance = std::hypot(entry.point.x() - point.x(), entry.point.y() - point.y());
+            if (distance <= radius)
+                hits.append({reinterpret_cast<const void*>(entry.geometry.first), entry.geometry.second, entry.index, distance});
+        }
+    };
+
+    const int minCellX = cellCoordinate(point.x() - radius);
+    const int maxCellX = cellCoordinate(point.x() + radius);
+    const int minCellY = cellCoordinate(point.y() - radius);
+    const int maxCellY = cellCoordinate(point.y() + radius);
+
+    // Large radii (zoomed out) cover more cells than are occupied, only visit those
+    if (qint64(maxCellX - minCellX + 1) * (maxCellY - minCellY + 1) > mCells.size()) {
+        for (auto it = mCells.constBegin(); it != mCells.constEnd(); it++) {
+            const int cellX = (int)(qint32)(it.key() >> 32);
+            const int cellY = (int)(qint32)(it.key() & 0xFFFFFFFF);
+            if (cellX >= minCellX && cellX <= maxCellX && cellY >= minCellY && cellY <= maxCellY)
+                testCell(it.value());
+        }
+    } else {
+        for (int cellX = minCellX; cellX <= maxCellX; cellX++) {
+            for (int cellY = minCellY; cellY <= maxCellY; cellY++) {
+                auto it = mCells.constFind(cellKey(cellX, cellY));
+                if (it != mCells.constEnd())
+                    testCell(it.value());
+            }
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const Hit &first, const Hit &second) {
+        return first.distance < second.distance;
+    });
+    return hits;
+}
+
+void MapHitIndex::removeFromCell(CellKey cell, const GeometryKey &geometry, int index)
+{
+    auto it = mCells.find(cell);
+    if (it == mCells.end())
+        return;
+
+    QVector<CellEntry> &entries = it.value();
+    for (int i = 0; i < entries.size(); i++) {
+        if (entries.at(i).geometry == geometry && entries.at(i).index == index) {
+            entries[i] = entries.last();
+            entries.removeLast();
+            break;
+        }
+    }
+    if (entries.isEmpty())
+        mCells.erase(it);
+}
@@ -0,0 +1,62 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Uniform grid over the points of map geometries (routes, vehicles, custom objects) for hit tests, i.e.,
+ * "what is within radius of this map position". Geometries are registered per owner (e.g., a MapModule) and id,
+ * single points can be moved without re-registering. Queries only visit occupied cells.
+ */
+
+#ifndef MAPHITINDEX_H
+#define MAPHITINDEX_H
+
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include <QPointF>
+#include <cmath>
+
+class MapHitIndex
+{
+public:
+    struct Hit {
+        const void *owner;
+        int id;
+        int index; // of the point in the geometry
+        double distance; // [m]
+    };
+
+    explicit MapHitIndex(double cellSize = 5.0);
+
+    void setPoints(const void *owner, int id, const QVector<QPointF> &points); // [m]
+    void movePoint(const void *owner, int id, int index, const QPointF &point);
+    void remove(const void *owner, int id);
+    void removeOwner(const void *owner);
+    void clear();
+    bool contains(const void *owner, int id) const { return mGeometries.contains(geometryKey(owner, id)); }
+
+    // Points within radius, closest first. Optionally limited to an owner (and id of that owner).
+    QVector<Hit> hitTest(const QPointF &point, double radius, const void *owner = nullptr, int id = -1) const;
+
+private:
+    typedef QPair<quintptr, int> GeometryKey;
+    typedef quint64 CellKey;
+
+    struct CellEntry {
+        GeometryKey geometry;
+        int index;
+        QPointF point;
+    };
+
+    static GeometryKey geometryKey(const void *owner, int id) { return GeometryKey((quintptr)owner, id); }
+    int cellCoordinate(double value) const { return (int)floor(value / mCellSize); }
+    static CellKey cellKey(int cellX, int cellY) { return ((CellKey)(quint32)cellX << 32) | (quint32)cellY; }
+    CellKey cellKeyOf(const QPointF &point) const { return cellKey(cellCoordinate(point.x()), cellCoordinate(point.y())); }
+    void removeFromCell(CellKey cell, const GeometryKey &geometry, int index);
+
+    double mCellSize;
+    QHash<GeometryKey, QVector<QPointF>> mGeometries;
+    QHash<CellKey, QVector<CellEntry>> mCells;
+};
+
+#endif // MAPHITINDEX_H
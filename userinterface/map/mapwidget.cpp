@@ -10,13 +10,24 @@
 #include <QPrintEngine>
 #include <QTime>
 #include <QTextStream>
+#include <QSet>
+#include <algorithm>
+#include <functional>
+#include "core/perfcounters.h"
 
 #include "mapwidget.h"
+#include "core/enureprojector.h"
 
-MapWidget::MapWidget(QWidget *parent) : QWidget(parent)
+MapWidget::MapWidget(QWidget *parent) : MapWidgetBase(parent)
 {
     qRegisterMetaType<llh_t>();
 
+#ifdef MAPWIDGET_OPENGL
+    QSurfaceFormat surfaceFormat = format();
+    surfaceFormat.setSamples(OPENGL_SAMPLES);
+    setFormat(surfaceFormat);
+#endif
+
     mScaleFactor = 0.1;
     mRotation = 0;
     mXOffset = 0;
@@ -28,13 +39,23 @@ MapWidget::MapWidget(QWidget *parent) : QWidget(parent)
     mAntialiasOsm = true;
     mDrawGrid = true;
 
-    mOsm = QSharedPointer<OsmClient>::create(this);
+    mOsm = OsmClient::getShared();
+    mHitIndex = QSharedPointer<MapHitIndex>::create();
+    mFleetStateStore = QSharedPointer<FleetStateStore>::create();
     mDrawOpenStreetmap = true;
     mOsmZoomLevel = 15;
     mOsmRes = 1.0;
     mOsmMaxZoomLevel = 19;
     mDrawOsmStats = false;
 
+    mDisplayClock.start();
+
+    mFrameTimer.setSingleShot(true);
+    connect(&mFrameTimer, &QTimer::timeout, this, [this]() {
+        mUpdatePending = true;
+        update();
+    });
+
 
     // ASTA
     //mRefLlh = {57.78100308, 12.76925422, 253.76};
@@ -42,10 +63,12 @@ MapWidget::MapWidget(QWidget *parent) : QWidget(parent)
     // RISE RTK base station
     mRefLlh = {57.71495867, 12.89134921, 219.0};
 
-    // Hardcoded for now
-    mOsm->setCacheDir("osm_tiles");
-    //    mOsm->setTileServerUrl("http://tile.openstreetmap.org");
-    mOsm->setTileServerUrl("http://c.osm.rrze.fau.de/osmhd"); // Also https
+    // Hardcoded for now, by the first map using the shared client
+    if (mOsm->getTileServerUrl().isEmpty()) {
+        mOsm->setCacheDir("osm_tiles");
+        //    mOsm->setTileServerUrl("http://tile.openstreetmap.org");
+        mOsm->setTileServerUrl("http://c.osm.rrze.fau.de/osmhd"); // Also https
+    }
 
     connect(mOsm.get(), &OsmClient::tileReady, this, &MapWidget::tileReady);
     connect(mOsm.get(), &OsmClient::errorGetTile, this, &MapWidget::errorGetTile);
@@ -57,7 +80,11 @@ MapWidget::MapWidget(QWidget *parent) : QWidget(parent)
 void MapWidget::addObjectState(QSharedPointer<ObjectState> objectState)
 {
     mObjectStateMap.insert(objectState->getId(), objectState);
-    connect(objectState.get(), &ObjectState::positionUpdated, this, &MapWidget::triggerUpdate);
+    mHitIndex->setPoints(this, objectState->getId(), {objectState->getPosition().getPoint()});
+    mFleetStateStore->track(objectState);
+    connect(objectState.get(), &ObjectState::positionUpdated, this, &MapWidget::objectStatePositionUpdated, Qt::UniqueConnection);
+    if (mRepaintOnPositionUpdates)
+        connect(objectState.get(), &ObjectState::positionUpdated, this, &MapWidget::triggerUpdate, Qt::UniqueConnection);
 }
 
 QSharedPointer<ObjectState> MapWidget::getObjectState(int objectID)
@@ -68,16 +95,46 @@ QSharedPointer<ObjectState> MapWidget::getObjectState(int objectID)
 bool MapWidget::removeObjectState(int objectID)
 {
     QObject::disconnect(mObjectStateMap.value(objectID).get(), &ObjectState::positionUpdated, this, &MapWidget::triggerUpdate);
+    QObject::disconnect(mObjectStateMap.value(objectID).get(), &ObjectState::positionUpdated, this, &MapWidget::objectStatePositionUpdated);
+    mHitIndex->remove(this, objectID);
+    mFleetStateStore->untrack(objectID);
+    mDisplayPredictor.remove(objectID);
 
     bool removedAnElement = mObjectStateMap.remove(objectID);
-    update();
+    scheduleUpdate();
 
     return removedAnElement;
 }
 
 void MapWidget::clearObjectStates()
 {
+    for (const auto &objectState : mObjectStateMap) {
+        QObject::disconnect(objectState.get(), &ObjectState::positionUpdated, this, &MapWidget::triggerUpdate);
+        QObject::disconnect(objectState.get(), &ObjectState::positionUpdated, this, &MapWidget::objectStatePositionUpdated);
+    }
     mObjectStateMap.clear();
+    mHitIndex->removeOwner(this);
+    mFleetStateStore->clear();
+    mDisplayPredictor.clear();
+}
+
+void MapWidget::setRepaintOnPositionUpdates(bool repaintOnPositionUpdates)
+{
+    mRepaintOnPositionUpdates = repaintOnPositionUpdates;
+
+    for (const auto &objectState : mObjectStateMap) {
+        if (mRepaintOnPositionUpdates)
+            connect(objectState.get(), &ObjectState::positionUpdated, this, &MapWidget::triggerUpdate, Qt::UniqueConnection);
+        else
+            QObject::disconnect(objectState.get(), &ObjectState::positionUpdated, this, &MapWidget::triggerUpdate);
+    }
+}
+
+void MapWidget::setDisplayPrediction(bool displayPrediction)
+{
+    mDisplayPrediction = displayPrediction;
+    mDisplayPredictor.clear();
+    scheduleUpdate();
 }
 
 void MapWidget::setScaleFactor(double scale)
@@ -86,7 +143,7 @@ void MapWidget::setScaleFactor(double scale)
     mScaleFactor = scale;
     mXOffset *= scaleDiff;
     mYOffset *= scaleDiff;
-    update();
+    scheduleUpdate();
 }
 
 double MapWidget::getScaleFactor()
@@ -97,19 +154,19 @@ double MapWidget::getScaleFactor()
 void MapWidget::setRotation(double rotation)
 {
     mRotation = rotation;
-    update();
+    scheduleUpdate();
 }
 
 void MapWidget::setXOffset(double offset)
 {
     mXOffset = offset;
-    update();
+    scheduleUpdate();
 }
 
 void MapWidget::setYOffset(double offset)
 {
     mYOffset = offset;
-    update();
+    scheduleUpdate();
 }
 
 void MapWidget::moveView(double px, double py)
@@ -118,7 +175,7 @@ void MapWidget::moveView(double px, double py)
     followLoc.setXY(px, py);
     mXOffset = -followLoc.getX() * 1000.0 * mScaleFactor;
     mYOffset = -followLoc.getY() * 1000.0 * mScaleFactor;
-    update();
+    scheduleUpdate();
 }
 
 QPoint MapWidget::getMousePosRelative()
@@ -132,19 +189,28 @@ QPoint MapWidget::getMousePosRelative()
 void MapWidget::setAntialiasDrawings(bool antialias)
 {
     mAntialiasDrawings = antialias;
-    update();
+    invalidateLayers();
 }
 
 void MapWidget::setAntialiasOsm(bool antialias)
 {
     mAntialiasOsm = antialias;
-    update();
+    invalidateLayers();
 }
 
 void MapWidget::tileReady(OsmTile tile)
 {
-    (void)tile;
-    update();
+    // Tiles requested by other maps sharing the client, unless visible (or a fallback) here
+    if (mOsmVisibleTiles.isValid()) {
+        const int zoomDiff = mOsmZoomLevel - tile.zoom();
+        const QRect tileRect = zoomDiff >= 0 ? QRect(tile.x() << zoomDiff, tile.y() << zoomDiff, 1 << zoomDiff, 1 << zoomDiff) :
+                                               QRect(tile.x() >> -zoomDiff, tile.y() >> -zoomDiff, 1, 1);
+        if (!tileRect.intersects(mOsmVisibleTiles))
+            return;
+    }
+
+    mBackgroundLayerValid = false;
+    scheduleUpdate();
 }
 
 void MapWidget::errorGetTile(QString reason)
@@ -152,9 +218,66 @@ void MapWidget::errorGetTile(QString reason)
     qWarning() << "OSM tile error:" << reason;
 }
 
+void MapWidget::scheduleUpdate()
+{
+    mFrameStatistics.updateRequests++;
+    if (mUpdatePending || mFrameTimer.isActive())
+        return;
+
+    const qint64 frameInterval_ms = mMaxFps > 0 ? 1000 / mMaxFps : 0;
+    const qint64 sinceLastFrame_ms = mFrameClock.isValid() ? mFrameClock.elapsed() : frameInterval_ms;
+    if (sinceLastFrame_ms >= frameInterval_ms) {
+        mUpdatePending = true;
+        update();
+    } else {
+        mFrameTimer.start(frameInterval_ms - sinceLastFrame_ms);
+    }
+}
+
+void MapWidget::setMaxFps(int maxFps)
+{
+    mMaxFps = std::max(0, maxFps);
+    if (mFrameTimer.isActive()) {
+        mFrameTimer.stop();
+        scheduleUpdate();
+    }
+}
+
+void MapWidget::beginFrame()
+{
+    mUpdatePending = false;
+    const int i = mFrameStatistics.frames % FRAME_STATISTICS_FRAMES;
+    mFrameStatistics.frameInterval_ms[i] = mFrameClock.isValid() ? mFrameClock.nsecsElapsed() / 1e6 : 0.0;
+    mFrameStatistics.updateRequests_n[i] = mFrameStatistics.updateRequests - mFrameStatistics.updateRequestsLastFrame;
+    mFrameStatistics.updateRequestsLastFrame = mFrameStatistics.updateRequests;
+    mFrameClock.start();
+}
+
+void MapWidget::endFrame()
+{
+    static const int frameLatencyId = PerfCounters::getInstance().registerCounter("MAP_FRAME", PerfCounters::Type::Latency);
+    const qint64 paintTime_ns = mFrameClock.nsecsElapsed();
+    PerfCounters::getInstance().recordLatency_ns(frameLatencyId, paintTime_ns); // e.g., for MavsdkStation's benchmark mode
+    mFrameStatistics.paintTime_ms[mFrameStatistics.frames % FRAME_STATISTICS_FRAMES] = paintTime_ns / 1e6;
+    mFrameStatistics.frames++;
+}
+
 void MapWidget::triggerUpdate()
 {
-    update();
+    scheduleUpdate();
+}
+
+void MapWidget::triggerModuleUpdate()
+{
+    mModuleLayerValid = false;
+    scheduleUpdate();
+}
+
+void MapWidget::invalidateLayers()
+{
+    mBackgroundLayerValid = false;
+    mModuleLayerValid = false;
+    scheduleUpdate();
 }
 
 void MapWidget::executeContextMenu(QMenu &contextMenu)
@@ -168,7 +291,7 @@ void MapWidget::setSelectedObjectState(int objectID)
     mSelectedObject = objectID;
 
     if (oldObject != mSelectedObject) {
-        update();
+        scheduleUpdate();
     }
 }
 
@@ -178,15 +301,30 @@ void MapWidget::setFollowObjectState(int objectID)
     mFollowObjectId = objectID;
 
     if (oldObject != mFollowObjectId) {
-        update();
+        scheduleUpdate();
     }
 }
 
+#ifdef MAPWIDGET_OPENGL
+void MapWidget::paintGL()
+{
+    // Tiles are cached as textures by the OpenGL paint engine, all layers are drawn directly instead of uploading cached layers
+    QPainter painter(this);
+    beginFrame();
+    painter.fillRect(rect(), palette().window());
+    paint(painter, width(), height(), false, mDrawOsmStats);
+    endFrame();
+}
+#else
 void MapWidget::paintEvent(QPaintEvent *event)
 {
+    Q_UNUSED(event)
+    beginFrame();
     QPainter painter(this);
-    paint(painter, event->rect().width(), event->rect().height());
+    paintLayers(painter, width(), height());
+    endFrame();
 }
+#endif
 
 void MapWidget::mouseMoveEvent(QMouseEvent *e)
 {
@@ -215,7 +353,7 @@ void MapWidget::mouseMoveEvent(QMouseEvent *e)
         {
             int diffx = x - mMouseLastX;
             mXOffset += diffx;
-            update();
+            scheduleUpdate();
         }
 
         if (mMouseLastY < 100000)
@@ -224,7 +362,7 @@ void MapWidget::mouseMoveEvent(QMouseEvent *e)
             mYOffset -= diffy;
 
             emit offsetChanged(mXOffset, mYOffset);
-            update();
+            scheduleUpdate();
         }
 
         mMouseLastX = x;
@@ -273,7 +411,7 @@ void MapWidget::mousePressEvent(QMouseEvent *e)
             setEnuRef({llh.latitude, llh.longitude, 0.0});
         }
 
-        update();
+        scheduleUpdate();
     }
 }
 
@@ -331,7 +469,7 @@ void MapWidget::wheelEvent(QWheelEvent *e)
 
     emit scaleChanged(mScaleFactor);
     emit offsetChanged(mXOffset, mYOffset);
-    update();
+    scheduleUpdate();
 }
 
 bool MapWidget::event(QEvent *event)
@@ -346,7 +484,7 @@ bool MapWidget::event(QEvent *event)
                 mScaleFactor *= pg->scaleFactor();
                 mXOffset *= pg->scaleFactor();
                 mYOffset *= pg->scaleFactor();
-                update();
+                scheduleUpdate();
             }
 
             return true;
@@ -379,7 +517,7 @@ bool MapWidget::event(QEvent *event)
         }
     }
 
-    return QWidget::event(event);
+    return MapWidgetBase::event(event);
 }
 
 QList<QSharedPointer<ObjectState> > MapWidget::getObjectStateList() const
@@ -387,16 +525,60 @@ QList<QSharedPointer<ObjectState> > MapWidget::getObjectStateList() const
     return mObjectStateMap.values();
 }
 
+QVector<MapHitIndex::Hit> MapWidget::hitTest(QPoint widgetPos, double radius_px, const void *owner, int id) const
+{
+    const QPointF mapPos((widgetPos.x() - mXOffset - width() / 2) / mScaleFactor / 1000.0,
+                         (-widgetPos.y() - mYOffset + height() / 2) / mScaleFactor / 1000.0);
+    return mHitIndex->hitTest(mapPos, radius_px / mScaleFactor / 1000.0, owner, id);
+}
+
+void MapWidget::objectStatePositionUpdated()
+{
+    ObjectState *objectState = qobject_cast<ObjectState*>(sender());
+    if (objectState)
+        mHitIndex->movePoint(this, objectState->getId(), 0, objectState->getPosition().getPoint());
+}
+
 bool MapWidget::setTileServerUrl(QString path)
 {
     return mOsm->setTileServerUrl(path);
 }
 
+bool MapWidget::setOsmTilePack(QString path)
+{
+    return mOsm->setTilePack(path);
+}
+
+void MapWidget::setOsmClient(QSharedPointer<OsmClient> osmClient)
+{
+    if (!osmClient || osmClient == mOsm)
+        return;
+
+    disconnect(mOsm.get(), &OsmClient::tileReady, this, &MapWidget::tileReady);
+    disconnect(mOsm.get(), &OsmClient::errorGetTile, this, &MapWidget::errorGetTile);
+    mOsm->removeView(this);
+
+    mOsm = osmClient;
+    mOsm->setViewPriority(this, mOsmRequestPriority);
+    connect(mOsm.get(), &OsmClient::tileReady, this, &MapWidget::tileReady);
+    connect(mOsm.get(), &OsmClient::errorGetTile, this, &MapWidget::errorGetTile);
+    invalidateLayers();
+}
+
+void MapWidget::setOsmRequestPriority(int priority)
+{
+    mOsmRequestPriority = priority;
+    mOsm->setViewPriority(this, priority);
+}
+
 void MapWidget::addMapModule(QSharedPointer<MapModule> m)
 {
     mMapModules.append(m);
-    connect(m.get(), &MapModule::requestRepaint, this, &MapWidget::triggerUpdate);
+    m->setHitIndex(mHitIndex);
+    m->enuReferenceChanged(mRefLlh);
+    connect(m.get(), &MapModule::requestRepaint, this, &MapWidget::triggerModuleUpdate);
     connect(m.get(), &MapModule::requestContextMenu, this, &MapWidget::executeContextMenu);
+    triggerModuleUpdate();
 }
 
 
@@ -405,7 +587,9 @@ void MapWidget::removeMapModule(QSharedPointer<MapModule> m)
     for (int i = 0;i < mMapModules.size();i++) {
         if (mMapModules.at(i).get() == m.get()) {
             mMapModules.remove(i);
-            disconnect(m.get(), &MapModule::requestRepaint, this, &MapWidget::triggerUpdate);
+            m->setHitIndex(nullptr);
+            disconnect(m.get(), &MapModule::requestRepaint, this, &MapWidget::triggerModuleUpdate);
+            triggerModuleUpdate();
             break;
         }
     }
@@ -414,7 +598,9 @@ void MapWidget::removeMapModule(QSharedPointer<MapModule> m)
 void MapWidget::removeMapModuleLast()
 {
     if (!mMapModules.isEmpty()) {
+        mMapModules.last()->setHitIndex(nullptr);
         mMapModules.removeLast();
+        triggerModuleUpdate();
     }
 }
 
@@ -468,7 +654,7 @@ void MapWidget::printPng(QString path, int width, int height)
 void MapWidget::setDrawOsmStats(bool drawOsmStats)
 {
     mDrawOsmStats = drawOsmStats;
-    update();
+    scheduleUpdate();
 }
 
 void MapWidget::setDrawGrid(bool drawGrid)
@@ -477,7 +663,7 @@ void MapWidget::setDrawGrid(bool drawGrid)
     mDrawGrid = drawGrid;
 
     if (drawGridOld != mDrawGrid) {
-        update();
+        invalidateLayers();
     }
 }
 
@@ -494,7 +680,7 @@ int MapWidget::getOsmMaxZoomLevel() const
 void MapWidget::setOsmMaxZoomLevel(int osmMaxZoomLevel)
 {
     mOsmMaxZoomLevel = osmMaxZoomLevel;
-    update();
+    invalidateLayers();
 }
 
 double MapWidget::getOsmRes() const
@@ -505,21 +691,27 @@ double MapWidget::getOsmRes() const
 void MapWidget::setOsmRes(double osmRes)
 {
     mOsmRes = osmRes;
-    update();
+    invalidateLayers();
 }
 
 void MapWidget::setDrawOpenStreetmap(bool drawOpenStreetmap)
 {
     mDrawOpenStreetmap = drawOpenStreetmap;
-    update();
+    invalidateLayers();
 }
 
 void MapWidget::setEnuRef(const llh_t &llh)
 {
     static llh_t lastEnuRef = mRefLlh;
 
+    const llh_t previousRefLlh = mRefLlh;
     mRefLlh = llh;
-    update();
+    if (mReprojectOnEnuRefChange)
+        reprojectToEnuRef(previousRefLlh);
+    mDisplayPredictor.clear(); // tracks are in the previous frame
+    for (const auto& m: mMapModules)
+        m->enuReferenceChanged(mRefLlh);
+    invalidateLayers();
 
     if (mRefLlh.latitude != lastEnuRef.latitude
             && mRefLlh.longitude != lastEnuRef.longitude
@@ -532,6 +724,30 @@ llh_t MapWidget::getEnuRef()
     return mRefLlh;
 }
 
+void MapWidget::reprojectToEnuRef(const llh_t &previousRefLlh)
+{
+    const coordinateTransforms::EnuTransform transform =
+            coordinateTransforms::EnuFrame(previousRefLlh).getTransformTo(coordinateTransforms::EnuFrame(mRefLlh));
+    if (transform.isIdentity())
+        return;
+
+    EnuReprojector reprojector;
+    for (const QSharedPointer<MapModule> &module : mMapModules)
+        reprojector.addDataset({[module](const coordinateTransforms::EnuTransform &transform) { module->reprojectEnu(transform); },
+                                [module]() { module->enuReprojected(); }});
+    if (mReprojectObjectStatesOnEnuRefChange)
+        for (const QSharedPointer<ObjectState> &objectState : mObjectStateMap)
+            reprojector.addDataset({[objectState](const coordinateTransforms::EnuTransform &transform) { objectState->reprojectEnu(transform); },
+                                    [this, objectState]() { mHitIndex->setPoints(this, objectState->getId(), {objectState->getPosition().getPoint()}); }});
+    reprojector.reproject(transform);
+
+    // Keep the view on the same place
+    const QPointF viewCenter_mm = transform.applyPlanar(QPointF(-mXOffset, -mYOffset) / mScaleFactor, 1000.0);
+    mXOffset = -viewCenter_mm.x() * mScaleFactor;
+    mYOffset = -viewCenter_mm.y() * mScaleFactor;
+    emit offsetChanged(mXOffset, mYOffset);
+}
+
 double MapWidget::drawGrid(QPainter& painter, QTransform drawTrans, QTransform txtTrans, double gridWidth, double gridHeight)
 {
     QPen pen;
@@ -650,19 +866,139 @@ double MapWidget::drawGrid(QPainter& painter, QTransform drawTrans, QTransform t
     return stepGrid;
 }
 
+void MapWidget::drawInfoOverlay(QPainter &painter, QTransform txtTrans, double width)
+{
+    // Statistics of the previous frames, the current one is being painted
+    const int frames = std::min(mFrameStatistics.frames, FRAME_STATISTICS_FRAMES);
+    double intervalSum_ms = 0.0, paintSum_ms = 0.0, paintMax_ms = 0.0;
+    int updateRequests = 0;
+    for (int i = 0; i < frames; i++) {
+        intervalSum_ms += mFrameStatistics.frameInterval_ms[i];
+        paintSum_ms += mFrameStatistics.paintTime_ms[i];
+        paintMax_ms = std::max(paintMax_ms, mFrameStatistics.paintTime_ms[i]);
+        updateRequests += mFrameStatistics.updateRequests_n[i];
+    }
+
+    const OsmTileCacheStatistics cacheStatistics = mOsm->getMemoryCacheStatistics();
+    QString info;
+    QTextStream infoStream(&info);
+    infoStream.setRealNumberNotation(QTextStream::FixedNotation);
+    infoStream.setRealNumberPrecision(1);
+    infoStream << "OSM zoom: " << mOsmZoomLevel << Qt::endl
+               << "Tiles RAM: " << mOsm->getMemoryTilesNow() << " (" << cacheStatistics.bytes / (1024.0 * 1024.0) << " MiB)" << Qt::endl
+               << "Tiles loaded RAM/HDD/net: " << mOsm->getRamTilesLoaded() << "/" << mOsm->getHddTilesLoaded() << "/" << mOsm->getTilesDownloaded() << Qt::endl
+               << "FPS: " << (intervalSum_ms > 0.0 ? 1000.0 * frames / intervalSum_ms : 0.0) << " (max " << mMaxFps << ")" << Qt::endl
+               << "Paint: " << (frames > 0 ? paintSum_ms / frames : 0.0) << " ms (max " << paintMax_ms << " ms)" << Qt::endl
+               << "Updates/frame: " << (frames > 0 ? (double)updateRequests / frames : 0.0);
+
+    painter.save();
+    painter.setTransform(txtTrans);
+    const QRectF textRect = painter.boundingRect(QRectF(), Qt::AlignLeft, info);
+    const QRectF backgroundRect(width - textRect.width() - 20.0, 10.0, textRect.width() + 10.0, textRect.height() + 10.0);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(255, 255, 255, 200));
+    painter.drawRect(backgroundRect);
+    painter.setPen(QPen(QPalette::WindowText));
+    painter.drawText(backgroundRect.adjusted(5.0, 5.0, -5.0, -5.0), Qt::AlignLeft, info);
+    painter.restore();
+}
+
+int MapWidget::calcOsmZoomLevel() const
+{
+    const int zoomLevel = (int)round(log(mScaleFactor * mOsmRes * 100000000.0 *
+                                         cos(mRefLlh.latitude * M_PI / 180.0)) / log(2.0));
+    return std::max(0, std::min(zoomLevel, mOsmMaxZoomLevel));
+}
+
+QVector<MapExporter::Tile> MapWidget::getOsmTiles(const View &view) const
+{
+    // Same tile layout as drawOSMTiles, without its limit on the number of tiles
+    QVector<MapExporter::Tile> tiles;
+    const int zoomLevel = calcOsmZoomLevel();
+    const int xt = OsmTile::long2tilex(mRefLlh.longitude, zoomLevel);
+    const int yt = OsmTile::lat2tiley(mRefLlh.latitude, zoomLevel);
+    const llh_t llhTile = {OsmTile::tiley2lat(yt, zoomLevel), OsmTile::tilex2long(xt, zoomLevel), 0.0};
+    const xyz_t xyz = coordinateTransforms::llhToEnu(mRefLlh, llhTile);
+    const double w = OsmTile::lat2width(mRefLlh.latitude, zoomLevel);
+    if (!(w > 0.0))
+        return tiles;
+
+    const int t_ofs_x = (int)ceil(-(view.center.x() - view.viewWidth / 2.0) / w);
+    const int t_ofs_y = (int)ceil((view.center.y() + view.viewHeight / 2.0) / w);
+    for (int j = 0;; j++) {
+        const double ts_y = -xyz.y + w * j - (double)t_ofs_y * w;
+        if ((ts_y - w) > (-view.center.y() + view.viewHeight / 2.0))
+            break;
+
+        for (int i = 0;; i++) {
+            const double ts_x = xyz.x + w * i - (double)t_ofs_x * w;
+            if (ts_x > (view.center.x() + view.viewWidth / 2.0))
+                break;
+
+            const int xt_i = xt + i - t_ofs_x;
+            const int yt_i = yt + j - t_ofs_y;
+            if (xt_i >= 0 && yt_i >= 0 && xt_i < (1 << zoomLevel) && yt_i < (1 << zoomLevel))
+                tiles.append({zoomLevel, xt_i, yt_i, QRectF(ts_x * 1000.0, ts_y * 1000.0, w * 1000.0, w * 1000.0)});
+        }
+    }
+
+    return tiles;
+}
+
+QSharedPointer<MapExporter> MapWidget::exportMap(const QString &path, int width, int height)
+{
+    if (width == 0) {
+        width = this->width();
+    }
+
+    if (height == 0) {
+        height = this->height();
+    }
+
+    const View view = prepareView(width, height);
+    MapExporter::Job job;
+    job.path = path;
+    job.width = width;
+    job.height = height;
+    if (mDrawOpenStreetmap) {
+        job.tileTrans = view.drawTrans;
+        job.tileTrans.scale(1, -1);
+        job.tiles = getOsmTiles(view);
+    }
+
+    // Recording is fast, the recorded drawings are replayed on the exporter's thread
+    QPainter painter(&job.overlay);
+    setupPainter(painter, true);
+    if (mDrawGrid)
+        drawGrid(painter, view.drawTrans, view.txtTrans, view.width, view.height);
+    paintMapModules(painter, view, true);
+    paintObjectStates(painter, view);
+    painter.end();
+
+    QSharedPointer<MapExporter> exporter = QSharedPointer<MapExporter>::create(mOsm);
+    if (!exporter->start(job))
+        return nullptr;
+
+    mExporters.append(exporter);
+    connect(exporter.get(), &MapExporter::finished, this, [this, finishedExporter = exporter.get()]() {
+        // Not from within the exporter's signal
+        QMetaObject::invokeMethod(this, [this, finishedExporter]() {
+            for (int i = 0; i < mExporters.size(); i++)
+                if (mExporters.at(i).get() == finishedExporter)
+                    mExporters.remove(i--);
+        }, Qt::QueuedConnection);
+    });
+
+    return exporter;
+}
+
 void MapWidget::drawOSMTiles(QPainter& painter, QTransform drawTrans, double viewWidth, double viewHeight, QPointF viewCenter, bool highQuality)
 {
     painter.setTransform(drawTrans);
     if (mDrawOpenStreetmap) {
         const llh_t &iLlh = mRefLlh;
 
-        mOsmZoomLevel = (int)round(log(mScaleFactor * mOsmRes * 100000000.0 *
-                                       cos(iLlh.latitude * M_PI / 180.0)) / log(2.0));
-        if (mOsmZoomLevel > mOsmMaxZoomLevel) {
-            mOsmZoomLevel = mOsmMaxZoomLevel;
-        } else if (mOsmZoomLevel < 0) {
-            mOsmZoomLevel = 0;
-        }
+        mOsmZoomLevel = calcOsmZoomLevel();
 
         int xt = OsmTile::long2tilex(iLlh.longitude, mOsmZoomLevel);
         int yt = OsmTile::lat2tiley(iLlh.latitude, mOsmZoomLevel);
@@ -677,6 +1013,21 @@ void MapWidget::drawOSMTiles(QPainter& painter, QTransform drawTrans, double vie
         int t_ofs_x = (int)ceil(-(viewCenter.x() - viewWidth / 2.0) / w);
         int t_ofs_y = (int)ceil((viewCenter.y() + viewHeight / 2.0) / w);
 
+        // Pan velocity in tiles (y points south), smoothed over paints
+        const double panDt_s = mOsmPanTimer.isValid() ? mOsmPanTimer.restart() / 1000.0 : 0.0;
+        if (!mOsmPanTimer.isValid())
+            mOsmPanTimer.start();
+        if (mOsmZoomLevel == mOsmLastPanZoomLevel && panDt_s > 0.0 && panDt_s < 1.0 && w > 0.0) {
+            const QPointF panVelocity((viewCenter.x() - mOsmLastViewCenter.x()) / w / panDt_s,
+                                      -(viewCenter.y() - mOsmLastViewCenter.y()) / w / panDt_s);
+            mOsmPanVelocity = 0.7 * mOsmPanVelocity + 0.3 * panVelocity;
+        } else {
+            mOsmPanVelocity = QPointF();
+        }
+        mOsmLastViewCenter = viewCenter;
+        mOsmLastPanZoomLevel = mOsmZoomLevel;
+        QRect visibleTiles(xt - t_ofs_x, yt - t_ofs_y, 0, 0);
+
         if (!highQuality) {
             painter.setRenderHint(QPainter::SmoothPixmapTransform, mAntialiasOsm);
         }
@@ -700,28 +1051,45 @@ void MapWidget::drawOSMTiles(QPainter& painter, QTransform drawTrans, double vie
                 }
 
                 int res;
-                OsmTile t = mOsm->getTile(mOsmZoomLevel, xt_i, yt_i, res);
+                OsmTile t = mOsm->getTile(mOsmZoomLevel, xt_i, yt_i, res, this);
 
                 if (w < 0.0) {
                     w = t.getWidthTop();
                 }
 
-                painter.drawPixmap(ts_x * 1000.0, ts_y * 1000.0,
-                                   w * 1000.0, w * 1000.0, t.pixmap());
-
-                if (res == 0 && !mOsm->downloadQueueFull()) {
-                    mOsm->downloadTile(mOsmZoomLevel, xt_i, yt_i);
+                // Part of a cached lower-zoom tile instead of the status pixmap while loading
+                OsmTile fallbackTile;
+                QRectF fallbackSourceRect;
+                if (res <= 0 && res != -1 && mOsm->getFallbackTile(mOsmZoomLevel, xt_i, yt_i, fallbackTile, fallbackSourceRect)) {
+                    painter.drawPixmap(QRectF(ts_x * 1000.0, ts_y * 1000.0, w * 1000.0, w * 1000.0),
+                                       fallbackTile.pixmap(), fallbackSourceRect);
+                } else {
+                    painter.drawPixmap(ts_x * 1000.0, ts_y * 1000.0,
+                                       w * 1000.0, w * 1000.0, t.pixmap());
+                }
+                visibleTiles.setRight(std::max(visibleTiles.right(), xt_i));
+                visibleTiles.setBottom(std::max(visibleTiles.bottom(), yt_i));
+
+                if (res == 0) {
+                    // Queued by distance to the view center when all download slots are busy
+                    const double dx = (ts_x + w / 2.0 - viewCenter.x()) / w;
+                    const double dy = (ts_y + w / 2.0 + viewCenter.y()) / w;
+                    mOsm->downloadTile(mOsmZoomLevel, xt_i, yt_i, dx * dx + dy * dy, this);
                 }
             }
         }
 
+        mOsmVisibleTiles = visibleTiles;
+        if (visibleTiles.isValid())
+            mOsm->updatePrefetch(mOsmZoomLevel, mOsmMaxZoomLevel, visibleTiles, mOsmPanVelocity, this);
+
         if (!highQuality) {
             painter.setRenderHint(QPainter::SmoothPixmapTransform, mAntialiasDrawings);
         }
     }
 }
 
-void MapWidget::paint(QPainter &painter, int width, int height, bool highQuality)
+void MapWidget::setupPainter(QPainter &painter, bool highQuality)
 {
     if (highQuality) {
         painter.setRenderHint(QPainter::Antialiasing, true);
@@ -733,6 +1101,15 @@ void MapWidget::paint(QPainter &painter, int width, int height, bool highQuality
         painter.setRenderHint(QPainter::SmoothPixmapTransform, mAntialiasDrawings);
     }
 
+    // Set font
+    QFont font = this->font();
+    font.setPointSize(10);
+    font.setFamily("Monospace");
+    painter.setFont(font);
+}
+
+MapWidget::View MapWidget::prepareView(int width, int height)
+{
     constexpr double scaleMax = 20;
     constexpr double scaleMin = 0.000001;
 
@@ -751,12 +1128,18 @@ void MapWidget::paint(QPainter &painter, int width, int height, bool highQuality
 
     // Optionally follow a vehicle
     if (mFollowObjectId >= 0) {
-        for (const auto& objectState : mObjectStateMap)
-            if (objectState->getId() == mFollowObjectId) {
-                PosPoint followLoc = objectState->getPosition();
-                mXOffset = -followLoc.getX() * 1000.0 * mScaleFactor;
-                mYOffset = -followLoc.getY() * 1000.0 * mScaleFactor;
-            }
+        const FleetStateStore::ObjectView followObject = mFleetStateStore->getObject(mFollowObjectId);
+        const QSharedPointer<ObjectState> followState = mObjectStateMap.value(mFollowObjectId);
+        if (mDisplayPrediction && followState) {
+            const ObjectDisplayPredictor::DisplayPose followPose =
+                    mDisplayPredictor.update(mFollowObjectId, followState->getPosition(), followState->getSpeed(), mDisplayClock.nsecsElapsed());
+            mXOffset = -followPose.position.x() * 1000.0 * mScaleFactor;
+            mYOffset = -followPose.position.y() * 1000.0 * mScaleFactor;
+        } else if (followObject.isValid()) {
+            PosPoint followLoc = followObject.getPosition();
+            mXOffset = -followLoc.getX() * 1000.0 * mScaleFactor;
+            mYOffset = -followLoc.getY() * 1000.0 * mScaleFactor;
+        }
     }
 
     // Limit the offset to avoid overflow at 2^31 mm
@@ -773,60 +1156,185 @@ void MapWidget::paint(QPainter &painter, int width, int height, bool highQuality
         mYOffset = -lim;
     }
 
-    // Paint begins here
-    QPen pen;
-    painter.fillRect(0, 0, width, height, QBrush(Qt::transparent));
+    View view;
+    view.width = width;
+    view.height = height;
 
     // Map coordinate transforms
-    QTransform drawTrans;
-    drawTrans.translate(width / 2 + mXOffset, height / 2 - mYOffset);
-    drawTrans.scale(mScaleFactor, -mScaleFactor);
-    drawTrans.rotate(mRotation);
+    view.drawTrans.translate(width / 2 + mXOffset, height / 2 - mYOffset);
+    view.drawTrans.scale(mScaleFactor, -mScaleFactor);
+    view.drawTrans.rotate(mRotation);
 
     // Text coordinates
-    QTransform txtTrans;
-    txtTrans.translate(0, 0);
-    txtTrans.scale(1, 1);
-    txtTrans.rotate(0);
-
-    // Set font
-    QFont font = this->font();
-    font.setPointSize(10);
-    font.setFamily("Monospace");
-    painter.setFont(font);
+    view.txtTrans.translate(0, 0);
+    view.txtTrans.scale(1, 1);
+    view.txtTrans.rotate(0);
 
     // View center, width and height in m
-    const QPointF viewCenter(-mXOffset / mScaleFactor / 1000.0, -mYOffset / mScaleFactor / 1000.0);
-    const double viewWidth = width / mScaleFactor / 1000.0;
-    const double viewHeight = height / mScaleFactor / 1000.0;
+    view.center = QPointF(-mXOffset / mScaleFactor / 1000.0, -mYOffset / mScaleFactor / 1000.0);
+    view.viewWidth = width / mScaleFactor / 1000.0;
+    view.viewHeight = height / mScaleFactor / 1000.0;
 
-    // View boundries in mm
-    const QRectF viewRect_mm(QPointF((viewCenter.x() - viewWidth / 2.0) * 1000.0, (viewCenter.y() - viewHeight / 2.0) * 1000.0),
-                             QPointF((viewCenter.x() + viewWidth / 2.0) * 1000.0, (viewCenter.y() + viewHeight / 2.0) * 1000.0));
+    return view;
+}
+
+void MapWidget::paintBackground(QPainter &painter, const View &view, bool highQuality)
+{
+    painter.fillRect(0, 0, view.width, view.height, QBrush(Qt::transparent));
 
     painter.save();
     // Draw openstreetmap tiles
-    drawOSMTiles(painter, drawTrans, viewWidth, viewHeight, viewCenter, highQuality);
+    drawOSMTiles(painter, view.drawTrans, view.viewWidth, view.viewHeight, view.center, highQuality);
     painter.restore();
 
     if (mDrawGrid)
-        drawGrid(painter, drawTrans, txtTrans, width, height);
+        drawGrid(painter, view.drawTrans, view.txtTrans, view.width, view.height);
+}
 
+void MapWidget::paintMapModules(QPainter &painter, const View &view, bool highQuality)
+{
     // Map module painting
     painter.save();
     painter.setPen(QPen(QPalette::WindowText));
     for (const auto& m: mMapModules) {
-        m->processPaint(painter, width, height, highQuality,
-                        drawTrans, txtTrans, mScaleFactor);
+        m->processPaint(painter, view.width, view.height, highQuality,
+                        view.drawTrans, view.txtTrans, mScaleFactor);
     }
     painter.restore();
+}
 
-    // Draw vehicles
+void MapWidget::paintObjectStates(QPainter &painter, const View &view)
+{
+    QHash<int, ObjectFootprint> footprints;
+    mFleetStateStore->read([&footprints](const FleetStateStore::Columns &columns) {
+        footprints.reserve(columns.size());
+        for (int i = 0; i < columns.size(); i++)
+            footprints.insert(columns.id.at(i), {columns.length.at(i), columns.width.at(i), columns.rearAxleToRearEnd.at(i)});
+    });
+
+    // Draw vehicles, skipping those outside of the (possibly rotated) view. Footprints are inflated by their size for what is drawn
+    // around them (trailers, turning radius), objects without one are checked by their position.
+    const QRectF visibleRect_px = QRectF(0, 0, view.width, view.height)
+            .adjusted(-OBJECT_CULL_MARGIN_PX, -OBJECT_CULL_MARGIN_PX, OBJECT_CULL_MARGIN_PX, OBJECT_CULL_MARGIN_PX);
+    const qint64 now_ns = mDisplayClock.nsecsElapsed();
     painter.setPen(QPen(QPalette::WindowText));
-    for(const auto& obj : mObjectStateMap)
-        obj->draw(painter, drawTrans, txtTrans, obj->getId() == mSelectedObject);
+    for(const auto& obj : mObjectStateMap) {
+        const bool isSelected = obj->getId() == mSelectedObject;
+        const PosPoint position = obj->getPosition();
+
+        // Hidden objects are tracked as well, to not blend in from stale poses when they appear
+        ObjectDisplayPredictor::DisplayPose displayPose;
+        displayPose.position = position.getPoint();
+        displayPose.yaw_deg = position.getYaw();
+        if (mDisplayPrediction)
+            displayPose = mDisplayPredictor.update(obj->getId(), position, obj->getSpeed(), now_ns);
+
+        const ObjectFootprint footprint = footprints.value(obj->getId());
+        const double size_m = qMax(footprint.length, footprint.width);
+        QTransform vehicleTrans = view.drawTrans;
+        vehicleTrans.translate(displayPose.position.x() * 1000.0, displayPose.position.y() * 1000.0);
+        vehicleTrans.rotate(displayPose.yaw_deg);
+        const QRectF footprint_mm = QRectF(footprint.rearAxleToRearEnd * 1000.0, -footprint.width * 500.0,
+                                           footprint.length * 1000.0, footprint.width * 1000.0)
+                .adjusted(-size_m * 1000.0, -size_m * 1000.0, size_m * 1000.0, size_m * 1000.0);
+        if (!isSelected && !vehicleTrans.mapRect(footprint_mm).intersects(visibleRect_px))
+            continue;
+
+        const double size_px = size_m * 1000.0 * mScaleFactor;
+        if (mObjectLevelOfDetail && !isSelected && size_m > 0.0 && size_px < OBJECT_OUTLINE_SIZE_PX) {
+            drawObjectSimplified(painter, view, obj->getColor(), displayPose.position, displayPose.yaw_deg, footprint,
+                                 size_px < OBJECT_DOT_SIZE_PX);
+        } else if (mDisplayPrediction) {
+            obj->draw(painter, ObjectDisplayPredictor::getDisplayTransform(position, displayPose) * view.drawTrans,
+                      view.txtTrans, isSelected);
+        } else {
+            obj->draw(painter, view.drawTrans, view.txtTrans, isSelected);
+        }
+    }
 
     painter.setPen(QPen(QPalette::WindowText));
 
+    if (mDisplayPrediction && mDisplayPredictor.isAnimating(now_ns))
+        scheduleUpdate();
+}
+
+void MapWidget::drawObjectSimplified(QPainter &painter, const View &view, const QColor &color, const QPointF &position, double yaw_deg,
+                                     const ObjectFootprint &footprint, bool asDot)
+{
+    painter.save();
+    if (asDot) {
+        painter.setTransform(view.txtTrans);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(color);
+        painter.drawEllipse(view.drawTrans.map(position * 1000.0), OBJECT_DOT_RADIUS_PX, OBJECT_DOT_RADIUS_PX);
+    } else {
+        // Footprint with a line towards the front for the heading
+        painter.setTransform(view.drawTrans);
+        painter.translate(position * 1000.0);
+        painter.rotate(yaw_deg);
+        painter.setPen(QPen(color.darker(), 0));
+        painter.setBrush(color);
+        const QRectF footprint_mm(footprint.rearAxleToRearEnd * 1000.0, -footprint.width * 500.0,
+                                  footprint.length * 1000.0, footprint.width * 1000.0);
+        painter.drawRect(footprint_mm);
+        painter.drawLine(footprint_mm.center(), QPointF(footprint_mm.right(), 0.0));
+    }
+    painter.restore();
+}
+
+void MapWidget::paint(QPainter &painter, int width, int height, bool highQuality, bool drawInfo)
+{
+    setupPainter(painter, highQuality);
+    const View view = prepareView(width, height);
+
+    paintBackground(painter, view, highQuality);
+    paintMapModules(painter, view, highQuality);
+    paintObjectStates(painter, view);
+    if (drawInfo)
+        drawInfoOverlay(painter, view.txtTrans, view.width);
+
+    painter.end();
+}
+
+void MapWidget::paintLayers(QPainter &painter, int width, int height)
+{
+    setupPainter(painter, false);
+    const View view = prepareView(width, height);
+
+    // Cached layers are drawn for the current view only
+    const LayerKey layerKey = {width, height, devicePixelRatioF(), mScaleFactor, mXOffset, mYOffset, mRotation};
+    if (!(layerKey == mLayerKey)) {
+        mLayerKey = layerKey;
+        mBackgroundLayerValid = false;
+        mModuleLayerValid = false;
+    }
+
+    auto renderLayer = [this, &view, &layerKey](QPixmap &layer, const std::function<void(QPainter&)> &paintLayer) {
+        if (layer.size() != QSize(qCeil(view.width * layerKey.devicePixelRatio), qCeil(view.height * layerKey.devicePixelRatio))) {
+            layer = QPixmap(qCeil(view.width * layerKey.devicePixelRatio), qCeil(view.height * layerKey.devicePixelRatio));
+            layer.setDevicePixelRatio(layerKey.devicePixelRatio);
+        }
+        layer.fill(Qt::transparent);
+
+        QPainter layerPainter(&layer);
+        setupPainter(layerPainter, false);
+        paintLayer(layerPainter);
+    };
+
+    if (!mBackgroundLayerValid) {
+        renderLayer(mBackgroundLayer, [this, &view](QPainter &layerPainter) { paintBackground(layerPainter, view, false); });
+        mBackgroundLayerValid = true;
+    }
+    if (!mModuleLayerValid) {
+        renderLayer(mModuleLayer, [this, &view](QPainter &layerPainter) { paintMapModules(layerPainter, view, false); });
+        mModuleLayerValid = true;
+    }
+
+    painter.drawPixmap(0, 0, mBackgroundLayer);
+    painter.drawPixmap(0, 0, mModuleLayer);
+    paintObjectStates(painter, view);
+    if (mDrawOsmStats)
+        drawInfoOverlay(painter, view.txtTrans, view.width);
+
     painter.end();
 }
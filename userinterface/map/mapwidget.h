@@ -20,15 +20,29 @@
 #include <QImage>
 #include <QTransform>
 #include <QMenu>
+#include <QElapsedTimer>
 
 #include "core/pospoint.h"
 #include "vehicles/vehiclestate.h"
 #include "vehicles/objectstate.h"
+#include "vehicles/fleetstatestore.h"
 #include "osmclient.h"
+#include "maphitindex.h"
+#include "mapexporter.h"
+#include "objectdisplaypredictor.h"
 #include "core/coordinatetransforms.h"
 
 Q_DECLARE_METATYPE(llh_t)
 
+// Define MAPWIDGET_OPENGL to render with OpenGL (QOpenGLWidget). QPainter then uses the OpenGL paint engine, i.e.,
+// pixmaps (OSM tiles, markers) are uploaded once and drawn as textures, and MapModule::processPaint works unchanged.
+#ifdef MAPWIDGET_OPENGL
+#include <QOpenGLWidget>
+typedef QOpenGLWidget MapWidgetBase;
+#else
+typedef QWidget MapWidgetBase;
+#endif
+
 class MapModule : public QObject
 {
     Q_OBJECT
@@ -43,13 +57,33 @@ public:
                                                                             return false; };
     virtual QSharedPointer<QMenu> populateContextMenu(const xyz_t& mapPos, const llh_t& enuReference) { Q_UNUSED(mapPos) Q_UNUSED(enuReference)
                                                                                                         return nullptr;};
+    // The ENU reference of the map changed (MapWidget::setEnuRef): convert the geometry stored in ENU. Called for all modules in
+    // parallel on worker threads (only touch the module's own data), followed by enuReprojected on the GUI thread.
+    virtual void reprojectEnu(const coordinateTransforms::EnuTransform &transform) { Q_UNUSED(transform) }
+    virtual void enuReprojected() {}
+    // The map's ENU reference when the module is added and after every change, e.g., for geometry kept geographically
+    virtual void enuReferenceChanged(const llh_t &enuReference) { Q_UNUSED(enuReference) }
+
+    // Set by MapWidget when the module is added (nullptr when removed), the module's geometries are removed from the previous index
+    void setHitIndex(QSharedPointer<MapHitIndex> hitIndex) {
+        if (mHitIndex)
+            mHitIndex->removeOwner(this);
+        mHitIndex = hitIndex;
+        hitIndexChanged();
+    }
 
 signals:
     void requestRepaint();
     void requestContextMenu(QMenu& contextMenu);
+
+protected:
+    // Register geometries for MapWidget::hitTest with owner this in mHitIndex (if set)
+    virtual void hitIndexChanged() {}
+
+    QSharedPointer<MapHitIndex> mHitIndex;
 };
 
-class MapWidget : public QWidget
+class MapWidget : public MapWidgetBase
 {
     Q_OBJECT
 
@@ -58,14 +92,23 @@ public:
     void setScaleFactor(double scale);
     double getScaleFactor();
     void setRotation(double rotation);
+    double getRotation() const { return mRotation; }
     void setXOffset(double offset);
+    double getXOffset() const { return mXOffset; }
     void setYOffset(double offset);
+    double getYOffset() const { return mYOffset; }
     void moveView(double px, double py);
     QPoint getMousePosRelative();
     void setAntialiasDrawings(bool antialias);
 
+    // Map modules (and object states, if enabled) are converted to the new reference, see EnuReprojector
     void setEnuRef(const llh_t &llh);
     llh_t getEnuRef();
+    bool getReprojectOnEnuRefChange() const { return mReprojectOnEnuRefChange; }
+    void setReprojectOnEnuRefChange(bool reprojectOnEnuRefChange) { mReprojectOnEnuRefChange = reprojectOnEnuRefChange; }
+    // Off by default: vehicles of a MavsdkStation are converted by MavsdkStation::setEnuReference, enable for local vehicles
+    bool getReprojectObjectStatesOnEnuRefChange() const { return mReprojectObjectStatesOnEnuRefChange; }
+    void setReprojectObjectStatesOnEnuRefChange(bool reprojectObjectStates) { mReprojectObjectStatesOnEnuRefChange = reprojectObjectStates; }
 
     void setAntialiasOsm(bool antialias);
     void setDrawOpenStreetmap(bool drawOpenStreetmap);
@@ -79,6 +122,9 @@ public:
 
     void printPdf(QString path, int width = 0, int height = 0);
     void printPng(QString path, int width = 0, int height = 0);
+    // Fetches the OSM tiles and renders on a worker thread instead of blocking, PDF for .pdf paths and an image otherwise.
+    // Connect to the signals of the returned exporter (nullptr if the export could not be started) for progress.
+    QSharedPointer<MapExporter> exportMap(const QString &path, int width = 0, int height = 0);
 
     void addObjectState(QSharedPointer<ObjectState> objectState);
     QSharedPointer<ObjectState> getObjectState(int objectID);
@@ -86,14 +132,52 @@ public:
     void setSelectedObjectState(int objectID);
     bool removeObjectState(int objectID);
     void clearObjectStates();
+    // Repaint on every ObjectState::positionUpdated (default). Disable when repaints are triggered otherwise, e.g., by FleetTelemetryAggregator frames
+    bool getRepaintOnPositionUpdates() const { return mRepaintOnPositionUpdates; }
+    void setRepaintOnPositionUpdates(bool repaintOnPositionUpdates);
+    // Object states are drawn (and followed) at their pose extrapolated to the frame time and repainted up to maxFps while moving,
+    // see ObjectDisplayPredictor (default). Disabled: at their last received pose.
+    bool getDisplayPrediction() const { return mDisplayPrediction; }
+    void setDisplayPrediction(bool displayPrediction);
+    ObjectDisplayPredictorParameters getDisplayPredictionParameters() const { return mDisplayPredictor.getParameters(); }
+    void setDisplayPredictionParameters(const ObjectDisplayPredictorParameters &parameters) { mDisplayPredictor.setParameters(parameters); }
+    // Vehicles smaller than OBJECT_OUTLINE_SIZE_PX on screen are drawn as outlines of their footprint, below OBJECT_DOT_SIZE_PX
+    // as dots, without status text (default). The selected object is always drawn in full.
+    bool getObjectLevelOfDetail() const { return mObjectLevelOfDetail; }
+    void setObjectLevelOfDetail(bool objectLevelOfDetail) { mObjectLevelOfDetail = objectLevelOfDetail; scheduleUpdate(); }
 
     void addMapModule(QSharedPointer<MapModule> m);
     void removeMapModule(QSharedPointer<MapModule> m);
     void removeMapModuleLast();
 
     QList<QSharedPointer<ObjectState>> getObjectStateList() const;
+    // Dynamic state of all object states, e.g., for collision checks
+    QSharedPointer<FleetStateStore> getFleetStateStore() const { return mFleetStateStore; }
 
+    // Registered map geometries within radius_px of widgetPos, closest first. Object states are registered with owner this and their id.
+    QVector<MapHitIndex::Hit> hitTest(QPoint widgetPos, double radius_px, const void *owner = nullptr, int id = -1) const;
+    QSharedPointer<MapHitIndex> getHitIndex() const { return mHitIndex; }
+
+    // Tiles come from OsmClient::getShared unless replaced: maps share its memory cache, disk loads and downloads,
+    // and tile server and pack settings apply to all of them
     bool setTileServerUrl(QString path);
+    bool setOsmTilePack(QString path);
+    void setOsmClient(QSharedPointer<OsmClient> osmClient);
+    QSharedPointer<OsmClient> getOsmClient() const { return mOsm; }
+    // Of this map's tile requests relative to other maps sharing the client, higher first (default 0), e.g., for the main map
+    void setOsmRequestPriority(int priority);
+
+    // Repaint requests (setters, tiles, modules, object states) are coalesced into at most maxFps frames per second, 0 for no limit
+    int getMaxFps() const { return mMaxFps; }
+    void setMaxFps(int maxFps);
+
+    static constexpr int OPENGL_SAMPLES = 4; // multisampling with MAPWIDGET_OPENGL
+    static constexpr int DEFAULT_MAX_FPS = 60;
+    static constexpr int FRAME_STATISTICS_FRAMES = 60; // shown with setDrawOsmStats
+    static constexpr double OBJECT_DOT_SIZE_PX = 4.0;
+    static constexpr double OBJECT_OUTLINE_SIZE_PX = 24.0;
+    static constexpr double OBJECT_DOT_RADIUS_PX = 2.5;
+    static constexpr double OBJECT_CULL_MARGIN_PX = 150.0; // around the view, for status text
 
 signals:
     void scaleChanged(double newScale);
@@ -105,10 +189,17 @@ private slots:
     void tileReady(OsmTile tile);
     void errorGetTile(QString reason);
     void triggerUpdate();
+    void triggerModuleUpdate();
+    void objectStatePositionUpdated();
+    void scheduleUpdate();
     void executeContextMenu(QMenu &contextMenu);
 
 protected:
+#ifdef MAPWIDGET_OPENGL
+    void paintGL() override;
+#else
     void paintEvent(QPaintEvent *event) override;
+#endif
     void mouseMoveEvent (QMouseEvent *e) override;
     void mousePressEvent(QMouseEvent *e) override;
     void mouseReleaseEvent(QMouseEvent *e) override;
@@ -117,7 +208,7 @@ protected:
 
     double drawGrid(QPainter &painter, QTransform drawTrans, QTransform txtTrans, double gridWidth, double gridHeight);
     void drawOSMTiles(QPainter &painter, QTransform drawTrans, double viewWidth, double viewHeight, QPointF viewCenter, bool highQuality);
-    void drawInfoOverlay(QPainter &painter, QTransform txtTrans, double width, double gridResolution, QPair<int, int> infoTraceStats);
+    void drawInfoOverlay(QPainter &painter, QTransform txtTrans, double width);
 
 private:
     QMap<int, QSharedPointer<ObjectState>> mObjectStateMap;
@@ -136,14 +227,92 @@ private:
     QSharedPointer<OsmClient> mOsm;
     int mOsmZoomLevel;
     int mOsmMaxZoomLevel;
+    QElapsedTimer mOsmPanTimer;
+    QPointF mOsmLastViewCenter;
+    int mOsmLastPanZoomLevel = -1;
+    QPointF mOsmPanVelocity; // [tiles/s] for prefetching
+    int mOsmRequestPriority = 0;
+    QRect mOsmVisibleTiles; // at mOsmZoomLevel when last drawn, tiles of other maps outside of it do not repaint
     bool mDrawOpenStreetmap;
     bool mDrawOsmStats;
+    int mMaxFps = DEFAULT_MAX_FPS;
+    QTimer mFrameTimer; // delays updates to the next frame
+    QElapsedTimer mFrameClock; // since start of last frame
+    bool mUpdatePending = false;
+    struct {
+        double frameInterval_ms[FRAME_STATISTICS_FRAMES] = {};
+        double paintTime_ms[FRAME_STATISTICS_FRAMES] = {};
+        int updateRequests_n[FRAME_STATISTICS_FRAMES] = {}; // coalesced into the frame
+        int frames = 0;
+        qint64 updateRequests = 0;
+        qint64 updateRequestsLastFrame = 0;
+    } mFrameStatistics;
     bool mDrawGrid;
+    bool mRepaintOnPositionUpdates = true;
+    bool mDisplayPrediction = true;
+    bool mObjectLevelOfDetail = true;
+    ObjectDisplayPredictor mDisplayPredictor;
+    QElapsedTimer mDisplayClock; // frame times for mDisplayPredictor
+    bool mReprojectOnEnuRefChange = true;
+    bool mReprojectObjectStatesOnEnuRefChange = false;
+    void reprojectToEnuRef(const llh_t &previousRefLlh);
     QList<QPixmap> mPixmaps;
 
     QVector<QSharedPointer<MapModule>> mMapModules;
+    QSharedPointer<MapHitIndex> mHitIndex;
+    QSharedPointer<FleetStateStore> mFleetStateStore;
+    QVector<QSharedPointer<MapExporter>> mExporters; // running exports
+
+    // Widget painting is split into layers: OSM tiles and grid, map modules (cached in pixmaps until the view changes
+    // or a tile arrives/a module requests a repaint) and object states (painted on every update)
+    struct View {
+        int width;
+        int height;
+        QTransform drawTrans;
+        QTransform txtTrans;
+        QPointF center; // [m]
+        double viewWidth; // [m]
+        double viewHeight; // [m]
+    };
+    struct LayerKey {
+        int width = -1;
+        int height = -1;
+        qreal devicePixelRatio = 1.0;
+        double scaleFactor = 0.0;
+        double xOffset = 0.0;
+        double yOffset = 0.0;
+        double rotation = 0.0;
+        bool operator==(const LayerKey &other) const {
+            return width == other.width && height == other.height && devicePixelRatio == other.devicePixelRatio &&
+                    scaleFactor == other.scaleFactor && xOffset == other.xOffset && yOffset == other.yOffset && rotation == other.rotation;
+        }
+    };
+    LayerKey mLayerKey;
+    QPixmap mBackgroundLayer;
+    QPixmap mModuleLayer;
+    bool mBackgroundLayerValid = false;
+    bool mModuleLayerValid = false;
 
-    void paint(QPainter &painter, int width, int height, bool highQuality = false);
+    void invalidateLayers();
+    void setupPainter(QPainter &painter, bool highQuality);
+    View prepareView(int width, int height);
+    void paintBackground(QPainter &painter, const View &view, bool highQuality);
+    void paintMapModules(QPainter &painter, const View &view, bool highQuality);
+    void paintObjectStates(QPainter &painter, const View &view);
+    // As FleetStateStore::Columns [m], length 0 if unknown
+    struct ObjectFootprint {
+        double length = 0.0;
+        double width = 0.0;
+        double rearAxleToRearEnd = 0.0;
+    };
+    void drawObjectSimplified(QPainter &painter, const View &view, const QColor &color, const QPointF &position, double yaw_deg,
+                              const ObjectFootprint &footprint, bool asDot);
+    void paintLayers(QPainter &painter, int width, int height);
+    void paint(QPainter &painter, int width, int height, bool highQuality = false, bool drawInfo = false); // all layers, uncached (printing)
+    int calcOsmZoomLevel() const;
+    QVector<MapExporter::Tile> getOsmTiles(const View &view) const;
+    void beginFrame();
+    void endFrame();
 };
 
 #endif // MAPWIDGET_H
@@ -0,0 +1,146 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+
+#include "objectdisplaypredictor.h"
+#include <QLineF>
+#include <cmath>
+
+ObjectDisplayPredictor::DisplayPose ObjectDisplayPredictor::update(int id, const PosPoint &position, double speed_ms, qint64 now_ns)
+{
+    const QPointF samplePosition = position.getPoint();
+    const double sampleYaw_deg = position.getYaw();
+    const qint64 sampleTimestamp_ns = position.getTimestamp_ns();
+
+    auto it = mTracks.find(id);
+    if (it == mTracks.end()) {
+        Track track;
+        track.position = samplePosition;
+        track.yaw_deg = sampleYaw_deg;
+        track.timestamp_ns = sampleTimestamp_ns;
+        track.received_ns = now_ns;
+        track.velocity_ms = QPointF(cos(sampleYaw_deg * M_PI / 180.0), sin(sampleYaw_deg * M_PI / 180.0)) * speed_ms;
+        mTracks.insert(id, track);
+
+        DisplayPose pose;
+        pose.position = samplePosition;
+        pose.yaw_deg = sampleYaw_deg;
+        return pose;
+    }
+
+    Track &track = it.value();
+    if (sampleTimestamp_ns == track.timestamp_ns && samplePosition == track.position && sampleYaw_deg == track.yaw_deg)
+        return predict(track, now_ns);
+
+    const DisplayPose shown = predict(track, now_ns);
+
+    // Sample timestamps when they increase, the receive times otherwise (sources without timestamps)
+    const double dt_s = (sampleTimestamp_ns > track.timestamp_ns && track.timestamp_ns > 0) ?
+                (sampleTimestamp_ns - track.timestamp_ns) / 1e9 : (now_ns - track.received_ns) / 1e9;
+    if (dt_s > 1e-3 && dt_s <= mParameters.maxSampleInterval_s) {
+        track.yawRate_degs = std::remainder(sampleYaw_deg - track.yaw_deg, 360.0) / dt_s;
+        // The chord velocity holds in the middle of the interval, the velocity at the sample turned by half of it since
+        const QPointF chord_ms = (samplePosition - track.position) / dt_s;
+        const double halfTurn_rad = track.yawRate_degs * dt_s / 2.0 * M_PI / 180.0;
+        track.velocity_ms = QPointF(chord_ms.x() * cos(halfTurn_rad) - chord_ms.y() * sin(halfTurn_rad),
+                                    chord_ms.x() * sin(halfTurn_rad) + chord_ms.y() * cos(halfTurn_rad));
+    } else {
+        track.yawRate_degs = 0.0;
+        track.velocity_ms = QPointF(cos(sampleYaw_deg * M_PI / 180.0), sin(sampleYaw_deg * M_PI / 180.0)) * speed_ms;
+    }
+
+    track.position = samplePosition;
+    track.yaw_deg = sampleYaw_deg;
+    track.timestamp_ns = sampleTimestamp_ns;
+    track.received_ns = now_ns;
+
+    track.correction.position = shown.position - samplePosition;
+    track.correction.yaw_deg = std::remainder(shown.yaw_deg - sampleYaw_deg, 360.0);
+    if (QLineF(QPointF(), track.correction.position).length() > mParameters.snapDistance_m) {
+        track.correction.position = QPointF();
+        track.correction.yaw_deg = 0.0;
+    }
+    track.correctionStart_ns = now_ns;
+
+    return predict(track, now_ns);
+}
+
+bool ObjectDisplayPredictor::getDisplayPose(int id, qint64 now_ns, ObjectDisplayPredictor::DisplayPose &pose) const
+{
+    auto it = mTracks.constFind(id);
+    if (it == mTracks.constEnd())
+        return false;
+
+    pose = predict(it.value(), now_ns);
+    return true;
+}
+
+bool ObjectDisplayPredictor::isAnimating(qint64 now_ns) const
+{
+    for (const Track &track : mTracks) {
+        const double tau_s = (now_ns - track.received_ns) / 1e9;
+        const bool moving = QLineF(QPointF(), track.velocity_ms).length() >= mParameters.minSpeed_ms || fabs(track.yawRate_degs) > 0.5;
+        if (moving && tau_s < mParameters.maxExtrapolation_s)
+            return true;
+
+        const bool corrected = !track.correction.position.isNull() || track.correction.yaw_deg != 0.0;
+        if (corrected && getCorrectionWeight(track, now_ns) > 0.0)
+            return true;
+    }
+
+    return false;
+}
+
+QTransform ObjectDisplayPredictor::getDisplayTransform(const PosPoint &reported, const ObjectDisplayPredictor::DisplayPose &display)
+{
+    const QPointF reported_mm = reported.getPointMm();
+    const QPointF display_mm = display.position * 1000.0;
+
+    QTransform rotation;
+    rotation.rotate(display.yaw_deg - reported.getYaw());
+    return QTransform::fromTranslate(-reported_mm.x(), -reported_mm.y()) * rotation *
+            QTransform::fromTranslate(display_mm.x(), display_mm.y());
+}
+
+ObjectDisplayPredictor::DisplayPose ObjectDisplayPredictor::predict(const ObjectDisplayPredictor::Track &track, qint64 now_ns) const
+{
+    const double tau_s = std::min(std::max((now_ns - track.received_ns) / 1e9, 0.0), mParameters.maxExtrapolation_s);
+
+    DisplayPose pose;
+    pose.position = track.position;
+    pose.yaw_deg = track.yaw_deg + track.yawRate_degs * tau_s;
+
+    // Constant turn rate: the velocity rotates with the yaw
+    const QPointF v = track.velocity_ms;
+    if (QLineF(QPointF(), v).length() >= mParameters.minSpeed_ms) {
+        const double turnRate_rads = track.yawRate_degs * M_PI / 180.0;
+        if (fabs(turnRate_rads * tau_s) < 1e-6) {
+            pose.position += v * tau_s;
+        } else {
+            const double s = sin(turnRate_rads * tau_s) / turnRate_rads;
+            const double c = (1.0 - cos(turnRate_rads * tau_s)) / turnRate_rads;
+            pose.position += QPointF(v.x() * s - v.y() * c, v.y() * s + v.x() * c);
+        }
+    }
+
+    const double weight = getCorrectionWeight(track, now_ns);
+    pose.position += track.correction.position * weight;
+    pose.yaw_deg += track.correction.yaw_deg * weight;
+
+    return pose;
+}
+
+double ObjectDisplayPredictor::getCorrectionWeight(const ObjectDisplayPredictor::Track &track, qint64 now_ns) const
+{
+    if (mParameters.blendTime_s <= 0.0)
+        return 0.0;
+
+    const double u = (now_ns - track.correctionStart_ns) / 1e9 / mParameters.blendTime_s;
+    if (u >= 1.0)
+        return 0.0;
+    if (u <= 0.0)
+        return 1.0;
+
+    return 1.0 - u * u * (3.0 - 2.0 * u); // smoothstep, no kink at the start or end
+}
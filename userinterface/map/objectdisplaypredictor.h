@@ -0,0 +1,69 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Display-side dead reckoning for MapWidget: objects are drawn at a pose extrapolated from their last received one, so that they
+ * move smoothly at the frame rate with low telemetry rates. Velocity and yaw rate come from consecutive samples (their timestamps,
+ * the receive times without), the velocity rotating with the yaw rate (constant turn rate); the object's speed along its yaw is used
+ * until there are two samples close enough in time. When a new sample arrives, the difference between the pose shown and the new
+ * one is blended out over blendTime_s instead of jumping, unless larger than snapDistance_m. Extrapolation stops after
+ * maxExtrapolation_s without new samples.
+ */
+
+#ifndef OBJECTDISPLAYPREDICTOR_H
+#define OBJECTDISPLAYPREDICTOR_H
+
+#include <QHash>
+#include <QPointF>
+#include <QTransform>
+#include "core/pospoint.h"
+
+struct ObjectDisplayPredictorParameters {
+    double maxExtrapolation_s = 1.0;
+    double blendTime_s = 0.3;
+    double snapDistance_m = 5.0;
+    double maxSampleInterval_s = 2.0; // rates are not estimated over longer gaps
+    double minSpeed_ms = 0.02; // below: standing still, not animated
+};
+
+class ObjectDisplayPredictor
+{
+public:
+    struct DisplayPose {
+        QPointF position; // [m] ENU
+        double yaw_deg = 0.0; // ENU
+    };
+
+    void setParameters(const ObjectDisplayPredictorParameters &parameters) { mParameters = parameters; }
+    ObjectDisplayPredictorParameters getParameters() const { return mParameters; }
+
+    // Display pose of the object at now_ns (monotonic clock), position and speed_ms: the object's current state
+    DisplayPose update(int id, const PosPoint &position, double speed_ms, qint64 now_ns);
+    bool getDisplayPose(int id, qint64 now_ns, DisplayPose &pose) const; // without new state, false if not tracked
+    void remove(int id) { mTracks.remove(id); }
+    void clear() { mTracks.clear(); }
+    bool isAnimating(qint64 now_ns) const; // any object moving or blending
+
+    // Moves drawings made at the reported pose to the display pose [mm], e.g., for ObjectState::draw (times drawTrans)
+    static QTransform getDisplayTransform(const PosPoint &reported, const DisplayPose &display);
+
+private:
+    struct Track {
+        QPointF position; // of the last sample [m]
+        double yaw_deg = 0.0;
+        qint64 timestamp_ns = 0; // of the sample, 0: none
+        qint64 received_ns = 0; // monotonic
+        QPointF velocity_ms; // at the sample
+        double yawRate_degs = 0.0;
+        DisplayPose correction; // display - sample when it arrived, blended out
+        qint64 correctionStart_ns = 0;
+    };
+
+    DisplayPose predict(const Track &track, qint64 now_ns) const;
+    double getCorrectionWeight(const Track &track, qint64 now_ns) const;
+
+    ObjectDisplayPredictorParameters mParameters;
+    QHash<int, Track> mTracks;
+};
+
+#endif // OBJECTDISPLAYPREDICTOR_H
@@ -0,0 +1,48 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "occupancygridmodule.h"
+#include <QPainter>
+#include <algorithm>
+
+OccupancyGridModule::OccupancyGridModule(QSharedPointer<const OccupancyGrid> occupancyGrid)
+    : mOccupancyGrid(occupancyGrid)
+{
+}
+
+void OccupancyGridModule::processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale)
+{
+    Q_UNUSED(width) Q_UNUSED(height) Q_UNUSED(highQuality) Q_UNUSED(txtTrans) Q_UNUSED(scale)
+
+    if (!mOccupancyGrid)
+        return;
+
+    QRectF bounds;
+    const QVector<qint8> logOdds = mOccupancyGrid->getLogOddsSnapshot(bounds);
+    const int size = mOccupancyGrid->getSize();
+    if (mImage.width() != size)
+        mImage = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
+
+    // Row 0 is the lowest y, which drawTrans (y up) maps to the image's top
+    for (int row = 0; row < size; row++) {
+        QRgb *line = reinterpret_cast<QRgb*>(mImage.scanLine(row));
+        for (int column = 0; column < size; column++) {
+            const int cellLogOdds = logOdds.at(row * size + column);
+            if (cellLogOdds == 0) {
+                line[column] = qPremultiply(qRgba(0, 0, 0, 0));
+            } else if (cellLogOdds > 0) {
+                const int alpha = std::min(255, 64 + cellLogOdds * 191 / OccupancyGrid::LOG_ODDS_MAX);
+                line[column] = qPremultiply(qRgba(40, 40, 40, alpha));
+            } else {
+                const int alpha = std::min(160, -cellLogOdds * 160 / -OccupancyGrid::LOG_ODDS_MIN);
+                line[column] = qPremultiply(qRgba(220, 240, 255, alpha));
+            }
+        }
+    }
+
+    painter.setTransform(drawTrans);
+    painter.setOpacity(mOpacity);
+    painter.drawImage(QRectF(bounds.left() * 1000.0, bounds.top() * 1000.0, bounds.width() * 1000.0, bounds.height() * 1000.0), mImage);
+    painter.setOpacity(1.0);
+}
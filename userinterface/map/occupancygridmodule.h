@@ -0,0 +1,34 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * MapModule that draws an OccupancyGrid (e.g., of OccupancyGridMapper) as an image, one pixel per cell:
+ * occupied cells dark, free cells light, unknown cells transparent.
+ */
+
+#ifndef OCCUPANCYGRIDMODULE_H
+#define OCCUPANCYGRIDMODULE_H
+
+#include "userinterface/map/mapwidget.h"
+#include "core/occupancygrid.h"
+#include <QSharedPointer>
+#include <QImage>
+
+class OccupancyGridModule : public MapModule
+{
+public:
+    explicit OccupancyGridModule(QSharedPointer<const OccupancyGrid> occupancyGrid = nullptr);
+
+    // MapModule interface
+    virtual void processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale) override;
+
+    void setOccupancyGrid(QSharedPointer<const OccupancyGrid> occupancyGrid) { mOccupancyGrid = occupancyGrid; emit requestRepaint(); }
+    void setOpacity(double opacity) { mOpacity = opacity; emit requestRepaint(); }
+
+private:
+    QSharedPointer<const OccupancyGrid> mOccupancyGrid;
+    QImage mImage; // reused between paints
+    double mOpacity = 0.6;
+};
+
+#endif // OCCUPANCYGRIDMODULE_H
@@ -6,17 +6,108 @@
 #include "osmclient.h"
 #include <QDebug>
 #include <QPainter>
+#include <QRunnable>
+#include <QLocale>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace {
+class DiskTileLoader : public QRunnable
+{
+public:
+    DiskTileLoader(const QString &path, QSharedPointer<OsmTilePack> tilePack, int zoom, int x, int y,
+                   QSharedPointer<std::atomic<bool>> canceled, std::function<void(const QImage&, const QDateTime&)> loaded) :
+        mPath(path), mTilePack(tilePack), mZoom(zoom), mX(x), mY(y), mCanceled(canceled), mLoaded(loaded) {}
+
+    void run() override {
+        if (*mCanceled)
+            return;
+
+        QImage image;
+        QDateTime lastModified; // invalid for pack tiles, they are not revalidated
+        if (mTilePack) {
+            const QByteArray data = mTilePack->getTileData(mZoom, mX, mY);
+            if (!data.isEmpty())
+                image.loadFromData(data, "PNG");
+        }
+        if (image.isNull() && !mPath.isEmpty()) {
+            const QFileInfo file(mPath);
+            if (file.exists() && image.load(mPath, "PNG"))
+                lastModified = file.lastModified();
+        }
+        mLoaded(image, lastModified);
+    }
+
+private:
+    QString mPath;
+    QSharedPointer<OsmTilePack> mTilePack;
+    int mZoom;
+    int mX;
+    int mY;
+    QSharedPointer<std::atomic<bool>> mCanceled;
+    std::function<void(const QImage&, const QDateTime&)> mLoaded;
+};
+
+struct CachedTile {
+    int zoom;
+    int x;
+    int y;
+};
+
+// Lists the <zoom>/<x>/<y>.png files of a cache dir
+class DiskCacheIndexer : public QRunnable
+{
+public:
+    DiskCacheIndexer(const QString &cacheDir, std::function<void(const QVector<CachedTile>&)> indexed) :
+        mCacheDir(cacheDir), mIndexed(indexed) {}
+
+    void run() override {
+        QVector<CachedTile> tiles;
+        const QDir cacheDir(mCacheDir);
+        for (const QString &zoomName : cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            bool zoomValid;
+            const int zoom = zoomName.toInt(&zoomValid);
+            if (!zoomValid)
+                continue;
+
+            const QDir zoomDir(cacheDir.filePath(zoomName));
+            for (const QString &xName : zoomDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+                bool xValid;
+                const int x = xName.toInt(&xValid);
+                if (!xValid)
+                    continue;
+
+                const QDir xDir(zoomDir.filePath(xName));
+                for (const QString &tileName : xDir.entryList({"*.png"}, QDir::Files)) {
+                    bool yValid;
+                    const int y = tileName.left(tileName.size() - 4).toInt(&yValid);
+                    if (yValid)
+                        tiles.append({zoom, x, y});
+                }
+            }
+        }
+        mIndexed(tiles);
+    }
+
+private:
+    QString mCacheDir;
+    std::function<void(const QVector<CachedTile>&)> mIndexed;
+};
+}
 
 OsmClient::OsmClient(QObject *parent) : QObject(parent)
 {
-    mMaxMemoryTiles = 600;
     mMaxDownloadingTiles = 6;
     mHddTilesLoaded = 0;
     mTilesDownloaded = 0;
     mRamTilesLoaded = 0;
+    mDiskThreadPool.setMaxThreadCount(DISK_LOADER_THREADS);
+    mDiskMissingTimer.start();
 
     // Generate status pixmaps
-    for (int i = 0;i < 4;i++) {
+    for (int i = 0;i < 5;i++) {
         QPixmap pix(512, 512);
         QPainter *p = new QPainter(&pix);
 
@@ -89,6 +180,23 @@ OsmClient::OsmClient(QObject *parent) : QObject(parent)
             p->drawText(rect, Qt::AlignCenter, txt);
         } break;
 
+        case 4: {
+            // Loading from disk cache.
+            p->fillRect(pix.rect(), Qt::white);
+            p->setBrush(QBrush(QColor(230, 230, 230)));
+            p->setPen(QPen(QBrush(Qt::gray), 3, Qt::SolidLine, Qt::SquareCap, Qt::MiterJoin));
+            QRect r(3, 3, 506, 506);
+            p->drawRect(r);
+            QString txt = "Loading\ntile...";
+            p->setPen(QColor(Qt::black));
+            QFont font;
+            font.setPointSize(32);
+            p->setFont(font);
+            QRect rect;
+            rect.setRect(0, 0, 512, 512);
+            p->drawText(rect, Qt::AlignCenter, txt);
+        } break;
+
         }
 
         delete p;
@@ -99,6 +207,23 @@ OsmClient::OsmClient(QObject *parent) : QObject(parent)
             this, SLOT(fileDownloaded(QNetworkReply*)));
 }
 
+OsmClient::~OsmClient()
+{
+    mDiskThreadPool.clear();
+    mDiskThreadPool.waitForDone();
+}
+
+QSharedPointer<OsmClient> OsmClient::getShared()
+{
+    static QWeakPointer<OsmClient> shared;
+    QSharedPointer<OsmClient> client = shared.toStrongRef();
+    if (!client) {
+        client = QSharedPointer<OsmClient>::create();
+        shared = client;
+    }
+    return client;
+}
+
 bool OsmClient::setCacheDir(QString path)
 {
     QDir().mkpath(path);
@@ -107,6 +232,8 @@ bool OsmClient::setCacheDir(QString path)
 
     if (file.isDir()) {
         mCacheDir = path;
+        mDiskMissingTiles.clear();
+        startDiskIndex();
         return true;
     } else {
         qWarning() << "Invalid cache directory provided.";
@@ -114,12 +241,42 @@ bool OsmClient::setCacheDir(QString path)
     }
 }
 
+bool OsmClient::setTilePack(QString path)
+{
+    mDiskMissingTiles.clear();
+    mCacheGeneration++;
+
+    if (path.isEmpty()) {
+        mTilePack.reset();
+        return true;
+    }
+
+    // Loads in progress keep the previous pack alive
+    QSharedPointer<OsmTilePack> tilePack(new OsmTilePack);
+    if (!tilePack->open(path)) {
+        qWarning() << "Invalid tile pack provided:" << tilePack->getErrorString();
+        mTilePack.reset();
+        return false;
+    }
+
+    mTilePack = tilePack;
+    return true;
+}
+
 bool OsmClient::setTileServerUrl(QString path)
 {
     QUrl url(path);
 
     if (url.isValid()) {
         mTileServer = path;
+
+        // Open the connection before the first tiles are requested, it is reused afterwards
+#ifndef QT_NO_SSL
+        if (url.scheme() == "https")
+            mWebCtrl.connectToHostEncrypted(url.host(), url.port(443));
+        else
+#endif
+            mWebCtrl.connectToHost(url.host(), url.port(80));
         return true;
     } else {
         qWarning() << "Invalid tile server url provided:" << url.errorString();
@@ -146,43 +303,36 @@ bool OsmClient::setTileServerUrl(QString path)
  * Result greater than 0 means that a valid tile is returned. Negative results
  * are errors.
  *
+ * -2: Tile is being loaded from disk, tileReady is emitted when done.
  * -1: Tile not part of map.
  * 0: Tile not cached in memory or on disk.
  * 1: Tile read from memory.
- * 2: Tile read from disk.
+ * 2: Tile read from disk (not returned anymore, disk reads are asynchronous).
  *
  * @return
  * The tile if res > 0, otherwise a tile with a status pixmap.
  */
-OsmTile OsmClient::getTile(int zoom, int x, int y, int &res)
+OsmTile OsmClient::getTile(int zoom, int x, int y, int &res, const QObject *view)
 {
     res = 0;
 
     quint64 key = calcKey(zoom, x, y);
-    OsmTile t = mMemoryTiles.value(key);
+    OsmTile t;
+    const OsmTile *memoryTile = nullptr;
 
     if (x < 0 || y < 0 ||
             x >= (1 << zoom) ||
             y >= (1 << zoom)) {
         res = -1;
         t = OsmTile(mStatusPixmaps.at(3), zoom, x, y);
-    } else if (!t.pixmap().isNull()) {
+    } else if ((memoryTile = mMemoryTiles.find(key))) {
         res = 1;
+        t = *memoryTile;
         mRamTilesLoaded++;
-    } else if (!mCacheDir.isEmpty()) {
-        QString path = mCacheDir + "/" + QString::number(zoom) + "/" +
-                QString::number(x) + "/" + QString::number(y) + ".png";
-        QFile file;
-        file.setFileName(path);
-
-        if (file.exists()) {
-            res = 2;
-            t = OsmTile(QPixmap(path), zoom, x, y);
-            storeTileMemory(key, t);
-            mHddTilesLoaded++;
-        } else {
-            t = OsmTile(getStatusPixmap(key), zoom, x, y);
-        }
+    } else if (hasDiskTiles() && mayBeOnDisk(key, zoom, x, y)) {
+        res = -2;
+        t = OsmTile(mStatusPixmaps.at(4), zoom, x, y);
+        loadTileFromDisk(key, zoom, x, y, mDiskLoadSequence++ + getViewPriority(view) * VIEW_DISK_PRIORITY_STEP);
     } else {
         t = OsmTile(getStatusPixmap(key), zoom, x, y);
     }
@@ -203,33 +353,37 @@ OsmTile OsmClient::getTile(int zoom, int x, int y, int &res)
  * @param y
  * y index
  *
+ * @param priority
+ * Order of queued downloads, lower first, e.g., squared distance to the view center in tiles.
+ *
+ * @param view
+ * Requester, its priority comes before the tile's priority. A tile queued by several views keeps the best order.
+ *
  * @return
  * -3: Tile server not set.
- * -2: Too many tiles downloading.
  * -1: Unknown error.
- * 1: Tile download started.
+ * 1: Tile download started (or running already).
+ * 2: Tile download queued, it is started when other downloads finish.
  *
  */
-int OsmClient::downloadTile(int zoom, int x, int y)
+int OsmClient::downloadTile(int zoom, int x, int y, double priority, const QObject *view)
 {
     int retval = -1;
 
     if (!mTileServer.isEmpty()) {
-        if (mDownloadingTiles.size() < mMaxDownloadingTiles) {
-            quint64 key = calcKey(zoom, x, y);
-            if (!mDownloadingTiles.contains(key)) {
-                // Only add if this tile is not already downloading
-                QString path = mTileServer + "/" + QString::number(zoom) +
-                        "/" + QString::number(x) + "/" + QString::number(y) + ".png";
-                QNetworkRequest request(path);
-                request.setRawHeader("User-Agent", "Firefox");
-                mWebCtrl.get(request);
-                mDownloadingTiles.insert(key, true);
-            }
+        quint64 key = calcKey(zoom, x, y);
+        if (mDownloadingTiles.contains(key)) {
+            // Only add if this tile is not already downloading
+            retval = 1;
+        } else if (mDownloadingTiles.size() < mMaxDownloadingTiles) {
+            startDownload(key);
             retval = 1;
         } else {
-            emit errorGetTile("Too many tiles downloading.");
-            retval = -2;
+            const QueuedDownload queuedDownload = {getViewPriority(view), priority};
+            const auto queued = mDownloadQueue.constFind(key);
+            if (queued == mDownloadQueue.constEnd() || queuedDownload < *queued)
+                mDownloadQueue.insert(key, queuedDownload);
+            retval = 2;
         }
     } else {
         emit errorGetTile("Tile server not set.");
@@ -239,17 +393,426 @@ int OsmClient::downloadTile(int zoom, int x, int y)
     return retval;
 }
 
+void OsmClient::startDownload(quint64 key)
+{
+    int zoom, x, y;
+    decodeKey(key, zoom, x, y);
+
+    QString path = mTileServer + "/" + QString::number(zoom) +
+            "/" + QString::number(x) + "/" + QString::number(y) + ".png";
+    QNetworkRequest request(path);
+    request.setRawHeader("User-Agent", "Firefox");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    // Multiplexed over a single connection if the server supports it, falls back to HTTP/1.1
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#endif
+
+    // Conditional request for cached tiles, answered with 304 if they did not change
+    if (!mCacheDir.isEmpty() && (!mDiskIndexReady || mDiskIndex.contains(key))) {
+        const QFileInfo cacheFile(cacheTilePath(zoom, x, y));
+        if (cacheFile.exists()) {
+            request.setRawHeader("If-Modified-Since", QLocale::c().toString(cacheFile.lastModified().toUTC(),
+                                                                            "ddd, dd MMM yyyy hh:mm:ss 'GMT'").toLatin1());
+            QFile etagFile(cacheFile.filePath() + ".etag");
+            if (etagFile.open(QIODevice::ReadOnly))
+                request.setRawHeader("If-None-Match", etagFile.readAll().trimmed());
+        }
+    }
+
+    mDownloadQueue.remove(key);
+    mDownloadingTiles.insert(key, mWebCtrl.get(request));
+}
+
 bool OsmClient::downloadQueueFull()
 {
     return mDownloadingTiles.size() >= mMaxDownloadingTiles;
 }
 
+/**
+ * @brief OsmClient::downloadArea
+ * Download all tiles of an area on several zoom levels into the cache dir. Tiles that are in the
+ * tile pack or the cache dir already are skipped. Downloads run concurrently, limited by
+ * mMaxDownloadingTiles (leaving room for visible tiles), areaDownloadProgress is emitted as they finish.
+ *
+ * @return
+ * Number of tiles queued, -1 on error.
+ */
+int OsmClient::downloadArea(double latMin, double lonMin, double latMax, double lonMax, int minZoom, int maxZoom)
+{
+    if (mTileServer.isEmpty()) {
+        emit errorGetTile("Tile server not set.");
+        return -1;
+    }
+    if (mCacheDir.isEmpty()) {
+        emit errorGetTile("Cache dir not set, downloaded area cannot be stored.");
+        return -1;
+    }
+
+    // Web Mercator is limited to +-85.0511 deg latitude
+    static constexpr double MAX_LATITUDE = 85.05112878;
+    latMin = std::max(-MAX_LATITUDE, std::min(MAX_LATITUDE, latMin));
+    latMax = std::max(-MAX_LATITUDE, std::min(MAX_LATITUDE, latMax));
+    minZoom = std::max(0, minZoom);
+
+    QList<quint64> tiles;
+    for (int zoom = minZoom; zoom <= maxZoom; zoom++) {
+        const int maxTile = (1 << zoom) - 1;
+        const int xMin = std::max(0, std::min(maxTile, OsmTile::long2tilex(std::min(lonMin, lonMax), zoom)));
+        const int xMax = std::max(0, std::min(maxTile, OsmTile::long2tilex(std::max(lonMin, lonMax), zoom)));
+        const int yMin = std::max(0, std::min(maxTile, OsmTile::lat2tiley(std::max(latMin, latMax), zoom)));
+        const int yMax = std::max(0, std::min(maxTile, OsmTile::lat2tiley(std::min(latMin, latMax), zoom)));
+        if ((qint64)tiles.size() + qint64(xMax - xMin + 1) * (yMax - yMin + 1) > MAX_AREA_DOWNLOAD_TILES) {
+            emit errorGetTile("Area contains more than " + QString::number(MAX_AREA_DOWNLOAD_TILES) + " tiles.");
+            return -1;
+        }
+
+        for (int x = xMin; x <= xMax; x++)
+            for (int y = yMin; y <= yMax; y++)
+                tiles.append(calcKey(zoom, x, y));
+    }
+
+    mAreaDownloadQueue.append(tiles);
+    mAreaTilesTotal += tiles.size();
+    startAreaDownloads();
+    return tiles.size();
+}
+
+void OsmClient::cancelAreaDownload()
+{
+    // Running downloads finish and are cached
+    mAreaDownloadQueue.clear();
+    mAreaTilesTotal = mAreaTilesDone + mAreaDownloadingTiles.size();
+    if (mAreaDownloadingTiles.isEmpty()) {
+        emit areaDownloadProgress(mAreaTilesDone, mAreaTilesTotal, mAreaTilesFailed);
+        mAreaTilesTotal = mAreaTilesDone = mAreaTilesFailed = 0;
+    }
+}
+
 void OsmClient::clearCache()
 {
     QDir dir(mCacheDir);
     dir.removeRecursively();
     mMemoryTiles.clear();
-    mMemoryTilesOrder.clear();
+    mDiskMissingTiles.clear();
+    mDiskIndex.clear();
+    mDiskIndexGeneration++; // a running scan is outdated, the cache dir is empty now
+    mDiskIndexReady = !mCacheDir.isEmpty();
+    mCacheGeneration++;
+    mRevalidationQueue.clear();
+    mRevalidatedTiles.clear();
+    for (View &view : mViews) {
+        view.prefetchTiles.clear();
+        view.prefetchDownloadQueue.clear();
+        view.prefetchZoom = -1;
+    }
+}
+
+void OsmClient::loadTileFromDisk(quint64 key, int zoom, int x, int y, int priority)
+{
+    if (mDiskLoadingTiles.contains(key) || mDiskLoadingTiles.size() >= MAX_PENDING_DISK_LOADS)
+        return; // already loading or retried on next getTile
+
+    const QString path = mCacheDir.isEmpty() ? QString() : cacheTilePath(zoom, x, y);
+    const int cacheGeneration = mCacheGeneration;
+    const QSharedPointer<std::atomic<bool>> canceled(new std::atomic<bool>(false));
+    mDiskLoadingTiles.insert(key, canceled);
+    mDiskThreadPool.start(new DiskTileLoader(path, mTilePack, zoom, x, y, canceled, [this, key, zoom, x, y, cacheGeneration, canceled](const QImage &image, const QDateTime &lastModified) {
+        // QPixmap can only be created on the GUI thread
+        QMetaObject::invokeMethod(this, [this, key, zoom, x, y, image, lastModified, cacheGeneration, canceled]() {
+            diskTileLoaded(key, zoom, x, y, image, lastModified, cacheGeneration, canceled);
+        }, Qt::QueuedConnection);
+    }), priority);
+}
+
+void OsmClient::diskTileLoaded(quint64 key, int zoom, int x, int y, const QImage &image, const QDateTime &lastModified,
+                               int cacheGeneration, QSharedPointer<std::atomic<bool>> canceled)
+{
+    if (mDiskLoadingTiles.value(key) == canceled)
+        mDiskLoadingTiles.remove(key);
+    if (cacheGeneration != mCacheGeneration)
+        return;
+
+    if (image.isNull()) {
+        setDiskMissing(key);
+        bool prefetched = false;
+        for (View &view : mViews) {
+            if (view.prefetchTiles.contains(key)) {
+                view.prefetchDownloadQueue.append(key);
+                prefetched = true;
+            }
+        }
+        if (prefetched)
+            startPrefetchDownloads();
+        emit tileReady(OsmTile(getStatusPixmap(key), zoom, x, y)); // placeholder, lets the tile be downloaded
+        return;
+    }
+
+    mHddTilesLoaded++;
+    emitTile(OsmTile(QPixmap::fromImage(image), zoom, x, y));
+
+    if (lastModified.isValid() && !mTileServer.isEmpty() && !mRevalidatedTiles.contains(key) &&
+            lastModified.secsTo(QDateTime::currentDateTime()) > CACHE_REVALIDATE_AGE_s) {
+        mRevalidatedTiles.insert(key);
+        mRevalidationQueue.append(key);
+        startRevalidations();
+    }
+}
+
+/**
+ * @brief OsmClient::getFallbackTile
+ * Find the closest lower-zoom tile in memory that covers a tile.
+ *
+ * @param fallbackTile
+ * Lower-zoom tile
+ *
+ * @param sourceRect
+ * Part of the fallback tile's pixmap that covers the requested tile.
+ *
+ * @return
+ * true if a fallback tile was found.
+ */
+bool OsmClient::getFallbackTile(int zoom, int x, int y, OsmTile &fallbackTile, QRectF &sourceRect)
+{
+    for (int zoomDiff = 1; zoomDiff <= std::min(zoom, MAX_FALLBACK_ZOOM_LEVELS); zoomDiff++) {
+        const OsmTile *memoryTile = mMemoryTiles.peek(calcKey(zoom - zoomDiff, x >> zoomDiff, y >> zoomDiff));
+        if (!memoryTile || memoryTile->pixmap().isNull())
+            continue;
+
+        const OsmTile &tile = *memoryTile;
+        const int mask = (1 << zoomDiff) - 1;
+        const double width = tile.pixmap().width() / (double)(1 << zoomDiff);
+        const double height = tile.pixmap().height() / (double)(1 << zoomDiff);
+        sourceRect = QRectF((x & mask) * width, (y & mask) * height, width, height);
+        fallbackTile = tile;
+        return true;
+    }
+
+    return false;
+}
+
+void OsmClient::updatePrefetch(int zoom, int maxZoom, const QRect &visibleTiles, const QPointF &panVelocity_tilesPerSecond, const QObject *view)
+{
+    View &state = getView(view);
+    const QPointF lookahead = panVelocity_tilesPerSecond * PREFETCH_LOOKAHEAD_s;
+    const QPoint lookaheadTiles(std::max(-PREFETCH_MAX_LOOKAHEAD_TILES, std::min(PREFETCH_MAX_LOOKAHEAD_TILES, (int)round(lookahead.x()))),
+                                std::max(-PREFETCH_MAX_LOOKAHEAD_TILES, std::min(PREFETCH_MAX_LOOKAHEAD_TILES, (int)round(lookahead.y()))));
+    if (zoom == state.prefetchZoom && visibleTiles == state.prefetchVisibleTiles && lookaheadTiles == state.prefetchLookahead)
+        return;
+    state.prefetchZoom = zoom;
+    state.prefetchVisibleTiles = visibleTiles;
+    state.prefetchLookahead = lookaheadTiles;
+
+    struct Candidate {
+        double priority; // lower first
+        int zoom;
+        int x;
+        int y;
+    };
+    QVector<Candidate> candidates;
+    auto addCandidate = [&candidates](double priority, int zoom, int x, int y) {
+        if (x >= 0 && y >= 0 && x < (1 << zoom) && y < (1 << zoom))
+            candidates.append({priority, zoom, x, y});
+    };
+
+    // Previous zoom level first, it is the fallback for missing tiles
+    if (zoom > 0)
+        for (int x = visibleTiles.left() >> 1; x <= visibleTiles.right() >> 1; x++)
+            for (int y = visibleTiles.top() >> 1; y <= visibleTiles.bottom() >> 1; y++)
+                addCandidate(0.0, zoom - 1, x, y);
+
+    // Ring around the view, extended and preferred in pan direction
+    QRect ring = visibleTiles.adjusted(-PREFETCH_RING_TILES, -PREFETCH_RING_TILES, PREFETCH_RING_TILES, PREFETCH_RING_TILES);
+    ring.setLeft(ring.left() + std::min(lookaheadTiles.x(), 0));
+    ring.setRight(ring.right() + std::max(lookaheadTiles.x(), 0));
+    ring.setTop(ring.top() + std::min(lookaheadTiles.y(), 0));
+    ring.setBottom(ring.bottom() + std::max(lookaheadTiles.y(), 0));
+    const QPointF viewCenter = QRectF(visibleTiles).center();
+    for (int x = ring.left(); x <= ring.right(); x++) {
+        for (int y = ring.top(); y <= ring.bottom(); y++) {
+            if (visibleTiles.contains(x, y))
+                continue;
+
+            const int distance = std::max({visibleTiles.left() - x, x - visibleTiles.right(), visibleTiles.top() - y, y - visibleTiles.bottom()});
+            const QPointF direction = QPointF(x + 0.5, y + 0.5) - viewCenter;
+            const double directionLength = std::hypot(direction.x(), direction.y());
+            const double ahead = directionLength > 0.0 ? (direction.x() * lookahead.x() + direction.y() * lookahead.y()) / directionLength : 0.0;
+            addCandidate(distance - ahead, zoom, x, y);
+        }
+    }
+
+    // Next zoom level last
+    if (zoom < maxZoom)
+        for (int x = 2 * visibleTiles.left(); x <= 2 * visibleTiles.right() + 1; x++)
+            for (int y = 2 * visibleTiles.top(); y <= 2 * visibleTiles.bottom() + 1; y++)
+                addCandidate(PREFETCH_RING_TILES + PREFETCH_MAX_LOOKAHEAD_TILES + 1.0, zoom + 1, x, y);
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &first, const Candidate &second) {
+        return first.priority < second.priority;
+    });
+    if (candidates.size() > MAX_PREFETCH_TILES)
+        candidates.resize(MAX_PREFETCH_TILES);
+
+    // Cancel requests that left the view and prefetch area, unless other views want them
+    state.prefetchTiles.clear();
+    for (const auto &candidate : candidates)
+        state.prefetchTiles.insert(calcKey(candidate.zoom, candidate.x, candidate.y));
+    state.wantedTiles = state.prefetchTiles;
+    for (int x = visibleTiles.left(); x <= visibleTiles.right(); x++)
+        for (int y = visibleTiles.top(); y <= visibleTiles.bottom(); y++)
+            state.wantedTiles.insert(calcKey(zoom, x, y));
+    const QList<QNetworkReply*> staleDownloads = cancelUnwantedRequests();
+
+    // Queue disk loads below visible tiles, downloads by priority
+    state.prefetchDownloadQueue.clear();
+    const int diskPriorityOffset = state.priority * VIEW_DISK_PRIORITY_STEP;
+    for (int i = 0; i < candidates.size(); i++) {
+        const Candidate &candidate = candidates.at(i);
+        const quint64 key = calcKey(candidate.zoom, candidate.x, candidate.y);
+        if (mMemoryTiles.contains(key) || mDownloadingTiles.contains(key) || mDownloadErrorTiles.contains(key))
+            continue;
+
+        if (hasDiskTiles() && mayBeOnDisk(key, candidate.zoom, candidate.x, candidate.y))
+            loadTileFromDisk(key, candidate.zoom, candidate.x, candidate.y, mDiskLoadSequence - MAX_PENDING_DISK_LOADS - i + diskPriorityOffset);
+        else
+            state.prefetchDownloadQueue.append(key);
+    }
+
+    // Finished (canceled) synchronously, freed slots are used for the new queue
+    for (QNetworkReply *reply : staleDownloads)
+        reply->abort();
+    startPrefetchDownloads();
+}
+
+QList<QNetworkReply*> OsmClient::cancelUnwantedRequests()
+{
+    QSet<quint64> wantedTiles;
+    for (const View &view : mViews)
+        wantedTiles.unite(view.wantedTiles);
+
+    for (auto it = mDiskLoadingTiles.begin(); it != mDiskLoadingTiles.end();) {
+        if (wantedTiles.contains(it.key())) {
+            it++;
+        } else {
+            *it.value() = true;
+            it = mDiskLoadingTiles.erase(it);
+        }
+    }
+
+    // Same for downloads, area downloads are kept. Running ones are aborted by the caller.
+    for (auto it = mDownloadQueue.begin(); it != mDownloadQueue.end();) {
+        if (wantedTiles.contains(it.key()))
+            it++;
+        else
+            it = mDownloadQueue.erase(it);
+    }
+    QList<QNetworkReply*> staleDownloads;
+    for (auto it = mDownloadingTiles.constBegin(); it != mDownloadingTiles.constEnd(); it++)
+        if (!wantedTiles.contains(it.key()) && !mAreaDownloadingTiles.contains(it.key()))
+            staleDownloads.append(it.value());
+    return staleDownloads;
+}
+
+void OsmClient::setViewPriority(const QObject *view, int priority)
+{
+    getView(view).priority = priority;
+}
+
+int OsmClient::getViewPriority(const QObject *view) const
+{
+    return mViews.value(view).priority;
+}
+
+void OsmClient::removeView(const QObject *view)
+{
+    if (!mViews.remove(view))
+        return;
+
+    for (QNetworkReply *reply : cancelUnwantedRequests())
+        reply->abort();
+}
+
+OsmClient::View &OsmClient::getView(const QObject *view)
+{
+    auto it = mViews.find(view);
+    if (it == mViews.end()) {
+        it = mViews.insert(view, View());
+        if (view)
+            connect(view, &QObject::destroyed, this, [this, view]() { removeView(view); });
+    }
+    return *it;
+}
+
+QList<OsmClient::View*> OsmClient::getViewsByPriority()
+{
+    QList<View*> views;
+    for (View &view : mViews)
+        views.append(&view);
+    std::stable_sort(views.begin(), views.end(), [](const View *first, const View *second) {
+        return first->priority > second->priority;
+    });
+    return views;
+}
+
+void OsmClient::startPrefetchDownloads()
+{
+    for (View *view : getViewsByPriority()) {
+        while (!mTileServer.isEmpty() && !view->prefetchDownloadQueue.isEmpty() &&
+               mDownloadingTiles.size() < mMaxDownloadingTiles - PREFETCH_RESERVED_DOWNLOADS) {
+            const quint64 key = view->prefetchDownloadQueue.takeFirst();
+            if (mMemoryTiles.contains(key) || mDownloadingTiles.contains(key) || mDownloadErrorTiles.contains(key))
+                continue;
+
+            startDownload(key);
+        }
+    }
+}
+
+void OsmClient::startRevalidations()
+{
+    while (!mTileServer.isEmpty() && !mRevalidationQueue.isEmpty() &&
+           mDownloadingTiles.size() < mMaxDownloadingTiles - PREFETCH_RESERVED_DOWNLOADS) {
+        const quint64 key = mRevalidationQueue.takeFirst();
+        if (!mDownloadingTiles.contains(key))
+            startDownload(key);
+    }
+}
+
+void OsmClient::startQueuedDownloads()
+{
+    // Visible tiles by priority, then prefetching, area downloads and revalidation in the remaining slots
+    while (!mTileServer.isEmpty() && !mDownloadQueue.isEmpty() && mDownloadingTiles.size() < mMaxDownloadingTiles) {
+        const auto next = std::min_element(mDownloadQueue.constBegin(), mDownloadQueue.constEnd());
+        startDownload(next.key());
+    }
+
+    startPrefetchDownloads();
+    startAreaDownloads();
+    startRevalidations();
+}
+
+void OsmClient::startAreaDownloads()
+{
+    const int tilesDoneBefore = mAreaTilesDone;
+    while (!mTileServer.isEmpty() && !mAreaDownloadQueue.isEmpty() &&
+           mDownloadingTiles.size() < std::max(1, mMaxDownloadingTiles - PREFETCH_RESERVED_DOWNLOADS)) {
+        const quint64 key = mAreaDownloadQueue.takeFirst();
+        int zoom, x, y;
+        decodeKey(key, zoom, x, y);
+        if (isOnDisk(key, zoom, x, y)) {
+            mAreaTilesDone++;
+            continue;
+        }
+
+        // Visible tiles might be downloading already, they are counted when they finish
+        mAreaDownloadingTiles.insert(key);
+        if (!mDownloadingTiles.contains(key))
+            startDownload(key);
+    }
+
+    if (mAreaTilesTotal > 0 && (mAreaTilesDone != tilesDoneBefore || mAreaTilesDone == mAreaTilesTotal))
+        emit areaDownloadProgress(mAreaTilesDone, mAreaTilesTotal, mAreaTilesFailed);
+    if (mAreaTilesTotal > 0 && mAreaTilesDone == mAreaTilesTotal)
+        mAreaTilesTotal = mAreaTilesDone = mAreaTilesFailed = 0;
 }
 
 void OsmClient::fileDownloaded(QNetworkReply *pReply)
@@ -266,37 +829,68 @@ void OsmClient::fileDownloaded(QNetworkReply *pReply)
     int zoom = path.mid(ind + 1).toInt();
     quint64 key = calcKey(zoom, x, y);
 
-    mDownloadingTiles.remove(key);
+    if (mDownloadingTiles.value(key) == pReply)
+        mDownloadingTiles.remove(key);
+    pReply->deleteLater();
+
+    const bool isAreaTile = mAreaDownloadingTiles.remove(key);
+    if (isAreaTile) {
+        mAreaTilesDone++;
+        if (pReply->error() != QNetworkReply::NoError)
+            mAreaTilesFailed++;
+    }
 
-    if (pReply->error() == QNetworkReply::NoError) {
+    if (pReply->error() == QNetworkReply::OperationCanceledError) {
+        // Stale request, the tile is requested again if it becomes visible
+        mRevalidatedTiles.remove(key);
+    } else if (pReply->error() == QNetworkReply::NoError &&
+               pReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+        // Cached tile is still valid
+        QFile file(cacheTilePath(zoom, x, y));
+        if (file.open(QIODevice::ReadWrite))
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        mDownloadErrorTiles.remove(key);
+    } else if (pReply->error() == QNetworkReply::NoError) {
         QPixmap pm;
         QByteArray data = pReply->readAll();
         pm.loadFromData(data, "PNG");
 
         // Try to cache tile
         if (!mCacheDir.isEmpty()) {
-            QString path = mCacheDir + "/" + QString::number(zoom) + "/" +
-                    QString::number(x) + "/" + QString::number(y) + ".png";
+            QString path = cacheTilePath(zoom, x, y);
             QFile file;
             file.setFileName(path);
-            if (!file.exists()) {
-                QDir().mkpath(mCacheDir + "/" + QString::number(zoom) + "/" + QString::number(x));
-                if (file.open(QIODevice::ReadWrite)) {
-                    file.write(data);
-                    file.close();
-                } else {
-                    emit errorGetTile("Cache error: " + file.errorString());
-                }
+            // Replaced when revalidated
+            QDir().mkpath(mCacheDir + "/" + QString::number(zoom) + "/" + QString::number(x));
+            if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                file.write(data);
+                file.close();
+                mDiskIndex.insert(key); // also while indexing, the scan's tiles are added to it
+            } else {
+                emit errorGetTile("Cache error: " + file.errorString());
             }
+
+            QFile etagFile(path + ".etag");
+            const QByteArray etag = pReply->rawHeader("ETag");
+            if (!etag.isEmpty() && etagFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+                etagFile.write(etag);
+            else if (etag.isEmpty() && etagFile.exists())
+                etagFile.remove();
         }
 
         mTilesDownloaded++;
         mDownloadErrorTiles.remove(key);
-        emitTile(OsmTile(pm, zoom, x, y));
+        mDiskMissingTiles.remove(key);
+        if (isAreaTile)
+            emit tileReady(OsmTile(pm, zoom, x, y)); // keep memory cache for the view, loaded from disk on demand
+        else
+            emitTile(OsmTile(pm, zoom, x, y));
     } else {
         mDownloadErrorTiles.insert(key, true);
         emit errorGetTile("Download error: " + pReply->errorString());
     }
+
+    startQueuedDownloads();
 }
 
 int OsmClient::getRamTilesLoaded() const
@@ -314,6 +908,11 @@ int OsmClient::getMemoryTilesNow() const
     return mMemoryTiles.size();
 }
 
+OsmTileCacheStatistics OsmClient::getMemoryCacheStatistics() const
+{
+    return mMemoryTiles.getStatistics();
+}
+
 int OsmClient::getHddTilesLoaded() const
 {
     return mHddTilesLoaded;
@@ -331,20 +930,28 @@ void OsmClient::setMaxDownloadingTiles(int maxDownloadingTiles)
 
 int OsmClient::getMaxMemoryTiles() const
 {
-    return mMaxMemoryTiles;
+    return mMemoryTiles.getMaxTiles();
 }
 
 void OsmClient::setMaxMemoryTiles(int maxMemoryTiles)
 {
-    mMaxMemoryTiles = maxMemoryTiles;
+    mMemoryTiles.setMaxTiles(maxMemoryTiles);
+}
+
+qint64 OsmClient::getMaxMemoryBytes() const
+{
+    return mMemoryTiles.getMaxBytes();
+}
+
+void OsmClient::setMaxMemoryBytes(qint64 maxMemoryBytes)
+{
+    mMemoryTiles.setMaxBytes(maxMemoryBytes);
 }
 
 void OsmClient::emitTile(OsmTile tile)
 {
-    quint64 key = calcKey(tile.zoom(), tile.x(), tile.y());
-    if (!mMemoryTiles.contains(key)) {
-        storeTileMemory(key, tile);
-    }
+    // Replaces revalidated tiles
+    mMemoryTiles.insert(calcKey(tile.zoom(), tile.x(), tile.y()), tile);
 
     emit tileReady(tile);
 }
@@ -354,16 +961,67 @@ quint64 OsmClient::calcKey(int zoom, int x, int y)
     return (quint64)0 | ((quint64)zoom << 50) | ((quint64)x << 25) | (quint64)y;
 }
 
-void OsmClient::storeTileMemory(quint64 key, const OsmTile &tile)
+void OsmClient::decodeKey(quint64 key, int &zoom, int &x, int &y)
 {
-    mMemoryTiles.insert(key, tile);
-    mMemoryTilesOrder.append(key);
+    zoom = (int)(key >> 50);
+    x = (int)((key >> 25) & 0x1FFFFFF);
+    y = (int)(key & 0x1FFFFFF);
+}
 
-    // Remove old tiles from memory if too much memory is used.
-    while (mMemoryTilesOrder.size() > mMaxMemoryTiles) {
-        quint64 k = mMemoryTilesOrder.takeFirst();
-        mMemoryTiles.remove(k);
+bool OsmClient::hasDiskTiles() const
+{
+    return !mCacheDir.isEmpty() || mTilePack;
+}
+
+void OsmClient::startDiskIndex()
+{
+    mDiskIndex.clear();
+    mDiskIndexReady = false;
+    const int diskIndexGeneration = ++mDiskIndexGeneration;
+    mDiskThreadPool.start(new DiskCacheIndexer(mCacheDir, [this, diskIndexGeneration](const QVector<CachedTile> &tiles) {
+        QMetaObject::invokeMethod(this, [this, diskIndexGeneration, tiles]() {
+            if (diskIndexGeneration != mDiskIndexGeneration)
+                return;
+            for (const CachedTile &tile : tiles)
+                mDiskIndex.insert(calcKey(tile.zoom, tile.x, tile.y));
+            mDiskIndexReady = true;
+        }, Qt::QueuedConnection);
+    }), std::numeric_limits<int>::max()); // before queued loads
+}
+
+bool OsmClient::mayBeOnDisk(quint64 key, int zoom, int x, int y)
+{
+    const auto missing = mDiskMissingTiles.find(key);
+    if (missing != mDiskMissingTiles.end()) {
+        if (mDiskMissingTimer.elapsed() < missing.value())
+            return false;
+        mDiskMissingTiles.erase(missing); // looked up again
     }
+
+    if (mTilePack && mTilePack->contains(zoom, x, y))
+        return true;
+    return !mCacheDir.isEmpty() && (!mDiskIndexReady || mDiskIndex.contains(key));
+}
+
+bool OsmClient::isOnDisk(quint64 key, int zoom, int x, int y) const
+{
+    if (mTilePack && mTilePack->contains(zoom, x, y))
+        return true;
+    if (mCacheDir.isEmpty())
+        return false;
+    return mDiskIndexReady ? mDiskIndex.contains(key) : QFileInfo::exists(cacheTilePath(zoom, x, y));
+}
+
+void OsmClient::setDiskMissing(quint64 key)
+{
+    mDiskIndex.remove(key); // unreadable or removed by someone else
+    mDiskMissingTiles.insert(key, mDiskMissingTimer.elapsed() + DISK_MISSING_TTL_s * 1000);
+}
+
+QString OsmClient::cacheTilePath(int zoom, int x, int y) const
+{
+    return mCacheDir + "/" + QString::number(zoom) + "/" +
+            QString::number(x) + "/" + QString::number(y) + ".png";
 }
 
 const QPixmap &OsmClient::getStatusPixmap(quint64 key)
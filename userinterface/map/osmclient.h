@@ -18,9 +18,21 @@
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QHash>
+#include <QSet>
 #include <QList>
+#include <QImage>
+#include <QThreadPool>
+#include <QRect>
+#include <QRectF>
+#include <QPointF>
+#include <QSharedPointer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <atomic>
 
 #include "osmtile.h"
+#include "osmtilecache.h"
+#include "osmtilepack.h"
 
 /**
  * @brief The OsmClient class
@@ -58,6 +70,26 @@
  *
  * HD Tiles:
  * https://lists.openstreetmap.org/pipermail/tile-serving/2014-July/001144.html
+ *
+ * Tiles that are not in memory are looked up and decoded from the disk cache by a thread pool,
+ * getTile returns a placeholder meanwhile and tileReady is emitted when the tile was loaded.
+ * getFallbackTile provides the part of a cached lower-zoom tile to be drawn instead of placeholders.
+ * updatePrefetch loads/downloads tiles around the view (further in pan direction) and on the neighbouring zoom levels,
+ * queued and running requests for tiles that are not wanted anymore are cancelled.
+ * Downloads of visible tiles are queued by priority (view center first) when all download slots are busy,
+ * HTTP/2 is used if the tile server supports it and cached tiles older than CACHE_REVALIDATE_AGE_s are
+ * revalidated in the background (If-None-Match/If-Modified-Since).
+ * setTilePack adds a read-only OsmTilePack that is looked up before the cache dir, downloadArea fetches all
+ * tiles of an area over several zoom levels into the cache dir, e.g., to create a pack for offline use.
+ * setCacheDir indexes the tiles of the cache dir in the background, the index is kept up to date as tiles are written.
+ * Once indexed, tiles that are neither in the index nor in the pack are known to be missing without touching the disk.
+ * Tiles the disk loader did not find (before indexing, or unreadable ones) are not looked up again for DISK_MISSING_TTL_s.
+ * The cache dir is assumed to be written by this client only, tiles added by others are found after the next setCacheDir.
+ *
+ * One client can serve several views (e.g., MapWidgets, see getShared): they share the memory cache, disk loads and downloads,
+ * which are only started once per tile. Each view (the requester passed to getTile, downloadTile and updatePrefetch) has its
+ * own prefetch area and a priority (setViewPriority), requests of views with higher priority are loaded and downloaded first.
+ * Tiles are only canceled when no view wants them anymore.
  */
 
 class OsmClient : public QObject
@@ -65,15 +97,32 @@ class OsmClient : public QObject
     Q_OBJECT
 public:
     explicit OsmClient(QObject *parent = 0);
+    ~OsmClient();
+    // Process-wide client, created on first use (GUI thread) and deleted with its last user
+    static QSharedPointer<OsmClient> getShared();
+
     bool setCacheDir(QString path);
+    QString getCacheDir() const { return mCacheDir; }
     bool setTileServerUrl(QString path);
-    OsmTile getTile(int zoom, int x, int y, int &res);
-    int downloadTile(int zoom, int x, int y);
+    QString getTileServerUrl() const { return mTileServer; }
+    bool setTilePack(QString path); // empty path removes the pack
+    OsmTile getTile(int zoom, int x, int y, int &res, const QObject *view = nullptr);
+    bool getFallbackTile(int zoom, int x, int y, OsmTile &fallbackTile, QRectF &sourceRect);
+    void updatePrefetch(int zoom, int maxZoom, const QRect &visibleTiles, const QPointF &panVelocity_tilesPerSecond, const QObject *view = nullptr);
+    int downloadTile(int zoom, int x, int y, double priority = 0.0, const QObject *view = nullptr);
+    // Higher first, default 0. Views are removed when destroyed.
+    void setViewPriority(const QObject *view, int priority);
+    int getViewPriority(const QObject *view) const;
+    void removeView(const QObject *view); // cancels the requests only it wanted
     bool downloadQueueFull();
+    int downloadArea(double latMin, double lonMin, double latMax, double lonMax, int minZoom, int maxZoom);
+    void cancelAreaDownload();
     void clearCache();
 
     int getMaxMemoryTiles() const;
     void setMaxMemoryTiles(int maxMemoryTiles);
+    qint64 getMaxMemoryBytes() const;
+    void setMaxMemoryBytes(qint64 maxMemoryBytes); // pixmap memory of tiles in memory cache
 
     int getMaxDownloadingTiles() const;
     void setMaxDownloadingTiles(int maxDownloadingTiles);
@@ -82,10 +131,26 @@ public:
     int getTilesDownloaded() const;
     int getMemoryTilesNow() const;
     int getRamTilesLoaded() const;
+    OsmTileCacheStatistics getMemoryCacheStatistics() const;
+    bool isDiskCacheIndexed() const { return mDiskIndexReady; }
+
+    static constexpr int DISK_LOADER_THREADS = 2;
+    static constexpr int MAX_PENDING_DISK_LOADS = 256;
+    static constexpr int MAX_FALLBACK_ZOOM_LEVELS = 6;
+    static constexpr int PREFETCH_RING_TILES = 1;
+    static constexpr double PREFETCH_LOOKAHEAD_s = 1.0;
+    static constexpr int PREFETCH_MAX_LOOKAHEAD_TILES = 4;
+    static constexpr int MAX_PREFETCH_TILES = 128;
+    static constexpr int PREFETCH_RESERVED_DOWNLOADS = 2; // download slots kept free for visible tiles
+    static constexpr int MAX_AREA_DOWNLOAD_TILES = 100000;
+    static constexpr qint64 CACHE_REVALIDATE_AGE_s = 7 * 24 * 3600;
+    static constexpr int VIEW_DISK_PRIORITY_STEP = 1 << 20; // disk load priority per view priority, above the load sequence
+    static constexpr qint64 DISK_MISSING_TTL_s = 60;
 
 signals:
     void tileReady(OsmTile tile);
     void errorGetTile(QString reason);
+    void areaDownloadProgress(int tilesDone, int tilesTotal, int tilesFailed); // done when tilesDone == tilesTotal
 
 public slots:
 
@@ -94,23 +159,74 @@ private slots:
 
 private:
     QString mCacheDir;
+    QSharedPointer<OsmTilePack> mTilePack;
     QString mTileServer;
     QNetworkAccessManager mWebCtrl;
-    QHash<quint64, OsmTile> mMemoryTiles;
-    QList<quint64> mMemoryTilesOrder;
-    QHash<quint64, bool> mDownloadingTiles;
+    OsmTileCache mMemoryTiles;
+    QHash<quint64, QNetworkReply*> mDownloadingTiles;
+    struct QueuedDownload {
+        int viewPriority; // higher first
+        double priority; // then lower first
+        bool operator<(const QueuedDownload &other) const {
+            return viewPriority != other.viewPriority ? viewPriority > other.viewPriority : priority < other.priority;
+        }
+    };
+    struct View {
+        int priority = 0;
+        int prefetchZoom = -1;
+        QRect prefetchVisibleTiles;
+        QPoint prefetchLookahead;
+        QSet<quint64> prefetchTiles;
+        QList<quint64> prefetchDownloadQueue; // by priority
+        QSet<quint64> wantedTiles; // visible and prefetched
+    };
+
+    QHash<quint64, QueuedDownload> mDownloadQueue; // visible tiles waiting for a download slot
     QHash<quint64, bool> mDownloadErrorTiles;
     QList<QPixmap> mStatusPixmaps;
+    QThreadPool mDiskThreadPool;
+    QHash<quint64, QSharedPointer<std::atomic<bool>>> mDiskLoadingTiles; // value: canceled
+    QHash<quint64, qint64> mDiskMissingTiles; // not found by the disk loader, value: until [ms of mDiskMissingTimer]
+    QElapsedTimer mDiskMissingTimer;
+    QSet<quint64> mDiskIndex; // tiles in the cache dir
+    bool mDiskIndexReady = false;
+    int mDiskIndexGeneration = 0; // scans of previous cache dirs are discarded
+    int mDiskLoadSequence = 0; // newest requests are loaded first
+    int mCacheGeneration = 0; // loads started before clearing the cache are discarded
+    QHash<const QObject*, View> mViews; // nullptr: requests without view
+    QList<quint64> mAreaDownloadQueue;
+    QSet<quint64> mAreaDownloadingTiles;
+    int mAreaTilesTotal = 0;
+    int mAreaTilesDone = 0;
+    int mAreaTilesFailed = 0;
+    QList<quint64> mRevalidationQueue;
+    QSet<quint64> mRevalidatedTiles; // once per session
 
-    int mMaxMemoryTiles;
     int mMaxDownloadingTiles;
     int mHddTilesLoaded;
     int mTilesDownloaded;
     int mRamTilesLoaded;
 
+    View &getView(const QObject *view);
+    QList<View*> getViewsByPriority();
+    QList<QNetworkReply*> cancelUnwantedRequests(); // of no view, returns the running downloads to abort
     void emitTile(OsmTile tile);
-    quint64 calcKey(int zoom, int x, int y);
-    void storeTileMemory(quint64 key, const OsmTile &tile);
+    static quint64 calcKey(int zoom, int x, int y);
+    static void decodeKey(quint64 key, int &zoom, int &x, int &y);
+    void loadTileFromDisk(quint64 key, int zoom, int x, int y, int priority);
+    void diskTileLoaded(quint64 key, int zoom, int x, int y, const QImage &image, const QDateTime &lastModified,
+                        int cacheGeneration, QSharedPointer<std::atomic<bool>> canceled);
+    void startDownload(quint64 key);
+    void startQueuedDownloads();
+    void startPrefetchDownloads();
+    void startRevalidations();
+    void startAreaDownloads();
+    bool hasDiskTiles() const;
+    void startDiskIndex();
+    bool mayBeOnDisk(quint64 key, int zoom, int x, int y); // false: known to be missing
+    bool isOnDisk(quint64 key, int zoom, int x, int y) const; // looks the cache dir up until indexed
+    void setDiskMissing(quint64 key);
+    QString cacheTilePath(int zoom, int x, int y) const;
     const QPixmap& getStatusPixmap(quint64 key);
 
 };
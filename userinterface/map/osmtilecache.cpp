@@ -0,0 +1,142 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+
+#include "osmtilecache.h"
+
+OsmTileCache::OsmTileCache(qint64 maxBytes, int maxTiles) : mMaxBytes(maxBytes), mMaxTiles(maxTiles)
+{
+
+}
+
+OsmTileCache::~OsmTileCache()
+{
+    clear();
+}
+
+const OsmTile *OsmTileCache::find(quint64 key)
+{
+    Node *node = mNodes.value(key, nullptr);
+    if (!node) {
+        mMisses++;
+        return nullptr;
+    }
+
+    mHits++;
+    if (node != mFront) {
+        unlink(node);
+        linkFront(node);
+    }
+    return &node->tile;
+}
+
+const OsmTile *OsmTileCache::peek(quint64 key) const
+{
+    Node *node = mNodes.value(key, nullptr);
+    return node ? &node->tile : nullptr;
+}
+
+void OsmTileCache::insert(quint64 key, const OsmTile &tile)
+{
+    Node *node = mNodes.value(key, nullptr);
+    if (node) {
+        unlink(node);
+        mBytes -= node->bytes;
+        node->tile = tile;
+    } else {
+        node = new Node{key, tile, 0, nullptr, nullptr};
+        mNodes.insert(key, node);
+    }
+
+    node->bytes = tileBytes(tile);
+    mBytes += node->bytes;
+    linkFront(node);
+    evict();
+}
+
+void OsmTileCache::clear()
+{
+    for (Node *node : mNodes)
+        delete node;
+    mNodes.clear();
+    mFront = nullptr;
+    mBack = nullptr;
+    mBytes = 0;
+}
+
+void OsmTileCache::setMaxBytes(qint64 maxBytes)
+{
+    mMaxBytes = maxBytes;
+    evict();
+}
+
+void OsmTileCache::setMaxTiles(int maxTiles)
+{
+    mMaxTiles = maxTiles;
+    evict();
+}
+
+OsmTileCacheStatistics OsmTileCache::getStatistics() const
+{
+    OsmTileCacheStatistics statistics;
+    statistics.hits = mHits;
+    statistics.misses = mMisses;
+    statistics.evictions = mEvictions;
+    statistics.bytes = mBytes;
+    statistics.tiles = mNodes.size();
+    return statistics;
+}
+
+void OsmTileCache::resetStatistics()
+{
+    mHits = 0;
+    mMisses = 0;
+    mEvictions = 0;
+}
+
+qint64 OsmTileCache::tileBytes(const OsmTile &tile)
+{
+    const QPixmap pixmap = tile.pixmap();
+    return (qint64)pixmap.width() * pixmap.height() * pixmap.depth() / 8;
+}
+
+void OsmTileCache::unlink(Node *node)
+{
+    if (node->previous)
+        node->previous->next = node->next;
+    else
+        mFront = node->next;
+
+    if (node->next)
+        node->next->previous = node->previous;
+    else
+        mBack = node->previous;
+
+    node->previous = nullptr;
+    node->next = nullptr;
+}
+
+void OsmTileCache::linkFront(Node *node)
+{
+    node->previous = nullptr;
+    node->next = mFront;
+    if (mFront)
+        mFront->previous = node;
+    mFront = node;
+    if (!mBack)
+        mBack = node;
+}
+
+void OsmTileCache::evict()
+{
+    // The most recently used tile is kept even if it alone exceeds the budget
+    while (mBack && mBack != mFront && (mBytes > mMaxBytes || mNodes.size() > mMaxTiles)) {
+        Node *node = mBack;
+        unlink(node);
+        mNodes.remove(node->key);
+        mBytes -= node->bytes;
+        mEvictions++;
+        delete node;
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Least recently used cache for OSM tiles in memory, limited by pixmap bytes and tile count.
+ * Entries are kept in an intrusive doubly linked list (most recently used first), lookup, touch and eviction are O(1).
+ */
+
+#ifndef OSMTILECACHE_H
+#define OSMTILECACHE_H
+
+#include <QHash>
+#include "osmtile.h"
+
+struct OsmTileCacheStatistics {
+    quint64 hits = 0;
+    quint64 misses = 0;
+    quint64 evictions = 0;
+    qint64 bytes = 0;
+    int tiles = 0;
+};
+
+class OsmTileCache
+{
+public:
+    OsmTileCache(qint64 maxBytes = DEFAULT_MAX_BYTES, int maxTiles = DEFAULT_MAX_TILES);
+    ~OsmTileCache();
+    OsmTileCache(const OsmTileCache &) = delete;
+    OsmTileCache &operator=(const OsmTileCache &) = delete;
+
+    const OsmTile *find(quint64 key); // marks the tile as most recently used, counts hit/miss, nullptr if not cached
+    const OsmTile *peek(quint64 key) const; // does not change order or statistics
+    bool contains(quint64 key) const { return mNodes.contains(key); }
+    void insert(quint64 key, const OsmTile &tile); // replaces an existing tile, evicts least recently used tiles to fit
+    void clear();
+
+    int size() const { return mNodes.size(); }
+    qint64 getBytes() const { return mBytes; }
+    qint64 getMaxBytes() const { return mMaxBytes; }
+    void setMaxBytes(qint64 maxBytes);
+    int getMaxTiles() const { return mMaxTiles; }
+    void setMaxTiles(int maxTiles);
+
+    OsmTileCacheStatistics getStatistics() const;
+    void resetStatistics();
+
+    static qint64 tileBytes(const OsmTile &tile);
+
+    static constexpr qint64 DEFAULT_MAX_BYTES = 256 * 1024 * 1024;
+    static constexpr int DEFAULT_MAX_TILES = 600;
+
+private:
+    struct Node {
+        quint64 key;
+        OsmTile tile;
+        qint64 bytes;
+        Node *previous;
+        Node *next;
+    };
+
+    void unlink(Node *node);
+    void linkFront(Node *node);
+    void evict();
+
+    QHash<quint64, Node*> mNodes;
+    Node *mFront = nullptr; // most recently used
+    Node *mBack = nullptr; // least recently used
+    qint64 mMaxBytes;
+    int mMaxTiles;
+    qint64 mBytes = 0;
+    quint64 mHits = 0;
+    quint64 mMisses = 0;
+    quint64 mEvictions = 0;
+};
+
+#endif // OSMTILECACHE_H
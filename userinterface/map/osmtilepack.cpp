@@ -0,0 +1,187 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "osmtilepack.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+constexpr char OsmTilePack::FILE_MAGIC[8];
+
+bool OsmTilePack::open(const QString &filename)
+{
+    close();
+
+    mFile.setFileName(filename);
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        mErrorString = "Could not open \"" + filename + "\" for reading.";
+        return false;
+    }
+
+    mSize = mFile.size();
+    FileHeader header;
+    if (mSize < (qint64)sizeof(header) || !(mData = mFile.map(0, mSize))) {
+        mErrorString = "\"" + filename + "\" is not a tile pack.";
+        close();
+        return false;
+    }
+
+    memcpy(&header, mData, sizeof(header));
+    if (memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0) {
+        mErrorString = "\"" + filename + "\" is not a tile pack.";
+        close();
+        return false;
+    }
+    if (header.version != VERSION) {
+        mErrorString = "Unsupported tile pack version " + QString::number(header.version) + " in \"" + filename + "\".";
+        close();
+        return false;
+    }
+    if (header.indexOffset % alignof(IndexEntry) != 0 ||
+            header.indexOffset + (quint64)header.tileCount * sizeof(IndexEntry) > header.dataOffset ||
+            header.dataOffset > (quint64)mSize) {
+        mErrorString = "Corrupt tile pack index in \"" + filename + "\".";
+        close();
+        return false;
+    }
+
+    mTileCount = header.tileCount;
+    mIndex = reinterpret_cast<const IndexEntry*>(mData + header.indexOffset);
+    mTileData = mData + header.dataOffset;
+
+    // Make sure that lookups stay within the file
+    const quint64 dataSize = mSize - header.dataOffset;
+    for (quint32 i = 0; i < mTileCount; i++) {
+        if (mIndex[i].offset + mIndex[i].size > dataSize || (i > 0 && mIndex[i].key <= mIndex[i - 1].key)) {
+            mErrorString = "Corrupt tile pack index in \"" + filename + "\".";
+            close();
+            return false;
+        }
+    }
+
+    mErrorString.clear();
+    return true;
+}
+
+void OsmTilePack::close()
+{
+    if (mData) {
+        mFile.unmap(const_cast<uchar*>(mData));
+        mData = nullptr;
+    }
+    if (mFile.isOpen())
+        mFile.close();
+
+    mSize = 0;
+    mTileCount = 0;
+    mIndex = nullptr;
+    mTileData = nullptr;
+}
+
+bool OsmTilePack::contains(int zoom, int x, int y) const
+{
+    return findEntry(calcKey(zoom, x, y)) != nullptr;
+}
+
+QByteArray OsmTilePack::getTileData(int zoom, int x, int y) const
+{
+    const IndexEntry *entry = findEntry(calcKey(zoom, x, y));
+    if (!entry)
+        return QByteArray();
+
+    // Deep copy, the pack can be closed while the tile is decoded
+    return QByteArray(reinterpret_cast<const char*>(mTileData + entry->offset), entry->size);
+}
+
+const OsmTilePack::IndexEntry *OsmTilePack::findEntry(quint64 key) const
+{
+    if (!mIndex)
+        return nullptr;
+
+    const IndexEntry *end = mIndex + mTileCount;
+    const IndexEntry *entry = std::lower_bound(mIndex, end, key, [](const IndexEntry &entry, quint64 key) {
+        return entry.key < key;
+    });
+    return (entry != end && entry->key == key) ? entry : nullptr;
+}
+
+int OsmTilePack::create(const QString &cacheDir, const QString &filename, QString *errorString)
+{
+    struct Tile {
+        quint64 key;
+        QString path;
+        quint32 size;
+    };
+    QVector<Tile> tiles;
+
+    const QDir dir(cacheDir);
+    QDirIterator it(cacheDir, {"*.png"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        const QStringList parts = dir.relativeFilePath(path).split('/');
+        if (parts.size() != 3)
+            continue;
+
+        bool zoomOk, xOk, yOk;
+        const int zoom = parts.at(0).toInt(&zoomOk);
+        const int x = parts.at(1).toInt(&xOk);
+        const int y = QFileInfo(parts.at(2)).completeBaseName().toInt(&yOk);
+        const qint64 size = QFileInfo(path).size();
+        if (!zoomOk || !xOk || !yOk || zoom < 0 || zoom > 24 || x < 0 || y < 0 || x >= (1 << zoom) || y >= (1 << zoom) || size <= 0)
+            continue;
+
+        tiles.append({calcKey(zoom, x, y), path, (quint32)size});
+    }
+
+    std::sort(tiles.begin(), tiles.end(), [](const Tile &first, const Tile &second) {
+        return first.key < second.key;
+    });
+
+    FileHeader header;
+    memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.tileCount = tiles.size();
+    header.indexOffset = sizeof(FileHeader);
+    header.dataOffset = header.indexOffset + (quint64)tiles.size() * sizeof(IndexEntry);
+
+    QVector<IndexEntry> index;
+    index.reserve(tiles.size());
+    quint64 offset = 0;
+    for (const auto &tile : tiles) {
+        index.append({tile.key, offset, tile.size, 0});
+        offset += tile.size;
+    }
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorString)
+            *errorString = "Could not open \"" + filename + "\" for writing: " + file.errorString();
+        return -1;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(index.constData()), index.size() * sizeof(IndexEntry));
+    for (const auto &tile : tiles) {
+        QFile tileFile(tile.path);
+        // Tile size is in the index already, it must not change
+        if (!tileFile.open(QIODevice::ReadOnly) || file.write(tileFile.read(tile.size)) != tile.size) {
+            file.cancelWriting();
+            if (errorString)
+                *errorString = "Could not read \"" + tile.path + "\".";
+            return -1;
+        }
+    }
+
+    if (!file.commit()) {
+        if (errorString)
+            *errorString = "Could not write \"" + filename + "\": " + file.errorString();
+        return -1;
+    }
+
+    return tiles.size();
+}
@@ -0,0 +1,69 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Offline OSM tiles in a single file, e.g., for field sites without internet. A pack is created from a
+ * zoom/x/y.png tile directory (OsmClient's cache dir) and contains a header, an index sorted by tile key and the PNG data.
+ * The file is memory-mapped read-only, lookups are binary searches and can be done from any thread.
+ */
+
+#ifndef OSMTILEPACK_H
+#define OSMTILEPACK_H
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+
+class OsmTilePack
+{
+public:
+    OsmTilePack() = default;
+    ~OsmTilePack() { close(); }
+    OsmTilePack(const OsmTilePack&) = delete;
+    OsmTilePack& operator=(const OsmTilePack&) = delete;
+
+    bool open(const QString &filename);
+    void close();
+    bool isOpen() const { return mData != nullptr; }
+    QString getErrorString() const { return mErrorString; }
+
+    quint32 getTileCount() const { return mTileCount; }
+    bool contains(int zoom, int x, int y) const;
+    QByteArray getTileData(int zoom, int x, int y) const; // PNG data, empty if not in pack
+
+    // Packs all zoom/x/y.png tiles below cacheDir, returns the number of tiles or -1 on error
+    static int create(const QString &cacheDir, const QString &filename, QString *errorString = nullptr);
+
+    static quint64 calcKey(int zoom, int x, int y) { return ((quint64)zoom << 50) | ((quint64)x << 25) | (quint64)y; }
+
+    static constexpr char FILE_MAGIC[8] = {'W', 'W', 'T', 'I', 'L', 'E', 'P', 'K'};
+    static constexpr quint32 VERSION = 1;
+
+private:
+    struct FileHeader {
+        char magic[8];
+        quint32 version;
+        quint32 tileCount;
+        quint64 indexOffset;
+        quint64 dataOffset;
+    };
+
+    struct IndexEntry {
+        quint64 key;
+        quint64 offset; // from dataOffset
+        quint32 size;
+        quint32 reserved;
+    };
+
+    const IndexEntry *findEntry(quint64 key) const;
+
+    QFile mFile;
+    const uchar *mData = nullptr;
+    qint64 mSize = 0;
+    quint32 mTileCount = 0;
+    const IndexEntry *mIndex = nullptr;
+    const uchar *mTileData = nullptr;
+    QString mErrorString;
+};
+
+#endif // OSMTILEPACK_H
@@ -0,0 +1,504 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "rasteroverlaymodule.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLineF>
+#include <QPainter>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+class RasterTileLoader : public QRunnable
+{
+public:
+    RasterTileLoader(const QString &path, QSharedPointer<std::atomic<bool>> canceled, std::function<void(const QImage&)> loaded) :
+        mPath(path), mCanceled(canceled), mLoaded(loaded) {}
+
+    void run() override {
+        if (*mCanceled)
+            return;
+
+        QImage image;
+        if (QFileInfo::exists(mPath))
+            image.load(mPath);
+        mLoaded(image);
+    }
+
+private:
+    QString mPath;
+    QSharedPointer<std::atomic<bool>> mCanceled;
+    std::function<void(const QImage&)> mLoaded;
+};
+
+const QString PYRAMID_INFO_FILE = "pyramid.json"; // written last, marks a complete pyramid
+}
+
+RasterOverlayModule::RasterOverlayModule()
+{
+    mCacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/raster_pyramids";
+    mLoaderThreadPool.setMaxThreadCount(LOADER_THREADS);
+
+    mThreadContext = new QObject();
+    mThread.setObjectName("Raster pyramid");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start(QThread::LowPriority);
+}
+
+RasterOverlayModule::~RasterOverlayModule()
+{
+    if (mBuildCanceled)
+        *mBuildCanceled = true;
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+
+    mLoaderThreadPool.clear();
+    mLoaderThreadPool.waitForDone();
+}
+
+bool RasterOverlayModule::openGeoTiff(const QString &path, QString &errorString)
+{
+    close();
+
+    GeoTiffReader reader;
+    if (!reader.open(path, errorString))
+        return false;
+    if (!reader.getGeoreference().valid) {
+        errorString = "image is not georeferenced";
+        return false;
+    }
+    if (!reader.getGeoreference().isProjectionSupported()) {
+        errorString = QString("unsupported projection EPSG:%1").arg(reader.getGeoreference().epsg);
+        return false;
+    }
+    reader.close();
+
+    const QFileInfo file(path);
+    const QByteArray fileId = file.canonicalFilePath().toUtf8() + "|" + QByteArray::number(file.size()) + "|" +
+            QByteArray::number(file.lastModified().toMSecsSinceEpoch());
+    mPyramidDir = mCacheDir + "/" + QCryptographicHash::hash(fileId, QCryptographicHash::Sha1).toHex().left(16);
+
+    const int generation = mGeneration;
+    RasterPyramidInfo info;
+    if (readPyramidInfo(mPyramidDir, info)) {
+        // First signals after the caller had a chance to connect
+        QTimer::singleShot(0, this, [this, info, generation]() { buildFinished(true, info, QString(), generation); });
+        return true;
+    }
+
+    const QString pyramidDir = mPyramidDir;
+    const QSharedPointer<std::atomic<bool>> canceled(new std::atomic<bool>(false));
+    mBuildCanceled = canceled;
+    QMetaObject::invokeMethod(mThreadContext, [this, path, pyramidDir, canceled, generation]() {
+        RasterPyramidInfo info;
+        QString errorString;
+        const bool success = buildPyramid(path, pyramidDir, *canceled, [this, generation](int tilesDone, int tilesTotal) {
+            QMetaObject::invokeMethod(this, [this, generation, tilesDone, tilesTotal]() {
+                if (generation == mGeneration)
+                    emit pyramidProgress(tilesDone, tilesTotal);
+            }, Qt::QueuedConnection);
+        }, info, errorString);
+        QMetaObject::invokeMethod(this, [this, success, info, errorString, generation]() {
+            buildFinished(success, info, errorString, generation);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+
+    return true;
+}
+
+void RasterOverlayModule::close()
+{
+    if (mBuildCanceled)
+        *mBuildCanceled = true;
+    mBuildCanceled.reset();
+    cancelLoads({});
+    mGeneration++;
+    mReady = false;
+    mInfo = RasterPyramidInfo();
+    mPyramidDir.clear();
+    mTileCache.clear();
+    mMissingTiles.clear();
+    mCornerEnu_mm.clear();
+    emit requestRepaint();
+}
+
+void RasterOverlayModule::buildFinished(bool success, const RasterPyramidInfo &info, const QString &errorString, int generation)
+{
+    if (generation != mGeneration)
+        return;
+
+    mBuildCanceled.reset();
+    if (success) {
+        mInfo = info;
+        mReady = true;
+        updateGeometry();
+        emit requestRepaint();
+    } else if (!errorString.isEmpty())
+        qWarning() << "WARNING: RasterOverlayModule: building the tile pyramid failed:" << errorString;
+    emit pyramidReady(success, errorString);
+}
+
+void RasterOverlayModule::enuReferenceChanged(const llh_t &enuReference)
+{
+    mEnuFrame.setReference(enuReference);
+    mEnuReferenceSet = true;
+    updateGeometry();
+}
+
+void RasterOverlayModule::updateGeometry()
+{
+    mCornerEnu_mm.clear();
+    if (!mReady || !mEnuReferenceSet)
+        return;
+
+    // Exact at the corners, the projections supported are close to it inside
+    const int width = mInfo.width, height = mInfo.height;
+    QPolygonF enu_mm, pixels;
+    enu_mm << getPixelEnu_mm(0, 0) << getPixelEnu_mm(width, 0) << getPixelEnu_mm(width, height) << getPixelEnu_mm(0, height);
+    pixels << QPointF(0, 0) << QPointF(width, 0) << QPointF(width, height) << QPointF(0, height);
+    if (!QTransform::quadToQuad(enu_mm, pixels, mEnuToPixel))
+        mEnuToPixel = QTransform();
+
+    mPixelSize_mm = (QLineF(enu_mm.at(0), enu_mm.at(1)).length() / width + QLineF(enu_mm.at(0), enu_mm.at(3)).length() / height) / 2.0;
+    emit requestRepaint();
+}
+
+QPointF RasterOverlayModule::getPixelEnu_mm(int column, int row)
+{
+    const quint64 key = ((quint64)(quint32)column << 32) | (quint32)row;
+    const auto cached = mCornerEnu_mm.constFind(key);
+    if (cached != mCornerEnu_mm.constEnd())
+        return *cached;
+
+    llh_t llh;
+    QPointF enu_mm;
+    if (mInfo.georeference.pixelToLlh(column, row, llh)) {
+        const xyz_t enu = mEnuFrame.llhToEnu(llh);
+        enu_mm = QPointF(enu.x * 1000.0, enu.y * 1000.0);
+    }
+    mCornerEnu_mm.insert(key, enu_mm);
+    return enu_mm;
+}
+
+void RasterOverlayModule::processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale)
+{
+    Q_UNUSED(txtTrans)
+
+    if (!mReady || !mEnuReferenceSet || mPixelSize_mm <= 0.0)
+        return;
+
+    // Visible level 0 pixels, with a margin for the approximation
+    const QRectF view_mm = drawTrans.inverted().mapRect(QRectF(0, 0, width, height));
+    const double imagePixelsPerScreenPixel = 1.0 / scale / mPixelSize_mm;
+    const double margin_px = 16.0 * imagePixelsPerScreenPixel;
+    const QRectF visible_px = mEnuToPixel.map(QPolygonF(view_mm)).boundingRect().adjusted(-margin_px, -margin_px, margin_px, margin_px)
+            .intersected(QRectF(0, 0, mInfo.width, mInfo.height));
+    if (visible_px.isEmpty())
+        return;
+
+    // Finest level with at most a screen pixel per image pixel, coarser ones when too many tiles are visible
+    int level = std::clamp((int)floor(log2(std::max(imagePixelsPerScreenPixel, 1.0))), 0, mInfo.levels - 1);
+    int x0, x1, y0, y1;
+    for (;; level++) {
+        const int span_px = TILE_SIZE << level;
+        x0 = (int)(visible_px.left() / span_px);
+        x1 = std::min((int)(visible_px.right() / span_px), (levelSize(mInfo, level).width() - 1) / TILE_SIZE);
+        y0 = (int)(visible_px.top() / span_px);
+        y1 = std::min((int)(visible_px.bottom() / span_px), (levelSize(mInfo, level).height() - 1) / TILE_SIZE);
+        if ((x1 - x0 + 1) * (y1 - y0 + 1) <= MAX_VISIBLE_TILES || level == mInfo.levels - 1)
+            break;
+    }
+
+    painter.save();
+    painter.setOpacity(mOpacity);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, highQuality);
+
+    QSet<quint64> visibleKeys;
+    const int span_px = TILE_SIZE << level;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            const quint64 key = calcKey(level, x, y);
+            visibleKeys.insert(key);
+            const QRect pixelRect = QRect(x * span_px, y * span_px, span_px, span_px).intersected(QRect(0, 0, mInfo.width, mInfo.height));
+
+            if (const OsmTile *tile = mTileCache.find(key)) {
+                drawTile(painter, drawTrans, pixelRect, tile->pixmap(), QRectF(QPointF(0, 0), tile->pixmap().size()));
+                continue;
+            }
+            if (!mMissingTiles.contains(key))
+                loadTile(key, level, x, y);
+
+            // Part of the closest parent in memory until then
+            for (int parentLevel = level + 1; parentLevel < mInfo.levels; parentLevel++) {
+                const int shift = parentLevel - level;
+                const OsmTile *parent = mTileCache.peek(calcKey(parentLevel, x >> shift, y >> shift));
+                if (!parent)
+                    continue;
+                const int parentSpan_px = TILE_SIZE << parentLevel;
+                const QPointF parentOrigin_px((x >> shift) * parentSpan_px, (y >> shift) * parentSpan_px);
+                const double parentScale = 1.0 / (1 << parentLevel);
+                const QRectF sourceRect((QPointF(pixelRect.topLeft()) - parentOrigin_px) * parentScale, QSizeF(pixelRect.size()) * parentScale);
+                drawTile(painter, drawTrans, pixelRect, parent->pixmap(), sourceRect.intersected(QRectF(QPointF(0, 0), parent->pixmap().size())));
+                break;
+            }
+        }
+    }
+
+    painter.restore();
+    cancelLoads(visibleKeys);
+}
+
+void RasterOverlayModule::drawTile(QPainter &painter, const QTransform &drawTrans, const QRect &pixelRect, const QPixmap &pixmap, const QRectF &sourceRect)
+{
+    if (sourceRect.isEmpty())
+        return;
+
+    const int left = pixelRect.x(), top = pixelRect.y(), right = pixelRect.x() + pixelRect.width(), bottom = pixelRect.y() + pixelRect.height();
+    QPolygonF source, target_mm;
+    source << sourceRect.topLeft() << sourceRect.topRight() << sourceRect.bottomRight() << sourceRect.bottomLeft();
+    target_mm << getPixelEnu_mm(left, top) << getPixelEnu_mm(right, top) << getPixelEnu_mm(right, bottom) << getPixelEnu_mm(left, bottom);
+
+    QTransform sourceToEnu_mm;
+    if (!QTransform::quadToQuad(source, target_mm, sourceToEnu_mm))
+        return;
+    painter.setTransform(sourceToEnu_mm * drawTrans);
+    painter.drawPixmap(sourceRect, pixmap, sourceRect);
+}
+
+void RasterOverlayModule::loadTile(quint64 key, int level, int x, int y)
+{
+    if (mLoadingTiles.contains(key) || mLoadingTiles.size() >= MAX_PENDING_LOADS)
+        return; // already loading or retried on next paint
+
+    const int generation = mGeneration;
+    const QSharedPointer<std::atomic<bool>> canceled(new std::atomic<bool>(false));
+    mLoadingTiles.insert(key, canceled);
+    // Coarser levels first, they fill in for the others
+    mLoaderThreadPool.start(new RasterTileLoader(tilePath(mPyramidDir, mInfo, level, x, y), canceled, [this, key, level, x, y, generation, canceled](const QImage &image) {
+        // QPixmap can only be created on the GUI thread
+        QMetaObject::invokeMethod(this, [this, key, level, x, y, image, generation, canceled]() {
+            tileLoaded(key, level, x, y, image, generation, canceled);
+        }, Qt::QueuedConnection);
+    }), level);
+}
+
+void RasterOverlayModule::tileLoaded(quint64 key, int level, int x, int y, const QImage &image, int generation, QSharedPointer<std::atomic<bool>> canceled)
+{
+    if (mLoadingTiles.value(key) == canceled)
+        mLoadingTiles.remove(key);
+    if (generation != mGeneration)
+        return;
+
+    if (image.isNull())
+        mMissingTiles.insert(key);
+    else
+        mTileCache.insert(key, OsmTile(QPixmap::fromImage(image), level, x, y));
+    emit requestRepaint();
+}
+
+void RasterOverlayModule::cancelLoads(const QSet<quint64> &keep)
+{
+    for (auto it = mLoadingTiles.begin(); it != mLoadingTiles.end();) {
+        if (keep.contains(it.key())) {
+            ++it;
+            continue;
+        }
+        *it.value() = true;
+        it = mLoadingTiles.erase(it);
+    }
+}
+
+QSize RasterOverlayModule::levelSize(const RasterPyramidInfo &info, int level)
+{
+    int width = info.width, height = info.height;
+    for (int i = 0; i < level; i++) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+    return QSize(width, height);
+}
+
+QString RasterOverlayModule::tilePath(const QString &pyramidDir, const RasterPyramidInfo &info, int level, int x, int y)
+{
+    return QString("%1/%2/%3_%4.%5").arg(pyramidDir).arg(level).arg(x).arg(y).arg(info.format);
+}
+
+bool RasterOverlayModule::buildPyramid(const QString &sourcePath, const QString &pyramidDir, const std::atomic<bool> &cancel,
+                                       const std::function<void(int, int)> &progress, RasterPyramidInfo &info, QString &errorString)
+{
+    GeoTiffReader reader;
+    if (!reader.open(sourcePath, errorString))
+        return false;
+
+    info = RasterPyramidInfo();
+    info.width = reader.getWidth();
+    info.height = reader.getHeight();
+    info.format = reader.hasAlpha() ? "png" : "jpg";
+    info.georeference = reader.getGeoreference();
+    info.levels = 1;
+    while (std::max(levelSize(info, info.levels - 1).width(), levelSize(info, info.levels - 1).height()) > TILE_SIZE)
+        info.levels++;
+
+    QDir(pyramidDir).removeRecursively(); // incomplete earlier build
+    int tilesTotal = 0;
+    for (int level = 0; level < info.levels; level++) {
+        const QSize size = levelSize(info, level);
+        tilesTotal += ((size.width() + TILE_SIZE - 1) / TILE_SIZE) * ((size.height() + TILE_SIZE - 1) / TILE_SIZE);
+        if (!QDir().mkpath(QString("%1/%2").arg(pyramidDir).arg(level))) {
+            errorString = "cannot create " + pyramidDir;
+            return false;
+        }
+    }
+
+    int tilesDone = 0;
+    auto saveTile = [&](const QImage &tile, int level, int x, int y) {
+        if (!tile.save(tilePath(pyramidDir, info, level, x, y), nullptr, info.format == "jpg" ? JPEG_QUALITY : -1)) {
+            errorString = "cannot write tiles to " + pyramidDir;
+            return false;
+        }
+        if (++tilesDone % 64 == 0 || tilesDone == tilesTotal)
+            progress(tilesDone, tilesTotal);
+        return true;
+    };
+
+    // Level 0 in bands of whole tile rows that cover whole source blocks: every block is decoded once, at most twice
+    const int bandHeight = std::min(((reader.getBlockHeight() + TILE_SIZE - 1) / TILE_SIZE) * TILE_SIZE, ((info.height + TILE_SIZE - 1) / TILE_SIZE) * TILE_SIZE);
+    for (int bandY = 0; bandY < info.height; bandY += bandHeight) {
+        const int bandRows = std::min(bandHeight, info.height - bandY);
+        QImage band;
+        for (int blockY = bandY / reader.getBlockHeight(); blockY <= (bandY + bandRows - 1) / reader.getBlockHeight(); blockY++) {
+            for (int blockX = 0; blockX < reader.getBlocksAcross(); blockX++) {
+                if (cancel)
+                    return false;
+                const QImage block = reader.readBlock(blockX, blockY, &errorString);
+                if (block.isNull())
+                    return false;
+                if (band.isNull()) {
+                    band = QImage(info.width, bandRows, block.format());
+                    if (band.isNull()) {
+                        errorString = "not enough memory for the source blocks";
+                        return false;
+                    }
+                    band.fill(Qt::transparent);
+                }
+
+                const int bytesPerPixel = block.depth() / 8;
+                const int columns = std::min(block.width(), info.width - blockX * reader.getBlockWidth());
+                const int firstRow = std::max(bandY, blockY * reader.getBlockHeight());
+                const int endRow = std::min(bandY + bandRows, std::min(blockY * reader.getBlockHeight() + block.height(), info.height));
+                for (int row = firstRow; row < endRow; row++)
+                    memcpy(band.scanLine(row - bandY) + (qint64)blockX * reader.getBlockWidth() * bytesPerPixel,
+                           block.constScanLine(row - blockY * reader.getBlockHeight()), (size_t)columns * bytesPerPixel);
+            }
+        }
+
+        for (int tileY = 0; tileY * TILE_SIZE < bandRows; tileY++)
+            for (int tileX = 0; tileX * TILE_SIZE < info.width; tileX++)
+                if (!saveTile(band.copy(tileX * TILE_SIZE, tileY * TILE_SIZE, std::min(TILE_SIZE, info.width - tileX * TILE_SIZE),
+                                        std::min(TILE_SIZE, bandRows - tileY * TILE_SIZE)), 0, tileX, bandY / TILE_SIZE + tileY))
+                    return false;
+    }
+
+    // Levels above from their four children
+    for (int level = 1; level < info.levels; level++) {
+        const QSize size = levelSize(info, level);
+        for (int tileY = 0; tileY * TILE_SIZE < size.height(); tileY++) {
+            for (int tileX = 0; tileX * TILE_SIZE < size.width(); tileX++) {
+                if (cancel)
+                    return false;
+
+                QImage children;
+                QPainter painter;
+                QSize childrenSize(0, 0);
+                for (int j = 0; j < 2; j++) {
+                    for (int i = 0; i < 2; i++) {
+                        QImage child;
+                        if (!child.load(tilePath(pyramidDir, info, level - 1, 2 * tileX + i, 2 * tileY + j)))
+                            continue;
+                        if (children.isNull()) {
+                            children = QImage(2 * TILE_SIZE, 2 * TILE_SIZE, info.format == "png" ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+                            children.fill(Qt::transparent);
+                            painter.begin(&children);
+                        }
+                        painter.drawImage(i * TILE_SIZE, j * TILE_SIZE, child);
+                        childrenSize = childrenSize.expandedTo(QSize(i * TILE_SIZE + child.width(), j * TILE_SIZE + child.height()));
+                    }
+                }
+                if (children.isNull()) {
+                    errorString = "missing tiles in " + pyramidDir;
+                    return false;
+                }
+                painter.end();
+
+                const QSize tileSize(std::min(TILE_SIZE, size.width() - tileX * TILE_SIZE), std::min(TILE_SIZE, size.height() - tileY * TILE_SIZE));
+                const QImage tile = children.copy(QRect(QPoint(0, 0), childrenSize)).scaled(tileSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                if (!saveTile(tile, level, tileX, tileY))
+                    return false;
+            }
+        }
+    }
+
+    if (!writePyramidInfo(pyramidDir, info)) {
+        errorString = "cannot write " + pyramidDir + "/" + PYRAMID_INFO_FILE;
+        return false;
+    }
+    return true;
+}
+
+bool RasterOverlayModule::readPyramidInfo(const QString &pyramidDir, RasterPyramidInfo &info)
+{
+    QFile file(pyramidDir + "/" + PYRAMID_INFO_FILE);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonArray pixelToModel = json.value("pixelToModel").toArray();
+    if (pixelToModel.size() != 6)
+        return false;
+
+    info.width = json.value("width").toInt();
+    info.height = json.value("height").toInt();
+    info.levels = json.value("levels").toInt();
+    info.format = json.value("format").toString();
+    info.georeference.valid = true;
+    info.georeference.epsg = json.value("epsg").toInt();
+    info.georeference.geographic = json.value("geographic").toBool();
+    for (int i = 0; i < 6; i++)
+        info.georeference.pixelToModel[i] = pixelToModel.at(i).toDouble();
+
+    return info.width > 0 && info.height > 0 && info.levels > 0 && json.value("tileSize").toInt() == TILE_SIZE &&
+            (info.format == "jpg" || info.format == "png");
+}
+
+bool RasterOverlayModule::writePyramidInfo(const QString &pyramidDir, const RasterPyramidInfo &info)
+{
+    QJsonArray pixelToModel;
+    for (double value : info.georeference.pixelToModel)
+        pixelToModel.append(value);
+
+    QJsonObject json;
+    json.insert("width", info.width);
+    json.insert("height", info.height);
+    json.insert("levels", info.levels);
+    json.insert("tileSize", TILE_SIZE);
+    json.insert("format", info.format);
+    json.insert("epsg", info.georeference.epsg);
+    json.insert("geographic", info.georeference.geographic);
+    json.insert("pixelToModel", pixelToModel);
+
+    QFile file(pyramidDir + "/" + PYRAMID_INFO_FILE);
+    return file.open(QIODevice::WriteOnly) && file.write(QJsonDocument(json).toJson()) > 0;
+}
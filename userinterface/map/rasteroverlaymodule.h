@@ -0,0 +1,112 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * MapModule that draws a georeferenced raster image (GeoTIFF, e.g., a drone orthophoto, see GeoTiffReader) as map background.
+ * Once per file, a tile pyramid is built on disk in the background: level 0 has the image's resolution in TILE_SIZE tiles,
+ * every level above halves it until the image fits a single tile. Later opens of the same file (path, size and modification time)
+ * reuse it. Painting only uses the pyramid level that matches the current scale: tiles are loaded asynchronously from disk into
+ * an OsmTileCache as in OsmClient, parent tiles fill in until they arrive. Each tile is drawn georeferenced at its exact corners,
+ * i.e., the image's projection is followed tile by tile. Add the module before others to draw it below them.
+ */
+
+#ifndef RASTEROVERLAYMODULE_H
+#define RASTEROVERLAYMODULE_H
+
+#include "userinterface/map/mapwidget.h"
+#include "userinterface/map/osmtilecache.h"
+#include "userinterface/map/geotiffreader.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <atomic>
+#include <functional>
+
+struct RasterPyramidInfo {
+    int width = 0; // of level 0 [px]
+    int height = 0;
+    int levels = 0;
+    QString format; // of the tile files, "jpg" or "png" (with alpha)
+    GeoTiffGeoreference georeference;
+};
+
+class RasterOverlayModule : public MapModule
+{
+    Q_OBJECT
+public:
+    RasterOverlayModule();
+    ~RasterOverlayModule();
+
+    // Opens a GeoTIFF, builds its pyramid unless built before (pyramidProgress, then pyramidReady). false (errorString) if the
+    // file cannot be read, is not georeferenced or has an unsupported projection.
+    bool openGeoTiff(const QString &path, QString &errorString);
+    void close(); // cancels a running build
+    bool isReady() const { return mReady; }
+    const RasterPyramidInfo &getPyramidInfo() const { return mInfo; }
+
+    // Pyramids are kept in sub directories, default: QStandardPaths::CacheLocation/raster_pyramids. Before openGeoTiff.
+    void setCacheDir(const QString &cacheDir) { mCacheDir = cacheDir; }
+    QString getCacheDir() const { return mCacheDir; }
+    void setOpacity(double opacity) { mOpacity = opacity; emit requestRepaint(); }
+    void setMemoryCacheSize(qint64 maxBytes) { mTileCache.setMaxBytes(maxBytes); }
+
+    // MapModule interface
+    virtual void processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale) override;
+    virtual void enuReferenceChanged(const llh_t &enuReference) override;
+
+    // Builds the pyramid of sourcePath in pyramidDir, progress from the calling thread. false on error or when canceled.
+    static bool buildPyramid(const QString &sourcePath, const QString &pyramidDir, const std::atomic<bool> &cancel,
+                             const std::function<void(int tilesDone, int tilesTotal)> &progress, RasterPyramidInfo &info, QString &errorString);
+
+    static constexpr int TILE_SIZE = 256;
+    static constexpr int LOADER_THREADS = 2;
+    static constexpr int MAX_PENDING_LOADS = 32;
+    static constexpr int MAX_VISIBLE_TILES = 300; // coarser levels above
+    static constexpr int JPEG_QUALITY = 90;
+
+signals:
+    void pyramidProgress(int tilesDone, int tilesTotal);
+    void pyramidReady(bool success, const QString &errorString);
+
+private:
+    static bool readPyramidInfo(const QString &pyramidDir, RasterPyramidInfo &info);
+    static bool writePyramidInfo(const QString &pyramidDir, const RasterPyramidInfo &info);
+    static QString tilePath(const QString &pyramidDir, const RasterPyramidInfo &info, int level, int x, int y);
+    static QSize levelSize(const RasterPyramidInfo &info, int level);
+    static quint64 calcKey(int level, int x, int y) { return ((quint64)level << 50) | ((quint64)x << 25) | (quint64)y; }
+
+    void buildFinished(bool success, const RasterPyramidInfo &info, const QString &errorString, int generation);
+    void loadTile(quint64 key, int level, int x, int y);
+    void tileLoaded(quint64 key, int level, int x, int y, const QImage &image, int generation, QSharedPointer<std::atomic<bool>> canceled);
+    void cancelLoads(const QSet<quint64> &keep);
+    void updateGeometry(); // after a new pyramid or ENU reference
+    QPointF getPixelEnu_mm(int column, int row); // of a level 0 pixel corner
+    // Level 0 pixels pixelRect of the image drawn from sourceRect of pixmap
+    void drawTile(QPainter &painter, const QTransform &drawTrans, const QRect &pixelRect, const QPixmap &pixmap, const QRectF &sourceRect);
+
+    QString mCacheDir;
+    QString mPyramidDir;
+    RasterPyramidInfo mInfo;
+    bool mReady = false;
+    int mGeneration = 0; // of the opened file, results for earlier ones are dropped
+    double mOpacity = 1.0;
+
+    QThread mThread; // pyramid builds
+    QObject *mThreadContext;
+    QSharedPointer<std::atomic<bool>> mBuildCanceled;
+
+    OsmTileCache mTileCache;
+    QThreadPool mLoaderThreadPool;
+    QHash<quint64, QSharedPointer<std::atomic<bool>>> mLoadingTiles;
+    QSet<quint64> mMissingTiles; // not in the pyramid
+
+    coordinateTransforms::EnuFrame mEnuFrame;
+    bool mEnuReferenceSet = false;
+    QHash<quint64, QPointF> mCornerEnu_mm; // by (column << 32) | row
+    QTransform mEnuToPixel; // approximation at the image corners, for the visible pixels [mm -> px]
+    double mPixelSize_mm = 0.0; // of level 0
+};
+
+#endif // RASTEROVERLAYMODULE_H
@@ -0,0 +1,212 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routedocument.h"
+#include "core/enureprojector.h"
+#include <QUndoCommand>
+#include <algorithm>
+#include <functional>
+
+class RouteDocument::ReplacePointsCommand : public QUndoCommand
+{
+public:
+    ReplacePointsCommand(RouteDocument *document, int routeIndex, int position, int removeCount, const QVector<pospoint_t> &points,
+                         int mergeId = -1, QUndoCommand *parent = nullptr)
+        : QUndoCommand(parent), mDocument(document), mRouteIndex(routeIndex), mPosition(position),
+          mRemovedPoints(document->mRoutes.at(routeIndex).mid(position, removeCount)), mInsertedPoints(points), mMergeId(mergeId)
+    {
+        if (mRemovedPoints.isEmpty())
+            setText(points.size() == 1 ? "Insert point" : "Insert points");
+        else if (points.isEmpty())
+            setText(mRemovedPoints.size() == 1 ? "Remove point" : "Remove points");
+        else
+            setText(mRemovedPoints.size() == 1 && points.size() == 1 ? "Edit point" : "Replace points");
+    }
+
+    void redo() override { mDocument->doReplacePoints(mRouteIndex, mPosition, mRemovedPoints.size(), mInsertedPoints); }
+    void undo() override { mDocument->doReplacePoints(mRouteIndex, mPosition, mInsertedPoints.size(), mRemovedPoints); }
+
+    int id() const override { return (mMergeId >= 0) ? 1 : -1; }
+    bool mergeWith(const QUndoCommand *other) override
+    {
+        const ReplacePointsCommand *command = static_cast<const ReplacePointsCommand*>(other);
+        if (command->mMergeId != mMergeId || command->mRouteIndex != mRouteIndex || command->mPosition != mPosition ||
+                mInsertedPoints.size() != 1 || command->mRemovedPoints.size() != 1 || command->mInsertedPoints.size() != 1)
+            return false;
+        mInsertedPoints = command->mInsertedPoints;
+        return true;
+    }
+
+    void reprojectEnu(const coordinateTransforms::EnuTransform &transform)
+    {
+        EnuReprojector::reprojectPoints(transform, mRemovedPoints);
+        EnuReprojector::reprojectPoints(transform, mInsertedPoints);
+    }
+
+private:
+    RouteDocument *mDocument;
+    int mRouteIndex;
+    int mPosition;
+    QVector<pospoint_t> mRemovedPoints;
+    QVector<pospoint_t> mInsertedPoints;
+    int mMergeId;
+};
+
+class RouteDocument::ReverseRouteCommand : public QUndoCommand
+{
+public:
+    ReverseRouteCommand(RouteDocument *document, int routeIndex) : QUndoCommand("Reverse route"), mDocument(document), mRouteIndex(routeIndex) {}
+
+    void redo() override { mDocument->doReverseRoute(mRouteIndex); }
+    void undo() override { mDocument->doReverseRoute(mRouteIndex); }
+
+private:
+    RouteDocument *mDocument;
+    int mRouteIndex;
+};
+
+class RouteDocument::InsertRouteCommand : public QUndoCommand
+{
+public:
+    InsertRouteCommand(RouteDocument *document, int index, const QVector<pospoint_t> &route, QUndoCommand *parent = nullptr)
+        : QUndoCommand("Add route", parent), mDocument(document), mIndex(index), mRoute(route) {}
+
+    void redo() override { mDocument->doInsertRoute(mIndex, mRoute); }
+    void undo() override { mDocument->doRemoveRoute(mIndex); }
+    void reprojectEnu(const coordinateTransforms::EnuTransform &transform) { EnuReprojector::reprojectPoints(transform, mRoute); }
+
+private:
+    RouteDocument *mDocument;
+    int mIndex;
+    QVector<pospoint_t> mRoute;
+};
+
+class RouteDocument::RemoveRouteCommand : public QUndoCommand
+{
+public:
+    RemoveRouteCommand(RouteDocument *document, int index, QUndoCommand *parent = nullptr)
+        : QUndoCommand("Remove route", parent), mDocument(document), mIndex(index), mRoute(document->mRoutes.at(index)) {}
+
+    void redo() override { mDocument->doRemoveRoute(mIndex); }
+    void undo() override { mDocument->doInsertRoute(mIndex, mRoute); }
+    void reprojectEnu(const coordinateTransforms::EnuTransform &transform) { EnuReprojector::reprojectPoints(transform, mRoute); }
+
+private:
+    RouteDocument *mDocument;
+    int mIndex;
+    QVector<pospoint_t> mRoute; // shares the points with the removed route
+};
+
+RouteDocument::RouteDocument(QObject *parent) : QObject(parent)
+{
+}
+
+void RouteDocument::setRoutes(const QList<QVector<pospoint_t>> &routes)
+{
+    mUndoStack.clear();
+    mRoutes = routes;
+    emit routesReset();
+}
+
+void RouteDocument::insertRoute(int index, const QVector<pospoint_t> &route)
+{
+    mUndoStack.push(new InsertRouteCommand(this, index, route));
+}
+
+void RouteDocument::removeRoute(int index)
+{
+    mUndoStack.push(new RemoveRouteCommand(this, index));
+}
+
+void RouteDocument::replacePoints(int routeIndex, int position, int removeCount, const QVector<pospoint_t> &points)
+{
+    if (removeCount == 0 && points.isEmpty())
+        return;
+    mUndoStack.push(new ReplacePointsCommand(this, routeIndex, position, removeCount, points));
+}
+
+void RouteDocument::setPoint(int routeIndex, int position, const pospoint_t &point, int mergeId)
+{
+    mUndoStack.push(new ReplacePointsCommand(this, routeIndex, position, 1, {point}, mergeId));
+}
+
+void RouteDocument::reverseRoute(int routeIndex)
+{
+    mUndoStack.push(new ReverseRouteCommand(this, routeIndex));
+}
+
+void RouteDocument::appendRouteTo(int routeIndex, int targetRouteIndex)
+{
+    // Children are undone in reverse order, i.e., the route is restored before the appended points are removed
+    QUndoCommand *command = new QUndoCommand("Append route");
+    new ReplacePointsCommand(this, targetRouteIndex, mRoutes.at(targetRouteIndex).size(), 0, mRoutes.at(routeIndex), -1, command);
+    new RemoveRouteCommand(this, routeIndex, command);
+    mUndoStack.push(command);
+}
+
+void RouteDocument::splitRouteAt(int routeIndex, int pointIndex)
+{
+    const QVector<pospoint_t> &route = mRoutes.at(routeIndex);
+    QUndoCommand *command = new QUndoCommand("Split route");
+    new InsertRouteCommand(this, mRoutes.size(), route.mid(pointIndex), command);
+    new ReplacePointsCommand(this, routeIndex, pointIndex, route.size() - pointIndex, {}, -1, command);
+    mUndoStack.push(command);
+}
+
+void RouteDocument::reprojectEnu(const coordinateTransforms::EnuTransform &transform)
+{
+    for (QVector<pospoint_t> &route : mRoutes)
+        EnuReprojector::reprojectPoints(transform, route);
+
+    // Commands hold the points they replace or insert (also as children, e.g., of appendRouteTo)
+    std::function<void(QUndoCommand*)> reprojectCommand = [&](QUndoCommand *command) {
+        if (ReplacePointsCommand *replacePoints = dynamic_cast<ReplacePointsCommand*>(command))
+            replacePoints->reprojectEnu(transform);
+        else if (InsertRouteCommand *insertRoute = dynamic_cast<InsertRouteCommand*>(command))
+            insertRoute->reprojectEnu(transform);
+        else if (RemoveRouteCommand *removeRoute = dynamic_cast<RemoveRouteCommand*>(command))
+            removeRoute->reprojectEnu(transform);
+        for (int i = 0; i < command->childCount(); i++)
+            reprojectCommand(const_cast<QUndoCommand*>(command->child(i)));
+    };
+    for (int i = 0; i < mUndoStack.count(); i++)
+        reprojectCommand(const_cast<QUndoCommand*>(mUndoStack.command(i)));
+}
+
+void RouteDocument::doReplacePoints(int routeIndex, int position, int removeCount, const QVector<pospoint_t> &points)
+{
+    // In place, only the points after position are moved if the size changes
+    QVector<pospoint_t> &route = mRoutes[routeIndex];
+    const int oldSize = route.size();
+    const int newSize = oldSize - removeCount + points.size();
+    if (newSize > oldSize) {
+        route.resize(newSize);
+        std::move_backward(route.begin() + position + removeCount, route.begin() + oldSize, route.end());
+    } else if (newSize < oldSize) {
+        std::move(route.begin() + position + removeCount, route.end(), route.begin() + position + points.size());
+        route.resize(newSize);
+    }
+    std::copy(points.begin(), points.end(), route.begin() + position);
+
+    emit pointsChanged(routeIndex, position, position + std::max(removeCount, int(points.size())) - 1, newSize != oldSize);
+}
+
+void RouteDocument::doReverseRoute(int routeIndex)
+{
+    QVector<pospoint_t> &route = mRoutes[routeIndex];
+    std::reverse(route.begin(), route.end());
+    emit pointsChanged(routeIndex, 0, route.size() - 1, false);
+}
+
+void RouteDocument::doInsertRoute(int index, const QVector<pospoint_t> &route)
+{
+    mRoutes.insert(index, route);
+    emit routeInserted(index);
+}
+
+void RouteDocument::doRemoveRoute(int index)
+{
+    mRoutes.removeAt(index);
+    emit routeRemoved(index);
+}
@@ -0,0 +1,74 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Editable set of routes, e.g., of RoutePlannerModule. All edits are done in place and pushed to an undo stack as
+ * commands holding the difference only: the replaced and inserted points of a route (a reversal holds no points at all),
+ * or a removed route. Changes are notified with the range of affected points, i.e., views only update what changed.
+ */
+
+#ifndef ROUTEDOCUMENT_H
+#define ROUTEDOCUMENT_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QUndoStack>
+#include "core/pospoint.h"
+#include "core/coordinatetransforms.h"
+
+class RouteDocument : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RouteDocument(QObject *parent = nullptr);
+
+    int getNumberOfRoutes() const { return mRoutes.size(); }
+    const QVector<pospoint_t> &getRoute(int index) const { return mRoutes.at(index); }
+    const QList<QVector<pospoint_t>> &getRoutes() const { return mRoutes; }
+    void setRoutes(const QList<QVector<pospoint_t>> &routes); // clears the undo stack
+
+    // Undoable edits
+    void insertRoute(int index, const QVector<pospoint_t> &route);
+    void removeRoute(int index);
+    // Replaces removeCount points from position on with points
+    void replacePoints(int routeIndex, int position, int removeCount, const QVector<pospoint_t> &points);
+    void insertPoint(int routeIndex, int position, const pospoint_t &point) { replacePoints(routeIndex, position, 0, {point}); }
+    void removePoint(int routeIndex, int position) { replacePoints(routeIndex, position, 1, {}); }
+    void appendPoints(int routeIndex, const QVector<pospoint_t> &points) { replacePoints(routeIndex, mRoutes.at(routeIndex).size(), 0, points); }
+    void clearRoute(int routeIndex) { replacePoints(routeIndex, 0, mRoutes.at(routeIndex).size(), {}); }
+    // Consecutive edits of the same point with the same mergeId >= 0 are undone at once, e.g., while dragging it
+    void setPoint(int routeIndex, int position, const pospoint_t &point, int mergeId = -1);
+    void reverseRoute(int routeIndex);
+    void appendRouteTo(int routeIndex, int targetRouteIndex); // removes the appended route
+    void splitRouteAt(int routeIndex, int pointIndex); // points from pointIndex on become a new last route
+
+    QUndoStack *getUndoStack() { return &mUndoStack; }
+
+    // Converts all routes and the points held by the undo stack to another ENU reference, not undoable itself.
+    // Does not emit, e.g., for EnuReprojector's worker threads: views have to be reset afterwards.
+    void reprojectEnu(const coordinateTransforms::EnuTransform &transform);
+
+signals:
+    void routesReset();
+    void routeInserted(int index);
+    void routeRemoved(int index);
+    // Points firstIndex to lastIndex changed in place or, with sizeChanged, all points from firstIndex on
+    void pointsChanged(int routeIndex, int firstIndex, int lastIndex, bool sizeChanged);
+
+private:
+    class ReplacePointsCommand;
+    class ReverseRouteCommand;
+    class InsertRouteCommand;
+    class RemoveRouteCommand;
+
+    void doReplacePoints(int routeIndex, int position, int removeCount, const QVector<pospoint_t> &points);
+    void doReverseRoute(int routeIndex);
+    void doInsertRoute(int index, const QVector<pospoint_t> &route);
+    void doRemoveRoute(int index);
+
+    QList<QVector<pospoint_t>> mRoutes;
+    QUndoStack mUndoStack;
+};
+
+#endif // ROUTEDOCUMENT_H
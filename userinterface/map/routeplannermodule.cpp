@@ -3,6 +3,9 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "routeplannermodule.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 RoutePlannerModule::RoutePlannerModule()
 {
@@ -34,19 +37,168 @@ RoutePlannerModule::RoutePlannerModule()
         mPixmaps.append(pix);
     }
 
-    mRoutes.clear();
-    mRoutes.append(QList<PosPoint>());
+    connect(&mRouteDocument, &RouteDocument::routesReset, this, &RoutePlannerModule::routesReset);
+    connect(&mRouteDocument, &RouteDocument::routeInserted, this, &RoutePlannerModule::routeInserted);
+    connect(&mRouteDocument, &RouteDocument::routeRemoved, this, &RoutePlannerModule::routeRemoved);
+    connect(&mRouteDocument, &RouteDocument::pointsChanged, this, &RoutePlannerModule::pointsChanged);
+    mRouteDocument.setRoutes({QVector<pospoint_t>()});
 }
 
 void RoutePlannerModule::processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale)
 {
-    Q_UNUSED(width)
-    Q_UNUSED(height)
-    for (int rn = 0; rn < mRoutes.size(); rn++) {
-        drawRoute(painter, drawTrans, txtTrans, highQuality, scale, mRoutes[rn], rn, rn == mPlannerState.currentRouteIndex, mPlannerState.drawRouteText);
+    const QRectF view_mm = drawTrans.inverted().mapRect(QRectF(0, 0, width, height));
+    for (int rn = 0; rn < mRouteDocument.getNumberOfRoutes(); rn++) {
+        updateRouteCache(rn);
+        drawRoute(painter, drawTrans, txtTrans, highQuality, scale, mRouteDocument.getRoute(rn), mRouteCaches[rn], view_mm, rn, rn == mPlannerState.currentRouteIndex, mPlannerState.drawRouteText);
     }
 }
 
+void RoutePlannerModule::routesReset()
+{
+    mRouteCaches = QVector<RouteRenderCache>(mRouteDocument.getNumberOfRoutes());
+    mPlannerState.currentRouteIndex = std::max(0, std::min(mPlannerState.currentRouteIndex, mRouteDocument.getNumberOfRoutes() - 1));
+    mHitIndexValid = false;
+    emit requestRepaint();
+}
+
+void RoutePlannerModule::routeInserted(int index)
+{
+    mRouteCaches.insert(index, RouteRenderCache());
+    mHitIndexValid = false; // ids of the following routes changed
+    emit requestRepaint();
+}
+
+void RoutePlannerModule::routeRemoved(int index)
+{
+    mRouteCaches.remove(index);
+    if (mPlannerState.currentRouteIndex >= mRouteDocument.getNumberOfRoutes())
+        mPlannerState.currentRouteIndex = std::max(0, mRouteDocument.getNumberOfRoutes() - 1);
+    mHitIndexValid = false;
+    emit requestRepaint();
+}
+
+void RoutePlannerModule::pointsChanged(int routeIndex, int firstIndex, int lastIndex, bool sizeChanged)
+{
+    if (firstIndex > lastIndex && !sizeChanged)
+        return;
+
+    RouteRenderCache &cache = mRouteCaches[routeIndex];
+    cache.dirtyFrom = std::min(cache.dirtyFrom, firstIndex);
+    cache.dirtyTo = sizeChanged ? std::numeric_limits<int>::max() : std::max(cache.dirtyTo, lastIndex);
+
+    if (mHitIndex && mHitIndexValid) {
+        if (!sizeChanged && firstIndex == lastIndex)
+            mHitIndex->movePoint(this, routeIndex, firstIndex, mRouteDocument.getRoute(routeIndex).at(firstIndex).getPoint());
+        else
+            mHitIndexChangedRoutes.insert(routeIndex);
+    }
+    emit requestRepaint();
+}
+
+void RoutePlannerModule::updateRouteCache(int routeIndex)
+{
+    RouteRenderCache &cache = mRouteCaches[routeIndex];
+    if (cache.isValid())
+        return;
+
+    // Chunk k starts at point k * ROUTE_CHUNK_POINTS - 1, i.e., point i is in chunks (i + 1) / ROUTE_CHUNK_POINTS and i / ROUTE_CHUNK_POINTS
+    const QVector<pospoint_t> &route = mRouteDocument.getRoute(routeIndex);
+    const int dirtyFrom = std::min<int>(cache.dirtyFrom, route.size());
+    const int chunkCount = (route.size() + ROUTE_CHUNK_POINTS - 1) / ROUTE_CHUNK_POINTS;
+    const int firstChunk = dirtyFrom / ROUTE_CHUNK_POINTS;
+    const int lastChunk = (cache.dirtyTo >= route.size() - 1) ? chunkCount - 1 : std::min(chunkCount - 1, (cache.dirtyTo + 1) / ROUTE_CHUNK_POINTS);
+    cache.chunks.resize(chunkCount);
+    for (int chunkIndex = firstChunk; chunkIndex <= lastChunk; chunkIndex++)
+        cache.chunks[chunkIndex] = buildRouteChunk(route, chunkIndex * ROUTE_CHUNK_POINTS);
+
+    // Arc lengths of all following points change, a point's label and curvature depend on its neighbours
+    cache.geometry.truncate(dirtyFrom);
+    cache.geometry.appendRoute(route.mid(cache.geometry.size()));
+    cache.annotations.resize(route.size());
+    for (int i = std::max(0, dirtyFrom - 1); i < cache.annotations.size(); i++)
+        cache.annotations[i].clear();
+
+    cache.dirtyFrom = std::numeric_limits<int>::max();
+    cache.dirtyTo = -1;
+}
+
+RoutePlannerModule::RouteChunk RoutePlannerModule::buildRouteChunk(const QVector<pospoint_t> &route, int start)
+{
+    // Chunks overlap in one point to be drawn connected
+    RouteChunk chunk;
+    chunk.firstIndex = std::max(0, start - 1);
+    const int end = std::min<int>(route.size(), start + ROUTE_CHUNK_POINTS);
+    chunk.points_mm.reserve(end - chunk.firstIndex);
+    const QPointF first_mm = route.at(chunk.firstIndex).getPointMm();
+    double left = first_mm.x(), right = first_mm.x(), top = first_mm.y(), bottom = first_mm.y();
+    double length_mm = 0.0;
+    for (int i = chunk.firstIndex; i < end; i++) {
+        const QPointF p = route.at(i).getPointMm();
+        if (!chunk.points_mm.isEmpty())
+            length_mm += QLineF(chunk.points_mm.last(), p).length();
+        chunk.points_mm.append(p);
+        left = std::min(left, p.x());
+        right = std::max(right, p.x());
+        top = std::min(top, p.y());
+        bottom = std::max(bottom, p.y());
+    }
+    chunk.bounds_mm = QRectF(QPointF(left, top), QPointF(right, bottom));
+    chunk.meanSpacing_mm = chunk.points_mm.size() > 1 ? length_mm / (chunk.points_mm.size() - 1) : std::numeric_limits<double>::infinity();
+    return chunk;
+}
+
+void RoutePlannerModule::hitIndexChanged()
+{
+    mHitIndexValid = false;
+}
+
+void RoutePlannerModule::updateHitIndex()
+{
+    if (!mHitIndex)
+        return;
+
+    auto setRoutePoints = [this](int rn) {
+        QVector<QPointF> points;
+        points.reserve(mRouteDocument.getRoute(rn).size());
+        for (const auto &point : mRouteDocument.getRoute(rn))
+            points.append(point.getPoint());
+        mHitIndex->setPoints(this, rn, points);
+    };
+
+    if (mHitIndexValid) {
+        for (int rn : mHitIndexChangedRoutes)
+            setRoutePoints(rn);
+    } else {
+        mHitIndex->removeOwner(this);
+        for (int rn = 0; rn < mRouteDocument.getNumberOfRoutes(); rn++)
+            setRoutePoints(rn);
+    }
+
+    mHitIndexChangedRoutes.clear();
+    mHitIndexValid = true;
+}
+
+const QString &RoutePlannerModule::getAnnotation(RouteRenderCache &cache, const QVector<pospoint_t> &route, int i)
+{
+    QString &pointLabel = cache.annotations[i];
+    if (pointLabel.isEmpty()) {
+        QTextStream pointLabelStream(&pointLabel);
+        pointLabelStream.setRealNumberPrecision(2);
+        //QTime t = route[i].getTime();
+        pointLabelStream << "P: " << i << ((i == 0) ? "- start" : ((i == route.size()-1) ? "- end" : "")) << Qt::endl
+                         << "(" << route[i].x <<  ", " << route[i].y << ", " << route[i].height << ")" << Qt::endl;
+        pointLabelStream.setRealNumberPrecision(1);
+        pointLabelStream << route[i].speed * 3.6 << " km/h" << Qt::endl
+                         << "s: " << cache.geometry.getArcLength(i) << " m";
+        const double curvature = fabs(cache.geometry.getCurvature(i));
+        if (curvature > 1e-6)
+            pointLabelStream << ", R: " << 1.0 / curvature << " m";
+        pointLabelStream << Qt::endl
+                         << "A: " << QString("%1").arg(route[i].attributes, 8, 16, QLatin1Char('0'));
+    }
+    return pointLabel;
+}
+
 bool RoutePlannerModule::processMouse(bool isPress, bool isRelease, bool isMove, bool isWheel, QPoint widgetPos, PosPoint mapPos,
                                       double wheelAngleDelta, Qt::KeyboardModifiers keyboardModifiers, Qt::MouseButtons mouseButtons, double scale)
 {
@@ -54,10 +206,6 @@ bool RoutePlannerModule::processMouse(bool isPress, bool isRelease, bool isMove,
     Q_UNUSED(widgetPos)
     Q_UNUSED(wheelAngleDelta)
 
-    double routeDist = 0.0;
-    int closestPointOnCurrRouteInd = getClosestPoint(mapPos, mRoutes[mPlannerState.currentRouteIndex], routeDist);
-    bool clickedOnPoint = (routeDist * scale * 1000.0) < 20 && routeDist >= 0.0;
-
     if (isRelease) {
         mPlannerState.currentPointIndex = -1;
         return false;
@@ -65,8 +213,10 @@ bool RoutePlannerModule::processMouse(bool isPress, bool isRelease, bool isMove,
 
     if (isMove) {
         if (mPlannerState.currentPointIndex >= 0) {
-            mRoutes[mPlannerState.currentRouteIndex][mPlannerState.currentPointIndex].setXY(mapPos.getX(), mapPos.getY());
-            emit requestRepaint();
+            pospoint_t movedPoint = mRouteDocument.getRoute(mPlannerState.currentRouteIndex).at(mPlannerState.currentPointIndex);
+            movedPoint.x = mapPos.getX();
+            movedPoint.y = mapPos.getY();
+            mRouteDocument.setPoint(mPlannerState.currentRouteIndex, mPlannerState.currentPointIndex, movedPoint, mPlannerState.dragId);
             return true;
         }
         return false;
@@ -74,54 +224,78 @@ bool RoutePlannerModule::processMouse(bool isPress, bool isRelease, bool isMove,
 
     if (isPress) {
         if (keyboardModifiers == Qt::ShiftModifier) {
+            // Points under the mouse from the hit index, the closest point of the whole route is only needed to insert new points
+            int closestPointOnCurrRouteInd = -1;
+            bool clickedOnPoint = false;
+            if (mHitIndex) {
+                if (!mHitIndexValid || !mHitIndexChangedRoutes.isEmpty())
+                    updateHitIndex();
+                const auto hits = mHitIndex->hitTest(mapPos.getPoint(), CLICK_RADIUS_px / (scale * 1000.0), this, mPlannerState.currentRouteIndex);
+                if (!hits.isEmpty()) {
+                    closestPointOnCurrRouteInd = hits.first().index;
+                    clickedOnPoint = true;
+                }
+            }
+            const QVector<pospoint_t> &route = mRouteDocument.getRoute(mPlannerState.currentRouteIndex);
+            if (!clickedOnPoint) {
+                double routeDist = 0.0;
+                closestPointOnCurrRouteInd = getClosestPoint(mapPos, route, routeDist);
+                clickedOnPoint = !mHitIndex && (routeDist * scale * 1000.0) < CLICK_RADIUS_px && routeDist >= 0.0;
+            }
+
             if (mouseButtons & Qt::LeftButton) {
                 if (clickedOnPoint) { // update existing point
                     if (mPlannerState.updatePointOnClick) {
+                        // Dragging the point afterwards is undone together with the update
                         mPlannerState.currentPointIndex = closestPointOnCurrRouteInd;
-                        mRoutes[mPlannerState.currentRouteIndex][closestPointOnCurrRouteInd].setXYZ({mapPos.getX(), mapPos.getY(), mPlannerState.newPointHeight});
-                        mRoutes[mPlannerState.currentRouteIndex][closestPointOnCurrRouteInd].setSpeed(mPlannerState.newPointSpeed);
-                        mRoutes[mPlannerState.currentRouteIndex][closestPointOnCurrRouteInd].setTime(mPlannerState.newPointTime);
-                        mRoutes[mPlannerState.currentRouteIndex][closestPointOnCurrRouteInd].setAttributes(mPlannerState.newPointAttribute);
+                        mPlannerState.dragId++;
+                        PosPoint updatedPoint(route.at(closestPointOnCurrRouteInd));
+                        updatedPoint.setXYZ({mapPos.getX(), mapPos.getY(), mPlannerState.newPointHeight});
+                        updatedPoint.setSpeed(mPlannerState.newPointSpeed);
+                        updatedPoint.setTime(mPlannerState.newPointTime);
+                        updatedPoint.setAttributes(mPlannerState.newPointAttribute);
+                        mRouteDocument.setPoint(mPlannerState.currentRouteIndex, closestPointOnCurrRouteInd, updatedPoint.toPOD(), mPlannerState.dragId);
                     }
                 } else { // create new point
-                    PosPoint newPoint;
-                    newPoint.setXYZ({mapPos.getX(), mapPos.getY(), mPlannerState.newPointHeight});
-                    newPoint.setSpeed(mPlannerState.newPointSpeed);
-                    newPoint.setTime(mPlannerState.newPointTime);
-                    newPoint.setAttributes(mPlannerState.newPointAttribute);
+                    PosPoint newPosPoint;
+                    newPosPoint.setXYZ({mapPos.getX(), mapPos.getY(), mPlannerState.newPointHeight});
+                    newPosPoint.setSpeed(mPlannerState.newPointSpeed);
+                    newPosPoint.setTime(mPlannerState.newPointTime);
+                    newPosPoint.setAttributes(mPlannerState.newPointAttribute);
+                    const pospoint_t newPoint = newPosPoint.toPOD();
 
                     // some hard to read logic to determine where in the route to insert (before or after closest point?) incl. special cases
-                    if (mRoutes[mPlannerState.currentRouteIndex].size() < 2)
-                        mRoutes[mPlannerState.currentRouteIndex].append(newPoint);
+                    int insertIndex;
+                    if (route.size() < 2)
+                        insertIndex = route.size();
                     else if (closestPointOnCurrRouteInd == 0) {
-                        if (mRoutes[mPlannerState.currentRouteIndex].at(closestPointOnCurrRouteInd + 1).getDistanceTo(mapPos) <
-                                mRoutes[mPlannerState.currentRouteIndex].at(closestPointOnCurrRouteInd).getDistanceTo(mRoutes[mPlannerState.currentRouteIndex].at(closestPointOnCurrRouteInd + 1)))
-                            mRoutes[mPlannerState.currentRouteIndex].insert(closestPointOnCurrRouteInd + 1, newPoint);
+                        if (route.at(closestPointOnCurrRouteInd + 1).getDistanceTo(newPoint) <
+                                route.at(closestPointOnCurrRouteInd).getDistanceTo(route.at(closestPointOnCurrRouteInd + 1)))
+                            insertIndex = closestPointOnCurrRouteInd + 1;
                         else
-                            mRoutes[mPlannerState.currentRouteIndex].insert(closestPointOnCurrRouteInd, newPoint);
-                    } else if (closestPointOnCurrRouteInd == mRoutes[mPlannerState.currentRouteIndex].size() - 1) {
-                        if (mRoutes[mPlannerState.currentRouteIndex].at(closestPointOnCurrRouteInd - 1).getDistanceTo(mapPos) <
-                                mRoutes[mPlannerState.currentRouteIndex].at(closestPointOnCurrRouteInd).getDistanceTo(mRoutes[mPlannerState.currentRouteIndex].at(closestPointOnCurrRouteInd - 1)))
-                            mRoutes[mPlannerState.currentRouteIndex].insert(closestPointOnCurrRouteInd, newPoint);
+                            insertIndex = closestPointOnCurrRouteInd;
+                    } else if (closestPointOnCurrRouteInd == route.size() - 1) {
+                        if (route.at(closestPointOnCurrRouteInd - 1).getDistanceTo(newPoint) <
+                                route.at(closestPointOnCurrRouteInd).getDistanceTo(route.at(closestPointOnCurrRouteInd - 1)))
+                            insertIndex = closestPointOnCurrRouteInd;
                         else
-                            mRoutes[mPlannerState.currentRouteIndex].insert(closestPointOnCurrRouteInd + 1, newPoint);
+                            insertIndex = closestPointOnCurrRouteInd + 1;
                     } else { // "standard case" somewhere on the route
-                        if (mRoutes[mPlannerState.currentRouteIndex].at(closestPointOnCurrRouteInd - 1).getDistanceTo(mapPos) <
-                                mRoutes[mPlannerState.currentRouteIndex].at(closestPointOnCurrRouteInd + 1).getDistanceTo(mapPos))
-                            mRoutes[mPlannerState.currentRouteIndex].insert(closestPointOnCurrRouteInd, newPoint);
+                        if (route.at(closestPointOnCurrRouteInd - 1).getDistanceTo(newPoint) <
+                                route.at(closestPointOnCurrRouteInd + 1).getDistanceTo(newPoint))
+                            insertIndex = closestPointOnCurrRouteInd;
                         else
-                            mRoutes[mPlannerState.currentRouteIndex].insert(closestPointOnCurrRouteInd + 1, newPoint);
+                            insertIndex = closestPointOnCurrRouteInd + 1;
                     }
+                    mRouteDocument.insertPoint(mPlannerState.currentRouteIndex, insertIndex, newPoint);
                 }
-                emit requestRepaint();
                 return true;
             } else if (mouseButtons & Qt::RightButton) {
                 if (clickedOnPoint) {
-                    mRoutes[mPlannerState.currentRouteIndex].removeAt(closestPointOnCurrRouteInd);
+                    mRouteDocument.removePoint(mPlannerState.currentRouteIndex, closestPointOnCurrRouteInd);
                 } else {
     //                removeLastRoutePoint();
                 }
-                emit requestRepaint();
                 return true;
             }
         }
@@ -133,7 +307,7 @@ bool RoutePlannerModule::processMouse(bool isPress, bool isRelease, bool isMove,
 
 void RoutePlannerModule::setCurrentRouteIndex(int index)
 {
-    if (index >= 0 && index < mRoutes.size())
+    if (index >= 0 && index < mRouteDocument.getNumberOfRoutes())
         mPlannerState.currentRouteIndex = index;
     emit requestRepaint();
 }
@@ -146,6 +320,7 @@ int RoutePlannerModule::getCurrentRouteIndex()
 void RoutePlannerModule::setDrawRouteText(bool draw)
 {
     mPlannerState.drawRouteText = draw;
+    emit requestRepaint();
 }
 
 QList<PosPoint> RoutePlannerModule::getCurrentRoute()
@@ -155,12 +330,12 @@ QList<PosPoint> RoutePlannerModule::getCurrentRoute()
 
 QList<PosPoint> RoutePlannerModule::getRoute(int index)
 {
-    return mRoutes.at(index);
+    return PosPoint::fromPODList(mRouteDocument.getRoute(index));
 }
 
 int RoutePlannerModule::getNumberOfRoutes()
 {
-    return mRoutes.size();
+    return mRouteDocument.getNumberOfRoutes();
 }
 
 void RoutePlannerModule::addNewRoute()
@@ -170,19 +345,33 @@ void RoutePlannerModule::addNewRoute()
 
 void RoutePlannerModule::addRoute(QList<PosPoint> route)
 {
-    mRoutes.append(route);
-    emit requestRepaint();
+    mRouteDocument.insertRoute(mRouteDocument.getNumberOfRoutes(), PosPoint::toPODList(route));
 }
 
 void RoutePlannerModule::appendRouteToCurrentRoute(QList<PosPoint> route)
 {
-    mRoutes[mPlannerState.currentRouteIndex].append(route);
-    emit requestRepaint();
+    mRouteDocument.appendPoints(mPlannerState.currentRouteIndex, PosPoint::toPODList(route));
+}
+
+void RoutePlannerModule::addRoute(const QVector<pospoint_t> &route)
+{
+    mRouteDocument.insertRoute(mRouteDocument.getNumberOfRoutes(), route);
+}
+
+void RoutePlannerModule::appendRouteToCurrentRoute(const QVector<pospoint_t> &route)
+{
+    mRouteDocument.appendPoints(mPlannerState.currentRouteIndex, route);
+}
+
+void RoutePlannerModule::setRoutesPOD(const QList<QVector<pospoint_t>> &routes)
+{
+    // There is always a route to edit
+    mRouteDocument.setRoutes(routes.isEmpty() ? QList<QVector<pospoint_t>>({QVector<pospoint_t>()}) : routes);
 }
 
 bool RoutePlannerModule::removeCurrentRoute()
 {
-    if (mRoutes.size() == 1)
+    if (mRouteDocument.getNumberOfRoutes() == 1)
         return false;
 
     removeRoute(mPlannerState.currentRouteIndex);
@@ -192,16 +381,12 @@ bool RoutePlannerModule::removeCurrentRoute()
 
 void RoutePlannerModule::clearCurrentRoute()
 {
-    mRoutes[mPlannerState.currentRouteIndex].clear();
-    emit requestRepaint();
+    mRouteDocument.clearRoute(mPlannerState.currentRouteIndex);
 }
 
 void RoutePlannerModule::removeRoute(int index)
 {
-    mRoutes.removeAt(index);
-
-    if (mPlannerState.currentRouteIndex == mRoutes.size())
-        mPlannerState.currentRouteIndex--;
+    mRouteDocument.removeRoute(index); // the current route index is updated in routeRemoved()
 }
 
 void RoutePlannerModule::setNewPointHeight(double height)
@@ -229,12 +414,13 @@ void RoutePlannerModule::setUpdatePointOnClick(bool update)
     mPlannerState.updatePointOnClick = update;
 }
 
-int RoutePlannerModule::getClosestPoint(PosPoint p, QList<PosPoint> points, double &dist)
+int RoutePlannerModule::getClosestPoint(const PosPoint &p, const QVector<pospoint_t> &points, double &dist)
 {
     int closest = -1;
     dist = -1.0;
+    const pospoint_t pPOD = p.toPOD();
     for (int i = 0;i < points.size();i++) {
-        double d = points[i].getDistanceTo(p);
+        double d = points[i].getDistanceTo(pPOD);
         if (dist < 0.0 || d < dist) {
             dist = d;
             closest = i;
@@ -250,7 +436,8 @@ void RoutePlannerModule::drawCircleFast(QPainter &painter, QPointF center, doubl
                        2.0 * radius, 2.0 * radius, mPixmaps.at(type));
 }
 
-void RoutePlannerModule::drawRoute(QPainter& painter, QTransform drawTrans, QTransform txtTrans, bool highQuality, double scaleFactor, const QList<PosPoint> &route, int routeID, bool isSelected, bool drawAnnotations)
+void RoutePlannerModule::drawRoute(QPainter& painter, QTransform drawTrans, QTransform txtTrans, bool highQuality, double scaleFactor, const QVector<pospoint_t> &route,
+                                   RouteRenderCache &cache, const QRectF &view_mm, int routeID, bool isSelected, bool drawAnnotations)
 {
 
     Qt::GlobalColor defaultDarkColor = Qt::darkGray;
@@ -264,121 +451,134 @@ void RoutePlannerModule::drawRoute(QPainter& painter, QTransform drawTrans, QTra
     pen.setWidthF(5.0 / scaleFactor);
     painter.setTransform(drawTrans);
 
-    for (int i = 1;i < route.size();i++) {
-        pen.setColor(defaultDarkColor);
-        painter.setBrush(defaultColor);
-        painter.setPen(pen);
+    // Margins for markers, highlights and labels
+    const double markerMargin_mm = 20.0 / scaleFactor;
+    const QRectF markerView_mm = view_mm.adjusted(-markerMargin_mm, -markerMargin_mm, markerMargin_mm, markerMargin_mm);
+    const double labelMargin_mm = 520.0 / scaleFactor;
+    const QRectF labelView_mm = view_mm.adjusted(-labelMargin_mm, -labelMargin_mm, labelMargin_mm, labelMargin_mm);
+    // Bounds can have zero width or height, QRectF::intersects does not handle that
+    auto isInView = [](const QRectF &bounds, const QRectF &view) {
+        return bounds.right() >= view.left() && bounds.left() <= view.right() && bounds.bottom() >= view.top() && bounds.top() <= view.bottom();
+    };
+
+    QVector<const RouteChunk*> visibleChunks;
+    for (const auto &chunk : cache.chunks)
+        if (isInView(chunk.bounds_mm, markerView_mm))
+            visibleChunks.append(&chunk);
+
+    pen.setColor(defaultDarkColor);
+    painter.setBrush(defaultColor);
+    painter.setPen(pen);
+    painter.setOpacity(0.7);
+    for (const RouteChunk *chunk : visibleChunks)
+        painter.drawPolyline(chunk->points_mm.constData(), chunk->points_mm.size());
+    painter.setOpacity(1.0);
+
+    for (const RouteChunk *chunk : visibleChunks) {
+        const double meanSpacing_px = chunk->meanSpacing_mm * scaleFactor;
+        const int firstPoint = chunk->firstIndex == 0 ? 0 : 1; // skip overlap with previous chunk
 
-        painter.setOpacity(0.7);
-        painter.drawLine(route.at(i-1).getX() * 1000.0, route.at(i-1).getY() * 1000.0,
-                         route.at(i).getX() * 1000.0, route.at(i).getY() * 1000.0);
-        painter.setOpacity(1.0);
-    }
+        painter.setTransform(drawTrans);
+        if (meanSpacing_px < MARKER_MIN_SPACING_px) {
+            // Markers would overlap, draw the points in one batch
+            QPen pointPen(defaultDarkColor);
+            pointPen.setWidthF(MARKER_MIN_SPACING_px / 2.0 / scaleFactor);
+            pointPen.setCapStyle(Qt::RoundCap);
+            painter.setPen(pointPen);
+            painter.drawPoints(chunk->points_mm.constData() + firstPoint, chunk->points_mm.size() - firstPoint);
+        }
 
-    for (int i = 0;i < route.size();i++) {
-        QString pointLabel;
-        QPointF pointLabelPos;
-        QRectF pointLabelRectangle;
-        QPointF p = route[i].getPointMm();
+        for (int j = firstPoint; j < chunk->points_mm.size(); j++) {
+            const int i = chunk->firstIndex + j;
+            const QPointF &p = chunk->points_mm.at(j);
+            const bool isHighlighted = isSelected && (i == 0 || i == route.size()-1);
+            const bool drawMarker = meanSpacing_px >= MARKER_MIN_SPACING_px;
+            const bool drawLabel = isSelected && drawAnnotations ? meanSpacing_px >= ANNOTATION_MIN_SPACING_px : meanSpacing_px >= LABEL_MIN_SPACING_px;
+            if (!(drawMarker || isHighlighted || drawLabel) || !isInView(QRectF(p, p), drawLabel ? labelView_mm : markerView_mm))
+                continue;
+
+            painter.setTransform(drawTrans);
+
+            if (drawMarker) {
+                if (highQuality) {
+                    if (isSelected) {
+                        pen.setColor(Qt::darkYellow);
+                        painter.setBrush(Qt::yellow);
+                    } else {
+                        pen.setColor(Qt::darkGray);
+                        painter.setBrush(Qt::gray);
+                    }
 
-        painter.setTransform(drawTrans);
+                    pen.setWidthF(3.0 / scaleFactor);
+                    painter.setPen(pen);
 
-        if (highQuality) {
-            if (isSelected) {
-                pen.setColor(Qt::darkYellow);
-                painter.setBrush(Qt::yellow);
-            } else {
-                pen.setColor(Qt::darkGray);
-                painter.setBrush(Qt::gray);
+                    painter.drawEllipse(p, 10.0 / scaleFactor,
+                                        10.0 / scaleFactor);
+                } else {
+                    drawCircleFast(painter, p, 10.0 / scaleFactor, isSelected ? 0 : 1); // TODO generalize / refactor (by color?)
+                }
             }
 
-            pen.setWidthF(3.0 / scaleFactor);
-            painter.setPen(pen);
-
-            painter.drawEllipse(p, 10.0 / scaleFactor,
-                                10.0 / scaleFactor);
-        } else {
-            drawCircleFast(painter, p, 10.0 / scaleFactor, isSelected ? 0 : 1); // TODO generalize / refactor (by color?)
-        }
+            // Draw highlight for first and last point in active route
+            if (isHighlighted) {
+                QPointF ptmp;
+                ptmp.setX(p.x() - 7.0 / scaleFactor);
+                ptmp.setY(p.y() + 7.0 / scaleFactor);
+                if (i == 0) {
+                    pen.setColor(Qt::green);
+                    painter.setBrush(Qt::darkGreen);
+                } else {
+                    pen.setColor(Qt::red);
+                    painter.setBrush(Qt::darkRed);
+                }
+                pen.setWidthF(2.0 / scaleFactor);
+                painter.setPen(pen);
+                painter.drawEllipse(ptmp, 5.0 / scaleFactor,
+                                    5.0 / scaleFactor);
+            }
 
-        // Draw highlight for first and last point in active route
-        if (isSelected && (i == 0 || i == route.size()-1)) {
-            QPointF ptmp;
-            ptmp.setX(p.x() - 7.0 / scaleFactor);
-            ptmp.setY(p.y() + 7.0 / scaleFactor);
-            if (i == 0) {
-                pen.setColor(Qt::green);
-                painter.setBrush(Qt::darkGreen);
+            if (!drawLabel)
+                continue;
+
+            // Draw text only for selected route
+            QPointF pointLabelPos;
+            QRectF pointLabelRectangle;
+            if (isSelected && drawAnnotations) {
+                pointLabelPos.setX(p.x() + 10 / scaleFactor);
+                pointLabelPos.setY(p.y());
+                painter.setTransform(txtTrans);
+                pointLabelPos = drawTrans.map(pointLabelPos);
+                pen.setColor(Qt::black);
+                painter.setPen(pen);
+                pointLabelRectangle.setCoords(pointLabelPos.x(), pointLabelPos.y() - 20,
+                                              pointLabelPos.x() + 500, pointLabelPos.y() + 100);
+                painter.drawText(pointLabelRectangle, getAnnotation(cache, route, i));
             } else {
-                pen.setColor(Qt::red);
-                painter.setBrush(Qt::darkRed);
+                pointLabelPos.setX(p.x());
+                pointLabelPos.setY(p.y());
+                painter.setTransform(txtTrans);
+                pointLabelPos = drawTrans.map(pointLabelPos);
+                pen.setColor(Qt::black);
+                painter.setPen(pen);
+                pointLabelRectangle.setCoords(pointLabelPos.x() - 20, pointLabelPos.y() - 20,
+                                              pointLabelPos.x() + 20, pointLabelPos.y() + 20);
+                painter.drawText(pointLabelRectangle, Qt::AlignCenter, QString::number(routeID));
             }
-            pen.setWidthF(2.0 / scaleFactor);
-            painter.setPen(pen);
-            painter.drawEllipse(ptmp, 5.0 / scaleFactor,
-                                5.0 / scaleFactor);
-        }
-
-        // Draw text only for selected route
-        pointLabel = "";
-        QTextStream pointLabelStream(&pointLabel);
-        pointLabelStream.setRealNumberPrecision(2);
-        if (isSelected && drawAnnotations) {
-            //QTime t = route[i].getTime();
-            pointLabelStream << "P: " << i << ((i == 0) ? "- start" : ((i == route.size()-1) ? "- end" : "")) << Qt::endl
-                             << "(" << route[i].getX() <<  ", " << route[i].getY() << ", " << route[i].getHeight() << ")" << Qt::endl;
-            pointLabelStream.setRealNumberPrecision(1);
-            pointLabelStream << route[i].getSpeed() * 3.6 << " km/h" << Qt::endl
-                             << "A: " << QString("%1").arg(route[i].getAttributes(), 8, 16, QLatin1Char('0'));
-
-            pointLabelPos.setX(p.x() + 10 / scaleFactor);
-            pointLabelPos.setY(p.y());
-            painter.setTransform(txtTrans);
-            pointLabelPos = drawTrans.map(pointLabelPos);
-            pen.setColor(Qt::black);
-            painter.setPen(pen);
-            pointLabelRectangle.setCoords(pointLabelPos.x(), pointLabelPos.y() - 20,
-                                          pointLabelPos.x() + 500, pointLabelPos.y() + 100);
-            painter.drawText(pointLabelRectangle, pointLabel);
-        } else {
-            pointLabelStream << routeID;
-            pointLabelPos.setX(p.x());
-            pointLabelPos.setY(p.y());
-            painter.setTransform(txtTrans);
-            pointLabelPos = drawTrans.map(pointLabelPos);
-            pen.setColor(Qt::black);
-            painter.setPen(pen);
-            pointLabelRectangle.setCoords(pointLabelPos.x() - 20, pointLabelPos.y() - 20,
-                                          pointLabelPos.x() + 20, pointLabelPos.y() + 20);
-            painter.drawText(pointLabelRectangle, Qt::AlignCenter, pointLabel);
         }
     }
 }
 
 void RoutePlannerModule::reverseCurrentRoute()
 {
-    int size = mRoutes[mPlannerState.currentRouteIndex].size(); // for readability
-
-    for(int i = 0; i < size/2; i++)
-        mRoutes[mPlannerState.currentRouteIndex].swapItemsAt(i, size - (1+i));  // reverses QList
-
-    emit requestRepaint();
+    mRouteDocument.reverseRoute(mPlannerState.currentRouteIndex);
 }
 
 void RoutePlannerModule::appendCurrentRouteTo(int routeIndex)
 {
-    mRoutes[routeIndex].append(getCurrentRoute());
-
-    removeRoute(mPlannerState.currentRouteIndex);
-
-    emit requestRepaint();
+    mRouteDocument.appendRouteTo(mPlannerState.currentRouteIndex, routeIndex);
 }
 
 void RoutePlannerModule::splitCurrentRouteAt(int pointIndex)
 {
-    QList<PosPoint> newRoute = mRoutes[mPlannerState.currentRouteIndex].mid(pointIndex);
-
-    mRoutes[mPlannerState.currentRouteIndex] = mRoutes[mPlannerState.currentRouteIndex].mid(0, pointIndex);
-
-    addRoute(newRoute);
+    mRouteDocument.splitRouteAt(mPlannerState.currentRouteIndex, pointIndex);
 }
@@ -3,12 +3,20 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * MapModule that allows creating and interacting with routes on the map
+ * Routes are edited in a RouteDocument (in place, undoable). They are drawn from a render cache of chunks with bounding
+ * boxes, of which only the chunks with changed points are rebuilt: chunks outside of the view are skipped, segments are
+ * drawn as one polyline per chunk. Point markers and labels are only drawn when the points are
+ * far enough apart on screen, otherwise the points are drawn in one batch.
  */
 
 #ifndef ROUTEPLANNERMODULE_H
 #define ROUTEPLANNERMODULE_H
 
 #include "userinterface/map/mapwidget.h"
+#include "userinterface/map/routedocument.h"
+#include "core/routegeometry.h"
+#include <QSet>
+#include <limits>
 
 class RoutePlannerModule : public MapModule
 {
@@ -18,15 +26,24 @@ public:
     // MapModule interface
     virtual void processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale) override;
     virtual bool processMouse(bool isPress, bool isRelease, bool isMove, bool isWheel, QPoint widgetPos, PosPoint mapPos, double wheelAngleDelta, Qt::KeyboardModifiers keyboardModifiers, Qt::MouseButtons mouseButtons, double scale) override;
+    virtual void reprojectEnu(const coordinateTransforms::EnuTransform &transform) override { mRouteDocument.reprojectEnu(transform); }
+    virtual void enuReprojected() override { routesReset(); }
     void setCurrentRouteIndex(int index);
     int getCurrentRouteIndex();
     void setDrawRouteText(bool draw);
     QList<PosPoint> getCurrentRoute();
     QList<PosPoint> getRoute(int index);
+    int getRouteSize(int index) const { return mRouteDocument.getRoute(index).size(); }
     int getNumberOfRoutes();
     void addNewRoute();
     void addRoute(QList<PosPoint> route);
     void appendRouteToCurrentRoute(QList<PosPoint> route);
+    // Routes as stored, without conversion (e.g., for routeCodec)
+    QVector<pospoint_t> getRoutePOD(int index) const { return mRouteDocument.getRoute(index); }
+    QList<QVector<pospoint_t>> getRoutesPOD() const { return mRouteDocument.getRoutes(); }
+    void setRoutesPOD(const QList<QVector<pospoint_t>> &routes); // replaces all routes, clears the undo stack
+    void addRoute(const QVector<pospoint_t> &route);
+    void appendRouteToCurrentRoute(const QVector<pospoint_t> &route);
     bool removeCurrentRoute();
     void clearCurrentRoute();
     void removeRoute(int index);
@@ -38,6 +55,16 @@ public:
     void reverseCurrentRoute();
     void appendCurrentRouteTo(int routeIndex);
     void splitCurrentRouteAt(int pointIndex);
+    QUndoStack *getUndoStack() { return mRouteDocument.getUndoStack(); }
+
+    static constexpr int ROUTE_CHUNK_POINTS = 128;
+    static constexpr double MARKER_MIN_SPACING_px = 8.0;
+    static constexpr double LABEL_MIN_SPACING_px = 40.0;
+    static constexpr double ANNOTATION_MIN_SPACING_px = 100.0;
+    static constexpr double CLICK_RADIUS_px = 20.0;
+
+protected:
+    void hitIndexChanged() override;
 
 private:
     typedef enum {
@@ -55,15 +82,44 @@ private:
         double newPointSpeed = 0.5; // [m/s]
         QTime newPointTime;
         uint32_t newPointAttribute = 0;
-
+        int dragId = 0; // edits of a dragged point are undone at once
     } mPlannerState;
 
-    void drawRoute(QPainter &painter, QTransform drawTrans, QTransform txtTrans, bool highQuality, double scaleFactor, const QList<PosPoint> &route, int routeID, bool isSelected, bool drawAnnotations);
+    struct RouteChunk {
+        QVector<QPointF> points_mm; // starts with the last point of the previous chunk
+        int firstIndex; // in route of points_mm[0]
+        QRectF bounds_mm;
+        double meanSpacing_mm;
+    };
+
+    struct RouteRenderCache {
+        QVector<RouteChunk> chunks;
+        QVector<QString> annotations; // label layout of the selected route, built on demand
+        RouteGeometry geometry;
+        // Points dirtyFrom to dirtyTo changed since the last update
+        int dirtyFrom = 0;
+        int dirtyTo = std::numeric_limits<int>::max();
+        bool isValid() const { return dirtyFrom > dirtyTo; }
+    };
+
+    void routesReset();
+    void routeInserted(int index);
+    void routeRemoved(int index);
+    void pointsChanged(int routeIndex, int firstIndex, int lastIndex, bool sizeChanged);
+    void updateRouteCache(int routeIndex);
+    static RouteChunk buildRouteChunk(const QVector<pospoint_t> &route, int start);
+    void updateHitIndex();
+    const QString &getAnnotation(RouteRenderCache &cache, const QVector<pospoint_t> &route, int index);
+    void drawRoute(QPainter &painter, QTransform drawTrans, QTransform txtTrans, bool highQuality, double scaleFactor, const QVector<pospoint_t> &route,
+                   RouteRenderCache &cache, const QRectF &view_mm, int routeID, bool isSelected, bool drawAnnotations);
     void drawCircleFast(QPainter &painter, QPointF center, double radius, int type);
 
     QList<QPixmap> mPixmaps;
-    QList<QList<PosPoint>> mRoutes;
-    int getClosestPoint(PosPoint p, QList<PosPoint> points, double &dist);
+    RouteDocument mRouteDocument;
+    QVector<RouteRenderCache> mRouteCaches;
+    bool mHitIndexValid = false; // routes registered in mHitIndex with their index as id
+    QSet<int> mHitIndexChangedRoutes; // to be registered again
+    int getClosestPoint(const PosPoint &p, const QVector<pospoint_t> &points, double &dist);
 };
 
 #endif // ROUTEPLANNERMODULE_H
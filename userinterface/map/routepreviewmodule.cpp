@@ -0,0 +1,159 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "routepreviewmodule.h"
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+RoutePreviewModule::RoutePreviewModule()
+{
+    mThreadContext = new QObject();
+    mThread.setObjectName("Route preview");
+    mThreadContext->moveToThread(&mThread);
+    mThread.start();
+}
+
+RoutePreviewModule::~RoutePreviewModule()
+{
+    mCancel = true;
+    mThread.quit();
+    mThread.wait();
+    delete mThreadContext;
+}
+
+void RoutePreviewModule::startPreview(const SimulationScenario &scenario)
+{
+    SimulationScenario previewScenario = scenario;
+    if (previewScenario.traceSpacing_m <= 0.0)
+        previewScenario.traceSpacing_m = DEFAULT_TRACE_SPACING_m;
+
+    if (mRunning) {
+        mHasPendingScenario = true;
+        mPendingScenario = previewScenario;
+        mCancel = true;
+        return;
+    }
+    run(previewScenario);
+}
+
+void RoutePreviewModule::run(const SimulationScenario &scenario)
+{
+    mRunning = true;
+    mCancel = false;
+    QMetaObject::invokeMethod(mThreadContext, [this, scenario]() {
+        const SimulationResult result = SimulationRunner::runScenario(scenario, DEFAULT_STEP_ms, &mCancel);
+        QMetaObject::invokeMethod(this, [this, result]() {
+            mRunning = false;
+            if (mHasPendingScenario) { // result of a canceled preview
+                mHasPendingScenario = false;
+                run(mPendingScenario);
+                return;
+            }
+
+            mResult = result;
+            mTrace_mm.clear();
+            mTrace_mm.reserve(mResult.trace.size());
+            for (const SimulationTracePoint &tracePoint : mResult.trace)
+                mTrace_mm.append(QPointF(tracePoint.x * 1000.0, tracePoint.y * 1000.0));
+            updateViolations();
+            emit requestRepaint();
+            emit previewFinished(mResult);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void RoutePreviewModule::clear()
+{
+    if (mRunning) {
+        mHasPendingScenario = false;
+        mCancel = true;
+    }
+    mResult = SimulationResult();
+    mTrace_mm.clear();
+    mViolations.clear();
+    emit requestRepaint();
+}
+
+void RoutePreviewModule::setMaxDeviation(double maxDeviation_m)
+{
+    mMaxDeviation_m = maxDeviation_m;
+    updateViolations();
+    emit requestRepaint();
+}
+
+void RoutePreviewModule::setMaxLateralAcceleration(double maxLateralAcceleration_ms2)
+{
+    mMaxLateralAcceleration_ms2 = maxLateralAcceleration_ms2;
+    updateViolations();
+    emit requestRepaint();
+}
+
+void RoutePreviewModule::updateViolations()
+{
+    mViolations.clear();
+    for (int i = 0; i < mResult.trace.size(); i++) {
+        const SimulationTracePoint &tracePoint = mResult.trace.at(i);
+        if (tracePoint.crossTrackError_m <= mMaxDeviation_m && fabs(tracePoint.lateralAcceleration_ms2) <= mMaxLateralAcceleration_ms2)
+            continue;
+
+        if (!mViolations.isEmpty() && mViolations.last().first + mViolations.last().second == i)
+            mViolations.last().second++;
+        else
+            mViolations.append({i, 1});
+    }
+}
+
+QColor RoutePreviewModule::getDeviationColor(double deviation_m) const
+{
+    // Green to red in steps, i.e., runs of similar deviation are drawn as one polyline (as TraceModule)
+    const int step = std::min(int(deviation_m / mMaxDeviation_m * DEVIATION_COLORS), DEVIATION_COLORS - 1);
+    return QColor::fromHsvF((1.0 - double(step) / (DEVIATION_COLORS - 1)) / 3.0, 1.0, 0.9);
+}
+
+void RoutePreviewModule::processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale)
+{
+    Q_UNUSED(width) Q_UNUSED(height) Q_UNUSED(highQuality) Q_UNUSED(txtTrans)
+
+    if (mTrace_mm.size() < 2)
+        return;
+
+    painter.setTransform(drawTrans);
+    QPen pen;
+    pen.setWidthF(5.0/scale);
+
+    // A segment is coloured by the deviation at its end point
+    QVector<QPointF> run = {mTrace_mm.first()};
+    QColor runColor = getDeviationColor(mResult.trace.at(1).crossTrackError_m);
+    for (int i = 1; i < mTrace_mm.size(); i++) {
+        const QColor color = getDeviationColor(mResult.trace.at(i).crossTrackError_m);
+        if (color != runColor) {
+            pen.setColor(runColor);
+            painter.setPen(pen);
+            painter.drawPolyline(run.constData(), run.size());
+            run = {mTrace_mm.at(i - 1)};
+            runColor = color;
+        }
+        run.append(mTrace_mm.at(i));
+    }
+    pen.setColor(runColor);
+    painter.setPen(pen);
+    painter.drawPolyline(run.constData(), run.size());
+
+    // Violations: circle around each run
+    pen.setColor(Qt::red);
+    pen.setWidthF(3.0/scale);
+    painter.setPen(pen);
+    painter.setBrush(Qt::NoBrush);
+    const double radius_mm = 20.0/scale;
+    for (const auto &violation : mViolations) {
+        QPointF min = mTrace_mm.at(violation.first), max = min;
+        for (int i = violation.first; i < violation.first + violation.second; i++) {
+            min = QPointF(std::min(min.x(), mTrace_mm.at(i).x()), std::min(min.y(), mTrace_mm.at(i).y()));
+            max = QPointF(std::max(max.x(), mTrace_mm.at(i).x()), std::max(max.y(), mTrace_mm.at(i).y()));
+        }
+        const double r = std::max(radius_mm, 0.5 * std::hypot(max.x() - min.x(), max.y() - min.y()) + radius_mm / 2.0);
+        painter.drawEllipse((min + max) / 2.0, r, r);
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Preview of a route before it is sent to a vehicle: the vehicle model follows the route in simulation
+ * (SimulationRunner::runScenario on a SimulatedClock, i.e., as fast as possible) on a worker thread.
+ * The predicted path is drawn coloured by its deviation from the route (green to red at maxDeviation),
+ * places beyond maxDeviation or maxLateralAcceleration are marked. Signals are emitted in the thread the module lives in.
+ */
+
+#ifndef ROUTEPREVIEWMODULE_H
+#define ROUTEPREVIEWMODULE_H
+
+#include "userinterface/map/mapwidget.h"
+#include "autopilot/simulationrunner.h"
+#include <QThread>
+#include <QVector>
+#include <atomic>
+
+class RoutePreviewModule : public MapModule
+{
+    Q_OBJECT
+public:
+    static constexpr double DEFAULT_TRACE_SPACING_m = 0.2;
+    static constexpr int DEFAULT_STEP_ms = 10;
+    static constexpr int DEVIATION_COLORS = 8;
+
+    RoutePreviewModule();
+    ~RoutePreviewModule();
+
+    // MapModule interface
+    virtual void processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale) override;
+
+    // A running preview is canceled and replaced, traceSpacing_m is set if the scenario has none
+    void startPreview(const SimulationScenario &scenario);
+    void clear();
+    bool isRunning() const { return mRunning; }
+    const SimulationResult &getResult() const { return mResult; }
+
+    double getMaxDeviation() const { return mMaxDeviation_m; }
+    void setMaxDeviation(double maxDeviation_m);
+    double getMaxLateralAcceleration() const { return mMaxLateralAcceleration_ms2; }
+    void setMaxLateralAcceleration(double maxLateralAcceleration_ms2);
+    // Runs of trace points beyond maxDeviation or maxLateralAcceleration, as index of the first point and count
+    QVector<QPair<int, int>> getViolations() const { return mViolations; }
+
+signals:
+    void previewFinished(const SimulationResult &result);
+
+private:
+    void run(const SimulationScenario &scenario);
+    void updateViolations();
+    QColor getDeviationColor(double deviation_m) const;
+
+    QThread mThread;
+    QObject *mThreadContext;
+    bool mRunning = false; // owner thread only
+    bool mHasPendingScenario = false;
+    SimulationScenario mPendingScenario;
+    std::atomic<bool> mCancel {false};
+
+    SimulationResult mResult;
+    QVector<QPointF> mTrace_mm;
+    QVector<QPair<int, int>> mViolations;
+    double mMaxDeviation_m = 0.5;
+    double mMaxLateralAcceleration_ms2 = 2.0;
+};
+
+#endif // ROUTEPREVIEWMODULE_H
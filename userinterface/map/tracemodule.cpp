@@ -3,6 +3,150 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "tracemodule.h"
+#include "core/routeprojection.h"
+#include "core/enureprojector.h"
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Trace session file: "WTS" | version (2, 1 is read) | zlib compressed (qCompress) body
+// Body: trace count (varint) | (vehicle ID (zigzag varint) | PosType (varint) | trace index (varint) | point count (varint) |
+//       timestamps [us] | x [mm] | y [mm] | GnssFixType | accuracy [mm])...
+// Columns are zigzag varint deltas to the previous point of the trace, invalid timestamps and unknown accuracies are stored as -1.
+// Version 1 has no fix type and accuracy columns.
+
+// Trace snapshot (native byte order): trace count (int32) | (vehicle ID | PosType | trace index | chunk count (int32 each) |
+//       (point count (int32) | bounds [mm] (left, top, width, height, double each) | points [mm] (QPointF) | timestamps [ns] (int64) |
+//       cross-track errors [m] (float) | accuracies [m] (float) | GnssFixType (uint8))...)...
+// Chunks are stored as in memory (including the point shared with the previous chunk), spilled ones are read back from the spill file.
+
+namespace {
+constexpr char TRACE_SESSION_MAGIC[] = {'W', 'T', 'S'};
+constexpr uint8_t TRACE_SESSION_VERSION = 2;
+constexpr uint8_t TRACE_SESSION_VERSION_WITHOUT_QUALITY = 1;
+constexpr const char *POS_TYPE_NAMES[] = {"simulated", "fused", "odom", "IMU", "GNSS", "UWB"};
+static_assert(sizeof(POS_TYPE_NAMES) / sizeof(POS_TYPE_NAMES[0]) == (int)PosType::_LAST_, "POS_TYPE_NAMES must match PosType");
+constexpr const char *FIX_TYPE_NAMES[] = {"unknown", "no_fix", "dead_reckoning", "2d", "3d", "rtk_float", "rtk_fixed"};
+static_assert(sizeof(FIX_TYPE_NAMES) / sizeof(FIX_TYPE_NAMES[0]) == (int)GnssFixType::_LAST_, "FIX_TYPE_NAMES must match GnssFixType");
+
+GnssFixType getFixType(const pospoint_t &position)
+{
+    return (position.type == PosType::GNSS && position.attributes < quint32(GnssFixType::_LAST_)) ? GnssFixType(position.attributes) : GnssFixType::Unknown;
+}
+
+float getAccuracy(const pospoint_t &position)
+{
+    return (position.sigma > 0.0) ? float(position.sigma) : std::numeric_limits<float>::quiet_NaN();
+}
+
+void writeVarint(QByteArray &data, quint64 value)
+{
+    while (value >= 0x80) {
+        data.append(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    data.append(char(value));
+}
+
+void writeSignedVarint(QByteArray &data, qint64 value)
+{
+    writeVarint(data, (quint64(value) << 1) ^ quint64(value >> 63));
+}
+
+bool readVarint(const uchar *&data, const uchar *end, quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7) {
+        const uchar byte = *data++;
+        value |= quint64(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool readSignedVarint(const uchar *&data, const uchar *end, qint64 &value)
+{
+    quint64 zigzag;
+    if (!readVarint(data, end, zigzag))
+        return false;
+    value = qint64(zigzag >> 1) ^ -qint64(zigzag & 1);
+    return true;
+}
+
+template<typename T>
+void appendRaw(QByteArray &data, const T *values, int count)
+{
+    data.append(reinterpret_cast<const char*>(values), count * int(sizeof(T)));
+}
+
+template<typename T>
+bool readRaw(const char *&data, const char *end, T *values, int count)
+{
+    const qint64 size = qint64(count) * qint64(sizeof(T));
+    if (count < 0 || end - data < size)
+        return false;
+    memcpy(static_cast<void*>(values), data, size);
+    data += size;
+    return true;
+}
+
+qint64 timestampToSession(qint64 timestamp_ns)
+{
+    return (timestamp_ns == utcTime::INVALID) ? -1 : timestamp_ns / 1000;
+}
+
+qint64 timestampFromSession(qint64 timestamp_us)
+{
+    return (timestamp_us < 0) ? utcTime::INVALID : timestamp_us * 1000;
+}
+
+// Douglas-Peucker, keeps points that deviate more than tolerance from the simplified line
+QVector<QPointF> simplifyPolyline(const QVector<QPointF> &points, double tolerance)
+{
+    if (points.size() < 3)
+        return points;
+
+    QVector<bool> keep(points.size(), false);
+    keep.first() = true;
+    keep.last() = true;
+    QVector<QPair<int, int>> ranges = {{0, points.size() - 1}};
+    while (!ranges.isEmpty()) {
+        const QPair<int, int> range = ranges.takeLast();
+        const QPointF &start = points.at(range.first);
+        const QPointF segment = points.at(range.second) - start;
+        const double segmentLengthSquared = QPointF::dotProduct(segment, segment);
+
+        double maxDistance = 0.0;
+        int maxIndex = -1;
+        for (int i = range.first + 1; i < range.second; i++) {
+            const QPointF offset = points.at(i) - start;
+            const double t = segmentLengthSquared > 0.0 ? std::max(0.0, std::min(1.0, QPointF::dotProduct(offset, segment) / segmentLengthSquared)) : 0.0;
+            const QPointF deviation = offset - t * segment;
+            const double distance = std::hypot(deviation.x(), deviation.y());
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                maxIndex = i;
+            }
+        }
+
+        if (maxDistance > tolerance) {
+            keep[maxIndex] = true;
+            ranges.append({range.first, maxIndex});
+            ranges.append({maxIndex, range.second});
+        }
+    }
+
+    QVector<QPointF> simplified;
+    for (int i = 0; i < points.size(); i++)
+        if (keep.at(i))
+            simplified.append(points.at(i));
+    return simplified;
+}
+}
 
 TraceModule::TraceModule()
 {
@@ -14,84 +158,444 @@ TraceModule::TraceModule()
     setTraceColorForPosType(PosType::GNSS, Qt::magenta);
     setTraceActiveForPosType(PosType::fused, true);
     setTraceColorForPosType(PosType::fused, Qt::red);
+}
+
+void TraceModule::sampleTrace(ObjectState::ObjectID_t vehicleId, const pospoint_t &position)
+{
+    const int posTypeInt = (int)position.type;
+    auto vehicleTraces = mVehicleTraces.find(vehicleId);
+    if (!mTraceModuleState.tracing || mTraceModuleState.currentTraceIndex < 0 || vehicleTraces == mVehicleTraces.end() || !vehicleTraces->vehicle ||
+            posTypeInt < 0 || posTypeInt >= (int)PosType::_LAST_ || !mTraceModuleState.traceActiveForPosType[posTypeInt])
+        return;
+
+    QList<Trace> &traceList = vehicleTraces->traceListPerPosType[posTypeInt];
+    while (mTraceModuleState.currentTraceIndex >= traceList.size())
+        traceList.append(Trace());
 
-    connect(&mTraceSampleTimer, &QTimer::timeout, [this](){
-        if (mTraceModuleState.currentTraceIndex < 0)
+    Trace &trace = traceList[mTraceModuleState.currentTraceIndex];
+    const TraceDecimation &decimation = mTraceModuleState.traceDecimationForPosType[posTypeInt];
+    const PosPoint point(position);
+    const QPointF point_mm = point.getPointMm();
+    if (!trace.isEmpty()) {
+        if (QLineF(trace.last_mm(), point_mm).length() <= decimation.minDistance_m * 1000.0)
             return;
+        if (decimation.minInterval_ms > 0 && position.timestamp_ns != utcTime::INVALID && trace.lastTimestamp_ns != utcTime::INVALID &&
+                position.timestamp_ns - trace.lastTimestamp_ns < qint64(decimation.minInterval_ms) * 1000000)
+            return;
+    }
 
-        for (int currentPosTypeInt = 0; currentPosTypeInt < (int)PosType::_LAST_; currentPosTypeInt++) {
-            if (mTraceModuleState.traceActiveForPosType[currentPosTypeInt]) {
-                while (mTraceModuleState.currentTraceIndex >= mTraceListPerPosType[currentPosTypeInt].size())
-                    mTraceListPerPosType[currentPosTypeInt].append(QList<PosPoint>());
+    const GnssFixType fixType = getFixType(position);
+    const float accuracy_m = getAccuracy(position);
+    if (trace.append(point_mm, getCrossTrackError(trace, point), position.timestamp_ns, fixType, accuracy_m)) {
+        mInMemoryChunks.append({vehicleId, posTypeInt, mTraceModuleState.currentTraceIndex, trace.chunks.size() - 2});
+        enforceTraceMemoryLimit();
+    }
+    trace.lastTimestamp_ns = position.timestamp_ns;
+    if (position.type == mQualityHeatmapPosType)
+        mQualityGrid.addSample(point_mm, fixType, accuracy_m);
 
+    // Traces are painted in MapWidget's cached module layer, which coalesces repaints
+    emit requestRepaint();
+}
 
-                if (mTraceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex].size() == 0
-                    || QLineF(mTraceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex].last().getPoint(),
-                              mTraceModuleState.currentTraceVehicle->getPosition((PosType)currentPosTypeInt).getPoint()).length() > mTraceModuleState.minTraceSampleDistance)
-                    mTraceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex].
-                            append(mTraceModuleState.currentTraceVehicle->getPosition((PosType)currentPosTypeInt));
-            }
-        }
+void TraceModule::connectTraceVehicle(VehicleTraces &vehicleTraces)
+{
+    if (vehicleTraces.connection || !vehicleTraces.vehicle)
+        return;
+
+    // Queued for updates from other threads, copies of the position are delivered in order
+    const ObjectState::ObjectID_t vehicleId = vehicleTraces.vehicle->getId();
+    vehicleTraces.connection = connect(vehicleTraces.vehicle.get(), &VehicleState::positionOfSourceUpdated, this, [this, vehicleId](const pospoint_t &position) {
+        sampleTrace(vehicleId, position);
     });
 }
 
-
 void TraceModule::processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale)
 {
-    Q_UNUSED(width) Q_UNUSED(height) Q_UNUSED(highQuality) Q_UNUSED(txtTrans)
+    Q_UNUSED(highQuality) Q_UNUSED(txtTrans)
 
     QPen pen;
     pen.setWidthF(7.5/scale);
     painter.setTransform(drawTrans);
 
+    // Visible area incl. line width, simplified to below a pixel per power of two of scale
+    const double margin_mm = pen.widthF();
+    const QRectF view_mm = drawTrans.inverted().mapRect(QRectF(0, 0, width, height)).adjusted(-margin_mm, -margin_mm, margin_mm, margin_mm);
+
+    // Below the traces, of all of them
+    if (mQualityHeatmap != QualityHeatmap::None)
+        mQualityGrid.paint(painter, view_mm);
+
     if (mTraceModuleState.currentTraceIndex < 0)
         return;
 
-    for (int currentPosTypeInt = 0; currentPosTypeInt < (int)PosType::_LAST_; currentPosTypeInt++) {
-        if (mTraceModuleState.traceActiveForPosType[currentPosTypeInt]) {
-            pen.setColor(mTraceModuleState.traceColorForPosType[currentPosTypeInt]);
-            painter.setPen(pen);
-            if (mTraceModuleState.currentTraceIndex < mTraceListPerPosType[currentPosTypeInt].size()) {
-                for (int i = 1; i < mTraceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex].size(); i++) {
-                    painter.drawLine(mTraceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex][i-1].getPointMm(),
-                            mTraceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex][i].getPointMm());
+    const int lodLevel = (int)floor(log2(scale));
+    const double tolerance_mm = SIMPLIFY_TOLERANCE_px / pow(2.0, lodLevel + 1);
+
+    for (VehicleTraces &vehicleTraces : mVehicleTraces) {
+        for (int currentPosTypeInt = 0; currentPosTypeInt < (int)PosType::_LAST_; currentPosTypeInt++) {
+            if (mTraceModuleState.traceActiveForPosType[currentPosTypeInt]) {
+                pen.setColor(mTraceModuleState.traceColorForPosType[currentPosTypeInt]);
+                painter.setPen(pen);
+                if (mTraceModuleState.currentTraceIndex < vehicleTraces.traceListPerPosType[currentPosTypeInt].size()) {
+                    for (auto &chunk : vehicleTraces.traceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex].chunks) {
+                        // Bounds can have zero width or height, QRectF::intersects does not handle that
+                        if (chunk.bounds_mm.right() < view_mm.left() || chunk.bounds_mm.left() > view_mm.right() ||
+                                chunk.bounds_mm.bottom() < view_mm.top() || chunk.bounds_mm.top() > view_mm.bottom()) {
+                            if (chunk.isSpilled() && !chunk.simplifiedPoints_mm.isEmpty()) {
+                                chunk.simplifiedPoints_mm = QVector<QPointF>();
+                                chunk.lodLevel = std::numeric_limits<int>::min();
+                            }
+                            continue;
+                        }
+
+                        if (mColorByCrossTrackError && chunk.crossTrackErrors_m.size() == (chunk.isSpilled() ? chunk.spilledPoints : chunk.points_mm.size())) {
+                            paintByCrossTrackError(painter, pen, chunk.isSpilled() ? loadSpilledPoints(chunk) : chunk.points_mm, chunk.crossTrackErrors_m,
+                                                   mTraceModuleState.traceColorForPosType[currentPosTypeInt]);
+                            pen.setColor(mTraceModuleState.traceColorForPosType[currentPosTypeInt]);
+                            painter.setPen(pen);
+                            continue;
+                        }
+
+                        if (chunk.lodLevel != lodLevel) {
+                            chunk.simplifiedPoints_mm = simplifyPolyline(chunk.isSpilled() ? loadSpilledPoints(chunk) : chunk.points_mm, tolerance_mm);
+                            chunk.lodLevel = lodLevel;
+                        }
+                        painter.drawPolyline(chunk.simplifiedPoints_mm.constData(), chunk.simplifiedPoints_mm.size());
+                    }
                 }
             }
         }
     }
 }
 
+bool TraceModule::Trace::append(const QPointF &point_mm, float crossTrackError_m, qint64 timestamp_ns, GnssFixType fixType, float accuracy_m)
+{
+    const bool chunkCompleted = !chunks.isEmpty() && chunks.last().points_mm.size() >= TRACE_CHUNK_POINTS;
+    if (chunks.isEmpty() || chunkCompleted) {
+        // Chunks overlap in one point to be drawn connected
+        TraceChunk chunk;
+        chunk.points_mm.reserve(TRACE_CHUNK_POINTS);
+        const QPointF first_mm = chunks.isEmpty() ? point_mm : chunks.last().points_mm.last();
+        if (!chunks.isEmpty()) {
+            chunk.points_mm.append(first_mm);
+            chunk.crossTrackErrors_m.append(chunks.last().crossTrackErrors_m.last());
+            chunk.timestamps_ns.append(chunks.last().timestamps_ns.last());
+            chunk.fixTypes.append(chunks.last().fixTypes.last());
+            chunk.accuracies_m.append(chunks.last().accuracies_m.last());
+        }
+        chunk.bounds_mm = QRectF(first_mm, first_mm);
+        chunks.append(chunk);
+    }
+
+    TraceChunk &chunk = chunks.last();
+    chunk.points_mm.append(point_mm);
+    chunk.crossTrackErrors_m.append(crossTrackError_m);
+    chunk.timestamps_ns.append(timestamp_ns);
+    chunk.fixTypes.append(fixType);
+    chunk.accuracies_m.append(accuracy_m);
+    chunk.bounds_mm.setLeft(std::min(chunk.bounds_mm.left(), point_mm.x()));
+    chunk.bounds_mm.setRight(std::max(chunk.bounds_mm.right(), point_mm.x()));
+    chunk.bounds_mm.setTop(std::min(chunk.bounds_mm.top(), point_mm.y()));
+    chunk.bounds_mm.setBottom(std::max(chunk.bounds_mm.bottom(), point_mm.y()));
+    chunk.lodLevel = std::numeric_limits<int>::min();
+    return chunkCompleted;
+}
+
+void TraceModule::enforceTraceMemoryLimit()
+{
+    const int maxInMemoryChunks = std::max<qint64>(1, mTraceMemoryLimit / (TRACE_CHUNK_POINTS * (sizeof(QPointF) + sizeof(qint64))));
+    if (mInMemoryChunks.size() <= maxInMemoryChunks)
+        return;
+
+    if (!mSpillFile.isOpen() && !mSpillFile.open()) {
+        qWarning() << "Could not open trace spill file:" << mSpillFile.errorString();
+        return;
+    }
+
+    while (mInMemoryChunks.size() > maxInMemoryChunks) {
+        const ChunkRef ref = mInMemoryChunks.takeFirst();
+        TraceChunk &chunk = mVehicleTraces[ref.vehicleId].traceListPerPosType[ref.posType][ref.traceIndex].chunks[ref.chunkIndex];
+
+        const qint64 offset = mSpillFile.size();
+        const qint64 size = chunk.points_mm.size() * sizeof(QPointF);
+        const qint64 timestampsSize = chunk.timestamps_ns.size() * sizeof(qint64);
+        if (!mSpillFile.seek(offset) || mSpillFile.write(reinterpret_cast<const char*>(chunk.points_mm.constData()), size) != size ||
+                mSpillFile.write(reinterpret_cast<const char*>(chunk.timestamps_ns.constData()), timestampsSize) != timestampsSize) {
+            qWarning() << "Could not write trace spill file:" << mSpillFile.errorString();
+            mInMemoryChunks.prepend(ref);
+            return;
+        }
+
+        chunk.spillOffset = offset;
+        chunk.spilledPoints = chunk.points_mm.size();
+        chunk.points_mm = QVector<QPointF>();
+        chunk.timestamps_ns = QVector<qint64>();
+        chunk.simplifiedPoints_mm = QVector<QPointF>();
+        chunk.lodLevel = std::numeric_limits<int>::min();
+        mSpilledChunks++;
+    }
+    mSpillFile.flush();
+}
+
+QVector<QPointF> TraceModule::loadSpilledPoints(const TraceChunk &chunk)
+{
+    QVector<QPointF> points;
+    const qint64 size = chunk.spilledPoints * sizeof(QPointF);
+    uchar *data = mSpillFile.map(chunk.spillOffset, size);
+    if (!data) {
+        qWarning() << "Could not map trace spill file:" << mSpillFile.errorString();
+        return points;
+    }
+
+    points.resize(chunk.spilledPoints);
+    memcpy(points.data(), data, size);
+    mSpillFile.unmap(data);
+    return points;
+}
+
+QVector<qint64> TraceModule::loadSpilledTimestamps(const TraceChunk &chunk)
+{
+    QVector<qint64> timestamps;
+    const qint64 size = chunk.spilledPoints * sizeof(qint64);
+    uchar *data = mSpillFile.map(chunk.spillOffset + chunk.spilledPoints * sizeof(QPointF), size);
+    if (!data) {
+        qWarning() << "Could not map trace spill file:" << mSpillFile.errorString();
+        return timestamps;
+    }
+
+    timestamps.resize(chunk.spilledPoints);
+    memcpy(timestamps.data(), data, size);
+    mSpillFile.unmap(data);
+    return timestamps;
+}
+
+void TraceModule::forEachTracePoint(const Trace &trace, const std::function<void (const QPointF &, qint64, GnssFixType, float)> &function)
+{
+    for (int chunkIndex = 0; chunkIndex < trace.chunks.size(); chunkIndex++) {
+        const TraceChunk &chunk = trace.chunks.at(chunkIndex);
+        const QVector<QPointF> points_mm = chunk.isSpilled() ? loadSpilledPoints(chunk) : chunk.points_mm;
+        const QVector<qint64> timestamps_ns = chunk.isSpilled() ? loadSpilledTimestamps(chunk) : chunk.timestamps_ns;
+        if (points_mm.size() != timestamps_ns.size() || points_mm.size() != chunk.fixTypes.size() || points_mm.size() != chunk.accuracies_m.size())
+            continue;
+        for (int i = (chunkIndex == 0) ? 0 : 1; i < points_mm.size(); i++)
+            function(points_mm.at(i), timestamps_ns.at(i), chunk.fixTypes.at(i), chunk.accuracies_m.at(i));
+    }
+}
+
+void TraceModule::rebuildQualityGrid()
+{
+    mQualityGrid.clear();
+    for (VehicleTraces &vehicleTraces : mVehicleTraces)
+        for (const Trace &trace : vehicleTraces.traceListPerPosType[(int)mQualityHeatmapPosType])
+            forEachTracePoint(trace, [this](const QPointF &point_mm, qint64, GnssFixType fixType, float accuracy_m) {
+                mQualityGrid.addSample(point_mm, fixType, accuracy_m);
+            });
+}
+
+float TraceModule::getCrossTrackError(Trace &trace, const PosPoint &position) const
+{
+    const RouteProjection projection = routeProjection::project(mReferenceRouteGeometry, mReferenceRouteIndex, position.getPoint(),
+                                                                position.getYaw() * M_PI / 180.0, trace.routeProjectionHint);
+    trace.routeProjectionHint = projection.segmentIndex;
+    return projection.valid ? float(projection.crossTrackError_m) : std::numeric_limits<float>::quiet_NaN();
+}
+
+QColor TraceModule::getCrossTrackErrorColor(float crossTrackError_m, const QColor &defaultColor) const
+{
+    if (std::isnan(crossTrackError_m))
+        return defaultColor;
+
+    // Green to red in steps, i.e., runs of similar error are drawn as one polyline
+    const int step = std::min(int(fabs(crossTrackError_m) / mMaxCrossTrackError_m * CROSS_TRACK_ERROR_COLORS), CROSS_TRACK_ERROR_COLORS - 1);
+    return QColor::fromHsvF((1.0 - double(step) / (CROSS_TRACK_ERROR_COLORS - 1)) / 3.0, 1.0, 0.9);
+}
+
+void TraceModule::paintByCrossTrackError(QPainter &painter, QPen &pen, const QVector<QPointF> &points_mm, const QVector<float> &crossTrackErrors_m, const QColor &defaultColor) const
+{
+    if (points_mm.size() < 2 || points_mm.size() != crossTrackErrors_m.size())
+        return;
+
+    // A segment is coloured by the error at its end point
+    QVector<QPointF> run = {points_mm.first()};
+    QColor runColor = getCrossTrackErrorColor(crossTrackErrors_m.at(1), defaultColor);
+    for (int i = 1; i < points_mm.size(); i++) {
+        const QColor color = getCrossTrackErrorColor(crossTrackErrors_m.at(i), defaultColor);
+        if (color != runColor) {
+            pen.setColor(runColor);
+            painter.setPen(pen);
+            painter.drawPolyline(run.constData(), run.size());
+            run = {points_mm.at(i - 1)};
+            runColor = color;
+        }
+        run.append(points_mm.at(i));
+    }
+    pen.setColor(runColor);
+    painter.setPen(pen);
+    painter.drawPolyline(run.constData(), run.size());
+}
+
+void TraceModule::reprojectEnu(const coordinateTransforms::EnuTransform &transform)
+{
+    // The transformation is rigid, cross-track errors stay valid
+    for (VehicleTraces &vehicleTraces : mVehicleTraces)
+        for (auto &traces : vehicleTraces.traceListPerPosType)
+            for (Trace &trace : traces)
+                for (TraceChunk &chunk : trace.chunks) {
+                    QPointF *points_mm = chunk.points_mm.data();
+                    int pointCount = chunk.points_mm.size();
+                    uchar *data = nullptr;
+                    if (chunk.isSpilled()) {
+                        data = mSpillFile.map(chunk.spillOffset, chunk.spilledPoints * sizeof(QPointF));
+                        if (!data) {
+                            qWarning() << "Could not map trace spill file:" << mSpillFile.errorString();
+                            continue;
+                        }
+                        points_mm = reinterpret_cast<QPointF*>(data);
+                        pointCount = chunk.spilledPoints;
+                    }
+
+                    transform.applyPlanar(points_mm, pointCount, 1000.0);
+                    if (pointCount > 0) {
+                        double left = points_mm[0].x(), right = left, top = points_mm[0].y(), bottom = top;
+                        for (int i = 1; i < pointCount; i++) {
+                            left = std::min(left, points_mm[i].x());
+                            right = std::max(right, points_mm[i].x());
+                            top = std::min(top, points_mm[i].y());
+                            bottom = std::max(bottom, points_mm[i].y());
+                        }
+                        chunk.bounds_mm = QRectF(QPointF(left, top), QPointF(right, bottom));
+                    }
+                    if (data)
+                        mSpillFile.unmap(data);
+
+                    chunk.simplifiedPoints_mm = QVector<QPointF>();
+                    chunk.lodLevel = std::numeric_limits<int>::min();
+                }
+
+    if (!mReferenceRoute.isEmpty()) {
+        QVector<pospoint_t> referenceRoute = mReferenceRoute;
+        EnuReprojector::reprojectPoints(transform, referenceRoute);
+        setReferenceRoute(referenceRoute);
+    }
+
+    // Cells do not map onto cells
+    rebuildQualityGrid();
+}
+
+void TraceModule::setReferenceRoute(const QVector<pospoint_t> &referenceRoute)
+{
+    mReferenceRoute = referenceRoute;
+    mReferenceRouteGeometry.setRoute(referenceRoute);
+    mReferenceRouteIndex.setRoute(referenceRoute);
+    for (VehicleTraces &vehicleTraces : mVehicleTraces)
+        for (auto &traces : vehicleTraces.traceListPerPosType)
+            for (Trace &trace : traces)
+                trace.routeProjectionHint = -1;
+}
+
+void TraceModule::setColorByCrossTrackError(bool colorByCrossTrackError)
+{
+    mColorByCrossTrackError = colorByCrossTrackError;
+    emit requestRepaint();
+}
+
+void TraceModule::setQualityHeatmap(TraceModule::QualityHeatmap qualityHeatmap)
+{
+    mQualityHeatmap = qualityHeatmap;
+    if (mQualityHeatmap != QualityHeatmap::None)
+        mQualityGrid.setColoring(mQualityHeatmap == QualityHeatmap::FixType ? TraceQualityGrid::Coloring::FixType : TraceQualityGrid::Coloring::Accuracy,
+                                 mQualityGrid.getMaxAccuracy());
+    emit requestRepaint();
+}
+
+void TraceModule::setQualityHeatmapPosType(PosType type)
+{
+    mQualityHeatmapPosType = type;
+    rebuildQualityGrid();
+    emit requestRepaint();
+}
+
+void TraceModule::setQualityHeatmapCellSize(double cellSize_m)
+{
+    mQualityGrid.setCellSize(cellSize_m);
+    rebuildQualityGrid();
+    emit requestRepaint();
+}
+
+void TraceModule::setMaxAccuracyColor(double maxAccuracy_m)
+{
+    mQualityGrid.setColoring(mQualityGrid.getColoring(), maxAccuracy_m);
+    emit requestRepaint();
+}
+
 void TraceModule::setTraceActiveForPosType(PosType type, bool active)
 {
     mTraceModuleState.traceActiveForPosType[(int)type] = active;
+    emit requestRepaint();
 }
 
 void TraceModule::setTraceColorForPosType(PosType type, QColor color)
 {
     mTraceModuleState.traceColorForPosType[(int)type] = color;
+    emit requestRepaint();
 }
 
 void TraceModule::setCurrentTraceVehicle(QSharedPointer<VehicleState> traceVehicle)
 {
-    mTraceModuleState.currentTraceVehicle = traceVehicle;
+    for (VehicleTraces &vehicleTraces : mVehicleTraces)
+        if (vehicleTraces.vehicle && vehicleTraces.vehicle != traceVehicle)
+            removeTraceVehicle(vehicleTraces.vehicle);
+    addTraceVehicle(traceVehicle);
 }
 
-void TraceModule::startTrace(int traceIndex)
+void TraceModule::addTraceVehicle(QSharedPointer<VehicleState> traceVehicle)
 {
-    if (mTraceModuleState.currentTraceVehicle == nullptr)
+    if (traceVehicle == nullptr)
         return;
 
+    VehicleTraces &vehicleTraces = mVehicleTraces[traceVehicle->getId()];
+    if (vehicleTraces.vehicle != traceVehicle) {
+        disconnect(vehicleTraces.connection);
+        vehicleTraces.connection = QMetaObject::Connection();
+        vehicleTraces.vehicle = traceVehicle;
+    }
+    if (mTraceModuleState.tracing)
+        connectTraceVehicle(vehicleTraces);
+}
+
+void TraceModule::removeTraceVehicle(QSharedPointer<VehicleState> traceVehicle)
+{
+    if (traceVehicle == nullptr)
+        return;
+
+    auto vehicleTraces = mVehicleTraces.find(traceVehicle->getId());
+    if (vehicleTraces == mVehicleTraces.end() || vehicleTraces->vehicle != traceVehicle)
+        return;
+
+    disconnect(vehicleTraces->connection);
+    vehicleTraces->connection = QMetaObject::Connection();
+    vehicleTraces->vehicle = nullptr;
+}
+
+void TraceModule::startTrace(int traceIndex)
+{
     if (traceIndex >= 0)
         mTraceModuleState.currentTraceIndex = traceIndex;
 
-    if (mTraceModuleState.currentTraceIndex >= 0)
-        mTraceSampleTimer.start(mTraceSampleTimerPeriod_ms);
+    if (mTraceModuleState.currentTraceIndex < 0)
+        return;
+
+    mTraceModuleState.tracing = true;
+    for (VehicleTraces &vehicleTraces : mVehicleTraces)
+        connectTraceVehicle(vehicleTraces);
 }
 
 void TraceModule::setCurrentTraceIndex(int traceIndex)
 {
     if (traceIndex >= 0)
         mTraceModuleState.currentTraceIndex = traceIndex;
+    emit requestRepaint();
 }
 
 int TraceModule::getCurrentTraceIndex()
@@ -101,18 +605,369 @@ int TraceModule::getCurrentTraceIndex()
 
 void TraceModule::stopTrace()
 {
-    mTraceSampleTimer.stop();
+    mTraceModuleState.tracing = false;
+    for (VehicleTraces &vehicleTraces : mVehicleTraces) {
+        disconnect(vehicleTraces.connection);
+        vehicleTraces.connection = QMetaObject::Connection();
+    }
 }
 
 void TraceModule::clearTraceIndex(int traceIndex)
 {
-    if (traceIndex >= 0)
-        for (int currentPosTypeInt = 0; currentPosTypeInt < (int)PosType::_LAST_; currentPosTypeInt++)
-            if (mTraceModuleState.currentTraceIndex < mTraceListPerPosType[currentPosTypeInt].size())
-                mTraceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex].clear();
+    if (traceIndex >= 0) {
+        for (VehicleTraces &vehicleTraces : mVehicleTraces)
+            for (int currentPosTypeInt = 0; currentPosTypeInt < (int)PosType::_LAST_; currentPosTypeInt++)
+                if (mTraceModuleState.currentTraceIndex < vehicleTraces.traceListPerPosType[currentPosTypeInt].size())
+                    vehicleTraces.traceListPerPosType[currentPosTypeInt][mTraceModuleState.currentTraceIndex].clear();
+
+        for (auto it = mInMemoryChunks.begin(); it != mInMemoryChunks.end();) {
+            if (it->traceIndex == mTraceModuleState.currentTraceIndex)
+                it = mInMemoryChunks.erase(it);
+            else
+                it++;
+        }
+        rebuildQualityGrid();
+    }
+    emit requestRepaint();
+}
+
+void TraceModule::setTraceMemoryLimit(qint64 traceMemoryLimit)
+{
+    mTraceMemoryLimit = traceMemoryLimit;
+    enforceTraceMemoryLimit();
+}
+
+void TraceModule::setTraceSamplePeriod(int traceSamplePeriod_ms)
+{
+    for (TraceDecimation &decimation : mTraceModuleState.traceDecimationForPosType)
+        decimation.minInterval_ms = std::max(0, traceSamplePeriod_ms);
+}
+
+void TraceModule::clearAllTraces()
+{
+    for (auto it = mVehicleTraces.begin(); it != mVehicleTraces.end();) {
+        if (it->vehicle == nullptr) {
+            it = mVehicleTraces.erase(it);
+            continue;
+        }
+        for (auto &traces : it->traceListPerPosType)
+            traces.clear();
+        it++;
+    }
+
+    mInMemoryChunks.clear();
+    mQualityGrid.clear();
+    mSpilledChunks = 0;
+    if (mSpillFile.isOpen())
+        mSpillFile.resize(0);
+}
+
+bool TraceModule::saveTraceSession(const QString &filename, QString &errorString)
+{
+    QByteArray body;
+    int traceCount = 0;
+    for (auto it = mVehicleTraces.begin(); it != mVehicleTraces.end(); it++)
+        for (int posTypeInt = 0; posTypeInt < (int)PosType::_LAST_; posTypeInt++)
+            for (int traceIndex = 0; traceIndex < it->traceListPerPosType[posTypeInt].size(); traceIndex++) {
+                const Trace &trace = it->traceListPerPosType[posTypeInt].at(traceIndex);
+                if (trace.isEmpty())
+                    continue;
+
+                QVector<qint64> timestamps_us, x_mm, y_mm, fixTypes, accuracies_mm;
+                forEachTracePoint(trace, [&](const QPointF &point_mm, qint64 timestamp_ns, GnssFixType fixType, float accuracy_m) {
+                    timestamps_us.append(timestampToSession(timestamp_ns));
+                    x_mm.append(std::llround(point_mm.x()));
+                    y_mm.append(std::llround(point_mm.y()));
+                    fixTypes.append(qint64(fixType));
+                    accuracies_mm.append(std::isnan(accuracy_m) ? -1 : std::llround(accuracy_m * 1000.0));
+                });
+
+                writeSignedVarint(body, it.key());
+                writeVarint(body, posTypeInt);
+                writeVarint(body, traceIndex);
+                writeVarint(body, timestamps_us.size());
+                for (const QVector<qint64> *column : {&timestamps_us, &x_mm, &y_mm, &fixTypes, &accuracies_mm}) {
+                    qint64 last = 0;
+                    for (const qint64 value : *column) {
+                        writeSignedVarint(body, value - last);
+                        last = value;
+                    }
+                }
+                traceCount++;
+            }
+
+    QByteArray data(TRACE_SESSION_MAGIC, sizeof(TRACE_SESSION_MAGIC));
+    data.append(char(TRACE_SESSION_VERSION));
+    QByteArray header;
+    writeVarint(header, traceCount);
+    data.append(qCompress(header + body));
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        errorString = "Could not write \"" + filename + "\": " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool TraceModule::loadTraceSession(const QString &filename, QString &errorString)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorString = "Could not open \"" + filename + "\": " + file.errorString();
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    const uint8_t version = (data.size() > int(sizeof(TRACE_SESSION_MAGIC))) ? uint8_t(data.at(sizeof(TRACE_SESSION_MAGIC))) : 0;
+    if (data.size() < int(sizeof(TRACE_SESSION_MAGIC)) + 1 || memcmp(data.constData(), TRACE_SESSION_MAGIC, sizeof(TRACE_SESSION_MAGIC)) != 0 ||
+            (version != TRACE_SESSION_VERSION && version != TRACE_SESSION_VERSION_WITHOUT_QUALITY)) {
+        errorString = "\"" + filename + "\" is not a trace session file of a supported version.";
+        return false;
+    }
+
+    // Decoded completely before replacing the traces, i.e., they are kept on malformed input
+    struct DecodedTrace {
+        ObjectState::ObjectID_t vehicleId;
+        int posType;
+        int traceIndex;
+        QVector<QPointF> points_mm;
+        QVector<qint64> timestamps_ns;
+        QVector<GnssFixType> fixTypes;
+        QVector<float> accuracies_m;
+    };
+    QVector<DecodedTrace> decodedTraces;
+    const QByteArray body = qUncompress(data.mid(sizeof(TRACE_SESSION_MAGIC) + 1));
+    const uchar *pos = reinterpret_cast<const uchar*>(body.constData());
+    const uchar *end = pos + body.size();
+    quint64 traceCount;
+    bool valid = !body.isEmpty() && readVarint(pos, end, traceCount);
+    for (quint64 i = 0; valid && i < traceCount; i++) {
+        qint64 vehicleId;
+        quint64 posType, traceIndex, pointCount;
+        valid = readSignedVarint(pos, end, vehicleId) && readVarint(pos, end, posType) && readVarint(pos, end, traceIndex) &&
+                readVarint(pos, end, pointCount) && posType < quint64(PosType::_LAST_) && traceIndex <= quint64(std::numeric_limits<int>::max()) &&
+                pointCount <= quint64(end - pos); // at least a byte per point and column
+        if (!valid)
+            break;
+
+        DecodedTrace trace {ObjectState::ObjectID_t(vehicleId), int(posType), int(traceIndex), QVector<QPointF>(int(pointCount)), QVector<qint64>(int(pointCount)),
+                            QVector<GnssFixType>(int(pointCount), GnssFixType::Unknown), QVector<float>(int(pointCount), std::numeric_limits<float>::quiet_NaN())};
+        qint64 value = 0;
+        for (qint64 &timestamp_ns : trace.timestamps_ns) {
+            qint64 delta;
+            valid = valid && readSignedVarint(pos, end, delta);
+            value += delta;
+            timestamp_ns = timestampFromSession(value);
+        }
+        value = 0;
+        for (QPointF &point_mm : trace.points_mm) {
+            qint64 delta;
+            valid = valid && readSignedVarint(pos, end, delta);
+            value += delta;
+            point_mm.setX(value);
+        }
+        value = 0;
+        for (QPointF &point_mm : trace.points_mm) {
+            qint64 delta;
+            valid = valid && readSignedVarint(pos, end, delta);
+            value += delta;
+            point_mm.setY(value);
+        }
+        if (version != TRACE_SESSION_VERSION_WITHOUT_QUALITY) {
+            value = 0;
+            for (GnssFixType &fixType : trace.fixTypes) {
+                qint64 delta;
+                valid = valid && readSignedVarint(pos, end, delta);
+                value += delta;
+                fixType = (value >= 0 && value < qint64(GnssFixType::_LAST_)) ? GnssFixType(value) : GnssFixType::Unknown;
+            }
+            value = 0;
+            for (float &accuracy_m : trace.accuracies_m) {
+                qint64 delta;
+                valid = valid && readSignedVarint(pos, end, delta);
+                value += delta;
+                accuracy_m = (value < 0) ? std::numeric_limits<float>::quiet_NaN() : float(value / 1000.0);
+            }
+        }
+        decodedTraces.append(trace);
+    }
+
+    if (!valid || pos != end) {
+        errorString = "\"" + filename + "\" is malformed.";
+        return false;
+    }
+
+    clearAllTraces();
+    for (const DecodedTrace &decodedTrace : decodedTraces) {
+        QList<Trace> &traceList = mVehicleTraces[decodedTrace.vehicleId].traceListPerPosType[decodedTrace.posType];
+        while (decodedTrace.traceIndex >= traceList.size())
+            traceList.append(Trace());
+
+        Trace &trace = traceList[decodedTrace.traceIndex];
+        trace.clear();
+        for (int i = 0; i < decodedTrace.points_mm.size(); i++) {
+            PosPoint point;
+            point.setXY(decodedTrace.points_mm.at(i).x() / 1000.0, decodedTrace.points_mm.at(i).y() / 1000.0);
+            if (trace.append(decodedTrace.points_mm.at(i), getCrossTrackError(trace, point), decodedTrace.timestamps_ns.at(i),
+                             decodedTrace.fixTypes.at(i), decodedTrace.accuracies_m.at(i)))
+                mInMemoryChunks.append({decodedTrace.vehicleId, decodedTrace.posType, decodedTrace.traceIndex, trace.chunks.size() - 2});
+            if (decodedTrace.posType == (int)mQualityHeatmapPosType)
+                mQualityGrid.addSample(decodedTrace.points_mm.at(i), decodedTrace.fixTypes.at(i), decodedTrace.accuracies_m.at(i));
+        }
+        trace.lastTimestamp_ns = trace.isEmpty() ? utcTime::INVALID : decodedTrace.timestamps_ns.last();
+    }
+    enforceTraceMemoryLimit();
+
+    if (mTraceModuleState.currentTraceIndex < 0 && !decodedTraces.isEmpty())
+        mTraceModuleState.currentTraceIndex = decodedTraces.first().traceIndex;
+    emit requestRepaint();
+    return true;
+}
+
+QByteArray TraceModule::getTraceSnapshot()
+{
+    QByteArray snapshot;
+    qint32 traceCount = 0;
+    appendRaw(snapshot, &traceCount, 1); // counts are written once known
+    for (auto it = mVehicleTraces.begin(); it != mVehicleTraces.end(); it++)
+        for (int posTypeInt = 0; posTypeInt < (int)PosType::_LAST_; posTypeInt++)
+            for (int traceIndex = 0; traceIndex < it->traceListPerPosType[posTypeInt].size(); traceIndex++) {
+                const Trace &trace = it->traceListPerPosType[posTypeInt].at(traceIndex);
+                if (trace.isEmpty())
+                    continue;
+
+                qint32 traceHeader[] = {qint32(it.key()), posTypeInt, traceIndex, 0};
+                const int traceHeaderOffset = snapshot.size();
+                appendRaw(snapshot, traceHeader, 4);
+                for (const TraceChunk &chunk : trace.chunks) {
+                    const QVector<QPointF> points_mm = chunk.isSpilled() ? loadSpilledPoints(chunk) : chunk.points_mm;
+                    const QVector<qint64> timestamps_ns = chunk.isSpilled() ? loadSpilledTimestamps(chunk) : chunk.timestamps_ns;
+                    const qint32 pointCount = points_mm.size();
+                    if (pointCount == 0 || timestamps_ns.size() != pointCount || chunk.crossTrackErrors_m.size() != pointCount ||
+                            chunk.accuracies_m.size() != pointCount || chunk.fixTypes.size() != pointCount)
+                        continue;
+
+                    const double bounds_mm[] = {chunk.bounds_mm.left(), chunk.bounds_mm.top(), chunk.bounds_mm.width(), chunk.bounds_mm.height()};
+                    appendRaw(snapshot, &pointCount, 1);
+                    appendRaw(snapshot, bounds_mm, 4);
+                    appendRaw(snapshot, points_mm.constData(), pointCount);
+                    appendRaw(snapshot, timestamps_ns.constData(), pointCount);
+                    appendRaw(snapshot, chunk.crossTrackErrors_m.constData(), pointCount);
+                    appendRaw(snapshot, chunk.accuracies_m.constData(), pointCount);
+                    appendRaw(snapshot, chunk.fixTypes.constData(), pointCount);
+                    traceHeader[3]++;
+                }
+                if (traceHeader[3] == 0) {
+                    snapshot.truncate(traceHeaderOffset);
+                    continue;
+                }
+                memcpy(snapshot.data() + traceHeaderOffset, traceHeader, sizeof(traceHeader));
+                traceCount++;
+            }
+    memcpy(snapshot.data(), &traceCount, sizeof(traceCount));
+    return snapshot;
+}
+
+bool TraceModule::restoreTraceSnapshot(const QByteArray &traceSnapshot)
+{
+    // Read completely before replacing the traces, i.e., they are kept on malformed input
+    struct RestoredTrace {
+        ObjectState::ObjectID_t vehicleId;
+        int posType;
+        int traceIndex;
+        Trace trace;
+    };
+    QVector<RestoredTrace> restoredTraces;
+    const char *pos = traceSnapshot.constData();
+    const char *end = pos + traceSnapshot.size();
+    qint32 traceCount;
+    bool valid = readRaw(pos, end, &traceCount, 1) && traceCount >= 0;
+    for (int i = 0; valid && i < traceCount; i++) {
+        qint32 traceHeader[4];
+        valid = readRaw(pos, end, traceHeader, 4) && traceHeader[1] >= 0 && traceHeader[1] < (int)PosType::_LAST_ &&
+                traceHeader[2] >= 0 && traceHeader[3] > 0;
+        if (!valid)
+            break;
+
+        RestoredTrace restoredTrace {ObjectState::ObjectID_t(traceHeader[0]), traceHeader[1], traceHeader[2], Trace()};
+        for (int chunkIndex = 0; valid && chunkIndex < traceHeader[3]; chunkIndex++) {
+            qint32 pointCount;
+            double bounds_mm[4];
+            valid = readRaw(pos, end, &pointCount, 1) && pointCount > 0 && pointCount <= TRACE_CHUNK_POINTS && readRaw(pos, end, bounds_mm, 4);
+            if (!valid)
+                break;
+
+            TraceChunk chunk;
+            chunk.points_mm.resize(pointCount);
+            chunk.timestamps_ns.resize(pointCount);
+            chunk.crossTrackErrors_m.resize(pointCount);
+            chunk.accuracies_m.resize(pointCount);
+            chunk.fixTypes.resize(pointCount);
+            valid = readRaw(pos, end, chunk.points_mm.data(), pointCount) && readRaw(pos, end, chunk.timestamps_ns.data(), pointCount) &&
+                    readRaw(pos, end, chunk.crossTrackErrors_m.data(), pointCount) && readRaw(pos, end, chunk.accuracies_m.data(), pointCount) &&
+                    readRaw(pos, end, chunk.fixTypes.data(), pointCount);
+            for (GnssFixType &fixType : chunk.fixTypes)
+                if (fixType >= GnssFixType::_LAST_)
+                    fixType = GnssFixType::Unknown;
+            chunk.bounds_mm = QRectF(bounds_mm[0], bounds_mm[1], bounds_mm[2], bounds_mm[3]);
+            restoredTrace.trace.chunks.append(chunk);
+        }
+        if (valid) {
+            restoredTrace.trace.lastTimestamp_ns = restoredTrace.trace.chunks.last().timestamps_ns.last();
+            restoredTraces.append(restoredTrace);
+        }
+    }
+
+    if (!valid || pos != end)
+        return false;
+
+    clearAllTraces();
+    for (const RestoredTrace &restoredTrace : restoredTraces) {
+        QList<Trace> &traceList = mVehicleTraces[restoredTrace.vehicleId].traceListPerPosType[restoredTrace.posType];
+        while (restoredTrace.traceIndex >= traceList.size())
+            traceList.append(Trace());
+
+        traceList[restoredTrace.traceIndex] = restoredTrace.trace;
+        for (int chunkIndex = 0; chunkIndex < restoredTrace.trace.chunks.size() - 1; chunkIndex++) // the last one is not completed
+            mInMemoryChunks.append({restoredTrace.vehicleId, restoredTrace.posType, restoredTrace.traceIndex, chunkIndex});
+    }
+    rebuildQualityGrid();
+    enforceTraceMemoryLimit();
+
+    if (mTraceModuleState.currentTraceIndex < 0 && !restoredTraces.isEmpty())
+        mTraceModuleState.currentTraceIndex = restoredTraces.first().traceIndex;
+    emit requestRepaint();
+    return true;
 }
 
-void TraceModule::setTraceSamplePeriod(int traceSampleTimerPeriod_ms)
+bool TraceModule::exportTracesToCsv(const QString &filename, QString &errorString)
 {
-    mTraceSampleTimerPeriod_ms = traceSampleTimerPeriod_ms;
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        errorString = "Could not open \"" + filename + "\" for writing: " + file.errorString();
+        return false;
+    }
+
+    // Written row by row into the file's buffer
+    file.write("vehicle_id,pos_type,trace_index,timestamp_ns,x_m,y_m,fix_type,accuracy_m\n");
+    char row[192];
+    for (auto it = mVehicleTraces.begin(); it != mVehicleTraces.end(); it++)
+        for (int posTypeInt = 0; posTypeInt < (int)PosType::_LAST_; posTypeInt++)
+            for (int traceIndex = 0; traceIndex < it->traceListPerPosType[posTypeInt].size(); traceIndex++) {
+                const int prefixLength = snprintf(row, sizeof(row), "%d,%s,%d,", it.key(), POS_TYPE_NAMES[posTypeInt], traceIndex);
+                forEachTracePoint(it->traceListPerPosType[posTypeInt].at(traceIndex), [&](const QPointF &point_mm, qint64 timestamp_ns, GnssFixType fixType, float accuracy_m) {
+                    int length = prefixLength + snprintf(row + prefixLength, sizeof(row) - prefixLength, "%lld,%.3f,%.3f,%s,",
+                                                         (long long)timestamp_ns, point_mm.x() / 1000.0, point_mm.y() / 1000.0, FIX_TYPE_NAMES[(int)fixType]);
+                    length += std::isnan(accuracy_m) ? snprintf(row + length, sizeof(row) - length, "\n")
+                                                     : snprintf(row + length, sizeof(row) - length, "%.3f\n", accuracy_m);
+                    file.write(row, length);
+                });
+            }
+
+    if (!file.commit()) {
+        errorString = "Could not write \"" + filename + "\": " + file.errorString();
+        return false;
+    }
+    return true;
 }
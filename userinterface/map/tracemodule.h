@@ -3,6 +3,20 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  *
  * MapModule that traces the different vehicles' position types, manages them and draws them on the map
+ * Several vehicles can be traced at the same time. Each traced source is sampled on its own position updates
+ * (VehicleState::positionOfSourceUpdated) and decimated per PosType by distance and time, i.e., fast sources are not
+ * undersampled and unchanged slow sources are not duplicated. The memory limit applies to the points of all traces.
+ * Traces are stored as contiguous point arrays in chunks with bounding boxes. Chunks outside of the view are skipped,
+ * the others are drawn as polylines simplified (Douglas-Peucker) to the current zoom level and cached until it changes.
+ * Full chunks beyond the memory limit are spilled (oldest first) to a temporary file and mapped back when they are in view.
+ * With a reference route, the cross-track error of each point is kept (in memory, also for spilled chunks) and traces
+ * can be coloured by it (green: on the route, red: at or beyond the max. error), unsimplified.
+ * Each point also keeps its GNSS fix type (the attributes of PosType::GNSS positions, see GnssFixType) and accuracy (sigma).
+ * The points of one PosType in all traces are aggregated into a TraceQualityGrid as they arrive, which can be drawn below the
+ * traces as a heatmap of the fix type or accuracy.
+ * On a change of the map's ENU reference, all points (also spilled ones, in place in the file) are converted in bulk.
+ * Trace sessions (all traces with their timestamps) can be saved to and loaded from a compact columnar file, and
+ * exported as CSV, see tracemodule.cpp for the format. Snapshots keep the chunks as they are, for fast restarts (SessionSnapshot).
  */
 
 #ifndef TRACEMODULE_H
@@ -10,6 +24,21 @@
 
 #include "userinterface/map/mapwidget.h"
 #include "core/pospoint.h"
+#include "core/routegeometry.h"
+#include "core/routespatialindex.h"
+#include "userinterface/map/tracequalitygrid.h"
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <QTemporaryFile>
+#include <QMap>
+#include <limits>
+#include <functional>
+
+struct TraceDecimation {
+    double minDistance_m = 0.1; // to the previous point of the trace
+    int minInterval_ms = 0; // between position timestamps, 0: every update
+};
 
 class TraceModule : public MapModule
 {
@@ -18,29 +47,135 @@ public:
 
     // MapModule interface
     virtual void processPaint(QPainter &painter, int width, int height, bool highQuality, QTransform drawTrans, QTransform txtTrans, double scale) override;
+    virtual void reprojectEnu(const coordinateTransforms::EnuTransform &transform) override;
+    virtual void enuReprojected() override { emit requestRepaint(); }
 
     void setTraceActiveForPosType(PosType type, bool active);
     void setTraceColorForPosType(PosType type, QColor color);
-    void setCurrentTraceVehicle(QSharedPointer<VehicleState> traceVehicle);
+    void setTraceDecimationForPosType(PosType type, const TraceDecimation &decimation) { mTraceModuleState.traceDecimationForPosType[(int)type] = decimation; }
+    TraceDecimation getTraceDecimationForPosType(PosType type) const { return mTraceModuleState.traceDecimationForPosType[(int)type]; }
+    void setCurrentTraceVehicle(QSharedPointer<VehicleState> traceVehicle); // traces only this vehicle
+    // Traces of a removed vehicle are kept (and drawn) until cleared
+    void addTraceVehicle(QSharedPointer<VehicleState> traceVehicle);
+    void removeTraceVehicle(QSharedPointer<VehicleState> traceVehicle);
     void startTrace(int traceIndex = -1);
     void setCurrentTraceIndex(int traceIndex);
     int getCurrentTraceIndex();
     void stopTrace();
     void clearTraceIndex(int traceIndex);
-    void setTraceSamplePeriod(int traceSamplePeriod_ms);
+    void setTraceSamplePeriod(int traceSamplePeriod_ms); // min. interval of all PosTypes
+    qint64 getTraceMemoryLimit() const { return mTraceMemoryLimit; }
+    void setTraceMemoryLimit(qint64 traceMemoryLimit); // bytes of trace points kept in memory
+    int getSpilledChunkCount() const { return mSpilledChunks; }
+
+    // Loading replaces all traces. Return false (and a user readable errorString) on failure.
+    bool saveTraceSession(const QString &filename, QString &errorString);
+    bool loadTraceSession(const QString &filename, QString &errorString);
+    bool exportTracesToCsv(const QString &filename, QString &errorString);
+    // Chunks as plain arrays for a SessionSnapshot, restored without decoding (see tracemodule.cpp). Restoring replaces all
+    // traces, returns false on malformed input (the traces are kept then).
+    QByteArray getTraceSnapshot();
+    bool restoreTraceSnapshot(const QByteArray &traceSnapshot);
+
+    // Cross-track errors of points traced afterwards refer to this route, empty: none
+    void setReferenceRoute(const QVector<pospoint_t> &referenceRoute);
+    void setColorByCrossTrackError(bool colorByCrossTrackError);
+    bool isColoredByCrossTrackError() const { return mColorByCrossTrackError; }
+    void setMaxCrossTrackErrorColor(double maxCrossTrackError_m) { mMaxCrossTrackError_m = std::max(maxCrossTrackError_m, 0.01); emit requestRepaint(); }
+
+    // Position quality heatmap of the points of heatmapPosType (default GNSS) in all traces
+    enum class QualityHeatmap {
+        None,
+        FixType,
+        Accuracy
+    };
+    void setQualityHeatmap(QualityHeatmap qualityHeatmap);
+    QualityHeatmap getQualityHeatmap() const { return mQualityHeatmap; }
+    void setQualityHeatmapPosType(PosType type);
+    PosType getQualityHeatmapPosType() const { return mQualityHeatmapPosType; }
+    void setQualityHeatmapCellSize(double cellSize_m);
+    double getQualityHeatmapCellSize() const { return mQualityGrid.getCellSize(); }
+    void setMaxAccuracyColor(double maxAccuracy_m); // red in the accuracy heatmap
+
+    static constexpr int TRACE_CHUNK_POINTS = 256;
+    static constexpr double SIMPLIFY_TOLERANCE_px = 0.5;
+    static constexpr qint64 DEFAULT_TRACE_MEMORY_LIMIT = 64 * 1024 * 1024;
+    static constexpr int CROSS_TRACK_ERROR_COLORS = 16;
 
 private:
+    struct TraceChunk {
+        QVector<QPointF> points_mm; // starts with the last point of the previous chunk
+        QVector<float> crossTrackErrors_m; // per point, NaN without reference route
+        QVector<GnssFixType> fixTypes; // per point, in memory also for spilled chunks
+        QVector<float> accuracies_m; // per point, NaN if unknown, in memory also for spilled chunks
+        QVector<qint64> timestamps_ns; // per point, spilled after the points
+        QRectF bounds_mm;
+        int lodLevel = std::numeric_limits<int>::min(); // of simplifiedPoints_mm
+        QVector<QPointF> simplifiedPoints_mm;
+        qint64 spillOffset = -1; // points_mm is empty when spilled
+        int spilledPoints = 0;
+        bool isSpilled() const { return spillOffset >= 0; }
+    };
+
+    struct Trace {
+        QVector<TraceChunk> chunks;
+        int routeProjectionHint = -1; // segment of the reference route
+        qint64 lastTimestamp_ns = utcTime::INVALID; // of the last point
+        bool isEmpty() const { return chunks.isEmpty(); }
+        const QPointF &last_mm() const { return chunks.last().points_mm.last(); }
+        bool append(const QPointF &point_mm, float crossTrackError_m, qint64 timestamp_ns, GnssFixType fixType, float accuracy_m); // true if a chunk was completed
+        void clear() { chunks.clear(); routeProjectionHint = -1; lastTimestamp_ns = utcTime::INVALID; }
+    };
+
+    struct VehicleTraces {
+        QSharedPointer<VehicleState> vehicle; // nullptr: no longer traced
+        QMetaObject::Connection connection; // valid while tracing
+        QList<Trace> traceListPerPosType[(int)PosType::_LAST_];
+    };
+
+    struct ChunkRef {
+        ObjectState::ObjectID_t vehicleId;
+        int posType;
+        int traceIndex;
+        int chunkIndex;
+    };
+
+    void sampleTrace(ObjectState::ObjectID_t vehicleId, const pospoint_t &position);
+    void connectTraceVehicle(VehicleTraces &vehicleTraces);
+    void enforceTraceMemoryLimit();
+    void clearAllTraces();
+    // Points of a trace in order, without the points shared by consecutive chunks
+    void forEachTracePoint(const Trace &trace, const std::function<void(const QPointF &point_mm, qint64 timestamp_ns, GnssFixType fixType, float accuracy_m)> &function);
+    void rebuildQualityGrid();
+    float getCrossTrackError(Trace &trace, const PosPoint &position) const;
+    QColor getCrossTrackErrorColor(float crossTrackError_m, const QColor &defaultColor) const;
+    void paintByCrossTrackError(QPainter &painter, QPen &pen, const QVector<QPointF> &points_mm, const QVector<float> &crossTrackErrors_m, const QColor &defaultColor) const;
+    QVector<QPointF> loadSpilledPoints(const TraceChunk &chunk);
+    QVector<qint64> loadSpilledTimestamps(const TraceChunk &chunk);
+
     struct {
         int currentTraceIndex = -1;
         bool traceActiveForPosType[(int)PosType::_LAST_];
         QColor traceColorForPosType[(int)PosType::_LAST_];
-        QSharedPointer<VehicleState> currentTraceVehicle = nullptr;
-        double minTraceSampleDistance = 0.1; // [m]
+        TraceDecimation traceDecimationForPosType[(int)PosType::_LAST_];
+        bool tracing = false;
     } mTraceModuleState;
 
-    QTimer mTraceSampleTimer;
-    int mTraceSampleTimerPeriod_ms = 100;
-    QList<QList<PosPoint>> mTraceListPerPosType[(int)PosType::_LAST_];
+    QMap<ObjectState::ObjectID_t, VehicleTraces> mVehicleTraces;
+    qint64 mTraceMemoryLimit = DEFAULT_TRACE_MEMORY_LIMIT;
+    QList<ChunkRef> mInMemoryChunks; // completed chunks, oldest first
+    QTemporaryFile mSpillFile; // space of cleared traces is not reused
+    int mSpilledChunks = 0;
+
+    QVector<pospoint_t> mReferenceRoute;
+    RouteGeometry mReferenceRouteGeometry;
+    RouteSpatialIndex mReferenceRouteIndex;
+    bool mColorByCrossTrackError = false;
+    double mMaxCrossTrackError_m = 0.5;
+
+    QualityHeatmap mQualityHeatmap = QualityHeatmap::None;
+    PosType mQualityHeatmapPosType = PosType::GNSS;
+    TraceQualityGrid mQualityGrid;
 
 };
 
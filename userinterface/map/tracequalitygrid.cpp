@@ -0,0 +1,105 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "tracequalitygrid.h"
+#include <QColor>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void TraceQualityGrid::setCellSize(double cellSize_m)
+{
+    mCellSize_m = std::max(cellSize_m, 0.01);
+    mBlocks.clear();
+}
+
+void TraceQualityGrid::setColoring(TraceQualityGrid::Coloring coloring, double maxAccuracy_m)
+{
+    mColoring = coloring;
+    mMaxAccuracy_m = std::max(maxAccuracy_m, 0.01);
+
+    for (Block &block : mBlocks)
+        for (int i = 0; i < block.cells.size(); i++)
+            block.image.setPixel(i % BLOCK_CELLS, i / BLOCK_CELLS, getCellColor(block.cells.at(i)));
+}
+
+void TraceQualityGrid::addSample(const QPointF &point_mm, GnssFixType fixType, float accuracy_m)
+{
+    if (fixType == GnssFixType::Unknown && std::isnan(accuracy_m))
+        return;
+
+    const qint64 cellX = qint64(floor(point_mm.x() / 1000.0 / mCellSize_m));
+    const qint64 cellY = qint64(floor(point_mm.y() / 1000.0 / mCellSize_m));
+    const qint64 blockX = (cellX >= 0) ? cellX / BLOCK_CELLS : (cellX + 1) / BLOCK_CELLS - 1;
+    const qint64 blockY = (cellY >= 0) ? cellY / BLOCK_CELLS : (cellY + 1) / BLOCK_CELLS - 1;
+    if (blockX < std::numeric_limits<qint32>::min() || blockX > std::numeric_limits<qint32>::max() ||
+            blockY < std::numeric_limits<qint32>::min() || blockY > std::numeric_limits<qint32>::max())
+        return;
+
+    Block &block = mBlocks[blockKey(int(blockX), int(blockY))];
+    if (block.cells.isEmpty()) {
+        block.cells.resize(BLOCK_CELLS * BLOCK_CELLS);
+        block.image = QImage(BLOCK_CELLS, BLOCK_CELLS, QImage::Format_ARGB32_Premultiplied);
+        block.image.fill(Qt::transparent);
+    }
+
+    const int column = int(cellX - blockX * BLOCK_CELLS);
+    const int row = int(cellY - blockY * BLOCK_CELLS);
+    Cell &cell = block.cells[row * BLOCK_CELLS + column];
+    if (fixType != GnssFixType::Unknown) {
+        if (cell.fixTypeSamples == std::numeric_limits<quint16>::max()) {
+            cell.fixTypeSamples /= 2;
+            cell.rtkFixedSamples /= 2;
+            cell.rtkFloatSamples /= 2;
+        }
+        cell.fixTypeSamples++;
+        if (fixType == GnssFixType::RtkFixed)
+            cell.rtkFixedSamples++;
+        else if (fixType == GnssFixType::RtkFloat)
+            cell.rtkFloatSamples++;
+    }
+    if (!std::isnan(accuracy_m)) {
+        if (cell.accuracySamples == std::numeric_limits<quint16>::max()) {
+            cell.accuracySamples /= 2;
+            cell.accuracySum_m /= 2.0f;
+        }
+        cell.accuracySamples++;
+        cell.accuracySum_m += accuracy_m;
+    }
+    block.image.setPixel(column, row, getCellColor(cell));
+}
+
+void TraceQualityGrid::paint(QPainter &painter, const QRectF &view_mm) const
+{
+    const double blockSize_mm = BLOCK_CELLS * mCellSize_m * 1000.0;
+
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform, false); // sharp cells
+    for (auto it = mBlocks.constBegin(); it != mBlocks.constEnd(); it++) {
+        const QRectF block_mm(qint32(it.key() >> 32) * blockSize_mm, qint32(it.key() & 0xFFFFFFFF) * blockSize_mm, blockSize_mm, blockSize_mm);
+        if (block_mm.intersects(view_mm))
+            painter.drawImage(block_mm, it.value().image);
+    }
+    painter.restore();
+}
+
+QRgb TraceQualityGrid::getCellColor(const TraceQualityGrid::Cell &cell) const
+{
+    // Red to green in steps, as TraceModule's cross-track error colors
+    double quality;
+    if (mColoring == Coloring::FixType) {
+        if (cell.fixTypeSamples == 0)
+            return qRgba(0, 0, 0, 0);
+        quality = (cell.rtkFixedSamples + 0.5 * cell.rtkFloatSamples) / cell.fixTypeSamples;
+    } else {
+        if (cell.accuracySamples == 0)
+            return qRgba(0, 0, 0, 0);
+        quality = 1.0 - std::min(cell.accuracySum_m / cell.accuracySamples / mMaxAccuracy_m, 1.0);
+    }
+
+    const int step = std::min(int(quality * COLORS), COLORS - 1);
+    QColor color = QColor::fromHsvF(double(step) / (COLORS - 1) / 3.0, 1.0, 0.9);
+    color.setAlpha(CELL_ALPHA);
+    return qPremultiply(color.rgba());
+}
@@ -0,0 +1,75 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Position quality (GNSS fix type and accuracy) of trace samples aggregated into a grid of square cells, e.g., to see where
+ * RTK fix degrades across a field (see TraceModule). Cells are allocated in blocks of BLOCK_CELLS x BLOCK_CELLS that each keep an
+ * image with a pixel per cell. Samples update their cell and its pixel when they are added, painting only draws the images of
+ * the visible blocks, i.e., the cost of painting does not grow with the number of samples.
+ */
+
+#ifndef TRACEQUALITYGRID_H
+#define TRACEQUALITYGRID_H
+
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include "core/pospoint.h"
+
+class TraceQualityGrid
+{
+public:
+    // FixType: (RTK fixed + 0.5 * RTK float samples) / samples with a fix type, red (none) to green (all fixed).
+    // Accuracy: mean accuracy, green (0) to red (maxAccuracy_m or more).
+    enum class Coloring {
+        FixType,
+        Accuracy
+    };
+
+    void setCellSize(double cellSize_m); // clears
+    double getCellSize() const { return mCellSize_m; }
+    void setColoring(Coloring coloring, double maxAccuracy_m); // recolors all cells
+    Coloring getColoring() const { return mColoring; }
+    double getMaxAccuracy() const { return mMaxAccuracy_m; }
+
+    // accuracy_m: NaN if unknown
+    void addSample(const QPointF &point_mm, GnssFixType fixType, float accuracy_m);
+    void clear() { mBlocks.clear(); }
+    bool isEmpty() const { return mBlocks.isEmpty(); }
+    int getBlockCount() const { return mBlocks.size(); }
+
+    // With the painter's transform in ENU [mm], cells without samples of the coloring are transparent
+    void paint(QPainter &painter, const QRectF &view_mm) const;
+
+    static constexpr int BLOCK_CELLS = 64;
+    static constexpr int COLORS = 16;
+    static constexpr int CELL_ALPHA = 160;
+
+private:
+    // Counts are halved when one would overflow, the shares stay the same
+    struct Cell {
+        quint16 fixTypeSamples = 0; // with a known fix type
+        quint16 rtkFixedSamples = 0;
+        quint16 rtkFloatSamples = 0;
+        quint16 accuracySamples = 0;
+        float accuracySum_m = 0.0f;
+    };
+
+    struct Block {
+        QVector<Cell> cells; // row by row, increasing y
+        QImage image; // a pixel per cell
+    };
+
+    static quint64 blockKey(int blockX, int blockY) { return (quint64(quint32(blockX)) << 32) | quint32(blockY); }
+    QRgb getCellColor(const Cell &cell) const;
+
+    double mCellSize_m = 2.0;
+    Coloring mColoring = Coloring::FixType;
+    double mMaxAccuracy_m = 0.5;
+    QHash<quint64, Block> mBlocks;
+};
+
+#endif // TRACEQUALITYGRID_H
@@ -0,0 +1,297 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "parametertablemodel.h"
+#include <QFont>
+#include <QBrush>
+#include <algorithm>
+
+ParameterTableModel::ParameterTableModel(QObject *parent) : QAbstractTableModel(parent)
+{
+}
+
+void ParameterTableModel::setParameters(Source source, const ParameterServer::AllParameters &parameters)
+{
+    beginResetModel();
+
+    QVector<Row> rows;
+    rows.reserve(mRows.size() + int(parameters.intParameters.size() + parameters.floatParameters.size() + parameters.customParameters.size()));
+    if (source == Source::ControlTower)
+        for (const auto& row : mRows)
+            if (row.source == Source::Vehicle)
+                rows.append(row);
+
+    for (const auto& parameter : parameters.intParameters) {
+        Row row {source, Type::Int, parameter.name};
+        row.intValue = parameter.value;
+        rows.append(row);
+    }
+    for (const auto& parameter : parameters.floatParameters) {
+        Row row {source, Type::Float, parameter.name};
+        row.floatValue = parameter.value;
+        rows.append(row);
+    }
+    for (const auto& parameter : parameters.customParameters) {
+        Row row {source, Type::Custom, parameter.name};
+        row.customValue = parameter.value;
+        rows.append(row);
+    }
+
+    if (source == Source::Vehicle)
+        for (const auto& row : mRows)
+            if (row.source == Source::ControlTower)
+                rows.append(row);
+
+    mRows = rows;
+    mChangedRows = std::count_if(mRows.begin(), mRows.end(), [](const Row &row) { return row.changed; });
+    rebuildRowIndex();
+    mFetchedRows = std::min(int(mRows.size()), FETCH_BATCH_SIZE);
+
+    endResetModel();
+}
+
+void ParameterTableModel::updateParameters(Source source, const ParameterServer::AllParameters &parameters)
+{
+    for (const auto& parameter : parameters.intParameters) {
+        const int row = findRow(source, parameter.name);
+        if (row >= 0 && mRows[row].type == Type::Int) {
+            mRows[row].intValue = parameter.value;
+            valueChanged(row);
+        }
+    }
+    for (const auto& parameter : parameters.floatParameters) {
+        const int row = findRow(source, parameter.name);
+        if (row >= 0 && mRows[row].type == Type::Float) {
+            mRows[row].floatValue = parameter.value;
+            valueChanged(row);
+        }
+    }
+    for (const auto& parameter : parameters.customParameters) {
+        const int row = findRow(source, parameter.name);
+        if (row >= 0 && mRows[row].type == Type::Custom) {
+            mRows[row].customValue = parameter.value;
+            valueChanged(row);
+        }
+    }
+}
+
+bool ParameterTableModel::containsParameter(Source source, const QString &name) const
+{
+    return getRowIndex(source).contains(name);
+}
+
+bool ParameterTableModel::isIntParameter(Source source, const QString &name) const
+{
+    const int row = getRowIndex(source).value(name, -1);
+    return row >= 0 && mRows.at(row).type == Type::Int;
+}
+
+bool ParameterTableModel::isFloatParameter(Source source, const QString &name) const
+{
+    const int row = getRowIndex(source).value(name, -1);
+    return row >= 0 && mRows.at(row).type == Type::Float;
+}
+
+ParameterServer::AllParameters ParameterTableModel::getChangedParameters(Source source) const
+{
+    ParameterServer::AllParameters parameters;
+    if (mChangedRows == 0)
+        return parameters;
+
+    for (const auto& row : mRows) {
+        if (!row.changed || row.source != source)
+            continue;
+        switch (row.type) {
+        case Type::Int: parameters.intParameters.push_back({row.name, row.editedIntValue}); break;
+        case Type::Float: parameters.floatParameters.push_back({row.name, row.editedFloatValue}); break;
+        case Type::Custom: parameters.customParameters.push_back({row.name, row.editedCustomValue}); break;
+        }
+    }
+    return parameters;
+}
+
+void ParameterTableModel::acceptChanges(Source source, const ParameterServer::AllParameters &parameters)
+{
+    // Known values first, rows still edited to other values stay changed
+    updateParameters(source, parameters);
+}
+
+void ParameterTableModel::revertChanges()
+{
+    for (int row = 0; row < mRows.size(); row++)
+        if (mRows.at(row).changed) {
+            setChanged(row, false);
+            emit dataChanged(index(row, NameColumn), index(row, ValueColumn));
+        }
+}
+
+QString ParameterTableModel::floatParameterToString(float value)
+{
+    return QString::number(value, 'f', 6);
+}
+
+int ParameterTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : mFetchedRows;
+}
+
+int ParameterTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant ParameterTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= mFetchedRows)
+        return QVariant();
+
+    const Row &row = mRows.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        if (index.column() == NameColumn)
+            return QString::fromStdString(row.name);
+        return getValueString(row, row.changed);
+    case Qt::ToolTipRole:
+        if (row.changed && index.column() == ValueColumn)
+            return tr("Changed, current value: %1").arg(getValueString(row, false));
+        return (row.source == Source::Vehicle) ? tr("Vehicle parameter") : tr("Control tower parameter");
+    case Qt::FontRole:
+        if (row.changed) {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        return QVariant();
+    case Qt::ForegroundRole:
+        if (row.source == Source::ControlTower && index.column() == NameColumn)
+            return QBrush(Qt::darkBlue);
+        return QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+QVariant ParameterTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return QVariant();
+    if (orientation == Qt::Vertical)
+        return section + 1;
+
+    switch (section) {
+    case NameColumn: return tr("Name");
+    case ValueColumn: return tr("Value");
+    default: return QVariant();
+    }
+}
+
+bool ParameterTableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (role != Qt::EditRole || !index.isValid() || index.column() != ValueColumn || index.row() >= mFetchedRows)
+        return false;
+
+    Row &row = mRows[index.row()];
+    bool ok = true;
+    bool changed = false;
+    switch (row.type) {
+    case Type::Int: {
+        const int32_t editedValue = value.toString().toInt(&ok);
+        if (!ok)
+            return false;
+        row.editedIntValue = editedValue;
+        changed = editedValue != row.intValue;
+    } break;
+    case Type::Float: {
+        const float editedValue = value.toString().toFloat(&ok);
+        if (!ok)
+            return false;
+        row.editedFloatValue = editedValue;
+        changed = editedValue != row.floatValue;
+    } break;
+    case Type::Custom:
+        row.editedCustomValue = value.toString().toStdString();
+        changed = row.editedCustomValue != row.customValue;
+        break;
+    }
+
+    setChanged(index.row(), changed);
+    emit dataChanged(this->index(index.row(), NameColumn), this->index(index.row(), ValueColumn));
+    return true;
+}
+
+Qt::ItemFlags ParameterTableModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    if (index.column() == ValueColumn)
+        return Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsEditable;
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+}
+
+bool ParameterTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && mFetchedRows < mRows.size();
+}
+
+void ParameterTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+        return;
+
+    const int rowsToFetch = std::min(int(mRows.size()) - mFetchedRows, FETCH_BATCH_SIZE);
+    if (rowsToFetch <= 0)
+        return;
+
+    beginInsertRows(QModelIndex(), mFetchedRows, mFetchedRows + rowsToFetch - 1);
+    mFetchedRows += rowsToFetch;
+    endInsertRows();
+}
+
+void ParameterTableModel::rebuildRowIndex()
+{
+    mVehicleRows.clear();
+    mControlTowerRows.clear();
+    for (int row = 0; row < mRows.size(); row++)
+        getRowIndex(mRows.at(row).source).insert(QString::fromStdString(mRows.at(row).name), row);
+}
+
+int ParameterTableModel::findRow(Source source, const std::string &name) const
+{
+    return getRowIndex(source).value(QString::fromStdString(name), -1);
+}
+
+void ParameterTableModel::setChanged(int row, bool changed)
+{
+    if (mRows.at(row).changed == changed)
+        return;
+    mRows[row].changed = changed;
+    mChangedRows += changed ? 1 : -1;
+}
+
+QString ParameterTableModel::getValueString(const Row &row, bool edited) const
+{
+    switch (row.type) {
+    case Type::Int: return QString::number(edited ? row.editedIntValue : row.intValue);
+    case Type::Float: return floatParameterToString(edited ? row.editedFloatValue : row.floatValue);
+    case Type::Custom: return QString::fromStdString(edited ? row.editedCustomValue : row.customValue);
+    }
+    return QString();
+}
+
+void ParameterTableModel::valueChanged(int row)
+{
+    const Row &changedRow = mRows.at(row);
+    // A pending edit is kept unless the parameter now has the edited value
+    if (changedRow.changed) {
+        switch (changedRow.type) {
+        case Type::Int: setChanged(row, changedRow.editedIntValue != changedRow.intValue); break;
+        case Type::Float: setChanged(row, changedRow.editedFloatValue != changedRow.floatValue); break;
+        case Type::Custom: setChanged(row, changedRow.editedCustomValue != changedRow.customValue); break;
+        }
+    }
+
+    if (row < mFetchedRows)
+        emit dataChanged(index(row, NameColumn), index(row, ValueColumn));
+}
@@ -0,0 +1,86 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Table model (name, value) of the vehicle's and the control tower's parameters for VehicleParameterUI.
+ * Rows are handed to the view in batches as it scrolls (fetchMore) and values are only formatted for visible rows.
+ * Edited values are kept next to the known values, i.e., only edited rows are sent (see getChangedParameters) and
+ * parameters updated from elsewhere do not overwrite pending edits.
+ */
+
+#ifndef PARAMETERTABLEMODEL_H
+#define PARAMETERTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
+#include "communication/parameterserver.h"
+
+class ParameterTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum class Source {Vehicle, ControlTower};
+    enum Column {NameColumn, ValueColumn, COLUMN_COUNT};
+    static constexpr int FETCH_BATCH_SIZE = 100;
+
+    explicit ParameterTableModel(QObject *parent = nullptr);
+
+    // Replaces all parameters of source, pending edits of them are discarded
+    void setParameters(Source source, const ParameterServer::AllParameters &parameters);
+    // Known values, e.g., changed on the vehicle. Unknown names are ignored.
+    void updateParameters(Source source, const ParameterServer::AllParameters &parameters);
+    bool containsParameter(Source source, const QString &name) const;
+    bool isIntParameter(Source source, const QString &name) const;
+    bool isFloatParameter(Source source, const QString &name) const;
+
+    bool hasChanges() const { return mChangedRows > 0; }
+    ParameterServer::AllParameters getChangedParameters(Source source) const;
+    // Changes are now the known values, e.g., after they were set successfully
+    void acceptChanges(Source source, const ParameterServer::AllParameters &parameters);
+    void revertChanges();
+
+    static QString floatParameterToString(float value);
+
+    // QAbstractTableModel
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    virtual bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    virtual Qt::ItemFlags flags(const QModelIndex &index) const override;
+    virtual bool canFetchMore(const QModelIndex &parent) const override;
+    virtual void fetchMore(const QModelIndex &parent) override;
+
+private:
+    enum class Type {Int, Float, Custom};
+    struct Row {
+        Source source;
+        Type type;
+        std::string name;
+        // Known and edited value, by type
+        int32_t intValue = 0;
+        float floatValue = 0.0f;
+        std::string customValue;
+        int32_t editedIntValue = 0;
+        float editedFloatValue = 0.0f;
+        std::string editedCustomValue;
+        bool changed = false;
+    };
+
+    void rebuildRowIndex();
+    int findRow(Source source, const std::string &name) const; // -1 if unknown
+    QHash<QString, int> &getRowIndex(Source source) { return (source == Source::Vehicle) ? mVehicleRows : mControlTowerRows; }
+    const QHash<QString, int> &getRowIndex(Source source) const { return (source == Source::Vehicle) ? mVehicleRows : mControlTowerRows; }
+    void setChanged(int row, bool changed);
+    QString getValueString(const Row &row, bool edited) const;
+    void valueChanged(int row);
+
+    QVector<Row> mRows; // vehicle parameters first
+    QHash<QString, int> mVehicleRows;
+    QHash<QString, int> mControlTowerRows;
+    int mFetchedRows = 0; // rows known to the view
+    int mChangedRows = 0;
+};
+
+#endif // PARAMETERTABLEMODEL_H
@@ -0,0 +1,87 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "perfcountersui.h"
+#include "ui_perfcountersui.h"
+
+PerfCountersUI::PerfCountersUI(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::PerfCountersUI)
+{
+    ui->setupUi(this);
+    ui->tableWidget->setColumnCount(NUM_COLUMNS);
+    ui->tableWidget->setHorizontalHeaderLabels({"Name", "Type", "Samples / Value", "Rate [Hz]", "Mean [us]", "p50 [us]", "p99 [us]", "Max [us]"});
+}
+
+PerfCountersUI::~PerfCountersUI()
+{
+    delete ui;
+}
+
+void PerfCountersUI::setCurrentVehicleConnection(const QSharedPointer<VehicleConnection> &currentVehicleConnection)
+{
+    disconnect(mPerfCounterConnection);
+    mCurrentVehicleConnection = qSharedPointerDynamicCast<MavsdkVehicleConnection>(currentVehicleConnection);
+    mPerfCounterRows.clear();
+    ui->tableWidget->setRowCount(0);
+
+    if (mCurrentVehicleConnection.isNull()) {
+        ui->statusLabel->setText(tr("Performance counters are only available for MAVLink vehicles."));
+        return;
+    }
+
+    ui->statusLabel->setText(tr("Vehicle %1").arg(mCurrentVehicleConnection->getVehicleState()->getId()));
+    for (const VehiclePerfCounter &perfCounter : mCurrentVehicleConnection->getPerfCounters())
+        updatePerfCounter(perfCounter.name);
+    mPerfCounterConnection = connect(mCurrentVehicleConnection.get(), &MavsdkVehicleConnection::updatedPerfCounter,
+                                     this, &PerfCountersUI::updatePerfCounter);
+}
+
+void PerfCountersUI::updatePerfCounter(const QString &name)
+{
+    if (mCurrentVehicleConnection.isNull())
+        return;
+
+    const VehiclePerfCounter perfCounter = mCurrentVehicleConnection->getPerfCounter(name);
+    if (perfCounter.name.isEmpty())
+        return;
+
+    if (!mPerfCounterRows.contains(name)) {
+        const int row = ui->tableWidget->rowCount();
+        ui->tableWidget->insertRow(row);
+        for (int column = 0; column < NUM_COLUMNS; column++)
+            ui->tableWidget->setItem(row, column, new QTableWidgetItem());
+        mPerfCounterRows.insert(name, row);
+    }
+    setPerfCounterRow(mPerfCounterRows.value(name), perfCounter);
+}
+
+void PerfCountersUI::setPerfCounterRow(int row, const VehiclePerfCounter &perfCounter)
+{
+    auto setText = [this, row, &perfCounter](int column, int valueIndex) {
+        ui->tableWidget->item(row, column)->setText(valueIndex < perfCounter.values.size() ?
+                                                        QString::number(perfCounter.values.at(valueIndex), 'g', 4) : QString());
+    };
+
+    ui->tableWidget->item(row, NameColumn)->setText(perfCounter.name);
+    switch (perfCounter.type) {
+    case PerfCounterSnapshot::Type::Counter:
+        ui->tableWidget->item(row, TypeColumn)->setText("Counter");
+        setText(ValueColumn, 0);
+        setText(RateColumn, 1);
+        break;
+    case PerfCounterSnapshot::Type::Gauge:
+        ui->tableWidget->item(row, TypeColumn)->setText("Gauge");
+        setText(ValueColumn, 0);
+        break;
+    case PerfCounterSnapshot::Type::Latency:
+        ui->tableWidget->item(row, TypeColumn)->setText("Latency");
+        setText(ValueColumn, 0);
+        setText(MeanColumn, 1);
+        setText(P50Column, 2);
+        setText(P99Column, 3);
+        setText(MaxColumn, 4);
+        break;
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Shows the performance counters a MAVLink vehicle publishes (see PerfCounters), one row per counter updated as they arrive.
+ */
+
+#ifndef PERFCOUNTERSUI_H
+#define PERFCOUNTERSUI_H
+
+#include <QDialog>
+#include <QHash>
+#include "communication/vehicleconnections/mavsdkvehicleconnection.h"
+
+namespace Ui {
+class PerfCountersUI;
+}
+
+class PerfCountersUI : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit PerfCountersUI(QWidget *parent = nullptr);
+    ~PerfCountersUI();
+
+    void setCurrentVehicleConnection(const QSharedPointer<VehicleConnection> &currentVehicleConnection);
+
+private:
+    enum Column {NameColumn, TypeColumn, ValueColumn, RateColumn, MeanColumn, P50Column, P99Column, MaxColumn, NUM_COLUMNS};
+
+    void updatePerfCounter(const QString &name);
+    void setPerfCounterRow(int row, const VehiclePerfCounter &perfCounter);
+
+    Ui::PerfCountersUI *ui;
+    QSharedPointer<MavsdkVehicleConnection> mCurrentVehicleConnection;
+    QHash<QString, int> mPerfCounterRows;
+    QMetaObject::Connection mPerfCounterConnection;
+};
+
+#endif // PERFCOUNTERSUI_H
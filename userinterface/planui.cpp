@@ -4,6 +4,7 @@
  */
 #include "planui.h"
 #include "ui_planui.h"
+#include "vehicles/truckstate.h"
 
 PlanUI::PlanUI(QWidget *parent) :
     QWidget(parent),
@@ -14,7 +15,7 @@ PlanUI::PlanUI(QWidget *parent) :
     mRoutePlanner = QSharedPointer<RoutePlannerModule>::create();
     mRouteGeneratorUI = QSharedPointer<RouteGeneratorUI>::create(this);
     connect(mRouteGeneratorUI.get(), &RouteGeneratorUI::routeDoneForUse, [this](const QList<PosPoint>& route) {
-                if (mRoutePlanner->getCurrentRoute().size() > 0) {
+                if (mRoutePlanner->getRouteSize(mRoutePlanner->getCurrentRouteIndex()) > 0) {
                     mRoutePlanner->addNewRoute();
                     mRoutePlanner->setCurrentRouteIndex(mRoutePlanner->getNumberOfRoutes()-1);
                 }
@@ -25,9 +26,31 @@ PlanUI::PlanUI(QWidget *parent) :
                 ui->currentRouteSpinBox->setSuffix(" / " + QString::number(mRoutePlanner->getNumberOfRoutes()));
     });
 
+    mRoutePreview = QSharedPointer<RoutePreviewModule>::create();
+    connect(mRoutePreview.get(), &RoutePreviewModule::previewFinished, this, &PlanUI::showPreviewResult);
+
     ui->splitButton->setEnabled(false); // disable upon runtime initialisation
     connect(mRoutePlanner.get(), &RoutePlannerModule::requestRepaint, [this]() {
-        ui->splitButton->setEnabled(mRoutePlanner->getCurrentRoute().size() > 1);
+        ui->splitButton->setEnabled(mRoutePlanner->getRouteSize(mRoutePlanner->getCurrentRouteIndex()) > 1);
+    });
+
+    QUndoStack *undoStack = mRoutePlanner->getUndoStack();
+    connect(undoStack, &QUndoStack::canUndoChanged, ui->undoButton, &QPushButton::setEnabled);
+    connect(undoStack, &QUndoStack::canRedoChanged, ui->redoButton, &QPushButton::setEnabled);
+    connect(undoStack, &QUndoStack::undoTextChanged, this, [this](const QString &text) { ui->undoButton->setToolTip(text); });
+    connect(undoStack, &QUndoStack::redoTextChanged, this, [this](const QString &text) { ui->redoButton->setToolTip(text); });
+
+    connect(&mRouteFileImporter, &RouteFileImporter::importedRoutes, this, &PlanUI::addImportedRoutes);
+    connect(&mRouteFileImporter, &RouteFileImporter::progress, this, [this](qint64 bytesRead, qint64 bytesTotal) {
+        if (mImportProgressDialog && bytesTotal > 0)
+            mImportProgressDialog->setValue(int(bytesRead * IMPORT_PROGRESS_STEPS / bytesTotal));
+    });
+    connect(&mRouteFileImporter, &RouteFileImporter::finished, this, [this](bool success, const QString &errorString) {
+        if (mImportProgressDialog)
+            mImportProgressDialog->deleteLater();
+        ui->importRouteButton->setEnabled(true);
+        if (!success && !errorString.isEmpty())
+            QMessageBox::critical(this, "Import Routes", errorString);
     });
 }
 
@@ -69,10 +92,54 @@ void PlanUI::on_currentRouteSpinBox_valueChanged(int value)
 
 void PlanUI::on_sendToAutopilotButton_clicked()
 {
-    if(!mRoutePlanner->getCurrentRoute().isEmpty())
+    if(mRoutePlanner->getRouteSize(mRoutePlanner->getCurrentRouteIndex()) > 0)
         emit routeDoneForUse(mRoutePlanner->getCurrentRoute());
 }
 
+void PlanUI::on_previewButton_clicked()
+{
+    const QList<PosPoint> route = mRoutePlanner->getCurrentRoute();
+    if (route.size() < 2) {
+        mRoutePreview->clear();
+        ui->previewLabel->clear();
+        return;
+    }
+
+    SimulationScenario scenario;
+    scenario.name = "Preview";
+    scenario.route = PosPoint::toPODList(route);
+    scenario.rateLimits = true;
+    scenario.maxDuration_s = 4.0 * 3600.0;
+
+    // Model of the selected vehicle, defaults otherwise
+    const QSharedPointer<CarState> carState = mCurrentVehicleConnection.isNull() ? QSharedPointer<CarState>()
+                                                                                  : mCurrentVehicleConnection->getVehicleState().dynamicCast<CarState>();
+    if (!carState.isNull()) {
+        const QSharedPointer<TruckState> truckState = carState.dynamicCast<TruckState>();
+        scenario.truck = !truckState.isNull();
+        scenario.trailer = scenario.truck && !truckState->getTrailingVehicle().isNull();
+        scenario.length_m = carState->getLength();
+        scenario.width_m = carState->getWidth();
+        scenario.axisDistance_m = carState->getAxisDistance();
+        scenario.maxSteeringAngle_rad = carState->getMaxSteeringAngle();
+    }
+
+    ui->previewLabel->setText("Simulating...");
+    mRoutePreview->startPreview(scenario);
+}
+
+void PlanUI::showPreviewResult(const SimulationResult &result)
+{
+    const int violations = mRoutePreview->getViolations().size();
+    ui->previewLabel->setText(QString("%1: %2 s for %3 m, max. deviation %4 m, max. lateral acceleration %5 m/s², %6 place(s) the vehicle cannot follow")
+                              .arg(result.finished ? "Finished" : "Not finished")
+                              .arg(result.simulatedTime_s, 0, 'f', 1)
+                              .arg(result.drivenDistance_m, 0, 'f', 1)
+                              .arg(result.maxCrossTrackError_m, 0, 'f', 2)
+                              .arg(result.maxLateralAcceleration_ms2, 0, 'f', 2)
+                              .arg(violations));
+}
+
 void PlanUI::on_heightSpinBox_valueChanged(double arg1)
 {
     mRoutePlanner->setNewPointHeight(arg1);
@@ -120,16 +187,13 @@ void PlanUI::xmlStreamWriteEnuRef(QXmlStreamWriter& xmlWriteStream, llh_t enuRef
 
 void PlanUI::on_exportCurrentRouteButton_clicked()
 {
-    QString filename = QFileDialog::getSaveFileName(this, tr("Export Current Route to File"), "", tr("XML Files (*.xml)"));
+    bool binary;
+    QString filename = getRouteExportFilename(tr("Export Current Route to File"), binary);
 
     if (filename.isEmpty()) {
         return;
     }
 
-    if (!filename.toLower().endsWith(".xml")) {
-        filename.append(".xml");
-    }
-
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly)) {
         QMessageBox::critical(this, "Save Routes",
@@ -137,6 +201,12 @@ void PlanUI::on_exportCurrentRouteButton_clicked()
         return;
     }
 
+    if (binary) {
+        file.write(routeCodec::encodeRouteFile({mRoutePlanner->getRoutePOD(mRoutePlanner->getCurrentRouteIndex())}, getRouteGeneratorUI()->getEnuRef()));
+        file.close();
+        return;
+    }
+
     QXmlStreamWriter stream(&file);
     stream.setCodec("UTF-8");
     stream.setAutoFormatting(true);
@@ -156,21 +226,24 @@ void PlanUI::on_exportCurrentRouteButton_clicked()
 
 void PlanUI::on_exportAllRoutesButton_clicked()
 {
-    QString filename = QFileDialog::getSaveFileName(this, tr("Export All Routes to File"), "", tr("XML Files (*.xml)"));
+    bool binary;
+    QString filename = getRouteExportFilename(tr("Export All Routes to File"), binary);
 
     if (filename.isEmpty())
         return;
 
-    if (!filename.toLower().endsWith(".xml")) {
-        filename.append(".xml");
-    }
-
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly)) {
         QMessageBox::critical(this, "Export Routes", "Could not open \"" + filename + "\" for writing.");
         return;
     }
 
+    if (binary) {
+        file.write(routeCodec::encodeRouteFile(mRoutePlanner->getRoutesPOD(), getRouteGeneratorUI()->getEnuRef()));
+        file.close();
+        return;
+    }
+
     QXmlStreamWriter xmlWriteStream(&file);
     xmlWriteStream.setCodec("UTF-8");
     xmlWriteStream.setAutoFormatting(true);
@@ -191,80 +264,45 @@ void PlanUI::on_exportAllRoutesButton_clicked()
 
 void PlanUI::on_importRouteButton_clicked()
 {
-    QString filename = QFileDialog::getOpenFileName(this, tr("Import Routes from File"), "", tr("XML Files (*.xml)"));
+    QString filename = QFileDialog::getOpenFileName(this, tr("Import Routes from File"), "", tr("Route Files (*.xml *.wwr);;XML Files (*.xml);;WayWise Route Files (*.wwr)"));
 
-    if (filename.isEmpty())
+    if (filename.isEmpty() || !mRouteFileImporter.start(filename, getRouteGeneratorUI()->getEnuRef()))
         return;
 
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)) {
-        QMessageBox::critical(this, "Import Routes", "Could not open \"" + filename + "\" for reading.");
-        return;
-    }
+    ui->importRouteButton->setEnabled(false);
+    mImportProgressDialog = new QProgressDialog("Importing routes from \"" + QFileInfo(filename).fileName() + "\"...", "Cancel", 0, IMPORT_PROGRESS_STEPS, this);
+    mImportProgressDialog->setWindowTitle("Import Routes");
+    mImportProgressDialog->setMinimumDuration(500);
+    mImportProgressDialog->setAutoReset(false);
+    connect(mImportProgressDialog, &QProgressDialog::canceled, &mRouteFileImporter, &RouteFileImporter::cancel);
+}
 
-    QXmlStreamReader stream(&file);
+QString PlanUI::getRouteExportFilename(const QString &caption, bool &binary)
+{
+    const QString xmlFilter = tr("XML Files (*.xml)");
+    const QString binaryFilter = tr("WayWise Route Files (*.wwr)");
+    QString selectedFilter;
+    QString filename = QFileDialog::getSaveFileName(this, caption, "", xmlFilter + ";;" + binaryFilter, &selectedFilter);
 
-    if (stream.readNextStartElement())
-    {
-        if (stream.name() == "routes") {
-            llh_t importedEnuRef{0.0, 0.0, 0.0};
-            while(stream.readNextStartElement())
-            {
-                if(stream.name() == "enuref")
-                {
-                    while(stream.readNextStartElement())
-                    {
-                        if (stream.name() == "Latitude")
-                            importedEnuRef.latitude = stream.readElementText().toDouble();
-                        if (stream.name() == "Longitude")
-                            importedEnuRef.longitude = stream.readElementText().toDouble();
-                        if (stream.name() == "Height")
-                            importedEnuRef.height = stream.readElementText().toDouble();
-                    }
-                }
-                if (stream.name() == "route")
-                {
-                    QList<PosPoint> importedRoute;
-                    while(stream.readNextStartElement())
-                    {
-                        if (stream.name() == "point")
-                        {
-                            PosPoint importedPoint;
-
-                            while(stream.readNextStartElement())
-                            {
-                                if (stream.name() == "x")
-                                    importedPoint.setX(stream.readElementText().toDouble());
-                                if (stream.name() == "y")
-                                    importedPoint.setY(stream.readElementText().toDouble());
-                                if (stream.name() == "z")
-                                    importedPoint.setHeight(stream.readElementText().toDouble());
-                                if (stream.name() == "speed")
-                                    importedPoint.setSpeed(stream.readElementText().toDouble());
-                                if (stream.name() == "attributes")
-                                    importedPoint.setAttributes(stream.readElementText().toUInt());
-                            }
-
-                            llh_t importedAbsPoint = coordinateTransforms::enuToLlh(importedEnuRef, {importedPoint.getX(), importedPoint.getY(), importedPoint.getHeight()});
-                            xyz_t importedEnuPoint = coordinateTransforms::llhToEnu(getRouteGeneratorUI()->getEnuRef(), importedAbsPoint);
-
-                            importedPoint.setX(importedEnuPoint.x);
-                            importedPoint.setY(importedEnuPoint.y);
-                            importedPoint.setHeight(importedEnuPoint.z);
-
-                            importedRoute.append(importedPoint);
-                        }
-                    }
-                    if (!importedRoute.isEmpty())
-                    {
-                        if (mRoutePlanner->getCurrentRoute().isEmpty())
-                            mRoutePlanner->appendRouteToCurrentRoute(importedRoute);
-                        else
-                            mRoutePlanner->addRoute(importedRoute);
-                    }
-                }
-            }
-        }
+    if (filename.isEmpty())
+        return filename;
+
+    binary = filename.toLower().endsWith(".wwr") || (selectedFilter == binaryFilter && !filename.toLower().endsWith(".xml"));
+    if (binary && !filename.toLower().endsWith(".wwr"))
+        filename.append(".wwr");
+    else if (!binary && !filename.toLower().endsWith(".xml"))
+        filename.append(".xml");
+
+    return filename;
+}
+
+void PlanUI::addImportedRoutes(const QList<QVector<pospoint_t>> &importedRoutes)
+{
+    for (const auto &importedRoute : importedRoutes) {
+        if (mRoutePlanner->getRoutePOD(mRoutePlanner->getCurrentRouteIndex()).isEmpty())
+            mRoutePlanner->appendRouteToCurrentRoute(importedRoute);
+        else
+            mRoutePlanner->addRoute(importedRoute);
     }
 
     ui->currentRouteSpinBox->setValue(mRoutePlanner->getCurrentRouteIndex() + 1);
@@ -301,7 +339,7 @@ void PlanUI::on_appendButton_clicked()
 
 void PlanUI::on_splitButton_clicked()
 {
-    int size = mRoutePlanner->getCurrentRoute().size();
+    int size = mRoutePlanner->getRouteSize(mRoutePlanner->getCurrentRouteIndex());
     QList<QString> connections;
 
     for(int i = 0; i < (size - 1); i++)
@@ -343,3 +381,21 @@ void PlanUI::on_downloadCurrentRouteFromVehicleButton_clicked()
     }
 }
 
+void PlanUI::on_undoButton_clicked()
+{
+    mRoutePlanner->getUndoStack()->undo();
+    updateCurrentRouteSpinBox();
+}
+
+void PlanUI::on_redoButton_clicked()
+{
+    mRoutePlanner->getUndoStack()->redo();
+    updateCurrentRouteSpinBox();
+}
+
+void PlanUI::updateCurrentRouteSpinBox()
+{
+    ui->currentRouteSpinBox->setMaximum(mRoutePlanner->getNumberOfRoutes());
+    ui->currentRouteSpinBox->setValue(mRoutePlanner->getCurrentRouteIndex() + 1);
+    ui->currentRouteSpinBox->setSuffix(" / " + QString::number(mRoutePlanner->getNumberOfRoutes()));
+}
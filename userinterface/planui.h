@@ -14,9 +14,15 @@
 #include <QMessageBox>
 #include <QXmlStreamWriter>
 #include <QInputDialog>
+#include <QProgressDialog>
+#include <QFileInfo>
+#include <QPointer>
 #include "userinterface/map/routeplannermodule.h"
+#include "userinterface/map/routepreviewmodule.h"
 #include "userinterface/routegeneratorui.h"
 #include "communication/vehicleconnections/vehicleconnection.h"
+#include "core/routecodec.h"
+#include "core/routefileimporter.h"
 
 namespace Ui {
 class PlanUI;
@@ -34,6 +40,7 @@ public:
 
     QSharedPointer<RoutePlannerModule> getRoutePlannerModule() const;
     QSharedPointer<RouteGeneratorUI> getRouteGeneratorUI() const;
+    QSharedPointer<RoutePreviewModule> getRoutePreviewModule() const { return mRoutePreview; }
 
 signals:
     void routeDoneForUse(const QList<PosPoint>& route);
@@ -47,6 +54,8 @@ private slots:
 
     void on_sendToAutopilotButton_clicked();
 
+    void on_previewButton_clicked();
+
     void on_heightSpinBox_valueChanged(double arg1);
 
     void on_speedSpinBox_valueChanged(double arg1);
@@ -71,12 +80,24 @@ private slots:
 
     void on_downloadCurrentRouteFromVehicleButton_clicked();
 
+    void on_undoButton_clicked();
+
+    void on_redoButton_clicked();
+
 private:
     Ui::PlanUI *ui;
     QSharedPointer<RoutePlannerModule> mRoutePlanner;
     QSharedPointer<RouteGeneratorUI> mRouteGeneratorUI;
+    QSharedPointer<RoutePreviewModule> mRoutePreview;
+    void showPreviewResult(const SimulationResult &result);
     void xmlStreamWriteRoute(QXmlStreamWriter &xmlWriteStream, const QList<PosPoint> route);
     void xmlStreamWriteEnuRef(QXmlStreamWriter &xmlWriteStream, const llh_t enuRef);
+    QString getRouteExportFilename(const QString &caption, bool &binary); // XML or binary (routeCodec) route file
+    void addImportedRoutes(const QList<QVector<pospoint_t>> &importedRoutes);
+    void updateCurrentRouteSpinBox();
+    RouteFileImporter mRouteFileImporter; // XML/binary route files, parsed on a worker thread
+    QPointer<QProgressDialog> mImportProgressDialog;
+    static constexpr int IMPORT_PROGRESS_STEPS = 1000;
     QSharedPointer<VehicleConnection> mCurrentVehicleConnection;
 };
 
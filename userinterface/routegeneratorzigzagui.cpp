@@ -4,6 +4,7 @@
  */
 #include "routegeneratorzigzagui.h"
 #include "ui_routegeneratorzigzagui.h"
+#include <QtConcurrent>
 
 RouteGeneratorZigZagUI::RouteGeneratorZigZagUI(QSharedPointer<RoutePlannerModule> routePlannerModule, QWidget *parent) :
     QWidget(parent),
@@ -15,10 +16,23 @@ RouteGeneratorZigZagUI::RouteGeneratorZigZagUI(QSharedPointer<RoutePlannerModule
     ui->boundDoneButton->setEnabled(false);
     ui->page_2->setEnabled(false);
     connect(mRoutePlannerModule.get(), &RoutePlannerModule::requestRepaint, [this](){
-        bool boundReady = mRoutePlannerModule->getRoute(RouteGeneratorUI::boundRouteIndex).size() > 2;
+        bool boundReady = mRoutePlannerModule->getRouteSize(RouteGeneratorUI::boundRouteIndex) > 2;
         ui->boundDoneButton->setEnabled(boundReady);
         ui->page_2->setEnabled(boundReady);
     });
+
+    connect(&mPreviewWatcher, &QFutureWatcher<QList<PosPoint>>::finished, this, [this](){
+        if (!mUpdatePending && !mRouteShown)
+            showRoute(mPreviewWatcher.result());
+        generationFinished();
+    });
+    connect(&mRouteWatcher, &QFutureWatcher<QList<PosPoint>>::finished, this, [this](){
+        if (!mUpdatePending) {
+            showRoute(mRouteWatcher.result());
+            mRouteShown = true;
+        }
+        generationFinished();
+    });
 }
 
 RouteGeneratorZigZagUI::~RouteGeneratorZigZagUI()
@@ -51,25 +65,64 @@ void RouteGeneratorZigZagUI::on_boundDoneButton_clicked()
 
 void RouteGeneratorZigZagUI::updatePreviewRoute()
 {
-    QList<PosPoint> bounds = mRoutePlannerModule->getRoute(RouteGeneratorUI::boundRouteIndex);
-
-    QList<PosPoint> route;
-    if (ui->generateFrameCheckBox->isChecked())
-        route = ZigZagRouteGenerator::fillConvexPolygonWithFramedZigZag(bounds, ui->rowSpacingSpinBox->value(), ui->forceTurnsIntoBoundsCheckBox->isChecked(), ui->speedStraightsSpinBox->value()/3.6,
-                                                              ui->speedTurnsSpinBox->value()/3.6, ui->stepsForTurningSpinBox->value(), ui->visitEverySpinBox->value(),
-                                                              ui->attributeStraightEdit->text().replace(" ", "").toUInt(nullptr, 16), ui->attributeTurnEdit->text().replace(" ", "").toUInt(nullptr, 16),
-                                                              ui->attributeDistanceAfterTurnSpinBox->value()*2, ui->attributeDistanceBeforeTurnSpinBox->value()*2);
-                                                              // attribute changes at half distance
+    if (mPreviewWatcher.isRunning() || mRouteWatcher.isRunning())
+        mUpdatePending = true;
     else
-        route = ZigZagRouteGenerator::fillConvexPolygonWithZigZag(bounds, ui->rowSpacingSpinBox->value(), ui->forceTurnsIntoBoundsCheckBox->isChecked(), ui->speedStraightsSpinBox->value()/3.6,
-                                                                  ui->speedTurnsSpinBox->value()/3.6, ui->stepsForTurningSpinBox->value(), ui->visitEverySpinBox->value(),
-                                                                  ui->attributeStraightEdit->text().replace(" ", "").toUInt(nullptr, 16), ui->attributeTurnEdit->text().replace(" ", "").toUInt(nullptr, 16),
-                                                                  ui->attributeDistanceAfterTurnSpinBox->value()*2, ui->attributeDistanceBeforeTurnSpinBox->value()*2);
+        startGeneration();
+}
+
+void RouteGeneratorZigZagUI::startGeneration()
+{
+    ZigZagParameters parameters;
+    parameters.bounds = mRoutePlannerModule->getRoute(RouteGeneratorUI::boundRouteIndex);
+    parameters.generateFrame = ui->generateFrameCheckBox->isChecked();
+    parameters.spacing = ui->rowSpacingSpinBox->value();
+    parameters.keepTurnsInBounds = ui->forceTurnsIntoBoundsCheckBox->isChecked();
+    parameters.speed = ui->speedStraightsSpinBox->value()/3.6;
+    parameters.speedInTurns = ui->speedTurnsSpinBox->value()/3.6;
+    parameters.turnIntermediateSteps = ui->stepsForTurningSpinBox->value();
+    parameters.visitEveryX = ui->visitEverySpinBox->value();
+    parameters.setAttributesOnStraights = ui->attributeStraightEdit->text().replace(" ", "").toUInt(nullptr, 16);
+    parameters.setAttributesInTurns = ui->attributeTurnEdit->text().replace(" ", "").toUInt(nullptr, 16);
+    // attribute changes at half distance
+    parameters.attributeDistanceAfterTurn = ui->attributeDistanceAfterTurnSpinBox->value()*2;
+    parameters.attributeDistanceBeforeTurn = ui->attributeDistanceBeforeTurnSpinBox->value()*2;
+
+    mUpdatePending = false;
+    mRouteShown = false;
+    // Tasks only work on their copy of the parameters, so they may outlive this widget
+    mRouteWatcher.setFuture(QtConcurrent::run(&RouteGeneratorZigZagUI::generateRoute, parameters));
+    if (parameters.turnIntermediateSteps > 0) {
+        ZigZagParameters previewParameters = parameters;
+        previewParameters.turnIntermediateSteps = 0;
+        mPreviewWatcher.setFuture(QtConcurrent::run(&RouteGeneratorZigZagUI::generateRoute, previewParameters));
+    }
+}
+
+void RouteGeneratorZigZagUI::generationFinished()
+{
+    if (mUpdatePending && !mPreviewWatcher.isRunning() && !mRouteWatcher.isRunning())
+        startGeneration();
+}
 
+void RouteGeneratorZigZagUI::showRoute(const QList<PosPoint> &route)
+{
     mRoutePlannerModule->clearCurrentRoute();
     mRoutePlannerModule->appendRouteToCurrentRoute(route);
 }
 
+QList<PosPoint> RouteGeneratorZigZagUI::generateRoute(const ZigZagParameters &parameters)
+{
+    if (parameters.generateFrame)
+        return ZigZagRouteGenerator::fillConvexPolygonWithFramedZigZag(parameters.bounds, parameters.spacing, parameters.keepTurnsInBounds, parameters.speed, parameters.speedInTurns,
+                                                                       parameters.turnIntermediateSteps, parameters.visitEveryX, parameters.setAttributesOnStraights, parameters.setAttributesInTurns,
+                                                                       parameters.attributeDistanceAfterTurn, parameters.attributeDistanceBeforeTurn);
+    else
+        return ZigZagRouteGenerator::fillConvexPolygonWithZigZag(parameters.bounds, parameters.spacing, parameters.keepTurnsInBounds, parameters.speed, parameters.speedInTurns,
+                                                                 parameters.turnIntermediateSteps, parameters.visitEveryX, parameters.setAttributesOnStraights, parameters.setAttributesInTurns,
+                                                                 parameters.attributeDistanceAfterTurn, parameters.attributeDistanceBeforeTurn);
+}
+
 void RouteGeneratorZigZagUI::on_speedStraightsSpinBox_valueChanged(double arg1)
 {
     Q_UNUSED(arg1)
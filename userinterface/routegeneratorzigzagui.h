@@ -7,6 +7,7 @@
 
 #include <QWidget>
 #include <QSharedPointer>
+#include <QFutureWatcher>
 #include "map/routeplannermodule.h"
 #include "routeplanning/zigzagroutegenerator.h"
 #include "userinterface/routegeneratorui.h"
@@ -53,10 +54,36 @@ private slots:
     void on_generateFrameCheckBox_stateChanged(int arg1);
 
 private:
+    struct ZigZagParameters {
+        QList<PosPoint> bounds;
+        bool generateFrame;
+        double spacing;
+        bool keepTurnsInBounds;
+        double speed;
+        double speedInTurns;
+        int turnIntermediateSteps;
+        int visitEveryX;
+        uint32_t setAttributesOnStraights;
+        uint32_t setAttributesInTurns;
+        double attributeDistanceAfterTurn;
+        double attributeDistanceBeforeTurn;
+    };
+
     Ui::RouteGeneratorZigZagUI *ui;
     QSharedPointer<RoutePlannerModule> mRoutePlannerModule;
 
+    // Routes are generated on the global thread pool, a preview with straight passes (no turns) in parallel to the full route.
+    // Parameter changes during a generation are coalesced, the stale results are dropped and the latest parameters are generated next.
+    QFutureWatcher<QList<PosPoint>> mPreviewWatcher;
+    QFutureWatcher<QList<PosPoint>> mRouteWatcher;
+    bool mUpdatePending = false;
+    bool mRouteShown = false;
+
     void updatePreviewRoute();
+    void startGeneration();
+    void generationFinished();
+    void showRoute(const QList<PosPoint> &route);
+    static QList<PosPoint> generateRoute(const ZigZagParameters &parameters);
 };
 
 #endif // ROUTEGENERATORZIGZAGUI_H
@@ -28,7 +28,9 @@ SerialPortDialog::~SerialPortDialog()
 
 void SerialPortDialog::on_addSerialConnectionButton_clicked()
 {
-    emit selectedSerialPort(ui->serialPortList->currentItem()->data(Qt::UserRole).value<QSerialPortInfo>(), ui->baudrateCombo->currentText().toInt());
+    SerialPortOptions options;
+    options.lowLatency = ui->lowLatencyCheckBox->isChecked();
+    emit selectedSerialPort(ui->serialPortList->currentItem()->data(Qt::UserRole).value<QSerialPortInfo>(), ui->baudrateCombo->currentText().toInt(), options);
     hide();
 }
 
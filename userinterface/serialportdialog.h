@@ -8,6 +8,7 @@
 #include <QDialog>
 #include <QSerialPort>
 #include <QSerialPortInfo>
+#include "core/serialportoptions.h"
 
 namespace Ui {
 class SerialPortDialog;
@@ -22,7 +23,7 @@ public:
     ~SerialPortDialog();
 
 signals:
-    void selectedSerialPort(QSerialPortInfo serialPortInfo, qint32 baudrate);
+    void selectedSerialPort(QSerialPortInfo serialPortInfo, qint32 baudrate, SerialPortOptions options);
 
 private slots:
     void on_cancelButton_clicked();
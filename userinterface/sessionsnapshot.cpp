@@ -0,0 +1,357 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "sessionsnapshot.h"
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// Session snapshot file: FileHeader | SectionEntry... | sections, each starting at a multiple of SECTION_ALIGNMENT
+// MapView:           scale factor | rotation | x offset | y offset | ENU reference latitude | longitude | height (double each)
+// Routes:            sizeof(pospoint_t) | current route index | route count | point count of each route (int32 each) |
+//                    padding to SECTION_ALIGNMENT | points of each route (pospoint_t)...
+// VehicleRoute:      route hash (uint64) | route (routeCodec)
+// VehicleParameters: int, float and custom parameter count (int32 each) | (name length (int32) | name | value)...,
+//                    values: int32, float and length (int32) | string
+// Traces:            see TraceModule::getTraceSnapshot
+
+namespace {
+constexpr char FILE_MAGIC[4] = {'W', 'S', 'S', 'N'};
+constexpr quint32 VERSION = 1;
+constexpr quint32 BYTE_ORDER_MARK = 0x01020304; // sections are in native byte order
+constexpr qint64 SECTION_ALIGNMENT = 8;
+
+struct FileHeader {
+    char magic[4];
+    quint32 version;
+    quint32 byteOrderMark;
+    quint32 sectionCount;
+};
+
+struct SectionEntry {
+    quint32 tag;
+    qint32 id;
+    quint64 offset;
+    quint64 size;
+};
+
+qint64 alignSection(qint64 offset)
+{
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+template<typename T>
+void appendRaw(QByteArray &data, const T *values, int count)
+{
+    data.append(reinterpret_cast<const char*>(values), count * int(sizeof(T)));
+}
+
+template<typename T>
+void appendValue(QByteArray &data, const T &value)
+{
+    appendRaw(data, &value, 1);
+}
+
+void appendString(QByteArray &data, const std::string &string)
+{
+    appendValue(data, qint32(string.size()));
+    data.append(string.data(), int(string.size()));
+}
+
+template<typename T>
+bool readRaw(const char *&data, const char *end, T *values, int count)
+{
+    const qint64 size = qint64(count) * qint64(sizeof(T));
+    if (count < 0 || end - data < size)
+        return false;
+    memcpy(static_cast<void*>(values), data, size);
+    data += size;
+    return true;
+}
+
+bool readString(const char *&data, const char *end, std::string &string)
+{
+    qint32 length;
+    if (!readRaw(data, end, &length, 1) || length < 0 || end - data < length)
+        return false;
+    string.assign(data, length);
+    data += length;
+    return true;
+}
+}
+
+void SessionSnapshot::captureMapView(MapWidget &mapWidget)
+{
+    const llh_t enuRef = mapWidget.getEnuRef();
+    const double mapView[] = {mapWidget.getScaleFactor(), mapWidget.getRotation(), mapWidget.getXOffset(), mapWidget.getYOffset(),
+                              enuRef.latitude, enuRef.longitude, enuRef.height};
+    QByteArray data;
+    appendRaw(data, mapView, 7);
+    setSection(SectionTag::MapView, 0, data);
+}
+
+void SessionSnapshot::captureRoutes(RoutePlannerModule &routePlanner)
+{
+    const QList<QVector<pospoint_t>> routes = routePlanner.getRoutesPOD();
+    QByteArray data;
+    appendValue(data, qint32(sizeof(pospoint_t)));
+    appendValue(data, qint32(routePlanner.getCurrentRouteIndex()));
+    appendValue(data, qint32(routes.size()));
+    for (const QVector<pospoint_t> &route : routes)
+        appendValue(data, qint32(route.size()));
+    data.append(QByteArray(int(alignSection(data.size()) - data.size()), '\0'));
+    for (const QVector<pospoint_t> &route : routes)
+        appendRaw(data, route.constData(), route.size());
+    setSection(SectionTag::Routes, 0, data);
+}
+
+void SessionSnapshot::captureTraces(TraceModule &traceModule)
+{
+    setSection(SectionTag::Traces, 0, traceModule.getTraceSnapshot());
+}
+
+void SessionSnapshot::captureVehicle(VehicleConnection &vehicleConnection, const ParameterServer::AllParameters &parameters)
+{
+    const qint32 vehicleId = vehicleConnection.getVehicleState()->getId();
+    if (vehicleConnection.getCachedCurrentRouteHash() != 0) {
+        QByteArray data;
+        appendValue(data, vehicleConnection.getCachedCurrentRouteHash());
+        data.append(vehicleConnection.getCachedCurrentRoute());
+        setSection(SectionTag::VehicleRoute, vehicleId, data);
+    } else {
+        mSections.erase(std::remove_if(mSections.begin(), mSections.end(), [vehicleId](const Section &section) {
+            return section.tag == SectionTag::VehicleRoute && section.id == vehicleId;
+        }), mSections.end());
+    }
+
+    QByteArray data;
+    appendValue(data, qint32(parameters.intParameters.size()));
+    appendValue(data, qint32(parameters.floatParameters.size()));
+    appendValue(data, qint32(parameters.customParameters.size()));
+    for (const ParameterServer::IntParameter &parameter : parameters.intParameters) {
+        appendString(data, parameter.name);
+        appendValue(data, qint32(parameter.value));
+    }
+    for (const ParameterServer::FloatParameter &parameter : parameters.floatParameters) {
+        appendString(data, parameter.name);
+        appendValue(data, parameter.value);
+    }
+    for (const ParameterServer::CustomParameter &parameter : parameters.customParameters) {
+        appendString(data, parameter.name);
+        appendString(data, parameter.value);
+    }
+    setSection(SectionTag::VehicleParameters, vehicleId, data);
+}
+
+bool SessionSnapshot::save(const QString &filename, QString &errorString) const
+{
+    FileHeader header;
+    memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.sectionCount = mSections.size();
+
+    QByteArray index;
+    appendValue(index, header);
+    qint64 offset = alignSection(sizeof(FileHeader) + mSections.size() * sizeof(SectionEntry));
+    for (const Section &section : mSections) {
+        const SectionEntry entry {quint32(section.tag), section.id, quint64(offset), quint64(section.data.size())};
+        appendValue(index, entry);
+        offset = alignSection(offset + section.data.size());
+    }
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        errorString = "Could not open \"" + filename + "\" for writing: " + file.errorString();
+        return false;
+    }
+
+    const char padding[SECTION_ALIGNMENT] = {};
+    bool written = file.write(index) == index.size();
+    qint64 position = index.size();
+    for (const Section &section : mSections) {
+        const qint64 paddingSize = alignSection(position) - position;
+        written = written && file.write(padding, paddingSize) == paddingSize && file.write(section.data) == section.data.size();
+        position += paddingSize + section.data.size();
+    }
+    if (!written || !file.commit()) {
+        errorString = "Could not write \"" + filename + "\": " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool SessionSnapshot::load(const QString &filename, QString &errorString)
+{
+    mSections.clear();
+    mFile.close(); // unmaps the previous file
+
+    mFile.setFileName(filename);
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        errorString = "Could not open \"" + filename + "\": " + mFile.errorString();
+        return false;
+    }
+
+    const qint64 size = mFile.size();
+    const uchar *data = (size >= qint64(sizeof(FileHeader))) ? mFile.map(0, size) : nullptr;
+    FileHeader header;
+    if (data)
+        memcpy(&header, data, sizeof(header));
+    if (!data || memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != VERSION ||
+            header.byteOrderMark != BYTE_ORDER_MARK) {
+        errorString = "\"" + filename + "\" is not a session snapshot of a supported version.";
+        mFile.close();
+        return false;
+    }
+
+    QVector<Section> sections;
+    bool valid = quint64(header.sectionCount) <= (quint64(size) - sizeof(FileHeader)) / sizeof(SectionEntry);
+    for (quint32 i = 0; valid && i < header.sectionCount; i++) {
+        SectionEntry entry;
+        memcpy(&entry, data + sizeof(FileHeader) + i * sizeof(SectionEntry), sizeof(entry));
+        valid = entry.offset <= quint64(size) && entry.size <= quint64(size) - entry.offset && entry.size <= quint64(std::numeric_limits<int>::max());
+        if (valid)
+            sections.append({SectionTag(entry.tag), entry.id, QByteArray::fromRawData(reinterpret_cast<const char*>(data + entry.offset), int(entry.size))});
+    }
+    if (!valid) {
+        errorString = "\"" + filename + "\" is malformed.";
+        mFile.close();
+        return false;
+    }
+
+    mSections = sections;
+    return true;
+}
+
+bool SessionSnapshot::restoreMapView(MapWidget &mapWidget) const
+{
+    double mapView[7];
+    const QByteArray *data = getSection(SectionTag::MapView);
+    if (!data || data->size() != int(sizeof(mapView)))
+        return false;
+
+    memcpy(mapView, data->constData(), sizeof(mapView));
+    mapWidget.setEnuRef({mapView[4], mapView[5], mapView[6]});
+    mapWidget.setScaleFactor(mapView[0]);
+    mapWidget.setRotation(mapView[1]);
+    mapWidget.setXOffset(mapView[2]);
+    mapWidget.setYOffset(mapView[3]);
+    return true;
+}
+
+bool SessionSnapshot::restoreRoutes(RoutePlannerModule &routePlanner) const
+{
+    const QByteArray *data = getSection(SectionTag::Routes);
+    if (!data)
+        return false;
+
+    const char *pos = data->constData();
+    const char *end = pos + data->size();
+    qint32 header[3]; // point size, current route index, route count
+    if (!readRaw(pos, end, header, 3) || header[0] != qint32(sizeof(pospoint_t)) || header[2] < 0 || header[2] > (end - pos) / qint64(sizeof(qint32)))
+        return false;
+
+    QVector<qint32> pointCounts(header[2]);
+    if (!readRaw(pos, end, pointCounts.data(), pointCounts.size()))
+        return false;
+    pos = data->constData() + alignSection(pos - data->constData());
+
+    QList<QVector<pospoint_t>> routes;
+    routes.reserve(pointCounts.size());
+    for (const qint32 pointCount : pointCounts) {
+        if (pointCount < 0 || pointCount > (end - pos) / qint64(sizeof(pospoint_t)))
+            return false;
+        QVector<pospoint_t> route(pointCount);
+        readRaw(pos, end, route.data(), pointCount);
+        routes.append(route);
+    }
+    if (pos != end)
+        return false;
+
+    routePlanner.setRoutesPOD(routes);
+    routePlanner.setCurrentRouteIndex(header[1]);
+    return true;
+}
+
+bool SessionSnapshot::restoreTraces(TraceModule &traceModule) const
+{
+    const QByteArray *data = getSection(SectionTag::Traces);
+    return data && traceModule.restoreTraceSnapshot(*data);
+}
+
+bool SessionSnapshot::restoreVehicle(VehicleConnection &vehicleConnection) const
+{
+    quint64 routeHash;
+    const QByteArray *data = getSection(SectionTag::VehicleRoute, vehicleConnection.getVehicleState()->getId());
+    if (!data || data->size() < int(sizeof(routeHash)))
+        return false;
+
+    memcpy(&routeHash, data->constData(), sizeof(routeHash));
+    // Copied, the connection keeps it beyond the mapping
+    vehicleConnection.setCachedCurrentRoute(QByteArray(data->constData() + sizeof(routeHash), data->size() - int(sizeof(routeHash))), routeHash);
+    return true;
+}
+
+bool SessionSnapshot::getVehicleParameters(int vehicleId, ParameterServer::AllParameters &parameters) const
+{
+    const QByteArray *data = getSection(SectionTag::VehicleParameters, vehicleId);
+    if (!data)
+        return false;
+
+    const char *pos = data->constData();
+    const char *end = pos + data->size();
+    qint32 counts[3];
+    if (!readRaw(pos, end, counts, 3) || counts[0] < 0 || counts[1] < 0 || counts[2] < 0)
+        return false;
+
+    // At least a name length per parameter
+    ParameterServer::AllParameters readParameters;
+    if (qint64(counts[0]) + counts[1] + counts[2] > (end - pos) / qint64(sizeof(qint32)))
+        return false;
+    readParameters.intParameters.resize(counts[0]);
+    readParameters.floatParameters.resize(counts[1]);
+    readParameters.customParameters.resize(counts[2]);
+    bool valid = true;
+    for (ParameterServer::IntParameter &parameter : readParameters.intParameters)
+        valid = valid && readString(pos, end, parameter.name) && readRaw(pos, end, &parameter.value, 1);
+    for (ParameterServer::FloatParameter &parameter : readParameters.floatParameters)
+        valid = valid && readString(pos, end, parameter.name) && readRaw(pos, end, &parameter.value, 1);
+    for (ParameterServer::CustomParameter &parameter : readParameters.customParameters)
+        valid = valid && readString(pos, end, parameter.name) && readString(pos, end, parameter.value);
+    if (!valid || pos != end)
+        return false;
+
+    parameters = readParameters;
+    return true;
+}
+
+QVector<int> SessionSnapshot::getVehicleIds() const
+{
+    QVector<int> vehicleIds;
+    for (const Section &section : mSections)
+        if ((section.tag == SectionTag::VehicleRoute || section.tag == SectionTag::VehicleParameters) && !vehicleIds.contains(section.id))
+            vehicleIds.append(section.id);
+    std::sort(vehicleIds.begin(), vehicleIds.end());
+    return vehicleIds;
+}
+
+void SessionSnapshot::setSection(SectionTag tag, qint32 id, const QByteArray &data)
+{
+    for (Section &section : mSections) {
+        if (section.tag == tag && section.id == id) {
+            section.data = data;
+            return;
+        }
+    }
+    mSections.append({tag, id, data});
+}
+
+const QByteArray *SessionSnapshot::getSection(SectionTag tag, qint32 id) const
+{
+    for (const Section &section : mSections)
+        if (section.tag == tag && section.id == id)
+            return &section.data;
+    return nullptr;
+}
@@ -0,0 +1,81 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Snapshot of a control station session to restart without re-importing routes, re-creating traces and re-downloading from
+ * vehicles: map view and ENU reference (MapWidget), planned routes (RoutePlannerModule), traces (TraceModule) and, per vehicle,
+ * its parameters and the route last downloaded from it with its hash (VehicleConnection::getCachedCurrentRoute).
+ * The file is a table of sections holding plain arrays. Loading maps it (QFile::map) without reading or decoding it, restoring
+ * copies the arrays from the mapping, i.e., also large sessions restore in milliseconds. Sections are written in native byte order.
+ * Restore the map view first: routes and traces are stored in the ENU frame of the snapshot.
+ *
+ *     SessionSnapshot snapshot;
+ *     if (snapshot.load(filename, errorString)) {
+ *         snapshot.restoreMapView(*mapWidget);
+ *         snapshot.restoreRoutes(*planUI->getRoutePlannerModule());
+ *         ...
+ *     }
+ *     // when a vehicle connects, requestCurrentRouteFromVehicle() then only downloads its route if it changed
+ *     snapshot.restoreVehicle(*vehicleConnection);
+ */
+
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QVector>
+#include "userinterface/map/mapwidget.h"
+#include "userinterface/map/routeplannermodule.h"
+#include "userinterface/map/tracemodule.h"
+#include "communication/vehicleconnections/vehicleconnection.h"
+#include "communication/parameterserver.h"
+
+class SessionSnapshot
+{
+public:
+    SessionSnapshot() = default;
+    SessionSnapshot(const SessionSnapshot &) = delete;
+    SessionSnapshot &operator=(const SessionSnapshot &) = delete;
+
+    // Captures replace the corresponding part of the snapshot (also of a loaded one)
+    void captureMapView(MapWidget &mapWidget);
+    void captureRoutes(RoutePlannerModule &routePlanner);
+    void captureTraces(TraceModule &traceModule);
+    // Parameters as last fetched, e.g., by VehicleParameterUI. The vehicle's cached route is captured if it has one.
+    void captureVehicle(VehicleConnection &vehicleConnection, const ParameterServer::AllParameters &parameters = {});
+
+    // Return false (and a user readable errorString) on failure. Loading keeps the file mapped until the next load() or destruction.
+    bool save(const QString &filename, QString &errorString) const;
+    bool load(const QString &filename, QString &errorString);
+
+    // Return false if the snapshot has no (valid) data for it
+    bool restoreMapView(MapWidget &mapWidget) const;
+    bool restoreRoutes(RoutePlannerModule &routePlanner) const; // replaces all routes, clears the undo stack
+    bool restoreTraces(TraceModule &traceModule) const; // replaces all traces
+    bool restoreVehicle(VehicleConnection &vehicleConnection) const; // cached route
+    bool getVehicleParameters(int vehicleId, ParameterServer::AllParameters &parameters) const;
+    QVector<int> getVehicleIds() const;
+
+private:
+    enum class SectionTag : quint32 {
+        MapView = 1,
+        Routes = 2,
+        Traces = 3,
+        VehicleRoute = 4, // id: vehicle ID
+        VehicleParameters = 5, // id: vehicle ID
+    };
+    struct Section {
+        SectionTag tag;
+        qint32 id;
+        QByteArray data; // refers to the mapping of the loaded file or is owned
+    };
+
+    void setSection(SectionTag tag, qint32 id, const QByteArray &data);
+    const QByteArray *getSection(SectionTag tag, qint32 id = 0) const;
+
+    QFile mFile; // mapped while loaded
+    QVector<Section> mSections;
+};
+
+#endif // SESSIONSNAPSHOT_H
@@ -4,6 +4,8 @@
  */
 #include "traceui.h"
 #include "ui_traceui.h"
+#include <QFileDialog>
+#include <QMessageBox>
 
 TraceUI::TraceUI(QWidget *parent) :
     QWidget(parent),
@@ -28,6 +30,11 @@ QSharedPointer<TraceModule> TraceUI::getTraceModule() const
     return mTracemodule;
 }
 
+void TraceUI::setReferenceRoute(const QList<PosPoint> &referenceRoute)
+{
+    mTracemodule->setReferenceRoute(PosPoint::toPODList(referenceRoute));
+}
+
 
 void TraceUI::on_startTraceButton_clicked()
 {
@@ -43,3 +50,45 @@ void TraceUI::on_clearTraceButton_clicked()
 {
     mTracemodule->clearTraceIndex(mTracemodule->getCurrentTraceIndex());
 }
+
+void TraceUI::on_colorByCrossTrackErrorCheckBox_toggled(bool checked)
+{
+    mTracemodule->setColorByCrossTrackError(checked);
+}
+
+void TraceUI::on_saveTraceSessionButton_clicked()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save Trace Session"), "", tr("WayWise Trace Sessions (*.wwt)"));
+    if (filename.isEmpty())
+        return;
+    if (!filename.endsWith(".wwt", Qt::CaseInsensitive))
+        filename.append(".wwt");
+
+    QString errorString;
+    if (!mTracemodule->saveTraceSession(filename, errorString))
+        QMessageBox::critical(this, "Save Trace Session", errorString);
+}
+
+void TraceUI::on_loadTraceSessionButton_clicked()
+{
+    const QString filename = QFileDialog::getOpenFileName(this, tr("Load Trace Session"), "", tr("WayWise Trace Sessions (*.wwt)"));
+    if (filename.isEmpty())
+        return;
+
+    QString errorString;
+    if (!mTracemodule->loadTraceSession(filename, errorString))
+        QMessageBox::critical(this, "Load Trace Session", errorString);
+}
+
+void TraceUI::on_exportTracesCsvButton_clicked()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Export Traces to CSV"), "", tr("CSV Files (*.csv)"));
+    if (filename.isEmpty())
+        return;
+    if (!filename.endsWith(".csv", Qt::CaseInsensitive))
+        filename.append(".csv");
+
+    QString errorString;
+    if (!mTracemodule->exportTracesToCsv(filename, errorString))
+        QMessageBox::critical(this, "Export Traces", errorString);
+}
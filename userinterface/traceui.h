@@ -28,6 +28,8 @@ public:
     void setCurrentTraceVehicle(QSharedPointer<VehicleState> vehicle);
 
     QSharedPointer<TraceModule> getTraceModule() const;
+    // Route the cross-track error of traced points refers to, e.g., the route sent to the vehicle
+    void setReferenceRoute(const QList<PosPoint> &referenceRoute);
 
 private slots:
     void on_startTraceButton_clicked();
@@ -36,6 +38,14 @@ private slots:
 
     void on_clearTraceButton_clicked();
 
+    void on_colorByCrossTrackErrorCheckBox_toggled(bool checked);
+
+    void on_saveTraceSessionButton_clicked();
+
+    void on_loadTraceSessionButton_clicked();
+
+    void on_exportTracesCsvButton_clicked();
+
 private:
     Ui::TraceUI *ui;
     QSharedPointer<TraceModule> mTracemodule;
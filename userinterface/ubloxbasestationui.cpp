@@ -103,6 +103,11 @@ UbloxBasestationUI::UbloxBasestationUI(QWidget *parent) :
         ui->surveyInStatusTextEdit->setPlainText(txt);
     });
 
+    connect(mUbloxBasestation.get(), &UbloxBasestation::configurationFinished, this, [this](bool succeeded) {
+        if (!succeeded && mUbloxBasestation->isSerialConnected())
+            QMessageBox::warning(this, "u-blox Basestation", "The receiver did not acknowledge all configuration steps.");
+    });
+
     connect(mUbloxBasestation.get(), &UbloxBasestation::rtcmData, [this](const QByteArray& data, const int& type) {
         mRtcmSentMap[type]++;
         emit rtcmData(data, type);
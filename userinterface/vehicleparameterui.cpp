@@ -2,16 +2,19 @@
  *     Copyright 2023 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
-#include <iomanip>
-#include <sstream>
 #include "vehicleparameterui.h"
 #include "ui_vehicleparameterui.h"
+#include <QPointer>
 
 VehicleParameterUI::VehicleParameterUI(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::VehicleParameterUI)
 {
     ui->setupUi(this);
+    ui->tableView->setModel(&mParameterTableModel);
+
+    if (ParameterServer::getInstance())
+        connect(ParameterServer::getInstance(), &ParameterServer::parametersChanged, this, &VehicleParameterUI::updateChangedControlTowerParameters);
 }
 
 VehicleParameterUI::~VehicleParameterUI()
@@ -21,14 +24,28 @@ VehicleParameterUI::~VehicleParameterUI()
 
 void VehicleParameterUI::setCurrentVehicleConnection(const QSharedPointer<VehicleConnection> &currentVehicleConnection)
 {
+    disconnect(mVehicleParametersChangedConnection);
     mCurrentVehicleConnection = currentVehicleConnection;
+    if (mCurrentVehicleConnection)
+        mVehicleParametersChangedConnection = connect(mCurrentVehicleConnection.get(), &VehicleConnection::updatedParametersOnVehicle,
+                                                      this, &VehicleParameterUI::updateChangedVehicleParameters);
 }
 
 void VehicleParameterUI::on_getAllParametersFromVehicleButton_clicked()
 {
     if (mCurrentVehicleConnection) {
-        mVehicleParameters = mCurrentVehicleConnection->getAllParametersFromVehicle();
-        populateTableWithParameters();
+        ui->getAllParametersFromVehicleButton->setEnabled(false);
+        QPointer<VehicleParameterUI> self(this);
+        const QSharedPointer<VehicleConnection> vehicleConnection = mCurrentVehicleConnection;
+        mCurrentVehicleConnection->getAllParametersFromVehicleAsync([self, vehicleConnection](const ParameterServer::AllParameters &parameters) {
+            if (!self)
+                return;
+            self->ui->getAllParametersFromVehicleButton->setEnabled(true);
+            if (self->mCurrentVehicleConnection != vehicleConnection) // switched vehicle in the meantime
+                return;
+            self->mParameterTableModel.setParameters(ParameterTableModel::Source::Vehicle, parameters);
+            self->populateTableWithParameters();
+        });
     }
 }
 
@@ -36,67 +53,21 @@ void VehicleParameterUI::populateTableWithParameters()
 {
     ui->setNewParameterOnVehicleStatus->clear();
 
-    if (ParameterServer::getInstance())
-        mControlTowerParameters = ParameterServer::getInstance()->getAllParameters();
-
-    int row = 0;
-    int column = 0;
-
-    ui->tableWidget->setRowCount(mVehicleParameters.floatParameters.size()+mVehicleParameters.intParameters.size()+mVehicleParameters.customParameters.size()+
-        mControlTowerParameters.floatParameters.size()+mControlTowerParameters.intParameters.size());
-
-    for (const auto& vehicleIntParameter : mVehicleParameters.intParameters) {
-        std::string value = std::to_string(vehicleIntParameter.value);
-        QTableWidgetItem *newItemName = new QTableWidgetItem(tr(vehicleIntParameter.name.c_str()));
-        ui->tableWidget->setItem(row, column, newItemName);
-        QTableWidgetItem *newItemValue = new QTableWidgetItem(tr(value.c_str()));
-        ui->tableWidget->setItem(row, column+1, newItemValue);
-        row++;
-    }
-
-    for (const auto& vehicleFloatParameter : mVehicleParameters.floatParameters) {
-        std::stringstream stream;
-        stream << std::fixed << std::setprecision(6) << vehicleFloatParameter.value;
-        std::string value = stream.str();
-        QTableWidgetItem *newItemName = new QTableWidgetItem(tr(vehicleFloatParameter.name.c_str()));
-        ui->tableWidget->setItem(row, column, newItemName);
-        QTableWidgetItem *newItemValue = new QTableWidgetItem(tr(value.c_str()));
-        ui->tableWidget->setItem(row, column+1, newItemValue);
-        row++;
-    }
-
-    for (const auto& vehicleCustomParameter : mVehicleParameters.customParameters) {
-        QTableWidgetItem *newItemName = new QTableWidgetItem(tr(vehicleCustomParameter.name.c_str()));
-        ui->tableWidget->setItem(row, column, newItemName);
-        QTableWidgetItem *newItemValue = new QTableWidgetItem(tr(vehicleCustomParameter.value.c_str()));
-        ui->tableWidget->setItem(row, column+1, newItemValue);
-        row++;
-    }
-
-    for (const auto& ControlTowerIntParameter : mControlTowerParameters.intParameters) {
-        std::string value = std::to_string(ControlTowerIntParameter.value);
-        QTableWidgetItem *newItemName = new QTableWidgetItem(tr(ControlTowerIntParameter.name.c_str()));
-        ui->tableWidget->setItem(row, column, newItemName);
-        QTableWidgetItem *newItemValue = new QTableWidgetItem(tr(value.c_str()));
-        ui->tableWidget->setItem(row, column+1, newItemValue);
-        row++;
-    }
-
-    for (const auto& ControlTowerFloatParameter : mControlTowerParameters.floatParameters) {
-        std::stringstream stream;
-        stream << std::fixed << std::setprecision(6) << ControlTowerFloatParameter.value;
-        std::string value = stream.str();
-        QTableWidgetItem *newItemName = new QTableWidgetItem(tr(ControlTowerFloatParameter.name.c_str()));
-        ui->tableWidget->setItem(row, column, newItemName);
-        QTableWidgetItem *newItemValue = new QTableWidgetItem(tr(value.c_str()));
-        ui->tableWidget->setItem(row, column+1, newItemValue);
-        row++;
+    if (ParameterServer::getInstance()) {
+        mControlTowerParametersVersion = ParameterServer::getInstance()->getVersion();
+        mParameterTableModel.setParameters(ParameterTableModel::Source::ControlTower, ParameterServer::getInstance()->getAllParameters());
+        mHasControlTowerParameters = true;
     }
 }
 
 void VehicleParameterUI::on_setNewParametersOnVehicleButton_clicked()
 {
-    if (updateChangedParameters()) {
+    updateChangedParameters();
+}
+
+void VehicleParameterUI::showUpdateStatus(bool success)
+{
+    if (success) {
         ui->setNewParameterOnVehicleStatus->setStyleSheet("QLabel {color : green; }");
         ui->setNewParameterOnVehicleStatus->setText("Vehicle parameters successfully updated!");
     } else {
@@ -105,69 +76,89 @@ void VehicleParameterUI::on_setNewParametersOnVehicleButton_clicked()
     }
 }
 
-bool VehicleParameterUI::updateChangedParameters()
+void VehicleParameterUI::updateChangedParameters()
 {
     if (mCurrentVehicleConnection) {
-        int row = 0;
-        int column = 1;
-        bool hasParamChanged = false;
-
-        for (auto& vehicleIntParameter : mVehicleParameters.intParameters) {
-            int32_t tableWidgetParameterValue = ui->tableWidget->item(row, column)->text().toInt();
-            if (tableWidgetParameterValue != vehicleIntParameter.value) {
-                hasParamChanged = true;
-                if (mCurrentVehicleConnection->setIntParameterOnVehicle(vehicleIntParameter.name.c_str(), tableWidgetParameterValue) != VehicleConnection::Result::Success)
-                    return false;
-                vehicleIntParameter.value = tableWidgetParameterValue;
-            }
-            row++;
-        }
+        const ParameterServer::AllParameters changedVehicleParameters = mParameterTableModel.getChangedParameters(ParameterTableModel::Source::Vehicle);
+        const ParameterServer::AllParameters changedControlTowerParameters = mParameterTableModel.getChangedParameters(ParameterTableModel::Source::ControlTower);
 
-        for (auto& vehicleFloatParameter : mVehicleParameters.floatParameters) {
-            float tableWidgetParameterValue = ui->tableWidget->item(row, column)->text().toFloat();
-            if (tableWidgetParameterValue != vehicleFloatParameter.value) {
-                hasParamChanged = true;
-                if (mCurrentVehicleConnection->setFloatParameterOnVehicle(vehicleFloatParameter.name.c_str(), tableWidgetParameterValue) != VehicleConnection::Result::Success)
-                    return false;
-                vehicleFloatParameter.value = tableWidgetParameterValue;
-            }
-            row++;
-        }
+        const bool hasVehicleParamChanged = !changedVehicleParameters.intParameters.empty() || !changedVehicleParameters.floatParameters.empty() ||
+                !changedVehicleParameters.customParameters.empty();
+        const bool hasControlTowerParamChanged = !changedControlTowerParameters.intParameters.empty() || !changedControlTowerParameters.floatParameters.empty();
 
-        for (auto& vehicleCustomParameter : mVehicleParameters.customParameters) {
-            std::string tableWidgetParameterValue = ui->tableWidget->item(row, column)->text().toStdString();
-            if (tableWidgetParameterValue != vehicleCustomParameter.value) {
-                hasParamChanged = true;
-                if (mCurrentVehicleConnection->setCustomParameterOnVehicle(vehicleCustomParameter.name.c_str(), tableWidgetParameterValue) != VehicleConnection::Result::Success)
-                    return false;
-                vehicleCustomParameter.value = tableWidgetParameterValue;
-            }
-            row++;
+        if (!hasVehicleParamChanged && !hasControlTowerParamChanged) {
+            showUpdateStatus(false);
+            return;
         }
 
-        for (auto& ControlTowerIntParameter : mControlTowerParameters.intParameters) {
-            float tableWidgetParameterValue = ui->tableWidget->item(row, column)->text().toInt();
-            if (tableWidgetParameterValue != ControlTowerIntParameter.value) {
-                hasParamChanged = true;
-                if (!ParameterServer::getInstance()->updateIntParameter(ControlTowerIntParameter.name, tableWidgetParameterValue))
-                    return false;
-                ControlTowerIntParameter.value = tableWidgetParameterValue;
-            }
-            row++;
+        // Applied as one transaction, the model is updated through parametersChanged
+        if (hasControlTowerParamChanged && !ParameterServer::getInstance()->updateParameters(changedControlTowerParameters)) {
+            showUpdateStatus(false);
+            return;
         }
 
-        for (auto& ControlTowerFloatParameter : mControlTowerParameters.floatParameters) {
-            float tableWidgetParameterValue = ui->tableWidget->item(row, column)->text().toFloat();
-            if (tableWidgetParameterValue != ControlTowerFloatParameter.value) {
-                hasParamChanged = true;
-                if (!ParameterServer::getInstance()->updateFloatParameter(ControlTowerFloatParameter.name, tableWidgetParameterValue))
-                    return false;
-                ControlTowerFloatParameter.value = tableWidgetParameterValue;
-            }
-            row++;
+        if (!hasVehicleParamChanged) {
+            showUpdateStatus(true);
+            return;
         }
 
-        return hasParamChanged;
+        ui->setNewParametersOnVehicleButton->setEnabled(false);
+        ui->setNewParameterOnVehicleStatus->setStyleSheet("");
+        ui->setNewParameterOnVehicleStatus->setText("Updating vehicle parameters...");
+        QPointer<VehicleParameterUI> self(this);
+        const QSharedPointer<VehicleConnection> vehicleConnection = mCurrentVehicleConnection;
+        mCurrentVehicleConnection->setParametersOnVehicleAsync(changedVehicleParameters, [self, vehicleConnection, changedVehicleParameters](VehicleConnection::Result result) {
+            if (!self)
+                return;
+            self->ui->setNewParametersOnVehicleButton->setEnabled(true);
+            if (self->mCurrentVehicleConnection != vehicleConnection)
+                return;
+
+            if (result != VehicleConnection::Result::Success) {
+                self->showUpdateStatus(false);
+                return;
+            }
+            self->mParameterTableModel.acceptChanges(ParameterTableModel::Source::Vehicle, changedVehicleParameters);
+            self->showUpdateStatus(true);
+        });
     } else
-        return false;
+        showUpdateStatus(false);
+}
+
+void VehicleParameterUI::updateChangedVehicleParameters(const QStringList &parameterNames)
+{
+    if (!mCurrentVehicleConnection)
+        return;
+
+    QPointer<VehicleParameterUI> self(this);
+    const QSharedPointer<VehicleConnection> vehicleConnection = mCurrentVehicleConnection;
+    for (const auto& parameterName : parameterNames) {
+        const std::string name = parameterName.toStdString();
+
+        if (mParameterTableModel.isIntParameter(ParameterTableModel::Source::Vehicle, parameterName))
+            mCurrentVehicleConnection->getIntParameterFromVehicleAsync(name, [self, vehicleConnection, name](VehicleConnection::Result result, int32_t value) {
+                if (!self || self->mCurrentVehicleConnection != vehicleConnection || result != VehicleConnection::Result::Success)
+                    return;
+                ParameterServer::AllParameters parameters;
+                parameters.intParameters.push_back({name, value});
+                self->mParameterTableModel.updateParameters(ParameterTableModel::Source::Vehicle, parameters);
+            });
+        else if (mParameterTableModel.isFloatParameter(ParameterTableModel::Source::Vehicle, parameterName))
+            mCurrentVehicleConnection->getFloatParameterFromVehicleAsync(name, [self, vehicleConnection, name](VehicleConnection::Result result, float value) {
+                if (!self || self->mCurrentVehicleConnection != vehicleConnection || result != VehicleConnection::Result::Success)
+                    return;
+                ParameterServer::AllParameters parameters;
+                parameters.floatParameters.push_back({name, value});
+                self->mParameterTableModel.updateParameters(ParameterTableModel::Source::Vehicle, parameters);
+            });
+    }
+}
+
+void VehicleParameterUI::updateChangedControlTowerParameters()
+{
+    if (!ParameterServer::getInstance() || !mHasControlTowerParameters)
+        return;
+
+    mParameterTableModel.updateParameters(ParameterTableModel::Source::ControlTower,
+                                          ParameterServer::getInstance()->getParametersChangedSince(mControlTowerParametersVersion, &mControlTowerParametersVersion));
 }
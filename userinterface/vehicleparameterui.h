@@ -8,8 +8,8 @@
 
 #include <QWidget>
 #include <QDialog>
-#include <QTableWidget>
 #include "communication/vehicleconnections/vehicleconnection.h"
+#include "userinterface/parametertablemodel.h"
 
 namespace Ui {
 class VehicleParameterUI;
@@ -31,12 +31,19 @@ private slots:
 
 private:
     void populateTableWithParameters();
-    bool updateChangedParameters();
+    // Only edited parameters are sent, vehicle parameters in one batch and asynchronously, result shown with showUpdateStatus()
+    void updateChangedParameters();
+    void showUpdateStatus(bool success);
+    // Only the rows of changed parameters are updated
+    void updateChangedVehicleParameters(const QStringList &parameterNames);
+    void updateChangedControlTowerParameters();
 
     Ui::VehicleParameterUI *ui;
+    ParameterTableModel mParameterTableModel;
     QSharedPointer<VehicleConnection> mCurrentVehicleConnection;
-    ParameterServer::AllParameters mVehicleParameters;
-    ParameterServer::AllParameters mControlTowerParameters;
+    quint64 mControlTowerParametersVersion = 0;
+    bool mHasControlTowerParameters = false;
+    QMetaObject::Connection mVehicleParametersChangedConnection;
 };
 
 #endif // VEHICLEPARAMETERUI_H
@@ -10,9 +10,41 @@
 
 #include "communication/parameterserver.h"
 
+namespace {
+// Value ramping from start towards target at a limited rate, then constant
+struct RateLimitedProfile {
+    double start;
+    double target;
+    double rampTime_s;
+
+    static RateLimitedProfile towards(double start, double target, double maxRate)
+    {
+        if (maxRate <= 0.0) // unlimited
+            return {target, target, 0.0};
+        return {start, target, fabs(target - start) / maxRate};
+    }
+    double at(double t_s) const
+    {
+        return (t_s >= rampTime_s) ? target : start + (target - start) * t_s / rampTime_s;
+    }
+    double integral(double t_s) const // from 0 to t_s
+    {
+        const double ramp_s = qMin(t_s, rampTime_s);
+        return (start + at(ramp_s)) / 2.0 * ramp_s + target * (t_s - ramp_s);
+    }
+};
+
+inline double normalizedYaw_deg(double yaw_deg)
+{
+    yaw_deg = fmod(yaw_deg, 360.0);
+    return (yaw_deg < 0.0) ? yaw_deg + 360.0 : yaw_deg;
+}
+}
+
 CarState::CarState(ObjectID_t id, Qt::GlobalColor color) : VehicleState(id, color)
 {
     ObjectState::setWaywiseObjectType(WAYWISE_OBJECT_TYPE_CAR);
+    updateSteeringGeometryTable();
 }
 
 void CarState::setLength(double length)
@@ -20,6 +52,27 @@ void CarState::setLength(double length)
     VehicleState::setLength(length);
     setRearAxleToRearEndOffset(-0.25 * length);
     setRearAxleToCenterOffset(0.0);
+    updateSteeringGeometryTable(); // axis distance defaults to a share of the length
+}
+
+void CarState::setAxisDistance(double axisDistance)
+{
+    mAxisDistance = axisDistance;
+    updateSteeringGeometryTable();
+}
+
+void CarState::updateSteeringGeometryTable()
+{
+    if (getAxisDistance() > 0.0)
+        mSteeringGeometryTable.build(getAxisDistance(), getMaxSteeringAngle());
+}
+
+vehicleKinematics::CarModel CarState::getKinematicModel() const
+{
+    vehicleKinematics::CarModel model;
+    model.axisDistance_m = getAxisDistance();
+    model.maxSteeringAngle_rad = getMaxSteeringAngle();
+    return model;
 }
 
 void CarState::setVelocity(const Velocity &velocity)
@@ -72,23 +125,29 @@ void CarState::draw(QPainter &painter, const QTransform &drawTrans, const QTrans
         painter.drawEllipse(pos.getPointMm(), pos.getSigma() * 1000.0, pos.getSigma() * 1000.0);
     }
 
-    // Draw car
+    // Draw car, pre-rendered as long as its look and the zoom level do not change
     painter.save();
     painter.translate(x, y);
     painter.rotate(pos.getYaw());
-    // Rear axle wheels
     const double wheel_diameter = car_len / 6.0;
     const double wheel_width = car_w / 12.0;
-    painter.setBrush(QBrush(col_wheels));
-    painter.drawRoundedRect(- wheel_diameter/2, - (car_w / 2 + wheel_width / 2), wheel_diameter, (car_w + wheel_width), car_corner / 3, car_corner / 3);
-    // Front axle wheels
-    painter.drawRoundedRect(wheelbase - wheel_diameter/2, -(car_w / 2 + wheel_width / 2), wheel_diameter, (car_w + wheel_width), car_corner / 3, car_corner / 3);
-    // Front bumper
-    painter.setBrush(col_bumper);
-    painter.drawRoundedRect(rearAxleToRearEndOffsetX, -((car_w - car_len / 20.0) / 2.0), car_len, car_w - car_len / 20.0, car_corner, car_corner);
-    // Hull
-    painter.setBrush(col_hull);
-    painter.drawRoundedRect(rearAxleToRearEndOffsetX, -((car_w - car_len / 20.0) / 2.0), car_len - (car_len / 20.0), car_w - car_len / 20.0, car_corner, car_corner);
+    const double penMargin = painter.pen().widthF() / 2.0;
+    const QRectF bodyBounds = QRectF(QPointF(std::min(-wheel_diameter/2, rearAxleToRearEndOffsetX), -(car_w / 2 + wheel_width / 2)),
+                                     QPointF(std::max(wheelbase + wheel_diameter/2, rearAxleToRearEndOffsetX + car_len), car_w / 2 + wheel_width / 2))
+            .adjusted(-penMargin, -penMargin, penMargin, penMargin);
+    mBodyGlyphCache.draw(painter, bodyBounds, {car_len, car_w, rearAxleToRearEndOffsetX, wheelbase, double(getColor()), double(isSelected)}, [&](QPainter &glyphPainter) {
+        // Rear axle wheels
+        glyphPainter.setBrush(QBrush(col_wheels));
+        glyphPainter.drawRoundedRect(- wheel_diameter/2, - (car_w / 2 + wheel_width / 2), wheel_diameter, (car_w + wheel_width), car_corner / 3, car_corner / 3);
+        // Front axle wheels
+        glyphPainter.drawRoundedRect(wheelbase - wheel_diameter/2, -(car_w / 2 + wheel_width / 2), wheel_diameter, (car_w + wheel_width), car_corner / 3, car_corner / 3);
+        // Front bumper
+        glyphPainter.setBrush(col_bumper);
+        glyphPainter.drawRoundedRect(rearAxleToRearEndOffsetX, -((car_w - car_len / 20.0) / 2.0), car_len, car_w - car_len / 20.0, car_corner, car_corner);
+        // Hull
+        glyphPainter.setBrush(col_hull);
+        glyphPainter.drawRoundedRect(rearAxleToRearEndOffsetX, -((car_w - car_len / 20.0) / 2.0), car_len - (car_len / 20.0), car_w - car_len / 20.0, car_corner, car_corner);
+    });
     painter.restore();
 
     // Rear axle point
@@ -170,44 +229,46 @@ void CarState::draw(QPainter &painter, const QTransform &drawTrans, const QTrans
     //                    t.hour(), t.minute(), t.second(), t.msec());
 
     if (getDrawStatusText()) {
-        // Print data
-        QString txt;
+        // Print data, laid out again only when a shown value changes
         QPointF pt_txt;
-        QRectF rect_txt;
-
-        QString flightModeStr;
-        switch (getFlightMode()) {
-            case FlightMode::Unknown: flightModeStr = "unknown"; break;
-            case FlightMode::Ready: flightModeStr = "ready"; break;
-            case FlightMode::Takeoff: flightModeStr = "takeoff"; break;
-            case FlightMode::Hold: flightModeStr = "hold"; break;
-            case FlightMode::Mission: flightModeStr = "mission"; break;
-            case FlightMode::ReturnToLaunch: flightModeStr = "return to launch"; break;
-            case FlightMode::Land: flightModeStr = "land"; break;
-            case FlightMode::Offboard: flightModeStr = "offboard"; break;
-            case FlightMode::FollowMe: flightModeStr = "follow me"; break;
-            case FlightMode::Manual: flightModeStr = "manual"; break;
-            case FlightMode::Altctl: flightModeStr = "altitude"; break;
-            case FlightMode::Posctl: flightModeStr = "position"; break;
-            case FlightMode::Acro: flightModeStr = "acro"; break;
-            case FlightMode::Stabilized: flightModeStr = "stabilized"; break;
-            case FlightMode::Rattitude: flightModeStr = "rattitude"; break;
-        }
 
-        QTextStream txtStream(&txt);
-        txtStream.setRealNumberPrecision(3);
-        txtStream << getName() << Qt::endl
-                  << "(" << pos.getX() << ", " << pos.getY() << ", " << pos.getHeight() << ", " << (int)pos.getYaw() << ")" << Qt::endl
-                  << "State: " << (getIsArmed() ? "armed" : "disarmed") << Qt::endl
-                  << flightModeStr;
+        if (mStatusTextCache.needsUpdate(getName(), {VehicleDrawInputs::roundToSignificantDigits(pos.getX(), 3), VehicleDrawInputs::roundToSignificantDigits(pos.getY(), 3),
+                                                     VehicleDrawInputs::roundToSignificantDigits(pos.getHeight(), 3), double(int(pos.getYaw())),
+                                                     double(getIsArmed()), double(int(getFlightMode()))})) {
+            QString txt;
+            QString flightModeStr;
+            switch (getFlightMode()) {
+                case FlightMode::Unknown: flightModeStr = "unknown"; break;
+                case FlightMode::Ready: flightModeStr = "ready"; break;
+                case FlightMode::Takeoff: flightModeStr = "takeoff"; break;
+                case FlightMode::Hold: flightModeStr = "hold"; break;
+                case FlightMode::Mission: flightModeStr = "mission"; break;
+                case FlightMode::ReturnToLaunch: flightModeStr = "return to launch"; break;
+                case FlightMode::Land: flightModeStr = "land"; break;
+                case FlightMode::Offboard: flightModeStr = "offboard"; break;
+                case FlightMode::FollowMe: flightModeStr = "follow me"; break;
+                case FlightMode::Manual: flightModeStr = "manual"; break;
+                case FlightMode::Altctl: flightModeStr = "altitude"; break;
+                case FlightMode::Posctl: flightModeStr = "position"; break;
+                case FlightMode::Acro: flightModeStr = "acro"; break;
+                case FlightMode::Stabilized: flightModeStr = "stabilized"; break;
+                case FlightMode::Rattitude: flightModeStr = "rattitude"; break;
+            }
+
+            QTextStream txtStream(&txt);
+            txtStream.setRealNumberPrecision(3);
+            txtStream << getName() << Qt::endl
+                      << "(" << pos.getX() << ", " << pos.getY() << ", " << pos.getHeight() << ", " << (int)pos.getYaw() << ")" << Qt::endl
+                      << "State: " << (getIsArmed() ? "armed" : "disarmed") << Qt::endl
+                      << flightModeStr;
+            mStatusTextCache.setText(txt);
+        }
 
         pt_txt.setX(x + car_w + car_len * ((cos(getPosition().getYaw() * (M_PI/180.0)) + 1) / 3));
         pt_txt.setY(y);
         painter.setTransform(txtTrans);
         pt_txt = drawTrans.map(pt_txt);
-        rect_txt.setCoords(pt_txt.x(), pt_txt.y() - 40,
-                           pt_txt.x() + 400, pt_txt.y() + 65);
-        painter.drawText(rect_txt, txt);
+        mStatusTextCache.draw(painter, QPointF(pt_txt.x(), pt_txt.y() - 40));
     }
 }
 
@@ -224,13 +285,14 @@ QPainterPath CarState::getBoundingBox() const
 
 void CarState::setSteering(double steering)
 {
-    steering = (steering > tanf(getMaxSteeringAngle())) ? tanf(getMaxSteeringAngle()) : steering;
-    steering = (steering < -tanf(getMaxSteeringAngle())) ? -tanf(getMaxSteeringAngle()) : steering;
+    const double maxSteering = mSteeringGeometryTable.getMaxSteering();
+    steering = qBound(-maxSteering, steering, maxSteering);
     VehicleState::setSteering(steering);
 }
 
 void CarState::setMaxSteeringAngle(double steeringAngle_rad) {
     mMaxSteeringAngle = fabs(steeringAngle_rad);
+    updateSteeringGeometryTable();
 }
 
 void CarState::setMinTurnRadiusRear(double minTurnRadius_m) {
@@ -268,54 +330,123 @@ const QPointF CarState::getStoppingPointForTurnRadius(const double turnRadius) c
 void CarState::updateOdomPositionAndYaw(double drivenDistance, PosType usePosType)
 {
     PosPoint currentPosition = getPosition(usePosType);
-    double yawRad = currentPosition.getYaw() / (180.0/M_PI);
 
-    // Bicycle kinematic model with rear axle as reference point
-    if (fabs(getSteering()) > 1e-6) { // Turning
-        double turnRadiusRear = getTurnRadiusRear();
-        double turnRadiusFront = getTurnRadiusFront();
+    // Bicycle kinematic model with rear axle as reference point: it moves on an arc with the rear turn radius
+    const vehicleKinematics::Pose pose = vehicleKinematics::arcStep({currentPosition.getX(), currentPosition.getY(), currentPosition.getYaw() * M_PI / 180.0},
+                                                                    drivenDistance * vehicleKinematics::CarModel::getRearAxleDistanceFactor(getSteering()),
+                                                                    drivenDistance * getYawCurvature(getSteering()));
+    currentPosition.setXY(pose.x, pose.y);
+    currentPosition.setYaw(normalizedYaw_deg(pose.yaw_rad * 180.0 / M_PI));
 
-        if (turnRadiusRear < 0.0) {
-            turnRadiusFront = -turnRadiusFront;
-        }
+    currentPosition.setTimestamp_ns(utcTime::now_ns());
+    setPosition(currentPosition);
+}
 
-        double yawChange = drivenDistance / ((turnRadiusRear + turnRadiusFront) / 2.0);
+void CarState::setSimulateRateLimits(bool simulateRateLimits)
+{
+    if (simulateRateLimits && !mSimulateRateLimits) {
+        mCommandedSpeed = getSpeed();
+        mCommandedSteering = getSteering();
+    }
+    mSimulateRateLimits = simulateRateLimits;
+}
 
-        currentPosition.setX(currentPosition.getX() - turnRadiusRear * (sin(yawRad - yawChange) - sinf(yawRad)));
-        currentPosition.setY(currentPosition.getY() - turnRadiusRear * (cos(yawRad + yawChange) - cosf(yawRad)));
+void CarState::setCommandedSteering(double commandedSteering)
+{
+    const double maxSteering = qMin(mSteeringGeometryTable.getMaxSteering(), 1.0);
+    mCommandedSteering = qBound(-maxSteering, commandedSteering, maxSteering);
+}
 
-        double newYaw_deg = (yawRad + yawChange) * (180.0/M_PI);
+void CarState::simulationStep(double dt_ms, PosType usePosType)
+{
+    const double dt_s = dt_ms / 1000.0;
+    if (dt_s <= 0.0)
+        return;
 
-        // normalize
-        while (newYaw_deg < 0.0)
-            newYaw_deg += 360.0;
-        while (newYaw_deg > 360.0)
-            newYaw_deg -= 360.0;
+    RateLimitedProfile speed{getSpeed(), getSpeed(), 0.0};
+    RateLimitedProfile steering{getSteering(), getSteering(), 0.0};
+    if (mSimulateRateLimits) {
+        // Speeding up (in either direction) is limited by the max, slowing down by the min (braking) acceleration
+        const bool speedingUp = getSpeed() * (mCommandedSpeed - getSpeed()) >= 0.0;
+        speed = RateLimitedProfile::towards(getSpeed(), mCommandedSpeed, speedingUp ? getMaxAcceleration() : fabs(getMinAcceleration()));
+        steering = RateLimitedProfile::towards(getSteering(), mCommandedSteering, mMaxSteeringRate);
+    }
 
-        currentPosition.setYaw(newYaw_deg);
-    } else { // Driving forward
-        currentPosition.setX(currentPosition.getX() + cos(yawRad) * drivenDistance);
-        currentPosition.setY(currentPosition.getY() + sin(yawRad) * drivenDistance);
+    // A single arc is exact for constant speed and steering, sub-steps are needed when they change or for models integrated per distance
+    const bool inputsChange = speed.rampTime_s > 0.0 || steering.rampTime_s > 0.0;
+    const double maxDistance = qMax(fabs(speed.at(0.0)), fabs(speed.at(dt_s))) * dt_s;
+    const double maxYawChange = maxDistance * qMax(fabs(getYawCurvature(steering.at(0.0))), fabs(getYawCurvature(steering.at(dt_s))));
+    double substeps = ceil(maxDistance / getMaxSimulationSubstepDistance());
+    if (inputsChange)
+        substeps = qMax(substeps, ceil(qMin(dt_s, qMax(speed.rampTime_s, steering.rampTime_s)) / MAX_SUBSTEP_s));
+    if (inputsChange || mSimulationIntegrator == SimulationIntegrator::RK4)
+        substeps = qMax(substeps, ceil(maxYawChange / MAX_SUBSTEP_YAW_CHANGE_rad));
+    const int substepCount = qBound(1, int(qMin(substeps, double(MAX_SUBSTEPS))), MAX_SUBSTEPS);
+
+    const double substep_s = dt_s / substepCount;
+    for (int i = 0; i < substepCount; i++) {
+        const double t0_s = i * substep_s;
+        const double t1_s = (i + 1) * substep_s;
+        const double drivenDistance = speed.integral(t1_s) - speed.integral(t0_s);
+
+        if (mSimulationIntegrator == SimulationIntegrator::RK4) {
+            PosPoint currentPosition = getPosition(usePosType);
+            double x = currentPosition.getX(), y = currentPosition.getY(), yaw_rad = currentPosition.getYaw() * M_PI / 180.0;
+
+            // d(x, y, yaw)/dt of the rear axle for the speed and steering at t
+            const auto derivative = [&](double t_s, double yawAt_rad, double &dx, double &dy, double &dyaw) {
+                const double v = speed.at(t_s);
+                const double rearAxleSpeed = v * vehicleKinematics::CarModel::getRearAxleDistanceFactor(steering.at(t_s));
+                dx = rearAxleSpeed * cos(yawAt_rad);
+                dy = rearAxleSpeed * sin(yawAt_rad);
+                dyaw = v * getYawCurvature(steering.at(t_s));
+            };
+            double k1x, k1y, k1yaw, k2x, k2y, k2yaw, k3x, k3y, k3yaw, k4x, k4y, k4yaw;
+            derivative(t0_s, yaw_rad, k1x, k1y, k1yaw);
+            derivative(t0_s + substep_s / 2.0, yaw_rad + k1yaw * substep_s / 2.0, k2x, k2y, k2yaw);
+            derivative(t0_s + substep_s / 2.0, yaw_rad + k2yaw * substep_s / 2.0, k3x, k3y, k3yaw);
+            derivative(t1_s, yaw_rad + k3yaw * substep_s, k4x, k4y, k4yaw);
+            x += substep_s / 6.0 * (k1x + 2.0*k2x + 2.0*k3x + k4x);
+            y += substep_s / 6.0 * (k1y + 2.0*k2y + 2.0*k3y + k4y);
+            yaw_rad += substep_s / 6.0 * (k1yaw + 2.0*k2yaw + 2.0*k3yaw + k4yaw);
+
+            setSteering(steering.at(t1_s));
+            currentPosition.setXY(x, y);
+            currentPosition.setYaw(normalizedYaw_deg(yaw_rad * 180.0 / M_PI));
+            currentPosition.setTimestamp_ns(utcTime::now_ns());
+            setPosition(currentPosition);
+            simulationSubstepIntegrated(drivenDistance, usePosType);
+        } else {
+            // Midpoint steering keeps the arcs second-order accurate while steering changes
+            setSteering(steering.at((t0_s + t1_s) / 2.0));
+            updateOdomPositionAndYaw(drivenDistance, usePosType);
+        }
     }
 
-    currentPosition.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
-    setPosition(currentPosition);
+    if (mSimulateRateLimits) {
+        setSteering(steering.at(dt_s));
+        Velocity velocity = getVelocity();
+        velocity.x = speed.at(dt_s);
+        setVelocity(velocity);
+    }
 }
 
 double CarState::steeringCurvatureToSteering(double steeringCurvature)
 {
-    double steeringAngle_rad = atan(getAxisDistance() * steeringCurvature);
-    if (abs(steeringAngle_rad) > getMaxSteeringAngle())
-        steeringAngle_rad = getMaxSteeringAngle() * ((steeringAngle_rad > 0) ? 1.0 : -1.0);
+    return mSteeringGeometryTable.getNormalizedSteering(steeringCurvature);
+}
 
-    return steeringAngle_rad / getMaxSteeringAngle();
+namespace {
+constexpr ParameterDescriptor<float> VEH_LENGTH{"VEH_LENGTH"};
+constexpr ParameterDescriptor<float> VEH_WIDTH{"VEH_WIDTH"};
+constexpr ParameterDescriptor<float> VEH_WHLBASE{"VEH_WHLBASE"};
 }
 
 void CarState::provideParametersToParameterServer()
 {
-    ParameterServer::getInstance()->provideFloatParameter("VEH_LENGTH", std::bind(&CarState::setLength, this, std::placeholders::_1), std::bind(&CarState::getLength, this));
-    ParameterServer::getInstance()->provideFloatParameter("VEH_WIDTH", std::bind(&CarState::setWidth, this, std::placeholders::_1), std::bind(&CarState::getWidth, this));
-    ParameterServer::getInstance()->provideFloatParameter("VEH_WHLBASE", std::bind(&CarState::setAxisDistance, this, std::placeholders::_1), std::bind(&CarState::getAxisDistance, this));
+    ParameterServer::getInstance()->provideParameter<&CarState::setLength, &CarState::getLength>(VEH_LENGTH, this);
+    ParameterServer::getInstance()->provideParameter<&CarState::setWidth, &CarState::getWidth>(VEH_WIDTH, this);
+    ParameterServer::getInstance()->provideParameter<&CarState::setAxisDistance, &CarState::getAxisDistance>(VEH_WHLBASE, this);
 
     ParameterServer::getInstance()->provideFloatParameter("VEH_RA2CO_X", std::bind(static_cast<void (CarState::*)(double)>(&CarState::setRearAxleToCenterOffset), this, std::placeholders::_1),
         [this]() -> float {
@@ -9,11 +9,14 @@
 #define CARSTATE_H
 
 #include "vehicles/vehiclestate.h"
+#include "vehicles/steeringgeometrytable.h"
+#include "vehicles/vehiclekinematics.h"
 
 #include <QObject>
 #include <QString>
 #ifdef QT_GUI_LIB
 #include <QPainter>
+#include "vehicles/vehicledrawcache.h"
 #endif
 #include <cmath>
 
@@ -36,7 +39,7 @@ public:
     // Static state
     virtual void setLength(double length) override;
     double getAxisDistance() const { return fabs(mAxisDistance) < 0.001 ? 0.6*getLength() : mAxisDistance; }
-    void setAxisDistance(double axisDistance) { mAxisDistance = axisDistance; }
+    void setAxisDistance(double axisDistance);
 
     inline double getMaxSteeringAngle() const { return mMaxSteeringAngle < M_PI/180.0 ? M_PI/4.0 : mMaxSteeringAngle; } // 45° assumed if unset
     void setMaxSteeringAngle(double steeringAngle_rad);
@@ -52,14 +55,57 @@ public:
     double getThreeSecondsDistance() const { return 3.0*getSpeed(); } // Distance the vehicle can move within 3 seconds at current speed, Swedish "Tresekundersregeln"
     const QPointF getStoppingPointForTurnRadiusAndBrakingDistance(const double turnRadius, const double brakeDistance) const;
     const QPointF getStoppingPointForTurnRadius(const double turnRadius) const;
-    inline double getMinTurnRadiusRear() const { return qMax(qMin(getAxisDistance() / tanf(getMaxSteeringAngle()), mMinTurnRadiusRear), pow(getSpeed(), 2)/(0.21*9.81)); }
+    inline double getMinTurnRadiusRear() const { return qMax(qMin(getAxisDistance() / mSteeringGeometryTable.getMaxSteering(), mMinTurnRadiusRear), pow(getSpeed(), 2)/(0.21*9.81)); }
     virtual void setVelocity(const Velocity &velocity) override;
+    double getYawCurvature(double steering) const { return mSteeringGeometryTable.getYawCurvature(steering); } // yaw change per driven distance [rad/m] of the bicycle model
+    // Interpolated, rebuilt when length, axis distance or max. steering angle change
+    const SteeringGeometryTable &getSteeringGeometryTable() const { return mSteeringGeometryTable; }
+    // Value copy of the static state, e.g., for PoseBatch
+    vehicleKinematics::CarModel getKinematicModel() const;
+
+    // Simulation: simulationStep() moves the rear axle on an arc, i.e., exactly for constant speed and steering and independent of dt.
+    // With rate limits, speed and steering follow the commanded values within [getMinAcceleration:getMaxAcceleration] and getMaxSteeringRate.
+    // Steps are then split into sub-steps (adaptive to the yaw change), RK4 also integrates within sub-steps while speed and steering change.
+    enum class SimulationIntegrator {EXACT_ARC, RK4};
+    static constexpr double MAX_SUBSTEP_YAW_CHANGE_rad = 0.05;
+    static constexpr double MAX_SUBSTEP_s = 0.05; // while speed or steering change
+    static constexpr int MAX_SUBSTEPS = 10000;
+    virtual void simulationStep(double dt_ms, PosType usePosType = PosType::simulated) override;
+    SimulationIntegrator getSimulationIntegrator() const { return mSimulationIntegrator; }
+    void setSimulationIntegrator(SimulationIntegrator simulationIntegrator) { mSimulationIntegrator = simulationIntegrator; }
+    bool getSimulateRateLimits() const { return mSimulateRateLimits; }
+    void setSimulateRateLimits(bool simulateRateLimits); // commanded speed and steering start at the current ones
+    double getMaxSteeringRate() const { return mMaxSteeringRate; }
+    void setMaxSteeringRate(double maxSteeringRate) { mMaxSteeringRate = fabs(maxSteeringRate); } // [1/s], 0: unlimited
+    double getCommandedSpeed() const { return mCommandedSpeed; }
+    void setCommandedSpeed(double commandedSpeed) { mCommandedSpeed = commandedSpeed; }
+    double getCommandedSteering() const { return mCommandedSteering; }
+    void setCommandedSteering(double commandedSteering);
+
+protected:
+    // Limits sub-steps for models integrated per driven distance, e.g., a simulated trailer
+    virtual double getMaxSimulationSubstepDistance() const { return std::numeric_limits<double>::infinity(); }
+    // RK4 updates the position directly, models that depend on it catch up here
+    virtual void simulationSubstepIntegrated(double drivenDistance, PosType usePosType) { Q_UNUSED(drivenDistance) Q_UNUSED(usePosType) }
+#ifdef QT_GUI_LIB
+    VehicleGlyphCache mBodyGlyphCache;
+    VehicleStatusTextCache mStatusTextCache;
+#endif
 
 private:
+    void updateSteeringGeometryTable();
+
     double mAxisDistance = 0.0; // [m]
     double mMaxSteeringAngle = 0.0; // [rad]
+    SteeringGeometryTable mSteeringGeometryTable;
     double mMinTurnRadiusRear = std::numeric_limits<double>::infinity(); // [m]
 
+    SimulationIntegrator mSimulationIntegrator = SimulationIntegrator::EXACT_ARC;
+    bool mSimulateRateLimits = false;
+    double mMaxSteeringRate = 2.0; // [1/s], full range in one second
+    double mCommandedSpeed = 0.0; // [m/s]
+    double mCommandedSteering = 0.0; // [-1.0:1.0]
+
 #ifdef QT_GUI_LIB
     bool mStateInitialized = false; // whether parameters are setup
 #endif
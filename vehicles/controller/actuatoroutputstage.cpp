@@ -0,0 +1,113 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "actuatoroutputstage.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+ActuatorOutputStage::ActuatorOutputStage(QObject *parent) : QObject(parent)
+{
+}
+
+int ActuatorOutputStage::addChannel(std::function<void(double)> output, const ActuatorOutputChannelConfig &config)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    Channel channel;
+    channel.output = output;
+    channel.config = config;
+    mChannels.append(channel);
+    return mChannels.size() - 1;
+}
+
+ActuatorOutputChannelConfig ActuatorOutputStage::getChannelConfig(int channel)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    return isValidChannel(channel) ? mChannels.at(channel).config : ActuatorOutputChannelConfig();
+}
+
+void ActuatorOutputStage::setChannelConfig(int channel, const ActuatorOutputChannelConfig &config)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (!isValidChannel(channel)) {
+        qDebug() << "Warning: ActuatorOutputStage has no channel" << channel;
+        return;
+    }
+    mChannels[channel].config = config;
+}
+
+void ActuatorOutputStage::setTarget(int channel, double target)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (!isValidChannel(channel))
+        return;
+
+    Channel &outputChannel = mChannels[channel];
+    outputChannel.statistics.targetUpdates++;
+    if (target != 0.0 && fabs(target - outputChannel.target) <= outputChannel.config.deadband)
+        return;
+
+    outputChannel.target = target;
+    outputChannel.statistics.target = target;
+}
+
+void ActuatorOutputStage::resetChannel(int channel, double value)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    if (!isValidChannel(channel))
+        return;
+
+    Channel &outputChannel = mChannels[channel];
+    outputChannel.target = value;
+    outputChannel.value = value;
+    outputChannel.hasOutput = false;
+    outputChannel.statistics.target = value;
+}
+
+ActuatorOutputChannelStatistics ActuatorOutputStage::getChannelStatistics(int channel)
+{
+    std::lock_guard<std::recursive_mutex> lock(mControlLoop.getIterationMutex());
+    return isValidChannel(channel) ? mChannels.at(channel).statistics : ActuatorOutputChannelStatistics();
+}
+
+void ActuatorOutputStage::updateOutputs()
+{
+    const qint64 now_us = mControlLoop.getClock()->now_us();
+    // At most a few periods, e.g., after the loop was stopped
+    const qint64 period_us = mControlLoop.getPeriod_us();
+    const double dt_s = (mHasLastUpdate ? qBound(qint64(0), now_us - mLastUpdateTime_us, 4 * period_us) : period_us) / 1e6;
+    mHasLastUpdate = true;
+    mLastUpdateTime_us = now_us;
+
+    for (Channel &channel : mChannels) {
+        const ActuatorOutputChannelConfig &config = channel.config;
+
+        // 1. Low-pass towards the target (exact for a constant target over dt)
+        double value = channel.target;
+        if (config.lowPassTimeConstant_s > 0.0)
+            value = channel.value + (channel.target - channel.value) * (1.0 - exp(-dt_s / config.lowPassTimeConstant_s));
+
+        // 2. Rate limit
+        if (config.maxRate > 0.0) {
+            const double maxChange = config.maxRate * dt_s;
+            value = std::clamp(value, channel.value - maxChange, channel.value + maxChange);
+        }
+        channel.value = value;
+
+        // 3. Output on change, on reaching the target (small remaining steps are not held back) or as keepalive
+        bool write = !channel.hasOutput || fabs(value - channel.lastOutput) > config.minOutputChange
+                || (value == channel.target && value != channel.lastOutput);
+        if (config.keepaliveInterval_ms > 0 && now_us - channel.lastOutputTime_us >= qint64(config.keepaliveInterval_ms) * 1000)
+            write = true;
+        if (!write)
+            continue;
+
+        channel.output(value);
+        channel.hasOutput = true;
+        channel.lastOutput = value;
+        channel.lastOutputTime_us = now_us;
+        channel.statistics.outputs++;
+        channel.statistics.output = value;
+    }
+}
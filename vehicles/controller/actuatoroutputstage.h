@@ -0,0 +1,80 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Output stage between a MovementController and its motor/servo controllers. Targets are set at the control rate
+ * (e.g., by an autopilot), each channel is shaped (deadband, first-order low-pass, rate limit) and written to its
+ * actuator at the stage's own fixed rate, only when the output changed noticeably (or a keepalive interval passed).
+ * Targets can be set from any thread, outputs are written from the stage's ControlLoop.
+ */
+
+#ifndef ACTUATOROUTPUTSTAGE_H
+#define ACTUATOROUTPUTSTAGE_H
+
+#include <QObject>
+#include <QVector>
+#include <functional>
+#include "core/controlloop.h"
+
+struct ActuatorOutputChannelConfig {
+    double deadband = 0.0; // target changes up to this are ignored, a target of 0 (stop) is always accepted
+    double lowPassTimeConstant_s = 0.0; // 0: no low-pass
+    double maxRate = 0.0; // [units/s], 0: unlimited
+    double minOutputChange = 0.0; // output is written when it changed by more than this, or reached the target
+    unsigned keepaliveInterval_ms = 0; // unchanged output is repeated at this interval, 0: never
+};
+
+struct ActuatorOutputChannelStatistics {
+    quint64 targetUpdates = 0;
+    quint64 outputs = 0; // written to the actuator
+    double target = 0.0;
+    double output = 0.0; // last value written
+};
+
+class ActuatorOutputStage : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr unsigned DEFAULT_PERIOD_MS = 20;
+
+    explicit ActuatorOutputStage(QObject *parent = nullptr);
+
+    // Returns the channel's index. The output function is called from the stage's loop.
+    int addChannel(std::function<void(double)> output, const ActuatorOutputChannelConfig &config = ActuatorOutputChannelConfig());
+    ActuatorOutputChannelConfig getChannelConfig(int channel);
+    void setChannelConfig(int channel, const ActuatorOutputChannelConfig &config);
+
+    void setTarget(int channel, double target);
+    // Jumps to the target, e.g., when taking over from direct output. Written in the next iteration.
+    void resetChannel(int channel, double value);
+
+    ActuatorOutputChannelStatistics getChannelStatistics(int channel);
+
+    // Rate and mode of the loop writing the outputs
+    ControlLoop &getControlLoop() { return mControlLoop; }
+    void setClock(Clock *clock) { mControlLoop.setClock(clock); } // nullptr: real-time clock
+
+private:
+    struct Channel {
+        std::function<void(double)> output;
+        ActuatorOutputChannelConfig config;
+        double target = 0.0;
+        double value = 0.0; // shaped
+        bool hasOutput = false;
+        double lastOutput = 0.0;
+        qint64 lastOutputTime_us = 0;
+        ActuatorOutputChannelStatistics statistics;
+    };
+
+    void updateOutputs();
+    bool isValidChannel(int channel) const { return channel >= 0 && channel < mChannels.size(); }
+
+    QVector<Channel> mChannels;
+    bool mHasLastUpdate = false;
+    qint64 mLastUpdateTime_us = 0;
+
+    // Last member, i.e., the loop is stopped before anything it uses is destroyed
+    ControlLoop mControlLoop{[this](){ updateOutputs(); }, DEFAULT_PERIOD_MS};
+};
+
+#endif // ACTUATOROUTPUTSTAGE_H
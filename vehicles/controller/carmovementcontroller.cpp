@@ -4,10 +4,14 @@
  */
 #include "carmovementcontroller.h"
 #include <QDebug>
+#include "core/commandlatencytrace.h"
+#include <atomic>
 
 CarMovementController::CarMovementController(QSharedPointer<CarState> vehicleState): MovementController(vehicleState)
 {
     mCarState = getVehicleState().dynamicCast<CarState>();
+    mSteeringOutputChannel = mActuatorOutputStage.addChannel([this](double steering) { outputSteering(steering); });
+    mSpeedOutputChannel = mActuatorOutputStage.addChannel([this](double speed) { outputSpeed(speed); });
 }
 
 void CarMovementController::setDesiredSteering(double desiredSteering)
@@ -16,8 +20,20 @@ void CarMovementController::setDesiredSteering(double desiredSteering)
         desiredSteering = (desiredSteering > 0) ? 1.0 : -1.0;
 
     MovementController::setDesiredSteering(desiredSteering);
-    // update vehicleState in any case (we do not expect feedback from servo)
-    mCarState->setSteering(desiredSteering);
+    if (mActuatorOutputStageActive)
+        mActuatorOutputStage.setTarget(mSteeringOutputChannel, desiredSteering);
+    else
+        outputSteering(desiredSteering);
+}
+
+void CarMovementController::outputSteering(double desiredSteering)
+{
+    CommandLatencyTrace::getInstance().mark(CommandLatencyTrace::Stage::Actuator);
+    // update vehicleState in any case (we do not expect feedback from servo), simulated steering follows at its max rate
+    if (mCarState->getSimulateRateLimits())
+        mCarState->setCommandedSteering(desiredSteering);
+    else
+        mCarState->setSteering(desiredSteering);
 
     if (mServoController) {
         // map from [-1.0:1.0] to actual servo range
@@ -27,23 +43,48 @@ void CarMovementController::setDesiredSteering(double desiredSteering)
         desiredSteering = desiredSteering * (mServoController->getServoRange() / 2.0) + mServoController->getServoCenter();
         mServoController->requestSteering(desiredSteering);
     }
-
 }
 
 void CarMovementController::setDesiredSpeed(double desiredSpeed)
 {
     MovementController::setDesiredSpeed(desiredSpeed);
+    desiredSpeed = getDesiredSpeed(); // limited, e.g., by the geofence
+    if (mActuatorOutputStageActive)
+        mActuatorOutputStage.setTarget(mSpeedOutputChannel, desiredSpeed);
+    else
+        outputSpeed(desiredSpeed);
+}
+
+void CarMovementController::setSafetyStop(bool active)
+{
+    MovementController::setSafetyStop(active);
+    if (!active)
+        return;
+
+    if (mActuatorOutputStageActive)
+        mActuatorOutputStage.resetChannel(mSpeedOutputChannel, 0.0);
+    outputSpeed(0.0);
+}
+
+void CarMovementController::outputSpeed(double desiredSpeed)
+{
+    if (isSafetyStopActive()) // also output stage keepalives
+        desiredSpeed = 0.0;
+
+    CommandLatencyTrace::getInstance().mark(CommandLatencyTrace::Stage::Actuator); // e.g., VESCMotorController::requestRPM, or simulated
     if (mMotorController)
         mMotorController->requestRPM(desiredSpeed*getSpeedToRPMFactor());
     else {
-        static bool warnedOnce = false;
-        if (!warnedOnce) {
+        static std::atomic<bool> warnedOnce{false}; // controllers of simulated vehicles may run on several threads
+        if (!warnedOnce.exchange(true))
             qDebug() << "WARNING: CarMovementController has no MotorController connection. Simulating movement."; // TODO: create explicitly simulated controller
-            warnedOnce = true;
+        if (mCarState->getSimulateRateLimits())
+            mCarState->setCommandedSpeed(desiredSpeed);
+        else {
+            xyz_t currentVelocity = mCarState->getVelocity();
+            currentVelocity.x = desiredSpeed;
+            mCarState->setVelocity(currentVelocity);
         }
-        xyz_t currentVelocity = mCarState->getVelocity();
-        currentVelocity.x = desiredSpeed;
-        mCarState->setVelocity(currentVelocity);
     }
 }
 
@@ -58,6 +99,25 @@ void CarMovementController::setServoController(const QSharedPointer<ServoControl
     mServoController = servoController;
 }
 
+void CarMovementController::setActuatorOutputStageActive(bool active)
+{
+    if (active == mActuatorOutputStageActive)
+        return;
+
+    if (active) {
+        // Continue from the last direct output
+        mActuatorOutputStage.resetChannel(mSteeringOutputChannel, getDesiredSteering());
+        mActuatorOutputStage.resetChannel(mSpeedOutputChannel, getDesiredSpeed());
+        mActuatorOutputStageActive = true;
+        mActuatorOutputStage.getControlLoop().start();
+    } else {
+        mActuatorOutputStage.getControlLoop().stop();
+        mActuatorOutputStageActive = false;
+        outputSteering(getDesiredSteering());
+        outputSpeed(getDesiredSpeed());
+    }
+}
+
 double CarMovementController::getSpeedToRPMFactor() const
 {
     return mSpeedToRPMFactor;
@@ -68,23 +128,30 @@ void CarMovementController::setSpeedToRPMFactor(double speedToRPMFactor)
     mSpeedToRPMFactor = speedToRPMFactor;
 }
 
-void CarMovementController::updateVehicleState(double rpm, int tachometer, int tachometer_abs, double voltageInput, double temperature, int errorID)
+void CarMovementController::updateVehicleState(double rpm, int tachometer, int tachometer_abs, double voltageInput, double temperature, int errorID, qint64 timestamp_ns)
 {
     Q_UNUSED(tachometer_abs)
     Q_UNUSED(voltageInput)
     Q_UNUSED(temperature)
     Q_UNUSED(errorID)
 
-    static int previousTachometer = tachometer;
+    if (!utcTime::isValid(timestamp_ns))
+        timestamp_ns = utcTime::now_ns();
     QSharedPointer<CarState> carState = getVehicleState().dynamicCast<CarState>();
     double currentSpeed = rpm/getSpeedToRPMFactor();
-    double drivenDistance = (tachometer - previousTachometer)/getSpeedToRPMFactor() * 60.0;
+    double drivenDistance = mHasPreviousStatus ? (tachometer - mPreviousTachometer)/getSpeedToRPMFactor() * 60.0 : 0.0;
+    const qint64 dt_ns = mHasPreviousStatus ? timestamp_ns - mPreviousStatusTimestamp_ns : 0;
 
     xyz_t currentVelocity = carState->getVelocity();
     currentVelocity.x = currentSpeed;
     carState->setVelocity(currentVelocity);
     carState->updateOdomPositionAndYaw(drivenDistance);
+    // Odometry is valid when the motor controller sampled the tachometer, not when it was processed here
+    carState->updatePosition(PosType::odom, [timestamp_ns](PosPoint &position) { position.setTimestamp_ns(timestamp_ns); });
 
-    previousTachometer = tachometer;
-    emit updatedOdomPositionAndYaw(carState, drivenDistance);
+    mHasPreviousStatus = true;
+    mPreviousTachometer = tachometer;
+    mPreviousStatusTimestamp_ns = timestamp_ns;
+    emit updatedOdomPositionAndYaw(carState, drivenDistance, timestamp_ns, dt_ns);
+    publishOdomPosition(drivenDistance, dt_ns);
 }
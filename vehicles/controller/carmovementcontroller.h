@@ -12,9 +12,11 @@
 #include "vehicles/controller/movementcontroller.h"
 #include "motorcontroller.h"
 #include "servocontroller.h"
+#include "actuatoroutputstage.h"
 #include "vehicles/carstate.h"
 #include <QObject>
 #include <QSharedPointer>
+#include <atomic>
 
 class CarMovementController : public MovementController
 {
@@ -24,6 +26,9 @@ public:
     // MovementController interface
     virtual void setDesiredSteering(double desiredSteering) override;
     virtual void setDesiredSpeed(double desiredSpeed) override;
+    // Stops the motor from the calling thread, i.e., needs a MotorController that accepts commands from any thread
+    // (VESCMotorController with dedicated I/O thread)
+    virtual void setSafetyStop(bool active) override;
 
     void setMotorController(const QSharedPointer<MotorController> motorController);
     void setServoController(const QSharedPointer<ServoController> servoController);
@@ -31,14 +36,32 @@ public:
     double getSpeedToRPMFactor() const;
     void setSpeedToRPMFactor(double getSpeedToRPMFactor);
 
+    // Active: steering (normalized, [-1.0:1.0]) and speed [m/s] are written through the output stage at its own rate,
+    // shaped per channel, instead of on every setDesiredSteering/setDesiredSpeed call
+    bool isActuatorOutputStageActive() const { return mActuatorOutputStageActive; }
+    void setActuatorOutputStageActive(bool active);
+    ActuatorOutputStage &getActuatorOutputStage() { return mActuatorOutputStage; }
+    int getSteeringOutputChannel() const { return mSteeringOutputChannel; }
+    int getSpeedOutputChannel() const { return mSpeedOutputChannel; }
 
 private:
-    void updateVehicleState(double rpm, int tachometer, int tachometer_abs, double voltageInput, double temperature, int errorID);
+    void outputSteering(double steering);
+    void outputSpeed(double speed);
+    void updateVehicleState(double rpm, int tachometer, int tachometer_abs, double voltageInput, double temperature, int errorID, qint64 timestamp_ns);
 
     QSharedPointer<CarState> mCarState;
     QSharedPointer<MotorController> mMotorController;
     QSharedPointer<ServoController> mServoController;
     double mSpeedToRPMFactor = 4123.3; // default for Traxxas Slash VXL
+    bool mHasPreviousStatus = false;
+    int mPreviousTachometer = 0;
+    qint64 mPreviousStatusTimestamp_ns = utcTime::INVALID;
+
+    std::atomic<bool> mActuatorOutputStageActive{false};
+    int mSteeringOutputChannel = -1;
+    int mSpeedOutputChannel = -1;
+    // Last member, its loop calls outputSteering/outputSpeed
+    ActuatorOutputStage mActuatorOutputStage;
 };
 
 #endif // CARMOVEMENTCONTROLLER_H
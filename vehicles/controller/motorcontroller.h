@@ -9,6 +9,7 @@
 #define MOTORCONTROLLER_H
 
 #include <QObject>
+#include "core/pospoint.h"
 
 class MotorController : public QObject
 {
@@ -19,7 +20,8 @@ public:
 
 signals:
     void firmwareVersionReceived(QPair<int,int>); // Major and minor firmware version
-    void gotStatusValues(double rpm, int tachometer, int tachometer_abs, double voltageInput, double temperature, int errorID);
+    // timestamp_ns (UTC): when the motor controller sampled the values, as far as known
+    void gotStatusValues(double rpm, int tachometer, int tachometer_abs, double voltageInput, double temperature, int errorID, qint64 timestamp_ns);
 
 };
 
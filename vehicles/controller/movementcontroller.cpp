@@ -3,6 +3,11 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "movementcontroller.h"
+#include "vehicles/carstate.h"
+#include "sensors/sensortopics.h"
+#include "core/commandlatencytrace.h"
+#include <QDebug>
+#include <cmath>
 
 MovementController::MovementController(QSharedPointer<VehicleState> vehicleState)
 {
@@ -16,6 +21,7 @@ double MovementController::getDesiredSteering() const
 
 void MovementController::setDesiredSteering(double desiredSteering)
 {
+    CommandLatencyTrace::getInstance().mark(CommandLatencyTrace::Stage::Controller);
     mDesiredSteering = desiredSteering;
 }
 
@@ -31,7 +37,18 @@ double MovementController::getDesiredSpeed() const
 
 void MovementController::setDesiredSpeed(double desiredSpeed)
 {
-    mDesiredSpeed = desiredSpeed;
+    CommandLatencyTrace::getInstance().mark(CommandLatencyTrace::Stage::Controller);
+    mDesiredSpeed = mSafetyStop ? 0.0 : limitSpeedByGeofence(desiredSpeed);
+}
+
+void MovementController::publishOdomPosition(double distanceDriven, qint64 dt_ns)
+{
+    OdomPositionMessage message;
+    message.vehicleId = mVehicleState->getId();
+    message.position = mVehicleState->getPosition(PosType::odom).toPOD();
+    message.distanceDriven_m = distanceDriven;
+    message.dt_ns = dt_ns;
+    sensorTopics::odomPosition()->publish(message);
 }
 
 void MovementController::setDesiredAttributes(quint32 desiredAttributes)
@@ -43,3 +60,62 @@ QSharedPointer<VehicleState> MovementController::getVehicleState() const
 {
     return mVehicleState;
 }
+
+void MovementController::setGeofence(QSharedPointer<const Geofence> geofence)
+{
+    std::lock_guard<std::mutex> lock(mGeofenceMutex);
+    mGeofence = geofence;
+}
+
+QSharedPointer<const Geofence> MovementController::getGeofence() const
+{
+    std::lock_guard<std::mutex> lock(mGeofenceMutex);
+    return mGeofence;
+}
+
+QRectF MovementController::getFootprint() const
+{
+#ifdef QT_GUI_LIB
+    const QRectF boundingBox = mVehicleState->getBoundingBox().boundingRect();
+    if (boundingBox.width() > 0.0 && boundingBox.height() > 0.0)
+        return boundingBox;
+#endif
+    return QRectF(-mVehicleState->getLength() / 2.0, -mVehicleState->getWidth() / 2.0, mVehicleState->getLength(), mVehicleState->getWidth());
+}
+
+double MovementController::limitSpeedByGeofence(double desiredSpeed)
+{
+    const QSharedPointer<const Geofence> geofence = getGeofence();
+    Geofence::Violation violation;
+    double limitedSpeed = desiredSpeed;
+    if (!geofence.isNull() && !geofence->isEmpty() && desiredSpeed != 0.0) {
+        const GeofenceEnforcementParameters &parameters = mGeofenceEnforcementParameters;
+        const double deceleration = (parameters.deceleration > 0.0) ? parameters.deceleration : std::max(-mVehicleState->getMinAcceleration(), 0.1);
+        const double speed = fabs(desiredSpeed);
+        const double stoppingDistance = speed * parameters.reactionTime_s + speed * speed / (2.0 * deceleration) + parameters.margin_m;
+
+        // Curvature of the current steering, straight for vehicles without a steering geometry
+        const QSharedPointer<CarState> carState = mVehicleState.dynamicCast<CarState>();
+        const double curvature = carState.isNull() ? 0.0 : carState->getYawCurvature(mVehicleState->getSteering());
+        const pospoint_t position = mVehicleState->getPositionPOD(parameters.posType);
+        violation = geofence->checkPath(getFootprint(), position.getPoint(), position.yaw * M_PI / 180.0, curvature,
+                                        copysign(stoppingDistance, desiredSpeed), parameters.predictionStep_m);
+
+        if (violation.isViolated()) {
+            // Fastest speed that stops within the distance left: v * reactionTime + v² / (2 * deceleration) = distance
+            const double distance = std::max(violation.distance_m - parameters.margin_m - parameters.predictionStep_m, 0.0);
+            const double maxSpeed = deceleration * (sqrt(parameters.reactionTime_s * parameters.reactionTime_s + 2.0 * distance / deceleration) - parameters.reactionTime_s);
+            limitedSpeed = copysign(std::min(speed, maxSpeed), desiredSpeed);
+        }
+    }
+
+    if (violation.isViolated() && mGeofenceLimitingZone < 0) {
+        mGeofenceLimitingZone = violation.zoneIndex;
+        qDebug() << "WARNING: MovementController limits speed by geofence zone" << violation.zoneIndex << ", violation in" << violation.distance_m << "m.";
+        emit geofenceSpeedLimited(violation.zoneIndex, violation.distance_m);
+    } else if (!violation.isViolated() && mGeofenceLimitingZone >= 0 && desiredSpeed != 0.0) {
+        mGeofenceLimitingZone = -1;
+        emit geofenceSpeedLimitCleared();
+    }
+    return limitedSpeed;
+}
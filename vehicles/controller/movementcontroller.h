@@ -5,6 +5,9 @@
  * Abstract class to provide interface towards, e.g., autopilot, and to be implemented for specific vehicle types.
  * Gets desired steering, throttle/speed as input and translates it for specific vehicle respecting kinematic model and, e.g., motor controller as well as servo setup.
  * Reports actual steering, throttle/speed reported from sensors/lower-level controllers back to VehicleState.
+ * An optional Geofence is enforced on every setDesiredSpeed: the vehicle's footprint is checked along the path it would drive
+ * with the current steering until it stops, the speed is limited such that it stops before violating a zone.
+ * A vehicle already violating a zone is stopped in both directions until the geofence is changed.
  */
 
 #ifndef MOVEMENTCONTROLLER_H
@@ -12,7 +15,18 @@
 
 #include <QObject>
 #include <QSharedPointer>
+#include <atomic>
+#include <mutex>
 #include "vehicles/vehiclestate.h"
+#include "core/geofence.h"
+
+struct GeofenceEnforcementParameters {
+    PosType posType = PosType::fused;
+    double reactionTime_s = 0.2; // until braking starts
+    double deceleration = 0.0; // [m/s²], 0: -VehicleState::getMinAcceleration()
+    double margin_m = 0.2; // stop at least this far before a violation
+    double predictionStep_m = 0.1;
+};
 
 class MovementController : public QObject
 {
@@ -28,16 +42,45 @@ public:
 
     virtual void setDesiredAttributes(quint32 desiredAttributes);
 
+    // Safety stop, e.g., by SafetyWatchdog from its own thread: implementations command their actuators to stop directly
+    // (thread-safe, without the event loop) and speed commands give 0 until released. Released, the next command applies.
+    virtual void setSafetyStop(bool active) { mSafetyStop = active; }
+    bool isSafetyStopActive() const { return mSafetyStop; }
+
     QSharedPointer<VehicleState> getVehicleState() const;
 
+    // Can be replaced from any thread, e.g., on uploads. Null: no geofence
+    void setGeofence(QSharedPointer<const Geofence> geofence);
+    QSharedPointer<const Geofence> getGeofence() const;
+    void setGeofenceEnforcementParameters(const GeofenceEnforcementParameters &parameters) { mGeofenceEnforcementParameters = parameters; }
+    GeofenceEnforcementParameters getGeofenceEnforcementParameters() const { return mGeofenceEnforcementParameters; }
+    // Footprint in the vehicle frame [m]: getBoundingBox if available, the vehicle's length and width around its origin otherwise
+    QRectF getFootprint() const;
+
 signals:
-    void updatedOdomPositionAndYaw(QSharedPointer<VehicleState> vehicleState, double distanceMoved);
+    // timestamp_ns (UTC) of the odometry sample and dt_ns since the previous one, if known
+    void updatedOdomPositionAndYaw(QSharedPointer<VehicleState> vehicleState, double distanceMoved, qint64 timestamp_ns = utcTime::INVALID, qint64 dt_ns = 0);
+    // Once when the geofence starts limiting the speed, distance_m to the predicted violation (0: already violated)
+    void geofenceSpeedLimited(int zoneIndex, double distance_m);
+    void geofenceSpeedLimitCleared();
+
+protected:
+    // Publishes the vehicle's PosType::odom to sensorTopics::odomPosition, next to updatedOdomPositionAndYaw
+    void publishOdomPosition(double distanceDriven, qint64 dt_ns);
 
 private:
+    double limitSpeedByGeofence(double desiredSpeed);
+
     QSharedPointer<VehicleState> mVehicleState;
     double mDesiredSteering = 0.0; // [-1.0:1.0]
     double mDesiredSpeed = 0.0; // [m/s]
     quint32 mDesiredAttributes = 0;
+    std::atomic<bool> mSafetyStop{false};
+
+    mutable std::mutex mGeofenceMutex;
+    QSharedPointer<const Geofence> mGeofence;
+    GeofenceEnforcementParameters mGeofenceEnforcementParameters;
+    int mGeofenceLimitingZone = -1; // setDesiredSpeed's thread
 };
 
 #endif // MOVEMENTCONTROLLER_H
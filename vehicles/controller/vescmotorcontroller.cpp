@@ -6,6 +6,7 @@
 #include "external/vesc/datatypes.h"
 #include "core/vbytearray.h"
 #include <QDebug>
+#include <algorithm>
 #include <cmath>
 
 VESCMotorController::VESCMotorController()
@@ -13,42 +14,54 @@ VESCMotorController::VESCMotorController()
     mVESCServoController.reset(new VESCServoController(&mVESCPacket));
 
     // --- Serial communication & command parsing setup
+    // Decoding, heartbeat and polling are connected directly, i.e., they run in the thread the I/O objects live in
     connect(&mSerialPort, &QSerialPort::readyRead, this, [this](){
-        while (mSerialPort.bytesAvailable() > 0)
+        while (mSerialPort.bytesAvailable() > 0) {
+            mRxTimestamp_ns = utcTime::now_ns();
             mVESCPacket.processData(mSerialPort.readAll());
-    });
+        }
+    }, Qt::DirectConnection);
 
-    connect(&mVESCPacket, &VESC::Packet::packetReceived, this, &VESCMotorController::processVESCPacket);
-    connect(&mVESCPacket, &VESC::Packet::dataToSend, this, [this](const QByteArray data){
+    connect(&mVESCPacket, &VESC::Packet::packetReceived, this, &VESCMotorController::processVESCPacket, Qt::DirectConnection);
+    // Frames of commands from other threads are queued to the serial port's thread
+    connect(&mVESCPacket, &VESC::Packet::dataToSend, &mSerialPort, [this](const QByteArray data){
         if (mSerialPort.isOpen()) {
             mSerialPort.write(data);
         }
     });
 
     // send periodic heartbeats to prevent VESC timeout, TODO: connect to IP communication timeout?
-    connect(&mHeartbeatTimer, &QTimer::timeout, this, [this](){
+    connect(&mHeartbeatTimer, &ClockTimer::timeout, this, [this](){
         VByteArray vb;
         vb.vbAppendInt8(VESC::COMM_ALIVE);
         mVESCPacket.sendPacket(vb);
-    });
+    }, Qt::DirectConnection);
 
-    // periodically poll VESC state and optionally IMU
-    connect(&mPollValuesTimer, &QTimer::timeout, this, [this](){
+    // periodically poll VESC state and optionally IMU, see MAX_OUTSTANDING_VALUE_REQUESTS
+    connect(&mPollValuesTimer, &ClockTimer::timeout, this, [this](){
         VByteArray packetData;
-        packetData.vbAppendUint8(VESC::COMM_GET_VALUES_SELECTIVE);
-        packetData.vbAppendUint32(SELECT_VALUES_MASK);
-        mVESCPacket.sendPacket(packetData);
+        if (mOutstandingValueRequests < MAX_OUTSTANDING_VALUE_REQUESTS) {
+            packetData.vbAppendUint8(VESC::COMM_GET_VALUES_SELECTIVE);
+            packetData.vbAppendUint32(SELECT_VALUES_MASK);
+            mVESCPacket.sendPacket(packetData);
+            mOutstandingValueRequests++;
+        } else
+            mOutstandingValueRequests--; // skip one period, the oldest response is considered lost
 
         if (mEnableIMUOrientationUpdate) {
-            packetData.clear();
-            packetData.vbAppendUint8(VESC::COMM_GET_IMU_DATA);
-            packetData.vbAppendUint16(SELECT_IMU_DATA_MASK);
-            mVESCPacket.sendPacket(packetData);
+            if (mOutstandingIMURequests < MAX_OUTSTANDING_VALUE_REQUESTS) {
+                packetData.clear();
+                packetData.vbAppendUint8(VESC::COMM_GET_IMU_DATA);
+                packetData.vbAppendUint16(SELECT_IMU_DATA_MASK);
+                mVESCPacket.sendPacket(packetData);
+                mOutstandingIMURequests++;
+            } else
+                mOutstandingIMURequests--;
         }
-    });
+    }, Qt::DirectConnection);
 
     // periodically make sure no current is sent to motor when stopped (VESC behavior that can fry the motor)
-    connect(&mCheckCurrentTimer, &QTimer::timeout, this, [this](){
+    connect(&mCheckCurrentTimer, &ClockTimer::timeout, this, [this](){
         static bool setCurrentToZeroNextTime = false;
 
         if (setCurrentToZeroNextTime) {
@@ -60,40 +73,119 @@ VESCMotorController::VESCMotorController()
             setCurrentToZeroNextTime = false;
         } else if (abs(mLastRPMrequest) < MAX_RPM_CONSIDERED_STOP)
             setCurrentToZeroNextTime = true;
-    });
+    }, Qt::DirectConnection);
 }
 
-bool VESCMotorController::connectSerial(const QSerialPortInfo &serialPortInfo)
+template<typename Function>
+void VESCMotorController::runOnIoThread(Function function)
 {
-    if(mSerialPort.isOpen()) {
-        mSerialPort.close();
+    if (mSerialPort.thread() == QThread::currentThread())
+        function();
+    else
+        QMetaObject::invokeMethod(&mSerialPort, function, Qt::BlockingQueuedConnection);
+}
+
+VESCMotorController::~VESCMotorController()
+{
+    if (mIoThread) {
+        runOnIoThread([this]() {
+            mHeartbeatTimer.stop();
+            mPollValuesTimer.stop();
+            mCheckCurrentTimer.stop();
+            mSerialPort.close();
+            for (QObject *object : getIoObjects())
+                object->moveToThread(thread());
+        });
+        mIoThread->quit();
+        mIoThread->wait();
     }
+}
 
-    mSerialPort.setPort(serialPortInfo);
-    mSerialPort.open(QIODevice::ReadWrite);
+QList<QObject*> VESCMotorController::getIoObjects()
+{
+    return {&mSerialPort, &mVESCPacket, &mHeartbeatTimer, &mPollValuesTimer, &mCheckCurrentTimer};
+}
 
-    if(!mSerialPort.isOpen()) {
-        return false;
+void VESCMotorController::setDedicatedIoThread(bool enabled)
+{
+    if (enabled == hasDedicatedIoThread())
+        return;
+
+    if (isSerialConnected()) {
+        qDebug() << "WARNING: VESC I/O thread can only be changed while disconnected.";
+        return;
+    }
+
+    if (enabled) {
+        mIoThread = new QThread(this);
+        mIoThread->setObjectName("VESC I/O");
+        for (QObject *object : getIoObjects())
+            object->moveToThread(mIoThread);
+        mIoThread->start(QThread::HighPriority);
+    } else {
+        runOnIoThread([this]() {
+            for (QObject *object : getIoObjects())
+                object->moveToThread(thread());
+        });
+        mIoThread->quit();
+        mIoThread->wait();
+        delete mIoThread;
+        mIoThread = nullptr;
     }
+}
 
-    mSerialPort.setBaudRate(115200);
-    mSerialPort.setDataBits(QSerialPort::Data8);
-    mSerialPort.setParity(QSerialPort::NoParity);
-    mSerialPort.setStopBits(QSerialPort::OneStop);
-    mSerialPort.setFlowControl(QSerialPort::NoFlowControl);
+bool VESCMotorController::connectSerial(const QSerialPortInfo &serialPortInfo)
+{
+    bool result = false;
+    runOnIoThread([this, &serialPortInfo, &result]() {
+        if(mSerialPort.isOpen()) {
+            mSerialPort.close();
+        }
+
+        mSerialPort.setPort(serialPortInfo);
+        mSerialPort.open(QIODevice::ReadWrite);
+
+        if(!mSerialPort.isOpen()) {
+            return;
+        }
+
+        mSerialPort.setBaudRate(115200);
+        mSerialPort.setDataBits(QSerialPort::Data8);
+        mSerialPort.setParity(QSerialPort::NoParity);
+        mSerialPort.setStopBits(QSerialPort::OneStop);
+        mSerialPort.setFlowControl(QSerialPort::NoFlowControl);
+        serialPortOptions::apply(mSerialPort, mSerialPortOptions);
 
-    pollFirmwareVersion();
+        pollFirmwareVersion();
 
-    mPollValuesTimer.start(pollValuesPeriod_ms);
-    mHeartbeatTimer.start(heartbeatPeriod_ms);
-    mCheckCurrentTimer.start(checkCurrentPeriod_ms);
+        mOutstandingValueRequests = 0;
+        mOutstandingIMURequests = 0;
+        mPollValuesTimer.start(pollValuesPeriod_ms);
+        mHeartbeatTimer.start(heartbeatPeriod_ms);
+        mCheckCurrentTimer.start(checkCurrentPeriod_ms);
 
-    return true;
+        result = true;
+    });
+
+    return result;
+}
+
+void VESCMotorController::setClock(Clock *clock)
+{
+    runOnIoThread([this, clock]() {
+        mHeartbeatTimer.setClock(clock);
+        mPollValuesTimer.setClock(clock);
+        mCheckCurrentTimer.setClock(clock);
+    });
 }
 
 bool VESCMotorController::isSerialConnected()
 {
-    return mSerialPort.isOpen() && mSerialPort.isWritable();
+    bool connected = false;
+    runOnIoThread([this, &connected]() {
+        connected = mSerialPort.isOpen() && mSerialPort.isWritable();
+    });
+    return connected;
 }
 
 void VESCMotorController::pollFirmwareVersion()
@@ -149,42 +241,55 @@ int VESCMotorController::getPollValuesPeriod() const
 
 void VESCMotorController::setPollValuesPeriod(int milliseconds)
 {
-    pollValuesPeriod_ms = milliseconds;
-    mPollValuesTimer.start(pollValuesPeriod_ms);
+    runOnIoThread([this, milliseconds]() {
+        pollValuesPeriod_ms = milliseconds;
+        mPollValuesTimer.start(pollValuesPeriod_ms);
+    });
+}
+
+qint64 VESCMotorController::getSampleTimestamp_ns(const QByteArray &data) const
+{
+    if (!utcTime::isValid(mRxTimestamp_ns))
+        return utcTime::now_ns();
+
+    // The VESC samples right before sending, i.e., the response ended arriving at reception.
+    // Frame: start, length, payload, crc (2), stop at 10 bits per byte (8N1)
+    const int frameSize = data.size() + (data.size() > 255 ? 6 : 5);
+    const qint32 baudRate = mSerialPort.baudRate();
+    return baudRate > 0 ? mRxTimestamp_ns - qint64(frameSize) * 10 * 1000000000LL / baudRate : mRxTimestamp_ns;
 }
 
 void VESCMotorController::processVESCPacket(QByteArray &data)
 {
-    VByteArray vb(data);
-    VESC::COMM_PACKET_ID id = VESC::COMM_PACKET_ID(vb.vbPopFrontUint8());
+    VByteArrayReader vb(data); // reads in place, no copy of the packet
+    VESC::COMM_PACKET_ID id = VESC::COMM_PACKET_ID(vb.vbReadUint8());
 
     switch (id) {
     case VESC::COMM_FW_VERSION: {
-        if (vb.size() >= 2) {
-            mVescFirmwareInfo.major = vb.vbPopFrontInt8();
-            mVescFirmwareInfo.minor = vb.vbPopFrontInt8();
-            mVescFirmwareInfo.hw = vb.vbPopFrontString();
+        if (vb.getRemaining() >= 2) {
+            mVescFirmwareInfo.major = vb.vbReadInt8();
+            mVescFirmwareInfo.minor = vb.vbReadInt8();
+            mVescFirmwareInfo.hw = vb.vbReadString();
         }
 
-        if (vb.size() >= 12) {
-            mVescFirmwareInfo.uuid.append(vb.left(12));
-            vb.remove(0, 12);
+        if (vb.getRemaining() >= 12) {
+            mVescFirmwareInfo.uuid.append(vb.vbReadBytes(12));
         }
 
-        if (vb.size() >= 1) {
-            mVescFirmwareInfo.isPaired = vb.vbPopFrontInt8();
+        if (vb.getRemaining() >= 1) {
+            mVescFirmwareInfo.isPaired = vb.vbReadInt8();
         }
 
-        if (vb.size() >= 1) {
-            mVescFirmwareInfo.isTestFw = vb.vbPopFrontInt8();
+        if (vb.getRemaining() >= 1) {
+            mVescFirmwareInfo.isTestFw = vb.vbReadInt8();
         }
 
-        if (vb.size() >= 1) {
-            mVescFirmwareInfo.hwType = VESC::HW_TYPE(vb.vbPopFrontInt8());
+        if (vb.getRemaining() >= 1) {
+            mVescFirmwareInfo.hwType = VESC::HW_TYPE(vb.vbReadInt8());
         }
 
-        if (vb.size() >= 1) {
-            mVescFirmwareInfo.customConfigNum = vb.vbPopFrontInt8();
+        if (vb.getRemaining() >= 1) {
+            mVescFirmwareInfo.customConfigNum = vb.vbReadInt8();
         }
 
         //qDebug().nospace() << "VESC firmware " << mVescFirmwareInfo.major << "." << mVescFirmwareInfo.minor << " on hardware version " << mVescFirmwareInfo.hw;
@@ -198,20 +303,21 @@ void VESCMotorController::processVESCPacket(QByteArray &data)
 
     case VESC::COMM_GET_VALUES_SELECTIVE: {
         VESC::MC_VALUES values;
+        const qint64 timestamp_ns = getSampleTimestamp_ns(data);
+        mOutstandingValueRequests = std::max(mOutstandingValueRequests - 1, 0);
 
-
-        uint32_t mask = vb.vbPopFrontUint32();
+        uint32_t mask = vb.vbReadUint32();
         if (mask != SELECT_VALUES_MASK)
             qDebug() << "Warning: VescMotorController got COMM_GET_VALUES_SELECTIVE but mask does not match selected values.";
 
-        values.temp_mos = vb.vbPopFrontDouble16(1e1);
-        values.current_motor = vb.vbPopFrontDouble32(1e2);
-        values.current_in = vb.vbPopFrontDouble32(1e2);
-        values.rpm = vb.vbPopFrontDouble32(1e0);
-        values.v_in = vb.vbPopFrontDouble16(1e1);
-        values.tachometer = vb.vbPopFrontInt32();
-        values.tachometer_abs = vb.vbPopFrontInt32();
-        values.fault_code = VESC::mc_fault_code(vb.vbPopFrontInt8());
+        values.temp_mos = vb.vbReadDouble16(1e1);
+        values.current_motor = vb.vbReadDouble32(1e2);
+        values.current_in = vb.vbReadDouble32(1e2);
+        values.rpm = vb.vbReadDouble32(1e0);
+        values.v_in = vb.vbReadDouble16(1e1);
+        values.tachometer = vb.vbReadInt32();
+        values.tachometer_abs = vb.vbReadInt32();
+        values.fault_code = VESC::mc_fault_code(vb.vbReadInt8());
         values.fault_str = VESCFaultToStr(values.fault_code);
 
 //        // --- DEBUG ---
@@ -229,25 +335,27 @@ void VESCMotorController::processVESCPacket(QByteArray &data)
 //            throttleqDebug--;
 
         // Note: tachometer needs to be divided by 6, not sure why
-        emit gotStatusValues(values.rpm, values.tachometer/6,  values.tachometer_abs/6, values.v_in, values.temp_mos, values.fault_code);
+        emit gotStatusValues(values.rpm, values.tachometer/6,  values.tachometer_abs/6, values.v_in, values.temp_mos, values.fault_code, timestamp_ns);
     } break;
 
     case VESC::COMM_GET_IMU_DATA: {
         VESC::IMU_VALUES values;
+        const qint64 timestamp_ns = getSampleTimestamp_ns(data);
+        mOutstandingIMURequests = std::max(mOutstandingIMURequests - 1, 0);
 
-        uint32_t mask = vb.vbPopFrontUint16();
+        uint32_t mask = vb.vbReadUint16();
         if (mask != SELECT_IMU_DATA_MASK)
             qDebug() << "Warning: VescMotorController got COMM_GET_IMU_DATA but mask does not match selected values.";
 
-        values.roll = vb.vbPopFrontDouble32Auto();
-        values.pitch = vb.vbPopFrontDouble32Auto();
-        values.yaw = vb.vbPopFrontDouble32Auto();
+        values.roll = vb.vbReadDouble32Auto();
+        values.pitch = vb.vbReadDouble32Auto();
+        values.yaw = vb.vbReadDouble32Auto();
 
 //        qDebug() << values.roll* 180.0 / M_PI << values. pitch* 180.0 / M_PI << values.yaw* 180.0 / M_PI;
-        mVESCOrientationUpdater->useIMUDataFromVESC(values.roll * 180.0 / M_PI, values.pitch * 180.0 / M_PI, values.yaw * 180.0 / M_PI);
+        mVESCOrientationUpdater->useIMUDataFromVESC(values.roll * 180.0 / M_PI, values.pitch * 180.0 / M_PI, values.yaw * 180.0 / M_PI, timestamp_ns);
     } break;
     case VESC::COMM_PRINT:
-        qDebug() << QString::fromLatin1(vb);
+        qDebug() << QString::fromLatin1(vb.vbReadBytes(vb.getRemaining()));
     break;
     default:
         qDebug() << "WARNING: unhandled VESC command with id" << id;
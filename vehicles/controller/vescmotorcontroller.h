@@ -16,7 +16,11 @@
 #include "sensors/imu/imuorientationupdater.h"
 #include <QSerialPort>
 #include <QSerialPortInfo>
+#include "core/serialportoptions.h"
 #include <QByteArray>
+#include <QThread>
+#include <atomic>
+#include "core/clock.h"
 #include "external/vesc/vescpacket.h"
 #include "external/vesc/datatypes.h"
 
@@ -25,7 +29,14 @@ class VESCMotorController : public MotorController
     Q_OBJECT
 public:
     VESCMotorController();
-
+    ~VESCMotorController();
+
+    // Serial I/O, packet decoding, heartbeat and polling on a dedicated thread, so that motor commands and status values are not delayed
+    // by the owner's event loop (e.g., GUI or GNSS work). Needs to be set before connecting. Commands can be sent from any thread,
+    // signals are then emitted from the I/O thread, i.e., queued to receivers in other threads.
+    void setDedicatedIoThread(bool enabled);
+    bool hasDedicatedIoThread() const { return mIoThread != nullptr; }
+    void setSerialPortOptions(const SerialPortOptions &options) { mSerialPortOptions = options; } // applied when connecting
     bool connectSerial(const QSerialPortInfo &serialPortInfo);
     bool isSerialConnected();
 
@@ -39,6 +50,8 @@ public:
     int getPollValuesPeriod() const;
     void setPollValuesPeriod(int milliseconds);
 
+    void setClock(Clock *clock); // heartbeat, polling and current check, nullptr: real-time clock
+
 private:
     // internal classes to avoid mutli-inheritance from QObject
     class VESCServoController : public ServoController {
@@ -57,24 +70,22 @@ private:
             return false; // TODO
         }
     private:
-        void useIMUDataFromVESC(double roll, double pitch, double yaw) {
-            QSharedPointer<VehicleState> vehicleState = getVehicleState();
-            PosPoint currIMUPos = vehicleState->getPosition(PosType::IMU);
-
-            currIMUPos.setRollPitchYaw(roll, pitch, coordinateTransforms::yawNEDtoENU(yaw));
-            currIMUPos.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
-            vehicleState->setPosition(currIMUPos);
-
-            emit updatedIMUOrientation(vehicleState);
+        void useIMUDataFromVESC(double roll, double pitch, double yaw, qint64 timestamp_ns) {
+            inputIMUSample(roll, pitch, coordinateTransforms::yawNEDtoENU(yaw), timestamp_ns);
         };
 
         friend class VESCMotorController;
     };
 
     QSerialPort mSerialPort;
+    SerialPortOptions mSerialPortOptions;
+    QThread *mIoThread = nullptr;
+    template<typename Function>
+    void runOnIoThread(Function function);
+    QList<QObject*> getIoObjects();
 
     const int heartbeatPeriod_ms = 300;
-    QTimer mHeartbeatTimer;
+    ClockTimer mHeartbeatTimer;
 
     // Only request selected values
     const unsigned TMOS_MASK = ((uint32_t)1 << 0);
@@ -93,17 +104,24 @@ private:
     const unsigned SELECT_IMU_DATA_MASK = ROLL_MASK | PITCH_MASK | YAW_MASK;
 
     int pollValuesPeriod_ms = 20;
-    QTimer mPollValuesTimer;
+    ClockTimer mPollValuesTimer;
+    // Polls are pipelined: a new request is sent every period without waiting for the previous response,
+    // so the sample rate does not depend on the round-trip time. Responses that never arrive are given up on at this limit.
+    static constexpr int MAX_OUTSTANDING_VALUE_REQUESTS = 3;
+    int mOutstandingValueRequests = 0; // I/O thread
+    int mOutstandingIMURequests = 0; // I/O thread
+    qint64 mRxTimestamp_ns = utcTime::INVALID; // I/O thread, reception of the data currently being decoded
+    qint64 getSampleTimestamp_ns(const QByteArray &data) const;
 
     const int checkCurrentPeriod_ms = 100;
-    QTimer mCheckCurrentTimer;
-    int mLastRPMrequest = 0;
+    ClockTimer mCheckCurrentTimer;
+    std::atomic<int> mLastRPMrequest{0};
     const int MAX_RPM_CONSIDERED_STOP = 500; // motor will not move when RPM lower than this are requested
 
     VESC::Packet mVESCPacket;
     VESC::FW_RX_PARAMS mVescFirmwareInfo;
 
-    bool mEnableIMUOrientationUpdate = false;
+    std::atomic<bool> mEnableIMUOrientationUpdate{false};
     void setEnableIMUOrientationUpdate(bool enabled);
     QSharedPointer<VESCOrientationUpdater> mVESCOrientationUpdater;
 
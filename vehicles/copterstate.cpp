@@ -100,21 +100,27 @@ void CopterState::draw(QPainter &painter, const QTransform &drawTrans, const QTr
     } else {
         painter.rotate((mFrameType == CopterFrameType::X) ? 45 : 0);
 
-        // Draw the frame
-        painter.setBrush(col_frame);
-        painter.drawRect(-getWidth()/2, -20, getWidth(), 40);
-        painter.drawRect(-20, -getLength()/2, 40, getLength());
-
-        // Draw propellers
-        painter.setBrush(QBrush(col_prop_main));
-        painter.drawEllipse(QPointF(getWidth()/2, 0), mPropellerSize/2, mPropellerSize/2);
-        if (mFrameType == CopterFrameType::PLUS)
-            painter.setBrush(QBrush(col_prop_other));
-        painter.drawEllipse(QPointF(0, getLength()/2), mPropellerSize/2, mPropellerSize/2);
-
-        painter.setBrush(QBrush(col_prop_other));
-        painter.drawEllipse(QPointF(0, -getLength()/2), mPropellerSize/2, mPropellerSize/2);
-        painter.drawEllipse(QPointF(-getWidth()/2, 0), mPropellerSize/2, mPropellerSize/2);
+        // Frame and propellers, pre-rendered as long as their look and the zoom level do not change
+        const double halfExtent = std::max({getWidth()/2 + mPropellerSize/2, getLength()/2 + mPropellerSize/2, 20.0}) + pen.widthF() / 2.0;
+        mFrameGlyphCache.draw(painter, QRectF(-halfExtent, -halfExtent, 2 * halfExtent, 2 * halfExtent),
+                              {getWidth(), getLength(), double(mPropellerSize), double(mFrameType == CopterFrameType::X), double(getColor()), double(isSelected)},
+                              [&](QPainter &glyphPainter) {
+            // Draw the frame
+            glyphPainter.setBrush(col_frame);
+            glyphPainter.drawRect(-getWidth()/2, -20, getWidth(), 40);
+            glyphPainter.drawRect(-20, -getLength()/2, 40, getLength());
+
+            // Draw propellers
+            glyphPainter.setBrush(QBrush(col_prop_main));
+            glyphPainter.drawEllipse(QPointF(getWidth()/2, 0), mPropellerSize/2, mPropellerSize/2);
+            if (mFrameType == CopterFrameType::PLUS)
+                glyphPainter.setBrush(QBrush(col_prop_other));
+            glyphPainter.drawEllipse(QPointF(0, getLength()/2), mPropellerSize/2, mPropellerSize/2);
+
+            glyphPainter.setBrush(QBrush(col_prop_other));
+            glyphPainter.drawEllipse(QPointF(0, -getLength()/2), mPropellerSize/2, mPropellerSize/2);
+            glyphPainter.drawEllipse(QPointF(-getWidth()/2, 0), mPropellerSize/2, mPropellerSize/2);
+        });
 
         // Draw velocity
         if (fabs(getVelocity().x) > 1e-5 || fabs(getVelocity().y) > 1e-5) {
@@ -125,54 +131,56 @@ void CopterState::draw(QPainter &painter, const QTransform &drawTrans, const QTr
         }
     }
 
-    // Print data
-    QString txt;
+    // Print data, laid out again only when a shown value changes
     QPointF pt_txt;
-    QRectF rect_txt;
-
-    QString landedStateStr;
-    switch (mLandedState) {
-        case LandedState::Unknown: landedStateStr = "unknown"; break;
-        case LandedState::OnGround: landedStateStr = "on ground"; break;
-        case LandedState::InAir: landedStateStr = "in air"; break;
-        case LandedState::TakingOff: landedStateStr = "taking off"; break;
-        case LandedState::Landing: landedStateStr = "landing"; break;
-    }
+
+    if (mStatusTextCache.needsUpdate(getName(), {VehicleDrawInputs::roundToSignificantDigits(pos.getX(), 3), VehicleDrawInputs::roundToSignificantDigits(pos.getY(), 3),
+                                                 VehicleDrawInputs::roundToSignificantDigits(pos.getHeight(), 3), double(int(pos.getYaw())),
+                                                 double(getIsArmed()), double(int(mLandedState)), double(int(getFlightMode()))})) {
+        QString txt;
+        QString landedStateStr;
+        switch (mLandedState) {
+            case LandedState::Unknown: landedStateStr = "unknown"; break;
+            case LandedState::OnGround: landedStateStr = "on ground"; break;
+            case LandedState::InAir: landedStateStr = "in air"; break;
+            case LandedState::TakingOff: landedStateStr = "taking off"; break;
+            case LandedState::Landing: landedStateStr = "landing"; break;
+        }
     
-    QString flightModeStr;
-    switch (getFlightMode()) {
-        case FlightMode::Unknown: flightModeStr = "unknown"; break;
-        case FlightMode::Ready: flightModeStr = "ready"; break;
-        case FlightMode::Takeoff: flightModeStr = "takeoff"; break;
-        case FlightMode::Hold: flightModeStr = "hold"; break;
-        case FlightMode::Mission: flightModeStr = "mission"; break;
-        case FlightMode::ReturnToLaunch: flightModeStr = "return to launch"; break;
-        case FlightMode::Land: flightModeStr = "land"; break;
-        case FlightMode::Offboard: flightModeStr = "offboard"; break;
-        case FlightMode::FollowMe: flightModeStr = "follow me"; break;
-        case FlightMode::Manual: flightModeStr = "manual"; break;
-        case FlightMode::Altctl: flightModeStr = "altitude"; break;
-        case FlightMode::Posctl: flightModeStr = "position"; break;
-        case FlightMode::Acro: flightModeStr = "acro"; break;
-        case FlightMode::Stabilized: flightModeStr = "stabilized"; break;
-        case FlightMode::Rattitude: flightModeStr = "rattitude"; break;
-    }
+        QString flightModeStr;
+        switch (getFlightMode()) {
+            case FlightMode::Unknown: flightModeStr = "unknown"; break;
+            case FlightMode::Ready: flightModeStr = "ready"; break;
+            case FlightMode::Takeoff: flightModeStr = "takeoff"; break;
+            case FlightMode::Hold: flightModeStr = "hold"; break;
+            case FlightMode::Mission: flightModeStr = "mission"; break;
+            case FlightMode::ReturnToLaunch: flightModeStr = "return to launch"; break;
+            case FlightMode::Land: flightModeStr = "land"; break;
+            case FlightMode::Offboard: flightModeStr = "offboard"; break;
+            case FlightMode::FollowMe: flightModeStr = "follow me"; break;
+            case FlightMode::Manual: flightModeStr = "manual"; break;
+            case FlightMode::Altctl: flightModeStr = "altitude"; break;
+            case FlightMode::Posctl: flightModeStr = "position"; break;
+            case FlightMode::Acro: flightModeStr = "acro"; break;
+            case FlightMode::Stabilized: flightModeStr = "stabilized"; break;
+            case FlightMode::Rattitude: flightModeStr = "rattitude"; break;
+        }
 
-    QTextStream txtStream(&txt);
-    txtStream.setRealNumberPrecision(3);
-    txtStream << getName() << Qt::endl
-              << "(" << pos.getX() << ", " << pos.getY() << ", " << pos.getHeight() << ", " << (int)pos.getYaw() << ")" << Qt::endl
-              << "State: " << (getIsArmed() ? "armed, " : "disarmed, ") << landedStateStr << Qt::endl
-              << flightModeStr;
+        QTextStream txtStream(&txt);
+        txtStream.setRealNumberPrecision(3);
+        txtStream << getName() << Qt::endl
+                  << "(" << pos.getX() << ", " << pos.getY() << ", " << pos.getHeight() << ", " << (int)pos.getYaw() << ")" << Qt::endl
+                  << "State: " << (getIsArmed() ? "armed, " : "disarmed, ") << landedStateStr << Qt::endl
+                  << flightModeStr;
+        mStatusTextCache.setText(txt);
+    }
 
     pt_txt.setX(x + ((scale < 0.05) ? scaleIndependentSize : (getWidth() + getLength())/2));
     pt_txt.setY(y);
     painter.setTransform(txtTrans);
     pt_txt = drawTrans.map(pt_txt);
-    rect_txt.setCoords(pt_txt.x(), pt_txt.y() - 40,
-                       pt_txt.x() + 400, pt_txt.y() + 65);
     painter.setPen(QPen(QPalette::WindowText));
-    painter.drawText(rect_txt, txt);
+    mStatusTextCache.draw(painter, QPointF(pt_txt.x(), pt_txt.y() - 40));
 
     // Restore transform
     painter.setTransform(drawTrans);
@@ -202,7 +210,7 @@ void CopterState::updateOdomPositionAndYaw(double drivenDistance, PosType usePos
     currentPosition.setY(currentPosition.getY() + drivenDistance*currVelocityNormalized.y);
     currentPosition.setHeight(currentPosition.getHeight() + drivenDistance*currVelocityNormalized.z);
 
-    currentPosition.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
+    currentPosition.setTimestamp_ns(utcTime::now_ns());
     setPosition(currentPosition);
 }
 
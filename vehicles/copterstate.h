@@ -12,6 +12,7 @@
 #include <QObject>
 #include <QPainter>
 #include <cmath>
+#include "vehicles/vehicledrawcache.h"
 
 class CopterState : public VehicleState
 {
@@ -44,6 +45,10 @@ private:
     CopterFrameType mFrameType;
     int mPropellerSize; // [mm]
     LandedState mLandedState = LandedState::Unknown;
+#ifdef QT_GUI_LIB
+    VehicleGlyphCache mFrameGlyphCache;
+    VehicleStatusTextCache mStatusTextCache;
+#endif
 };
 
 #endif // COPTERSTATE_H
@@ -0,0 +1,42 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "detectedobjectstate.h"
+
+DetectedObjectState::DetectedObjectState(ObjectID_t id, Qt::GlobalColor color) : ObjectState(id, color)
+{
+    setName(QString("Object %1").arg(id));
+}
+
+#ifdef QT_GUI_LIB
+void DetectedObjectState::draw(QPainter &painter, const QTransform &drawTrans, const QTransform &txtTrans, bool isSelected)
+{
+    if (!mActive)
+        return;
+
+    const PosPoint position = getPosition();
+    const QPointF center = position.getPoint() * 1000.0;
+    const double scale = drawTrans.map(QLineF(0, 0, 0, 1)).length();
+    const double radius = 8.0 / scale;
+
+    painter.setTransform(drawTrans);
+    QPen pen(isSelected ? Qt::black : getColor());
+    pen.setWidthF(2.0 / scale);
+    painter.setPen(pen);
+    painter.setBrush(QBrush(getColor(), Qt::Dense4Pattern));
+    painter.drawEllipse(center, radius, radius);
+
+    // Velocity for one second
+    const Velocity velocity = getVelocity();
+    painter.drawLine(center, center + QPointF(velocity.x, velocity.y) * 1000.0);
+
+    if (getDrawStatusText()) {
+        painter.setTransform(txtTrans);
+        const QPointF textPosition = drawTrans.map(center);
+        painter.setPen(QPen(Qt::black));
+        painter.drawText(QRectF(textPosition.x() + 10, textPosition.y() - 10, 100, 20), Qt::AlignLeft | Qt::AlignVCenter,
+                         QString("Track %1").arg(mTrackId));
+    }
+}
+#endif
@@ -0,0 +1,34 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * ObjectState of an object tracked by a sensor (see ObjectTracker, DepthAiCamera). Instances are reused for different tracks,
+ * inactive ones are not drawn, i.e., they can stay added to MapWidget.
+ */
+
+#ifndef DETECTEDOBJECTSTATE_H
+#define DETECTEDOBJECTSTATE_H
+
+#include <atomic>
+#include "vehicles/objectstate.h"
+
+class DetectedObjectState : public ObjectState
+{
+    Q_OBJECT
+public:
+    DetectedObjectState(ObjectID_t id = 1, Qt::GlobalColor color = Qt::darkMagenta);
+#ifdef QT_GUI_LIB
+    virtual void draw(QPainter &painter, const QTransform &drawTrans, const QTransform &txtTrans, bool isSelected = true) override;
+#endif
+
+    bool isActive() const { return mActive; }
+    void setActive(bool active) { mActive = active; }
+    int getTrackId() const { return mTrackId; }
+    void setTrackId(int trackId) { mTrackId = trackId; }
+
+private:
+    std::atomic<bool> mActive{false};
+    std::atomic<int> mTrackId{-1};
+};
+
+#endif // DETECTEDOBJECTSTATE_H
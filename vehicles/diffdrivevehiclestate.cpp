@@ -26,43 +26,40 @@ void DiffDriveVehicleState::updateOdomPositionAndYaw(double drivenDistance, PosT
     double yaw_rad = currentPosition.getYaw() / (180.0/M_PI);
 
     // TODO: somewhat ugly, updateOdomPositionAndYaw interface in VehicleState needs to be revised
-    static QTime lastTimeCalled = QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc());
-    QTime thisTimeCalled = QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc());
-    int dt_ms = lastTimeCalled.msecsTo(thisTimeCalled);
+    static qint64 lastTimeCalled_ns = utcTime::now_ns();
+    qint64 thisTimeCalled_ns = utcTime::now_ns();
+    double dt_ms = (thisTimeCalled_ns - lastTimeCalled_ns) / 1e6;
 
     double drivenDistLeft = getSpeedLeft() * dt_ms / 1000.0;
     double drivenDistRight = getSpeedRight() * dt_ms / 1000.0;
 
     // Differential drive kinematic model, getWidth() should be distance between center of left/right wheel
-    if (fabs(getSpeedLeft() - getSpeedRight()) > 1e-6) { // Turning
-        double turnRadius = (getWidth() *  (getSpeedLeft() + getSpeedRight())) / (2 * (getSpeedLeft() - getSpeedRight()));
-        double yawChange = (drivenDistRight - drivenDistLeft) / getWidth();
-
-        // TODO the following part is generic -> move to parent class
-        currentPosition.setX(currentPosition.getX() + turnRadius * (sin(yaw_rad - yawChange) - sin(yaw_rad)));
-        currentPosition.setY(currentPosition.getY() + turnRadius * (cos(yaw_rad + yawChange) - cos(yaw_rad)));
-
-        double nextYaw_rad = yaw_rad + yawChange;
-        // normalize Yaw
-        while (nextYaw_rad > M_PI)
-            nextYaw_rad -= 2.0 * M_PI;
-        while (nextYaw_rad < -M_PI)
-            nextYaw_rad += 2.0 * M_PI;
-        currentPosition.setYaw(nextYaw_rad * 180.0 / M_PI);
-    } else { // Driving forward
-        currentPosition.setX(currentPosition.getX() + cos(yaw_rad) * drivenDistance);
-        currentPosition.setY(currentPosition.getY() + sin(yaw_rad) * drivenDistance);
-    }
-
-    currentPosition.setTime(thisTimeCalled);
+    const vehicleKinematics::Pose pose {currentPosition.getX(), currentPosition.getY(), yaw_rad};
+    vehicleKinematics::Pose nextPose;
+    if (fabs(getSpeedLeft() - getSpeedRight()) > 1e-6) // Turning
+        nextPose = getKinematicModel().stepWheels(pose, drivenDistLeft, drivenDistRight);
+    else // Driving forward
+        nextPose = vehicleKinematics::arcStep(pose, drivenDistance, 0.0);
+
+    currentPosition.setXY(nextPose.x, nextPose.y);
+    currentPosition.setYaw(remainder(nextPose.yaw_rad, 2.0 * M_PI) * 180.0 / M_PI);
+
+    currentPosition.setTimestamp_ns(thisTimeCalled_ns);
     setPosition(currentPosition);
 
-    lastTimeCalled = thisTimeCalled;
+    lastTimeCalled_ns = thisTimeCalled_ns;
 }
 
 double DiffDriveVehicleState::steeringCurvatureToSteering(double steeringCurvature)
 {
-    return (getWidth() / 2.0) * steeringCurvature;
+    return getKinematicModel().steeringCurvatureToSteering(steeringCurvature);
+}
+
+vehicleKinematics::DiffDriveModel DiffDriveVehicleState::getKinematicModel() const
+{
+    vehicleKinematics::DiffDriveModel model;
+    model.width_m = getWidth();
+    return model;
 }
 
 double DiffDriveVehicleState::getSpeedLeft() const
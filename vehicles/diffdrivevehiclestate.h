@@ -9,6 +9,7 @@
 #define DIFFDRIVEVEHICLESTATE_H
 
 #include "vehicles/vehiclestate.h"
+#include "vehicles/vehiclekinematics.h"
 
 class DiffDriveVehicleState : public VehicleState
 {
@@ -21,6 +22,7 @@ public:
 
     virtual void updateOdomPositionAndYaw(double drivenDistance, PosType usePosType = PosType::odom) override;
     virtual double steeringCurvatureToSteering(double steeringCurvature) override;
+    vehicleKinematics::DiffDriveModel getKinematicModel() const; // value copy of the static state
 
     double getSpeedLeft() const;
     void setSpeedLeft(double getSpeedLeft);
@@ -0,0 +1,244 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ */
+#include "fleetstatestore.h"
+#include "vehicles/vehiclestate.h"
+
+namespace {
+template<typename Function>
+void forEachColumn(FleetStateStore::Columns &columns, Function function)
+{
+    function(columns.id);
+    function(columns.type);
+    function(columns.x);
+    function(columns.y);
+    function(columns.height);
+    function(columns.yaw_deg);
+    function(columns.speed);
+    function(columns.vx);
+    function(columns.vy);
+    function(columns.vz);
+    function(columns.timestamp_ns);
+    function(columns.length);
+    function(columns.width);
+    function(columns.rearAxleToRearEnd);
+}
+}
+
+PosPoint FleetStateStore::ObjectView::getPosition() const
+{
+    pospoint_t position;
+    if (mStore) {
+        std::shared_lock<std::shared_mutex> lock(mStore->mMutex);
+        int i;
+        if (mStore->getIndexLocked(mId, i)) {
+            const Columns &columns = mStore->mColumns;
+            position.x = columns.x.at(i);
+            position.y = columns.y.at(i);
+            position.height = columns.height.at(i);
+            position.yaw = columns.yaw_deg.at(i);
+            position.timestamp_ns = columns.timestamp_ns.at(i);
+            position.id = mId;
+        }
+    }
+    return PosPoint(position);
+}
+
+qint64 FleetStateStore::ObjectView::getTimestamp_ns() const
+{
+    if (mStore) {
+        std::shared_lock<std::shared_mutex> lock(mStore->mMutex);
+        int i;
+        if (mStore->getIndexLocked(mId, i))
+            return mStore->mColumns.timestamp_ns.at(i);
+    }
+    return utcTime::INVALID;
+}
+
+double FleetStateStore::ObjectView::getSpeed() const
+{
+    if (mStore) {
+        std::shared_lock<std::shared_mutex> lock(mStore->mMutex);
+        int i;
+        if (mStore->getIndexLocked(mId, i))
+            return mStore->mColumns.speed.at(i);
+    }
+    return 0.0;
+}
+
+ObjectState::Velocity FleetStateStore::ObjectView::getVelocity() const
+{
+    if (mStore) {
+        std::shared_lock<std::shared_mutex> lock(mStore->mMutex);
+        int i;
+        if (mStore->getIndexLocked(mId, i)) {
+            const Columns &columns = mStore->mColumns;
+            return {columns.vx.at(i), columns.vy.at(i), columns.vz.at(i)};
+        }
+    }
+    return {0.0, 0.0, 0.0};
+}
+
+WAYWISE_OBJECT_TYPE FleetStateStore::ObjectView::getWaywiseObjectType() const
+{
+    if (mStore) {
+        std::shared_lock<std::shared_mutex> lock(mStore->mMutex);
+        int i;
+        if (mStore->getIndexLocked(mId, i))
+            return mStore->mColumns.type.at(i);
+    }
+    return WAYWISE_OBJECT_TYPE_GENERIC;
+}
+
+FleetStateStore::FleetStateStore(QObject *parent) : QObject(parent)
+{
+
+}
+
+int FleetStateStore::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    return mColumns.size();
+}
+
+bool FleetStateStore::contains(ObjectID_t id) const
+{
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    return mIndexById.contains(id);
+}
+
+QVector<FleetStateStore::ObjectID_t> FleetStateStore::getIds() const
+{
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    return mColumns.id;
+}
+
+void FleetStateStore::setState(ObjectID_t id, const pospoint_t &position, double speed, const ObjectState::Velocity &velocity,
+                               WAYWISE_OBJECT_TYPE type, double length, double width, double rearAxleToRearEnd)
+{
+    std::unique_lock<std::shared_mutex> lock(mMutex);
+    int i;
+    if (!getIndexLocked(id, i)) {
+        i = mColumns.size();
+        mIndexById.insert(id, i);
+        forEachColumn(mColumns, [](auto &column) { column.resize(column.size() + 1); });
+        mColumns.id[i] = id;
+    }
+
+    mColumns.type[i] = type;
+    mColumns.x[i] = position.x;
+    mColumns.y[i] = position.y;
+    mColumns.height[i] = position.height;
+    mColumns.yaw_deg[i] = position.yaw;
+    mColumns.speed[i] = speed;
+    mColumns.vx[i] = velocity.x;
+    mColumns.vy[i] = velocity.y;
+    mColumns.vz[i] = velocity.z;
+    mColumns.timestamp_ns[i] = position.timestamp_ns;
+    mColumns.length[i] = length;
+    mColumns.width[i] = width;
+    mColumns.rearAxleToRearEnd[i] = rearAxleToRearEnd;
+}
+
+void FleetStateStore::setState(const ObjectState &objectState)
+{
+    double length = 0.0, width = 0.0, rearAxleToRearEnd = 0.0;
+    if (const VehicleState *vehicleState = qobject_cast<const VehicleState*>(&objectState)) {
+        length = vehicleState->getLength();
+        width = vehicleState->getWidth();
+        rearAxleToRearEnd = vehicleState->getRearAxleToRearEndOffset().x;
+    }
+    setState(objectState.getId(), objectState.getPosition().toPOD(), objectState.getSpeed(), objectState.getVelocity(),
+             objectState.getWaywiseObjectType(), length, width, rearAxleToRearEnd);
+}
+
+bool FleetStateStore::removeObject(ObjectID_t id)
+{
+    std::unique_lock<std::shared_mutex> lock(mMutex);
+    int i;
+    if (!getIndexLocked(id, i))
+        return false;
+
+    // Move the last object into the gap to keep the columns contiguous
+    const int last = mColumns.size() - 1;
+    if (i != last) {
+        forEachColumn(mColumns, [i, last](auto &column) { column[i] = column.at(last); });
+        mIndexById.insert(mColumns.id.at(i), i);
+    }
+    forEachColumn(mColumns, [](auto &column) { column.removeLast(); });
+    mIndexById.remove(id);
+
+    return true;
+}
+
+void FleetStateStore::clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(mTrackingMutex);
+        for (const auto &tracking : mTrackingById) {
+            disconnect(tracking.positionUpdated);
+            disconnect(tracking.destroyed);
+        }
+        mTrackingById.clear();
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mMutex);
+    forEachColumn(mColumns, [](auto &column) { column.clear(); });
+    mIndexById.clear();
+}
+
+void FleetStateStore::track(QSharedPointer<ObjectState> objectState)
+{
+    if (!objectState)
+        return;
+
+    const ObjectID_t id = objectState->getId();
+    untrack(id, false);
+    setState(*objectState);
+
+    // Direct connections: updates come from the thread of the vehicle connection, sensor, ...
+    ObjectState *object = objectState.get();
+    Tracking tracking;
+    tracking.positionUpdated = connect(object, &ObjectState::positionUpdated, this, [this, object]() { setState(*object); }, Qt::DirectConnection);
+    tracking.destroyed = connect(object, &QObject::destroyed, this, [this, id]() { untrack(id); }, Qt::DirectConnection);
+
+    std::lock_guard<std::mutex> lock(mTrackingMutex);
+    mTrackingById.insert(id, tracking);
+}
+
+void FleetStateStore::untrack(ObjectID_t id, bool remove)
+{
+    {
+        std::lock_guard<std::mutex> lock(mTrackingMutex);
+        if (mTrackingById.contains(id)) {
+            const Tracking tracking = mTrackingById.take(id);
+            disconnect(tracking.positionUpdated);
+            disconnect(tracking.destroyed);
+        }
+    }
+
+    if (remove)
+        removeObject(id);
+}
+
+void FleetStateStore::read(const std::function<void (const Columns &)> &reader) const
+{
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    reader(mColumns);
+}
+
+FleetStateStore::Columns FleetStateStore::snapshot() const
+{
+    std::shared_lock<std::shared_mutex> lock(mMutex);
+    return mColumns;
+}
+
+bool FleetStateStore::getIndexLocked(ObjectID_t id, int &index) const
+{
+    const auto it = mIndexById.constFind(id);
+    if (it == mIndexById.constEnd())
+        return false;
+    index = it.value();
+    return true;
+}
@@ -0,0 +1,101 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Dynamic state of many objects (vehicles, detected objects, ...) in contiguous structure-of-arrays columns, indexed by ObjectID_t.
+ * Meant for code that looks at all objects at once, e.g., map drawing, collision checks or telemetry fan-in, and scales to hundreds of objects.
+ * Tracked ObjectStates update their entry on every positionUpdated, from the thread emitting it. Entries can also be set directly,
+ * e.g., for objects without an ObjectState. ObjectView gives ObjectState-like read access to a single entry.
+ */
+
+#ifndef FLEETSTATESTORE_H
+#define FLEETSTATESTORE_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QSharedPointer>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include "vehicles/objectstate.h"
+
+class FleetStateStore : public QObject
+{
+    Q_OBJECT
+public:
+    typedef ObjectState::ObjectID_t ObjectID_t;
+
+    // Index i of all columns is the same object, order changes when objects are removed
+    struct Columns {
+        QVector<ObjectID_t> id;
+        QVector<WAYWISE_OBJECT_TYPE> type;
+        QVector<double> x, y, height; // [m], ENU
+        QVector<double> yaw_deg;
+        QVector<double> speed; // [m/s]
+        QVector<double> vx, vy, vz; // [m/s]
+        QVector<qint64> timestamp_ns; // UTC
+        // Footprint as CarState::getBoundingBox: [rearAxleToRearEnd:rearAxleToRearEnd+length] x [-width/2:width/2] in the vehicle frame
+        QVector<double> length, width; // [m], 0 if unknown (not a VehicleState)
+        QVector<double> rearAxleToRearEnd; // [m]
+
+        int size() const { return id.size(); }
+    };
+
+    class ObjectView
+    {
+    public:
+        ObjectView(const FleetStateStore *store = nullptr, ObjectID_t id = -1) : mStore(store), mId(id) {}
+        bool isValid() const { return mStore && mStore->contains(mId); }
+
+        // Same as ObjectState
+        ObjectID_t getId() const { return mId; }
+        PosPoint getPosition() const; // x, y, height, yaw and timestamp
+        qint64 getTimestamp_ns() const;
+        double getSpeed() const;
+        ObjectState::Velocity getVelocity() const;
+        WAYWISE_OBJECT_TYPE getWaywiseObjectType() const;
+
+    private:
+        const FleetStateStore *mStore;
+        ObjectID_t mId;
+    };
+
+    FleetStateStore(QObject *parent = nullptr);
+
+    int size() const;
+    bool contains(ObjectID_t id) const;
+    QVector<ObjectID_t> getIds() const;
+    ObjectView getObject(ObjectID_t id) const { return ObjectView(this, id); }
+
+    // Adds the object if it is not in the store yet
+    void setState(ObjectID_t id, const pospoint_t &position, double speed, const ObjectState::Velocity &velocity,
+                  WAYWISE_OBJECT_TYPE type = WAYWISE_OBJECT_TYPE_GENERIC, double length = 0.0, double width = 0.0, double rearAxleToRearEnd = 0.0);
+    void setState(const ObjectState &objectState);
+    bool removeObject(ObjectID_t id);
+    void clear();
+
+    // Fan-in: the object's entry follows its positionUpdated until untracked or destroyed, the id must not change meanwhile
+    void track(QSharedPointer<ObjectState> objectState);
+    void untrack(ObjectID_t id, bool remove = true);
+
+    // All columns consistently, the store is locked against writers while reading, i.e., readers should not block
+    void read(const std::function<void(const Columns &columns)> &reader) const;
+    Columns snapshot() const;
+
+private:
+    bool getIndexLocked(ObjectID_t id, int &index) const;
+
+    struct Tracking {
+        QMetaObject::Connection positionUpdated;
+        QMetaObject::Connection destroyed;
+    };
+
+    mutable std::shared_mutex mMutex;
+    Columns mColumns;
+    QHash<ObjectID_t, int> mIndexById;
+    std::mutex mTrackingMutex;
+    QHash<ObjectID_t, Tracking> mTrackingById;
+};
+
+#endif // FLEETSTATESTORE_H
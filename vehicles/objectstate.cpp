@@ -4,8 +4,11 @@
  */
 
 #include "objectstate.h"
+#include "core/enureprojector.h"
 #include <QDebug>
+#include <QMetaMethod>
 #include <QTextStream>
+#include <algorithm>
 
 ObjectState::ObjectState(ObjectID_t id, Qt::GlobalColor color)
 {
@@ -20,21 +23,84 @@ void ObjectState::setId(int id, bool changeName)
         mName = "";
         QTextStream(&mName) << "Vehicle " << mId;
     }
+    markChanged(FIELD_STATIC);
 }
 
 
 void ObjectState::setPosition(PosPoint &point)
 {
-    mPosition = point;
+    mPosition.store(point.toPOD());
+    markChanged(FIELD_POSITION);
     emit positionUpdated();
 }
 
+void ObjectState::reprojectEnu(const coordinateTransforms::EnuTransform &transform)
+{
+    mPosition.update([&transform](pospoint_t &position) { EnuReprojector::reprojectPoint(transform, position); });
+    markChanged(FIELD_POSITION);
+}
+
 void ObjectState::setDrawStatusText(bool drawStatusText)
 {
     mDrawStatusText = drawStatusText;
+    markChanged(FIELD_STATIC);
 }
 
 bool ObjectState::getDrawStatusText() const
 {
     return mDrawStatusText;
 }
+
+quint64 ObjectState::getStateVersion(quint32 fields) const
+{
+    quint64 version = 0;
+    for (int i = 0; i < STATE_FIELD_COUNT; i++)
+        if (fields & (1u << i))
+            version = std::max(version, mFieldVersions[i].load(std::memory_order_acquire));
+    return version;
+}
+
+quint32 ObjectState::getChangedFields(quint64 sinceVersion, quint32 fields) const
+{
+    quint32 changedFields = FIELD_NONE;
+    for (int i = 0; i < STATE_FIELD_COUNT; i++)
+        if ((fields & (1u << i)) && mFieldVersions[i].load(std::memory_order_acquire) > sinceVersion)
+            changedFields |= (1u << i);
+    return changedFields;
+}
+
+QMetaObject::Connection ObjectState::subscribeStateChanges(quint32 fields, const QObject *context, const std::function<void (quint32)> &callback)
+{
+    return connect(this, &ObjectState::stateChanged, context, [fields, callback](quint32 changedFields, quint64) {
+        if (changedFields & fields)
+            callback(changedFields & fields);
+    });
+}
+
+void ObjectState::markChanged(quint32 fields)
+{
+    const quint64 version = mStateVersion.fetch_add(1, std::memory_order_acq_rel) + 1;
+    for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+        if (!(fields & (1u << i)))
+            continue;
+        // Concurrent setters of the same field: keep the newest version
+        quint64 fieldVersion = mFieldVersions[i].load(std::memory_order_relaxed);
+        while (fieldVersion < version && !mFieldVersions[i].compare_exchange_weak(fieldVersion, version, std::memory_order_acq_rel))
+            ;
+    }
+
+    static const QMetaMethod stateChangedSignal = QMetaMethod::fromSignal(&ObjectState::stateChanged);
+    if (!isSignalConnected(stateChangedSignal))
+        return;
+
+    // The first change since the last emission schedules the next one, later changes are batched into it
+    if (mPendingFields.fetch_or(fields, std::memory_order_acq_rel) == FIELD_NONE)
+        QMetaObject::invokeMethod(this, [this]() { emitStateChanged(); }, Qt::QueuedConnection);
+}
+
+void ObjectState::emitStateChanged()
+{
+    const quint32 changedFields = mPendingFields.exchange(FIELD_NONE, std::memory_order_acq_rel);
+    if (changedFields != FIELD_NONE)
+        emit stateChanged(changedFields, getStateVersion());
+}
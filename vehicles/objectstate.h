@@ -18,6 +18,10 @@
 #endif
 
 #include "core/pospoint.h"
+#include "core/seqlock.h"
+#include <array>
+#include <atomic>
+#include <functional>
 #include <math.h>
 typedef enum WAYWISE_OBJECT_TYPE
 {
@@ -35,6 +39,24 @@ public:
     typedef int ObjectID_t;
     typedef xyz_t Velocity;
     typedef xyz_t Acceleration;
+    // Fields of the state for change notifications (bit mask), setters mark their field as changed, also without a new value
+    enum StateField : quint32 {
+        FIELD_NONE = 0,
+        FIELD_STATIC = 1u << 0, // id, name, color, dimensions, ...
+        FIELD_POSITION = 1u << 1, // any source, also reprojections
+        FIELD_TIMESTAMP = 1u << 2,
+        FIELD_SPEED = 1u << 3,
+        FIELD_VELOCITY = 1u << 4,
+        FIELD_ACCELERATION = 1u << 5,
+        FIELD_STEERING = 1u << 6, // VehicleState from here on
+        FIELD_FLIGHT_MODE = 1u << 7,
+        FIELD_ARMED = 1u << 8,
+        FIELD_HOME_POSITION = 1u << 9,
+        FIELD_AUTOPILOT = 1u << 10, // radius, target point, end goal alignment
+        FIELD_IMU = 1u << 11, // gyroscope, accelerometer
+        FIELD_ALL = (1u << 12) - 1
+    };
+    static constexpr int STATE_FIELD_COUNT = 12;
     ObjectState(ObjectID_t id = 1, Qt::GlobalColor color = Qt::red);
     virtual void provideParametersToParameterServer() {}; // Provide using ParameterServer in child classes (if implemented)
 #ifdef QT_GUI_LIB
@@ -46,29 +68,47 @@ public:
     ObjectID_t getId() const { return mId; }
     void setId(ObjectID_t id, bool changeName = false);
     QString getName() const { return mName; }
-    void setName(const QString& name) { mName = name; }
+    void setName(const QString& name) { mName = name; markChanged(FIELD_STATIC); }
     Qt::GlobalColor getColor() const { return mColor; }
-    void setColor(const Qt::GlobalColor color) { mColor = color; }
+    void setColor(const Qt::GlobalColor color) { mColor = color; markChanged(FIELD_STATIC); }
     WAYWISE_OBJECT_TYPE getWaywiseObjectType() const { return mWaywiseObjectType; }
-    void setWaywiseObjectType(const WAYWISE_OBJECT_TYPE value) { mWaywiseObjectType = value; }
+    void setWaywiseObjectType(const WAYWISE_OBJECT_TYPE value) { mWaywiseObjectType = value; markChanged(FIELD_STATIC); }
 
-    // Dynamic state
-    virtual PosPoint getPosition() const { return mPosition; }
+    // Dynamic state, can be written and read concurrently from different threads (e.g., vehicle connection callbacks vs. GUI/autopilot)
+    virtual PosPoint getPosition() const { return PosPoint(mPosition.load()); }
     virtual void setPosition(PosPoint &point);
-    virtual QTime getTime() const { return mPosition.getTime(); }
-    virtual void setTime(const QTime &time) { mPosition.setTime(time); }
+    // Converts the positions to another ENU reference, e.g., on a worker thread of EnuReprojector. Does not emit positionUpdated (marks FIELD_POSITION).
+    virtual void reprojectEnu(const coordinateTransforms::EnuTransform &transform);
+    virtual qint64 getTimestamp_ns() const { return mPosition.load().timestamp_ns; } // UTC [ns], see utcTime
+    virtual void setTimestamp_ns(qint64 timestamp_ns) { mPosition.update([timestamp_ns](pospoint_t &position) { position.timestamp_ns = timestamp_ns; }); markChanged(FIELD_TIMESTAMP); }
+    QTime getTime() const { return utcTime::toTimeOfDay(getTimestamp_ns()); }
+    void setTime(const QTime &time) { setTimestamp_ns(utcTime::fromTimeOfDay(time)); }
     virtual double getSpeed() const { return mSpeed; }
-    virtual void setSpeed(double value) { mSpeed = value; }
-    virtual Velocity getVelocity() const { return mVelocity; }
-    virtual void setVelocity(const Velocity &velocity) { mVelocity = velocity; }
-    virtual Acceleration getAcceleration() const { return mAcceleration; }
-    virtual void setAcceleration(const Acceleration &acceleration) { mAcceleration = acceleration; }
+    virtual void setSpeed(double value) { mSpeed = value; markChanged(FIELD_SPEED); }
+    virtual Velocity getVelocity() const { return mVelocity.load(); }
+    virtual void setVelocity(const Velocity &velocity) { mVelocity.store(velocity); markChanged(FIELD_VELOCITY); }
+    virtual Acceleration getAcceleration() const { return mAcceleration.load(); }
+    virtual void setAcceleration(const Acceleration &acceleration) { mAcceleration.store(acceleration); markChanged(FIELD_ACCELERATION); }
 
     void setDrawStatusText(bool drawStatusText);
     bool getDrawStatusText() const;
 
+    // Versioned state: every change increments the state version, a field's version is the state version of its last change.
+    // Consumers remember the version they have handled and skip their work while their fields did not change since.
+    quint64 getStateVersion() const { return mStateVersion.load(std::memory_order_acquire); }
+    quint64 getStateVersion(quint32 fields) const; // of the latest change to any of the fields
+    quint32 getChangedFields(quint64 sinceVersion, quint32 fields = FIELD_ALL) const;
+    // Calls callback (in the thread of context) with the changed ones of fields for each stateChanged that includes any of them
+    QMetaObject::Connection subscribeStateChanges(quint32 fields, const QObject *context, const std::function<void(quint32 changedFields)> &callback);
+
 signals:
     void positionUpdated();
+    // Batched: emitted in the thread of the object at most once per event loop iteration, with all fields changed since
+    // the previous emission. Changes are only collected while the signal is connected.
+    void stateChanged(quint32 changedFields, quint64 stateVersion);
+
+protected:
+    void markChanged(quint32 fields); // thread-safe, after the new value is stored
 
 private:
     // Static state
@@ -78,12 +118,18 @@ private:
     bool mDrawStatusText = true;
     WAYWISE_OBJECT_TYPE mWaywiseObjectType = WAYWISE_OBJECT_TYPE_GENERIC;
 
+    // Change tracking
+    void emitStateChanged();
+    std::atomic<quint64> mStateVersion{0};
+    std::array<std::atomic<quint64>, STATE_FIELD_COUNT> mFieldVersions{};
+    std::atomic<quint32> mPendingFields{0}; // since the last stateChanged, non-zero while an emission is scheduled
+
 protected:
-    // Dynamic state
-    PosPoint mPosition;
-    double mSpeed = 0.0; // [m/s]
-    Velocity mVelocity = {0.0, 0.0, 0.0}; // [m/s]
-    Acceleration mAcceleration = {0.0, 0.0, 0.0}; // [m/s²]
+    // Dynamic state, published as consistent snapshots (PosPoint::getInfo() is not part of them)
+    SeqLock<pospoint_t> mPosition;
+    std::atomic<double> mSpeed{0.0}; // [m/s]
+    SeqLock<Velocity> mVelocity{Velocity{0.0, 0.0, 0.0}}; // [m/s]
+    SeqLock<Acceleration> mAcceleration{Acceleration{0.0, 0.0, 0.0}}; // [m/s²]
 };
 
 
@@ -0,0 +1,85 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Lookup tables (uniform grid, linear interpolation) for the steering geometry of a car-type vehicle, built once per
+ * wheelbase and max. steering angle instead of evaluating sqrt/atan on each call:
+ * steering -> yaw curvature of the bicycle model (see CarState::getYawCurvature) and
+ * steering curvature -> normalized steering (see CarState::steeringCurvatureToSteering).
+ * The interpolation error is below 1e-5 (relative to the full range) for max. steering angles up to 60°.
+ */
+
+#ifndef STEERINGGEOMETRYTABLE_H
+#define STEERINGGEOMETRYTABLE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+class SteeringGeometryTable
+{
+public:
+    static constexpr int TABLE_SIZE = 513; // odd, i.e., 0 is a grid point
+
+    void build(double axisDistance_m, double maxSteeringAngle_rad) {
+        mAxisDistance = axisDistance_m;
+        mMaxSteeringAngle = maxSteeringAngle_rad;
+        mMaxSteering = tan(maxSteeringAngle_rad);
+        mMaxCurvature = mMaxSteering / axisDistance_m;
+
+        for (int i = 0; i < TABLE_SIZE; i++) {
+            const double ratio = -1.0 + 2.0 * i / (TABLE_SIZE - 1);
+            mYawCurvature[i] = computeYawCurvature(ratio * mMaxSteering);
+            mNormalizedSteering[i] = computeNormalizedSteering(ratio * mMaxCurvature);
+        }
+    }
+
+    double getAxisDistance() const { return mAxisDistance; }
+    double getMaxSteeringAngle() const { return mMaxSteeringAngle; }
+    double getMaxSteering() const { return mMaxSteering; } // tan(max. steering angle)
+    double getMaxCurvature() const { return mMaxCurvature; } // [1/m] at max. steering angle
+
+    // steering: as in VehicleState::setSteering, computed directly beyond getMaxSteering()
+    double getYawCurvature(double steering) const {
+        if (fabs(steering) > mMaxSteering)
+            return computeYawCurvature(steering);
+        return interpolate(mYawCurvature, steering / mMaxSteering);
+    }
+
+    // [-1.0:1.0], saturated beyond getMaxCurvature()
+    double getNormalizedSteering(double steeringCurvature) const {
+        if (fabs(steeringCurvature) >= mMaxCurvature)
+            return steeringCurvature > 0.0 ? 1.0 : -1.0;
+        return interpolate(mNormalizedSteering, steeringCurvature / mMaxCurvature);
+    }
+
+    // Reference implementations the tables are built from
+    double computeYawCurvature(double steering) const {
+        // 1 / mean of rear and front turn radius, sign as the rear turn radius; steering approximates tan(steering angle)
+        return -steering * 2.0 / (1.0 + sqrt(1.0 + steering * steering)) / mAxisDistance;
+    }
+    double computeNormalizedSteering(double steeringCurvature) const {
+        double steeringAngle_rad = atan(mAxisDistance * steeringCurvature);
+        if (fabs(steeringAngle_rad) > mMaxSteeringAngle)
+            steeringAngle_rad = mMaxSteeringAngle * ((steeringAngle_rad > 0) ? 1.0 : -1.0);
+        return steeringAngle_rad / mMaxSteeringAngle;
+    }
+
+private:
+    // ratio: [-1.0:1.0] over the table
+    static double interpolate(const std::array<double, TABLE_SIZE> &table, double ratio) {
+        const double position = (ratio + 1.0) * 0.5 * (TABLE_SIZE - 1);
+        const int index = std::min(int(position), TABLE_SIZE - 2);
+        const double fraction = position - index;
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    double mAxisDistance = 1.0;
+    double mMaxSteeringAngle = M_PI / 4.0;
+    double mMaxSteering = 1.0;
+    double mMaxCurvature = 1.0;
+    std::array<double, TABLE_SIZE> mYawCurvature {}; // over [-getMaxSteering():getMaxSteering()]
+    std::array<double, TABLE_SIZE> mNormalizedSteering {}; // over [-getMaxCurvature():getMaxCurvature()]
+};
+
+#endif // STEERINGGEOMETRYTABLE_H
@@ -0,0 +1,169 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Kinematic truck and (single axle) trailer model over driven distance, e.g., to forward-simulate candidate steering
+ * sequences of a reversing controller over its horizon. The truck's rear axle moves on an arc per step (exact for constant
+ * curvature), the trailer follows the hitch (midpoint rule):
+ *
+ *     d(trailerYaw)/ds = (sin(phi) + hitchOffset * curvature * cos(phi)) / trailerWheelbase,   phi = yaw - trailerYaw (hitch angle)
+ *
+ * with hitchOffset the hitch's x in the truck's rear axle frame (negative: behind) and ds the signed driven distance.
+ * linearize() gives the analytical Jacobians of exactly that step, CandidateBatch steps many candidates in lock-step
+ * (structure of arrays, the inner loops run over candidates). Nothing allocates. Angles in radians, ENU.
+ */
+
+#ifndef TRAILERKINEMATICS_H
+#define TRAILERKINEMATICS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "core/fixedmatrix.h"
+
+namespace trailerKinematics {
+
+struct Parameters {
+    double hitchOffset_m = 0.0; // x of the hitch in the truck's rear axle frame
+    double trailerWheelbase_m = 1.0; // hitch to trailer rear axle
+};
+
+struct State {
+    double x = 0.0; // truck rear axle [m]
+    double y = 0.0;
+    double yaw_rad = 0.0;
+    double trailerYaw_rad = 0.0;
+
+    double getHitchAngle_rad() const { return normalizeAngle(yaw_rad - trailerYaw_rad); }
+    static double normalizeAngle(double angle_rad) { return std::remainder(angle_rad, 2.0 * M_PI); }
+};
+
+using StateJacobian = FixedMatrix<4, 4>; // d(next state)/d(state), order x, y, yaw, trailerYaw
+using CurvatureJacobian = FixedMatrix<4, 1>; // d(next state)/d(curvature)
+
+namespace detail {
+// sin(h) / h and its derivative, i.e., the chord of an arc with yaw change 2h relative to its length
+inline void chordFactor(double h, double &factor, double &derivative)
+{
+    if (std::fabs(h) > 1e-4) {
+        factor = std::sin(h) / h;
+        derivative = (std::cos(h) - factor) / h;
+    } else {
+        factor = 1.0 - h * h / 6.0;
+        derivative = -h / 3.0;
+    }
+}
+}
+
+inline double trailerYawRate(const Parameters &parameters, double hitchAngle_rad, double curvature)
+{
+    return (std::sin(hitchAngle_rad) + parameters.hitchOffset_m * curvature * std::cos(hitchAngle_rad)) / parameters.trailerWheelbase_m;
+}
+
+// Truck curvature that keeps the hitch angle constant (the combination drives on a circle), e.g., as feed-forward when reversing
+inline double equilibriumCurvature(const Parameters &parameters, double hitchAngle_rad)
+{
+    return std::sin(hitchAngle_rad) / (parameters.trailerWheelbase_m - parameters.hitchOffset_m * std::cos(hitchAngle_rad));
+}
+
+// curvature: of the truck's rear axle [1/m] (e.g., CarState::getYawCurvature), ds: driven distance [m], negative when reversing
+inline State step(const Parameters &parameters, const State &state, double curvature, double ds)
+{
+    State next;
+    const double yawMid = state.yaw_rad + 0.5 * curvature * ds;
+    double chordFactor, chordFactorDerivative;
+    detail::chordFactor(0.5 * curvature * ds, chordFactor, chordFactorDerivative);
+    next.x = state.x + ds * chordFactor * std::cos(yawMid);
+    next.y = state.y + ds * chordFactor * std::sin(yawMid);
+    next.yaw_rad = state.yaw_rad + curvature * ds;
+
+    const double trailerYawMid = state.trailerYaw_rad + 0.5 * ds * trailerYawRate(parameters, state.yaw_rad - state.trailerYaw_rad, curvature);
+    next.trailerYaw_rad = state.trailerYaw_rad + ds * trailerYawRate(parameters, yawMid - trailerYawMid, curvature);
+    return next;
+}
+
+// Jacobians of step() at state and curvature, e.g., for iterative (LQR/Gauss-Newton) refinement of a steering sequence
+inline void linearize(const Parameters &parameters, const State &state, double curvature, double ds,
+                      StateJacobian &stateJacobian, CurvatureJacobian &curvatureJacobian)
+{
+    const double a = parameters.hitchOffset_m;
+    const double trailerWheelbase = parameters.trailerWheelbase_m;
+    auto rateByHitchAngle = [&](double phi) { return (std::cos(phi) - a * curvature * std::sin(phi)) / trailerWheelbase; };
+    auto rateByCurvature = [&](double phi) { return a * std::cos(phi) / trailerWheelbase; };
+
+    stateJacobian = StateJacobian::identity();
+    curvatureJacobian = CurvatureJacobian();
+
+    // Truck on the arc, i.e., on its chord
+    const double yawMid = state.yaw_rad + 0.5 * curvature * ds;
+    double chordFactor, chordFactorDerivative;
+    detail::chordFactor(0.5 * curvature * ds, chordFactor, chordFactorDerivative);
+    const double cosYawMid = std::cos(yawMid);
+    const double sinYawMid = std::sin(yawMid);
+    stateJacobian(0, 2) = -ds * chordFactor * sinYawMid;
+    stateJacobian(1, 2) = ds * chordFactor * cosYawMid;
+    curvatureJacobian(0, 0) = 0.5 * ds * ds * (chordFactorDerivative * cosYawMid - chordFactor * sinYawMid);
+    curvatureJacobian(1, 0) = 0.5 * ds * ds * (chordFactorDerivative * sinYawMid + chordFactor * cosYawMid);
+    curvatureJacobian(2, 0) = ds;
+
+    // Trailer, midpoint rule
+    const double phi0 = state.yaw_rad - state.trailerYaw_rad;
+    const double trailerYawMid = state.trailerYaw_rad + 0.5 * ds * trailerYawRate(parameters, phi0, curvature);
+    const double phiMid = state.yaw_rad + 0.5 * curvature * ds - trailerYawMid;
+
+    const double phiMidByYaw = 1.0 - 0.5 * ds * rateByHitchAngle(phi0);
+    const double phiMidByTrailerYaw = -phiMidByYaw;
+    const double phiMidByCurvature = 0.5 * ds * (1.0 - rateByCurvature(phi0));
+    const double rateMidByHitchAngle = rateByHitchAngle(phiMid);
+
+    stateJacobian(3, 2) = ds * rateMidByHitchAngle * phiMidByYaw;
+    stateJacobian(3, 3) = 1.0 + ds * rateMidByHitchAngle * phiMidByTrailerYaw;
+    curvatureJacobian(3, 0) = ds * (rateMidByHitchAngle * phiMidByCurvature + rateByCurvature(phiMid));
+}
+
+// Steps up to MaxCandidates candidates at once, i.e., one call per horizon step instead of one per candidate and step
+template<int MaxCandidates>
+struct CandidateBatch {
+    int numCandidates = 0;
+    std::array<double, MaxCandidates> x {};
+    std::array<double, MaxCandidates> y {};
+    std::array<double, MaxCandidates> yaw_rad {};
+    std::array<double, MaxCandidates> trailerYaw_rad {};
+
+    void reset(const State &initial, int candidates) {
+        numCandidates = std::min(candidates, MaxCandidates);
+        x.fill(initial.x);
+        y.fill(initial.y);
+        yaw_rad.fill(initial.yaw_rad);
+        trailerYaw_rad.fill(initial.trailerYaw_rad);
+    }
+
+    State getState(int candidate) const { return {x[candidate], y[candidate], yaw_rad[candidate], trailerYaw_rad[candidate]}; }
+
+    // curvatures: one per candidate for this step. Same as step(), but sin(h)/h of the chord is taken from its series
+    // (no branch or division, i.e., vectorizable; accurate to 1e-9 for yaw changes of up to 0.5 rad per step).
+    void step(const Parameters &parameters, const double *curvatures, double ds) {
+        const double inverseTrailerWheelbase = 1.0 / parameters.trailerWheelbase_m;
+        const double a = parameters.hitchOffset_m;
+        for (int i = 0; i < numCandidates; i++) {
+            const double curvature = curvatures[i];
+            const double yawChange = curvature * ds;
+            const double yawMid = yaw_rad[i] + 0.5 * yawChange;
+
+            const double phi0 = yaw_rad[i] - trailerYaw_rad[i];
+            const double trailerYawMid = trailerYaw_rad[i] + 0.5 * ds * (std::sin(phi0) + a * curvature * std::cos(phi0)) * inverseTrailerWheelbase;
+            const double phiMid = yawMid - trailerYawMid;
+            trailerYaw_rad[i] += ds * (std::sin(phiMid) + a * curvature * std::cos(phiMid)) * inverseTrailerWheelbase;
+
+            const double halfYawChange2 = 0.25 * yawChange * yawChange;
+            const double chord = ds * (1.0 - halfYawChange2 / 6.0 * (1.0 - halfYawChange2 / 20.0 * (1.0 - halfYawChange2 / 42.0)));
+            x[i] += chord * std::cos(yawMid);
+            y[i] += chord * std::sin(yawMid);
+            yaw_rad[i] += yawChange;
+        }
+    }
+};
+
+}
+
+#endif // TRAILERKINEMATICS_H
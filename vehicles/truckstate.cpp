@@ -37,6 +37,19 @@ void TruckState::updateOdomPositionAndYaw(double drivenDistance, PosType usePosT
     CarState::updateOdomPositionAndYaw(drivenDistance, usePosType);
 }
 
+double TruckState::getMaxSimulationSubstepDistance() const
+{
+    // The trailer's yaw changes by at most drivenDistance / wheelbase
+    if (hasTrailingVehicle() && mSimulateTrailer && getTrailingVehicle()->getWheelBase() > 0.0)
+        return MAX_SUBSTEP_YAW_CHANGE_rad * getTrailingVehicle()->getWheelBase();
+    return CarState::getMaxSimulationSubstepDistance();
+}
+
+void TruckState::simulationSubstepIntegrated(double drivenDistance, PosType usePosType)
+{
+    updateTrailingVehicleOdomPositionAndYaw(drivenDistance, usePosType);
+}
+
 void TruckState::setPosition(PosPoint &point)
 {
     CarState::setPosition(point);
@@ -45,6 +58,42 @@ void TruckState::setPosition(PosPoint &point)
     }
 }
 
+void TruckState::updatePosition(PosType type, const std::function<void (PosPoint &)> &modify)
+{
+    CarState::updatePosition(type, modify);
+    if (hasTrailingVehicle()){
+        updateTrailingVehicleOdomPositionAndYaw(0, type);
+    }
+}
+
+trailerKinematics::Parameters TruckState::getTrailerKinematicsParameters() const
+{
+    trailerKinematics::Parameters parameters;
+    parameters.hitchOffset_m = getRearAxleToHitchOffset().x;
+    if (hasTrailingVehicle())
+        parameters.trailerWheelbase_m = getTrailingVehicle()->getWheelBase();
+    return parameters;
+}
+
+trailerKinematics::State TruckState::getTrailerKinematicsState(PosType type) const
+{
+    const PosPoint position = getPosition(type);
+    trailerKinematics::State state;
+    state.x = position.getX();
+    state.y = position.getY();
+    state.yaw_rad = position.getYaw() * M_PI / 180.0;
+    state.trailerYaw_rad = hasTrailingVehicle() ? getTrailingVehicle()->getPosition(type).getYaw() * M_PI / 180.0 : state.yaw_rad;
+    return state;
+}
+
+vehicleKinematics::TruckTrailerModel TruckState::getTruckTrailerModel() const
+{
+    vehicleKinematics::TruckTrailerModel model;
+    model.truck = getKinematicModel();
+    model.trailer = getTrailerKinematicsParameters();
+    return model;
+}
+
 bool TruckState::getSimulateTrailer() const
 {
     return mSimulateTrailer;
@@ -66,7 +115,7 @@ void TruckState::updateTrailingVehicleOdomPositionAndYaw(double drivenDistance,
 
         double trailerYaw_rad = trailer->getPosition(usePosType).getYaw() * M_PI / 180.0;
         if (mSimulateTrailer) { // We do not get external updates on the trailer angle -> simple estimation
-            trailerYaw_rad = trailerYaw_rad + ((drivenDistance / trailer->getWheelBase()) * sin(currYaw_rad - trailerYaw_rad));
+            trailerYaw_rad += drivenDistance * trailerKinematics::trailerYawRate(getTrailerKinematicsParameters(), currYaw_rad - trailerYaw_rad, getYawCurvature(getSteering()));
             trailerYaw_rad = fmod(trailerYaw_rad + M_PI, 2 * M_PI) - M_PI;
             setTrailerAngle((currYaw_rad - trailerYaw_rad) * 180.0 / M_PI);
         } else {
@@ -76,7 +125,7 @@ void TruckState::updateTrailingVehicleOdomPositionAndYaw(double drivenDistance,
         currentTrailerPosition.setXYZ(truckHitchPosition.getXYZ());
         xyz_t trailerHitchToTrailerRearAxleOffset = -(getTrailingVehicle()->getRearAxleToHitchOffset());
         currentTrailerPosition.updateWithOffsetAndYawRotation(trailerHitchToTrailerRearAxleOffset, trailerYaw_rad);
-        currentTrailerPosition.setTime(QTime::currentTime().addSecs(-QDateTime::currentDateTime().offsetFromUtc()));
+        currentTrailerPosition.setTimestamp_ns(utcTime::now_ns());
         trailer->setPosition(currentTrailerPosition);
     }
 }
@@ -118,9 +167,9 @@ void TruckState::setTrailingVehicle(QSharedPointer<TrailerState> trailer)
     VehicleState::setTrailingVehicle(trailer);
 }
 
-void TruckState::setTrailerAngle(double angle_deg)
+void TruckState::setTrailerAngle(double angle_deg, qint64 timestamp_ns)
 {
-    mTrailerAngle_deg = angle_deg;
+    mTrailerAngle.store({angle_deg, timestamp_ns});
 }
 
 void TruckState::provideParametersToParameterServer()
@@ -183,24 +232,30 @@ void TruckState::draw(QPainter &painter, const QTransform &drawTrans, const QTra
         painter.drawEllipse(pos.getPointMm(), pos.getSigma() * 1000.0, pos.getSigma() * 1000.0);
     }
 
-    // Draw truck
+    // Draw truck, pre-rendered as long as its look and the zoom level do not change
     painter.save();
     painter.translate(x, y);
     painter.rotate(pos.getYaw());
-    // Rear axle wheels
-    double wheel_diameter = truck_len / 6.0;
-    double wheel_width = truck_w / 12.0;
-    painter.setBrush(QBrush(col_wheels));
-    painter.drawRoundedRect(- wheel_diameter/2, - (truck_w / 2 + wheel_width / 2), wheel_diameter, (truck_w + wheel_width), truck_corner / 3, truck_corner / 3);
-    // Front axle wheels
-    wheel_diameter = truck_len / 10.0;
-    painter.drawRoundedRect(wheelbase - wheel_diameter/2, -(truck_w / 2 + wheel_width / 2), wheel_diameter, (truck_w + wheel_width), truck_corner / 3, truck_corner / 3);
-    // Front bumper
-    painter.setBrush(col_bumper);
-    painter.drawRoundedRect(rearAxleToRearEndOffsetX, -((truck_w - truck_len / 20.0) / 2.0), truck_len, truck_w - truck_len / 20.0, truck_corner, truck_corner);
-    // Hull
-    painter.setBrush(col_hull);
-    painter.drawRoundedRect(rearAxleToRearEndOffsetX, -((truck_w - truck_len / 20.0) / 2.0), truck_len - (truck_len / 20.0), truck_w - truck_len / 20.0, truck_corner, truck_corner);
+    const double rear_wheel_diameter = truck_len / 6.0;
+    const double front_wheel_diameter = truck_len / 10.0;
+    const double wheel_width = truck_w / 12.0;
+    const double penMargin = painter.pen().widthF() / 2.0;
+    const QRectF bodyBounds = QRectF(QPointF(std::min(-rear_wheel_diameter/2, rearAxleToRearEndOffsetX), -(truck_w / 2 + wheel_width / 2)),
+                                     QPointF(std::max(wheelbase + front_wheel_diameter/2, rearAxleToRearEndOffsetX + truck_len), truck_w / 2 + wheel_width / 2))
+            .adjusted(-penMargin, -penMargin, penMargin, penMargin);
+    mBodyGlyphCache.draw(painter, bodyBounds, {truck_len, truck_w, rearAxleToRearEndOffsetX, wheelbase, double(getColor()), double(isSelected)}, [&](QPainter &glyphPainter) {
+        // Rear axle wheels
+        glyphPainter.setBrush(QBrush(col_wheels));
+        glyphPainter.drawRoundedRect(- rear_wheel_diameter/2, - (truck_w / 2 + wheel_width / 2), rear_wheel_diameter, (truck_w + wheel_width), truck_corner / 3, truck_corner / 3);
+        // Front axle wheels
+        glyphPainter.drawRoundedRect(wheelbase - front_wheel_diameter/2, -(truck_w / 2 + wheel_width / 2), front_wheel_diameter, (truck_w + wheel_width), truck_corner / 3, truck_corner / 3);
+        // Front bumper
+        glyphPainter.setBrush(col_bumper);
+        glyphPainter.drawRoundedRect(rearAxleToRearEndOffsetX, -((truck_w - truck_len / 20.0) / 2.0), truck_len, truck_w - truck_len / 20.0, truck_corner, truck_corner);
+        // Hull
+        glyphPainter.setBrush(col_hull);
+        glyphPainter.drawRoundedRect(rearAxleToRearEndOffsetX, -((truck_w - truck_len / 20.0) / 2.0), truck_len - (truck_len / 20.0), truck_w - truck_len / 20.0, truck_corner, truck_corner);
+    });
 
     if (hasTrailingVehicle())
     {
@@ -257,49 +312,56 @@ void TruckState::draw(QPainter &painter, const QTransform &drawTrans, const QTra
     painter.setPen(Qt::black);
 
     if (getDrawStatusText()) {
-        // Print data
-        QString txt;
+        // Print data, laid out again only when a shown value changes
         QPointF pt_txt;
-        QRectF rect_txt;
-
-        QString flightModeStr;
-        switch (getFlightMode()) {
-            case FlightMode::Unknown: flightModeStr = "unknown"; break;
-            case FlightMode::Ready: flightModeStr = "ready"; break;
-            case FlightMode::Takeoff: flightModeStr = "takeoff"; break;
-            case FlightMode::Hold: flightModeStr = "hold"; break;
-            case FlightMode::Mission: flightModeStr = "mission"; break;
-            case FlightMode::ReturnToLaunch: flightModeStr = "return to launch"; break;
-            case FlightMode::Land: flightModeStr = "land"; break;
-            case FlightMode::Offboard: flightModeStr = "offboard"; break;
-            case FlightMode::FollowMe: flightModeStr = "follow me"; break;
-            case FlightMode::Manual: flightModeStr = "manual"; break;
-            case FlightMode::Altctl: flightModeStr = "altitude"; break;
-            case FlightMode::Posctl: flightModeStr = "position"; break;
-            case FlightMode::Acro: flightModeStr = "acro"; break;
-            case FlightMode::Stabilized: flightModeStr = "stabilized"; break;
-            case FlightMode::Rattitude: flightModeStr = "rattitude"; break;
+        const PosPoint trailerPos = hasTrailingVehicle() ? getTrailingVehicle()->getPosition() : PosPoint();
+        const QString trailerName = hasTrailingVehicle() ? getTrailingVehicle()->getName() : QString();
+
+        if (mStatusTextCache.needsUpdate(getName() + trailerName,
+                                         {VehicleDrawInputs::roundToSignificantDigits(pos.getX(), 3), VehicleDrawInputs::roundToSignificantDigits(pos.getY(), 3),
+                                          VehicleDrawInputs::roundToSignificantDigits(pos.getHeight(), 3), VehicleDrawInputs::roundToSignificantDigits(pos.getYaw(), 3),
+                                          double(getIsArmed()), double(int(getFlightMode())), double(hasTrailingVehicle()),
+                                          VehicleDrawInputs::roundToSignificantDigits(trailerPos.getX(), 3), VehicleDrawInputs::roundToSignificantDigits(trailerPos.getY(), 3),
+                                          VehicleDrawInputs::roundToSignificantDigits(trailerPos.getHeight(), 3), VehicleDrawInputs::roundToSignificantDigits(trailerPos.getYaw(), 3)})) {
+            QString txt;
+            QString flightModeStr;
+            switch (getFlightMode()) {
+                case FlightMode::Unknown: flightModeStr = "unknown"; break;
+                case FlightMode::Ready: flightModeStr = "ready"; break;
+                case FlightMode::Takeoff: flightModeStr = "takeoff"; break;
+                case FlightMode::Hold: flightModeStr = "hold"; break;
+                case FlightMode::Mission: flightModeStr = "mission"; break;
+                case FlightMode::ReturnToLaunch: flightModeStr = "return to launch"; break;
+                case FlightMode::Land: flightModeStr = "land"; break;
+                case FlightMode::Offboard: flightModeStr = "offboard"; break;
+                case FlightMode::FollowMe: flightModeStr = "follow me"; break;
+                case FlightMode::Manual: flightModeStr = "manual"; break;
+                case FlightMode::Altctl: flightModeStr = "altitude"; break;
+                case FlightMode::Posctl: flightModeStr = "position"; break;
+                case FlightMode::Acro: flightModeStr = "acro"; break;
+                case FlightMode::Stabilized: flightModeStr = "stabilized"; break;
+                case FlightMode::Rattitude: flightModeStr = "rattitude"; break;
+            }
+
+            QTextStream txtStream(&txt);
+            txtStream.setRealNumberPrecision(3);
+            txtStream << getName() << Qt::endl
+                      << "(" << pos.getX() << ", " << pos.getY() << ", " << pos.getHeight() << ", " << pos.getYaw() << ")" << Qt::endl
+                      << "State: " << (getIsArmed() ? "armed" : "disarmed") << Qt::endl
+                      << flightModeStr << Qt::endl << Qt::endl;
+            if (hasTrailingVehicle()) {
+                txtStream << getTrailingVehicle()->getName() << Qt::endl
+                        << "(" << trailerPos.getX() << ", " << trailerPos.getY() << ", " << trailerPos.getHeight() << ", "
+                        << trailerPos.getYaw()<< ")" << Qt::endl;
+            }
+            mStatusTextCache.setText(txt);
         }
 
-        QTextStream txtStream(&txt);
-        txtStream.setRealNumberPrecision(3);
-        txtStream << getName() << Qt::endl
-                  << "(" << pos.getX() << ", " << pos.getY() << ", " << pos.getHeight() << ", " << pos.getYaw() << ")" << Qt::endl
-                  << "State: " << (getIsArmed() ? "armed" : "disarmed") << Qt::endl
-                  << flightModeStr << Qt::endl << Qt::endl;
-        if (hasTrailingVehicle()) {
-            PosPoint trailerPos = getTrailingVehicle()->getPosition();
-            txtStream << getTrailingVehicle()->getName() << Qt::endl
-                    << "(" << trailerPos.getX() << ", " << trailerPos.getY() << ", " << trailerPos.getHeight() << ", "
-                    << trailerPos.getYaw()<< ")" << Qt::endl;
-        }
         pt_txt.setX(x + truck_w + truck_len * ((cos(getPosition().getYaw() * (M_PI/180.0)) + 1) / 3));
         pt_txt.setY(y);
         painter.setTransform(txtTrans);
         pt_txt = drawTrans.map(pt_txt);
-        rect_txt.setCoords(pt_txt.x(), pt_txt.y() - 40,
-                           pt_txt.x() + 400, pt_txt.y() + 65);
-        painter.drawText(rect_txt, txt);
+        mStatusTextCache.draw(painter, QPointF(pt_txt.x(), pt_txt.y() - 40));
     }
 
 }
@@ -8,8 +8,17 @@
 
 #include "vehicles/carstate.h"
 #include "vehicles/trailerstate.h"
+#include "vehicles/trailerkinematics.h"
+#include "vehicles/vehiclekinematics.h"
+#include "core/seqlock.h"
+#include "core/utctime.h"
 #include <QSharedPointer>
 
+struct TrailerAngleSample {
+    double angle_deg = 0.0;
+    qint64 timestamp_ns = utcTime::INVALID; // UTC, when it was measured (if known)
+};
+
 class TruckState : public CarState
 {
     Q_OBJECT
@@ -29,11 +38,19 @@ public:
 
     QSharedPointer<TrailerState> getTrailingVehicle() const;
     void setTrailingVehicle(QSharedPointer<TrailerState> trailer);
-    // Additional set/get state for angle of trailing vehicle towards us / ego vehicle
-    double getTrailerAngleRadians() const { return mTrailerAngle_deg * (M_PI / 180.0); }
-    double getTrailerAngleDegrees() const { return mTrailerAngle_deg; }
-    void setTrailerAngle(double angle_deg);
+    // Additional set/get state for angle of trailing vehicle towards us / ego vehicle.
+    // Lock-free, e.g., set by a high-rate angle sensor on its own thread and read by the control loop.
+    double getTrailerAngleRadians() const { return getTrailerAngleDegrees() * (M_PI / 180.0); }
+    double getTrailerAngleDegrees() const { return mTrailerAngle.load().angle_deg; }
+    TrailerAngleSample getTrailerAngleSample() const { return mTrailerAngle.load(); }
+    void setTrailerAngle(double angle_deg, qint64 timestamp_ns = utcTime::INVALID);
     virtual void setPosition(PosPoint &point) override;
+    virtual void updatePosition(PosType type, const std::function<void(PosPoint&)> &modify) override;
+
+    // Truck and trailer as trailerKinematics model, e.g., to forward-simulate candidate steering sequences when reversing
+    trailerKinematics::Parameters getTrailerKinematicsParameters() const;
+    trailerKinematics::State getTrailerKinematicsState(PosType type = PosType::fused) const;
+    vehicleKinematics::TruckTrailerModel getTruckTrailerModel() const; // with the steering of CarState
 
     bool getSimulateTrailer() const;
     void setSimulateTrailer(bool simulateTrailer);
@@ -45,11 +62,16 @@ public:
     virtual void draw(QPainter &painter, const QTransform &drawTrans, const QTransform &txtTrans, bool isSelected = true) override;
 #endif
 
+protected:
+    // The simulated trailer is integrated per driven distance
+    virtual double getMaxSimulationSubstepDistance() const override;
+    virtual void simulationSubstepIntegrated(double drivenDistance, PosType usePosType) override;
+
 private:
     double mPurePursuitForwardGain = 1.0;
     double mPurePursuitReverseGain = -1.0;
 
-    double mTrailerAngle_deg = 0.0;
+    SeqLock<TrailerAngleSample> mTrailerAngle;
     bool mSimulateTrailer = false;
 
     double getCurvatureWithTrailer(const QPointF &point);
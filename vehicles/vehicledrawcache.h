@@ -0,0 +1,126 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Caches for drawing vehicles on the map, i.e., for content that rarely changes compared to the repaint rate:
+ * VehicleGlyphCache keeps the vehicle body pre-rendered as pixmap (per look and zoom level bucket) that is then only
+ * blitted at the vehicle's pose, VehicleStatusTextCache keeps the status text laid out (QStaticText) until a shown value changes.
+ * Both decide on change by comparing the values their content is made from, given as a list of doubles.
+ */
+
+#ifndef VEHICLEDRAWCACHE_H
+#define VEHICLEDRAWCACHE_H
+
+#ifdef QT_GUI_LIB
+#include <QPainter>
+#include <QPixmap>
+#include <QStaticText>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+class VehicleDrawInputs
+{
+public:
+    // Stores values and returns true if they differ from the stored ones
+    bool update(std::initializer_list<double> values) {
+        if (int(values.size()) == mValues.size() && std::equal(values.begin(), values.end(), mValues.constBegin()))
+            return false;
+        mValues.clear();
+        for (const double value : values)
+            mValues.append(value);
+        return true;
+    }
+    void invalidate() { mValues.clear(); }
+
+    // Value as shown with the given significant digits (e.g., QTextStream::setRealNumberPrecision), i.e., only changes when the text would
+    static double roundToSignificantDigits(double value, int digits) {
+        if (value == 0.0 || !std::isfinite(value))
+            return value;
+        const double magnitude = std::pow(10.0, digits - 1 - std::floor(std::log10(std::fabs(value))));
+        return std::round(value * magnitude) / magnitude;
+    }
+
+private:
+    QVarLengthArray<double, 16> mValues;
+};
+
+class VehicleGlyphCache
+{
+public:
+    static constexpr double SCALE_BUCKETS_PER_OCTAVE = 4.0; // re-rendered when zooming by more than 2^(1/8)
+    static constexpr int MAX_PIXMAP_SIZE = 2048; // [px], larger glyphs (close zoom) are drawn directly
+    static constexpr int MARGIN_PX = 2; // antialiased edges
+
+    // painter: transformed to the vehicle frame [mm], drawGlyph: draws the body within bounds_mm to the given painter,
+    // inputs: everything drawGlyph depends on (the painter's pen is taken into account)
+    template<typename DrawGlyph>
+    void draw(QPainter &painter, const QRectF &bounds_mm, std::initializer_list<double> inputs, DrawGlyph drawGlyph) {
+        const double deviceScale = std::sqrt(std::fabs(painter.transform().determinant())) * painter.device()->devicePixelRatioF();
+        if (!(deviceScale > 0.0) || bounds_mm.isEmpty()) // also NaN
+            return;
+
+        const double scale = std::pow(2.0, std::round(std::log2(deviceScale) * SCALE_BUCKETS_PER_OCTAVE) / SCALE_BUCKETS_PER_OCTAVE);
+        const QSize size(std::ceil(bounds_mm.width() * scale) + 2 * MARGIN_PX, std::ceil(bounds_mm.height() * scale) + 2 * MARGIN_PX);
+        if (size.width() > MAX_PIXMAP_SIZE || size.height() > MAX_PIXMAP_SIZE) {
+            drawGlyph(painter);
+            return;
+        }
+
+        const QPen pen = painter.pen();
+        const bool inputsChanged = mInputs.update(inputs);
+        if (inputsChanged || mPixmap.isNull() || scale != mScale || pen != mPen) {
+            mScale = scale;
+            mPen = pen;
+            mPixmap = QPixmap(size);
+            mPixmap.fill(Qt::transparent);
+            QPainter glyphPainter(&mPixmap);
+            glyphPainter.setRenderHints(painter.renderHints());
+            glyphPainter.setPen(pen);
+            glyphPainter.translate(MARGIN_PX, MARGIN_PX);
+            glyphPainter.scale(scale, scale);
+            glyphPainter.translate(-bounds_mm.topLeft());
+            drawGlyph(glyphPainter);
+        }
+
+        const bool smoothPixmapTransform = painter.testRenderHint(QPainter::SmoothPixmapTransform);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        const double margin_mm = MARGIN_PX / scale;
+        painter.drawPixmap(QRectF(bounds_mm.topLeft() - QPointF(margin_mm, margin_mm), QSizeF(mPixmap.width() / scale, mPixmap.height() / scale)),
+                           mPixmap, QRectF(mPixmap.rect()));
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, smoothPixmapTransform);
+    }
+
+private:
+    VehicleDrawInputs mInputs;
+    QPixmap mPixmap;
+    double mScale = 0.0;
+    QPen mPen;
+};
+
+class VehicleStatusTextCache
+{
+public:
+    VehicleStatusTextCache() {
+        mStaticText.setTextFormat(Qt::PlainText);
+        mStaticText.setPerformanceHint(QStaticText::AggressiveCaching);
+    }
+
+    // Returns true if the values shown differ from the cached text, i.e., setText() is to be called
+    bool needsUpdate(const QString &name, std::initializer_list<double> values) {
+        const bool nameChanged = name != mName;
+        mName = name;
+        return mInputs.update(values) || nameChanged;
+    }
+    void setText(const QString &text) { mStaticText.setText(text); }
+    void draw(QPainter &painter, const QPointF &topLeft) const { painter.drawStaticText(topLeft, mStaticText); }
+
+private:
+    VehicleDrawInputs mInputs;
+    QString mName;
+    QStaticText mStaticText;
+};
+#endif
+
+#endif // VEHICLEDRAWCACHE_H
@@ -0,0 +1,158 @@
+/*
+ *     Copyright 2026 RISE Research Institutes of Sweden AB, Safety and Transport   waywise@ri.se
+ *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
+ *
+ * Kinematic vehicle models as plain values (no QObject, no virtual calls), e.g., to forward-simulate many candidates in
+ * a controller or simulation batch. CarState, DiffDriveVehicleState and TruckState stay the interface to the rest of the
+ * system and provide their model by getKinematicModel() / getTruckTrailerModel().
+ * Each model gives the yaw curvature and the distance of its reference point per driven distance for a steering
+ * (as in VehicleState::setSteering), KinematicModel then moves the reference point on that arc. PoseBatch steps candidates
+ * of one model type in lock-step (structure of arrays), the model is a template parameter, i.e., its functions are inlined.
+ * Steering curvature: negative is left, as VehicleState::getCurvatureToPointInVehicleFrame. Angles in radians, ENU.
+ */
+
+#ifndef VEHICLEKINEMATICS_H
+#define VEHICLEKINEMATICS_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "vehicles/trailerkinematics.h"
+
+namespace vehicleKinematics {
+
+struct Pose {
+    double x = 0.0; // reference point, e.g., rear axle [m]
+    double y = 0.0;
+    double yaw_rad = 0.0;
+};
+
+namespace detail {
+// sin(h) / h, i.e., the chord of an arc with yaw change 2h relative to its length
+inline double chordFactor(double h)
+{
+    return std::fabs(h) > 1e-4 ? std::sin(h) / h : 1.0 - h * h / 6.0;
+}
+
+// Same from its series (no branch or division), accurate to 1e-9 up to h = 0.25
+inline double chordFactorSeries(double h)
+{
+    const double h2 = h * h;
+    return 1.0 - h2 / 6.0 * (1.0 - h2 / 20.0 * (1.0 - h2 / 42.0));
+}
+}
+
+// Moves the reference point by distance on an arc along which the yaw changes by yawChange (exact for constant curvature)
+inline Pose arcStep(const Pose &pose, double distance, double yawChange)
+{
+    const double yawMid = pose.yaw_rad + 0.5 * yawChange;
+    const double chord = distance * detail::chordFactor(0.5 * yawChange);
+    return {pose.x + chord * std::cos(yawMid), pose.y + chord * std::sin(yawMid), pose.yaw_rad + yawChange};
+}
+
+// Model: getYawCurvature(steering) [rad/m] and getPathDistanceFactor(steering), the reference point's distance per driven distance
+template<typename Model>
+struct KinematicModel {
+    // ds: driven distance [m], negative when reversing
+    Pose step(const Pose &pose, double steering, double ds) const {
+        const Model &model = static_cast<const Model &>(*this);
+        return arcStep(pose, ds * model.getPathDistanceFactor(steering), ds * model.getYawCurvature(steering));
+    }
+
+    // Pure pursuit to a point in the vehicle frame
+    static double getSteeringCurvatureToPoint(double x, double y) { return -2.0 * y / (x * x + y * y); }
+};
+
+// Bicycle model of a car-type (ackermann) vehicle with the rear axle as reference point, steering approximates tan(steering angle)
+struct CarModel : KinematicModel<CarModel> {
+    double axisDistance_m = 1.0;
+    double maxSteeringAngle_rad = M_PI / 4.0;
+
+    // 1 / mean of rear and front turn radius, sign as the rear turn radius (see SteeringGeometryTable)
+    double getYawCurvature(double steering) const { return -steering * getRearAxleDistanceFactor(steering) / axisDistance_m; }
+    double getPathDistanceFactor(double steering) const { return getRearAxleDistanceFactor(steering); }
+    // Rear / mean turn radius
+    static double getRearAxleDistanceFactor(double steering) { return 2.0 / (1.0 + std::sqrt(1.0 + steering * steering)); }
+
+    // [-1.0:1.0], saturated at maxSteeringAngle_rad
+    double steeringCurvatureToSteering(double steeringCurvature) const {
+        const double steeringAngle_rad = std::atan(axisDistance_m * steeringCurvature);
+        return std::max(-1.0, std::min(steeringAngle_rad / maxSteeringAngle_rad, 1.0));
+    }
+    // Inverse of steeringCurvatureToSteering() within [-1.0:1.0]
+    double getSteeringCurvature(double steering) const { return std::tan(steering * maxSteeringAngle_rad) / axisDistance_m; }
+};
+
+// Differential drive with the center between the wheels as reference point, steering splits the speed into
+// speed * (1 + steering) left and speed * (1 - steering) right (see DiffDriveVehicleState::setSteering)
+struct DiffDriveModel : KinematicModel<DiffDriveModel> {
+    double width_m = 1.0; // between the centers of the left and right wheels
+
+    double getYawCurvature(double steering) const { return -2.0 * steering / width_m; }
+    double getPathDistanceFactor(double steering) const { (void)steering; return 1.0; }
+    double steeringCurvatureToSteering(double steeringCurvature) const { return width_m / 2.0 * steeringCurvature; }
+
+    // Driven distances of the wheels
+    Pose stepWheels(const Pose &pose, double leftDistance, double rightDistance) const {
+        return arcStep(pose, 0.5 * (leftDistance + rightDistance), (rightDistance - leftDistance) / width_m);
+    }
+};
+
+// Truck (CarModel) and trailer (trailerKinematics), the trailer's yaw follows the truck's curvature
+struct TruckTrailerModel : KinematicModel<TruckTrailerModel> {
+    CarModel truck;
+    trailerKinematics::Parameters trailer;
+
+    double getYawCurvature(double steering) const { return truck.getYawCurvature(steering); }
+    double getPathDistanceFactor(double steering) const { return truck.getPathDistanceFactor(steering); }
+    double steeringCurvatureToSteering(double steeringCurvature) const { return truck.steeringCurvatureToSteering(steeringCurvature); }
+
+    using KinematicModel<TruckTrailerModel>::step;
+    trailerKinematics::State step(const trailerKinematics::State &state, double steering, double ds) const {
+        return trailerKinematics::step(trailer, state, getYawCurvature(steering), ds);
+    }
+
+    // steerings: one per candidate of the batch
+    template<int MaxCandidates>
+    void stepBatch(trailerKinematics::CandidateBatch<MaxCandidates> &batch, const double *steerings, double ds) const {
+        std::array<double, MaxCandidates> curvatures;
+        for (int i = 0; i < batch.numCandidates; i++)
+            curvatures[i] = getYawCurvature(steerings[i]);
+        batch.step(trailer, curvatures.data(), ds);
+    }
+};
+
+// Steps up to MaxCandidates poses of one model at once, e.g., candidate steerings over a controller's horizon
+template<typename Model, int MaxCandidates>
+struct PoseBatch {
+    int numCandidates = 0;
+    std::array<double, MaxCandidates> x {};
+    std::array<double, MaxCandidates> y {};
+    std::array<double, MaxCandidates> yaw_rad {};
+
+    void reset(const Pose &initial, int candidates) {
+        numCandidates = std::min(candidates, MaxCandidates);
+        x.fill(initial.x);
+        y.fill(initial.y);
+        yaw_rad.fill(initial.yaw_rad);
+    }
+
+    Pose getPose(int candidate) const { return {x[candidate], y[candidate], yaw_rad[candidate]}; }
+
+    // steerings: one per candidate for this step. Same as KinematicModel::step(), but the chord from its series,
+    // i.e., vectorizable; accurate to 1e-9 for yaw changes of up to 0.5 rad per step.
+    void step(const Model &model, const double *steerings, double ds) {
+        for (int i = 0; i < numCandidates; i++) {
+            const double yawChange = ds * model.getYawCurvature(steerings[i]);
+            const double yawMid = yaw_rad[i] + 0.5 * yawChange;
+            const double chord = ds * model.getPathDistanceFactor(steerings[i]) * detail::chordFactorSeries(0.5 * yawChange);
+            x[i] += chord * std::cos(yawMid);
+            y[i] += chord * std::sin(yawMid);
+            yaw_rad[i] += yawChange;
+        }
+    }
+};
+
+}
+
+#endif // VEHICLEKINEMATICS_H
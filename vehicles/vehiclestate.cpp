@@ -3,32 +3,122 @@
  *     Published under GPLv3: https://www.gnu.org/licenses/gpl-3.0.html
  */
 #include "vehiclestate.h"
+#include "core/enureprojector.h"
 #include <QDebug>
 
+namespace {
+pospoint_t interpolatePosition(const pospoint_t &before, const pospoint_t &after, double fraction)
+{
+    pospoint_t position = (fraction < 0.5) ? before : after;
+    position.x = before.x + (after.x - before.x) * fraction;
+    position.y = before.y + (after.y - before.y) * fraction;
+    position.height = before.height + (after.height - before.height) * fraction;
+    position.roll = before.roll + (after.roll - before.roll) * fraction;
+    position.pitch = before.pitch + (after.pitch - before.pitch) * fraction;
+    double yawDiff = after.yaw - before.yaw;
+    while (yawDiff < -180.0) yawDiff += 360.0;
+    while (yawDiff > 180.0) yawDiff -= 360.0;
+    position.yaw = before.yaw + yawDiff * fraction;
+    position.speed = before.speed + (after.speed - before.speed) * fraction;
+    position.sigma = before.sigma + (after.sigma - before.sigma) * fraction;
+    position.timestamp_ns = before.timestamp_ns + qint64((after.timestamp_ns - before.timestamp_ns) * fraction);
+    return position;
+}
+}
+
 VehicleState::VehicleState(ObjectID_t id, Qt::GlobalColor color)
     : ObjectState (id, color)
 {
-    mTime = QTime();
-
+    qRegisterMetaType<pospoint_t>();
     for (int i = 0; i < (int)PosType::_LAST_; i++)
-        switch((PosType) i) {
-        case PosType::simulated: mPositionBySource[i].setType(PosType::simulated); break;
-        case PosType::fused: mPositionBySource[i].setType(PosType::fused); break;
-        case PosType::odom: mPositionBySource[i].setType(PosType::odom); break;
-        case PosType::IMU: mPositionBySource[i].setType(PosType::IMU); break;
-        case PosType::GNSS: mPositionBySource[i].setType(PosType::GNSS); break;
-        case PosType::UWB: mPositionBySource[i].setType(PosType::UWB); break;
-        case PosType::_LAST_: qDebug() << "This should not have happended."; break;
-
-        }
+        mPositionBySource[i].update([i](pospoint_t &position) { position.type = (PosType) i; });
 }
 
 
 void VehicleState::setPosition(PosPoint &point)
 {
-    mPositionBySource[(int)point.getType()] = point;
+    const pospoint_t position = point.toPOD();
+    mPositionBySource[(int)point.getType()].store(position);
+    appendToPositionHistory(position);
+
+    markChanged(FIELD_POSITION);
+    emit positionUpdated();
+    emit positionOfSourceUpdated(position);
+}
+
+void VehicleState::updatePosition(PosType type, const std::function<void (PosPoint &)> &modify)
+{
+    pospoint_t updated;
+    mPositionBySource[(int)type].update([&modify, type, &updated](pospoint_t &position) {
+        PosPoint point(position);
+        modify(point);
+        point.setType(type);
+        position = point.toPOD();
+        updated = position;
+    });
+    appendToPositionHistory(updated);
 
+    markChanged(FIELD_POSITION);
     emit positionUpdated();
+    emit positionOfSourceUpdated(updated);
+}
+
+void VehicleState::reprojectEnu(const coordinateTransforms::EnuTransform &transform)
+{
+    for (int type = 0; type < (int)PosType::_LAST_; type++) {
+        mPositionBySource[type].update([&transform](pospoint_t &position) { EnuReprojector::reprojectPoint(transform, position); });
+        clearPositionHistory((PosType)type);
+    }
+    mHomePosition.update([&transform](pospoint_t &position) { EnuReprojector::reprojectPoint(transform, position); });
+    markChanged(FIELD_POSITION | FIELD_HOME_POSITION);
+
+    if (hasTrailingVehicle())
+        getTrailingVehicle()->reprojectEnu(transform);
+}
+
+void VehicleState::appendToPositionHistory(const pospoint_t &position)
+{
+    if (position.timestamp_ns == utcTime::INVALID)
+        return;
+
+    PositionHistory &history = mPositionHistoryBySource[(int)position.type];
+    std::lock_guard<std::mutex> lock(history.mutex);
+    if (!history.samples.isEmpty() && history.samples.newest().timestamp == position.timestamp_ns)
+        history.samples.replaceNewest(position); // e.g., updatePosition() without a new timestamp
+    else
+        history.samples.append(position.timestamp_ns, position);
+}
+
+PosPoint VehicleState::getPosition(PosType type, qint64 timestamp_ns) const
+{
+    const PositionHistory &history = mPositionHistoryBySource[(int)type];
+    pospoint_t position;
+    bool found;
+    {
+        std::lock_guard<std::mutex> lock(history.mutex);
+        found = history.samples.getSampleAt(timestamp_ns, position, interpolatePosition);
+    }
+    return found ? PosPoint(position) : getPosition(type);
+}
+
+int VehicleState::getPositionHistorySize() const
+{
+    return mPositionHistoryBySource[0].samples.getCapacity();
+}
+
+void VehicleState::setPositionHistorySize(int positionHistorySize)
+{
+    for (PositionHistory &history : mPositionHistoryBySource) {
+        std::lock_guard<std::mutex> lock(history.mutex);
+        history.samples.setCapacity(positionHistorySize);
+    }
+}
+
+void VehicleState::clearPositionHistory(PosType type)
+{
+    PositionHistory &history = mPositionHistoryBySource[(int)type];
+    std::lock_guard<std::mutex> lock(history.mutex);
+    history.samples.clear();
 }
 
 void VehicleState::simulationStep(double dt_ms, PosType usePosType)
@@ -45,6 +135,7 @@ std::array<float, 3> VehicleState::getGyroscopeXYZ() const
 void VehicleState::setGyroscopeXYZ(const std::array<float, 3> &gyroscopeXYZ)
 {
     mGyroscopeXYZ = gyroscopeXYZ;
+    markChanged(FIELD_IMU);
 }
 
 std::array<float, 3> VehicleState::getAccelerometerXYZ() const
@@ -55,6 +146,7 @@ std::array<float, 3> VehicleState::getAccelerometerXYZ() const
 void VehicleState::setAccelerometerXYZ(const std::array<float, 3> &accelerometerXYZ)
 {
     mAccelerometerXYZ = accelerometerXYZ;
+    markChanged(FIELD_IMU);
 }
 
 double VehicleState::getSteering() const
@@ -68,16 +160,18 @@ void VehicleState::setSteering(double steering)
         steering = steering / abs(steering);
 
     mSteering = steering;
+    markChanged(FIELD_STEERING);
 }
 
 PosPoint VehicleState::getHomePosition() const
 {
-    return mHomePosition;
+    return PosPoint(mHomePosition.load());
 }
 
 void VehicleState::setHomePosition(const PosPoint &homePosition)
 {
-    mHomePosition = homePosition;
+    mHomePosition.store(homePosition.toPOD());
+    markChanged(FIELD_HOME_POSITION);
 }
 
 bool VehicleState::getIsArmed() const
@@ -88,11 +182,12 @@ bool VehicleState::getIsArmed() const
 void VehicleState::setIsArmed(bool isArmed)
 {
     mIsArmed = isArmed;
+    markChanged(FIELD_ARMED);
 }
 
 PosPoint VehicleState::getPosition(PosType type) const
 {
-    return mPositionBySource[(int)type];
+    return PosPoint(mPositionBySource[(int)type].load());
 }
 
 PosPoint VehicleState::posInVehicleFrameToPosPointENU(xyz_t offset, PosType type) const
@@ -110,11 +205,13 @@ VehicleState::FlightMode VehicleState::getFlightMode() const
 void VehicleState::setFlightMode(const FlightMode &flightMode)
 {
     mFlightMode = flightMode;
+    markChanged(FIELD_FLIGHT_MODE);
 }
 
 void VehicleState::setAutopilotRadius(double radius)
 {
     mAutopilotRadius = radius;
+    markChanged(FIELD_AUTOPILOT);
 }
 
 double VehicleState::getAutopilotRadius()
@@ -133,7 +230,7 @@ double VehicleState::getCurvatureToPointInVehicleFrame(const QPointF &point)
 
 double VehicleState::getCurvatureToPointInENU(const QPointF &point, PosType type)
 {
-    PosPoint vehiclePosition = mPositionBySource[(int)type];
+    PosPoint vehiclePosition = getPosition(type);
 
     return getCurvatureToPointInVehicleFrame(coordinateTransforms::ENUToVehicleFrame(point, vehiclePosition.getXYZ(), vehiclePosition.getYaw()));
 }
@@ -146,6 +243,7 @@ QSharedPointer<VehicleState> VehicleState::getTrailingVehicle() const
 void VehicleState::setTrailingVehicle(QSharedPointer<VehicleState> trailer)
 {
     mTrailingVehicle = trailer;
+    markChanged(FIELD_STATIC);
 }
 
 bool VehicleState::hasTrailingVehicle() const
@@ -12,11 +12,14 @@
 #include <QVector>
 #include <QString>
 #include <QSharedPointer>
+#include <functional>
+#include <mutex>
 #ifdef QT_GUI_LIB
 #include <QPainter>
 #endif
 
 #include "core/pospoint.h"
+#include "core/timestampedhistory.h"
 #include "vehicles/objectstate.h"
 #include <math.h>
 
@@ -45,36 +48,49 @@ public:
         Rattitude
     };
 
+    static constexpr int DEFAULT_POSITION_HISTORY_SIZE = 128; // per source, e.g., >1 s of IMU at 100 Hz
+
     VehicleState(ObjectID_t id = 1, Qt::GlobalColor color = Qt::red);
 
     // Static state
     double getLength() const { return mLength; }
-    virtual void setLength(double length) { mLength = length; }
+    virtual void setLength(double length) { mLength = length; markChanged(FIELD_STATIC); }
     double getWidth() const { return mWidth; }
-    void setWidth(double width) { mWidth = width; }
+    void setWidth(double width) { mWidth = width; markChanged(FIELD_STATIC); }
     double getMinAcceleration() const { return mMinAcceleration; }
-    void setMinAcceleration(double minAcceleration) { mMinAcceleration = minAcceleration; }
+    void setMinAcceleration(double minAcceleration) { mMinAcceleration = minAcceleration; markChanged(FIELD_STATIC); }
     double getMaxAcceleration() const { return mMaxAcceleration; }
-    void setMaxAcceleration(double maxAcceleration) { mMaxAcceleration = maxAcceleration; }
+    void setMaxAcceleration(double maxAcceleration) { mMaxAcceleration = maxAcceleration; markChanged(FIELD_STATIC); }
 
     xyz_t getRearAxleToCenterOffset() const { return mRearAxleToCenterOffset; }
-    void setRearAxleToCenterOffset(double rearAxleToCenterOffsetX) { mRearAxleToCenterOffset.x = rearAxleToCenterOffsetX; }
-    void setRearAxleToCenterOffset(xyz_t rearAxleToCenterOffset) { mRearAxleToCenterOffset = rearAxleToCenterOffset; }
+    void setRearAxleToCenterOffset(double rearAxleToCenterOffsetX) { mRearAxleToCenterOffset.x = rearAxleToCenterOffsetX; markChanged(FIELD_STATIC); }
+    void setRearAxleToCenterOffset(xyz_t rearAxleToCenterOffset) { mRearAxleToCenterOffset = rearAxleToCenterOffset; markChanged(FIELD_STATIC); }
     xyz_t getRearAxleToRearEndOffset() const { return mRearAxleToRearEndOffset; }
-    void setRearAxleToRearEndOffset(double rearAxleToRearEndOffsetX) { mRearAxleToRearEndOffset.x = rearAxleToRearEndOffsetX; }
-    void setRearAxleToRearEndOffset(xyz_t rearAxleToRearEndOffset) { mRearAxleToRearEndOffset = rearAxleToRearEndOffset; }
+    void setRearAxleToRearEndOffset(double rearAxleToRearEndOffsetX) { mRearAxleToRearEndOffset.x = rearAxleToRearEndOffsetX; markChanged(FIELD_STATIC); }
+    void setRearAxleToRearEndOffset(xyz_t rearAxleToRearEndOffset) { mRearAxleToRearEndOffset = rearAxleToRearEndOffset; markChanged(FIELD_STATIC); }
     xyz_t getRearAxleToHitchOffset() const { return mRearAxleToHitchOffset; }
-    void setRearAxleToHitchOffset(double rearAxleToHitchOffsetX) { mRearAxleToHitchOffset.x = rearAxleToHitchOffsetX; }
-    void setRearAxleToHitchOffset(xyz_t rearAxleToHitchOffset) { mRearAxleToHitchOffset = rearAxleToHitchOffset; }
+    void setRearAxleToHitchOffset(double rearAxleToHitchOffsetX) { mRearAxleToHitchOffset.x = rearAxleToHitchOffsetX; markChanged(FIELD_STATIC); }
+    void setRearAxleToHitchOffset(xyz_t rearAxleToHitchOffset) { mRearAxleToHitchOffset = rearAxleToHitchOffset; markChanged(FIELD_STATIC); }
 
     // Dynamic state
     virtual PosPoint getPosition(PosType type) const;
+    pospoint_t getPositionPOD(PosType type) const { return mPositionBySource[(int)type].load(); } // without PosPoint's info, e.g., for high-rate telemetry
     virtual PosPoint getPosition() const override { return getPosition(PosType::simulated); }
     virtual PosPoint posInVehicleFrameToPosPointENU(xyz_t offset, PosType type) const;
     virtual PosPoint posInVehicleFrameToPosPointENU(xyz_t offset) const { return posInVehicleFrameToPosPointENU(offset, PosType::simulated); }
     virtual void setPosition(PosPoint &point) override;
-    virtual QTime getTime() const override { return mTime; }
-    virtual void setTime(const QTime &time) override { mTime = time; }
+    // Read-modify-write of a single source that is atomic with respect to other writers, e.g., for callbacks that only update some fields
+    virtual void updatePosition(PosType type, const std::function<void(PosPoint&)> &modify);
+    // All sources, the home position and the trailing vehicle, clears the position histories (interpolation across references is meaningless)
+    virtual void reprojectEnu(const coordinateTransforms::EnuTransform &transform) override;
+    // Position of a source at a given time (UTC [ns]), interpolated between the two samples around it in the source's history.
+    // Times outside of the history are clamped to the oldest/newest sample, without history the latest position is returned.
+    PosPoint getPosition(PosType type, qint64 timestamp_ns) const;
+    int getPositionHistorySize() const;
+    void setPositionHistorySize(int positionHistorySize); // clears the histories
+    void clearPositionHistory(PosType type);
+    virtual qint64 getTimestamp_ns() const override { return mTimestamp_ns; }
+    virtual void setTimestamp_ns(qint64 timestamp_ns) override { mTimestamp_ns = timestamp_ns; markChanged(FIELD_TIMESTAMP); }
     FlightMode getFlightMode() const;
     void setFlightMode(const FlightMode &flightMode);
     double getSteering() const;
@@ -85,10 +101,10 @@ public:
     void setIsArmed(bool isArmed);
     void setAutopilotRadius(double radius);
     double getAutopilotRadius();
-    void setAutopilotTargetPoint(QPointF autopilotTargetPoint) { mAutopilotTargetPoint = autopilotTargetPoint; }
+    void setAutopilotTargetPoint(QPointF autopilotTargetPoint) { mAutopilotTargetPoint = autopilotTargetPoint; markChanged(FIELD_AUTOPILOT); }
     QPointF getAutopilotTargetPoint() const { return mAutopilotTargetPoint; }
     AutopilotEndGoalAlignmentType getEndGoalAlignmentType() const {return mEndGoalAlignmentType;};
-    void setEndGoalAlignmentType(AutopilotEndGoalAlignmentType value) { mEndGoalAlignmentType = value; };
+    void setEndGoalAlignmentType(AutopilotEndGoalAlignmentType value) { mEndGoalAlignmentType = value; markChanged(FIELD_AUTOPILOT); };
     virtual double getCurvatureToPointInVehicleFrame(const QPointF &point);
     double getCurvatureToPointInENU(const QPointF &point, PosType type);
 
@@ -98,7 +114,7 @@ public:
     void setTrailingVehicle(QSharedPointer<VehicleState> trailer);
     bool hasTrailingVehicle() const;
 
-    void simulationStep(double dt_ms, PosType usePosType = PosType::simulated); // Take current state and simulate step forward for dt_ms milliseconds, update state accordingly
+    virtual void simulationStep(double dt_ms, PosType usePosType = PosType::simulated); // Take current state and simulate step forward for dt_ms milliseconds, update state accordingly
     virtual void updateOdomPositionAndYaw(double drivenDistance, PosType usePosType = PosType::odom) = 0;
     virtual double steeringCurvatureToSteering(double steeringCurvature) = 0;
 
@@ -108,6 +124,10 @@ public:
     std::array<float, 3> getAccelerometerXYZ() const;
     void setAccelerometerXYZ(const std::array<float, 3> &accelerometerXYZ);
 
+signals:
+    // Emitted with positionUpdated() for every update of a source, with the updated (timestamped) position.
+    // Updates can come from other threads, queued connections get a copy.
+    void positionOfSourceUpdated(const pospoint_t &position);
 
 private:
     // Static state
@@ -123,10 +143,16 @@ private:
 
     // Dynamic state
     double mSteering = 0.0; // [-1.0:1.0]
-    PosPoint mPositionBySource[(int)PosType::_LAST_];
+    SeqLock<pospoint_t> mPositionBySource[(int)PosType::_LAST_];
+    struct PositionHistory {
+        mutable std::mutex mutex;
+        TimestampedHistory<pospoint_t> samples{DEFAULT_POSITION_HISTORY_SIZE}; // timestamps: UTC [ns]
+    };
+    PositionHistory mPositionHistoryBySource[(int)PosType::_LAST_];
+    void appendToPositionHistory(const pospoint_t &position);
     PosPoint mApGoal;
-    QTime mTime;
-    PosPoint mHomePosition;
+    std::atomic<qint64> mTimestamp_ns{utcTime::INVALID};
+    SeqLock<pospoint_t> mHomePosition;
     bool mIsArmed = false;
     FlightMode mFlightMode = FlightMode::Unknown;
     double mAutopilotRadius = 0;
@@ -139,4 +165,6 @@ private:
     std::array<float,3> mAccelerometerXYZ = std::array<float,3>({0.0, 0.0, 0.0}); // [g]
 };
 
+Q_DECLARE_METATYPE(pospoint_t)
+
 #endif // VEHICLESTATE_H